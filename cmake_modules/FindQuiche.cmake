@@ -0,0 +1,41 @@
+# Try to find quiche, the QUIC and HTTP/3 library
+# Once done, this will define
+#
+# Quiche_FOUND        - system has quiche
+# QUICHE_INCLUDE_DIRS - quiche include directories
+# QUICHE_LIBRARIES    - libraries need to use quiche
+
+if (QUICHE_INCLUDE_DIRS AND QUICHE_LIBRARIES)
+    set(QUICHE_FIND_QUIETLY TRUE)
+    set(Quiche_FOUND TRUE)
+else ()
+    find_path(
+            QUICHE_INCLUDE_DIR
+            NAMES quiche.h
+            HINTS ${QUICHE_ROOT_DIR}
+            PATH_SUFFIXES include)
+
+    find_library(
+            QUICHE_LIBRARY
+            NAMES quiche
+            HINTS ${QUICHE_ROOT_DIR}
+            PATH_SUFFIXES ${CMAKE_INSTALL_LIBDIR})
+
+    set(QUICHE_INCLUDE_DIRS ${QUICHE_INCLUDE_DIR})
+    set(QUICHE_LIBRARIES ${QUICHE_LIBRARY})
+
+    include(FindPackageHandleStandardArgs)
+    find_package_handle_standard_args(
+            Quiche DEFAULT_MSG QUICHE_LIBRARY QUICHE_INCLUDE_DIR)
+
+    mark_as_advanced(QUICHE_LIBRARY QUICHE_INCLUDE_DIR)
+endif ()
+
+if(Quiche_FOUND)
+    add_library(Quiche_lib INTERFACE IMPORTED)
+    set_target_properties(Quiche_lib
+            PROPERTIES INTERFACE_INCLUDE_DIRECTORIES
+            "${QUICHE_INCLUDE_DIRS}"
+            INTERFACE_LINK_LIBRARIES
+            "${QUICHE_LIBRARIES}")
+endif(Quiche_FOUND)
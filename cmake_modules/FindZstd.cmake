@@ -0,0 +1,41 @@
+# Try to find zstd
+# Once done, this will define
+#
+# Zstd_FOUND        - system has zstd
+# ZSTD_INCLUDE_DIRS - zstd include directories
+# ZSTD_LIBRARIES    - libraries need to use zstd
+
+if (ZSTD_INCLUDE_DIRS AND ZSTD_LIBRARIES)
+    set(ZSTD_FIND_QUIETLY TRUE)
+    set(Zstd_FOUND TRUE)
+else ()
+    find_path(
+            ZSTD_INCLUDE_DIR
+            NAMES zstd.h
+            HINTS ${ZSTD_ROOT_DIR}
+            PATH_SUFFIXES include)
+
+    find_library(
+            ZSTD_LIBRARY
+            NAMES zstd zstd_static
+            HINTS ${ZSTD_ROOT_DIR}
+            PATH_SUFFIXES ${CMAKE_INSTALL_LIBDIR})
+
+    set(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+    set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+
+    include(FindPackageHandleStandardArgs)
+    find_package_handle_standard_args(
+            Zstd DEFAULT_MSG ZSTD_LIBRARY ZSTD_INCLUDE_DIR)
+
+    mark_as_advanced(ZSTD_LIBRARY ZSTD_INCLUDE_DIR)
+endif ()
+
+if(Zstd_FOUND)
+    add_library(Zstd_lib INTERFACE IMPORTED)
+    set_target_properties(Zstd_lib
+            PROPERTIES INTERFACE_INCLUDE_DIRECTORIES
+            "${ZSTD_INCLUDE_DIRS}"
+            INTERFACE_LINK_LIBRARIES
+            "${ZSTD_LIBRARIES}")
+endif(Zstd_FOUND)
@@ -30,6 +30,10 @@ static const std::string cxx_val_start = "[[";
 static const std::string cxx_val_end = "]]";
 static const std::string sub_view_start = "<%view";
 static const std::string sub_view_end = "%>";
+static const std::regex layoutReg(
+    "<%layout[ \\t]+(((?!%\\}).)*[^ \\t])[ \\t]*%>");
+static const std::regex modelReg(
+    "<%model[ \\t]+(((?!%\\}).)*[^ \\t])[ \\t]*%>");
 
 using namespace drogon_ctl;
 
@@ -71,8 +75,16 @@ static void parseCxxLine(std::ofstream &oSrcFile,
 static void outputVal(std::ofstream &oSrcFile,
                       const std::string &streamName,
                       const std::string &viewDataName,
+                      bool typed,
                       const std::string &keyName)
 {
+    if (typed)
+    {
+        // A member of the model, no lookup
+        oSrcFile << "\t" << streamName << "<<" << viewDataName << "."
+                 << keyName << ";\n";
+        return;
+    }
     oSrcFile << "{\n";
     oSrcFile << "    auto & val=" << viewDataName << "[\"" << keyName
              << "\"];\n";
@@ -91,14 +103,17 @@ static void outputVal(std::ofstream &oSrcFile,
 static void outputSubView(std::ofstream &oSrcFile,
                           const std::string &streamName,
                           const std::string &viewDataName,
+                          bool typed,
                           const std::string &keyName)
 {
     oSrcFile << "{\n";
     oSrcFile << "    auto templ=DrTemplateBase::newTemplate(\"" << keyName
              << "\");\n";
     oSrcFile << "    if(templ){\n";
-    oSrcFile << "      " << streamName << "<< templ->genText(" << viewDataName
-             << ");\n";
+    // The sub views of a typed view get no data
+    oSrcFile << "      templ->renderTo("
+             << (typed ? std::string("DrTemplateData()") : viewDataName)
+             << ", " << streamName << ");\n";
     oSrcFile << "    }\n";
     oSrcFile << "}\n";
 }
@@ -107,6 +122,7 @@ static void parseLine(std::ofstream &oSrcFile,
                       std::string &line,
                       const std::string &streamName,
                       const std::string &viewDataName,
+                      bool typed,
                       int &cxx_flag,
                       int returnFlag = 1)
 {
@@ -131,8 +147,13 @@ static void parseLine(std::ofstream &oSrcFile,
         {
             std::string oldLine = line.substr(0, pos);
             if (oldLine.length() > 0)
-                parseLine(
-                    oSrcFile, oldLine, streamName, viewDataName, cxx_flag, 0);
+                parseLine(oSrcFile,
+                          oldLine,
+                          streamName,
+                          viewDataName,
+                          typed,
+                          cxx_flag,
+                          0);
             std::string newLine = line.substr(pos + cxx_lang.length());
             cxx_flag = 1;
             if (newLine.length() > 0)
@@ -140,6 +161,7 @@ static void parseLine(std::ofstream &oSrcFile,
                           newLine,
                           streamName,
                           viewDataName,
+                          typed,
                           cxx_flag,
                           returnFlag);
         }
@@ -148,8 +170,13 @@ static void parseLine(std::ofstream &oSrcFile,
             if ((pos = line.find(cxx_val_start)) != std::string::npos)
             {
                 std::string oldLine = line.substr(0, pos);
-                parseLine(
-                    oSrcFile, oldLine, streamName, viewDataName, cxx_flag, 0);
+                parseLine(oSrcFile,
+                          oldLine,
+                          streamName,
+                          viewDataName,
+                          typed,
+                          cxx_flag,
+                          0);
                 std::string newLine = line.substr(pos + cxx_val_start.length());
                 if ((pos = newLine.find(cxx_val_end)) != std::string::npos)
                 {
@@ -161,13 +188,15 @@ static void parseLine(std::ofstream &oSrcFile,
                     while (iterEnd != keyName.end() && *iterEnd != ' ')
                         ++iterEnd;
                     keyName = std::string(iter, iterEnd);
-                    outputVal(oSrcFile, streamName, viewDataName, keyName);
+                    outputVal(
+                        oSrcFile, streamName, viewDataName, typed, keyName);
                     std::string tailLine =
                         newLine.substr(pos + cxx_val_end.length());
                     parseLine(oSrcFile,
                               tailLine,
                               streamName,
                               viewDataName,
+                              typed,
                               cxx_flag,
                               returnFlag);
                 }
@@ -180,8 +209,13 @@ static void parseLine(std::ofstream &oSrcFile,
             else if ((pos = line.find(sub_view_start)) != std::string::npos)
             {
                 std::string oldLine = line.substr(0, pos);
-                parseLine(
-                    oSrcFile, oldLine, streamName, viewDataName, cxx_flag, 0);
+                parseLine(oSrcFile,
+                          oldLine,
+                          streamName,
+                          viewDataName,
+                          typed,
+                          cxx_flag,
+                          0);
                 std::string newLine =
                     line.substr(pos + sub_view_start.length());
                 if ((pos = newLine.find(sub_view_end)) != std::string::npos)
@@ -194,13 +228,15 @@ static void parseLine(std::ofstream &oSrcFile,
                     while (iterEnd != keyName.end() && *iterEnd != ' ')
                         ++iterEnd;
                     keyName = std::string(iter, iterEnd);
-                    outputSubView(oSrcFile, streamName, viewDataName, keyName);
+                    outputSubView(
+                        oSrcFile, streamName, viewDataName, typed, keyName);
                     std::string tailLine =
                         newLine.substr(pos + sub_view_end.length());
                     parseLine(oSrcFile,
                               tailLine,
                               streamName,
                               viewDataName,
+                              typed,
                               cxx_flag,
                               returnFlag);
                 }
@@ -238,6 +274,7 @@ static void parseLine(std::ofstream &oSrcFile,
                           oldLine,
                           streamName,
                           viewDataName,
+                          typed,
                           cxx_flag,
                           returnFlag);
         }
@@ -248,6 +285,78 @@ static void parseLine(std::ofstream &oSrcFile,
     }
 }
 
+// Returns the argument of the first tag matching the regex, e.g. the name of
+// the layout, and rewinds the file
+static std::string findTag(std::ifstream &infile, const std::regex &reg)
+{
+    std::string value;
+    for (std::string buffer; std::getline(infile, buffer);)
+    {
+        std::smatch results;
+        if (std::regex_search(buffer, results, reg) && results.size() > 1)
+        {
+            value = results[1].str();
+            break;
+        }
+    }
+    infile.clear();
+    infile.seekg(0, std::ifstream::beg);
+    return value;
+}
+
+// Reads the <%inc %> block, the file is left after it or rewound if there is
+// none
+static void readIncludes(std::ifstream &infile, std::string &includes)
+{
+    bool import_flag{false};
+    for (std::string buffer; std::getline(infile, buffer);)
+    {
+        std::string::size_type pos(0);
+
+        if (!import_flag)
+        {
+            std::string lowerBuffer = buffer;
+            std::transform(lowerBuffer.begin(),
+                           lowerBuffer.end(),
+                           lowerBuffer.begin(),
+                           [](unsigned char c) { return tolower(c); });
+            if ((pos = lowerBuffer.find(cxx_include)) != std::string::npos)
+            {
+                std::string newLine = buffer.substr(pos + cxx_include.length());
+                import_flag = true;
+                if ((pos = newLine.find(cxx_end)) != std::string::npos)
+                {
+                    newLine = newLine.substr(0, pos);
+                    includes.append(newLine).append("\n");
+                    break;
+                }
+                else
+                {
+                    includes.append(newLine).append("\n");
+                }
+            }
+        }
+        else
+        {
+            if ((pos = buffer.find(cxx_end)) != std::string::npos)
+            {
+                std::string newLine = buffer.substr(0, pos);
+                includes.append(newLine).append("\n");
+                break;
+            }
+            else
+            {
+                includes.append(buffer).append("\n");
+            }
+        }
+    }
+    if (!import_flag)
+    {
+        infile.clear();
+        infile.seekg(0, std::ifstream::beg);
+    }
+}
+
 void create_view::handleCommand(std::vector<std::string> &parameters)
 {
     for (auto iter = parameters.begin(); iter != parameters.end();)
@@ -365,8 +474,18 @@ int create_view::createViewFile(const std::string &script_filename)
                 return -1;
             }
 
-            newViewHeaderFile(oHeadFile, className);
-            newViewSourceFile(oSourceFile, className, npPrefix, infile);
+            auto layoutName = findTag(infile, layoutReg);
+            auto modelType = findTag(infile, modelReg);
+            std::string includes;
+            readIncludes(infile, includes);
+            newViewHeaderFile(oHeadFile, className, modelType, includes);
+            newViewSourceFile(oSourceFile,
+                              className,
+                              npPrefix,
+                              layoutName,
+                              modelType,
+                              includes,
+                              infile);
         }
         else
             return -1;
@@ -380,11 +499,19 @@ int create_view::createViewFile(const std::string &script_filename)
 }
 
 void create_view::newViewHeaderFile(std::ofstream &file,
-                                    const std::string &className)
+                                    const std::string &className,
+                                    const std::string &modelType,
+                                    const std::string &includes)
 {
     file << "//this file is generated by program automatically,don't modify "
             "it!\n";
+    if (!modelType.empty())
+        file << "#pragma once\n";
     file << "#include <drogon/DrTemplate.h>\n";
+    file << "#include <drogon/utils/OStringStream.h>\n";
+    // The model is declared by the included headers
+    if (!modelType.empty())
+        file << includes;
     for (auto &np : namespaces_)
     {
         file << "namespace " << np << "\n";
@@ -395,18 +522,73 @@ void create_view::newViewHeaderFile(std::ofstream &file,
     file << "{\npublic:\n\t" << className << "(){};\n\tvirtual ~" << className
          << "(){};\n\t"
             "virtual std::string genText(const drogon::DrTemplateData &) "
-            "override;\n};\n";
+            "override;\n\t"
+            "virtual void renderTo(const drogon::DrTemplateData &, "
+            "drogon::OStringStream &) override;\n";
+    if (!modelType.empty())
+    {
+        file << "\tusing Model = " << modelType << ";\n";
+        file << "\tstatic std::string render(const Model &model);\n";
+        file << "\tstatic void render(const Model &model, "
+                "drogon::OStringStream &stream);\n";
+    }
+    file << "};\n";
     for (std::size_t i = 0; i < namespaces_.size(); ++i)
     {
         file << "}\n";
     }
 }
 
+// The text of a view with a layout is passed whole to the layout, which is
+// written to the stream of the caller
+static void outputLayout(std::ofstream &file,
+                         const std::string &streamName,
+                         const std::string &outStreamName,
+                         const std::string &viewDataName,
+                         const std::string &layoutName)
+{
+    file << "auto templ = DrTemplateBase::newTemplate(\"" << layoutName
+         << "\");\n";
+    file << "if(!templ) return;\n";
+    if (viewDataName.empty())
+        file << "HttpViewData data;\n";
+    else
+        file << "HttpViewData data = " << viewDataName << ";\n";
+    file << "auto str = std::move(" << streamName << ".str());\n";
+    file << "if(!str.empty() && str[str.length()-1] == '\\n') "
+            "str.resize(str.length()-1);\n";
+    file << "data[\"\"] = std::move(str);\n";
+    file << "templ->renderTo(data, " << outStreamName << ");\n";
+}
+
+// A function returning the text as a string, the buffer is reserved with the
+// size of the last rendering
+static void outputStringFunction(std::ofstream &file,
+                                 const std::string &signature,
+                                 const std::string &streamName,
+                                 const std::string &renderCall)
+{
+    file << "std::string " << signature << "\n{\n";
+    file << "\tstatic std::atomic<size_t> sizeHint{0};\n";
+    file << "\tdrogon::OStringStream " << streamName << ";\n";
+    file << "\t" << streamName
+         << ".reserve(sizeHint.load(std::memory_order_relaxed));\n";
+    file << "\t" << renderCall << ";\n";
+    file << "\tsizeHint.store(" << streamName
+         << ".str().size(), std::memory_order_relaxed);\n";
+    file << "\treturn std::move(" << streamName << ".str());\n";
+    file << "}\n";
+}
+
 void create_view::newViewSourceFile(std::ofstream &file,
                                     const std::string &className,
                                     const std::string &namespacePrefix,
+                                    const std::string &layoutName,
+                                    const std::string &modelType,
+                                    const std::string &includes,
                                     std::ifstream &infile)
 {
+    bool typed = !modelType.empty();
     file << "//this file is generated by program(drogon_ctl) "
             "automatically,don't modify it!\n";
     file << "#include \"" << namespacePrefix << className << ".h\"\n";
@@ -423,75 +605,9 @@ void create_view::newViewSourceFile(std::ofstream &file,
     file << "#include <list>\n";
     file << "#include <deque>\n";
     file << "#include <queue>\n";
-
-    // Find layout tag
-    std::string layoutName;
-    std::regex layoutReg("<%layout[ \\t]+(((?!%\\}).)*[^ \\t])[ \\t]*%>");
-    for (std::string buffer; std::getline(infile, buffer);)
-    {
-        std::smatch results;
-        if (std::regex_search(buffer, results, layoutReg))
-        {
-            if (results.size() > 1)
-            {
-                layoutName = results[1].str();
-                break;
-            }
-        }
-    }
-    infile.clear();
-    infile.seekg(0, std::ifstream::beg);
-    bool import_flag{false};
-    for (std::string buffer; std::getline(infile, buffer);)
-    {
-        std::string::size_type pos(0);
-
-        if (!import_flag)
-        {
-            std::string lowerBuffer = buffer;
-            std::transform(lowerBuffer.begin(),
-                           lowerBuffer.end(),
-                           lowerBuffer.begin(),
-                           [](unsigned char c) { return tolower(c); });
-            if ((pos = lowerBuffer.find(cxx_include)) != std::string::npos)
-            {
-                // std::cout<<"haha find it!"<<endl;
-                std::string newLine = buffer.substr(pos + cxx_include.length());
-                import_flag = true;
-                if ((pos = newLine.find(cxx_end)) != std::string::npos)
-                {
-                    newLine = newLine.substr(0, pos);
-                    file << newLine << "\n";
-                    break;
-                }
-                else
-                {
-                    file << newLine << "\n";
-                }
-            }
-        }
-        else
-        {
-            // std::cout<<buffer<<endl;
-            if ((pos = buffer.find(cxx_end)) != std::string::npos)
-            {
-                std::string newLine = buffer.substr(0, pos);
-                file << newLine << "\n";
-                break;
-            }
-            else
-            {
-                // std::cout<<"to source file"<<buffer<<endl;
-                file << buffer << "\n";
-            }
-        }
-    }
-    // std::cout<<"import_flag="<<import_flag<<std::endl;
-    if (!import_flag)
-    {
-        infile.clear();
-        infile.seekg(0, std::ifstream::beg);
-    }
+    file << "#include <atomic>\n";
+    if (!typed)
+        file << includes;
 
     if (!namespaces_.empty())
     {
@@ -511,22 +627,30 @@ void create_view::newViewSourceFile(std::ofstream &file,
     }
     file << "using namespace drogon;\n";
     std::string viewDataName = className + "_view_data";
-    // virtual std::string genText(const DrTemplateData &)
-    file << "std::string " << className << "::genText(const DrTemplateData& "
-         << viewDataName << ")\n{\n";
-    // std::string bodyName=className+"_bodystr";
+    std::string modelName = className + "_model";
     std::string streamName = className + "_tmp_stream";
+    std::string outStreamName = className + "_out_stream";
+    std::string dataName = typed ? modelName : viewDataName;
 
-    // oSrcFile <<"\tstd::string "<<bodyName<<";\n";
-    file << "\tdrogon::OStringStream " << streamName << ";\n";
-    file << "\tstd::string layoutName{\"" << layoutName << "\"};\n";
+    // The text is written to the stream of the caller as it goes, except for
+    // the views with a layout
+    if (typed)
+        file << "void " << className << "::render(const " << modelType
+             << " &";
+    else
+        file << "void " << className << "::renderTo(const DrTemplateData& ";
+    file << dataName << ", drogon::OStringStream &"
+         << (layoutName.empty() ? streamName : outStreamName) << ")\n{\n";
+    if (!layoutName.empty())
+        file << "\tdrogon::OStringStream " << streamName << ";\n";
     int cxx_flag = 0;
     for (std::string buffer; std::getline(infile, buffer);)
     {
         if (buffer.length() > 0)
         {
             std::smatch results;
-            if (std::regex_search(buffer, results, layoutReg))
+            if (std::regex_search(buffer, results, layoutReg) ||
+                std::regex_search(buffer, results, modelReg))
             {
                 if (results.size() > 1)
                 {
@@ -537,18 +661,49 @@ void create_view::newViewSourceFile(std::ofstream &file,
             std::regex re("\\{%[ \\t]*(((?!%\\}).)*[^ \\t])[ \\t]*%\\}");
             buffer = std::regex_replace(buffer, re, "<%c++$$$$<<$1;%>");
         }
-        parseLine(file, buffer, streamName, viewDataName, cxx_flag);
+        parseLine(file, buffer, streamName, dataName, typed, cxx_flag);
     }
-    file << "if(layoutName.empty())\n{\n";
-    file << "std::string ret{std::move(" << streamName << ".str())};\n";
-    file << "return ret;\n}else\n{\n";
-    file << "auto templ = DrTemplateBase::newTemplate(layoutName);\n";
-    file << "if(!templ) return \"\";\n";
-    file << "HttpViewData data = " << viewDataName << ";\n";
-    file << "auto str = std::move(" << streamName << ".str());\n";
-    file << "if(!str.empty() && str[str.length()-1] == '\\n') "
-            "str.resize(str.length()-1);\n";
-    file << "data[\"\"] = std::move(str);\n";
-    file << "return templ->genText(data);\n";
-    file << "}\n}\n";
+    if (!layoutName.empty())
+        outputLayout(file,
+                     streamName,
+                     outStreamName,
+                     typed ? std::string() : viewDataName,
+                     layoutName);
+    file << "}\n";
+
+    if (!typed)
+    {
+        // virtual std::string genText(const DrTemplateData &)
+        outputStringFunction(file,
+                             className + "::genText(const DrTemplateData& " +
+                                 viewDataName + ")",
+                             streamName,
+                             "renderTo(" + viewDataName + ", " + streamName +
+                                 ")");
+        return;
+    }
+    outputStringFunction(file,
+                         className + "::render(const " + modelType + " &" +
+                             modelName + ")",
+                         streamName,
+                         "render(" + modelName + ", " + streamName + ")");
+
+    // The untyped interface takes the model from the "model" key
+    auto getModel = [&](const std::string &failure) {
+        file << "\tauto " << modelName << " = std::any_cast<const "
+             << modelType << ">(&" << viewDataName << "[\"model\"]);\n";
+        file << "\tif(!" << modelName << ")\n\t{\n";
+        file << "\t\tLOG_ERROR << \"The view " << className << " needs a "
+             << modelType << " under the key \\\"model\\\"\";\n";
+        file << "\t\treturn" << failure << ";\n\t}\n";
+    };
+    file << "std::string " << className << "::genText(const DrTemplateData& "
+         << viewDataName << ")\n{\n";
+    getModel(" \"\"");
+    file << "\treturn render(*" << modelName << ");\n}\n";
+    file << "void " << className << "::renderTo(const DrTemplateData& "
+         << viewDataName << ", drogon::OStringStream &" << streamName
+         << ")\n{\n";
+    getModel("");
+    file << "\trender(*" << modelName << ", " << streamName << ");\n}\n";
 }
@@ -36,10 +36,16 @@ class create_view : public DrObject<create_view>, public CommandHandler
     bool pathToNamespaceFlag_{false};
     void createViewFiles(std::vector<std::string> &cspFileNames);
     int createViewFile(const std::string &script_filename);
-    void newViewHeaderFile(std::ofstream &file, const std::string &className);
+    void newViewHeaderFile(std::ofstream &file,
+                           const std::string &className,
+                           const std::string &modelType,
+                           const std::string &includes);
     void newViewSourceFile(std::ofstream &file,
                            const std::string &className,
                            const std::string &namespacePrefix,
+                           const std::string &layoutName,
+                           const std::string &modelType,
+                           const std::string &includes,
                            std::ifstream &infile);
 };
 }  // namespace drogon_ctl
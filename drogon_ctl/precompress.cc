@@ -0,0 +1,202 @@
+/**
+ *
+ *  precompress.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "precompress.h"
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+using namespace drogon_ctl;
+
+std::string precompress::detail()
+{
+    return "Use precompress command to compress the static files of a "
+           "document root at deploy time,\n"
+           "so that drogon sends them with the gzip_static and br_static "
+           "options\n"
+           "Usage:drogon_ctl precompress <options> <directory> "
+           "[<directory>...]\n"
+           "  -f           compress again the files whose siblings are up to "
+           "date\n"
+           "  --no-gzip    do not make .gz siblings\n"
+           "  --no-br      do not make .br siblings\n"
+           "  -m size      the minimum size of the compressed files(default: "
+           "1024)\n"
+           "  -e ext,...   the extensions of the compressed files(default: "
+           "html,htm,js,mjs,css,json,map,xml,xsl,svg,txt,csv,wasm,ttf,otf,"
+           "eot)\n\n"
+           "A sibling is only written if it is smaller than the file.\n"
+           "example: drogon_ctl precompress -m 512 ./public\n";
+}
+
+static void outputErrorAndExit(const std::string_view &err)
+{
+    std::cerr << err << std::endl;
+    exit(1);
+}
+
+void precompress::handleCommand(std::vector<std::string> &parameters)
+{
+    std::vector<std::string> directories;
+    for (auto iter = parameters.begin(); iter != parameters.end(); ++iter)
+    {
+        auto &param = *iter;
+        if (param == "-f")
+        {
+            force_ = true;
+        }
+        else if (param == "--no-gzip")
+        {
+            gzip_ = false;
+        }
+        else if (param == "--no-br")
+        {
+            brotli_ = false;
+        }
+        else if (param == "-m")
+        {
+            ++iter;
+            if (iter == parameters.end())
+                outputErrorAndExit("No minimum size!");
+            try
+            {
+                minSize_ = std::stoull(*iter);
+            }
+            catch (...)
+            {
+                outputErrorAndExit("Invalid minimum size!");
+            }
+        }
+        else if (param == "-e")
+        {
+            ++iter;
+            if (iter == parameters.end())
+                outputErrorAndExit("No extensions!");
+            extensions_.clear();
+            for (auto &extension : utils::splitString(*iter, ","))
+            {
+                extensions_.insert(extension);
+            }
+        }
+        else if (!param.empty() && param[0] == '-')
+        {
+            outputErrorAndExit("Unknown option: " + param);
+        }
+        else
+        {
+            directories.push_back(param);
+        }
+    }
+#ifndef USE_BROTLI
+    if (brotli_)
+    {
+        std::cout << "drogon is built without brotli, no .br sibling is made"
+                  << std::endl;
+        brotli_ = false;
+    }
+#endif
+    if (directories.empty())
+        outputErrorAndExit("No directory!");
+    if (!gzip_ && !brotli_)
+        outputErrorAndExit("Nothing to do!");
+
+    for (auto &directory : directories)
+    {
+        std::error_code err;
+        std::filesystem::recursive_directory_iterator iter(
+            utils::toNativePath(directory), err);
+        if (err)
+        {
+            outputErrorAndExit("Cannot read " + directory + ": " +
+                               err.message());
+        }
+        for (auto &entry : iter)
+        {
+            if (!entry.is_regular_file(err))
+                continue;
+            auto &path = entry.path();
+            auto extension = path.extension().string();
+            if (extension.empty())
+                continue;
+            extension = extension.substr(1);
+            std::transform(extension.begin(),
+                           extension.end(),
+                           extension.begin(),
+                           [](unsigned char c) { return tolower(c); });
+            if (extensions_.find(extension) == extensions_.end())
+                continue;
+            if (entry.file_size(err) < minSize_)
+                continue;
+            compressFile(path);
+        }
+    }
+    std::cout << numOfSiblings_ << " siblings made for " << numOfFiles_
+              << " files" << std::endl;
+}
+
+void precompress::compressFile(const std::filesystem::path &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Cannot read " << path.string() << std::endl;
+        return;
+    }
+    std::string data{std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>()};
+    ++numOfFiles_;
+    if (gzip_)
+    {
+        writeSibling(path, ".gz", data, [&data]() {
+            return utils::gzipCompress(data.data(), data.length(), 9);
+        });
+    }
+    if (brotli_)
+    {
+        writeSibling(path, ".br", data, [&data]() {
+            return utils::brotliCompress(data.data(), data.length(), 11);
+        });
+    }
+}
+
+void precompress::writeSibling(const std::filesystem::path &path,
+                               const std::string &extension,
+                               const std::string &data,
+                               const std::function<std::string()> &compress)
+{
+    auto siblingPath = path;
+    siblingPath += extension;
+    std::error_code err;
+    if (!force_ && std::filesystem::exists(siblingPath, err) &&
+        std::filesystem::last_write_time(siblingPath, err) >=
+            std::filesystem::last_write_time(path, err))
+    {
+        return;
+    }
+    auto compressed = compress();
+    if (compressed.empty() || compressed.length() >= data.length())
+    {
+        // A stale sibling would be sent instead of the file
+        std::filesystem::remove(siblingPath, err);
+        return;
+    }
+    std::ofstream out(siblingPath, std::ios::binary | std::ios::trunc);
+    if (!out.write(compressed.data(),
+                   static_cast<std::streamsize>(compressed.length())))
+    {
+        std::cerr << "Cannot write " << siblingPath.string() << std::endl;
+        return;
+    }
+    ++numOfSiblings_;
+}
@@ -0,0 +1,75 @@
+/**
+ *
+ *  precompress.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "CommandHandler.h"
+#include <drogon/DrObject.h>
+#include <filesystem>
+#include <functional>
+#include <set>
+#include <string>
+
+using namespace drogon;
+
+namespace drogon_ctl
+{
+class precompress : public DrObject<precompress>, public CommandHandler
+{
+  public:
+    void handleCommand(std::vector<std::string> &parameters) override;
+
+    std::string script() override
+    {
+        return "Compress static files into .br and .gz siblings(Use "
+               "'drogon_ctl help precompress' for more information)";
+    }
+
+    bool isTopCommand() override
+    {
+        return true;
+    }
+
+    std::string detail() override;
+
+  private:
+    void compressFile(const std::filesystem::path &path);
+    void writeSibling(const std::filesystem::path &path,
+                      const std::string &extension,
+                      const std::string &data,
+                      const std::function<std::string()> &compress);
+
+    std::set<std::string> extensions_{"html",
+                                      "htm",
+                                      "js",
+                                      "mjs",
+                                      "css",
+                                      "json",
+                                      "map",
+                                      "xml",
+                                      "xsl",
+                                      "svg",
+                                      "txt",
+                                      "csv",
+                                      "wasm",
+                                      "ttf",
+                                      "otf",
+                                      "eot"};
+    bool force_{false};
+    bool gzip_{true};
+    bool brotli_{true};
+    size_t minSize_{1024};
+    size_t numOfFiles_{0};
+    size_t numOfSiblings_{0};
+};
+}  // namespace drogon_ctl
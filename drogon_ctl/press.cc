@@ -15,12 +15,15 @@
 #include "press.h"
 #include "cmd.h"
 #include <drogon/DrClassMap.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <iomanip>
+#include <iterator>
 #include <cstdlib>
 #include <json/json.h>
 #include <fstream>
+#include <random>
 #include <string>
 #include <unordered_map>
 #ifndef _WIN32
@@ -36,11 +39,65 @@ std::string press::detail()
            "  -n num    number of requests(default : 1)\n"
            "  -t num    number of threads(default : 1)\n"
            "  -c num    concurrent connections(default : 1)\n"
+           "  -r num    target requests per second of all the connections, "
+           "every\n"
+           "            connection sends its requests on a fixed schedule and "
+           "the\n"
+           "            latency is counted from the time a request was due\n"
+           "            (default : 0, send a request when the last one is "
+           "done)\n"
+           "  -j file   also write the results to a json file(default: "
+           "disable)\n"
+           "  -p num    pipelining depth of every connection(default : 0)\n"
+           "  -s file   scenario json file of weighted requests, the path of "
+           "the\n"
+           "            url is ignored(default: disable)\n"
+           "  -l file   replay a log of the TrafficCapture plugin, every "
+           "request of\n"
+           "            the log is sent once when it is due and the latency is "
+           "counted\n"
+           "            from that time, -n, -r, -s and -f are ignored"
+           "(default: disable)\n"
+           "  -x num    speed of the replay, 2 replays the log twice as fast"
+           "(default: 1)\n"
+           "  -b file   json results of an earlier run (-j) to compare the "
+           "latencies\n"
+           "            with(default: disable)\n"
            "  -k        disable SSL certificate validation(default: enable)\n"
            "  -f        customize http request json file(default: disenable)\n"
            "  -q        no progress indication(default: show)\n\n"
            "example: drogon_ctl press -n 10000 -c 100 -t 4 -q "
-           "http://localhost:8080/index.html -f ./http_request.json\n";
+           "http://localhost:8080/index.html -f ./http_request.json\n"
+           "         drogon_ctl press -n 600000 -c 100 -t 4 -r 10000 -j "
+           "results.json http://localhost:8080/index.html\n"
+           "         drogon_ctl press -n 100000 -c 50 -s ./scenario.json "
+           "http://localhost:8080\n"
+           "         drogon_ctl press -c 50 -t 4 -l ./traffic.cap -x 2 -b "
+           "before.json\n"
+           "         http://localhost:8080\n\n"
+           "A scenario file looks like:\n"
+           "{\n"
+           "    // Optional, a csv file whose first line names the columns\n"
+           "    \"csv\": \"./users.csv\",\n"
+           "    \"requests\": [\n"
+           "        {\"name\": \"home\", \"weight\": 8, \"path\": \"/\"},\n"
+           "        {\"name\": \"login\", \"weight\": 1, \"method\": "
+           "\"POST\",\n"
+           "         \"path\": \"/login\", \"header\": {\"X-Id\": "
+           "\"${uuid}\"},\n"
+           "         \"body\": {\"user\": \"${csv:name}\"}, \"think_time\": "
+           "0.5},\n"
+           "        {\"name\": \"item\", \"weight\": 4, \"path\":\n"
+           "         \"/items/${random:1:10000}\"}\n"
+           "    ]\n"
+           "}\n"
+           "The variables ${uuid}, ${random:min:max} and ${csv:column} are "
+           "replaced in\n"
+           "the path, the header values and the body of every request, a "
+           "request takes\n"
+           "the csv rows in turn. The think time in seconds pauses the "
+           "connection after\n"
+           "the response, without -r.\n";
 }
 
 void outputErrorAndExit(const std::string_view &err)
@@ -49,6 +106,47 @@ void outputErrorAndExit(const std::string_view &err)
     exit(1);
 }
 
+static drogon::HttpMethod toHttpMethod(std::string methodStr)
+{
+    std::transform(methodStr.begin(),
+                   methodStr.end(),
+                   methodStr.begin(),
+                   ::toupper);
+    if (methodStr == "GET")
+    {
+        return drogon::HttpMethod::Get;
+    }
+    else if (methodStr == "POST")
+    {
+        return drogon::HttpMethod::Post;
+    }
+    else if (methodStr == "HEAD")
+    {
+        return drogon::HttpMethod::Head;
+    }
+    else if (methodStr == "PUT")
+    {
+        return drogon::HttpMethod::Put;
+    }
+    else if (methodStr == "DELETE")
+    {
+        return drogon::HttpMethod::Delete;
+    }
+    else if (methodStr == "OPTIONS")
+    {
+        return drogon::HttpMethod::Options;
+    }
+    else if (methodStr == "PATCH")
+    {
+        return drogon::HttpMethod::Patch;
+    }
+    else
+    {
+        outputErrorAndExit("invalid method");
+    }
+    return drogon::HttpMethod::Get;
+}
+
 void press::handleCommand(std::vector<std::string> &parameters)
 {
     for (auto iter = parameters.begin(); iter != parameters.end(); iter++)
@@ -156,6 +254,180 @@ void press::handleCommand(std::vector<std::string> &parameters)
                 continue;
             }
         }
+        else if (param.find("-r") == 0)
+        {
+            if (param == "-r")
+            {
+                ++iter;
+                if (iter == parameters.end())
+                {
+                    outputErrorAndExit("No request rate!");
+                }
+                auto &num = *iter;
+                try
+                {
+                    requestsPerSecond_ = std::stod(num);
+                }
+                catch (...)
+                {
+                    outputErrorAndExit("Invalid request rate!");
+                }
+                continue;
+            }
+            else
+            {
+                auto num = param.substr(2);
+                try
+                {
+                    requestsPerSecond_ = std::stod(num);
+                }
+                catch (...)
+                {
+                    outputErrorAndExit("Invalid request rate!");
+                }
+                continue;
+            }
+        }
+        else if (param.find("-j") == 0)
+        {
+            if (param == "-j")
+            {
+                ++iter;
+                if (iter == parameters.end())
+                {
+                    outputErrorAndExit("No json output file!");
+                }
+                jsonOutputFile_ = *iter;
+                continue;
+            }
+            else
+            {
+                jsonOutputFile_ = param.substr(2);
+                continue;
+            }
+        }
+        else if (param.find("-p") == 0)
+        {
+            if (param == "-p")
+            {
+                ++iter;
+                if (iter == parameters.end())
+                {
+                    outputErrorAndExit("No pipelining depth!");
+                }
+                auto &num = *iter;
+                try
+                {
+                    pipeliningDepth_ = std::stoll(num);
+                }
+                catch (...)
+                {
+                    outputErrorAndExit("Invalid pipelining depth!");
+                }
+                continue;
+            }
+            else
+            {
+                auto num = param.substr(2);
+                try
+                {
+                    pipeliningDepth_ = std::stoll(num);
+                }
+                catch (...)
+                {
+                    outputErrorAndExit("Invalid pipelining depth!");
+                }
+                continue;
+            }
+        }
+        else if (param.find("-s") == 0)
+        {
+            if (param == "-s")
+            {
+                ++iter;
+                if (iter == parameters.end())
+                {
+                    outputErrorAndExit("No scenario file!");
+                }
+                scenarioFile_ = *iter;
+                continue;
+            }
+            else
+            {
+                scenarioFile_ = param.substr(2);
+                continue;
+            }
+        }
+        else if (param.find("-l") == 0)
+        {
+            if (param == "-l")
+            {
+                ++iter;
+                if (iter == parameters.end())
+                {
+                    outputErrorAndExit("No traffic capture file!");
+                }
+                replayFile_ = *iter;
+                continue;
+            }
+            else
+            {
+                replayFile_ = param.substr(2);
+                continue;
+            }
+        }
+        else if (param.find("-x") == 0)
+        {
+            if (param == "-x")
+            {
+                ++iter;
+                if (iter == parameters.end())
+                {
+                    outputErrorAndExit("No replay speed!");
+                }
+                auto &num = *iter;
+                try
+                {
+                    replaySpeed_ = std::stod(num);
+                }
+                catch (...)
+                {
+                    outputErrorAndExit("Invalid replay speed!");
+                }
+                continue;
+            }
+            else
+            {
+                auto num = param.substr(2);
+                try
+                {
+                    replaySpeed_ = std::stod(num);
+                }
+                catch (...)
+                {
+                    outputErrorAndExit("Invalid replay speed!");
+                }
+                continue;
+            }
+        }
+        else if (param.find("-b") == 0)
+        {
+            if (param == "-b")
+            {
+                ++iter;
+                if (iter == parameters.end())
+                {
+                    outputErrorAndExit("No baseline file!");
+                }
+                baselineFile_ = *iter;
+                continue;
+            }
+            else
+            {
+                baselineFile_ = param.substr(2);
+                continue;
+            }
+        }
         else if (param.find("-f") == 0)
         {
             if (param == "-f")
@@ -193,6 +465,14 @@ void press::handleCommand(std::vector<std::string> &parameters)
     // std::cout << "c=" << numOfConnections_ << std::endl;
     // std::cout << "q=" << processIndication_ << std::endl;
     // std::cout << "url=" << url_ << std::endl;
+    if (requestsPerSecond_ < 0)
+    {
+        outputErrorAndExit("Invalid request rate!");
+    }
+    if (replaySpeed_ <= 0)
+    {
+        outputErrorAndExit("Invalid replay speed!");
+    }
     if (url_.empty() || url_.compare(0, 4, "http") != 0 ||
         (url_.compare(4, 3, "://") != 0 && url_.compare(4, 4, "s://") != 0))
     {
@@ -243,47 +523,7 @@ void press::handleCommand(std::vector<std::string> &parameters)
             outputErrorAndExit("No contain method");
         }
 
-        auto methodStr = httpRequestJson["method"].asString();
-        std::transform(methodStr.begin(),
-                       methodStr.end(),
-                       methodStr.begin(),
-                       ::toupper);
-
-        auto toHttpMethod = [&]() -> drogon::HttpMethod {
-            if (methodStr == "GET")
-            {
-                return drogon::HttpMethod::Get;
-            }
-            else if (methodStr == "POST")
-            {
-                return drogon::HttpMethod::Post;
-            }
-            else if (methodStr == "HEAD")
-            {
-                return drogon::HttpMethod::Head;
-            }
-            else if (methodStr == "PUT")
-            {
-                return drogon::HttpMethod::Put;
-            }
-            else if (methodStr == "DELETE")
-            {
-                return drogon::HttpMethod::Delete;
-            }
-            else if (methodStr == "OPTIONS")
-            {
-                return drogon::HttpMethod::Options;
-            }
-            else if (methodStr == "PATCH")
-            {
-                return drogon::HttpMethod::Patch;
-            }
-            else
-            {
-                outputErrorAndExit("invalid method");
-            }
-            return drogon::HttpMethod::Get;
-        };
+        auto method = toHttpMethod(httpRequestJson["method"].asString());
 
         std::unordered_map<std::string, std::string> header;
         if (httpRequestJson.isMember("header"))
@@ -310,7 +550,7 @@ void press::handleCommand(std::vector<std::string> &parameters)
         }
 
         createHttpRequestFunc_ = [this,
-                                  method = toHttpMethod(),
+                                  method,
                                   body = std::move(body),
                                   header =
                                       std::move(header)]() -> HttpRequestPtr {
@@ -325,11 +565,265 @@ void press::handleCommand(std::vector<std::string> &parameters)
         };
     }
 
+    if (!replayFile_.empty())
+    {
+        loadReplay();
+    }
+    else if (!scenarioFile_.empty())
+    {
+        loadScenario();
+    }
+
     // std::cout << "host=" << host_ << std::endl;
     // std::cout << "path=" << path_ << std::endl;
     doTesting();
 }
 
+void press::loadScenario()
+{
+    Json::Value scenario;
+    std::ifstream file(scenarioFile_, std::ifstream::binary);
+    if (!file.is_open())
+    {
+        outputErrorAndExit(std::string{"No "} + scenarioFile_);
+    }
+    Json::CharReaderBuilder builder;
+    builder["allowComments"] = true;
+    std::string errs;
+    if (!Json::parseFromStream(builder, file, &scenario, &errs))
+    {
+        outputErrorAndExit(scenarioFile_ + ": " + errs);
+    }
+    if (scenario.isMember("csv"))
+    {
+        loadCsv(scenario["csv"].asString());
+    }
+    const auto &requests = scenario["requests"];
+    if (!requests.isArray() || requests.empty())
+    {
+        outputErrorAndExit("No requests in the scenario file");
+    }
+    double totalWeight = 0;
+    for (const auto &item : requests)
+    {
+        auto endpoint = std::make_unique<Endpoint>();
+        endpoint->path_ = item.get("path", "/").asString();
+        endpoint->name_ = item.get("name", endpoint->path_).asString();
+        endpoint->weight_ = item.get("weight", 1).asDouble();
+        endpoint->method_ = toHttpMethod(item.get("method", "GET").asString());
+        endpoint->thinkTime_ = item.get("think_time", 0).asDouble();
+        if (endpoint->weight_ <= 0)
+        {
+            continue;
+        }
+        const auto &header = item["header"];
+        for (const auto &key : header.getMemberNames())
+        {
+            endpoint->headers_.emplace_back(key,
+                                            header[key].isString()
+                                                ? header[key].asString()
+                                                : header[key].toStyledString());
+        }
+        if (item["body"].isString())
+        {
+            endpoint->body_ = item["body"].asString();
+        }
+        else if (!item["body"].isNull())
+        {
+            Json::FastWriter fastWriter;
+            endpoint->body_ = fastWriter.write(item["body"]);
+        }
+        totalWeight += endpoint->weight_;
+        cumulativeWeights_.push_back(totalWeight);
+        endpoints_.push_back(std::move(endpoint));
+    }
+    if (endpoints_.empty())
+    {
+        outputErrorAndExit("No requests in the scenario file");
+    }
+}
+
+void press::loadCsv(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        outputErrorAndExit(std::string{"No "} + path);
+    }
+    // Plain comma separated values, quoting isn't supported
+    auto split = [](std::string line) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        return utils::splitString(line, ",", true);
+    };
+    std::string line;
+    if (!std::getline(file, line))
+    {
+        outputErrorAndExit(path + " is empty");
+    }
+    csvColumns_ = split(line);
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line == "\r")
+            continue;
+        auto row = split(line);
+        row.resize(csvColumns_.size());
+        csvRows_.push_back(std::move(row));
+    }
+}
+
+void press::loadReplay()
+{
+    std::ifstream file(replayFile_, std::ifstream::binary);
+    if (!file.is_open())
+    {
+        outputErrorAndExit(std::string{"No "} + replayFile_);
+    }
+    std::string log((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+    auto magic = drogon::plugin::TrafficCapture::fileMagic();
+    if (log.compare(0, magic.size(), magic) != 0)
+    {
+        outputErrorAndExit(replayFile_ + " is not a traffic capture");
+    }
+    std::string_view rest(log);
+    rest.remove_prefix(magic.size());
+    // The latencies are reported by method and path, the paths beyond the
+    // first ones are counted together.
+    constexpr size_t maxEndpoints = 50;
+    std::unordered_map<std::string, size_t> endpointIndexes;
+    auto endpointOf = [this, &endpointIndexes](std::string name) {
+        auto iter = endpointIndexes.find(name);
+        if (iter == endpointIndexes.end() &&
+            endpoints_.size() + 1 >= maxEndpoints)
+        {
+            name = "other";
+            iter = endpointIndexes.find(name);
+        }
+        if (iter != endpointIndexes.end())
+        {
+            return iter->second;
+        }
+        auto endpoint = std::make_unique<Endpoint>();
+        endpoint->name_ = name;
+        endpoints_.push_back(std::move(endpoint));
+        endpointIndexes.emplace(std::move(name), endpoints_.size() - 1);
+        return endpoints_.size() - 1;
+    };
+    double dueTime = 0;
+    while (!rest.empty())
+    {
+        drogon::plugin::TrafficCapture::Record record;
+        auto size = drogon::plugin::TrafficCapture::decode(rest, record);
+        if (size == 0)
+        {
+            // The capture was stopped while writing
+            std::cout << "The last " << rest.size() << " bytes of "
+                      << replayFile_ << " are ignored" << std::endl;
+            break;
+        }
+        rest.remove_prefix(size);
+        dueTime += static_cast<double>(record.gap) / replaySpeed_;
+        replayDueTimes_.push_back(static_cast<int64_t>(dueTime));
+        replayEndpoints_.push_back(endpointOf(
+            std::string(to_string_view(record.method)) + " " + record.path));
+        replayRecords_.push_back(std::move(record));
+    }
+    if (replayRecords_.empty())
+    {
+        outputErrorAndExit(std::string{"No requests in "} + replayFile_);
+    }
+    numOfRequests_ = replayRecords_.size();
+}
+
+size_t press::pickEndpoint()
+{
+    if (endpoints_.size() == 1)
+        return 0;
+    thread_local std::mt19937_64 generator{std::random_device{}()};
+    std::uniform_real_distribution<double> distribution(
+        0, cumulativeWeights_.back());
+    auto point = distribution(generator);
+    auto iter = std::upper_bound(cumulativeWeights_.begin(),
+                                 cumulativeWeights_.end(),
+                                 point);
+    return (std::min)(static_cast<size_t>(iter - cumulativeWeights_.begin()),
+                      endpoints_.size() - 1);
+}
+
+HttpRequestPtr press::newRequest(const Endpoint &endpoint)
+{
+    // All the csv variables of a request come from the same row
+    size_t row = csvRows_.empty() ? 0 : nextCsvRow_++ % csvRows_.size();
+    auto request = HttpRequest::newHttpRequest();
+    request->setMethod(endpoint.method_);
+    request->setPath(expandVariables(endpoint.path_, row));
+    for (const auto &[field, val] : endpoint.headers_)
+        request->addHeader(field, expandVariables(val, row));
+    if (!endpoint.body_.empty())
+        request->setBody(expandVariables(endpoint.body_, row));
+    return request;
+}
+
+std::string press::expandVariables(const std::string &text, size_t row) const
+{
+    auto pos = text.find("${");
+    if (pos == std::string::npos)
+        return text;
+    thread_local std::mt19937_64 generator{std::random_device{}()};
+    std::string result;
+    size_t last = 0;
+    for (; pos != std::string::npos; pos = text.find("${", last))
+    {
+        auto end = text.find('}', pos + 2);
+        if (end == std::string::npos)
+            break;
+        result.append(text, last, pos - last);
+        last = end + 1;
+        std::string_view name(text.data() + pos + 2, end - pos - 2);
+        if (name == "uuid")
+        {
+            result.append(utils::getUuid());
+        }
+        else if (name.substr(0, 7) == "random:")
+        {
+            auto bounds = utils::splitString(std::string(name.substr(7)), ":");
+            int64_t min = 0, max = 0;
+            try
+            {
+                min = bounds.size() == 2 ? std::stoll(bounds[0]) : 0;
+                max = std::stoll(bounds.back());
+            }
+            catch (...)
+            {
+                outputErrorAndExit("Invalid variable " + std::string(name));
+            }
+            if (max < min)
+                std::swap(min, max);
+            std::uniform_int_distribution<int64_t> distribution(min, max);
+            result.append(std::to_string(distribution(generator)));
+        }
+        else if (name.substr(0, 4) == "csv:")
+        {
+            auto column = std::find(csvColumns_.begin(),
+                                    csvColumns_.end(),
+                                    name.substr(4));
+            if (column == csvColumns_.end() || csvRows_.empty())
+            {
+                outputErrorAndExit("Unknown variable " + std::string(name));
+            }
+            result.append(csvRows_[row][column - csvColumns_.begin()]);
+        }
+        else
+        {
+            // Not a variable, kept as it is
+            result.append(text, pos, last - pos);
+        }
+    }
+    result.append(text, last, std::string::npos);
+    return result;
+}
+
 void press::doTesting()
 {
     createRequestAndClients();
@@ -338,9 +832,40 @@ void press::doTesting()
         outputErrorAndExit("No connection!");
     }
     statistics_.startDate_ = trantor::Date::now();
-    for (auto &client : clients_)
+    if (!replayRecords_.empty())
+    {
+        replayStart_ = statistics_.startDate_.microSecondsSinceEpoch();
+        for (size_t i = 0; i < clients_.size(); ++i)
+        {
+            clients_[i]->getLoop()->queueInLoop(
+                [this, i]() { sendReplayRequests(i, i); });
+        }
+        loopPool_->wait();
+        return;
+    }
+    if (requestsPerSecond_ > 0)
     {
-        sendRequest(client);
+        // Every connection takes its share of the rate, the connections are
+        // staggered so the requests are spread evenly.
+        auto start = statistics_.startDate_.microSecondsSinceEpoch();
+        auto gap = 1000000.0 / requestsPerSecond_;
+        interval_ = (std::max)(static_cast<int64_t>(gap * clients_.size()),
+                               int64_t(1));
+        nextSendTimes_.resize(clients_.size());
+        for (size_t i = 0; i < clients_.size(); ++i)
+        {
+            nextSendTimes_[i] = start + static_cast<int64_t>(gap * i);
+        }
+    }
+    // With pipelining every connection keeps that many requests in flight
+    auto requestsPerConnection = (std::max)(pipeliningDepth_, size_t(1));
+    for (size_t i = 0; i < clients_.size(); ++i)
+    {
+        for (size_t n = 0; n < requestsPerConnection; ++n)
+        {
+            clients_[i]->getLoop()->queueInLoop(
+                [this, i]() { sendNextRequest(i); });
+        }
     }
     loopPool_->wait();
 }
@@ -356,11 +881,37 @@ void press::createRequestAndClients()
                                                 false,
                                                 certValidation_);
         client->enableCookies();
+        client->setPipeliningDepth(pipeliningDepth_);
         clients_.push_back(client);
     }
 }
 
-void press::sendRequest(const HttpClientPtr &client)
+void press::sendNextRequest(size_t index)
+{
+    if (interval_ == 0)
+    {
+        sendRequest(index, 0);
+        return;
+    }
+    // The open-loop mode, like wrk2: a request is sent when it is due, or at
+    // once if the connection was busy then. Counting the latency from the
+    // due time charges the wait to the server, so a stall shows up in the
+    // latencies of all the requests it delayed (coordinated omission).
+    auto intendedTime = nextSendTimes_[index];
+    nextSendTimes_[index] += interval_;
+    auto wait = intendedTime - trantor::Date::now().microSecondsSinceEpoch();
+    if (wait <= 0)
+    {
+        sendRequest(index, intendedTime);
+        return;
+    }
+    clients_[index]->getLoop()->runAfter(static_cast<double>(wait) / 1000000,
+                                         [this, index, intendedTime]() {
+                                             sendRequest(index, intendedTime);
+                                         });
+}
+
+void press::sendRequest(size_t index, int64_t intendedTime)
 {
     auto numOfRequest = statistics_.numOfRequestsSent_++;
     if (numOfRequest >= numOfRequests_)
@@ -369,7 +920,13 @@ void press::sendRequest(const HttpClientPtr &client)
     }
 
     HttpRequestPtr request;
-    if (createHttpRequestFunc_)
+    Endpoint *endpoint = nullptr;
+    if (!endpoints_.empty())
+    {
+        endpoint = endpoints_[pickEndpoint()].get();
+        request = newRequest(*endpoint);
+    }
+    else if (createHttpRequestFunc_)
     {
         request = createHttpRequestFunc_();
     }
@@ -379,56 +936,147 @@ void press::sendRequest(const HttpClientPtr &client)
         request->setPath(path_);
         request->setMethod(Get);
     }
+    if (intendedTime == 0)
+    {
+        intendedTime = request->creationDate().microSecondsSinceEpoch();
+    }
 
     // std::cout << "send!" << std::endl;
+    const auto &client = clients_[index];
     client->sendRequest(
         request,
-        [this, client, request](ReqResult r, const HttpResponsePtr &resp) {
-            size_t goodNum, badNum;
-            if (r == ReqResult::Ok)
-            {
-                // std::cout << "OK" << std::endl;
-                goodNum = ++statistics_.numOfGoodResponse_;
-                badNum = statistics_.numOfBadResponse_;
-                statistics_.bytesRecieved_ += resp->body().length();
-                auto delay = trantor::Date::now().microSecondsSinceEpoch() -
-                             request->creationDate().microSecondsSinceEpoch();
-                statistics_.totalDelay_ += delay;
-            }
-            else
+        [this, client, index, intendedTime, endpoint](
+            ReqResult r, const HttpResponsePtr &resp) {
+            countResponse(r, resp, intendedTime, endpoint);
+            if (r == ReqResult::Ok && endpoint && endpoint->thinkTime_ > 0 &&
+                interval_ == 0)
             {
-                goodNum = statistics_.numOfGoodResponse_;
-                badNum = ++statistics_.numOfBadResponse_;
-                if (badNum > numOfRequests_ / 10)
-                {
-                    outputErrorAndExit("Too many errors");
-                }
-            }
-            if (goodNum + badNum >= numOfRequests_)
-            {
-                outputResults();
+                client->getLoop()->runAfter(endpoint->thinkTime_,
+                                            [this, index]() {
+                                                sendNextRequest(index);
+                                            });
             }
-            if (r == ReqResult::Ok)
-                sendRequest(client);
+            else if (r == ReqResult::Ok)
+                sendNextRequest(index);
             else
             {
-                client->getLoop()->runAfter(1, [this, client]() {
-                    sendRequest(client);
+                client->getLoop()->runAfter(1, [this, index]() {
+                    sendNextRequest(index);
                 });
             }
-
-            if (processIndication_)
-            {
-                auto rec = goodNum + badNum;
-                if (rec % 100000 == 0)
-                {
-                    std::cout << rec << " responses are received" << std::endl
-                              << std::endl;
-                }
-            }
         });
 }
 
+void press::sendReplayRequests(size_t index, size_t next)
+{
+    // The requests which are due are sent without waiting for the responses,
+    // the connection queues them if it is busy.
+    for (; next < replayRecords_.size(); next += clients_.size())
+    {
+        auto intendedTime = replayStart_ + replayDueTimes_[next];
+        auto wait =
+            intendedTime - trantor::Date::now().microSecondsSinceEpoch();
+        if (wait > 0)
+        {
+            clients_[index]->getLoop()->runAfter(
+                static_cast<double>(wait) / 1000000, [this, index, next]() {
+                    sendReplayRequests(index, next);
+                });
+            return;
+        }
+        sendReplayRequest(index, next, intendedTime);
+    }
+}
+
+void press::sendReplayRequest(size_t index,
+                              size_t record,
+                              int64_t intendedTime)
+{
+    ++statistics_.numOfRequestsSent_;
+    const auto &captured = replayRecords_[record];
+    auto request = HttpRequest::newHttpRequest();
+    request->setMethod(captured.method);
+    // The query is sent as it was received
+    request->setPathEncode(false);
+    if (captured.query.empty())
+        request->setPath(utils::urlEncode(captured.path));
+    else
+        request->setPath(utils::urlEncode(captured.path) + "?" +
+                         captured.query);
+    for (const auto &[field, val] : captured.headers)
+    {
+        // Set by the client for its own connection
+        if (field == "host" || field == "content-length" ||
+            field == "connection" || field == "transfer-encoding" ||
+            field == "keep-alive" || field == "upgrade" || field == "expect")
+            continue;
+        if (field == "content-type")
+            request->setContentTypeString(val);
+        else
+            request->addHeader(field, val);
+    }
+    if (!captured.body.empty())
+        request->setBody(captured.body);
+    auto endpoint = endpoints_[replayEndpoints_[record]].get();
+    clients_[index]->sendRequest(request,
+                                 [this, intendedTime, endpoint](
+                                     ReqResult r, const HttpResponsePtr &resp) {
+                                     countResponse(r,
+                                                   resp,
+                                                   intendedTime,
+                                                   endpoint);
+                                 });
+}
+
+void press::countResponse(ReqResult r,
+                          const HttpResponsePtr &resp,
+                          int64_t intendedTime,
+                          Endpoint *endpoint)
+{
+    size_t goodNum, badNum;
+    if (r == ReqResult::Ok)
+    {
+        // std::cout << "OK" << std::endl;
+        goodNum = ++statistics_.numOfGoodResponse_;
+        badNum = statistics_.numOfBadResponse_;
+        statistics_.bytesRecieved_ += resp->body().length();
+        auto now = trantor::Date::now().microSecondsSinceEpoch();
+        auto delay = now - intendedTime;
+        statistics_.totalDelay_ += delay;
+        statistics_.delays_.observe(static_cast<double>(delay) / 1000);
+        if (endpoint)
+        {
+            ++endpoint->numOfGoodResponse_;
+            endpoint->delays_.observe(static_cast<double>(delay) / 1000);
+        }
+    }
+    else
+    {
+        if (endpoint)
+            ++endpoint->numOfBadResponse_;
+        goodNum = statistics_.numOfGoodResponse_;
+        badNum = ++statistics_.numOfBadResponse_;
+        if (badNum > numOfRequests_ / 10)
+        {
+            outputErrorAndExit("Too many errors");
+        }
+    }
+    if (goodNum + badNum >= numOfRequests_)
+    {
+        outputResults();
+    }
+
+    if (processIndication_)
+    {
+        auto rec = goodNum + badNum;
+        if (rec % 100000 == 0)
+        {
+            std::cout << rec << " responses are received" << std::endl
+                      << std::endl;
+        }
+    }
+}
+
 void press::outputResults()
 {
     size_t totalSent = 0;
@@ -464,9 +1112,178 @@ void press::outputResults()
                      statistics_.numOfGoodResponse_ / 1000
               << " ms avg req time" << std::endl;
 
+    auto delays = statistics_.delays_.sketch();
+    std::cout << "LATENCY:  " << delays.quantile(0.5) << " ms p50, "
+              << delays.quantile(0.9) << " ms p90, " << delays.quantile(0.99)
+              << " ms p99, " << delays.quantile(0.999) << " ms p99.9, "
+              << delays.quantile(1) << " ms max" << std::endl;
+
+    if (requestsPerSecond_ > 0)
+    {
+        std::cout << "LATENCY:  counted from the due time of the requests, "
+                  << requestsPerSecond_ << " rps target" << std::endl;
+    }
+    else if (!replayRecords_.empty())
+    {
+        std::cout << "LATENCY:  counted from the due time of the requests, "
+                  << replayFile_ << " replayed at " << replaySpeed_ << "x"
+                  << std::endl;
+    }
+
+    for (const auto &endpoint : endpoints_)
+    {
+        auto endpointDelays = endpoint->delays_.sketch();
+        std::cout << "ENDPOINT: " << endpoint->name_ << ", "
+                  << endpoint->numOfGoodResponse_ << " success, "
+                  << endpoint->numOfBadResponse_ << " fail, "
+                  << endpointDelays.quantile(0.5) << " ms p50, "
+                  << endpointDelays.quantile(0.99) << " ms p99, "
+                  << endpointDelays.quantile(1) << " ms max" << std::endl;
+    }
+
     std::cout << "SPEED:    download " << totalRecv / seconds / 1000
               << " kBps, upload " << totalSent / seconds / 1000 << " kBps"
               << std::endl
               << std::endl;
+    if (jsonOutputFile_.empty() && baselineFile_.empty())
+    {
+        exit(0);
+    }
+    auto results = jsonResults(seconds, totalSent, totalRecv);
+    if (!baselineFile_.empty())
+    {
+        auto comparison = compareWithBaseline(results);
+        for (const auto &key : comparison.getMemberNames())
+        {
+            const auto &item = comparison[key];
+            std::cout << "COMPARE:  " << key << " "
+                      << item["baseline"].asDouble() << " -> "
+                      << item["current"].asDouble() << " ("
+                      << std::showpos << item["change"].asDouble() * 100
+                      << std::noshowpos << "%)" << std::endl;
+        }
+        std::cout << std::endl;
+        results["comparison"] = std::move(comparison);
+    }
+    if (!jsonOutputFile_.empty())
+    {
+        std::ofstream file(jsonOutputFile_);
+        if (!file.is_open())
+        {
+            outputErrorAndExit(std::string{"Can't write "} + jsonOutputFile_);
+        }
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "    ";
+        file << Json::writeString(builder, results) << std::endl;
+    }
     exit(0);
 }
+
+Json::Value press::jsonResults(double seconds,
+                               size_t totalSent,
+                               size_t totalRecv) const
+{
+    Json::Value results;
+    results["url"] = url_;
+    results["threads"] = static_cast<Json::UInt64>(numOfThreads_);
+    results["connections"] = static_cast<Json::UInt64>(numOfConnections_);
+    results["requests"] = static_cast<Json::UInt64>(numOfRequests_);
+    results["target_rps"] = requestsPerSecond_;
+    results["success"] =
+        static_cast<Json::UInt64>(statistics_.numOfGoodResponse_.load());
+    results["fail"] =
+        static_cast<Json::UInt64>(statistics_.numOfBadResponse_.load());
+    results["seconds"] = seconds;
+    results["rps"] =
+        static_cast<double>(statistics_.numOfGoodResponse_) / seconds;
+    results["body_bytes"] =
+        static_cast<Json::UInt64>(statistics_.bytesRecieved_.load());
+    results["received_bytes"] = static_cast<Json::UInt64>(totalRecv);
+    results["sent_bytes"] = static_cast<Json::UInt64>(totalSent);
+
+    // In milliseconds
+    auto &latency = results["latency"];
+    auto delays = statistics_.delays_.sketch();
+    latency["avg"] = static_cast<double>(statistics_.totalDelay_) /
+                     statistics_.numOfGoodResponse_ / 1000;
+    latency["p50"] = delays.quantile(0.5);
+    latency["p90"] = delays.quantile(0.9);
+    latency["p99"] = delays.quantile(0.99);
+    latency["p99.9"] = delays.quantile(0.999);
+    latency["max"] = delays.quantile(1);
+
+    auto &endpoints = results["endpoints"];
+    endpoints = Json::Value(Json::arrayValue);
+    for (const auto &endpoint : endpoints_)
+    {
+        Json::Value item;
+        auto endpointDelays = endpoint->delays_.sketch();
+        item["name"] = endpoint->name_;
+        item["success"] =
+            static_cast<Json::UInt64>(endpoint->numOfGoodResponse_.load());
+        item["fail"] =
+            static_cast<Json::UInt64>(endpoint->numOfBadResponse_.load());
+        item["latency"]["p50"] = endpointDelays.quantile(0.5);
+        item["latency"]["p90"] = endpointDelays.quantile(0.9);
+        item["latency"]["p99"] = endpointDelays.quantile(0.99);
+        item["latency"]["p99.9"] = endpointDelays.quantile(0.999);
+        item["latency"]["max"] = endpointDelays.quantile(1);
+        endpoints.append(std::move(item));
+    }
+    return results;
+}
+
+Json::Value press::compareWithBaseline(const Json::Value &results) const
+{
+    std::ifstream file(baselineFile_);
+    if (!file.is_open())
+    {
+        outputErrorAndExit(std::string{"Can't read "} + baselineFile_);
+    }
+    Json::Value baseline;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    if (!Json::parseFromStream(builder, file, &baseline, &errors))
+    {
+        outputErrorAndExit(baselineFile_ + ": " + errors);
+    }
+
+    // Keyed by the name of the figure, the change is relative to the baseline
+    Json::Value comparison(Json::objectValue);
+    auto compare = [&comparison](const std::string &key,
+                                 const Json::Value &before,
+                                 const Json::Value &after) {
+        if (!before.isNumeric() || !after.isNumeric())
+            return;
+        auto &item = comparison[key];
+        item["baseline"] = before.asDouble();
+        item["current"] = after.asDouble();
+        item["change"] = before.asDouble() == 0
+                             ? 0.0
+                             : after.asDouble() / before.asDouble() - 1;
+    };
+    static const char *quantiles[] = {"p50", "p90", "p99", "p99.9", "max"};
+    compare("rps", baseline["rps"], results["rps"]);
+    for (auto quantile : quantiles)
+    {
+        compare(std::string{"latency "} + quantile,
+                baseline["latency"][quantile],
+                results["latency"][quantile]);
+    }
+    // The endpoints are matched by name
+    for (const auto &before : baseline["endpoints"])
+    {
+        for (const auto &after : results["endpoints"])
+        {
+            if (after["name"] != before["name"])
+                continue;
+            for (auto quantile : quantiles)
+            {
+                compare(before["name"].asString() + " latency " + quantile,
+                        before["latency"][quantile],
+                        after["latency"][quantile]);
+            }
+        }
+    }
+    return comparison;
+}
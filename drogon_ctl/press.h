@@ -18,6 +18,8 @@
 #include <drogon/DrObject.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/HttpClient.h>
+#include <drogon/plugins/TrafficCapture.h>
+#include <drogon/utils/monitoring/Summary.h>
 #include <trantor/utils/Date.h>
 #include <trantor/net/EventLoopThreadPool.h>
 #include <functional>
@@ -37,10 +39,30 @@ struct Statistics
     std::atomic_size_t numOfGoodResponse_{0};
     std::atomic_size_t numOfBadResponse_{0};
     std::atomic_size_t totalDelay_{0};
+    // In milliseconds
+    drogon::monitoring::Summary delays_{"delay", {}, {}};
     trantor::Date startDate_;
     trantor::Date endDate_;
 };
 
+// A request template of a scenario file
+struct Endpoint
+{
+    std::string name_;
+    double weight_{1};
+    drogon::HttpMethod method_{drogon::Get};
+    // The path, the header values and the body may contain variables
+    std::string path_;
+    std::vector<std::pair<std::string, std::string>> headers_;
+    std::string body_;
+    // In seconds, the pause of the connection after the response
+    double thinkTime_{0};
+    std::atomic_size_t numOfGoodResponse_{0};
+    std::atomic_size_t numOfBadResponse_{0};
+    // In milliseconds
+    drogon::monitoring::Summary delays_{"delay", {}, {}};
+};
+
 class press : public DrObject<press>, public CommandHandler
 {
   public:
@@ -63,6 +85,29 @@ class press : public DrObject<press>, public CommandHandler
     size_t numOfThreads_{1};
     size_t numOfRequests_{1};
     size_t numOfConnections_{1};
+    // The target rate of the open-loop mode, 0 for the closed-loop mode
+    double requestsPerSecond_{0};
+    // The interval between the requests of a connection in microseconds
+    int64_t interval_{0};
+    std::string jsonOutputFile_;
+    size_t pipeliningDepth_{0};
+    std::string scenarioFile_;
+    std::vector<std::unique_ptr<Endpoint>> endpoints_;
+    std::vector<double> cumulativeWeights_;
+    std::vector<std::string> csvColumns_;
+    std::vector<std::vector<std::string>> csvRows_;
+    std::atomic_size_t nextCsvRow_{0};
+    // The traffic capture replayed, the requests are sent when they are due
+    // and dealt to the connections in turn
+    std::string replayFile_;
+    double replaySpeed_{1};
+    std::vector<drogon::plugin::TrafficCapture::Record> replayRecords_;
+    // In microseconds since the start, scaled by the speed
+    std::vector<int64_t> replayDueTimes_;
+    std::vector<size_t> replayEndpoints_;
+    int64_t replayStart_{0};
+    // The json results of an earlier run to compare the latencies with
+    std::string baselineFile_;
     std::string httpRequestJsonFile_;
     std::function<HttpRequestPtr()> createHttpRequestFunc_;
     bool certValidation_{true};
@@ -70,12 +115,32 @@ class press : public DrObject<press>, public CommandHandler
     std::string url_;
     std::string host_;
     std::string path_;
+    void loadScenario();
+    void loadCsv(const std::string &path);
+    void loadReplay();
+    size_t pickEndpoint();
+    HttpRequestPtr newRequest(const Endpoint &endpoint);
+    std::string expandVariables(const std::string &text, size_t row) const;
     void doTesting();
     void createRequestAndClients();
-    void sendRequest(const HttpClientPtr &client);
+    void sendNextRequest(size_t index);
+    void sendRequest(size_t index, int64_t intendedTime);
+    void sendReplayRequests(size_t index, size_t next);
+    void sendReplayRequest(size_t index, size_t record, int64_t intendedTime);
+    void countResponse(ReqResult result,
+                       const HttpResponsePtr &resp,
+                       int64_t intendedTime,
+                       Endpoint *endpoint);
     void outputResults();
+    Json::Value jsonResults(double seconds,
+                            size_t totalSent,
+                            size_t totalRecv) const;
+    Json::Value compareWithBaseline(const Json::Value &results) const;
     std::unique_ptr<trantor::EventLoopThreadPool> loopPool_;
     std::vector<HttpClientPtr> clients_;
+    // The time the next request of every connection is due in the open-loop
+    // mode, only touched in the loop of the connection
+    std::vector<int64_t> nextSendTimes_;
     Statistics statistics_;
 };
 }  // namespace drogon_ctl
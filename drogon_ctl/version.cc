@@ -53,6 +53,11 @@ void version::handleCommand(std::vector<std::string> &parameters)
 #else
     std::cout << "  brotli: no\n";
 #endif
+#ifdef USE_ZSTD
+    std::cout << "  zstd: yes\n";
+#else
+    std::cout << "  zstd: no\n";
+#endif
 #ifdef USE_REDIS
     std::cout << "  hiredis: yes\n";
 #else
@@ -190,8 +190,10 @@ void Chat::handleNewConnection(const HttpRequestPtr &req,
             }
             std::shared_ptr<ClientContext> context =
                 std::make_shared<ClientContext>();
+            // All the users share one subscriber connection, messages are
+            // delivered in the IO loop of the websocket connection.
             context->subscriber_ =
-                drogon::app().getRedisClient()->newSubscriber();
+                drogon::app().getRedisClient()->newSharedSubscriber();
             context->name_ = name;
             context->loginKey_ = loginKey;
             wsConnPtr->setContext(context);
@@ -0,0 +1,206 @@
+// Measures the memory an idle WebSocket connection costs the server.
+//
+// Start the server:
+//     ./websocket_memory_benchmark server
+// Then open the idle connections from another process (raise "ulimit -n" in
+// both shells first):
+//     ./websocket_memory_benchmark client 10000
+// The client reports the resident memory the server gained per connection.
+
+#include <drogon/WebSocketClient.h>
+#include <drogon/WebSocketController.h>
+#include <drogon/HttpAppFramework.h>
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr uint16_t kPort = 8849;
+// The handshakes in progress at once
+constexpr size_t kConcurrency = 256;
+
+std::atomic<size_t> serverConnections{0};
+
+// The resident set of the process in bytes, from procfs
+long residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = -1;
+    if (!(statm >> size >> resident))
+        return -1;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+}  // namespace
+
+class IdleSocket : public drogon::WebSocketController<IdleSocket>
+{
+  public:
+    void handleNewMessage(const WebSocketConnectionPtr &,
+                          std::string &&,
+                          const WebSocketMessageType &) override
+    {
+    }
+
+    void handleConnectionClosed(const WebSocketConnectionPtr &) override
+    {
+        --serverConnections;
+    }
+
+    void handleNewConnection(const HttpRequestPtr &,
+                             const WebSocketConnectionPtr &) override
+    {
+        ++serverConnections;
+    }
+
+    WS_PATH_LIST_BEGIN
+    WS_PATH_ADD("/idle", Get);
+    WS_PATH_LIST_END
+};
+
+static void runServer()
+{
+    app().registerHandler(
+        "/stats",
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            Json::Value stats;
+            stats["connections"] =
+                static_cast<Json::UInt64>(serverConnections.load());
+            stats["resident"] = static_cast<Json::Int64>(residentBytes());
+            callback(HttpResponse::newHttpJsonResponse(stats));
+        },
+        {Get});
+    LOG_INFO << "Listening on port " << kPort;
+    app().addListener("127.0.0.1", kPort).run();
+}
+
+class Benchmark : public std::enable_shared_from_this<Benchmark>
+{
+  public:
+    explicit Benchmark(size_t total) : total_(total)
+    {
+        clients_.reserve(total);
+    }
+
+    void start()
+    {
+        auto thisPtr = shared_from_this();
+        stats([thisPtr](size_t connections, long resident) {
+            thisPtr->baseConnections_ = connections;
+            thisPtr->baseResident_ = resident;
+            for (size_t i = 0; i < kConcurrency && i < thisPtr->total_; ++i)
+                thisPtr->connectNext();
+        });
+    }
+
+  private:
+    void stats(std::function<void(size_t, long)> &&callback)
+    {
+        auto client = HttpClient::newHttpClient(
+            "http://127.0.0.1:" + std::to_string(kPort), app().getLoop());
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/stats");
+        client->sendRequest(
+            req,
+            [client, callback = std::move(callback)](
+                ReqResult result, const HttpResponsePtr &resp) {
+                auto json = resp ? resp->getJsonObject() : nullptr;
+                if (result != ReqResult::Ok || !json)
+                {
+                    LOG_ERROR << "Cannot get the stats of the server";
+                    app().quit();
+                    return;
+                }
+                callback((*json)["connections"].asUInt64(),
+                         static_cast<long>((*json)["resident"].asInt64()));
+            });
+    }
+
+    void connectNext()
+    {
+        if (started_ == total_)
+            return;
+        ++started_;
+        // The clients share the main loop, which runs these callbacks
+        auto client = WebSocketClient::newWebSocketClient(
+            "ws://127.0.0.1:" + std::to_string(kPort), app().getLoop());
+        clients_.push_back(client);
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/idle");
+        auto thisPtr = shared_from_this();
+        client->connectToServer(req,
+                                [thisPtr](ReqResult result,
+                                          const HttpResponsePtr &,
+                                          const WebSocketClientPtr &) {
+                                    if (result != ReqResult::Ok)
+                                        ++thisPtr->failed_;
+                                    thisPtr->onConnected();
+                                });
+    }
+
+    void onConnected()
+    {
+        if (++finished_ < total_)
+        {
+            connectNext();
+            return;
+        }
+        // Leave the server time to free the buffers of the handshakes
+        auto thisPtr = shared_from_this();
+        app().getLoop()->runAfter(2s, [thisPtr]() {
+            thisPtr->stats([thisPtr](size_t connections, long resident) {
+                thisPtr->report(connections, resident);
+            });
+        });
+    }
+
+    void report(size_t connections, long resident)
+    {
+        auto opened = connections - baseConnections_;
+        std::cout << "Connections: " << opened << " (" << failed_
+                  << " failed)" << std::endl;
+        if (opened > 0 && resident > 0 && baseResident_ > 0)
+        {
+            std::cout << "Server resident memory per connection: "
+                      << (resident - baseResident_) / static_cast<long>(opened)
+                      << " bytes" << std::endl;
+        }
+        app().quit();
+    }
+
+    size_t total_;
+    size_t started_{0};
+    size_t finished_{0};
+    size_t failed_{0};
+    size_t baseConnections_{0};
+    long baseResident_{0};
+    std::vector<WebSocketClientPtr> clients_;
+};
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "server")
+    {
+        runServer();
+        return 0;
+    }
+    if (argc < 3 || std::string(argv[1]) != "client")
+    {
+        std::cout << "usage: " << argv[0] << " server | client <connections>"
+                  << std::endl;
+        return 1;
+    }
+    auto total = std::stoul(argv[2]);
+    if (total == 0)
+        return 1;
+    auto benchmark = std::make_shared<Benchmark>(total);
+    app().getLoop()->queueInLoop([benchmark]() { benchmark->start(); });
+    app().run();
+    return 0;
+}
@@ -0,0 +1,821 @@
+/**
+ *
+ *  @file AsyncLoadingCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpAppFramework.h>
+#include <trantor/utils/NonCopyable.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef __cpp_impl_coroutine
+#include <drogon/utils/coroutine.h>
+#endif
+
+namespace drogon
+{
+namespace monitoring
+{
+class Counter;
+class Histogram;
+}  // namespace monitoring
+
+/// The eviction policy of an AsyncLoadingCache
+enum class CacheEviction
+{
+    /// The least recently used entry is evicted
+    kLru = 0,
+    /**
+     * A new entry enters a small LRU window, and leaves it for the main LRU
+     * space only if it was requested more often than the entry it would
+     * evict there (W-TinyLFU). The keys requested once, e.g. by a scan, do
+     * not push the popular keys out.
+     */
+    kTinyLfu
+};
+
+/// The options of an AsyncLoadingCache
+struct AsyncLoadingCacheOptions
+{
+    /// The maximum number of entries
+    size_t maxEntries{10000};
+    /// The maximum number of bytes given by the weigher, 0 for no limit
+    size_t maxBytes{0};
+    /// The seconds a value is kept after it is loaded, 0 for no limit
+    double ttl{0};
+    /**
+     * The seconds after which a hit reloads the value in the background
+     * while the current value is returned, 0 to disable. Shorter than ttl,
+     * it keeps the popular keys from ever expiring.
+     */
+    double refreshAfter{0};
+    CacheEviction eviction{CacheEviction::kTinyLfu};
+    /// The number of shards locked independently
+    size_t shards{16};
+    /**
+     * One shard per IO loop instead of shards by key: the loops never wait
+     * for each other, but a key may be loaded and cached by every loop. The
+     * limits are still shared out between the shards. It needs the number
+     * of IO threads to be set.
+     */
+    bool perIoLoop{false};
+    /**
+     * The label of the metrics of the cache, see below, empty for no
+     * metrics.
+     */
+    std::string name;
+};
+
+namespace internal
+{
+/**
+ * @brief The metrics of a named AsyncLoadingCache, reported to
+ * drogon_loading_cache_total{cache,result} and
+ * drogon_loading_cache_load_seconds{cache} once the builtin metrics are
+ * enabled.
+ */
+class DROGON_EXPORT LoadingCacheStats : public trantor::NonCopyable
+{
+  public:
+    enum Event
+    {
+        kHit = 0,
+        kMiss,
+        kRefresh,
+        kEviction,
+        kFailure
+    };
+
+    explicit LoadingCacheStats(std::string cache) : cache_(std::move(cache))
+    {
+    }
+
+    void count(Event event, size_t times = 1)
+    {
+        if (resolved_.load(std::memory_order_acquire) || resolve())
+            increment(event, times);
+    }
+
+    void loaded(double seconds)
+    {
+        if (resolved_.load(std::memory_order_acquire) || resolve())
+            observe(seconds);
+    }
+
+  private:
+    bool resolve();
+    void increment(Event event, size_t times);
+    void observe(double seconds);
+
+    const std::string cache_;
+    std::atomic<bool> resolved_{false};
+    std::mutex mutex_;
+    std::array<monitoring::Counter *, 5> events_{};
+    monitoring::Histogram *loadDuration_{nullptr};
+};
+
+#ifdef __cpp_impl_coroutine
+template <typename Cache, typename V>
+struct [[nodiscard]] LoadingCacheAwaiter : public CallbackAwaiter<V>
+{
+    using Key = typename Cache::KeyType;
+
+    LoadingCacheAwaiter(std::shared_ptr<Cache> cache, Key key)
+        : cache_(std::move(cache)), key_(std::move(key))
+    {
+    }
+
+    // A hit completes in the call
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        cache_->get(
+            key_,
+            [handle, this](const V &value) {
+                this->setValue(value);
+                this->resumeIfSuspended(handle);
+            },
+            [handle, this](const std::exception_ptr &e) {
+                this->setException(e);
+                this->resumeIfSuspended(handle);
+            });
+        return this->suspendUnlessCompleted();
+    }
+
+  private:
+    std::shared_ptr<Cache> cache_;
+    Key key_;
+};
+#endif
+}  // namespace internal
+
+/**
+ * @brief A bounded cache which loads the missing values itself, once per key
+ * however many requests want it at the same time.
+ *
+ * It replaces the usual "look into a CacheMap, else query the database and
+ * insert the result" of the handlers, where all the requests of a key which
+ * arrive during the query run their own query. Here the first miss of a key
+ * calls the loader, and the later requests of the key wait for the same
+ * load (single flight). A failed load is passed to all its waiters and is not
+ * cached.
+ *
+ * @code
+   // Created once, e.g. in the constructor of a controller
+   auto users = AsyncLoadingCache<int64_t, UserPtr>::newCoroCache(
+       [](int64_t id) -> Task<UserPtr> {
+           auto row = co_await app().getDbClient()->execSqlCoro(
+               "select * from users where id = $1", id);
+           co_return std::make_shared<const User>(row[0]);
+       },
+       {.maxEntries = 100000, .ttl = 300, .refreshAfter = 240,
+        .name = "users"});
+   auto user = co_await users->getCoro(id);
+   @endcode
+ *
+ * The entries expire ttl seconds after their load, they are dropped when
+ * they are read or evicted. The values are copied to the callbacks, so the
+ * large values should be held by shared pointers to const objects.
+ *
+ * With a name, the lookups ("hit", "miss"), the background reloads
+ * ("refresh"), the evictions ("eviction") and the failed loads ("failure")
+ * are counted by drogon_loading_cache_total{cache,result}, and the time of
+ * the loads is observed by drogon_loading_cache_load_seconds{cache}, when the
+ * builtin metrics of the PromExporter plugin are enabled.
+ *
+ * @tparam K The key type.
+ * @tparam V The value type.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class AsyncLoadingCache
+    : public std::enable_shared_from_this<AsyncLoadingCache<K, V, Hash>>,
+      public trantor::NonCopyable
+{
+  public:
+    using KeyType = K;
+    using ValueType = V;
+    using ValueCallback = std::function<void(V &&)>;
+    using ErrorCallback = std::function<void(const std::exception_ptr &)>;
+    using GetCallback = std::function<void(const V &)>;
+    /**
+     * The loader is called with the key and must call one of the callbacks
+     * once, in any thread.
+     */
+    using Loader =
+        std::function<void(const K &, ValueCallback &&, ErrorCallback &&)>;
+    /// The size of a value in bytes, for maxBytes
+    using Weigher = std::function<size_t(const K &, const V &)>;
+
+    AsyncLoadingCache(Loader loader,
+                      const AsyncLoadingCacheOptions &options,
+                      Weigher weigher)
+        : loader_(std::move(loader)),
+          weigher_(std::move(weigher)),
+          ttl_(toDuration(options.ttl)),
+          refreshAfter_(toDuration(options.refreshAfter)),
+          tinyLfu_(options.eviction == CacheEviction::kTinyLfu),
+          perIoLoop_(options.perIoLoop)
+    {
+        shardsNum_ = perIoLoop_ ? app().getThreadNum() + 1 : options.shards;
+        if (shardsNum_ == 0)
+            shardsNum_ = 1;
+        auto maxEntries = (std::max)(options.maxEntries, size_t(1));
+        maxEntries_ = (maxEntries + shardsNum_ - 1) / shardsNum_;
+        maxBytes_ = weigher_ ? (options.maxBytes + shardsNum_ - 1) / shardsNum_
+                             : 0;
+        if (tinyLfu_)
+        {
+            // The window takes 1% of the space
+            windowEntries_ = (std::max)(maxEntries_ / 100, size_t(1));
+            mainEntries_ = (std::max)(maxEntries_ - windowEntries_, size_t(1));
+            windowBytes_ = maxBytes_ / 100;
+            mainBytes_ = maxBytes_ - windowBytes_;
+        }
+        else
+        {
+            mainEntries_ = maxEntries_;
+            mainBytes_ = maxBytes_;
+        }
+        shards_.reset(new Shard[shardsNum_]);
+        if (tinyLfu_)
+        {
+            for (size_t i = 0; i < shardsNum_; ++i)
+                shards_[i].sketch.init(maxEntries_);
+        }
+        if (!options.name.empty())
+            stats_ = std::make_unique<internal::LoadingCacheStats>(
+                options.name);
+    }
+
+    static std::shared_ptr<AsyncLoadingCache> newCache(
+        Loader loader,
+        const AsyncLoadingCacheOptions &options = {},
+        Weigher weigher = nullptr)
+    {
+        return std::make_shared<AsyncLoadingCache>(std::move(loader),
+                                                   options,
+                                                   std::move(weigher));
+    }
+
+#ifdef __cpp_impl_coroutine
+    /// A cache whose values are loaded by a coroutine
+    static std::shared_ptr<AsyncLoadingCache> newCoroCache(
+        std::function<Task<V>(K)> loader,
+        const AsyncLoadingCacheOptions &options = {},
+        Weigher weigher = nullptr)
+    {
+        return newCache(
+            [loader = std::move(loader)](const K &key,
+                                         ValueCallback &&callback,
+                                         ErrorCallback &&errorCallback) {
+                async_run([loader,
+                           key,
+                           callback = std::move(callback),
+                           errorCallback =
+                               std::move(errorCallback)]() -> Task<> {
+                    std::optional<V> value;
+                    try
+                    {
+                        value.emplace(co_await loader(key));
+                    }
+                    catch (...)
+                    {
+                        errorCallback(std::current_exception());
+                        co_return;
+                    }
+                    callback(std::move(*value));
+                });
+            },
+            options,
+            std::move(weigher));
+    }
+#endif
+
+    /**
+     * @brief Get the value of the key, loading it if it is not cached.
+     *
+     * The callback is called in the calling thread on a hit, and in the
+     * thread where the loader passes the value on a miss.
+     */
+    void get(const K &key, GetCallback callback, ErrorCallback errorCallback)
+    {
+        auto &shard = shardOf(key);
+        auto now = Clock::now();
+        std::optional<V> value;
+        std::shared_ptr<Load> load;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (tinyLfu_)
+                shard.sketch.increment(hashOf(key));
+            auto iter = shard.entries.find(key);
+            if (iter != shard.entries.end() && !expired(iter->second, now))
+            {
+                touch(shard, iter->second);
+                value = iter->second.value;
+                if (refreshAfter_.count() > 0 &&
+                    now - iter->second.loadedAt >= refreshAfter_ &&
+                    shard.loads.find(key) == shard.loads.end())
+                {
+                    load = std::make_shared<Load>();
+                    shard.loads.emplace(key, load);
+                }
+            }
+            else
+            {
+                if (iter != shard.entries.end())
+                    remove(shard, iter);
+                auto [loadIter, first] = shard.loads.try_emplace(key);
+                if (first)
+                    loadIter->second = std::make_shared<Load>();
+                loadIter->second->waiters.emplace_back(
+                    std::move(callback), std::move(errorCallback));
+                if (first)
+                    load = loadIter->second;
+            }
+        }
+        if (value)
+        {
+            count(internal::LoadingCacheStats::kHit);
+            if (load)
+            {
+                count(internal::LoadingCacheStats::kRefresh);
+                start(shard, key, std::move(load));
+            }
+            callback(*value);
+            return;
+        }
+        count(internal::LoadingCacheStats::kMiss);
+        if (load)
+            start(shard, key, std::move(load));
+    }
+
+#ifdef __cpp_impl_coroutine
+    /// Await the value of the key, see get()
+    internal::LoadingCacheAwaiter<AsyncLoadingCache, V> getCoro(K key)
+    {
+        return internal::LoadingCacheAwaiter<AsyncLoadingCache, V>(
+            this->shared_from_this(), std::move(key));
+    }
+#endif
+
+    /// Return the cached value of the key without loading it
+    std::optional<V> getIfPresent(const K &key)
+    {
+        auto &shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto iter = shard.entries.find(key);
+        if (iter == shard.entries.end() ||
+            expired(iter->second, Clock::now()))
+            return std::nullopt;
+        touch(shard, iter->second);
+        return iter->second.value;
+    }
+
+    /**
+     * @brief Set the value of the key. The load of the key in progress, if
+     * any, still passes its value to its waiters but does not cache it.
+     */
+    void put(const K &key, V value)
+    {
+        auto &shard = shardOf(key);
+        size_t evicted;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            forgetLoad(shard, key);
+            evicted = store(shard, key, std::move(value));
+        }
+        if (evicted > 0)
+            count(internal::LoadingCacheStats::kEviction, evicted);
+    }
+
+    /**
+     * @brief Remove the value of the key, e.g. when it is modified in the
+     * database. The next request of the key loads it again even if a load
+     * is in progress.
+     */
+    void invalidate(const K &key)
+    {
+        auto &shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        forgetLoad(shard, key);
+        auto iter = shard.entries.find(key);
+        if (iter != shard.entries.end())
+            remove(shard, iter);
+    }
+
+    /// Remove all the values, see invalidate()
+    void invalidateAll()
+    {
+        for (size_t i = 0; i < shardsNum_; ++i)
+        {
+            auto &shard = shards_[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto &[key, load] : shard.loads)
+                load->stale = true;
+            shard.loads.clear();
+            shard.entries.clear();
+            shard.window.clear();
+            shard.main.clear();
+            shard.windowBytes = 0;
+            shard.mainBytes = 0;
+        }
+    }
+
+    /// The number of cached values, with the expired ones not dropped yet
+    size_t size() const
+    {
+        size_t count{0};
+        for (size_t i = 0; i < shardsNum_; ++i)
+        {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            count += shards_[i].entries.size();
+        }
+        return count;
+    }
+
+    /// The bytes of the cached values given by the weigher
+    size_t bytes() const
+    {
+        size_t count{0};
+        for (size_t i = 0; i < shardsNum_; ++i)
+        {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            count += shards_[i].windowBytes + shards_[i].mainBytes;
+        }
+        return count;
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        V value;
+        size_t weight{0};
+        Clock::time_point loadedAt;
+        bool inWindow{false};
+        typename std::list<K>::iterator position;
+    };
+
+    using EntryMap = std::unordered_map<K, Entry, Hash>;
+
+    struct Load
+    {
+        std::vector<std::pair<GetCallback, ErrorCallback>> waiters;
+        // Set when the key is put or invalidated during the load
+        bool stale{false};
+    };
+
+    /**
+     * @brief The frequencies of the recent requests of the keys, 4-bit
+     * counters in a count-min sketch of 4 rows, halved when 10 times the
+     * capacity of requests are counted so the old popularity fades.
+     */
+    class FrequencySketch
+    {
+      public:
+        void init(size_t capacity)
+        {
+            size_t size = 16;
+            while (size < capacity * 4)
+                size <<= 1;
+            counters_.assign(size, 0);
+            mask_ = size - 1;
+            sampleSize_ = capacity * 10;
+        }
+
+        void increment(uint64_t hash)
+        {
+            bool added{false};
+            for (uint64_t i = 0; i < 4; ++i)
+            {
+                auto &counter = counters_[indexOf(hash, i)];
+                if (counter < 15)
+                {
+                    ++counter;
+                    added = true;
+                }
+            }
+            if (added && ++additions_ >= sampleSize_)
+            {
+                for (auto &counter : counters_)
+                    counter >>= 1;
+                additions_ /= 2;
+            }
+        }
+
+        uint8_t frequency(uint64_t hash) const
+        {
+            uint8_t frequency{15};
+            for (uint64_t i = 0; i < 4; ++i)
+                frequency = (std::min)(frequency, counters_[indexOf(hash, i)]);
+            return frequency;
+        }
+
+      private:
+        size_t indexOf(uint64_t hash, uint64_t row) const
+        {
+            hash += row * 0x9e3779b97f4a7c15ull;
+            hash ^= hash >> 31;
+            hash *= 0xbf58476d1ce4e5b9ull;
+            return static_cast<size_t>(hash >> 32) & mask_;
+        }
+
+        std::vector<uint8_t> counters_;
+        size_t mask_{0};
+        size_t sampleSize_{0};
+        size_t additions_{0};
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        EntryMap entries;
+        // The keys, the most recently used first
+        std::list<K> window;
+        std::list<K> main;
+        size_t windowBytes{0};
+        size_t mainBytes{0};
+        std::unordered_map<K, std::shared_ptr<Load>, Hash> loads;
+        FrequencySketch sketch;
+    };
+
+    static Clock::duration toDuration(double seconds)
+    {
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds > 0 ? seconds : 0));
+    }
+
+    static uint64_t hashOf(const K &key)
+    {
+        return static_cast<uint64_t>(Hash{}(key));
+    }
+
+    Shard &shardOf(const K &key)
+    {
+        if (perIoLoop_)
+        {
+            // The threads which are not IO threads share the last shard
+            auto index = app().getCurrentThreadIndex();
+            return shards_[(std::min)(index, shardsNum_ - 1)];
+        }
+        // The bits of the hash above the ones used by the maps
+        return shards_[((hashOf(key) * 0x9e3779b97f4a7c15ull) >> 32) %
+                       shardsNum_];
+    }
+
+    bool expired(const Entry &entry, Clock::time_point now) const
+    {
+        return ttl_.count() > 0 && now - entry.loadedAt >= ttl_;
+    }
+
+    void count(internal::LoadingCacheStats::Event event, size_t times = 1)
+    {
+        if (stats_)
+            stats_->count(event, times);
+    }
+
+    void touch(Shard &shard, Entry &entry)
+    {
+        auto &list = entry.inWindow ? shard.window : shard.main;
+        list.splice(list.begin(), list, entry.position);
+    }
+
+    void remove(Shard &shard, typename EntryMap::iterator iter)
+    {
+        auto &entry = iter->second;
+        if (entry.inWindow)
+        {
+            shard.window.erase(entry.position);
+            shard.windowBytes -= entry.weight;
+        }
+        else
+        {
+            shard.main.erase(entry.position);
+            shard.mainBytes -= entry.weight;
+        }
+        shard.entries.erase(iter);
+    }
+
+    void forgetLoad(Shard &shard, const K &key)
+    {
+        auto iter = shard.loads.find(key);
+        if (iter == shard.loads.end())
+            return;
+        iter->second->stale = true;
+        shard.loads.erase(iter);
+    }
+
+    /// Store a value and return the number of evicted entries
+    size_t store(Shard &shard, const K &key, V &&value)
+    {
+        size_t weight = weigher_ ? weigher_(key, value) : 0;
+        auto iter = shard.entries.find(key);
+        if (iter != shard.entries.end())
+            remove(shard, iter);
+        // A value larger than the whole shard is not cached
+        if (maxBytes_ > 0 && weight > maxBytes_)
+            return 0;
+        iter = shard.entries
+                   .emplace(key,
+                            Entry{std::move(value),
+                                  weight,
+                                  Clock::now(),
+                                  tinyLfu_,
+                                  {}})
+                   .first;
+        auto &entry = iter->second;
+        if (tinyLfu_)
+        {
+            entry.position = shard.window.insert(shard.window.begin(), key);
+            shard.windowBytes += weight;
+            return evictWindow(shard);
+        }
+        entry.position = shard.main.insert(shard.main.begin(), key);
+        shard.mainBytes += weight;
+        return evictMain(shard);
+    }
+
+    bool mainOver(const Shard &shard, size_t extraEntries, size_t extraBytes)
+    {
+        return shard.main.size() + extraEntries > mainEntries_ ||
+               (mainBytes_ > 0 && shard.mainBytes + extraBytes > mainBytes_);
+    }
+
+    size_t evictMain(Shard &shard)
+    {
+        size_t evicted{0};
+        while (shard.main.size() > 1 && mainOver(shard, 0, 0))
+        {
+            remove(shard, shard.entries.find(shard.main.back()));
+            ++evicted;
+        }
+        return evicted;
+    }
+
+    // Move the entries leaving the window to the main space, or evict them
+    // if they are requested less often than the entries they would evict.
+    size_t evictWindow(Shard &shard)
+    {
+        size_t evicted{0};
+        while (shard.window.size() > windowEntries_ ||
+               (windowBytes_ > 0 && shard.windowBytes > windowBytes_ &&
+                shard.window.size() > 1))
+        {
+            auto iter = shard.entries.find(shard.window.back());
+            auto &entry = iter->second;
+            if (!shard.main.empty() && mainOver(shard, 1, entry.weight) &&
+                shard.sketch.frequency(hashOf(iter->first)) <=
+                    shard.sketch.frequency(hashOf(shard.main.back())))
+            {
+                remove(shard, iter);
+                ++evicted;
+                continue;
+            }
+            shard.window.erase(entry.position);
+            shard.windowBytes -= entry.weight;
+            entry.inWindow = false;
+            entry.position = shard.main.insert(shard.main.begin(), iter->first);
+            shard.mainBytes += entry.weight;
+            evicted += evictMain(shard);
+        }
+        return evicted;
+    }
+
+    // The shard is the one of the calling thread in the perIoLoop mode, the
+    // load may end in another thread.
+    void start(Shard &shard, const K &key, std::shared_ptr<Load> load)
+    {
+        std::weak_ptr<AsyncLoadingCache> weakPtr = this->shared_from_this();
+        auto shardPtr = &shard;
+        auto started = Clock::now();
+        try
+        {
+            loader_(
+                key,
+                [weakPtr, shardPtr, key, load, started](V &&value) {
+                    loaded(weakPtr,
+                           shardPtr,
+                           key,
+                           load,
+                           started,
+                           std::move(value));
+                },
+                [weakPtr, shardPtr, key, load](const std::exception_ptr &e) {
+                    failed(weakPtr, shardPtr, key, load, e);
+                });
+        }
+        catch (...)
+        {
+            failed(weakPtr, shardPtr, key, load, std::current_exception());
+        }
+    }
+
+    // The waiters are called even if the cache is destroyed during the load
+    static void loaded(const std::weak_ptr<AsyncLoadingCache> &weakPtr,
+                       Shard *shardPtr,
+                       const K &key,
+                       const std::shared_ptr<Load> &load,
+                       Clock::time_point started,
+                       V &&value)
+    {
+        auto thisPtr = weakPtr.lock();
+        std::vector<std::pair<GetCallback, ErrorCallback>> waiters;
+        size_t evicted{0};
+        if (thisPtr)
+        {
+            auto &shard = *shardPtr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto iter = shard.loads.find(key);
+            if (iter != shard.loads.end() && iter->second == load)
+                shard.loads.erase(iter);
+            waiters = std::move(load->waiters);
+            if (!load->stale)
+                evicted = thisPtr->store(shard, key, V(value));
+        }
+        else
+        {
+            waiters = std::move(load->waiters);
+        }
+        if (thisPtr && thisPtr->stats_)
+        {
+            thisPtr->stats_->loaded(
+                std::chrono::duration<double>(Clock::now() - started)
+                    .count());
+            if (evicted > 0)
+                thisPtr->count(internal::LoadingCacheStats::kEviction,
+                               evicted);
+        }
+        for (auto &waiter : waiters)
+            waiter.first(value);
+    }
+
+    static void failed(const std::weak_ptr<AsyncLoadingCache> &weakPtr,
+                       Shard *shardPtr,
+                       const K &key,
+                       const std::shared_ptr<Load> &load,
+                       const std::exception_ptr &e)
+    {
+        auto thisPtr = weakPtr.lock();
+        std::vector<std::pair<GetCallback, ErrorCallback>> waiters;
+        if (thisPtr)
+        {
+            auto &shard = *shardPtr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto iter = shard.loads.find(key);
+            if (iter != shard.loads.end() && iter->second == load)
+                shard.loads.erase(iter);
+            waiters = std::move(load->waiters);
+        }
+        else
+        {
+            waiters = std::move(load->waiters);
+        }
+        if (thisPtr)
+            thisPtr->count(internal::LoadingCacheStats::kFailure);
+        // A failed refresh keeps the current value until it expires
+        for (auto &waiter : waiters)
+            waiter.second(e);
+    }
+
+    const Loader loader_;
+    const Weigher weigher_;
+    const Clock::duration ttl_;
+    const Clock::duration refreshAfter_;
+    const bool tinyLfu_;
+    const bool perIoLoop_;
+    size_t shardsNum_;
+    // The limits of every shard
+    size_t maxEntries_;
+    size_t maxBytes_;
+    size_t windowEntries_{0};
+    size_t windowBytes_{0};
+    size_t mainEntries_;
+    size_t mainBytes_;
+    std::unique_ptr<Shard[]> shards_;
+    std::unique_ptr<internal::LoadingCacheStats> stats_;
+};
+
+}  // namespace drogon
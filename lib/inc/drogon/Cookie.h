@@ -16,6 +16,7 @@
 #include <drogon/exports.h>
 #include <trantor/utils/Date.h>
 #include <trantor/utils/Logger.h>
+#include <trantor/utils/MsgBuffer.h>
 #include <drogon/utils/Utilities.h>
 #include <cctype>
 #include <string>
@@ -173,6 +174,12 @@ class DROGON_EXPORT Cookie
      */
     std::string cookieString() const;
 
+    /**
+     * @brief Append the string value of the cookie to the buffer, without
+     * building a temporary string.
+     */
+    void appendCookieString(trantor::MsgBuffer &buffer) const;
+
     /**
      * @brief Get the string value of the cookie
      */
@@ -17,6 +17,7 @@
 #include <drogon/exports.h>
 #include <drogon/DrObject.h>
 #include <drogon/HttpViewData.h>
+#include <drogon/utils/OStringStream.h>
 #include <memory>
 #include <string>
 
@@ -29,6 +30,11 @@ using DrTemplateData = HttpViewData;
  * This class can generate a text string from the template file and template
  * data.
  * For more details on the template file, see the wiki site (the 'View' section)
+ *
+ * A template with a <%model Type %> tag is typed: its [[ name ]] tags and @@
+ * refer to the members of a Type object, and the generated class has static
+ * render(const Type &) methods which need no lookup in a HttpViewData. Its
+ * genText() renders the Type object stored under the "model" key.
  */
 class DROGON_EXPORT DrTemplateBase : public virtual DrObjectBase
 {
@@ -51,6 +57,18 @@ class DROGON_EXPORT DrTemplateBase : public virtual DrObjectBase
     virtual std::string genText(
         const DrTemplateData &data = DrTemplateData()) = 0;
 
+    /// Write the text to the stream
+    /**
+     * The views created by drogon_ctl write their text to the stream as it is
+     * rendered, so a stream with a sink (see OStringStream::setSink()) never
+     * holds the whole text, except the text passed to a layout. The default
+     * implementation writes the string returned by genText().
+     */
+    virtual void renderTo(const DrTemplateData &data, OStringStream &stream)
+    {
+        stream << genText(data);
+    }
+
     virtual ~DrTemplateBase(){};
     DrTemplateBase(){};
 };
@@ -0,0 +1,433 @@
+/**
+ *
+ *  @file Grpc.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpClient.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Register a gRPC method of a controller, the path is the one of the
+ * method in the service, like "/helloworld.Greeter/SayHello".
+ *
+ * @code
+  class Greeter : public drogon::HttpController<Greeter>
+  {
+    public:
+      METHOD_LIST_BEGIN
+      ADD_GRPC_METHOD(Greeter::sayHello, "/helloworld.Greeter/SayHello");
+      METHOD_LIST_END
+
+      void sayHello(const HttpRequestPtr &req,
+                    std::function<void(const HttpResponsePtr &)> &&callback)
+      {
+          helloworld::HelloRequest request;
+          auto status = drogon::grpc::parseRequest(req, request);
+          if (!status.ok())
+          {
+              callback(drogon::grpc::newErrorResponse(status));
+              return;
+          }
+          helloworld::HelloReply reply;
+          reply.set_message("Hello " + request.name());
+          callback(drogon::grpc::newResponse(reply));
+      }
+  };
+  @endcode
+ */
+#define ADD_GRPC_METHOD(method, path, ...) \
+    ADD_METHOD_TO(method, path, drogon::Post, __VA_ARGS__)
+
+namespace drogon
+{
+/**
+ * @brief gRPC over the HTTP/2 streams of the application and of HttpClient.
+ *
+ * The messages are the protobuf classes generated by protoc, or any class
+ * with their ByteSizeLong(), SerializeToArray() and ParseFromArray()
+ * methods, or std::string for the serialized messages. Drogon doesn't link
+ * protobuf, the generated code brings it.
+ *
+ * A gRPC handler is an ordinary handler of a controller registered with
+ * ADD_GRPC_METHOD. The unary and the server streaming calls are supported,
+ * the messages of a client streaming call are received at once when the
+ * client has sent them all, since the requests are handled once their
+ * streams are half-closed. The grpc-timeout of a request sets its deadline.
+ * The messages are not compressed.
+ *
+ * @note The trailers carrying the status are only sent over HTTP/2, the
+ * gRPC clients reach the application over h2 or h2c.
+ */
+namespace grpc
+{
+/// The status codes of gRPC
+enum class StatusCode : int
+{
+    kOk = 0,
+    kCancelled = 1,
+    kUnknown = 2,
+    kInvalidArgument = 3,
+    kDeadlineExceeded = 4,
+    kNotFound = 5,
+    kAlreadyExists = 6,
+    kPermissionDenied = 7,
+    kResourceExhausted = 8,
+    kFailedPrecondition = 9,
+    kAborted = 10,
+    kOutOfRange = 11,
+    kUnimplemented = 12,
+    kInternal = 13,
+    kUnavailable = 14,
+    kDataLoss = 15,
+    kUnauthenticated = 16,
+};
+
+/// The status of a call, sent in the grpc-status and grpc-message fields
+struct Status
+{
+    StatusCode code{StatusCode::kOk};
+    std::string message;
+
+    bool ok() const
+    {
+        return code == StatusCode::kOk;
+    }
+};
+
+/// The content type of the gRPC requests and responses
+constexpr std::string_view kContentType = "application/grpc";
+
+/// Append the 5 bytes prefix of an uncompressed message of a length
+inline void appendPrefix(std::string &body, size_t length)
+{
+    body.push_back('\0');
+    for (int shift = 24; shift >= 0; shift -= 8)
+        body.push_back(static_cast<char>((length >> shift) & 0xff));
+}
+
+/// Append a message to a body with its prefix
+template <typename Message>
+void appendMessage(std::string &body, const Message &message)
+{
+    if constexpr (std::is_convertible_v<const Message &, std::string_view>)
+    {
+        std::string_view data(message);
+        appendPrefix(body, data.length());
+        body.append(data);
+    }
+    else
+    {
+        // The message is serialized in place, after its prefix
+        auto length = static_cast<size_t>(message.ByteSizeLong());
+        appendPrefix(body, length);
+        auto pos = body.length();
+        body.resize(pos + length);
+        message.SerializeToArray(body.data() + pos, static_cast<int>(length));
+    }
+}
+
+/// Parse a serialized message
+template <typename Message>
+bool parseMessage(std::string_view data, Message &message)
+{
+    if constexpr (std::is_same_v<Message, std::string>)
+    {
+        message.assign(data);
+        return true;
+    }
+    else
+    {
+        return message.ParseFromArray(data.data(),
+                                      static_cast<int>(data.length()));
+    }
+}
+
+/**
+ * @brief Split a body into its length-prefixed messages, which point into
+ * the body.
+ *
+ * @return kInternal if a message is truncated, kUnimplemented if one is
+ * compressed.
+ */
+DROGON_EXPORT Status splitFrames(std::string_view body,
+                                 std::vector<std::string_view> &messages);
+
+/**
+ * @brief Parse the value of a grpc-timeout field, like "100m" or "5S".
+ *
+ * @return false if the value is not valid.
+ */
+DROGON_EXPORT bool parseTimeout(std::string_view value,
+                                std::chrono::nanoseconds &timeout);
+
+/// Format a timeout as the value of a grpc-timeout field
+DROGON_EXPORT std::string formatTimeout(std::chrono::nanoseconds timeout);
+
+/**
+ * @brief Check that a request is a gRPC one and split its body into its
+ * messages.
+ */
+DROGON_EXPORT Status splitRequest(const HttpRequestPtr &req,
+                                  std::vector<std::string_view> &messages);
+
+/// Parse the message of a unary or a server streaming call
+template <typename Message>
+Status parseRequest(const HttpRequestPtr &req, Message &message)
+{
+    std::vector<std::string_view> messages;
+    auto status = splitRequest(req, messages);
+    if (!status.ok())
+        return status;
+    if (messages.size() != 1)
+    {
+        return {StatusCode::kInvalidArgument,
+                "A unary call has one request message"};
+    }
+    if (!parseMessage(messages.front(), message))
+        return {StatusCode::kInvalidArgument, "Invalid request message"};
+    return status;
+}
+
+/// Parse the messages of a client streaming call
+template <typename Message>
+Status parseRequests(const HttpRequestPtr &req, std::vector<Message> &messages)
+{
+    std::vector<std::string_view> frames;
+    auto status = splitRequest(req, frames);
+    if (!status.ok())
+        return status;
+    messages.resize(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        if (!parseMessage(frames[i], messages[i]))
+            return {StatusCode::kInvalidArgument, "Invalid request message"};
+    }
+    return status;
+}
+
+/// Create the response of a call whose framed messages are the body
+DROGON_EXPORT HttpResponsePtr newFramedResponse(std::string body);
+
+/// Create the response of a unary call, its status is kOk
+template <typename Message>
+HttpResponsePtr newResponse(const Message &message)
+{
+    std::string body;
+    appendMessage(body, message);
+    return newFramedResponse(std::move(body));
+}
+
+/// Create the response of a failed call, with no message
+DROGON_EXPORT HttpResponsePtr newErrorResponse(const Status &status);
+
+inline HttpResponsePtr newErrorResponse(StatusCode code,
+                                        std::string message = {})
+{
+    return newErrorResponse(Status{code, std::move(message)});
+}
+
+/**
+ * @brief The writer of the messages of a server streaming call, the methods
+ * can be called in any thread.
+ */
+class DROGON_EXPORT ServerWriter
+{
+  public:
+    ServerWriter(ResponseStreamPtr stream, HttpResponsePtr response);
+
+    /// Finish the call with kUnknown if finish() was not called
+    ~ServerWriter();
+
+    ServerWriter(const ServerWriter &) = delete;
+    ServerWriter &operator=(const ServerWriter &) = delete;
+
+    /**
+     * @brief Send a message.
+     *
+     * @return false if the call is finished or the client is gone.
+     */
+    template <typename Message>
+    bool write(const Message &message)
+    {
+        std::string frame;
+        appendMessage(frame, message);
+        return writeFrames(frame);
+    }
+
+    /// Send messages framed by appendMessage()
+    bool writeFrames(const std::string &frames);
+
+    /// Finish the call with its status, sent in the trailers
+    void finish(const Status &status = {});
+
+  private:
+    ResponseStreamPtr stream_;
+    HttpResponsePtr response_;
+    bool finished_{false};
+};
+
+using ServerWriterPtr = std::shared_ptr<ServerWriter>;
+
+/**
+ * @brief Create the response of a server streaming call, the callback is
+ * invoked once the response header is sent.
+ */
+DROGON_EXPORT HttpResponsePtr
+newStreamResponse(const std::function<void(const ServerWriterPtr &)> &callback);
+
+/**
+ * @brief Create the request of a call to a method, like
+ * "/helloworld.Greeter/SayHello", whose framed messages are the body.
+ *
+ * @param timeout The grpc-timeout sent to the server if it is positive.
+ */
+DROGON_EXPORT HttpRequestPtr
+newFramedRequest(const std::string &path,
+                 std::string body,
+                 std::chrono::nanoseconds timeout = {});
+
+/// Create the request of a unary or a server streaming call
+template <typename Message>
+HttpRequestPtr newRequest(const std::string &path,
+                          const Message &message,
+                          std::chrono::nanoseconds timeout = {})
+{
+    std::string body;
+    appendMessage(body, message);
+    return newFramedRequest(path, std::move(body), timeout);
+}
+
+/// Create the request of a client streaming call
+template <typename Message>
+HttpRequestPtr newRequest(const std::string &path,
+                          const std::vector<Message> &messages,
+                          std::chrono::nanoseconds timeout = {})
+{
+    std::string body;
+    for (auto &message : messages)
+        appendMessage(body, message);
+    return newFramedRequest(path, std::move(body), timeout);
+}
+
+/**
+ * @brief The status of a response, from its trailers or, when it has none,
+ * from its header, and from the status code of the response if it is not a
+ * gRPC one.
+ */
+DROGON_EXPORT Status statusOf(const HttpResponsePtr &resp);
+
+/// The status of a call whose request failed
+DROGON_EXPORT Status statusOf(ReqResult result);
+
+/**
+ * @brief Check the status of a response and split its body into its
+ * messages.
+ */
+DROGON_EXPORT Status splitResponse(const HttpResponsePtr &resp,
+                                   std::vector<std::string_view> &messages);
+
+/// Parse the messages of a response
+template <typename Message>
+Status parseResponses(const HttpResponsePtr &resp,
+                      std::vector<Message> &messages)
+{
+    std::vector<std::string_view> frames;
+    auto status = splitResponse(resp, frames);
+    if (!status.ok())
+        return status;
+    messages.resize(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        if (!parseMessage(frames[i], messages[i]))
+            return {StatusCode::kInternal, "Invalid response message"};
+    }
+    return status;
+}
+
+/// Parse the message of the response of a unary call
+template <typename Message>
+Status parseResponse(const HttpResponsePtr &resp, Message &message)
+{
+    std::vector<std::string_view> frames;
+    auto status = splitResponse(resp, frames);
+    if (!status.ok())
+        return status;
+    if (frames.size() != 1)
+    {
+        return {StatusCode::kInternal,
+                "A unary call has one response message"};
+    }
+    if (!parseMessage(frames.front(), message))
+        return {StatusCode::kInternal, "Invalid response message"};
+    return status;
+}
+
+/**
+ * @brief Call a unary method on the loop of the client, which should have
+ * HTTP/2 enabled.
+ *
+ * @param timeout The deadline of the call, sent to the server too, no
+ * deadline if it is not positive.
+ *
+ * @code
+  auto client = HttpClient::newHttpClient("http://127.0.0.1:50051");
+  client->enableHttp2();
+  helloworld::HelloRequest request;
+  request.set_name("drogon");
+  drogon::grpc::call<helloworld::HelloReply>(
+      client,
+      "/helloworld.Greeter/SayHello",
+      request,
+      [](const drogon::grpc::Status &status,
+         helloworld::HelloReply &&reply) {
+          if (status.ok())
+              LOG_INFO << reply.message();
+      },
+      std::chrono::seconds(1));
+  @endcode
+ */
+template <typename Response, typename Request>
+void call(const HttpClientPtr &client,
+          const std::string &path,
+          const Request &request,
+          std::function<void(const Status &, Response &&)> callback,
+          std::chrono::nanoseconds timeout = {})
+{
+    client->sendRequest(
+        newRequest(path, request, timeout),
+        [callback = std::move(callback)](ReqResult result,
+                                         const HttpResponsePtr &resp) {
+            Response response{};
+            if (result != ReqResult::Ok)
+            {
+                callback(statusOf(result), std::move(response));
+                return;
+            }
+            auto status = parseResponse(resp, response);
+            callback(status, std::move(response));
+        },
+        timeout.count() > 0
+            ? std::chrono::duration<double>(timeout).count()
+            : 0.0);
+}
+}  // namespace grpc
+}  // namespace drogon
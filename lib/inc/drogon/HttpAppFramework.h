@@ -18,6 +18,7 @@
 #endif
 #include <drogon/exports.h>
 #include <drogon/utils/HttpConstraint.h>
+#include <drogon/utils/JsonBackend.h>
 #include <drogon/CacheMap.h>
 #include <drogon/DrObject.h>
 #include <drogon/HttpBinder.h>
@@ -30,9 +31,12 @@
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/orm/DbClient.h>
+#include <drogon/orm/ShardedDbClient.h>
 #include <drogon/orm/DbConfig.h>
 #include <drogon/nosql/RedisClient.h>
 #include <drogon/Cookie.h>
+#include <drogon/SessionStore.h>
+#include <drogon/WebSocketConnection.h>
 #include <trantor/net/Resolver.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/utils/NonCopyable.h>
@@ -79,6 +83,37 @@ using DefaultHandler =
                        std::function<void(const HttpResponsePtr &)> &&)>;
 using HttpHandlerInfo = std::tuple<std::string, HttpMethod, std::string>;
 
+/**
+ * @brief The socket options of a listener and of the connections it accepts,
+ * see HttpAppFramework::addListener().
+ *
+ * The options left to 0 or false keep the defaults of the system, those the
+ * system lacks are ignored.
+ */
+struct ListenerSocketOptions
+{
+    /// TCP_DEFER_ACCEPT, the seconds the kernel waits for the first data of
+    /// a connection before the connection is accepted (Linux).
+    int deferAccept{0};
+    /// TCP_FASTOPEN, the length of the queue of the TCP Fast Open requests
+    /// not accepted yet.
+    int fastOpenQueueLength{0};
+    /// SO_BUSY_POLL, the microseconds the receives of a connection busy poll
+    /// the device queue when it is empty (Linux).
+    int busyPoll{0};
+    /// SO_SNDBUF and SO_RCVBUF, in bytes, inherited by the connections from
+    /// the listening socket so the window scaling is negotiated with them.
+    int sendBufferSize{0};
+    int receiveBufferSize{0};
+    /// TCP_NOTSENT_LOWAT, the connections are writable while less than this
+    /// number of bytes isn't sent yet.
+    int notSentLowat{0};
+    /// TCP_NODELAY, the responses are sent without waiting for the
+    /// acknowledgement of the previous segments. The pipelined responses of
+    /// a connection are already coalesced into one write.
+    bool tcpNoDelay{false};
+};
+
 #ifdef __cpp_impl_coroutine
 class HttpAppFramework;
 
@@ -99,7 +134,7 @@ struct [[nodiscard]] ForwardAwaiter
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle) noexcept;
+    bool await_suspend(std::coroutine_handle<> handle) noexcept;
 
   private:
     drogon::HttpRequestPtr req_;
@@ -107,6 +142,55 @@ struct [[nodiscard]] ForwardAwaiter
     double timeout_;
     HttpAppFramework &app_;
 };
+
+struct [[nodiscard]] SubrequestAwaiter
+    : public CallbackAwaiter<drogon::HttpResponsePtr>
+{
+  public:
+    SubrequestAwaiter(drogon::HttpRequestPtr &&req, HttpAppFramework &app)
+        : req_(std::move(req)), app_(app)
+    {
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept;
+
+  private:
+    drogon::HttpRequestPtr req_;
+    HttpAppFramework &app_;
+};
+
+struct [[nodiscard]] SubrequestsAwaiter
+    : public CallbackAwaiter<std::vector<drogon::HttpResponsePtr>>
+{
+  public:
+    SubrequestsAwaiter(std::vector<drogon::HttpRequestPtr> &&reqs,
+                       HttpAppFramework &app)
+        : reqs_(std::move(reqs)), app_(app)
+    {
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept;
+
+  private:
+    std::vector<drogon::HttpRequestPtr> reqs_;
+    HttpAppFramework &app_;
+};
+
+template <typename T>
+struct [[nodiscard]] OffloadAwaiter : public CallbackAwaiter<T>
+{
+  public:
+    OffloadAwaiter(std::function<T()> &&task, HttpAppFramework &app)
+        : task_(std::move(task)), app_(app)
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+  private:
+    std::function<T()> task_;
+    HttpAppFramework &app_;
+};
 }  // namespace internal
 #endif
 class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
@@ -486,8 +570,8 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      * called.
      * @param ctrlName is the name of the controller. It includes the namespace
      * to which the controller belongs.
-     * @param constraints is a vector containing Http methods or middleware
-     names
+     * @param constraints is a vector containing Http methods, middleware
+     names or a BodyLimit of the route
      *
      *   Example:
      * @code
@@ -556,6 +640,14 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
             {
                 validMethods.push_back(constraint.getHttpMethod());
             }
+            else if (constraint.type() == internal::ConstraintType::BodyLimit)
+            {
+                binder->setBodyLimit(constraint.getBodyLimit());
+            }
+            else if (constraint.type() == internal::ConstraintType::Offload)
+            {
+                binder->setOffload(true);
+            }
             else
             {
                 LOG_ERROR << "Invalid controller constraint type";
@@ -607,6 +699,14 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
             {
                 validMethods.push_back(constraint.getHttpMethod());
             }
+            else if (constraint.type() == internal::ConstraintType::BodyLimit)
+            {
+                binder->setBodyLimit(constraint.getBodyLimit());
+            }
+            else if (constraint.type() == internal::ConstraintType::Offload)
+            {
+                binder->setOffload(true);
+            }
             else
             {
                 LOG_ERROR << "Invalid controller constraint type";
@@ -618,6 +718,34 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         return *this;
     }
 
+    /**
+     * @brief Register a constant response for a path.
+     *
+     * Every IO thread renders its own copy of the response (the status line,
+     * the headers and the body) into one contiguous buffer the first time
+     * the path is requested. Later requests send that shared buffer with a
+     * single write and no rendering, only the Date header is patched once per
+     * second. A body of 4KB or more is not rendered into the buffer, the
+     * copies share it and send it after their headers. This is intended for
+     * hot endpoints like health checks or small JSON constants.
+     *
+     * @param path The path of the response, placeholders are not allowed.
+     * @param resp The response, it must not be modified after registration.
+     * If its expiredTime() is negative, it is set to 0 (never expires).
+     * @param constraints The same as the third parameter of registerHandler().
+     *
+     *   Example:
+     * @code
+       auto resp = HttpResponse::newHttpResponse();
+       resp->setBody("ok");
+       app().registerStaticResponse("/health", resp, {Get});
+       @endcode
+     */
+    virtual HttpAppFramework &registerStaticResponse(
+        const std::string &path,
+        const HttpResponsePtr &resp,
+        const std::vector<internal::HttpConstraint> &constraints = {}) = 0;
+
     /// Register a WebSocketController into the framework.
     /**
      * The parameters of this method are the same as those in the
@@ -777,6 +905,47 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
                                         *this);
     }
 #endif
+
+    /**
+     * @brief Handle a request by the routes of this application in the same
+     * process, like the subrequests of nginx.
+     *
+     * The request, usually created by HttpRequest::newSubrequest(), goes
+     * straight to the routing: the sync and pre-routing advices and the
+     * session loading are skipped, the post-routing advices, the middlewares
+     * and the handler of its route run as for a request of a client. The
+     * response is passed to the callback as the handler created it, it is
+     * neither serialized nor compressed, and the pre-sending advices don't
+     * see it.
+     *
+     * @note The request is handled in its loop, so the subrequests of a
+     * request run in the loop of the parent.
+     */
+    virtual void subrequest(
+        const HttpRequestPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback) = 0;
+
+    /**
+     * @brief Send the subrequests at the same time and pass their responses to
+     * the callback in the order of the requests once all of them are done.
+     */
+    virtual void subrequests(
+        std::vector<HttpRequestPtr> reqs,
+        std::function<void(std::vector<HttpResponsePtr> &&)> &&callback) = 0;
+#ifdef __cpp_impl_coroutine
+    /// The coroutine version of subrequest()
+    internal::SubrequestAwaiter subrequestCoro(HttpRequestPtr req)
+    {
+        return internal::SubrequestAwaiter(std::move(req), *this);
+    }
+
+    /// The coroutine version of subrequests()
+    internal::SubrequestsAwaiter subrequestsCoro(
+        std::vector<HttpRequestPtr> reqs)
+    {
+        return internal::SubrequestsAwaiter(std::move(reqs), *this);
+    }
+#endif
     /// Get information about the handlers registered to drogon
     /**
      * @return
@@ -804,6 +973,210 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Get the number of threads for IO event loops
     virtual size_t getThreadNum() const = 0;
 
+    /// Pin the IO threads to CPUs
+    /**
+     * @param cpus The CPU numbers, the IO thread with the index i is pinned to
+     * cpus[i % cpus.size()]. An empty vector (the default) leaves the
+     * threads to the scheduler. The CPUs which are not in the affinity mask
+     * of the process are logged and ignored.
+     *
+     * @note
+     * This option only takes effect on Linux, where every IO thread listens
+     * on its own socket of each listener. The sockets of a pinned thread are
+     * also bound to its CPU with SO_INCOMING_CPU, so the kernel hands a new
+     * connection to the thread running on the CPU which received it, when
+     * one exists.
+     * This option can be configured in the configuration file.
+     */
+    virtual HttpAppFramework &setIoThreadsAffinity(
+        const std::vector<unsigned int> &cpus) = 0;
+
+    /// Get the CPUs which the IO threads are pinned to
+    virtual const std::vector<unsigned int> &getIoThreadsAffinity() const = 0;
+
+    /// Handle the requests which share a key in the same IO loop
+    /**
+     * @param key "ip" for the IP of the client, "header:<name>" for a
+     * header or "cookie:<name>" for a cookie, e.g. "header:X-Tenant". Empty
+     * by default, which handles the requests in the loop of their
+     * connection.
+     *
+     * The key is mapped to an IO loop by a consistent hash, the request is
+     * handed over to that loop once it is parsed and its response is handed
+     * back to the loop of the connection. So the per-loop data of a client
+     * or a tenant (IOThreadStorage, the fast database and redis clients, the
+     * caches of the handlers) stays in one loop. The requests without the
+     * key and the ones with a streamed body are handled in the loop of their
+     * connection.
+     *
+     * @note
+     * This option can be configured in the configuration file. An invalid key
+     * is logged and disables the affinity.
+     */
+    virtual HttpAppFramework &setLoopAffinityKey(const std::string &key) = 0;
+
+    /// Set the number of threads of the compute pool
+    /**
+     * @param threadNum the number of threads, 0 by default, which means the
+     * number of CPU cores.
+     *
+     * The compute pool runs the CPU heavy work passed to offload() and the
+     * handlers of the routes with the Offload constraint, out of the IO
+     * loops. Its threads are started by the first task.
+     *
+     * @note
+     * This number can be configured in the configuration file.
+     */
+    virtual HttpAppFramework &setComputeThreadNum(size_t threadNum) = 0;
+
+    /// Get the number set by the above method.
+    virtual size_t getComputeThreadNum() const = 0;
+
+    /// Split the handling of the requests from the IO loops
+    /**
+     * @param maxThreadNum The maximum number of handler loops, 0 by default,
+     * which means the handlers run in the IO loops.
+     * @param minThreadNum The number of handler loops always running.
+     *
+     * The IO loops then only parse the requests and send the responses, and
+     * the routing, the middlewares and the handlers run in a pool of loops.
+     * A loop is added when the requests waiting outnumber the loops, and
+     * retired when it has been idle for 10 seconds. The responses go back to
+     * the IO loop of their connection.
+     *
+     * The handler loops have slots in the IOThreadStorage after the ones of
+     * the IO loops and the main loop. The fast database and redis clients are
+     * bound to the IO loops, getFastDbClient() and getFastRedisClient() throw
+     * in the handlers in this mode, except for a redis client which also has
+     * a shared client.
+     *
+     * @note
+     * This number can be configured in the configuration file. It must be set
+     * before the application runs.
+     */
+    virtual HttpAppFramework &setHandlerThreadNum(size_t maxThreadNum,
+                                                  size_t minThreadNum = 1) = 0;
+
+    /// Get the maximum number of handler loops set by the above method.
+    virtual size_t getHandlerThreadNum() const = 0;
+
+    /// Set the number of worker processes
+    /**
+     * @param num The number of processes, 1 by default, which means the
+     * application runs in the process calling run().
+     *
+     * With more than one, the process calling run() becomes a master which
+     * binds the listening sockets and forks the workers. Each worker runs the
+     * application with the number of IO threads set by setThreadNum(), and
+     * accepts the connections of the sockets of the master, so a worker which
+     * crashes or blocks doesn't stop the others. The master restarts the
+     * workers which die, forwards SIGTERM and SIGINT to them and exits once
+     * they have all stopped. The metrics exported by the PromExporter plugin
+     * of a worker are the sums of the metrics of all of them. The hot restart
+     * is not supported with worker processes, which are only supported on
+     * Linux.
+     *
+     * @note
+     * This number can be configured in the configuration file.
+     */
+    virtual HttpAppFramework &setWorkerProcesses(size_t num) = 0;
+
+    /// Get the number set by the above method.
+    virtual size_t getWorkerProcesses() const = 0;
+
+    /// Get the index of the worker process running the application, from 0,
+    /// which is the index of the single process without worker processes.
+    virtual size_t getWorkerIndex() const = 0;
+
+    /// Run the task in the compute pool.
+    virtual void runInComputePool(std::function<void()> &&task) = 0;
+
+    /**
+     * @brief Run the function in the compute pool, then pass its result to the
+     * callback in the IO loop of the calling thread, or in the compute pool if
+     * the calling thread runs no loop.
+     *
+     * @param exceptionCallback Called instead of the callback if the function
+     * throws. The exception is logged if it is empty.
+     */
+    template <typename Function, typename Callback>
+    void offload(Function &&function,
+                 Callback &&callback,
+                 std::function<void(const std::exception_ptr &)>
+                     exceptionCallback = nullptr)
+    {
+        using Result = std::invoke_result_t<std::decay_t<Function>>;
+        auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        runInComputePool([function = std::forward<Function>(function),
+                          callback = std::forward<Callback>(callback),
+                          exceptionCallback = std::move(exceptionCallback),
+                          loop]() mutable {
+            std::function<void()> done;
+            try
+            {
+                if constexpr (std::is_void_v<Result>)
+                {
+                    function();
+                    done = std::move(callback);
+                }
+                else
+                {
+                    done = [callback = std::move(callback),
+                            result = function()]() mutable {
+                        callback(std::move(result));
+                    };
+                }
+            }
+            catch (...)
+            {
+                done = [exceptionCallback = std::move(exceptionCallback),
+                        exception = std::current_exception()]() {
+                    if (exceptionCallback)
+                    {
+                        exceptionCallback(exception);
+                        return;
+                    }
+                    try
+                    {
+                        std::rethrow_exception(exception);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        LOG_ERROR << "Exception in offloaded task: "
+                                  << e.what();
+                    }
+                    catch (...)
+                    {
+                        LOG_ERROR << "Exception in offloaded task";
+                    }
+                };
+            }
+            if (loop)
+                loop->queueInLoop(std::move(done));
+            else
+                done();
+        });
+    }
+#ifdef __cpp_impl_coroutine
+    /**
+     * @brief Run the function in the compute pool, this is the coroutine
+     * version of the above method. The coroutine is resumed in the IO loop
+     * it is suspended in.
+     * @code
+       auto thumbnail = co_await app().offloadCoro(
+           [&image]() { return resize(image, 128, 128); });
+       @endcode
+     */
+    template <typename Function>
+    internal::OffloadAwaiter<std::invoke_result_t<std::decay_t<Function>>>
+    offloadCoro(Function &&function)
+    {
+        using Result = std::invoke_result_t<std::decay_t<Function>>;
+        return internal::OffloadAwaiter<Result>(
+            std::function<Result()>(std::forward<Function>(function)), *this);
+    }
+#endif
+
     /// Set the global cert file and private key file for https
     /// These options can be configured in the configuration file.
     virtual HttpAppFramework &setSSLFiles(const std::string &certPath,
@@ -825,6 +1198,19 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// is to use the new SSL certificate without stopping the framework.
     virtual HttpAppFramework &reloadSSLFiles() = 0;
 
+    /// Reload the cert files of the https servers on a schedule
+    /**
+     * @param seconds The interval of the reloads, 0 (the default) disables
+     * them. The certificates rotated by an external agent (e.g. certbot or a
+     * secret manager writing the files) are then picked up without calling
+     * reloadSSLFiles().
+     *
+     * @note
+     * This operation can be performed by the reload_interval option of the
+     * ssl section in the configuration file.
+     */
+    virtual HttpAppFramework &setSSLReloadInterval(double seconds) = 0;
+
     /// Add plugins
     /**
      * @param configs The plugins array
@@ -857,6 +1243,14 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      * @param useOldTLS if true, the TLS1.0/1.1 are enabled for HTTPS
      * connections.
      * @param sslConfCmds vector of ssl configuration key/value pairs.
+     * @param proxyProtocol if true, the connections begin with the PROXY
+     * protocol header (v1 or v2) of a load balancer, and the client address
+     * it carries is the peer address of the requests, of the connection limit
+     * per IP and of the new connection advices. It can't be used with
+     * useSSL, the load balancer terminates TLS.
+     * @param socketOptions the options of the listening socket and of the
+     * connections it accepts, applied before the callbacks set by
+     * setBeforeListenSockOptCallback() and setAfterAcceptSockOptCallback().
      *
      * @note
      * This operation can be performed by an option in the configuration file.
@@ -869,7 +1263,9 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         const std::string &keyFile = "",
         bool useOldTLS = false,
         const std::vector<std::pair<std::string, std::string>> &sslConfCmds =
-            {}) = 0;
+            {},
+        bool proxyProtocol = false,
+        const ListenerSocketOptions &socketOptions = {}) = 0;
 
     /// Enable sessions supporting.
     /**
@@ -913,6 +1309,50 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
                              idGeneratorCallback);
     }
 
+    /// Let the sessions read their data without locking.
+    /**
+     * @param enable If it is true, every change of the data of a session
+     * copies the data and atomically publishes the copy, so reading the data
+     * never waits for the other requests of the same session. That suits the
+     * sessions which are read by every request and seldom changed.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableSessionCopyOnWrite(bool enable = true) = 0;
+
+    /// Keep the sessions in a store shared by several instances.
+    /**
+     * @param store The session store, the sessions are kept in the memory of
+     * the process if it is nullptr (the default).
+     * @param nearCacheTtl The number of seconds for which a session loaded
+     * from the store is reused without loading it again. The data written by
+     * other instances may be seen that late, 0 loads the session for every
+     * request.
+     *
+     * @note
+     * The data of a session is written back to the store when the response
+     * is sent, only if it has been changed. Only the values of std::string,
+     * bool, the integer types, float, double and Json::Value are kept in the
+     * store. The session destroying advices are not called for the sessions
+     * expired in the store.
+     * This method must be called before running the application.
+     */
+    virtual HttpAppFramework &setSessionStore(SessionStorePtr store,
+                                              size_t nearCacheTtl = 5) = 0;
+
+    /// Keep the sessions in Redis.
+    /**
+     * @param redisClientName The name of the redis client used by the
+     * RedisSessionStore, which is created when the application runs.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setRedisSessionStore(
+        const std::string &redisClientName = "default",
+        size_t nearCacheTtl = 5) = 0;
+
     /// Register an advice called when starting a new session.
     /**
      * @param advice is called with the session id.
@@ -1065,6 +1505,38 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &disableSigtermHandling() = 0;
 
+    /**
+     * @brief Reload the configuration file loaded by loadConfigFile() and
+     * apply the settings which can change while the application runs, in the
+     * main loop. The connections and the caches are kept.
+     *
+     * The reloaded settings are use_gzip, use_brotli, use_zstd,
+     * zstd_compression_level, static_files_cache_time,
+     * idle_connection_timeout (for the new connections), request_deadline,
+     * header_timeout, body_timeout, min_body_rate, keepalive_requests,
+     * pipelining_requests, client_max_body_size,
+     * client_max_memory_body_size, client_max_websocket_message_size and
+     * the log level, as well as the configurations of the plugins which
+     * support it (see PluginBase::reloadConfig()). The other settings are
+     * ignored until the application is restarted.
+     *
+     * The errors are logged and leave every setting unchanged: the values
+     * are all checked before any is applied, and the plugins reloaded before
+     * one rejecting its configuration get their previous one back.
+     */
+    virtual void reloadConfigFile() = 0;
+
+    /**
+     * @brief Reload the configuration file on SIGHUP, see reloadConfigFile().
+     * The signal is checked by the main loop every second. The worker
+     * processes are sent the signal by the master. Disabled by default.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableConfigReloadOnSighup(
+        bool enable = true) = 0;
+
     /// Make the application restart after crashing.
     /**
      * Disabled by default.
@@ -1161,11 +1633,81 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Return true if brotli is enabled.
     virtual bool isBrotliEnabled() const = 0;
 
+    /// Enable zstd compression.
+    /**
+     * @param useZstd if the parameter is true, use zstd to compress the
+     * response body's content when the client accepts it. zstd is preferred
+     * to brotli and gzip;
+     * The default value is false.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * After zstd is enabled, zstd is used under the same conditions as gzip
+     * and brotli. Request bodies with the zstd content encoding are
+     * decompressed if compressed requests are enabled, whether zstd responses
+     * are enabled or not.
+     */
+    virtual HttpAppFramework &enableZstd(bool useZstd) = 0;
+
+    /// Return true if zstd is enabled.
+    virtual bool isZstdEnabled() const = 0;
+
+    /// Set the zstd compression level of responses.
+    /**
+     * @param level from 1 (fastest) to 19, 3 by default.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setZstdCompressionLevel(int level) = 0;
+
+    /// Return the zstd compression level of responses.
+    virtual int getZstdCompressionLevel() const = 0;
+
+    /// Set the zstd dictionary used to compress responses and to decompress
+    /// requests and the responses received by HttpClient.
+    /**
+     * @param dictionary The content of a dictionary trained with
+     * `zstd --train`, empty (the default) means no dictionary.
+     *
+     * @note
+     * A dictionary improves the ratio of small bodies a lot, but the peers
+     * must be set up with the same dictionary, so it is only suited for
+     * service-to-service traffic. This operation can be performed by an option
+     * in the configuration file, which gives the path of the dictionary file.
+     */
+    virtual HttpAppFramework &setZstdDictionary(std::string dictionary) = 0;
+
+    /// Return the zstd dictionary.
+    virtual const std::string &getZstdDictionary() const = 0;
+
+    /// Set the size of the compressed body cache of each IO thread.
+    /**
+     * @param bytes The maximum number of bytes (uncompressed plus compressed
+     * bodies) kept by each IO thread, the least recently used bodies are
+     * evicted first. 0 (the default) disables the cache.
+     *
+     * @note
+     * When a response is compressed with gzip, brotli or zstd, its
+     * compressed body is cached by the hash of the original body, so that
+     * dynamic responses returning the same bytes repeatedly are compressed
+     * only once. If the PromExporter plugin is loaded, the hits and misses
+     * are exported as the drogon_compressed_body_cache_total counter.
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setCompressedBodyCacheSize(size_t bytes) = 0;
+
+    /// Return the size of the compressed body cache of each IO thread.
+    virtual size_t getCompressedBodyCacheSize() const = 0;
+
     /// Set the time in which the static file response is cached in memory.
     /**
      * @param cacheTime in seconds. 0 means always cached, negative means no
      * cache
      *
+     * On Linux, the cached responses are also dropped as soon as their files
+     * change.
+     *
      * @note
      * This operation can be performed by an option in the configuration file.
      */
@@ -1174,6 +1716,21 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Get the time set by the above method.
     virtual int staticFilesCacheTime() const = 0;
 
+    /// Set the memory budget of the static file cache shared by all the IO
+    /// threads.
+    /**
+     * @param bytes 64 MiB by default, 0 disables the cache. The least recently
+     * used responses are evicted first, files larger than a quarter of the
+     * budget are not cached.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setStaticFilesCacheSize(size_t bytes) = 0;
+
+    /// Get the size set by the above method.
+    virtual size_t getStaticFilesCacheSize() const = 0;
+
     /// Set the lifetime of the connection without read or write
     /**
      * @param timeout in seconds. 60 by default. Setting the timeout to 0 means
@@ -1199,6 +1756,121 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         return setIdleConnectionTimeout((size_t)timeout.count());
     }
 
+    /// Set the time to answer a request, counted from its arrival
+    /**
+     * @param timeout in seconds. 0 by default, which means no deadline.
+     *
+     * The deadline of a request is passed to the database, redis and http
+     * client calls awaited by the coroutines of its handler, which throw
+     * timeout errors once it passes instead of holding upstream capacity
+     * for an abandoned request. See HttpRequest::setDeadline().
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setRequestDeadline(double timeout) = 0;
+
+    /// Get the timeout set by the above method.
+    virtual double getRequestDeadline() const = 0;
+
+    /// Close the connections of the clients that send requests too slowly
+    /**
+     * @param headerTimeout The time in seconds from the first byte of a
+     * request to the end of its headers. 0 by default, which means no limit.
+     * @param bodyTimeout The time in seconds to receive the body of a
+     * request, counted from the end of its headers. 0 by default, which means
+     * no limit.
+     * @param minBodyRate The body timeout is extended by one second for every
+     * minBodyRate bytes received. 0 by default.
+     *
+     * Otherwise a client that sends its requests a few bytes at a time holds
+     * its connections until the idle timeout. The connections closed this way
+     * are counted for their client, which is refused new connections for a
+     * minute once the count reaches the limit set by
+     * setMaxConnectionNumPerIP().
+     *
+     * @note
+     * This operation can be performed by options in the configuration file.
+     */
+    virtual HttpAppFramework &setSlowClientTimeouts(double headerTimeout,
+                                                    double bodyTimeout,
+                                                    size_t minBodyRate) = 0;
+
+    /// Send early hints to the GET requests of a path
+    /**
+     * @param path The path of the requests, a path ending with '*' is a
+     * prefix of the paths.
+     * @param links The values of the Link headers, e.g.
+     * "</css/app.css>; rel=preload; as=style".
+     *
+     * The links are sent in a 103 Early Hints response as soon as the request
+     * is received, so the client fetches them while the handler prepares the
+     * page. A path matches its own links or else the links of the first
+     * prefix added that matches it. See HttpRequest::sendEarlyHints() to send
+     * them from a handler.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &addEarlyHints(
+        const std::string &path,
+        const std::vector<std::string> &links) = 0;
+
+    /// Trace the phases of a sample of the requests
+    /**
+     * @param sampleRate The fraction of the requests traced, from 0 to 1. 0
+     * by default, which disables the tracing.
+     * @param serverTiming If true, the phases of a traced request are added
+     * to its response in a Server-Timing header.
+     *
+     * The time a traced request spends parsing, routing, in the middlewares,
+     * in its handler and so on is observed by the
+     * drogon_http_phase_duration_seconds metric when the builtin metrics are
+     * enabled and can be logged by the $phase_ placeholders of the
+     * AccessLogger plugin.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setPhaseTracing(double sampleRate,
+                                              bool serverTiming = false) = 0;
+
+    /// Watch the IO loops for the handlers which block them
+    /**
+     * @param threshold The time in seconds after which a loop which has not
+     * come back to its events is reported as stalled. 0 by default, which
+     * disables the watchdog.
+     *
+     * A stall is logged as a warning with the handler running on the loop
+     * and, on Linux, a stack sample of the loop thread. The lag, the
+     * utilization and the stalls of the loops are observed by the
+     * drogon_loop_* metrics when the builtin metrics are enabled.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setLoopStallThreshold(double threshold) = 0;
+
+    /// Restart the application without closing its listening sockets
+    /**
+     * @param path The path of the unix socket on which the listening sockets
+     * are handed over. Empty by default, which disables the hot restart.
+     * @param drainTimeout The time in seconds after which the connections
+     * still open in the replaced process are closed.
+     *
+     * A process started with the same path while another one serves it takes
+     * the listening sockets of that process, so no connection waiting in
+     * their queues is refused. Once it listens, the old process answers its
+     * pending requests with "Connection: close", closes its idle connections
+     * and quits when all of them are closed. The listeners of the new process
+     * must be the same, and the hot restart is only supported on Linux.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setHotRestartSocket(const std::string &path,
+                                                  double drainTimeout = 30) = 0;
+
     /// Set the 'server' header field in each response sent by drogon.
     /**
      * @param server empty string by default with which the 'server' header
@@ -1226,6 +1898,24 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &enableDateHeader(bool flag) = 0;
 
+    /// Control if ETags are generated for the responses of the handlers
+    /**
+     * If enabled, a 200 response to a GET request whose body is in memory
+     * gets a weak ETag of the hash of its body, and the responses with an
+     * ETag, computed or set by their handler, are answered with a 304
+     * response when the If-None-Match header of the request matches it, before
+     * their compression. The clients that poll a resource get its body only
+     * when it changes.
+     *
+     * A handler which knows the version of its resource can set it as the
+     * ETag and check HttpRequest::isNotModified() to skip generating the body.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The ETags are not generated by default.
+     */
+    virtual HttpAppFramework &enableDynamicETags(bool flag) = 0;
+
     /// Set the maximum number of requests that can be served through one
     /// keep-alive connection.
     /**
@@ -1273,6 +1963,33 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &setBrStatic(bool useGzipStatic) = 0;
 
+    /// Compress the static files which have no precompressed sibling.
+    /**
+     * If it is enabled, the first request accepting br or gzip (as allowed by
+     * the br_static and gzip_static options) for a text file without a
+     * ".br" or ".gz" sibling is answered uncompressed, while the file is
+     * compressed at the highest ratio on a background thread. The following
+     * requests are sent the compressed file. Use `drogon_ctl precompress` at
+     * deploy time to make the siblings beforehand.
+     *
+     * @param enable false by default.
+     * @param cachePath The directory of the compressed files, a directory in
+     * the temporary directory of the system if it is empty. Compressed files
+     * are named after the path and the ETag of their sources, so this
+     * directory can be kept across restarts. It is created with the mode
+     * 0700, and nothing is compressed if it is not owned by the user of the
+     * process or if other users can write to it.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableStaticFilesCompression(
+        bool enable,
+        const std::string &cachePath = "") = 0;
+
+    /// Return true if the static files are compressed by drogon.
+    virtual bool isStaticFilesCompressionEnabled() const = 0;
+
     /// Set the max body size of the requests received by drogon.
     /**
      * The default value is 1M.
@@ -1292,6 +2009,21 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &setClientMaxMemoryBodySize(size_t maxSize) = 0;
 
+    /// Set the total memory of the request bodies kept in memory.
+    /**
+     * There is no limit by default. The bodies of all the connections share
+     * this budget. When it is used up, a body with a content-length waits,
+     * its connection stops reading until other requests release their
+     * bodies, and a chunked body is stored to a temporary file. A body
+     * larger than the budget is always stored to a temporary file.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The limits of a route are set by a BodyLimit constraint, see
+     * registerHandler().
+     */
+    virtual HttpAppFramework &setClientBodyMemoryBudget(size_t budget) = 0;
+
     /// Set the max size of messages sent by WebSocket client.
     /**
      * The default value is 128K.
@@ -1301,6 +2033,17 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     virtual HttpAppFramework &setClientMaxWebSocketMessageSize(
         size_t maxSize) = 0;
 
+    /// Set the options of the permessage-deflate extension of WebSocket.
+    /**
+     * The extension is disabled by default. When it is enabled, the server
+     * accepts the offers of the clients within the limits of the options and
+     * compresses the messages not smaller than the threshold.
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setWebSocketCompressionOptions(
+        const WebSocketCompressionOptions &options) = 0;
+
     // Set the HTML file of the home page, the default value is "index.html"
     /**
      * If there isn't any handler registered to the path "/", the home page file
@@ -1393,12 +2136,24 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
 
     /// Get a 'fast' database client by name
     /**
+     * @return The client of the current IO thread or of the main loop, it
+     * must only be used in that thread.
+     * @throw std::runtime_error in the other threads, including the handler
+     * loops (see setHandlerThreadNum()), which have no fast client.
      * @note
      * This method must be called after the framework has been run.
      */
     virtual orm::DbClientPtr getFastDbClient(
         const std::string &name = "default") = 0;
 
+    /// Get a sharded database client by name
+    /**
+     * @note
+     * This method must be called after the framework has been run.
+     */
+    virtual orm::ShardedDbClientPtr getShardedDbClient(
+        const std::string &name) = 0;
+
     /**
      * @brief Check if all database clients in the framework are available
      * (connect to the database successfully).
@@ -1415,6 +2170,14 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
 
     /// Get a 'fast' redis client by name
     /**
+     * @return The client of the current IO thread, created for a client
+     * configured with isFast or a positive fastConnectionNum. Its commands
+     * are sent without locking or switching threads, so it must only be used
+     * in that thread. If the current thread isn't an IO thread, the shared
+     * client of the same name is returned if there is one.
+     * @throw std::runtime_error in the threads other than the IO loops and
+     * the main loop, such as the handler loops, if there is no shared client
+     * of the same name.
      * @note
      * This method must be called after the framework has been run.
      */
@@ -1436,6 +2199,22 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      * string.
      */
     virtual size_t getJsonParserStackLimit() const noexcept = 0;
+
+    /**
+     * @brief Set the parser and writer of the JSON bodies of requests and
+     * responses. The default backend is JsonBackend::create("jsoncpp").
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file,
+     * with the name of a built-in backend.
+     */
+    virtual HttpAppFramework &setJsonBackend(
+        const std::shared_ptr<JsonBackend> &backend) = 0;
+
+    /// Get the parser and writer of the JSON bodies
+    virtual const std::shared_ptr<JsonBackend> &getJsonBackend()
+        const noexcept = 0;
+
     /**
      * @brief This method is to enable or disable the unicode escaping (\\u) in
      * the json string of HTTP responses or requests. it works (disable
@@ -1509,6 +2288,23 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
 
     virtual HttpAppFramework &addDbClient(const orm::DbConfig &config) = 0;
 
+    /// Create a sharded database client
+    /**
+     * @param name The client name.
+     * @param shards The names of the database clients among which the shard
+     * keys are spread, they must be neither fast nor sharded.
+     * @param shardMap The keys pinned to a shard by its name.
+     * @param virtualNodes The points of every shard on the hash ring.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &addShardedDbClient(
+        const std::string &name,
+        const std::vector<std::string> &shards,
+        const std::map<std::string, std::string> &shardMap = {},
+        size_t virtualNodes = 160) = 0;
+
     /// Create a redis client
     /**
      * @param ip IP of redis server.
@@ -1518,6 +2314,19 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      * @param password Password for the redis server
      * @param connectionNum The number of connections to the redis server.
      * @param isFast Indicates if the client is a fast database client.
+     * @param cluster The server is a node of a Redis Cluster, connectionNum
+     * connections are then made to every node, see
+     * RedisClient::newRedisClusterClient(). Not supported by fast clients.
+     * @param fastConnectionNum If it's positive and isFast is false, a fast
+     * client with this number of connections is also created for every IO
+     * thread and returned by getFastRedisClient() with the same name. If
+     * isFast is true, it overrides connectionNum.
+     * @param sentinelMaster If it's not empty, the server is a Redis Sentinel
+     * and this is the name of the replication group it monitors, the client
+     * follows the primary of the group, see
+     * RedisClient::newRedisSentinelClient(). Not supported by fast clients.
+     * @param replicaReads With sentinelMaster, send the read-only commands to
+     * the replicas of the group.
      *
      * @note
      * This operation can be performed by an option in the configuration file.
@@ -1531,7 +2340,11 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
         bool isFast = false,
         double timeout = -1.0,
         unsigned int db = 0,
-        const std::string &username = "") = 0;
+        const std::string &username = "",
+        bool cluster = false,
+        size_t fastConnectionNum = 0,
+        const std::string &sentinelMaster = "",
+        bool replicaReads = false) = 0;
 
     /// Get the DNS resolver
     /**
@@ -1585,6 +2398,44 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
      */
     virtual bool reusePort() const = 0;
 
+    /**
+     * @brief Enable HTTP/2 or not. If it is enabled, the https listeners
+     * offer h2 by ALPN, and the clients of the http listeners may upgrade to
+     * h2c or start with the HTTP/2 preface. The requests of all the streams
+     * of a connection go through the same routing, middlewares and
+     * controllers as the HTTP/1 ones. If this method is not called, the
+     * feature is disabled.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableHttp2(bool enable = true) = 0;
+
+    /**
+     * @brief Return if HTTP/2 is enabled.
+     */
+    virtual bool isHttp2Enabled() const = 0;
+
+    /**
+     * @brief Enable HTTP/3 or not. If it is enabled, every https listener
+     * also accepts the QUIC connections of HTTP/3 clients on the UDP port of
+     * the same number, with the same certificate, and the responses
+     * advertise them with the Alt-Svc header. The requests go through the
+     * same routing, middlewares and controllers as the other ones, the ones
+     * sent in 0-RTT data are only handled if their method is safe. If this
+     * method is not called, the feature is disabled.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * It has no effect if drogon is built without quiche.
+     */
+    virtual HttpAppFramework &enableHttp3(bool enable = true) = 0;
+
+    /**
+     * @brief Return if HTTP/3 is enabled.
+     */
+    virtual bool isHttp3Enabled() const = 0;
+
     /**
      * @brief handler will be called upon an exception escapes a request handler
      */
@@ -1660,17 +2511,64 @@ inline HttpAppFramework &app()
 #ifdef __cpp_impl_coroutine
 namespace internal
 {
-inline void ForwardAwaiter::await_suspend(
+// The local handlers which respond at once complete the calls
+inline bool ForwardAwaiter::await_suspend(
     std::coroutine_handle<> handle) noexcept
 {
     app_.forward(
         req_,
         [this, handle](const drogon::HttpResponsePtr &resp) {
             setValue(resp);
-            handle.resume();
+            resumeIfSuspended(handle);
         },
         host_,
         timeout_);
+    return suspendUnlessCompleted();
+}
+
+inline bool SubrequestAwaiter::await_suspend(
+    std::coroutine_handle<> handle) noexcept
+{
+    app_.subrequest(req_,
+                    [this, handle](const drogon::HttpResponsePtr &resp) {
+                        setValue(resp);
+                        resumeIfSuspended(handle);
+                    });
+    return suspendUnlessCompleted();
+}
+
+inline bool SubrequestsAwaiter::await_suspend(
+    std::coroutine_handle<> handle) noexcept
+{
+    app_.subrequests(std::move(reqs_),
+                     [this, handle](std::vector<HttpResponsePtr> &&resps) {
+                         setValue(std::move(resps));
+                         resumeIfSuspended(handle);
+                     });
+    return suspendUnlessCompleted();
+}
+
+template <typename T>
+inline void OffloadAwaiter<T>::await_suspend(std::coroutine_handle<> handle)
+{
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    app_.runInComputePool([this, handle, loop]() {
+        try
+        {
+            if constexpr (std::is_void_v<T>)
+                task_();
+            else
+                this->setValue(task_());
+        }
+        catch (...)
+        {
+            this->setException(std::current_exception());
+        }
+        if (loop)
+            loop->queueInLoop([handle]() { handle.resume(); });
+        else
+            handle.resume();
+    });
 }
 }  // namespace internal
 #endif
@@ -21,12 +21,14 @@
 #include <drogon/DrClassMap.h>
 #include <drogon/DrObject.h>
 #include <drogon/utils/FunctionTraits.h>
+#include <drogon/utils/HttpConstraint.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/HttpRequest.h>
 #include <deque>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 namespace drogon
 {
@@ -70,10 +72,27 @@ struct BinderArgTypeTraits<const T &>
     static const bool isValid = true;
 };
 
+template <typename T, typename = void>
+struct HasParameterConverter : std::false_type
+{
+};
+
+template <typename T>
+struct HasParameterConverter<
+    T,
+    std::void_t<decltype(ParameterConverter<T>::fromString(
+        std::declval<std::string_view>()))>> : std::true_type
+{
+};
+
 template <typename T>
 T getHandlerArgumentValue(std::string &&p)
 {
-    if constexpr (internal::CanConstructFromString<T>::value)
+    if constexpr (HasParameterConverter<T>::value)
+    {
+        return ParameterConverter<T>::fromString(p);
+    }
+    else if constexpr (internal::CanConstructFromString<T>::value)
     {
         return T(std::move(p));
     }
@@ -106,55 +125,6 @@ inline std::string getHandlerArgumentValue<std::string>(std::string &&p)
     return std::move(p);
 }
 
-template <>
-inline int getHandlerArgumentValue<int>(std::string &&p)
-{
-    return std::stoi(p);
-}
-
-template <>
-inline long getHandlerArgumentValue<long>(std::string &&p)
-{
-    return std::stol(p);
-}
-
-template <>
-inline long long getHandlerArgumentValue<long long>(std::string &&p)
-{
-    return std::stoll(p);
-}
-
-template <>
-inline unsigned long getHandlerArgumentValue<unsigned long>(std::string &&p)
-{
-    return std::stoul(p);
-}
-
-template <>
-inline unsigned long long getHandlerArgumentValue<unsigned long long>(
-    std::string &&p)
-{
-    return std::stoull(p);
-}
-
-template <>
-inline float getHandlerArgumentValue<float>(std::string &&p)
-{
-    return std::stof(p);
-}
-
-template <>
-inline double getHandlerArgumentValue<double>(std::string &&p)
-{
-    return std::stod(p);
-}
-
-template <>
-inline long double getHandlerArgumentValue<long double>(std::string &&p)
-{
-    return std::stold(p);
-}
-
 class HttpBinderBase
 {
   public:
@@ -169,6 +139,30 @@ class HttpBinderBase
     virtual ~HttpBinderBase()
     {
     }
+
+    void setBodyLimit(const BodyLimit &bodyLimit)
+    {
+        bodyLimit_ = bodyLimit;
+    }
+
+    const BodyLimit &bodyLimit() const
+    {
+        return bodyLimit_;
+    }
+
+    void setOffload(bool offload)
+    {
+        offload_ = offload;
+    }
+
+    bool offload() const
+    {
+        return offload_;
+    }
+
+  private:
+    BodyLimit bodyLimit_;
+    bool offload_{false};
 };
 
 template <typename T>
@@ -289,7 +283,25 @@ class HttpBinder : public HttpBinderBase
                 "reference type or right reference type");
             using ValueType = std::remove_cv_t<
                 std::remove_reference_t<nth_argument_type<sizeof...(Values)>>>;
-            if (!pathArguments.empty())
+            if constexpr (std::is_same_v<ValueType, std::string_view>)
+            {
+                // Views of the copies of the arguments kept by the request,
+                // valid as long as the request
+                std::string_view v;
+                if (!pathArguments.empty())
+                {
+                    auto &params = req->getRoutingParameters();
+                    v = params[params.size() - pathArguments.size()];
+                    pathArguments.pop_front();
+                }
+                run(pathArguments,
+                    req,
+                    std::move(callback),
+                    std::forward<Values>(values)...,
+                    std::move(v));
+                return;
+            }
+            else if (!pathArguments.empty())
             {
                 std::string v{std::move(pathArguments.front())};
                 pathArguments.pop_front();
@@ -36,17 +36,69 @@ namespace drogon
 {
 class HttpClient;
 using HttpClientPtr = std::shared_ptr<HttpClient>;
+
+/**
+ * @brief The flow control of a response body received by
+ * HttpClient::sendRequestForStream(). The methods can be called in any thread.
+ */
+class DROGON_EXPORT HttpBodyStream
+{
+  public:
+    virtual ~HttpBodyStream() = default;
+
+    /// Stop reading from the connection until resume() is called, so the
+    /// server is held back by the flow control of TCP.
+    virtual void pause() = 0;
+
+    virtual void resume() = 0;
+
+    /// Close the connection, no callback of the request is called after.
+    virtual void cancel() = 0;
+};
+
+using HttpBodyStreamPtr = std::shared_ptr<HttpBodyStream>;
+using HttpStreamHeadersCallback =
+    std::function<void(const HttpResponsePtr &, const HttpBodyStreamPtr &)>;
+using HttpStreamDataCallback =
+    std::function<void(const char *data, size_t length)>;
+
 #ifdef __cpp_impl_coroutine
+class HttpBodyReader;
+using HttpBodyReaderPtr = std::shared_ptr<HttpBodyReader>;
+
 namespace internal
 {
-struct HttpRespAwaiter : public CallbackAwaiter<HttpResponsePtr>
+struct HttpStreamAwaiter : public CallbackAwaiter<HttpBodyReaderPtr>
+{
+    HttpStreamAwaiter(HttpClient *client,
+                      HttpRequestPtr req,
+                      double timeout,
+                      size_t highWatermark)
+        : client_(client),
+          req_(std::move(req)),
+          timeout_(timeout),
+          highWatermark_(highWatermark)
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+  private:
+    HttpClient *client_;
+    HttpRequestPtr req_;
+    double timeout_;
+    size_t highWatermark_;
+};
+
+struct HttpRespAwaiter : public DeadlineAwaiter<HttpResponsePtr>
 {
     HttpRespAwaiter(HttpClient *client, HttpRequestPtr req, double timeout)
         : client_(client), req_(std::move(req)), timeout_(timeout)
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle);
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle);
 
   private:
     HttpClient *client_;
@@ -110,6 +162,11 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
      * sent, so calling this method with a same request object in different
      * thread is dangerous.
      * Please be careful when using timeout on an non-idempotent request.
+     * The body set by HttpRequest::setBodyFile() or
+     * HttpRequest::setBodyGenerator(), or the files of an upload, of a
+     * request with the `Expect: 100-continue` header is sent once the server
+     * answers 100 (Continue), or after one second without an answer. If the
+     * final response comes first, the body is not sent.
      */
     virtual void sendRequest(const HttpRequestPtr &req,
                              const HttpReqCallback &callback,
@@ -278,6 +335,81 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
     }
 #endif
 
+    /**
+     * @brief Send a request and receive the response body in pieces as they
+     * arrive, instead of in a response holding the whole body.
+     *
+     * @param req The request sent to the server, on a connection of its own
+     * which is closed after the response.
+     * @param headersCallback Called with the response once its header is
+     * received, the body of the response is empty. The stream paces the
+     * reading of the connection, e.g. to wait for a slow consumer.
+     * @param dataCallback Called with each piece of the body. The gzip, br
+     * and zstd content codings are decoded as by sendRequest().
+     * @param finishCallback Always called last, unless the stream is
+     * cancelled, with ReqResult::Ok once the whole body is received. The
+     * response is nullptr if the header was not received.
+     * @param timeout In seconds. If the response header is not received
+     * within the timeout, finishCallback is called with ReqResult::Timeout.
+     * The zero value by default disables the timeout.
+     *
+     * @note All the callbacks are called in the event loop of the client.
+     *
+     * @code
+       client->sendRequestForStream(
+           req,
+           [](const HttpResponsePtr &resp, const HttpBodyStreamPtr &stream) {
+               LOG_INFO << resp->statusCode();
+           },
+           [file](const char *data, size_t length) {
+               file->write(data, length);
+           },
+           [](ReqResult result, const HttpResponsePtr &resp) {
+               LOG_INFO << "Done: " << result;
+           });
+       @endcode
+     */
+    virtual void sendRequestForStream(const HttpRequestPtr &req,
+                                      HttpStreamHeadersCallback headersCallback,
+                                      HttpStreamDataCallback dataCallback,
+                                      HttpReqCallback finishCallback,
+                                      double timeout = 0) = 0;
+
+#ifdef __cpp_impl_coroutine
+    /**
+     * @brief Send a request via coroutines and read the response body in
+     * pieces from the returned reader.
+     *
+     * @param timeout In seconds, for the response header. A
+     * `drogon::HttpException` with `ReqResult::Timeout` is thrown if it is
+     * not received in time. The zero value by default disables the timeout.
+     * @param highWatermark The bytes of the body buffered by the reader,
+     * reading from the connection pauses beyond them until the coroutine
+     * reads.
+     *
+     * @code
+       auto reader = co_await client->sendRequestForStreamCoro(req);
+       for (;;)
+       {
+           auto data = co_await reader->read();
+           if (data.empty())
+               break;
+           co_await save(data);
+       }
+       @endcode
+     */
+    internal::HttpStreamAwaiter sendRequestForStreamCoro(
+        HttpRequestPtr req,
+        double timeout = 0,
+        size_t highWatermark = 1024 * 1024)
+    {
+        return internal::HttpStreamAwaiter(this,
+                                           std::move(req),
+                                           timeout,
+                                           highWatermark);
+    }
+#endif
+
     /// Set socket options(before connecting)
     /**
      * @brief Set the callback which is called before connecting to the
@@ -308,6 +440,42 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
      */
     virtual void setPipeliningDepth(size_t depth) = 0;
 
+    /// Enable HTTP/2 for the client
+    /**
+     * With HTTP/2, the requests are sent at once as concurrent streams of one
+     * connection, up to the limit set by the server, and the pipelining depth
+     * is ignored. Over TLS, h2 is offered by ALPN and the client falls back
+     * to HTTP/1.1 if the server does not select it. Over cleartext, the
+     * server must support h2c with prior knowledge (RFC 9113 3.3).
+     *
+     * @note This method must be called before the first request is sent. The
+     * requests for server-sent events always use HTTP/1.1.
+     */
+    virtual void enableHttp2(bool enable = true) = 0;
+
+    /// Enable the HTTP cache for the client
+    /**
+     * The responses to the GET requests are cached as RFC 9111 describes: a
+     * fresh response is served without a request, a stale one is revalidated
+     * with its ETag or Last-Modified, or served during its
+     * stale-while-revalidate window while it is revalidated in the
+     * background, and the variants listed by Vary are kept apart. The
+     * concurrent misses of a URL are collapsed into one request. A successful
+     * POST, PUT, PATCH or DELETE request removes the responses of its URL.
+     *
+     * The cache is shared by all the clients of the process which enable it,
+     * its size is set by setCacheSize(). The responses marked private or
+     * setting cookies are not cached, nor the responses to the requests with
+     * credentials unless they are marked public.
+     */
+    virtual void enableCache(bool enable = true) = 0;
+
+    /**
+     * @brief Set the size limit of the responses cached for the clients with
+     * the cache enabled, in bytes. 64MB by default, 0 disables the cache.
+     */
+    static void setCacheSize(size_t maxBytes);
+
     /// Enable cookies for the client
     /**
      * @param flag if the parameter is true, all requests sent by the client
@@ -372,6 +540,14 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
     /// Get the event loop of the client;
     virtual trantor::EventLoop *getLoop() = 0;
 
+    /**
+     * @brief Set how long the addresses of the host names are cached, in
+     * seconds. The cache is shared by all the HTTP and WebSocket clients of
+     * the process, an entry in use is refreshed in the background before it
+     * expires. 60 by default, 0 disables the cache.
+     */
+    static void setDnsCacheTtl(double seconds);
+
     /// Get the number of bytes sent or received
     virtual size_t bytesSent() const = 0;
     virtual size_t bytesReceived() const = 0;
@@ -495,18 +671,237 @@ class HttpException : public std::exception
     std::string_view message_;
 };
 
-inline void internal::HttpRespAwaiter::await_suspend(
+template <typename Promise>
+inline bool internal::HttpRespAwaiter::await_suspend(
+    std::coroutine_handle<Promise> handle)
+{
+    assert(client_ != nullptr);
+    assert(req_ != nullptr);
+    if (auto deadline = deadlineOf(handle))
+        inheritDeadline(*deadline);
+    if (deadline_)
+    {
+        // The timeout of the client cancels the request at the deadline
+        std::chrono::duration<double> left =
+            *deadline_ - std::chrono::steady_clock::now();
+        if (left.count() <= 0)
+        {
+            setException(
+                std::make_exception_ptr(HttpException(ReqResult::Timeout)));
+            return false;
+        }
+        if (timeout_ <= 0 || left.count() < timeout_)
+            timeout_ = left.count();
+    }
+    {
+        // The request is a child span of the trace of the coroutine
+        TraceScope traceScope(traceContextOf(handle));
+        client_->sendRequest(
+            req_,
+            [handle, this](ReqResult result, const HttpResponsePtr &resp) {
+                if (result == ReqResult::Ok)
+                    setValue(resp);
+                else
+                    setException(
+                        std::make_exception_ptr(HttpException(result)));
+                resumeIfSuspended(handle);
+            },
+            timeout_);
+    }
+    // A response cache hit completes in the call
+    return suspendUnlessCompleted();
+}
+
+/**
+ * @brief The body of a response read from a coroutine, returned by
+ * HttpClient::sendRequestForStreamCoro().
+ *
+ * The body received is buffered up to the high watermark, reading from the
+ * connection pauses beyond it until the coroutine reads. Destroying the
+ * reader before the end of the body closes the connection.
+ */
+class HttpBodyReader : public trantor::NonCopyable,
+                       public std::enable_shared_from_this<HttpBodyReader>
+{
+  public:
+    struct ReadAwaiter : public CallbackAwaiter<std::string>
+    {
+        explicit ReadAwaiter(HttpBodyReaderPtr reader)
+            : reader_(std::move(reader))
+        {
+        }
+
+        // The body buffered is taken without suspending
+        bool await_ready()
+        {
+            return reader_->loop_->isInLoopThread() && reader_->take(this);
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            auto loop = reader_->loop_;
+            loop->runInLoop([this, handle]() {
+                if (!reader_->take(this))
+                {
+                    reader_->waiting_ = handle;
+                    reader_->waiter_ = this;
+                    return;
+                }
+                handle.resume();
+            });
+        }
+
+      private:
+        friend class HttpBodyReader;
+        HttpBodyReaderPtr reader_;
+    };
+
+    HttpBodyReader(trantor::EventLoop *loop, size_t highWatermark)
+        : loop_(loop), highWatermark_(highWatermark)
+    {
+    }
+
+    ~HttpBodyReader()
+    {
+        if (stream_ && !finished_)
+            stream_->cancel();
+    }
+
+    /// The response, with the header but without the body
+    const HttpResponsePtr &response() const
+    {
+        return response_;
+    }
+
+    /**
+     * @brief Await the body received since the last read, an empty string
+     * at the end of the body. A `drogon::HttpException` is thrown if the
+     * body can't be received in full.
+     */
+    ReadAwaiter read()
+    {
+        return ReadAwaiter(shared_from_this());
+    }
+
+    // The callbacks of the request, called in the event loop of the client
+
+    void onHeaders(const HttpResponsePtr &resp, const HttpBodyStreamPtr &stream)
+    {
+        response_ = resp;
+        stream_ = stream;
+    }
+
+    void onData(const char *data, size_t length)
+    {
+        buffer_.append(data, length);
+        if (waiter_)
+        {
+            wake();
+            return;
+        }
+        if (!paused_ && buffer_.size() > highWatermark_)
+        {
+            paused_ = true;
+            stream_->pause();
+        }
+    }
+
+    void onFinish(ReqResult result)
+    {
+        finished_ = true;
+        result_ = result;
+        if (waiter_)
+            wake();
+    }
+
+  private:
+    // Give the buffer or the end of the body to the awaiter, return false if
+    // there is nothing yet.
+    bool take(ReadAwaiter *awaiter)
+    {
+        if (!buffer_.empty())
+        {
+            std::string data;
+            data.swap(buffer_);
+            awaiter->setValue(std::move(data));
+            if (paused_)
+            {
+                paused_ = false;
+                stream_->resume();
+            }
+            return true;
+        }
+        if (!finished_)
+            return false;
+        if (result_ == ReqResult::Ok)
+            awaiter->setValue(std::string{});
+        else
+            awaiter->setException(
+                std::make_exception_ptr(HttpException(result_)));
+        return true;
+    }
+
+    void wake()
+    {
+        auto awaiter = waiter_;
+        auto handle = waiting_;
+        waiter_ = nullptr;
+        waiting_ = nullptr;
+        take(awaiter);
+        handle.resume();
+    }
+
+    trantor::EventLoop *loop_;
+    size_t highWatermark_;
+    HttpResponsePtr response_;
+    HttpBodyStreamPtr stream_;
+    std::string buffer_;
+    bool paused_{false};
+    bool finished_{false};
+    ReqResult result_{ReqResult::Ok};
+    std::coroutine_handle<> waiting_;
+    ReadAwaiter *waiter_{nullptr};
+};
+
+inline void internal::HttpStreamAwaiter::await_suspend(
     std::coroutine_handle<> handle)
 {
     assert(client_ != nullptr);
     assert(req_ != nullptr);
-    client_->sendRequest(
+    auto reader =
+        std::make_shared<HttpBodyReader>(client_->getLoop(), highWatermark_);
+    // The callbacks don't keep the reader, the coroutine owns it once the
+    // header is received.
+    std::weak_ptr<HttpBodyReader> weakReader = reader;
+    client_->sendRequestForStream(
         req_,
-        [handle, this](ReqResult result, const HttpResponsePtr &resp) {
-            if (result == ReqResult::Ok)
-                setValue(resp);
+        [handle, this, reader](const HttpResponsePtr &resp,
+                               const HttpBodyStreamPtr &stream) mutable {
+            reader->onHeaders(resp, stream);
+            setValue(std::move(reader));
+            handle.resume();
+        },
+        [weakReader](const char *data, size_t length) {
+            if (auto reader = weakReader.lock())
+                reader->onData(data, length);
+        },
+        [handle, this, weakReader](ReqResult result, const HttpResponsePtr &) {
+            if (auto reader = weakReader.lock())
+            {
+                if (reader->response())
+                {
+                    reader->onFinish(result);
+                    return;
+                }
+            }
             else
-                setException(std::make_exception_ptr(HttpException(result)));
+            {
+                // The header was received, the reader is gone
+                return;
+            }
+            setException(std::make_exception_ptr(
+                HttpException(result == ReqResult::Ok ? ReqResult::BadResponse
+                                                      : result)));
             handle.resume();
         },
         timeout_);
@@ -0,0 +1,190 @@
+/**
+ *
+ *  @file HttpClientPool.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpClient.h>
+#include <trantor/utils/NonCopyable.h>
+#include <trantor/net/EventLoop.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+class HttpClientPool;
+using HttpClientPoolPtr = std::shared_ptr<HttpClientPool>;
+
+/// A pool of persistent connections to one server
+/**
+ * The pool keeps up to a number of HttpClient connections to the server in
+ * every one of its event loops. A request is sent by a connection of the
+ * loop of the calling thread, or of the next loop in turn if the thread is
+ * not one of them. The idle connection with the fewest requests in flight is
+ * chosen first, a new connection is opened when all of them are busy, and the
+ * request waits in the pool when every connection has reached the maximum
+ * number of requests in flight. So a slow response does not hold up the
+ * requests queued behind it.
+ *
+ * The connections idle for longer than the idle timeout are closed, and the
+ * ones older than the maximum lifetime are replaced once they are idle, the
+ * new connections resolve the domain of the server again.
+ *
+ * @code
+   auto pool = HttpClientPool::newHttpClientPool("http://backend:8080", 8);
+   pool->sendRequest(req, [](ReqResult result, const HttpResponsePtr &resp) {
+       ...
+   });
+   @endcode
+ */
+class DROGON_EXPORT HttpClientPool : public trantor::NonCopyable
+{
+  public:
+    struct Metrics
+    {
+        /// The open connections
+        size_t connections{0};
+        /// The requests sent and not yet answered
+        size_t inFlight{0};
+        /// The requests waiting in the pool for a connection
+        size_t queued{0};
+        /// The requests answered, including the failed ones
+        size_t completed{0};
+        /// The requests which did not get a response
+        size_t failed{0};
+        /// The connections closed because they were idle or too old
+        size_t reaped{0};
+        /// The duplicates sent by the hedging
+        size_t hedged{0};
+        /// The requests answered by their duplicate first
+        size_t hedgesWon{0};
+        /// The requests sent again after a network error
+        size_t retried{0};
+        /// The hedges and retries not sent because the budget was exhausted
+        size_t throttled{0};
+    };
+
+    /**
+     * @brief The hedging of the idempotent requests, see enableHedging().
+     */
+    struct HedgingPolicy
+    {
+        /// The delay in seconds after which a duplicate is sent, 0 derives
+        /// it from the latencies of the last responses
+        double delay{0};
+        /// The percentile of the last latencies used as the delay
+        double percentile{0.95};
+        /// The shortest derived delay in seconds
+        double minDelay{0.005};
+        /// The share of the requests which may be hedged or retried, every
+        /// request adds this many tokens to the budget and every hedge or
+        /// retry takes one
+        double budgetRatio{0.1};
+        /// The tokens the budget holds at most, i.e. the burst of hedges and
+        /// retries allowed after a quiet time
+        double budgetCapacity{10};
+        /// The times a request failed by a network error is sent again
+        size_t maxRetries{1};
+    };
+
+    /**
+     * @brief Send a request asynchronously to the server.
+     *
+     * @param timeout In seconds, counted from the time the request is handed
+     * to a connection. See HttpClient::sendRequest().
+     */
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             HttpReqCallback &&callback,
+                             double timeout = 0) = 0;
+
+    void sendRequest(const HttpRequestPtr &req,
+                     const HttpReqCallback &callback,
+                     double timeout = 0)
+    {
+        HttpReqCallback cb = callback;
+        sendRequest(req, std::move(cb), timeout);
+    }
+
+    /**
+     * @brief Set the maximum number of requests in flight on one connection,
+     * 1 by default. Set it above 1 for the connections which use HTTP/2 or
+     * pipelining.
+     */
+    virtual void setMaxInFlight(size_t maxInFlight) = 0;
+
+    /**
+     * @brief Set the time in seconds after which an idle connection is
+     * closed, 60 by default. 0 keeps the idle connections open.
+     */
+    virtual void setIdleTimeout(double timeout) = 0;
+
+    /**
+     * @brief Set the time in seconds after which a connection is replaced,
+     * so the domain of the server is resolved again. 0 by default, which
+     * keeps the connections as long as they are used.
+     */
+    virtual void setMaxConnectionLifetime(double lifetime) = 0;
+
+    /**
+     * @brief Set the callback called with every new connection, to set it up
+     * (enableHttp2(), setPipeliningDepth(), setUserAgent()...).
+     */
+    virtual void setClientInitializer(
+        std::function<void(const HttpClientPtr &)> initializer) = 0;
+
+    /**
+     * @brief Hedge the idempotent requests (GET, HEAD, OPTIONS, PUT and
+     * DELETE) to cut the tail latency.
+     *
+     * When a request is not answered within the delay, a duplicate is sent
+     * on another connection of the pool, the first response is passed to the
+     * callback and the other one is dropped. The requests which failed by a
+     * network error (ReqResult::NetworkFailure or BadServerAddress) are sent
+     * again, up to maxRetries times. The hedges and the retries share a
+     * budget of the pool, so they never exceed a share of the traffic.
+     *
+     * The requests with a body generator are never duplicated. The
+     * duplicates in flight are not interrupted, the connections stay
+     * usable once they got their responses. The hedges are counted in the
+     * metrics of the pool and, when the builtin metrics are enabled, in
+     * drogon_http_client_retries_total.
+     */
+    virtual void enableHedging(const HedgingPolicy &policy) = 0;
+
+    /// Return the counters of the pool, summed over all its loops.
+    virtual Metrics metrics() const = 0;
+
+    /**
+     * @brief Create a pool of connections to a server.
+     *
+     * @param hostString The server, as in HttpClient::newHttpClient(),
+     * e.g. "https://www.example.com:8443".
+     * @param connectionsPerLoop The maximum number of connections in every
+     * loop.
+     * @param loops The loops of the connections. If it is empty, the IO
+     * loops of the framework, which must be running then, are used.
+     *
+     * @note The setters must be called before the first request is sent.
+     */
+    static HttpClientPoolPtr newHttpClientPool(
+        const std::string &hostString,
+        size_t connectionsPerLoop = 4,
+        const std::vector<trantor::EventLoop *> &loops = {},
+        bool useOldTLS = false,
+        bool validateCert = true);
+
+    virtual ~HttpClientPool() = default;
+};
+}  // namespace drogon
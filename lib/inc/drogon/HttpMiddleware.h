@@ -95,12 +95,14 @@ struct [[nodiscard]] MiddlewareNextAwaiter
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle) noexcept
+    // The handlers which respond at once complete the call
+    bool await_suspend(std::coroutine_handle<> handle) noexcept
     {
         nextCb_([this, handle](const HttpResponsePtr &resp) {
             setValue(resp);
-            handle.resume();
+            resumeIfSuspended(handle);
         });
+        return suspendUnlessCompleted();
     }
 
   private:
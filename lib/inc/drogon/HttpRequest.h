@@ -25,6 +25,9 @@
 #include <trantor/net/InetAddress.h>
 #include <trantor/net/Certificate.h>
 #include <trantor/utils/Date.h>
+#include <charconv>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -49,6 +52,96 @@ T fromRequest(const HttpRequest &)
     exit(1);
 }
 
+/**
+ * @brief This template is used to convert the path and query parameters bound
+ * to the arguments of HTTP handlers to a custom type. Users must specialize
+ * the template for a particular type, for example:
+ * @code
+   template <>
+   struct drogon::ParameterConverter<Point>
+   {
+       static Point fromString(std::string_view str)
+       {
+           auto comma = str.find(',');
+           if (comma == std::string_view::npos)
+               throw std::invalid_argument("bad point");
+           return {drogon::ParameterConverter<int>::fromString(
+                       str.substr(0, comma)),
+                   drogon::ParameterConverter<int>::fromString(
+                       str.substr(comma + 1))};
+       }
+   };
+   @endcode
+ * An exception thrown by the conversion is handled like the exceptions thrown
+ * by the handlers. The arithmetic types have built-in converters.
+ */
+template <typename T, typename = void>
+struct ParameterConverter
+{
+};
+
+namespace internal
+{
+template <typename T>
+struct IsNumberParameter
+    : std::bool_constant<std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+                         !std::is_same_v<T, char> &&
+                         !std::is_same_v<T, signed char> &&
+                         !std::is_same_v<T, unsigned char> &&
+                         !std::is_same_v<T, wchar_t> &&
+                         !std::is_same_v<T, char16_t> &&
+                         !std::is_same_v<T, char32_t>>
+{
+};
+}  // namespace internal
+
+/**
+ * @brief The numbers are converted with std::from_chars, as leniently as
+ * std::stoi() and std::stod(): leading spaces and a '+' sign are skipped and
+ * the conversion stops at the first character which is not part of the
+ * number. std::invalid_argument or std::out_of_range is thrown on failure.
+ */
+template <typename T>
+struct ParameterConverter<
+    T,
+    std::enable_if_t<internal::IsNumberParameter<T>::value>>
+{
+    static T fromString(std::string_view str)
+    {
+        size_t pos = 0;
+        while (pos < str.size() &&
+               isspace(static_cast<unsigned char>(str[pos])))
+            ++pos;
+        if (pos + 1 < str.size() && str[pos] == '+' && str[pos + 1] != '-')
+            ++pos;
+        str.remove_prefix(pos);
+        T value{};
+#if !defined(__cpp_lib_to_chars)
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            // No std::from_chars for floating point numbers in this library
+            std::string s(str);
+            if constexpr (std::is_same_v<T, float>)
+                return std::stof(s);
+            else if constexpr (std::is_same_v<T, double>)
+                return std::stod(s);
+            else
+                return std::stold(s);
+        }
+        else
+#endif
+        {
+            auto result =
+                std::from_chars(str.data(), str.data() + str.size(), value);
+            if (result.ec == std::errc::invalid_argument)
+                throw std::invalid_argument("Invalid number");
+            if (result.ec == std::errc::result_out_of_range)
+                throw std::out_of_range("Number out of range");
+        }
+        return value;
+    }
+};
+
 /**
  * @brief This template is used to create a request object from a custom
  * type object by calling the newCustomHttpRequest(). Users must specialize
@@ -220,12 +313,66 @@ class DROGON_EXPORT HttpRequest
     virtual const char *bodyData() const = 0;
     virtual size_t bodyLength() const = 0;
 
+    /**
+     * @brief Pass the body to the callback in pieces of at most chunkSize
+     * bytes.
+     *
+     * A body larger than the client_max_memory_body_size is stored in a
+     * temporary file, which body() maps as a whole. This maps one window of
+     * the file at a time instead, so a handler hashing or forwarding a large
+     * upload doesn't fault in the whole file.
+     *
+     * @param callback Called with each piece, return false to stop.
+     * @return false if the callback stopped or the file couldn't be read.
+     */
+    virtual bool bodyChunks(
+        const std::function<bool(std::string_view)> &callback,
+        size_t chunkSize = 1024 * 1024) const = 0;
+
     /// Set the content string of the request.
     virtual void setBody(const std::string &body) = 0;
 
     /// Set the content string of the request.
     virtual void setBody(std::string &&body) = 0;
 
+    /**
+     * @brief Send a range of the file as the body when the request is sent
+     * by HttpClient, instead of reading the file into memory.
+     *
+     * The file is sent by sendfile() on plain connections. It must not change
+     * until the response is received.
+     *
+     * @param path The path of the file.
+     * @param offset The first byte of the body in the file.
+     * @param length The length of the body, 0 for the rest of the file.
+     * @return false if the file can't be read, the body is then unchanged.
+     */
+    virtual bool setBodyFile(const std::string &path,
+                             size_t offset = 0,
+                             size_t length = 0) = 0;
+
+    /**
+     * @brief Send a body produced piece by piece when the request is sent by
+     * HttpClient.
+     *
+     * The generator is called like the callback of
+     * HttpResponse::newStreamResponse(), whenever the connection can take
+     * more data: it writes at most the given number of bytes to the buffer
+     * and returns how many it wrote, 0 at the end of the body. It's called
+     * with a null buffer when the request is done, to release its resources.
+     * So a slow server throttles the generator instead of the body piling up
+     * in memory.
+     *
+     * @param length The length of the body if it's known, sent in the
+     * content-length header. Otherwise the body is sent with the chunked
+     * transfer coding.
+     * @note The body is generated once, the request can't be sent again.
+     * Over HTTP/2 the body is generated into memory before it's sent.
+     */
+    virtual void setBodyGenerator(
+        std::function<std::size_t(char *, std::size_t)> generator,
+        std::optional<size_t> length = std::nullopt) = 0;
+
     /// Get the path of the request.
     virtual const std::string &path() const = 0;
 
@@ -274,6 +421,8 @@ class DROGON_EXPORT HttpRequest
     /**
      * kHttp10 means Http version is 1.0
      * kHttp11 means Http version is 1.1
+     * kHttp2 means the request was received on an HTTP/2 stream
+     * kHttp3 means the request was received on an HTTP/3 stream
      */
     virtual Version version() const = 0;
 
@@ -372,6 +521,44 @@ class DROGON_EXPORT HttpRequest
         return creationDate();
     }
 
+    /**
+     * @brief Set the time point by which the request should be answered. The
+     * coroutines of its handler pass it to the database, redis and http client
+     * calls they await, which throw timeout errors past it. The framework sets
+     * it by the request deadline of the application, filters can change it.
+     */
+    virtual void setDeadline(
+        std::chrono::steady_clock::time_point deadline) = 0;
+
+    /// Return the deadline of the request, if any
+    virtual const std::optional<std::chrono::steady_clock::time_point>
+        &deadline() const = 0;
+
+    const std::optional<std::chrono::steady_clock::time_point> &getDeadline()
+        const
+    {
+        return deadline();
+    }
+
+    /**
+     * @brief Send a 103 Early Hints interim response with a Link header for
+     * each of the links, e.g. "</app.css>; rel=preload; as=style", so the
+     * client fetches them while the final response is being prepared.
+     *
+     * It is called by the handler or a middleware before the final response.
+     * The hints are advisory, they are dropped over HTTP/1.0, after the final
+     * response, and while the responses of the earlier pipelined requests are
+     * not sent.
+     */
+    virtual void sendEarlyHints(const std::vector<std::string> &links) = 0;
+
+    /**
+     * @brief Return true if the If-None-Match header of the request matches
+     * the ETag, the handler can then answer with a 304 response carrying the
+     * ETag without generating the body.
+     */
+    bool isNotModified(const std::string &etag) const;
+
     // Return the peer certificate (if any)
     virtual const trantor::CertificatePtr &peerCertificate() const = 0;
 
@@ -393,6 +580,22 @@ class DROGON_EXPORT HttpRequest
         return jsonObject();
     }
 
+    /**
+     * @brief Get the value at a JSON pointer (RFC 6901) in the JSON body,
+     * e.g. "/user/name".
+     *
+     * If the body was not parsed by getJsonObject() yet, only the requested
+     * value is built when the JSON backend supports it (simdjson), which is
+     * much faster than building the whole document to read a few fields of
+     * a large body. Each call parses the body again, use getJsonObject() to
+     * read many values.
+     *
+     * @return std::nullopt if the body is not valid JSON, or has no value at
+     * the pointer.
+     */
+    virtual std::optional<Json::Value> getJsonAt(
+        std::string_view pointer) const = 0;
+
     /**
      * @brief Get the error message of parsing the JSON body received from peer.
      * This method usually is called after getting a empty shared_ptr object
@@ -403,6 +606,16 @@ class DROGON_EXPORT HttpRequest
      */
     virtual const std::string &getJsonError() const = 0;
 
+    /**
+     * @brief Decode the MessagePack body of the request into a Json::Value.
+     * The body is decoded by every call.
+     *
+     * @param errs Set to the reason when the body is not valid, if not null.
+     * @return nullptr if the body is not valid MessagePack.
+     */
+    std::shared_ptr<Json::Value> getMsgPackObject(
+        std::string *errs = nullptr) const;
+
     /// Get the content type
     virtual ContentType contentType() const = 0;
 
@@ -469,6 +682,17 @@ class DROGON_EXPORT HttpRequest
     /// Create a normal request with http method Get and version Http1.1.
     static HttpRequestPtr newHttpRequest();
 
+    /**
+     * @brief Create a request handled by this application on behalf of the
+     * parent request, see HttpAppFramework::subrequest().
+     *
+     * The subrequest is a GET on the loop of the parent, it shares the
+     * session, the addresses, the trace and the deadline of the parent but
+     * none of its headers or body, the ones the route needs are set by the
+     * caller.
+     */
+    static HttpRequestPtr newSubrequest(const HttpRequestPtr &parent);
+
     /// Create a http request with:
     /// Method: Get
     /// Version: Http1.1
@@ -476,6 +700,14 @@ class DROGON_EXPORT HttpRequest
     /// content of the request.
     static HttpRequestPtr newHttpJsonRequest(const Json::Value &data);
 
+    /// Create a http request with:
+    /// Method: Get
+    /// Version: Http1.1
+    /// Content type: application/msgpack, the @param data is encoded as
+    /// MessagePack into the content of the request. The request accepts
+    /// MessagePack responses.
+    static HttpRequestPtr newHttpMsgPackRequest(const Json::Value &data);
+
     /// Create a http request with:
     /// Method: Post
     /// Version: Http1.1
@@ -487,7 +719,8 @@ class DROGON_EXPORT HttpRequest
     /// Version: Http1.1
     /// Content type: multipart/form-data
     /// The @param files represents pload files which are transferred to the
-    /// server via the multipart/form-data format
+    /// server via the multipart/form-data format. HttpClient sends the files
+    /// from the disk, they are not read into memory.
     static HttpRequestPtr newFileUploadRequest(
         const std::vector<UploadFile> &files);
 
@@ -23,12 +23,18 @@
 #include <drogon/HttpTypes.h>
 #include <drogon/HttpViewData.h>
 #include <drogon/SseWriter.h>
+#include <drogon/utils/JsonWriter.h>
 #include <drogon/utils/Utilities.h>
 #include <json/json.h>
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
 
+#ifdef __cpp_impl_coroutine
+#include <drogon/utils/coroutine.h>
+#endif
+
 namespace drogon
 {
 /// Abstract class for webapp developer to get or set the Http response;
@@ -75,11 +81,37 @@ inline HttpResponsePtr toResponse<Json::Value &>(Json::Value &pJson)
 class DROGON_EXPORT ResponseStream
 {
   public:
+    /**
+     * @brief The encoder of a compressed stream, it is called with the data
+     * of every send() and with finish set to true when the stream is closed,
+     * and returns the bytes to be sent.
+     */
+    using Encoder =
+        std::function<std::string(const std::string &data, bool finish)>;
+
     explicit ResponseStream(trantor::AsyncStreamPtr asyncStream)
         : asyncStream_(std::move(asyncStream))
     {
     }
 
+    ResponseStream(trantor::AsyncStreamPtr asyncStream, Encoder encoder)
+        : asyncStream_(std::move(asyncStream)), encoder_(std::move(encoder))
+    {
+    }
+
+    /**
+     * @brief The data is sent in chunks of the chunked transfer coding unless
+     * chunked is false, as on the streams of HTTP/2 which frame the data.
+     */
+    ResponseStream(trantor::AsyncStreamPtr asyncStream,
+                   Encoder encoder,
+                   bool chunked)
+        : asyncStream_(std::move(asyncStream)),
+          encoder_(std::move(encoder)),
+          chunked_(chunked)
+    {
+    }
+
     ~ResponseStream()
     {
         close();
@@ -91,25 +123,167 @@ class DROGON_EXPORT ResponseStream
         {
             return false;
         }
-        std::ostringstream oss;
-        oss << std::hex << data.length() << "\r\n";
-        oss << data << "\r\n";
-        return asyncStream_->send(oss.str());
+        if (maxBufferedBytes_ > 0 && overflows(data.size()))
+        {
+            return false;
+        }
+        if (encoder_)
+        {
+            auto encoded = encoder_(data, false);
+            // The encoder may buffer the data, an empty chunk would end the
+            // stream.
+            if (encoded.empty())
+                return true;
+            return sendChunk(encoded);
+        }
+        return sendChunk(data);
     }
 
     void close()
     {
         if (asyncStream_)
         {
-            static std::string closeStream{"0\r\n\r\n"};
-            asyncStream_->send(closeStream);
+            if (encoder_)
+            {
+                auto encoded = encoder_(std::string{}, true);
+                if (!encoded.empty())
+                    sendChunk(encoded);
+                encoder_ = nullptr;
+            }
+            if (chunked_)
+            {
+                static std::string closeStream{"0\r\n\r\n"};
+                asyncStream_->send(closeStream);
+            }
             asyncStream_->close();
             asyncStream_.reset();
         }
+        if (flow_)
+            detachConnection();
+    }
+
+    /**
+     * @brief Attach the stream to the HTTP/1 connection carrying it, which is
+     * done by the server. The flow control below needs the connection and is
+     * not available on the streams of HTTP/2. The callbacks set on the
+     * connection are removed when the stream is closed, the drain callbacks
+     * still waiting are called then.
+     */
+    void setConnection(const trantor::TcpConnectionPtr &conn);
+
+    /**
+     * @brief The number of bytes sent to the stream but not yet written to
+     * the connection, 0 if it is unknown.
+     */
+    size_t pendingBytes() const;
+
+    /**
+     * @brief Set the callbacks pacing a producer, both are called in the IO
+     * loop of the connection.
+     *
+     * @param highWatermark onHigh is called when the connection buffers more
+     * than this number of bytes.
+     * @param onDrained Called when the connection has written all the data
+     * after onHigh was called.
+     */
+    void setWatermarkCallbacks(size_t highWatermark,
+                               std::function<void()> onHigh,
+                               std::function<void()> onDrained);
+
+    /// Return false while the connection buffers more than the high watermark
+    bool writable() const
+    {
+        return highWatermark_ == 0 || pendingBytes() <= highWatermark_;
+    }
+
+    /**
+     * @brief Call the callback in the IO loop of the connection once it has
+     * written all the data sent to the stream.
+     */
+    void drain(std::function<void()> callback);
+
+    /**
+     * @brief What send() does when the data would make the connection buffer
+     * more than the limit set by setMaxBufferedBytes().
+     */
+    enum class OverflowPolicy
+    {
+        /// send() returns false without sending the data
+        kReject,
+        /// The connection is closed and send() returns false
+        kClose
+    };
+
+    /**
+     * @brief Limit the bytes buffered by the connection, 0 means no limit.
+     * The data of a send() is accepted whatever its size when nothing is
+     * buffered.
+     */
+    void setMaxBufferedBytes(size_t maxBytes,
+                             OverflowPolicy policy = OverflowPolicy::kReject)
+    {
+        maxBufferedBytes_ = maxBytes;
+        overflowPolicy_ = policy;
+    }
+
+#ifdef __cpp_impl_coroutine
+    struct [[nodiscard]] DrainAwaiter : CallbackAwaiter<void>
+    {
+        explicit DrainAwaiter(ResponseStream *stream) : stream_(stream)
+        {
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            stream_->drain([handle]() { handle.resume(); });
+        }
+
+      private:
+        ResponseStream *stream_;
+    };
+
+    /**
+     * @brief Wait until the connection has written all the data sent to the
+     * stream, the coroutine resumes in the IO loop of the connection.
+     * @code
+       co_await stream->drainCoro();
+       @endcode
+     */
+    DrainAwaiter drainCoro()
+    {
+        return DrainAwaiter(this);
     }
+#endif
 
   private:
+    bool sendChunk(const std::string &data)
+    {
+        if (!chunked_)
+        {
+            onSent(data.length());
+            return asyncStream_->send(data);
+        }
+        std::ostringstream oss;
+        oss << std::hex << data.length() << "\r\n";
+        oss << data << "\r\n";
+        auto chunk = oss.str();
+        onSent(chunk.length());
+        return asyncStream_->send(chunk);
+    }
+
+    void onSent(size_t length);
+    bool overflows(size_t length);
+    void detachConnection();
+
+    struct FlowState;
+
     trantor::AsyncStreamPtr asyncStream_;
+    Encoder encoder_;
+    bool chunked_{true};
+    std::shared_ptr<FlowState> flow_;
+    size_t highWatermark_{0};
+    size_t maxBufferedBytes_{0};
+    OverflowPolicy overflowPolicy_{OverflowPolicy::kReject};
 };
 
 using ResponseStreamPtr = std::unique_ptr<ResponseStream>;
@@ -263,6 +437,20 @@ class DROGON_EXPORT HttpResponse
     virtual void addHeader(std::string field, const std::string &value) = 0;
     virtual void addHeader(std::string field, std::string &&value) = 0;
 
+    /**
+     * @brief Add a trailer field, sent after the body like the grpc-status
+     * of a gRPC response.
+     *
+     * @note The trailers are only sent over HTTP/2. The ones of an async
+     * stream response may be added until the stream is closed.
+     * @param field The field parameter is transformed to lower case before
+     * storing.
+     */
+    virtual void addTrailer(std::string field, std::string value) = 0;
+
+    /// Get all trailers of the response
+    virtual const SafeStringMap<std::string> &trailers() const = 0;
+
     /// Add a cookie
     virtual void addCookie(const std::string &key,
                            const std::string &value) = 0;
@@ -296,6 +484,14 @@ class DROGON_EXPORT HttpResponse
     /// Set the response body(content).
     virtual void setBody(std::string &&body) = 0;
 
+    /**
+     * @brief Set the response body to a string shared by many responses, e.g.
+     * a large file kept in memory, which is sent without being copied.
+     *
+     * @note The string must not be changed while it is shared.
+     */
+    virtual void setSharedBody(std::shared_ptr<const std::string> body) = 0;
+
     /// Set the response body(content).
     template <int N>
     void setBody(const char (&body)[N])
@@ -374,6 +570,16 @@ class DROGON_EXPORT HttpResponse
      */
     virtual const std::string &getJsonError() const = 0;
 
+    /**
+     * @brief Decode the MessagePack body of the response, e.g. one received
+     * by HttpClient, into a Json::Value. The body is decoded by every call.
+     *
+     * @param errs Set to the reason when the body is not valid, if not null.
+     * @return nullptr if the body is not valid MessagePack.
+     */
+    std::shared_ptr<Json::Value> getMsgPackObject(
+        std::string *errs = nullptr) const;
+
     /**
      * @brief Set the response object to the pass-through mode or not. It's not
      * by default when a new response object is created.
@@ -414,6 +620,22 @@ class DROGON_EXPORT HttpResponse
     /// Create a response which returns a json object. Its content-type is set
     /// to application/json.
     static HttpResponsePtr newHttpJsonResponse(Json::Value &&data);
+    /// Create a response whose json body is produced by a JsonWriter, without
+    /// building a Json::Value. Its content-type is set to application/json.
+    /**
+     * @param writeBody Called once, synchronously, to write the whole body.
+     */
+    static HttpResponsePtr newHttpJsonResponse(
+        const std::function<void(JsonWriter &)> &writeBody);
+    /// Create a response which returns a json object encoded as MessagePack.
+    /// Its content-type is set to application/msgpack.
+    static HttpResponsePtr newHttpMsgPackResponse(const Json::Value &data);
+    /// Create a response which returns a json object as MessagePack if the
+    /// Accept header of the request prefers application/msgpack to
+    /// application/json, as JSON otherwise.
+    static HttpResponsePtr newHttpJsonOrMsgPackResponse(
+        const HttpRequestPtr &req,
+        const Json::Value &data);
     /// Create a response that returns a page rendered by a view named
     /// viewName.
     /**
@@ -426,6 +648,26 @@ class DROGON_EXPORT HttpResponse
         const HttpViewData &data = HttpViewData(),
         const HttpRequestPtr &req = HttpRequestPtr());
 
+    /// Create a response that streams a page rendered by a view named
+    /// viewName.
+    /**
+     * The view is rendered in the compute pool and its text is sent in chunks
+     * of about flushThreshold bytes as it is rendered, with the chunked
+     * transfer coding. The rendering waits while the connection has more
+     * than 4 chunks to write, so the page is never whole in memory and its
+     * first bytes are sent before it is rendered.
+     *
+     * @param data is copied, it must not refer to objects owned by the
+     * handler.
+     * @note The view must be created by drogon_ctl to be rendered
+     * progressively, see DrTemplateBase::renderTo().
+     */
+    static HttpResponsePtr newHttpViewStreamResponse(
+        const std::string &viewName,
+        const HttpViewData &data = HttpViewData(),
+        size_t flushThreshold = 16384,
+        const HttpRequestPtr &req = HttpRequestPtr());
+
     /// Create a response that returns a redirection page, redirecting to
     /// another page located in the location parameter.
     /**
@@ -93,7 +93,9 @@ enum class Version
 {
     kUnknown = 0,
     kHttp10,
-    kHttp11
+    kHttp11,
+    kHttp2,
+    kHttp3
 };
 
 enum ContentType
@@ -173,6 +175,7 @@ enum ContentType
     CT_VIDEO_X_MSVIDEO,
     CT_TEXT_EVENT_STREAM,
     CT_MULTIPART_FORM_DATA,
+    CT_APPLICATION_MSGPACK,
     CT_CUSTOM
 };
 
@@ -16,7 +16,11 @@
 
 #include <drogon/HttpAppFramework.h>
 #include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <vector>
 #include <limits>
 #include <functional>
@@ -72,10 +76,11 @@ class IOThreadStorage : public trantor::NonCopyable
         assert(numThreads > 0 &&
                numThreads != (std::numeric_limits<size_t>::max)());
         // set the size to numThreads+1 to enable access to this in the main
-        // thread.
-        storage_.reserve(numThreads + 1);
+        // thread, followed by the handler loops if any.
+        auto size = numThreads + 1 + app().getHandlerThreadNum();
+        storage_.reserve(size);
 
-        for (size_t i = 0; i <= numThreads; ++i)
+        for (size_t i = 0; i < size; ++i)
         {
             storage_.emplace_back(std::forward<Args>(args)...);
         }
@@ -165,4 +170,193 @@ inline trantor::EventLoop *getIOThreadStorageLoop(size_t index) noexcept(false)
         return drogon::app().getLoop();
     return drogon::app().getIOLoop(index);
 }
+
+/**
+ * @brief Read-mostly data shared by all IO loops, such as configurations,
+ * routing tables or feature flags.
+ *
+ * Every loop holds its own pointer to the current immutable version, so a
+ * read in a request handler is a plain pointer read, with no atomics and no
+ * locks. publish() may be called from any thread; the new version replaces
+ * the old one on each loop through runInLoop(), so the publishing loop sees it
+ * at once and the other loops once the tasks queued before it have run. The
+ * old version is freed when the last loop drops it and no reader holds a
+ * shared_ptr to it.
+ *
+ * Example usage:
+ *
+ * @code
+ * IOThreadSnapshot<FeatureFlags> flags_{std::make_shared<FeatureFlags>()};
+ *
+ * // In a request handler
+ * if (flags_->newCheckout) {...}
+ *
+ * // Anywhere
+ * flags_.publish(std::make_shared<FeatureFlags>(loadFlags()));
+ * @endcode
+ *
+ * @note Like IOThreadStorage, it must be constructed once the number of IO
+ * threads is set. The handler loops and the other threads read the latest
+ * version through getShared() or operator->(), which keep it alive.
+ */
+template <typename T>
+class IOThreadSnapshot : public trantor::NonCopyable
+{
+  public:
+    using ValuePtr = std::shared_ptr<const T>;
+
+    explicit IOThreadSnapshot(ValuePtr initial = nullptr)
+        : state_(std::make_shared<State>(initial))
+    {
+    }
+
+    /**
+     * @brief Publish a new version to all loops.
+     *
+     * Versions published concurrently are applied in the order of the calls
+     * on every loop, a late task never replaces a newer version.
+     */
+    void publish(ValuePtr value)
+    {
+        uint64_t version;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex_);
+            version = ++state_->version_;
+            state_->latest_ = value;
+        }
+        if (!app().isRunning())
+        {
+            // No loop is reading the slots yet
+            std::lock_guard<std::mutex> lock(state_->mutex_);
+            for (auto &slot : state_->slots_)
+                slot.set(version, value);
+            return;
+        }
+        for (size_t i = 0; i < state_->slots_.size(); ++i)
+        {
+            auto loop = getIOThreadStorageLoop(i);
+            loop->runInLoop([state = state_, i, version, value]() {
+                state->slots_[i].set(version, value);
+            });
+        }
+    }
+
+    /**
+     * @brief Get the version seen by the current loop.
+     *
+     * The pointer is valid until the loop runs its next task, it may only be
+     * called on the IO loops and the main loop. Elsewhere use getShared() or
+     * operator->().
+     *
+     * @throw std::logic_error off the IO loops and the main loop
+     */
+    const T *get() const
+    {
+        size_t idx = app().getCurrentThreadIndex();
+        if (idx >= state_->slots_.size())
+        {
+            throw std::logic_error(
+                "IOThreadSnapshot::get() called off the IO loops, use "
+                "getShared()");
+        }
+        return state_->slots_[idx].value_.get();
+    }
+
+    /**
+     * @brief Get a reference to the version seen by the current loop, which
+     * keeps it alive after the loop moves to a newer one. Outside the IO
+     * loops and the main loop, the latest published version is returned.
+     */
+    ValuePtr getShared() const
+    {
+        size_t idx = app().getCurrentThreadIndex();
+        if (idx < state_->slots_.size())
+            return state_->slots_[idx].value_;
+        std::lock_guard<std::mutex> lock(state_->mutex_);
+        return state_->latest_;
+    }
+
+    /// Keeps the version read by operator->() alive until the end of the
+    /// expression
+    class Pinned
+    {
+      public:
+        const T *operator->() const
+        {
+            return ptr_;
+        }
+
+      private:
+        friend class IOThreadSnapshot;
+
+        Pinned(const T *ptr, ValuePtr owner)
+            : ptr_(ptr), owner_(std::move(owner))
+        {
+        }
+
+        const T *ptr_;
+        // Only set off the loops, where a publish() may free the version
+        ValuePtr owner_;
+    };
+
+    /**
+     * @brief Access the version seen by the current loop, with no atomics on
+     * the loops. It may be called from any thread, off the loops the latest
+     * version is held until the end of the expression.
+     */
+    Pinned operator->() const
+    {
+        size_t idx = app().getCurrentThreadIndex();
+        if (idx < state_->slots_.size())
+            return Pinned(state_->slots_[idx].value_.get(), nullptr);
+        auto owner = getShared();
+        auto ptr = owner.get();
+        return Pinned(ptr, std::move(owner));
+    }
+
+    /// @throw std::logic_error off the IO loops and the main loop, like get()
+    const T &operator*() const
+    {
+        return *get();
+    }
+
+  private:
+    // Padded to a cache line, so the loops don't share the lines they read
+    struct alignas(64) Slot
+    {
+        void set(uint64_t version, const ValuePtr &value)
+        {
+            if (version > version_)
+            {
+                version_ = version;
+                value_ = value;
+            }
+        }
+
+        uint64_t version_{0};
+        ValuePtr value_;
+    };
+
+    struct State
+    {
+        explicit State(const ValuePtr &initial) : latest_(initial)
+        {
+            size_t numThreads = app().getThreadNum();
+            assert(numThreads > 0 &&
+                   numThreads != (std::numeric_limits<size_t>::max)());
+            // One more slot for the main loop, as in IOThreadStorage
+            slots_.resize(numThreads + 1);
+            for (auto &slot : slots_)
+                slot.value_ = initial;
+        }
+
+        std::vector<Slot> slots_;
+        mutable std::mutex mutex_;
+        uint64_t version_{0};
+        ValuePtr latest_;
+    };
+
+    // Shared with the queued tasks, which may run after this is destroyed
+    std::shared_ptr<State> state_;
+};
 }  // namespace drogon
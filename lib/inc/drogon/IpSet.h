@@ -0,0 +1,128 @@
+/**
+ *
+ *  @file IpSet.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <trantor/net/InetAddress.h>
+#include <array>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace drogon
+{
+/**
+ * @brief A set of IPv4 and IPv6 addresses and CIDR blocks, like the trusted
+ * proxies or a deny list of a threat feed with many thousands of entries.
+ *
+ * The blocks are kept in a path-compressed binary trie per address family,
+ * so a lookup walks at most one node per bit of the address whatever the
+ * size of the set. A block covered by a shorter one adds nothing. The
+ * IPv4-mapped IPv6 addresses are looked up as IPv4 addresses.
+ *
+ * The set is not thread-safe to modify, it is usually built by the
+ * initialization of a plugin and then only read.
+ */
+class DROGON_EXPORT IpSet
+{
+  public:
+    IpSet() = default;
+    // The nodes link each other, a moved set keeps them where they are
+    IpSet(const IpSet &) = delete;
+    IpSet &operator=(const IpSet &) = delete;
+
+    IpSet(IpSet &&that) noexcept
+        : nodes_(std::move(that.nodes_)),
+          ipv4Root_(std::exchange(that.ipv4Root_, nullptr)),
+          ipv6Root_(std::exchange(that.ipv6Root_, nullptr)),
+          size_(std::exchange(that.size_, 0))
+    {
+        that.nodes_.clear();
+    }
+
+    IpSet &operator=(IpSet &&that) noexcept
+    {
+        if (this != &that)
+        {
+            nodes_ = std::move(that.nodes_);
+            ipv4Root_ = std::exchange(that.ipv4Root_, nullptr);
+            ipv6Root_ = std::exchange(that.ipv6Root_, nullptr);
+            size_ = std::exchange(that.size_, 0);
+            that.nodes_.clear();
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Add an address like "10.1.2.3" or "::1", or a CIDR block like
+     * "172.16.0.0/12" or "2001:db8::/32".
+     *
+     * @throw std::runtime_error if the entry is not a valid address or block.
+     */
+    void add(std::string_view ipOrCidr);
+
+    /**
+     * @brief Add the entries of a text, one per line, like a file of a
+     * threat feed. The blank lines and the text after a '#' or a ';' are
+     * ignored.
+     *
+     * @return The number of entries read.
+     * @throw std::runtime_error if an entry is not valid.
+     */
+    size_t addLines(std::string_view text);
+
+    /// Return true if the address is in one of the blocks of the set
+    bool contains(const trantor::InetAddress &addr) const;
+
+    /// Return true if the address, like "10.1.2.3" or "::1", is in the set
+    bool contains(std::string_view ip) const;
+
+    /// The number of blocks added, the covered ones included
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    void clear();
+
+  private:
+    using Key = std::array<unsigned char, 16>;
+
+    struct Node
+    {
+        Key key_{};
+        unsigned char length_{0};
+        // The whole block of the node is in the set
+        bool member_{false};
+        Node *children_[2]{nullptr, nullptr};
+    };
+
+    void insert(Node *&root, const Key &key, unsigned char length);
+    static bool find(const Node *node, const Key &key);
+    Node *newNode(const Key &key, unsigned char length, bool member);
+
+    // The nodes never move, the trie links them by pointers
+    std::deque<Node> nodes_;
+    Node *ipv4Root_{nullptr};
+    Node *ipv6Root_{nullptr};
+    size_t size_{0};
+};
+
+}  // namespace drogon
@@ -0,0 +1,156 @@
+/**
+ *
+ *  @file JwtAuthMiddleware.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpMiddleware.h>
+#include <drogon/IOThreadStorage.h>
+#include <json/value.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The verifier of the signatures of the JSON Web Tokens of an
+ * algorithm, e.g. "ES256" with the OpenSSL ECDSA functions.
+ *
+ * The verifiers are called from all the IO threads at the same time, so the
+ * implementations must be thread safe.
+ */
+class DROGON_EXPORT JwtVerifier
+{
+  public:
+    virtual ~JwtVerifier() = default;
+
+    /// The value of the "alg" header of the tokens
+    virtual const std::string &algorithm() const = 0;
+
+    /**
+     * @brief Return true if the signature is the one of the input.
+     *
+     * @param signingInput The encoded header and payload separated by a dot.
+     * @param signature The decoded signature.
+     */
+    virtual bool verify(std::string_view signingInput,
+                        std::string_view signature) const = 0;
+};
+
+using JwtVerifierPtr = std::shared_ptr<JwtVerifier>;
+
+/// The verifier of the HS256 tokens, signed by HMAC-SHA256 with a secret.
+class DROGON_EXPORT HmacJwtVerifier : public JwtVerifier
+{
+  public:
+    explicit HmacJwtVerifier(std::string_view secret);
+
+    const std::string &algorithm() const override
+    {
+        return algorithm_;
+    }
+
+    bool verify(std::string_view signingInput,
+                std::string_view signature) const override;
+
+    /// The raw signature of the data, to issue tokens
+    std::string sign(std::string_view data) const;
+
+  private:
+    std::string algorithm_{"HS256"};
+    // The key xored with the inner and outer pads
+    std::string innerPad_;
+    std::string outerPad_;
+};
+
+/**
+ * @brief A middleware which authenticates the requests by the JSON Web Token
+ * (RFC 7519) of their "Authorization: Bearer" header.
+ *
+ * The signature of a token is checked by the verifier of its algorithm and
+ * its "exp" and "nbf" claims by the time, the requests with no valid token
+ * are answered with the 401 status. The claims of the valid tokens are put
+ * in the attributes of the requests, see claims().
+ *
+ * Every IO thread keeps the tokens it verified with their parsed claims until
+ * they expire, so the next requests with the same token are authenticated
+ * without decoding and verifying it again. The cache is keyed by the whole
+ * token, a forged token can't be taken for a cached one.
+ *
+ * @code
+   app().registerMiddleware(std::make_shared<JwtAuthMiddleware>(
+       std::vector<JwtVerifierPtr>{
+           std::make_shared<HmacJwtVerifier>(secret)}));
+   app().registerHandler("/api/orders",
+                         &getOrders,
+                         {Get, "drogon::JwtAuthMiddleware"});
+   @endcode
+ */
+class DROGON_EXPORT JwtAuthMiddleware
+    : public HttpMiddleware<JwtAuthMiddleware, false>
+{
+  public:
+    /**
+     * @param verifiers The verifiers of the accepted algorithms.
+     * @param maxCachedTokens The number of tokens cached by each IO thread, 0
+     * disables the cache.
+     */
+    explicit JwtAuthMiddleware(std::vector<JwtVerifierPtr> verifiers,
+                               size_t maxCachedTokens = 10000);
+
+    void invoke(const HttpRequestPtr &req,
+                MiddlewareNextCallback &&nextCb,
+                MiddlewareCallback &&mcb) override;
+
+    /**
+     * @brief Verify a token without the cache.
+     *
+     * @param claims Set to the payload of a valid token.
+     * @param expiry Set to the "exp" claim, 0 if there is none.
+     * @return false if the token is malformed, its signature is not valid or
+     * it is expired or not valid yet.
+     */
+    bool verify(std::string_view token,
+                Json::Value &claims,
+                int64_t &expiry) const;
+
+    /// The claims of the token of a request authenticated by the middleware,
+    /// null for other requests.
+    static const Json::Value &claims(const HttpRequestPtr &req);
+
+  private:
+    struct CachedToken
+    {
+        std::shared_ptr<const Json::Value> claims;
+        int64_t expiry;
+    };
+
+    using TokenCache = std::unordered_map<std::string, CachedToken>;
+
+    std::shared_ptr<const Json::Value> lookup(std::string_view token);
+    void cache(std::string_view token,
+               const std::shared_ptr<const Json::Value> &claims,
+               int64_t expiry);
+
+    std::vector<JwtVerifierPtr> verifiers_;
+    size_t maxCachedTokens_;
+    // Created when the first request is authenticated, once the number of
+    // IO threads is known
+    std::once_flag cachesOnce_;
+    std::unique_ptr<IOThreadStorage<TokenCache>> caches_;
+};
+}  // namespace drogon
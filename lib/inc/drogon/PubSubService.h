@@ -14,13 +14,16 @@
 
 #pragma once
 
+#include <trantor/net/EventLoop.h>
 #include <trantor/utils/NonCopyable.h>
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace drogon
 {
@@ -119,6 +122,234 @@ class Topic : public trantor::NonCopyable
     SubscriberID id_{0};
 };
 
+/**
+ * @brief An unnamed topic whose subscribers run on their own event loops.
+ *
+ * The subscribers are partitioned by event loop in immutable snapshots that
+ * are replaced on every subscription change (copy-on-write, only the
+ * partition of the changed loop is copied). A publisher only takes the
+ * current snapshot, it's never blocked by subscribers coming and going, and
+ * posts one task per loop sharing a single copy of the message.
+ *
+ * @note A handler may still receive the messages published before it was
+ * unsubscribed if their tasks are already queued, but not the ones whose
+ * tasks run after the unsubscription.
+ */
+template <typename MessageType>
+class LoopTopic : public trantor::NonCopyable
+{
+  public:
+    using MessageHandler = std::function<void(const MessageType &)>;
+
+    /**
+     * @brief Publish a message, every subscriber receives it on its loop.
+     */
+    void publish(const MessageType &message) const
+    {
+        publish(std::make_shared<const MessageType>(message));
+    }
+
+    void publish(MessageType &&message) const
+    {
+        publish(std::make_shared<const MessageType>(std::move(message)));
+    }
+
+    void publish(const std::shared_ptr<const MessageType> &message) const
+    {
+        auto snapshot = loadSnapshot();
+        if (!snapshot)
+            return;
+        for (auto &partition : *snapshot)
+        {
+            if (!partition->loop)
+            {
+                partition->deliver(*message);
+                continue;
+            }
+            partition->loop->runInLoop(
+                [partition, message]() { partition->deliver(*message); });
+        }
+    }
+
+    /**
+     * @brief Subscribe to the topic with a handler invoked on the loop of the
+     * current thread, or by the publishers if there is none.
+     */
+    SubscriberID subscribe(MessageHandler handler)
+    {
+        return subscribe(std::move(handler),
+                         trantor::EventLoop::getEventLoopOfCurrentThread());
+    }
+
+    /**
+     * @brief Subscribe to the topic.
+     *
+     * @param handler is invoked on the loop when a message arrives.
+     * @param loop The loop of the handler, if it is nullptr the handler is
+     * invoked by the publishers.
+     * @return SubscriberID
+     */
+    SubscriberID subscribe(MessageHandler handler, trantor::EventLoop *loop)
+    {
+        auto subscriber = std::make_shared<Subscriber>();
+        subscriber->handler = std::move(handler);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto id = ++id_;
+        subscriber->id = id;
+        auto snapshot = copySnapshot();
+        auto iter = findPartition(*snapshot, loop);
+        auto partition = std::make_shared<Partition>();
+        partition->loop = loop;
+        if (iter != snapshot->end())
+        {
+            partition->subscribers = (*iter)->subscribers;
+            *iter = partition;
+        }
+        else
+        {
+            snapshot->push_back(partition);
+        }
+        partition->subscribers.push_back(std::move(subscriber));
+        loops_[id] = loop;
+        storeSnapshot(std::move(snapshot));
+        return id;
+    }
+
+    /**
+     * @brief Unsubscribe from the topic.
+     */
+    void unsubscribe(SubscriberID id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto loopIter = loops_.find(id);
+        if (loopIter == loops_.end())
+            return;
+        auto snapshot = copySnapshot();
+        auto iter = findPartition(*snapshot, loopIter->second);
+        loops_.erase(loopIter);
+        if (iter == snapshot->end())
+            return;
+        auto partition = std::make_shared<Partition>();
+        partition->loop = (*iter)->loop;
+        for (auto &subscriber : (*iter)->subscribers)
+        {
+            if (subscriber->id == id)
+                subscriber->active.store(false, std::memory_order_release);
+            else
+                partition->subscribers.push_back(subscriber);
+        }
+        if (partition->subscribers.empty())
+            snapshot->erase(iter);
+        else
+            *iter = std::move(partition);
+        storeSnapshot(std::move(snapshot));
+    }
+
+    /**
+     * @brief Check if the topic is empty.
+     */
+    bool empty() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return loops_.empty();
+    }
+
+    /**
+     * @brief Remove all subscribers from the topic.
+     */
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto snapshot = loadSnapshot();
+        if (snapshot)
+        {
+            for (auto &partition : *snapshot)
+            {
+                for (auto &subscriber : partition->subscribers)
+                    subscriber->active.store(false, std::memory_order_release);
+            }
+        }
+        loops_.clear();
+        storeSnapshot(nullptr);
+    }
+
+  private:
+    struct Subscriber
+    {
+        SubscriberID id{0};
+        MessageHandler handler;
+        std::atomic<bool> active{true};
+    };
+
+    struct Partition
+    {
+        trantor::EventLoop *loop{nullptr};
+        std::vector<std::shared_ptr<Subscriber>> subscribers;
+
+        void deliver(const MessageType &message) const
+        {
+            for (auto &subscriber : subscribers)
+            {
+                if (subscriber->active.load(std::memory_order_acquire))
+                    subscriber->handler(message);
+            }
+        }
+    };
+
+    using PartitionPtr = std::shared_ptr<const Partition>;
+    using Snapshot = std::vector<PartitionPtr>;
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    static typename Snapshot::iterator findPartition(Snapshot &snapshot,
+                                                     trantor::EventLoop *loop)
+    {
+        auto iter = snapshot.begin();
+        while (iter != snapshot.end() && (*iter)->loop != loop)
+            ++iter;
+        return iter;
+    }
+
+    std::shared_ptr<Snapshot> copySnapshot() const
+    {
+        auto snapshot = loadSnapshot();
+        return snapshot ? std::make_shared<Snapshot>(*snapshot)
+                        : std::make_shared<Snapshot>();
+    }
+
+#ifdef __cpp_lib_atomic_shared_ptr
+    SnapshotPtr loadSnapshot() const
+    {
+        return snapshot_.load(std::memory_order_acquire);
+    }
+
+    void storeSnapshot(SnapshotPtr snapshot)
+    {
+        snapshot_.store(std::move(snapshot), std::memory_order_release);
+    }
+
+    std::atomic<SnapshotPtr> snapshot_;
+#else
+    SnapshotPtr loadSnapshot() const
+    {
+        return std::atomic_load_explicit(&snapshot_,
+                                         std::memory_order_acquire);
+    }
+
+    void storeSnapshot(SnapshotPtr snapshot)
+    {
+        std::atomic_store_explicit(&snapshot_,
+                                   std::move(snapshot),
+                                   std::memory_order_release);
+    }
+
+    SnapshotPtr snapshot_;
+#endif
+    // Serializes the writers, the publishers never take it
+    mutable std::mutex mutex_;
+    std::unordered_map<SubscriberID, trantor::EventLoop *> loops_;
+    SubscriberID id_{0};
+};
+
 /**
  * @brief This class template implements a publish-subscribe pattern with
  * multiple named topics.
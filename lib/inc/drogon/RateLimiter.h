@@ -11,7 +11,10 @@ enum class DROGON_EXPORT RateLimiterType
 {
     kFixedWindow,
     kSlidingWindow,
-    kTokenBucket
+    kTokenBucket,
+    // The limiters below are thread-safe without a lock
+    kAtomicSlidingWindow,
+    kAtomicTokenBucket
 };
 
 inline RateLimiterType stringToRateLimiterType(const std::string &type)
@@ -20,8 +23,22 @@ inline RateLimiterType stringToRateLimiterType(const std::string &type)
         return RateLimiterType::kFixedWindow;
     else if (type == "slidingWindow" || type == "sliding_window")
         return RateLimiterType::kSlidingWindow;
+    else if (type == "atomicSlidingWindow" || type == "atomic_sliding_window")
+        return RateLimiterType::kAtomicSlidingWindow;
+    else if (type == "atomicTokenBucket" || type == "atomic_token_bucket")
+        return RateLimiterType::kAtomicTokenBucket;
     return RateLimiterType::kTokenBucket;
 }
+
+/**
+ * @brief Return true if the limiters of the type can be shared by threads
+ * without being wrapped by a SafeRateLimiter.
+ */
+inline bool isThreadSafeRateLimiterType(RateLimiterType type)
+{
+    return type == RateLimiterType::kAtomicSlidingWindow ||
+           type == RateLimiterType::kAtomicTokenBucket;
+}
 class DROGON_EXPORT RateLimiter;
 using RateLimiterPtr = std::shared_ptr<RateLimiter>;
 
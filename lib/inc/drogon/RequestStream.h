@@ -13,10 +13,13 @@
  */
 #pragma once
 #include <drogon/exports.h>
+#include <drogon/utils/Hasher.h>
 #include <string>
 #include <functional>
 #include <memory>
 #include <exception>
+#include <string_view>
+#include <vector>
 
 namespace drogon
 {
@@ -33,6 +36,98 @@ struct MultipartHeader
     std::string contentType;
 };
 
+/// A part of a multipart request saved by an upload reader
+struct UploadedPart
+{
+    MultipartHeader header;
+    /// The file the part was written to, empty for the form fields
+    std::string path;
+    /// The content of a form field, the files are not kept in memory
+    std::string value;
+    size_t size{0};
+    /// The upper case hex digests of a file, empty unless computed
+    std::string md5;
+    std::string sha256;
+};
+
+struct UploadOptions
+{
+    /**
+     * The path a file part is written to, its parent directories are created.
+     * It is called with the header of every part with a filename, the parts
+     * it returns an empty path for are discarded.
+     */
+    std::function<std::string(const MultipartHeader &)> pathOf;
+    bool computeMd5{false};
+    bool computeSha256{false};
+    /// The size limit of a file in bytes, 0 means no limit
+    size_t maxFileSize{0};
+    /// The size limit of a form field in bytes
+    size_t maxFieldSize{64 * 1024};
+};
+
+/**
+ * The events of an incremental JSON parser, see
+ * RequestStreamReader::newJsonReader(). A handler returns false to stop the
+ * parsing with an error.
+ */
+class DROGON_EXPORT JsonSaxHandler
+{
+  public:
+    virtual ~JsonSaxHandler() = default;
+
+    virtual bool onStartObject()
+    {
+        return true;
+    }
+
+    virtual bool onEndObject()
+    {
+        return true;
+    }
+
+    virtual bool onStartArray()
+    {
+        return true;
+    }
+
+    virtual bool onEndArray()
+    {
+        return true;
+    }
+
+    /// A member name of an object, unescaped
+    virtual bool onKey(std::string_view)
+    {
+        return true;
+    }
+
+    /// A string value, unescaped
+    virtual bool onString(std::string_view)
+    {
+        return true;
+    }
+
+    /// A number in its text form, valid JSON number syntax
+    virtual bool onNumber(std::string_view)
+    {
+        return true;
+    }
+
+    virtual bool onBool(bool)
+    {
+        return true;
+    }
+
+    virtual bool onNull()
+    {
+        return true;
+    }
+};
+
+/// The digests computed by RequestStreamReader::newDigestReader()
+using StreamDigest = utils::HashAlgorithm;
+
 class DROGON_EXPORT RequestStream
 {
   public:
@@ -112,6 +207,60 @@ class DROGON_EXPORT RequestStreamReader
         MultipartHeaderCallback headerCb,
         StreamDataCallback dataCb,
         StreamFinishCallback finishCb);
+
+    using UploadFinishCallback =
+        std::function<void(std::exception_ptr, std::vector<UploadedPart>)>;
+
+    /**
+     * Write the files of a multipart request to their destinations as the
+     * data arrives, computing their digests on the way, so an upload takes
+     * constant memory and a single pass over the data whatever its size.
+     * The files written are removed if the upload fails.
+     */
+    /**
+     * Pass the data on to the next reader, failing the stream with
+     * StreamErrorCode::kBadRequest once more than maxSize bytes arrived.
+     */
+    static RequestStreamReaderPtr newSizeLimiter(size_t maxSize,
+                                                 RequestStreamReaderPtr next);
+
+    /**
+     * Inflate the data according to the Content-Encoding header of the
+     * request (gzip, deflate, br or zstd) and pass it on to the next reader,
+     * or return the next reader itself if the body is not encoded. Chain a
+     * size limiter after it to bound the inflated size.
+     */
+    static RequestStreamReaderPtr newDecompressor(const HttpRequestPtr &req,
+                                                  RequestStreamReaderPtr next);
+
+    using DigestCallback = std::function<void(const std::string &hexDigest)>;
+
+    /**
+     * Compute the digest of the data passed on to the next reader, the upper
+     * case hex digest is given to the callback before the stream of the next
+     * reader finishes successfully.
+     */
+    static RequestStreamReaderPtr newDigestReader(StreamDigest algorithm,
+                                                  DigestCallback digestCb,
+                                                  RequestStreamReaderPtr next);
+
+    /**
+     * Parse a JSON document as it arrives, reporting its values to the
+     * handler instead of building it in memory.
+     *
+     * @param maxDepth The nesting limit of arrays and objects.
+     * @param finishCb Called with an error if the document is invalid or
+     * incomplete, or a handler method returned false.
+     */
+    static RequestStreamReaderPtr newJsonReader(
+        std::shared_ptr<JsonSaxHandler> handler,
+        StreamFinishCallback finishCb,
+        size_t maxDepth = 256);
+
+    static RequestStreamReaderPtr newUploadReader(
+        const HttpRequestPtr &req,
+        UploadOptions options,
+        UploadFinishCallback finishCb);
 };
 
 }  // namespace drogon
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <trantor/utils/Logger.h>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -44,21 +45,9 @@ class Session
     template <typename T>
     T get(const std::string &key) const
     {
-        {
-            std::lock_guard<std::mutex> lck(mutex_);
-            auto it = sessionMap_.find(key);
-            if (it != sessionMap_.end())
-            {
-                if (typeid(T) == it->second.type())
-                {
-                    return *(std::any_cast<T>(&(it->second)));
-                }
-                else
-                {
-                    LOG_ERROR << "Bad type";
-                }
-            }
-        }
+        auto value = getOptional<T>(key);
+        if (value)
+            return std::move(*value);
         return T();
     }
 
@@ -73,22 +62,22 @@ class Session
     template <typename T>
     std::optional<T> getOptional(const std::string &key) const
     {
-        {
-            std::lock_guard<std::mutex> lck(mutex_);
-            auto it = sessionMap_.find(key);
-            if (it != sessionMap_.end())
+        std::optional<T> value;
+        visit([&key, &value](const SessionMap &sessionMap) {
+            auto it = sessionMap.find(key);
+            if (it != sessionMap.end())
             {
                 if (typeid(T) == it->second.type())
                 {
-                    return *(std::any_cast<T>(&(it->second)));
+                    value = *(std::any_cast<T>(&(it->second)));
                 }
                 else
                 {
                     LOG_ERROR << "Bad type";
                 }
             }
-        }
-        return std::nullopt;
+        });
+        return value;
     }
 
     /**
@@ -107,25 +96,27 @@ class Session
     template <typename T, typename Callable>
     void modify(const std::string &key, Callable &&handler)
     {
-        std::lock_guard<std::mutex> lck(mutex_);
-        auto it = sessionMap_.find(key);
-        if (it != sessionMap_.end())
-        {
-            if (typeid(T) == it->second.type())
+        update([&key, &handler](SessionMap &sessionMap) {
+            auto it = sessionMap.find(key);
+            if (it != sessionMap.end())
             {
-                handler(*(std::any_cast<T>(&(it->second))));
+                if (typeid(T) == it->second.type())
+                {
+                    handler(*(std::any_cast<T>(&(it->second))));
+                }
+                else
+                {
+                    LOG_ERROR << "Bad type";
+                }
             }
             else
             {
-                LOG_ERROR << "Bad type";
+                auto item = T();
+                handler(item);
+                sessionMap.insert(
+                    std::make_pair(key, std::any(std::move(item))));
             }
-        }
-        else
-        {
-            auto item = T();
-            handler(item);
-            sessionMap_.insert(std::make_pair(key, std::any(std::move(item))));
-        }
+        });
     }
 
     /**
@@ -140,8 +131,7 @@ class Session
     template <typename Callable>
     void modify(Callable &&handler)
     {
-        std::lock_guard<std::mutex> lck(mutex_);
-        handler(sessionMap_);
+        update(std::forward<Callable>(handler));
     }
 
     /**
@@ -154,8 +144,9 @@ class Session
      */
     void insert(const std::string &key, const std::any &obj)
     {
-        std::lock_guard<std::mutex> lck(mutex_);
-        sessionMap_.insert(std::make_pair(key, obj));
+        update([&key, &obj](SessionMap &sessionMap) {
+            sessionMap.insert(std::make_pair(key, obj));
+        });
     }
 
     /**
@@ -168,8 +159,9 @@ class Session
      */
     void insert(const std::string &key, std::any &&obj)
     {
-        std::lock_guard<std::mutex> lck(mutex_);
-        sessionMap_.insert(std::make_pair(key, std::move(obj)));
+        update([&key, &obj](SessionMap &sessionMap) {
+            sessionMap.insert(std::make_pair(key, std::move(obj)));
+        });
     }
 
     /**
@@ -177,8 +169,7 @@ class Session
      */
     void erase(const std::string &key)
     {
-        std::lock_guard<std::mutex> lck(mutex_);
-        sessionMap_.erase(key);
+        update([&key](SessionMap &sessionMap) { sessionMap.erase(key); });
     }
 
     /**
@@ -186,12 +177,11 @@ class Session
      */
     bool find(const std::string &key)
     {
-        std::lock_guard<std::mutex> lck(mutex_);
-        if (sessionMap_.find(key) == sessionMap_.end())
-        {
-            return false;
-        }
-        return true;
+        bool found{false};
+        visit([&key, &found](const SessionMap &sessionMap) {
+            found = sessionMap.find(key) != sessionMap.end();
+        });
+        return found;
     }
 
     /**
@@ -199,8 +189,16 @@ class Session
      */
     void clear()
     {
-        std::lock_guard<std::mutex> lck(mutex_);
-        sessionMap_.clear();
+        update([](SessionMap &sessionMap) { sessionMap.clear(); });
+    }
+
+    /**
+     * @brief Return true if the session reads copy-on-write snapshots of its
+     * data without locking, see HttpAppFramework::enableSessionCopyOnWrite().
+     */
+    bool isCopyOnWrite() const
+    {
+        return copyOnWrite_;
     }
 
     /**
@@ -226,20 +224,92 @@ class Session
     Session() = delete;
 
   private:
+    using SnapshotPtr = std::shared_ptr<const SessionMap>;
+
+    // Used if copyOnWrite_ is false
     SessionMap sessionMap_;
+    // Used if copyOnWrite_ is true, every change publishes a new snapshot
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<SnapshotPtr> snapshot_;
+#else
+    SnapshotPtr snapshot_;
+#endif
+    const bool copyOnWrite_{false};
     mutable std::mutex mutex_;
     std::string sessionId_;
     bool needToSet_{false};
     bool needToChange_{false};
+    std::atomic<bool> dirty_{false};
     friend class SessionManager;
     friend class HttpAppFrameworkImpl;
 
     /**
      * @brief Constructor, usually called by the framework
      */
-    Session(const std::string &id, bool needToSet)
-        : sessionId_(id), needToSet_(needToSet)
+    Session(const std::string &id, bool needToSet, bool copyOnWrite = false)
+        : copyOnWrite_(copyOnWrite), sessionId_(id), needToSet_(needToSet)
     {
+        if (copyOnWrite_)
+            storeSnapshot(std::make_shared<const SessionMap>());
+    }
+
+    SnapshotPtr loadSnapshot() const
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return snapshot_.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+#endif
+    }
+
+    void storeSnapshot(SnapshotPtr snapshot)
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        snapshot_.store(std::move(snapshot), std::memory_order_release);
+#else
+        std::atomic_store_explicit(&snapshot_,
+                                   std::move(snapshot),
+                                   std::memory_order_release);
+#endif
+    }
+
+    /**
+     * @brief Call the handler with the data. A copy-on-write session doesn't
+     * lock, the handler gets the current snapshot.
+     */
+    template <typename Callable>
+    void visit(Callable &&handler) const
+    {
+        if (copyOnWrite_)
+        {
+            auto snapshot = loadSnapshot();
+            handler(*snapshot);
+            return;
+        }
+        std::lock_guard<std::mutex> lck(mutex_);
+        handler(sessionMap_);
+    }
+
+    /**
+     * @brief Call the handler to change the data. The writers of a
+     * copy-on-write session are serialized by the mutex, every one of them
+     * changes a copy of the current snapshot and publishes the copy.
+     */
+    template <typename Callable>
+    void update(Callable &&handler)
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (copyOnWrite_)
+        {
+            auto copy = std::make_shared<SessionMap>(*loadSnapshot());
+            handler(*copy);
+            storeSnapshot(std::move(copy));
+        }
+        else
+        {
+            handler(sessionMap_);
+        }
+        dirty_ = true;
     }
 
     /**
@@ -274,6 +344,28 @@ class Session
         sessionId_ = id;
         needToChange_ = false;
     }
+
+    /**
+     * @brief Replace the data without making the session dirty, when the
+     * session is loaded from a session store.
+     */
+    void setData(SessionMap &&data)
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (copyOnWrite_)
+            storeSnapshot(std::make_shared<const SessionMap>(std::move(data)));
+        else
+            sessionMap_ = std::move(data);
+    }
+
+    /**
+     * @brief Return true if the data has been changed since the last call,
+     * which means the session has to be written back to the session store.
+     */
+    bool takeDirty()
+    {
+        return dirty_.exchange(false);
+    }
 };
 
 using SessionPtr = std::shared_ptr<Session>;
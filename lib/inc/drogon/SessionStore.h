@@ -0,0 +1,129 @@
+/**
+ *
+ *  @file SessionStore.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/SharedMemoryMap.h>
+#include <drogon/nosql/RedisClient.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace drogon
+{
+class SessionStore;
+using SessionStorePtr = std::shared_ptr<SessionStore>;
+
+/// The storage shared by several application instances to keep sessions
+/**
+ * When a session store is set by HttpAppFramework::setSessionStore(), the
+ * sessions are no more kept only in the memory of the process, so any
+ * instance behind a load balancer can serve any session.
+ *
+ * The data of a session is serialized by the framework, the store only keeps
+ * the strings. All the methods may be called in any thread and the callbacks
+ * may be called in any thread.
+ */
+class DROGON_EXPORT SessionStore : public trantor::NonCopyable
+{
+  public:
+    using LoadCallback = std::function<void(std::optional<std::string> &&)>;
+
+    /**
+     * @brief Load the data of a session.
+     *
+     * @param timeout The timeout of the session in seconds, if it is not 0,
+     * the store should restart counting of the expiration of the session.
+     * @param callback Called with std::nullopt if the session doesn't exist
+     * or the store fails.
+     */
+    virtual void load(const std::string &sessionId,
+                      size_t timeout,
+                      LoadCallback &&callback) = 0;
+
+    /**
+     * @brief Save the data of a session, the session expires after the
+     * timeout in seconds, or never if the timeout is 0.
+     */
+    virtual void save(const std::string &sessionId,
+                      const std::string &data,
+                      size_t timeout) = 0;
+
+    /// Remove a session from the store.
+    virtual void erase(const std::string &sessionId) = 0;
+
+    virtual ~SessionStore() = default;
+};
+
+/// The session store which keeps the sessions in Redis
+/**
+ * Every session is a string value whose key is the session ID with a prefix,
+ * the expiration of the session is the expiration of the key.
+ *
+ * It is usually created by HttpAppFramework::setRedisSessionStore() with a
+ * redis client of the application.
+ */
+class DROGON_EXPORT RedisSessionStore final : public SessionStore
+{
+  public:
+    explicit RedisSessionStore(nosql::RedisClientPtr client,
+                               std::string keyPrefix = "drogon:session:")
+        : client_(std::move(client)), keyPrefix_(std::move(keyPrefix))
+    {
+    }
+
+    void load(const std::string &sessionId,
+              size_t timeout,
+              LoadCallback &&callback) override;
+    void save(const std::string &sessionId,
+              const std::string &data,
+              size_t timeout) override;
+    void erase(const std::string &sessionId) override;
+
+  private:
+    nosql::RedisClientPtr client_;
+    std::string keyPrefix_;
+};
+
+/// The session store which keeps the sessions in a SharedMemoryMap
+/**
+ * The sessions are shared by the processes of the host which map the same
+ * file, like the worker processes of the application, and are loaded without
+ * any round trip. A session whose data doesn't fit in a slot of the map is
+ * not saved. The expiration of a session is the expiration of its entry.
+ */
+class DROGON_EXPORT SharedMemorySessionStore final : public SessionStore
+{
+  public:
+    explicit SharedMemorySessionStore(SharedMemoryMapPtr map,
+                                      std::string keyPrefix = "session:")
+        : map_(std::move(map)), keyPrefix_(std::move(keyPrefix))
+    {
+    }
+
+    void load(const std::string &sessionId,
+              size_t timeout,
+              LoadCallback &&callback) override;
+    void save(const std::string &sessionId,
+              const std::string &data,
+              size_t timeout) override;
+    void erase(const std::string &sessionId) override;
+
+  private:
+    SharedMemoryMapPtr map_;
+    std::string keyPrefix_;
+};
+}  // namespace drogon
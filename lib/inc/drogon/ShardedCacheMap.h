@@ -0,0 +1,444 @@
+/**
+ *
+ *  @file ShardedCacheMap.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A cache map split into shards which are locked independently, for
+ * the caches used by all the IO threads.
+ *
+ * It has the interface of CacheMap. A key is always kept in the same shard,
+ * so the threads which access different keys rarely wait for each other.
+ * The expiring entries are linked into the buckets of one timing wheel per
+ * shard by pointers stored in the entries themselves, so accesses allocate
+ * nothing: an access only moves the deadline of the entry forward, and the
+ * entry is moved to the bucket of its deadline when its current bucket is
+ * due. The timeouts longer than a turn of the wheel take several turns.
+ *
+ * @tparam T1 The keyword type.
+ * @tparam T2 The value type.
+ */
+template <typename T1, typename T2, typename Hash = std::hash<T1>>
+class ShardedCacheMap : public trantor::NonCopyable
+{
+  public:
+    static constexpr size_t kDefaultBucketsNum = 1024;
+    static constexpr size_t kDefaultShardsNum = 16;
+
+    /// constructor
+    /**
+     * @param loop The event loop of the timer of the cache.
+     * @param tickInterval The resolution of the timeouts in seconds, 0
+     * disables them.
+     * @param bucketsNum The number of the buckets of the wheel of every
+     * shard.
+     * @param shardsNum The number of the shards.
+     * @param fnOnInsert The function to execute on insertion.
+     * @param fnOnErase The function to execute on erase.
+     */
+    ShardedCacheMap(trantor::EventLoop *loop,
+                    float tickInterval = 1.0f,
+                    size_t bucketsNum = kDefaultBucketsNum,
+                    size_t shardsNum = kDefaultShardsNum,
+                    std::function<void(const T1 &)> fnOnInsert = nullptr,
+                    std::function<void(const T1 &)> fnOnErase = nullptr)
+        : loop_(loop),
+          tickInterval_(tickInterval),
+          bucketsNum_(bucketsNum),
+          shardsNum_(shardsNum == 0 ? 1 : shardsNum),
+          shards_(new Shard[shardsNum_]),
+          ctrlBlockPtr_(std::make_shared<ControlBlock>()),
+          fnOnInsert_(std::move(fnOnInsert)),
+          fnOnErase_(std::move(fnOnErase))
+    {
+        if (tickInterval_ > 0 && bucketsNum_ > 0)
+        {
+            for (size_t i = 0; i < shardsNum_; ++i)
+            {
+                shards_[i].buckets.resize(bucketsNum_, nullptr);
+            }
+            timerId_ = loop_->runEvery(
+                tickInterval_, [this, ctrlBlockPtr = ctrlBlockPtr_]() {
+                    std::lock_guard<std::mutex> lock(ctrlBlockPtr->mtx);
+                    if (ctrlBlockPtr->destructed)
+                        return;
+                    tick();
+                });
+            loop_->runOnQuit([ctrlBlockPtr = ctrlBlockPtr_] {
+                std::lock_guard<std::mutex> lock(ctrlBlockPtr->mtx);
+                ctrlBlockPtr->loopEnded = true;
+            });
+        }
+        else
+        {
+            noWheels_ = true;
+        }
+    }
+
+    ~ShardedCacheMap()
+    {
+        std::lock_guard<std::mutex> lock(ctrlBlockPtr_->mtx);
+        ctrlBlockPtr_->destructed = true;
+        if (!noWheels_ && !ctrlBlockPtr_->loopEnded)
+        {
+            loop_->invalidateTimer(timerId_);
+        }
+        LOG_TRACE << "ShardedCacheMap destruct!";
+    }
+
+    /**
+     * @brief Insert a key-value pair into the cache, see CacheMap::insert().
+     */
+    void insert(const T1 &key,
+                T2 &&value,
+                size_t timeout = 0,
+                std::function<void()> timeoutCallback = std::function<void()>())
+    {
+        emplace(key, std::move(value), timeout, std::move(timeoutCallback));
+    }
+
+    void insert(const T1 &key,
+                const T2 &value,
+                size_t timeout = 0,
+                std::function<void()> timeoutCallback = std::function<void()>())
+    {
+        emplace(key, value, timeout, std::move(timeoutCallback));
+    }
+
+    /**
+     * @brief Return a copy of the value of the keyword, or a default T2 value
+     * if it is not found.
+     */
+    T2 operator[](const T1 &key)
+    {
+        auto &shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end())
+            return T2();
+        touch(iter->second);
+        return iter->second.value;
+    }
+
+    /**
+     * @brief Modify or visit the data identified by the key parameter, see
+     * CacheMap::modify().
+     *
+     * @note The handler is called with the lock of the shard of the key held,
+     * it must not access the cache.
+     */
+    template <typename Callable>
+    void modify(const T1 &key, Callable &&handler, size_t timeout = 0)
+    {
+        auto &shard = shardOf(key);
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto iter = shard.map.find(key);
+            if (iter != shard.map.end())
+            {
+                handler(iter->second.value);
+                touch(iter->second);
+                return;
+            }
+            iter = shard.map.emplace(key, Entry()).first;
+            auto &entry = iter->second;
+            handler(entry.value);
+            start(shard, iter, timeout);
+        }
+        if (fnOnInsert_)
+            fnOnInsert_(key);
+    }
+
+    /// Check if the value of the keyword exists
+    bool find(const T1 &key)
+    {
+        auto &shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end())
+            return false;
+        touch(iter->second);
+        return true;
+    }
+
+    /// Atomically find and get the value of a keyword
+    /**
+     * Return true when the value is found, and the value
+     * is assigned to the value argument.
+     */
+    bool findAndFetch(const T1 &key, T2 &value)
+    {
+        auto &shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end())
+            return false;
+        touch(iter->second);
+        value = iter->second.value;
+        return true;
+    }
+
+    /// Erase the value of the keyword.
+    /**
+     * @param key the keyword.
+     * @note This function does not cause the timeout callback to be executed.
+     */
+    void erase(const T1 &key)
+    {
+        {
+            auto &shard = shardOf(key);
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto iter = shard.map.find(key);
+            if (iter != shard.map.end())
+            {
+                unlink(shard, iter->second);
+                shard.map.erase(iter);
+            }
+        }
+        if (fnOnErase_)
+            fnOnErase_(key);
+    }
+
+    /// Return the number of the entries of the cache.
+    size_t size()
+    {
+        size_t count{0};
+        for (size_t i = 0; i < shardsNum_; ++i)
+        {
+            std::lock_guard<std::mutex> lock(shards_[i].mtx);
+            count += shards_[i].map.size();
+        }
+        return count;
+    }
+
+    trantor::EventLoop *getLoop()
+    {
+        return loop_;
+    }
+
+    /**
+     * @brief run the task function after a period of time, see
+     * CacheMap::runAfter().
+     *
+     * @note As in CacheMap, the task runs at once if the timeouts are
+     * disabled.
+     */
+    void runAfter(size_t delay, std::function<void()> &&task)
+    {
+        if (noWheels_)
+        {
+            task();
+            return;
+        }
+        std::lock_guard<std::mutex> lock(tasksMutex_);
+        tasks_.emplace(deadlineOf(delay), std::move(task));
+    }
+
+    void runAfter(size_t delay, const std::function<void()> &task)
+    {
+        runAfter(delay, std::function<void()>(task));
+    }
+
+  private:
+    struct Entry
+    {
+        T2 value;
+        size_t timeout{0};
+        uint64_t deadline{0};
+        std::function<void()> timeoutCallback;
+        // The links of the list of the bucket, the key is the one of the
+        // node of the map, whose address never changes
+        const T1 *key{nullptr};
+        Entry *prev{nullptr};
+        Entry *next{nullptr};
+    };
+
+    using Map = std::unordered_map<T1, Entry, Hash>;
+
+    struct alignas(64) Shard
+    {
+        std::mutex mtx;
+        Map map;
+        // The heads of the lists of the expiring entries
+        std::vector<Entry *> buckets;
+    };
+
+    /// See CacheMap::ControlBlock.
+    struct ControlBlock
+    {
+        bool destructed{false};
+        bool loopEnded{false};
+        std::mutex mtx;
+    };
+
+    Shard &shardOf(const T1 &key)
+    {
+        // The bits of the hash above the ones used by the maps
+        auto hash = static_cast<uint64_t>(Hash{}(key));
+        hash *= 0x9e3779b97f4a7c15ull;
+        return shards_[(hash >> 32) % shardsNum_];
+    }
+
+    uint64_t deadlineOf(size_t timeout) const
+    {
+        return ticksCounter_.load(std::memory_order_relaxed) +
+               static_cast<uint64_t>(timeout / tickInterval_) + 1;
+    }
+
+    template <typename V>
+    void emplace(const T1 &key,
+                 V &&value,
+                 size_t timeout,
+                 std::function<void()> &&timeoutCallback)
+    {
+        auto &shard = shardOf(key);
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto [iter, inserted] = shard.map.emplace(key, Entry());
+            if (!inserted)
+            {
+                // As in CacheMap, the value in the cache is kept
+                touch(iter->second);
+                return;
+            }
+            iter->second.value = std::forward<V>(value);
+            iter->second.timeoutCallback = std::move(timeoutCallback);
+            start(shard, iter, timeout);
+        }
+        if (fnOnInsert_)
+            fnOnInsert_(key);
+    }
+
+    void start(Shard &shard, typename Map::iterator iter, size_t timeout)
+    {
+        auto &entry = iter->second;
+        entry.key = &iter->first;
+        if (timeout == 0 || noWheels_)
+            return;
+        entry.timeout = timeout;
+        entry.deadline = deadlineOf(timeout);
+        link(shard, entry);
+    }
+
+    void touch(Entry &entry)
+    {
+        // The entry is moved when its bucket is due
+        if (entry.timeout > 0 && !noWheels_)
+            entry.deadline = deadlineOf(entry.timeout);
+    }
+
+    void link(Shard &shard, Entry &entry)
+    {
+        auto &head = shard.buckets[entry.deadline % bucketsNum_];
+        entry.prev = nullptr;
+        entry.next = head;
+        if (head)
+            head->prev = &entry;
+        head = &entry;
+    }
+
+    void unlink(Shard &shard, Entry &entry)
+    {
+        if (entry.timeout == 0 || noWheels_)
+            return;
+        if (entry.prev)
+            entry.prev->next = entry.next;
+        else
+            shard.buckets[entry.deadline % bucketsNum_] = entry.next;
+        if (entry.next)
+            entry.next->prev = entry.prev;
+    }
+
+    void tick()
+    {
+        auto t = ++ticksCounter_;
+        std::vector<std::pair<T1, std::function<void()>>> expired;
+        for (size_t i = 0; i < shardsNum_; ++i)
+        {
+            auto &shard = shards_[i];
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto &head = shard.buckets[t % bucketsNum_];
+            auto entry = head;
+            head = nullptr;
+            while (entry)
+            {
+                auto next = entry->next;
+                if (entry->deadline <= t)
+                {
+                    expired.emplace_back(*entry->key,
+                                         std::move(entry->timeoutCallback));
+                    shard.map.erase(shard.map.find(expired.back().first));
+                }
+                else
+                {
+                    // The bucket was linked before the last accesses
+                    link(shard, *entry);
+                }
+                entry = next;
+            }
+        }
+        std::vector<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex_);
+            auto end = tasks_.upper_bound(t);
+            for (auto iter = tasks_.begin(); iter != end; ++iter)
+            {
+                tasks.push_back(std::move(iter->second));
+            }
+            tasks_.erase(tasks_.begin(), end);
+        }
+        for (auto &[key, timeoutCallback] : expired)
+        {
+            if (fnOnErase_)
+                fnOnErase_(key);
+            if (timeoutCallback)
+                timeoutCallback();
+        }
+        for (auto &task : tasks)
+        {
+            task();
+        }
+    }
+
+    trantor::EventLoop *loop_;
+    float tickInterval_;
+    size_t bucketsNum_;
+    size_t shardsNum_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint64_t> ticksCounter_{0};
+    trantor::TimerId timerId_{0};
+    std::shared_ptr<ControlBlock> ctrlBlockPtr_;
+    std::function<void(const T1 &)> fnOnInsert_;
+    std::function<void(const T1 &)> fnOnErase_;
+    bool noWheels_{false};
+
+    // The tasks of runAfter() by their deadlines
+    std::mutex tasksMutex_;
+    std::multimap<uint64_t, std::function<void()>> tasks_;
+};
+}  // namespace drogon
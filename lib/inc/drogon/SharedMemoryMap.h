@@ -0,0 +1,133 @@
+/**
+ *
+ *  @file SharedMemoryMap.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief A hash table of strings in a memory mapped file, shared by all the
+ * processes which open the file, like the worker processes of the
+ * application (see HttpAppFramework::setWorkerProcesses()).
+ *
+ * The table has a fixed number of slots of a fixed size, which are allocated
+ * when the file is created, so an entry whose key and value don't fit in a
+ * slot can't be inserted. The slot of a key is one of the few slots after the
+ * slot its hash points to; when all of them are used, the entry expiring
+ * first is evicted. The expired entries are not found and their slots are
+ * reused.
+ *
+ * The lookups don't take any lock: every slot is written under a sequence
+ * number, and a lookup which sees it change reads the slot again. The writes
+ * are serialized by a robust mutex in the file, which is released when a
+ * process dies holding it. This is only supported on Linux.
+ *
+ * All the processes must open the file with the same capacity and slot
+ * size, the file is created when it doesn't exist. A file in a tmpfs, like
+ * /dev/shm, is never written to the disk.
+ */
+class DROGON_EXPORT SharedMemoryMap : public trantor::NonCopyable
+{
+  public:
+    /**
+     * @param path The path of the file.
+     * @param capacity The number of slots.
+     * @param slotSize The size of a slot in bytes, which holds an entry and a
+     * header of 32 bytes.
+     * @throw std::runtime_error if the file can't be mapped or was created
+     * with another capacity or slot size.
+     */
+    explicit SharedMemoryMap(const std::string &path,
+                             size_t capacity = 65536,
+                             size_t slotSize = 512);
+    ~SharedMemoryMap();
+
+    /**
+     * @brief Insert or replace an entry which expires after the timeout in
+     * seconds, or never if the timeout is 0.
+     *
+     * @return false if the key and the value don't fit in a slot.
+     */
+    bool insert(std::string_view key,
+                std::string_view value,
+                size_t timeout = 0);
+
+    /// Return true and copy the value of the key if it is found.
+    bool findAndFetch(std::string_view key, std::string &value) const;
+
+    bool find(std::string_view key) const;
+
+    void erase(std::string_view key);
+
+    /**
+     * @brief Restart the expiration of an entry, which expires after the
+     * timeout in seconds, or never if the timeout is 0.
+     *
+     * @return false if the key is not found.
+     */
+    bool touch(std::string_view key, size_t timeout);
+
+    /**
+     * @brief Add the delta to a counter and return its new value. A counter
+     * which doesn't exist is created with the delta as its value and expires
+     * after the timeout in seconds, which is not restarted by the next
+     * increments.
+     */
+    int64_t increment(std::string_view key,
+                      int64_t delta = 1,
+                      size_t timeout = 0);
+
+    /// Remove all the entries.
+    void clear();
+
+    /// The greatest size of a key and its value.
+    size_t maxEntrySize() const;
+
+  private:
+    struct Header;
+    struct Slot;
+    class WriteLock;
+
+    Slot *slotAt(size_t index) const;
+    bool lookup(std::string_view key, std::string *value) const;
+    // The slot of the key, -1 if it is not found. The slot in which the key
+    // would be inserted is returned in vacant.
+    int64_t locate(uint64_t hash,
+                   std::string_view key,
+                   int64_t *vacant = nullptr) const;
+    // The slots are changed between these calls, with the lock held
+    Slot *beginWrite(size_t index);
+    void endWrite(Slot *slot);
+    void write(size_t index,
+               uint64_t hash,
+               std::string_view key,
+               std::string_view value,
+               int64_t expiry);
+    void remove(size_t index);
+
+    Header *header_{nullptr};
+    char *slots_{nullptr};
+    size_t capacity_;
+    size_t slotSize_;
+    size_t mappedSize_{0};
+};
+
+using SharedMemoryMapPtr = std::shared_ptr<SharedMemoryMap>;
+}  // namespace drogon
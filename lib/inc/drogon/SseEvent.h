@@ -15,6 +15,7 @@
 #include <drogon/exports.h>
 #include <drogon/HttpTypes.h>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <functional>
 
@@ -142,9 +143,28 @@ class DROGON_EXPORT SseEvent
     int retry_{0};
 };
 
+/**
+ * @brief An SSE event whose fields are views into the buffers of the
+ * parser, valid only during the callback it is passed to. Copy the fields
+ * which are kept.
+ */
+struct SseEventView
+{
+    /// The event type, "message" if the event has none
+    std::string_view event;
+    std::string_view data;
+    /// The ID of the event, empty if it has none
+    std::string_view id;
+    /// Retry time in milliseconds. 0 means not specified.
+    int retry{0};
+};
+
 /// Callback for receiving SSE events
 using SseEventCallback = std::function<void(const SseEventPtr &)>;
 
+/// Callback for receiving SSE events without copying them
+using SseEventViewCallback = std::function<void(const SseEventView &)>;
+
 /// Callback for SSE connection closed or error
 using SseClosedCallback = std::function<void(ReqResult, const HttpResponsePtr &)>;
 
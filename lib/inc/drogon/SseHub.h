@@ -0,0 +1,122 @@
+/**
+ *
+ *  @file SseHub.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <drogon/SseEvent.h>
+#include <drogon/SseWriter.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/// What an SseHub does with a subscriber whose connection can't keep up
+enum class SseBackpressurePolicy
+{
+    /// Close the stream, the client reconnects and resumes from the replay
+    /// buffer with its Last-Event-ID.
+    kDisconnect,
+    /// Skip the events until the connection has written its backlog.
+    kDropEvents
+};
+
+struct SseHubOptions
+{
+    /// The number of recent events of a channel kept for Last-Event-ID resume.
+    size_t replayCapacity{1024};
+    /**
+     * The bytes a subscriber may have sent but not yet written to its
+     * connection before the backpressure policy applies, 0 means no limit.
+     */
+    size_t maxPendingBytes{1024 * 1024};
+    SseBackpressurePolicy backpressurePolicy{
+        SseBackpressurePolicy::kDisconnect};
+};
+
+/**
+ * @brief A hub publishing Server-Sent Events to the subscribers of named
+ * channels.
+ *
+ * An event is formatted once, the events published to a channel are queued
+ * per IO loop and a single task per loop sends them to the subscribers of that
+ * loop in one batch. The recent events of every channel are kept in a bounded
+ * buffer, a client reconnecting with a Last-Event-ID header is sent the events
+ * it has missed before the live ones. The events published without an id are
+ * given the sequence number of the channel as their id.
+ *
+ * Subscribers are dropped when their streams are closed, which the hub
+ * notices on the next event of their channel. All the methods are
+ * thread-safe. For example:
+ * @code
+   app().registerHandler("/events",
+                         [&hub](const HttpRequestPtr &req,
+                                std::function<void(const HttpResponsePtr &)>
+                                    &&callback) {
+                             callback(hub.newResponse(req, "news"));
+                         });
+   ...
+   hub.publish("news", SseEvent::newEvent("update", data));
+   @endcode
+ */
+class DROGON_EXPORT SseHub : public trantor::NonCopyable
+{
+  public:
+    explicit SseHub(const SseHubOptions &options = SseHubOptions());
+    ~SseHub();
+
+    /**
+     * @brief Publish an event to the subscribers of a channel.
+     *
+     * @return The id of the event.
+     */
+    std::string publish(const std::string &channel, const SseEvent &event);
+
+    std::string publish(const std::string &channel, const SseEventPtr &event)
+    {
+        return publish(channel, *event);
+    }
+
+    /**
+     * @brief Subscribe a writer to a channel.
+     *
+     * @param lastEventId The id of the last event the client received, the
+     * events after it still in the replay buffer are sent first. Nothing is
+     * replayed if it is empty or no longer in the buffer.
+     * @return false if not called in the IO loop of the writer.
+     * @note Call it in the callback of HttpResponse::newSseResponse(), which
+     * runs in the IO loop of the connection.
+     */
+    bool subscribe(const std::string &channel,
+                   const SseWriterPtr &writer,
+                   const std::string &lastEventId = std::string());
+
+    /**
+     * @brief Create an SSE response subscribing to a channel, resuming from
+     * the Last-Event-ID header of the request.
+     */
+    HttpResponsePtr newResponse(const HttpRequestPtr &req,
+                                const std::string &channel);
+
+    /// The number of subscribers of a channel.
+    size_t subscriberCount(const std::string &channel) const;
+
+  private:
+    struct Impl;
+    std::shared_ptr<Impl> impl_;
+};
+
+}  // namespace drogon
@@ -0,0 +1,146 @@
+/**
+ *
+ *  @file SseSubscriptionManager.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpClient.h>
+#include <drogon/SseEvent.h>
+#include <trantor/utils/NonCopyable.h>
+#include <trantor/net/EventLoop.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+class SseSubscriptionManager;
+using SseSubscriptionManagerPtr = std::shared_ptr<SseSubscriptionManager>;
+
+/// Many Server-Sent Events subscriptions, kept open across event loops
+/**
+ * The subscriptions are dealt to the loops in turn, the subscriptions of a
+ * loop to the same server share one HttpClient. Every subscription has a
+ * connection of its own, whose stream is parsed as it arrives. The events
+ * are passed as views into the buffers of the parser, so a single-line event
+ * received in one piece is never copied.
+ *
+ * When a connection ends or fails, it is opened again after a delay, with
+ * the ID of the last event received in the Last-Event-ID header so the
+ * server resumes the stream. The delay starts at the retry time sent by the
+ * server, or at the initial delay, doubles with every failure in a row up to
+ * the maximum delay, and is jittered, so the subscriptions to a server which
+ * restarted don't reconnect all at once. A subscription ends when the server
+ * answers 204 or a 4xx status other than 408 and 429, or after the maximum
+ * number of failures in a row.
+ *
+ * @code
+   auto manager = SseSubscriptionManager::newSseSubscriptionManager();
+   auto req = HttpRequest::newHttpRequest();
+   req->setPath("/feed");
+   auto id = manager->subscribe(
+       "http://upstream:8080", req, [](const SseEventView &event) {
+           LOG_INFO << event.event << ": " << event.data;
+       });
+   @endcode
+ */
+class DROGON_EXPORT SseSubscriptionManager : public trantor::NonCopyable
+{
+  public:
+    using SubscriptionId = uint64_t;
+
+    struct Metrics
+    {
+        /// The subscriptions which did not end
+        size_t subscriptions{0};
+        /// The subscriptions receiving their stream
+        size_t connected{0};
+        /// The connections opened again after a failure or an end
+        size_t reconnects{0};
+        /// The events passed to the callbacks
+        size_t events{0};
+    };
+
+    /**
+     * @brief Subscribe to a stream of events.
+     *
+     * @param hostString The server, as in HttpClient::newHttpClient(),
+     * e.g. "https://www.example.com:8443".
+     * @param req The request, sent again by every reconnection. It must not
+     * be changed after.
+     * @param eventCallback Called with every event, in the loop of the
+     * subscription.
+     * @param closedCallback Called when the subscription ends, with the
+     * result and the response of its last connection. It is not called
+     * after unsubscribe().
+     * @return The ID of the subscription, to unsubscribe.
+     */
+    virtual SubscriptionId subscribe(
+        const std::string &hostString,
+        const HttpRequestPtr &req,
+        SseEventViewCallback eventCallback,
+        SseClosedCallback closedCallback = nullptr) = 0;
+
+    /**
+     * @brief Close a subscription, none of its callbacks is called after.
+     * It can be called in any thread, also in the event callback.
+     */
+    virtual void unsubscribe(SubscriptionId id) = 0;
+
+    /**
+     * @brief Set the delays in seconds of the reconnections, 1 and 30 by
+     * default. The initial delay is replaced by the retry time sent by the
+     * server.
+     */
+    virtual void setReconnectDelay(double initialDelay, double maxDelay) = 0;
+
+    /**
+     * @brief Set the number of failures in a row after which a subscription
+     * ends, 0 by default for no limit. A connection which received an event
+     * is not a failure.
+     */
+    virtual void setMaxRetries(size_t maxRetries) = 0;
+
+    /**
+     * @brief Set the time in seconds to wait for the response header of a
+     * connection, 10 by default. 0 disables the timeout.
+     */
+    virtual void setTimeout(double timeout) = 0;
+
+    /**
+     * @brief Set the callback called with every new client, to set it up
+     * (setUserAgent(), addCookie()...).
+     */
+    virtual void setClientInitializer(
+        std::function<void(const HttpClientPtr &)> initializer) = 0;
+
+    /// Return the counters of the manager, summed over all its loops.
+    virtual Metrics metrics() const = 0;
+
+    /**
+     * @brief Create a manager of subscriptions.
+     *
+     * @param loops The loops of the connections. If it is empty, the IO
+     * loops of the framework, which must be running then, are used.
+     *
+     * @note The setters must be called before the first subscription.
+     */
+    static SseSubscriptionManagerPtr newSseSubscriptionManager(
+        const std::vector<trantor::EventLoop *> &loops = {},
+        bool validateCert = true);
+
+    virtual ~SseSubscriptionManager() = default;
+};
+}  // namespace drogon
@@ -153,6 +153,26 @@ class DROGON_EXPORT SseWriter
         return stream_ && !closed_;
     }
 
+    /**
+     * @brief Send an event already formatted by formatEvent()
+     *
+     * @param message The wire bytes of one or more events
+     * @return true if sent successfully
+     */
+    bool sendFormatted(const std::string &message);
+
+    /**
+     * @brief The number of bytes sent but not yet written to the connection
+     *
+     * @return 0 if it is unknown, as on HTTP/2 streams
+     */
+    size_t pendingBytes() const;
+
+    /**
+     * @brief Format an SSE event according to the specification
+     */
+    static std::string formatEvent(const SseEvent &event);
+
 #ifdef __cpp_impl_coroutine
     /**
      * @brief Coroutine-friendly send that can be awaited
@@ -190,11 +210,6 @@ class DROGON_EXPORT SseWriter
 #endif
 
   private:
-    /**
-     * @brief Format an SSE event according to the specification
-     */
-    std::string formatEvent(const SseEventPtr &event) const;
-
     ResponseStreamPtr stream_;
     std::atomic<bool> closed_{false};
 };
@@ -0,0 +1,88 @@
+/**
+ *
+ *  @file WebSocketBroadcastGroup.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/WebSocketConnection.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief A set of WebSocket connections receiving the same messages.
+ *
+ * A broadcast message is framed once into a buffer shared by all the
+ * connections, and a single task per IO loop sends it to the connections of
+ * that loop, so broadcasting to many subscribers neither copies the message
+ * per connection nor crosses threads per connection.
+ *
+ * The connections are kept until they are removed, the closed ones are
+ * dropped by the next broadcast. All the methods are thread-safe.
+ * For example:
+ * @code
+   // in a WebSocketController
+   void handleNewConnection(const HttpRequestPtr &,
+                            const WebSocketConnectionPtr &conn) override
+   {
+       group_.add(conn);
+   }
+   void handleConnectionClosed(const WebSocketConnectionPtr &conn) override
+   {
+       group_.remove(conn);
+   }
+   ...
+   group_.broadcast(message);
+   @endcode
+ * @note The messages are never compressed by permessage-deflate, and the
+ * connections of WebSocket clients, whose frames must be masked one by one,
+ * are sent the message like WebSocketConnection::send() does.
+ */
+class DROGON_EXPORT WebSocketBroadcastGroup : public trantor::NonCopyable
+{
+  public:
+    WebSocketBroadcastGroup() = default;
+
+    /// Add a connection to the group, adding it twice has no effect.
+    void add(const WebSocketConnectionPtr &conn);
+
+    /// Remove a connection from the group.
+    void remove(const WebSocketConnectionPtr &conn);
+
+    /// The number of connections in the group.
+    size_t size() const;
+
+    /**
+     * @brief Send a message to all the connections in the group.
+     *
+     * @param type Text, Binary, Ping or Pong, the control messages must not be
+     * larger than 125 bytes.
+     */
+    void broadcast(std::string_view message,
+                   WebSocketMessageType type = WebSocketMessageType::Text);
+
+  private:
+    struct Bucket;
+    using BucketPtr = std::shared_ptr<Bucket>;
+
+    mutable std::mutex mutex_;
+    // The connections grouped by their IO loops
+    std::unordered_map<trantor::EventLoop *, BucketPtr> buckets_;
+};
+
+}  // namespace drogon
@@ -24,6 +24,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <trantor/net/EventLoop.h>
 
 namespace drogon
@@ -75,6 +76,18 @@ class DROGON_EXPORT WebSocketClient
                                  const WebSocketClientPtr &,
                                  const WebSocketMessageType &)> &callback) = 0;
 
+    /**
+     * @brief Set the handler which receives the messages as views instead of
+     * the handler of setMessageHandler(). The messages of a single frame are
+     * not copied, so a view is only valid during the call.
+     *
+     * @note The handler must be set before the connection is established.
+     */
+    virtual void setMessageViewHandler(
+        const std::function<void(std::string_view message,
+                                 const WebSocketClientPtr &,
+                                 const WebSocketMessageType &)> &callback) = 0;
+
     /// Set the connection closing handler. When the connection is established
     /// or closed, the @p callback is called with a bool parameter.
     /**
@@ -115,6 +128,17 @@ class DROGON_EXPORT WebSocketClient
         const std::vector<std::pair<std::string, std::string>>
             &sslConfCmds) = 0;
 
+    /**
+     * @brief Offer the permessage-deflate extension to the server in the
+     * opening handshake, the messages are compressed if the server accepts it.
+     *
+     * @param options The limits of the negotiation, the extension is not
+     * offered if options.enabled is false (the default).
+     * @note this method must be called before connecting to the server.
+     */
+    virtual void setCompressionOptions(
+        const WebSocketCompressionOptions &options) = 0;
+
 #ifdef __cpp_impl_coroutine
     /**
      * @brief Set messages handler. When a message is received from the server,
@@ -15,8 +15,10 @@
 #pragma once
 
 #include <json/value.h>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 #include <drogon/HttpTypes.h>
 #include <string_view>
 #include <trantor/net/InetAddress.h>
@@ -85,6 +87,36 @@ enum class CloseCode
     kTLSFailed = 1015
 };
 
+/**
+ * @brief The options of the permessage-deflate extension (RFC7692) that
+ * compresses the messages of a WebSocket connection.
+ *
+ * The server and the client in Drogon negotiate the extension in the opening
+ * handshake when it is enabled, the parameters below are the limits of the
+ * negotiation, the peer may ask for lower windows or no context takeover.
+ */
+struct WebSocketCompressionOptions
+{
+    bool enabled{false};
+    /// The LZ77 window of the messages sent by the server, 9 to 15 bits.
+    uint8_t serverMaxWindowBits{15};
+    /// The LZ77 window of the messages sent by the client, 9 to 15 bits.
+    uint8_t clientMaxWindowBits{15};
+    /// Reset the compression context of the server after every message.
+    bool serverNoContextTakeover{false};
+    /// Reset the compression context of the client after every message.
+    bool clientNoContextTakeover{false};
+    /**
+     * The memory of the compression contexts of a connection in bytes. The
+     * memory level of the compressor, then the windows, are lowered to fit it,
+     * the extension is declined if they can't. A compressor with a 15 bits
+     * window and the default memory level takes about 256K.
+     */
+    size_t maxMemoryPerConnection{320 * 1024};
+    /// The messages smaller than this size in bytes are sent uncompressed.
+    size_t threshold{256};
+};
+
 /**
  * @brief The WebSocket connection abstract class.
  *
@@ -127,6 +159,32 @@ class WebSocketConnection
         const Json::Value &json,
         const WebSocketMessageType type = WebSocketMessageType::Text) = 0;
 
+    /**
+     * @brief Send several messages to the peer with a single write
+     *
+     * @param messages The messages to be sent.
+     * @param type The type of the messages.
+     */
+    virtual void sendBatch(
+        const std::vector<std::string_view> &messages,
+        const WebSocketMessageType type = WebSocketMessageType::Text) = 0;
+
+    /**
+     * @brief Coalesce the frames sent on the connection, which are written
+     * together at the end of the current loop iteration, or when the window
+     * elapses after the first of them if it is not zero. Chatty applications
+     * sending many small messages make far fewer system calls and TCP
+     * segments, at the cost of the latency of the window.
+     *
+     * @param window The time during which the frames are accumulated.
+     */
+    virtual void enableCoalescing(
+        const std::chrono::microseconds &window =
+            std::chrono::microseconds::zero()) = 0;
+
+    /// Write the frames immediately again, the pending ones are flushed.
+    virtual void disableCoalescing() = 0;
+
     /// Return the local IP address and port number of the connection
     virtual const trantor::InetAddress &localAddr() const = 0;
 
@@ -22,6 +22,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #define WS_PATH_LIST_BEGIN        \
@@ -46,6 +47,22 @@ class WebSocketControllerBase : public virtual DrObjectBase
                                   std::string &&,
                                   const WebSocketMessageType &) = 0;
 
+    // This function is called instead of handleNewMessage() when
+    // receivesMessageViews() returns true. The message is only valid during
+    // the call, the messages of a single frame are not copied.
+    virtual void handleNewMessageView(const WebSocketConnectionPtr &conn,
+                                      std::string_view message,
+                                      const WebSocketMessageType &type)
+    {
+        handleNewMessage(conn, std::string(message), type);
+    }
+
+    // Return true to receive the messages by handleNewMessageView()
+    virtual bool receivesMessageViews() const
+    {
+        return false;
+    }
+
     // This function is called after a new connection of WebSocket is
     // established.
     virtual void handleNewConnection(const HttpRequestPtr &,
@@ -20,8 +20,10 @@
 #include <trantor/utils/Logger.h>
 
 #include <drogon/CacheMap.h>
+#include <drogon/ShardedCacheMap.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/HttpClient.h>
+#include <drogon/HttpClientPool.h>
 #include <drogon/HttpController.h>
 #include <drogon/HttpSimpleController.h>
 #include <drogon/utils/Utilities.h>
@@ -34,10 +36,15 @@
 #include <drogon/plugins/SlashRemover.h>
 #include <drogon/plugins/GlobalFilters.h>
 #include <drogon/plugins/PromExporter.h>
+#include <drogon/plugins/AdmissionScheduler.h>
+#include <drogon/plugins/ConcurrencyLimiter.h>
+#include <drogon/plugins/ResponseCache.h>
 #include <drogon/IntranetIpFilter.h>
 #include <drogon/LocalHostFilter.h>
+#include <drogon/JwtAuthMiddleware.h>
 #include <drogon/Cookie.h>
 #include <drogon/Session.h>
+#include <drogon/SessionStore.h>
 #include <drogon/IOThreadStorage.h>
 #include <drogon/UploadFile.h>
 #include <drogon/orm/DbClient.h>
@@ -9,11 +9,19 @@
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/plugins/Plugin.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/InetAddress.h>
 #include <trantor/utils/AsyncFileLogger.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace drogon
 {
+template <typename T>
+class SpscRingBuffer;
+
 namespace plugin
 {
 /**
@@ -36,7 +44,13 @@ namespace plugin
             // "show_microseconds": true,
             // "custom_time_format": "",
             // "use_real_ip": false
-            // "path_exempt": ""
+            // "path_exempt": "",
+            // "async": false,
+            // "queue_size": 8192,
+            // "flush_interval": 0.05,
+            // "sink": "file",
+            // "udp_address": "127.0.0.1",
+            // "udp_port": 514
       }
    }
    @endcode
@@ -66,6 +80,10 @@ namespace plugin
  *     $processing_time: request processing time in seconds with a microseconds
  *                       resolution; time elapsed between the request object was
  *                       created and response object was created.
+ *     $phase_[phase_name]: the milliseconds the request spent in the phase
+ *                          if it is sampled by the phase tracing, "-"
+ *                          otherwise; the phases are parse, pre_route, route,
+ *                          middleware, handler and post_handle.
  * @note If the format string is empty or not configured, a default value of
  * "$request_date $method $url [$body_bytes_received] ($remote_addr -
  * $local_addr) $status $body_bytes_sent $processing_time" is applied.
@@ -103,17 +121,39 @@ namespace plugin
  * (for matching the path of a request) or a regular expression list for URLs
  * that don't have to be logged.
  *
+ * async: false by default. If true, the IO threads format the lines and push
+ * them into their own lock-free ring of queue_size lines (8192 by default), a
+ * writer thread collects the lines of all the rings every flush_interval
+ * seconds (0.05 by default) and writes them to the sink in one batch. The
+ * lines of the requests answered by other threads are pushed into a ring
+ * shared by those threads. When a ring is full, the line is dropped and
+ * counted, the number of dropped lines is logged as a warning by the writer
+ * and returned by droppedLines().
+ *
+ * sink: "file" by default, the lines are written to the same output as in
+ * the synchronous mode (log_path, spdlog or the regular log). If "udp", every
+ * line is sent in a datagram to udp_address:udp_port (127.0.0.1:514 by
+ * default), e.g. to a syslog server. Only used in the asynchronous mode.
+ *
  */
 class DROGON_EXPORT AccessLogger : public drogon::Plugin<AccessLogger>
 {
   public:
-    AccessLogger()
-    {
-    }
+    AccessLogger();
+    ~AccessLogger() override;
 
     void initAndStart(const Json::Value &config) override;
     void shutdown() override;
 
+    /**
+     * @brief Return the number of lines dropped in the asynchronous mode
+     * because their ring was full.
+     */
+    uint64_t droppedLines() const
+    {
+        return droppedLines_.load(std::memory_order_relaxed);
+    }
+
   private:
     trantor::AsyncFileLogger asyncFileLogger_;
     int logIndex_{0};
@@ -125,6 +165,25 @@ class DROGON_EXPORT AccessLogger : public drogon::Plugin<AccessLogger>
     std::regex exemptRegex_;
     bool regexFlag_{false};
 
+    using LineRing = SpscRingBuffer<std::string>;
+    bool async_{false};
+    bool useFileLogger_{false};
+    std::vector<trantor::EventLoop *> ioLoops_;
+    std::vector<std::unique_ptr<LineRing>> rings_;
+    std::mutex sharedRingMutex_;
+    std::unique_ptr<LineRing> sharedRing_;
+    std::unique_ptr<trantor::EventLoopThread> writerThread_;
+    std::string batch_;
+    std::atomic<uint64_t> droppedLines_{0};
+    uint64_t reportedDrops_{0};
+    intptr_t udpSocket_{-1};
+    std::unique_ptr<trantor::InetAddress> udpAddress_;
+    void startWriter(const Json::Value &config);
+    void stopWriter();
+    void pushLine(const char *data, size_t len);
+    void writeLines();
+    void sendLine(const std::string &line);
+
     using LogFunction = std::function<void(trantor::LogStream &,
                                            const drogon::HttpRequestPtr &,
                                            const drogon::HttpResponsePtr &)>;
@@ -0,0 +1,163 @@
+/**
+ *  @file AdmissionScheduler.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpAppFramework.h>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief The AdmissionScheduler plugin shares the handlers between classes of
+ * requests by their weights when the application is overloaded, so a flood
+ * of low priority requests does not delay the important ones.
+ *
+ * Every IO loop handles at most max_concurrency requests at the same time.
+ * The requests above it wait in the queue of their class, and the classes
+ * are served by deficit round-robin: each turn a class may start as many of
+ * its requests as its weight, so with the weights 8 and 1 a class gets 8/9 of
+ * the handlers while both are queued, and all of them when alone. When the
+ * queues of a loop are full, the oldest request of the class with the lowest
+ * weight is answered with a 503 response, and so are the requests which
+ * waited longer than queue_timeout.
+ *
+ * A request belongs to the first class it matches. A class matches the
+ * requests whose path pattern matches one of its urls, whose header has one
+ * of the values and whose string attribute (set by a filter or a middleware,
+ * e.g. the tenant) has one of the values, the conditions omitted match all
+ * requests. The requests matching no class belong to the last one.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+  {
+     "name": "drogon::plugin::AdmissionScheduler",
+     "dependencies": [],
+     "config": {
+        // The requests handled at the same time by every IO loop.
+        "max_concurrency": 64,
+        // The requests waiting in the queues of every IO loop.
+        "max_queue": 256,
+        // In seconds, the longest wait of a request in a queue.
+        "queue_timeout": 1.0,
+        "classes": [
+            {
+                "name": "checkout",
+                "weight": 8,
+                // Regular expressions for the path patterns of the handlers.
+                "urls": ["^/api/checkout.*"]
+            },
+            {
+                "name": "premium",
+                "weight": 4,
+                "header": "x-tenant-tier",
+                "header_values": ["gold", "platinum"]
+            },
+            {
+                "name": "export",
+                "weight": 1,
+                "attribute": "tenant",
+                "attribute_values": ["bulk-importer"]
+            },
+            {
+                "name": "default",
+                "weight": 2
+            }
+        ],
+        // The message body of the response when the request is rejected.
+        "rejection_message": "Service unavailable"
+     }
+  }
+  @endcode
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file. The requests are scheduled by a pre-handling advice,
+ * after the filters and middlewares of their handlers.
+ * */
+class DROGON_EXPORT AdmissionScheduler
+    : public drogon::Plugin<AdmissionScheduler>
+{
+  public:
+    AdmissionScheduler()
+    {
+    }
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+  private:
+    struct RequestClass
+    {
+        std::string name;
+        double weight{1};
+        bool matchUrls{false};
+        std::regex urls;
+        std::string header;
+        std::vector<std::string> headerValues;
+        std::string attribute;
+        std::vector<std::string> attributeValues;
+    };
+
+    struct WaitingRequest
+    {
+        AdviceCallback reject;
+        AdviceChainCallback admit;
+        std::chrono::steady_clock::time_point queuedTime;
+    };
+
+    struct ClassQueue
+    {
+        std::deque<WaitingRequest> requests;
+        double deficit{0};
+    };
+
+    /// The state of a loop, only used in it
+    struct LoopState
+    {
+        trantor::EventLoop *loop{nullptr};
+        std::vector<ClassQueue> queues;
+        size_t inFlight{0};
+        size_t queued{0};
+        size_t current{0};
+        bool dispatching{false};
+    };
+
+    /// Keep a request in the count of its loop until it is handled
+    class AdmittedRequest;
+
+    size_t classify(const HttpRequestPtr &req) const;
+    void schedule(LoopState &state,
+                  size_t requestClass,
+                  AdviceCallback &&reject,
+                  AdviceChainCallback &&admit);
+    void release(LoopState &state);
+    void dispatch(LoopState &state);
+    void shed(LoopState &state);
+    void expire(LoopState &state);
+
+    std::vector<RequestClass> classes_;
+    std::vector<std::unique_ptr<LoopState>> loops_;
+    size_t maxConcurrency_{64};
+    size_t maxQueue_{256};
+    std::chrono::steady_clock::duration queueTimeout_{std::chrono::seconds(1)};
+    HttpResponsePtr rejectResponse_;
+};
+}  // namespace plugin
+}  // namespace drogon
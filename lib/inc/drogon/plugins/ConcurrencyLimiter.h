@@ -0,0 +1,122 @@
+/**
+ *  @file ConcurrencyLimiter.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpAppFramework.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief The ConcurrencyLimiter plugin bounds the number of requests being
+ * handled by every handler at the same time, and adapts the bound to the
+ * latency of the handler.
+ *
+ * Every handler (a path pattern and a method, as in
+ * HttpAppFramework::getHandlersInfo()) has its own limit. The limit grows by
+ * about one after every limit requests completed in time, and is multiplied
+ * by the backoff ratio, at most once per average latency, when a request
+ * takes too long (AIMD). A request above the limit gets a 503 response before
+ * it reaches the handler, so the queues do not grow when the traffic spikes.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+  {
+     "name": "drogon::plugin::ConcurrencyLimiter",
+     "dependencies": [],
+     "config": {
+        // A regular expression list for the path patterns of the handlers
+to be limited. if the list is empty, all handlers are limited.
+        "urls": ["^/api/.*", ...],
+        // The limit of a handler when the application starts.
+        "initial_limit": 20,
+        // The minimum and maximum limits.
+        "min_limit": 1,
+        "max_limit": 1000,
+        // The ratio by which the limit is multiplied when a request takes
+too long.
+        "backoff_ratio": 0.9,
+        // In milliseconds, the latency above which a request takes too long.
+the default value 0 means the latency_tolerance times the average latency of
+the handler.
+        "latency_threshold": 0,
+        "latency_tolerance": 2.0,
+        // The message body of the response when the request is rejected.
+        "rejection_message": "Service unavailable"
+     }
+  }
+  @endcode
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file. The handlers registered by other plugins are limited
+ * only if those plugins are in the dependencies list.
+ * */
+class DROGON_EXPORT ConcurrencyLimiter
+    : public drogon::Plugin<ConcurrencyLimiter>
+{
+  public:
+    ConcurrencyLimiter()
+    {
+    }
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+    /**
+     * @brief Return the current limit of a handler, or 0 if the handler is
+     * not limited.
+     */
+    size_t limitOf(const std::string &pathPattern, HttpMethod method) const;
+
+  private:
+    struct RouteLimit
+    {
+        std::atomic<size_t> inFlight{0};
+        std::atomic<size_t> limit{0};
+        // The fields below are protected by the mutex
+        std::mutex mutex;
+        double exactLimit{0};
+        double averageLatency{0};
+        std::chrono::steady_clock::time_point lastBackoff;
+    };
+
+    /// Keep a request in the count of its handler until it is handled
+    class InFlightRequest;
+
+    using RouteLimits = std::array<std::unique_ptr<RouteLimit>, Invalid>;
+
+    RouteLimit *findLimit(const HttpRequestPtr &req) const;
+    void onCompletion(RouteLimit &route,
+                      std::chrono::steady_clock::duration latency,
+                      size_t inFlight);
+
+    std::map<std::string, RouteLimits, std::less<>> routes_;
+    size_t initialLimit_{20};
+    size_t minLimit_{1};
+    size_t maxLimit_{1000};
+    double backoffRatio_{0.9};
+    std::chrono::steady_clock::duration latencyThreshold_{0};
+    double latencyTolerance_{2.0};
+    HttpResponsePtr rejectResponse_;
+};
+}  // namespace plugin
+}  // namespace drogon
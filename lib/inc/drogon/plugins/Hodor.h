@@ -15,7 +15,9 @@
 #include <drogon/plugins/Plugin.h>
 #include <drogon/plugins/RealIpResolver.h>
 #include <drogon/HttpAppFramework.h>
-#include <drogon/CacheMap.h>
+#include <drogon/IOThreadStorage.h>
+#include <drogon/ShardedCacheMap.h>
+#include <drogon/SharedMemoryMap.h>
 #include <regex>
 #include <optional>
 
@@ -35,7 +37,8 @@ namespace plugin
      "config": {
         // The algorithm used to limit the number of requests.
         // The default value is "token_bucket". other values are "fixed_window"
-or "sliding_window".
+or "sliding_window", or "atomic_token_bucket" and "atomic_sliding_window"
+which are shared by threads without lock.
         "algorithm": "token_bucket",
         // a regular expression (for matching the path of a request) list for
 URLs that have to be limited. if the list is empty, all URLs are limited.
@@ -74,9 +77,30 @@ IPs or users. the default value is 600.
         ],
         // Trusted proxy ip or cidr
         "trust_ips": ["127.0.0.1", "172.16.0.0/12"],
+        // The name of the redis client with which the limits are shared by
+all instances of the application. empty by default, which limits every instance
+on its own. The shared limiters count fixed windows in Redis whatever the
+algorithm is, so all instances must use the same time unit.
+        "redis_client": "",
+        // The number of tokens an instance leases from Redis at a time. most
+requests are decided without accessing Redis, an instance may exceed a limit by
+up to this number of requests in a window. the default value is 10.
+        "redis_lease_size": 10,
+        // The prefix of the redis keys of the limiters.
+        "redis_key_prefix": "drogon:hodor:",
+        // The path of a file mapped by the processes of the host, like the
+worker processes of the application, with which they share the limits
+without Redis (see SharedMemoryMap). The shared limiters count fixed windows
+whatever the algorithm is. empty by default, ignored with a redis client.
+        "shared_memory_file": "",
+        // The number of counters of the file, 2 per limiter in use.
+        "shared_memory_capacity": 65536
      }
   }
   @endcode
+ * The urls, the capacities and the sub_limits can be changed by reloading
+ * the configuration file (see HttpAppFramework::reloadConfigFile()), which
+ * restarts the counting of all the limits.
  *
  * Enable the plugin by adding the configuration to the list of plugins in the
  * configuration file.
@@ -90,6 +114,7 @@ class DROGON_EXPORT Hodor : public drogon::Plugin<Hodor>
 
     void initAndStart(const Json::Value &config) override;
     void shutdown() override;
+    bool reloadConfig(const Json::Value &config) override;
 
     /**
      * @brief the method is used to set a function to get the user id from the
@@ -121,25 +146,40 @@ class DROGON_EXPORT Hodor : public drogon::Plugin<Hodor>
         size_t ipCapacity{0};
         size_t userCapacity{0};
         bool regexFlag{false};
+        std::string redisKeyPrefix;
         RateLimiterPtr globalLimiterPtr;
-        std::unique_ptr<CacheMap<std::string, RateLimiterPtr>> ipLimiterMapPtr;
-        std::unique_ptr<CacheMap<std::string, RateLimiterPtr>>
+        std::unique_ptr<ShardedCacheMap<std::string, RateLimiterPtr>>
+            ipLimiterMapPtr;
+        std::unique_ptr<ShardedCacheMap<std::string, RateLimiterPtr>>
             userLimiterMapPtr;
     };
 
-    LimitStrategy makeLimitStrategy(const Json::Value &config);
-    std::vector<LimitStrategy> limitStrategies_;
+    using LimitStrategies = std::vector<LimitStrategy>;
+
+    LimitStrategy makeLimitStrategy(const Json::Value &config, size_t index);
+    std::shared_ptr<const LimitStrategies> makeLimitStrategies(
+        const Json::Value &config);
+    RateLimiterPtr newLimiter(size_t capacity,
+                              const std::string &redisKey) const;
+    // Replaced when the configuration is reloaded
+    std::unique_ptr<IOThreadSnapshot<LimitStrategies>> limitStrategies_;
+    // The options which can't be reloaded
+    Json::Value fixedConfig_;
     RateLimiterType algorithm_{RateLimiterType::kTokenBucket};
     std::chrono::duration<double> timeUnit_{1.0};
     bool multiThreads_{true};
     bool useRealIpResolver_{false};
     size_t limiterExpireTime_{600};
+    nosql::RedisClientPtr redisClientPtr_;
+    size_t redisLeaseSize_{10};
+    std::string redisKeyPrefix_;
+    SharedMemoryMapPtr sharedMemoryPtr_;
     std::function<std::optional<std::string>(const drogon::HttpRequestPtr &)>
         userIdGetter_;
     std::function<HttpResponsePtr(const drogon::HttpRequestPtr &)>
         rejectResponseFactory_;
 
-    RealIpResolver::CIDRs trustCIDRs_;
+    IpSet trustIps_;
 
     void onHttpRequest(const drogon::HttpRequestPtr &,
                        AdviceCallback &&,
@@ -0,0 +1,83 @@
+/**
+ *  @file IpFilter.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpResponse.h>
+#include <drogon/IpSet.h>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief The IpFilter plugin accepts or rejects the requests by the address
+ * of the client, before they are routed.
+ *
+ * An address in the allow list is always accepted. An address in the deny
+ * list is rejected, and so is any address out of the allow list if it is not
+ * empty. The lists are kept in IpSet tries, so they can hold the hundreds of
+ * thousands of entries of threat feeds without slowing the requests down.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+  {
+     "name": "drogon::plugin::IpFilter",
+     "dependencies": [],
+     "config": {
+        // The ip addresses or cidr blocks, ipv4 or ipv6, always accepted.
+if the list is not empty, the other addresses are rejected.
+        "allow": ["10.0.0.0/8", "::1"],
+        // The files of addresses or cidr blocks always accepted, one per line.
+the text after a '#' or a ';' in a line is ignored.
+        "allow_files": [],
+        // The ip addresses or cidr blocks rejected.
+        "deny": [],
+        // The files of addresses or cidr blocks rejected, like threat feeds.
+        "deny_files": ["/etc/drogon/drop.txt"],
+        // Use the RealIpResolver plugin to get the real IP address of the
+request. if this option is true, the RealIpResolver plugin should be added to
+the dependencies list. the default value is false.
+        "use_real_ip_resolver": false,
+        // The status code of the response when the request is rejected.
+        "rejection_status": 403,
+        // The message body of the response when the request is rejected.
+        "rejection_message": "Forbidden"
+     }
+  }
+  @endcode
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ * */
+class DROGON_EXPORT IpFilter : public drogon::Plugin<IpFilter>
+{
+  public:
+    IpFilter()
+    {
+    }
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+    /// Return true if a request from the address is accepted
+    bool isAllowed(const trantor::InetAddress &addr) const;
+
+  private:
+    IpSet allowed_;
+    IpSet denied_;
+    bool useRealIpResolver_{false};
+    HttpResponsePtr rejectResponse_;
+};
+}  // namespace plugin
+}  // namespace drogon
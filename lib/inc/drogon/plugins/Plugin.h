@@ -70,6 +70,37 @@ class DROGON_EXPORT PluginBase : public virtual DrObjectBase,
     /// It must be implemented by the user.
     virtual void shutdown() = 0;
 
+    /**
+     * @brief Apply a configuration reloaded while the application runs (see
+     * HttpAppFramework::reloadConfigFile()), in the main loop. The plugins
+     * which don't override this method keep their configuration until the
+     * application is restarted.
+     *
+     * @return false if the configuration is not applied.
+     * @note Throw to reject an invalid configuration, the whole reload fails
+     * and the plugins reloaded before this one get their previous
+     * configuration back.
+     */
+    virtual bool reloadConfig(const Json::Value &config)
+    {
+        (void)config;
+        return false;
+    }
+
+    /// This method is called by drogon when the configuration is reloaded.
+    void reload(const Json::Value &config)
+    {
+        if (status_ != PluginStatus::Initialized || config == config_)
+            return;
+        if (reloadConfig(config))
+        {
+            config_ = config;
+            return;
+        }
+        LOG_WARN << "The new configuration of the plugin " << className()
+                 << " is applied when the application is restarted";
+    }
+
     virtual ~PluginBase()
     {
     }
@@ -82,6 +113,7 @@ class DROGON_EXPORT PluginBase : public virtual DrObjectBase,
   private:
     PluginStatus status_{PluginStatus::None};
     friend class PluginsManager;
+    friend class ConfigLoader;
 
     void setConfig(const Json::Value &config)
     {
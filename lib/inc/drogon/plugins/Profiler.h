@@ -0,0 +1,83 @@
+/**
+ *
+ *  @file Profiler.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief The Profiler plugin takes CPU profiles of the running application on
+ * demand, e.g. `go tool pprof http://host/debug/pprof/profile?seconds=10`.
+ *
+ * A GET request of the path samples the stacks of all the threads for the
+ * given seconds and is answered with the gzipped pprof profile. The samples
+ * are labelled by the "loop" which took them and the "route" pattern of the
+ * handler running, e.g. `pprof -tagfocus=route=/api/users/{id}`. Only one
+ * profile is taken at a time, the requests received meanwhile are answered
+ * with the 409 status. The profiler costs nothing when no profile is taken.
+ *
+ * The profiler is only implemented on Linux, with a SIGPROF timer, so the
+ * application mustn't use the signal for itself.
+ *
+ * The json configuration is as follows:
+ * @code
+   {
+      "name": "drogon::plugin::Profiler",
+      "dependencies": [],
+      "config": {
+         // The path of the profiles.
+         "path": "/debug/pprof/profile",
+         // The requests must carry an "Authorization: Bearer <token>" header
+         // with the token. If it is empty, only the requests from the
+         // loopback addresses are accepted.
+         "token": "",
+         // The duration of the profiles without a seconds parameter and the
+         // longest one, in seconds.
+         "default_seconds": 30,
+         "max_seconds": 60,
+         // The samples per second of CPU time of every thread.
+         "frequency": 100,
+         // The samples beyond it are dropped, each takes about half a KiB
+         // while the profile is taken.
+         "max_samples": 30000
+      }
+   }
+   @endcode
+ */
+class DROGON_EXPORT Profiler : public drogon::Plugin<Profiler>,
+                               public std::enable_shared_from_this<Profiler>
+{
+  public:
+    Profiler()
+    {
+    }
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+  private:
+    std::string path_{"/debug/pprof/profile"};
+    std::string token_;
+    double defaultSeconds_{30};
+    double maxSeconds_{60};
+    int frequency_{100};
+    size_t maxSamples_{30000};
+};
+}  // namespace plugin
+}  // namespace drogon
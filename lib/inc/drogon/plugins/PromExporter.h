@@ -15,6 +15,7 @@
 #include <drogon/plugins/Plugin.h>
 #include <drogon/utils/monitoring/Registry.h>
 #include <drogon/utils/monitoring/Collector.h>
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -32,6 +33,17 @@ namespace plugin
       "config": {
          // The path of the metrics. the default value is "/metrics".
          "path": "/metrics",
+         // Compress the metrics with gzip for the scrapers accepting it. The
+         // default value is false.
+         "gzip": false,
+         // Export the metrics collected by the framework itself, i.e. the
+         // count, latency and body bytes of the requests of every handler,
+         // the connections of every IO loop and the time the database and
+         // redis commands wait for a connection. The default value is false.
+         "builtin_metrics": false,
+         // The bucket boundaries (in seconds) of the latency histograms of
+         // the builtin metrics.
+         "latency_buckets": [0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5],
          // The list of collectors.
          "collectors":[
             {
@@ -41,7 +53,7 @@ namespace plugin
                "help": "The total number of http requests",
                // The type of the collector. The default value is "counter".
                // The other possible value is as following:
-               // "gauge", "histogram".
+               // "gauge", "histogram", "summary".
                "type": "counter",
                // The labels of the collector.
                "labels": ["method", "status"]
@@ -50,6 +62,14 @@ namespace plugin
       }
     }
     @endcode
+ * The metrics are rendered in the compute pool, not in the IO loop of the
+ * scrape, and in the OpenMetrics format for the scrapers accepting
+ * application/openmetrics-text.
+ *
+ * With worker processes (see HttpAppFramework::setWorkerProcesses()), the
+ * worker which is scraped adds the metrics of the other ones, published by
+ * them every second, to its own. The values of the same samples are summed.
+ * The merged metrics are always in the Prometheus text format.
  * */
 class DROGON_EXPORT PromExporter
     : public drogon::Plugin<PromExporter>,
@@ -92,7 +112,10 @@ class DROGON_EXPORT PromExporter
                        std::shared_ptr<drogon::monitoring::CollectorBase>>
         collectors_;
     std::string path_{"/metrics"};
-    std::string exportMetrics();
+    bool gzip_{false};
+    // The size of the last scrape, reserved for the next one
+    std::atomic<size_t> lastSize_{0};
+    std::string exportMetrics(bool openMetrics = false);
 };
 }  // namespace plugin
 }  // namespace drogon
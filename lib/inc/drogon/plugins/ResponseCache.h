@@ -0,0 +1,189 @@
+/**
+ *  @file ResponseCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpAppFramework.h>
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+class HttpResponseImpl;
+
+namespace plugin
+{
+/**
+ * @brief The ResponseCache plugin caches the responses of GET requests in a
+ * local LRU tier shared by the IO threads and, optionally, in Redis to share
+ * them between the instances of the application.
+ *
+ * A cached response is served before it reaches the handler. The requests
+ * missing the cache at the same time for the same key are coalesced: only
+ * the first one is handled, the others get a copy of its response. A response
+ * older than the ttl but within the stale_while_revalidate window is still
+ * served while a single request refreshes it in the background, so the
+ * expiry of a hot page doesn't send a burst of requests to the handler.
+ *
+ * Only the responses whose status code is listed, without cookies and
+ * without a no-store or private Cache-Control directive are cached. The
+ * requests with an Authorization header or cookies have entries of their
+ * own, which only keep the responses with a public Cache-Control
+ * directive, so a personalized response is never served to another client.
+ * A response with a Vary header is cached only if every field it lists is
+ * one of the key_headers, or accept-encoding. The Host header is always part
+ * of the key. The compressed bodies are cached along the entries of the local
+ * tier, Redis keeps the uncompressed one.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+  {
+     "name": "drogon::plugin::ResponseCache",
+     "dependencies": [],
+     "config": {
+        // A regular expression list for the paths to be cached. if the list
+is empty, all GET requests are cached.
+        "urls": ["^/api/public/.*", ...],
+        // In seconds, how long a response is fresh.
+        "ttl": 60,
+        // In seconds, how long a response is served after its ttl while it is
+refreshed.
+        "stale_while_revalidate": 30,
+        // Whether the query string is part of the key.
+        "key_query": true,
+        // The request headers whose values are part of the key.
+        "key_headers": ["accept-language"],
+        // The status codes of the cached responses.
+        "status_codes": [200],
+        // The size limit of the local tier in bytes, 0 disables it.
+        "local_max_bytes": 67108864,
+        // The size limit of a cached body in bytes.
+        "max_body_size": 1048576,
+        // The name of the redis client of the redis tier, the redis tier is
+disabled if it is empty.
+        "redis_client": "",
+        // The prefix of the redis keys.
+        "redis_key_prefix": "drogon:response:"
+     }
+  }
+  @endcode
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ * */
+class DROGON_EXPORT ResponseCache : public drogon::Plugin<ResponseCache>
+{
+  public:
+    ResponseCache()
+    {
+    }
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+    /// The key of the cached response of a request, made of its host, its
+    /// path and the configured parts
+    std::string cacheKey(const HttpRequestPtr &req) const;
+
+    /// Remove a cached response from both tiers
+    void invalidate(const std::string &key);
+
+  private:
+    struct Entry
+    {
+        std::string key;
+        // The uncompressed response, copied for every hit
+        HttpResponsePtr response;
+        // The compressed responses, indexed by their content encoding, built
+        // on the first hit of every encoding. Protected by the mutex.
+        std::array<HttpResponsePtr, 4> variants;
+        bool compressible{false};
+        // Microseconds since the epoch
+        int64_t storedAt{0};
+        size_t bytes{0};
+    };
+
+    using EntryPtr = std::shared_ptr<Entry>;
+    using EntryList = std::list<EntryPtr>;
+
+    struct Waiter
+    {
+        HttpRequestPtr req;
+        AdviceCallback adviceCallback;
+        AdviceChainCallback chainCallback;
+    };
+
+    /// Release the waiters of a key once the request it owns is handled
+    class Leader;
+
+    void lookup(const HttpRequestPtr &req,
+                std::string &&key,
+                AdviceCallback &&adviceCallback,
+                AdviceChainCallback &&chainCallback);
+    void fetch(const HttpRequestPtr &req,
+               const std::shared_ptr<Leader> &leader,
+               AdviceCallback &&adviceCallback,
+               AdviceChainCallback &&chainCallback);
+    void revalidate(const HttpRequestPtr &req, const std::string &key);
+    void onResponse(const std::string &key, const HttpResponsePtr &resp);
+    void land(const std::string &key, const EntryPtr &entry);
+    /// Return nullptr if the response can't be cached
+    EntryPtr makeEntry(const std::string &key,
+                       const HttpResponsePtr &resp) const;
+    static EntryPtr makeEntry(
+        const std::string &key,
+        const std::shared_ptr<HttpResponseImpl> &prototype,
+        int64_t storedAt);
+    /// Parse an entry stored in redis, return nullptr if it's malformed
+    static EntryPtr decodeEntry(const std::string &key, std::string_view data);
+    void store(const EntryPtr &entry);
+    HttpResponsePtr responseOf(const HttpRequestPtr &req,
+                               const EntryPtr &entry);
+    bool isFresh(const Entry &entry, int64_t now) const
+    {
+        return now - entry.storedAt < ttl_;
+    }
+    bool isUsable(const Entry &entry, int64_t now) const
+    {
+        return now - entry.storedAt < ttl_ + staleWhileRevalidate_;
+    }
+
+    std::regex urlsRegex_;
+    bool regexFlag_{false};
+    // In microseconds
+    int64_t ttl_{60000000};
+    int64_t staleWhileRevalidate_{30000000};
+    bool keyQuery_{true};
+    std::vector<std::string> keyHeaders_;
+    std::vector<int> statusCodes_;
+    size_t maxBytes_{64 * 1024 * 1024};
+    size_t maxBodySize_{1024 * 1024};
+    std::string redisClientName_;
+    std::string redisKeyPrefix_;
+
+    std::mutex mutex_;
+    EntryList entries_;
+    std::unordered_map<std::string, EntryList::iterator> index_;
+    size_t bytes_{0};
+    // The keys being fetched or handled, with the requests waiting for them
+    std::unordered_map<std::string, std::vector<Waiter>> flights_;
+};
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,146 @@
+/**
+ *  @file ReverseProxy.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpAppFramework.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+class UpstreamBalancer;
+
+template <typename C>
+class IOThreadStorage;
+
+namespace plugin
+{
+/**
+ * @brief The ReverseProxy plugin forwards the requests under some paths to a
+ * group of upstream HTTP/1.1 servers.
+ *
+ * The bodies are streamed in both directions: the response body is passed
+ * to the client as it arrives from the upstream server, reading from the
+ * upstream connection pauses while the client connection has more than
+ * high_watermark bytes to write. With the request stream enabled
+ * (HttpAppFramework::enableRequestStream()), the request body is passed to
+ * the upstream server as it arrives as well, with the same back pressure.
+ *
+ * Every IO thread keeps its own pool of idle keep-alive connections to
+ * every upstream server. The servers are chosen in turn, by the fewest
+ * requests in flight, by the lowest latency (a decaying average weighted by
+ * the requests in flight) or by a consistent hash of the client address, the
+ * path or a header. A server failing max_fails times within fail_timeout
+ * (connection errors, timeouts, invalid responses and the 502, 503 and 504
+ * responses) is skipped for fail_timeout. A request which got no response
+ * from a server is tried once more on another server, unless its method is
+ * not idempotent and it was sent, or its body was streamed.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+  {
+     "name": "drogon::plugin::ReverseProxy",
+     "dependencies": [],
+     "config": {
+        // The upstream servers, a path after the address is prepended to the
+paths of the requests.
+        "backends": ["http://127.0.0.1:8081", "https://10.0.0.2/app"],
+        // The path prefixes of the requests to be proxied. if the list is
+empty, all requests are proxied.
+        "path_prefixes": ["/api/"],
+        // Whether the matched prefix is removed from the forwarded path.
+        "strip_prefix": false,
+        // round_robin, least_connections, ewma_latency or consistent_hash.
+        "balancing": "round_robin",
+        // The key of consistent_hash: ip, path or header:<name>.
+        "hash_key": "ip",
+        // The number of failures marking a server down, 0 disables the
+passive health check.
+        "max_fails": 3,
+        // In seconds, the window of the failures and how long a server is
+down.
+        "fail_timeout": 10,
+        // The idle connections kept per upstream server in every IO thread.
+        "max_idle_connections": 32,
+        // In seconds, how long an idle connection is kept.
+        "idle_timeout": 60,
+        // In seconds, how long to wait for the header of the upstream
+response, including the connection, 0 means no limit.
+        "response_timeout": 60,
+        // The bytes buffered by a connection before the other side pauses.
+        "high_watermark": 1048576,
+        // Whether the Host header of the request is forwarded, instead of
+the address of the upstream server.
+        "preserve_host": false,
+        // Whether the X-Forwarded-For and X-Forwarded-Proto headers are set.
+        "forwarded_headers": true,
+        // Whether the certificates of the https servers are validated.
+        "validate_cert": true
+     }
+  }
+  @endcode
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file. Protocol upgrades (e.g. WebSocket) are not proxied.
+ * */
+class DROGON_EXPORT ReverseProxy : public drogon::Plugin<ReverseProxy>
+{
+  public:
+    ReverseProxy();
+    ~ReverseProxy() override;
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+  private:
+    enum class HashKey
+    {
+        kIp,
+        kPath,
+        kHeader
+    };
+
+    struct Upstream;
+    class Connection;
+    class Exchange;
+    struct LoopPool;
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    /// Return the matched prefix length, or -1 if the path isn't proxied
+    long matchPrefix(const std::string &path) const;
+    std::string hashKeyOf(const HttpRequestPtr &req) const;
+    ConnectionPtr takeIdle(size_t backend);
+    void putIdle(const ConnectionPtr &connection);
+    void removeIdle(const ConnectionPtr &connection);
+    ConnectionPtr newConnection(size_t backend, trantor::EventLoop *loop);
+
+    std::vector<Upstream> upstreams_;
+    std::unique_ptr<UpstreamBalancer> balancer_;
+    std::unique_ptr<IOThreadStorage<LoopPool>> pools_;
+    std::vector<std::string> pathPrefixes_;
+    bool stripPrefix_{false};
+    HashKey hashKey_{HashKey::kIp};
+    std::string hashHeader_;
+    size_t maxIdle_{32};
+    // In microseconds
+    int64_t idleTimeout_{60000000};
+    double responseTimeout_{60};
+    size_t highWatermark_{1024 * 1024};
+    bool preserveHost_{false};
+    bool forwardedHeaders_{true};
+    bool validateCert_{true};
+};
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,79 @@
+/**
+ *
+ *  @file RuntimeInspector.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief The RuntimeInspector plugin shows the state of the running
+ * application in JSON, to diagnose the overloads.
+ *
+ * A GET request of the path is answered with:
+ * - "loops": for every IO loop, the delay of its task queue, its open HTTP
+ *   connections with their peer, age, bytes and pipelined requests, and the
+ *   pipelined requests of all of them;
+ * - "db_clients" and "redis_clients": the busy, idle and established
+ *   connections of every shared client and the commands waiting for one;
+ * - "sessions": the sessions held in memory.
+ *
+ * The state of a loop is read by a task queued in it, so the connections
+ * are tracked without locks. The clients are read under their own lock once
+ * per request.
+ *
+ * The json configuration is as follows:
+ * @code
+   {
+      "name": "drogon::plugin::RuntimeInspector",
+      "dependencies": [],
+      "config": {
+         // The path of the state.
+         "path": "/debug/runtime",
+         // The requests must carry an "Authorization: Bearer <token>" header
+         // with the token. If it is empty, only the requests from the
+         // loopback addresses are accepted.
+         "token": "",
+         // The connections listed per loop, the others are only counted.
+         "max_listed_connections": 100
+      }
+   }
+   @endcode
+ */
+class DROGON_EXPORT RuntimeInspector
+    : public drogon::Plugin<RuntimeInspector>,
+      public std::enable_shared_from_this<RuntimeInspector>
+{
+  public:
+    RuntimeInspector()
+    {
+    }
+
+    void initAndStart(const Json::Value &config) override;
+
+    void shutdown() override
+    {
+    }
+
+  private:
+    std::string path_{"/debug/runtime"};
+    std::string token_;
+    size_t maxListedConnections_{100};
+};
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,103 @@
+/**
+ *
+ *  @file Tracer.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpClient.h>
+#include <drogon/plugins/Plugin.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+struct SpanData;
+
+namespace plugin
+{
+/**
+ * @brief The Tracer plugin traces the requests with the W3C trace context and
+ * exports the spans to an OpenTelemetry collector by OTLP/HTTP in JSON.
+ *
+ * Every request gets a server span continuing the trace of its traceparent
+ * header. The http requests, SQL statements and redis commands sent from its
+ * handler, callbacks or coroutines, get child spans, and the http requests
+ * carry their traceparent header to the next service. The calls made from
+ * the callbacks of other calls are not traced.
+ *
+ * The json configuration is as follows:
+ * @code
+   {
+      "name": "drogon::plugin::Tracer",
+      "dependencies": [],
+      "config": {
+         // The OTLP/HTTP endpoint of the collector.
+         "endpoint": "http://127.0.0.1:4318",
+         "path": "/v1/traces",
+         // The headers of the export requests, e.g. for the authentication.
+         "headers": {},
+         // The service.name attribute of the spans.
+         "service_name": "drogon",
+         // The fraction of the traces started by this service which are
+         // sampled, the traces continued from another service follow its
+         // decision. The default value is 1.
+         "sample_ratio": 1.0,
+         // Record the traces which are not sampled too, and export the ones
+         // with an error (a 5xx status or a failed call) or slower than
+         // tail_latency seconds when their request is answered. The default
+         // value is false.
+         "tail_sampling": false,
+         "tail_latency": 0,
+         "keep_errors": true,
+         // The spans are exported every export_interval seconds, or as soon
+         // as batch_size spans are waiting. The spans beyond max_queue_size
+         // are dropped.
+         "batch_size": 512,
+         "export_interval": 5,
+         "max_queue_size": 4096
+      }
+   }
+   @endcode
+ */
+class DROGON_EXPORT Tracer : public drogon::Plugin<Tracer>,
+                             public std::enable_shared_from_this<Tracer>
+{
+  public:
+    Tracer();
+    ~Tracer() override;
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+  private:
+    void enqueue(std::vector<SpanData> &&spans);
+    void flush();
+    std::string toOtlpJson(const std::vector<SpanData> &spans) const;
+
+    HttpClientPtr client_;
+    std::string path_{"/v1/traces"};
+    std::map<std::string, std::string> headers_;
+    std::string serviceName_{"drogon"};
+    size_t batchSize_{512};
+    size_t maxQueueSize_{4096};
+    trantor::TimerId timerId_{0};
+
+    std::mutex mutex_;
+    std::vector<SpanData> queue_;
+    bool flushQueued_{false};
+    size_t dropped_{0};
+};
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,166 @@
+/**
+ *
+ *  @file TrafficCapture.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpTypes.h>
+#include <drogon/plugins/Plugin.h>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace trantor
+{
+class EventLoop;
+class EventLoopThread;
+}  // namespace trantor
+
+namespace drogon
+{
+template <typename T>
+class SpscRingBuffer;
+
+namespace plugin
+{
+/**
+ * @brief The TrafficCapture plugin samples the incoming requests into a
+ * binary log, which `drogon_ctl press -l` replays against a server to
+ * benchmark it with the real traffic.
+ *
+ * The method, the path, the query, the headers and the body of a sampled
+ * request are recorded with the time since the previous sampled request.
+ * The IO threads push the requests into their own lock-free ring, a writer
+ * thread sorts them by arrival and appends them to the file every
+ * flush_interval seconds. When a ring is full, the request is dropped and
+ * counted.
+ *
+ * The json configuration is as follows:
+ * @code
+   {
+      "name": "drogon::plugin::TrafficCapture",
+      "dependencies": [],
+      "config": {
+         // The log, overwritten when the plugin starts.
+         "file": "./traffic.cap",
+         // The fraction of the requests recorded. The gaps in the log are
+         // those of the sample, replay a 1% sample at 100x to get the
+         // original rate.
+         "sample_ratio": 1.0,
+         // The longer bodies are cut.
+         "max_body_size": 65536,
+         // The headers not recorded, in lower case.
+         "exclude_headers": ["authorization", "proxy-authorization",
+                             "cookie"],
+         // The capture stops when the log reaches the size, 0 for no limit.
+         "max_file_size": 0,
+         "queue_size": 8192,
+         "flush_interval": 0.1
+      }
+   }
+   @endcode
+ *
+ * A log is the fileMagic() followed by the records written by encode().
+ */
+class DROGON_EXPORT TrafficCapture : public drogon::Plugin<TrafficCapture>
+{
+  public:
+    struct Record
+    {
+        // In microseconds, the time since the previous request of the log
+        uint64_t gap{0};
+        HttpMethod method{Get};
+        std::string path;
+        std::string query;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+    };
+
+    TrafficCapture();
+    ~TrafficCapture() override;
+
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+    /**
+     * @brief Append the record to the output.
+     */
+    static void encode(const Record &record, std::string &output);
+
+    /**
+     * @brief Decode the record at the start of the data.
+     * @return The number of bytes of the record, 0 if the data does not start
+     * with a complete and valid one.
+     */
+    static size_t decode(std::string_view data, Record &record);
+
+    static constexpr std::string_view fileMagic()
+    {
+        return "DRTCAP1\n";
+    }
+
+    uint64_t capturedRequests() const
+    {
+        return captured_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief The number of sampled requests dropped because their ring was
+     * full or the log reached max_file_size.
+     */
+    uint64_t droppedRequests() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    // A request as pushed by the IO threads
+    struct Pending
+    {
+        // In microseconds since the epoch
+        int64_t arrival{0};
+        Record record;
+    };
+
+    using PendingRing = SpscRingBuffer<Pending>;
+    double sampleRatio_{1.0};
+    size_t maxBodySize_{65536};
+    uint64_t maxFileSize_{0};
+    std::unordered_set<std::string> excludedHeaders_;
+    std::vector<trantor::EventLoop *> ioLoops_;
+    std::vector<std::unique_ptr<PendingRing>> rings_;
+    std::mutex sharedRingMutex_;
+    std::unique_ptr<PendingRing> sharedRing_;
+    std::unique_ptr<trantor::EventLoopThread> writerThread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> captured_{0};
+    std::atomic<uint64_t> dropped_{0};
+    // Only touched by the writer
+    std::ofstream file_;
+    uint64_t fileSize_{0};
+    bool full_{false};
+    int64_t lastArrival_{0};
+    std::vector<Pending> batch_;
+    std::string buffer_;
+    uint64_t reportedDrops_{0};
+    void push(Pending &&pending);
+    void writeRecords();
+};
+}  // namespace plugin
+}  // namespace drogon
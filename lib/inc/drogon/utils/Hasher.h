@@ -0,0 +1,99 @@
+/**
+ *
+ *  @file Hasher.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+namespace utils
+{
+/// The algorithms of utils::getMd5(), getSha1(), getSha256(), getSha3() and
+/// getBlake2b()
+enum class HashAlgorithm
+{
+    kMd5,
+    kSha1,
+    kSha256,
+    kSha3,
+    kBlake2b
+};
+
+/**
+ * @brief A hash computed over data fed in pieces, e.g. a streamed upload or
+ * the slices of a mapped file.
+ *
+ * The digests are the same as the ones of utils::getMd5() and the other
+ * functions of the same algorithm over the whole data. When drogon is built
+ * with OpenSSL, MD5, SHA-1, SHA-256 and SHA3-256 are computed by its EVP
+ * implementations, which use the SHA extensions of x86 and ARMv8 CPUs.
+ *
+ * @code
+   utils::Hasher hasher(utils::HashAlgorithm::kSha256);
+   hasher.update(part1);
+   hasher.update(part2);
+   unsigned char digest[utils::Hasher::kMaxDigestLength];
+   auto length = hasher.final(digest);
+   @endcode
+ */
+class DROGON_EXPORT Hasher
+{
+  public:
+    static constexpr size_t kMaxDigestLength = 32;
+
+    explicit Hasher(HashAlgorithm algorithm);
+    ~Hasher();
+    Hasher(Hasher &&) noexcept;
+    Hasher &operator=(Hasher &&) noexcept;
+
+    HashAlgorithm algorithm() const
+    {
+        return algorithm_;
+    }
+
+    /// The length of the raw digest: 16 bytes for MD5, 20 bytes for SHA-1
+    /// and 32 bytes for the others.
+    size_t digestLength() const;
+
+    void update(const void *data, size_t length);
+
+    void update(std::string_view data)
+    {
+        update(data.data(), data.size());
+    }
+
+    /**
+     * @brief Write the raw digest of the data fed since the construction or
+     * the last call to final(), and start a new hash.
+     *
+     * @param digest At least digestLength() bytes.
+     * @return The length of the digest.
+     */
+    size_t final(unsigned char *digest);
+
+    /// The upper case hex digest, like utils::getMd5(), and start a new hash.
+    std::string hexDigest();
+
+    struct Impl;
+
+  private:
+    HashAlgorithm algorithm_;
+    std::unique_ptr<Impl> impl_;
+};
+}  // namespace utils
+}  // namespace drogon
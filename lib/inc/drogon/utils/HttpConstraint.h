@@ -15,17 +15,50 @@
 #pragma once
 
 #include <drogon/HttpTypes.h>
+#include <cstddef>
 #include <string>
 
 namespace drogon
 {
+/**
+ * @brief The body limits of a route, passed as a constraint of the route.
+ * A field of 0 keeps the value of the application.
+ *
+ * @code
+   PATH_ADD("/upload", Post, BodyLimit{512 * 1024 * 1024, 1024 * 1024});
+   @endcode
+ */
+struct BodyLimit
+{
+    /// The maximum body size, see HttpAppFramework::setClientMaxBodySize()
+    size_t maxBodySize{0};
+    /// The maximum size of a body kept in memory, see
+    /// HttpAppFramework::setClientMaxMemoryBodySize()
+    size_t maxMemoryBodySize{0};
+};
+
+/**
+ * @brief A constraint running the handler of a route in the compute pool
+ * instead of the IO loop, for CPU heavy handlers. The response is sent from
+ * the IO loop of the request.
+ *
+ * @code
+   PATH_ADD("/thumbnail", Post, Offload{});
+   @endcode
+ */
+struct Offload
+{
+};
+
 namespace internal
 {
 enum class ConstraintType
 {
     None,
     HttpMethod,
-    HttpMiddleware
+    HttpMiddleware,
+    BodyLimit,
+    Offload
 };
 
 class HttpConstraint
@@ -47,6 +80,15 @@ class HttpConstraint
     {
     }
 
+    HttpConstraint(const drogon::BodyLimit &bodyLimit)
+        : type_(ConstraintType::BodyLimit), bodyLimit_(bodyLimit)
+    {
+    }
+
+    HttpConstraint(const drogon::Offload &) : type_(ConstraintType::Offload)
+    {
+    }
+
     ConstraintType type() const
     {
         return type_;
@@ -62,10 +104,16 @@ class HttpConstraint
         return middlewareName_;
     }
 
+    const drogon::BodyLimit &getBodyLimit() const
+    {
+        return bodyLimit_;
+    }
+
   private:
     ConstraintType type_{ConstraintType::None};
     HttpMethod method_{HttpMethod::Invalid};
     std::string middlewareName_;
+    drogon::BodyLimit bodyLimit_;
 };
 }  // namespace internal
 }  // namespace drogon
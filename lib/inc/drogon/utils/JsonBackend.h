@@ -0,0 +1,91 @@
+/**
+ *
+ *  @file JsonBackend.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <json/value.h>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief The parser and writer of the JSON bodies of requests and responses.
+ *
+ * The backend is used by HttpRequest::getJsonObject(),
+ * HttpRequest::getJsonAt(), HttpResponse::newHttpJsonResponse(),
+ * HttpRequest::newHttpJsonRequest() and the JSON responses of HttpClient. It
+ * is called from all the IO threads at the same time, so the implementations
+ * must be thread safe.
+ *
+ * The built-in backends are "jsoncpp", the default, and "simdjson" when
+ * drogon is built with the simdjson library. The simdjson backend hands the
+ * documents it rejects over to jsoncpp, so both accept the same documents
+ * (comments, trailing characters and big integers included) and report the
+ * same errors.
+ */
+class DROGON_EXPORT JsonBackend
+{
+  public:
+    virtual ~JsonBackend() = default;
+
+    virtual const char *name() const = 0;
+
+    /**
+     * @brief Parse the document into root.
+     *
+     * @return false if the document is not valid, errs is then set to the
+     * parsing errors.
+     */
+    virtual bool parse(std::string_view document,
+                       Json::Value &root,
+                       std::string &errs) const = 0;
+
+    /**
+     * @brief Get the value at a JSON pointer (RFC 6901) in the document, e.g.
+     * "/items/0/id". The default implementation parses the whole document,
+     * a backend can build the value at the pointer only.
+     *
+     * @return false if the document is not valid or has no value at the
+     * pointer.
+     */
+    virtual bool parseAt(std::string_view document,
+                         std::string_view pointer,
+                         Json::Value &value) const;
+
+    /**
+     * @brief Write the value as compact JSON, according to the options of the
+     * application (unicode escaping and float precision).
+     */
+    virtual std::string write(const Json::Value &value) const = 0;
+
+    /**
+     * @brief Create a built-in backend.
+     *
+     * @return nullptr if there is no backend with this name in this build.
+     */
+    static std::shared_ptr<JsonBackend> create(const std::string &name);
+
+    /**
+     * @brief Find the value at a JSON pointer in a Json::Value.
+     *
+     * @return nullptr if there is no value at the pointer.
+     */
+    static const Json::Value *resolve(const Json::Value &root,
+                                      std::string_view pointer);
+};
+
+using JsonBackendPtr = std::shared_ptr<JsonBackend>;
+}  // namespace drogon
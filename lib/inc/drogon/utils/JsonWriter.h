@@ -0,0 +1,187 @@
+/**
+ *
+ *  @file JsonWriter.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <json/value.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace drogon
+{
+class ResponseStream;
+
+/**
+ * @brief A SAX style JSON writer producing compact JSON directly into its
+ * output, without building a Json::Value DOM first.
+ *
+ * The output is a std::string, a trantor::MsgBuffer or a ResponseStream. When
+ * writing to a ResponseStream, the text is sent in chunks of about
+ * flushThreshold bytes, so arbitrarily large documents need a bounded amount
+ * of memory. Strings are written as UTF-8, only the characters that must be
+ * escaped are escaped.
+ *
+ * Usage example:
+ * @code
+   auto resp = HttpResponse::newHttpJsonResponse([](JsonWriter &writer) {
+       writer.startArray();
+       for (auto &item : items)
+       {
+           writer.startObject();
+           writer.key("id").value(item.id);
+           writer.key("name").value(item.name);
+           writer.endObject();
+       }
+       writer.endArray();
+   });
+   @endcode
+ * For a streamed body, bind the writer to the stream of an async stream
+ * response:
+ * @code
+   auto resp = HttpResponse::newAsyncStreamResponse(
+       [](ResponseStreamPtr stream) {
+           {
+               JsonWriter writer(*stream);
+               writer.startArray();
+               // ...
+               writer.endArray();
+           }
+           stream->close();
+       });
+   resp->setContentTypeCode(CT_APPLICATION_JSON);
+   @endcode
+ */
+class DROGON_EXPORT JsonWriter
+{
+  public:
+    explicit JsonWriter(std::string &output) : string_(&output)
+    {
+    }
+
+    explicit JsonWriter(trantor::MsgBuffer &output) : buffer_(&output)
+    {
+    }
+
+    /**
+     * @param output The stream, it must outlive the writer.
+     * @param flushThreshold The size of the chunks sent to the stream.
+     */
+    explicit JsonWriter(ResponseStream &output, size_t flushThreshold = 16384);
+
+    /**
+     * @brief Flush the pending text to the stream, if any.
+     */
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter &operator=(const JsonWriter &) = delete;
+
+    JsonWriter &startObject();
+    JsonWriter &endObject();
+    JsonWriter &startArray();
+    JsonWriter &endArray();
+
+    /**
+     * @brief Write the key of the next member of the current object.
+     */
+    JsonWriter &key(std::string_view name);
+
+    JsonWriter &value(std::string_view str);
+
+    JsonWriter &value(const char *str)
+    {
+        return value(std::string_view{str});
+    }
+
+    JsonWriter &value(const std::string &str)
+    {
+        return value(std::string_view{str});
+    }
+
+    JsonWriter &value(bool b);
+    JsonWriter &value(int64_t number);
+    JsonWriter &value(uint64_t number);
+
+    /**
+     * @brief Write a floating point number with 17 significant digits, NaN
+     * and infinities are written as null.
+     */
+    JsonWriter &value(double number);
+
+    template <typename T,
+              std::enable_if_t<std::is_integral_v<T> &&
+                                   !std::is_same_v<T, bool>,
+                               int> = 0>
+    JsonWriter &value(T number)
+    {
+        if constexpr (std::is_signed_v<T>)
+            return value(static_cast<int64_t>(number));
+        else
+            return value(static_cast<uint64_t>(number));
+    }
+
+    JsonWriter &value(std::nullptr_t);
+
+    /**
+     * @brief Write a Json::Value as the next value.
+     */
+    JsonWriter &value(const Json::Value &json);
+
+    /**
+     * @brief Write a piece of already serialized JSON as the next value.
+     */
+    JsonWriter &rawValue(std::string_view json);
+
+    /**
+     * @brief Send the pending text to the stream. Does nothing for the other
+     * outputs, which are always up to date.
+     *
+     * @return false if the stream is closed.
+     */
+    bool flush();
+
+    /**
+     * @brief The number of bytes written so far.
+     */
+    size_t bytesWritten() const
+    {
+        return bytesWritten_;
+    }
+
+  private:
+    void beforeValue();
+    void write(const char *data, size_t length);
+
+    void write(std::string_view str)
+    {
+        write(str.data(), str.length());
+    }
+
+    void writeString(std::string_view str);
+
+    std::string *string_{nullptr};
+    trantor::MsgBuffer *buffer_{nullptr};
+    ResponseStream *stream_{nullptr};
+    std::string pending_;
+    size_t flushThreshold_{0};
+    size_t bytesWritten_{0};
+    // One entry per open container: true once it has a first element
+    std::vector<bool> hasElements_;
+    bool afterKey_{false};
+};
+}  // namespace drogon
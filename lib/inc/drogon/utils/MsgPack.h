@@ -0,0 +1,55 @@
+/**
+ *
+ *  @file MsgPack.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <json/value.h>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+namespace utils
+{
+/**
+ * @brief Append a value to a buffer as MessagePack, the binary counterpart of
+ * the JSON bodies used by HttpResponse::newHttpMsgPackResponse().
+ *
+ * The integers take the shortest encoding of their value, the reals are
+ * written as 64 bit floats and the strings as str, whatever their content.
+ */
+DROGON_EXPORT void toMsgPack(const Json::Value &value, std::string &out);
+
+/// Write a value as MessagePack
+inline std::string toMsgPack(const Json::Value &value)
+{
+    std::string out;
+    toMsgPack(value, out);
+    return out;
+}
+
+/**
+ * @brief Decode a MessagePack document into a Json::Value.
+ *
+ * The bin values are decoded as strings and the keys of the maps that are
+ * not strings are converted to strings. The ext values, the documents nested
+ * deeper than 1000 levels and the trailing bytes are rejected.
+ *
+ * @return false if the document is not valid, errs is then set to the reason.
+ */
+DROGON_EXPORT bool fromMsgPack(std::string_view data,
+                               Json::Value &root,
+                               std::string &errs);
+}  // namespace utils
+}  // namespace drogon
@@ -13,6 +13,7 @@
  */
 
 #pragma once
+#include <functional>
 #include <string>
 #include <sstream>
 #include <string_view>
@@ -44,20 +45,44 @@ class OStringStream
         buffer_.reserve(size);
     }
 
+    /**
+     * @brief Pass the text to the sink whenever flushThreshold bytes are
+     * buffered instead of keeping all of it, e.g. to stream a view to a
+     * response. The sink returns false when it takes no more text, the text
+     * is dropped then. str() only returns the text not passed yet.
+     */
+    void setSink(std::function<bool(const std::string &)> sink,
+                 size_t flushThreshold)
+    {
+        sink_ = std::move(sink);
+        flushThreshold_ = flushThreshold;
+        buffer_.reserve(flushThreshold + flushThreshold / 4);
+    }
+
+    /// Pass the buffered text to the sink, if any
+    bool flush()
+    {
+        if (!sink_ || buffer_.empty())
+            return true;
+        auto ret = sink_(buffer_);
+        buffer_.clear();
+        return ret;
+    }
+
     template <typename T>
     OStringStream &operator<<(T &&value)
     {
         if constexpr (internal::CanConvertToString<T>::value)
         {
             buffer_.append(std::to_string(std::forward<T>(value)));
-            return *this;
+            return appended();
         }
         else
         {
             std::stringstream ss;
             ss << std::forward<T>(value);
             buffer_.append(ss.str());
-            return *this;
+            return appended();
         }
     }
 
@@ -65,31 +90,31 @@ class OStringStream
     OStringStream &operator<<(const char (&buf)[N])
     {
         buffer_.append(buf, N - 1);
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(const std::string_view &str)
     {
         buffer_.append(str.data(), str.length());
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(std::string_view &&str)
     {
         buffer_.append(str.data(), str.length());
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(const std::string &str)
     {
         buffer_.append(str);
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(std::string &&str)
     {
         buffer_.append(std::move(str));
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(const double &d)
@@ -97,7 +122,7 @@ class OStringStream
         std::stringstream ss;
         ss << d;
         buffer_.append(ss.str());
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(const float &f)
@@ -105,7 +130,7 @@ class OStringStream
         std::stringstream ss;
         ss << f;
         buffer_.append(ss.str());
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(double &&d)
@@ -113,7 +138,7 @@ class OStringStream
         std::stringstream ss;
         ss << d;
         buffer_.append(ss.str());
-        return *this;
+        return appended();
     }
 
     OStringStream &operator<<(float &&f)
@@ -121,7 +146,7 @@ class OStringStream
         std::stringstream ss;
         ss << f;
         buffer_.append(ss.str());
-        return *this;
+        return appended();
     }
 
     std::string &str()
@@ -135,6 +160,15 @@ class OStringStream
     }
 
   private:
+    OStringStream &appended()
+    {
+        if (sink_ && buffer_.size() >= flushThreshold_)
+            flush();
+        return *this;
+    }
+
     std::string buffer_;
+    std::function<bool(const std::string &)> sink_;
+    size_t flushThreshold_{0};
 };
 }  // namespace drogon
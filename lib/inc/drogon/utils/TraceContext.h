@@ -0,0 +1,88 @@
+/**
+ *
+ *  @file TraceContext.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief The W3C trace context of a span, see the Tracer plugin.
+ *
+ * It's carried by the "traceparent" header between the services, e.g.
+ * "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01".
+ */
+struct DROGON_EXPORT TraceContext
+{
+    uint64_t traceIdHigh{0};
+    uint64_t traceIdLow{0};
+    uint64_t spanId{0};
+    /// The sampled flag of the traceparent header, the trace is exported
+    bool sampled{false};
+    /// The spans of the trace are recorded in this process, they are
+    /// exported if the trace is sampled or kept by the tail sampling.
+    bool recorded{false};
+
+    bool valid() const
+    {
+        return (traceIdHigh != 0 || traceIdLow != 0) && spanId != 0;
+    }
+
+    /// The value of the traceparent header
+    std::string traceparent() const;
+
+    /// The trace id in 32 lowercase hex digits
+    std::string traceIdHex() const;
+
+    /// Parse a traceparent header, the context is invalid if it's malformed
+    static TraceContext fromTraceparent(std::string_view value);
+};
+
+namespace internal
+{
+/// The trace context of the request whose handler is being called on this
+/// thread, the client calls made from there are its child spans.
+inline TraceContext &currentTraceContext()
+{
+    static thread_local TraceContext context;
+    return context;
+}
+
+/// Make the client calls and the coroutines created in the scope belong to
+/// the trace
+class TraceScope
+{
+  public:
+    explicit TraceScope(const TraceContext &context)
+        : saved_(currentTraceContext())
+    {
+        currentTraceContext() = context;
+    }
+
+    ~TraceScope()
+    {
+        currentTraceContext() = saved_;
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+  private:
+    TraceContext saved_;
+};
+}  // namespace internal
+}  // namespace drogon
@@ -100,6 +100,13 @@ DROGON_EXPORT std::string hexToBinaryString(const char *ptr, size_t length);
 DROGON_EXPORT std::vector<char> hexToBinaryVector(const char *ptr,
                                                   size_t length);
 
+/// Decode the hexadecimal format into the buffer of length / 2 bytes
+/**
+ * Return false if the string has a character which is not a hexadecimal
+ * digit, the content of the buffer is then unspecified.
+ */
+DROGON_EXPORT bool hexToBinary(const char *ptr, size_t length, char *out);
+
 DROGON_EXPORT void binaryStringToHex(const char *ptr,
                                      size_t length,
                                      char *out,
@@ -124,9 +131,18 @@ DROGON_EXPORT std::set<std::string> splitStringToSet(
     const std::string &str,
     const std::string &separator);
 
-/// Get UUID string.
+/// Get a random (version 4) UUID string.
 DROGON_EXPORT std::string getUuid(bool lowercase = true);
 
+/// Get a time-ordered (version 7) UUID string.
+/**
+ * The UUID starts with the Unix time in milliseconds, so the UUIDs generated
+ * one after the other sort in the same order and are inserted at the end of
+ * the indexes of the database keys. The UUIDs generated by a thread in the
+ * same millisecond are ordered by a counter, the rest of the bits are random.
+ */
+DROGON_EXPORT std::string getUuidV7(bool lowercase = true);
+
 /// Get the encoded length of base64.
 constexpr size_t base64EncodedLength(size_t in_len, bool padded = true)
 {
@@ -134,6 +150,11 @@ constexpr size_t base64EncodedLength(size_t in_len, bool padded = true)
 }
 
 /// Encode the string to base64 format.
+/**
+ * The output buffer receives base64EncodedLength(inLen, padded) characters.
+ * A long input can be encoded in chunks whose lengths are multiples of 3 into
+ * consecutive parts of the output, only the last one may be padded.
+ */
 DROGON_EXPORT void base64Encode(const unsigned char *bytesToEncode,
                                 size_t inLen,
                                 unsigned char *outputBuffer,
@@ -195,7 +216,13 @@ constexpr size_t base64DecodedLength(size_t inLen)
 }
 
 /// Decode the base64 format string.
-/// Return the number of bytes written.
+/**
+ * Return the number of bytes written, at most base64DecodedLength(inLen). A
+ * long input without separators can be decoded in chunks of multiples of 4
+ * characters, each one after the bytes written by the previous one. The
+ * characters of both alphabets are accepted, the other characters are
+ * skipped and the decoding stops at the first '='.
+ */
 DROGON_EXPORT size_t base64Decode(const char *encodedString,
                                   size_t inLen,
                                   unsigned char *outputBuffer);
@@ -217,6 +244,13 @@ DROGON_EXPORT std::vector<char> base64DecodeToVector(
 /// Check if the string need decoding
 DROGON_EXPORT bool needUrlDecoding(const char *begin, const char *end);
 
+/**
+ * @brief Decode the URL format string into a buffer of at least
+ * end - begin bytes, and return the length of the decoded string.
+ * @note out may be begin, to decode in place.
+ */
+DROGON_EXPORT size_t urlDecode(const char *begin, const char *end, char *out);
+
 /// Decode from or encode to the URL format string
 DROGON_EXPORT std::string urlDecode(const char *begin, const char *end);
 
@@ -275,19 +309,45 @@ inline std::string getBlake2b(const std::string &originalString)
 /**
  * @param data the input data
  * @param ndata the input data length
+ * @param level the compression level, from 1 (fastest) to 9 (smallest), -1
+ * is the default level of zlib
  */
-DROGON_EXPORT std::string gzipCompress(const char *data, const size_t ndata);
+DROGON_EXPORT std::string gzipCompress(const char *data,
+                                       const size_t ndata,
+                                       int level = -1);
 DROGON_EXPORT std::string gzipDecompress(const char *data, const size_t ndata);
 
 /// Compress or decompress data using brotli lib.
 /**
  * @param data the input data
  * @param ndata the input data length
+ * @param quality the compression quality, from 0 (fastest) to 11 (smallest)
  */
-DROGON_EXPORT std::string brotliCompress(const char *data, const size_t ndata);
+DROGON_EXPORT std::string brotliCompress(const char *data,
+                                         const size_t ndata,
+                                         int quality = 5);
 DROGON_EXPORT std::string brotliDecompress(const char *data,
                                            const size_t ndata);
 
+/// Compress or decompress data using zstd lib.
+/**
+ * @param data the input data
+ * @param ndata the input data length
+ * @param level the compression level, from 1 (fastest) to 19, negative
+ * levels trade more ratio for speed
+ * @param dictionary an optional dictionary (trained with `zstd --train`),
+ * the same dictionary must be used to decompress the data. It is digested
+ * once per thread for consecutive calls with the same dictionary.
+ * @return the result, or an empty string on error.
+ */
+DROGON_EXPORT std::string zstdCompress(const char *data,
+                                       const size_t ndata,
+                                       int level = 3,
+                                       std::string_view dictionary = {});
+DROGON_EXPORT std::string zstdDecompress(const char *data,
+                                         const size_t ndata,
+                                         std::string_view dictionary = {});
+
 /// Get the http full date string
 /**
  * rfc2616-3.3.1
@@ -443,6 +503,9 @@ DROGON_EXPORT void replaceAll(std::string &s,
 /**
  * @brief Generates cryptographically secure random bytes.
  *
+ * The bytes come from a ChaCha20 generator per thread seeded by the OS, so
+ * the calls don't make system calls or take locks.
+ *
  * @param ptr the pointer which the random bytes are stored to
  * @param size number of bytes to generate
  *
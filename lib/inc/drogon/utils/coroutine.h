@@ -13,19 +13,29 @@
  */
 #pragma once
 
+#include <drogon/utils/TraceContext.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/utils/Logger.h>
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
+#include <functional>
 #include <future>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <stdexcept>
 #include <type_traits>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace drogon
 {
@@ -59,6 +69,197 @@ template <typename T>
 using void_to_false_t =
     std::conditional_t<std::is_same_v<T, void>, std::false_type, T>;
 
+#ifndef DROGON_NO_CORO_FRAME_POOL
+/**
+ * @brief A per-thread cache of the freed frames of coroutines, by size classes
+ * of 64 bytes up to 2K. Handlers awaiting a few queries create several frames
+ * per request, reusing them avoids the contention of the global allocator.
+ * A frame freed by another thread than the one allocating it goes to the
+ * cache of the freeing thread. Define DROGON_NO_CORO_FRAME_POOL to allocate
+ * frames with the global operator new.
+ */
+class CoroFramePool
+{
+  public:
+    static constexpr size_t kGranularity = 64;
+    static constexpr size_t kClasses = 32;
+    static constexpr size_t kMaxCachedPerClass = 64;
+
+    static void *allocate(size_t size)
+    {
+        auto index = (size - 1) / kGranularity;
+        if (index < kClasses && !destroyed())
+        {
+            auto &list = local().lists_[index];
+            if (list.head)
+            {
+                auto block = list.head;
+                list.head = block->next;
+                --list.count;
+                return block;
+            }
+            return ::operator new((index + 1) * kGranularity);
+        }
+        return ::operator new(size);
+    }
+
+    static void deallocate(void *ptr, size_t size) noexcept
+    {
+        auto index = (size - 1) / kGranularity;
+        if (index < kClasses && !destroyed())
+        {
+            auto &list = local().lists_[index];
+            if (list.count < kMaxCachedPerClass)
+            {
+                auto block = static_cast<Block *>(ptr);
+                block->next = list.head;
+                list.head = block;
+                ++list.count;
+                return;
+            }
+        }
+        ::operator delete(ptr);
+    }
+
+  private:
+    struct Block
+    {
+        Block *next;
+    };
+
+    struct FreeList
+    {
+        Block *head{nullptr};
+        size_t count{0};
+    };
+
+    CoroFramePool() = default;
+
+    ~CoroFramePool()
+    {
+        destroyed() = true;
+        for (auto &list : lists_)
+        {
+            while (list.head)
+            {
+                auto block = list.head;
+                list.head = block->next;
+                ::operator delete(block);
+            }
+        }
+    }
+
+    static CoroFramePool &local()
+    {
+        static thread_local CoroFramePool pool;
+        return pool;
+    }
+
+    // Frames freed by the destructors of other thread local objects after
+    // the pool is gone go to the global allocator
+    static bool &destroyed()
+    {
+        static thread_local bool flag{false};
+        return flag;
+    }
+
+    FreeList lists_[kClasses];
+};
+
+/// The base of the promise types, allocating their frames from the pool
+struct PooledCoroFrame
+{
+    static void *operator new(size_t size)
+    {
+        return CoroFramePool::allocate(size);
+    }
+
+    static void operator delete(void *ptr, size_t size) noexcept
+    {
+        CoroFramePool::deallocate(ptr, size);
+    }
+};
+#else
+struct PooledCoroFrame
+{
+};
+#endif
+
+/// The deadline of the request whose handler is being called on this thread
+inline std::optional<std::chrono::steady_clock::time_point> &currentDeadline()
+{
+    static thread_local std::optional<std::chrono::steady_clock::time_point>
+        deadline;
+    return deadline;
+}
+
+/// Make the coroutines created in the scope inherit the deadline
+class DeadlineScope
+{
+  public:
+    explicit DeadlineScope(
+        const std::optional<std::chrono::steady_clock::time_point> &deadline)
+        : saved_(currentDeadline())
+    {
+        currentDeadline() = deadline;
+    }
+
+    ~DeadlineScope()
+    {
+        currentDeadline() = saved_;
+    }
+
+    DeadlineScope(const DeadlineScope &) = delete;
+    DeadlineScope &operator=(const DeadlineScope &) = delete;
+
+  private:
+    std::optional<std::chrono::steady_clock::time_point> saved_;
+};
+
+/**
+ * The base of the promise types holding the deadline and the trace context
+ * of the coroutine, read by the awaited tasks and the awaiters of the
+ * database, redis and http clients through the handle passed to their
+ * await_suspend().
+ */
+struct DeadlinePromise
+{
+    void inheritDeadline(std::chrono::steady_clock::time_point deadline)
+    {
+        if (!deadline_ || deadline < *deadline_)
+            deadline_ = deadline;
+    }
+
+    void inheritTraceContext(const TraceContext &context)
+    {
+        if (!traceContext_.valid())
+            traceContext_ = context;
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> deadline_{
+        currentDeadline()};
+    TraceContext traceContext_{currentTraceContext()};
+};
+
+template <typename Promise>
+std::optional<std::chrono::steady_clock::time_point> deadlineOf(
+    std::coroutine_handle<Promise> handle)
+{
+    if constexpr (std::is_base_of_v<DeadlinePromise, Promise>)
+        return handle.promise().deadline_;
+    else
+        return std::nullopt;
+}
+
+template <typename Promise>
+TraceContext traceContextOf(std::coroutine_handle<Promise> handle)
+{
+    if constexpr (std::is_base_of_v<DeadlinePromise, Promise>)
+        return handle.promise().traceContext_;
+    else
+        return currentTraceContext();
+}
+
 }  // end namespace internal
 
 template <typename T>
@@ -133,8 +334,14 @@ struct task_awaiter
         return !coro_ || coro_.done();
     }
 
-    auto await_suspend(std::coroutine_handle<> handle) noexcept
+    template <typename AwaitingPromise>
+    auto await_suspend(std::coroutine_handle<AwaitingPromise> handle) noexcept
     {
+        // The task inherits the deadline and the trace of the awaiting
+        // coroutine
+        if (auto deadline = internal::deadlineOf(handle))
+            coro_.promise().inheritDeadline(*deadline);
+        coro_.promise().inheritTraceContext(internal::traceContextOf(handle));
         coro_.promise().setContinuation(handle);
         return coro_;
     }
@@ -194,7 +401,7 @@ struct [[nodiscard]] Task
         return *this;
     }
 
-    struct promise_type
+    struct promise_type : internal::PooledCoroFrame, internal::DeadlinePromise
     {
         Task<T> get_return_object()
         {
@@ -298,7 +505,7 @@ struct [[nodiscard]] Task<void>
         return *this;
     }
 
-    struct promise_type
+    struct promise_type : internal::PooledCoroFrame, internal::DeadlinePromise
     {
         Task<> get_return_object()
         {
@@ -382,7 +589,7 @@ struct AsyncTask
         return *this;
     }
 
-    struct promise_type
+    struct promise_type : internal::PooledCoroFrame, internal::DeadlinePromise
     {
         AsyncTask get_return_object() noexcept
         {
@@ -416,12 +623,19 @@ struct AsyncTask
 /// Helper class that provides the infrastructure for turning callback into
 /// coroutines
 // The user is responsible to fill in `await_suspend()` and constructors.
+//
+// When the operation may complete in the calling thread (a cache hit, a value
+// read ahead), await_suspend() returns suspendUnlessCompleted() once the
+// operation is started and the callbacks call resumeIfSuspended(), so the
+// coroutine goes on without being suspended and resumed from within
+// await_suspend(). An awaiter which has its value at construction is not
+// suspended at all.
 template <typename T = void>
 struct CallbackAwaiter : public trantor::NonCopyable
 {
     bool await_ready() noexcept
     {
-        return false;
+        return result_.has_value() || exception_ != nullptr;
     }
 
     bool hasException() const noexcept
@@ -447,6 +661,8 @@ struct CallbackAwaiter : public trantor::NonCopyable
     // that.
     std::optional<T> result_;
     std::exception_ptr exception_{nullptr};
+    // Set by the first of the end of await_suspend() and the callback
+    std::atomic<bool> handoff_{false};
 
   protected:
     void setException(const std::exception_ptr &e)
@@ -463,6 +679,19 @@ struct CallbackAwaiter : public trantor::NonCopyable
     {
         result_.emplace(std::move(v));
     }
+
+    /// Return false if the callback was called during await_suspend()
+    bool suspendUnlessCompleted() noexcept
+    {
+        return !handoff_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    /// Resume the coroutine unless await_suspend() has not returned yet
+    void resumeIfSuspended(std::coroutine_handle<> handle)
+    {
+        if (handoff_.exchange(true, std::memory_order_acq_rel))
+            handle.resume();
+    }
 };
 
 template <>
@@ -486,13 +715,93 @@ struct CallbackAwaiter<void> : public trantor::NonCopyable
 
   private:
     std::exception_ptr exception_{nullptr};
+    std::atomic<bool> handoff_{false};
 
   protected:
     void setException(const std::exception_ptr &e)
     {
         exception_ = e;
     }
+
+    /// See CallbackAwaiter<T>::suspendUnlessCompleted()
+    bool suspendUnlessCompleted() noexcept
+    {
+        return !handoff_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void resumeIfSuspended(std::coroutine_handle<> handle)
+    {
+        if (handoff_.exchange(true, std::memory_order_acq_rel))
+            handle.resume();
+    }
+};
+
+namespace internal
+{
+/**
+ * @brief The base of the awaiters of client calls bounded by the deadline of
+ * the awaiting coroutine. The coroutine is resumed with the exception made by
+ * timeoutError() at the deadline, the late result is dropped.
+ */
+template <typename T>
+struct DeadlineAwaiter : public CallbackAwaiter<T>
+{
+    void inheritDeadline(std::chrono::steady_clock::time_point deadline)
+    {
+        if (!deadline_ || deadline < *deadline_)
+            deadline_ = deadline;
+    }
+
+  protected:
+    using DoneFlag = std::shared_ptr<std::atomic<bool>>;
+
+    /**
+     * @brief Start the timer of the deadline of the awaiting coroutine in the
+     * current event loop.
+     *
+     * @return nullptr if the deadline has passed, the exception is set then.
+     * Otherwise the flag to pass to complete() in the callbacks.
+     */
+    template <typename Promise, typename MakeError>
+    DoneFlag armDeadline(std::coroutine_handle<Promise> awaiting,
+                         MakeError timeoutError)
+    {
+        if (auto deadline = deadlineOf(awaiting))
+            inheritDeadline(*deadline);
+        std::coroutine_handle<> handle = awaiting;
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        if (!deadline_)
+            return done;
+        auto now = std::chrono::steady_clock::now();
+        if (*deadline_ <= now)
+        {
+            this->setException(timeoutError());
+            return nullptr;
+        }
+        auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        if (loop)
+        {
+            loop->runAfter(std::chrono::duration<double>(*deadline_ - now),
+                           [this, handle, done, timeoutError]() {
+                               if (done->exchange(true))
+                                   return;
+                               this->setException(timeoutError());
+                               handle.resume();
+                           });
+        }
+        return done;
+    }
+
+    /// Return false if the deadline has resumed the coroutine, `this` is
+    /// likely gone then.
+    static bool complete(const DoneFlag &done)
+    {
+        return !done->exchange(true);
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> deadline_;
 };
+}  // namespace internal
 
 // An ok implementation of sync_await. This allows one to call
 // coroutines and wait for the result from a function.
@@ -656,9 +965,15 @@ struct [[nodiscard]] SwitchThreadAwaiter : CallbackAwaiter<void>
     {
     }
 
+    // Already in the thread of the loop, nothing to switch
+    bool await_ready() noexcept
+    {
+        return loop_->isInLoopThread();
+    }
+
     void await_suspend(std::coroutine_handle<> handle)
     {
-        loop_->runInLoop([handle]() { handle.resume(); });
+        loop_->queueInLoop([handle]() { handle.resume(); });
     }
 
   private:
@@ -823,15 +1138,14 @@ struct WhenAllAwaiter
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle)
+    bool await_suspend(std::coroutine_handle<> handle)
     {
         if (counter_ == 0)
-        {
-            handle.resume();
-            return;
-        }
+            return false;
 
         await_suspend_impl(handle, std::index_sequence_for<Tasks...>{});
+        // The tasks may all have completed without suspending
+        return this->suspendUnlessCompleted();
     }
 
   private:
@@ -871,7 +1185,7 @@ struct WhenAllAwaiter
             {
                 if (!self->hasException())
                     self->setValue(std::move(self->results_));
-                handle.resume();
+                self->resumeIfSuspended(handle);
             }
         }(this, handle);
     }
@@ -895,13 +1209,12 @@ struct WhenAllAwaiter<std::vector<Task<T>>>
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle)
+    bool await_suspend(std::coroutine_handle<> handle)
     {
         if (tasks_.empty())
         {
             this->setValue(std::vector<T>{});
-            handle.resume();
-            return;
+            return false;
         }
 
         const size_t count = tasks_.size();
@@ -928,10 +1241,11 @@ struct WhenAllAwaiter<std::vector<Task<T>>>
                     {
                         self->setValue(std::move(self->results_));
                     }
-                    handle.resume();
+                    self->resumeIfSuspended(handle);
                 }
             }(this, handle, std::move(tasks_[i]), i);
         }
+        return this->suspendUnlessCompleted();
     }
 
   private:
@@ -949,17 +1263,12 @@ struct WhenAllAwaiter<std::vector<Task<void>>> : public CallbackAwaiter<void>
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle)
+    bool await_suspend(std::coroutine_handle<> handle)
     {
         if (tasks_.empty())
-        {
-            handle.resume();
-            return;
-        }
+            return false;
 
-        const size_t count =
-            tasks_
-                .size();  // capture the size fist (see lifetime comment beflow)
+        const size_t count = tasks_.size();
         for (size_t i = 0; i < count; ++i)
         {
             [](WhenAllAwaiter *self,
@@ -975,11 +1284,12 @@ struct WhenAllAwaiter<std::vector<Task<void>>> : public CallbackAwaiter<void>
                         self->setException(std::current_exception());
                 }
                 if (self->counter_.fetch_sub(1, std::memory_order_acq_rel) == 1)
-                    // This line CAN delete `this` at last iteration. We MUST
-                    // NOT depend on this after last iteration
-                    handle.resume();
+                    self->resumeIfSuspended(handle);
             }(this, handle, std::move(tasks_[i]));
         }
+        // `this` lives until the coroutine is resumed, which is not before
+        // this call
+        return suspendUnlessCompleted();
     }
 
     std::vector<Task<void>> tasks_;
@@ -1175,6 +1485,316 @@ class Mutex final
     CoroMutexAwaiter *waiters_;
 };
 
+/**
+ * @brief A counting semaphore suspending the coroutines waiting for a unit
+ * instead of blocking their thread. A waiter is resumed in the event loop it
+ * acquired from, or inline by release() if it had no loop.
+ */
+class AsyncSemaphore final
+{
+    class SemaphoreAwaiter;
+
+  public:
+    explicit AsyncSemaphore(size_t count) noexcept : count_(count)
+    {
+    }
+
+    AsyncSemaphore(const AsyncSemaphore &) = delete;
+    AsyncSemaphore &operator=(const AsyncSemaphore &) = delete;
+
+    ~AsyncSemaphore()
+    {
+        assert(head_ == nullptr);
+    }
+
+    bool try_acquire() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == 0)
+            return false;
+        --count_;
+        return true;
+    }
+
+    [[nodiscard]] SemaphoreAwaiter acquire(
+        trantor::EventLoop *loop =
+            trantor::EventLoop::getEventLoopOfCurrentThread()) noexcept
+    {
+        return SemaphoreAwaiter(*this, loop);
+    }
+
+    /// Give a unit back, handing it to the oldest waiter if any.
+    void release()
+    {
+        SemaphoreAwaiter *waiter;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            waiter = head_;
+            if (waiter == nullptr)
+            {
+                ++count_;
+                return;
+            }
+            head_ = waiter->next_;
+            if (head_ == nullptr)
+                tail_ = nullptr;
+        }
+        if (waiter->loop_)
+        {
+            auto handle = waiter->handle_;
+            waiter->loop_->runInLoop([handle] { handle.resume(); });
+        }
+        else
+        {
+            waiter->handle_.resume();
+        }
+    }
+
+    size_t available() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+  private:
+    class SemaphoreAwaiter
+    {
+      public:
+        SemaphoreAwaiter(AsyncSemaphore &semaphore,
+                         trantor::EventLoop *loop) noexcept
+            : semaphore_(semaphore), loop_(loop)
+        {
+        }
+
+        bool await_ready() noexcept
+        {
+            return semaphore_.try_acquire();
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            handle_ = handle;
+            std::lock_guard<std::mutex> lock(semaphore_.mutex_);
+            if (semaphore_.count_ > 0)
+            {
+                --semaphore_.count_;
+                return false;
+            }
+            if (semaphore_.tail_)
+                semaphore_.tail_->next_ = this;
+            else
+                semaphore_.head_ = this;
+            semaphore_.tail_ = this;
+            return true;
+        }
+
+        void await_resume() noexcept
+        {
+        }
+
+      private:
+        friend class AsyncSemaphore;
+
+        AsyncSemaphore &semaphore_;
+        trantor::EventLoop *loop_;
+        std::coroutine_handle<> handle_;
+        SemaphoreAwaiter *next_{nullptr};
+    };
+
+    mutable std::mutex mutex_;
+    size_t count_;
+    SemaphoreAwaiter *head_{nullptr};
+    SemaphoreAwaiter *tail_{nullptr};
+};
+
+/**
+ * @brief A shared flag telling coroutines to give up their work, e.g. the
+ * losers of when_any() or the upstream calls of a handler past its deadline.
+ * Copies refer to the same state. Cancelling is cooperative, the coroutines
+ * check isCancelled() or register a callback with onCancel().
+ */
+class CancellationToken
+{
+  public:
+    CancellationToken() : state_(std::make_shared<State>())
+    {
+    }
+
+    void cancel() const
+    {
+        cancel(state_);
+    }
+
+    bool isCancelled() const noexcept
+    {
+        return state_->cancelled_.load(std::memory_order_acquire);
+    }
+
+    /// Call the callback on cancellation, at once if already cancelled.
+    void onCancel(std::function<void()> callback) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex_);
+            if (!state_->cancelled_.load(std::memory_order_relaxed))
+            {
+                state_->callbacks_.emplace_back(std::move(callback));
+                return;
+            }
+        }
+        callback();
+    }
+
+    /**
+     * @brief Cancel the token after a timeout in the loop, e.g. the time left
+     * to answer a request. The timer doesn't keep the token alive.
+     */
+    void cancelAfter(trantor::EventLoop *loop, double seconds) const
+    {
+        std::weak_ptr<State> weakState = state_;
+        loop->runAfter(seconds, [weakState]() {
+            if (auto state = weakState.lock())
+                cancel(state);
+        });
+    }
+
+  private:
+    struct State
+    {
+        std::mutex mutex_;
+        std::atomic<bool> cancelled_{false};
+        std::vector<std::function<void()>> callbacks_;
+    };
+
+    static void cancel(const std::shared_ptr<State> &state)
+    {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex_);
+            if (state->cancelled_.load(std::memory_order_relaxed))
+                return;
+            state->cancelled_.store(true, std::memory_order_release);
+            callbacks.swap(state->callbacks_);
+        }
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+namespace internal
+{
+template <typename T>
+using when_any_result_t =
+    std::conditional_t<std::is_same_v<T, void>, size_t, std::pair<size_t, T>>;
+
+/**
+ * The tasks left running after the first one completes only share the flag,
+ * the awaiter is gone once the awaiting coroutine is resumed.
+ */
+template <typename T>
+struct [[nodiscard]] WhenAnyAwaiter : CallbackAwaiter<when_any_result_t<T>>
+{
+    WhenAnyAwaiter(std::vector<Task<T>> tasks,
+                   std::optional<CancellationToken> token)
+        : tasks_(std::move(tasks)), token_(std::move(token))
+    {
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        if (tasks_.empty())
+        {
+            this->setException(std::make_exception_ptr(
+                std::invalid_argument("when_any() of no task")));
+            return false;
+        }
+        auto done = std::make_shared<std::atomic_flag>();
+        // The winner may resume the awaiting coroutine, destroying this, once
+        // all the tasks are started
+        auto tasks = std::move(tasks_);
+        auto token = std::move(token_);
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            [](WhenAnyAwaiter *self,
+               std::coroutine_handle<> handle,
+               std::shared_ptr<std::atomic_flag> done,
+               std::optional<CancellationToken> token,
+               Task<T> task,
+               size_t index) -> AsyncTask {
+                std::exception_ptr exception;
+                std::optional<void_to_false_t<T>> result;
+                try
+                {
+                    if constexpr (std::is_same_v<T, void>)
+                    {
+                        co_await task;
+                        result.emplace();
+                    }
+                    else
+                    {
+                        result.emplace(co_await task);
+                    }
+                }
+                catch (...)
+                {
+                    exception = std::current_exception();
+                }
+                if (done->test_and_set(std::memory_order_acq_rel))
+                    co_return;
+                if (token)
+                    token->cancel();
+                if (exception)
+                    self->setException(exception);
+                else if constexpr (std::is_same_v<T, void>)
+                    self->setValue(index);
+                else
+                    self->setValue({index, std::move(*result)});
+                self->resumeIfSuspended(handle);
+            }(this, handle, done, token, std::move(tasks[i]), i);
+        }
+        return this->suspendUnlessCompleted();
+    }
+
+  private:
+    std::vector<Task<T>> tasks_;
+    std::optional<CancellationToken> token_;
+};
+
+template <typename Iterator>
+struct ParallelForState
+{
+    std::mutex mutex_;
+    Iterator next_;
+    Iterator end_;
+    bool failed_{false};
+};
+
+template <typename Iterator, typename Fn>
+Task<> parallelForWorker(ParallelForState<Iterator> &state, Fn &fn)
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(state.mutex_);
+        if (state.failed_ || state.next_ == state.end_)
+            co_return;
+        auto it = state.next_++;
+        lock.unlock();
+        try
+        {
+            co_await fn(*it);
+        }
+        catch (...)
+        {
+            // Don't start more work, the first error is rethrown by when_all
+            lock.lock();
+            state.failed_ = true;
+            throw;
+        }
+    }
+}
+}  // namespace internal
+
 template <typename... Tasks>
 internal::WhenAllAwaiter<Tasks...> when_all(Tasks... tasks)
 {
@@ -1194,4 +1814,50 @@ inline internal::WhenAllAwaiter<std::vector<Task<void>>> when_all(
     return internal::WhenAllAwaiter(std::move(tasks));
 }
 
+/**
+ * @brief Wait for the first of the tasks to complete, returning its index and
+ * result, or only its index for Task<void>, or rethrowing its exception. The
+ * other tasks run to completion in the background, their results are
+ * dropped.
+ */
+template <typename T>
+internal::WhenAnyAwaiter<T> when_any(std::vector<Task<T>> tasks)
+{
+    return internal::WhenAnyAwaiter<T>(std::move(tasks), std::nullopt);
+}
+
+/**
+ * @brief Like when_any() above, and cancel the token once the first task
+ * completes, so the others can stop early if they watch it.
+ */
+template <typename T>
+internal::WhenAnyAwaiter<T> when_any(std::vector<Task<T>> tasks,
+                                     CancellationToken token)
+{
+    return internal::WhenAnyAwaiter<T>(std::move(tasks), std::move(token));
+}
+
+/**
+ * @brief Await fn(element) for each element of the range, running at most
+ * maxConcurrency of them at a time (0 for no limit). After an exception no
+ * more elements are started, the exception is rethrown once the running ones
+ * complete. The range must outlive the returned task.
+ */
+template <typename Range, typename Fn>
+Task<> co_parallel_for(Range &&range, size_t maxConcurrency, Fn fn)
+{
+    using Iterator = decltype(std::begin(range));
+    internal::ParallelForState<Iterator> state;
+    state.next_ = std::begin(range);
+    state.end_ = std::end(range);
+    size_t count = static_cast<size_t>(std::distance(state.next_, state.end_));
+    if (maxConcurrency == 0 || maxConcurrency > count)
+        maxConcurrency = count;
+    std::vector<Task<>> workers;
+    workers.reserve(maxConcurrency);
+    for (size_t i = 0; i < maxConcurrency; ++i)
+        workers.emplace_back(internal::parallelForWorker(state, fn));
+    co_await when_all(std::move(workers));
+}
+
 }  // namespace drogon
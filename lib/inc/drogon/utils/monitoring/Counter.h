@@ -14,8 +14,8 @@
 
 #pragma once
 #include <drogon/utils/monitoring/Metric.h>
+#include <drogon/utils/monitoring/Shards.h>
 #include <string_view>
-#include <mutex>
 
 namespace drogon
 {
@@ -23,6 +23,7 @@ namespace monitoring
 {
 /**
  * This class is used to collect samples for a counter metric.
+ * The counter can be incremented by any thread without a lock.
  * */
 class Counter : public Metric
 {
@@ -38,10 +39,7 @@ class Counter : public Metric
     {
         Sample s;
         s.name = name_;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            s.value = value_;
-        }
+        s.value = internal::sumOf(shards_);
         return {s};
     }
 
@@ -50,8 +48,7 @@ class Counter : public Metric
      * */
     void increment()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_++;
+        increment(1);
     }
 
     /**
@@ -59,14 +56,16 @@ class Counter : public Metric
      * */
     void increment(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ += value;
+        internal::atomicAdd(shards_[internal::shardOfThisThread()].value,
+                            value);
     }
 
     void reset()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ = 0;
+        for (auto &shard : shards_)
+        {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
     }
 
     static std::string_view type()
@@ -75,8 +74,7 @@ class Counter : public Metric
     }
 
   private:
-    mutable std::mutex mutex_;
-    double value_{0};
+    internal::DoubleShards shards_;
 };
 }  // namespace monitoring
 }  // namespace drogon
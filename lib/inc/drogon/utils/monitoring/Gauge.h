@@ -14,6 +14,7 @@
 
 #pragma once
 #include <drogon/utils/monitoring/Metric.h>
+#include <drogon/utils/monitoring/Shards.h>
 #include <string_view>
 #include <atomic>
 
@@ -23,6 +24,8 @@ namespace monitoring
 {
 /**
  * This class is used to collect samples for a gauge metric.
+ * The gauge is not sharded like the counter because it can be set, but it is
+ * updated with atomics, without a lock.
  * */
 class Gauge : public Metric
 {
@@ -40,10 +43,10 @@ class Gauge : public Metric
     std::vector<Sample> collect() const override
     {
         Sample s;
-        std::lock_guard<std::mutex> lock(mutex_);
         s.name = name_;
-        s.value = value_;
-        s.timestamp = timestamp_;
+        s.value = value_.load(std::memory_order_relaxed);
+        s.timestamp =
+            trantor::Date(timestamp_.load(std::memory_order_relaxed));
         return {s};
     }
 
@@ -52,20 +55,17 @@ class Gauge : public Metric
      * */
     void increment()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ += 1;
+        internal::atomicAdd(value_, 1);
     }
 
     void decrement()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ -= 1;
+        internal::atomicAdd(value_, -1);
     }
 
     void decrement(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ -= value;
+        internal::atomicAdd(value_, -value);
     }
 
     /**
@@ -73,20 +73,17 @@ class Gauge : public Metric
      * */
     void increment(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ += value;
+        internal::atomicAdd(value_, value);
     }
 
     void reset()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ = 0;
+        value_.store(0, std::memory_order_relaxed);
     }
 
     void set(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ = value;
+        value_.store(value, std::memory_order_relaxed);
     }
 
     static std::string_view type()
@@ -96,14 +93,13 @@ class Gauge : public Metric
 
     void setToCurrentTime()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        timestamp_ = trantor::Date::now();
+        timestamp_.store(trantor::Date::now().microSecondsSinceEpoch(),
+                         std::memory_order_relaxed);
     }
 
   private:
-    mutable std::mutex mutex_;
-    double value_{0};
-    trantor::Date timestamp_{0};
+    std::atomic<double> value_{0};
+    std::atomic<int64_t> timestamp_{0};
 };
 }  // namespace monitoring
 }  // namespace drogon
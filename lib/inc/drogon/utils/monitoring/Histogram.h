@@ -15,9 +15,11 @@
 #pragma once
 #include <drogon/exports.h>
 #include <drogon/utils/monitoring/Metric.h>
+#include <drogon/utils/monitoring/Shards.h>
 #include <trantor/net/EventLoopThread.h>
 #include <string_view>
 #include <atomic>
+#include <deque>
 #include <mutex>
 
 namespace drogon
@@ -25,7 +27,10 @@ namespace drogon
 namespace monitoring
 {
 /**
- * This class is used to collect samples for a counter metric.
+ * This class is used to collect samples for a histogram metric.
+ * The observations of the current time bucket are counted by per-thread
+ * shards without a lock, they are merged when the time buckets rotate or the
+ * histogram is collected.
  * */
 class DROGON_EXPORT Histogram : public Metric
 {
@@ -47,7 +52,11 @@ class DROGON_EXPORT Histogram : public Metric
         : Metric(name, labelNames, labelValues),
           maxAge_(maxAge),
           timeBucketCount_(timeBucketsCount),
-          bucketBoundaries_(bucketBoundaries)
+          bucketBoundaries_(bucketBoundaries),
+          linesPerShard_((bucketBoundaries.size() + kCountsPerLine) /
+                         kCountsPerLine),
+          lines_(std::make_unique<CacheLine[]>(linesPerShard_ *
+                                               internal::kShardsNum))
     {
         if (loop == nullptr)
         {
@@ -67,8 +76,6 @@ class DROGON_EXPORT Histogram : public Metric
                     "timeBucketsCount must be greater than 0");
             }
         }
-        timeBuckets_.emplace_back();
-        timeBuckets_.back().buckets.resize(bucketBoundaries.size() + 1);
         // check the bucket boundaries are sorted
         for (size_t i = 1; i < bucketBoundaries.size(); i++)
         {
@@ -97,6 +104,14 @@ class DROGON_EXPORT Histogram : public Metric
     }
 
   private:
+    static constexpr size_t kCountsPerLine = 8;
+
+    struct alignas(64) CacheLine
+    {
+        std::atomic<uint64_t> counts[kCountsPerLine];
+    };
+
+    // The finished time buckets, the current one is in the shards.
     std::deque<TimeBucket> timeBuckets_;
     std::unique_ptr<trantor::EventLoopThread> loopThreadPtr_;
     trantor::EventLoop *loopPtr_{nullptr};
@@ -105,19 +120,19 @@ class DROGON_EXPORT Histogram : public Metric
     trantor::TimerId timerId_{trantor::InvalidTimerId};
     size_t timeBucketCount_{0};
     const std::vector<double> bucketBoundaries_;
+    const size_t linesPerShard_;
+    std::unique_ptr<CacheLine[]> lines_;
+    internal::DoubleShards sums_;
+    std::atomic<bool> timerStarted_{false};
 
-    void rotateTimeBuckets()
+    std::atomic<uint64_t> &countOf(size_t shard, size_t bucket) const
     {
-        std::lock_guard<std::mutex> guard(mutex_);
-        TimeBucket bucket;
-        bucket.buckets.resize(bucketBoundaries_.size() + 1);
-        timeBuckets_.emplace_back(std::move(bucket));
-        if (timeBuckets_.size() > timeBucketCount_)
-        {
-            auto expiredTimeBucket = timeBuckets_.front();
-            timeBuckets_.erase(timeBuckets_.begin());
-        }
+        return lines_[shard * linesPerShard_ + bucket / kCountsPerLine]
+            .counts[bucket % kCountsPerLine];
     }
+
+    void startTimer();
+    void rotateTimeBuckets();
 };
 }  // namespace monitoring
 }  // namespace drogon
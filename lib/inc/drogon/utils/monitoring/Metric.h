@@ -50,6 +50,21 @@ class Metric : public std::enable_shared_from_this<Metric>
         {
             labels_[i].first = labelNames[i];
             labels_[i].second = labelValues[i];
+            if (i > 0)
+                labelsText_.push_back(',');
+            labelsText_.append(labelNames[i]).append("=\"");
+            for (auto c : labelValues[i])
+            {
+                if (c == '\n')
+                {
+                    labelsText_.append("\\n");
+                    continue;
+                }
+                if (c == '\\' || c == '"')
+                    labelsText_.push_back('\\');
+                labelsText_.push_back(c);
+            }
+            labelsText_.push_back('"');
         }
     };
 
@@ -63,12 +78,22 @@ class Metric : public std::enable_shared_from_this<Metric>
         return labels_;
     }
 
+    /**
+     * @brief The labels in the exposition format, e.g.
+     * `method="GET",code="200"`, rendered once for all the scrapes.
+     */
+    const std::string &labelsText() const
+    {
+        return labelsText_;
+    }
+
     virtual ~Metric() = default;
     virtual std::vector<Sample> collect() const = 0;
 
   protected:
     const std::string name_;
     std::vector<std::pair<std::string, std::string>> labels_;
+    std::string labelsText_;
 };
 
 using MetricPtr = std::shared_ptr<Metric>;
@@ -0,0 +1,69 @@
+/**
+ *
+ *  Shards.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace drogon
+{
+namespace monitoring
+{
+namespace internal
+{
+/**
+ * The metrics keep their values in several shards on separate cache lines,
+ * every thread updates one of them with relaxed atomics, and the shards are
+ * merged only when the metric is collected.
+ * */
+constexpr size_t kShardsNum = 16;
+
+inline size_t shardOfThisThread()
+{
+    static std::atomic<size_t> nextShard{0};
+    thread_local size_t shard =
+        nextShard.fetch_add(1, std::memory_order_relaxed) % kShardsNum;
+    return shard;
+}
+
+inline void atomicAdd(std::atomic<double> &target, double value)
+{
+    auto current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current,
+                                         current + value,
+                                         std::memory_order_relaxed))
+    {
+    }
+}
+
+struct alignas(64) DoubleShard
+{
+    std::atomic<double> value{0};
+};
+
+using DoubleShards = std::array<DoubleShard, kShardsNum>;
+
+inline double sumOf(const DoubleShards &shards)
+{
+    double sum{0};
+    for (auto &shard : shards)
+    {
+        sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+}  // namespace internal
+}  // namespace monitoring
+}  // namespace drogon
@@ -0,0 +1,137 @@
+/**
+ *
+ *  Summary.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+#include <drogon/exports.h>
+#include <drogon/utils/monitoring/Metric.h>
+#include <drogon/utils/monitoring/Shards.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace drogon
+{
+namespace monitoring
+{
+/**
+ * A streaming quantile sketch (DDSketch) with a relative error guarantee.
+ *
+ * A value x is counted in the bucket ceil(log(x) / log(gamma)), where gamma
+ * is (1 + a) / (1 - a) for the relative accuracy a, so any quantile is
+ * estimated within a relative error of a. The buckets are kept in a dense
+ * array of at most maxBuckets counts; when a value would need more, the
+ * lowest buckets are collapsed, so only the low quantiles lose accuracy.
+ * Sketches of the same accuracy can be merged. Values less than or equal to
+ * 0 are counted as 0.
+ * */
+class DROGON_EXPORT DDSketch
+{
+  public:
+    explicit DDSketch(double relativeAccuracy = 0.01,
+                      size_t maxBuckets = 2048) noexcept(false);
+
+    void add(double value, uint64_t count = 1);
+
+    /**
+     * Add the values of another sketch, which must have the same relative
+     * accuracy.
+     * */
+    void merge(const DDSketch &other) noexcept(false);
+
+    /**
+     * Return the estimated value at the quantile q (in [0, 1]), or 0 if the
+     * sketch is empty.
+     * */
+    double quantile(double q) const;
+
+    uint64_t count() const
+    {
+        return count_;
+    }
+
+    double sum() const
+    {
+        return sum_;
+    }
+
+    double relativeAccuracy() const
+    {
+        return relativeAccuracy_;
+    }
+
+    void clear();
+
+  private:
+    int32_t indexOf(double value) const;
+    double valueOf(int32_t index) const;
+    void addToBuckets(int32_t index, uint64_t count);
+
+    double relativeAccuracy_;
+    double gamma_;
+    double logGamma_;
+    size_t maxBuckets_;
+    std::vector<uint64_t> buckets_;
+    int32_t minIndex_{0};
+    uint64_t zeroCount_{0};
+    uint64_t count_{0};
+    double sum_{0};
+    double min_{0};
+    double max_{0};
+};
+
+/**
+ * This class is used to collect samples for a summary metric, whose
+ * quantiles are estimated by a DDSketch.
+ * Every thread adds its observations to the sketch of its shard, the shards
+ * are merged when the summary is collected.
+ * */
+class DROGON_EXPORT Summary : public Metric
+{
+  public:
+    Summary(const std::string &name,
+            const std::vector<std::string> &labelNames,
+            const std::vector<std::string> &labelValues,
+            const std::vector<double> &quantiles = {0.5, 0.9, 0.99},
+            double relativeAccuracy = 0.01,
+            size_t maxBuckets = 2048) noexcept(false);
+
+    void observe(double value);
+    std::vector<Sample> collect() const override;
+
+    /**
+     * Return a sketch of all the observations.
+     * */
+    DDSketch sketch() const;
+
+    static std::string_view type()
+    {
+        return "summary";
+    }
+
+  private:
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        DDSketch sketch;
+    };
+
+    const std::vector<double> quantiles_;
+    const double relativeAccuracy_;
+    const size_t maxBuckets_;
+    std::array<Shard, internal::kShardsNum> shards_;
+};
+}  // namespace monitoring
+}  // namespace drogon
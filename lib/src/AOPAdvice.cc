@@ -15,7 +15,6 @@
 #include "AOPAdvice.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
-#include <trantor/net/TcpConnection.h>
 
 namespace drogon
 {
@@ -30,11 +29,12 @@ static void doAdviceChain(
         &&callbackPtr);
 
 bool AopAdvice::passNewConnectionAdvices(
-    const trantor::TcpConnectionPtr &conn) const
+    const trantor::InetAddress &local,
+    const trantor::InetAddress &peer) const
 {
     for (auto &advice : newConnectionAdvices_)
     {
-        if (!advice(conn->localAddr(), conn->peerAddr()))
+        if (!advice(local, peer))
         {
             return false;
         }
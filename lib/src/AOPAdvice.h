@@ -46,6 +46,14 @@ class AopAdvice
         return !preHandlingAdvices_.empty();
     }
 
+    // Whether any observer or advice runs between the routing and the handler
+    bool hasRoutedStages() const
+    {
+        return !postRoutingObservers_.empty() ||
+               !postRoutingAdvices_.empty() ||
+               !preHandlingObservers_.empty() || !preHandlingAdvices_.empty();
+    }
+
     // Setters?
     void registerNewConnectionAdvice(
         std::function<bool(const trantor::InetAddress &,
@@ -124,7 +132,8 @@ class AopAdvice
     }
 
     // Executors
-    bool passNewConnectionAdvices(const trantor::TcpConnectionPtr &conn) const;
+    bool passNewConnectionAdvices(const trantor::InetAddress &local,
+                                  const trantor::InetAddress &peer) const;
     void passResponseCreationAdvices(const HttpResponsePtr &resp) const;
 
     HttpResponsePtr passSyncAdvices(const HttpRequestPtr &req) const;
@@ -12,10 +12,13 @@
  *
  */
 
+#include "HttpRequestImpl.h"
 #include "HttpUtils.h"
+#include "SpscRingBuffer.h"
 #include <drogon/drogon.h>
 #include <drogon/plugins/AccessLogger.h>
 #include <drogon/plugins/RealIpResolver.h>
+#include <cstdio>
 #include <regex>
 #include <thread>
 #if !defined _WIN32 && !defined __HAIKU__
@@ -62,6 +65,13 @@ using namespace drogon::plugin;
 
 bool AccessLogger::useRealIp_ = false;
 
+AccessLogger::AccessLogger() = default;
+
+AccessLogger::~AccessLogger()
+{
+    stopWriter();
+}
+
 void AccessLogger::initAndStart(const Json::Value &config)
 {
     useLocalTime_ = config.get("use_local_time", true).asBool();
@@ -239,6 +249,7 @@ void AccessLogger::initAndStart(const Json::Value &config)
         }
         asyncFileLogger_.setFileName(fileName, extension, logPath);
         asyncFileLogger_.startLogging();
+        useFileLogger_ = true;
         logIndex_ = config.get("log_index", 0).asInt();
         trantor::Logger::setOutputFunction(
             [&](const char *msg, const uint64_t len) {
@@ -262,15 +273,24 @@ void AccessLogger::initAndStart(const Json::Value &config)
         auto maxFiles = config.get("max_files", 0).asUInt();
         asyncFileLogger_.setMaxFiles(maxFiles);
     }
+    async_ = config.get("async", false).asBool();
+    if (async_)
+    {
+        startWriter(config);
+    }
     drogon::app().registerPreSendingAdvice(
         [this](const drogon::HttpRequestPtr &req,
                const drogon::HttpResponsePtr &resp) {
-            if (regexFlag_)
+            if (regexFlag_ && std::regex_match(req->path(), exemptRegex_))
             {
-                if (!std::regex_match(req->path(), exemptRegex_))
-                {
-                    logging(LOG_RAW_TO(logIndex_), req, resp);
-                }
+                return;
+            }
+            if (async_)
+            {
+                thread_local trantor::LogStream stream;
+                stream.resetBuffer();
+                logging(stream, req, resp);
+                pushLine(stream.bufferData(), stream.bufferLength());
             }
             else
             {
@@ -281,6 +301,164 @@ void AccessLogger::initAndStart(const Json::Value &config)
 
 void AccessLogger::shutdown()
 {
+    stopWriter();
+}
+
+void AccessLogger::startWriter(const Json::Value &config)
+{
+    auto queueSize = config.get("queue_size", 8192).asUInt64();
+    if (queueSize == 0)
+    {
+        queueSize = 8192;
+    }
+    for (size_t i = 0; i < app().getThreadNum(); ++i)
+    {
+        ioLoops_.push_back(app().getIOLoop(i));
+        rings_.push_back(std::make_unique<LineRing>(queueSize));
+    }
+    sharedRing_ = std::make_unique<LineRing>(queueSize);
+
+    auto sink = config.get("sink", "file").asString();
+    if (sink == "udp")
+    {
+        auto ip = config.get("udp_address", "127.0.0.1").asString();
+        auto port = static_cast<uint16_t>(config.get("udp_port", 514).asUInt());
+        udpAddress_ = std::make_unique<trantor::InetAddress>(
+            ip, port, ip.find(':') != std::string::npos);
+        udpSocket_ = static_cast<intptr_t>(
+            ::socket(udpAddress_->family(), SOCK_DGRAM, 0));
+        if (udpSocket_ < 0)
+        {
+            LOG_ERROR << "Can't create the UDP socket of the access log, the "
+                         "file sink is used";
+            udpAddress_.reset();
+        }
+    }
+    else if (sink != "file")
+    {
+        LOG_ERROR << "Unknown access log sink: " << sink
+                  << ", the file sink is used";
+    }
+
+    auto interval = config.get("flush_interval", 0.05).asDouble();
+    if (interval <= 0)
+    {
+        interval = 0.05;
+    }
+    writerThread_ = std::make_unique<trantor::EventLoopThread>("AccessLogger");
+    writerThread_->run();
+    writerThread_->getLoop()->runEvery(interval, [this]() { writeLines(); });
+}
+
+void AccessLogger::stopWriter()
+{
+    if (!writerThread_)
+    {
+        return;
+    }
+    // Join the writer thread, then write the remaining lines in this thread
+    writerThread_.reset();
+    writeLines();
+    if (udpAddress_)
+    {
+#ifdef _WIN32
+        ::closesocket(static_cast<SOCKET>(udpSocket_));
+#else
+        ::close(static_cast<int>(udpSocket_));
+#endif
+        udpAddress_.reset();
+    }
+}
+
+void AccessLogger::pushLine(const char *data, size_t len)
+{
+    std::string_view line(data, len);
+    bool pushed;
+    // Every IO loop is the only producer of its ring, the other threads
+    // share a ring under a lock.
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (loop && loop->index() < ioLoops_.size() &&
+        ioLoops_[loop->index()] == loop)
+    {
+        pushed = rings_[loop->index()]->push(line);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(sharedRingMutex_);
+        pushed = sharedRing_->push(line);
+    }
+    if (!pushed)
+    {
+        droppedLines_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AccessLogger::writeLines()
+{
+    auto collect = [this](std::string &line) {
+        if (udpAddress_)
+        {
+            sendLine(line);
+        }
+        else
+        {
+            batch_.append(line);
+        }
+        // Keep the capacity of the slot for the next line
+        line.clear();
+    };
+    for (auto &ring : rings_)
+    {
+        ring->consumeAll(collect);
+    }
+    sharedRing_->consumeAll(collect);
+    if (!batch_.empty())
+    {
+        if (useFileLogger_)
+        {
+            asyncFileLogger_.output(batch_.data(), batch_.size());
+        }
+        else
+        {
+            LOG_RAW_TO(logIndex_) << batch_;
+        }
+        batch_.clear();
+    }
+    auto dropped = droppedLines_.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops_)
+    {
+        LOG_WARN << dropped - reportedDrops_
+                 << " access log lines were dropped because the queues were "
+                    "full";
+        reportedDrops_ = dropped;
+    }
+}
+
+void AccessLogger::sendLine(const std::string &line)
+{
+    auto len = line.size();
+    if (len > 0 && line[len - 1] == '\n')
+    {
+        --len;
+    }
+    auto addrLen = udpAddress_->isIpV6() ? sizeof(struct sockaddr_in6)
+                                         : sizeof(struct sockaddr_in);
+    // The datagrams are sent on a best effort basis, the errors are ignored
+#ifdef _WIN32
+    ::sendto(static_cast<SOCKET>(udpSocket_),
+             line.data(),
+             static_cast<int>(len),
+             0,
+             udpAddress_->getSockAddr(),
+             static_cast<int>(addrLen));
+#else
+    ::sendto(static_cast<int>(udpSocket_),
+             line.data(),
+             len,
+             0,
+             udpAddress_->getSockAddr(),
+             static_cast<socklen_t>(addrLen));
+#endif
 }
 
 void AccessLogger::logging(trantor::LogStream &stream,
@@ -382,6 +560,33 @@ AccessLogger::LogFunction AccessLogger::newLogFunction(
             outputReqCookie(stream, req, cookieName);
         };
     }
+    if (placeholder.find("$phase_") == 0)
+    {
+        // Only the phases ended before the pre-sending advices are known
+        auto name = placeholder.substr(7);
+        for (size_t i = 1; i <= static_cast<size_t>(RequestPhase::kSending);
+             ++i)
+        {
+            auto phase = static_cast<RequestPhase>(i);
+            if (name != RequestPhases::name(phase))
+                continue;
+            return [phase](trantor::LogStream &stream,
+                           const drogon::HttpRequestPtr &req,
+                           const drogon::HttpResponsePtr &) {
+                auto phases =
+                    static_cast<HttpRequestImpl *>(req.get())->phases();
+                auto seconds = phases ? phases->seconds(phase) : -1.0;
+                if (seconds < 0)
+                {
+                    stream << "-";
+                    return;
+                }
+                char buf[32];
+                snprintf(buf, sizeof(buf), "%.3f", seconds * 1000);
+                stream << buf;
+            };
+        }
+    }
     if (placeholder.find("$upstream_http_") == 0 && placeholder.size() > 15)
     {
         auto headerName = placeholder.substr(15);
@@ -0,0 +1,40 @@
+/**
+ *
+ *  @file AdminAuth.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpRequest.h>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief Whether the request may use the admin endpoints of the plugins: it
+ * must carry an "Authorization: Bearer <token>" header with the token, or,
+ * without a token, come from a loopback address.
+ */
+inline bool isAdminRequest(const HttpRequestPtr &req, const std::string &token)
+{
+    if (token.empty())
+        return req->peerAddr().isLoopbackIp();
+    const auto &authorization = req->getHeader("authorization");
+    if (authorization.length() != token.length() + 7 ||
+        authorization.compare(0, 7, "Bearer ") != 0)
+        return false;
+    // Compare in constant time, not to reveal the length of the right prefix
+    unsigned char diff = 0;
+    for (size_t i = 0; i < token.length(); ++i)
+        diff |= static_cast<unsigned char>(authorization[i + 7] ^ token[i]);
+    return diff == 0;
+}
+}  // namespace drogon
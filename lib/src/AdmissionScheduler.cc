@@ -0,0 +1,335 @@
+/**
+ *  @file AdmissionScheduler.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/AdmissionScheduler.h>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+using namespace drogon::plugin;
+
+namespace
+{
+const char *const kAdmittedKey = "drogon.admissionScheduler";
+
+std::vector<std::string> stringList(const Json::Value &values)
+{
+    std::vector<std::string> list;
+    if (values.isString())
+    {
+        list.push_back(values.asString());
+    }
+    else if (values.isArray())
+    {
+        for (auto &value : values)
+            list.push_back(value.asString());
+    }
+    return list;
+}
+
+bool contains(const std::vector<std::string> &list, std::string_view value)
+{
+    return std::find(list.begin(), list.end(), value) != list.end();
+}
+}  // namespace
+
+class AdmissionScheduler::AdmittedRequest
+{
+  public:
+    AdmittedRequest(AdmissionScheduler *scheduler, LoopState *state)
+        : scheduler_(scheduler), state_(state)
+    {
+    }
+
+    /// Called when the handler produced the response
+    void finish()
+    {
+        if (finished_)
+            return;
+        finished_ = true;
+        release();
+    }
+
+    /// The request was rejected by another advice or dropped
+    ~AdmittedRequest()
+    {
+        if (!finished_)
+            release();
+    }
+
+  private:
+    void release()
+    {
+        // The response may be produced in any thread
+        state_->loop->runInLoop(
+            [scheduler = scheduler_, state = state_]() {
+                scheduler->release(*state);
+            });
+    }
+
+    AdmissionScheduler *scheduler_;
+    LoopState *state_;
+    bool finished_{false};
+};
+
+void AdmissionScheduler::initAndStart(const Json::Value &config)
+{
+    maxConcurrency_ = (std::max)(static_cast<size_t>(1),
+                                 static_cast<size_t>(
+                                     config.get("max_concurrency", 64)
+                                         .asUInt64()));
+    maxQueue_ = config.get("max_queue", 256).asUInt64();
+    auto timeout = config.get("queue_timeout", 1.0).asDouble();
+    queueTimeout_ =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(timeout));
+    rejectResponse_ = HttpResponse::newHttpResponse();
+    rejectResponse_->setStatusCode(k503ServiceUnavailable);
+    rejectResponse_->setBody(
+        config.get("rejection_message", "Service unavailable").asString());
+
+    for (auto &item : config["classes"])
+    {
+        RequestClass requestClass;
+        requestClass.name =
+            item.get("name", std::to_string(classes_.size())).asString();
+        requestClass.weight = item.get("weight", 1.0).asDouble();
+        if (requestClass.weight <= 0)
+        {
+            throw std::runtime_error(
+                "The weights of AdmissionScheduler must be positive");
+        }
+        std::string regexString;
+        for (auto &url : stringList(item["urls"]))
+            regexString.append("(").append(url).append(")|");
+        if (!regexString.empty())
+        {
+            regexString.resize(regexString.length() - 1);
+            requestClass.urls = std::regex(regexString);
+            requestClass.matchUrls = true;
+        }
+        requestClass.header = item.get("header", "").asString();
+        std::transform(requestClass.header.begin(),
+                       requestClass.header.end(),
+                       requestClass.header.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        requestClass.headerValues = stringList(item["header_values"]);
+        requestClass.attribute = item.get("attribute", "").asString();
+        requestClass.attributeValues = stringList(item["attribute_values"]);
+        classes_.push_back(std::move(requestClass));
+    }
+    if (classes_.empty())
+    {
+        RequestClass requestClass;
+        requestClass.name = "default";
+        classes_.push_back(std::move(requestClass));
+    }
+
+    for (size_t i = 0; i < app().getThreadNum(); ++i)
+    {
+        auto state = std::make_unique<LoopState>();
+        state->loop = app().getIOLoop(i);
+        state->queues.resize(classes_.size());
+        if (timeout > 0)
+        {
+            state->loop->runEvery(timeout / 2,
+                                  [this, state = state.get()]() {
+                                      expire(*state);
+                                  });
+        }
+        loops_.push_back(std::move(state));
+    }
+    LOG_TRACE << "AdmissionScheduler: " << classes_.size()
+              << " request classes";
+
+    app().registerPreHandlingAdvice(
+        [this](const HttpRequestPtr &req,
+               AdviceCallback &&adviceCallback,
+               AdviceChainCallback &&chainCallback) {
+            auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+            if (!loop || loop->index() >= loops_.size() ||
+                loops_[loop->index()]->loop != loop)
+            {
+                chainCallback();
+                return;
+            }
+            auto state = loops_[loop->index()].get();
+            auto admit = [this,
+                          state,
+                          req,
+                          chainCallback = std::move(chainCallback)]() {
+                req->attributes()->insert(
+                    kAdmittedKey,
+                    std::make_shared<AdmittedRequest>(this, state));
+                chainCallback();
+            };
+            schedule(*state,
+                     classify(req),
+                     std::move(adviceCallback),
+                     std::move(admit));
+        });
+    app().registerPostHandlingAdvice(
+        [](const HttpRequestPtr &req, const HttpResponsePtr &) {
+            auto &attributes = req->attributes();
+            if (!attributes->find(kAdmittedKey))
+                return;
+            auto &admittedRequest =
+                attributes->get<std::shared_ptr<AdmittedRequest>>(
+                    kAdmittedKey);
+            if (admittedRequest)
+                admittedRequest->finish();
+        });
+}
+
+void AdmissionScheduler::shutdown()
+{
+    LOG_TRACE << "AdmissionScheduler plugin is shutdown!";
+}
+
+size_t AdmissionScheduler::classify(const HttpRequestPtr &req) const
+{
+    auto pattern = req->matchedPathPattern();
+    for (size_t i = 0; i < classes_.size(); ++i)
+    {
+        auto &requestClass = classes_[i];
+        if (requestClass.matchUrls &&
+            !std::regex_match(pattern.begin(),
+                              pattern.end(),
+                              requestClass.urls))
+            continue;
+        if (!requestClass.header.empty() &&
+            !contains(requestClass.headerValues,
+                      req->getHeader(requestClass.header)))
+            continue;
+        if (!requestClass.attribute.empty())
+        {
+            auto &attributes = req->attributes();
+            if (!attributes->find(requestClass.attribute))
+                continue;
+            auto &value = (*attributes)[requestClass.attribute];
+            if (value.type() != typeid(std::string) ||
+                !contains(requestClass.attributeValues,
+                          *std::any_cast<std::string>(&value)))
+                continue;
+        }
+        return i;
+    }
+    return classes_.size() - 1;
+}
+
+void AdmissionScheduler::schedule(LoopState &state,
+                                  size_t requestClass,
+                                  AdviceCallback &&reject,
+                                  AdviceChainCallback &&admit)
+{
+    if (state.queued == 0 && state.inFlight < maxConcurrency_)
+    {
+        ++state.inFlight;
+        admit();
+        return;
+    }
+    state.queues[requestClass].requests.push_back(
+        {std::move(reject),
+         std::move(admit),
+         std::chrono::steady_clock::now()});
+    ++state.queued;
+    if (state.queued > maxQueue_)
+        shed(state);
+}
+
+void AdmissionScheduler::release(LoopState &state)
+{
+    --state.inFlight;
+    dispatch(state);
+}
+
+void AdmissionScheduler::dispatch(LoopState &state)
+{
+    // A request admitted here may complete at once, the outer call goes on
+    if (state.dispatching)
+        return;
+    state.dispatching = true;
+    auto deadline = std::chrono::steady_clock::now() - queueTimeout_;
+    while (state.inFlight < maxConcurrency_ && state.queued > 0)
+    {
+        auto &queue = state.queues[state.current];
+        if (queue.requests.empty())
+        {
+            // An idle class doesn't save its turns for later
+            queue.deficit = 0;
+            state.current = (state.current + 1) % state.queues.size();
+            continue;
+        }
+        if (queue.deficit < 1)
+            queue.deficit += classes_[state.current].weight;
+        while (queue.deficit >= 1 && !queue.requests.empty() &&
+               state.inFlight < maxConcurrency_)
+        {
+            auto request = std::move(queue.requests.front());
+            queue.requests.pop_front();
+            --state.queued;
+            if (queueTimeout_.count() > 0 && request.queuedTime < deadline)
+            {
+                request.reject(rejectResponse_);
+                continue;
+            }
+            queue.deficit -= 1;
+            ++state.inFlight;
+            request.admit();
+        }
+        if (queue.requests.empty())
+            queue.deficit = 0;
+        if (queue.deficit < 1)
+            state.current = (state.current + 1) % state.queues.size();
+    }
+    state.dispatching = false;
+}
+
+void AdmissionScheduler::shed(LoopState &state)
+{
+    ClassQueue *lowest{nullptr};
+    double lowestWeight{0};
+    for (size_t i = 0; i < state.queues.size(); ++i)
+    {
+        auto &queue = state.queues[i];
+        if (queue.requests.empty())
+            continue;
+        if (!lowest || classes_[i].weight <= lowestWeight)
+        {
+            lowest = &queue;
+            lowestWeight = classes_[i].weight;
+        }
+    }
+    if (!lowest)
+        return;
+    // The oldest request is the one most likely to be late anyway
+    auto request = std::move(lowest->requests.front());
+    lowest->requests.pop_front();
+    --state.queued;
+    request.reject(rejectResponse_);
+}
+
+void AdmissionScheduler::expire(LoopState &state)
+{
+    auto deadline = std::chrono::steady_clock::now() - queueTimeout_;
+    for (auto &queue : state.queues)
+    {
+        while (!queue.requests.empty() &&
+               queue.requests.front().queuedTime < deadline)
+        {
+            auto request = std::move(queue.requests.front());
+            queue.requests.pop_front();
+            --state.queued;
+            request.reject(rejectResponse_);
+        }
+    }
+}
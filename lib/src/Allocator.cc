@@ -0,0 +1,133 @@
+/**
+ *
+ *  @file Allocator.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Allocator.h"
+#include <trantor/utils/Logger.h>
+#include <cstdint>
+#if defined(USE_MIMALLOC)
+#include <mimalloc.h>
+#elif defined(USE_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace drogon;
+
+#if defined(USE_MIMALLOC)
+
+std::string_view Allocator::name()
+{
+    return "mimalloc";
+}
+
+void Allocator::bindThread()
+{
+    // The default heap of mimalloc belongs to its thread, the blocks freed
+    // by other threads are handed back to it.
+    mi_thread_init();
+}
+
+Allocator::Stats Allocator::stats()
+{
+    size_t elapsed, user, system, rss, peakRss, commit, peakCommit, faults;
+    mi_process_info(&elapsed,
+                    &user,
+                    &system,
+                    &rss,
+                    &peakRss,
+                    &commit,
+                    &peakCommit,
+                    &faults);
+    Stats stats;
+    stats.resident = static_cast<double>(rss);
+    stats.mapped = static_cast<double>(commit);
+    return stats;
+}
+
+#elif defined(USE_JEMALLOC)
+
+namespace
+{
+double readSize(const char *name)
+{
+    size_t value = 0;
+    size_t size = sizeof(value);
+    if (mallctl(name, &value, &size, nullptr, 0) != 0)
+        return -1;
+    return static_cast<double>(value);
+}
+}  // namespace
+
+std::string_view Allocator::name()
+{
+    return "jemalloc";
+}
+
+void Allocator::bindThread()
+{
+    // The threads share the automatic arenas of jemalloc, an IO thread gets
+    // one of its own.
+    unsigned arena = 0;
+    size_t size = sizeof(arena);
+    if (mallctl("arenas.create", &arena, &size, nullptr, 0) != 0)
+    {
+        LOG_WARN << "Cannot create a jemalloc arena for the IO thread";
+        return;
+    }
+    if (mallctl("thread.arena", nullptr, nullptr, &arena, sizeof(arena)) != 0)
+    {
+        LOG_WARN << "Cannot bind the IO thread to the jemalloc arena "
+                 << arena;
+    }
+}
+
+Allocator::Stats Allocator::stats()
+{
+    // The statistics are refreshed by a new epoch
+    uint64_t epoch = 1;
+    size_t size = sizeof(epoch);
+    mallctl("epoch", &epoch, &size, &epoch, size);
+    Stats stats;
+    stats.allocated = readSize("stats.allocated");
+    stats.active = readSize("stats.active");
+    stats.resident = readSize("stats.resident");
+    stats.mapped = readSize("stats.mapped");
+    stats.retained = readSize("stats.retained");
+    return stats;
+}
+
+#else
+
+std::string_view Allocator::name()
+{
+    return "system";
+}
+
+void Allocator::bindThread()
+{
+}
+
+Allocator::Stats Allocator::stats()
+{
+    Stats stats;
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    auto info = mallinfo2();
+    stats.allocated = static_cast<double>(info.uordblks + info.hblkhd);
+    stats.mapped = static_cast<double>(info.arena + info.hblkhd);
+#endif
+    return stats;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ *
+ *  @file Allocator.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief The hooks of the allocator chosen by the USE_ALLOCATOR cmake
+ * option: mimalloc, jemalloc or the system malloc.
+ *
+ * Every IO thread is bound to a heap of its own before it serves, so the
+ * loops never contend for an arena with each other or with the database and
+ * worker threads. A block freed by another thread goes back to the heap it
+ * came from. When the IO threads are pinned (io_threads_affinity), the
+ * pages of their heaps are first touched on their CPU and so come from its
+ * NUMA node.
+ */
+class Allocator
+{
+  public:
+    /**
+     * @brief The bytes reported by the allocator, the kinds it does not
+     * report are -1.
+     */
+    struct Stats
+    {
+        /// Allocated by the application
+        double allocated{-1};
+        /// In the pages which hold allocations
+        double active{-1};
+        /// Resident in physical memory
+        double resident{-1};
+        /// Mapped or committed from the system
+        double mapped{-1};
+        /// Unmapped but kept to be reused
+        double retained{-1};
+    };
+
+    /// "mimalloc", "jemalloc" or "system"
+    static std::string_view name();
+
+    /**
+     * @brief Give the calling thread a heap of its own, a no-op with the
+     * system malloc.
+     */
+    static void bindThread();
+
+    static Stats stats();
+};
+}  // namespace drogon
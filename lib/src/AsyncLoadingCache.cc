@@ -0,0 +1,43 @@
+/**
+ *
+ *  @file AsyncLoadingCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/AsyncLoadingCache.h>
+#include "BuiltinMetrics.h"
+
+using namespace drogon;
+using namespace drogon::internal;
+
+bool LoadingCacheStats::resolve()
+{
+    auto metrics = BuiltinMetrics::instance().loadingCacheMetrics(cache_);
+    if (!metrics)
+        return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!resolved_.load(std::memory_order_relaxed))
+    {
+        events_ = metrics->events;
+        loadDuration_ = metrics->loadDuration;
+        resolved_.store(true, std::memory_order_release);
+    }
+    return true;
+}
+
+void LoadingCacheStats::increment(Event event, size_t times)
+{
+    events_[event]->increment(static_cast<double>(times));
+}
+
+void LoadingCacheStats::observe(double seconds)
+{
+    loadDuration_->observe(seconds);
+}
@@ -0,0 +1,79 @@
+#include "AtomicSlidingWindowRateLimiter.h"
+#include <algorithm>
+
+using namespace drogon;
+
+namespace
+{
+size_t stripeOfThisThread()
+{
+    static std::atomic<size_t> nextStripe{0};
+    thread_local size_t stripe =
+        nextStripe.fetch_add(1, std::memory_order_relaxed);
+    return stripe;
+}
+}  // namespace
+
+AtomicSlidingWindowRateLimiter::AtomicSlidingWindowRateLimiter(
+    size_t capacity,
+    std::chrono::duration<double> timeUnit)
+    : capacity_(capacity),
+      startTime_(std::chrono::steady_clock::now()),
+      timeUnit_(
+          (std::max)(static_cast<int64_t>(1),
+                     static_cast<int64_t>(
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             timeUnit)
+                             .count())))
+{
+}
+
+void AtomicSlidingWindowRateLimiter::rotate(int64_t window)
+{
+    auto current = window_.load(std::memory_order_acquire);
+    while (current < window)
+    {
+        if (window_.compare_exchange_weak(current,
+                                          window,
+                                          std::memory_order_acq_rel))
+        {
+            // Only one thread moves the counts of the window
+            uint64_t sum{0};
+            for (auto &stripe : stripes_)
+            {
+                sum += stripe.count.exchange(0, std::memory_order_relaxed);
+            }
+            previousRequests_.store(window == current + 1 ? sum : 0,
+                                    std::memory_order_release);
+            return;
+        }
+    }
+}
+
+// implementation of the sliding window algorithm without lock
+bool AtomicSlidingWindowRateLimiter::isAllowed()
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - startTime_)
+                       .count();
+    auto window = elapsed / timeUnit_;
+    if (window > window_.load(std::memory_order_acquire))
+        rotate(window);
+    auto coef = static_cast<double>(elapsed - window * timeUnit_) /
+                static_cast<double>(timeUnit_);
+    uint64_t currentRequests{0};
+    for (auto &stripe : stripes_)
+    {
+        currentRequests += stripe.count.load(std::memory_order_relaxed);
+    }
+    auto count =
+        previousRequests_.load(std::memory_order_acquire) * (1.0 - coef) +
+        currentRequests;
+    if (count < capacity_)
+    {
+        stripes_[stripeOfThisThread() % kStripesNum].count.fetch_add(
+            1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <drogon/RateLimiter.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace drogon
+{
+/**
+ * @brief A sliding window limiter which can be shared by threads without a
+ * lock.
+ *
+ * The requests of the current window are counted by per-thread stripes on
+ * separate cache lines, so the threads don't write the same counter. A
+ * request reads all stripes to estimate the count of the window, and the
+ * first thread which sees a new window moves the counts to the previous
+ * window. Because the check and the increment are not one atomic step, the
+ * limiter may allow up to one more request per concurrent thread than the
+ * capacity.
+ */
+class AtomicSlidingWindowRateLimiter : public RateLimiter
+{
+  public:
+    AtomicSlidingWindowRateLimiter(size_t capacity,
+                                   std::chrono::duration<double> timeUnit);
+    bool isAllowed() override;
+    ~AtomicSlidingWindowRateLimiter() noexcept override = default;
+
+  private:
+    static constexpr size_t kStripesNum = 16;
+
+    struct alignas(64) Stripe
+    {
+        std::atomic<uint64_t> count{0};
+    };
+
+    void rotate(int64_t window);
+
+    const size_t capacity_;
+    const std::chrono::steady_clock::time_point startTime_;
+    const int64_t timeUnit_;
+    std::array<Stripe, kStripesNum> stripes_;
+    std::atomic<int64_t> window_{0};
+    std::atomic<uint64_t> previousRequests_{0};
+};
+}  // namespace drogon
@@ -0,0 +1,41 @@
+#include "AtomicTokenBucketRateLimiter.h"
+#include <algorithm>
+
+using namespace drogon;
+
+AtomicTokenBucketRateLimiter::AtomicTokenBucketRateLimiter(
+    size_t capacity,
+    std::chrono::duration<double> timeUnit)
+    : startTime_(std::chrono::steady_clock::now()),
+      interval_(capacity == 0
+                    ? 0
+                    : static_cast<int64_t>(
+                          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              timeUnit)
+                              .count() /
+                          static_cast<int64_t>(capacity))),
+      timeUnit_(std::chrono::duration_cast<std::chrono::nanoseconds>(timeUnit)
+                    .count())
+{
+}
+
+// implementation of the token bucket algorithm without lock
+bool AtomicTokenBucketRateLimiter::isAllowed()
+{
+    if (interval_ == 0)
+        return false;
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - startTime_)
+                   .count();
+    auto arrivalTime = arrivalTime_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto newArrivalTime = (std::max)(arrivalTime, now) + interval_;
+        if (newArrivalTime - now > timeUnit_)
+            return false;
+        if (arrivalTime_.compare_exchange_weak(arrivalTime,
+                                               newArrivalTime,
+                                               std::memory_order_relaxed))
+            return true;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <drogon/RateLimiter.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace drogon
+{
+/**
+ * @brief A token bucket limiter which can be shared by threads without a
+ * lock.
+ *
+ * The whole state is one 64-bit value, the theoretical arrival time of the
+ * generic cell rate algorithm in nanoseconds, which is equivalent to the
+ * number of tokens and the time of the last refill. A request moves that time
+ * forward by the interval of one token with a CAS, and is refused if the time
+ * would be more than a time unit ahead of now, that is, the bucket is empty.
+ */
+class AtomicTokenBucketRateLimiter : public RateLimiter
+{
+  public:
+    AtomicTokenBucketRateLimiter(size_t capacity,
+                                 std::chrono::duration<double> timeUnit);
+    bool isAllowed() override;
+    ~AtomicTokenBucketRateLimiter() noexcept override = default;
+
+  private:
+    const std::chrono::steady_clock::time_point startTime_;
+    const int64_t interval_;
+    const int64_t timeUnit_;
+    std::atomic<int64_t> arrivalTime_{0};
+};
+}  // namespace drogon
@@ -0,0 +1,501 @@
+/**
+ *
+ *  @file BinaryCodecs.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "BinaryCodecs.h"
+#include <stdint.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define DROGON_CODECS_AVX2 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define DROGON_CODECS_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+#ifdef DROGON_CODECS_AVX2
+// The base64 codecs follow "Faster Base64 Encoding and Decoding Using AVX2
+// Instructions" by W. Mula and D. Lemire.
+__attribute__((target("avx2"))) size_t base64EncodeAvx2(
+    const unsigned char *in,
+    size_t len,
+    unsigned char *out,
+    bool urlSafe)
+{
+    // The 12 bytes of each lane as 16 bits words [b1 b0] [b2 b1]
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                             7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4,
+                                             7, 6, 8, 7, 10, 9, 11, 10);
+    // The offsets from the indices to the characters, by range of indices
+    const char plus = urlSafe ? '-' : '+';
+    const char slash = urlSafe ? '_' : '/';
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, plus - 62,
+                                             slash - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, plus - 62,
+                                             slash - 63, 'A', 0, 0);
+    size_t i = 0;
+    // 16 bytes are loaded from the start of each 12 bytes lane
+    for (; i + 28 <= len; i += 24, out += 32)
+    {
+        __m256i data = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 12)),
+            1);
+        data = _mm256_shuffle_epi8(data, shuffle);
+        // Move the four 6 bits fields of every 24 bits to their own bytes
+        __m256i ac = _mm256_mulhi_epu16(
+            _mm256_and_si256(data, _mm256_set1_epi32(0x0fc0fc00)),
+            _mm256_set1_epi32(0x04000040));
+        __m256i bd = _mm256_mullo_epi16(
+            _mm256_and_si256(data, _mm256_set1_epi32(0x003f03f0)),
+            _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(ac, bd);
+        // The range of each index: 13 for the capitals, 0 for the small
+        // letters, 1 to 10 for the digits, then 11 and 12
+        __m256i ranges = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        ranges = _mm256_or_si256(
+            ranges, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        __m256i chars = _mm256_add_epi8(
+            _mm256_shuffle_epi8(offsets, ranges), indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), chars);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t base64DecodeAvx2(const char *in,
+                                                        size_t len,
+                                                        unsigned char *out)
+{
+    // The classes of the characters by their low and high nibbles, a valid
+    // character has no class in common in both tables
+    const __m256i lowClasses = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i highClasses = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    // The offsets from the characters to the values, by high nibble, '/'
+    // uses the entry 1
+    const __m256i offsets = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9,
+                                          8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9,
+                                          8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32, out += 24)
+    {
+        __m256i chars =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        // The url safe alphabet is accepted as well
+        chars = _mm256_blendv_epi8(
+            chars,
+            _mm256_set1_epi8('+'),
+            _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('-')));
+        chars = _mm256_blendv_epi8(
+            chars,
+            _mm256_set1_epi8('/'),
+            _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_')));
+        __m256i high =
+            _mm256_and_si256(_mm256_srli_epi32(chars, 4), nibble);
+        __m256i low = _mm256_and_si256(chars, nibble);
+        if (!_mm256_testz_si256(_mm256_shuffle_epi8(lowClasses, low),
+                                _mm256_shuffle_epi8(highClasses, high)))
+            break;
+        __m256i slashes = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+        __m256i values = _mm256_add_epi8(
+            chars,
+            _mm256_shuffle_epi8(offsets, _mm256_add_epi8(slashes, high)));
+        // Join the 6 bits values into 24 bits, then the bytes of each lane
+        __m256i merged = _mm256_maddubs_epi16(values,
+                                              _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_shuffle_epi8(merged, pack);
+        // The 24 bytes are stored exactly, the output may end with them
+        merged = _mm256_permutevar8x32_epi32(
+            merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         _mm256_castsi256_si128(merged));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 16),
+                         _mm256_extracti128_si256(merged, 1));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t hexEncodeAvx2(const char *in,
+                                                     size_t len,
+                                                     char *out,
+                                                     bool lowerCase)
+{
+    const __m256i digits =
+        lowerCase ? _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                     '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                                     '0', '1', '2', '3', '4', '5', '6', '7',
+                                     '8', '9', 'a', 'b', 'c', 'd', 'e', 'f')
+                  : _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                     '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+                                     '0', '1', '2', '3', '4', '5', '6', '7',
+                                     '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32, out += 64)
+    {
+        __m256i data =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        __m256i high = _mm256_shuffle_epi8(
+            digits, _mm256_and_si256(_mm256_srli_epi16(data, 4), nibble));
+        __m256i low =
+            _mm256_shuffle_epi8(digits, _mm256_and_si256(data, nibble));
+        // The interleaving stays in the lanes, put the halves in order
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t hexDecodeAvx2(const char *in,
+                                                     size_t len,
+                                                     char *out)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32, out += 16)
+    {
+        __m256i chars =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        __m256i digits = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+        __m256i isDigit = _mm256_cmpeq_epi8(
+            _mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+        __m256i letters =
+            _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)),
+                            _mm256_set1_epi8('a'));
+        __m256i isLetter = _mm256_cmpeq_epi8(
+            _mm256_min_epu8(letters, _mm256_set1_epi8(5)), letters);
+        if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter)) != -1)
+            break;
+        __m256i values = _mm256_blendv_epi8(
+            _mm256_add_epi8(letters, _mm256_set1_epi8(10)), digits, isDigit);
+        // high * 16 + low in 16 bits, then the 8 bytes of each lane
+        __m256i bytes =
+            _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0110));
+        bytes = _mm256_packus_epi16(bytes, bytes);
+        bytes = _mm256_permute4x64_epi64(bytes, 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         _mm256_castsi256_si128(bytes));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t urlPlainLengthAvx2(const char *in,
+                                                          size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i chars =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('%')),
+                            _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('+')))));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return i;
+}
+#endif
+
+#ifdef DROGON_CODECS_NEON
+uint8x16x4_t loadTable(const char *table)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(table);
+    return {{vld1q_u8(bytes),
+             vld1q_u8(bytes + 16),
+             vld1q_u8(bytes + 32),
+             vld1q_u8(bytes + 48)}};
+}
+
+size_t base64EncodeNeon(const unsigned char *in,
+                        size_t len,
+                        unsigned char *out,
+                        bool urlSafe)
+{
+    const uint8x16x4_t table =
+        loadTable(urlSafe ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuv"
+                            "wxyz0123456789-_"
+                          : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuv"
+                            "wxyz0123456789+/");
+    size_t i = 0;
+    for (; i + 48 <= len; i += 48, out += 64)
+    {
+        uint8x16x3_t data = vld3q_u8(in + i);
+        uint8x16x4_t chars;
+        chars.val[0] = vshrq_n_u8(data.val[0], 2);
+        chars.val[1] = vorrq_u8(
+            vandq_u8(vshlq_n_u8(data.val[0], 4), vdupq_n_u8(0x30)),
+            vshrq_n_u8(data.val[1], 4));
+        chars.val[2] = vorrq_u8(
+            vandq_u8(vshlq_n_u8(data.val[1], 2), vdupq_n_u8(0x3c)),
+            vshrq_n_u8(data.val[2], 6));
+        chars.val[3] = vandq_u8(data.val[2], vdupq_n_u8(0x3f));
+        for (auto &value : chars.val)
+            value = vqtbl4q_u8(table, value);
+        vst4q_u8(out, chars);
+    }
+    return i;
+}
+
+size_t base64DecodeNeon(const char *in, size_t len, unsigned char *out)
+{
+    // The values of the characters below and above 64, 0xff if invalid
+    static const char values[] =
+        "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+        "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+        "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x3e\xff\x3e\xff\x3f"
+        "\x34\x35\x36\x37\x38\x39\x3a\x3b\x3c\x3d\xff\xff\xff\xff\xff\xff"
+        "\xff\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e"
+        "\x0f\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\xff\xff\xff\xff\x3f"
+        "\xff\x1a\x1b\x1c\x1d\x1e\x1f\x20\x21\x22\x23\x24\x25\x26\x27\x28"
+        "\x29\x2a\x2b\x2c\x2d\x2e\x2f\x30\x31\x32\x33\xff\xff\xff\xff\xff";
+    const uint8x16x4_t low = loadTable(values);
+    const uint8x16x4_t high = loadTable(values + 64);
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64, out += 48)
+    {
+        uint8x16x4_t chars =
+            vld4q_u8(reinterpret_cast<const uint8_t *>(in + i));
+        uint8x16_t invalid = vdupq_n_u8(0);
+        for (auto &value : chars.val)
+        {
+            // The indices out of a table leave the value unchanged
+            uint8x16_t mapped = vqtbl4q_u8(low, value);
+            mapped = vqtbx4q_u8(mapped, high, vsubq_u8(value, vdupq_n_u8(64)));
+            invalid = vorrq_u8(invalid, vcgeq_u8(value, vdupq_n_u8(128)));
+            invalid = vorrq_u8(invalid, mapped);
+            value = mapped;
+        }
+        if (vmaxvq_u8(invalid) > 0x3f)
+            break;
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(chars.val[0], 2),
+                                vshrq_n_u8(chars.val[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(chars.val[1], 4),
+                                vshrq_n_u8(chars.val[2], 2));
+        bytes.val[2] =
+            vorrq_u8(vshlq_n_u8(chars.val[2], 6), chars.val[3]);
+        vst3q_u8(out, bytes);
+    }
+    return i;
+}
+
+size_t hexEncodeNeon(const char *in, size_t len, char *out, bool lowerCase)
+{
+    const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t *>(
+        lowerCase ? "0123456789abcdef" : "0123456789ABCDEF"));
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16, out += 32)
+    {
+        uint8x16_t data = vld1q_u8(reinterpret_cast<const uint8_t *>(in + i));
+        uint8x16x2_t chars;
+        chars.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(data, 4));
+        chars.val[1] = vqtbl1q_u8(digits, vandq_u8(data, vdupq_n_u8(0x0f)));
+        vst2q_u8(reinterpret_cast<uint8_t *>(out), chars);
+    }
+    return i;
+}
+
+// The values of the hex digits, with all bits set in valid for the digits
+inline uint8x16_t hexValues(uint8x16_t chars, uint8x16_t &valid)
+{
+    uint8x16_t digits = vsubq_u8(chars, vdupq_n_u8('0'));
+    uint8x16_t isDigit = vcleq_u8(digits, vdupq_n_u8(9));
+    uint8x16_t letters =
+        vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isLetter = vcleq_u8(letters, vdupq_n_u8(5));
+    valid = vandq_u8(valid, vorrq_u8(isDigit, isLetter));
+    return vbslq_u8(isDigit, digits, vaddq_u8(letters, vdupq_n_u8(10)));
+}
+
+size_t hexDecodeNeon(const char *in, size_t len, char *out)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32, out += 16)
+    {
+        uint8x16x2_t chars =
+            vld2q_u8(reinterpret_cast<const uint8_t *>(in + i));
+        uint8x16_t valid = vdupq_n_u8(0xff);
+        uint8x16_t high = hexValues(chars.val[0], valid);
+        uint8x16_t low = hexValues(chars.val[1], valid);
+        if (vminvq_u8(valid) != 0xff)
+            break;
+        vst1q_u8(reinterpret_cast<uint8_t *>(out),
+                 vorrq_u8(vshlq_n_u8(high, 4), low));
+    }
+    return i;
+}
+
+size_t urlPlainLengthNeon(const char *in, size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t *>(in + i));
+        uint8x16_t found = vorrq_u8(vceqq_u8(chars, vdupq_n_u8('%')),
+                                    vceqq_u8(chars, vdupq_n_u8('+')));
+        // 4 bits per byte
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(found), 4)),
+            0);
+        if (mask != 0)
+            return i + __builtin_ctzll(mask) / 4;
+    }
+    return i;
+}
+#endif
+
+#ifndef DROGON_CODECS_NEON
+size_t base64EncodeScalar(const unsigned char *, size_t, unsigned char *, bool)
+{
+    return 0;
+}
+
+size_t base64DecodeScalar(const char *, size_t, unsigned char *)
+{
+    return 0;
+}
+
+size_t hexEncodeScalar(const char *, size_t, char *, bool)
+{
+    return 0;
+}
+
+size_t hexDecodeScalar(const char *, size_t, char *)
+{
+    return 0;
+}
+
+size_t urlPlainLengthScalar(const char *, size_t)
+{
+    return 0;
+}
+#endif
+
+struct Implementation
+{
+    size_t (*base64Encode)(const unsigned char *,
+                           size_t,
+                           unsigned char *,
+                           bool);
+    size_t (*base64Decode)(const char *, size_t, unsigned char *);
+    size_t (*hexEncode)(const char *, size_t, char *, bool);
+    size_t (*hexDecode)(const char *, size_t, char *);
+    size_t (*urlPlainLength)(const char *, size_t);
+    const char *name;
+};
+
+Implementation selectImplementation()
+{
+#ifdef DROGON_CODECS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {base64EncodeAvx2,
+                base64DecodeAvx2,
+                hexEncodeAvx2,
+                hexDecodeAvx2,
+                urlPlainLengthAvx2,
+                "avx2"};
+#endif
+#ifdef DROGON_CODECS_NEON
+    return {base64EncodeNeon,
+            base64DecodeNeon,
+            hexEncodeNeon,
+            hexDecodeNeon,
+            urlPlainLengthNeon,
+            "neon"};
+#else
+    // The callers' loops do all the work
+    return {base64EncodeScalar,
+            base64DecodeScalar,
+            hexEncodeScalar,
+            hexDecodeScalar,
+            urlPlainLengthScalar,
+            "scalar"};
+#endif
+}
+
+const Implementation &implementation()
+{
+    static const Implementation impl = selectImplementation();
+    return impl;
+}
+}  // namespace
+
+size_t binary_codecs::base64Encode(const unsigned char *in,
+                                   size_t len,
+                                   unsigned char *out,
+                                   bool urlSafe)
+{
+    return implementation().base64Encode(in, len, out, urlSafe);
+}
+
+size_t binary_codecs::base64Decode(const char *in,
+                                   size_t len,
+                                   unsigned char *out)
+{
+    return implementation().base64Decode(in, len, out);
+}
+
+size_t binary_codecs::hexEncode(const char *in,
+                                size_t len,
+                                char *out,
+                                bool lowerCase)
+{
+    return implementation().hexEncode(in, len, out, lowerCase);
+}
+
+size_t binary_codecs::hexDecode(const char *in, size_t len, char *out)
+{
+    return implementation().hexDecode(in, len, out);
+}
+
+size_t binary_codecs::urlPlainLength(const char *in, size_t len)
+{
+    return implementation().urlPlainLength(in, len);
+}
+
+const char *binary_codecs::implementationName()
+{
+    return implementation().name;
+}
@@ -0,0 +1,69 @@
+/**
+ *
+ *  @file BinaryCodecs.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <stddef.h>
+
+namespace drogon
+{
+namespace binary_codecs
+{
+/**
+ * The vectorized blocks of the base64 and hex codecs in drogon::utils.
+ *
+ * Each function converts the longest prefix of its input made of whole
+ * blocks (24 or 48 bytes for base64 encoding, 32 or 64 characters for base64
+ * decoding, 16 or 32 bytes for hex), and returns the length of the input it
+ * converted. The callers convert the rest with their scalar loops, so the
+ * results are the same as the ones of the scalar loops. The decoding stops
+ * before the first block which contains a character the fast path doesn't
+ * take (padding, separators, invalid characters), and the implementation is
+ * chosen once at runtime according to the CPU features.
+ */
+
+/// Encode to base64 without padding, out receives 4 characters per 3 bytes
+DROGON_EXPORT size_t base64Encode(const unsigned char *in,
+                                  size_t len,
+                                  unsigned char *out,
+                                  bool urlSafe);
+
+/// Decode base64 in either alphabet, out receives 3 bytes per 4 characters
+DROGON_EXPORT size_t base64Decode(const char *in,
+                                  size_t len,
+                                  unsigned char *out);
+
+/// Encode to hex, out receives 2 characters per byte
+DROGON_EXPORT size_t hexEncode(const char *in,
+                               size_t len,
+                               char *out,
+                               bool lowerCase);
+
+/// Decode hex in either case, out receives 1 byte per 2 characters
+DROGON_EXPORT size_t hexDecode(const char *in, size_t len, char *out);
+
+/**
+ * @brief The length of the prefix of a URL encoded string without '%' or
+ * '+', which decodes to itself. The scan stops at the first escape or at the
+ * last whole block, so the callers check the rest.
+ */
+DROGON_EXPORT size_t urlPlainLength(const char *in, size_t len);
+
+/**
+ * @brief The name of the implementation selected for this CPU, one of
+ * "avx2", "neon" or "scalar".
+ */
+DROGON_EXPORT const char *implementationName();
+}  // namespace binary_codecs
+}  // namespace drogon
@@ -0,0 +1,75 @@
+/**
+ *
+ *  @file BodyMemoryBudget.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "BodyMemoryBudget.h"
+#include "BuiltinMetrics.h"
+
+using namespace drogon;
+
+static void accountBytes(double delta)
+{
+    BuiltinMetrics::instance().memory(
+        BuiltinMetrics::MemoryUser::kRequestBodies, delta);
+}
+
+bool BodyMemoryBudget::tryAcquire(size_t bytes)
+{
+    auto used = used_.load(std::memory_order_relaxed);
+    do
+    {
+        if (bytes > budget_ - used)
+            return false;
+    } while (!used_.compare_exchange_weak(used,
+                                          used + bytes,
+                                          std::memory_order_relaxed));
+    accountBytes(static_cast<double>(bytes));
+    return true;
+}
+
+void BodyMemoryBudget::release(size_t bytes)
+{
+    if (bytes == 0)
+        return;
+    used_.fetch_sub(bytes, std::memory_order_relaxed);
+    accountBytes(-static_cast<double>(bytes));
+    std::vector<Waiter> waiters;
+    {
+        // Taking the lock after releasing the bytes, a waiter registered at
+        // the same time either sees them or is woken up here
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (waiters_.empty())
+            return;
+        waiters.swap(waiters_);
+    }
+    // All the waiters compete for the released memory, those failing wait
+    // again
+    for (auto &waiter : waiters)
+    {
+        waiter.loop->queueInLoop(std::move(waiter.callback));
+    }
+}
+
+void BodyMemoryBudget::waitFor(size_t bytes,
+                               trantor::EventLoop *loop,
+                               std::function<void()> &&callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (bytes > budget_ - used_.load(std::memory_order_relaxed))
+        {
+            waiters_.push_back({loop, std::move(callback)});
+            return;
+        }
+    }
+    loop->queueInLoop(std::move(callback));
+}
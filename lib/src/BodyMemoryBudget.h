@@ -0,0 +1,79 @@
+/**
+ *
+ *  @file BodyMemoryBudget.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <trantor/net/EventLoop.h>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The memory shared by the request bodies kept in memory by all the IO
+ * threads. A body which doesn't get its share is written to a temporary file,
+ * or its connection stops reading until other requests release some memory.
+ */
+class DROGON_EXPORT BodyMemoryBudget
+{
+  public:
+    static BodyMemoryBudget &instance()
+    {
+        static BodyMemoryBudget inst;
+        return inst;
+    }
+
+    // don't set after start, the default is no limit
+    void setBudget(size_t budget)
+    {
+        budget_ = budget;
+    }
+
+    size_t budget() const
+    {
+        return budget_;
+    }
+
+    size_t used() const
+    {
+        return used_.load(std::memory_order_relaxed);
+    }
+
+    bool tryAcquire(size_t bytes);
+    void release(size_t bytes);
+
+    /**
+     * @brief Run the callback in the loop once the bytes may be acquired, which
+     * is checked again by the callback. It is run at once if they already may.
+     */
+    void waitFor(size_t bytes,
+                 trantor::EventLoop *loop,
+                 std::function<void()> &&callback);
+
+  private:
+    struct Waiter
+    {
+        trantor::EventLoop *loop;
+        std::function<void()> callback;
+    };
+
+    size_t budget_{static_cast<size_t>(-1)};
+    std::atomic<size_t> used_{0};
+    std::mutex mutex_;
+    std::vector<Waiter> waiters_;
+};
+}  // namespace drogon
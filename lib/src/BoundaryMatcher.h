@@ -0,0 +1,105 @@
+/**
+ *
+ *  @file BoundaryMatcher.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief The Boyer-Moore-Horspool search of a multipart boundary, whose skip
+ * table is built once for all the chunks of a request.
+ *
+ * The last byte of a window is compared first and a mismatch skips the
+ * window by up to its length, so the body bytes are mostly not visited one by
+ * one. The skips are stored in bytes and capped at 255, which only shortens
+ * them for the boundaries longer than RFC 2046 allows.
+ */
+class BoundaryMatcher
+{
+  public:
+    BoundaryMatcher() = default;
+
+    explicit BoundaryMatcher(std::string_view pattern) : pattern_(pattern)
+    {
+        auto length = pattern_.length();
+        skips_.fill(static_cast<uint8_t>(std::min<size_t>(length, 255)));
+        for (size_t i = 0; i + 1 < length; ++i)
+        {
+            skips_[static_cast<unsigned char>(pattern_[i])] =
+                static_cast<uint8_t>(std::min<size_t>(length - 1 - i, 255));
+        }
+    }
+
+    size_t size() const
+    {
+        return pattern_.length();
+    }
+
+    /// The position of the first match from the offset, npos if none.
+    size_t find(std::string_view text, size_t from = 0) const
+    {
+        auto length = pattern_.length();
+        if (length == 0)
+            return from <= text.length() ? from : std::string_view::npos;
+        auto last = static_cast<unsigned char>(pattern_[length - 1]);
+        auto data = text.data();
+        for (auto pos = from; pos + length <= text.length();)
+        {
+            auto c = static_cast<unsigned char>(data[pos + length - 1]);
+            if (c == last &&
+                memcmp(data + pos, pattern_.data(), length - 1) == 0)
+                return pos;
+            pos += skips_[c];
+        }
+        return std::string_view::npos;
+    }
+
+    /**
+     * @brief The position of the first trailing bytes of the text which are a
+     * prefix of the pattern, the length of the text if none. The bytes before
+     * it can't be part of a match with the next chunks, so they needn't be
+     * scanned again.
+     *
+     * The text must contain no full match.
+     */
+    size_t partialMatch(std::string_view text) const
+    {
+        auto length = pattern_.length();
+        auto pos = text.length() >= length ? text.length() - length + 1 : 0;
+        auto first = pattern_.empty() ? '\0' : pattern_[0];
+        while (pos < text.length())
+        {
+            auto p = static_cast<const char *>(
+                memchr(text.data() + pos, first, text.length() - pos));
+            if (!p)
+                break;
+            pos = p - text.data();
+            if (memcmp(p, pattern_.data(), text.length() - pos) == 0)
+                return pos;
+            ++pos;
+        }
+        return text.length();
+    }
+
+  private:
+    std::string pattern_;
+    std::array<uint8_t, 256> skips_{};
+};
+}  // namespace drogon
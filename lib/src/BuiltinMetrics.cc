@@ -0,0 +1,464 @@
+/**
+ *
+ *  @file BuiltinMetrics.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "BuiltinMetrics.h"
+#include "Allocator.h"
+#include "HttpRequestImpl.h"
+#include <drogon/HttpAppFramework.h>
+#include <unordered_map>
+
+using namespace drogon;
+using namespace drogon::monitoring;
+
+namespace
+{
+const std::vector<std::string> kRouteLabels{"route", "method"};
+
+template <typename T>
+std::shared_ptr<Collector<T>> newCollector(
+    const std::string &name,
+    const std::string &help,
+    const std::vector<std::string> &labels)
+{
+    return std::make_shared<Collector<T>>(name, help, labels);
+}
+
+double secondsBetween(const trantor::Date &from, const trantor::Date &to)
+{
+    return static_cast<double>(to.microSecondsSinceEpoch() -
+                               from.microSecondsSinceEpoch()) /
+           1000000;
+}
+}  // namespace
+
+void BuiltinMetrics::enable(Registry &registry,
+                            const std::vector<double> &latencyBuckets)
+{
+    if (enabled())
+        return;
+    latencyBuckets_ = latencyBuckets;
+    requests_ = newCollector<Counter>("drogon_http_requests_total",
+                                      "The number of HTTP requests",
+                                      {"route", "method", "status"});
+    durations_ = newCollector<Histogram>(
+        "drogon_http_request_duration_seconds",
+        "The time from a request is parsed to its response is sent",
+        kRouteLabels);
+    queueDurations_ = newCollector<Histogram>(
+        "drogon_http_queue_duration_seconds",
+        "The time from a request is parsed to it is passed to its handler",
+        kRouteLabels);
+    handlerDurations_ = newCollector<Histogram>(
+        "drogon_http_handler_duration_seconds",
+        "The time from a request is passed to its handler to its response",
+        kRouteLabels);
+    requestBytes_ =
+        newCollector<Counter>("drogon_http_request_bytes_total",
+                              "The body bytes of the HTTP requests",
+                              kRouteLabels);
+    responseBytes_ =
+        newCollector<Counter>("drogon_http_response_bytes_total",
+                              "The body bytes of the HTTP responses",
+                              kRouteLabels);
+    connections_ =
+        newCollector<Gauge>("drogon_http_active_connections",
+                            "The number of connections of every IO loop",
+                            {"loop"});
+    connectionMemory_ = newCollector<Gauge>(
+        "drogon_http_connection_memory_bytes",
+        "The bytes held by the parsers of the connections of every IO loop",
+        {"loop"});
+    memoryCollector_ = newCollector<Gauge>(
+        "drogon_memory_bytes",
+        "The bytes held by the caches and the request bodies by subsystem",
+        {"subsystem"});
+    redisFastConnections_ = newCollector<Gauge>(
+        "drogon_redis_fast_connections",
+        "The connections of the fast redis clients of every IO loop",
+        {"loop"});
+    poolWaitCollector_ = newCollector<Histogram>(
+        "drogon_pool_wait_seconds",
+        "The time a command waits for a connection of a client pool",
+        {"pool"});
+    dbPoolConnectionCollector_ = newCollector<Gauge>(
+        "drogon_db_pool_connections",
+        "The established connections of the database clients by state",
+        {"state"});
+    statementCacheCollector_ = newCollector<Counter>(
+        "drogon_db_statement_cache_total",
+        "The lookups and evictions of the prepared statements",
+        {"result"});
+    statementDurations_ = newCollector<Summary>(
+        "drogon_db_statement_duration_seconds",
+        "The duration of the queries of every normalized SQL statement",
+        {"statement"});
+    statementRows_ = newCollector<Counter>(
+        "drogon_db_statement_rows_total",
+        "The rows returned by the queries of every normalized SQL statement",
+        {"statement"});
+    statementBytes_ = newCollector<Counter>(
+        "drogon_db_statement_bytes_total",
+        "The bytes returned by the queries of every normalized SQL statement",
+        {"statement"});
+    resultCacheCollector_ = newCollector<Counter>(
+        "drogon_db_result_cache_total",
+        "The lookups and evictions of the cached query results",
+        {"result"});
+    clientRetryCollector_ = newCollector<Counter>(
+        "drogon_http_client_retries_total",
+        "The hedges and retries of the HTTP client pools",
+        {"kind"});
+    loadingCacheCollector_ = newCollector<Counter>(
+        "drogon_loading_cache_total",
+        "The lookups, reloads, evictions and failed loads of the caches",
+        {"cache", "result"});
+    loadingCacheLoads_ =
+        newCollector<Histogram>("drogon_loading_cache_load_seconds",
+                                "The duration of the loads of the caches",
+                                {"cache"});
+    phaseCollector_ = newCollector<Histogram>(
+        "drogon_http_phase_duration_seconds",
+        "The time spent in every phase of the sampled requests",
+        {"phase"});
+    loopLagCollector_ = newCollector<Histogram>(
+        "drogon_loop_lag_seconds",
+        "The delay of the heartbeat timer of every IO loop",
+        {"loop"});
+    loopUtilizationCollector_ = newCollector<Gauge>(
+        "drogon_loop_utilization",
+        "The share of the time the thread of every IO loop is on the CPU",
+        {"loop"});
+    loopStallCollector_ = newCollector<Counter>(
+        "drogon_loop_stalls_total",
+        "The times every IO loop was blocked beyond the stall threshold",
+        {"loop"});
+    allocatorCollector_ = newCollector<Gauge>(
+        "drogon_allocator_bytes",
+        "The bytes reported by the allocator by kind",
+        {"allocator", "kind"});
+
+    auto loop = app().getLoop();
+    for (size_t i = 0; i < app().getThreadNum(); ++i)
+    {
+        loopConnections_.push_back(
+            connections_->metric({std::to_string(i)}).get());
+        loopConnectionMemory_.push_back(
+            connectionMemory_->metric({std::to_string(i)}).get());
+        loopRedisFastConnections_.push_back(
+            redisFastConnections_->metric({std::to_string(i)}).get());
+        loopLags_.push_back(loopLagCollector_
+                                ->metric({std::to_string(i)},
+                                         latencyBuckets_,
+                                         std::chrono::seconds(0),
+                                         0,
+                                         loop)
+                                .get());
+        loopUtilizations_.push_back(
+            loopUtilizationCollector_->metric({std::to_string(i)}).get());
+        loopStalls_.push_back(
+            loopStallCollector_->metric({std::to_string(i)}).get());
+    }
+    poolWaits_[static_cast<size_t>(Pool::kDb)] =
+        poolWaitCollector_
+            ->metric({"db"}, latencyBuckets_, std::chrono::seconds(0), 0, loop)
+            .get();
+    poolWaits_[static_cast<size_t>(Pool::kRedis)] =
+        poolWaitCollector_
+            ->metric(
+                {"redis"}, latencyBuckets_, std::chrono::seconds(0), 0, loop)
+            .get();
+    poolWaits_[static_cast<size_t>(Pool::kRedisFast)] =
+        poolWaitCollector_
+            ->metric({"redis_fast"},
+                     latencyBuckets_,
+                     std::chrono::seconds(0),
+                     0,
+                     loop)
+            .get();
+
+    dbPoolConnections_[static_cast<size_t>(PoolConnectionState::kBusy)] =
+        dbPoolConnectionCollector_->metric({"busy"}).get();
+    dbPoolConnections_[static_cast<size_t>(PoolConnectionState::kIdle)] =
+        dbPoolConnectionCollector_->metric({"idle"}).get();
+
+    const char *memoryUsers[] = {"request_bodies",
+                                 "static_files",
+                                 "compressed_bodies",
+                                 "response_cache",
+                                 "http_client_cache"};
+    for (size_t i = 0; i < memory_.size(); ++i)
+        memory_[i] = memoryCollector_->metric({memoryUsers[i]}).get();
+
+    const char *statementCacheResults[] = {"hit", "miss", "eviction"};
+    for (size_t i = 0; i < statementCacheEvents_.size(); ++i)
+    {
+        statementCacheEvents_[i] =
+            statementCacheCollector_->metric({statementCacheResults[i]}).get();
+        resultCacheEvents_[i] =
+            resultCacheCollector_->metric({statementCacheResults[i]}).get();
+    }
+    const char *clientRetryKinds[] = {"hedge",
+                                      "hedge_won",
+                                      "retry",
+                                      "throttled"};
+    for (size_t i = 0; i < clientRetries_.size(); ++i)
+        clientRetries_[i] =
+            clientRetryCollector_->metric({clientRetryKinds[i]}).get();
+    // The first point starts the phases, it ends none
+    for (size_t i = 1; i < phases_.size(); ++i)
+    {
+        phases_[i] = phaseCollector_
+                         ->metric({RequestPhases::name(
+                                      static_cast<RequestPhase>(i))},
+                                  latencyBuckets_,
+                                  std::chrono::seconds(0),
+                                  0,
+                                  loop)
+                         .get();
+    }
+
+    requests_->registerTo(registry);
+    durations_->registerTo(registry);
+    queueDurations_->registerTo(registry);
+    handlerDurations_->registerTo(registry);
+    requestBytes_->registerTo(registry);
+    responseBytes_->registerTo(registry);
+    connections_->registerTo(registry);
+    connectionMemory_->registerTo(registry);
+    memoryCollector_->registerTo(registry);
+    redisFastConnections_->registerTo(registry);
+    poolWaitCollector_->registerTo(registry);
+    dbPoolConnectionCollector_->registerTo(registry);
+    statementCacheCollector_->registerTo(registry);
+    statementDurations_->registerTo(registry);
+    statementRows_->registerTo(registry);
+    statementBytes_->registerTo(registry);
+    resultCacheCollector_->registerTo(registry);
+    clientRetryCollector_->registerTo(registry);
+    loadingCacheCollector_->registerTo(registry);
+    loadingCacheLoads_->registerTo(registry);
+    phaseCollector_->registerTo(registry);
+    loopLagCollector_->registerTo(registry);
+    loopUtilizationCollector_->registerTo(registry);
+    loopStallCollector_->registerTo(registry);
+
+    // Only the kinds reported by the allocator are exported
+    auto allocatorStats = Allocator::stats();
+    const double *allocatorValues[] = {&allocatorStats.allocated,
+                                       &allocatorStats.active,
+                                       &allocatorStats.resident,
+                                       &allocatorStats.mapped,
+                                       &allocatorStats.retained};
+    const char *allocatorKinds[] = {
+        "allocated", "active", "resident", "mapped", "retained"};
+    std::string allocator(Allocator::name());
+    for (size_t i = 0; i < allocatorBytes_.size(); ++i)
+    {
+        if (*allocatorValues[i] >= 0)
+            allocatorBytes_[i] =
+                allocatorCollector_->metric({allocator, allocatorKinds[i]})
+                    .get();
+    }
+    allocatorCollector_->registerTo(registry);
+    updateAllocator();
+    loop->runEvery(1.0, [this]() { updateAllocator(); });
+    enabled_.store(true, std::memory_order_release);
+}
+
+void BuiltinMetrics::updateAllocator()
+{
+    auto stats = Allocator::stats();
+    const double values[] = {stats.allocated,
+                             stats.active,
+                             stats.resident,
+                             stats.mapped,
+                             stats.retained};
+    for (size_t i = 0; i < allocatorBytes_.size(); ++i)
+    {
+        if (allocatorBytes_[i] && values[i] >= 0)
+            allocatorBytes_[i]->set(values[i]);
+    }
+}
+
+const BuiltinMetrics::StatementMetrics *BuiltinMetrics::statementMetrics(
+    const std::string &statement)
+{
+    if (!enabled())
+        return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = statements_.find(statement);
+    if (iter != statements_.end())
+        return &iter->second;
+    auto &metrics = statements_[statement];
+    metrics.duration = statementDurations_->metric({statement}).get();
+    metrics.rows = statementRows_->metric({statement}).get();
+    metrics.bytes = statementBytes_->metric({statement}).get();
+    return &metrics;
+}
+
+const BuiltinMetrics::LoadingCacheMetrics *
+BuiltinMetrics::loadingCacheMetrics(const std::string &cache)
+{
+    if (!enabled())
+        return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = loadingCaches_.find(cache);
+    if (iter != loadingCaches_.end())
+        return &iter->second;
+    auto &metrics = loadingCaches_[cache];
+    const char *results[] = {"hit", "miss", "refresh", "eviction", "failure"};
+    for (size_t i = 0; i < metrics.events.size(); ++i)
+        metrics.events[i] =
+            loadingCacheCollector_->metric({cache, results[i]}).get();
+    metrics.loadDuration = loadingCacheLoads_
+                               ->metric({cache},
+                                        latencyBuckets_,
+                                        std::chrono::seconds(0),
+                                        0,
+                                        app().getLoop())
+                               .get();
+    return &metrics;
+}
+
+void BuiltinMetrics::updateConnections(trantor::EventLoop *loop, double delta)
+{
+    if (!loop || loop->index() >= loopConnections_.size())
+        return;
+    loopConnections_[loop->index()]->increment(delta);
+}
+
+void BuiltinMetrics::updateRedisFastConnections(trantor::EventLoop *loop,
+                                                double delta)
+{
+    if (!loop || loop->index() >= loopRedisFastConnections_.size())
+        return;
+    loopRedisFastConnections_[loop->index()]->increment(delta);
+}
+
+void BuiltinMetrics::markHandling(const HttpRequestImplPtr &req)
+{
+    req->setHandlingDate(trantor::Date::now());
+}
+
+void BuiltinMetrics::observePhases(const RequestPhases &phases)
+{
+    for (size_t i = 1; i < phases_.size(); ++i)
+    {
+        auto seconds = phases.seconds(static_cast<RequestPhase>(i));
+        if (seconds >= 0)
+            phases_[i]->observe(seconds);
+    }
+}
+
+void BuiltinMetrics::observeResponse(const HttpRequestImplPtr &req,
+                                     const HttpResponsePtr &resp)
+{
+    if (req->method() >= Invalid)
+        return;
+    auto now = trantor::Date::now();
+    auto &metrics = routeMetrics(req);
+    auto statusClass = static_cast<size_t>(resp->statusCode()) / 100;
+    if (statusClass >= 1 && statusClass <= 5)
+        requestsCounter(metrics, statusClass - 1).increment();
+    auto &creationDate = req->creationDate();
+    metrics.duration->observe(secondsBetween(creationDate, now));
+    auto &handlingDate = req->handlingDate();
+    if (handlingDate.microSecondsSinceEpoch() > 0)
+    {
+        metrics.queueDuration->observe(
+            secondsBetween(creationDate, handlingDate));
+        metrics.handlerDuration->observe(secondsBetween(handlingDate, now));
+    }
+    metrics.requestBytes->increment(
+        static_cast<double>(req->realContentLength()));
+    metrics.responseBytes->increment(
+        static_cast<double>(resp->getBody().length()));
+}
+
+BuiltinMetrics::RouteMetrics &BuiltinMetrics::routeMetrics(
+    const HttpRequestImplPtr &req)
+{
+    // The path patterns are views of the keys of the router, so their
+    // addresses identify the routes without comparing the strings.
+    thread_local std::unordered_map<const char *, RouteSlots *> cache;
+    auto pattern = req->matchedPathPattern();
+    RouteSlots *slots;
+    auto iter = cache.find(pattern.data());
+    if (iter != cache.end())
+    {
+        slots = iter->second;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots = &routes_[std::string(pattern)];
+        cache.emplace(pattern.data(), slots);
+    }
+    auto method = req->method();
+    auto metrics = slots->methods[method].load(std::memory_order_acquire);
+    if (metrics)
+        return *metrics;
+    return createRouteMetrics(*slots, pattern, method);
+}
+
+BuiltinMetrics::RouteMetrics &BuiltinMetrics::createRouteMetrics(
+    RouteSlots &slots,
+    std::string_view route,
+    HttpMethod method)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto metrics = slots.methods[method].load(std::memory_order_relaxed);
+    if (metrics)
+        return *metrics;
+    auto newMetrics = std::make_unique<RouteMetrics>();
+    newMetrics->labels = {std::string(route),
+                          std::string(to_string_view(method))};
+    auto &labels = newMetrics->labels;
+    auto loop = app().getLoop();
+    newMetrics->duration =
+        durations_
+            ->metric(labels, latencyBuckets_, std::chrono::seconds(0), 0, loop)
+            .get();
+    newMetrics->queueDuration =
+        queueDurations_
+            ->metric(labels, latencyBuckets_, std::chrono::seconds(0), 0, loop)
+            .get();
+    newMetrics->handlerDuration =
+        handlerDurations_
+            ->metric(labels, latencyBuckets_, std::chrono::seconds(0), 0, loop)
+            .get();
+    newMetrics->requestBytes = requestBytes_->metric(labels).get();
+    newMetrics->responseBytes = responseBytes_->metric(labels).get();
+    metrics = newMetrics.get();
+    routeMetrics_.push_back(std::move(newMetrics));
+    slots.methods[method].store(metrics, std::memory_order_release);
+    return *metrics;
+}
+
+Counter &BuiltinMetrics::requestsCounter(RouteMetrics &metrics,
+                                         size_t statusClass)
+{
+    auto counter =
+        metrics.requests[statusClass].load(std::memory_order_acquire);
+    if (counter)
+        return *counter;
+    std::lock_guard<std::mutex> lock(mutex_);
+    counter = metrics.requests[statusClass].load(std::memory_order_relaxed);
+    if (counter)
+        return *counter;
+    auto labels = metrics.labels;
+    labels.push_back(std::to_string(statusClass + 1) + "xx");
+    counter = requests_->metric(labels).get();
+    metrics.requests[statusClass].store(counter, std::memory_order_release);
+    return *counter;
+}
@@ -0,0 +1,462 @@
+/**
+ *
+ *  @file BuiltinMetrics.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include "RequestPhases.h"
+#include <drogon/HttpTypes.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Gauge.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <drogon/utils/monitoring/Registry.h>
+#include <drogon/utils/monitoring/Summary.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The metrics collected by the framework itself.
+ *
+ * They are disabled (one atomic load per event) until the PromExporter
+ * plugin enables them with the builtin_metrics option, then they are exported
+ * with the user collectors. The HTTP metrics are labelled by the path pattern
+ * of the handler, not the path, so the number of series is bounded by the
+ * number of handlers; the requests without a handler share the empty route.
+ *
+ * - drogon_http_requests_total{route,method,status}: the status is the class
+ *   of the status code, e.g. "2xx".
+ * - drogon_http_request_duration_seconds{route,method}: from the request is
+ *   parsed to its response is sent.
+ * - drogon_http_queue_duration_seconds{route,method}: from the request is
+ *   parsed to it is passed to its handler, i.e. the advices, the
+ *   middlewares and the session loading.
+ * - drogon_http_handler_duration_seconds{route,method}: from the request is
+ *   passed to its handler to the response.
+ * - drogon_http_request_bytes_total, drogon_http_response_bytes_total
+ *   {route,method}: the body bytes, the responses before compression.
+ * - drogon_http_active_connections{loop}: the connections of every IO loop.
+ * - drogon_http_connection_memory_bytes{loop}: the bytes held by the HTTP/1
+ *   parsers of the connections of every IO loop, with the requests being
+ *   parsed and the send buffers, but not the socket buffers. Divided by the
+ *   active connections, it gives the footprint of a connection.
+ * - drogon_memory_bytes{subsystem}: the bytes held by the request bodies in
+ *   memory ("request_bodies"), the static file cache ("static_files"), the
+ *   cache of the compressed bodies ("compressed_bodies"), the ResponseCache
+ *   plugins ("response_cache") and the cache of the HTTP clients
+ *   ("http_client_cache"), as counted for their limits. The sessions and the
+ *   CacheMap objects hold values of unknown sizes and are not included.
+ * - drogon_pool_wait_seconds{pool}: how long a query waits for a free
+ *   connection of a database ("db"), redis ("redis") or fast redis
+ *   ("redis_fast") client.
+ * - drogon_db_pool_connections{state}: the established connections of the
+ *   database clients, running a command ("busy") or not ("idle"), updated
+ *   every second. busy / (busy + idle) is the utilization of the pools.
+ * - drogon_redis_fast_connections{loop}: the established connections of the
+ *   fast redis clients of every IO loop.
+ * - drogon_db_statement_cache_total{result}: the lookups of the prepared
+ *   statements of the PostgreSQL connections ("hit", "miss") and the
+ *   statements deallocated to respect the cache size ("eviction").
+ * - drogon_db_statement_duration_seconds{statement}: the duration of the
+ *   queries of the database clients with statement statistics, labelled by
+ *   the statement with its literals replaced by "?"; the count and the sum
+ *   of the summary give the number of queries and the total time.
+ * - drogon_db_statement_rows_total, drogon_db_statement_bytes_total
+ *   {statement}: the rows and the bytes of the values returned by the
+ *   queries of these statements.
+ * - drogon_db_result_cache_total{result}: the lookups of the results cached
+ *   by the CachedDbClient objects ("hit", "miss") and the results dropped to
+ *   respect the capacity ("eviction").
+ * - drogon_http_client_retries_total{kind}: the duplicates sent by the
+ *   hedging of the HttpClientPool objects ("hedge"), the requests answered
+ *   by their duplicate first ("hedge_won"), the requests sent again after a
+ *   network error ("retry") and the ones not sent because the retry budget
+ *   was exhausted ("throttled").
+ * - drogon_loading_cache_total{cache,result}: the lookups of the
+ *   AsyncLoadingCache objects with a name ("hit", "miss"), their background
+ *   reloads ("refresh"), evictions ("eviction") and failed loads ("failure").
+ * - drogon_loading_cache_load_seconds{cache}: the duration of their loads.
+ * - drogon_http_phase_duration_seconds{phase}: the phases of the requests
+ *   sampled by the phase tracing, see RequestPhase.
+ * - drogon_loop_lag_seconds{loop}: the delay of the heartbeat timer of every
+ *   IO loop, observed when the loop watchdog is started.
+ * - drogon_loop_utilization{loop}: the share of the wall time the thread of
+ *   every IO loop spent on the CPU since the last check (Linux only).
+ * - drogon_loop_stalls_total{loop}: the times every IO loop was blocked for
+ *   longer than the loop_stall_threshold.
+ * - drogon_allocator_bytes{allocator,kind}: the bytes reported by the
+ *   malloc chosen by USE_ALLOCATOR, updated every second. jemalloc reports
+ *   the "allocated", "active", "resident", "mapped" and "retained" bytes,
+ *   mimalloc the "resident" and "mapped" (committed) ones, glibc the
+ *   "allocated" and "mapped" ones.
+ */
+class BuiltinMetrics : public trantor::NonCopyable
+{
+  public:
+    enum class Pool
+    {
+        kDb = 0,
+        kRedis,
+        kRedisFast
+    };
+
+    enum class PoolConnectionState
+    {
+        kBusy = 0,
+        kIdle
+    };
+
+    enum class StatementCacheEvent
+    {
+        kHit = 0,
+        kMiss,
+        kEviction
+    };
+
+    enum class ResultCacheEvent
+    {
+        kHit = 0,
+        kMiss,
+        kEviction
+    };
+
+    enum class ClientRetry
+    {
+        kHedge = 0,
+        kHedgeWon,
+        kRetry,
+        kThrottled
+    };
+
+    enum class MemoryUser
+    {
+        kRequestBodies = 0,
+        kStaticFiles,
+        kCompressedBodies,
+        kResponseCache,
+        kHttpClientCache
+    };
+
+    struct StatementMetrics
+    {
+        monitoring::Summary *duration{nullptr};
+        monitoring::Counter *rows{nullptr};
+        monitoring::Counter *bytes{nullptr};
+    };
+
+    struct LoadingCacheMetrics
+    {
+        std::array<monitoring::Counter *, 5> events{};
+        monitoring::Histogram *loadDuration{nullptr};
+    };
+
+    static BuiltinMetrics &instance()
+    {
+        static BuiltinMetrics inst;
+        return inst;
+    }
+
+    /**
+     * @brief Create the collectors and register them, must be called once
+     * the number of IO threads is known and before the listeners start.
+     */
+    void enable(monitoring::Registry &registry,
+                const std::vector<double> &latencyBuckets);
+
+    bool enabled() const
+    {
+        return enabled_.load(std::memory_order_acquire);
+    }
+
+    void connectionOpened(trantor::EventLoop *loop)
+    {
+        if (enabled())
+            updateConnections(loop, 1);
+    }
+
+    void connectionClosed(trantor::EventLoop *loop)
+    {
+        if (enabled())
+            updateConnections(loop, -1);
+    }
+
+    /// Called when a connection parser takes or releases memory
+    void connectionMemory(trantor::EventLoop *loop, double delta)
+    {
+        if (enabled() && loop->index() < loopConnectionMemory_.size())
+            loopConnectionMemory_[loop->index()]->increment(delta);
+    }
+
+    /// Called when a subsystem takes or releases memory
+    void memory(MemoryUser user, double delta)
+    {
+        if (enabled())
+            memory_[static_cast<size_t>(user)]->increment(delta);
+    }
+
+    /// Called when the request is passed to its handler
+    void requestHandling(const HttpRequestImplPtr &req)
+    {
+        if (enabled())
+            markHandling(req);
+    }
+
+    /// Called when the response of the request is about to be sent
+    void responseSending(const HttpRequestImplPtr &req,
+                         const HttpResponsePtr &resp)
+    {
+        if (enabled())
+            observeResponse(req, resp);
+    }
+
+    /// Called with the phases of a sampled request once they are all done
+    void requestPhases(const RequestPhases &phases)
+    {
+        if (enabled())
+            observePhases(phases);
+    }
+
+    /// Called when a connection of a fast redis client is established
+    void redisFastConnectionOpened(trantor::EventLoop *loop)
+    {
+        if (enabled())
+            updateRedisFastConnections(loop, 1);
+    }
+
+    void redisFastConnectionClosed(trantor::EventLoop *loop)
+    {
+        if (enabled())
+            updateRedisFastConnections(loop, -1);
+    }
+
+    /// Called with the time a command waited for a connection of a pool
+    void poolWaited(Pool pool, double seconds)
+    {
+        if (enabled())
+            poolWaits_[static_cast<size_t>(pool)]->observe(seconds);
+    }
+
+    /// Called with the change of the connections of a database client
+    void dbPoolConnections(PoolConnectionState state, double delta)
+    {
+        if (enabled())
+            dbPoolConnections_[static_cast<size_t>(state)]->increment(delta);
+    }
+
+    void statementCache(StatementCacheEvent event)
+    {
+        if (enabled())
+            statementCacheEvents_[static_cast<size_t>(event)]->increment();
+    }
+
+    /**
+     * @brief The metrics of a normalized SQL statement, created on the first
+     * call, nullptr while the metrics are disabled.
+     */
+    const StatementMetrics *statementMetrics(const std::string &statement);
+
+    /**
+     * @brief The metrics of a named AsyncLoadingCache, created on the first
+     * call, nullptr while the metrics are disabled. The events are indexed
+     * by internal::LoadingCacheStats::Event.
+     */
+    const LoadingCacheMetrics *loadingCacheMetrics(const std::string &cache);
+
+    void resultCache(ResultCacheEvent event)
+    {
+        if (enabled())
+            resultCacheEvents_[static_cast<size_t>(event)]->increment();
+    }
+
+    void clientRetry(ClientRetry kind)
+    {
+        if (enabled())
+            clientRetries_[static_cast<size_t>(kind)]->increment();
+    }
+
+    /// Called by the loop watchdog, the loops are given by their index
+    void loopLag(trantor::EventLoop *loop, double seconds)
+    {
+        if (enabled() && loop->index() < loopLags_.size())
+            loopLags_[loop->index()]->observe(seconds);
+    }
+
+    void loopUtilization(size_t loop, double ratio)
+    {
+        if (enabled() && loop < loopUtilizations_.size())
+            loopUtilizations_[loop]->set(ratio);
+    }
+
+    void loopStalled(size_t loop)
+    {
+        if (enabled() && loop < loopStalls_.size())
+            loopStalls_[loop]->increment();
+    }
+
+  private:
+    BuiltinMetrics() = default;
+
+    struct RouteMetrics
+    {
+        std::vector<std::string> labels;
+        std::array<std::atomic<monitoring::Counter *>, 5> requests{};
+        monitoring::Histogram *duration{nullptr};
+        monitoring::Histogram *queueDuration{nullptr};
+        monitoring::Histogram *handlerDuration{nullptr};
+        monitoring::Counter *requestBytes{nullptr};
+        monitoring::Counter *responseBytes{nullptr};
+    };
+
+    struct RouteSlots
+    {
+        std::array<std::atomic<RouteMetrics *>, Invalid> methods{};
+    };
+
+    void updateConnections(trantor::EventLoop *loop, double delta);
+    void updateAllocator();
+    void updateRedisFastConnections(trantor::EventLoop *loop, double delta);
+    void markHandling(const HttpRequestImplPtr &req);
+    void observeResponse(const HttpRequestImplPtr &req,
+                         const HttpResponsePtr &resp);
+    void observePhases(const RequestPhases &phases);
+    RouteMetrics &routeMetrics(const HttpRequestImplPtr &req);
+    RouteMetrics &createRouteMetrics(RouteSlots &slots,
+                                     std::string_view route,
+                                     HttpMethod method);
+    monitoring::Counter &requestsCounter(RouteMetrics &metrics,
+                                         size_t statusClass);
+
+    std::atomic<bool> enabled_{false};
+    std::vector<double> latencyBuckets_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>> requests_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>> durations_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        queueDurations_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        handlerDurations_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        requestBytes_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        responseBytes_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>> connections_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        poolWaitCollector_;
+    std::vector<monitoring::Gauge *> loopConnections_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>>
+        connectionMemory_;
+    std::vector<monitoring::Gauge *> loopConnectionMemory_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>>
+        memoryCollector_;
+    std::array<monitoring::Gauge *, 5> memory_{};
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>>
+        redisFastConnections_;
+    std::vector<monitoring::Gauge *> loopRedisFastConnections_;
+    std::array<monitoring::Histogram *, 3> poolWaits_{};
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>>
+        dbPoolConnectionCollector_;
+    std::array<monitoring::Gauge *, 2> dbPoolConnections_{};
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        statementCacheCollector_;
+    std::array<monitoring::Counter *, 3> statementCacheEvents_{};
+    std::shared_ptr<monitoring::Collector<monitoring::Summary>>
+        statementDurations_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        statementRows_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        statementBytes_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        resultCacheCollector_;
+    std::array<monitoring::Counter *, 3> resultCacheEvents_{};
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        clientRetryCollector_;
+    std::array<monitoring::Counter *, 4> clientRetries_{};
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        loadingCacheCollector_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        loadingCacheLoads_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        phaseCollector_;
+    std::array<monitoring::Histogram *, RequestPhases::kCount> phases_{};
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        loopLagCollector_;
+    std::vector<monitoring::Histogram *> loopLags_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>>
+        loopUtilizationCollector_;
+    std::vector<monitoring::Gauge *> loopUtilizations_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        loopStallCollector_;
+    std::vector<monitoring::Counter *> loopStalls_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>>
+        allocatorCollector_;
+    std::array<monitoring::Gauge *, 5> allocatorBytes_{};
+
+    // Protects the creation of the route metrics, they are never removed.
+    std::mutex mutex_;
+    std::map<std::string, RouteSlots, std::less<>> routes_;
+    std::vector<std::unique_ptr<RouteMetrics>> routeMetrics_;
+    std::map<std::string, StatementMetrics> statements_;
+    std::map<std::string, LoadingCacheMetrics> loadingCaches_;
+};
+/**
+ * @brief The byte counter of a cache, which reports its changes to the
+ * drogon_memory_bytes gauge of the subsystem.
+ */
+class AccountedBytes
+{
+  public:
+    explicit AccountedBytes(BuiltinMetrics::MemoryUser user) : user_(user)
+    {
+    }
+
+    AccountedBytes &operator+=(size_t bytes)
+    {
+        bytes_ += bytes;
+        BuiltinMetrics::instance().memory(user_, static_cast<double>(bytes));
+        return *this;
+    }
+
+    AccountedBytes &operator-=(size_t bytes)
+    {
+        bytes_ -= bytes;
+        BuiltinMetrics::instance().memory(user_, -static_cast<double>(bytes));
+        return *this;
+    }
+
+    AccountedBytes &operator=(size_t bytes)
+    {
+        BuiltinMetrics::instance().memory(user_,
+                                          static_cast<double>(bytes) -
+                                              static_cast<double>(bytes_));
+        bytes_ = bytes;
+        return *this;
+    }
+
+    operator size_t() const
+    {
+        return bytes_;
+    }
+
+  private:
+    BuiltinMetrics::MemoryUser user_;
+    size_t bytes_{0};
+};
+}  // namespace drogon
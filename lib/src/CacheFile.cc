@@ -14,10 +14,12 @@
 
 #include "CacheFile.h"
 #include <trantor/utils/Logger.h>
+#include <algorithm>
 #ifdef _WIN32
 #include <mman.h>
 #include <drogon/utils/Utilities.h>
 #else
+#include <errno.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #endif
@@ -82,6 +84,98 @@ size_t CacheFile::length()
     return 0;
 }
 
+void CacheFile::flush()
+{
+    if (file_)
+        fflush(file_);
+}
+
+size_t CacheFile::copyRangeTo(size_t offset, size_t length, int fd)
+{
+#ifdef __linux__
+    if (!file_)
+        return 0;
+    fflush(file_);
+    auto in = static_cast<loff_t>(offset);
+    size_t copied = 0;
+    while (copied < length)
+    {
+        auto n = copy_file_range(
+            fileno(file_), &in, fd, nullptr, length - copied, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            // EXDEV, ENOSYS or EINVAL when the kernel or the filesystems
+            // can't copy, the caller writes the rest
+            LOG_TRACE << "copy_file_range stopped at " << copied
+                      << " bytes, errno " << errno;
+            break;
+        }
+        copied += static_cast<size_t>(n);
+    }
+    return copied;
+#else
+    (void)offset;
+    (void)length;
+    (void)fd;
+    return 0;
+#endif
+}
+
+bool CacheFile::readChunks(
+    size_t chunkSize,
+    const std::function<bool(std::string_view)> &callback)
+{
+    if (!file_ || chunkSize == 0)
+        return true;
+    auto passChunks = [chunkSize, &callback](std::string_view window) {
+        while (!window.empty())
+        {
+            auto n = (std::min)(chunkSize, window.length());
+            if (!callback(window.substr(0, n)))
+                return false;
+            window.remove_prefix(n);
+        }
+        return true;
+    };
+    if (data_)
+        return passChunks(std::string_view(data_, dataLength_));
+
+    fflush(file_);
+#ifdef _WIN32
+    auto fd = _fileno(file_);
+#else
+    auto fd = fileno(file_);
+#endif
+    // The offsets of mappings are multiples of the allocation granularity,
+    // which is 64K on Windows
+    constexpr size_t kAlignment = 64 * 1024;
+    const size_t windowSize =
+        (chunkSize + kAlignment - 1) / kAlignment * kAlignment;
+    const size_t fileLength = length();
+    for (size_t offset = 0; offset < fileLength; offset += windowSize)
+    {
+        auto mapLength = (std::min)(windowSize, fileLength - offset);
+        auto window = static_cast<char *>(mmap(nullptr,
+                                               mapLength,
+                                               PROT_READ,
+                                               MAP_SHARED,
+                                               fd,
+                                               offset));
+        if (window == MAP_FAILED)
+        {
+            LOG_SYSERR << "CacheFile mmap:";
+            return false;
+        }
+        bool ok = passChunks(std::string_view(window, mapLength));
+        munmap(window, mapLength);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
 char *CacheFile::data()
 {
     if (!file_)
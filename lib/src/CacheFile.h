@@ -15,6 +15,7 @@
 #pragma once
 
 #include <trantor/utils/NonCopyable.h>
+#include <functional>
 #include <string>
 #include <string_view>
 #include <stdio.h>
@@ -41,9 +42,41 @@ class CacheFile : public trantor::NonCopyable
         return std::string_view();
     }
 
+    /**
+     * @brief Pass the content to the callback in pieces of at most chunkSize
+     * bytes. Unless the whole file is already mapped by getStringView(), only
+     * a window around the current piece is mapped at a time.
+     *
+     * @return false if the callback returns false or the file can't be
+     * mapped.
+     */
+    bool readChunks(size_t chunkSize,
+                    const std::function<bool(std::string_view)> &callback);
+
+    /// Write the buffered data to the file, e.g. before it is sent by path.
+    void flush();
+
+    /**
+     * @brief Copy a range of the file to the current offset of another file
+     * in the kernel (copy_file_range on Linux), without reading it in user
+     * space. The filesystems with reflinks share the blocks of the range
+     * instead of copying them.
+     *
+     * @return The number of bytes copied, less than length if the kernel
+     * can't copy the rest (e.g. across filesystems on old kernels), which
+     * must then be written by the caller. Always 0 on the other systems.
+     */
+    size_t copyRangeTo(size_t offset, size_t length, int fd);
+
+    size_t length();
+
+    const std::string &path() const
+    {
+        return path_;
+    }
+
   private:
     char *data();
-    size_t length();
     FILE *file_{nullptr};
     bool autoDelete_{true};
     const std::string path_;
@@ -0,0 +1,133 @@
+/**
+ *
+ *  @file CompressedBodyCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "CompressedBodyCache.h"
+#include <drogon/HttpAppFramework.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoop.h>
+#include <string.h>
+
+using namespace drogon;
+
+CompressedBodyCache::CompressedBodyCache()
+    : collector_(
+          std::make_shared<monitoring::Collector<monitoring::Counter>>(
+              "drogon_compressed_body_cache_total",
+              "The number of lookups in the compressed body cache",
+              std::vector<std::string>{"result"}))
+{
+    hits_ = collector_->metric({"hit"});
+    misses_ = collector_->metric({"miss"});
+}
+
+void CompressedBodyCache::init(size_t maxBytesPerThread)
+{
+    maxBytesPerThread_ = maxBytesPerThread;
+    if (maxBytesPerThread_ == 0)
+    {
+        caches_.reset();
+        return;
+    }
+    caches_ = std::make_unique<IOThreadStorage<ThreadCache>>();
+}
+
+std::shared_ptr<const std::string> CompressedBodyCache::compressBody(
+    ContentEncoding encoding,
+    const char *data,
+    size_t length)
+{
+    std::string compressed;
+    switch (encoding)
+    {
+        case ContentEncoding::kBrotli:
+            compressed = utils::brotliCompress(data, length);
+            break;
+        case ContentEncoding::kZstd:
+            compressed = utils::zstdCompress(data,
+                                             length,
+                                             app().getZstdCompressionLevel(),
+                                             app().getZstdDictionary());
+            break;
+        default:
+            compressed = utils::gzipCompress(data, length);
+            break;
+    }
+    if (compressed.empty())
+        return nullptr;
+    return std::make_shared<const std::string>(std::move(compressed));
+}
+
+void CompressedBodyCache::evict(ThreadCache &cache, size_t neededBytes)
+{
+    while (!cache.entries.empty() &&
+           cache.bytes + neededBytes > maxBytesPerThread_)
+    {
+        auto &entry = cache.entries.back();
+        cache.bytes -= entry.body.length() + entry.compressed->length();
+        cache.index.erase(entry.key);
+        cache.entries.pop_back();
+    }
+}
+
+std::shared_ptr<const std::string> CompressedBodyCache::compress(
+    ContentEncoding encoding,
+    const char *data,
+    size_t length)
+{
+    // Bodies larger than a quarter of the cache would evict everything else
+    if (!caches_ || length > maxBytesPerThread_ / 4)
+    {
+        return compressBody(encoding, data, length);
+    }
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!loop || loop->index() >= app().getThreadNum())
+    {
+        return compressBody(encoding, data, length);
+    }
+
+    auto &cache = caches_->getThreadData();
+    Key key{std::hash<std::string_view>{}(std::string_view{data, length}),
+            length,
+            encoding};
+    auto iter = cache.index.find(key);
+    if (iter != cache.index.end())
+    {
+        auto entryIter = iter->second;
+        if (memcmp(entryIter->body.data(), data, length) == 0)
+        {
+            hits_->increment();
+            cache.entries.splice(cache.entries.begin(),
+                                 cache.entries,
+                                 entryIter);
+            return entryIter->compressed;
+        }
+        // A hash collision, the new body replaces the old one
+        cache.bytes -=
+            entryIter->body.length() + entryIter->compressed->length();
+        cache.entries.erase(entryIter);
+        cache.index.erase(iter);
+    }
+    misses_->increment();
+
+    auto compressed = compressBody(encoding, data, length);
+    if (!compressed)
+        return compressed;
+    auto entrySize = length + compressed->length();
+    if (entrySize > maxBytesPerThread_)
+        return compressed;
+    evict(cache, entrySize);
+    cache.entries.push_front(Entry{key, std::string(data, length), compressed});
+    cache.index.emplace(key, cache.entries.begin());
+    cache.bytes += entrySize;
+    return compressed;
+}
@@ -0,0 +1,136 @@
+/**
+ *
+ *  @file CompressedBodyCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "BuiltinMetrics.h"
+#include "HttpUtils.h"
+#include <drogon/IOThreadStorage.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief A per IO thread LRU cache of compressed response bodies, keyed by the
+ * hash of the uncompressed body and the encoding.
+ *
+ * Controllers returning the same body over and over get the compressed bytes
+ * of the first compression, instead of compressing the body again for every
+ * response. The cache is disabled unless a size is set with
+ * app().setCompressedBodyCacheSize(). Lookups and insertions only happen on
+ * IO threads, bodies compressed on other threads bypass the cache.
+ *
+ * Hits and misses are counted by the drogon_compressed_body_cache_total
+ * collector, which is registered to the PromExporter plugin if it is loaded.
+ */
+class CompressedBodyCache : public trantor::NonCopyable
+{
+  public:
+    static CompressedBodyCache &instance()
+    {
+        static CompressedBodyCache inst;
+        return inst;
+    }
+
+    /**
+     * @brief Create the caches of the IO threads, must be called once the
+     * number of IO threads is known.
+     *
+     * @param maxBytesPerThread The maximum size of the cached bodies (the
+     * uncompressed and compressed bytes) per IO thread, 0 disables the cache.
+     */
+    void init(size_t maxBytesPerThread);
+
+    bool enabled() const
+    {
+        return static_cast<bool>(caches_);
+    }
+
+    /**
+     * @brief Compress the body, reusing the result of a former compression of
+     * the same bytes if possible.
+     *
+     * @return The compressed body, shared with the cache so that hits do not
+     * copy it, or nullptr if the compression failed.
+     */
+    std::shared_ptr<const std::string> compress(ContentEncoding encoding,
+                                                const char *data,
+                                                size_t length);
+
+    const std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        &collector() const
+    {
+        return collector_;
+    }
+
+  private:
+    CompressedBodyCache();
+
+    struct Key
+    {
+        size_t hash;
+        size_t length;
+        ContentEncoding encoding;
+
+        bool operator==(const Key &other) const
+        {
+            return hash == other.hash && length == other.length &&
+                   encoding == other.encoding;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            return key.hash ^ (static_cast<size_t>(key.encoding) << 1);
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        // The original body, compared on lookup so a hash collision can never
+        // return the compressed bytes of another body
+        std::string body;
+        std::shared_ptr<const std::string> compressed;
+    };
+
+    struct ThreadCache
+    {
+        std::list<Entry> entries;  // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        AccountedBytes bytes{BuiltinMetrics::MemoryUser::kCompressedBodies};
+    };
+
+    static std::shared_ptr<const std::string> compressBody(
+        ContentEncoding encoding,
+        const char *data,
+        size_t length);
+    void evict(ThreadCache &cache, size_t neededBytes);
+
+    size_t maxBytesPerThread_{0};
+    std::unique_ptr<IOThreadStorage<ThreadCache>> caches_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>> collector_;
+    std::shared_ptr<monitoring::Counter> hits_;
+    std::shared_ptr<monitoring::Counter> misses_;
+};
+}  // namespace drogon
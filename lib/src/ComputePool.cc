@@ -0,0 +1,132 @@
+/**
+ *
+ *  @file ComputePool.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ComputePool.h"
+#include <trantor/utils/Logger.h>
+#include <exception>
+
+using namespace drogon;
+
+// The index of the worker running on this thread, or -1
+static thread_local size_t currentWorker = static_cast<size_t>(-1);
+
+ComputePool::~ComputePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stop_ = true;
+    }
+    sleepCond_.notify_all();
+    for (auto &worker : workers_)
+    {
+        if (worker->thread_.joinable())
+            worker->thread_.join();
+    }
+}
+
+void ComputePool::start()
+{
+    auto threadNum = threadNum_;
+    if (threadNum == 0)
+        threadNum = std::thread::hardware_concurrency();
+    if (threadNum == 0)
+        threadNum = 1;
+    workers_.reserve(threadNum);
+    for (size_t i = 0; i < threadNum; ++i)
+        workers_.emplace_back(std::make_unique<Worker>());
+    // The workers may steal from each other once they run
+    for (size_t i = 0; i < threadNum; ++i)
+        workers_[i]->thread_ = std::thread([this, i]() { work(i); });
+}
+
+void ComputePool::run(std::function<void()> &&task)
+{
+    std::call_once(startFlag_, [this]() { start(); });
+    auto index = currentWorker;
+    if (index >= workers_.size())
+        index = nextWorker_.fetch_add(1, std::memory_order_relaxed) %
+                workers_.size();
+    auto &worker = *workers_[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex_);
+        worker.tasks_.emplace_back(std::move(task));
+    }
+    // Paired with the check of pending_ by a worker going to sleep
+    pending_.fetch_add(1);
+    if (sleeping_.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+        }
+        sleepCond_.notify_one();
+    }
+}
+
+bool ComputePool::takeTask(size_t index, std::function<void()> &task)
+{
+    {
+        auto &worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex_);
+        if (!worker.tasks_.empty())
+        {
+            task = std::move(worker.tasks_.back());
+            worker.tasks_.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i)
+    {
+        auto &victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex_);
+        if (!victim.tasks_.empty())
+        {
+            task = std::move(victim.tasks_.front());
+            victim.tasks_.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ComputePool::work(size_t index)
+{
+    currentWorker = index;
+    while (true)
+    {
+        std::function<void()> task;
+        if (takeTask(index, task))
+        {
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            try
+            {
+                task();
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR << "Exception in the compute pool: " << e.what();
+            }
+            catch (...)
+            {
+                LOG_ERROR << "Exception in the compute pool";
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleeping_.fetch_add(1);
+        sleepCond_.wait(lock,
+                        [this]() { return stop_ || pending_.load() > 0; });
+        sleeping_.fetch_sub(1);
+        if (stop_)
+            return;
+    }
+}
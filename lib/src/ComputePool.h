@@ -0,0 +1,85 @@
+/**
+ *
+ *  @file ComputePool.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The threads running the CPU heavy work out of the IO loops. Every
+ * worker has its own queue, the tasks queued by a worker go to its queue and
+ * the others round-robin. An idle worker takes the newest task of its queue or
+ * steals the oldest one of another queue.
+ */
+class DROGON_EXPORT ComputePool
+{
+  public:
+    static ComputePool &instance()
+    {
+        static ComputePool inst;
+        return inst;
+    }
+
+    ~ComputePool();
+
+    // don't set after the first task, 0 (the default) for the number of CPUs
+    void setThreadNum(size_t threadNum)
+    {
+        threadNum_ = threadNum;
+    }
+
+    size_t threadNum() const
+    {
+        return threadNum_;
+    }
+
+    /// Run the task in a worker, the workers are started by the first task.
+    void run(std::function<void()> &&task);
+
+  private:
+    struct Worker
+    {
+        std::mutex mutex_;
+        std::deque<std::function<void()>> tasks_;
+        std::thread thread_;
+    };
+
+    ComputePool() = default;
+
+    void start();
+    void work(size_t index);
+    bool takeTask(size_t index, std::function<void()> &task);
+
+    size_t threadNum_{0};
+    std::once_flag startFlag_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> nextWorker_{0};
+    // The tasks queued and not taken yet
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> sleeping_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCond_;
+    bool stop_{false};
+};
+}  // namespace drogon
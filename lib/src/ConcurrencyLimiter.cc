@@ -0,0 +1,225 @@
+/**
+ *  @file ConcurrencyLimiter.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/ConcurrencyLimiter.h>
+#include <algorithm>
+#include <regex>
+
+using namespace drogon::plugin;
+
+namespace
+{
+const char *const kInFlightKey = "drogon.concurrencyLimiter";
+// The weight of a new sample in the average latency
+constexpr double kLatencyWeight = 0.05;
+}  // namespace
+
+class ConcurrencyLimiter::InFlightRequest
+{
+  public:
+    InFlightRequest(ConcurrencyLimiter *limiter, RouteLimit *route)
+        : limiter_(limiter),
+          route_(route),
+          startTime_(std::chrono::steady_clock::now())
+    {
+    }
+
+    /// Called when the handler produced the response
+    void finish()
+    {
+        if (finished_)
+            return;
+        finished_ = true;
+        auto inFlight =
+            route_->inFlight.fetch_sub(1, std::memory_order_relaxed);
+        limiter_->onCompletion(*route_,
+                               std::chrono::steady_clock::now() - startTime_,
+                               inFlight);
+    }
+
+    /// The request was rejected by another advice or dropped
+    ~InFlightRequest()
+    {
+        if (!finished_)
+            route_->inFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+  private:
+    ConcurrencyLimiter *limiter_;
+    RouteLimit *route_;
+    std::chrono::steady_clock::time_point startTime_;
+    bool finished_{false};
+};
+
+void ConcurrencyLimiter::initAndStart(const Json::Value &config)
+{
+    initialLimit_ = config.get("initial_limit", 20).asUInt64();
+    minLimit_ = (std::max)(static_cast<size_t>(1),
+                           static_cast<size_t>(
+                               config.get("min_limit", 1).asUInt64()));
+    maxLimit_ = (std::max)(minLimit_,
+                           static_cast<size_t>(
+                               config.get("max_limit", 1000).asUInt64()));
+    initialLimit_ = (std::min)((std::max)(initialLimit_, minLimit_), maxLimit_);
+    backoffRatio_ = config.get("backoff_ratio", 0.9).asDouble();
+    if (backoffRatio_ <= 0 || backoffRatio_ >= 1)
+    {
+        throw std::runtime_error(
+            "The backoff_ratio of ConcurrencyLimiter must be in (0, 1)");
+    }
+    latencyThreshold_ =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(
+                config.get("latency_threshold", 0).asDouble()));
+    latencyTolerance_ = config.get("latency_tolerance", 2.0).asDouble();
+    rejectResponse_ = HttpResponse::newHttpResponse();
+    rejectResponse_->setStatusCode(k503ServiceUnavailable);
+    rejectResponse_->setBody(
+        config.get("rejection_message", "Service unavailable").asString());
+
+    std::regex urlsRegex;
+    bool regexFlag{false};
+    if (config.isMember("urls") && config["urls"].isArray())
+    {
+        std::string regexString;
+        for (auto &str : config["urls"])
+        {
+            assert(str.isString());
+            regexString.append("(").append(str.asString()).append(")|");
+        }
+        if (!regexString.empty())
+        {
+            regexString.resize(regexString.length() - 1);
+            urlsRegex = std::regex(regexString);
+            regexFlag = true;
+        }
+    }
+    for (auto &info : app().getHandlersInfo())
+    {
+        auto &path = std::get<0>(info);
+        if (regexFlag && !std::regex_match(path, urlsRegex))
+            continue;
+        auto &route = routes_[path][std::get<1>(info)];
+        route = std::make_unique<RouteLimit>();
+        route->exactLimit = static_cast<double>(initialLimit_);
+        route->limit = initialLimit_;
+    }
+    LOG_TRACE << "ConcurrencyLimiter: " << routes_.size()
+              << " path patterns are limited";
+
+    app().registerPreHandlingAdvice(
+        [this](const HttpRequestPtr &req,
+               AdviceCallback &&adviceCallback,
+               AdviceChainCallback &&chainCallback) {
+            auto route = findLimit(req);
+            if (!route)
+            {
+                chainCallback();
+                return;
+            }
+            auto inFlight =
+                route->inFlight.fetch_add(1, std::memory_order_relaxed);
+            if (inFlight >= route->limit.load(std::memory_order_relaxed))
+            {
+                route->inFlight.fetch_sub(1, std::memory_order_relaxed);
+                adviceCallback(rejectResponse_);
+                return;
+            }
+            req->attributes()->insert(
+                kInFlightKey, std::make_shared<InFlightRequest>(this, route));
+            chainCallback();
+        });
+    app().registerPostHandlingAdvice(
+        [](const HttpRequestPtr &req, const HttpResponsePtr &) {
+            auto &attributes = req->attributes();
+            if (!attributes->find(kInFlightKey))
+                return;
+            auto &inFlightRequest =
+                attributes->get<std::shared_ptr<InFlightRequest>>(
+                    kInFlightKey);
+            if (inFlightRequest)
+                inFlightRequest->finish();
+        });
+}
+
+void ConcurrencyLimiter::shutdown()
+{
+    LOG_TRACE << "ConcurrencyLimiter plugin is shutdown!";
+}
+
+size_t ConcurrencyLimiter::limitOf(const std::string &pathPattern,
+                                   HttpMethod method) const
+{
+    auto iter = routes_.find(pathPattern);
+    if (iter == routes_.end() || method >= Invalid || !iter->second[method])
+        return 0;
+    return iter->second[method]->limit.load(std::memory_order_relaxed);
+}
+
+ConcurrencyLimiter::RouteLimit *ConcurrencyLimiter::findLimit(
+    const HttpRequestPtr &req) const
+{
+    auto iter = routes_.find(req->matchedPathPattern());
+    if (iter == routes_.end())
+        return nullptr;
+    auto method = req->method();
+    if (method >= Invalid)
+        return nullptr;
+    auto &route = iter->second[method];
+    if (!route && method == Head)
+    {
+        // HEAD requests are handled by the GET handlers
+        return iter->second[Get].get();
+    }
+    return route.get();
+}
+
+void ConcurrencyLimiter::onCompletion(
+    RouteLimit &route,
+    std::chrono::steady_clock::duration latency,
+    size_t inFlight)
+{
+    // A sample less changes nothing, don't let the completions wait for each
+    // other.
+    std::unique_lock<std::mutex> lock(route.mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return;
+    auto seconds = std::chrono::duration<double>(latency).count();
+    if (route.averageLatency == 0)
+        route.averageLatency = seconds;
+    bool tooLong =
+        latencyThreshold_.count() > 0
+            ? latency > latencyThreshold_
+            : seconds > route.averageLatency * latencyTolerance_;
+    route.averageLatency += (seconds - route.averageLatency) * kLatencyWeight;
+    if (tooLong)
+    {
+        // The requests sent in the same period are slow for the same reason,
+        // back off once for them.
+        auto now = std::chrono::steady_clock::now();
+        if (now - route.lastBackoff >=
+            std::chrono::duration<double>(route.averageLatency))
+        {
+            route.exactLimit = (std::max)(static_cast<double>(minLimit_),
+                                          route.exactLimit * backoffRatio_);
+            route.lastBackoff = now;
+        }
+    }
+    else if (inFlight * 2 >= route.exactLimit)
+    {
+        // Only grow when the limit is used
+        route.exactLimit = (std::min)(static_cast<double>(maxLimit_),
+                                      route.exactLimit + 1 / route.exactLimit);
+    }
+    route.limit.store(static_cast<size_t>(route.exactLimit),
+                      std::memory_order_relaxed);
+}
@@ -17,6 +17,7 @@
 #include <drogon/config.h>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <thread>
 #include <trantor/utils/Logger.h>
@@ -154,6 +155,28 @@ ConfigLoader::~ConfigLoader()
 {
 }
 
+// An unknown level leaves the level unchanged
+static std::optional<trantor::Logger::LogLevel> readLogLevel(
+    const Json::Value &log)
+{
+    auto logLevel = log.get("log_level", "DEBUG").asString();
+    if (logLevel == "TRACE")
+        return trantor::Logger::kTrace;
+    if (logLevel == "DEBUG")
+        return trantor::Logger::kDebug;
+    if (logLevel == "INFO")
+        return trantor::Logger::kInfo;
+    if (logLevel == "WARN")
+        return trantor::Logger::kWarn;
+    return std::nullopt;
+}
+
+static void loadLogLevel(const Json::Value &log)
+{
+    if (auto logLevel = readLogLevel(log))
+        trantor::Logger::setLogLevel(*logLevel);
+}
+
 static void loadLogSetting(const Json::Value &log)
 {
     if (!log)
@@ -165,23 +188,7 @@ static void loadLogSetting(const Json::Value &log)
     auto maxFiles = log.get("max_files", 0).asUInt();
     HttpAppFrameworkImpl::instance().setLogPath(
         logPath, baseName, logSize, maxFiles, useSpdlog);
-    auto logLevel = log.get("log_level", "DEBUG").asString();
-    if (logLevel == "TRACE")
-    {
-        trantor::Logger::setLogLevel(trantor::Logger::kTrace);
-    }
-    else if (logLevel == "DEBUG")
-    {
-        trantor::Logger::setLogLevel(trantor::Logger::kDebug);
-    }
-    else if (logLevel == "INFO")
-    {
-        trantor::Logger::setLogLevel(trantor::Logger::kInfo);
-    }
-    else if (logLevel == "WARN")
-    {
-        trantor::Logger::setLogLevel(trantor::Logger::kWarn);
-    }
+    loadLogLevel(log);
     auto localTime = log.get("display_local_time", false).asBool();
     trantor::Logger::setDisplayLocalTime(localTime);
 }
@@ -239,10 +246,119 @@ static void loadControllers(const Json::Value &controllers)
                 constraints.push_back(filter.asString());
             }
         }
+        BodyLimit bodyLimit;
+        auto maxBodySize =
+            controller.get("client_max_body_size", "").asString();
+        if (!maxBodySize.empty() &&
+            !bytesSize(maxBodySize, bodyLimit.maxBodySize))
+        {
+            throw std::runtime_error("Error format of client_max_body_size");
+        }
+        auto maxMemoryBodySize =
+            controller.get("client_max_memory_body_size", "").asString();
+        if (!maxMemoryBodySize.empty() &&
+            !bytesSize(maxMemoryBodySize, bodyLimit.maxMemoryBodySize))
+        {
+            throw std::runtime_error(
+                "Error format of client_max_memory_body_size");
+        }
+        if (bodyLimit.maxBodySize != 0 || bodyLimit.maxMemoryBodySize != 0)
+        {
+            constraints.push_back(bodyLimit);
+        }
+        if (controller.get("offload", false).asBool())
+        {
+            constraints.push_back(Offload{});
+        }
         drogon::app().registerHttpSimpleController(path, ctrlName, constraints);
     }
 }
 
+namespace
+{
+// The settings which can be reloaded while the application runs, all read
+// and checked before any is changed
+struct Tunables
+{
+    size_t maxBodySize;
+    size_t maxMemoryBodySize;
+    size_t maxWsMsgSize;
+    bool useGzip;
+    bool useBr;
+    bool useZstd;
+    int zstdLevel;
+    int staticFilesCacheTime;
+    uint64_t kickOffTimeout;
+    double requestDeadline;
+    double headerTimeout;
+    double bodyTimeout;
+    uint64_t minBodyRate;
+    uint64_t keepaliveReqs;
+    uint64_t pipeliningReqs;
+};
+}  // namespace
+
+static Tunables readTunables(const Json::Value &app)
+{
+    Tunables tunables;
+    auto sizeStr = app.get("client_max_body_size", "1M").asString();
+    if (!bytesSize(sizeStr, tunables.maxBodySize))
+    {
+        throw std::runtime_error("Error format of client_max_body_size");
+    }
+    sizeStr = app.get("client_max_memory_body_size", "64K").asString();
+    if (!bytesSize(sizeStr, tunables.maxMemoryBodySize))
+    {
+        throw std::runtime_error("Error format of client_max_memory_body_size");
+    }
+    sizeStr = app.get("client_max_websocket_message_size", "128K").asString();
+    if (!bytesSize(sizeStr, tunables.maxWsMsgSize))
+    {
+        throw std::runtime_error(
+            "Error format of client_max_websocket_message_size");
+    }
+    tunables.useGzip = app.get("use_gzip", true).asBool();
+    tunables.useBr = app.get("use_brotli", false).asBool();
+    tunables.useZstd = app.get("use_zstd", false).asBool();
+    tunables.zstdLevel = app.get("zstd_compression_level", 3).asInt();
+    tunables.staticFilesCacheTime =
+        app.get("static_files_cache_time", 5).asInt();
+    // Kick off idle connections
+    tunables.kickOffTimeout =
+        app.get("idle_connection_timeout", 60).asUInt64();
+    tunables.requestDeadline = app.get("request_deadline", 0.0).asDouble();
+    tunables.headerTimeout = app.get("header_timeout", 0.0).asDouble();
+    tunables.bodyTimeout = app.get("body_timeout", 0.0).asDouble();
+    tunables.minBodyRate = app.get("min_body_rate", 0).asUInt64();
+    tunables.keepaliveReqs = app.get("keepalive_requests", 0).asUInt64();
+    tunables.pipeliningReqs = app.get("pipelining_requests", 0).asUInt64();
+    return tunables;
+}
+
+static void applyTunables(const Tunables &tunables)
+{
+    drogon::app().setClientMaxBodySize(tunables.maxBodySize);
+    drogon::app().setClientMaxMemoryBodySize(tunables.maxMemoryBodySize);
+    drogon::app().setClientMaxWebSocketMessageSize(tunables.maxWsMsgSize);
+    drogon::app().enableGzip(tunables.useGzip);
+    drogon::app().enableBrotli(tunables.useBr);
+    drogon::app().enableZstd(tunables.useZstd);
+    drogon::app().setZstdCompressionLevel(tunables.zstdLevel);
+    drogon::app().setStaticFilesCacheTime(tunables.staticFilesCacheTime);
+    drogon::app().setIdleConnectionTimeout(tunables.kickOffTimeout);
+    drogon::app().setRequestDeadline(tunables.requestDeadline);
+    drogon::app().setSlowClientTimeouts(tunables.headerTimeout,
+                                        tunables.bodyTimeout,
+                                        tunables.minBodyRate);
+    drogon::app().setKeepaliveRequestsNumber(tunables.keepaliveReqs);
+    drogon::app().setPipeliningRequestsNumber(tunables.pipeliningReqs);
+}
+
+static void loadTunables(const Json::Value &app)
+{
+    applyTunables(readTunables(app));
+}
+
 static void loadApp(const Json::Value &app)
 {
     if (!app)
@@ -262,6 +378,45 @@ static void loadApp(const Json::Value &app)
     if (threadsNum < 1)
         threadsNum = 1;
     drogon::app().setThreadNum(threadsNum);
+    auto &affinity = app["io_threads_affinity"];
+    if (!affinity.isNull())
+    {
+        if (!affinity.isArray())
+        {
+            throw std::runtime_error(
+                "io_threads_affinity must be an array of CPU numbers");
+        }
+        std::vector<unsigned int> cpus;
+        for (auto const &cpu : affinity)
+        {
+            if (!cpu.isUInt())
+            {
+                throw std::runtime_error(
+                    "io_threads_affinity must be an array of CPU numbers");
+            }
+            cpus.push_back(cpu.asUInt());
+        }
+        drogon::app().setIoThreadsAffinity(cpus);
+    }
+    auto affinityKey = app.get("loop_affinity_key", "").asString();
+    if (!affinityKey.empty())
+    {
+        if (!LoopAffinity().setKey(affinityKey))
+        {
+            throw std::runtime_error(
+                "loop_affinity_key must be \"ip\", \"header:<name>\" or "
+                "\"cookie:<name>\"");
+        }
+        drogon::app().setLoopAffinityKey(affinityKey);
+    }
+    auto computeThreadsNum = app.get("compute_threads_num", 0).asUInt64();
+    drogon::app().setComputeThreadNum(computeThreadsNum);
+    auto handlerThreadsNum = app.get("handler_threads_num", 0).asUInt64();
+    auto minHandlerThreadsNum =
+        app.get("min_handler_threads_num", 1).asUInt64();
+    drogon::app().setHandlerThreadNum(handlerThreadsNum, minHandlerThreadsNum);
+    auto workerProcesses = app.get("worker_processes", 1).asUInt64();
+    drogon::app().setWorkerProcesses(workerProcesses);
     // session
     auto enableSession = app.get("enable_session", false).asBool();
     if (enableSession)
@@ -274,6 +429,27 @@ static void loadApp(const Json::Value &app)
                                     Cookie::convertString2SameSite(sameSite),
                                     cookieKey,
                                     maxAge);
+        drogon::app().enableSessionCopyOnWrite(
+            app.get("session_copy_on_write", false).asBool());
+        auto redisClient = app.get("session_redis_client", "").asString();
+        if (!redisClient.empty())
+        {
+            auto ttl = app.get("session_near_cache_ttl", 5).asUInt64();
+            drogon::app().setRedisSessionStore(redisClient, ttl);
+        }
+        auto sharedMemoryFile =
+            app.get("session_shared_memory_file", "").asString();
+        if (redisClient.empty() && !sharedMemoryFile.empty())
+        {
+            // Mapped before the worker processes are forked, the sessions
+            // are loaded without a round trip so they are not cached
+            auto map = std::make_shared<SharedMemoryMap>(
+                sharedMemoryFile,
+                app.get("session_shared_memory_capacity", 16384).asUInt64(),
+                4096);
+            drogon::app().setSessionStore(
+                std::make_shared<SharedMemorySessionStore>(std::move(map)), 0);
+        }
     }
     else
         drogon::app().disableSession();
@@ -405,6 +581,14 @@ static void loadApp(const Json::Value &app)
 #endif
     auto stackLimit = app.get("json_parser_stack_limit", 1000).asUInt64();
     drogon::app().setJsonParserStackLimit(stackLimit);
+    auto jsonBackendName = app.get("json_backend", "jsoncpp").asString();
+    auto jsonBackend = JsonBackend::create(jsonBackendName);
+    if (!jsonBackend)
+    {
+        throw std::runtime_error("The JSON backend " + jsonBackendName +
+                                 " is not available in this build");
+    }
+    drogon::app().setJsonBackend(jsonBackend);
     auto unicodeEscaping =
         app.get("enable_unicode_escaping_in_json", true).asBool();
     drogon::app().setUnicodeEscapingInJson(unicodeEscaping);
@@ -431,6 +615,8 @@ static void loadApp(const Json::Value &app)
     {
         drogon::app().disableSigtermHandling();
     }
+    auto reloadOnSighup = app.get("reload_config_on_sighup", false).asBool();
+    drogon::app().enableConfigReloadOnSighup(reloadOnSighup);
     // relaunch
     auto relaunch = app.get("relaunch_on_error", false).asBool();
     if (relaunch)
@@ -439,16 +625,49 @@ static void loadApp(const Json::Value &app)
     }
     auto useSendfile = app.get("use_sendfile", true).asBool();
     drogon::app().enableSendfile(useSendfile);
-    auto useGzip = app.get("use_gzip", true).asBool();
-    drogon::app().enableGzip(useGzip);
-    auto useBr = app.get("use_brotli", false).asBool();
-    drogon::app().enableBrotli(useBr);
-    auto staticFilesCacheTime = app.get("static_files_cache_time", 5).asInt();
-    drogon::app().setStaticFilesCacheTime(staticFilesCacheTime);
+    loadTunables(app);
+    auto zstdDictionaryFile = app.get("zstd_dictionary_file", "").asString();
+    if (!zstdDictionaryFile.empty())
+    {
+        std::ifstream infile(
+            drogon::utils::toNativePath(zstdDictionaryFile).c_str(),
+            std::ifstream::in | std::ifstream::binary);
+        if (!infile)
+        {
+            throw std::runtime_error("Cannot open the zstd dictionary file " +
+                                     zstdDictionaryFile);
+        }
+        std::string dictionary((std::istreambuf_iterator<char>(infile)),
+                               std::istreambuf_iterator<char>());
+        drogon::app().setZstdDictionary(std::move(dictionary));
+    }
     loadControllers(app["simple_controllers_map"]);
-    // Kick off idle connections
-    auto kickOffTimeout = app.get("idle_connection_timeout", 60).asUInt64();
-    drogon::app().setIdleConnectionTimeout(kickOffTimeout);
+    if (!app["early_hints"].empty())
+    {
+        if (!app["early_hints"].isArray())
+        {
+            throw std::runtime_error("The early_hints option must be an array");
+        }
+        for (auto &hints : app["early_hints"])
+        {
+            std::vector<std::string> links;
+            for (auto &link : hints["links"])
+            {
+                links.push_back(link.asString());
+            }
+            drogon::app().addEarlyHints(hints["path"].asString(), links);
+        }
+    }
+    auto phaseSampleRate = app.get("phase_tracing_sample_rate", 0.0).asDouble();
+    auto phaseServerTiming = app.get("phase_server_timing", false).asBool();
+    drogon::app().setPhaseTracing(phaseSampleRate, phaseServerTiming);
+    auto loopStallThreshold = app.get("loop_stall_threshold", 0.0).asDouble();
+    drogon::app().setLoopStallThreshold(loopStallThreshold);
+    auto hotRestartSocket = app.get("hot_restart_socket", "").asString();
+    auto hotRestartDrainTimeout =
+        app.get("hot_restart_drain_timeout", 30.0).asDouble();
+    drogon::app().setHotRestartSocket(hotRestartSocket,
+                                      hotRestartDrainTimeout);
     auto server = app.get("server_header_field", "").asString();
     if (!server.empty())
         drogon::app().setServerHeaderField(server);
@@ -456,46 +675,76 @@ static void loadApp(const Json::Value &app)
     drogon::app().enableServerHeader(sendServerHeader);
     auto sendDateHeader = app.get("enable_date_header", true).asBool();
     drogon::app().enableDateHeader(sendDateHeader);
-    auto keepaliveReqs = app.get("keepalive_requests", 0).asUInt64();
-    drogon::app().setKeepaliveRequestsNumber(keepaliveReqs);
-    auto pipeliningReqs = app.get("pipelining_requests", 0).asUInt64();
-    drogon::app().setPipeliningRequestsNumber(pipeliningReqs);
+    auto dynamicETags = app.get("enable_dynamic_etags", false).asBool();
+    drogon::app().enableDynamicETags(dynamicETags);
     auto useGzipStatic = app.get("gzip_static", true).asBool();
     drogon::app().setGzipStatic(useGzipStatic);
     auto useBrStatic = app.get("br_static", true).asBool();
     drogon::app().setBrStatic(useBrStatic);
-    auto maxBodySize = app.get("client_max_body_size", "1M").asString();
+    auto useStaticFilesCompression =
+        app.get("static_files_compression", false).asBool();
+    if (useStaticFilesCompression)
+    {
+        drogon::app().enableStaticFilesCompression(
+            true, app.get("static_files_compression_path", "").asString());
+    }
     size_t size;
-    if (bytesSize(maxBodySize, size))
+    auto compressedBodyCacheSize =
+        app.get("compressed_body_cache_size", "0").asString();
+    if (bytesSize(compressedBodyCacheSize, size))
     {
-        drogon::app().setClientMaxBodySize(size);
+        drogon::app().setCompressedBodyCacheSize(size);
     }
     else
     {
-        throw std::runtime_error("Error format of client_max_body_size");
+        throw std::runtime_error("Error format of compressed_body_cache_size");
     }
-    auto maxMemoryBodySize =
-        app.get("client_max_memory_body_size", "64K").asString();
-    if (bytesSize(maxMemoryBodySize, size))
+    auto staticFilesCacheSize =
+        app.get("static_files_cache_size", "64M").asString();
+    if (bytesSize(staticFilesCacheSize, size))
     {
-        drogon::app().setClientMaxMemoryBodySize(size);
+        drogon::app().setStaticFilesCacheSize(size);
     }
     else
     {
-        throw std::runtime_error("Error format of client_max_memory_body_size");
+        throw std::runtime_error("Error format of static_files_cache_size");
     }
-    auto maxWsMsgSize =
-        app.get("client_max_websocket_message_size", "128K").asString();
-    if (bytesSize(maxWsMsgSize, size))
+    auto bodyMemoryBudget =
+        app.get("client_body_memory_budget", "").asString();
+    if (bytesSize(bodyMemoryBudget, size))
     {
-        drogon::app().setClientMaxWebSocketMessageSize(size);
+        drogon::app().setClientBodyMemoryBudget(size);
     }
     else
     {
-        throw std::runtime_error(
-            "Error format of client_max_websocket_message_size");
+        throw std::runtime_error("Error format of client_body_memory_budget");
+    }
+    auto &wsCompression = app["websocket_compression"];
+    if (!wsCompression.isNull())
+    {
+        WebSocketCompressionOptions options;
+        options.enabled = wsCompression.get("enabled", false).asBool();
+        options.serverMaxWindowBits = static_cast<uint8_t>(
+            wsCompression.get("server_max_window_bits", 15).asUInt());
+        options.clientMaxWindowBits = static_cast<uint8_t>(
+            wsCompression.get("client_max_window_bits", 15).asUInt());
+        options.serverNoContextTakeover =
+            wsCompression.get("server_no_context_takeover", false).asBool();
+        options.clientNoContextTakeover =
+            wsCompression.get("client_no_context_takeover", false).asBool();
+        auto maxMemory =
+            wsCompression.get("max_memory_per_connection", "320K").asString();
+        if (!bytesSize(maxMemory, options.maxMemoryPerConnection))
+        {
+            throw std::runtime_error("Error format of websocket_compression."
+                                     "max_memory_per_connection");
+        }
+        options.threshold = wsCompression.get("threshold", 256).asUInt64();
+        drogon::app().setWebSocketCompressionOptions(options);
     }
     drogon::app().enableReusePort(app.get("reuse_port", false).asBool());
+    drogon::app().enableHttp2(app.get("enable_http2", false).asBool());
+    drogon::app().enableHttp3(app.get("enable_http3", false).asBool());
     drogon::app().setHomePage(app.get("home_page", "index.html").asString());
     drogon::app().setImplicitPageEnable(
         app.get("use_implicit_page", true).asBool());
@@ -535,6 +784,31 @@ static void loadDbClients(const Json::Value &dbClients)
         return;
     for (auto const &client : dbClients)
     {
+        if (client.isMember("shards"))
+        {
+            auto name = client.get("name", "default").asString();
+            std::vector<std::string> shards;
+            for (auto const &shard : client["shards"])
+                shards.push_back(shard.asString());
+            if (shards.empty())
+            {
+                throw std::runtime_error("The sharded db client " + name +
+                                         " has no shards");
+            }
+            std::map<std::string, std::string> shardMap;
+            auto const &pinned = client["shard_map"];
+            if (pinned.isObject())
+            {
+                for (const auto &key : pinned.getMemberNames())
+                    shardMap[key] = pinned[key].asString();
+            }
+            HttpAppFrameworkImpl::instance().addShardedDbClient(
+                name,
+                shards,
+                shardMap,
+                client.get("virtual_nodes", 160).asUInt64());
+            continue;
+        }
         auto type = client.get("rdbms", "postgresql").asString();
         std::transform(type.begin(),
                        type.end(),
@@ -570,6 +844,38 @@ static void loadDbClients(const Json::Value &dbClients)
         auto connectOptions = client.get("connect_options", Json::Value());
         auto timeout = client.get("timeout", -1.0).asDouble();
         auto autoBatch = client.get("auto_batch", false).asBool();
+        auto loopAffine = client.get("loop_affine", false).asBool();
+        auto binaryResults = client.get("binary_results", false).asBool();
+        auto statementCacheSize =
+            client.get("statement_cache_size", 0).asUInt64();
+        auto warmStatements = client.get("warm_statements", 0).asUInt64();
+        std::vector<orm::ReplicaConfig> replicas;
+        for (auto const &replica : client["replicas"])
+        {
+            replicas.push_back(
+                {replica.get("host", "127.0.0.1").asString(),
+                 static_cast<unsigned short>(
+                     replica.get("port", port).asUInt())});
+        }
+        auto maxReplicaLag = client.get("max_replica_lag", -1.0).asDouble();
+        auto walPool = client.get("wal_pool", false).asBool();
+        auto batchWrites = client.get("batch_writes", false).asBool();
+        auto preparedStatements =
+            client.get("prepared_statements", false).asBool();
+        orm::PoolConfig pool;
+        pool.maxConnectionNumber =
+            client.get("max_number_of_connections", 0).asUInt64();
+        pool.idleTimeout =
+            client.get("idle_timeout", pool.idleTimeout).asDouble();
+        pool.healthCheckInterval =
+            client.get("health_check_interval", 0.0).asDouble();
+        pool.maxLifetime = client.get("max_lifetime", 0.0).asDouble();
+        orm::QueryStatsConfig queryStats;
+        queryStats.enabled = client.get("statement_stats", false).asBool();
+        queryStats.slowQueryThreshold =
+            client.get("slow_query_threshold", 0.0).asDouble();
+        queryStats.explainSlowQueries =
+            client.get("explain_slow_queries", false).asBool();
 
         std::unordered_map<std::string, std::string> options;
         if (connectOptions.isObject() && !connectOptions.empty())
@@ -593,7 +899,18 @@ static void loadDbClients(const Json::Value &dbClients)
                                                      characterSet,
                                                      timeout,
                                                      autoBatch,
-                                                     std::move(options));
+                                                     std::move(options),
+                                                     loopAffine,
+                                                     binaryResults,
+                                                     statementCacheSize,
+                                                     warmStatements,
+                                                     std::move(replicas),
+                                                     maxReplicaLag,
+                                                     walPool,
+                                                     batchWrites,
+                                                     preparedStatements,
+                                                     pool,
+                                                     queryStats);
     }
 }
 
@@ -626,6 +943,10 @@ static void loadRedisClients(const Json::Value &redisClients)
         auto isFast = client.get("is_fast", false).asBool();
         auto timeout = client.get("timeout", -1.0).asDouble();
         auto db = client.get("db", 0).asUInt();
+        auto cluster = client.get("cluster", false).asBool();
+        auto fastConnNum = client.get("fast_connection_number", 0).asUInt();
+        auto sentinelMaster = client.get("sentinel_master", "").asString();
+        auto replicaReads = client.get("replica_reads", false).asBool();
         auto hostIp = future.get();
         drogon::app().createRedisClient(hostIp,
                                         port,
@@ -635,7 +956,11 @@ static void loadRedisClients(const Json::Value &redisClients)
                                         isFast,
                                         timeout,
                                         db,
-                                        username);
+                                        username,
+                                        cluster,
+                                        fastConnNum,
+                                        sentinelMaster,
+                                        replicaReads);
     }
 }
 
@@ -652,6 +977,24 @@ static void loadListeners(const Json::Value &listeners)
         auto cert = listener.get("cert", "").asString();
         auto key = listener.get("key", "").asString();
         auto useOldTLS = listener.get("use_old_tls", false).asBool();
+        auto proxyProtocol = listener.get("proxy_protocol", false).asBool();
+        ListenerSocketOptions socketOptions;
+        if (listener.isMember("socket_options"))
+        {
+            auto &options = listener["socket_options"];
+            socketOptions.deferAccept = options.get("defer_accept", 0).asInt();
+            socketOptions.fastOpenQueueLength =
+                options.get("fast_open", 0).asInt();
+            socketOptions.busyPoll = options.get("busy_poll", 0).asInt();
+            socketOptions.sendBufferSize =
+                options.get("send_buffer", 0).asInt();
+            socketOptions.receiveBufferSize =
+                options.get("receive_buffer", 0).asInt();
+            socketOptions.notSentLowat =
+                options.get("not_sent_lowat", 0).asInt();
+            socketOptions.tcpNoDelay =
+                options.get("tcp_nodelay", false).asBool();
+        }
         std::vector<std::pair<std::string, std::string>> sslConfCmds;
         if (listener.isMember("ssl_conf"))
         {
@@ -668,8 +1011,15 @@ static void loadListeners(const Json::Value &listeners)
             }
         }
         LOG_TRACE << "Add listener:" << addr << ":" << port;
-        drogon::app().addListener(
-            addr, port, useSSL, cert, key, useOldTLS, sslConfCmds);
+        drogon::app().addListener(addr,
+                                  port,
+                                  useSSL,
+                                  cert,
+                                  key,
+                                  useOldTLS,
+                                  sslConfCmds,
+                                  proxyProtocol,
+                                  socketOptions);
     }
 }
 
@@ -696,6 +1046,8 @@ static void loadSSL(const Json::Value &sslConf)
         }
     }
     drogon::app().setSSLConfigCommands(sslConfCmds);
+    drogon::app().setSSLReloadInterval(
+        sslConf.get("reload_interval", 0).asDouble());
 }
 
 void ConfigLoader::load()
@@ -707,3 +1059,43 @@ void ConfigLoader::load()
     loadDbClients(configJsonRoot_["db_clients"]);
     loadRedisClients(configJsonRoot_["redis_clients"]);
 }
+
+void ConfigLoader::reload()
+{
+    // Every value is read before any setting changes, so an invalid one
+    // leaves them all unchanged
+    auto &app = configJsonRoot_["app"];
+    std::optional<Tunables> tunables;
+    std::optional<trantor::Logger::LogLevel> logLevel;
+    if (app)
+    {
+        tunables = readTunables(app);
+        if (app["log"])
+            logLevel = readLogLevel(app["log"]);
+    }
+    // A plugin rejecting its configuration throws, the plugins reloaded
+    // before it get their previous configuration back
+    std::vector<std::pair<PluginBase *, Json::Value>> reloaded;
+    try
+    {
+        for (auto &plugin : configJsonRoot_["plugins"])
+        {
+            auto name = plugin.get("name", "").asString();
+            if (auto pluginPtr = drogon::app().getPlugin(name))
+            {
+                reloaded.emplace_back(pluginPtr, pluginPtr->config_);
+                pluginPtr->reload(plugin["config"]);
+            }
+        }
+    }
+    catch (...)
+    {
+        for (auto iter = reloaded.rbegin(); iter != reloaded.rend(); ++iter)
+            iter->first->reload(iter->second);
+        throw;
+    }
+    if (tunables)
+        applyTunables(*tunables);
+    if (logLevel)
+        trantor::Logger::setLogLevel(*logLevel);
+}
@@ -35,6 +35,10 @@ class ConfigLoader : public trantor::NonCopyable
 
     void load() noexcept(false);
 
+    /// Apply the settings which can change while the application runs, in
+    /// the main loop
+    void reload() noexcept(false);
+
   private:
     std::string configFile_;
     Json::Value configJsonRoot_;
@@ -18,13 +18,13 @@
 #include <vector>
 #include <memory>
 #include <drogon/IOThreadStorage.h>
+#include <drogon/utils/HttpConstraint.h>
 #include <drogon/HttpResponse.h>
 #include "HttpRequestImpl.h"
+#include "MiddlewaresFunction.h"
 
 namespace drogon
 {
-class HttpMiddlewareBase;
-
 /**
  * @brief A component to associate router class and controller class
  */
@@ -32,10 +32,16 @@ struct ControllerBinderBase
 {
     std::string handlerName_;
     std::vector<std::string> middlewareNames_;
-    std::vector<std::shared_ptr<HttpMiddlewareBase>> middlewares_;
+    middlewares_function::MiddlewareChain middlewares_;
     IOThreadStorage<HttpResponsePtr> responseCache_;
     std::shared_ptr<std::string> corsMethods_;
+    BodyLimit bodyLimit_;
+    // Run the handler in the compute pool
+    bool offload_{false};
     bool isCORS_{false};
+    // Neither advices nor middlewares run between the routing and the
+    // handler, composed with the middlewares when the routes are initialized
+    bool passThrough_{false};
 
     virtual ~ControllerBinderBase() = default;
     virtual void handleRequest(
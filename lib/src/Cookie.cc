@@ -15,73 +15,99 @@
 #include <drogon/Cookie.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <charconv>
 using namespace drogon;
 
-std::string Cookie::cookieString() const
+namespace
 {
-    constexpr std::string_view prefix = "Set-Cookie: ";
-    std::string ret;
-    // reserve space to reduce frequency allocation
-    ret.reserve(prefix.size() + key_.size() + value_.size() + 30);
-    ret = prefix;
-    ret.append(key_).append("=").append(value_).append("; ");
-    if (expiresDate_.microSecondsSinceEpoch() !=
+// Write the Set-Cookie line with out.append(const char *, size_t), both
+// std::string and trantor::MsgBuffer have it
+template <typename Output>
+void writeCookieString(const Cookie &cookie, Output &out)
+{
+    auto &expiresDate = cookie.expiresDate();
+    auto maxAge = cookie.maxAge();
+    auto sameSite = cookie.sameSite();
+    auto append = [&out](std::string_view str) {
+        out.append(str.data(), str.length());
+    };
+    append("Set-Cookie: ");
+    append(cookie.key());
+    append("=");
+    append(cookie.value());
+    if (expiresDate.microSecondsSinceEpoch() !=
             (std::numeric_limits<int64_t>::max)() &&
-        expiresDate_.microSecondsSinceEpoch() >= 0)
+        expiresDate.microSecondsSinceEpoch() >= 0)
     {
-        ret.append("Expires=")
-            .append(utils::getHttpFullDateStr(expiresDate_))
-            .append("; ");
+        append("; Expires=");
+        append(utils::getHttpFullDate(expiresDate));
     }
-    if (maxAge_.has_value())
+    if (maxAge.has_value())
     {
-        ret.append("Max-Age=")
-            .append(std::to_string(maxAge_.value()))
-            .append("; ");
+        char buf[16];
+        auto result = std::to_chars(buf, buf + sizeof(buf), maxAge.value());
+        append("; Max-Age=");
+        append(std::string_view(buf, result.ptr - buf));
     }
-    if (!domain_.empty())
+    if (!cookie.domain().empty())
     {
-        ret.append("Domain=").append(domain_).append("; ");
+        append("; Domain=");
+        append(cookie.domain());
     }
-    if (!path_.empty())
+    if (!cookie.path().empty())
     {
-        ret.append("Path=").append(path_).append("; ");
+        append("; Path=");
+        append(cookie.path());
     }
-    if (sameSite_ != SameSite::kNull)
+    if (sameSite != Cookie::SameSite::kNull)
     {
-        switch (sameSite_)
+        switch (sameSite)
         {
-            case SameSite::kLax:
-                ret.append("SameSite=Lax; ");
+            case Cookie::SameSite::kLax:
+                append("; SameSite=Lax");
                 break;
-            case SameSite::kStrict:
-                ret.append("SameSite=Strict; ");
+            case Cookie::SameSite::kStrict:
+                append("; SameSite=Strict");
                 break;
-            case SameSite::kNone:
-                ret.append("SameSite=None; ");
+            case Cookie::SameSite::kNone:
+                append("; SameSite=None");
                 // Cookies with SameSite=None must now also specify the Secure
                 // attribute (they require a secure context/HTTPS).
-                ret.append("Secure; ");
+                append("; Secure");
                 break;
             default:
                 // Lax replaced None as the default value to ensure that users
                 // have reasonably robust defense against some CSRF attacks
-                ret.append("SameSite=Lax; ");
+                append("; SameSite=Lax");
         }
     }
-    if ((secure_ && sameSite_ != SameSite::kNone) || partitioned_)
+    if ((cookie.isSecure() && sameSite != Cookie::SameSite::kNone) ||
+        cookie.isPartitioned())
     {
-        ret.append("Secure; ");
+        append("; Secure");
     }
-    if (httpOnly_)
+    if (cookie.isHttpOnly())
     {
-        ret.append("HttpOnly; ");
+        append("; HttpOnly");
     }
-    if (partitioned_)
+    if (cookie.isPartitioned())
     {
-        ret.append("Partitioned; ");
+        append("; Partitioned");
     }
-    ret.resize(ret.length() - 2);  // delete last semicolon
-    ret.append("\r\n");
+    append("\r\n");
+}
+}  // namespace
+
+std::string Cookie::cookieString() const
+{
+    std::string ret;
+    // reserve space to reduce frequency allocation
+    ret.reserve(key_.size() + value_.size() + 42);
+    writeCookieString(*this, ret);
     return ret;
 }
+
+void Cookie::appendCookieString(trantor::MsgBuffer &buffer) const
+{
+    writeCookieString(*this, buffer);
+}
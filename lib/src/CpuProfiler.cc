@@ -0,0 +1,332 @@
+/**
+ *
+ *  @file CpuProfiler.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "CpuProfiler.h"
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#ifdef __linux__
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+using namespace drogon;
+
+thread_local ProfilerTags CpuProfiler::tags_ DROGON_PROFILER_TLS;
+
+namespace
+{
+// The wire format of the protocol buffers of profile.proto
+void putVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putUint(std::string &out, int field, uint64_t value)
+{
+    putVarint(out, static_cast<uint64_t>(field) << 3);
+    putVarint(out, value);
+}
+
+void putBytes(std::string &out, int field, std::string_view bytes)
+{
+    putVarint(out, (static_cast<uint64_t>(field) << 3) | 2);
+    putVarint(out, bytes.length());
+    out.append(bytes.data(), bytes.length());
+}
+
+class StringTable
+{
+  public:
+    StringTable()
+    {
+        index("");
+    }
+
+    uint64_t index(const std::string &str)
+    {
+        auto it = indexes_.find(str);
+        if (it != indexes_.end())
+            return it->second;
+        strings_.push_back(str);
+        return indexes_[str] = strings_.size() - 1;
+    }
+
+    const std::vector<std::string> &strings() const
+    {
+        return strings_;
+    }
+
+  private:
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint64_t> indexes_;
+};
+
+std::string valueType(StringTable &strings,
+                      const std::string &type,
+                      const std::string &unit)
+{
+    std::string message;
+    putUint(message, 1, strings.index(type));
+    putUint(message, 2, strings.index(unit));
+    return message;
+}
+
+#ifdef __linux__
+// The name of the function of a code address, demangled if possible
+std::string symbolize(void *address)
+{
+    Dl_info info;
+    if (dladdr(address, &info) == 0 || !info.dli_fname)
+        return utils::formattedString("%p", address);
+    if (!info.dli_sname)
+    {
+        auto base = reinterpret_cast<uintptr_t>(info.dli_fbase);
+        return utils::formattedString(
+            "%s+0x%zx",
+            info.dli_fname,
+            static_cast<size_t>(reinterpret_cast<uintptr_t>(address) - base));
+    }
+    int status;
+    auto demangled =
+        abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    if (status != 0 || !demangled)
+        return info.dli_sname;
+    std::string name(demangled);
+    free(demangled);
+    return name;
+}
+#endif
+}  // namespace
+
+#ifdef __linux__
+void CpuProfiler::onSignal(int)
+{
+    auto &profiler = instance();
+    profiler.writers_.fetch_add(1, std::memory_order_acquire);
+    if (profiler.active_.load(std::memory_order_acquire))
+    {
+        auto index = profiler.next_.fetch_add(1, std::memory_order_relaxed);
+        if (index < profiler.capacity_)
+        {
+            auto savedErrno = errno;
+            auto &sample = profiler.samples_[index];
+            sample.depth = backtrace(sample.frames, kMaxFrames);
+            sample.tags = tags_;
+            errno = savedErrno;
+        }
+    }
+    profiler.writers_.fetch_sub(1, std::memory_order_release);
+}
+#endif
+
+bool CpuProfiler::start(int frequency, size_t maxSamples)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frequency <= 0 || maxSamples == 0 || active())
+        return false;
+    // Not owned by a signal handler any more
+    while (writers_.load(std::memory_order_acquire) != 0)
+        ;
+    samples_.reset(new Sample[maxSamples]);
+    capacity_ = maxSamples;
+    next_.store(0, std::memory_order_relaxed);
+    period_ = 1000000000 / frequency;
+    startTime_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+
+    static bool installed = false;
+    if (!installed)
+    {
+        // backtrace() loads libgcc on its first call, which isn't safe in the
+        // signal handler
+        void *frame;
+        backtrace(&frame, 1);
+        // The handler stays installed, the default action of the signals
+        // delivered after the timer is stopped would kill the process
+        struct sigaction action = {};
+        action.sa_handler = onSignal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0)
+            return false;
+        installed = true;
+    }
+    active_.store(true, std::memory_order_release);
+
+    itimerval timer = {};
+    timer.it_interval.tv_sec = period_ / 1000000000;
+    timer.it_interval.tv_usec = (period_ % 1000000000) / 1000;
+    if (timer.it_interval.tv_sec == 0 && timer.it_interval.tv_usec == 0)
+        timer.it_interval.tv_usec = 1;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+        active_.store(false, std::memory_order_release);
+        return false;
+    }
+    return true;
+#else
+    (void)frequency;
+    (void)maxSamples;
+    return false;
+#endif
+}
+
+std::string CpuProfiler::stop()
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active())
+        return {};
+    itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    active_.store(false, std::memory_order_release);
+    // The handlers which saw the profile active finish their sample
+    while (writers_.load(std::memory_order_acquire) != 0)
+        ;
+    auto profile = encode(sampleCount());
+    samples_.reset();
+    return utils::gzipCompress(profile.data(), profile.length());
+#else
+    return {};
+#endif
+}
+
+size_t CpuProfiler::sampleCount() const
+{
+    return (std::min)(next_.load(std::memory_order_relaxed), capacity_);
+}
+
+std::string CpuProfiler::encode(size_t count) const
+{
+    // The identical samples are merged
+    using Key = std::tuple<std::vector<void *>, int32_t, std::string>;
+    std::map<Key, int64_t> counts;
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto &sample = samples_[i];
+        // The first frames are the signal handler
+        if (sample.depth <= 2)
+            continue;
+        Key key{std::vector<void *>(sample.frames + 2,
+                                    sample.frames + sample.depth),
+                sample.tags.loop,
+                sample.tags.route ? std::string(sample.tags.route,
+                                                sample.tags.routeLength)
+                                  : std::string()};
+        ++counts[std::move(key)];
+    }
+
+    StringTable strings;
+    std::string profile;
+    putBytes(profile, 1, valueType(strings, "samples", "count"));
+    putBytes(profile, 1, valueType(strings, "cpu", "nanoseconds"));
+
+    std::unordered_map<void *, uint64_t> locations;
+    std::unordered_map<std::string, uint64_t> functions;
+    std::string locationMessages;
+    std::string functionMessages;
+    auto locationId = [&](void *address, bool leaf) -> uint64_t {
+        auto it = locations.find(address);
+        if (it != locations.end())
+            return it->second;
+        // The return addresses are past the calls
+        auto pc = leaf ? address : static_cast<char *>(address) - 1;
+#ifdef __linux__
+        auto name = symbolize(pc);
+#else
+        auto name = utils::formattedString("%p", pc);
+#endif
+        auto &functionId = functions[name];
+        if (functionId == 0)
+        {
+            functionId = functions.size();
+            std::string function;
+            putUint(function, 1, functionId);
+            putUint(function, 2, strings.index(name));
+            putUint(function, 3, strings.index(name));
+            putBytes(functionMessages, 5, function);
+        }
+        auto id = locations.size() + 1;
+        locations[address] = id;
+        std::string line;
+        putUint(line, 1, functionId);
+        std::string location;
+        putUint(location, 1, id);
+        putUint(location, 3, reinterpret_cast<uintptr_t>(pc));
+        putBytes(location, 4, line);
+        putBytes(locationMessages, 4, location);
+        return id;
+    };
+
+    auto loopKey = strings.index("loop");
+    auto routeKey = strings.index("route");
+    for (auto &[key, samples] : counts)
+    {
+        auto &[frames, loop, route] = key;
+        std::string ids;
+        for (size_t i = 0; i < frames.size(); ++i)
+            putVarint(ids, locationId(frames[i], i == 0));
+        std::string values;
+        putVarint(values, static_cast<uint64_t>(samples));
+        putVarint(values, static_cast<uint64_t>(samples * period_));
+        std::string sample;
+        putBytes(sample, 1, ids);
+        putBytes(sample, 2, values);
+        if (loop >= 0)
+        {
+            std::string label;
+            putUint(label, 1, loopKey);
+            putUint(label, 3, static_cast<uint64_t>(loop));
+            putBytes(sample, 3, label);
+        }
+        if (!route.empty())
+        {
+            std::string label;
+            putUint(label, 1, routeKey);
+            putUint(label, 2, strings.index(route));
+            putBytes(sample, 3, label);
+        }
+        putBytes(profile, 2, sample);
+    }
+    profile.append(locationMessages).append(functionMessages);
+
+    auto periodType = valueType(strings, "cpu", "nanoseconds");
+    for (auto &str : strings.strings())
+        putBytes(profile, 6, str);
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count();
+    putUint(profile, 9, static_cast<uint64_t>(startTime_));
+    putUint(profile, 10, static_cast<uint64_t>(now - startTime_));
+    putBytes(profile, 11, periodType);
+    putUint(profile, 12, static_cast<uint64_t>(period_));
+    return profile;
+}
@@ -0,0 +1,149 @@
+/**
+ *
+ *  @file CpuProfiler.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#if defined(__linux__) && defined(__GNUC__)
+// Static TLS, which the signal handler can read without allocating it
+#define DROGON_PROFILER_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define DROGON_PROFILER_TLS
+#endif
+
+namespace drogon
+{
+/**
+ * @brief The tags of the samples taken on a thread: the IO loop it runs and
+ * the route of the handler it is in.
+ */
+struct ProfilerTags
+{
+    int32_t loop{-1};
+    const char *route{nullptr};
+    uint32_t routeLength{0};
+};
+
+/**
+ * @brief A sampling CPU profiler, one profile at a time.
+ *
+ * On Linux, a SIGPROF timer interrupts the threads every period of CPU time
+ * they use, and the signal handler copies the stack and the tags of the
+ * interrupted thread in a buffer allocated when the profile starts. The
+ * profile is symbolized and encoded in the pprof format once it is stopped.
+ * When no profile runs, the only cost is the check of the route scopes.
+ */
+class CpuProfiler : public trantor::NonCopyable
+{
+  public:
+    static CpuProfiler &instance()
+    {
+        static CpuProfiler inst;
+        return inst;
+    }
+
+    /**
+     * @brief Start a profile.
+     *
+     * @param frequency The samples per second of CPU time.
+     * @param maxSamples The samples beyond it are dropped.
+     * @return false if a profile is already running or the platform has no
+     * profiler.
+     */
+    bool start(int frequency, size_t maxSamples);
+
+    /// Stop the profile and return it in the gzipped pprof format
+    std::string stop();
+
+    bool active() const
+    {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+    /// The samples of the running or last profile
+    size_t sampleCount() const;
+
+    /// Set the loop tag of the current thread
+    static void setLoop(int32_t index)
+    {
+        tags_.loop = index;
+    }
+
+    /// Tags the samples taken while the route handler runs on the thread
+    class RouteScope
+    {
+      public:
+        explicit RouteScope(std::string_view route)
+        {
+            if (CpuProfiler::instance().active())
+            {
+                saved_ = tags_;
+                tags_.routeLength = static_cast<uint32_t>(route.length());
+                tags_.route = route.data();
+                set_ = true;
+            }
+        }
+
+        ~RouteScope()
+        {
+            if (set_)
+            {
+                tags_.route = saved_.route;
+                tags_.routeLength = saved_.routeLength;
+            }
+        }
+
+        RouteScope(const RouteScope &) = delete;
+        RouteScope &operator=(const RouteScope &) = delete;
+
+      private:
+        ProfilerTags saved_;
+        bool set_{false};
+    };
+
+  private:
+    CpuProfiler() = default;
+
+    static constexpr int kMaxFrames = 64;
+
+    struct Sample
+    {
+        void *frames[kMaxFrames];
+        int depth;
+        ProfilerTags tags;
+    };
+
+    static void onSignal(int);
+    std::string encode(size_t count) const;
+
+    static thread_local ProfilerTags tags_ DROGON_PROFILER_TLS;
+
+    // Serializes the starts and the stops
+    std::mutex mutex_;
+    std::atomic<bool> active_{false};
+    // The signal handlers which may be writing a sample
+    std::atomic<int> writers_{0};
+    std::unique_ptr<Sample[]> samples_;
+    size_t capacity_{0};
+    std::atomic<size_t> next_{0};
+    int64_t period_{0};
+    int64_t startTime_{0};
+};
+}  // namespace drogon
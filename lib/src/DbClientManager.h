@@ -16,12 +16,16 @@
 
 #include <drogon/orm/DbClient.h>
 #include <drogon/orm/DbConfig.h>
+#include <drogon/orm/ShardedDbClient.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/IOThreadStorage.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoop.h>
 #include <string>
+#include <map>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 namespace drogon
 {
@@ -40,26 +44,68 @@ class DbClientManager : public trantor::NonCopyable
 
     ~DbClientManager();
 
+    /// The shared clients by name, the fast ones are not included
+    const std::map<std::string, DbClientPtr> &dbClients() const
+    {
+        return dbClientsMap_;
+    }
+
     DbClientPtr getFastDbClient(const std::string &name)
     {
         auto iter = dbFastClientsMap_.find(name);
         assert(iter != dbFastClientsMap_.end());
+        // The fast clients are bound to the IO loops and the main loop, the
+        // handler loops and the other threads have none
+        if (app().getCurrentThreadIndex() > app().getThreadNum())
+        {
+            throw std::runtime_error(
+                "The fast database client '" + name +
+                "' can only be used in the IO loops and the main loop");
+        }
         return iter->second.getThreadData();
     }
 
+    ShardedDbClientPtr getShardedDbClient(const std::string &name)
+    {
+        auto iter = shardedClientsMap_.find(name);
+        assert(iter != shardedClientsMap_.end());
+        return iter->second;
+    }
+
     void addDbClient(const DbConfig &config);
+    void addShardedDbClient(const std::string &name,
+                            const std::vector<std::string> &shards,
+                            const std::map<std::string, std::string> &shardMap,
+                            size_t virtualNodes);
     bool areAllDbClientsAvailable() const noexcept;
 
-  private:
-    std::map<std::string, DbClientPtr> dbClientsMap_;
+    /// True if no database client is configured
+    bool empty() const noexcept
+    {
+        return dbInfos_.empty();
+    }
 
     struct DbInfo
     {
         std::string connectionInfo_;
         DbConfig config_;
+        std::vector<std::string> replicaConnectionInfos_{};
+    };
+
+    struct ShardedInfo
+    {
+        std::string name_;
+        std::vector<std::string> shards_;
+        std::map<std::string, std::string> shardMap_;
+        size_t virtualNodes_;
     };
 
+  private:
+    std::map<std::string, DbClientPtr> dbClientsMap_;
+    std::map<std::string, ShardedDbClientPtr> shardedClientsMap_;
+
     std::vector<DbInfo> dbInfos_;
+    std::vector<ShardedInfo> shardedInfos_;
     std::map<std::string, IOThreadStorage<orm::DbClientPtr>> dbFastClientsMap_;
 };
 }  // namespace orm
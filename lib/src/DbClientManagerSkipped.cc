@@ -32,6 +32,17 @@ void DbClientManager::addDbClient(const DbConfig &)
     abort();
 }
 
+void DbClientManager::addShardedDbClient(
+    const std::string &,
+    const std::vector<std::string> &,
+    const std::map<std::string, std::string> &,
+    size_t)
+{
+    LOG_FATAL << "No database is supported by drogon, please install the "
+                 "database development library first.";
+    abort();
+}
+
 bool DbClientManager::areAllDbClientsAvailable() const noexcept
 {
     LOG_FATAL << "No database is supported by drogon, please install the "
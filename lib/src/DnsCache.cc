@@ -0,0 +1,193 @@
+/**
+ *
+ *  @file DnsCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "DnsCache.h"
+#include <trantor/utils/Logger.h>
+#include <cstring>
+
+using namespace drogon;
+
+namespace
+{
+// The expired entries are swept when there are more entries than this
+constexpr size_t kSweepThreshold = 1024;
+
+bool sameAddress(const trantor::InetAddress &a, const trantor::InetAddress &b)
+{
+    if (a.isIpV6() != b.isIpV6())
+        return false;
+    if (!a.isIpV6())
+        return a.ipNetEndian() == b.ipNetEndian();
+    return memcmp(a.ip6NetEndian(), b.ip6NetEndian(), 16) == 0;
+}
+}  // namespace
+
+DnsCache &DnsCache::instance()
+{
+    // Never destroyed, the resolver may call back while the process exits
+    static DnsCache *cache = new DnsCache;
+    return *cache;
+}
+
+void DnsCache::resolve(const std::string &host,
+                       trantor::EventLoop *loop,
+                       Callback callback)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+    auto &entry = entries_[host];
+    if (!entry.addresses.empty() && now < entry.expiry)
+    {
+        auto addresses = entry.addresses;
+        bool prefetch = !entry.resolving && entry.expiry - now < ttl_ / 10;
+        if (prefetch)
+            entry.resolving = true;
+        lock.unlock();
+        if (prefetch)
+            lookup(host);
+        if (loop->isInLoopThread())
+            callback(addresses);
+        else
+            loop->queueInLoop(
+                [callback = std::move(callback),
+                 addresses = std::move(addresses)]() { callback(addresses); });
+        return;
+    }
+    entry.waiters.push_back({loop, std::move(callback)});
+    if (entry.resolving)
+        return;
+    entry.resolving = true;
+    lock.unlock();
+    lookup(host);
+}
+
+void DnsCache::lookup(const std::string &host)
+{
+    std::shared_ptr<trantor::Resolver> resolver;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!resolver_)
+        {
+            // Its own cache is short, this one replaces it
+            resolver_ = trantor::Resolver::newResolver(nullptr, 1);
+        }
+        resolver = resolver_;
+    }
+    resolver->resolve(
+        host, [this, host](const std::vector<trantor::InetAddress> &addrs) {
+            onResolved(host, addrs);
+        });
+}
+
+void DnsCache::onResolved(const std::string &host,
+                          const std::vector<trantor::InetAddress> &addresses)
+{
+    auto sorted = sortForConnecting(addresses);
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+        auto iter = entries_.find(host);
+        if (iter == entries_.end())
+            return;
+        auto &entry = iter->second;
+        entry.resolving = false;
+        waiters.swap(entry.waiters);
+        if (!sorted.empty())
+        {
+            entry.addresses = sorted;
+            entry.expiry = now + ttl_;
+        }
+        else if (now >= entry.expiry)
+        {
+            // A failed refresh keeps the addresses until they expire
+            entries_.erase(iter);
+        }
+        if (entries_.size() > kSweepThreshold)
+        {
+            for (auto it = entries_.begin(); it != entries_.end();)
+            {
+                if (!it->second.resolving && it->second.expiry <= now)
+                    it = entries_.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+    if (sorted.empty())
+    {
+        LOG_ERROR << "Failed to resolve " << host;
+    }
+    for (auto &waiter : waiters)
+    {
+        waiter.loop->runInLoop(
+            [callback = std::move(waiter.callback), sorted]() {
+                callback(sorted);
+            });
+    }
+}
+
+void DnsCache::setTtl(double seconds)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds < 0 ? 0 : seconds));
+}
+
+void DnsCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        if (it->second.resolving)
+        {
+            it->second.addresses.clear();
+            ++it;
+        }
+        else
+        {
+            it = entries_.erase(it);
+        }
+    }
+}
+
+std::vector<trantor::InetAddress> DnsCache::sortForConnecting(
+    const std::vector<trantor::InetAddress> &addresses)
+{
+    std::vector<trantor::InetAddress> v6, v4;
+    for (auto &addr : addresses)
+    {
+        auto &family = addr.isIpV6() ? v6 : v4;
+        bool duplicate{false};
+        for (auto &known : family)
+        {
+            if (sameAddress(known, addr))
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate)
+            family.push_back(addr);
+    }
+    std::vector<trantor::InetAddress> sorted;
+    sorted.reserve(v6.size() + v4.size());
+    for (size_t i = 0; i < v6.size() || i < v4.size(); ++i)
+    {
+        if (i < v6.size())
+            sorted.push_back(v6[i]);
+        if (i < v4.size())
+            sorted.push_back(v4[i]);
+    }
+    return sorted;
+}
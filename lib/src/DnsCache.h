@@ -0,0 +1,98 @@
+/**
+ *
+ *  @file DnsCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/net/Resolver.h>
+#include <trantor/utils/NonCopyable.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The addresses of the host names resolved for the HTTP and WebSocket
+ * clients, shared by all the clients of the process.
+ *
+ * An entry is refreshed in the background when a client uses it in the last
+ * tenth of its lifetime, so the busy hosts never wait for the resolver. The
+ * concurrent lookups of a host are coalesced into one.
+ */
+class DROGON_EXPORT DnsCache : public trantor::NonCopyable
+{
+  public:
+    /// The addresses in the order to try them, empty if the lookup failed.
+    /// Their port is 0.
+    using Callback =
+        std::function<void(const std::vector<trantor::InetAddress> &)>;
+
+    static DnsCache &instance();
+
+    /**
+     * @brief Resolve the host, the callback is called in the loop, at once
+     * when the addresses are cached.
+     */
+    void resolve(const std::string &host,
+                 trantor::EventLoop *loop,
+                 Callback callback);
+
+    /// How long the addresses are cached, 0 disables the cache.
+    void setTtl(double seconds);
+
+    void clear();
+
+    /**
+     * @brief Order the addresses as RFC 8305 does: the duplicates are
+     * removed and the address families alternate, IPv6 first.
+     */
+    static std::vector<trantor::InetAddress> sortForConnecting(
+        const std::vector<trantor::InetAddress> &addresses);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Waiter
+    {
+        trantor::EventLoop *loop;
+        Callback callback;
+    };
+
+    struct Entry
+    {
+        std::vector<trantor::InetAddress> addresses;
+        Clock::time_point expiry;
+        bool resolving{false};
+        std::vector<Waiter> waiters;
+    };
+
+    DnsCache() = default;
+
+    void lookup(const std::string &host);
+    void onResolved(const std::string &host,
+                    const std::vector<trantor::InetAddress> &addresses);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::shared_ptr<trantor::Resolver> resolver_;
+    Clock::duration ttl_{std::chrono::seconds(60)};
+};
+
+}  // namespace drogon
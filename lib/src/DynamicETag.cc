@@ -0,0 +1,212 @@
+/**
+ *
+ *  @file DynamicETag.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "DynamicETag.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include <stdio.h>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// Little endian on every platform, compiled to a single load on most
+inline uint64_t read64(const unsigned char *p)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+inline uint64_t read32(const unsigned char *p)
+{
+    return static_cast<uint64_t>(p[0]) | (static_cast<uint64_t>(p[1]) << 8) |
+           (static_cast<uint64_t>(p[2]) << 16) |
+           (static_cast<uint64_t>(p[3]) << 24);
+}
+
+inline uint64_t mix(uint64_t acc, uint64_t input)
+{
+    acc += input * kPrime2;
+    return rotl(acc, 31) * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= mix(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+// The fields of a 304 response which the 200 response would have had,
+// rfc9110-15.4.5
+const char *const kNotModifiedFields[] =
+    {"etag", "cache-control", "expires", "vary", "content-location"};
+
+std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+        text.remove_suffix(1);
+    return text;
+}
+
+std::string_view opaqueTag(std::string_view etag)
+{
+    if (etag.substr(0, 2) == "W/")
+        etag.remove_prefix(2);
+    return etag;
+}
+}  // namespace
+
+uint64_t dynamic_etag::hash(const char *data, size_t length)
+{
+    auto p = reinterpret_cast<const unsigned char *>(data);
+    auto end = p + length;
+    uint64_t h;
+    if (length >= 32)
+    {
+        uint64_t v1 = kPrime1 + kPrime2;
+        uint64_t v2 = kPrime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - kPrime1;
+        do
+        {
+            v1 = mix(v1, read64(p));
+            v2 = mix(v2, read64(p + 8));
+            v3 = mix(v3, read64(p + 16));
+            v4 = mix(v4, read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else
+    {
+        h = kPrime5;
+    }
+    h += static_cast<uint64_t>(length);
+    for (; end - p >= 8; p += 8)
+    {
+        h ^= mix(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (end - p >= 4)
+    {
+        h ^= read32(p) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        h ^= *p * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool dynamic_etag::matches(std::string_view ifNoneMatch, std::string_view etag)
+{
+    if (etag.empty())
+        return false;
+    if (trim(ifNoneMatch) == "*")
+        return true;
+    etag = opaqueTag(etag);
+    while (!ifNoneMatch.empty())
+    {
+        auto comma = ifNoneMatch.find(',');
+        if (opaqueTag(trim(ifNoneMatch.substr(0, comma))) == etag)
+            return true;
+        if (comma == std::string_view::npos)
+            break;
+        ifNoneMatch.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+HttpResponsePtr dynamic_etag::apply(const HttpRequestImplPtr &req,
+                                    const HttpResponsePtr &resp)
+{
+    if (req->method() != Get || resp->statusCode() != k200OK)
+        return resp;
+    auto response = resp;
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    if (respImplPtr->getHeaderBy("etag").empty())
+    {
+        if (!respImplPtr->sendfileName().empty() ||
+            respImplPtr->streamCallback() ||
+            respImplPtr->asyncStreamCallback() ||
+            respImplPtr->getHeaderBy("cache-control").find("no-store") !=
+                std::string::npos)
+        {
+            return resp;
+        }
+        char etag[24];
+        snprintf(etag,
+                 sizeof(etag),
+                 "W/\"%016llx\"",
+                 static_cast<unsigned long long>(
+                     hash(respImplPtr->getBodyData(),
+                          respImplPtr->getBodyLength())));
+        if (respImplPtr->expiredTime() >= 0)
+        {
+            // The cached responses are shared by the requests
+            auto newResp = std::make_shared<HttpResponseImpl>(*respImplPtr);
+            newResp->setExpiredTime(-1);
+            respImplPtr = newResp.get();
+            response = std::move(newResp);
+        }
+        respImplPtr->addHeader("ETag", etag);
+    }
+    auto ifNoneMatch = req->getHeaderView(HttpHeaderId::kIfNoneMatch);
+    if (ifNoneMatch.empty() ||
+        !matches(ifNoneMatch, respImplPtr->getHeaderBy("etag")))
+    {
+        return response;
+    }
+    auto notModified = std::make_shared<HttpResponseImpl>();
+    notModified->setStatusCode(k304NotModified);
+    notModified->setContentTypeCode(CT_NONE);
+    for (auto field : kNotModifiedFields)
+    {
+        auto &value = respImplPtr->getHeaderBy(field);
+        if (!value.empty())
+            notModified->addHeader(field, value);
+    }
+    for (auto &cookie : respImplPtr->cookies())
+    {
+        notModified->addCookie(cookie.second);
+    }
+    return notModified;
+}
@@ -0,0 +1,51 @@
+/**
+ *
+ *  @file DynamicETag.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <drogon/HttpResponse.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+namespace drogon
+{
+namespace dynamic_etag
+{
+/// The 64-bit xxHash (XXH64) of the data with a seed of 0
+uint64_t hash(const char *data, size_t length);
+
+/**
+ * @brief Return true if the value of an If-None-Match header matches the
+ * ETag, by the weak comparison of rfc9110-8.8.3.2 which ignores the W/
+ * prefixes.
+ */
+bool matches(std::string_view ifNoneMatch, std::string_view etag);
+
+/**
+ * @brief The conditional stage of the responses of the handlers, run before
+ * their compression when the dynamic ETags are enabled.
+ *
+ * A 200 response to a GET request whose body is in memory and which has no
+ * ETag gets a weak ETag of the hash of its body. A response with an ETag,
+ * computed or set by its handler, is answered with a 304 response when the
+ * If-None-Match header of the request matches it.
+ *
+ * @return The response to send, the one passed or a new one.
+ */
+HttpResponsePtr apply(const HttpRequestImplPtr &req,
+                      const HttpResponsePtr &resp);
+
+}  // namespace dynamic_etag
+}  // namespace drogon
@@ -0,0 +1,368 @@
+/**
+ *
+ *  @file Grpc.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/Grpc.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+
+using namespace drogon;
+using namespace drogon::grpc;
+
+namespace
+{
+// The grpc-message field is percent-encoded, the printable ASCII characters
+// but '%' are sent as they are
+std::string encodeMessage(std::string_view message)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(message.length());
+    for (unsigned char c : message)
+    {
+        if (c >= 0x20 && c <= 0x7e && c != '%')
+        {
+            out.push_back(static_cast<char>(c));
+        }
+        else
+        {
+            out.push_back('%');
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 0x0f]);
+        }
+    }
+    return out;
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+std::string decodeMessage(std::string_view message)
+{
+    std::string out;
+    out.reserve(message.length());
+    for (size_t i = 0; i < message.length(); ++i)
+    {
+        int high, low;
+        if (message[i] == '%' && i + 2 < message.length() &&
+            (high = hexValue(message[i + 1])) >= 0 &&
+            (low = hexValue(message[i + 2])) >= 0)
+        {
+            out.push_back(static_cast<char>((high << 4) | low));
+            i += 2;
+        }
+        else
+        {
+            // An invalid escape is kept as it is
+            out.push_back(message[i]);
+        }
+    }
+    return out;
+}
+
+bool isGrpcContentType(std::string_view type)
+{
+    // Like application/grpc+proto
+    if (type.substr(0, kContentType.length()) != kContentType)
+        return false;
+    return type.length() == kContentType.length() ||
+           type[kContentType.length()] == '+' ||
+           type[kContentType.length()] == ';';
+}
+
+// The status of the responses which are not gRPC ones, by their status code
+StatusCode codeOfHttpStatus(int status)
+{
+    switch (status)
+    {
+        case 400:
+            return StatusCode::kInternal;
+        case 401:
+            return StatusCode::kUnauthenticated;
+        case 403:
+            return StatusCode::kPermissionDenied;
+        case 404:
+            return StatusCode::kUnimplemented;
+        case 429:
+        case 502:
+        case 503:
+        case 504:
+            return StatusCode::kUnavailable;
+        default:
+            return StatusCode::kUnknown;
+    }
+}
+
+Status statusOfFields(const std::string &code, const std::string &message)
+{
+    Status status;
+    if (code.empty() || code.length() > 2 ||
+        !std::all_of(code.begin(), code.end(), [](char c) {
+            return c >= '0' && c <= '9';
+        }))
+    {
+        status.code = StatusCode::kUnknown;
+        status.message = "Invalid grpc-status";
+        return status;
+    }
+    status.code = static_cast<StatusCode>(std::stoi(code));
+    status.message = decodeMessage(message);
+    return status;
+}
+}  // namespace
+
+Status grpc::splitFrames(std::string_view body,
+                         std::vector<std::string_view> &messages)
+{
+    messages.clear();
+    while (!body.empty())
+    {
+        if (body.length() < 5)
+            return {StatusCode::kInternal, "Truncated message prefix"};
+        if (body[0] != 0)
+        {
+            return {StatusCode::kUnimplemented,
+                    "Compressed messages are not supported"};
+        }
+        size_t length = 0;
+        for (size_t i = 1; i < 5; ++i)
+            length = (length << 8) | static_cast<unsigned char>(body[i]);
+        body.remove_prefix(5);
+        if (body.length() < length)
+            return {StatusCode::kInternal, "Truncated message"};
+        messages.emplace_back(body.substr(0, length));
+        body.remove_prefix(length);
+    }
+    return {};
+}
+
+bool grpc::parseTimeout(std::string_view value,
+                        std::chrono::nanoseconds &timeout)
+{
+    // At most 8 digits and a unit (gRPC over HTTP/2)
+    if (value.length() < 2 || value.length() > 9)
+        return false;
+    int64_t number = 0;
+    for (size_t i = 0; i + 1 < value.length(); ++i)
+    {
+        if (value[i] < '0' || value[i] > '9')
+            return false;
+        number = number * 10 + (value[i] - '0');
+    }
+    switch (value.back())
+    {
+        case 'H':
+            // The nanoseconds overflow past 2562047 hours
+            timeout = std::chrono::hours((std::min)(number, int64_t{1000000}));
+            return true;
+        case 'M':
+            timeout = std::chrono::minutes(number);
+            return true;
+        case 'S':
+            timeout = std::chrono::seconds(number);
+            return true;
+        case 'm':
+            timeout = std::chrono::milliseconds(number);
+            return true;
+        case 'u':
+            timeout = std::chrono::microseconds(number);
+            return true;
+        case 'n':
+            timeout = std::chrono::nanoseconds(number);
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string grpc::formatTimeout(std::chrono::nanoseconds timeout)
+{
+    // The finest unit whose value fits in 8 digits, rounded up so the
+    // server doesn't give up before the client
+    constexpr int64_t kMaxValue = 99999999;
+    struct Unit
+    {
+        int64_t nanoseconds;
+        char name;
+    };
+    static const Unit units[] = {{1, 'n'},
+                                 {1000, 'u'},
+                                 {1000000, 'm'},
+                                 {1000000000, 'S'},
+                                 {60 * int64_t{1000000000}, 'M'},
+                                 {3600 * int64_t{1000000000}, 'H'}};
+    auto count = (std::max)(timeout.count(), int64_t{0});
+    for (auto &unit : units)
+    {
+        auto value = (count + unit.nanoseconds - 1) / unit.nanoseconds;
+        if (value <= kMaxValue)
+            return std::to_string(value) + unit.name;
+    }
+    return std::to_string(kMaxValue) + 'H';
+}
+
+Status grpc::splitRequest(const HttpRequestPtr &req,
+                          std::vector<std::string_view> &messages)
+{
+    if (!isGrpcContentType(req->getHeader("content-type")))
+    {
+        return {StatusCode::kInvalidArgument,
+                "The content type is not application/grpc"};
+    }
+    return splitFrames(req->body(), messages);
+}
+
+HttpResponsePtr grpc::newFramedResponse(std::string body)
+{
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setContentTypeString(kContentType);
+    resp->setBody(std::move(body));
+    resp->addTrailer("grpc-status", "0");
+    return resp;
+}
+
+HttpResponsePtr grpc::newErrorResponse(const Status &status)
+{
+    // A trailers-only response, the status is in the header
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setContentTypeString(kContentType);
+    resp->addHeader("grpc-status",
+                    std::to_string(static_cast<int>(status.code)));
+    if (!status.message.empty())
+        resp->addHeader("grpc-message", encodeMessage(status.message));
+    return resp;
+}
+
+ServerWriter::ServerWriter(ResponseStreamPtr stream, HttpResponsePtr response)
+    : stream_(std::move(stream)), response_(std::move(response))
+{
+}
+
+ServerWriter::~ServerWriter()
+{
+    if (!finished_)
+        finish({StatusCode::kUnknown, "The call was not finished"});
+}
+
+bool ServerWriter::writeFrames(const std::string &frames)
+{
+    if (finished_ || !stream_)
+        return false;
+    return stream_->send(frames);
+}
+
+void ServerWriter::finish(const Status &status)
+{
+    if (finished_)
+        return;
+    finished_ = true;
+    if (!stream_)
+        return;
+    // The trailers are read by the connection once the stream is closed
+    response_->addTrailer("grpc-status",
+                          std::to_string(static_cast<int>(status.code)));
+    if (!status.message.empty())
+        response_->addTrailer("grpc-message", encodeMessage(status.message));
+    stream_->close();
+}
+
+HttpResponsePtr grpc::newStreamResponse(
+    const std::function<void(const ServerWriterPtr &)> &callback)
+{
+    // The writer sets the trailers of the response that owns the callback
+    auto self = std::make_shared<std::weak_ptr<HttpResponse>>();
+    auto resp = HttpResponse::newAsyncStreamResponse(
+        [callback, self](ResponseStreamPtr stream) {
+            auto response = self->lock();
+            if (!response)
+            {
+                LOG_ERROR << "The gRPC stream response is gone";
+                return;
+            }
+            callback(std::make_shared<ServerWriter>(std::move(stream),
+                                                    std::move(response)));
+        },
+        true);
+    *self = resp;
+    resp->setContentTypeString(kContentType);
+    return resp;
+}
+
+HttpRequestPtr grpc::newFramedRequest(const std::string &path,
+                                      std::string body,
+                                      std::chrono::nanoseconds timeout)
+{
+    auto req = HttpRequest::newHttpRequest();
+    req->setMethod(Post);
+    req->setPath(path);
+    req->setContentTypeString(kContentType);
+    req->addHeader("te", "trailers");
+    if (timeout.count() > 0)
+        req->addHeader("grpc-timeout", formatTimeout(timeout));
+    req->setBody(std::move(body));
+    return req;
+}
+
+Status grpc::statusOf(const HttpResponsePtr &resp)
+{
+    auto &trailers = resp->trailers();
+    auto code = trailers.find("grpc-status");
+    if (code != trailers.end())
+    {
+        auto message = trailers.find("grpc-message");
+        return statusOfFields(code->second,
+                              message != trailers.end() ? message->second
+                                                        : std::string());
+    }
+    auto &header = resp->getHeader("grpc-status");
+    if (!header.empty())
+        return statusOfFields(header, resp->getHeader("grpc-message"));
+    if (resp->statusCode() != k200OK)
+    {
+        return {codeOfHttpStatus(resp->statusCode()),
+                "HTTP status " + std::to_string(resp->statusCode())};
+    }
+    return {StatusCode::kInternal, "The response has no grpc-status"};
+}
+
+Status grpc::statusOf(ReqResult result)
+{
+    switch (result)
+    {
+        case ReqResult::Ok:
+            return {};
+        case ReqResult::Timeout:
+            return {StatusCode::kDeadlineExceeded, "Deadline exceeded"};
+        case ReqResult::BadResponse:
+            return {StatusCode::kInternal, std::string(to_string_view(result))};
+        default:
+            return {StatusCode::kUnavailable,
+                    std::string(to_string_view(result))};
+    }
+}
+
+Status grpc::splitResponse(const HttpResponsePtr &resp,
+                           std::vector<std::string_view> &messages)
+{
+    auto status = statusOf(resp);
+    if (!status.ok())
+        return status;
+    return splitFrames(resp->body(), messages);
+}
@@ -0,0 +1,248 @@
+/**
+ *
+ *  @file HandlerLoopPool.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HandlerLoopPool.h"
+#include <trantor/utils/Logger.h>
+#include <chrono>
+#include <exception>
+
+using namespace drogon;
+
+namespace
+{
+// The requests a loop handles before it serves its timers and sockets again
+constexpr size_t kDrainBatch = 16;
+
+int64_t steadyNow()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+HandlerLoopPool::~HandlerLoopPool()
+{
+    for (auto &worker : workers_)
+        worker->thread.reset();
+}
+
+void HandlerLoopPool::setThreadNum(size_t minThreadNum, size_t maxThreadNum)
+{
+    maxThreadNum_ = maxThreadNum;
+    if (minThreadNum == 0)
+        minThreadNum = 1;
+    minThreadNum_ = minThreadNum < maxThreadNum ? minThreadNum : maxThreadNum;
+}
+
+void HandlerLoopPool::start(trantor::EventLoop *mainLoop, size_t firstIndex)
+{
+    if (maxThreadNum_ == 0 || started())
+        return;
+    mainLoop_ = mainLoop;
+    firstIndex_ = firstIndex;
+    workers_.reserve(maxThreadNum_);
+    for (size_t i = 0; i < maxThreadNum_; ++i)
+        workers_.emplace_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < minThreadNum_; ++i)
+        grow();
+    timerId_ = mainLoop_->runEvery(1.0, [this]() { resize(); });
+    started_.store(true, std::memory_order_release);
+}
+
+void HandlerLoopPool::stop()
+{
+    if (!started_.exchange(false))
+        return;
+    mainLoop_->invalidateTimer(timerId_);
+    // The requests still queued are dropped with their connections
+    for (auto &worker : workers_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->stopped = true;
+            worker->tasks.clear();
+        }
+        worker->thread.reset();
+        worker->loop = nullptr;
+    }
+    active_ = 0;
+}
+
+void HandlerLoopPool::run(Task &&task)
+{
+    auto active = active_.load(std::memory_order_acquire);
+    if (active == 0)
+    {
+        // Stopped with the application
+        return;
+    }
+    auto start = nextWorker_.fetch_add(1, std::memory_order_relaxed) % active;
+    auto index = start;
+    for (size_t i = 0; i < active; ++i)
+    {
+        auto candidate = (start + i) % active;
+        if (!workers_[candidate]->scheduled.load(std::memory_order_relaxed))
+        {
+            index = candidate;
+            break;
+        }
+    }
+    for (;;)
+    {
+        auto &worker = *workers_[index];
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        if (worker.stopped)
+        {
+            // Retired and stopped meanwhile, the first loop is never retired
+            if (index == 0)
+                return;
+            index = 0;
+            continue;
+        }
+        worker.tasks.emplace_back(std::move(task));
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        if (!worker.scheduled.exchange(true))
+        {
+            lock.unlock();
+            worker.loop.load()->queueInLoop(
+                [this, index]() { drain(index); });
+        }
+        break;
+    }
+    // More requests waiting than loops
+    if (pending_.load(std::memory_order_relaxed) > active &&
+        active < maxThreadNum_ && !growing_.exchange(true))
+    {
+        mainLoop_->queueInLoop([this]() {
+            grow();
+            growing_ = false;
+        });
+    }
+}
+
+void HandlerLoopPool::done(trantor::EventLoop *loop)
+{
+    for (auto &worker : workers_)
+    {
+        if (worker->loop.load(std::memory_order_relaxed) == loop)
+        {
+            worker->inflight.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void HandlerLoopPool::grow()
+{
+    auto index = active_.load();
+    if (index >= workers_.size())
+        return;
+    auto &worker = *workers_[index];
+    worker.lastActive = steadyNow();
+    if (!worker.thread)
+    {
+        worker.thread =
+            std::make_unique<trantor::EventLoopThread>("HandlerLoop");
+        auto loop = worker.thread->getLoop();
+        loop->setIndex(firstIndex_ + index);
+        worker.thread->run();
+        worker.loop = loop;
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.stopped = false;
+        LOG_DEBUG << "Handler loop " << index << " started";
+    }
+    // A retired loop not stopped yet takes new requests again
+    active_.store(index + 1, std::memory_order_release);
+    // Steals the requests waiting in the other loops
+    if (!worker.scheduled.exchange(true))
+        worker.loop.load()->queueInLoop([this, index]() { drain(index); });
+}
+
+void HandlerLoopPool::resize()
+{
+    auto active = active_.load();
+    auto now = steadyNow();
+    if (active > minThreadNum_)
+    {
+        auto &last = *workers_[active - 1];
+        if (now - last.lastActive.load() >
+                static_cast<int64_t>(idleTimeout_ * 1000000) &&
+            !last.scheduled.load())
+        {
+            // The loop is parked, not stopped: the handlers, the database
+            // and Redis clients may still queue tasks and timers in it
+            active_.store(active - 1, std::memory_order_release);
+            LOG_DEBUG << "Handler loop " << active - 1 << " retired";
+        }
+    }
+}
+
+bool HandlerLoopPool::takeTask(size_t index, Task &task)
+{
+    auto &own = *workers_[index];
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+        // A request queued from now on schedules a new drain
+        own.scheduled = false;
+    }
+    for (size_t i = 1; i < workers_.size(); ++i)
+    {
+        auto &victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            // Busy with the stolen request
+            own.scheduled = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void HandlerLoopPool::drain(size_t index)
+{
+    auto &worker = *workers_[index];
+    auto loop = worker.loop.load();
+    Task task;
+    for (size_t i = 0; i < kDrainBatch; ++i)
+    {
+        if (!takeTask(index, task))
+            return;
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        worker.inflight.fetch_add(1, std::memory_order_relaxed);
+        worker.lastActive.store(steadyNow(), std::memory_order_relaxed);
+        try
+        {
+            task(loop);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "Exception in the handler loop: " << e.what();
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Exception in the handler loop";
+        }
+    }
+    // Still busy, the timers and sockets of the loop run in between
+    loop->queueInLoop([this, index]() { drain(index); });
+}
@@ -0,0 +1,148 @@
+/**
+ *
+ *  @file HandlerLoopPool.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The loops running the handlers of the requests when they are split
+ * from the IO loops, which then only parse the requests and send the
+ * responses.
+ *
+ * Every loop has its own queue. A request goes to an idle loop if there is
+ * one, or round-robin, and a loop which has emptied its queue steals the
+ * oldest request of another one. A loop is added when the requests waiting
+ * outnumber the loops, up to the maximum, and the last one is retired when
+ * it has been idle for the idle timeout, down to the minimum. A retired loop
+ * takes no new requests but keeps running, since the handlers and the
+ * clients they used may still have tasks and timers in it, and it is the
+ * first one to take requests again when the pool grows. The loops are only
+ * stopped with the pool.
+ *
+ * The loops are indexed after the IO loops and the main loop, so the
+ * IOThreadStorage of the handlers has a slot for each of them.
+ */
+class HandlerLoopPool : public trantor::NonCopyable
+{
+  public:
+    using Task = std::function<void(trantor::EventLoop *)>;
+
+    static HandlerLoopPool &instance()
+    {
+        static HandlerLoopPool inst;
+        return inst;
+    }
+
+    ~HandlerLoopPool();
+
+    /// Don't set after start(), a maximum of 0 (the default) disables the pool
+    void setThreadNum(size_t minThreadNum, size_t maxThreadNum);
+
+    size_t minThreadNum() const
+    {
+        return minThreadNum_;
+    }
+
+    size_t maxThreadNum() const
+    {
+        return maxThreadNum_;
+    }
+
+    /// In seconds, 10 by default
+    void setIdleTimeout(double timeout)
+    {
+        idleTimeout_ = timeout;
+    }
+
+    /**
+     * @brief Start the minimum number of loops, the pool is resized by a
+     * timer of the main loop.
+     *
+     * @param firstIndex The index of the first loop, the others follow.
+     */
+    void start(trantor::EventLoop *mainLoop, size_t firstIndex);
+    void stop();
+
+    bool started() const
+    {
+        return started_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Run the task in a loop, which is passed to it. done() must be
+     * called with the loop once the request is answered.
+     */
+    void run(Task &&task);
+    void done(trantor::EventLoop *loop);
+
+    /// The loops taking new requests
+    size_t loopNum() const
+    {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+    /// The requests waiting for a loop
+    size_t queueDepth() const
+    {
+        return pending_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        // A drain of the queue is queued in the loop or running
+        std::atomic<bool> scheduled{false};
+        bool stopped{true};
+        std::unique_ptr<trantor::EventLoopThread> thread;
+        std::atomic<trantor::EventLoop *> loop{nullptr};
+        // The requests taken by the loop and not answered yet
+        std::atomic<size_t> inflight{0};
+        // The steady time in microseconds when the loop last took a request
+        std::atomic<int64_t> lastActive{0};
+    };
+
+    HandlerLoopPool() = default;
+
+    void grow();
+    void resize();
+    void drain(size_t index);
+    bool takeTask(size_t index, Task &task);
+
+    size_t minThreadNum_{1};
+    size_t maxThreadNum_{0};
+    double idleTimeout_{10};
+    size_t firstIndex_{0};
+    trantor::EventLoop *mainLoop_{nullptr};
+    trantor::TimerId timerId_{0};
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> active_{0};
+    std::atomic<size_t> nextWorker_{0};
+    std::atomic<size_t> pending_{0};
+    std::atomic<bool> growing_{false};
+    std::atomic<bool> started_{false};
+};
+}  // namespace drogon
@@ -0,0 +1,180 @@
+/**
+ *
+ *  @file Hasher.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/Hasher.h>
+#include <drogon/utils/Utilities.h>
+#include "IncrementalHash.h"
+#ifdef USE_OPENSSL
+#include <openssl/evp.h>
+#endif
+
+using namespace drogon;
+using namespace drogon::utils;
+
+struct Hasher::Impl
+{
+    virtual ~Impl() = default;
+    virtual void update(const void *data, size_t length) = 0;
+    // Write the digest and start a new hash
+    virtual void final(unsigned char *digest) = 0;
+};
+
+namespace
+{
+template <typename Hash>
+class PortableHasher : public Hasher::Impl
+{
+  public:
+    void update(const void *data, size_t length) override
+    {
+        hash_.update(static_cast<const char *>(data), length);
+    }
+
+    void final(unsigned char *digest) override
+    {
+        hash_.final(digest);
+        hash_ = Hash();
+    }
+
+  private:
+    Hash hash_;
+};
+
+#ifdef USE_OPENSSL
+class EvpHasher : public Hasher::Impl
+{
+  public:
+    /// Return nullptr if OpenSSL doesn't provide the digest, e.g. MD5 in the
+    /// FIPS mode.
+    static std::unique_ptr<Hasher::Impl> create(HashAlgorithm algorithm)
+    {
+        auto md = digest(algorithm);
+        if (!md)
+            return nullptr;
+        std::unique_ptr<EvpHasher> hasher(new EvpHasher(md));
+        if (!hasher->ctx_ || !EVP_DigestInit_ex(hasher->ctx_, md, nullptr))
+            return nullptr;
+        return hasher;
+    }
+
+    ~EvpHasher() override
+    {
+        EVP_MD_CTX_free(ctx_);
+    }
+
+    void update(const void *data, size_t length) override
+    {
+        EVP_DigestUpdate(ctx_, data, length);
+    }
+
+    void final(unsigned char *digest) override
+    {
+        EVP_DigestFinal_ex(ctx_, digest, nullptr);
+        EVP_DigestInit_ex(ctx_, md_, nullptr);
+    }
+
+  private:
+    explicit EvpHasher(const EVP_MD *md) : md_(md), ctx_(EVP_MD_CTX_new())
+    {
+    }
+
+    static const EVP_MD *digest(HashAlgorithm algorithm)
+    {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        // Fetch the implementations once, EVP_md5() and the others look them
+        // up again on every initialization
+        static EVP_MD *const mds[] = {EVP_MD_fetch(nullptr, "MD5", nullptr),
+                                      EVP_MD_fetch(nullptr, "SHA1", nullptr),
+                                      EVP_MD_fetch(nullptr, "SHA256", nullptr),
+                                      EVP_MD_fetch(nullptr,
+                                                   "SHA3-256",
+                                                   nullptr)};
+#else
+        static const EVP_MD *const mds[] = {EVP_md5(),
+                                            EVP_sha1(),
+                                            EVP_sha256(),
+                                            EVP_sha3_256()};
+#endif
+        // The BLAKE2b of OpenSSL only has 64 bytes digests
+        if (algorithm == HashAlgorithm::kBlake2b)
+            return nullptr;
+        return mds[static_cast<int>(algorithm)];
+    }
+
+    const EVP_MD *md_;
+    EVP_MD_CTX *ctx_;
+};
+#endif
+
+std::unique_ptr<Hasher::Impl> createImpl(HashAlgorithm algorithm)
+{
+#ifdef USE_OPENSSL
+    if (auto impl = EvpHasher::create(algorithm))
+        return impl;
+#endif
+    switch (algorithm)
+    {
+        case HashAlgorithm::kMd5:
+            return std::make_unique<PortableHasher<Md5Hash>>();
+        case HashAlgorithm::kSha1:
+            return std::make_unique<PortableHasher<Sha1Hash>>();
+        case HashAlgorithm::kSha256:
+            return std::make_unique<PortableHasher<Sha256Hash>>();
+        case HashAlgorithm::kSha3:
+            return std::make_unique<PortableHasher<Sha3Hash>>();
+        case HashAlgorithm::kBlake2b:
+        default:
+            return std::make_unique<PortableHasher<Blake2bHash>>();
+    }
+}
+}  // namespace
+
+Hasher::Hasher(HashAlgorithm algorithm)
+    : algorithm_(algorithm), impl_(createImpl(algorithm))
+{
+}
+
+Hasher::~Hasher() = default;
+Hasher::Hasher(Hasher &&) noexcept = default;
+Hasher &Hasher::operator=(Hasher &&) noexcept = default;
+
+size_t Hasher::digestLength() const
+{
+    switch (algorithm_)
+    {
+        case HashAlgorithm::kMd5:
+            return 16;
+        case HashAlgorithm::kSha1:
+            return 20;
+        default:
+            return 32;
+    }
+}
+
+void Hasher::update(const void *data, size_t length)
+{
+    if (length > 0)
+        impl_->update(data, length);
+}
+
+size_t Hasher::final(unsigned char *digest)
+{
+    impl_->final(digest);
+    return digestLength();
+}
+
+std::string Hasher::hexDigest()
+{
+    unsigned char digest[kMaxDigestLength];
+    return binaryStringToHex(digest, final(digest));
+}
@@ -1,51 +1,97 @@
 #include <drogon/utils/monitoring/Histogram.h>
+#include <algorithm>
 using namespace drogon;
 using namespace drogon::monitoring;
 
 void Histogram::observe(double value)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
     if (maxAge_ > std::chrono::seconds(0) &&
-        timerId_ == trantor::InvalidTimerId)
+        !timerStarted_.load(std::memory_order_acquire))
     {
-        std::weak_ptr<Histogram> weakPtr =
-            std::dynamic_pointer_cast<Histogram>(shared_from_this());
-        timerId_ = loopPtr_->runEvery(maxAge_ / timeBucketCount_, [weakPtr]() {
-            auto thisPtr = weakPtr.lock();
-            if (!thisPtr)
-                return;
-            thisPtr->rotateTimeBuckets();
-        });
+        startTimer();
     }
-    auto &currentBucket = timeBuckets_.back();
-    currentBucket.sum += value;
-    currentBucket.count += 1;
-    for (size_t i = 0; i < bucketBoundaries_.size(); i++)
+    auto shard = internal::shardOfThisThread();
+    size_t bucket = std::lower_bound(bucketBoundaries_.begin(),
+                                     bucketBoundaries_.end(),
+                                     value) -
+                    bucketBoundaries_.begin();
+    countOf(shard, bucket).fetch_add(1, std::memory_order_relaxed);
+    internal::atomicAdd(sums_[shard].value, value);
+}
+
+void Histogram::startTimer()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timerId_ != trantor::InvalidTimerId)
+        return;
+    std::weak_ptr<Histogram> weakPtr =
+        std::dynamic_pointer_cast<Histogram>(shared_from_this());
+    timerId_ = loopPtr_->runEvery(maxAge_ / timeBucketCount_, [weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->rotateTimeBuckets();
+    });
+    timerStarted_.store(true, std::memory_order_release);
+}
+
+void Histogram::rotateTimeBuckets()
+{
+    TimeBucket bucket;
+    bucket.buckets.resize(bucketBoundaries_.size() + 1);
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (size_t shard = 0; shard < internal::kShardsNum; ++shard)
     {
-        if (value <= bucketBoundaries_[i])
+        for (size_t i = 0; i < bucket.buckets.size(); ++i)
         {
-            currentBucket.buckets[i] += 1;
-            break;
+            bucket.buckets[i] +=
+                countOf(shard, i).exchange(0, std::memory_order_relaxed);
         }
+        bucket.sum +=
+            sums_[shard].value.exchange(0, std::memory_order_relaxed);
+    }
+    for (auto count : bucket.buckets)
+    {
+        bucket.count += count;
     }
-    if (value > bucketBoundaries_.back())
+    timeBuckets_.emplace_back(std::move(bucket));
+    // The shards are the current time bucket
+    while (!timeBuckets_.empty() && timeBuckets_.size() >= timeBucketCount_)
     {
-        currentBucket.buckets.back() += 1;
+        timeBuckets_.pop_front();
     }
 }
 
 std::vector<Sample> Histogram::collect() const
 {
-    std::vector<Sample> samples;
-    std::lock_guard<std::mutex> guard(mutex_);
-    size_t count{0};
-    for (size_t i = 0; i < bucketBoundaries_.size(); i++)
+    std::vector<uint64_t> counts(bucketBoundaries_.size() + 1);
+    double sum{0};
     {
-        Sample sample;
+        std::lock_guard<std::mutex> guard(mutex_);
         for (auto &bucket : timeBuckets_)
         {
-            count += bucket.buckets[i];
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                counts[i] += bucket.buckets[i];
+            }
+            sum += bucket.sum;
+        }
+        for (size_t shard = 0; shard < internal::kShardsNum; ++shard)
+        {
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                counts[i] +=
+                    countOf(shard, i).load(std::memory_order_relaxed);
+            }
         }
+        sum += internal::sumOf(sums_);
+    }
+    std::vector<Sample> samples;
+    uint64_t count{0};
+    for (size_t i = 0; i < bucketBoundaries_.size(); i++)
+    {
+        Sample sample;
+        count += counts[i];
         sample.name = name_ + "_bucket";
         sample.exLabels.emplace_back("le",
                                      std::to_string(bucketBoundaries_[i]));
@@ -53,28 +99,20 @@ std::vector<Sample> Histogram::collect() const
         samples.emplace_back(std::move(sample));
     }
     Sample sample;
-    for (auto &bucket : timeBuckets_)
-    {
-        count += bucket.buckets.back();
-    }
+    count += counts.back();
     sample.name = name_ + "_bucket";
     sample.exLabels.emplace_back("le", "+Inf");
     sample.value = count;
     samples.emplace_back(std::move(sample));
-    double sum{0};
-    uint64_t totalCount{0};
-    for (auto &bucket : timeBuckets_)
-    {
-        sum += bucket.sum;
-        totalCount += bucket.count;
-    }
     Sample sumSample;
     sumSample.name = name_ + "_sum";
     sumSample.value = sum;
     samples.emplace_back(std::move(sumSample));
+    // The count is the +Inf bucket even if the shards were updated while
+    // being collected.
     Sample countSample;
     countSample.name = name_ + "_count";
-    countSample.value = totalCount;
+    countSample.value = count;
     samples.emplace_back(std::move(countSample));
     return samples;
 }
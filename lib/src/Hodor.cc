@@ -1,11 +1,25 @@
 #include <drogon/plugins/Hodor.h>
 #include <drogon/plugins/RealIpResolver.h>
+#include "RedisRateLimiter.h"
+#include "SharedMemoryRateLimiter.h"
 
 using namespace drogon::plugin;
 
-Hodor::LimitStrategy Hodor::makeLimitStrategy(const Json::Value &config)
+// The options which can be reloaded are removed
+static Json::Value fixedOptions(const Json::Value &config)
+{
+    auto fixed = config;
+    for (auto key :
+         {"urls", "capacity", "ip_capacity", "user_capacity", "sub_limits"})
+        fixed.removeMember(key);
+    return fixed;
+}
+
+Hodor::LimitStrategy Hodor::makeLimitStrategy(const Json::Value &config,
+                                              size_t index)
 {
     LimitStrategy strategy;
+    strategy.redisKeyPrefix = redisKeyPrefix_ + std::to_string(index) + ":";
     strategy.capacity = config.get("capacity", 0).asUInt();
     if (config.isMember("urls") && config["urls"].isArray())
     {
@@ -25,45 +39,54 @@ Hodor::LimitStrategy Hodor::makeLimitStrategy(const Json::Value &config)
 
     if (strategy.capacity > 0)
     {
-        if (multiThreads_)
-        {
-            strategy.globalLimiterPtr = std::make_shared<SafeRateLimiter>(
-                RateLimiter::newRateLimiter(algorithm_,
-                                            strategy.capacity,
-                                            timeUnit_));
-        }
-        else
-        {
-            strategy.globalLimiterPtr =
-                RateLimiter::newRateLimiter(algorithm_,
-                                            strategy.capacity,
-                                            timeUnit_);
-        }
+        strategy.globalLimiterPtr =
+            newLimiter(strategy.capacity, strategy.redisKeyPrefix + "global");
     }
     strategy.ipCapacity = config.get("ip_capacity", 0).asUInt();
     if (strategy.ipCapacity > 0)
     {
         strategy.ipLimiterMapPtr =
-            std::make_unique<CacheMap<std::string, RateLimiterPtr>>(
+            std::make_unique<ShardedCacheMap<std::string, RateLimiterPtr>>(
                 drogon::app().getLoop(),
                 float(timeUnit_.count() / 60 < 1 ? 1 : timeUnit_.count() / 60),
-                2,
-                100);
+                200);
     }
 
     strategy.userCapacity = config.get("user_capacity", 0).asUInt();
     if (strategy.userCapacity > 0)
     {
         strategy.userLimiterMapPtr =
-            std::make_unique<CacheMap<std::string, RateLimiterPtr>>(
+            std::make_unique<ShardedCacheMap<std::string, RateLimiterPtr>>(
                 drogon::app().getLoop(),
                 float(timeUnit_.count() / 60 < 1 ? 1 : timeUnit_.count() / 60),
-                2,
-                100);
+                200);
     }
     return strategy;
 }
 
+drogon::RateLimiterPtr Hodor::newLimiter(size_t capacity,
+                                         const std::string &redisKey) const
+{
+    if (redisClientPtr_)
+    {
+        return std::make_shared<RedisRateLimiter>(
+            redisClientPtr_, redisKey, capacity, timeUnit_, redisLeaseSize_);
+    }
+    if (sharedMemoryPtr_)
+    {
+        return std::make_shared<SharedMemoryRateLimiter>(sharedMemoryPtr_,
+                                                         redisKey,
+                                                         capacity,
+                                                         timeUnit_);
+    }
+    if (multiThreads_ && !isThreadSafeRateLimiterType(algorithm_))
+    {
+        return std::make_shared<SafeRateLimiter>(
+            RateLimiter::newRateLimiter(algorithm_, capacity, timeUnit_));
+    }
+    return RateLimiter::newRateLimiter(algorithm_, capacity, timeUnit_);
+}
+
 void Hodor::initAndStart(const Json::Value &config)
 {
     algorithm_ = stringToRateLimiterType(
@@ -82,7 +105,54 @@ void Hodor::initAndStart(const Json::Value &config)
         (std::max)(static_cast<size_t>(
                        config.get("limiter_expire_time", 600).asUInt()),
                    static_cast<size_t>(timeUnit_.count() * 3));
-    limitStrategies_.emplace_back(makeLimitStrategy(config));
+    auto redisClientName = config.get("redis_client", "").asString();
+    if (!redisClientName.empty())
+    {
+        redisClientPtr_ = app().getRedisClient(redisClientName);
+        if (!redisClientPtr_)
+        {
+            throw std::runtime_error("Hodor: no redis client named " +
+                                     redisClientName);
+        }
+        redisLeaseSize_ = config.get("redis_lease_size", 10).asUInt();
+    }
+    redisKeyPrefix_ =
+        config.get("redis_key_prefix", "drogon:hodor:").asString();
+    auto sharedMemoryFile = config.get("shared_memory_file", "").asString();
+    if (!sharedMemoryFile.empty() && !redisClientPtr_)
+    {
+        // A slot holds a counter and its key, with the IP or the user ID
+        sharedMemoryPtr_ = std::make_shared<SharedMemoryMap>(
+            sharedMemoryFile,
+            config.get("shared_memory_capacity", 65536).asUInt64(),
+            256);
+    }
+    limitStrategies_ = std::make_unique<IOThreadSnapshot<LimitStrategies>>(
+        makeLimitStrategies(config));
+    fixedConfig_ = fixedOptions(config);
+
+    const Json::Value &trustIps = config["trust_ips"];
+    if (!trustIps.isNull() && !trustIps.isArray())
+    {
+        throw std::runtime_error("Invalid trusted_ips. Should be array.");
+    }
+    for (const auto &ipOrCidr : trustIps)
+    {
+        trustIps_.add(ipOrCidr.asString());
+    }
+
+    app().registerPreHandlingAdvice([this](const drogon::HttpRequestPtr &req,
+                                           AdviceCallback &&acb,
+                                           AdviceChainCallback &&accb) {
+        onHttpRequest(req, std::move(acb), std::move(accb));
+    });
+}
+
+std::shared_ptr<const Hodor::LimitStrategies> Hodor::makeLimitStrategies(
+    const Json::Value &config)
+{
+    auto strategies = std::make_shared<LimitStrategies>();
+    strategies->emplace_back(makeLimitStrategy(config, 0));
     if (config.isMember("sub_limits") && config["sub_limits"].isArray())
     {
         for (auto &subLimit : config["sub_limits"])
@@ -102,25 +172,21 @@ void Hodor::initAndStart(const Json::Value &config)
                              "greater than 0!";
                 continue;
             }
-            limitStrategies_.emplace_back(makeLimitStrategy(subLimit));
+            strategies->emplace_back(
+                makeLimitStrategy(subLimit, strategies->size()));
         }
     }
+    return strategies;
+}
 
-    const Json::Value &trustIps = config["trust_ips"];
-    if (!trustIps.isNull() && !trustIps.isArray())
-    {
-        throw std::runtime_error("Invalid trusted_ips. Should be array.");
-    }
-    for (const auto &ipOrCidr : trustIps)
-    {
-        trustCIDRs_.emplace_back(ipOrCidr.asString());
-    }
-
-    app().registerPreHandlingAdvice([this](const drogon::HttpRequestPtr &req,
-                                           AdviceCallback &&acb,
-                                           AdviceChainCallback &&accb) {
-        onHttpRequest(req, std::move(acb), std::move(accb));
-    });
+bool Hodor::reloadConfig(const Json::Value &config)
+{
+    if (fixedOptions(config) != fixedConfig_)
+        return false;
+    // The requests being checked keep the old limits
+    limitStrategies_->publish(makeLimitStrategies(config));
+    LOG_INFO << "The limits of Hodor are reloaded";
+    return true;
 }
 
 void Hodor::shutdown()
@@ -133,7 +199,7 @@ bool Hodor::checkLimit(const drogon::HttpRequestPtr &req,
                        const trantor::InetAddress &ip,
                        const std::optional<std::string> &userId)
 {
-    if (RealIpResolver::matchCidr(ip, trustCIDRs_))
+    if (trustIps_.contains(ip))
     {
         return true;
     }
@@ -156,22 +222,12 @@ bool Hodor::checkLimit(const drogon::HttpRequestPtr &req,
         RateLimiterPtr limiterPtr;
         strategy.ipLimiterMapPtr->modify(
             ip.toIpNetEndian(),
-            [this, &limiterPtr, &strategy](RateLimiterPtr &ptr) {
+            [this, &limiterPtr, &strategy, &ip](RateLimiterPtr &ptr) {
                 if (!ptr)
                 {
-                    if (multiThreads_)
-                    {
-                        ptr = std::make_shared<SafeRateLimiter>(
-                            RateLimiter::newRateLimiter(algorithm_,
-                                                        strategy.ipCapacity,
-                                                        timeUnit_));
-                    }
-                    else
-                    {
-                        ptr = RateLimiter::newRateLimiter(algorithm_,
-                                                          strategy.ipCapacity,
-                                                          timeUnit_);
-                    }
+                    ptr = newLimiter(strategy.ipCapacity,
+                                     strategy.redisKeyPrefix + "ip:" +
+                                         ip.toIp());
                 }
                 limiterPtr = ptr;
             },
@@ -190,22 +246,12 @@ bool Hodor::checkLimit(const drogon::HttpRequestPtr &req,
         RateLimiterPtr limiterPtr;
         strategy.userLimiterMapPtr->modify(
             *userId,
-            [this, &strategy, &limiterPtr](RateLimiterPtr &ptr) {
+            [this, &strategy, &limiterPtr, &userId](RateLimiterPtr &ptr) {
                 if (!ptr)
                 {
-                    if (multiThreads_)
-                    {
-                        ptr = std::make_shared<SafeRateLimiter>(
-                            RateLimiter::newRateLimiter(algorithm_,
-                                                        strategy.userCapacity,
-                                                        timeUnit_));
-                    }
-                    else
-                    {
-                        ptr = RateLimiter::newRateLimiter(algorithm_,
-                                                          strategy.userCapacity,
-                                                          timeUnit_);
-                    }
+                    ptr = newLimiter(strategy.userCapacity,
+                                     strategy.redisKeyPrefix + "user:" +
+                                         *userId);
                 }
                 limiterPtr = ptr;
             },
@@ -230,7 +276,8 @@ void Hodor::onHttpRequest(const drogon::HttpRequestPtr &req,
     {
         userId = userIdGetter_(req);
     }
-    for (auto &strategy : limitStrategies_)
+    auto strategies = limitStrategies_->getShared();
+    for (auto &strategy : *strategies)
     {
         if (!checkLimit(req, strategy, ip, userId))
         {
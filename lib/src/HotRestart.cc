@@ -0,0 +1,446 @@
+/**
+ *
+ *  @file HotRestart.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HotRestart.h"
+#include "Http2ServerConnection.h"
+#include "HttpRequestParser.h"
+#include "WebSocketConnectionImpl.h"
+#include <drogon/HttpAppFramework.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+
+#ifdef __linux__
+namespace
+{
+// The commands of the new process
+constexpr char kTakeOver = 'T';
+constexpr char kReady = 'R';
+// The sockets sent in one message
+constexpr size_t kMaxSocketsPerMessage = 64;
+
+bool toUnixAddress(const std::string &path, sockaddr_un &addr)
+{
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        LOG_ERROR << "The hot restart socket path is too long: " << path;
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+// Receive a message with its sockets, returns the length of the message
+ssize_t receiveSockets(int fd,
+                       std::string &message,
+                       std::vector<int> &sockets)
+{
+    char data[4096];
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) *
+                                             kMaxSocketsPerMessage)];
+    iovec iov{data, sizeof(data)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    auto n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n <= 0)
+        return n;
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; ++i)
+        {
+            int socket;
+            memcpy(&socket, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            sockets.push_back(socket);
+        }
+    }
+    message.assign(data, static_cast<size_t>(n));
+    return n;
+}
+
+void closeIfIdle(const trantor::TcpConnectionPtr &conn)
+{
+    auto requestParser = conn->getContext<HttpRequestParser>();
+    if (!requestParser)
+    {
+        conn->shutdown();
+        return;
+    }
+    if (requestParser->http2Conn())
+    {
+        requestParser->http2Conn()->goAway();
+    }
+    else if (requestParser->webSocketConn())
+    {
+        requestParser->webSocketConn()->shutdown(CloseCode::kEndpointGone);
+    }
+    else if (requestParser->atRequestStart() &&
+             requestParser->emptyPipelining())
+    {
+        // The other connections are closed after their pending responses
+        conn->shutdown();
+    }
+}
+}  // namespace
+#endif
+
+void HotRestart::takeOver(const std::string &path)
+{
+#ifdef __linux__
+    path_ = path;
+    enabled_ = true;
+    sockaddr_un addr;
+    if (!toUnixAddress(path, addr))
+        return;
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "socket";
+        return;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        // No process to replace
+        ::close(fd);
+        return;
+    }
+    timeval timeout{5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string message;
+    std::vector<int> sockets;
+    if (::send(fd, &kTakeOver, 1, MSG_NOSIGNAL) != 1 ||
+        receiveSockets(fd, message, sockets) <= 0)
+    {
+        LOG_ERROR << "Failed to take over the listeners of the process "
+                     "serving "
+                  << path;
+        ::close(fd);
+        return;
+    }
+    // The number of sockets comes first, then the addresses of the sockets
+    // of each message
+    size_t total = std::strtoul(message.c_str(), nullptr, 10);
+    size_t received = 0;
+    while (received < total)
+    {
+        sockets.clear();
+        if (receiveSockets(fd, message, sockets) <= 0)
+        {
+            LOG_ERROR << "The previous process closed the hot restart socket";
+            break;
+        }
+        size_t pos = 0;
+        for (auto socket : sockets)
+        {
+            auto end = message.find('\n', pos);
+            inherited_[message.substr(pos, end - pos)].push_back(socket);
+            pos = end == std::string::npos ? end : end + 1;
+        }
+        received += sockets.size();
+    }
+    LOG_INFO << "Took over " << received << " listening sockets from the "
+             << "process serving " << path;
+    previousFd_ = fd;
+#else
+    (void)path;
+    LOG_WARN << "The hot restart is only supported on Linux";
+#endif
+}
+
+bool HotRestart::inherits(const trantor::InetAddress &address)
+{
+    auto iter = inherited_.find(address.toIpPort());
+    return iter != inherited_.end() && !iter->second.empty();
+}
+
+std::function<void(int)> HotRestart::wrapBeforeListen(
+    const trantor::InetAddress &address,
+    std::function<void(int)> callback)
+{
+    if (!enabled_)
+        return callback;
+    return [this, address = address.toIpPort(), callback](int fd) {
+#ifdef __linux__
+        int inherited = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto iter = inherited_.find(address);
+            if (iter != inherited_.end() && !iter->second.empty())
+            {
+                inherited = iter->second.back();
+                iter->second.pop_back();
+            }
+        }
+        // Listen on the socket of the previous process, with its queue
+        if (inherited >= 0)
+        {
+            if (::dup3(inherited, fd, O_CLOEXEC) < 0)
+                LOG_SYSERR << "dup3";
+            ::close(inherited);
+        }
+#endif
+        if (callback)
+            callback(fd);
+        std::lock_guard<std::mutex> lock(mutex_);
+        sockets_.emplace_back(address, fd);
+    };
+}
+
+void HotRestart::start(trantor::EventLoop *loop, double drainTimeout)
+{
+#ifdef __linux__
+    if (!enabled_)
+        return;
+    loop_ = loop;
+    drainTimeout_ = drainTimeout;
+    // The sockets of the listeners which are not configured anymore
+    for (auto &[address, sockets] : inherited_)
+    {
+        for (auto socket : sockets)
+            ::close(socket);
+    }
+    inherited_.clear();
+
+    sockaddr_un addr;
+    if (!toUnixAddress(path_, addr))
+        return;
+    listenFd_ =
+        ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ::unlink(path_.c_str());
+    auto sockAddr = reinterpret_cast<sockaddr *>(&addr);
+    if (listenFd_ < 0 || ::bind(listenFd_, sockAddr, sizeof(addr)) != 0 ||
+        ::listen(listenFd_, 4) != 0)
+    {
+        LOG_SYSERR << "Failed to listen on the hot restart socket " << path_;
+    }
+    else
+    {
+        listenChannel_ = std::make_unique<trantor::Channel>(loop_, listenFd_);
+        listenChannel_->setReadCallback([this]() { onAccept(); });
+        listenChannel_->enableReading();
+    }
+    if (previousFd_ >= 0)
+    {
+        ::send(previousFd_, &kReady, 1, MSG_NOSIGNAL);
+        ::close(previousFd_);
+        previousFd_ = -1;
+    }
+#else
+    (void)loop;
+    (void)drainTimeout;
+#endif
+}
+
+void HotRestart::stop()
+{
+#ifdef __linux__
+    if (listenChannel_)
+    {
+        listenChannel_->disableAll();
+        listenChannel_->remove();
+        listenChannel_.reset();
+        // The path may be served by the next process already
+        struct stat pathStat, socketStat;
+        if (::stat(path_.c_str(), &pathStat) == 0 &&
+            ::fstat(listenFd_, &socketStat) == 0 &&
+            pathStat.st_ino == socketStat.st_ino)
+        {
+            ::unlink(path_.c_str());
+        }
+    }
+    if (listenFd_ >= 0)
+    {
+        ::close(listenFd_);
+        listenFd_ = -1;
+    }
+    for (auto &[fd, channel] : controls_)
+    {
+        channel->disableAll();
+        channel->remove();
+        ::close(fd);
+    }
+    controls_.clear();
+#endif
+}
+
+void HotRestart::onAccept()
+{
+#ifdef __linux__
+    int fd =
+        ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+        return;
+    auto channel = std::make_unique<trantor::Channel>(loop_, fd);
+    channel->setReadCallback([this, fd]() { onCommand(fd); });
+    channel->enableReading();
+    controls_[fd] = std::move(channel);
+#endif
+}
+
+void HotRestart::onCommand(int fd)
+{
+#ifdef __linux__
+    char command;
+    auto n = ::recv(fd, &command, 1, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+    if (n == 1 && command == kTakeOver)
+    {
+        sendSockets(fd);
+        return;
+    }
+    if (n == 1 && command == kReady)
+    {
+        closeControl(fd);
+        drain();
+        return;
+    }
+    LOG_WARN << "The new process exited before it listened, this process "
+                "keeps serving";
+    closeControl(fd);
+#else
+    (void)fd;
+#endif
+}
+
+void HotRestart::sendSockets(int fd)
+{
+#ifdef __linux__
+    std::vector<std::pair<std::string, int>> sockets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sockets = sockets_;
+    }
+    auto total = std::to_string(sockets.size());
+    if (::send(fd, total.data(), total.size(), MSG_NOSIGNAL) < 0)
+    {
+        LOG_SYSERR << "Failed to hand over the listening sockets";
+        return;
+    }
+    for (size_t begin = 0; begin < sockets.size();
+         begin += kMaxSocketsPerMessage)
+    {
+        auto end = (std::min)(begin + kMaxSocketsPerMessage, sockets.size());
+        std::string addresses;
+        std::vector<int> fds;
+        for (auto i = begin; i < end; ++i)
+        {
+            addresses.append(sockets[i].first).append("\n");
+            fds.push_back(sockets[i].second);
+        }
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) *
+                                                 kMaxSocketsPerMessage)];
+        iovec iov{addresses.data(), addresses.size()};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        auto cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+        if (::sendmsg(fd, &msg, MSG_NOSIGNAL) < 0)
+        {
+            LOG_SYSERR << "Failed to hand over the listening sockets";
+            return;
+        }
+    }
+    LOG_INFO << "Handed over " << sockets.size()
+             << " listening sockets to a new process";
+#else
+    (void)fd;
+#endif
+}
+
+void HotRestart::closeControl(int fd)
+{
+#ifdef __linux__
+    auto iter = controls_.find(fd);
+    if (iter == controls_.end())
+        return;
+    iter->second->disableAll();
+    iter->second->remove();
+    // The channel is running its callback
+    loop_->queueInLoop(
+        [fd, channel = std::shared_ptr<trantor::Channel>(
+                 std::move(iter->second))]() { ::close(fd); });
+    controls_.erase(iter);
+#else
+    (void)fd;
+#endif
+}
+
+void HotRestart::drain()
+{
+#ifdef __linux__
+    if (draining_.exchange(true, std::memory_order_acq_rel))
+        return;
+    LOG_INFO << "The new process listens, draining the connections";
+    std::vector<std::weak_ptr<trantor::TcpConnection>> connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &[ptr, weakConn] : connections_)
+            connections.push_back(weakConn);
+    }
+    for (auto &weakConn : connections)
+    {
+        auto conn = weakConn.lock();
+        if (!conn)
+            continue;
+        conn->getLoop()->queueInLoop([conn]() {
+            if (conn->connected())
+                closeIfIdle(conn);
+        });
+    }
+    // This process keeps accepting its share of the new connections until it
+    // quits, they are closed after their first response
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::duration<double>(drainTimeout_));
+    auto timerId = std::make_shared<trantor::TimerId>();
+    *timerId = loop_->runEvery(0.1, [this, timerId, deadline]() {
+        bool empty;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            empty = connections_.empty();
+        }
+        if (!empty && std::chrono::steady_clock::now() < deadline)
+            return;
+        loop_->invalidateTimer(*timerId);
+        if (!empty)
+            LOG_WARN << "The drain timeout expired, closing the remaining "
+                        "connections";
+        app().quit();
+    });
+#endif
+}
@@ -0,0 +1,132 @@
+/**
+ *
+ *  @file HotRestart.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/Channel.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Hands the listening sockets over from a running process to the one
+ * replacing it.
+ *
+ * The process serves a unix socket. A new process started with the same path
+ * connects to it and receives the listening sockets (SCM_RIGHTS), which it
+ * listens on in place of the ones it binds, so the connections waiting in
+ * their queues are not lost. When the new process listens, it tells the old
+ * one, which answers its pending requests with "Connection: close", closes
+ * the idle connections and quits when they are all closed or the drain
+ * timeout expires. This is only supported on Linux.
+ */
+class HotRestart : public trantor::NonCopyable
+{
+  public:
+    static HotRestart &instance()
+    {
+        static HotRestart inst;
+        return inst;
+    }
+
+    /// Take the listening sockets of the process serving the path, if any.
+    /// Called before the listeners are created.
+    void takeOver(const std::string &path);
+
+    /// Serve the path once the listeners listen, and tell the previous
+    /// process to drain its connections
+    void start(trantor::EventLoop *loop, double drainTimeout);
+    void stop();
+
+    bool enabled() const
+    {
+        return enabled_;
+    }
+
+    bool draining() const
+    {
+        return draining_.load(std::memory_order_acquire);
+    }
+
+    /// True if a socket listening on the address was taken over
+    bool inherits(const trantor::InetAddress &address);
+
+    /**
+     * @brief Wrap the callback called before a listener listens: the socket
+     * bound by the listener is replaced by the taken over one, and is handed
+     * over to the next process.
+     */
+    std::function<void(int)> wrapBeforeListen(
+        const trantor::InetAddress &address,
+        std::function<void(int)> callback);
+
+    void connectionOpened(const trantor::TcpConnectionPtr &conn)
+    {
+        if (!enabled_)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.emplace(conn.get(), conn);
+    }
+
+    void connectionClosed(const trantor::TcpConnectionPtr &conn)
+    {
+        if (!enabled_)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.erase(conn.get());
+    }
+
+  private:
+    HotRestart() = default;
+
+    void onAccept();
+    void onCommand(int fd);
+    void sendSockets(int fd);
+    void closeControl(int fd);
+    void drain();
+
+    bool enabled_{false};
+    std::atomic<bool> draining_{false};
+    std::string path_;
+    double drainTimeout_{0};
+    trantor::EventLoop *loop_{nullptr};
+
+    // The sockets taken over, by address, and the connection to the process
+    // which gave them
+    std::map<std::string, std::vector<int>> inherited_;
+    int previousFd_{-1};
+
+    int listenFd_{-1};
+    std::unique_ptr<trantor::Channel> listenChannel_;
+    std::map<int, std::unique_ptr<trantor::Channel>> controls_;
+
+    std::mutex mutex_;
+    // The listening sockets handed over to the next process
+    std::vector<std::pair<std::string, int>> sockets_;
+    std::unordered_map<trantor::TcpConnection *,
+                       std::weak_ptr<trantor::TcpConnection>>
+        connections_;
+};
+}  // namespace drogon
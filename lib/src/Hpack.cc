@@ -0,0 +1,588 @@
+/**
+ *
+ *  @file Hpack.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Hpack.h"
+#include <algorithm>
+#include <array>
+
+using namespace drogon;
+
+namespace
+{
+// RFC 7541 Appendix A
+const std::pair<std::string_view, std::string_view> kStaticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+constexpr size_t kStaticTableSize =
+    sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+// The default SETTINGS_HEADER_TABLE_SIZE, which a decoder assumes until it is
+// told otherwise
+constexpr size_t kDefaultTableSize = 4096;
+
+// RFC 7541 Appendix B, the codes are aligned to the least significant bit
+const uint32_t kHuffmanCodes[256] = {
+    0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5,
+    0xfffffe6, 0xfffffe7, 0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9,
+    0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec, 0xfffffed, 0xfffffee,
+    0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+    0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9,
+    0xffffffa, 0xffffffb, 0x14, 0x3f8, 0x3f9, 0xffa,
+    0x1ff9, 0x15, 0xf8, 0x7fa, 0x3fa, 0x3fb,
+    0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+    0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b,
+    0x1c, 0x1d, 0x1e, 0x1f, 0x5c, 0xfb,
+    0x7ffc, 0x20, 0xffb, 0x3fc, 0x1ffa, 0x21,
+    0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+    0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e,
+    0x6f, 0x70, 0x71, 0x72, 0xfc, 0x73,
+    0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+    0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5,
+    0x25, 0x26, 0x27, 0x6, 0x74, 0x75,
+    0x28, 0x29, 0x2a, 0x7, 0x2b, 0x76,
+    0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+    0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd,
+    0x1ffd, 0xffffffc, 0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8,
+    0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9, 0x3fffd6, 0x7fffda,
+    0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+    0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1,
+    0x7fffe2, 0x7fffe3, 0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5,
+    0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef, 0x3fffda, 0x1fffdd,
+    0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+    0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf,
+    0x7fffeb, 0x7fffec, 0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2,
+    0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef, 0xfffea, 0x3fffe2,
+    0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+    0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2,
+    0x3fffe8, 0x1ffffec, 0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde,
+    0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed, 0x7fff2, 0x1fffe3,
+    0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+    0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3,
+    0x7ffffe4, 0x7ffffe5, 0xfffec, 0xfffff3, 0xfffed, 0x1fffe6,
+    0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3, 0x3fffea, 0x3fffeb,
+    0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+    0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8,
+    0x7ffffe9, 0x7ffffea, 0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed,
+    0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+};
+const uint8_t kHuffmanCodeLengths[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+
+constexpr uint16_t kLeaf = 0x8000;
+
+/**
+ * The decoding tree of the Huffman code, every node resolves 8 bits. An
+ * entry is 0 if no code starts with its bits, the index of the next node, or
+ * a leaf with the symbol and the number of its bits resolved by the node.
+ */
+struct HuffmanTree
+{
+    HuffmanTree() : nodes(1)
+    {
+        nodes[0].fill(0);
+        for (size_t sym = 0; sym < 256; ++sym)
+        {
+            auto code = kHuffmanCodes[sym];
+            auto length = kHuffmanCodeLengths[sym];
+            size_t node = 0;
+            while (length > 8)
+            {
+                length -= 8;
+                auto index = static_cast<uint8_t>(code >> length);
+                if (nodes[node][index] == 0)
+                {
+                    nodes.emplace_back();
+                    nodes.back().fill(0);
+                    nodes[node][index] =
+                        static_cast<uint16_t>(nodes.size() - 1);
+                }
+                node = nodes[node][index];
+            }
+            auto shift = 8 - length;
+            size_t start = static_cast<uint8_t>(code << shift);
+            size_t count = size_t(1) << shift;
+            for (auto i = start; i < start + count; ++i)
+            {
+                nodes[node][i] =
+                    static_cast<uint16_t>(kLeaf | (length << 8) | sym);
+            }
+        }
+    }
+
+    std::vector<std::array<uint16_t, 256>> nodes;
+};
+
+const HuffmanTree &huffmanTree()
+{
+    static const HuffmanTree tree;
+    return tree;
+}
+
+bool decodeInteger(const uint8_t *&p,
+                   const uint8_t *end,
+                   int prefixBits,
+                   uint64_t &value)
+{
+    if (p == end)
+        return false;
+    uint8_t mask = static_cast<uint8_t>((1 << prefixBits) - 1);
+    value = *p++ & mask;
+    if (value < mask)
+        return true;
+    unsigned shift = 0;
+    while (p != end)
+    {
+        // No integer of HTTP/2 needs more than 32 bits
+        if (shift > 28)
+            return false;
+        auto b = *p++;
+        value += static_cast<uint64_t>(b & 0x7f) << shift;
+        shift += 7;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+void encodeInteger(std::string &out,
+                   uint8_t flags,
+                   int prefixBits,
+                   uint64_t value)
+{
+    uint8_t mask = static_cast<uint8_t>((1 << prefixBits) - 1);
+    if (value < mask)
+    {
+        out.push_back(static_cast<char>(flags | value));
+        return;
+    }
+    out.push_back(static_cast<char>(flags | mask));
+    value -= mask;
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool decodeString(const uint8_t *&p, const uint8_t *end, std::string &str)
+{
+    if (p == end)
+        return false;
+    bool huffman = (*p & 0x80) != 0;
+    uint64_t length;
+    if (!decodeInteger(p, end, 7, length) ||
+        length > static_cast<uint64_t>(end - p))
+        return false;
+    str.clear();
+    if (huffman)
+    {
+        if (!hpack::huffmanDecode(p, length, str))
+            return false;
+    }
+    else
+    {
+        str.assign(reinterpret_cast<const char *>(p), length);
+    }
+    p += length;
+    return true;
+}
+
+void encodeString(std::string_view str, std::string &out)
+{
+    auto huffmanLength = hpack::huffmanEncodedLength(str);
+    if (huffmanLength < str.length())
+    {
+        encodeInteger(out, 0x80, 7, huffmanLength);
+        hpack::huffmanEncode(str, out);
+        return;
+    }
+    encodeInteger(out, 0, 7, str.length());
+    out.append(str);
+}
+
+enum class Indexing
+{
+    kIncremental,
+    kWithout,
+    kNever
+};
+
+Indexing indexingOf(std::string_view name)
+{
+    if (name == "set-cookie" || name == "authorization" ||
+        name == "proxy-authorization")
+        return Indexing::kNever;
+    // These values rarely repeat, they would only evict the ones which do
+    if (name == "content-length" || name == "content-range" ||
+        name == "etag" || name == "last-modified" || name == "location" ||
+        name == "age" || name == ":path")
+        return Indexing::kWithout;
+    return Indexing::kIncremental;
+}
+}  // namespace
+
+void HpackTable::add(std::string name, std::string value)
+{
+    auto entrySize = name.length() + value.length() + 32;
+    if (entrySize > maxSize_)
+    {
+        // An entry larger than the table empties it (RFC 7541 section 4.4)
+        evict(0);
+        return;
+    }
+    evict(maxSize_ - entrySize);
+    size_ += entrySize;
+    entries_.emplace_front(std::move(name), std::move(value));
+}
+
+void HpackTable::setMaxSize(size_t maxSize)
+{
+    maxSize_ = maxSize;
+    evict(maxSize);
+}
+
+void HpackTable::evict(size_t maxSize)
+{
+    while (size_ > maxSize)
+    {
+        auto &entry = entries_.back();
+        size_ -= entry.first.length() + entry.second.length() + 32;
+        entries_.pop_back();
+    }
+}
+
+bool HpackDecoder::field(size_t index,
+                         std::string &name,
+                         std::string &value) const
+{
+    if (index == 0)
+        return false;
+    if (index <= kStaticTableSize)
+    {
+        auto &entry = kStaticTable[index - 1];
+        name.assign(entry.first);
+        value.assign(entry.second);
+        return true;
+    }
+    index -= kStaticTableSize + 1;
+    if (index >= table_.count())
+        return false;
+    name = table_[index].first;
+    value = table_[index].second;
+    return true;
+}
+
+bool HpackDecoder::decode(const uint8_t *data,
+                          size_t length,
+                          HpackHeaders &headers)
+{
+    auto p = data;
+    auto end = data + length;
+    size_t listSize = 0;
+    bool fieldDecoded = false;
+    std::string name, value;
+    while (p < end)
+    {
+        auto b = *p;
+        uint64_t index;
+        if (b & 0x80)
+        {
+            // Indexed header field
+            if (!decodeInteger(p, end, 7, index) ||
+                !field(static_cast<size_t>(index), name, value))
+                return false;
+        }
+        else if ((b & 0xe0) == 0x20)
+        {
+            // Dynamic table size update, only allowed at the beginning of a
+            // block
+            if (fieldDecoded || !decodeInteger(p, end, 5, index) ||
+                index > maxTableSize_)
+                return false;
+            table_.setMaxSize(static_cast<size_t>(index));
+            continue;
+        }
+        else
+        {
+            // Literal header field, with incremental indexing, without
+            // indexing or never indexed
+            bool indexing = (b & 0x40) != 0;
+            if (!decodeInteger(p, end, indexing ? 6 : 4, index))
+                return false;
+            if (index == 0)
+            {
+                if (!decodeString(p, end, name))
+                    return false;
+            }
+            else if (!field(static_cast<size_t>(index), name, value))
+            {
+                return false;
+            }
+            if (!decodeString(p, end, value))
+                return false;
+            if (indexing)
+                table_.add(name, value);
+        }
+        fieldDecoded = true;
+        listSize += name.length() + value.length() + 32;
+        if (listSize > maxHeaderListSize_)
+            return false;
+        headers.emplace_back(std::move(name), std::move(value));
+    }
+    return true;
+}
+
+void HpackEncoder::setMaxTableSize(size_t size)
+{
+    size = (std::min)(size, maxTableSize_);
+    if (size == table_.maxSize())
+        return;
+    minPendingSize_ = (std::min)(minPendingSize_, size);
+    table_.setMaxSize(size);
+    sizeUpdatePending_ = true;
+}
+
+void HpackEncoder::encode(const HpackHeaders &headers, std::string &out)
+{
+    if (sizeUpdatePending_)
+    {
+        // Signal the smallest size if the table shrank and grew again, so
+        // that the decoder evicts the same entries (RFC 7541 section 4.2)
+        if (minPendingSize_ < table_.maxSize())
+            encodeInteger(out, 0x20, 5, minPendingSize_);
+        encodeInteger(out, 0x20, 5, table_.maxSize());
+        sizeUpdatePending_ = false;
+        minPendingSize_ = SIZE_MAX;
+    }
+    for (auto &header : headers)
+    {
+        encodeField(header.first, header.second, out);
+    }
+}
+
+void HpackEncoder::encodeField(std::string_view name,
+                               std::string_view value,
+                               std::string &out)
+{
+    size_t nameIndex = 0;
+    for (size_t i = 0; i < kStaticTableSize; ++i)
+    {
+        if (kStaticTable[i].first != name)
+            continue;
+        if (kStaticTable[i].second == value)
+        {
+            encodeInteger(out, 0x80, 7, i + 1);
+            return;
+        }
+        if (nameIndex == 0)
+            nameIndex = i + 1;
+    }
+    for (size_t i = 0; i < table_.count(); ++i)
+    {
+        if (table_[i].first != name)
+            continue;
+        if (table_[i].second == value)
+        {
+            encodeInteger(out, 0x80, 7, kStaticTableSize + 1 + i);
+            return;
+        }
+        if (nameIndex == 0)
+            nameIndex = kStaticTableSize + 1 + i;
+    }
+    auto indexing = indexingOf(name);
+    switch (indexing)
+    {
+        case Indexing::kIncremental:
+            encodeInteger(out, 0x40, 6, nameIndex);
+            break;
+        case Indexing::kWithout:
+            encodeInteger(out, 0x00, 4, nameIndex);
+            break;
+        case Indexing::kNever:
+            encodeInteger(out, 0x10, 4, nameIndex);
+            break;
+    }
+    if (nameIndex == 0)
+        encodeString(name, out);
+    encodeString(value, out);
+    if (indexing == Indexing::kIncremental)
+        table_.add(std::string(name), std::string(value));
+}
+
+void hpack::huffmanEncode(std::string_view str, std::string &out)
+{
+    uint64_t bits = 0;
+    unsigned bitCount = 0;
+    for (auto c : str)
+    {
+        auto sym = static_cast<uint8_t>(c);
+        auto length = kHuffmanCodeLengths[sym];
+        bits = (bits << length) | kHuffmanCodes[sym];
+        bitCount += length;
+        while (bitCount >= 8)
+        {
+            bitCount -= 8;
+            out.push_back(static_cast<char>(bits >> bitCount));
+        }
+        bits &= (uint64_t(1) << bitCount) - 1;
+    }
+    if (bitCount > 0)
+    {
+        // Padded with the most significant bits of EOS, which are all ones
+        out.push_back(
+            static_cast<char>((bits << (8 - bitCount)) | (0xff >> bitCount)));
+    }
+}
+
+size_t hpack::huffmanEncodedLength(std::string_view str)
+{
+    size_t bitCount = 0;
+    for (auto c : str)
+    {
+        bitCount += kHuffmanCodeLengths[static_cast<uint8_t>(c)];
+    }
+    return (bitCount + 7) / 8;
+}
+
+bool hpack::huffmanDecode(const uint8_t *data, size_t length, std::string &out)
+{
+    auto &nodes = huffmanTree().nodes;
+    uint64_t bits = 0;
+    // The number of the bits to be resolved, and of the bits since the end of
+    // the last symbol
+    unsigned bitCount = 0;
+    unsigned symbolBits = 0;
+    size_t node = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        bits = (bits << 8) | data[i];
+        bitCount += 8;
+        symbolBits += 8;
+        while (bitCount >= 8)
+        {
+            auto entry =
+                nodes[node][static_cast<uint8_t>(bits >> (bitCount - 8))];
+            if (entry == 0)
+                return false;
+            if (entry & kLeaf)
+            {
+                out.push_back(static_cast<char>(entry & 0xff));
+                bitCount -= (entry >> 8) & 0x0f;
+                node = 0;
+                symbolBits = bitCount;
+            }
+            else
+            {
+                node = entry;
+                bitCount -= 8;
+            }
+        }
+    }
+    while (bitCount > 0)
+    {
+        auto entry =
+            nodes[node][static_cast<uint8_t>(bits << (8 - bitCount))];
+        if (entry == 0)
+            return false;
+        if ((entry & kLeaf) == 0 || ((entry >> 8) & 0x0f) > bitCount)
+            break;
+        out.push_back(static_cast<char>(entry & 0xff));
+        bitCount -= (entry >> 8) & 0x0f;
+        node = 0;
+        symbolBits = bitCount;
+    }
+    // The padding is shorter than 8 bits and is the prefix of EOS
+    if (symbolBits > 7)
+        return false;
+    auto mask = (uint64_t(1) << bitCount) - 1;
+    return (bits & mask) == mask;
+}
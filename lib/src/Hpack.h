@@ -0,0 +1,157 @@
+/**
+ *
+ *  @file Hpack.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/// A list of header fields in the order of their header block.
+using HpackHeaders = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief The dynamic table of an HPACK (RFC 7541) context.
+ */
+class HpackTable
+{
+  public:
+    explicit HpackTable(size_t maxSize) : maxSize_(maxSize)
+    {
+    }
+
+    /// The entry at the dynamic index which starts at 0 with the newest one.
+    const std::pair<std::string, std::string> &operator[](size_t index) const
+    {
+        return entries_[index];
+    }
+
+    size_t count() const
+    {
+        return entries_.size();
+    }
+
+    size_t maxSize() const
+    {
+        return maxSize_;
+    }
+
+    void add(std::string name, std::string value);
+    void setMaxSize(size_t maxSize);
+
+  private:
+    void evict(size_t maxSize);
+
+    std::deque<std::pair<std::string, std::string>> entries_;
+    size_t size_{0};
+    size_t maxSize_;
+};
+
+/**
+ * @brief Decodes the header blocks received on one HTTP/2 connection.
+ */
+class HpackDecoder : public trantor::NonCopyable
+{
+  public:
+    /**
+     * @param maxTableSize The SETTINGS_HEADER_TABLE_SIZE sent to the peer.
+     * @param maxHeaderListSize The limit of the decoded size of a header
+     * block, counted as in SETTINGS_MAX_HEADER_LIST_SIZE.
+     */
+    explicit HpackDecoder(size_t maxTableSize = 4096,
+                          size_t maxHeaderListSize = 64 * 1024)
+        : table_(maxTableSize),
+          maxTableSize_(maxTableSize),
+          maxHeaderListSize_(maxHeaderListSize)
+    {
+    }
+
+    /**
+     * @brief Decode a complete header block and append its fields to
+     * headers.
+     *
+     * @return false if the block is malformed or too large, which is a
+     * connection error of the type COMPRESSION_ERROR.
+     */
+    bool decode(const uint8_t *data, size_t length, HpackHeaders &headers);
+
+  private:
+    bool field(size_t index, std::string &name, std::string &value) const;
+
+    HpackTable table_;
+    size_t maxTableSize_;
+    size_t maxHeaderListSize_;
+};
+
+/**
+ * @brief Encodes the header blocks sent on one HTTP/2 connection.
+ *
+ * The fields which repeat across responses are added to the dynamic table,
+ * the ones which rarely do (content-length, etag...) are sent as literals,
+ * and set-cookie is never indexed.
+ */
+class HpackEncoder : public trantor::NonCopyable
+{
+  public:
+    explicit HpackEncoder(size_t maxTableSize = 4096)
+        : table_(maxTableSize), maxTableSize_(maxTableSize)
+    {
+    }
+
+    /**
+     * @brief Apply the SETTINGS_HEADER_TABLE_SIZE of the peer, the table
+     * never grows beyond the size given to the constructor.
+     */
+    void setMaxTableSize(size_t size);
+
+    /**
+     * @brief Encode the fields, whose names must be lowercase, as one header
+     * block appended to out.
+     */
+    void encode(const HpackHeaders &headers, std::string &out);
+
+  private:
+    void encodeField(std::string_view name,
+                     std::string_view value,
+                     std::string &out);
+
+    HpackTable table_;
+    size_t maxTableSize_;
+    // The smallest table size since the last block, and the new one, which
+    // are signaled at the beginning of the next block
+    size_t minPendingSize_{SIZE_MAX};
+    bool sizeUpdatePending_{false};
+};
+
+namespace hpack
+{
+/// Huffman-encode the string (RFC 7541 Appendix B) and append it to out.
+void huffmanEncode(std::string_view str, std::string &out);
+
+/// The length of the Huffman encoding of the string.
+size_t huffmanEncodedLength(std::string_view str);
+
+/**
+ * @brief Decode the Huffman-encoded string and append it to out.
+ *
+ * @return false if the encoding is invalid.
+ */
+bool huffmanDecode(const uint8_t *data, size_t length, std::string &out);
+}  // namespace hpack
+}  // namespace drogon
@@ -0,0 +1,736 @@
+/**
+ *
+ *  @file Http2ClientConnection.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http2ClientConnection.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+using namespace drogon;
+using namespace drogon::http2;
+
+namespace
+{
+// The receive windows of the connection and of every stream, they are
+// replenished once half of them is consumed
+constexpr uint32_t kRecvWindowSize = 1024 * 1024;
+// The data of the streams written before waiting for the socket to drain
+constexpr size_t kMaxWriteBatch = 256 * 1024;
+constexpr size_t kMaxHeaderBlockSize = 64 * 1024;
+constexpr uint32_t kMaxStreamId = 0x7fffffff;
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t' ||
+                            str.back() == '\r'))
+        str.remove_suffix(1);
+    return str;
+}
+}  // namespace
+
+Http2ClientConnection::Http2ClientConnection(
+    const trantor::TcpConnectionPtr &conn,
+    bool secure)
+    : conn_(conn),
+      loop_(conn->getLoop()),
+      secure_(secure),
+      decoder_(4096, kMaxHeaderBlockSize)
+{
+}
+
+void Http2ClientConnection::start()
+{
+    auto conn = conn_.lock();
+    if (!conn)
+        return;
+    // Resume the bodies of the requests once a batch is written
+    conn->setWriteCompleteCallback(
+        [weakSelf = weak_from_this()](const trantor::TcpConnectionPtr &) {
+            auto self = weakSelf.lock();
+            if (!self)
+                return;
+            self->waitingForWrite_ = false;
+            self->flush();
+        });
+    output_.append(kConnectionPreface.data(), kConnectionPreface.length());
+    appendFrameHeader(output_, 6 * 3, FrameType::kSettings, 0, 0);
+    appendSetting(output_, Setting::kEnablePush, 0);
+    appendSetting(output_, Setting::kInitialWindowSize, kRecvWindowSize);
+    appendSetting(output_, Setting::kMaxHeaderListSize, kMaxHeaderBlockSize);
+    appendWindowUpdate(output_, 0, kRecvWindowSize - kDefaultWindowSize);
+    sendOutput();
+}
+
+bool Http2ClientConnection::canOpenStream() const
+{
+    return !goingAway_ && !closed_ && nextStreamId_ <= kMaxStreamId &&
+           streams_.size() < peerMaxConcurrentStreams_;
+}
+
+void Http2ClientConnection::sendRequest(const HttpRequestPtr &req,
+                                        ResponseCallback &&callback)
+{
+    assert(canOpenStream());
+    // The request is rendered as in HTTP/1 and its request line is turned
+    // into pseudo-header fields
+    trantor::MsgBuffer buffer;
+    static_cast<HttpRequestImpl *>(req.get())->appendToBuffer(&buffer);
+    std::string_view text(buffer.peek(), buffer.readableBytes());
+    auto headerEnd = text.find("\r\n\r\n");
+    auto eol = text.find("\r\n");
+    auto requestLine = text.substr(0, eol);
+    auto space = requestLine.find(' ');
+    auto lastSpace = requestLine.rfind(' ');
+    if (headerEnd == std::string_view::npos || space == lastSpace)
+    {
+        LOG_ERROR << "Invalid request";
+        callback(ReqResult::BadResponse, nullptr);
+        return;
+    }
+    auto body = text.substr(headerEnd + 4);
+    text = text.substr(0, headerEnd + 2);
+
+    HpackHeaders fields;
+    fields.emplace_back(":method", std::string(requestLine.substr(0, space)));
+    fields.emplace_back(":scheme", secure_ ? "https" : "http");
+    fields.emplace_back(":authority", std::string());
+    fields.emplace_back(
+        ":path",
+        std::string(requestLine.substr(space + 1, lastSpace - space - 1)));
+    while (true)
+    {
+        text.remove_prefix(eol + 2);
+        eol = text.find("\r\n");
+        if (eol == std::string_view::npos)
+            break;
+        auto fieldLine = text.substr(0, eol);
+        auto colon = fieldLine.find(':');
+        if (colon == std::string_view::npos)
+            continue;
+        std::string name(fieldLine.substr(0, colon));
+        std::transform(name.begin(),
+                       name.end(),
+                       name.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        auto value = trim(fieldLine.substr(colon + 1));
+        if (name == "host")
+            fields[2].second.assign(value);
+        else if (!isConnectionSpecific(name))
+            fields.emplace_back(std::move(name), std::string(value));
+    }
+    if (fields[2].second.empty())
+        fields.erase(fields.begin() + 2);
+
+    auto streamId = nextStreamId_;
+    nextStreamId_ += 2;
+    auto &stream = streams_[streamId];
+    stream.callback = std::move(callback);
+    stream.sendWindow = initialSendWindow_;
+    std::string block;
+    encoder_.encode(fields, block);
+    appendHeaderBlock(
+        output_, streamId, block, body.empty(), peerMaxFrameSize_);
+    if (body.empty())
+    {
+        stream.localClosed = true;
+    }
+    else
+    {
+        stream.pending.assign(body);
+        scheduleStream(streamId, stream);
+    }
+    scheduleFlush();
+}
+
+void Http2ClientConnection::onMessage(trantor::MsgBuffer *buf)
+{
+    if (closed_)
+    {
+        buf->retrieveAll();
+        return;
+    }
+    while (!closed_ && buf->readableBytes() >= kFrameHeaderLength)
+    {
+        auto data = reinterpret_cast<const uint8_t *>(buf->peek());
+        auto header = parseFrameHeader(data);
+        // The SETTINGS_MAX_FRAME_SIZE of the client is the default one
+        if (header.length > kDefaultMaxFrameSize)
+        {
+            connectionError(ErrorCode::kFrameSizeError);
+            break;
+        }
+        if (buf->readableBytes() < kFrameHeaderLength + header.length)
+            break;
+        bool ok = onFrame(header, data + kFrameHeaderLength);
+        buf->retrieve(kFrameHeaderLength + header.length);
+        if (!ok)
+            break;
+    }
+    if (closed_)
+    {
+        buf->retrieveAll();
+        return;
+    }
+    flush();
+}
+
+void Http2ClientConnection::onClose(ReqResult result)
+{
+    closed_ = true;
+    writableStreams_.clear();
+    auto streams = std::move(streams_);
+    streams_.clear();
+    for (auto &[id, stream] : streams)
+    {
+        stream.callback(result, nullptr);
+    }
+}
+
+bool Http2ClientConnection::onFrame(const FrameHeader &header,
+                                    const uint8_t *payload)
+{
+    if (headerStreamId_ != 0 && header.type != FrameType::kContinuation)
+        return connectionError(ErrorCode::kProtocolError);
+    switch (header.type)
+    {
+        case FrameType::kData:
+            return onData(header, payload);
+        case FrameType::kHeaders:
+            return onHeaders(header, payload);
+        case FrameType::kPriority:
+            if (header.streamId == 0)
+                return connectionError(ErrorCode::kProtocolError);
+            return true;
+        case FrameType::kRstStream:
+        {
+            if (header.streamId == 0 || header.streamId >= nextStreamId_)
+                return connectionError(ErrorCode::kProtocolError);
+            if (header.length != 4)
+                return connectionError(ErrorCode::kFrameSizeError);
+            auto it = streams_.find(header.streamId);
+            if (it == streams_.end())
+                return true;
+            LOG_DEBUG << "Stream " << header.streamId << " reset, error "
+                      << readUint32(payload);
+            failStream(it, ReqResult::BadResponse);
+            return true;
+        }
+        case FrameType::kSettings:
+            return onSettings(header, payload);
+        case FrameType::kPushPromise:
+            // Push was disabled by the settings
+            return connectionError(ErrorCode::kProtocolError);
+        case FrameType::kPing:
+            if (header.streamId != 0)
+                return connectionError(ErrorCode::kProtocolError);
+            if (header.length != 8)
+                return connectionError(ErrorCode::kFrameSizeError);
+            if (!(header.flags & flags::kAck))
+            {
+                appendFrameHeader(output_, 8, FrameType::kPing, flags::kAck, 0);
+                output_.append(reinterpret_cast<const char *>(payload), 8);
+            }
+            return true;
+        case FrameType::kGoAway:
+            return onGoAway(header, payload);
+        case FrameType::kWindowUpdate:
+            return onWindowUpdate(header, payload);
+        case FrameType::kContinuation:
+            return onContinuation(header, payload);
+        default:
+            // Unknown frames are ignored
+            return true;
+    }
+}
+
+bool Http2ClientConnection::onHeaders(const FrameHeader &header,
+                                      const uint8_t *payload)
+{
+    if (header.streamId == 0 || header.streamId % 2 == 0 ||
+        header.streamId >= nextStreamId_)
+        return connectionError(ErrorCode::kProtocolError);
+    size_t pos = 0;
+    size_t end = header.length;
+    if (header.flags & flags::kPadded)
+    {
+        if (end < 1 || payload[0] >= end)
+            return connectionError(ErrorCode::kProtocolError);
+        end -= payload[0];
+        pos = 1;
+    }
+    if (header.flags & flags::kPriority)
+    {
+        if (end - pos < 5)
+            return connectionError(ErrorCode::kFrameSizeError);
+        pos += 5;
+    }
+    headerStreamId_ = header.streamId;
+    headerEndStream_ = (header.flags & flags::kEndStream) != 0;
+    headerBlock_.assign(reinterpret_cast<const char *>(payload) + pos,
+                        end - pos);
+    if (header.flags & flags::kEndHeaders)
+        return onHeaderBlock();
+    return true;
+}
+
+bool Http2ClientConnection::onContinuation(const FrameHeader &header,
+                                           const uint8_t *payload)
+{
+    if (headerStreamId_ == 0 || header.streamId != headerStreamId_)
+        return connectionError(ErrorCode::kProtocolError);
+    headerBlock_.append(reinterpret_cast<const char *>(payload),
+                        header.length);
+    if (headerBlock_.length() > kMaxHeaderBlockSize)
+        return connectionError(ErrorCode::kEnhanceYourCalm);
+    if (header.flags & flags::kEndHeaders)
+        return onHeaderBlock();
+    return true;
+}
+
+bool Http2ClientConnection::onHeaderBlock()
+{
+    auto streamId = headerStreamId_;
+    headerStreamId_ = 0;
+    HpackHeaders fields;
+    // The block is decoded even if the stream is gone, the dynamic table is
+    // shared by all the streams
+    if (!decoder_.decode(reinterpret_cast<const uint8_t *>(headerBlock_.data()),
+                         headerBlock_.length(),
+                         fields))
+    {
+        return connectionError(ErrorCode::kCompressionError);
+    }
+    headerBlock_.clear();
+
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return true;
+    auto &stream = it->second;
+    if (stream.response)
+    {
+        // Only the trailers may follow the response header
+        if (!headerEndStream_)
+        {
+            resetStream(it, ErrorCode::kProtocolError);
+            return true;
+        }
+        for (auto &[name, value] : fields)
+        {
+            if (name.empty() || name[0] == ':')
+            {
+                resetStream(it, ErrorCode::kProtocolError);
+                return true;
+            }
+        }
+        for (auto &[name, value] : fields)
+            stream.response->addTrailer(name, std::move(value));
+        completeStream(it);
+        return true;
+    }
+    int statusCode{0};
+    auto resp = newResponse(fields, statusCode);
+    if (!resp)
+    {
+        resetStream(it, ErrorCode::kProtocolError);
+        return true;
+    }
+    if (statusCode < 200)
+    {
+        // The informational responses are skipped
+        if (headerEndStream_)
+            resetStream(it, ErrorCode::kProtocolError);
+        return true;
+    }
+    stream.response = std::move(resp);
+    auto contentLength = stream.response->getHeaderBy("content-length");
+    if (!contentLength.empty())
+    {
+        auto length = std::strtoull(contentLength.c_str(), nullptr, 10);
+        stream.body.reserve(
+            static_cast<size_t>((std::min)(length, 64ull * 1024 * 1024)));
+    }
+    if (headerEndStream_)
+        completeStream(it);
+    return true;
+}
+
+HttpResponseImplPtr Http2ClientConnection::newResponse(
+    const HpackHeaders &fields,
+    int &statusCode)
+{
+    auto resp = std::make_shared<HttpResponseImpl>();
+    resp->setVersion(Version::kHttp2);
+    bool regularFields{false};
+    std::string line;
+    for (auto &[name, value] : fields)
+    {
+        if (!name.empty() && name[0] == ':')
+        {
+            // :status is the only pseudo-header field of a response
+            if (regularFields || name != ":status" || statusCode != 0 ||
+                value.length() != 3 ||
+                !std::all_of(value.begin(), value.end(), [](char c) {
+                    return c >= '0' && c <= '9';
+                }))
+                return nullptr;
+            statusCode = std::stoi(value);
+            continue;
+        }
+        regularFields = true;
+        if (isConnectionSpecific(name))
+            return nullptr;
+        // The set-cookie fields are parsed by the response
+        line.assign(name).append(":").append(value);
+        resp->addHeader(line.data(),
+                        line.data() + name.length(),
+                        line.data() + line.length());
+    }
+    if (statusCode < 100)
+        return nullptr;
+    resp->setStatusCode(static_cast<HttpStatusCode>(statusCode));
+    if (auto conn = conn_.lock())
+        resp->setPeerCertificate(conn->peerCertificate());
+    return resp;
+}
+
+bool Http2ClientConnection::onData(const FrameHeader &header,
+                                   const uint8_t *payload)
+{
+    if (header.streamId == 0 || header.streamId >= nextStreamId_)
+        return connectionError(ErrorCode::kProtocolError);
+    size_t pos = 0;
+    size_t end = header.length;
+    if (header.flags & flags::kPadded)
+    {
+        if (end < 1 || payload[0] >= end)
+            return connectionError(ErrorCode::kProtocolError);
+        end -= payload[0];
+        pos = 1;
+    }
+    // The whole frame counts against the windows
+    if (header.length > kRecvWindowSize - unackedRecv_)
+        return connectionError(ErrorCode::kFlowControlError);
+    unackedRecv_ += header.length;
+    if (unackedRecv_ >= kRecvWindowSize / 2)
+    {
+        appendWindowUpdate(output_, 0, unackedRecv_);
+        unackedRecv_ = 0;
+    }
+
+    // The data of the streams reset by the client may still arrive
+    auto it = streams_.find(header.streamId);
+    if (it == streams_.end())
+        return true;
+    auto &stream = it->second;
+    if (!stream.response)
+    {
+        resetStream(it, ErrorCode::kProtocolError);
+        return true;
+    }
+    if (header.length > kRecvWindowSize - stream.unackedRecv)
+    {
+        resetStream(it, ErrorCode::kFlowControlError);
+        return true;
+    }
+    stream.unackedRecv += header.length;
+    stream.body.append(reinterpret_cast<const char *>(payload) + pos,
+                       end - pos);
+    if (header.flags & flags::kEndStream)
+    {
+        completeStream(it);
+    }
+    else if (stream.unackedRecv >= kRecvWindowSize / 2)
+    {
+        appendWindowUpdate(output_, header.streamId, stream.unackedRecv);
+        stream.unackedRecv = 0;
+    }
+    return true;
+}
+
+bool Http2ClientConnection::onSettings(const FrameHeader &header,
+                                       const uint8_t *payload)
+{
+    if (header.streamId != 0)
+        return connectionError(ErrorCode::kProtocolError);
+    if (header.flags & flags::kAck)
+    {
+        if (header.length != 0)
+            return connectionError(ErrorCode::kFrameSizeError);
+        return true;
+    }
+    if (header.length % 6 != 0)
+        return connectionError(ErrorCode::kFrameSizeError);
+    for (size_t pos = 0; pos < header.length; pos += 6)
+    {
+        auto value = readUint32(payload + pos + 2);
+        switch (static_cast<Setting>(readUint16(payload + pos)))
+        {
+            case Setting::kHeaderTableSize:
+                encoder_.setMaxTableSize(value);
+                break;
+            case Setting::kEnablePush:
+                // Only a client may send it
+                if (value != 0)
+                    return connectionError(ErrorCode::kProtocolError);
+                break;
+            case Setting::kMaxConcurrentStreams:
+                peerMaxConcurrentStreams_ = value;
+                break;
+            case Setting::kInitialWindowSize:
+            {
+                if (value > kMaxWindowSize)
+                    return connectionError(ErrorCode::kFlowControlError);
+                // The change applies to the windows of the open streams
+                auto delta = static_cast<int64_t>(value) - initialSendWindow_;
+                initialSendWindow_ = value;
+                for (auto &[id, stream] : streams_)
+                {
+                    stream.sendWindow += delta;
+                    if (stream.sendWindow > kMaxWindowSize)
+                        return connectionError(ErrorCode::kFlowControlError);
+                    if (delta > 0 && !stream.localClosed)
+                        scheduleStream(id, stream);
+                }
+                break;
+            }
+            case Setting::kMaxFrameSize:
+                if (value < kDefaultMaxFrameSize || value > kMaxFrameSizeLimit)
+                    return connectionError(ErrorCode::kProtocolError);
+                peerMaxFrameSize_ = value;
+                break;
+            default:
+                break;
+        }
+    }
+    appendFrameHeader(output_, 0, FrameType::kSettings, flags::kAck, 0);
+    return true;
+}
+
+bool Http2ClientConnection::onWindowUpdate(const FrameHeader &header,
+                                           const uint8_t *payload)
+{
+    if (header.length != 4)
+        return connectionError(ErrorCode::kFrameSizeError);
+    auto increment = readUint32(payload) & 0x7fffffff;
+    if (header.streamId == 0)
+    {
+        if (increment == 0)
+            return connectionError(ErrorCode::kProtocolError);
+        sendWindow_ += increment;
+        if (sendWindow_ > kMaxWindowSize)
+            return connectionError(ErrorCode::kFlowControlError);
+        return true;
+    }
+    auto it = streams_.find(header.streamId);
+    if (it == streams_.end())
+        return true;
+    if (increment == 0)
+    {
+        resetStream(it, ErrorCode::kProtocolError);
+        return true;
+    }
+    it->second.sendWindow += increment;
+    if (it->second.sendWindow > kMaxWindowSize)
+    {
+        resetStream(it, ErrorCode::kFlowControlError);
+        return true;
+    }
+    if (!it->second.localClosed)
+        scheduleStream(header.streamId, it->second);
+    return true;
+}
+
+bool Http2ClientConnection::onGoAway(const FrameHeader &header,
+                                     const uint8_t *payload)
+{
+    if (header.streamId != 0)
+        return connectionError(ErrorCode::kProtocolError);
+    if (header.length < 8)
+        return connectionError(ErrorCode::kFrameSizeError);
+    auto lastStreamId = readUint32(payload) & 0x7fffffff;
+    LOG_DEBUG << "GOAWAY received, last stream " << lastStreamId << ", error "
+              << readUint32(payload + 4);
+    goingAway_ = true;
+    // The streams the server did not process can be retried on a new
+    // connection, they fail like the ones of a closed connection
+    for (auto it = streams_.begin(); it != streams_.end();)
+    {
+        if (it->first > lastStreamId)
+        {
+            auto callback = std::move(it->second.callback);
+            it = streams_.erase(it);
+            callback(ReqResult::NetworkFailure, nullptr);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    if (streamClosedCallback_)
+        streamClosedCallback_();
+    return true;
+}
+
+void Http2ClientConnection::completeStream(StreamMap::iterator it)
+{
+    auto streamId = it->first;
+    auto &stream = it->second;
+    // The rest of the body of the request is not needed anymore
+    if (!stream.localClosed)
+        appendRstStream(output_, streamId, ErrorCode::kCancel);
+    auto resp = std::move(stream.response);
+    if (!stream.body.empty())
+        resp->setBody(std::move(stream.body));
+    auto callback = std::move(stream.callback);
+    streams_.erase(it);
+    // The callback may send new requests
+    callback(ReqResult::Ok, resp);
+    if (streamClosedCallback_)
+        streamClosedCallback_();
+}
+
+void Http2ClientConnection::failStream(StreamMap::iterator it,
+                                       ReqResult result)
+{
+    auto callback = std::move(it->second.callback);
+    streams_.erase(it);
+    callback(result, nullptr);
+    if (streamClosedCallback_)
+        streamClosedCallback_();
+}
+
+void Http2ClientConnection::resetStream(StreamMap::iterator it,
+                                        ErrorCode error)
+{
+    appendRstStream(output_, it->first, error);
+    failStream(it, ReqResult::BadResponse);
+}
+
+bool Http2ClientConnection::connectionError(ErrorCode error)
+{
+    if (closed_)
+        return false;
+    LOG_DEBUG << "HTTP/2 connection error " << static_cast<uint32_t>(error);
+    appendGoAway(output_, 0, error);
+    sendOutput();
+    onClose(ReqResult::BadResponse);
+    if (auto conn = conn_.lock())
+        conn->shutdown();
+    return false;
+}
+
+void Http2ClientConnection::scheduleStream(uint32_t streamId, Stream &stream)
+{
+    if (stream.scheduled)
+        return;
+    stream.scheduled = true;
+    writableStreams_.push_back(streamId);
+}
+
+void Http2ClientConnection::scheduleFlush()
+{
+    // The requests sent in this loop iteration are written together
+    if (flushQueued_ || closed_)
+        return;
+    flushQueued_ = true;
+    loop_->queueInLoop([weakSelf = weak_from_this()]() {
+        auto self = weakSelf.lock();
+        if (!self)
+            return;
+        self->flushQueued_ = false;
+        self->flush();
+    });
+}
+
+void Http2ClientConnection::flush()
+{
+    if (closed_)
+        return;
+    if (!waitingForWrite_)
+        writeData();
+    sendOutput();
+}
+
+void Http2ClientConnection::writeData()
+{
+    while (!writableStreams_.empty() && sendWindow_ > 0 &&
+           output_.readableBytes() < kMaxWriteBatch)
+    {
+        auto streamId = writableStreams_.front();
+        writableStreams_.pop_front();
+        auto it = streams_.find(streamId);
+        if (it == streams_.end())
+            continue;
+        it->second.scheduled = false;
+        if (writeStreamData(streamId, it))
+        {
+            // The streams take turns
+            it->second.scheduled = true;
+            writableStreams_.push_back(streamId);
+        }
+    }
+    if (!writableStreams_.empty() && sendWindow_ > 0)
+    {
+        // The rest is written once this batch is
+        waitingForWrite_ = true;
+    }
+}
+
+bool Http2ClientConnection::writeStreamData(uint32_t streamId,
+                                            StreamMap::iterator it)
+{
+    auto &stream = it->second;
+    if (stream.localClosed)
+        return false;
+    auto window = (std::min)({sendWindow_,
+                              stream.sendWindow,
+                              static_cast<int64_t>(peerMaxFrameSize_)});
+    if (window <= 0)
+        return false;
+    auto available = stream.pending.length() - stream.pendingPos;
+    auto n = (std::min)(available, static_cast<size_t>(window));
+    bool endStream = n == available;
+    appendFrameHeader(output_,
+                      static_cast<uint32_t>(n),
+                      FrameType::kData,
+                      endStream ? flags::kEndStream : 0,
+                      streamId);
+    output_.append(stream.pending.data() + stream.pendingPos, n);
+    stream.pendingPos += n;
+    sendWindow_ -= n;
+    stream.sendWindow -= n;
+    if (endStream)
+    {
+        stream.localClosed = true;
+        std::string().swap(stream.pending);
+        stream.pendingPos = 0;
+        return false;
+    }
+    return true;
+}
+
+void Http2ClientConnection::sendOutput()
+{
+    if (output_.readableBytes() == 0)
+        return;
+    if (bytesSentCallback_)
+        bytesSentCallback_(output_.readableBytes());
+    if (auto conn = conn_.lock())
+        conn->send(output_);
+    output_.retrieveAll();
+}
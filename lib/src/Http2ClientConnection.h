@@ -0,0 +1,167 @@
+/**
+ *
+ *  @file Http2ClientConnection.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "Hpack.h"
+#include "Http2Frame.h"
+#include "impl_forwards.h"
+#include <drogon/HttpTypes.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief The client side of an HTTP/2 connection (RFC 9113).
+ *
+ * Every request is sent on a new stream as soon as the peer allows one more
+ * stream, so the requests to one server are multiplexed on one connection
+ * instead of being queued behind each other. The bodies of the requests take
+ * turns within the flow control windows. Server push is disabled.
+ *
+ * @note All the methods are called in the loop of the connection.
+ */
+class Http2ClientConnection
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<Http2ClientConnection>
+{
+  public:
+    using ResponseCallback =
+        std::function<void(ReqResult, const HttpResponseImplPtr &)>;
+
+    Http2ClientConnection(const trantor::TcpConnectionPtr &conn, bool secure);
+
+    /// Send the preface, the data received next begins with the settings.
+    void start();
+
+    /// Return true if a new stream can be opened now.
+    bool canOpenStream() const;
+
+    /**
+     * @brief Return true if the server sent GOAWAY or the connection is
+     * closed, the requests have to be sent on a new connection.
+     */
+    bool isGoingAway() const
+    {
+        return goingAway_ || closed_;
+    }
+
+    size_t streamCount() const
+    {
+        return streams_.size();
+    }
+
+    /// Send the request on a new stream, canOpenStream() must be true.
+    void sendRequest(const HttpRequestPtr &req, ResponseCallback &&callback);
+
+    void onMessage(trantor::MsgBuffer *buf);
+
+    /// Fail the requests of all the open streams.
+    void onClose(ReqResult result = ReqResult::NetworkFailure);
+
+    /**
+     * @brief Set the callback called after a stream is closed, when one more
+     * request may be sent.
+     */
+    void setStreamClosedCallback(std::function<void()> cb)
+    {
+        streamClosedCallback_ = std::move(cb);
+    }
+
+    /// Set the callback called with the number of bytes of every write.
+    void setBytesSentCallback(std::function<void(size_t)> cb)
+    {
+        bytesSentCallback_ = std::move(cb);
+    }
+
+  private:
+    struct Stream
+    {
+        ResponseCallback callback;
+        HttpResponseImplPtr response;
+        std::string body;
+        int64_t sendWindow{0};
+        uint32_t unackedRecv{0};
+        // The body of the request not yet sent
+        std::string pending;
+        size_t pendingPos{0};
+        bool localClosed{false};
+        bool scheduled{false};
+    };
+
+    using StreamMap = std::unordered_map<uint32_t, Stream>;
+
+    bool onFrame(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onHeaders(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onContinuation(const http2::FrameHeader &header,
+                        const uint8_t *payload);
+    bool onHeaderBlock();
+    bool onData(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onSettings(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onWindowUpdate(const http2::FrameHeader &header,
+                        const uint8_t *payload);
+    bool onGoAway(const http2::FrameHeader &header, const uint8_t *payload);
+
+    HttpResponseImplPtr newResponse(const HpackHeaders &fields,
+                                    int &statusCode);
+    void completeStream(StreamMap::iterator it);
+    void failStream(StreamMap::iterator it, ReqResult result);
+    void resetStream(StreamMap::iterator it, http2::ErrorCode error);
+    bool connectionError(http2::ErrorCode error);
+    void scheduleStream(uint32_t streamId, Stream &stream);
+    void scheduleFlush();
+    void flush();
+    void writeData();
+    bool writeStreamData(uint32_t streamId, StreamMap::iterator it);
+    void sendOutput();
+
+    std::weak_ptr<trantor::TcpConnection> conn_;
+    trantor::EventLoop *loop_;
+    bool secure_;
+    HpackDecoder decoder_;
+    HpackEncoder encoder_;
+    StreamMap streams_;
+    // The streams with request bodies to send, in the order of their turns
+    std::deque<uint32_t> writableStreams_;
+    trantor::MsgBuffer output_;
+    std::function<void()> streamClosedCallback_;
+    std::function<void(size_t)> bytesSentCallback_;
+
+    bool flushQueued_{false};
+    bool waitingForWrite_{false};
+    bool goingAway_{false};
+    bool closed_{false};
+    uint32_t nextStreamId_{1};
+    // The header block being received in CONTINUATION frames
+    uint32_t headerStreamId_{0};
+    bool headerEndStream_{false};
+    std::string headerBlock_;
+
+    int64_t sendWindow_{http2::kDefaultWindowSize};
+    int64_t initialSendWindow_{http2::kDefaultWindowSize};
+    uint32_t peerMaxFrameSize_{http2::kDefaultMaxFrameSize};
+    // The limit assumed until the settings of the server arrive, which
+    // should not be below 100 (RFC 9113 6.5.2)
+    uint32_t peerMaxConcurrentStreams_{100};
+    uint32_t unackedRecv_{0};
+};
+
+using Http2ClientConnectionPtr = std::shared_ptr<Http2ClientConnection>;
+}  // namespace drogon
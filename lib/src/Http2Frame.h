@@ -0,0 +1,218 @@
+/**
+ *
+ *  @file Http2Frame.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/MsgBuffer.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace drogon
+{
+/// The framing layer of HTTP/2 (RFC 9113).
+namespace http2
+{
+constexpr std::string_view kConnectionPreface{
+    "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"};
+constexpr size_t kFrameHeaderLength = 9;
+constexpr uint32_t kDefaultWindowSize = 65535;
+constexpr uint32_t kMaxWindowSize = 0x7fffffff;
+constexpr uint32_t kDefaultMaxFrameSize = 16384;
+constexpr uint32_t kMaxFrameSizeLimit = 16777215;
+
+enum class FrameType : uint8_t
+{
+    kData = 0x0,
+    kHeaders = 0x1,
+    kPriority = 0x2,
+    kRstStream = 0x3,
+    kSettings = 0x4,
+    kPushPromise = 0x5,
+    kPing = 0x6,
+    kGoAway = 0x7,
+    kWindowUpdate = 0x8,
+    kContinuation = 0x9
+};
+
+namespace flags
+{
+constexpr uint8_t kEndStream = 0x1;
+constexpr uint8_t kAck = 0x1;
+constexpr uint8_t kEndHeaders = 0x4;
+constexpr uint8_t kPadded = 0x8;
+constexpr uint8_t kPriority = 0x20;
+}  // namespace flags
+
+enum class Setting : uint16_t
+{
+    kHeaderTableSize = 0x1,
+    kEnablePush = 0x2,
+    kMaxConcurrentStreams = 0x3,
+    kInitialWindowSize = 0x4,
+    kMaxFrameSize = 0x5,
+    kMaxHeaderListSize = 0x6
+};
+
+enum class ErrorCode : uint32_t
+{
+    kNoError = 0x0,
+    kProtocolError = 0x1,
+    kInternalError = 0x2,
+    kFlowControlError = 0x3,
+    kSettingsTimeout = 0x4,
+    kStreamClosed = 0x5,
+    kFrameSizeError = 0x6,
+    kRefusedStream = 0x7,
+    kCancel = 0x8,
+    kCompressionError = 0x9,
+    kConnectError = 0xa,
+    kEnhanceYourCalm = 0xb,
+    kInadequateSecurity = 0xc,
+    kHttp11Required = 0xd
+};
+
+struct FrameHeader
+{
+    uint32_t length;
+    FrameType type;
+    uint8_t flags;
+    uint32_t streamId;
+};
+
+inline uint16_t readUint16(const uint8_t *p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline uint32_t readUint32(const uint8_t *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+/// The fields which are not allowed in HTTP/2 (RFC 9113 8.2.2).
+inline bool isConnectionSpecific(std::string_view name)
+{
+    return name == "connection" || name == "keep-alive" ||
+           name == "proxy-connection" || name == "transfer-encoding" ||
+           name == "upgrade";
+}
+
+/// Parse the 9 bytes of a frame header.
+inline FrameHeader parseFrameHeader(const uint8_t *p)
+{
+    FrameHeader header;
+    header.length = (static_cast<uint32_t>(p[0]) << 16) |
+                    (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    header.type = static_cast<FrameType>(p[3]);
+    header.flags = p[4];
+    // The reserved bit is ignored
+    header.streamId = readUint32(p + 5) & 0x7fffffff;
+    return header;
+}
+
+/// Write the 9 bytes of a frame header to p.
+inline void writeFrameHeader(char *p,
+                             uint32_t length,
+                             FrameType type,
+                             uint8_t flags,
+                             uint32_t streamId)
+{
+    p[0] = static_cast<char>(length >> 16);
+    p[1] = static_cast<char>(length >> 8);
+    p[2] = static_cast<char>(length);
+    p[3] = static_cast<char>(type);
+    p[4] = static_cast<char>(flags);
+    p[5] = static_cast<char>(streamId >> 24);
+    p[6] = static_cast<char>(streamId >> 16);
+    p[7] = static_cast<char>(streamId >> 8);
+    p[8] = static_cast<char>(streamId);
+}
+
+inline void appendFrameHeader(trantor::MsgBuffer &out,
+                              uint32_t length,
+                              FrameType type,
+                              uint8_t flags,
+                              uint32_t streamId)
+{
+    out.ensureWritableBytes(kFrameHeaderLength);
+    writeFrameHeader(out.beginWrite(), length, type, flags, streamId);
+    out.hasWritten(kFrameHeaderLength);
+}
+
+inline void appendSetting(trantor::MsgBuffer &out,
+                          Setting setting,
+                          uint32_t value)
+{
+    out.appendInt16(static_cast<uint16_t>(setting));
+    out.appendInt32(value);
+}
+
+inline void appendWindowUpdate(trantor::MsgBuffer &out,
+                               uint32_t streamId,
+                               uint32_t increment)
+{
+    appendFrameHeader(out, 4, FrameType::kWindowUpdate, 0, streamId);
+    out.appendInt32(increment);
+}
+
+inline void appendRstStream(trantor::MsgBuffer &out,
+                            uint32_t streamId,
+                            ErrorCode error)
+{
+    appendFrameHeader(out, 4, FrameType::kRstStream, 0, streamId);
+    out.appendInt32(static_cast<uint32_t>(error));
+}
+
+inline void appendGoAway(trantor::MsgBuffer &out,
+                         uint32_t lastStreamId,
+                         ErrorCode error)
+{
+    appendFrameHeader(out, 8, FrameType::kGoAway, 0, 0);
+    out.appendInt32(lastStreamId);
+    out.appendInt32(static_cast<uint32_t>(error));
+}
+
+/**
+ * @brief Append a header block as a HEADERS frame followed by the
+ * CONTINUATION frames it needs.
+ */
+inline void appendHeaderBlock(trantor::MsgBuffer &out,
+                              uint32_t streamId,
+                              std::string_view block,
+                              bool endStream,
+                              uint32_t maxFrameSize)
+{
+    auto type = FrameType::kHeaders;
+    uint8_t frameFlags = endStream ? flags::kEndStream : 0;
+    do
+    {
+        auto length = (std::min)(block.length(), size_t(maxFrameSize));
+        if (length == block.length())
+            frameFlags |= flags::kEndHeaders;
+        appendFrameHeader(out,
+                          static_cast<uint32_t>(length),
+                          type,
+                          frameFlags,
+                          streamId);
+        out.append(block.data(), length);
+        block.remove_prefix(length);
+        type = FrameType::kContinuation;
+        frameFlags = 0;
+    } while (!block.empty());
+}
+}  // namespace http2
+}  // namespace drogon
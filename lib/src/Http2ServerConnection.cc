@@ -0,0 +1,1043 @@
+/**
+ *
+ *  @file Http2ServerConnection.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http2ServerConnection.h"
+#include "HttpAppFrameworkImpl.h"
+#include "HttpControllersRouter.h"
+#include "HttpRequestImpl.h"
+#include "HttpRequestPool.h"
+#include <drogon/HttpResponse.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+
+using namespace drogon;
+using namespace drogon::http2;
+
+namespace
+{
+constexpr uint32_t kMaxConcurrentStreams = 100;
+// The receive windows of the connection and of every stream, they are
+// replenished once half of them is consumed
+constexpr uint32_t kRecvWindowSize = 1024 * 1024;
+// The data of the streams written before waiting for the socket to drain
+constexpr size_t kMaxWriteBatch = 256 * 1024;
+constexpr size_t kMaxHeaderBlockSize = 64 * 1024;
+// The streams the client may reset in a second before the connection is
+// closed, against the rapid reset attack (CVE-2023-44487)
+constexpr size_t kMaxResetsPerSecond = 2 * kMaxConcurrentStreams;
+// The output not sent yet, because the client doesn't read it, past which
+// the connection is closed. The data of the responses only take
+// kMaxWriteBatch of it, the rest is made of the frames answering the ones
+// of the client.
+constexpr size_t kMaxUnsentOutput = 4 * 1024 * 1024;
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t' ||
+                            str.back() == '\r'))
+        str.remove_suffix(1);
+    return str;
+}
+}  // namespace
+
+namespace drogon
+{
+/**
+ * @brief The body of a response pushed from any thread into the loop of its
+ * connection.
+ */
+class Http2AsyncStream : public trantor::AsyncStream
+{
+  public:
+    Http2AsyncStream(std::weak_ptr<Http2ServerConnection> conn,
+                     trantor::EventLoop *loop,
+                     uint32_t streamId)
+        : conn_(std::move(conn)), loop_(loop), streamId_(streamId)
+    {
+    }
+
+    bool send(const char *data, size_t len) override
+    {
+        auto conn = conn_.lock();
+        if (!conn)
+            return false;
+        loop_->runInLoop([conn = std::move(conn),
+                          streamId = streamId_,
+                          data = std::string(data, len)]() mutable {
+            conn->pushData(streamId, std::move(data));
+        });
+        return true;
+    }
+
+    void close() override
+    {
+        auto conn = conn_.lock();
+        conn_.reset();
+        if (!conn)
+            return;
+        loop_->runInLoop([conn = std::move(conn), streamId = streamId_]() {
+            conn->endData(streamId);
+        });
+    }
+
+  private:
+    std::weak_ptr<Http2ServerConnection> conn_;
+    trantor::EventLoop *loop_;
+    uint32_t streamId_;
+};
+}  // namespace drogon
+
+Http2ServerConnection::Http2ServerConnection(
+    const trantor::TcpConnectionPtr &conn,
+    RequestHandler handler)
+    : conn_(conn),
+      loop_(conn->getLoop()),
+      peerAddr_(conn->peerAddr()),
+      localAddr_(conn->localAddr()),
+      handler_(std::move(handler)),
+      decoder_(4096, kMaxHeaderBlockSize)
+{
+}
+
+bool Http2ServerConnection::isUpgradeRequest(const HttpRequestImplPtr &req)
+{
+    auto upgrade = req->getHeaderView(HttpHeaderId::kUpgrade);
+    if (upgrade.length() != 3 || upgrade != "h2c" ||
+        req->getHeaderView(HttpHeaderId::kHttp2Settings).empty())
+        return false;
+    std::string connection(
+        req->getHeaderView(HttpHeaderId::kConnection));
+    std::transform(connection.begin(),
+                   connection.end(),
+                   connection.begin(),
+                   [](unsigned char c) { return tolower(c); });
+    return connection.find("upgrade") != std::string::npos &&
+           connection.find("http2-settings") != std::string::npos;
+}
+
+void Http2ServerConnection::start()
+{
+    auto conn = conn_.lock();
+    if (!conn)
+        return;
+    // Resume the data of the streams once a batch is written
+    conn->setWriteCompleteCallback(
+        [weakSelf = weak_from_this()](const trantor::TcpConnectionPtr &) {
+            auto self = weakSelf.lock();
+            if (!self)
+                return;
+            self->waitingForWrite_ = false;
+            self->flush();
+        });
+    // A client which sends frames without reading the answers, such as PING
+    // or SETTINGS acks, would grow the output without a bound
+    conn->setHighWaterMarkCallback(
+        [weakSelf = weak_from_this()](const trantor::TcpConnectionPtr &,
+                                      size_t) {
+            if (auto self = weakSelf.lock())
+                self->onOutputOverflow();
+        },
+        kMaxUnsentOutput);
+    appendFrameHeader(output_, 4 * 6, FrameType::kSettings, 0, 0);
+    appendSetting(output_, Setting::kEnablePush, 0);
+    appendSetting(output_,
+                  Setting::kMaxConcurrentStreams,
+                  kMaxConcurrentStreams);
+    appendSetting(output_, Setting::kInitialWindowSize, kRecvWindowSize);
+    appendSetting(output_, Setting::kMaxHeaderListSize, kMaxHeaderBlockSize);
+    appendWindowUpdate(output_, 0, kRecvWindowSize - kDefaultWindowSize);
+    sendOutput();
+}
+
+void Http2ServerConnection::upgrade(const HttpRequestImplPtr &req)
+{
+    static const std::string switchingProtocols{
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "connection: Upgrade\r\n"
+        "upgrade: h2c\r\n\r\n"};
+    output_.append(switchingProtocols);
+    // The settings of the client are in the HTTP2-Settings header, in the
+    // URL-safe base64 encoding which the decoder also accepts
+    auto settings = utils::base64Decode(
+        req->getHeaderView(HttpHeaderId::kHttp2Settings));
+    if (!applySettings(reinterpret_cast<const uint8_t *>(settings.data()),
+                       settings.length()))
+    {
+        connectionError(ErrorCode::kProtocolError);
+        return;
+    }
+    start();
+    lastStreamId_ = 1;
+    auto &stream = streams_[1];
+    stream.sendWindow = initialSendWindow_;
+    stream.request = req;
+    req->setVersion(Version::kHttp2);
+    onRemoteClosed(1, stream);
+}
+
+void Http2ServerConnection::onMessage(trantor::MsgBuffer *buf)
+{
+    if (closed_)
+    {
+        buf->retrieveAll();
+        return;
+    }
+    if (!prefaceReceived_)
+    {
+        auto len =
+            (std::min)(buf->readableBytes(), kConnectionPreface.length());
+        if (std::string_view(buf->peek(), len) !=
+            kConnectionPreface.substr(0, len))
+        {
+            LOG_DEBUG << "Invalid HTTP/2 connection preface";
+            connectionError(ErrorCode::kProtocolError);
+            buf->retrieveAll();
+            return;
+        }
+        if (len < kConnectionPreface.length())
+            return;
+        buf->retrieve(len);
+        prefaceReceived_ = true;
+    }
+    while (!closed_ && buf->readableBytes() >= kFrameHeaderLength)
+    {
+        auto data = reinterpret_cast<const uint8_t *>(buf->peek());
+        auto header = parseFrameHeader(data);
+        // The SETTINGS_MAX_FRAME_SIZE of the server is the default one
+        if (header.length > kDefaultMaxFrameSize)
+        {
+            connectionError(ErrorCode::kFrameSizeError);
+            break;
+        }
+        if (buf->readableBytes() < kFrameHeaderLength + header.length)
+            break;
+        bool ok = onFrame(header, data + kFrameHeaderLength);
+        buf->retrieve(kFrameHeaderLength + header.length);
+        if (!ok)
+            break;
+    }
+    if (closed_)
+    {
+        buf->retrieveAll();
+        return;
+    }
+    // The frames answering all the frames received are sent at once
+    flush();
+}
+
+void Http2ServerConnection::onClose()
+{
+    closed_ = true;
+    for (auto &[id, stream] : streams_)
+    {
+        if (stream.source)
+            stream.source(nullptr, 0);
+    }
+    streams_.clear();
+    writableStreams_.clear();
+}
+
+bool Http2ServerConnection::onFrame(const FrameHeader &header,
+                                    const uint8_t *payload)
+{
+    if (!settingsReceived_ && header.type != FrameType::kSettings)
+        return connectionError(ErrorCode::kProtocolError);
+    if (headerStreamId_ != 0 && header.type != FrameType::kContinuation)
+        return connectionError(ErrorCode::kProtocolError);
+    switch (header.type)
+    {
+        case FrameType::kData:
+            return onData(header, payload);
+        case FrameType::kHeaders:
+            return onHeaders(header, payload);
+        case FrameType::kPriority:
+            if (header.streamId == 0)
+                return connectionError(ErrorCode::kProtocolError);
+            if (header.length != 5)
+                resetStream(header.streamId, ErrorCode::kFrameSizeError);
+            return true;
+        case FrameType::kRstStream:
+        {
+            if (header.streamId == 0 || header.streamId > lastStreamId_)
+                return connectionError(ErrorCode::kProtocolError);
+            if (header.length != 4)
+                return connectionError(ErrorCode::kFrameSizeError);
+            auto it = streams_.find(header.streamId);
+            if (it != streams_.end())
+            {
+                LOG_TRACE << "Stream " << header.streamId << " reset, error "
+                          << readUint32(payload);
+                if (it->second.source)
+                    it->second.source(nullptr, 0);
+                streams_.erase(it);
+                return onClientReset();
+            }
+            return true;
+        }
+        case FrameType::kSettings:
+            return onSettings(header, payload);
+        case FrameType::kPushPromise:
+            return connectionError(ErrorCode::kProtocolError);
+        case FrameType::kPing:
+            if (header.streamId != 0)
+                return connectionError(ErrorCode::kProtocolError);
+            if (header.length != 8)
+                return connectionError(ErrorCode::kFrameSizeError);
+            if (!(header.flags & flags::kAck))
+            {
+                appendFrameHeader(output_, 8, FrameType::kPing, flags::kAck, 0);
+                output_.append(reinterpret_cast<const char *>(payload), 8);
+            }
+            return true;
+        case FrameType::kGoAway:
+            if (header.streamId != 0)
+                return connectionError(ErrorCode::kProtocolError);
+            // The client opens no more streams, the open ones are finished
+            LOG_TRACE << "GOAWAY received";
+            return true;
+        case FrameType::kWindowUpdate:
+            return onWindowUpdate(header, payload);
+        case FrameType::kContinuation:
+            return onContinuation(header, payload);
+        default:
+            // Unknown frames are ignored
+            return true;
+    }
+}
+
+bool Http2ServerConnection::onHeaders(const FrameHeader &header,
+                                      const uint8_t *payload)
+{
+    if (header.streamId == 0 || header.streamId % 2 == 0)
+        return connectionError(ErrorCode::kProtocolError);
+    size_t pos = 0;
+    size_t end = header.length;
+    if (header.flags & flags::kPadded)
+    {
+        if (end < 1 || payload[0] >= end)
+            return connectionError(ErrorCode::kProtocolError);
+        end -= payload[0];
+        pos = 1;
+    }
+    if (header.flags & flags::kPriority)
+    {
+        if (end - pos < 5)
+            return connectionError(ErrorCode::kFrameSizeError);
+        pos += 5;
+    }
+    headerStreamId_ = header.streamId;
+    headerEndStream_ = (header.flags & flags::kEndStream) != 0;
+    headerBlock_.assign(reinterpret_cast<const char *>(payload) + pos,
+                        end - pos);
+    if (header.flags & flags::kEndHeaders)
+        return onHeaderBlock();
+    return true;
+}
+
+bool Http2ServerConnection::onContinuation(const FrameHeader &header,
+                                           const uint8_t *payload)
+{
+    if (headerStreamId_ == 0 || header.streamId != headerStreamId_)
+        return connectionError(ErrorCode::kProtocolError);
+    headerBlock_.append(reinterpret_cast<const char *>(payload),
+                        header.length);
+    if (headerBlock_.length() > kMaxHeaderBlockSize)
+        return connectionError(ErrorCode::kEnhanceYourCalm);
+    if (header.flags & flags::kEndHeaders)
+        return onHeaderBlock();
+    return true;
+}
+
+bool Http2ServerConnection::onHeaderBlock()
+{
+    auto streamId = headerStreamId_;
+    headerStreamId_ = 0;
+    HpackHeaders fields;
+    // The block is decoded even if the stream is refused, the dynamic table
+    // is shared by all the streams
+    if (!decoder_.decode(reinterpret_cast<const uint8_t *>(headerBlock_.data()),
+                         headerBlock_.length(),
+                         fields))
+    {
+        return connectionError(ErrorCode::kCompressionError);
+    }
+    headerBlock_.clear();
+
+    if (streamId <= lastStreamId_)
+    {
+        // Only the trailers of an open stream may follow its headers, the
+        // ones of the streams closed by the server are ignored
+        auto it = streams_.find(streamId);
+        if (it == streams_.end())
+            return true;
+        if (it->second.remoteClosed)
+            resetStream(streamId, ErrorCode::kStreamClosed);
+        else if (!headerEndStream_)
+            resetStream(streamId, ErrorCode::kProtocolError);
+        else
+            onRemoteClosed(streamId, it->second);  // The trailers are dropped
+        return true;
+    }
+    lastStreamId_ = streamId;
+    // The handlers of the streams reset by the client are still running
+    if (goingAway_ ||
+        (std::max)(streams_.size(), runningHandlers_) >= kMaxConcurrentStreams)
+    {
+        resetStream(streamId, ErrorCode::kRefusedStream);
+        return true;
+    }
+    auto req = newRequest(fields);
+    if (!req)
+    {
+        resetStream(streamId, ErrorCode::kProtocolError);
+        return true;
+    }
+    auto &stream = streams_[streamId];
+    stream.sendWindow = initialSendWindow_;
+    stream.request = std::move(req);
+    if (headerEndStream_)
+    {
+        onRemoteClosed(streamId, stream);
+    }
+    else
+    {
+        auto &router = HttpControllersRouter::instance();
+        if (router.hasBodyLimits())
+        {
+            stream.request->setBodyLimit(
+                router.bodyLimitOf(*stream.request));
+        }
+        auto contentLength = stream.request->getContentLengthHeaderValue();
+        if (contentLength.has_value() &&
+            contentLength.value() <= stream.request->maxBodySize())
+        {
+            // The flow control windows bound what the stream receives, if
+            // the memory budget is used up, appendToBody() moves the body to
+            // a temporary file.
+            (void)stream.request->reserveBodySize(contentLength.value());
+        }
+    }
+    return true;
+}
+
+bool Http2ServerConnection::onData(const FrameHeader &header,
+                                   const uint8_t *payload)
+{
+    if (header.streamId == 0)
+        return connectionError(ErrorCode::kProtocolError);
+    size_t pos = 0;
+    size_t end = header.length;
+    if (header.flags & flags::kPadded)
+    {
+        if (end < 1 || payload[0] >= end)
+            return connectionError(ErrorCode::kProtocolError);
+        end -= payload[0];
+        pos = 1;
+    }
+    // The whole frame counts against the windows
+    if (header.length > kRecvWindowSize - unackedRecv_)
+        return connectionError(ErrorCode::kFlowControlError);
+    unackedRecv_ += header.length;
+    if (unackedRecv_ >= kRecvWindowSize / 2)
+    {
+        appendWindowUpdate(output_, 0, unackedRecv_);
+        unackedRecv_ = 0;
+    }
+
+    auto it = streams_.find(header.streamId);
+    if (it == streams_.end() || it->second.remoteClosed)
+    {
+        if (header.streamId > lastStreamId_)
+            return connectionError(ErrorCode::kProtocolError);
+        // The data of the streams closed by the server may still arrive
+        if (it != streams_.end())
+            resetStream(header.streamId, ErrorCode::kStreamClosed);
+        return true;
+    }
+    auto &stream = it->second;
+    if (header.length > kRecvWindowSize - stream.unackedRecv)
+    {
+        resetStream(header.streamId, ErrorCode::kFlowControlError);
+        return true;
+    }
+    stream.unackedRecv += header.length;
+    stream.bodyLength += end - pos;
+    if (stream.bodyLength > stream.request->maxBodySize())
+    {
+        respondError(header.streamId, k413RequestEntityTooLarge);
+        return true;
+    }
+    stream.request->appendToBody(reinterpret_cast<const char *>(payload) + pos,
+                                 end - pos);
+    if (header.flags & flags::kEndStream)
+    {
+        onRemoteClosed(header.streamId, stream);
+    }
+    else if (stream.unackedRecv >= kRecvWindowSize / 2)
+    {
+        appendWindowUpdate(output_, header.streamId, stream.unackedRecv);
+        stream.unackedRecv = 0;
+    }
+    return true;
+}
+
+bool Http2ServerConnection::onSettings(const FrameHeader &header,
+                                       const uint8_t *payload)
+{
+    if (header.streamId != 0)
+        return connectionError(ErrorCode::kProtocolError);
+    if (header.flags & flags::kAck)
+    {
+        if (header.length != 0)
+            return connectionError(ErrorCode::kFrameSizeError);
+        return true;
+    }
+    if (header.length % 6 != 0)
+        return connectionError(ErrorCode::kFrameSizeError);
+    if (!applySettings(payload, header.length))
+        return false;
+    settingsReceived_ = true;
+    appendFrameHeader(output_, 0, FrameType::kSettings, flags::kAck, 0);
+    return true;
+}
+
+bool Http2ServerConnection::applySettings(const uint8_t *payload,
+                                          size_t length)
+{
+    for (size_t pos = 0; pos + 6 <= length; pos += 6)
+    {
+        auto value = readUint32(payload + pos + 2);
+        switch (static_cast<Setting>(readUint16(payload + pos)))
+        {
+            case Setting::kHeaderTableSize:
+                encoder_.setMaxTableSize(value);
+                break;
+            case Setting::kEnablePush:
+                if (value > 1)
+                    return connectionError(ErrorCode::kProtocolError);
+                break;
+            case Setting::kInitialWindowSize:
+            {
+                if (value > kMaxWindowSize)
+                    return connectionError(ErrorCode::kFlowControlError);
+                // The change applies to the windows of the open streams
+                auto delta = static_cast<int64_t>(value) - initialSendWindow_;
+                initialSendWindow_ = value;
+                for (auto &[id, stream] : streams_)
+                {
+                    stream.sendWindow += delta;
+                    if (stream.sendWindow > kMaxWindowSize)
+                        return connectionError(ErrorCode::kFlowControlError);
+                    if (delta > 0)
+                        scheduleStream(id, stream);
+                }
+                break;
+            }
+            case Setting::kMaxFrameSize:
+                if (value < kDefaultMaxFrameSize || value > kMaxFrameSizeLimit)
+                    return connectionError(ErrorCode::kProtocolError);
+                peerMaxFrameSize_ = value;
+                break;
+            default:
+                // The other settings limit what the client receives
+                break;
+        }
+    }
+    return true;
+}
+
+bool Http2ServerConnection::onWindowUpdate(const FrameHeader &header,
+                                           const uint8_t *payload)
+{
+    if (header.length != 4)
+        return connectionError(ErrorCode::kFrameSizeError);
+    auto increment = readUint32(payload) & 0x7fffffff;
+    if (header.streamId == 0)
+    {
+        if (increment == 0)
+            return connectionError(ErrorCode::kProtocolError);
+        sendWindow_ += increment;
+        if (sendWindow_ > kMaxWindowSize)
+            return connectionError(ErrorCode::kFlowControlError);
+        return true;
+    }
+    auto it = streams_.find(header.streamId);
+    if (it == streams_.end())
+        return true;
+    if (increment == 0)
+    {
+        resetStream(header.streamId, ErrorCode::kProtocolError);
+        return true;
+    }
+    it->second.sendWindow += increment;
+    if (it->second.sendWindow > kMaxWindowSize)
+    {
+        resetStream(header.streamId, ErrorCode::kFlowControlError);
+        return true;
+    }
+    scheduleStream(header.streamId, it->second);
+    return true;
+}
+
+HttpRequestImplPtr Http2ServerConnection::newRequest(
+    const HpackHeaders &fields)
+{
+    auto conn = conn_.lock();
+    if (!conn)
+        return nullptr;
+    auto req = HttpRequestPool::acquire(loop_);
+    req->setVersion(Version::kHttp2);
+    const std::string *method{nullptr};
+    const std::string *path{nullptr};
+    const std::string *scheme{nullptr};
+    const std::string *authority{nullptr};
+    bool hasHost{false};
+    bool regularFields{false};
+    std::string line;
+    for (auto &[name, value] : fields)
+    {
+        if (!name.empty() && name[0] == ':')
+        {
+            // The pseudo-header fields come first and only once
+            const std::string **field;
+            if (name == ":method")
+                field = &method;
+            else if (name == ":path")
+                field = &path;
+            else if (name == ":scheme")
+                field = &scheme;
+            else if (name == ":authority")
+                field = &authority;
+            else
+                return nullptr;
+            if (regularFields || *field)
+                return nullptr;
+            *field = &value;
+            continue;
+        }
+        regularFields = true;
+        if (std::any_of(name.begin(), name.end(), [](char c) {
+                return c >= 'A' && c <= 'Z';
+            }))
+            return nullptr;
+        if (isConnectionSpecific(name) || (name == "te" && value != "trailers"))
+            return nullptr;
+        if (name == "host")
+            hasHost = true;
+        // The cookie fields are parsed by the request
+        line.assign(name).append(":").append(value);
+        req->addHeader(line.data(),
+                       line.data() + name.length(),
+                       line.data() + line.length());
+    }
+    if (!method || !path || !scheme || path->empty())
+        return nullptr;
+    if (!req->setMethod(method->data(), method->data() + method->length()))
+        return nullptr;
+    auto question = std::find(path->begin(), path->end(), '?');
+    req->setPath(path->data(), path->data() + (question - path->begin()));
+    if (question != path->end())
+        req->setQuery(&*question + 1, path->data() + path->length());
+    if (authority && !hasHost)
+    {
+        line.assign("host:").append(*authority);
+        req->addHeader(line.data(),
+                       line.data() + 4,
+                       line.data() + line.length());
+    }
+    req->setPeerAddr(peerAddr_);
+    req->setLocalAddr(localAddr_);
+    req->setCreationDate(trantor::Date::date());
+    req->setSecure(conn->isSSLConnection());
+    req->setPeerCertificate(conn->peerCertificate());
+    req->setConnectionPtr(conn);
+    return req;
+}
+
+void Http2ServerConnection::onRemoteClosed(uint32_t streamId, Stream &stream)
+{
+    stream.remoteClosed = true;
+    // The handler may answer at once, the stream is not used after the call
+    auto req = std::move(stream.request);
+    if (req)
+        handler_(shared_from_this(), streamId, req);
+}
+
+void Http2ServerConnection::sendHeaders(uint32_t streamId,
+                                        const trantor::MsgBuffer &header,
+                                        bool endStream)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+    std::string_view text(header.peek(), header.readableBytes());
+    auto eol = text.find("\r\n");
+    auto statusLine = text.substr(0, eol);
+    auto space = statusLine.find(' ');
+    if (space == std::string_view::npos)
+    {
+        LOG_ERROR << "Invalid response header";
+        resetStream(streamId, ErrorCode::kInternalError);
+        return;
+    }
+    HpackHeaders fields;
+    fields.emplace_back(":status",
+                        std::string(trim(statusLine.substr(space + 1, 3))));
+    while (eol != std::string_view::npos)
+    {
+        text.remove_prefix(eol + 2);
+        eol = text.find("\r\n");
+        auto fieldLine = text.substr(0, eol);
+        auto colon = fieldLine.find(':');
+        if (colon == std::string_view::npos)
+            continue;
+        std::string name(fieldLine.substr(0, colon));
+        std::transform(name.begin(),
+                       name.end(),
+                       name.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (isConnectionSpecific(name))
+            continue;
+        fields.emplace_back(std::move(name),
+                            std::string(trim(fieldLine.substr(colon + 1))));
+    }
+    writeHeaders(streamId, fields, endStream);
+    if (endStream)
+        closeLocal(it);
+    scheduleFlush();
+}
+
+void Http2ServerConnection::sendBody(uint32_t streamId, DataCallback callback)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+    {
+        callback(nullptr, 0);
+        return;
+    }
+    it->second.source = std::move(callback);
+    scheduleStream(streamId, it->second);
+    scheduleFlush();
+}
+
+trantor::AsyncStreamPtr Http2ServerConnection::newAsyncStream(
+    uint32_t streamId)
+{
+    return std::make_unique<Http2AsyncStream>(weak_from_this(),
+                                              loop_,
+                                              streamId);
+}
+
+void Http2ServerConnection::setResponse(uint32_t streamId,
+                                        const HttpResponsePtr &response)
+{
+    auto it = streams_.find(streamId);
+    if (it != streams_.end())
+        it->second.response = response;
+}
+
+void Http2ServerConnection::pushData(uint32_t streamId, std::string data)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end() || data.empty())
+        return;
+    auto &stream = it->second;
+    if (stream.pending.empty())
+        stream.pending = std::move(data);
+    else
+        stream.pending.append(data);
+    scheduleStream(streamId, stream);
+    scheduleFlush();
+}
+
+void Http2ServerConnection::endData(uint32_t streamId)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+    it->second.dataEnded = true;
+    scheduleStream(streamId, it->second);
+    scheduleFlush();
+}
+
+void Http2ServerConnection::writeHeaders(uint32_t streamId,
+                                         const HpackHeaders &fields,
+                                         bool endStream)
+{
+    std::string block;
+    encoder_.encode(fields, block);
+    appendHeaderBlock(output_, streamId, block, endStream, peerMaxFrameSize_);
+}
+
+void Http2ServerConnection::respondError(uint32_t streamId,
+                                         HttpStatusCode code)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+    writeHeaders(streamId,
+                 {{":status", std::to_string(code)}, {"content-length", "0"}},
+                 true);
+    closeLocal(it);
+}
+
+void Http2ServerConnection::resetStream(uint32_t streamId, ErrorCode error)
+{
+    appendRstStream(output_, streamId, error);
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+    if (it->second.source)
+        it->second.source(nullptr, 0);
+    streams_.erase(it);
+}
+
+void Http2ServerConnection::closeLocal(StreamMap::iterator it)
+{
+    // The body of the request is not needed anymore (RFC 9113 8.1)
+    if (!it->second.remoteClosed)
+        appendRstStream(output_, it->first, ErrorCode::kNoError);
+    if (it->second.source)
+        it->second.source(nullptr, 0);
+    streams_.erase(it);
+}
+
+std::shared_ptr<void> Http2ServerConnection::handlerToken()
+{
+    ++runningHandlers_;
+    return std::shared_ptr<void>(
+        nullptr, [weakSelf = weak_from_this(), loop = loop_](void *) {
+            loop->runInLoop([weakSelf]() {
+                if (auto self = weakSelf.lock())
+                    --self->runningHandlers_;
+            });
+        });
+}
+
+bool Http2ServerConnection::onClientReset()
+{
+    auto second = trantor::Date::now().microSecondsSinceEpoch() / 1000000;
+    if (second != resetSecond_)
+    {
+        resetSecond_ = second;
+        resetCount_ = 0;
+    }
+    if (++resetCount_ <= kMaxResetsPerSecond)
+        return true;
+    LOG_WARN << "HTTP/2 client " << peerAddr_.toIpPort()
+             << " resets too many streams";
+    return connectionError(ErrorCode::kEnhanceYourCalm);
+}
+
+void Http2ServerConnection::onOutputOverflow()
+{
+    if (closed_)
+        return;
+    LOG_WARN << "HTTP/2 client " << peerAddr_.toIpPort()
+             << " doesn't read its responses";
+    // The GOAWAY would wait behind the output, the client is not answered
+    onClose();
+    if (auto conn = conn_.lock())
+        conn->forceClose();
+}
+
+bool Http2ServerConnection::connectionError(ErrorCode error)
+{
+    if (closed_)
+        return false;
+    LOG_DEBUG << "HTTP/2 connection error " << static_cast<uint32_t>(error);
+    appendGoAway(output_, lastStreamId_, error);
+    sendOutput();
+    onClose();
+    if (auto conn = conn_.lock())
+        conn->shutdown();
+    return false;
+}
+
+void Http2ServerConnection::goAway()
+{
+    if (closed_ || goingAway_)
+        return;
+    goingAway_ = true;
+    appendGoAway(output_, lastStreamId_, ErrorCode::kNoError);
+    flush();
+}
+
+void Http2ServerConnection::scheduleStream(uint32_t streamId, Stream &stream)
+{
+    if (stream.scheduled)
+        return;
+    stream.scheduled = true;
+    writableStreams_.push_back(streamId);
+}
+
+void Http2ServerConnection::scheduleFlush()
+{
+    // The frames of the responses completed in this loop iteration are sent
+    // together
+    if (flushQueued_ || closed_)
+        return;
+    flushQueued_ = true;
+    loop_->queueInLoop([weakSelf = weak_from_this()]() {
+        auto self = weakSelf.lock();
+        if (!self)
+            return;
+        self->flushQueued_ = false;
+        self->flush();
+    });
+}
+
+void Http2ServerConnection::flush()
+{
+    if (closed_)
+        return;
+    if (!waitingForWrite_)
+        writeData();
+    sendOutput();
+    if (goingAway_ && streams_.empty())
+    {
+        if (auto conn = conn_.lock())
+            conn->shutdown();
+    }
+}
+
+void Http2ServerConnection::writeData()
+{
+    while (!writableStreams_.empty() && sendWindow_ > 0 &&
+           output_.readableBytes() < kMaxWriteBatch)
+    {
+        auto streamId = writableStreams_.front();
+        writableStreams_.pop_front();
+        auto it = streams_.find(streamId);
+        if (it == streams_.end())
+            continue;
+        it->second.scheduled = false;
+        if (writeStreamData(streamId, it))
+        {
+            // The streams take turns
+            it->second.scheduled = true;
+            writableStreams_.push_back(streamId);
+        }
+    }
+    if (!writableStreams_.empty() && sendWindow_ > 0)
+    {
+        // The rest is written once this batch is
+        waitingForWrite_ = true;
+    }
+}
+
+bool Http2ServerConnection::writeStreamData(uint32_t streamId,
+                                            StreamMap::iterator it)
+{
+    auto &stream = it->second;
+    auto window = (std::min)({sendWindow_,
+                              stream.sendWindow,
+                              static_cast<int64_t>(peerMaxFrameSize_)});
+    if (stream.source)
+    {
+        if (window <= 0)
+            return false;
+        auto length = static_cast<size_t>(window);
+        output_.ensureWritableBytes(kFrameHeaderLength + length);
+        auto frame = output_.beginWrite();
+        auto n = stream.source(frame + kFrameHeaderLength, length);
+        if (n == 0)
+        {
+            if (hasTrailers(stream))
+            {
+                writeTrailers(streamId, stream);
+            }
+            else
+            {
+                writeFrameHeader(
+                    frame, 0, FrameType::kData, flags::kEndStream, streamId);
+                output_.hasWritten(kFrameHeaderLength);
+            }
+            closeLocal(it);
+            return false;
+        }
+        writeFrameHeader(frame,
+                         static_cast<uint32_t>(n),
+                         FrameType::kData,
+                         0,
+                         streamId);
+        output_.hasWritten(kFrameHeaderLength + n);
+        sendWindow_ -= n;
+        stream.sendWindow -= n;
+        return true;
+    }
+
+    auto available = stream.pending.length() - stream.pendingPos;
+    if (available == 0 && !stream.dataEnded)
+        return false;
+    auto n = (std::min)(available,
+                        static_cast<size_t>((std::max)(window, int64_t{0})));
+    if (n == 0 && available > 0)
+        return false;
+    bool endStream = stream.dataEnded && n == available;
+    bool trailers = endStream && hasTrailers(stream);
+    if (n > 0 || !trailers)
+    {
+        appendFrameHeader(output_,
+                          static_cast<uint32_t>(n),
+                          FrameType::kData,
+                          endStream && !trailers ? flags::kEndStream : 0,
+                          streamId);
+        output_.append(stream.pending.data() + stream.pendingPos, n);
+    }
+    stream.pendingPos += n;
+    sendWindow_ -= n;
+    stream.sendWindow -= n;
+    if (stream.pendingPos == stream.pending.length())
+    {
+        stream.pending.clear();
+        stream.pendingPos = 0;
+    }
+    if (endStream)
+    {
+        if (trailers)
+            writeTrailers(streamId, stream);
+        closeLocal(it);
+        return false;
+    }
+    return available > n;
+}
+
+bool Http2ServerConnection::hasTrailers(const Stream &stream) const
+{
+    return stream.response && !stream.response->trailers().empty();
+}
+
+void Http2ServerConnection::writeTrailers(uint32_t streamId,
+                                          const Stream &stream)
+{
+    HpackHeaders fields;
+    for (auto &[name, value] : stream.response->trailers())
+    {
+        if (!isConnectionSpecific(name))
+            fields.emplace_back(name, value);
+    }
+    writeHeaders(streamId, fields, true);
+}
+
+void Http2ServerConnection::sendOutput()
+{
+    if (output_.readableBytes() == 0)
+        return;
+    if (auto conn = conn_.lock())
+        conn->send(output_);
+    output_.retrieveAll();
+}
@@ -0,0 +1,219 @@
+/**
+ *
+ *  @file Http2ServerConnection.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "Hpack.h"
+#include "Http2Frame.h"
+#include "impl_forwards.h"
+#include <drogon/HttpTypes.h>
+#include <trantor/net/AsyncStream.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief The server side of an HTTP/2 connection (RFC 9113).
+ *
+ * The connection starts with the preface of the client, after h2 was
+ * negotiated by ALPN or is known in advance, or with an h2c upgrade request.
+ * Every request is handed to the handler once its stream is half-closed by
+ * the client, and the responses of all the streams are multiplexed on the
+ * loop of the connection: their DATA frames are sent in turn within the
+ * flow control windows. Server push is disabled and priorities are ignored.
+ *
+ * @note All the methods are called in the loop of the connection.
+ */
+class Http2ServerConnection
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<Http2ServerConnection>
+{
+  public:
+    using RequestHandler =
+        std::function<void(const std::shared_ptr<Http2ServerConnection> &,
+                           uint32_t streamId,
+                           const HttpRequestImplPtr &)>;
+    /// Fills the buffer and returns the length, or 0 at the end of the body.
+    /// It is called with a null buffer when the stream is closed.
+    using DataCallback = std::function<size_t(char *, size_t)>;
+
+    Http2ServerConnection(const trantor::TcpConnectionPtr &conn,
+                          RequestHandler handler);
+
+    /// Return true if the request asks to switch to h2c (RFC 7540 3.2).
+    static bool isUpgradeRequest(const HttpRequestImplPtr &req);
+
+    /// The addresses of the requests when a load balancer gave others.
+    void setAddresses(const trantor::InetAddress &peer,
+                      const trantor::InetAddress &local)
+    {
+        peerAddr_ = peer;
+        localAddr_ = local;
+    }
+
+    /// Start the connection, the data received next begins with the preface.
+    void start();
+
+    /**
+     * @brief Accept the h2c upgrade request and start the connection, the
+     * request is answered on stream 1.
+     */
+    void upgrade(const HttpRequestImplPtr &req);
+
+    void onMessage(trantor::MsgBuffer *buf);
+    void onClose();
+
+    /**
+     * @brief Refuse the new streams with a GOAWAY frame (RFC 9113 6.8), the
+     * connection is closed once the open streams are answered.
+     */
+    void goAway();
+
+    trantor::EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+    /**
+     * @brief Send the header of the response of the stream, rendered as an
+     * HTTP/1 header whose connection-specific fields are dropped.
+     */
+    void sendHeaders(uint32_t streamId,
+                     const trantor::MsgBuffer &header,
+                     bool endStream);
+
+    /// Send the body of the response of the stream pulled from the callback.
+    void sendBody(uint32_t streamId, DataCallback callback);
+
+    /**
+     * @brief Return a stream into which the body of the response of the
+     * stream is pushed, from any thread.
+     */
+    trantor::AsyncStreamPtr newAsyncStream(uint32_t streamId);
+
+    /**
+     * @brief Keep the response of the stream, its trailers are sent in a
+     * HEADERS frame that ends the stream once the body is sent.
+     */
+    void setResponse(uint32_t streamId, const HttpResponsePtr &response);
+
+    /**
+     * @brief Count a request as being handled until the returned token is
+     * destroyed, which may happen in any thread. The handlers of the streams
+     * reset by the client still count toward the concurrent streams.
+     */
+    std::shared_ptr<void> handlerToken();
+
+  private:
+    friend class Http2AsyncStream;
+
+    struct Stream
+    {
+        HttpRequestImplPtr request;
+        int64_t sendWindow{0};
+        uint32_t unackedRecv{0};
+        size_t bodyLength{0};
+        bool remoteClosed{false};
+        bool scheduled{false};
+        // The pulled body
+        DataCallback source;
+        // The pushed body
+        std::string pending;
+        size_t pendingPos{0};
+        bool dataEnded{false};
+        // The response whose trailers follow the body
+        HttpResponsePtr response;
+    };
+
+    using StreamMap = std::unordered_map<uint32_t, Stream>;
+
+    bool onFrame(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onHeaders(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onContinuation(const http2::FrameHeader &header,
+                        const uint8_t *payload);
+    bool onHeaderBlock();
+    bool onData(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onSettings(const http2::FrameHeader &header, const uint8_t *payload);
+    bool onWindowUpdate(const http2::FrameHeader &header,
+                        const uint8_t *payload);
+    bool applySettings(const uint8_t *payload, size_t length);
+
+    HttpRequestImplPtr newRequest(const HpackHeaders &fields);
+    void onRemoteClosed(uint32_t streamId, Stream &stream);
+    void pushData(uint32_t streamId, std::string data);
+    void endData(uint32_t streamId);
+
+    void writeHeaders(uint32_t streamId,
+                      const HpackHeaders &fields,
+                      bool endStream);
+    void respondError(uint32_t streamId, HttpStatusCode code);
+    void resetStream(uint32_t streamId, http2::ErrorCode error);
+    void closeLocal(StreamMap::iterator it);
+    bool connectionError(http2::ErrorCode error);
+    bool onClientReset();
+    void onOutputOverflow();
+    void scheduleStream(uint32_t streamId, Stream &stream);
+    void scheduleFlush();
+    void flush();
+    void writeData();
+    bool writeStreamData(uint32_t streamId, StreamMap::iterator it);
+    bool hasTrailers(const Stream &stream) const;
+    void writeTrailers(uint32_t streamId, const Stream &stream);
+    void sendOutput();
+
+    std::weak_ptr<trantor::TcpConnection> conn_;
+    trantor::EventLoop *loop_;
+    trantor::InetAddress peerAddr_;
+    trantor::InetAddress localAddr_;
+    RequestHandler handler_;
+    HpackDecoder decoder_;
+    HpackEncoder encoder_;
+    StreamMap streams_;
+    // The streams with data to send, in the order of their turns
+    std::deque<uint32_t> writableStreams_;
+    trantor::MsgBuffer output_;
+
+    bool prefaceReceived_{false};
+    bool settingsReceived_{false};
+    bool flushQueued_{false};
+    bool waitingForWrite_{false};
+    bool closed_{false};
+    bool goingAway_{false};
+    uint32_t lastStreamId_{0};
+    // The header block being received in CONTINUATION frames
+    uint32_t headerStreamId_{0};
+    bool headerEndStream_{false};
+    std::string headerBlock_;
+
+    int64_t sendWindow_{http2::kDefaultWindowSize};
+    int64_t initialSendWindow_{http2::kDefaultWindowSize};
+    uint32_t peerMaxFrameSize_{http2::kDefaultMaxFrameSize};
+    uint32_t unackedRecv_{0};
+
+    // The requests whose handlers have not finished, their streams may have
+    // been reset
+    size_t runningHandlers_{0};
+    // The streams reset by the client in the current second
+    int64_t resetSecond_{0};
+    size_t resetCount_{0};
+};
+
+using Http2ServerConnectionPtr = std::shared_ptr<Http2ServerConnection>;
+}  // namespace drogon
@@ -0,0 +1,467 @@
+/**
+ *
+ *  @file Http3Listener.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http3Listener.h"
+#include "AOPAdvice.h"
+#include "HttpAppFrameworkImpl.h"
+#include "HttpConnectionLimit.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <quiche.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t kConnectionIdLength = 16;
+constexpr size_t kMaxDatagramSize = 1350;
+constexpr size_t kMaxTokenLength = 256;
+// The type of the long header packets which open the connections
+constexpr uint8_t kInitialPacket = 1;
+// The flow control limits of the connections and of their streams
+constexpr uint64_t kConnectionWindow = 10 * 1024 * 1024;
+constexpr uint64_t kStreamWindow = 1024 * 1024;
+constexpr uint64_t kMaxStreams = 100;
+// Past this number of connections on a socket, the new clients must prove
+// their address with a Retry packet (RFC 9000 8.1.2)
+constexpr size_t kRetryThreshold = 256;
+// The connections of a socket past which the new clients are ignored
+constexpr size_t kMaxConnections = 16384;
+// How long the token of a Retry packet is accepted
+constexpr int64_t kTokenLifetime = 10;
+// The length of the MAC of the tokens, in hexadecimal digits
+constexpr size_t kTokenMacLength = 32;
+
+socklen_t addressLength(const sockaddr_storage &addr)
+{
+    return addr.ss_family == AF_INET6 ? sizeof(sockaddr_in6)
+                                      : sizeof(sockaddr_in);
+}
+
+trantor::InetAddress toInetAddress(const sockaddr_storage &addr)
+{
+    if (addr.ss_family == AF_INET6)
+        return trantor::InetAddress(
+            *reinterpret_cast<const sockaddr_in6 *>(&addr));
+    return trantor::InetAddress(*reinterpret_cast<const sockaddr_in *>(&addr));
+}
+
+int64_t nowSeconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+Http3Listener::Http3Listener(trantor::EventLoop *loop,
+                             const trantor::InetAddress &address,
+                             const std::string &certFile,
+                             const std::string &keyFile,
+                             const std::vector<uint8_t> &ticketKey,
+                             Http3ServerConnection::RequestHandler handler)
+    : loop_(loop),
+      address_(address),
+      handler_(std::move(handler)),
+      recvBuffer_(65536)
+{
+    config_ = quiche_config_new(QUICHE_PROTOCOL_VERSION);
+    if (!config_ ||
+        quiche_config_load_cert_chain_from_pem_file(config_,
+                                                    certFile.c_str()) < 0 ||
+        quiche_config_load_priv_key_from_pem_file(config_, keyFile.c_str()) <
+            0)
+    {
+        LOG_FATAL << "Failed to load the certificate of the HTTP/3 listener";
+        exit(1);
+    }
+    quiche_config_set_application_protos(
+        config_,
+        reinterpret_cast<const uint8_t *>(QUICHE_H3_APPLICATION_PROTOCOL),
+        sizeof(QUICHE_H3_APPLICATION_PROTOCOL) - 1);
+    quiche_config_set_max_idle_timeout(
+        config_,
+        HttpAppFrameworkImpl::instance().getIdleConnectionTimeout() * 1000);
+    quiche_config_set_max_recv_udp_payload_size(config_, kMaxDatagramSize);
+    quiche_config_set_max_send_udp_payload_size(config_, kMaxDatagramSize);
+    quiche_config_set_initial_max_data(config_, kConnectionWindow);
+    quiche_config_set_initial_max_stream_data_bidi_local(config_,
+                                                         kStreamWindow);
+    quiche_config_set_initial_max_stream_data_bidi_remote(config_,
+                                                          kStreamWindow);
+    quiche_config_set_initial_max_stream_data_uni(config_, kStreamWindow);
+    quiche_config_set_initial_max_streams_bidi(config_, kMaxStreams);
+    // The control stream and the two streams of QPACK
+    quiche_config_set_initial_max_streams_uni(config_, 3);
+    quiche_config_set_disable_active_migration(config_, true);
+    quiche_config_enable_early_data(config_);
+    if (quiche_config_set_ticket_key(config_,
+                                     ticketKey.data(),
+                                     ticketKey.size()) < 0)
+    {
+        LOG_WARN << "The HTTP/3 sessions are only resumed by the same loop";
+    }
+    h3Config_ = quiche_h3_config_new();
+    // The datagrams of a client may reach another loop after a Retry, the
+    // key is derived from the one shared by the listeners of the port
+    retryKey_ = utils::getSha256(
+        "drogon HTTP/3 retry" +
+        std::string(ticketKey.begin(), ticketKey.end()));
+}
+
+Http3Listener::~Http3Listener()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    if (h3Config_)
+        quiche_h3_config_free(h3Config_);
+    if (config_)
+        quiche_config_free(config_);
+}
+
+void Http3Listener::start()
+{
+    loop_->runInLoop([thisPtr = shared_from_this()]() {
+        auto &address = thisPtr->address_;
+        int fd = ::socket(address.family(), SOCK_DGRAM, IPPROTO_UDP);
+        if (fd < 0)
+        {
+            LOG_SYSERR << "Failed to create the HTTP/3 socket";
+            exit(1);
+        }
+        thisPtr->fd_ = fd;
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef SO_REUSEPORT
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+        socklen_t length = address.isIpV6() ? sizeof(sockaddr_in6)
+                                            : sizeof(sockaddr_in);
+        if (::bind(fd, address.getSockAddr(), length) < 0)
+        {
+            LOG_SYSERR << "Failed to bind the HTTP/3 socket to "
+                       << address.toIpPort();
+            exit(1);
+        }
+        length = sizeof(thisPtr->local_);
+        ::getsockname(fd,
+                      reinterpret_cast<sockaddr *>(&thisPtr->local_),
+                      &length);
+        thisPtr->channel_ =
+            std::make_unique<trantor::Channel>(thisPtr->loop_, fd);
+        thisPtr->channel_->setReadCallback(
+            [weakPtr = std::weak_ptr<Http3Listener>(thisPtr)]() {
+                if (auto listener = weakPtr.lock())
+                    listener->onRead();
+            });
+        thisPtr->channel_->enableReading();
+    });
+}
+
+void Http3Listener::stop()
+{
+    loop_->runInLoop([thisPtr = shared_from_this()]() {
+        // Every connection is registered under several IDs
+        std::vector<Http3ServerConnectionPtr> connections;
+        for (auto &[id, conn] : thisPtr->connections_)
+        {
+            if (conn->connectionIds().front() == id)
+                connections.push_back(conn);
+        }
+        for (auto &conn : connections)
+            conn->close();
+        thisPtr->connections_.clear();
+        thisPtr->connectionNum_ = 0;
+        if (thisPtr->channel_)
+        {
+            thisPtr->channel_->disableAll();
+            thisPtr->channel_->remove();
+            thisPtr->channel_.reset();
+        }
+        if (thisPtr->fd_ >= 0)
+        {
+            ::close(thisPtr->fd_);
+            thisPtr->fd_ = -1;
+        }
+    });
+}
+
+void Http3Listener::onRead()
+{
+    while (fd_ >= 0)
+    {
+        sockaddr_storage peer;
+        socklen_t peerLength = sizeof(peer);
+        auto n = ::recvfrom(fd_,
+                            recvBuffer_.data(),
+                            recvBuffer_.size(),
+                            0,
+                            reinterpret_cast<sockaddr *>(&peer),
+                            &peerLength);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                LOG_SYSERR << "Failed to receive an HTTP/3 datagram";
+            return;
+        }
+        onDatagram(recvBuffer_.data(), static_cast<size_t>(n), peer);
+    }
+}
+
+void Http3Listener::onDatagram(uint8_t *data,
+                               size_t length,
+                               const sockaddr_storage &peer)
+{
+    uint32_t version;
+    uint8_t type;
+    uint8_t scid[QUICHE_MAX_CONN_ID_LEN];
+    size_t scidLength = sizeof(scid);
+    uint8_t dcid[QUICHE_MAX_CONN_ID_LEN];
+    size_t dcidLength = sizeof(dcid);
+    uint8_t token[kMaxTokenLength];
+    size_t tokenLength = sizeof(token);
+    if (quiche_header_info(data,
+                           length,
+                           kConnectionIdLength,
+                           &version,
+                           &type,
+                           scid,
+                           &scidLength,
+                           dcid,
+                           &dcidLength,
+                           token,
+                           &tokenLength) < 0)
+    {
+        return;
+    }
+    std::string id(reinterpret_cast<char *>(dcid), dcidLength);
+    auto it = connections_.find(id);
+    if (it != connections_.end())
+    {
+        auto conn = it->second;
+        conn->onDatagram(data, length, peer);
+        return;
+    }
+    if (!quiche_version_is_supported(version))
+    {
+        uint8_t out[kMaxDatagramSize];
+        auto n = quiche_negotiate_version(
+            scid, scidLength, dcid, dcidLength, out, sizeof(out));
+        if (n > 0)
+        {
+            ::sendto(fd_,
+                     out,
+                     n,
+                     0,
+                     reinterpret_cast<const sockaddr *>(&peer),
+                     addressLength(peer));
+        }
+        return;
+    }
+    if (type != kInitialPacket || connectionNum_ >= kMaxConnections)
+        return;
+    if (tokenLength == 0)
+    {
+        if (connectionNum_ >= kRetryThreshold)
+        {
+            sendRetry(scid, scidLength, dcid, dcidLength, version, peer);
+            return;
+        }
+        accept(id, std::string(), data, length, peer);
+        return;
+    }
+    // The client answers a Retry, its address is validated
+    auto odcid = validateToken(token, tokenLength, peer);
+    if (odcid.empty())
+    {
+        LOG_TRACE << "Invalid QUIC token";
+        return;
+    }
+    accept(id, odcid, data, length, peer);
+}
+
+void Http3Listener::accept(const std::string &dcid,
+                           const std::string &odcid,
+                           uint8_t *data,
+                           size_t length,
+                           const sockaddr_storage &peer)
+{
+    // After a Retry the client uses the ID given by the server
+    std::string id;
+    if (odcid.empty())
+    {
+        id.resize(kConnectionIdLength);
+        if (!utils::secureRandomBytes(&id[0], id.length()))
+            return;
+    }
+    else
+    {
+        id = dcid;
+    }
+    auto peerAddr = toInetAddress(peer);
+    auto &limit = HttpConnectionLimit::instance();
+    if (!limit.tryAddConnection(peerAddr))
+    {
+        LOG_ERROR << "too much connections!refuse an HTTP/3 client!";
+        limit.releaseConnection(peerAddr);
+        return;
+    }
+    if (!AopAdvice::instance().passNewConnectionAdvices(toInetAddress(local_),
+                                                        peerAddr))
+    {
+        limit.releaseConnection(peerAddr);
+        return;
+    }
+    auto *conn = quiche_accept(
+        reinterpret_cast<const uint8_t *>(id.data()),
+        id.length(),
+        odcid.empty() ? nullptr
+                      : reinterpret_cast<const uint8_t *>(odcid.data()),
+        odcid.length(),
+        reinterpret_cast<const sockaddr *>(&local_),
+        addressLength(local_),
+        reinterpret_cast<const sockaddr *>(&peer),
+        addressLength(peer),
+        config_);
+    if (!conn)
+    {
+        limit.releaseConnection(peerAddr);
+        return;
+    }
+    auto connPtr = std::make_shared<Http3ServerConnection>(
+        loop_,
+        fd_,
+        conn,
+        h3Config_,
+        local_,
+        peer,
+        handler_,
+        [weakPtr = weak_from_this(),
+         peerAddr](const Http3ServerConnectionPtr &closed) {
+            // Called once, even when the listener is stopped
+            HttpConnectionLimit::instance().releaseConnection(peerAddr);
+            if (auto listener = weakPtr.lock())
+                listener->removeConnection(closed);
+        });
+    if (odcid.empty())
+        connPtr->connectionIds() = {id, dcid};
+    else
+        connPtr->connectionIds() = {id};
+    for (auto &connId : connPtr->connectionIds())
+        connections_[connId] = connPtr;
+    ++connectionNum_;
+    connPtr->onDatagram(data, length, peer);
+}
+
+void Http3Listener::sendRetry(const uint8_t *scid,
+                              size_t scidLength,
+                              const uint8_t *dcid,
+                              size_t dcidLength,
+                              uint32_t version,
+                              const sockaddr_storage &peer)
+{
+    std::string newId(kConnectionIdLength, '\0');
+    if (!utils::secureRandomBytes(&newId[0], newId.length()))
+        return;
+    // The token holds its expiry and the ID the client chose, with a MAC of
+    // them and of the address of the client
+    auto expiry = static_cast<uint64_t>(nowSeconds() + kTokenLifetime);
+    std::string token;
+    for (int i = 7; i >= 0; --i)
+        token.push_back(static_cast<char>((expiry >> (i * 8)) & 0xff));
+    token.push_back(static_cast<char>(dcidLength));
+    token.append(reinterpret_cast<const char *>(dcid), dcidLength);
+    token.append(tokenMac(token, peer));
+    uint8_t out[kMaxDatagramSize];
+    auto n = quiche_retry(scid,
+                          scidLength,
+                          dcid,
+                          dcidLength,
+                          reinterpret_cast<const uint8_t *>(newId.data()),
+                          newId.length(),
+                          reinterpret_cast<const uint8_t *>(token.data()),
+                          token.length(),
+                          version,
+                          out,
+                          sizeof(out));
+    if (n <= 0)
+        return;
+    ::sendto(fd_,
+             out,
+             n,
+             0,
+             reinterpret_cast<const sockaddr *>(&peer),
+             addressLength(peer));
+}
+
+std::string Http3Listener::validateToken(const uint8_t *token,
+                                         size_t length,
+                                         const sockaddr_storage &peer) const
+{
+    std::string_view view(reinterpret_cast<const char *>(token), length);
+    if (view.length() < 9 + kTokenMacLength)
+        return {};
+    size_t idLength = static_cast<uint8_t>(view[8]);
+    if (idLength == 0 || view.length() != 9 + idLength + kTokenMacLength)
+        return {};
+    std::string data(view.substr(0, 9 + idLength));
+    auto mac = tokenMac(data, peer);
+    auto given = view.substr(9 + idLength);
+    // Compare in constant time
+    unsigned char diff = 0;
+    for (size_t i = 0; i < kTokenMacLength; ++i)
+        diff |= static_cast<unsigned char>(mac[i] ^ given[i]);
+    if (diff != 0)
+        return {};
+    uint64_t expiry = 0;
+    for (size_t i = 0; i < 8; ++i)
+        expiry = (expiry << 8) | static_cast<uint8_t>(view[i]);
+    if (static_cast<int64_t>(expiry) < nowSeconds())
+        return {};
+    return data.substr(9);
+}
+
+std::string Http3Listener::tokenMac(const std::string &data,
+                                    const sockaddr_storage &peer) const
+{
+    std::string input(retryKey_);
+    input.append(data);
+    input.append(toInetAddress(peer).toIpPort());
+    input.append(retryKey_);
+    return utils::getSha256(input).substr(0, kTokenMacLength);
+}
+
+void Http3Listener::removeConnection(const Http3ServerConnectionPtr &conn)
+{
+    bool found = false;
+    for (auto &id : conn->connectionIds())
+    {
+        auto it = connections_.find(id);
+        if (it != connections_.end() && it->second == conn)
+        {
+            connections_.erase(it);
+            found = true;
+        }
+    }
+    if (found)
+        --connectionNum_;
+}
@@ -0,0 +1,108 @@
+/**
+ *
+ *  @file Http3Listener.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "Http3ServerConnection.h"
+#include <trantor/net/Channel.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct quiche_config;
+
+namespace drogon
+{
+/**
+ * @brief A UDP socket of an IO loop which accepts the QUIC connections of
+ * HTTP/3 clients.
+ *
+ * On Linux every IO loop has its own socket bound to the port with
+ * SO_REUSEPORT, the kernel keeps the datagrams of a client on the same
+ * socket as long as its address does not change, and the connections don't
+ * migrate. All the listeners of a port share the key of the session tickets
+ * so the clients resume their sessions, and send 0-RTT data, whichever loop
+ * receives them.
+ *
+ * The connections count toward the connection limits of the application and
+ * go through its new connection advices. Past a number of connections on
+ * the socket, the clients must prove their address with a Retry packet
+ * before a connection is created for them, so spoofed Initial packets don't
+ * take memory, and past a larger number the new clients are ignored.
+ */
+class Http3Listener : public trantor::NonCopyable,
+                      public std::enable_shared_from_this<Http3Listener>
+{
+  public:
+    Http3Listener(trantor::EventLoop *loop,
+                  const trantor::InetAddress &address,
+                  const std::string &certFile,
+                  const std::string &keyFile,
+                  const std::vector<uint8_t> &ticketKey,
+                  Http3ServerConnection::RequestHandler handler);
+    ~Http3Listener();
+
+    /// Bind the socket, exits the process if it fails like the TCP ones.
+    void start();
+
+    /// Close the connections and the socket, from any thread.
+    void stop();
+
+  private:
+    void onRead();
+    void onDatagram(uint8_t *data, size_t length, const sockaddr_storage &peer);
+    // The odcid is the ID of the first Initial packet of a client which was
+    // sent a Retry
+    void accept(const std::string &dcid,
+                const std::string &odcid,
+                uint8_t *data,
+                size_t length,
+                const sockaddr_storage &peer);
+    void removeConnection(const Http3ServerConnectionPtr &conn);
+    void sendRetry(const uint8_t *scid,
+                   size_t scidLength,
+                   const uint8_t *dcid,
+                   size_t dcidLength,
+                   uint32_t version,
+                   const sockaddr_storage &peer);
+    // Return the connection ID the client chose for its first Initial
+    // packet, or an empty string if the token is invalid
+    std::string validateToken(const uint8_t *token,
+                              size_t length,
+                              const sockaddr_storage &peer) const;
+    std::string tokenMac(const std::string &data,
+                         const sockaddr_storage &peer) const;
+
+    trantor::EventLoop *loop_;
+    trantor::InetAddress address_;
+    Http3ServerConnection::RequestHandler handler_;
+    quiche_config *config_{nullptr};
+    quiche_h3_config *h3Config_{nullptr};
+    int fd_{-1};
+    sockaddr_storage local_{};
+    std::unique_ptr<trantor::Channel> channel_;
+    std::vector<uint8_t> recvBuffer_;
+    // The connections by the IDs the server gave them and by the ones the
+    // clients chose for their first packets
+    std::unordered_map<std::string, Http3ServerConnectionPtr> connections_;
+    size_t connectionNum_{0};
+    // Authenticates the address validation tokens of the Retry packets
+    std::string retryKey_;
+};
+
+using Http3ListenerPtr = std::shared_ptr<Http3Listener>;
+}  // namespace drogon
@@ -0,0 +1,731 @@
+/**
+ *
+ *  @file Http3ServerConnection.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http3ServerConnection.h"
+#include "Http2Frame.h"
+#include "HttpControllersRouter.h"
+#include "HttpRequestImpl.h"
+#include "HttpRequestPool.h"
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/Logger.h>
+#include <quiche.h>
+#include <netinet/in.h>
+#include <algorithm>
+
+using namespace drogon;
+
+namespace
+{
+// The error codes of HTTP/3 (RFC 9114 8.1)
+constexpr uint64_t kH3NoError = 0x100;
+constexpr uint64_t kH3InternalError = 0x102;
+constexpr uint64_t kH3ExcessiveLoad = 0x107;
+constexpr uint64_t kH3MessageError = 0x10e;
+constexpr size_t kMaxDatagramSize = 1350;
+// The size of the chunks pulled from the sources of the bodies
+constexpr size_t kChunkSize = 16 * 1024;
+constexpr size_t kMaxConcurrentStreams = 100;
+// The streams the client may reset in a second before the connection is
+// closed, against the rapid reset attack (CVE-2023-44487)
+constexpr size_t kMaxResetsPerSecond = 2 * kMaxConcurrentStreams;
+
+socklen_t addressLength(const sockaddr_storage &addr)
+{
+    return addr.ss_family == AF_INET6 ? sizeof(sockaddr_in6)
+                                      : sizeof(sockaddr_in);
+}
+
+trantor::InetAddress toInetAddress(const sockaddr_storage &addr)
+{
+    if (addr.ss_family == AF_INET6)
+        return trantor::InetAddress(
+            *reinterpret_cast<const sockaddr_in6 *>(&addr));
+    return trantor::InetAddress(*reinterpret_cast<const sockaddr_in *>(&addr));
+}
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t' ||
+                            str.back() == '\r'))
+        str.remove_suffix(1);
+    return str;
+}
+
+int collectField(uint8_t *name,
+                 size_t nameLength,
+                 uint8_t *value,
+                 size_t valueLength,
+                 void *fields)
+{
+    static_cast<std::vector<std::pair<std::string, std::string>> *>(fields)
+        ->emplace_back(std::string(reinterpret_cast<char *>(name), nameLength),
+                       std::string(reinterpret_cast<char *>(value),
+                                   valueLength));
+    return 0;
+}
+
+// The methods which may be replayed by an attacker (RFC 8470 4.1)
+bool isSafeMethod(HttpMethod method)
+{
+    return method == Get || method == Head || method == Options;
+}
+}  // namespace
+
+namespace drogon
+{
+/**
+ * @brief The body of a response pushed from any thread into the loop of its
+ * connection.
+ */
+class Http3AsyncStream : public trantor::AsyncStream
+{
+  public:
+    Http3AsyncStream(std::weak_ptr<Http3ServerConnection> conn,
+                     trantor::EventLoop *loop,
+                     uint64_t streamId)
+        : conn_(std::move(conn)), loop_(loop), streamId_(streamId)
+    {
+    }
+
+    bool send(const char *data, size_t len) override
+    {
+        auto conn = conn_.lock();
+        if (!conn)
+            return false;
+        loop_->runInLoop([conn = std::move(conn),
+                          streamId = streamId_,
+                          data = std::string(data, len)]() mutable {
+            conn->pushData(streamId, std::move(data));
+        });
+        return true;
+    }
+
+    void close() override
+    {
+        auto conn = conn_.lock();
+        conn_.reset();
+        if (!conn)
+            return;
+        loop_->runInLoop([conn = std::move(conn), streamId = streamId_]() {
+            conn->endData(streamId);
+        });
+    }
+
+  private:
+    std::weak_ptr<Http3ServerConnection> conn_;
+    trantor::EventLoop *loop_;
+    uint64_t streamId_;
+};
+}  // namespace drogon
+
+Http3ServerConnection::Http3ServerConnection(trantor::EventLoop *loop,
+                                             int fd,
+                                             quiche_conn *conn,
+                                             quiche_h3_config *h3Config,
+                                             const sockaddr_storage &local,
+                                             const sockaddr_storage &peer,
+                                             RequestHandler handler,
+                                             CloseCallback closeCallback)
+    : loop_(loop),
+      fd_(fd),
+      conn_(conn),
+      h3Config_(h3Config),
+      local_(local),
+      peer_(peer),
+      handler_(std::move(handler)),
+      closeCallback_(std::move(closeCallback))
+{
+}
+
+Http3ServerConnection::~Http3ServerConnection()
+{
+    if (h3_)
+        quiche_h3_conn_free(h3_);
+    quiche_conn_free(conn_);
+}
+
+void Http3ServerConnection::onDatagram(uint8_t *data,
+                                       size_t length,
+                                       const sockaddr_storage &peer)
+{
+    if (closed_)
+        return;
+    quiche_recv_info info{
+        reinterpret_cast<sockaddr *>(const_cast<sockaddr_storage *>(&peer)),
+        addressLength(peer),
+        reinterpret_cast<sockaddr *>(&local_),
+        addressLength(local_)};
+    auto done = quiche_conn_recv(conn_, data, length, &info);
+    if (done < 0)
+        LOG_DEBUG << "Failed to process a QUIC packet: " << done;
+    if (!h3_ && (quiche_conn_is_established(conn_) ||
+                 quiche_conn_is_in_early_data(conn_)))
+    {
+        h3_ = quiche_h3_conn_new_with_transport(conn_, h3Config_);
+        if (!h3_)
+        {
+            LOG_ERROR << "Failed to start an HTTP/3 connection";
+            quiche_conn_close(conn_, true, kH3InternalError, nullptr, 0);
+        }
+    }
+    if (h3_)
+        pollEvents();
+    // The acknowledgements may have given credit to the blocked streams
+    writeStreams();
+    flush();
+}
+
+void Http3ServerConnection::close()
+{
+    if (closed_)
+        return;
+    quiche_conn_close(conn_, true, kH3NoError, nullptr, 0);
+    flush();
+    onClosed();
+}
+
+void Http3ServerConnection::pollEvents()
+{
+    while (!closed_)
+    {
+        quiche_h3_event *event;
+        auto streamId = quiche_h3_conn_poll(h3_, conn_, &event);
+        if (streamId < 0)
+            break;
+        switch (quiche_h3_event_type(event))
+        {
+            case QUICHE_H3_EVENT_HEADERS:
+            {
+                Fields fields;
+                if (quiche_h3_event_for_each_header(event,
+                                                    collectField,
+                                                    &fields) != 0)
+                {
+                    quiche_conn_stream_shutdown(conn_,
+                                                streamId,
+                                                QUICHE_SHUTDOWN_WRITE,
+                                                kH3MessageError);
+                    break;
+                }
+                onHeaders(streamId, std::move(fields));
+                break;
+            }
+            case QUICHE_H3_EVENT_DATA:
+                onData(streamId);
+                break;
+            case QUICHE_H3_EVENT_FINISHED:
+                onFinished(streamId);
+                break;
+            case QUICHE_H3_EVENT_RESET:
+            {
+                auto it = streams_.find(streamId);
+                if (it != streams_.end())
+                {
+                    if (it->second.source)
+                        it->second.source(nullptr, 0);
+                    streams_.erase(it);
+                    onClientReset();
+                }
+                break;
+            }
+            default:
+                // GOAWAY and PRIORITY_UPDATE, the priorities are ignored
+                break;
+        }
+        quiche_h3_event_free(event);
+    }
+}
+
+void Http3ServerConnection::onHeaders(uint64_t streamId, Fields fields)
+{
+    // The trailers of a request are dropped
+    if (streams_.find(streamId) != streams_.end())
+        return;
+    // The handlers of the streams reset by the client are still running
+    if ((std::max)(streams_.size(), runningHandlers_) >= kMaxConcurrentStreams)
+    {
+        quiche_conn_stream_shutdown(conn_,
+                                    streamId,
+                                    QUICHE_SHUTDOWN_WRITE,
+                                    kH3InternalError);
+        return;
+    }
+    auto req = newRequest(fields);
+    auto &stream = streams_[streamId];
+    if (!req)
+    {
+        respondError(streamId, k400BadRequest);
+        return;
+    }
+    if (quiche_conn_is_in_early_data(conn_) && !isSafeMethod(req->method()))
+    {
+        respondError(streamId, k425TooEarly);
+        return;
+    }
+    auto &router = HttpControllersRouter::instance();
+    if (router.hasBodyLimits())
+        req->setBodyLimit(router.bodyLimitOf(*req));
+    auto contentLength = req->getContentLengthHeaderValue();
+    if (contentLength.has_value() &&
+        contentLength.value() <= req->maxBodySize())
+    {
+        // If the memory budget is used up, appendToBody() moves the body to
+        // a temporary file.
+        (void)req->reserveBodySize(contentLength.value());
+    }
+    stream.request = std::move(req);
+}
+
+void Http3ServerConnection::onData(uint64_t streamId)
+{
+    uint8_t buffer[kChunkSize];
+    auto it = streams_.find(streamId);
+    while (true)
+    {
+        auto n = quiche_h3_recv_body(h3_, conn_, streamId, buffer, kChunkSize);
+        if (n <= 0)
+            break;
+        // The body of a stream already answered is drained
+        if (it == streams_.end() || !it->second.request)
+            continue;
+        auto &stream = it->second;
+        stream.bodyLength += n;
+        if (stream.bodyLength > stream.request->maxBodySize())
+        {
+            stream.request.reset();
+            respondError(streamId, k413RequestEntityTooLarge);
+            it = streams_.find(streamId);
+            continue;
+        }
+        stream.request->appendToBody(reinterpret_cast<const char *>(buffer),
+                                     n);
+    }
+}
+
+void Http3ServerConnection::onFinished(uint64_t streamId)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+    it->second.remoteFinished = true;
+    // The handler may answer at once, the stream is not used after the call
+    auto req = std::move(it->second.request);
+    if (req)
+        handler_(shared_from_this(), streamId, req);
+}
+
+HttpRequestImplPtr Http3ServerConnection::newRequest(const Fields &fields)
+{
+    auto req = HttpRequestPool::acquire(loop_);
+    req->setVersion(Version::kHttp3);
+    const std::string *method{nullptr};
+    const std::string *path{nullptr};
+    const std::string *scheme{nullptr};
+    const std::string *authority{nullptr};
+    bool hasHost{false};
+    bool regularFields{false};
+    std::string line;
+    for (auto &[name, value] : fields)
+    {
+        if (!name.empty() && name[0] == ':')
+        {
+            // The pseudo-header fields come first and only once
+            const std::string **field;
+            if (name == ":method")
+                field = &method;
+            else if (name == ":path")
+                field = &path;
+            else if (name == ":scheme")
+                field = &scheme;
+            else if (name == ":authority")
+                field = &authority;
+            else
+                return nullptr;
+            if (regularFields || *field)
+                return nullptr;
+            *field = &value;
+            continue;
+        }
+        regularFields = true;
+        if (std::any_of(name.begin(), name.end(), [](char c) {
+                return c >= 'A' && c <= 'Z';
+            }))
+            return nullptr;
+        if (http2::isConnectionSpecific(name) ||
+            (name == "te" && value != "trailers"))
+            return nullptr;
+        if (name == "host")
+            hasHost = true;
+        // The cookie fields are parsed by the request
+        line.assign(name).append(":").append(value);
+        req->addHeader(line.data(),
+                       line.data() + name.length(),
+                       line.data() + line.length());
+    }
+    if (!method || !path || !scheme || path->empty())
+        return nullptr;
+    if (!req->setMethod(method->data(), method->data() + method->length()))
+        return nullptr;
+    auto question = std::find(path->begin(), path->end(), '?');
+    req->setPath(path->data(), path->data() + (question - path->begin()));
+    if (question != path->end())
+        req->setQuery(&*question + 1, path->data() + path->length());
+    if (authority && !hasHost)
+    {
+        line.assign("host:").append(*authority);
+        req->addHeader(line.data(),
+                       line.data() + 4,
+                       line.data() + line.length());
+    }
+    req->setPeerAddr(toInetAddress(peer_));
+    req->setLocalAddr(toInetAddress(local_));
+    req->setCreationDate(trantor::Date::date());
+    req->setSecure(true);
+    return req;
+}
+
+void Http3ServerConnection::sendHeaders(uint64_t streamId,
+                                        const trantor::MsgBuffer &header,
+                                        bool endStream)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end() || closed_)
+        return;
+    std::string_view text(header.peek(), header.readableBytes());
+    auto eol = text.find("\r\n");
+    auto statusLine = text.substr(0, eol);
+    auto space = statusLine.find(' ');
+    if (space == std::string_view::npos)
+    {
+        LOG_ERROR << "Invalid response header";
+        resetStream(it);
+        return;
+    }
+    auto &stream = it->second;
+    stream.headers.clear();
+    stream.headers.emplace_back(
+        ":status", std::string(trim(statusLine.substr(space + 1, 3))));
+    while (eol != std::string_view::npos)
+    {
+        text.remove_prefix(eol + 2);
+        eol = text.find("\r\n");
+        auto fieldLine = text.substr(0, eol);
+        auto colon = fieldLine.find(':');
+        if (colon == std::string_view::npos)
+            continue;
+        std::string name(fieldLine.substr(0, colon));
+        std::transform(name.begin(),
+                       name.end(),
+                       name.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (http2::isConnectionSpecific(name))
+            continue;
+        stream.headers.emplace_back(
+            std::move(name), std::string(trim(fieldLine.substr(colon + 1))));
+    }
+    stream.headersPending = true;
+    stream.dataEnded = endStream;
+    scheduleFlush();
+}
+
+void Http3ServerConnection::sendBody(uint64_t streamId, DataCallback callback)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end() || closed_)
+    {
+        callback(nullptr, 0);
+        return;
+    }
+    it->second.source = std::move(callback);
+    scheduleFlush();
+}
+
+trantor::AsyncStreamPtr Http3ServerConnection::newAsyncStream(
+    uint64_t streamId)
+{
+    return std::make_unique<Http3AsyncStream>(weak_from_this(),
+                                              loop_,
+                                              streamId);
+}
+
+void Http3ServerConnection::pushData(uint64_t streamId, std::string data)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end() || data.empty())
+        return;
+    auto &stream = it->second;
+    if (stream.pendingPos == stream.pending.size())
+    {
+        stream.pending = std::move(data);
+        stream.pendingPos = 0;
+    }
+    else
+    {
+        stream.pending.append(data);
+    }
+    scheduleFlush();
+}
+
+void Http3ServerConnection::endData(uint64_t streamId)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+    it->second.dataEnded = true;
+    scheduleFlush();
+}
+
+std::shared_ptr<void> Http3ServerConnection::handlerToken()
+{
+    ++runningHandlers_;
+    return std::shared_ptr<void>(
+        nullptr, [weakSelf = weak_from_this(), loop = loop_](void *) {
+            loop->runInLoop([weakSelf]() {
+                if (auto self = weakSelf.lock())
+                    --self->runningHandlers_;
+            });
+        });
+}
+
+void Http3ServerConnection::onClientReset()
+{
+    auto second = trantor::Date::now().microSecondsSinceEpoch() / 1000000;
+    if (second != resetSecond_)
+    {
+        resetSecond_ = second;
+        resetCount_ = 0;
+    }
+    if (++resetCount_ <= kMaxResetsPerSecond)
+        return;
+    LOG_WARN << "HTTP/3 client " << toInetAddress(peer_).toIpPort()
+             << " resets too many streams";
+    quiche_conn_close(conn_, true, kH3ExcessiveLoad, nullptr, 0);
+}
+
+void Http3ServerConnection::respondError(uint64_t streamId,
+                                         HttpStatusCode code)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+    auto &stream = it->second;
+    stream.headers = {{":status", std::to_string(code)},
+                      {"content-length", "0"}};
+    stream.headersPending = true;
+    stream.dataEnded = true;
+    writeStream(it);
+}
+
+void Http3ServerConnection::resetStream(StreamMap::iterator it)
+{
+    quiche_conn_stream_shutdown(conn_,
+                                it->first,
+                                QUICHE_SHUTDOWN_WRITE,
+                                kH3InternalError);
+    if (it->second.source)
+        it->second.source(nullptr, 0);
+    streams_.erase(it);
+}
+
+void Http3ServerConnection::writeStreams()
+{
+    if (!h3_ || closed_)
+        return;
+    for (auto it = streams_.begin(); it != streams_.end();)
+    {
+        auto next = std::next(it);
+        writeStream(it);
+        it = next;
+    }
+}
+
+bool Http3ServerConnection::writeStream(StreamMap::iterator it)
+{
+    auto streamId = it->first;
+    auto &stream = it->second;
+    if (stream.headersPending)
+    {
+        std::vector<quiche_h3_header> headers;
+        headers.reserve(stream.headers.size());
+        for (auto &[name, value] : stream.headers)
+        {
+            headers.push_back(
+                {reinterpret_cast<const uint8_t *>(name.data()),
+                 name.length(),
+                 reinterpret_cast<const uint8_t *>(value.data()),
+                 value.length()});
+        }
+        bool fin = stream.dataEnded && !stream.source &&
+                   stream.pendingPos == stream.pending.size();
+        auto rc = quiche_h3_send_response(
+            h3_, conn_, streamId, headers.data(), headers.size(), fin);
+        if (rc == QUICHE_H3_ERR_STREAM_BLOCKED)
+            return false;
+        if (rc < 0)
+        {
+            LOG_DEBUG << "Failed to send the HTTP/3 headers: " << rc;
+            resetStream(it);
+            return true;
+        }
+        stream.headersPending = false;
+        stream.headers.clear();
+        if (fin)
+        {
+            // The body of the request is not needed anymore
+            if (!stream.remoteFinished)
+            {
+                quiche_conn_stream_shutdown(conn_,
+                                            streamId,
+                                            QUICHE_SHUTDOWN_READ,
+                                            kH3NoError);
+            }
+            streams_.erase(it);
+            return true;
+        }
+    }
+    while (true)
+    {
+        if (stream.pendingPos == stream.pending.size() && stream.source)
+        {
+            stream.pending.resize(kChunkSize);
+            auto n = stream.source(&stream.pending[0], kChunkSize);
+            stream.pending.resize(n);
+            stream.pendingPos = 0;
+            if (n == 0)
+            {
+                stream.source = nullptr;
+                stream.dataEnded = true;
+            }
+        }
+        auto remaining = stream.pending.size() - stream.pendingPos;
+        if (remaining == 0 && !stream.dataEnded)
+            return true;
+        auto sent = quiche_h3_send_body(
+            h3_,
+            conn_,
+            streamId,
+            reinterpret_cast<uint8_t *>(&stream.pending[0]) +
+                stream.pendingPos,
+            remaining,
+            stream.dataEnded);
+        if (sent == QUICHE_H3_ERR_DONE)
+            return false;
+        if (sent < 0)
+        {
+            LOG_DEBUG << "Failed to send the HTTP/3 body: " << sent;
+            resetStream(it);
+            return true;
+        }
+        stream.pendingPos += sent;
+        if (static_cast<size_t>(sent) < remaining)
+            return false;
+        if (stream.dataEnded)
+        {
+            streams_.erase(it);
+            return true;
+        }
+    }
+}
+
+void Http3ServerConnection::scheduleFlush()
+{
+    // The responses completed in this loop iteration are sent together
+    if (flushQueued_ || closed_)
+        return;
+    flushQueued_ = true;
+    loop_->queueInLoop([weakSelf = weak_from_this()]() {
+        auto self = weakSelf.lock();
+        if (!self)
+            return;
+        self->flushQueued_ = false;
+        self->writeStreams();
+        self->flush();
+    });
+}
+
+void Http3ServerConnection::flush()
+{
+    if (closed_)
+        return;
+    uint8_t out[kMaxDatagramSize];
+    while (true)
+    {
+        quiche_send_info info;
+        auto n = quiche_conn_send(conn_, out, sizeof(out), &info);
+        if (n == QUICHE_ERR_DONE)
+            break;
+        if (n < 0)
+        {
+            LOG_DEBUG << "Failed to create a QUIC packet: " << n;
+            break;
+        }
+        // A datagram dropped by a full socket buffer is lost like on the
+        // network, QUIC sends its frames again
+        if (::sendto(fd_,
+                     out,
+                     n,
+                     0,
+                     reinterpret_cast<const sockaddr *>(&info.to),
+                     info.to_len) < 0)
+        {
+            LOG_TRACE << "Failed to send a QUIC datagram";
+        }
+    }
+    if (quiche_conn_is_closed(conn_))
+    {
+        onClosed();
+        return;
+    }
+    scheduleTimeout();
+}
+
+void Http3ServerConnection::scheduleTimeout()
+{
+    loop_->invalidateTimer(timerId_);
+    auto timeout = quiche_conn_timeout_as_millis(conn_);
+    if (timeout == UINT64_MAX)
+        return;
+    timerId_ = loop_->runAfter(static_cast<double>(timeout) / 1000,
+                               [weakSelf = weak_from_this()]() {
+                                   auto self = weakSelf.lock();
+                                   if (!self || self->closed_)
+                                       return;
+                                   quiche_conn_on_timeout(self->conn_);
+                                   self->writeStreams();
+                                   self->flush();
+                               });
+}
+
+void Http3ServerConnection::onClosed()
+{
+    if (closed_)
+        return;
+    closed_ = true;
+    loop_->invalidateTimer(timerId_);
+    for (auto &[streamId, stream] : streams_)
+    {
+        if (stream.source)
+            stream.source(nullptr, 0);
+    }
+    streams_.clear();
+    // The listener drops the connection once the current call returns
+    if (closeCallback_)
+    {
+        loop_->queueInLoop([self = shared_from_this()]() {
+            self->closeCallback_(self);
+        });
+    }
+}
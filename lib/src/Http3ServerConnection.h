@@ -0,0 +1,184 @@
+/**
+ *
+ *  @file Http3ServerConnection.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <drogon/HttpTypes.h>
+#include <trantor/net/AsyncStream.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <sys/socket.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct quiche_conn;
+struct quiche_h3_conn;
+struct quiche_h3_config;
+
+namespace drogon
+{
+/**
+ * @brief The server side of an HTTP/3 connection (RFC 9114).
+ *
+ * The QUIC transport and the HTTP/3 framing are done by quiche, the
+ * connection is fed with the datagrams its listener receives and sends the
+ * ones quiche produces from the socket of the listener. Every request is
+ * handed to the handler once its stream is finished by the client, so it
+ * goes through the same routing as the HTTP/1 and HTTP/2 ones. The requests
+ * received in 0-RTT data are only handled if their method is safe, the
+ * others are answered with 425 Too Early (RFC 8470).
+ *
+ * @note All the methods are called in the loop of the listener.
+ */
+class Http3ServerConnection
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<Http3ServerConnection>
+{
+  public:
+    using RequestHandler =
+        std::function<void(const std::shared_ptr<Http3ServerConnection> &,
+                           uint64_t streamId,
+                           const HttpRequestImplPtr &)>;
+    /// Fills the buffer and returns the length, or 0 at the end of the body.
+    /// It is called with a null buffer when the stream is closed.
+    using DataCallback = std::function<size_t(char *, size_t)>;
+    using CloseCallback =
+        std::function<void(const std::shared_ptr<Http3ServerConnection> &)>;
+
+    /**
+     * @brief Take the ownership of a connection accepted by quiche, the
+     * close callback is called once it is closed.
+     */
+    Http3ServerConnection(trantor::EventLoop *loop,
+                          int fd,
+                          quiche_conn *conn,
+                          quiche_h3_config *h3Config,
+                          const sockaddr_storage &local,
+                          const sockaddr_storage &peer,
+                          RequestHandler handler,
+                          CloseCallback closeCallback);
+    ~Http3ServerConnection();
+
+    void onDatagram(uint8_t *data, size_t length, const sockaddr_storage &peer);
+
+    /// Close the connection with H3_NO_ERROR, the streams are dropped.
+    void close();
+
+    /// The connection IDs under which the listener finds the connection
+    std::vector<std::string> &connectionIds()
+    {
+        return connectionIds_;
+    }
+
+    trantor::EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+    /**
+     * @brief Send the header of the response of the stream, rendered as an
+     * HTTP/1 header whose connection-specific fields are dropped.
+     */
+    void sendHeaders(uint64_t streamId,
+                     const trantor::MsgBuffer &header,
+                     bool endStream);
+
+    /// Send the body of the response of the stream pulled from the callback.
+    void sendBody(uint64_t streamId, DataCallback callback);
+
+    /**
+     * @brief Return a stream into which the body of the response of the
+     * stream is pushed, from any thread.
+     */
+    trantor::AsyncStreamPtr newAsyncStream(uint64_t streamId);
+
+    /**
+     * @brief Count a request as being handled until the returned token is
+     * destroyed, which may happen in any thread. The handlers of the streams
+     * reset by the client still count toward the concurrent streams.
+     */
+    std::shared_ptr<void> handlerToken();
+
+  private:
+    friend class Http3AsyncStream;
+
+    using Fields = std::vector<std::pair<std::string, std::string>>;
+
+    struct Stream
+    {
+        HttpRequestImplPtr request;
+        size_t bodyLength{0};
+        bool remoteFinished{false};
+        // The header waits for the credit of the stream
+        Fields headers;
+        bool headersPending{false};
+        // The pulled body
+        DataCallback source;
+        // The pushed body, or the chunk pulled from the source
+        std::string pending;
+        size_t pendingPos{0};
+        bool dataEnded{false};
+    };
+
+    using StreamMap = std::unordered_map<uint64_t, Stream>;
+
+    void pollEvents();
+    void onHeaders(uint64_t streamId, Fields fields);
+    void onData(uint64_t streamId);
+    void onFinished(uint64_t streamId);
+    HttpRequestImplPtr newRequest(const Fields &fields);
+    void pushData(uint64_t streamId, std::string data);
+    void endData(uint64_t streamId);
+
+    void onClientReset();
+    void respondError(uint64_t streamId, HttpStatusCode code);
+    void resetStream(StreamMap::iterator it);
+    void writeStreams();
+    // Return false while the stream waits for credit
+    bool writeStream(StreamMap::iterator it);
+    void scheduleFlush();
+    void flush();
+    void scheduleTimeout();
+    void onClosed();
+
+    trantor::EventLoop *loop_;
+    int fd_;
+    quiche_conn *conn_;
+    quiche_h3_config *h3Config_;
+    quiche_h3_conn *h3_{nullptr};
+    sockaddr_storage local_;
+    sockaddr_storage peer_;
+    RequestHandler handler_;
+    CloseCallback closeCallback_;
+    std::vector<std::string> connectionIds_;
+    StreamMap streams_;
+    trantor::TimerId timerId_{0};
+    bool flushQueued_{false};
+    bool closed_{false};
+
+    // The requests whose handlers have not finished, their streams may have
+    // been reset
+    size_t runningHandlers_{0};
+    // The streams reset by the client in the current second
+    int64_t resetSecond_{0};
+    size_t resetCount_{0};
+};
+
+using Http3ServerConnectionPtr = std::shared_ptr<Http3ServerConnection>;
+}  // namespace drogon
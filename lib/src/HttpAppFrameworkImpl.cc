@@ -16,27 +16,40 @@
 #include <drogon/DrClassMap.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/HttpTypes.h>
+#include <drogon/plugins/PromExporter.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/version.h>
 #include <json/json.h>
 #include <trantor/utils/AsyncFileLogger.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include "AOPAdvice.h"
+#include "Allocator.h"
+#include "BodyMemoryBudget.h"
+#include "CompressedBodyCache.h"
+#include "ComputePool.h"
 #include "ConfigLoader.h"
 #include "DbClientManager.h"
+#include "HandlerLoopPool.h"
+#include "HotRestart.h"
 #include "HttpClientImpl.h"
 #include "HttpConnectionLimit.h"
 #include "HttpControllersRouter.h"
+#include "HttpDateCache.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "HttpServer.h"
 #include "HttpUtils.h"
 #include "ListenerManager.h"
+#include "LoopWatchdog.h"
 #include "PluginsManager.h"
 #include "RedisClientManager.h"
 #include "SessionManager.h"
 #include "SharedLibManager.h"
 #include "StaticFileRouter.h"
+#include "WorkerProcesses.h"
 
 #include <iostream>
 #include <memory>
@@ -51,6 +64,10 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #define os_access access
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #elif !defined(_WIN32) || defined(__MINGW32__)
 #include <sys/file.h>
 #include <unistd.h>
@@ -78,6 +95,52 @@
 using namespace drogon;
 using namespace std::placeholders;
 
+namespace
+{
+// The durations of the phases of the startup, logged once the server listens
+class StartupPhases
+{
+  public:
+    void end(const char *phase)
+    {
+        auto now = std::chrono::steady_clock::now();
+        phases_.emplace_back(phase, milliseconds(now - last_));
+        last_ = now;
+    }
+
+    void log() const
+    {
+        std::string report;
+        for (auto &[phase, duration] : phases_)
+        {
+            report.append(report.empty() ? "" : ", ")
+                .append(phase)
+                .append(" ")
+                .append(std::to_string(duration))
+                .append("ms");
+        }
+        LOG_INFO << "Started in " << milliseconds(last_ - start_) << "ms ("
+                 << report << ")";
+    }
+
+    double sinceStart() const
+    {
+        return milliseconds(std::chrono::steady_clock::now() - start_);
+    }
+
+  private:
+    static double milliseconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    std::chrono::steady_clock::time_point start_{
+        std::chrono::steady_clock::now()};
+    std::chrono::steady_clock::time_point last_{start_};
+    std::vector<std::pair<const char *, double>> phases_;
+};
+}  // namespace
+
 HttpAppFrameworkImpl::HttpAppFrameworkImpl()
     : listenerManagerPtr_(new ListenerManager),
       pluginsManagerPtr_(new PluginsManager),
@@ -179,6 +242,17 @@ static void TERMFunction(int sig)
     }
 }
 
+#ifndef _WIN32
+// Only a flag is set in the handler, nothing else there is
+// async-signal-safe. The main loop polls it and reloads the configuration.
+static volatile std::sig_atomic_t hupReceived = 0;
+
+static void HUPFunction(int)
+{
+    hupReceived = 1;
+}
+#endif
+
 }  // namespace drogon
 
 HttpAppFrameworkImpl::~HttpAppFrameworkImpl() noexcept
@@ -201,6 +275,17 @@ int HttpAppFrameworkImpl::staticFilesCacheTime() const
     return StaticFileRouter::instance().staticFilesCacheTime();
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::setStaticFilesCacheSize(size_t bytes)
+{
+    StaticFileRouter::instance().setStaticFilesCacheSize(bytes);
+    return *this;
+}
+
+size_t HttpAppFrameworkImpl::getStaticFilesCacheSize() const
+{
+    return StaticFileRouter::instance().staticFilesCacheSize();
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setGzipStatic(bool useGzipStatic)
 {
     StaticFileRouter::instance().setGzipStatic(useGzipStatic);
@@ -213,6 +298,19 @@ HttpAppFramework &HttpAppFrameworkImpl::setBrStatic(bool useGzipStatic)
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::enableStaticFilesCompression(
+    bool enable,
+    const std::string &cachePath)
+{
+    StaticFileRouter::instance().setStaticFilesCompression(enable, cachePath);
+    return *this;
+}
+
+bool HttpAppFrameworkImpl::isStaticFilesCompressionEnabled() const
+{
+    return StaticFileRouter::instance().isStaticFilesCompressionEnabled();
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setImplicitPageEnable(
     bool useImplicitPage)
 {
@@ -317,6 +415,40 @@ HttpAppFramework &HttpAppFrameworkImpl::registerHttpSimpleController(
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::registerStaticResponse(
+    const std::string &path,
+    const HttpResponsePtr &resp,
+    const std::vector<internal::HttpConstraint> &constraints)
+{
+    assert(resp);
+    if (path.find('{') != std::string::npos)
+    {
+        LOG_ERROR << "Placeholders are not allowed in the path of a static "
+                     "response: "
+                  << path;
+        exit(1);
+    }
+    if (resp->expiredTime() < 0)
+    {
+        resp->setExpiredTime(0);
+    }
+    // The handler is called once per IO thread, then the copy it returns is
+    // served from the response cache of the binder. Each thread owning its
+    // copy means the rendered buffer is never shared between threads.
+    auto prototype =
+        std::make_shared<HttpResponseImpl>(*static_cast<HttpResponseImpl *>(
+            resp.get()));
+    registerHandler(
+        path,
+        [prototype = std::move(prototype)](
+            const HttpRequestPtr &,
+            std::function<void(const HttpResponsePtr &)> &&callback) {
+            callback(std::make_shared<HttpResponseImpl>(*prototype));
+        },
+        constraints);
+    return *this;
+}
+
 void HttpAppFrameworkImpl::registerHttpController(
     const std::string &pathPattern,
     const internal::HttpBinderBasePtr &binder,
@@ -356,6 +488,39 @@ HttpAppFramework &HttpAppFrameworkImpl::setThreadNum(size_t threadNum)
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::setIoThreadsAffinity(
+    const std::vector<unsigned int> &cpus)
+{
+    ioThreadsAffinity_.clear();
+#ifdef __linux__
+    // The CPUs the process may run on, the numbers of the online CPUs are
+    // not contiguous in a cpuset or with offlined CPUs
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        LOG_SYSERR << "sched_getaffinity";
+        CPU_ZERO(&allowed);
+    }
+    for (auto cpu : cpus)
+    {
+        // CPU_ISSET() reads out of its set for larger numbers
+        if (cpu >= static_cast<unsigned int>(CPU_SETSIZE) ||
+            !CPU_ISSET(cpu, &allowed))
+        {
+            LOG_ERROR << "The CPU " << cpu
+                      << " of the IO threads affinity is not available to "
+                         "the process, it is ignored";
+            continue;
+        }
+        ioThreadsAffinity_.push_back(cpu);
+    }
+#else
+    ioThreadsAffinity_ = cpus;
+#endif
+    return *this;
+}
+
 PluginBase *HttpAppFrameworkImpl::getPlugin(const std::string &name)
 {
     return pluginsManagerPtr_->getPlugin(name);
@@ -404,11 +569,20 @@ HttpAppFramework &HttpAppFrameworkImpl::addListener(
     const std::string &certFile,
     const std::string &keyFile,
     bool useOldTLS,
-    const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
+    const std::vector<std::pair<std::string, std::string>> &sslConfCmds,
+    bool proxyProtocol,
+    const ListenerSocketOptions &socketOptions)
 {
     assert(!running_);
-    listenerManagerPtr_->addListener(
-        ip, port, useSSL, certFile, keyFile, useOldTLS, sslConfCmds);
+    listenerManagerPtr_->addListener(ip,
+                                     port,
+                                     useSSL,
+                                     certFile,
+                                     keyFile,
+                                     useOldTLS,
+                                     sslConfCmds,
+                                     proxyProtocol,
+                                     socketOptions);
     return *this;
 }
 
@@ -419,6 +593,77 @@ HttpAppFramework &HttpAppFrameworkImpl::setMaxConnectionNum(
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::addEarlyHints(
+    const std::string &path,
+    const std::vector<std::string> &links)
+{
+    assert(!running_);
+    if (!path.empty() && path.back() == '*')
+        earlyHintPrefixes_.emplace_back(path.substr(0, path.length() - 1),
+                                        links);
+    else
+        earlyHints_[path] = links;
+    return *this;
+}
+
+const std::vector<std::string> *HttpAppFrameworkImpl::getEarlyHints(
+    const std::string &path) const
+{
+    if (!earlyHints_.empty())
+    {
+        auto iter = earlyHints_.find(path);
+        if (iter != earlyHints_.end())
+            return &iter->second;
+    }
+    for (auto &prefix : earlyHintPrefixes_)
+    {
+        if (path.compare(0, prefix.first.length(), prefix.first) == 0)
+            return &prefix.second;
+    }
+    return nullptr;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setComputeThreadNum(size_t threadNum)
+{
+    ComputePool::instance().setThreadNum(threadNum);
+    return *this;
+}
+
+size_t HttpAppFrameworkImpl::getComputeThreadNum() const
+{
+    return ComputePool::instance().threadNum();
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setHandlerThreadNum(
+    size_t maxThreadNum,
+    size_t minThreadNum)
+{
+    HandlerLoopPool::instance().setThreadNum(minThreadNum, maxThreadNum);
+    return *this;
+}
+
+size_t HttpAppFrameworkImpl::getHandlerThreadNum() const
+{
+    return HandlerLoopPool::instance().maxThreadNum();
+}
+
+void HttpAppFrameworkImpl::runInComputePool(std::function<void()> &&task)
+{
+    ComputePool::instance().run(std::move(task));
+}
+
+size_t HttpAppFrameworkImpl::getWorkerIndex() const
+{
+    return WorkerProcesses::instance().index();
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setClientBodyMemoryBudget(
+    size_t budget)
+{
+    BodyMemoryBudget::instance().setBudget(budget);
+    return *this;
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setMaxConnectionNumPerIP(
     size_t maxConnectionsPerIP)
 {
@@ -433,9 +678,36 @@ HttpAppFramework &HttpAppFrameworkImpl::loadConfigFile(
     ConfigLoader loader(fileName);
     loader.load();
     jsonConfig_ = loader.jsonValue();
+    configFile_ = fileName;
     return *this;
 }
 
+void HttpAppFrameworkImpl::reloadConfigFile()
+{
+    if (!getLoop()->isInLoopThread())
+    {
+        getLoop()->queueInLoop([this]() { reloadConfigFile(); });
+        return;
+    }
+    if (configFile_.empty())
+    {
+        LOG_ERROR << "No configuration file was loaded, nothing to reload";
+        return;
+    }
+    try
+    {
+        ConfigLoader loader(configFile_);
+        loader.reload();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << "Failed to reload the configuration file " << configFile_
+                  << ": " << e.what();
+        return;
+    }
+    LOG_INFO << "The configuration file " << configFile_ << " is reloaded";
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::loadConfigJson(const Json::Value &data)
 {
     ConfigLoader loader(data);
@@ -571,6 +843,27 @@ void HttpAppFrameworkImpl::run()
         getLoop()->resetAfterFork();
 #endif
     }
+    if (workerProcesses_ > 1)
+    {
+        if (!hotRestartSocket_.empty())
+        {
+            LOG_WARN << "The hot restart is not supported with worker "
+                        "processes";
+            hotRestartSocket_.clear();
+        }
+        // Only returns in the workers, before any thread is started
+        WorkerProcesses::instance().start(
+            workerProcesses_,
+            listenerManagerPtr_->getListenAddresses(),
+            reloadOnSighup_);
+        if (WorkerProcesses::instance().enabled())
+        {
+#ifdef __linux__
+            getLoop()->resetTimerQueue();
+#endif
+            getLoop()->resetAfterFork();
+        }
+    }
     if (handleSigterm_)
     {
 #ifdef WIN32
@@ -593,6 +886,27 @@ void HttpAppFrameworkImpl::run()
         }
 #endif
     }
+#ifndef _WIN32
+    if (reloadOnSighup_)
+    {
+        struct sigaction sa;
+        sa.sa_handler = HUPFunction;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = 0;
+        if (sigaction(SIGHUP, &sa, NULL) == -1)
+        {
+            LOG_ERROR << "sigaction() failed, can't set SIGHUP handler";
+            abort();
+        }
+        getLoop()->runEvery(1.0, []() {
+            if (hupReceived)
+            {
+                hupReceived = 0;
+                HttpAppFrameworkImpl::instance().reloadConfigFile();
+            }
+        });
+    }
+#endif
     setupFileLogger();
     if (relaunchOnError_)
     {
@@ -608,6 +922,7 @@ void HttpAppFrameworkImpl::run()
     }
 #endif
 
+    auto startupPhases = std::make_shared<StartupPhases>();
     // Create IO threads
     ioLoopThreadPool_ =
         std::make_unique<trantor::EventLoopThreadPool>(threadNum_,
@@ -618,27 +933,84 @@ void HttpAppFrameworkImpl::run()
         ioLoops[i]->setIndex(i);
     }
     getLoop()->setIndex(threadNum_);
+#ifdef __linux__
+    for (size_t i = 0; i < threadNum_ && !ioThreadsAffinity_.empty(); ++i)
+    {
+        // Runs before the loop accepts any connection
+        auto cpu = ioThreadsAffinity_[i % ioThreadsAffinity_.size()];
+        ioLoops[i]->queueInLoop([cpu]() {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(cpu, &cpuSet);
+            auto err =
+                pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+            if (err != 0)
+            {
+                LOG_ERROR << "Cannot pin the IO thread to the CPU " << cpu
+                          << ": " << strerror(err);
+            }
+        });
+    }
+#else
+    if (!ioThreadsAffinity_.empty())
+        LOG_WARN << "The IO threads affinity is only supported on Linux";
+#endif
+    // Queued after the pinning so the pages of the heaps are first touched
+    // on the CPUs of the loops
+    for (auto *loop : ioLoops)
+    {
+        loop->queueInLoop([]() { Allocator::bindThread(); });
+    }
+    if (enableDateHeader_)
+    {
+        // The Date header of the responses is formatted once per second by
+        // each loop
+        for (auto *loop : ioLoops)
+        {
+            loop->queueInLoop([loop]() { HttpDateCache::start(loop); });
+        }
+        getLoop()->queueInLoop([this]() { HttpDateCache::start(getLoop()); });
+    }
+    // Indexed after the IO loops and the main loop
+    HandlerLoopPool::instance().start(getLoop(), threadNum_ + 1);
+    startupPhases->end("io threads");
 
+    // Take the listening sockets of the process being replaced
+    if (!hotRestartSocket_.empty())
+        HotRestart::instance().takeOver(hotRestartSocket_);
     // Create all listeners.
     listenerManagerPtr_->createListeners(sslCertPath_,
                                          sslKeyPath_,
                                          sslConfCmds_,
                                          ioLoops);
+    startupPhases->end("listeners");
 
     // A fast database client instance should be created in the main event
     // loop, so put the main loop into ioLoops.
     ioLoops.push_back(getLoop());
+    // The connections are opened in the background by the loops
     dbClientManagerPtr_->createDbClients(ioLoops);
+    startupPhases->end("db clients");
     redisClientManagerPtr_->createRedisClients(ioLoops);
+    startupPhases->end("redis clients");
     if (useSession_)
     {
+        if (!sessionRedisClientName_.empty())
+        {
+            sessionStore_ = std::make_shared<RedisSessionStore>(
+                getRedisClient(sessionRedisClientName_));
+        }
         sessionManagerPtr_ =
             std::make_unique<SessionManager>(getLoop(),
                                              sessionTimeout_,
                                              sessionStartAdvices_,
                                              sessionDestroyAdvices_,
-                                             sessionIdGeneratorCallback_);
+                                             sessionIdGeneratorCallback_,
+                                             sessionStore_,
+                                             sessionNearCacheTtl_,
+                                             sessionCopyOnWrite_);
     }
+    startupPhases->end("sessions");
     // now start running!!
     running_ = true;
     // Initialize plugins
@@ -667,18 +1039,66 @@ void HttpAppFrameworkImpl::run()
                                                          << plugin->className();
                                                      // TODO: new plugin
                                                  });
+        for (auto &[name, duration] : pluginsManagerPtr_->initTimes())
+        {
+            LOG_DEBUG << "Plugin " << name << " initialized in "
+                      << duration * 1000 << "ms";
+        }
     }
+    startupPhases->end("plugins");
     routersInit_ = true;
     HttpControllersRouter::instance().init(ioLoops);
     StaticFileRouter::instance().init(ioLoops);
-    getLoop()->queueInLoop([this]() {
+    CompressedBodyCache::instance().init(compressedBodyCacheSize_);
+    if (CompressedBodyCache::instance().enabled())
+    {
+        auto exporter = std::dynamic_pointer_cast<plugin::PromExporter>(
+            getSharedPlugin(plugin::PromExporter::classTypeName()));
+        if (exporter)
+        {
+            CompressedBodyCache::instance().collector()->registerTo(*exporter);
+        }
+    }
+    startupPhases->end("routers");
+    getLoop()->queueInLoop([this, startupPhases]() {
         for (auto &adv : beginningAdvices_)
         {
             adv();
         }
         beginningAdvices_.clear();
+        startupPhases->end("beginning advices");
         // Let listener event loops run when everything is ready.
         listenerManagerPtr_->startListening();
+        startupPhases->end("listening");
+        startupPhases->log();
+        if (!dbClientManagerPtr_->empty())
+        {
+            // The pools connect in the background, tell when they are ready
+            auto timerId = std::make_shared<trantor::TimerId>();
+            *timerId = getLoop()->runEvery(
+                0.05, [this, timerId, startupPhases]() {
+                    if (!dbClientManagerPtr_->areAllDbClientsAvailable())
+                        return;
+                    getLoop()->invalidateTimer(*timerId);
+                    LOG_INFO << "The database clients are available "
+                             << startupPhases->sinceStart()
+                             << "ms after the start";
+                });
+        }
+        if (!hotRestartSocket_.empty())
+        {
+            HotRestart::instance().start(getLoop(), hotRestartDrainTimeout_);
+        }
+        if (loopStallThreshold_ > 0)
+        {
+            LoopWatchdog::instance().start(ioLoopThreadPool_->getLoops(),
+                                           loopStallThreshold_);
+        }
+        if (sslReloadInterval_ > 0)
+        {
+            getLoop()->runEvery(sslReloadInterval_,
+                                [this]() { reloadSSLFiles(); });
+        }
     });
     // start all loops
     // TODO: when should IOLoops start?
@@ -704,20 +1124,41 @@ HttpAppFramework &HttpAppFrameworkImpl::setUploadPath(
     return *this;
 }
 
-void HttpAppFrameworkImpl::findSessionForRequest(const HttpRequestImplPtr &req)
+bool HttpAppFrameworkImpl::findSessionForRequest(const HttpRequestImplPtr &req)
 {
     if (useSession_)
     {
-        std::string sessionId = req->getCookie(sessionCookieKey_);
+        std::string sessionId(req->getCookieView(sessionCookieKey_));
         bool needSetSessionid = false;
         if (sessionId.empty())
         {
             sessionId = sessionIdGeneratorCallback_();
             needSetSessionid = true;
         }
-        req->setSession(
-            sessionManagerPtr_->getSession(sessionId, needSetSessionid));
+        auto sessionPtr =
+            sessionManagerPtr_->getSession(sessionId, needSetSessionid);
+        if (!sessionPtr)
+            return false;
+        req->setSession(std::move(sessionPtr));
     }
+    return true;
+}
+
+size_t HttpAppFrameworkImpl::sessionCount() const
+{
+    return sessionManagerPtr_ ? sessionManagerPtr_->sessionCount() : 0;
+}
+
+void HttpAppFrameworkImpl::loadSessionForRequest(
+    const HttpRequestImplPtr &req,
+    std::function<void()> &&callback)
+{
+    sessionManagerPtr_->loadSession(
+        std::string(req->getCookieView(sessionCookieKey_)),
+        [req, callback = std::move(callback)](const SessionPtr &sessionPtr) {
+            req->setSession(sessionPtr);
+            callback();
+        });
 }
 
 std::vector<HttpHandlerInfo> HttpAppFrameworkImpl::getHandlersInfo() const
@@ -740,6 +1181,7 @@ HttpResponsePtr HttpAppFrameworkImpl::handleSessionForResponse(
         {
             sessionManagerPtr_->changeSessionId(sessionPtr);
         }
+        sessionManagerPtr_->saveSession(sessionPtr);
         if (sessionPtr->needSetToClient())
         {
             if (resp->expiredTime() >= 0)
@@ -896,16 +1338,85 @@ void HttpAppFrameworkImpl::forward(
     }
 }
 
+void HttpAppFrameworkImpl::subrequest(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    auto reqImpl = std::static_pointer_cast<HttpRequestImpl>(req);
+    auto loop = reqImpl->getLoop();
+    if (loop && !loop->isInLoopThread())
+    {
+        loop->queueInLoop(
+            [reqImpl = std::move(reqImpl),
+             callback = std::move(callback)]() mutable {
+                HttpInternalForwardHelper::subrequest(reqImpl,
+                                                      std::move(callback));
+            });
+        return;
+    }
+    HttpInternalForwardHelper::subrequest(reqImpl, std::move(callback));
+}
+
+void HttpAppFrameworkImpl::subrequests(
+    std::vector<HttpRequestPtr> reqs,
+    std::function<void(std::vector<HttpResponsePtr> &&)> &&callback)
+{
+    struct Results
+    {
+        std::vector<HttpResponsePtr> responses;
+        std::function<void(std::vector<HttpResponsePtr> &&)> callback;
+        std::atomic<size_t> pending;
+    };
+
+    if (reqs.empty())
+    {
+        callback({});
+        return;
+    }
+    auto results = std::make_shared<Results>();
+    results->responses.resize(reqs.size());
+    results->callback = std::move(callback);
+    results->pending = reqs.size();
+    for (size_t i = 0; i < reqs.size(); ++i)
+    {
+        subrequest(reqs[i], [results, i](const HttpResponsePtr &resp) {
+            results->responses[i] = resp;
+            if (--results->pending == 0)
+            {
+                results->callback(std::move(results->responses));
+            }
+        });
+    }
+}
+
 orm::DbClientPtr HttpAppFrameworkImpl::getDbClient(const std::string &name)
 {
     return dbClientManagerPtr_->getDbClient(name);
 }
 
+const std::map<std::string, orm::DbClientPtr> &
+HttpAppFrameworkImpl::dbClients() const
+{
+    return dbClientManagerPtr_->dbClients();
+}
+
+const std::map<std::string, nosql::RedisClientPtr> &
+HttpAppFrameworkImpl::redisClients() const
+{
+    return redisClientManagerPtr_->redisClients();
+}
+
 orm::DbClientPtr HttpAppFrameworkImpl::getFastDbClient(const std::string &name)
 {
     return dbClientManagerPtr_->getFastDbClient(name);
 }
 
+orm::ShardedDbClientPtr HttpAppFrameworkImpl::getShardedDbClient(
+    const std::string &name)
+{
+    return dbClientManagerPtr_->getShardedDbClient(name);
+}
+
 nosql::RedisClientPtr HttpAppFrameworkImpl::getRedisClient(
     const std::string &name)
 {
@@ -966,7 +1477,18 @@ void HttpAppFrameworkImpl::addDbClient(
     const std::string &characterSet,
     double timeout,
     bool autoBatch,
-    std::unordered_map<std::string, std::string> options)
+    std::unordered_map<std::string, std::string> options,
+    bool loopAffine,
+    bool binaryResults,
+    size_t statementCacheSize,
+    size_t warmStatements,
+    std::vector<orm::ReplicaConfig> replicas,
+    double maxReplicaLag,
+    bool walPool,
+    bool batchWrites,
+    bool preparedStatements,
+    const orm::PoolConfig &pool,
+    const orm::QueryStatsConfig &queryStats)
 {
     if (dbType == "postgresql" || dbType == "postgres")
     {
@@ -981,7 +1503,15 @@ void HttpAppFrameworkImpl::addDbClient(
                                         characterSet,
                                         timeout,
                                         autoBatch,
-                                        std::move(options)});
+                                        std::move(options),
+                                        loopAffine,
+                                        binaryResults,
+                                        statementCacheSize,
+                                        warmStatements,
+                                        std::move(replicas),
+                                        maxReplicaLag,
+                                        pool,
+                                        queryStats});
     }
     else if (dbType == "mysql")
     {
@@ -994,11 +1524,24 @@ void HttpAppFrameworkImpl::addDbClient(
                                      name,
                                      isFast,
                                      characterSet,
-                                     timeout});
+                                     timeout,
+                                     loopAffine,
+                                     std::move(replicas),
+                                     maxReplicaLag,
+                                     preparedStatements,
+                                     statementCacheSize,
+                                     pool,
+                                     queryStats});
     }
     else if (dbType == "sqlite3")
     {
-        addDbClient(orm::Sqlite3Config{connectionNum, filename, name, timeout});
+        addDbClient(orm::Sqlite3Config{connectionNum,
+                                       filename,
+                                       name,
+                                       timeout,
+                                       walPool,
+                                       batchWrites,
+                                       queryStats});
     }
     else
     {
@@ -1014,6 +1557,20 @@ HttpAppFramework &HttpAppFrameworkImpl::addDbClient(const orm::DbConfig &config)
     return *this;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::addShardedDbClient(
+    const std::string &name,
+    const std::vector<std::string> &shards,
+    const std::map<std::string, std::string> &shardMap,
+    size_t virtualNodes)
+{
+    assert(!running_);
+    dbClientManagerPtr_->addShardedDbClient(name,
+                                            shards,
+                                            shardMap,
+                                            virtualNodes);
+    return *this;
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::createRedisClient(
     const std::string &ip,
     unsigned short port,
@@ -1023,11 +1580,26 @@ HttpAppFramework &HttpAppFrameworkImpl::createRedisClient(
     bool isFast,
     double timeout,
     unsigned int db,
-    const std::string &username)
+    const std::string &username,
+    bool cluster,
+    size_t fastConnectionNum,
+    const std::string &sentinelMaster,
+    bool replicaReads)
 {
     assert(!running_);
-    redisClientManagerPtr_->createRedisClient(
-        name, ip, port, username, password, connectionNum, isFast, timeout, db);
+    redisClientManagerPtr_->createRedisClient(name,
+                                              ip,
+                                              port,
+                                              username,
+                                              password,
+                                              connectionNum,
+                                              isFast,
+                                              timeout,
+                                              db,
+                                              cluster,
+                                              fastConnectionNum,
+                                              sentinelMaster,
+                                              replicaReads);
     return *this;
 }
 
@@ -1037,8 +1609,11 @@ void HttpAppFrameworkImpl::quit()
     {
         getLoop()->queueInLoop([this]() {
             // Release members in the reverse order of initialization
+            LoopWatchdog::instance().stop();
+            HotRestart::instance().stop();
             listenerManagerPtr_->stopListening();
             listenerManagerPtr_.reset();
+            HandlerLoopPool::instance().stop();
             StaticFileRouter::instance().reset();
             HttpControllersRouter::instance().reset();
             pluginsManagerPtr_.reset();
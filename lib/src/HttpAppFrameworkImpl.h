@@ -17,10 +17,15 @@
 #include <drogon/HttpAppFramework.h>
 #include <drogon/config.h>
 #include <json/json.h>
+#include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include "LoopAffinity.h"
+#include "RequestPhases.h"
 #include "SessionManager.h"
 #include "drogon/utils/Utilities.h"
 #include "impl_forwards.h"
@@ -70,8 +75,9 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         const std::string &certFile,
         const std::string &keyFile,
         bool useOldTLS,
-        const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
-        override;
+        const std::vector<std::pair<std::string, std::string>> &sslConfCmds,
+        bool proxyProtocol,
+        const ListenerSocketOptions &socketOptions) override;
     HttpAppFramework &setThreadNum(size_t threadNum) override;
 
     size_t getThreadNum() const override
@@ -79,6 +85,46 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return threadNum_;
     }
 
+    HttpAppFramework &setIoThreadsAffinity(
+        const std::vector<unsigned int> &cpus) override;
+
+    const std::vector<unsigned int> &getIoThreadsAffinity() const override
+    {
+        return ioThreadsAffinity_;
+    }
+
+    HttpAppFramework &setLoopAffinityKey(const std::string &key) override
+    {
+        if (!loopAffinity_.setKey(key))
+            LOG_ERROR << "Invalid loop affinity key: " << key;
+        return *this;
+    }
+
+    const LoopAffinity &loopAffinity() const
+    {
+        return loopAffinity_;
+    }
+
+    HttpAppFramework &setComputeThreadNum(size_t threadNum) override;
+    size_t getComputeThreadNum() const override;
+    HttpAppFramework &setHandlerThreadNum(size_t maxThreadNum,
+                                          size_t minThreadNum) override;
+    size_t getHandlerThreadNum() const override;
+    void runInComputePool(std::function<void()> &&task) override;
+
+    HttpAppFramework &setWorkerProcesses(size_t num) override
+    {
+        workerProcesses_ = num;
+        return *this;
+    }
+
+    size_t getWorkerProcesses() const override
+    {
+        return workerProcesses_;
+    }
+
+    size_t getWorkerIndex() const override;
+
     HttpAppFramework &setSSLConfigCommands(
         const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
         override;
@@ -86,6 +132,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
                                   const std::string &keyPath) override;
 
     HttpAppFramework &reloadSSLFiles() override;
+    HttpAppFramework &setSSLReloadInterval(double seconds) override
+    {
+        sslReloadInterval_ = seconds;
+        return *this;
+    }
 
     void run() override;
     HttpAppFramework &registerWebSocketController(
@@ -100,6 +151,10 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         const std::string &pathName,
         const std::string &ctrlName,
         const std::vector<internal::HttpConstraint> &constraints) override;
+    HttpAppFramework &registerStaticResponse(
+        const std::string &path,
+        const HttpResponsePtr &resp,
+        const std::vector<internal::HttpConstraint> &constraints) override;
 
     HttpAppFramework &setCustom404Page(const HttpResponsePtr &resp,
                                        bool set404) override
@@ -129,6 +184,14 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
                  const std::string &hostString,
                  double timeout = 0);
 
+    void subrequest(
+        const HttpRequestPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback) override;
+
+    void subrequests(std::vector<HttpRequestPtr> reqs,
+                     std::function<void(std::vector<HttpResponsePtr> &&)>
+                         &&callback) override;
+
     HttpAppFramework &registerBeginningAdvice(
         const std::function<void()> &advice) override
     {
@@ -215,6 +278,31 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return *this;
     }
 
+    HttpAppFramework &enableSessionCopyOnWrite(bool enable = true) override
+    {
+        sessionCopyOnWrite_ = enable;
+        return *this;
+    }
+
+    HttpAppFramework &setSessionStore(SessionStorePtr store,
+                                      size_t nearCacheTtl = 5) override
+    {
+        sessionStore_ = std::move(store);
+        sessionRedisClientName_.clear();
+        sessionNearCacheTtl_ = nearCacheTtl;
+        return *this;
+    }
+
+    HttpAppFramework &setRedisSessionStore(
+        const std::string &redisClientName = "default",
+        size_t nearCacheTtl = 5) override
+    {
+        sessionStore_.reset();
+        sessionRedisClientName_ = redisClientName;
+        sessionNearCacheTtl_ = nearCacheTtl;
+        return *this;
+    }
+
     HttpAppFramework &registerSessionStartAdvice(
         const AdviceStartSessionCallback &advice) override
     {
@@ -273,6 +361,7 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         const std::string &outputPath) override;
 #endif
     HttpAppFramework &setMaxConnectionNum(size_t maxConnections) override;
+    HttpAppFramework &setClientBodyMemoryBudget(size_t budget) override;
     HttpAppFramework &setMaxConnectionNumPerIP(
         size_t maxConnectionsPerIP) override;
     HttpAppFramework &loadConfigFile(const std::string &fileName) noexcept(
@@ -294,6 +383,14 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return *this;
     }
 
+    void reloadConfigFile() override;
+
+    HttpAppFramework &enableConfigReloadOnSighup(bool enable) override
+    {
+        reloadOnSighup_ = enable;
+        return *this;
+    }
+
     HttpAppFramework &enableRelaunchOnError() override
     {
         relaunchOnError_ = true;
@@ -336,8 +433,56 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return useBrotli_;
     }
 
+    HttpAppFramework &enableZstd(bool useZstd) override
+    {
+        useZstd_ = useZstd;
+        return *this;
+    }
+
+    bool isZstdEnabled() const override
+    {
+        return useZstd_;
+    }
+
+    HttpAppFramework &setZstdCompressionLevel(int level) override
+    {
+        zstdCompressionLevel_ = level;
+        return *this;
+    }
+
+    int getZstdCompressionLevel() const override
+    {
+        return zstdCompressionLevel_;
+    }
+
+    HttpAppFramework &setZstdDictionary(std::string dictionary) override
+    {
+        assert(!running_);
+        zstdDictionary_ = std::move(dictionary);
+        return *this;
+    }
+
+    const std::string &getZstdDictionary() const override
+    {
+        return zstdDictionary_;
+    }
+
+    HttpAppFramework &setCompressedBodyCacheSize(size_t bytes) override
+    {
+        assert(!running_);
+        compressedBodyCacheSize_ = bytes;
+        return *this;
+    }
+
+    size_t getCompressedBodyCacheSize() const override
+    {
+        return compressedBodyCacheSize_;
+    }
+
     HttpAppFramework &setStaticFilesCacheTime(int cacheTime) override;
     int staticFilesCacheTime() const override;
+    HttpAppFramework &setStaticFilesCacheSize(size_t bytes) override;
+    size_t getStaticFilesCacheSize() const override;
 
     HttpAppFramework &setIdleConnectionTimeout(size_t timeout) override
     {
@@ -350,6 +495,71 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return idleConnectionTimeout_;
     }
 
+    HttpAppFramework &setRequestDeadline(double timeout) override
+    {
+        requestDeadline_ = timeout;
+        return *this;
+    }
+
+    double getRequestDeadline() const override
+    {
+        return requestDeadline_;
+    }
+
+    HttpAppFramework &setSlowClientTimeouts(double headerTimeout,
+                                            double bodyTimeout,
+                                            size_t minBodyRate) override
+    {
+        headerTimeout_ = headerTimeout;
+        bodyTimeout_ = bodyTimeout;
+        minBodyRate_ = minBodyRate;
+        return *this;
+    }
+
+    double getHeaderTimeout() const
+    {
+        return headerTimeout_;
+    }
+
+    double getBodyTimeout() const
+    {
+        return bodyTimeout_;
+    }
+
+    size_t getMinBodyRate() const
+    {
+        return minBodyRate_;
+    }
+
+    HttpAppFramework &addEarlyHints(
+        const std::string &path,
+        const std::vector<std::string> &links) override;
+
+    /// The links of the early hints of a path, nullptr if there are none
+    const std::vector<std::string> *getEarlyHints(
+        const std::string &path) const;
+
+    HttpAppFramework &setPhaseTracing(double sampleRate,
+                                      bool serverTiming) override
+    {
+        PhaseTracing::configure(sampleRate, serverTiming);
+        return *this;
+    }
+
+    HttpAppFramework &setLoopStallThreshold(double threshold) override
+    {
+        loopStallThreshold_ = threshold;
+        return *this;
+    }
+
+    HttpAppFramework &setHotRestartSocket(const std::string &path,
+                                          double drainTimeout) override
+    {
+        hotRestartSocket_ = path;
+        hotRestartDrainTimeout_ = drainTimeout;
+        return *this;
+    }
+
     HttpAppFramework &setKeepaliveRequestsNumber(const size_t number) override
     {
         keepaliveRequestsNumber_ = number;
@@ -364,6 +574,10 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
 
     HttpAppFramework &setGzipStatic(bool useGzipStatic) override;
     HttpAppFramework &setBrStatic(bool useGzipStatic) override;
+    HttpAppFramework &enableStaticFilesCompression(
+        bool enable,
+        const std::string &cachePath) override;
+    bool isStaticFilesCompressionEnabled() const override;
 
     HttpAppFramework &setClientMaxBodySize(size_t maxSize) override
     {
@@ -383,6 +597,13 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return *this;
     }
 
+    HttpAppFramework &setWebSocketCompressionOptions(
+        const WebSocketCompressionOptions &options) override
+    {
+        webSocketCompressionOptions_ = options;
+        return *this;
+    }
+
     HttpAppFramework &setHomePage(const std::string &homePageFile) override
     {
         homePageFile_ = homePageFile;
@@ -439,6 +660,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return clientMaxWebSocketMessageSize_;
     }
 
+    const WebSocketCompressionOptions &getWebSocketCompressionOptions() const
+    {
+        return webSocketCompressionOptions_;
+    }
+
     std::vector<HttpHandlerInfo> getHandlersInfo() const override;
 
     size_t keepaliveRequestsNumber() const
@@ -469,6 +695,20 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return jsonStackLimit_;
     }
 
+    HttpAppFramework &setJsonBackend(
+        const std::shared_ptr<JsonBackend> &backend) override
+    {
+        assert(!running_);
+        assert(backend);
+        jsonBackend_ = backend;
+        return *this;
+    }
+
+    const std::shared_ptr<JsonBackend> &getJsonBackend() const noexcept override
+    {
+        return jsonBackend_;
+    }
+
     HttpAppFramework &setUnicodeEscapingInJson(bool enable) noexcept override
     {
         usingUnicodeEscaping_ = enable;
@@ -520,6 +760,12 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return *this;
     }
 
+    HttpAppFramework &enableDynamicETags(bool flag) override
+    {
+        enableDynamicETags_ = flag;
+        return *this;
+    }
+
     bool sendServerHeader() const
     {
         return enableServerHeader_;
@@ -530,6 +776,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return enableDateHeader_;
     }
 
+    bool useDynamicETags() const
+    {
+        return enableDynamicETags_;
+    }
+
     const std::string &getServerHeaderString() const
     {
         return serverHeader_;
@@ -537,6 +788,8 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
 
     orm::DbClientPtr getDbClient(const std::string &name) override;
     orm::DbClientPtr getFastDbClient(const std::string &name) override;
+    orm::ShardedDbClientPtr getShardedDbClient(
+        const std::string &name) override;
 
     HttpAppFramework &createDbClient(const std::string &dbType,
                                      const std::string &host,
@@ -565,8 +818,24 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
                      const std::string &characterSet,
                      double timeout,
                      bool autoBatch,
-                     std::unordered_map<std::string, std::string> options);
+                     std::unordered_map<std::string, std::string> options,
+                     bool loopAffine = false,
+                     bool binaryResults = false,
+                     size_t statementCacheSize = 0,
+                     size_t warmStatements = 0,
+                     std::vector<orm::ReplicaConfig> replicas = {},
+                     double maxReplicaLag = -1.0,
+                     bool walPool = false,
+                     bool batchWrites = false,
+                     bool preparedStatements = false,
+                     const orm::PoolConfig &pool = {},
+                     const orm::QueryStatsConfig &queryStats = {});
     HttpAppFramework &addDbClient(const orm::DbConfig &config) override;
+    HttpAppFramework &addShardedDbClient(
+        const std::string &name,
+        const std::vector<std::string> &shards,
+        const std::map<std::string, std::string> &shardMap,
+        size_t virtualNodes) override;
 
     HttpAppFramework &createRedisClient(const std::string &ip,
                                         unsigned short port,
@@ -576,7 +845,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
                                         bool isFast,
                                         double timeout,
                                         unsigned int db,
-                                        const std::string &username) override;
+                                        const std::string &username,
+                                        bool cluster,
+                                        size_t fastConnectionNum,
+                                        const std::string &sentinelMaster,
+                                        bool replicaReads) override;
     nosql::RedisClientPtr getRedisClient(const std::string &name) override;
     nosql::RedisClientPtr getFastRedisClient(const std::string &name) override;
     std::vector<trantor::InetAddress> getListeners() const override;
@@ -627,6 +900,40 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return reusePort_;
     }
 
+    HttpAppFramework &enableHttp2(bool enable) override
+    {
+        http2Enabled_ = enable;
+        return *this;
+    }
+
+    bool isHttp2Enabled() const override
+    {
+        return http2Enabled_;
+    }
+
+    HttpAppFramework &enableHttp3(bool enable) override
+    {
+        http3Enabled_ = enable;
+        return *this;
+    }
+
+    bool isHttp3Enabled() const override
+    {
+        return http3Enabled_;
+    }
+
+    /// Set by the listeners once the ports of HTTP/3 are known
+    void setAltSvcHeader(std::string header)
+    {
+        altSvcHeader_ = std::move(header);
+    }
+
+    // The Alt-Svc field of the responses, empty without HTTP/3
+    const std::string &getAltSvcHeaderString() const
+    {
+        return altSvcHeader_;
+    }
+
     HttpAppFramework &setExceptionHandler(ExceptionHandler handler) override
     {
         exceptionHandler_ = std::move(handler);
@@ -657,9 +964,21 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     int64_t getConnectionCount() const override;
 
     // TODO: move session related codes to its own singleton class
-    void findSessionForRequest(const HttpRequestImplPtr &req);
+    /**
+     * @brief Set the session to the request, return false if it has to be
+     * loaded from the session store by loadSessionForRequest().
+     */
+    bool findSessionForRequest(const HttpRequestImplPtr &req);
+    void loadSessionForRequest(const HttpRequestImplPtr &req,
+                               std::function<void()> &&callback);
     HttpResponsePtr handleSessionForResponse(const HttpRequestImplPtr &req,
                                              const HttpResponsePtr &resp);
+    /// The sessions held in memory, 0 if the sessions are disabled
+    size_t sessionCount() const;
+
+    /// The shared database and redis clients by name, for the diagnosis
+    const std::map<std::string, orm::DbClientPtr> &dbClients() const;
+    const std::map<std::string, nosql::RedisClientPtr> &redisClients() const;
 
     HttpAppFramework &setBeforeListenSockOptCallback(
         std::function<void(int)> cb) override;
@@ -688,10 +1007,27 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     // set sessionTimeout_=0 to make location session valid forever based on
     // cookies;
     size_t sessionTimeout_{0};
+    SessionStorePtr sessionStore_;
+    std::string sessionRedisClientName_;
+    size_t sessionNearCacheTtl_{5};
+    bool sessionCopyOnWrite_{false};
     Cookie::SameSite sessionSameSite_{Cookie::SameSite::kNull};
     std::string sessionCookieKey_{"JSESSIONID"};
     int sessionMaxAge_{-1};
-    size_t idleConnectionTimeout_{60};
+    // The settings read by the IO threads while they can be reloaded (see
+    // reloadConfigFile()) are atomic
+    std::atomic<size_t> idleConnectionTimeout_{60};
+    std::atomic<double> requestDeadline_{0};
+    std::atomic<double> headerTimeout_{0};
+    std::atomic<double> bodyTimeout_{0};
+    std::atomic<size_t> minBodyRate_{0};
+    std::unordered_map<std::string, std::vector<std::string>> earlyHints_;
+    std::vector<std::pair<std::string, std::vector<std::string>>>
+        earlyHintPrefixes_;
+    double loopStallThreshold_{0};
+    std::string hotRestartSocket_;
+    double hotRestartDrainTimeout_{30};
+    size_t workerProcesses_{1};
     bool useSession_{false};
     std::string serverHeader_{"server: drogon/" + drogon::getVersion() +
                               "\r\n"};
@@ -707,6 +1043,8 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     std::atomic_bool routersInit_{false};
 
     size_t threadNum_{1};
+    std::vector<unsigned int> ioThreadsAffinity_;
+    LoopAffinity loopAffinity_;
     std::unique_ptr<trantor::EventLoopThreadPool> ioLoopThreadPool_;
 
 #if !defined(_WIN32) && !TARGET_OS_IOS
@@ -718,28 +1056,38 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     std::vector<std::pair<std::string, std::string>> sslConfCmds_;
     std::string sslCertPath_;
     std::string sslKeyPath_;
+    double sslReloadInterval_{0};
 
     bool runAsDaemon_{false};
     bool handleSigterm_{true};
+    bool reloadOnSighup_{false};
+    // The file loaded by loadConfigFile(), to be reloaded
+    std::string configFile_;
     bool relaunchOnError_{false};
     bool logWithSpdlog_{false};
     std::string logPath_;
     std::string logfileBaseName_;
     size_t logfileSize_{100000000};
     size_t logfileMaxNum_{0};
-    size_t keepaliveRequestsNumber_{0};
-    size_t pipeliningRequestsNumber_{0};
+    std::atomic<size_t> keepaliveRequestsNumber_{0};
+    std::atomic<size_t> pipeliningRequestsNumber_{0};
     size_t jsonStackLimit_{1000};
+    std::shared_ptr<JsonBackend> jsonBackend_{JsonBackend::create("jsoncpp")};
     bool useSendfile_{true};
-    bool useGzip_{true};
-    bool useBrotli_{false};
+    std::atomic<bool> useGzip_{true};
+    std::atomic<bool> useBrotli_{false};
+    std::atomic<bool> useZstd_{false};
+    std::atomic<int> zstdCompressionLevel_{3};
+    std::string zstdDictionary_;
+    size_t compressedBodyCacheSize_{0};
     bool usingUnicodeEscaping_{true};
     std::pair<unsigned int, std::string> floatPrecisionInJson_{0,
                                                                "significant"};
     bool usingCustomErrorHandler_{false};
-    size_t clientMaxBodySize_{1024 * 1024};
-    size_t clientMaxMemoryBodySize_{64 * 1024};
-    size_t clientMaxWebSocketMessageSize_{128 * 1024};
+    std::atomic<size_t> clientMaxBodySize_{1024 * 1024};
+    std::atomic<size_t> clientMaxMemoryBodySize_{64 * 1024};
+    std::atomic<size_t> clientMaxWebSocketMessageSize_{128 * 1024};
+    WebSocketCompressionOptions webSocketCompressionOptions_;
     std::string homePageFile_{"index.html"};
     std::function<void()> termSignalHandler_{[]() { app().quit(); }};
     std::function<void()> intSignalHandler_{[]() { app().quit(); }};
@@ -756,7 +1104,11 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     static InitBeforeMainFunction initFirst_;
     bool enableServerHeader_{true};
     bool enableDateHeader_{true};
+    bool enableDynamicETags_{false};
     bool reusePort_{false};
+    bool http2Enabled_{false};
+    bool http3Enabled_{false};
+    std::string altSvcHeader_;
     std::vector<std::function<void()>> beginningAdvices_;
 
     ExceptionHandler exceptionHandler_{defaultExceptionHandler};
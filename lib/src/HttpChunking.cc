@@ -0,0 +1,119 @@
+/**
+ *
+ *  @file HttpChunking.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpChunking.h"
+#include <trantor/utils/Logger.h>
+#include <cstdio>
+#include <cstring>
+
+std::size_t drogon::chunkingCallback(
+    const std::shared_ptr<ChunkingParams> &cbParams,
+    char *pBuffer,
+    std::size_t nSize)
+{
+    if (!cbParams)
+        return 0;
+    // Cleanup
+    if (pBuffer == nullptr)
+    {
+        LOG_TRACE << "Chunking callback cleanup";
+        if (cbParams && cbParams->dataCallback)
+        {
+            cbParams->dataCallback(pBuffer, nSize);
+            cbParams->dataCallback = {};
+        }
+        return 0;
+    }
+    // Terminal chunk already returned
+    if (cbParams->bFinished)
+    {
+        LOG_TRACE << "Chunking callback has no more data";
+#ifndef NDEBUG  // defined by CMake for release build
+        LOG_TRACE << "Chunking callback: total data returned: "
+                  << cbParams->nDataReturned << " bytes";
+#endif
+        return 0;
+    }
+
+    // Reserve size to prepend the chunk size & append cr/lf, and get data
+    struct
+    {
+        std::size_t operator()(std::size_t n)
+        {
+            return n == 0 ? 0 : 1 + (*this)(n >> 4);
+        }
+    } neededDigits;
+
+    auto nHeaderSize = neededDigits(nSize) + 2;
+    auto nDataSize =
+        cbParams->dataCallback(pBuffer + nHeaderSize, nSize - nHeaderSize - 2);
+    if (nDataSize == 0)
+    {
+        // Terminal chunk + cr/lf
+        cbParams->bFinished = true;
+#ifdef _WIN32
+        memcpy_s(pBuffer, nSize, "0\r\n\r\n", 5);
+#else
+        memcpy(pBuffer, "0\r\n\r\n", 5);
+#endif
+        LOG_TRACE << "Chunking callback: no more data, return last chunk of "
+                     "size 0 & end of message";
+        return 5;
+    }
+    // Non-terminal chunks
+    pBuffer[nHeaderSize + nDataSize] = '\r';
+    pBuffer[nHeaderSize + nDataSize + 1] = '\n';
+    // The spec does not say if the chunk size is allowed tohave leading zeroes
+    // Use a fixed size header with leading zeroes
+    // (tested to work with Chrome, Firefox, Safari, Edge, wget, curl and VLC)
+#ifdef _WIN32
+    char pszFormat[]{"%04llx\r"};
+#else
+    char pszFormat[]{"%04lx\r"};
+#endif
+    pszFormat[2] = '0' + char(nHeaderSize - 2);
+    snprintf(pBuffer, nHeaderSize, pszFormat, nDataSize);
+    pBuffer[nHeaderSize - 1] = '\n';
+    LOG_TRACE << "Chunking callback: return chunk of size " << nDataSize;
+#ifndef NDEBUG  // defined by CMake for release build
+    cbParams->nDataReturned += nDataSize;
+#endif
+    return nHeaderSize + nDataSize + 2;
+    // Alternative code if there are client software that do not support chunk
+    // size with leading zeroes
+    //    auto nHeaderLen =
+    // #ifdef _WIN32
+    //    sprintf_s(pBuffer,
+    //    nHeaderSize, "%llx\r",
+    //    nDataSize);
+    // #else
+    //    sprintf(pBuffer, "%lx\r",
+    //    nDataSize);
+    // #endif
+    //    pBuffer[nHeaderLen++] = '\n';
+    //    if (nHeaderLen < nHeaderSize)  // smaller that what was reserved ->
+    //    move data
+    // #ifdef _WIN32
+    //    memmove_s(pBuffer +
+    //    nHeaderLen,
+    //              nSize - nHeaderLen,
+    //              pBuffer +
+    //              nHeaderSize,
+    //              nDataSize + 2);
+    // #else
+    //    memmove(pBuffer + nHeaderLen,
+    //            pBuffer + nHeaderSize,
+    //            nDataSize + 2);
+    // #endif
+    //    return nHeaderLen + nDataSize + 2;
+}
@@ -0,0 +1,48 @@
+/**
+ *
+ *  @file HttpChunking.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace drogon
+{
+/// The state of a stream sent with the chunked transfer coding
+struct ChunkingParams
+{
+    using DataCallback = std::function<std::size_t(char *, std::size_t)>;
+
+    explicit ChunkingParams(DataCallback cb) : dataCallback(std::move(cb))
+    {
+    }
+
+    DataCallback dataCallback;
+    bool bFinished{false};
+#ifndef NDEBUG  // defined by CMake for release build
+    std::size_t nDataReturned{0};
+#endif
+};
+
+/**
+ * @brief Fill the buffer with a chunk of the data of the callback, its
+ * header and its trailing CRLF, or with the last chunk when the callback has
+ * no more data. Used as the callback of TcpConnection::sendStream(), by the
+ * stream responses of the server and the generated request bodies of the
+ * client.
+ */
+std::size_t chunkingCallback(const std::shared_ptr<ChunkingParams> &cbParams,
+                             char *pBuffer,
+                             std::size_t nSize);
+}  // namespace drogon
@@ -0,0 +1,638 @@
+/**
+ *
+ *  @file HttpClientCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpClientCache.h"
+#include "HttpClientImpl.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include "HttpUtils.h"
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <limits>
+
+using namespace drogon;
+
+namespace
+{
+constexpr int64_t kMicroseconds = 1000000;
+// The heuristic freshness of the responses with only a Last-Modified field
+constexpr int64_t kMaxHeuristicLifetime = 24 * 3600 * kMicroseconds;
+
+struct CacheControl
+{
+    bool noStore{false};
+    bool noCache{false};
+    bool mustRevalidate{false};
+    bool isPrivate{false};
+    bool isPublic{false};
+    // In seconds, -1 if absent
+    int64_t maxAge{-1};
+    int64_t staleWhileRevalidate{-1};
+};
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+        str.remove_suffix(1);
+    return str;
+}
+
+int64_t parseSeconds(std::string_view value)
+{
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        value = value.substr(1, value.size() - 2);
+    if (value.empty())
+        return -1;
+    int64_t seconds = 0;
+    for (auto c : value)
+    {
+        if (c < '0' || c > '9')
+            return -1;
+        // A too large value is taken as the greatest one (RFC 9111 1.2.2)
+        if (seconds < std::numeric_limits<int32_t>::max())
+            seconds = seconds * 10 + (c - '0');
+    }
+    return (std::min)(seconds,
+                      int64_t{std::numeric_limits<int32_t>::max()});
+}
+
+CacheControl parseCacheControl(std::string_view value)
+{
+    CacheControl directives;
+    while (!value.empty())
+    {
+        auto comma = value.find(',');
+        auto directive = trim(value.substr(0, comma));
+        value = comma == std::string_view::npos ? std::string_view{}
+                                                : value.substr(comma + 1);
+        auto equal = directive.find('=');
+        auto name = trim(directive.substr(0, equal));
+        auto argument = equal == std::string_view::npos
+                            ? std::string_view{}
+                            : trim(directive.substr(equal + 1));
+        if (equalsIgnoreCase(name, "no-store"))
+            directives.noStore = true;
+        else if (equalsIgnoreCase(name, "no-cache"))
+            directives.noCache = true;
+        else if (equalsIgnoreCase(name, "must-revalidate"))
+            directives.mustRevalidate = true;
+        else if (equalsIgnoreCase(name, "private"))
+            directives.isPrivate = true;
+        else if (equalsIgnoreCase(name, "public"))
+            directives.isPublic = true;
+        else if (equalsIgnoreCase(name, "max-age"))
+            directives.maxAge = parseSeconds(argument);
+        else if (equalsIgnoreCase(name, "stale-while-revalidate"))
+            directives.staleWhileRevalidate = parseSeconds(argument);
+    }
+    return directives;
+}
+
+// Microseconds since the epoch, -1 if the date is not valid
+int64_t parseDate(const std::string &value)
+{
+    if (value.empty())
+        return -1;
+    auto date = utils::getHttpDate(value).microSecondsSinceEpoch();
+    if (date == (std::numeric_limits<int64_t>::max)())
+        return -1;
+    return date;
+}
+
+// The status codes whose responses are cacheable by default (RFC 9110 15.1)
+bool isHeuristicallyCacheable(int status)
+{
+    switch (status)
+    {
+        case 200:
+        case 203:
+        case 204:
+        case 300:
+        case 301:
+        case 308:
+        case 404:
+        case 405:
+        case 410:
+        case 414:
+        case 501:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// The names listed by Vary, lower-cased
+std::vector<std::string> varyNames(std::string_view value)
+{
+    std::vector<std::string> names;
+    while (!value.empty())
+    {
+        auto comma = value.find(',');
+        auto name = trim(value.substr(0, comma));
+        value = comma == std::string_view::npos ? std::string_view{}
+                                                : value.substr(comma + 1);
+        if (name.empty())
+            continue;
+        std::string lower(name);
+        std::transform(lower.begin(),
+                       lower.end(),
+                       lower.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        names.emplace_back(std::move(lower));
+    }
+    return names;
+}
+
+// A copy of a request sent to revalidate an entry in the background, the
+// request of the caller is answered and may be reused
+HttpRequestPtr cloneRequest(const HttpRequest &req)
+{
+    auto &impl = static_cast<const HttpRequestImpl &>(req);
+    auto clone = HttpRequest::newHttpRequest();
+    auto cloneImpl = static_cast<HttpRequestImpl *>(clone.get());
+    clone->setMethod(Get);
+    clone->setPath(req.path());
+    clone->setPathEncode(impl.pathEncode());
+    clone->setPassThrough(impl.passThrough());
+    cloneImpl->setQuery(req.query());
+    for (auto &[name, value] : req.parameters())
+        clone->setParameter(name, value);
+    for (auto &[name, value] : req.headers())
+        clone->addHeader(name, value);
+    for (auto &[name, value] : req.cookies())
+        clone->addCookie(name, value);
+    return clone;
+}
+
+int64_t now()
+{
+    return trantor::Date::now().microSecondsSinceEpoch();
+}
+}  // namespace
+
+HttpClientCache &HttpClientCache::instance()
+{
+    static HttpClientCache cache;
+    return cache;
+}
+
+void HttpClientCache::setMaxBytes(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxBytes_ = maxBytes;
+    while (bytes_ > maxBytes_ && !entries_.empty())
+        removeLocked(entries_.back());
+}
+
+void HttpClientCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+HttpClientCache::Freshness HttpClientCache::freshnessOf(
+    const HttpRequest &req,
+    const HttpResponse &resp,
+    int64_t requestTime,
+    int64_t responseTime)
+{
+    Freshness freshness;
+    if (!isHeuristicallyCacheable(resp.statusCode()) ||
+        !resp.cookies().empty())
+        return freshness;
+    auto requestDirectives = parseCacheControl(req.getHeader("cache-control"));
+    auto directives = parseCacheControl(resp.getHeader("cache-control"));
+    if (requestDirectives.noStore || directives.noStore ||
+        directives.isPrivate)
+        return freshness;
+    if ((!req.getHeader("authorization").empty() || !req.cookies().empty()) &&
+        !directives.isPublic)
+        return freshness;
+    auto &vary = resp.getHeader("vary");
+    if (vary.find('*') != std::string::npos)
+        return freshness;
+
+    auto date = parseDate(resp.getHeader("date"));
+    if (date < 0)
+        date = responseTime;
+    int64_t lifetime = 0;
+    auto &expires = resp.getHeader("expires");
+    auto lastModified = parseDate(resp.getHeader("last-modified"));
+    if (directives.maxAge >= 0)
+    {
+        lifetime = directives.maxAge * kMicroseconds;
+    }
+    else if (!expires.empty())
+    {
+        // An invalid date, like 0, is in the past
+        auto expiry = parseDate(expires);
+        lifetime = expiry < 0 ? 0 : (std::max)(expiry - date, int64_t{0});
+    }
+    else if (lastModified >= 0 && lastModified < date)
+    {
+        lifetime = (std::min)((date - lastModified) / 10,
+                              kMaxHeuristicLifetime);
+    }
+    bool hasValidator =
+        !resp.getHeader("etag").empty() || lastModified >= 0;
+    if (lifetime == 0 && !hasValidator)
+        return freshness;
+
+    // RFC 9111 4.2.3
+    auto ageValue = parseSeconds(resp.getHeader("age"));
+    auto apparentAge = (std::max)(responseTime - date, int64_t{0});
+    auto correctedAge = (std::max)(ageValue, int64_t{0}) * kMicroseconds +
+                        (responseTime - requestTime);
+    freshness.storable = true;
+    freshness.initialAge = (std::max)(apparentAge, correctedAge);
+    freshness.lifetime = lifetime;
+    freshness.staleWhileRevalidate =
+        (std::max)(directives.staleWhileRevalidate, int64_t{0}) *
+        kMicroseconds;
+    freshness.noCache = directives.noCache;
+    freshness.mustRevalidate = directives.mustRevalidate;
+    return freshness;
+}
+
+std::string HttpClientCache::keyOf(const HttpClientImpl &client,
+                                   const HttpRequest &req)
+{
+    auto &impl = static_cast<const HttpRequestImpl &>(req);
+    std::string key(client.secure() ? "https://" : "http://");
+    key.append(client.host())
+        .append(":")
+        .append(std::to_string(client.port()))
+        .append(req.path());
+    if (impl.passThrough())
+    {
+        if (!req.query().empty())
+            key.append("?").append(req.query());
+        return key;
+    }
+    // The parameters are sorted, their map is not ordered
+    std::vector<std::pair<std::string, std::string>> parameters(
+        req.parameters().begin(), req.parameters().end());
+    std::sort(parameters.begin(), parameters.end());
+    char separator = '?';
+    for (auto &[name, value] : parameters)
+    {
+        key.push_back(separator);
+        key.append(utils::urlEncodeComponent(name))
+            .append("=")
+            .append(utils::urlEncodeComponent(value));
+        separator = '&';
+    }
+    return key;
+}
+
+bool HttpClientCache::matches(const Entry &entry, const HttpRequest &req)
+{
+    return std::all_of(entry.vary.begin(),
+                       entry.vary.end(),
+                       [&req](const auto &field) {
+                           return req.getHeader(field.first) == field.second;
+                       });
+}
+
+HttpResponsePtr HttpClientCache::responseOf(const Entry &entry, int64_t now)
+{
+    auto resp = std::make_shared<HttpResponseImpl>(
+        static_cast<const HttpResponseImpl &>(*entry.response));
+    auto age = entry.freshness.initialAge + now - entry.responseTime;
+    resp->addHeader("age",
+                    std::to_string((std::max)(age, int64_t{0}) /
+                                   kMicroseconds));
+    return resp;
+}
+
+HttpClientCache::EntryPtr HttpClientCache::find(const std::string &key,
+                                                const HttpRequest &req)
+{
+    auto it = index_.find(key);
+    if (it == index_.end())
+        return nullptr;
+    for (auto &entryIt : it->second)
+    {
+        if (matches(**entryIt, req))
+        {
+            // The most recently used first
+            entries_.splice(entries_.begin(), entries_, entryIt);
+            return *entryIt;
+        }
+    }
+    return nullptr;
+}
+
+void HttpClientCache::sendRequest(const HttpClientImplPtr &client,
+                                  const HttpRequestPtr &req,
+                                  HttpReqCallback &&callback,
+                                  double timeout)
+{
+    auto method = req->method();
+    if (method != Get)
+    {
+        if (method == Head || method == Options)
+        {
+            client->sendRequestInLoop(req, std::move(callback), timeout);
+            return;
+        }
+        // A successful unsafe request invalidates the responses of its URL
+        // (RFC 9111 4.4)
+        client->sendRequestInLoop(
+            req,
+            [this, key = keyOf(*client, *req), callback = std::move(callback)](
+                ReqResult result, const HttpResponsePtr &resp) {
+                if (result == ReqResult::Ok && resp->statusCode() < 400)
+                    invalidate(key);
+                callback(result, resp);
+            },
+            timeout);
+        return;
+    }
+    auto requestDirectives = parseCacheControl(req->getHeader("cache-control"));
+    // The conditional and the range requests of the caller go to the server
+    if (requestDirectives.noStore || !req->getHeader("if-none-match").empty() ||
+        !req->getHeader("if-modified-since").empty() ||
+        !req->getHeader("range").empty())
+    {
+        client->sendRequestInLoop(req, std::move(callback), timeout);
+        return;
+    }
+
+    auto key = keyOf(*client, *req);
+    auto time = now();
+    auto waiter = std::make_shared<Waiter>(
+        Waiter{client, req, std::move(callback), timeout});
+    HttpResponsePtr served;
+    EntryPtr stale;
+    bool disabled{false};
+    bool joined{false};
+    bool backgroundFetch{false};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        disabled = maxBytes_ == 0;
+        auto entry = disabled ? nullptr : find(key, *req);
+        if (entry)
+        {
+            auto &freshness = entry->freshness;
+            auto age = freshness.initialAge + time - entry->responseTime;
+            bool revalidate =
+                freshness.noCache || requestDirectives.noCache ||
+                (requestDirectives.maxAge >= 0 &&
+                 age >= requestDirectives.maxAge * kMicroseconds);
+            if (!revalidate && age < freshness.lifetime)
+            {
+                served = responseOf(*entry, time);
+            }
+            else if (!revalidate && !freshness.mustRevalidate &&
+                     age < freshness.lifetime + freshness.staleWhileRevalidate)
+            {
+                // Served while a single request revalidates it
+                served = responseOf(*entry, time);
+                if (flights_.find(key) == flights_.end())
+                {
+                    flights_[key];
+                    stale = entry;
+                    backgroundFetch = true;
+                }
+            }
+            else
+            {
+                stale = entry;
+            }
+        }
+        if (!disabled && !served)
+        {
+            auto flight = flights_.find(key);
+            if (flight != flights_.end())
+            {
+                flight->second.push_back(waiter);
+                joined = true;
+            }
+            else
+            {
+                flights_[key];
+            }
+        }
+    }
+    if (disabled)
+    {
+        client->sendRequestInLoop(req, std::move(waiter->callback), timeout);
+        return;
+    }
+    if (served)
+    {
+        if (backgroundFetch)
+        {
+            // The request of the caller is answered and may be reused
+            fetch(std::make_shared<Waiter>(
+                      Waiter{client, cloneRequest(*req), nullptr, 0}),
+                  key,
+                  stale);
+        }
+        waiter->done = true;
+        waiter->callback(ReqResult::Ok, served);
+        return;
+    }
+    if (joined)
+    {
+        if (timeout > 0)
+        {
+            client->getLoop()->runAfter(timeout, [waiter]() {
+                if (waiter->done)
+                    return;
+                waiter->done = true;
+                waiter->callback(ReqResult::Timeout, nullptr);
+            });
+        }
+        return;
+    }
+    fetch(waiter, key, stale);
+}
+
+void HttpClientCache::fetch(const WaiterPtr &leader,
+                            const std::string &key,
+                            const EntryPtr &stale)
+{
+    if (stale)
+    {
+        // Revalidated with the validators of the stored response
+        auto &etag = stale->response->getHeader("etag");
+        if (!etag.empty())
+            leader->req->addHeader("if-none-match", etag);
+        auto &lastModified = stale->response->getHeader("last-modified");
+        if (!lastModified.empty())
+            leader->req->addHeader("if-modified-since", lastModified);
+    }
+    leader->client->sendRequestInLoop(
+        leader->req,
+        [this, leader, key, stale, requestTime = now()](
+            ReqResult result, const HttpResponsePtr &resp) {
+            EntryPtr entry;
+            if (result == ReqResult::Ok)
+                entry = onResponse(key, leader->req, resp, stale, requestTime);
+            std::vector<WaiterPtr> waiters;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = flights_.find(key);
+                if (it != flights_.end())
+                {
+                    waiters = std::move(it->second);
+                    flights_.erase(it);
+                }
+            }
+            auto time = now();
+            if (entry)
+                answer(leader, ReqResult::Ok, responseOf(*entry, time));
+            else
+                answer(leader, result, resp);
+            for (auto &waiter : waiters)
+            {
+                // The other variants and the uncacheable responses are
+                // requested by every waiter
+                if (entry && matches(*entry, *waiter->req))
+                    answer(waiter, ReqResult::Ok, responseOf(*entry, time));
+                else
+                    resend(waiter);
+            }
+        },
+        leader->timeout);
+}
+
+void HttpClientCache::answer(const WaiterPtr &waiter,
+                             ReqResult result,
+                             const HttpResponsePtr &resp)
+{
+    // The background revalidations have no caller
+    if (!waiter->callback)
+        return;
+    waiter->client->getLoop()->runInLoop([waiter, result, resp]() {
+        if (waiter->done)
+            return;
+        waiter->done = true;
+        waiter->callback(result, resp);
+    });
+}
+
+void HttpClientCache::resend(const WaiterPtr &waiter)
+{
+    waiter->client->getLoop()->runInLoop([waiter]() {
+        if (waiter->done)
+            return;
+        waiter->done = true;
+        waiter->client->sendRequestInLoop(waiter->req,
+                                          std::move(waiter->callback),
+                                          waiter->timeout);
+    });
+}
+
+HttpClientCache::EntryPtr HttpClientCache::onResponse(
+    const std::string &key,
+    const HttpRequestPtr &req,
+    const HttpResponsePtr &resp,
+    const EntryPtr &stale,
+    int64_t requestTime)
+{
+    auto responseTime = now();
+    HttpResponsePtr stored = resp;
+    if (resp->statusCode() == k304NotModified)
+    {
+        if (!stale)
+            return nullptr;
+        // The stored header is updated by the one of the 304 response
+        // (RFC 9111 4.3.4)
+        auto updated = std::make_shared<HttpResponseImpl>(
+            static_cast<const HttpResponseImpl &>(*stale->response));
+        for (auto &[name, value] : resp->headers())
+        {
+            if (name != "content-length")
+                updated->addHeader(name, value);
+        }
+        stored = updated;
+    }
+    auto entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->response = stored;
+    entry->freshness =
+        freshnessOf(*req, *stored, requestTime, responseTime);
+    entry->responseTime = responseTime;
+    for (auto &name : varyNames(stored->getHeader("vary")))
+    {
+        auto &value = req->getHeader(name);
+        entry->vary.emplace_back(std::move(name), value);
+    }
+    entry->bytes = stored->getBody().length() + 256;
+    for (auto &[name, value] : stored->headers())
+        entry->bytes += name.length() + value.length();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stale)
+        removeLocked(stale);
+    if (!entry->freshness.storable || entry->bytes > maxBytes_ / 8)
+    {
+        // A revalidated response is served even if it can't be stored
+        return stored == resp ? nullptr : entry;
+    }
+    if (auto existing = find(key, *req))
+        removeLocked(existing);
+    store(entry);
+    return entry;
+}
+
+void HttpClientCache::store(const EntryPtr &entry)
+{
+    entries_.push_front(entry);
+    index_[entry->key].push_back(entries_.begin());
+    bytes_ += entry->bytes;
+    while (bytes_ > maxBytes_ && !entries_.empty())
+        removeLocked(entries_.back());
+}
+
+void HttpClientCache::removeLocked(const EntryPtr &entry)
+{
+    auto it = index_.find(entry->key);
+    if (it == index_.end())
+        return;
+    auto &variants = it->second;
+    for (auto variant = variants.begin(); variant != variants.end();
+         ++variant)
+    {
+        if (**variant == entry)
+        {
+            bytes_ -= entry->bytes;
+            entries_.erase(*variant);
+            variants.erase(variant);
+            break;
+        }
+    }
+    if (variants.empty())
+        index_.erase(it);
+}
+
+void HttpClientCache::invalidate(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end())
+        return;
+    for (auto &variant : it->second)
+    {
+        bytes_ -= (*variant)->bytes;
+        entries_.erase(variant);
+    }
+    index_.erase(it);
+}
@@ -0,0 +1,155 @@
+/**
+ *
+ *  @file HttpClientCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "BuiltinMetrics.h"
+#include "impl_forwards.h"
+#include <drogon/exports.h>
+#include <drogon/HttpClient.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+class HttpClientImpl;
+using HttpClientImplPtr = std::shared_ptr<HttpClientImpl>;
+
+/**
+ * @brief The responses to the GET requests of the HTTP clients with the cache
+ * enabled, shared by all the clients of the process (RFC 9111).
+ *
+ * A fresh response is served without a request. A stale one is revalidated
+ * with its ETag or Last-Modified, or served within its
+ * stale-while-revalidate window while a single request revalidates it in
+ * the background. The variants listed by Vary are kept apart. The
+ * concurrent misses of a URL are collapsed into one request whose response
+ * is shared. The entries are evicted in LRU order once their size exceeds
+ * the limit.
+ *
+ * The cache is shared by clients which may carry different credentials, so
+ * the responses marked private or setting cookies aren't stored, nor the
+ * responses to requests with an Authorization or a Cookie header unless
+ * they are marked public.
+ */
+class DROGON_EXPORT HttpClientCache : public trantor::NonCopyable
+{
+  public:
+    static HttpClientCache &instance();
+
+    /// The maximum size of the cached responses, 0 empties the cache.
+    void setMaxBytes(size_t maxBytes);
+
+    /**
+     * @brief Send a request of the client through the cache, in the loop of
+     * the client.
+     */
+    void sendRequest(const HttpClientImplPtr &client,
+                     const HttpRequestPtr &req,
+                     HttpReqCallback &&callback,
+                     double timeout);
+
+    void clear();
+
+    /// The freshness of a response, in microseconds
+    struct Freshness
+    {
+        bool storable{false};
+        // The age of the response when it was received
+        int64_t initialAge{0};
+        int64_t lifetime{0};
+        int64_t staleWhileRevalidate{0};
+        // The response must be revalidated before it is served
+        bool noCache{false};
+        bool mustRevalidate{false};
+    };
+
+    /**
+     * @brief Compute the freshness of the response to a request sent at
+     * requestTime and received at responseTime, in microseconds since the
+     * epoch.
+     */
+    static Freshness freshnessOf(const HttpRequest &req,
+                                 const HttpResponse &resp,
+                                 int64_t requestTime,
+                                 int64_t responseTime);
+
+  private:
+    struct Entry
+    {
+        std::string key;
+        // The values of the request fields listed by Vary
+        std::vector<std::pair<std::string, std::string>> vary;
+        HttpResponsePtr response;
+        Freshness freshness;
+        int64_t responseTime{0};
+        size_t bytes{0};
+    };
+
+    using EntryPtr = std::shared_ptr<Entry>;
+    using EntryList = std::list<EntryPtr>;
+
+    struct Waiter
+    {
+        HttpClientImplPtr client;
+        HttpRequestPtr req;
+        HttpReqCallback callback;
+        double timeout;
+        // Set in the loop of the client once the waiter is answered
+        bool done{false};
+    };
+
+    using WaiterPtr = std::shared_ptr<Waiter>;
+
+    HttpClientCache() = default;
+
+    static std::string keyOf(const HttpClientImpl &client,
+                             const HttpRequest &req);
+    static bool matches(const Entry &entry, const HttpRequest &req);
+    static HttpResponsePtr responseOf(const Entry &entry, int64_t now);
+
+    EntryPtr find(const std::string &key, const HttpRequest &req);
+    void fetch(const WaiterPtr &leader,
+               const std::string &key,
+               const EntryPtr &stale);
+    void resend(const WaiterPtr &waiter);
+    EntryPtr onResponse(const std::string &key,
+                        const HttpRequestPtr &req,
+                        const HttpResponsePtr &resp,
+                        const EntryPtr &stale,
+                        int64_t requestTime);
+    void store(const EntryPtr &entry);
+    void removeLocked(const EntryPtr &entry);
+    void invalidate(const std::string &key);
+    void answer(const WaiterPtr &waiter,
+                ReqResult result,
+                const HttpResponsePtr &resp);
+
+    std::mutex mutex_;
+    EntryList entries_;
+    std::unordered_map<std::string, std::vector<EntryList::iterator>> index_;
+    AccountedBytes bytes_{BuiltinMetrics::MemoryUser::kHttpClientCache};
+    size_t maxBytes_{64 * 1024 * 1024};
+    // The keys being fetched, with the requests waiting for them
+    std::unordered_map<std::string, std::vector<WaiterPtr>> flights_;
+};
+
+}  // namespace drogon
@@ -14,10 +14,15 @@
 
 #include "HttpClientImpl.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpChunking.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "HttpResponseParser.h"
+#include "DnsCache.h"
+#include "HttpClientCache.h"
 #include "SseClientContext.h"
+#include "StreamClientContext.h"
+#include "Tracing.h"
 
 #include <drogon/config.h>
 #include <stdlib.h>
@@ -27,65 +32,192 @@ using namespace trantor;
 using namespace drogon;
 using namespace std::placeholders;
 
-namespace trantor
+namespace
+{
+// The delay before the next address is tried while the previous attempts
+// are in progress (RFC 8305 5)
+constexpr double kConnectionAttemptDelay = 0.25;
+// How long the body of a request waits for 100 (Continue), the server may
+// not support the expectation (RFC 9110 10.1.1)
+constexpr double kContinueTimeout = 1.0;
+
+bool expectsContinue(const HttpRequestPtr &req)
 {
-static const size_t kDefaultDNSTimeout{600};
+    std::string_view expect = req->getHeader("expect");
+    std::string_view value = "100-continue";
+    return std::equal(expect.begin(),
+                      expect.end(),
+                      value.begin(),
+                      value.end(),
+                      [](char a, char b) {
+                          return tolower(static_cast<unsigned char>(a)) == b;
+                      });
 }
+}  // namespace
 
 void HttpClientImpl::createTcpClient()
 {
-    LOG_TRACE << "New TcpClient," << serverAddr_.toIpPort();
-    tcpClientPtr_ =
-        std::make_shared<trantor::TcpClient>(loop_, serverAddr_, "httpClient");
+    if (candidates_.empty())
+        candidates_.push_back(serverAddr_);
+    nextCandidate_ = 0;
+    tcpClientPtr_.reset();
+    startNextAttempt();
+}
+
+void HttpClientImpl::startNextAttempt()
+{
+    if (nextCandidate_ >= candidates_.size())
+        return;
+    auto client = newTcpClient(candidates_[nextCandidate_++]);
+    // The first attempt stands for the connection until one succeeds
+    if (!tcpClientPtr_)
+        tcpClientPtr_ = client;
+    racing_.push_back(client);
+    if (raceTimer_ != 0)
+    {
+        loop_->invalidateTimer(raceTimer_);
+        raceTimer_ = 0;
+    }
+    if (nextCandidate_ < candidates_.size())
+    {
+        std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+        raceTimer_ = loop_->runAfter(kConnectionAttemptDelay, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->raceTimer_ = 0;
+            if (!thisPtr->racing_.empty())
+                thisPtr->startNextAttempt();
+        });
+    }
+    client->connect();
+}
+
+bool HttpClientImpl::winRace(trantor::TcpClient *client)
+{
+    if (racing_.empty())
+        return client == tcpClientPtr_.get();
+    auto iter = std::find_if(racing_.begin(),
+                             racing_.end(),
+                             [client](const auto &c) {
+                                 return c.get() == client;
+                             });
+    if (iter == racing_.end())
+        return false;
+    tcpClientPtr_ = *iter;
+    stopRace();
+    return true;
+}
+
+void HttpClientImpl::stopRace()
+{
+    if (raceTimer_ != 0)
+    {
+        loop_->invalidateTimer(raceTimer_);
+        raceTimer_ = 0;
+    }
+    for (auto &client : racing_)
+    {
+        if (client == tcpClientPtr_)
+            continue;
+        client->stop();
+        // Not destroyed in its own callbacks
+        loop_->queueInLoop([client]() {});
+    }
+    racing_.clear();
+}
+
+void HttpClientImpl::onAttemptFailed(trantor::TcpClient *client)
+{
+    if (racing_.empty())
+    {
+        if (client == tcpClientPtr_.get())
+            onError(ReqResult::BadServerAddress);
+        return;
+    }
+    auto iter = std::find_if(racing_.begin(),
+                             racing_.end(),
+                             [client](const auto &c) {
+                                 return c.get() == client;
+                             });
+    if (iter == racing_.end())
+        return;
+    loop_->queueInLoop([failed = *iter]() {});
+    racing_.erase(iter);
+    LOG_TRACE << "Connection attempt failed, " << racing_.size()
+              << " in progress, "
+              << candidates_.size() - nextCandidate_ << " left";
+    // The next address is tried at once
+    if (nextCandidate_ < candidates_.size())
+    {
+        startNextAttempt();
+        return;
+    }
+    if (racing_.empty())
+        onError(ReqResult::BadServerAddress);
+}
+
+std::shared_ptr<trantor::TcpClient> HttpClientImpl::newTcpClient(
+    const trantor::InetAddress &addr)
+{
+    LOG_TRACE << "New TcpClient," << addr.toIpPort();
+    auto tcpClient =
+        std::make_shared<trantor::TcpClient>(loop_, addr, "httpClient");
 
     if (useSSL_ && utils::supportsTls())
     {
         LOG_TRACE << "useOldTLS=" << useOldTLS_;
         LOG_TRACE << "domain=" << domain_;
-        auto policy = trantor::TLSPolicy::defaultClientPolicy();
-        policy->setUseOldTLS(useOldTLS_)
-            .setValidate(validateCert_)
-            .setHostname(domain_)
-            .setConfCmds(sslConfCmds_)
-            .setCertPath(clientCertPath_)
-            .setKeyPath(clientKeyPath_);
-        tcpClientPtr_->enableSSL(std::move(policy));
+        tcpClient->enableSSL(tlsPolicy(http2Enabled_));
     }
 
     auto thisPtr = shared_from_this();
     std::weak_ptr<HttpClientImpl> weakPtr = thisPtr;
-    tcpClientPtr_->setSockOptCallback([weakPtr](int fd) {
+    auto client = tcpClient.get();
+    tcpClient->setSockOptCallback([weakPtr](int fd) {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
         if (thisPtr->sockOptCallback_)
             thisPtr->sockOptCallback_(fd);
     });
-    tcpClientPtr_->setConnectionCallback(
-        [weakPtr](const trantor::TcpConnectionPtr &connPtr) {
+    tcpClient->setConnectionCallback(
+        [weakPtr, client](const trantor::TcpConnectionPtr &connPtr) {
             auto thisPtr = weakPtr.lock();
             if (!thisPtr)
                 return;
             if (connPtr->connected())
             {
+                // Another attempt connected first
+                if (!thisPtr->winRace(client))
+                {
+                    connPtr->forceClose();
+                    return;
+                }
                 connPtr->setContext(
                     std::make_shared<HttpResponseParser>(connPtr));
                 // send request;
                 LOG_TRACE << "Connection established!";
-                while (thisPtr->pipeliningCallbacks_.size() <=
-                           thisPtr->pipeliningDepth_ &&
-                       !thisPtr->requestsBuffer_.empty())
+                // Over TLS the server may not select h2
+                if (thisPtr->http2Enabled_ &&
+                    (!thisPtr->useSSL_ ||
+                     connPtr->applicationProtocol() == "h2"))
                 {
-                    thisPtr->sendReq(connPtr,
-                                     thisPtr->requestsBuffer_.front().first);
-                    thisPtr->pipeliningCallbacks_.push(
-                        std::move(thisPtr->requestsBuffer_.front()));
-                    thisPtr->requestsBuffer_.pop_front();
+                    thisPtr->startHttp2(connPtr);
+                    return;
                 }
+                thisPtr->sendBufferedRequests(connPtr);
             }
             else
             {
+                if (client != thisPtr->tcpClientPtr_.get())
+                    return;
                 LOG_TRACE << "connection disconnect";
+                if (thisPtr->http2ConnPtr_)
+                {
+                    thisPtr->onError(ReqResult::NetworkFailure);
+                    return;
+                }
                 auto responseParser = connPtr->getContext<HttpResponseParser>();
                 if (responseParser && responseParser->parseResponseOnClose() &&
                     responseParser->gotAll())
@@ -110,26 +242,33 @@ void HttpClientImpl::createTcpClient()
                 thisPtr->onError(ReqResult::NetworkFailure);
             }
         });
-    tcpClientPtr_->setConnectionErrorCallback([weakPtr]() {
+    tcpClient->setConnectionErrorCallback([weakPtr, client]() {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
         // can't connect to server
-        thisPtr->onError(ReqResult::BadServerAddress);
+        thisPtr->onAttemptFailed(client);
     });
-    tcpClientPtr_->setMessageCallback(
-        [weakPtr](const trantor::TcpConnectionPtr &connPtr,
-                  trantor::MsgBuffer *msg) {
+    tcpClient->setMessageCallback(
+        [weakPtr, client](const trantor::TcpConnectionPtr &connPtr,
+                          trantor::MsgBuffer *msg) {
             auto thisPtr = weakPtr.lock();
-            if (thisPtr)
+            if (thisPtr && client == thisPtr->tcpClientPtr_.get())
             {
                 thisPtr->onRecvMessage(connPtr, msg);
             }
         });
-    tcpClientPtr_->setSSLErrorCallback([weakPtr](SSLError err) {
+    tcpClient->setSSLErrorCallback([weakPtr, client](SSLError err) {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
+        if (client != thisPtr->tcpClientPtr_.get() &&
+            std::none_of(thisPtr->racing_.begin(),
+                         thisPtr->racing_.end(),
+                         [client](const auto &c) {
+                             return c.get() == client;
+                         }))
+            return;
         if (err == trantor::SSLError::kSSLHandshakeError)
             thisPtr->onError(ReqResult::HandshakeError);
         else if (err == trantor::SSLError::kSSLInvalidCertificate)
@@ -142,7 +281,7 @@ void HttpClientImpl::createTcpClient()
             abort();
         }
     });
-    tcpClientPtr_->connect();
+    return tcpClient;
 }
 
 HttpClientImpl::HttpClientImpl(trantor::EventLoop *loop,
@@ -260,30 +399,65 @@ HttpClientImpl::HttpClientImpl(trantor::EventLoop *loop,
 HttpClientImpl::~HttpClientImpl()
 {
     LOG_TRACE << "Deconstruction HttpClient";
-    if (resolverPtr_ && !(loop_->isInLoopThread()))
-    {
-        // Make sure the resolverPtr_ is destroyed in the correct thread.
-        loop_->queueInLoop([resolverPtr = std::move(resolverPtr_)]() {});
-    }
+    if (raceTimer_ != 0)
+        loop_->invalidateTimer(raceTimer_);
+    dropContinuedBody();
+}
+
+/**
+ * @brief Make the request a child span of the trace of the current thread
+ * and send its traceparent header, see Tracing.
+ */
+static void traceRequest(const HttpRequestPtr &req,
+                         HttpReqCallback &callback,
+                         const HttpClientImpl &client)
+{
+    auto span = Tracing::instance().startClientSpan({});
+    if (!span)
+        return;
+    span->name = req->methodString();
+    span->attributes.emplace_back("http.request.method", req->methodString());
+    span->attributes.emplace_back("server.address", client.host());
+    span->attributes.emplace_back("url.path", req->path());
+    req->addHeader("traceparent", span->context.traceparent());
+    callback = [span, callback = std::move(callback)](
+                   ReqResult result, const HttpResponsePtr &resp) {
+        bool error = result != ReqResult::Ok;
+        if (resp)
+        {
+            span->attributes.emplace_back(
+                "http.response.status_code",
+                std::to_string(resp->statusCode()));
+            error = error || resp->statusCode() >= 500;
+        }
+        Tracing::instance().endClientSpan(span, error);
+        callback(result, resp);
+    };
 }
 
 void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
                                  const drogon::HttpReqCallback &callback,
                                  double timeout)
 {
-    auto thisPtr = shared_from_this();
-    loop_->runInLoop([thisPtr, req, callback = callback, timeout]() mutable {
-        thisPtr->sendRequestInLoop(req, std::move(callback), timeout);
-    });
+    sendRequest(req, HttpReqCallback(callback), timeout);
 }
 
 void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
                                  drogon::HttpReqCallback &&callback,
                                  double timeout)
 {
+    traceRequest(req, callback, *this);
     auto thisPtr = shared_from_this();
     loop_->runInLoop(
         [thisPtr, req, callback = std::move(callback), timeout]() mutable {
+            if (thisPtr->cacheEnabled_)
+            {
+                HttpClientCache::instance().sendRequest(thisPtr,
+                                                        req,
+                                                        std::move(callback),
+                                                        timeout);
+                return;
+            }
             thisPtr->sendRequestInLoop(req, std::move(callback), timeout);
         });
 }
@@ -450,40 +624,42 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
             return;
         }
 
-        // Always do dns query when (re)connects a domain.
+        // Always do dns query when (re)connects a domain, the cache makes
+        // it cheap.
         dns_ = true;
-        if (!resolverPtr_)
-        {
-            resolverPtr_ =
-                trantor::Resolver::newResolver(loop_, kDefaultDNSTimeout);
-        }
         auto thisPtr = shared_from_this();
-        resolverPtr_->resolve(
-            domain_, [thisPtr](const trantor::InetAddress &addr) {
-                thisPtr->loop_->runInLoop([thisPtr, addr]() {
-                    // Retrieve port from old serverAddr_
-                    auto port = thisPtr->serverAddr_.portNetEndian();
-                    thisPtr->serverAddr_ = addr;
-                    thisPtr->serverAddr_.setPortNetEndian(port);
+        DnsCache::instance().resolve(
+            domain_,
+            loop_,
+            [thisPtr](const std::vector<trantor::InetAddress> &addrs) {
+                thisPtr->dns_ = false;
+                // Retrieve port from old serverAddr_
+                auto port = thisPtr->serverAddr_.portNetEndian();
+                thisPtr->candidates_.clear();
+                for (auto addr : addrs)
+                {
+                    addr.setPortNetEndian(port);
+                    if (isValidIpAddr(addr))
+                        thisPtr->candidates_.push_back(addr);
+                }
+                if (!thisPtr->candidates_.empty())
+                {
+                    thisPtr->serverAddr_ = thisPtr->candidates_.front();
                     LOG_TRACE << "dns:domain=" << thisPtr->domain_
-                              << ";ip=" << thisPtr->serverAddr_.toIp();
-                    thisPtr->dns_ = false;
-
-                    if (isValidIpAddr(thisPtr->serverAddr_))
-                    {
-                        thisPtr->createTcpClient();
-                        return;
-                    }
+                              << ";ip=" << thisPtr->serverAddr_.toIp()
+                              << ";addresses=" << thisPtr->candidates_.size();
+                    thisPtr->createTcpClient();
+                    return;
+                }
 
-                    // DNS fail to get valid ip address,
-                    // respond all requests with BadServerAddress
-                    while (!(thisPtr->requestsBuffer_).empty())
-                    {
-                        auto &reqAndCb = (thisPtr->requestsBuffer_).front();
-                        reqAndCb.second(ReqResult::BadServerAddress, nullptr);
-                        (thisPtr->requestsBuffer_).pop_front();
-                    }
-                });
+                // DNS fail to get valid ip address,
+                // respond all requests with BadServerAddress
+                while (!(thisPtr->requestsBuffer_).empty())
+                {
+                    auto &reqAndCb = (thisPtr->requestsBuffer_).front();
+                    reqAndCb.second(ReqResult::BadServerAddress, nullptr);
+                    (thisPtr->requestsBuffer_).pop_front();
+                }
             });
 
         return;
@@ -506,9 +682,22 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
         return;
     }
 
+    if (http2ConnPtr_)
+    {
+        requestsBuffer_.push_back(
+            {req,
+             [thisPtr,
+              callback = std::move(callback)](ReqResult result,
+                                              const HttpResponsePtr &response) {
+                 callback(result, response);
+             }});
+        sendHttp2Requests();
+        return;
+    }
+
     // Connected, send request now
     if (pipeliningCallbacks_.size() <= pipeliningDepth_ &&
-        requestsBuffer_.empty())
+        requestsBuffer_.empty() && !continueBody_)
     {
         sendReq(connPtr, req);
         pipeliningCallbacks_.push(
@@ -532,16 +721,137 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
 }
 
 void HttpClientImpl::sendReq(const trantor::TcpConnectionPtr &connPtr,
-                             const HttpRequestPtr &req)
+                             const HttpRequestPtr &req,
+                             bool waitForContinue)
 {
     trantor::MsgBuffer buffer;
     assert(req);
     auto implPtr = static_cast<HttpRequestImpl *>(req.get());
-    implPtr->appendToBuffer(&buffer);
+    // The body stored in files is sent from the files and a generated body as
+    // the connection drains, instead of being copied into the buffer
+    std::vector<HttpRequestImpl::BodyPiece> pieces;
+    implPtr->appendToBuffer(&buffer, &pieces);
     LOG_TRACE << "Send request:"
               << std::string(buffer.peek(), buffer.readableBytes());
     bytesSent_ += buffer.readableBytes();
     connPtr->send(std::move(buffer));
+    auto generator = implPtr->takeBodyGenerator();
+    if (pieces.empty() && !generator)
+        return;
+    auto chunked = generator && !implPtr->generatedBodyLength();
+    if (waitForContinue && expectsContinue(req))
+    {
+        continueBody_ = std::make_unique<ContinueBody>();
+        continueBody_->connection = connPtr;
+        continueBody_->pieces = std::move(pieces);
+        continueBody_->generator = std::move(generator);
+        continueBody_->chunked = chunked;
+        std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+        continueTimer_ = loop_->runAfter(kContinueTimeout, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->continueTimer_ = 0;
+            thisPtr->sendContinuedBody();
+        });
+        return;
+    }
+    sendBody(connPtr, std::move(pieces), std::move(generator), chunked);
+}
+
+void HttpClientImpl::sendBody(
+    const trantor::TcpConnectionPtr &connPtr,
+    std::vector<HttpRequestImpl::BodyPiece> &&pieces,
+    std::function<std::size_t(char *, std::size_t)> &&generator,
+    bool chunked)
+{
+    for (auto &piece : pieces)
+    {
+        if (piece.path.empty())
+        {
+            bytesSent_ += piece.data.length();
+            connPtr->send(std::move(piece.data));
+        }
+        else if (piece.length > 0)
+        {
+            bytesSent_ += piece.length;
+            connPtr->sendFile(piece.path.c_str(), piece.offset, piece.length);
+        }
+    }
+    if (!generator)
+        return;
+    std::function<std::size_t(char *, std::size_t)> stream;
+    if (chunked)
+    {
+        stream = [ctx = std::make_shared<ChunkingParams>(std::move(generator))](
+                     char *buffer, size_t len) {
+            return chunkingCallback(ctx, buffer, len);
+        };
+    }
+    else
+    {
+        stream = std::move(generator);
+    }
+    // Pulled by the connection whenever its buffer drains, so a slow server
+    // throttles the generator
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    connPtr->sendStream(
+        [weakPtr, stream = std::move(stream)](char *buffer, size_t len) {
+            auto n = stream(buffer, len);
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->bytesSent_ += n;
+            return n;
+        });
+}
+
+void HttpClientImpl::sendContinuedBody()
+{
+    if (continueTimer_ != 0)
+    {
+        loop_->invalidateTimer(continueTimer_);
+        continueTimer_ = 0;
+    }
+    auto body = std::move(continueBody_);
+    if (!body)
+        return;
+    auto connPtr = body->connection.lock();
+    if (!connPtr || !connPtr->connected())
+    {
+        if (body->generator)
+            body->generator(nullptr, 0);
+        return;
+    }
+    sendBody(connPtr,
+             std::move(body->pieces),
+             std::move(body->generator),
+             body->chunked);
+    // The requests held back meanwhile
+    sendBufferedRequests(connPtr);
+}
+
+void HttpClientImpl::dropContinuedBody()
+{
+    if (continueTimer_ != 0)
+    {
+        loop_->invalidateTimer(continueTimer_);
+        continueTimer_ = 0;
+    }
+    if (continueBody_ && continueBody_->generator)
+        continueBody_->generator(nullptr, 0);
+    continueBody_.reset();
+}
+
+void HttpClientImpl::sendBufferedRequests(
+    const trantor::TcpConnectionPtr &connPtr)
+{
+    // A request waiting for 100 (Continue) holds back the next ones
+    while (pipeliningCallbacks_.size() <= pipeliningDepth_ &&
+           !requestsBuffer_.empty() && !continueBody_)
+    {
+        sendReq(connPtr, requestsBuffer_.front().first);
+        pipeliningCallbacks_.push(std::move(requestsBuffer_.front()));
+        requestsBuffer_.pop_front();
+    }
 }
 
 void HttpClientImpl::handleResponse(
@@ -550,20 +860,21 @@ void HttpClientImpl::handleResponse(
     const trantor::TcpConnectionPtr &connPtr)
 {
     assert(!pipeliningCallbacks_.empty());
-    auto &coding = resp->getHeaderBy("content-encoding");
-    if (coding == "gzip")
-    {
-        resp->gunzip();
-    }
-#ifdef USE_BROTLI
-    else if (coding == "br")
-    {
-        resp->brDecompress();
-    }
-#endif
+    decodeResponse(resp);
     auto cb = std::move(reqAndCb);
     pipeliningCallbacks_.pop();
     handleCookies(resp);
+    if (continueBody_ && pipeliningCallbacks_.empty())
+    {
+        // The final response came instead of 100 (Continue), the server
+        // doesn't read the body, so the connection can't be reused
+        dropContinuedBody();
+        tcpClientPtr_.reset();
+        cb.second(ReqResult::Ok, resp);
+        if (!tcpClientPtr_ && !requestsBuffer_.empty())
+            createTcpClient();
+        return;
+    }
     cb.second(ReqResult::Ok, resp);
 
     // LOG_TRACE << "pipelining buffer size=" <<
@@ -572,7 +883,7 @@ void HttpClientImpl::handleResponse(
 
     if (connPtr->connected())
     {
-        if (!requestsBuffer_.empty())
+        if (!requestsBuffer_.empty() && !continueBody_)
         {
             auto &reqAndCallback = requestsBuffer_.front();
             sendReq(connPtr, reqAndCallback.first);
@@ -598,9 +909,38 @@ void HttpClientImpl::handleResponse(
     }
 }
 
+void HttpClientImpl::decodeResponse(const HttpResponseImplPtr &resp)
+{
+    auto &coding = resp->getHeaderBy("content-encoding");
+    if (coding == "gzip")
+    {
+        resp->gunzip();
+    }
+#ifdef USE_BROTLI
+    else if (coding == "br")
+    {
+        resp->brDecompress();
+    }
+#endif
+#ifdef USE_ZSTD
+    else if (coding == "zstd")
+    {
+        resp->zstdDecompress();
+    }
+#endif
+}
+
 void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
                                    trantor::MsgBuffer *msg)
 {
+    if (http2ConnPtr_)
+    {
+        bytesReceived_ += msg->readableBytes();
+        // The connection may be dropped by the callbacks of the streams
+        auto h2 = http2ConnPtr_;
+        h2->onMessage(msg);
+        return;
+    }
     auto responseParser = connPtr->getContext<HttpResponseParser>();
 
     // LOG_TRACE << "###:" << msg->readableBytes();
@@ -631,6 +971,14 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
             responseParser->reset();
             bytesReceived_ += (msgSize - msg->readableBytes());
             msgSize = msg->readableBytes();
+            if (resp->statusCode() < k200OK &&
+                resp->statusCode() != k101SwitchingProtocols)
+            {
+                // An interim response, the final one follows
+                if (resp->statusCode() == k100Continue)
+                    sendContinuedBody();
+                continue;
+            }
             handleResponse(resp, std::move(firstReq), connPtr);
         }
         else
@@ -669,8 +1017,21 @@ HttpClientPtr HttpClient::newHttpClient(const std::string &hostString,
         validateCert);
 }
 
+void HttpClient::setDnsCacheTtl(double seconds)
+{
+    DnsCache::instance().setTtl(seconds);
+}
+
+void HttpClient::setCacheSize(size_t maxBytes)
+{
+    HttpClientCache::instance().setMaxBytes(maxBytes);
+}
+
 void HttpClientImpl::onError(ReqResult result)
 {
+    stopRace();
+    dropContinuedBody();
+    closeHttp2(result);
     while (!pipeliningCallbacks_.empty())
     {
         auto cb = std::move(pipeliningCallbacks_.front());
@@ -686,6 +1047,71 @@ void HttpClientImpl::onError(ReqResult result)
     tcpClientPtr_.reset();
 }
 
+void HttpClientImpl::startHttp2(const trantor::TcpConnectionPtr &connPtr)
+{
+    LOG_TRACE << "Use HTTP/2";
+    http2ConnPtr_ = std::make_shared<Http2ClientConnection>(connPtr, useSSL_);
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    http2ConnPtr_->setStreamClosedCallback([weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (thisPtr)
+            thisPtr->sendHttp2Requests();
+    });
+    http2ConnPtr_->setBytesSentCallback([weakPtr](size_t bytes) {
+        auto thisPtr = weakPtr.lock();
+        if (thisPtr)
+            thisPtr->bytesSent_ += bytes;
+    });
+    http2ConnPtr_->start();
+    sendHttp2Requests();
+}
+
+void HttpClientImpl::sendHttp2Requests()
+{
+    auto h2 = http2ConnPtr_;
+    if (!h2)
+        return;
+    // The callbacks may close the connection while the requests are sent
+    while (h2 == http2ConnPtr_ && h2->canOpenStream() &&
+           !requestsBuffer_.empty())
+    {
+        auto reqAndCb = std::move(requestsBuffer_.front());
+        requestsBuffer_.pop_front();
+        h2->sendRequest(
+            reqAndCb.first,
+            [thisPtr = shared_from_this(),
+             callback = std::move(reqAndCb.second)](
+                ReqResult result, const HttpResponseImplPtr &resp) {
+                if (resp)
+                {
+                    thisPtr->decodeResponse(resp);
+                    thisPtr->handleCookies(resp);
+                }
+                callback(result, resp);
+            });
+    }
+    if (h2 == http2ConnPtr_ && h2->isGoingAway() && h2->streamCount() == 0)
+    {
+        // The server opens no more streams, the next requests are sent on a
+        // new connection
+        http2ConnPtr_.reset();
+        tcpClientPtr_.reset();
+        if (!requestsBuffer_.empty())
+        {
+            createTcpClient();
+        }
+    }
+}
+
+void HttpClientImpl::closeHttp2(ReqResult result)
+{
+    if (!http2ConnPtr_)
+        return;
+    auto h2 = std::move(http2ConnPtr_);
+    http2ConnPtr_.reset();
+    h2->onClose(result);
+}
+
 void HttpClientImpl::handleCookies(const HttpResponseImplPtr &resp)
 {
     loop_->assertInLoopThread();
@@ -717,6 +1143,8 @@ void HttpClientImpl::setCertPath(const std::string &cert,
 {
     clientCertPath_ = cert;
     clientKeyPath_ = key;
+    tlsPolicies_[0].reset();
+    tlsPolicies_[1].reset();
 }
 
 void HttpClientImpl::addSSLConfigs(
@@ -726,6 +1154,29 @@ void HttpClientImpl::addSSLConfigs(
     {
         sslConfCmds_.push_back(cmd);
     }
+    tlsPolicies_[0].reset();
+    tlsPolicies_[1].reset();
+}
+
+const std::shared_ptr<trantor::TLSPolicy> &HttpClientImpl::tlsPolicy(
+    bool offerHttp2)
+{
+    // All the connections of the client share the policy, it is only read
+    // when a connection starts its handshake.
+    auto &policy = tlsPolicies_[offerHttp2 ? 1 : 0];
+    if (!policy)
+    {
+        policy = trantor::TLSPolicy::defaultClientPolicy();
+        policy->setUseOldTLS(useOldTLS_)
+            .setValidate(validateCert_)
+            .setHostname(domain_)
+            .setConfCmds(sslConfCmds_)
+            .setCertPath(clientCertPath_)
+            .setKeyPath(clientKeyPath_);
+        if (offerHttp2)
+            policy->setAlpnProtocols({"h2", "http/1.1"});
+    }
+    return policy;
 }
 
 // SSE Implementation
@@ -860,14 +1311,7 @@ void HttpClientImpl::sendRequestForSseInLoop(const HttpRequestPtr &req,
 
     if (useSSL_ && utils::supportsTls())
     {
-        auto policy = trantor::TLSPolicy::defaultClientPolicy();
-        policy->setUseOldTLS(useOldTLS_)
-            .setValidate(validateCert_)
-            .setHostname(domain_)
-            .setConfCmds(sslConfCmds_)
-            .setCertPath(clientCertPath_)
-            .setKeyPath(clientKeyPath_);
-        holder->client->enableSSL(std::move(policy));
+        holder->client->enableSSL(tlsPolicy(false));
     }
 
     auto thisPtr = shared_from_this();
@@ -999,29 +1443,24 @@ void HttpClientImpl::sendRequestForSseInLoop(const HttpRequestPtr &req,
     // Handle DNS resolution if needed
     if (isDomainName_ && !domain_.empty())
     {
-        if (!resolverPtr_)
-        {
-            resolverPtr_ = trantor::Resolver::newResolver(loop_, 600);
-        }
-
-        resolverPtr_->resolve(
-            domain_, [thisPtr, holder](const trantor::InetAddress &addr) {
-                thisPtr->loop_->runInLoop([thisPtr, holder, addr]() {
-                    if (holder->context->status() ==
-                        SseClientContext::Status::Closed)
-                    {
-                        return;
-                    }
+        DnsCache::instance().resolve(
+            domain_,
+            loop_,
+            [holder](const std::vector<trantor::InetAddress> &addrs) {
+                if (holder->context->status() ==
+                    SseClientContext::Status::Closed)
+                {
+                    return;
+                }
 
-                    if (!addr.isUnspecified() && addr.portNetEndian() != 0)
-                    {
-                        holder->client->connect();
-                    }
-                    else
-                    {
-                        holder->context->onClose(ReqResult::BadServerAddress);
-                    }
-                });
+                if (!addrs.empty())
+                {
+                    holder->client->connect();
+                }
+                else
+                {
+                    holder->context->onClose(ReqResult::BadServerAddress);
+                }
             });
     }
     else
@@ -1031,3 +1470,174 @@ void HttpClientImpl::sendRequestForSseInLoop(const HttpRequestPtr &req,
     }
 }
 
+// Streamed response bodies
+
+void HttpClientImpl::sendRequestForStream(
+    const HttpRequestPtr &req,
+    HttpStreamHeadersCallback headersCallback,
+    HttpStreamDataCallback dataCallback,
+    HttpReqCallback finishCallback,
+    double timeout)
+{
+    auto thisPtr = shared_from_this();
+    loop_->runInLoop([thisPtr,
+                      req,
+                      headersCallback = std::move(headersCallback),
+                      dataCallback = std::move(dataCallback),
+                      finishCallback = std::move(finishCallback),
+                      timeout]() mutable {
+        thisPtr->sendRequestForStreamInLoop(req,
+                                            std::move(headersCallback),
+                                            std::move(dataCallback),
+                                            std::move(finishCallback),
+                                            timeout);
+    });
+}
+
+void HttpClientImpl::sendRequestForStreamInLoop(
+    const HttpRequestPtr &req,
+    HttpStreamHeadersCallback &&headersCallback,
+    HttpStreamDataCallback &&dataCallback,
+    HttpReqCallback &&finishCallback,
+    double timeout)
+{
+    loop_->assertInLoopThread();
+    if (!static_cast<drogon::HttpRequestImpl *>(req.get())->passThrough())
+    {
+        // The connection serves this request only
+        req->addHeader("connection", "close");
+        if (!userAgent_.empty())
+            req->addHeader("user-agent", userAgent_);
+    }
+    if (req->getHeader("host").empty())
+    {
+        if (onDefaultPort())
+        {
+            req->addHeader("host", host());
+        }
+        else
+        {
+            req->addHeader("host", host() + ":" + std::to_string(port()));
+        }
+    }
+    for (auto &cookie : validCookies_)
+    {
+        if ((cookie.expiresDate().microSecondsSinceEpoch() == 0 ||
+             cookie.expiresDate() > trantor::Date::now()) &&
+            (cookie.path().empty() || req->path().find(cookie.path()) == 0))
+        {
+            req->addCookie(cookie.key(), cookie.value());
+        }
+    }
+
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    auto context = std::make_shared<StreamClientContext>(
+        loop_,
+        req->method() == Head,
+        [weakPtr, headersCallback = std::move(headersCallback)](
+            const HttpResponsePtr &resp, const HttpBodyStreamPtr &stream) {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->handleCookies(
+                    std::static_pointer_cast<HttpResponseImpl>(resp));
+            if (headersCallback)
+                headersCallback(resp, stream);
+        },
+        std::move(dataCallback),
+        std::move(finishCallback));
+    context->start(timeout);
+
+    if (domain_.empty() || !isDomainName_)
+    {
+        if (isValidIpAddr(serverAddr_))
+            connectForStream(context, req, serverAddr_);
+        else
+            context->onClose(ReqResult::BadServerAddress);
+        return;
+    }
+    auto thisPtr = shared_from_this();
+    DnsCache::instance().resolve(
+        domain_,
+        loop_,
+        [thisPtr, context, req](
+            const std::vector<trantor::InetAddress> &addrs) {
+            if (context->finished())
+                return;
+            for (auto addr : addrs)
+            {
+                addr.setPortNetEndian(thisPtr->serverAddr_.portNetEndian());
+                if (isValidIpAddr(addr))
+                {
+                    thisPtr->connectForStream(context, req, addr);
+                    return;
+                }
+            }
+            context->onClose(ReqResult::BadServerAddress);
+        });
+}
+
+void HttpClientImpl::connectForStream(const StreamClientContextPtr &context,
+                                      const HttpRequestPtr &req,
+                                      const trantor::InetAddress &addr)
+{
+    auto client =
+        std::make_shared<trantor::TcpClient>(loop_, addr, "streamClient");
+    if (useSSL_ && utils::supportsTls())
+    {
+        client->enableSSL(tlsPolicy(false));
+    }
+    if (sockOptCallback_)
+    {
+        client->setSockOptCallback(sockOptCallback_);
+    }
+
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    std::weak_ptr<StreamClientContext> weakContext = context;
+    client->setConnectionCallback(
+        [weakPtr, weakContext, req](const trantor::TcpConnectionPtr &connPtr) {
+            auto context = weakContext.lock();
+            if (!context)
+                return;
+            if (!connPtr->connected())
+            {
+                context->onClose(ReqResult::NetworkFailure);
+                return;
+            }
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                context->onClose(ReqResult::NetworkFailure);
+                return;
+            }
+            context->onConnected(connPtr);
+            // The stream parser doesn't expect interim responses, the body
+            // is sent at once
+            thisPtr->sendReq(connPtr, req, false);
+        });
+    client->setConnectionErrorCallback([weakContext]() {
+        if (auto context = weakContext.lock())
+            context->onClose(ReqResult::BadServerAddress);
+    });
+    client->setMessageCallback(
+        [weakPtr, weakContext](const trantor::TcpConnectionPtr &,
+                               trantor::MsgBuffer *msg) {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->bytesReceived_ += msg->readableBytes();
+            if (auto context = weakContext.lock())
+                context->onMessage(msg);
+            else
+                msg->retrieveAll();
+        });
+    client->setSSLErrorCallback([weakContext](trantor::SSLError err) {
+        auto context = weakContext.lock();
+        if (!context)
+            return;
+        if (err == trantor::SSLError::kSSLHandshakeError)
+            context->onClose(ReqResult::HandshakeError);
+        else if (err == trantor::SSLError::kSSLInvalidCertificate)
+            context->onClose(ReqResult::InvalidCertificate);
+        else if (err == trantor::SSLError::kSSLProtocolError)
+            context->onClose(ReqResult::EncryptionFailure);
+    });
+    context->setClient(client);
+    client->connect();
+}
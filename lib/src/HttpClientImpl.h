@@ -17,7 +17,6 @@
 #include <drogon/Cookie.h>
 #include <drogon/HttpClient.h>
 #include <trantor/net/EventLoop.h>
-#include <trantor/net/Resolver.h>
 #include <trantor/net/TcpClient.h>
 #include <cstddef>
 #include <functional>
@@ -26,10 +25,14 @@
 #include <mutex>
 #include <queue>
 #include <vector>
+#include "Http2ClientConnection.h"
+#include "HttpRequestImpl.h"
 #include "impl_forwards.h"
 
 namespace drogon
 {
+class StreamClientContext;
+
 class HttpClientImpl final : public HttpClient,
                              public std::enable_shared_from_this<HttpClientImpl>
 {
@@ -61,6 +64,12 @@ class HttpClientImpl final : public HttpClient,
                            SseHeadersCallback &&headersCallback,
                            double timeout = 0) override;
 
+    void sendRequestForStream(const HttpRequestPtr &req,
+                              HttpStreamHeadersCallback headersCallback,
+                              HttpStreamDataCallback dataCallback,
+                              HttpReqCallback finishCallback,
+                              double timeout = 0) override;
+
     trantor::EventLoop *getLoop() override
     {
         return loop_;
@@ -71,6 +80,16 @@ class HttpClientImpl final : public HttpClient,
         pipeliningDepth_ = depth;
     }
 
+    void enableHttp2(bool enable = true) override
+    {
+        http2Enabled_ = enable;
+    }
+
+    void enableCache(bool enable = true) override
+    {
+        cacheEnabled_ = enable;
+    }
+
     ~HttpClientImpl();
 
     void enableCookies(bool flag = true) override
@@ -145,13 +164,28 @@ class HttpClientImpl final : public HttpClient,
     }
 
   private:
+    friend class HttpClientCache;
+
     std::shared_ptr<trantor::TcpClient> tcpClientPtr_;
     trantor::EventLoop *loop_;
     trantor::InetAddress serverAddr_;
     bool useSSL_;
     bool validateCert_;
+    /**
+     * Send the request. If it expects 100 (Continue) and waitForContinue is
+     * true, its body is held back until the response or a timeout, and the
+     * next requests are buffered meanwhile.
+     */
     void sendReq(const trantor::TcpConnectionPtr &connPtr,
-                 const HttpRequestPtr &req);
+                 const HttpRequestPtr &req,
+                 bool waitForContinue = true);
+    void sendBody(const trantor::TcpConnectionPtr &connPtr,
+                  std::vector<HttpRequestImpl::BodyPiece> &&pieces,
+                  std::function<std::size_t(char *, std::size_t)> &&generator,
+                  bool chunked);
+    void sendContinuedBody();
+    void dropContinuedBody();
+    void sendBufferedRequests(const trantor::TcpConnectionPtr &connPtr);
     void sendRequestInLoop(const HttpRequestPtr &req,
                            HttpReqCallback &&callback);
     void sendRequestInLoop(const HttpRequestPtr &req,
@@ -162,11 +196,30 @@ class HttpClientImpl final : public HttpClient,
                                  SseClosedCallback &&closedCallback,
                                  SseHeadersCallback &&headersCallback,
                                  double timeout);
+    void sendRequestForStreamInLoop(const HttpRequestPtr &req,
+                                    HttpStreamHeadersCallback &&headersCallback,
+                                    HttpStreamDataCallback &&dataCallback,
+                                    HttpReqCallback &&finishCallback,
+                                    double timeout);
+    void connectForStream(const std::shared_ptr<StreamClientContext> &context,
+                          const HttpRequestPtr &req,
+                          const trantor::InetAddress &addr);
     void handleCookies(const HttpResponseImplPtr &resp);
     void handleResponse(const HttpResponseImplPtr &resp,
                         std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb,
                         const trantor::TcpConnectionPtr &connPtr);
+    void decodeResponse(const HttpResponseImplPtr &resp);
     void createTcpClient();
+    const std::shared_ptr<trantor::TLSPolicy> &tlsPolicy(bool offerHttp2);
+    std::shared_ptr<trantor::TcpClient> newTcpClient(
+        const trantor::InetAddress &addr);
+    void startNextAttempt();
+    bool winRace(trantor::TcpClient *client);
+    void stopRace();
+    void onAttemptFailed(trantor::TcpClient *client);
+    void startHttp2(const trantor::TcpConnectionPtr &connPtr);
+    void sendHttp2Requests();
+    void closeHttp2(ReqResult result);
     std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> pipeliningCallbacks_;
     std::list<std::pair<HttpRequestPtr, HttpReqCallback>> requestsBuffer_;
     void onRecvMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
@@ -174,18 +227,41 @@ class HttpClientImpl final : public HttpClient,
     std::string domain_;
     bool isDomainName_{true};  // true if domain_ is name
     size_t pipeliningDepth_{0};
+    bool http2Enabled_{false};
+    bool cacheEnabled_{false};
+    Http2ClientConnectionPtr http2ConnPtr_;
     bool enableCookies_{false};
     std::vector<Cookie> validCookies_;
     size_t bytesSent_{0};
     size_t bytesReceived_{0};
     bool dns_{false};
-    std::shared_ptr<trantor::Resolver> resolverPtr_;
+    // Happy eyeballs (RFC 8305): the addresses of the domain are tried in
+    // turn, the next one while the previous attempts are in progress, and
+    // the first connection wins.
+    std::vector<trantor::InetAddress> candidates_;
+    size_t nextCandidate_{0};
+    std::vector<std::shared_ptr<trantor::TcpClient>> racing_;
+    trantor::TimerId raceTimer_{0};
     bool useOldTLS_{false};
     std::string userAgent_{"DrogonClient"};
     std::vector<std::pair<std::string, std::string>> sslConfCmds_;
     std::string clientCertPath_;
     std::string clientKeyPath_;
     std::function<void(int)> sockOptCallback_;
+    // Built on first use, the second one offers h2 through ALPN
+    std::shared_ptr<trantor::TLSPolicy> tlsPolicies_[2];
+
+    // The body of the last request sent, held back until the server accepts
+    // its Expect: 100-continue
+    struct ContinueBody
+    {
+        std::weak_ptr<trantor::TcpConnection> connection;
+        std::vector<HttpRequestImpl::BodyPiece> pieces;
+        std::function<std::size_t(char *, std::size_t)> generator;
+        bool chunked{false};
+    };
+    std::unique_ptr<ContinueBody> continueBody_;
+    trantor::TimerId continueTimer_{0};
 };
 
 using HttpClientImplPtr = std::shared_ptr<HttpClientImpl>;
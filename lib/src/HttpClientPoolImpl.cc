@@ -0,0 +1,414 @@
+/**
+ *
+ *  @file HttpClientPoolImpl.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpClientPoolImpl.h"
+#include "HttpAppFrameworkImpl.h"
+#include "BuiltinMetrics.h"
+#include "HttpRequestImpl.h"
+#include <algorithm>
+
+using namespace drogon;
+
+namespace
+{
+constexpr double kReapInterval = 1.0;
+}  // namespace
+
+HttpClientPoolPtr HttpClientPool::newHttpClientPool(
+    const std::string &hostString,
+    size_t connectionsPerLoop,
+    const std::vector<trantor::EventLoop *> &loops,
+    bool useOldTLS,
+    bool validateCert)
+{
+    return std::make_shared<HttpClientPoolImpl>(
+        hostString, connectionsPerLoop, loops, useOldTLS, validateCert);
+}
+
+HttpClientPoolImpl::HttpClientPoolImpl(
+    std::string hostString,
+    size_t connectionsPerLoop,
+    const std::vector<trantor::EventLoop *> &loops,
+    bool useOldTLS,
+    bool validateCert)
+    : hostString_(std::move(hostString)),
+      connectionsPerLoop_(connectionsPerLoop == 0 ? 1 : connectionsPerLoop),
+      useOldTLS_(useOldTLS),
+      validateCert_(validateCert)
+{
+    auto poolLoops = loops;
+    if (poolLoops.empty())
+    {
+        auto &app = HttpAppFrameworkImpl::instance();
+        for (size_t i = 0; i < app.getThreadNum(); ++i)
+        {
+            auto loop = app.getIOLoop(i);
+            if (!loop)
+                break;
+            poolLoops.push_back(loop);
+        }
+        if (poolLoops.empty())
+            poolLoops.push_back(app.getLoop());
+    }
+    loopPools_.resize(poolLoops.size());
+    for (size_t i = 0; i < poolLoops.size(); ++i)
+    {
+        loopPools_[i].loop = poolLoops[i];
+    }
+}
+
+HttpClientPoolImpl::~HttpClientPoolImpl()
+{
+    for (auto &pool : loopPools_)
+    {
+        if (!pool.started)
+            continue;
+        pool.loop->invalidateTimer(pool.reaperTimer);
+        if (!pool.loop->isInLoopThread())
+        {
+            // Make sure the clients are destroyed in the correct thread.
+            pool.loop->queueInLoop(
+                [connections = std::move(pool.connections)]() {});
+        }
+    }
+}
+
+void HttpClientPoolImpl::sendRequest(const HttpRequestPtr &req,
+                                     HttpReqCallback &&callback,
+                                     double timeout)
+{
+    auto &pool = currentLoopPool();
+    WaitingRequest request{req, std::move(callback), timeout};
+    if (pool.loop->isInLoopThread())
+    {
+        dispatch(pool, std::move(request));
+        return;
+    }
+    pool.loop->queueInLoop([thisPtr = shared_from_this(),
+                            poolPtr = &pool,
+                            request = std::move(request)]() mutable {
+        thisPtr->dispatch(*poolPtr, std::move(request));
+    });
+}
+
+HttpClientPool::Metrics HttpClientPoolImpl::metrics() const
+{
+    Metrics metrics;
+    metrics.connections = connections_.load(std::memory_order_relaxed);
+    metrics.inFlight = inFlight_.load(std::memory_order_relaxed);
+    metrics.queued = queued_.load(std::memory_order_relaxed);
+    metrics.completed = completed_.load(std::memory_order_relaxed);
+    metrics.failed = failed_.load(std::memory_order_relaxed);
+    metrics.reaped = reaped_.load(std::memory_order_relaxed);
+    metrics.hedged = hedged_.load(std::memory_order_relaxed);
+    metrics.hedgesWon = hedgesWon_.load(std::memory_order_relaxed);
+    metrics.retried = retried_.load(std::memory_order_relaxed);
+    metrics.throttled = throttled_.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+HttpClientPoolImpl::LoopPool &HttpClientPoolImpl::currentLoopPool()
+{
+    for (auto &pool : loopPools_)
+    {
+        if (pool.loop->isInLoopThread())
+            return pool;
+    }
+    auto index = nextLoop_.fetch_add(1, std::memory_order_relaxed);
+    return loopPools_[index % loopPools_.size()];
+}
+
+void HttpClientPoolImpl::dispatch(LoopPool &pool, WaitingRequest &&request)
+{
+    if (!pool.started)
+    {
+        pool.started = true;
+        std::weak_ptr<HttpClientPoolImpl> weakPtr = shared_from_this();
+        pool.reaperTimer =
+            pool.loop->runEvery(kReapInterval, [weakPtr, poolPtr = &pool]() {
+                auto thisPtr = weakPtr.lock();
+                if (thisPtr)
+                    thisPtr->reap(*poolPtr);
+            });
+    }
+    if (hedging_ && !request.hedged && isHedgeable(request.req))
+    {
+        budget_->deposit();
+        auto hedged = std::make_shared<HedgedRequest>();
+        hedged->req = std::move(request.req);
+        hedged->callback = std::move(request.callback);
+        hedged->timeout = request.timeout;
+        request = newAttempt(pool, hedged, false);
+    }
+    auto conn = selectConnection(pool);
+    if (!conn)
+    {
+        pool.waiting.push_back(std::move(request));
+        ++queued_;
+        return;
+    }
+    send(pool, conn, std::move(request));
+}
+
+HttpClientPoolImpl::ConnectionPtr HttpClientPoolImpl::selectConnection(
+    LoopPool &pool,
+    const Connection *exclude)
+{
+    ConnectionPtr best;
+    size_t open{0};
+    for (auto &conn : pool.connections)
+    {
+        if (conn->retired)
+            continue;
+        ++open;
+        if (conn.get() == exclude)
+            continue;
+        if (!best || conn->inFlight < best->inFlight)
+            best = conn;
+    }
+    // A new connection is better than waiting behind a busy one
+    if ((!best || best->inFlight > 0) && open < connectionsPerLoop_)
+    {
+        auto client = std::make_shared<HttpClientImpl>(pool.loop,
+                                                       hostString_,
+                                                       useOldTLS_,
+                                                       validateCert_);
+        if (initializer_)
+            initializer_(client);
+        auto conn = std::make_shared<Connection>();
+        conn->client = std::move(client);
+        conn->created = trantor::Date::now();
+        conn->lastActive = conn->created;
+        pool.connections.push_back(conn);
+        ++connections_;
+        return conn;
+    }
+    if (best && best->inFlight < maxInFlight_)
+        return best;
+    return nullptr;
+}
+
+void HttpClientPoolImpl::send(LoopPool &pool,
+                              const ConnectionPtr &conn,
+                              WaitingRequest &&request)
+{
+    ++conn->inFlight;
+    ++inFlight_;
+    conn->lastActive = trantor::Date::now();
+    if (request.hedged && !request.hedged->primary)
+    {
+        request.hedged->primary = conn.get();
+        armHedge(pool, request.hedged);
+    }
+    conn->client->sendRequest(
+        request.req,
+        [thisPtr = shared_from_this(),
+         poolPtr = &pool,
+         conn,
+         sent = conn->lastActive,
+         callback = std::move(request.callback)](ReqResult result,
+                                                 const HttpResponsePtr &resp) {
+            --conn->inFlight;
+            --thisPtr->inFlight_;
+            ++thisPtr->completed_;
+            conn->lastActive = trantor::Date::now();
+            if (thisPtr->hedging_ && result == ReqResult::Ok)
+            {
+                poolPtr->latencies.observe(
+                    static_cast<double>(
+                        conn->lastActive.microSecondsSinceEpoch() -
+                        sent.microSecondsSinceEpoch()) /
+                    1000000);
+            }
+            if (result != ReqResult::Ok)
+            {
+                ++thisPtr->failed_;
+                // The request which timed out still occupies the connection,
+                // which is closed instead of being reused
+                if (result == ReqResult::Timeout)
+                    conn->retired = true;
+            }
+            callback(result, resp);
+            thisPtr->dispatchWaiting(*poolPtr);
+        },
+        request.timeout);
+}
+
+void HttpClientPoolImpl::dispatchWaiting(LoopPool &pool)
+{
+    while (!pool.waiting.empty())
+    {
+        // The retry of a request answered by its hedge meanwhile
+        auto &front = pool.waiting.front();
+        if (front.hedged && front.hedged->done)
+        {
+            pool.waiting.pop_front();
+            --queued_;
+            continue;
+        }
+        auto conn = selectConnection(pool);
+        if (!conn)
+            return;
+        auto request = std::move(pool.waiting.front());
+        pool.waiting.pop_front();
+        --queued_;
+        send(pool, conn, std::move(request));
+    }
+}
+
+void HttpClientPoolImpl::reap(LoopPool &pool)
+{
+    auto now = trantor::Date::now();
+    auto end = std::remove_if(
+        pool.connections.begin(),
+        pool.connections.end(),
+        [this, &now](const ConnectionPtr &conn) {
+            if (maxLifetime_ > 0 && now > conn->created.after(maxLifetime_))
+                conn->retired = true;
+            if (conn->inFlight > 0)
+                return false;
+            return conn->retired ||
+                   (idleTimeout_ > 0 &&
+                    now > conn->lastActive.after(idleTimeout_));
+        });
+    auto count = static_cast<size_t>(pool.connections.end() - end);
+    if (count == 0)
+        return;
+    pool.connections.erase(end, pool.connections.end());
+    connections_ -= count;
+    reaped_ += count;
+    // The retired connections made room for new ones
+    dispatchWaiting(pool);
+}
+
+bool HttpClientPoolImpl::isHedgeable(const HttpRequestPtr &req) const
+{
+    switch (req->method())
+    {
+        case Get:
+        case Head:
+        case Options:
+        case Put:
+        case Delete:
+            return !static_cast<const HttpRequestImpl *>(req.get())
+                        ->hasBodyGenerator();
+        default:
+            return false;
+    }
+}
+
+HttpClientPoolImpl::WaitingRequest HttpClientPoolImpl::newAttempt(
+    LoopPool &pool,
+    const HedgedRequestPtr &hedged,
+    bool isHedge)
+{
+    ++hedged->pending;
+    // The callback of send() holds the pool until this one returns
+    return {hedged->req,
+            [this, poolPtr = &pool, hedged, isHedge](
+                ReqResult result, const HttpResponsePtr &resp) {
+                onAttemptDone(*poolPtr, hedged, isHedge, result, resp);
+            },
+            hedged->timeout,
+            hedged};
+}
+
+void HttpClientPoolImpl::armHedge(LoopPool &pool,
+                                  const HedgedRequestPtr &hedged)
+{
+    auto delay = hedging_->delay;
+    if (delay <= 0)
+    {
+        auto latency = pool.latencies.percentile(hedging_->percentile);
+        // Too few responses yet to know what is slow
+        if (!latency)
+            return;
+        delay = std::max(*latency, hedging_->minDelay);
+    }
+    std::weak_ptr<HttpClientPoolImpl> weakPtr = shared_from_this();
+    hedged->hedgeTimer =
+        pool.loop->runAfter(delay, [weakPtr, poolPtr = &pool, hedged]() {
+            hedged->hedgeTimer = 0;
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr && !hedged->done)
+                thisPtr->sendHedge(*poolPtr, hedged);
+        });
+}
+
+void HttpClientPoolImpl::sendHedge(LoopPool &pool,
+                                   const HedgedRequestPtr &hedged)
+{
+    auto conn = selectConnection(pool, hedged->primary);
+    // A duplicate waiting behind the first attempt would not be faster
+    if (!conn)
+        return;
+    if (!budget_->withdraw())
+    {
+        ++throttled_;
+        BuiltinMetrics::instance().clientRetry(
+            BuiltinMetrics::ClientRetry::kThrottled);
+        return;
+    }
+    ++hedged_;
+    BuiltinMetrics::instance().clientRetry(BuiltinMetrics::ClientRetry::kHedge);
+    send(pool, conn, newAttempt(pool, hedged, true));
+}
+
+void HttpClientPoolImpl::onAttemptDone(LoopPool &pool,
+                                       const HedgedRequestPtr &hedged,
+                                       bool isHedge,
+                                       ReqResult result,
+                                       const HttpResponsePtr &resp)
+{
+    --hedged->pending;
+    // A duplicate was answered first, this response is dropped
+    if (hedged->done)
+        return;
+    if (result != ReqResult::Ok)
+    {
+        // The other attempt may still succeed
+        if (hedged->pending > 0)
+            return;
+        if ((result == ReqResult::NetworkFailure ||
+             result == ReqResult::BadServerAddress) &&
+            hedged->retries < hedging_->maxRetries)
+        {
+            if (budget_->withdraw())
+            {
+                ++hedged->retries;
+                ++retried_;
+                BuiltinMetrics::instance().clientRetry(
+                    BuiltinMetrics::ClientRetry::kRetry);
+                dispatch(pool, newAttempt(pool, hedged, false));
+                return;
+            }
+            ++throttled_;
+            BuiltinMetrics::instance().clientRetry(
+                BuiltinMetrics::ClientRetry::kThrottled);
+        }
+    }
+    hedged->done = true;
+    if (hedged->hedgeTimer != 0)
+    {
+        pool.loop->invalidateTimer(hedged->hedgeTimer);
+        hedged->hedgeTimer = 0;
+    }
+    if (isHedge && result == ReqResult::Ok)
+    {
+        ++hedgesWon_;
+        BuiltinMetrics::instance().clientRetry(
+            BuiltinMetrics::ClientRetry::kHedgeWon);
+    }
+    auto callback = std::move(hedged->callback);
+    callback(result, resp);
+}
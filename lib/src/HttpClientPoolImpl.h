@@ -0,0 +1,168 @@
+/**
+ *
+ *  @file HttpClientPoolImpl.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpClientImpl.h"
+#include "RetryBudget.h"
+#include <drogon/HttpClientPool.h>
+#include <trantor/utils/Date.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+class HttpClientPoolImpl final
+    : public HttpClientPool,
+      public std::enable_shared_from_this<HttpClientPoolImpl>
+{
+  public:
+    HttpClientPoolImpl(std::string hostString,
+                       size_t connectionsPerLoop,
+                       const std::vector<trantor::EventLoop *> &loops,
+                       bool useOldTLS,
+                       bool validateCert);
+    ~HttpClientPoolImpl() override;
+
+    void sendRequest(const HttpRequestPtr &req,
+                     HttpReqCallback &&callback,
+                     double timeout = 0) override;
+
+    void setMaxInFlight(size_t maxInFlight) override
+    {
+        maxInFlight_ = maxInFlight == 0 ? 1 : maxInFlight;
+    }
+
+    void setIdleTimeout(double timeout) override
+    {
+        idleTimeout_ = timeout;
+    }
+
+    void setMaxConnectionLifetime(double lifetime) override
+    {
+        maxLifetime_ = lifetime;
+    }
+
+    void setClientInitializer(
+        std::function<void(const HttpClientPtr &)> initializer) override
+    {
+        initializer_ = std::move(initializer);
+    }
+
+    void enableHedging(const HedgingPolicy &policy) override
+    {
+        hedging_ = policy;
+        budget_ = std::make_unique<RetryBudget>(policy.budgetRatio,
+                                                policy.budgetCapacity);
+    }
+
+    Metrics metrics() const override;
+
+  private:
+    struct Connection
+    {
+        HttpClientImplPtr client;
+        size_t inFlight{0};
+        trantor::Date created;
+        trantor::Date lastActive;
+        bool retired{false};
+    };
+
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    /// The attempts of a hedged request, the first response ends them
+    struct HedgedRequest
+    {
+        HttpRequestPtr req;
+        HttpReqCallback callback;
+        double timeout{0};
+        size_t pending{0};
+        size_t retries{0};
+        bool done{false};
+        trantor::TimerId hedgeTimer{0};
+        // The connection of the first attempt, the hedge avoids it
+        const Connection *primary{nullptr};
+    };
+
+    using HedgedRequestPtr = std::shared_ptr<HedgedRequest>;
+
+    struct WaitingRequest
+    {
+        HttpRequestPtr req;
+        HttpReqCallback callback;
+        double timeout;
+        HedgedRequestPtr hedged;
+    };
+
+    /// The connections of one loop, only used in the loop.
+    struct LoopPool
+    {
+        trantor::EventLoop *loop{nullptr};
+        std::vector<ConnectionPtr> connections;
+        std::deque<WaitingRequest> waiting;
+        trantor::TimerId reaperTimer{0};
+        bool started{false};
+        // The latencies of the last responses, for the hedging delay
+        LatencyWindow latencies;
+    };
+
+    LoopPool &currentLoopPool();
+    void dispatch(LoopPool &pool, WaitingRequest &&request);
+    ConnectionPtr selectConnection(LoopPool &pool,
+                                   const Connection *exclude = nullptr);
+    void send(LoopPool &pool,
+              const ConnectionPtr &conn,
+              WaitingRequest &&request);
+    bool isHedgeable(const HttpRequestPtr &req) const;
+    WaitingRequest newAttempt(LoopPool &pool,
+                              const HedgedRequestPtr &hedged,
+                              bool isHedge);
+    void armHedge(LoopPool &pool, const HedgedRequestPtr &hedged);
+    void sendHedge(LoopPool &pool, const HedgedRequestPtr &hedged);
+    void onAttemptDone(LoopPool &pool,
+                       const HedgedRequestPtr &hedged,
+                       bool isHedge,
+                       ReqResult result,
+                       const HttpResponsePtr &resp);
+    void dispatchWaiting(LoopPool &pool);
+    void reap(LoopPool &pool);
+
+    const std::string hostString_;
+    const size_t connectionsPerLoop_;
+    const bool useOldTLS_;
+    const bool validateCert_;
+    size_t maxInFlight_{1};
+    double idleTimeout_{60.0};
+    double maxLifetime_{0.0};
+    std::function<void(const HttpClientPtr &)> initializer_;
+    std::optional<HedgingPolicy> hedging_;
+    std::unique_ptr<RetryBudget> budget_;
+    std::vector<LoopPool> loopPools_;
+    std::atomic<size_t> nextLoop_{0};
+
+    std::atomic<size_t> connections_{0};
+    std::atomic<size_t> inFlight_{0};
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> completed_{0};
+    std::atomic<size_t> failed_{0};
+    std::atomic<size_t> reaped_{0};
+    std::atomic<size_t> hedged_{0};
+    std::atomic<size_t> hedgesWon_{0};
+    std::atomic<size_t> retried_{0};
+    std::atomic<size_t> throttled_{0};
+};
+}  // namespace drogon
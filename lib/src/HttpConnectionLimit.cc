@@ -17,6 +17,14 @@
 
 using namespace drogon;
 
+namespace
+{
+// How long the slow connections of a client are remembered
+constexpr std::chrono::seconds kSlowClientPeriod{60};
+// The expired clients are removed when there are more
+constexpr size_t kSlowClientsPruneSize{1024};
+}  // namespace
+
 void HttpConnectionLimit::setMaxConnectionNum(size_t num)
 {
     maxConnectionNum_ = num;
@@ -27,10 +35,8 @@ void HttpConnectionLimit::setMaxConnectionNumPerIP(size_t num)
     maxConnectionNumPerIP_ = num;
 }
 
-bool HttpConnectionLimit::tryAddConnection(
-    const trantor::TcpConnectionPtr &conn)
+bool HttpConnectionLimit::tryAddConnection(const trantor::InetAddress &peer)
 {
-    assert(conn->connected());
     if (connectionNum_.fetch_add(1, std::memory_order_relaxed) >
         maxConnectionNum_)
     {
@@ -38,11 +44,16 @@ bool HttpConnectionLimit::tryAddConnection(
     }
     if (maxConnectionNumPerIP_ > 0)
     {
-        std::string ip = conn->peerAddr().toIp();
+        std::string ip = peer.toIp();
         size_t numOnThisIp;
         {
             std::lock_guard<std::mutex> lock(mutex_);
             numOnThisIp = (++ipConnectionsMap_[ip]);
+            if (!slowClients_.empty() && isSlowClient(ip))
+            {
+                LOG_DEBUG << "refuse the slow client " << ip;
+                return false;
+            }
         }
         if (numOnThisIp > maxConnectionNumPerIP_)
         {
@@ -53,20 +64,12 @@ bool HttpConnectionLimit::tryAddConnection(
     return true;
 }
 
-void HttpConnectionLimit::releaseConnection(
-    const trantor::TcpConnectionPtr &conn)
+void HttpConnectionLimit::releaseConnection(const trantor::InetAddress &peer)
 {
-    assert(!conn->connected());
-    if (!conn->hasContext())
-    {
-        // If the connection is connected to the SSL port and then
-        // disconnected before the SSL handshake.
-        return;
-    }
     connectionNum_.fetch_sub(1, std::memory_order_relaxed);
     if (maxConnectionNumPerIP_ > 0)
     {
-        std::string ip = conn->peerAddr().toIp();
+        std::string ip = peer.toIp();
         std::lock_guard<std::mutex> lock(mutex_);
         auto iter = ipConnectionsMap_.find(ip);
         if (iter != ipConnectionsMap_.end())
@@ -78,3 +81,37 @@ void HttpConnectionLimit::releaseConnection(
         }
     }
 }
+
+void HttpConnectionLimit::addSlowClient(const trantor::InetAddress &peer)
+{
+    if (maxConnectionNumPerIP_ == 0)
+        return;
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slowClients_.size() >= kSlowClientsPruneSize)
+    {
+        for (auto iter = slowClients_.begin(); iter != slowClients_.end();)
+        {
+            if (iter->second.expiry <= now)
+                iter = slowClients_.erase(iter);
+            else
+                ++iter;
+        }
+    }
+    auto &client = slowClients_[peer.toIp()];
+    ++client.count;
+    client.expiry = now + kSlowClientPeriod;
+}
+
+bool HttpConnectionLimit::isSlowClient(const std::string &ip)
+{
+    auto iter = slowClients_.find(ip);
+    if (iter == slowClients_.end())
+        return false;
+    if (iter->second.expiry <= std::chrono::steady_clock::now())
+    {
+        slowClients_.erase(iter);
+        return false;
+    }
+    return iter->second.count >= maxConnectionNumPerIP_;
+}
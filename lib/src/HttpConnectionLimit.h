@@ -17,9 +17,10 @@
 #include <string>
 #include <unordered_map>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <mutex>
-#include <trantor/net/TcpConnection.h>
+#include <trantor/net/InetAddress.h>
 
 namespace drogon
 {
@@ -41,10 +42,25 @@ class HttpConnectionLimit
     void setMaxConnectionNum(size_t num);
     void setMaxConnectionNumPerIP(size_t num);
 
-    bool tryAddConnection(const trantor::TcpConnectionPtr &conn);
-    void releaseConnection(const trantor::TcpConnectionPtr &conn);
+    // The peer is the client, given by the PROXY protocol header on the
+    // listeners behind a load balancer
+    bool tryAddConnection(const trantor::InetAddress &peer);
+    void releaseConnection(const trantor::InetAddress &peer);
+
+    // A connection of the peer was closed for sending its request too slowly,
+    // the peer is refused once it has as many as the connections per IP
+    void addSlowClient(const trantor::InetAddress &peer);
 
   private:
+    struct SlowClient
+    {
+        size_t count{0};
+        std::chrono::steady_clock::time_point expiry;
+    };
+
+    // True if the peer is refused, called with the mutex locked
+    bool isSlowClient(const std::string &ip);
+
     std::mutex mutex_;
 
     size_t maxConnectionNum_{100000};
@@ -52,5 +68,6 @@ class HttpConnectionLimit
 
     size_t maxConnectionNumPerIP_{0};
     std::unordered_map<std::string, size_t> ipConnectionsMap_;
+    std::unordered_map<std::string, SlowClient> slowClients_;
 };
 }  // namespace drogon
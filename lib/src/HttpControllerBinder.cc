@@ -13,7 +13,9 @@
  */
 
 #include "HttpControllerBinder.h"
+#include "HttpAppFrameworkImpl.h"
 #include "HttpResponseImpl.h"
+#include "WebSocketDeflate.h"
 #include <drogon/HttpSimpleController.h>
 #include <drogon/WebSocketController.h>
 
@@ -68,6 +70,18 @@ void WebsocketControllerBinder::handleRequest(
     resp->addHeader("Upgrade", "websocket");
     resp->addHeader("Connection", "Upgrade");
     resp->addHeader("Sec-WebSocket-Accept", base64Key);
+    auto &options =
+        HttpAppFrameworkImpl::instance().getWebSocketCompressionOptions();
+    if (options.enabled)
+    {
+        auto &offers = req->getHeaderBy("sec-websocket-extensions");
+        std::string extension;
+        if (!offers.empty() &&
+            WebSocketDeflate::acceptOffer(offers, options, extension))
+        {
+            resp->addHeader("Sec-WebSocket-Extensions", extension);
+        }
+    }
     callback(resp);
 }
 
@@ -77,16 +91,35 @@ void WebsocketControllerBinder::handleNewConnection(
 {
     auto ctrlPtr = controller_;
     assert(ctrlPtr);
-    wsConnPtr->setMessageCallback(
-        [ctrlPtr](std::string &&message,
-                  const WebSocketConnectionImplPtr &connPtr,
-                  const WebSocketMessageType &type) {
-            ctrlPtr->handleNewMessage(connPtr, std::move(message), type);
-        });
-    wsConnPtr->setCloseCallback(
-        [ctrlPtr](const WebSocketConnectionImplPtr &connPtr) {
-            ctrlPtr->handleConnectionClosed(connPtr);
-        });
+    std::call_once(callbacksOnce_, [this, &ctrlPtr]() {
+        auto callbacks = std::make_shared<WebSocketCallbacks>();
+        if (ctrlPtr->receivesMessageViews())
+        {
+            callbacks->messageView =
+                [ctrlPtr](std::string_view message,
+                          const WebSocketConnectionImplPtr &connPtr,
+                          const WebSocketMessageType &type) {
+                    ctrlPtr->handleNewMessageView(connPtr, message, type);
+                };
+        }
+        else
+        {
+            callbacks->message =
+                [ctrlPtr](std::string &&message,
+                          const WebSocketConnectionImplPtr &connPtr,
+                          const WebSocketMessageType &type) {
+                    ctrlPtr->handleNewMessage(connPtr,
+                                              std::move(message),
+                                              type);
+                };
+        }
+        callbacks->close =
+            [ctrlPtr](const WebSocketConnectionImplPtr &connPtr) {
+                ctrlPtr->handleConnectionClosed(connPtr);
+            };
+        callbacks_ = std::move(callbacks);
+    });
+    wsConnPtr->setCallbacks(callbacks_);
     ctrlPtr->handleNewConnection(req, wsConnPtr);
 }
 
@@ -18,6 +18,7 @@
 #include "HttpRequestImpl.h"
 #include "WebSocketConnectionImpl.h"
 #include <drogon/HttpBinder.h>
+#include <mutex>
 
 namespace drogon
 {
@@ -60,6 +61,12 @@ struct WebsocketControllerBinder : public ControllerBinderBase
 
     void handleNewConnection(const HttpRequestImplPtr &req,
                              const WebSocketConnectionImplPtr &wsConnPtr) const;
+
+  private:
+    // Shared by the connections, made by the first one as the controller is
+    // set after the binder is registered
+    mutable std::once_flag callbacksOnce_;
+    mutable std::shared_ptr<const WebSocketCallbacks> callbacks_;
 };
 
 }  // namespace drogon
@@ -13,10 +13,12 @@
  */
 
 #include "HttpControllersRouter.h"
+#include "AOPAdvice.h"
 #include "HttpControllerBinder.h"
 #include "HttpRequestImpl.h"
 #include "HttpAppFrameworkImpl.h"
 #include "MiddlewaresFunction.h"
+#include "RoutePlaceholders.h"
 #include <drogon/HttpSimpleController.h>
 #include <drogon/WebSocketController.h>
 #include <algorithm>
@@ -26,15 +28,18 @@ using namespace drogon;
 void HttpControllersRouter::init(
     const std::vector<trantor::EventLoop *> & /*ioLoops*/)
 {
-    auto initMiddlewaresAndCorsMethods = [](const auto &item) {
+    auto &aop = AopAdvice::instance();
+    auto initMiddlewaresAndCorsMethods = [&aop](const auto &item) {
         auto corsMethods = std::make_shared<std::string>("OPTIONS,");
         for (size_t i = 0; i < Invalid; ++i)
         {
             auto &binder = item.binders_[i];
             if (binder)
             {
-                binder->middlewares_ = middlewares_function::createMiddlewares(
+                binder->middlewares_ = middlewares_function::MiddlewareChain(
                     binder->middlewareNames_);
+                binder->passThrough_ =
+                    binder->middlewares_.empty() && !aop.hasRoutedStages();
                 binder->corsMethods_ = corsMethods;
                 if (binder->isCORS_)
                 {
@@ -70,19 +75,24 @@ void HttpControllersRouter::init(
         initMiddlewaresAndCorsMethods(router);
     }
 
+    for (auto *router : ctrlTrie_.items())
+    {
+        initMiddlewaresAndCorsMethods(*router);
+    }
+
+    // Found by their paths, the regex of their items is never matched
     for (auto &p : ctrlMap_)
     {
-        auto &router = p.second;
-        router.regex_ = std::regex(router.pathParameterPattern_,
-                                   std::regex_constants::icase);
-        initMiddlewaresAndCorsMethods(router);
+        initMiddlewaresAndCorsMethods(p.second);
     }
 }
 
 void HttpControllersRouter::reset()
 {
+    hasBodyLimits_ = false;
     simpleCtrlMap_.clear();
     ctrlMap_.clear();
+    ctrlTrie_.clear();
     ctrlVector_.clear();
     wsCtrlMap_.clear();
 }
@@ -131,6 +141,10 @@ std::vector<HttpHandlerInfo> HttpControllersRouter::getHandlersInfo() const
     {
         gatherInfo(path, item);
     }
+    for (auto *item : ctrlTrie_.items())
+    {
+        gatherInfo(item->pathPattern_, *item);
+    }
     for (auto &item : ctrlVector_)
     {
         gatherInfo(item.pathPattern_, item);
@@ -182,6 +196,8 @@ struct SimpleControllerProcessResult
     std::string lowerPath;
     std::vector<HttpMethod> validMethods;
     std::vector<std::string> middlewares;
+    BodyLimit bodyLimit;
+    bool offload;
 };
 
 static SimpleControllerProcessResult processSimpleControllerParams(
@@ -195,6 +211,8 @@ static SimpleControllerProcessResult processSimpleControllerParams(
                    [](unsigned char c) { return tolower(c); });
     std::vector<HttpMethod> validMethods;
     std::vector<std::string> middlewareNames;
+    BodyLimit bodyLimit;
+    bool offload = false;
     for (const auto &constraint : constraints)
     {
         if (constraint.type() == internal::ConstraintType::HttpMiddleware)
@@ -205,6 +223,14 @@ static SimpleControllerProcessResult processSimpleControllerParams(
         {
             validMethods.push_back(constraint.getHttpMethod());
         }
+        else if (constraint.type() == internal::ConstraintType::BodyLimit)
+        {
+            bodyLimit = constraint.getBodyLimit();
+        }
+        else if (constraint.type() == internal::ConstraintType::Offload)
+        {
+            offload = true;
+        }
         else
         {
             LOG_ERROR << "Invalid controller constraint type";
@@ -215,6 +241,8 @@ static SimpleControllerProcessResult processSimpleControllerParams(
         std::move(path),
         std::move(validMethods),
         std::move(middlewareNames),
+        bodyLimit,
+        offload,
     };
 }
 
@@ -234,6 +262,8 @@ void HttpControllersRouter::registerHttpSimpleController(
     auto binder = std::make_shared<HttpSimpleControllerBinder>();
     binder->handlerName_ = ctrlName;
     binder->middlewareNames_ = result.middlewares;
+    setBodyLimit(*binder, result.bodyLimit);
+    binder->offload_ = result.offload;
     drogon::app().getLoop()->queueInLoop([this, binder, ctrlName, path]() {
         auto &object_ = DrClassMap::getSingleInstance(ctrlName);
         auto controller =
@@ -318,6 +348,8 @@ void HttpControllersRouter::addHttpRegex(
     binderInfo->middlewareNames_ = middlewareNames;
     binderInfo->handlerName_ = handlerName;
     binderInfo->binderPtr_ = binder;
+    setBodyLimit(*binderInfo, binder->bodyLimit());
+    binderInfo->offload_ = binder->offload();
     drogon::app().getLoop()->queueInLoop([binderInfo]() {
         // Recreate this with the correct number of threads.
         binderInfo->responseCache_ = IOThreadStorage<HttpResponsePtr>();
@@ -337,8 +369,6 @@ void HttpControllersRouter::addHttpPath(
     std::vector<size_t> places;
     std::string tmpPath = path;
     std::string paras;
-    static const std::regex regex("\\{([^/]*)\\}");
-    std::smatch results;
     auto pos = tmpPath.find('?');
     if (pos != std::string::npos)
     {
@@ -348,22 +378,45 @@ void HttpControllersRouter::addHttpPath(
     std::string originPath = tmpPath;
     size_t placeIndex = 1;
     // Process path parameter placeholders
-    while (std::regex_search(tmpPath, results, regex))
+    size_t searchPos = 0;
+    std::string_view result;
+    while (internal::nextPathPlaceholder(originPath, searchPos, result))
     {
-        if (results.size() > 1)
+        if (!result.empty() &&
+            std::all_of(result.begin(), result.end(), [](const char c) {
+                return std::isdigit(c);
+            }))
         {
-            auto result = results[1].str();
-            if (!result.empty() &&
-                std::all_of(result.begin(), result.end(), [](const char c) {
-                    return std::isdigit(c);
-                }))
+            auto place = (size_t)std::stoi(std::string(result));
+            if (place > binder->paramCount() || place == 0)
+            {
+                LOG_ERROR << "Parameter placeholder(value=" << place
+                          << ") out of range (1 to " << binder->paramCount()
+                          << ")";
+                LOG_ERROR << "Path pattern: " << path;
+                exit(1);
+            }
+            if (!std::all_of(places.begin(),
+                             places.end(),
+                             [place](size_t i) { return i != place; }))
             {
-                auto place = (size_t)std::stoi(result);
+                LOG_ERROR << "Parameter placeholders are duplicated: index="
+                          << place;
+                LOG_ERROR << "Path pattern: " << path;
+                exit(1);
+            }
+            places.push_back(place);
+        }
+        else
+        {
+            if (internal::isNumberAndName(result))
+            {
+                auto place = (size_t)std::stoi(std::string(result));
                 if (place > binder->paramCount() || place == 0)
                 {
                     LOG_ERROR << "Parameter placeholder(value=" << place
-                              << ") out of range (1 to " << binder->paramCount()
-                              << ")";
+                              << ") out of range (1 to "
+                              << binder->paramCount() << ")";
                     LOG_ERROR << "Path pattern: " << path;
                     exit(1);
                 }
@@ -371,8 +424,9 @@ void HttpControllersRouter::addHttpPath(
                                  places.end(),
                                  [place](size_t i) { return i != place; }))
                 {
-                    LOG_ERROR << "Parameter placeholders are duplicated: index="
-                              << place;
+                    LOG_ERROR
+                        << "Parameter placeholders are duplicated: index="
+                        << place;
                     LOG_ERROR << "Path pattern: " << path;
                     exit(1);
                 }
@@ -380,70 +434,71 @@ void HttpControllersRouter::addHttpPath(
             }
             else
             {
-                static const std::regex regNumberAndName("([0-9]+):.*");
-                std::smatch regexResult;
-                if (std::regex_match(result, regexResult, regNumberAndName))
-                {
-                    assert(regexResult.size() == 2 && regexResult[1].matched);
-                    auto num = regexResult[1].str();
-                    auto place = (size_t)std::stoi(num);
-                    if (place > binder->paramCount() || place == 0)
-                    {
-                        LOG_ERROR << "Parameter placeholder(value=" << place
-                                  << ") out of range (1 to "
-                                  << binder->paramCount() << ")";
-                        LOG_ERROR << "Path pattern: " << path;
-                        exit(1);
-                    }
-                    if (!std::all_of(places.begin(),
-                                     places.end(),
-                                     [place](size_t i) { return i != place; }))
-                    {
-                        LOG_ERROR
-                            << "Parameter placeholders are duplicated: index="
-                            << place;
-                        LOG_ERROR << "Path pattern: " << path;
-                        exit(1);
-                    }
-                    places.push_back(place);
-                }
-                else
+                if (!std::all_of(places.begin(),
+                                 places.end(),
+                                 [placeIndex](size_t i) {
+                                     return i != placeIndex;
+                                 }))
                 {
-                    if (!std::all_of(places.begin(),
-                                     places.end(),
-                                     [placeIndex](size_t i) {
-                                         return i != placeIndex;
-                                     }))
-                    {
-                        LOG_ERROR
-                            << "Parameter placeholders are duplicated: index="
-                            << placeIndex;
-                        LOG_ERROR << "Path pattern: " << path;
-                        exit(1);
-                    }
-                    places.push_back(placeIndex);
+                    LOG_ERROR
+                        << "Parameter placeholders are duplicated: index="
+                        << placeIndex;
+                    LOG_ERROR << "Path pattern: " << path;
+                    exit(1);
                 }
+                places.push_back(placeIndex);
             }
-            ++placeIndex;
         }
-        tmpPath = results.suffix();
+        ++placeIndex;
     }
     // Process query parameter placeholders
     std::vector<std::pair<std::string, size_t>> parametersPlaces;
     if (!paras.empty())
     {
-        static const std::regex pregex("([^&]*)=\\{([^&]*)\\}&*");
-        while (std::regex_search(paras, results, pregex))
+        size_t searchPos = 0;
+        std::string_view key;
+        std::string_view result;
+        while (internal::nextQueryPlaceholder(paras, searchPos, key, result))
         {
-            if (results.size() > 2)
+            if (!result.empty() &&
+                std::all_of(result.begin(), result.end(), [](const char c) {
+                    return std::isdigit(c);
+                }))
+            {
+                auto place = (size_t)std::stoi(std::string(result));
+                if (place > binder->paramCount() || place == 0)
+                {
+                    LOG_ERROR << "Parameter placeholder(value=" << place
+                              << ") out of range (1 to "
+                              << binder->paramCount() << ")";
+                    LOG_ERROR << "Path pattern: " << path;
+                    exit(1);
+                }
+                if (!std::all_of(places.begin(),
+                                 places.end(),
+                                 [place](size_t i) {
+                                     return i != place;
+                                 }) ||
+                    !all_of(parametersPlaces.begin(),
+                            parametersPlaces.end(),
+                            [place](const std::pair<std::string, size_t>
+                                        &item) {
+                                return item.second != place;
+                            }))
+                {
+                    LOG_ERROR << "Parameter placeholders are "
+                                 "duplicated: index="
+                              << place;
+                    LOG_ERROR << "Path pattern: " << path;
+                    exit(1);
+                }
+                parametersPlaces.emplace_back(std::string(key), place);
+            }
+            else
             {
-                auto result = results[2].str();
-                if (!result.empty() &&
-                    std::all_of(result.begin(), result.end(), [](const char c) {
-                        return std::isdigit(c);
-                    }))
+                if (internal::isNumberAndName(result))
                 {
-                    auto place = (size_t)std::stoi(result);
+                    auto place = (size_t)std::stoi(std::string(result));
                     if (place > binder->paramCount() || place == 0)
                     {
                         LOG_ERROR << "Parameter placeholder(value=" << place
@@ -470,74 +525,34 @@ void HttpControllersRouter::addHttpPath(
                         LOG_ERROR << "Path pattern: " << path;
                         exit(1);
                     }
-                    parametersPlaces.emplace_back(results[1].str(), place);
+                    parametersPlaces.emplace_back(std::string(key), place);
                 }
                 else
                 {
-                    std::regex regNumberAndName("([0-9]+):.*");
-                    std::smatch regexResult;
-                    if (std::regex_match(result, regexResult, regNumberAndName))
-                    {
-                        assert(regexResult.size() == 2 &&
-                               regexResult[1].matched);
-                        auto num = regexResult[1].str();
-                        auto place = (size_t)std::stoi(num);
-                        if (place > binder->paramCount() || place == 0)
-                        {
-                            LOG_ERROR << "Parameter placeholder(value=" << place
-                                      << ") out of range (1 to "
-                                      << binder->paramCount() << ")";
-                            LOG_ERROR << "Path pattern: " << path;
-                            exit(1);
-                        }
-                        if (!std::all_of(places.begin(),
-                                         places.end(),
-                                         [place](size_t i) {
-                                             return i != place;
-                                         }) ||
-                            !all_of(parametersPlaces.begin(),
-                                    parametersPlaces.end(),
-                                    [place](const std::pair<std::string, size_t>
-                                                &item) {
-                                        return item.second != place;
-                                    }))
-                        {
-                            LOG_ERROR << "Parameter placeholders are "
-                                         "duplicated: index="
-                                      << place;
-                            LOG_ERROR << "Path pattern: " << path;
-                            exit(1);
-                        }
-                        parametersPlaces.emplace_back(results[1].str(), place);
-                    }
-                    else
+                    if (!std::all_of(places.begin(),
+                                     places.end(),
+                                     [placeIndex](size_t i) {
+                                         return i != placeIndex;
+                                     }) ||
+                        !all_of(parametersPlaces.begin(),
+                                parametersPlaces.end(),
+                                [placeIndex](
+                                    const std::pair<std::string, size_t>
+                                        &item) {
+                                    return item.second != placeIndex;
+                                }))
                     {
-                        if (!std::all_of(places.begin(),
-                                         places.end(),
-                                         [placeIndex](size_t i) {
-                                             return i != placeIndex;
-                                         }) ||
-                            !all_of(parametersPlaces.begin(),
-                                    parametersPlaces.end(),
-                                    [placeIndex](
-                                        const std::pair<std::string, size_t>
-                                            &item) {
-                                        return item.second != placeIndex;
-                                    }))
-                        {
-                            LOG_ERROR << "Parameter placeholders are "
-                                         "duplicated: index="
-                                      << placeIndex;
-                            LOG_ERROR << "Path pattern: " << path;
-                            exit(1);
-                        }
-                        parametersPlaces.emplace_back(results[1].str(),
-                                                      placeIndex);
+                        LOG_ERROR << "Parameter placeholders are "
+                                     "duplicated: index="
+                                  << placeIndex;
+                        LOG_ERROR << "Path pattern: " << path;
+                        exit(1);
                     }
+                    parametersPlaces.emplace_back(std::string(key),
+                                                  placeIndex);
                 }
-                ++placeIndex;
             }
-            paras = results.suffix();
+            ++placeIndex;
         }
     }
 
@@ -546,6 +561,8 @@ void HttpControllersRouter::addHttpPath(
     binderInfo->middlewareNames_ = middlewareNames;
     binderInfo->handlerName_ = handlerName;
     binderInfo->binderPtr_ = binder;
+    setBodyLimit(*binderInfo, binder->bodyLimit());
+    binderInfo->offload_ = binder->offload();
     binderInfo->parameterPlaces_ = std::move(places);
     binderInfo->queryParametersPlaces_ = std::move(parametersPlaces);
     drogon::app().getLoop()->queueInLoop([binderInfo]() {
@@ -554,14 +571,9 @@ void HttpControllersRouter::addHttpPath(
     });
 
     // Create or update RouterItem
-    auto pathParameterPattern =
-        std::regex_replace(originPath, regex, "([^/]*)");
-    if (originPath != pathParameterPattern)  // require regex
-    {
-        addRegexCtrlBinder(binderInfo,
-                           path,
-                           pathParameterPattern,
-                           validMethods);
+    if (placeIndex > 1)  // has placeholders
+    {
+        addTrieCtrlBinder(binderInfo, path, originPath, validMethods);
         return;
     }
 
@@ -582,7 +594,7 @@ void HttpControllersRouter::addHttpPath(
     else
     {
         struct HttpControllerRouterItem router;
-        router.pathParameterPattern_ = pathParameterPattern;
+        router.pathParameterPattern_ = originPath;
         router.pathPattern_ = path;
         routerItemPtr =
             &ctrlMap_.emplace(loweredPath, std::move(router)).first->second;
@@ -594,13 +606,8 @@ void HttpControllersRouter::addHttpPath(
 RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
 {
     // Find simple controller
-    std::string loweredPath(req->path().length(), 0);
-    std::transform(req->path().begin(),
-                   req->path().end(),
-                   loweredPath.begin(),
-                   [](unsigned char c) { return tolower(c); });
     {
-        auto it = simpleCtrlMap_.find(loweredPath);
+        auto it = simpleCtrlMap_.find(req->path());
         if (it != simpleCtrlMap_.end())
         {
             auto &ctrlInfo = it->second;
@@ -617,23 +624,36 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
     // Find http controller
     HttpControllerRouterItem *routerItemPtr = nullptr;
     std::smatch result;
-    auto it = ctrlMap_.find(loweredPath);
-    // Try to find a controller in the hash map. If can't linear search
-    // with regex.
+    // Reused across requests of this thread to avoid allocations
+    static thread_local std::vector<std::string_view> captures;
+    captures.clear();
+    auto it = ctrlMap_.find(req->path());
+    // Try to find a controller in the hash map, then in the placeholder trie.
+    // If can't, linear search with regex.
     if (it != ctrlMap_.end())
     {
         routerItemPtr = &it->second;
     }
     else
     {
-        for (auto &item : ctrlVector_)
+        auto method = req->method();
+        routerItemPtr = ctrlTrie_.match(
+            req->path(),
+            captures,
+            [method](const HttpControllerRouterItem &item) {
+                return item.binders_[method] != nullptr;
+            });
+        if (!routerItemPtr)
         {
-            const auto &ctrlRegex = item.regex_;
-            if (item.binders_[req->method()] &&
-                std::regex_match(req->path(), result, ctrlRegex))
+            for (auto &item : ctrlVector_)
             {
-                routerItemPtr = &item;
-                break;
+                const auto &ctrlRegex = item.regex_;
+                if (item.binders_[req->method()] &&
+                    std::regex_match(req->path(), result, ctrlRegex))
+                {
+                    routerItemPtr = &item;
+                    break;
+                }
             }
         }
     }
@@ -652,10 +672,7 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
         return {RouteResult::MethodNotAllowed, nullptr};
     }
     std::vector<std::string> params;
-    for (size_t j = 1; j < result.size(); ++j)
-    {
-        if (!result[j].matched)
-            continue;
+    auto setParameter = [&params, &binder](size_t j, std::string &&value) {
         size_t place = j;
         if (j <= binder->parameterPlaces_.size())
         {
@@ -663,8 +680,18 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
         }
         if (place > params.size())
             params.resize(place);
-        params[place - 1] = result[j].str();
+        params[place - 1] = std::move(value);
         LOG_TRACE << "place=" << place << " para:" << params[place - 1];
+    };
+    for (size_t j = 0; j < captures.size(); ++j)
+    {
+        setParameter(j + 1, std::string{captures[j]});
+    }
+    for (size_t j = 1; j < result.size(); ++j)
+    {
+        if (!result[j].matched)
+            continue;
+        setParameter(j, result[j].str());
     }
 
     if (!binder->queryParametersPlaces_.empty())
@@ -690,17 +717,69 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
     return {RouteResult::Success, binder};
 }
 
+void HttpControllersRouter::setBodyLimit(ControllerBinderBase &binder,
+                                         const BodyLimit &bodyLimit)
+{
+    binder.bodyLimit_ = bodyLimit;
+    if (bodyLimit.maxBodySize != 0 || bodyLimit.maxMemoryBodySize != 0)
+    {
+        hasBodyLimits_ = true;
+    }
+}
+
+BodyLimit HttpControllersRouter::bodyLimitOf(const HttpRequestImpl &req) const
+{
+    // The same lookup as route(), without touching the request whose body
+    // has not arrived yet
+    auto method = req.method();
+    if (method >= Invalid)
+        return {};
+    auto simpleIt = simpleCtrlMap_.find(req.path());
+    if (simpleIt != simpleCtrlMap_.end())
+    {
+        auto &binder = simpleIt->second.binders_[method];
+        return binder ? binder->bodyLimit_ : BodyLimit{};
+    }
+    const HttpControllerRouterItem *routerItemPtr = nullptr;
+    auto it = ctrlMap_.find(req.path());
+    if (it != ctrlMap_.end())
+    {
+        routerItemPtr = &it->second;
+    }
+    else
+    {
+        static thread_local std::vector<std::string_view> captures;
+        captures.clear();
+        routerItemPtr = ctrlTrie_.match(
+            req.path(),
+            captures,
+            [method](const HttpControllerRouterItem &item) {
+                return item.binders_[method] != nullptr;
+            });
+        if (!routerItemPtr)
+        {
+            for (auto &item : ctrlVector_)
+            {
+                if (item.binders_[method] &&
+                    std::regex_match(req.path(), item.regex_))
+                {
+                    routerItemPtr = &item;
+                    break;
+                }
+            }
+        }
+    }
+    if (!routerItemPtr || !routerItemPtr->binders_[method])
+        return {};
+    return routerItemPtr->binders_[method]->bodyLimit_;
+}
+
 RouteResult HttpControllersRouter::routeWs(const HttpRequestImplPtr &req)
 {
-    std::string wsKey = req->getHeaderBy("sec-websocket-key");
+    auto wsKey = req->getHeaderView(HttpHeaderId::kSecWebSocketKey);
     if (!wsKey.empty())
     {
-        std::string pathLower(req->path().length(), 0);
-        std::transform(req->path().begin(),
-                       req->path().end(),
-                       pathLower.begin(),
-                       [](unsigned char c) { return tolower(c); });
-        auto iter = wsCtrlMap_.find(pathLower);
+        auto iter = wsCtrlMap_.find(req->path());
         if (iter != wsCtrlMap_.end())
         {
             auto &ctrlInfo = iter->second;
@@ -750,7 +829,7 @@ void HttpControllersRouter::addRegexCtrlBinder(
     if (existRouter == ctrlVector_.end())
     {
         struct HttpControllerRouterItem router;
-        router.pathParameterPattern_ = pathParameterPattern;
+        router.pathParameterPattern_ = originPath;
         router.pathPattern_ = pathPattern;
         ctrlVector_.push_back(std::move(router));
         routerItemPtr = &ctrlVector_.back();
@@ -762,3 +841,19 @@ void HttpControllersRouter::addRegexCtrlBinder(
 
     addCtrlBinderToRouterItem(binderPtr, *routerItemPtr, methods);
 }
+
+void HttpControllersRouter::addTrieCtrlBinder(
+    const std::shared_ptr<HttpControllerBinder> &binderPtr,
+    const std::string &pathPattern,
+    const std::string &pathWithoutQuery,
+    const std::vector<HttpMethod> &methods)
+{
+    bool created{false};
+    auto &router = ctrlTrie_.insert(pathWithoutQuery, created);
+    if (created)
+    {
+        router.pathParameterPattern_ = pathWithoutQuery;
+        router.pathPattern_ = pathPattern;
+    }
+    addCtrlBinderToRouterItem(binderPtr, router, methods);
+}
@@ -16,6 +16,8 @@
 
 #include "impl_forwards.h"
 #include "ControllerBinderBase.h"
+#include "RouteTrie.h"
+#include "HttpUtils.h"
 #include <trantor/utils/NonCopyable.h>
 #include <memory>
 #include <regex>
@@ -68,12 +70,28 @@ class HttpControllersRouter : public trantor::NonCopyable
     RouteResult routeWs(const HttpRequestImplPtr &req);
     std::vector<HttpHandlerInfo> getHandlersInfo() const;
 
+    // True if any route has its own body limits
+    bool hasBodyLimits() const
+    {
+        return hasBodyLimits_;
+    }
+
+    // Find the body limits of the route of a request whose headers are
+    // parsed, before its body is received
+    BodyLimit bodyLimitOf(const HttpRequestImpl &req) const;
+
   private:
+    void setBodyLimit(ControllerBinderBase &binder, const BodyLimit &bodyLimit);
     void addRegexCtrlBinder(
         const std::shared_ptr<HttpControllerBinder> &binderPtr,
         const std::string &pathPattern,
         const std::string &pathParameterPattern,
         const std::vector<HttpMethod> &methods);
+    void addTrieCtrlBinder(
+        const std::shared_ptr<HttpControllerBinder> &binderPtr,
+        const std::string &pathPattern,
+        const std::string &pathWithoutQuery,
+        const std::vector<HttpMethod> &methods);
 
     struct SimpleControllerRouterItem
     {
@@ -100,10 +118,15 @@ class HttpControllersRouter : public trantor::NonCopyable
         std::shared_ptr<WebsocketControllerBinder> binders_[Invalid]{nullptr};
     };
 
-    std::unordered_map<std::string, SimpleControllerRouterItem> simpleCtrlMap_;
-    std::unordered_map<std::string, HttpControllerRouterItem> ctrlMap_;
+    // The exact paths, looked up by the path of a request regardless of its
+    // case
+    IgnoreCaseMap<SimpleControllerRouterItem> simpleCtrlMap_;
+    IgnoreCaseMap<HttpControllerRouterItem> ctrlMap_;
+    // for paths with parameter placeholders
+    RouteTrie<HttpControllerRouterItem> ctrlTrie_;
     std::vector<HttpControllerRouterItem> ctrlVector_;  // for regexp path
-    std::unordered_map<std::string, WebSocketControllerRouterItem> wsCtrlMap_;
+    IgnoreCaseMap<WebSocketControllerRouterItem> wsCtrlMap_;
     std::vector<RegExWebSocketControllerRouterItem> wsCtrlVector_;
+    bool hasBodyLimits_{false};
 };
 }  // namespace drogon
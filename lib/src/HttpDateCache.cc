@@ -0,0 +1,71 @@
+/**
+ *
+ *  @file HttpDateCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpDateCache.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Date.h>
+#include <assert.h>
+#include <string.h>
+
+using namespace drogon;
+
+namespace
+{
+struct LoopDate
+{
+    bool active{false};
+    int64_t second{0};
+    char date[32]{};
+};
+
+thread_local LoopDate loopDate;
+
+void update(trantor::EventLoop *loop)
+{
+    auto now = trantor::Date::now();
+    auto microSeconds = now.microSecondsSinceEpoch();
+    loopDate.second = microSeconds / trantor::Date::MICRO_SECONDS_PER_SEC;
+    memcpy(loopDate.date, utils::getHttpFullDate(now), HttpDateCache::length());
+    // 1ms after the start of the next second, in case the timer fires early
+    auto delay = static_cast<double>(trantor::Date::MICRO_SECONDS_PER_SEC -
+                                     microSeconds %
+                                         trantor::Date::MICRO_SECONDS_PER_SEC) /
+                     trantor::Date::MICRO_SECONDS_PER_SEC +
+                 0.001;
+    loop->runAfter(delay, [loop]() { update(loop); });
+}
+}  // namespace
+
+void HttpDateCache::start(trantor::EventLoop *loop)
+{
+    assert(loop->isInLoopThread());
+    if (loopDate.active)
+        return;
+    loopDate.active = true;
+    update(loop);
+}
+
+const char *HttpDateCache::date()
+{
+    if (loopDate.active)
+        return loopDate.date;
+    return utils::getHttpFullDate(trantor::Date::now());
+}
+
+int64_t HttpDateCache::second()
+{
+    if (loopDate.active)
+        return loopDate.second;
+    return trantor::Date::now().microSecondsSinceEpoch() /
+           trantor::Date::MICRO_SECONDS_PER_SEC;
+}
@@ -0,0 +1,49 @@
+/**
+ *
+ *  @file HttpDateCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace drogon
+{
+/**
+ * @brief The value of the Date header of the responses, formatted once per
+ * second by a timer of each IO loop.
+ *
+ * The timer fires just after the start of every second, so the responses
+ * rendered in a loop copy the formatted date without reading the clock. The
+ * responses rendered in the other threads get the date formatted by
+ * utils::getHttpFullDate() as before.
+ */
+class HttpDateCache
+{
+  public:
+    /// The length of the date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+    static constexpr size_t length()
+    {
+        return 29;
+    }
+
+    /// Start updating the date of the loop, called in the loop thread
+    static void start(trantor::EventLoop *loop);
+
+    /// The date for the responses rendered in the current thread
+    static const char *date();
+
+    /// The second of date(), since the epoch
+    static int64_t second();
+};
+}  // namespace drogon
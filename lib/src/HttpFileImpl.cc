@@ -14,12 +14,18 @@
 
 #include "HttpFileImpl.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpRequestImpl.h"
 #include <drogon/MultiPart.h>
 #include <drogon/utils/Utilities.h>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <filesystem>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace drogon;
 
@@ -112,6 +118,54 @@ int HttpFileImpl::saveTo(
     const std::filesystem::path &pathAndFileName) const noexcept
 {
     LOG_TRACE << "save uploaded file:" << pathAndFileName;
+#ifndef _WIN32
+    int fd = ::open(pathAndFileName.c_str(),
+                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "save failed!";
+        return -1;
+    }
+    std::string_view rest = fileContent_;
+    // A file of a body spilled to a cache file is copied by the kernel from
+    // the cache file, without faulting its mapping in
+    auto cacheFile =
+        requestPtr_
+            ? static_cast<HttpRequestImpl *>(requestPtr_.get())->cacheFile()
+            : nullptr;
+    if (cacheFile && !rest.empty())
+    {
+        auto body = cacheFile->getStringView();
+        if (rest.data() >= body.data() &&
+            rest.data() + rest.size() <= body.data() + body.size())
+        {
+            rest.remove_prefix(cacheFile->copyRangeTo(
+                static_cast<size_t>(rest.data() - body.data()),
+                rest.size(),
+                fd));
+        }
+    }
+    while (!rest.empty())
+    {
+        auto n = ::write(fd, rest.data(), rest.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            LOG_SYSERR << "save failed!";
+            ::close(fd);
+            return -1;
+        }
+        rest.remove_prefix(static_cast<size_t>(n));
+    }
+    if (::close(fd) != 0)
+    {
+        LOG_SYSERR << "save failed!";
+        return -1;
+    }
+    return 0;
+#else
     auto wPath = utils::toNativePath(pathAndFileName.native());
     std::ofstream file(wPath, std::ios::binary);
     if (file.is_open())
@@ -125,6 +179,7 @@ int HttpFileImpl::saveTo(
         LOG_ERROR << "save failed!";
         return -1;
     }
+#endif
 }
 
 std::string HttpFileImpl::getMd5() const noexcept
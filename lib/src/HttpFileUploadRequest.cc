@@ -15,6 +15,7 @@
 #include "HttpFileUploadRequest.h"
 #include <drogon/UploadFile.h>
 #include <drogon/utils/Utilities.h>
+#include <filesystem>
 
 using namespace drogon;
 
@@ -29,3 +30,60 @@ HttpFileUploadRequest::HttpFileUploadRequest(
     setContentType("multipart/form-data; boundary=" + boundary_);
     contentType_ = CT_MULTIPART_FORM_DATA;
 }
+
+std::vector<HttpRequestImpl::BodyPiece> HttpFileUploadRequest::bodyParts() const
+{
+    std::vector<BodyPiece> parts;
+    std::string content;
+    for (auto &param : getParameters())
+    {
+        content.append("--");
+        content.append(boundary_);
+        content.append("\r\n");
+        content.append("content-disposition: form-data; name=\"");
+        content.append(param.first);
+        content.append("\"\r\n\r\n");
+        content.append(param.second);
+        content.append("\r\n");
+    }
+    for (auto &file : files_)
+    {
+        content.append("--");
+        content.append(boundary_);
+        content.append("\r\n");
+        content.append("content-disposition: form-data; name=\"");
+        content.append(file.itemName());
+        content.append("\"; filename=\"");
+        content.append(file.fileName());
+        content.append("\"");
+        if (file.contentType() != CT_NONE)
+        {
+            content.append("\r\n");
+
+            auto &type = contentTypeToMime(file.contentType());
+            content.append("content-type: ");
+            content.append(type.data(), type.length());
+        }
+        content.append("\r\n\r\n");
+        std::error_code err;
+        auto size =
+            std::filesystem::file_size(utils::toNativePath(file.path()), err);
+        if (err)
+        {
+            LOG_ERROR << file.path() << " not found";
+        }
+        else if (size > 0)
+        {
+            parts.push_back({std::move(content)});
+            content.clear();
+            parts.push_back(
+                {std::string{}, file.path(), 0, static_cast<size_t>(size)});
+        }
+        content.append("\r\n");
+    }
+    content.append("--");
+    content.append(boundary_);
+    content.append("--");
+    parts.push_back({std::move(content)});
+    return parts;
+}
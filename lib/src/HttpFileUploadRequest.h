@@ -34,6 +34,12 @@ class HttpFileUploadRequest : public HttpRequestImpl
 
     explicit HttpFileUploadRequest(const std::vector<UploadFile> &files);
 
+    /**
+     * @brief The multipart body: the strings of the parameters and the part
+     * headers, and the ranges of the files which are not read into memory.
+     */
+    std::vector<BodyPiece> bodyParts() const;
+
   private:
     std::string boundary_;
     std::vector<UploadFile> files_;
@@ -0,0 +1,106 @@
+/**
+ *
+ *  @file HttpHeaderIds.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpHeaderIds.h"
+#include "HttpUtils.h"
+#include <array>
+#include <cassert>
+
+using namespace drogon;
+
+namespace
+{
+const std::string headerNames[] = {"",
+                                   "accept",
+                                   "accept-encoding",
+                                   "accept-language",
+                                   "access-control-request-headers",
+                                   "access-control-request-method",
+                                   "authorization",
+                                   "cache-control",
+                                   "connection",
+                                   "content-encoding",
+                                   "content-length",
+                                   "content-type",
+                                   "cookie",
+                                   "expect",
+                                   "host",
+                                   "http2-settings",
+                                   "if-modified-since",
+                                   "if-none-match",
+                                   "if-range",
+                                   "origin",
+                                   "range",
+                                   "referer",
+                                   "sec-websocket-extensions",
+                                   "sec-websocket-key",
+                                   "sec-websocket-protocol",
+                                   "sec-websocket-version",
+                                   "te",
+                                   "traceparent",
+                                   "transfer-encoding",
+                                   "upgrade",
+                                   "user-agent",
+                                   "x-forwarded-for",
+                                   "x-request-id"};
+static_assert(sizeof(headerNames) / sizeof(headerNames[0]) ==
+                  static_cast<size_t>(HttpHeaderId::kCount),
+              "A name for every header ID");
+
+constexpr size_t kTableSize = 64;
+
+// The names only have letters, digits and '-', which OR 0x20 maps to lower
+// case. The multipliers were searched for to place every name in its own
+// slot, adding a name may need new ones.
+inline size_t hashOf(std::string_view field)
+{
+    auto c = [&field](size_t i) {
+        return static_cast<size_t>(static_cast<unsigned char>(field[i]) |
+                                   0x20);
+    };
+    return (field.length() * 15 + c(0) + c(field.length() - 1) * 17 +
+            c(field.length() / 2) * 22) &
+           (kTableSize - 1);
+}
+
+const std::array<HttpHeaderId, kTableSize> &table()
+{
+    static const std::array<HttpHeaderId, kTableSize> slots = []() {
+        std::array<HttpHeaderId, kTableSize> t{};
+        for (size_t i = 1; i < static_cast<size_t>(HttpHeaderId::kCount); ++i)
+        {
+            auto &slot = t[hashOf(headerNames[i])];
+            assert(slot == HttpHeaderId::kUnknown);
+            slot = static_cast<HttpHeaderId>(i);
+        }
+        return t;
+    }();
+    return slots;
+}
+}  // namespace
+
+HttpHeaderId drogon::findHttpHeaderId(std::string_view field)
+{
+    if (field.empty())
+        return HttpHeaderId::kUnknown;
+    auto id = table()[hashOf(field)];
+    auto &name = headerNames[static_cast<size_t>(id)];
+    if (equalsIgnoreCase(field, name))
+        return id;
+    return HttpHeaderId::kUnknown;
+}
+
+const std::string &drogon::httpHeaderName(HttpHeaderId id)
+{
+    return headerNames[static_cast<size_t>(id)];
+}
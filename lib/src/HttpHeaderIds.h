@@ -0,0 +1,78 @@
+/**
+ *
+ *  @file HttpHeaderIds.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief The header names the framework looks up itself.
+ *
+ * Request headers with these names are indexed by their ID when they are
+ * parsed, so HttpRequestImpl::getHeaderView(HttpHeaderId) is an array
+ * lookup instead of a scan of the headers.
+ */
+enum class HttpHeaderId : uint8_t
+{
+    kUnknown = 0,
+    kAccept,
+    kAcceptEncoding,
+    kAcceptLanguage,
+    kAccessControlRequestHeaders,
+    kAccessControlRequestMethod,
+    kAuthorization,
+    kCacheControl,
+    kConnection,
+    kContentEncoding,
+    kContentLength,
+    kContentType,
+    kCookie,
+    kExpect,
+    kHost,
+    kHttp2Settings,
+    kIfModifiedSince,
+    kIfNoneMatch,
+    kIfRange,
+    kOrigin,
+    kRange,
+    kReferer,
+    kSecWebSocketExtensions,
+    kSecWebSocketKey,
+    kSecWebSocketProtocol,
+    kSecWebSocketVersion,
+    kTe,
+    kTraceparent,
+    kTransferEncoding,
+    kUpgrade,
+    kUserAgent,
+    kXForwardedFor,
+    kXRequestId,
+    kCount
+};
+
+/**
+ * @brief Find the ID of a header name, in any case.
+ *
+ * The names are placed in a table by a hash of their length and three of
+ * their characters which has no collision, so the lookup compares the name
+ * with one entry at most.
+ */
+HttpHeaderId findHttpHeaderId(std::string_view field);
+
+/// The lower case name of the header, empty for HttpHeaderId::kUnknown.
+const std::string &httpHeaderName(HttpHeaderId id);
+}  // namespace drogon
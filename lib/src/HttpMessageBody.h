@@ -26,10 +26,11 @@ class HttpMessageBody
     {
         kNone = 0,
         kString,
-        kStringView
+        kStringView,
+        kSharedString
     };
 
-    BodyType bodyType()
+    BodyType bodyType() const
     {
         return type_;
     }
@@ -106,6 +107,11 @@ class HttpMessageStringBody : public HttpMessageBody
         body_.append(buf, len);
     }
 
+    std::string &str()
+    {
+        return body_;
+    }
+
   private:
     std::string body_;
 };
@@ -142,4 +148,44 @@ class HttpMessageStringViewBody : public HttpMessageBody
     std::string_view body_;
 };
 
+/// A string shared by many messages, which is never changed
+class HttpMessageSharedStringBody : public HttpMessageBody
+{
+  public:
+    explicit HttpMessageSharedStringBody(
+        std::shared_ptr<const std::string> body)
+        : body_(std::move(body))
+    {
+        type_ = BodyType::kSharedString;
+    }
+
+    const char *data() const override
+    {
+        return body_->data();
+    }
+
+    char *data() override
+    {
+        return const_cast<char *>(body_->data());
+    }
+
+    size_t length() const override
+    {
+        return body_->length();
+    }
+
+    std::string_view getString() const override
+    {
+        return *body_;
+    }
+
+    const std::shared_ptr<const std::string> &sharedString() const
+    {
+        return body_;
+    }
+
+  private:
+    std::shared_ptr<const std::string> body_;
+};
+
 }  // namespace drogon
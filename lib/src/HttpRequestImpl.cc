@@ -14,11 +14,16 @@
 
 #include "HttpRequestImpl.h"
 #include "HttpFileUploadRequest.h"
+#include "BodyMemoryBudget.h"
+#include "DynamicETag.h"
 #include "HttpAppFrameworkImpl.h"
 
+#include <drogon/utils/MsgPack.h>
 #include <drogon/utils/Utilities.h>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -27,32 +32,78 @@
 #ifdef USE_BROTLI
 #include <brotli/decode.h>
 #endif
+#include "ZlibContext.h"
+#include "ZstdContext.h"
 
 using namespace drogon;
 
+namespace
+{
+// Call f(name, value) for every cookie of a Cookie header, in order
+template <typename F>
+void forEachCookie(std::string_view header, F &&f)
+{
+    auto trimFront = [](std::string_view str) {
+        size_t pos = 0;
+        while (pos < str.length() &&
+               isspace(static_cast<unsigned char>(str[pos])))
+            ++pos;
+        return str.substr(pos);
+    };
+    while (!header.empty())
+    {
+        auto pos = header.find(';');
+        auto cookie = header.substr(0, pos);
+        header = pos == std::string_view::npos ? std::string_view{}
+                                               : header.substr(pos + 1);
+        auto epos = cookie.find('=');
+        if (epos == std::string_view::npos)
+            continue;
+        f(trimFront(cookie.substr(0, epos)),
+          trimFront(cookie.substr(epos + 1)));
+    }
+}
+}  // namespace
+
+bool HttpRequestImpl::isJsonBody() const
+{
+    return contentType_ == CT_APPLICATION_JSON ||
+           getHeaderView(HttpHeaderId::kContentType).find("application/json") !=
+               std::string::npos;
+}
+
+std::optional<Json::Value> HttpRequestImpl::getJsonAt(
+    std::string_view pointer) const
+{
+    if (flagForParsingJson_)
+    {
+        // The document is already built
+        if (!jsonPtr_)
+            return std::nullopt;
+        auto value = JsonBackend::resolve(*jsonPtr_, pointer);
+        if (!value)
+            return std::nullopt;
+        return *value;
+    }
+    auto input = contentView();
+    if (input.empty() || !isJsonBody())
+        return std::nullopt;
+    Json::Value value;
+    if (!app().getJsonBackend()->parseAt(input, pointer, value))
+        return std::nullopt;
+    return value;
+}
+
 void HttpRequestImpl::parseJson() const
 {
     auto input = contentView();
     if (input.empty())
         return;
-    if (contentType_ == CT_APPLICATION_JSON ||
-        getHeaderBy("content-type").find("application/json") !=
-            std::string::npos)
-    {
-        static std::once_flag once;
-        static Json::CharReaderBuilder builder;
-        std::call_once(once, []() {
-            builder["collectComments"] = false;
-            builder["stackLimit"] = static_cast<Json::UInt>(
-                drogon::app().getJsonParserStackLimit());
-        });
+    if (isJsonBody())
+    {
         jsonPtr_ = std::make_shared<Json::Value>();
-        JSONCPP_STRING errs;
-        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-        if (!reader->parse(input.data(),
-                           input.data() + input.size(),
-                           jsonPtr_.get(),
-                           &errs))
+        std::string errs;
+        if (!app().getJsonBackend()->parse(input, *jsonPtr_, errs))
         {
             LOG_DEBUG << errs;
             jsonPtr_.reset();
@@ -74,123 +125,122 @@ void HttpRequestImpl::parseJson() const
 
 void HttpRequestImpl::parseParameters() const
 {
-    auto input = queryView();
-    if (!input.empty())
-    {
-        std::string_view::size_type pos = 0;
-        while ((input[pos] == '?' ||
-                isspace(static_cast<unsigned char>(input[pos]))) &&
-               pos < input.length())
-        {
-            ++pos;
-        }
-        auto value = input.substr(pos);
-        while ((pos = value.find('&')) != std::string_view::npos)
-        {
-            auto coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-            value.remove_prefix(pos + 1);
-        }
-        if (value.length() > 0)
-        {
-            auto &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-        }
-    }
+    parseUrlEncoded(queryView());
 
-    input = contentView();
+    auto input = contentView();
     if (input.empty())
         return;
-    std::string type = getHeaderBy("content-type");
-    std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) {
-        return tolower(c);
-    });
+    auto type = getHeaderView(HttpHeaderId::kContentType);
+    static constexpr std::string_view formType{
+        "application/x-www-form-urlencoded"};
     if (type.empty() ||
-        type.find("application/x-www-form-urlencoded") != std::string::npos)
+        std::search(type.begin(),
+                    type.end(),
+                    formType.begin(),
+                    formType.end(),
+                    [](char a, char b) {
+                        return tolower(static_cast<unsigned char>(a)) == b;
+                    }) != type.end())
     {
-        std::string_view::size_type pos = 0;
-        while ((input[pos] == '?' ||
-                isspace(static_cast<unsigned char>(input[pos]))) &&
-               pos < input.length())
-        {
-            ++pos;
-        }
-        auto value = input.substr(pos);
-        while ((pos = value.find('&')) != std::string_view::npos)
-        {
-            auto coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
-            value.remove_prefix(pos + 1);
-        }
-        if (value.length() > 0)
+        parseUrlEncoded(input);
+    }
+}
+
+void HttpRequestImpl::parseUrlEncoded(std::string_view input) const
+{
+    std::string_view::size_type pos = 0;
+    while (pos < input.length() &&
+           (input[pos] == '?' ||
+            isspace(static_cast<unsigned char>(input[pos]))))
+    {
+        ++pos;
+    }
+    input.remove_prefix(pos);
+    if (input.empty())
+        return;
+    // The keys and values are decoded into a buffer kept by the request, so
+    // the only strings built are the ones stored in the map. A pair never
+    // decodes to more than its length.
+    if (parametersBuffer_.size() < input.length())
+        parametersBuffer_.resize(input.length());
+    char *buffer = &parametersBuffer_[0];
+    auto addParameter = [this, buffer](std::string_view pair) {
+        auto epos = pair.find('=');
+        if (epos == std::string_view::npos)
         {
-            auto &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string_view::npos)
-            {
-                auto key = coo.substr(0, epos);
-                std::string_view::size_type cpos = 0;
-                while (cpos < key.length() &&
-                       isspace(static_cast<unsigned char>(key[cpos])))
-                    ++cpos;
-                key.remove_prefix(cpos);
-                auto pvalue = coo.substr(epos + 1);
-                parameters_[utils::urlDecode(key)] = utils::urlDecode(pvalue);
-            }
-            else
-            {
-                parameters_[utils::urlDecode(coo)];
-            }
+            auto len = utils::urlDecode(pair.data(),
+                                        pair.data() + pair.size(),
+                                        buffer);
+            nodeCache_.emplace(parameters_, std::string_view(buffer, len), {});
+            return;
         }
+        auto key = pair.substr(0, epos);
+        std::string_view::size_type cpos = 0;
+        while (cpos < key.length() &&
+               isspace(static_cast<unsigned char>(key[cpos])))
+            ++cpos;
+        key.remove_prefix(cpos);
+        auto value = pair.substr(epos + 1);
+        auto keyLen =
+            utils::urlDecode(key.data(), key.data() + key.size(), buffer);
+        auto valueLen = utils::urlDecode(value.data(),
+                                         value.data() + value.size(),
+                                         buffer + keyLen);
+        nodeCache_.assign(parameters_,
+                          std::string_view(buffer, keyLen),
+                          std::string_view(buffer + keyLen, valueLen));
+    };
+    while ((pos = input.find('&')) != std::string_view::npos)
+    {
+        addParameter(input.substr(0, pos));
+        input.remove_prefix(pos + 1);
     }
+    if (!input.empty())
+        addParameter(input);
 }
 
-void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
+static void appendFileRange(trantor::MsgBuffer *output,
+                            const HttpRequestImpl::BodyPiece &piece)
+{
+    std::ifstream infile(utils::toNativePath(piece.path),
+                         std::ifstream::binary);
+    if (infile)
+        infile.seekg(static_cast<std::streamoff>(piece.offset));
+    output->ensureWritableBytes(piece.length);
+    if (infile)
+    {
+        infile.read(output->beginWrite(),
+                    static_cast<std::streamsize>(piece.length));
+        output->hasWritten(static_cast<size_t>(infile.gcount()));
+    }
+    if (!infile)
+    {
+        LOG_ERROR << "Failed to read " << piece.path;
+    }
+}
+
+bool HttpRequestImpl::setBodyFile(const std::string &path,
+                                  size_t offset,
+                                  size_t length)
+{
+    std::error_code err;
+    auto size = std::filesystem::file_size(utils::toNativePath(path), err);
+    if (err || offset > size || length > size - offset)
+    {
+        LOG_ERROR << "Can't send " << path << " as the body of the request";
+        return false;
+    }
+    content_.clear();
+    clearBodySources();
+    bodyFile_.path = path;
+    bodyFile_.offset = offset;
+    bodyFile_.length =
+        length > 0 ? length : static_cast<size_t>(size) - offset;
+    return true;
+}
+
+void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output,
+                                     std::vector<BodyPiece> *bodyPieces)
 {
     switch (method_)
     {
@@ -288,76 +338,62 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
     }
     output->append("\r\n");
 
+    // The pieces of the body after content_, which may be stored in files
+    std::vector<BodyPiece> pieces;
     if (!passThrough_ && contentType_ == CT_MULTIPART_FORM_DATA)
     {
         auto mReq = dynamic_cast<const HttpFileUploadRequest *>(this);
         if (mReq)
+            pieces = mReq->bodyParts();
+    }
+    // The body received from a client may be stored in a temporary file,
+    // e.g. when a request is forwarded
+    if (cacheFilePtr_ && cacheFilePtr_->length() > 0)
+    {
+        cacheFilePtr_->flush();
+        pieces.push_back(
+            {std::string{}, cacheFilePtr_->path(), 0, cacheFilePtr_->length()});
+    }
+    if (!bodyFile_.path.empty())
+        pieces.push_back(bodyFile_);
+    if (bodyGenerator_ && !bodyPieces)
+    {
+        // Rendered as a whole, e.g. into the frames of HTTP/2
+        BodyPiece generated;
+        std::string buffer(16 * 1024, '\0');
+        while (auto n = bodyGenerator_(buffer.data(), buffer.size()))
         {
-            for (auto &param : mReq->getParameters())
-            {
-                content.append("--");
-                content.append(mReq->boundary());
-                content.append("\r\n");
-                content.append("content-disposition: form-data; name=\"");
-                content.append(param.first);
-                content.append("\"\r\n\r\n");
-                content.append(param.second);
-                content.append("\r\n");
-            }
-            for (auto &file : mReq->files())
-            {
-                content.append("--");
-                content.append(mReq->boundary());
-                content.append("\r\n");
-                content.append("content-disposition: form-data; name=\"");
-                content.append(file.itemName());
-                content.append("\"; filename=\"");
-                content.append(file.fileName());
-                content.append("\"");
-                if (file.contentType() != CT_NONE)
-                {
-                    content.append("\r\n");
-
-                    auto &type = contentTypeToMime(file.contentType());
-                    content.append("content-type: ");
-                    content.append(type.data(), type.length());
-                }
-                content.append("\r\n\r\n");
-                std::ifstream infile(utils::toNativePath(file.path()),
-                                     std::ifstream::binary);
-                if (!infile)
-                {
-                    LOG_ERROR << file.path() << " not found";
-                }
-                else
-                {
-                    std::streambuf *pbuf = infile.rdbuf();
-                    std::streamsize filesize = pbuf->pubseekoff(0, infile.end);
-                    pbuf->pubseekoff(0, infile.beg);  // rewind
-                    std::string str;
-                    str.resize(filesize);
-                    pbuf->sgetn(&str[0], filesize);
-                    content.append(std::move(str));
-                }
-                content.append("\r\n");
-            }
-            content.append("--");
-            content.append(mReq->boundary());
-            content.append("--");
+            generated.data.append(buffer.data(), n);
         }
+        clearBodySources();
+        pieces.push_back(std::move(generated));
+    }
+    size_t piecesLength = 0;
+    for (auto &piece : pieces)
+    {
+        piecesLength += piece.path.empty() ? piece.data.length() : piece.length;
     }
     assert(!(!content.empty() && !content_.empty()));
     if (!passThrough_)
     {
-        if (!content.empty() || !content_.empty())
+        if (!content.empty() || !content_.empty() || !pieces.empty() ||
+            bodyGenerator_)
         {
-            char buf[64];
-            auto len = snprintf(
-                buf,
-                sizeof(buf),
-                contentLengthFormatString<decltype(content.length())>(),
-                content.length() + content_.length());
-            output->append(buf, len);
+            if (bodyGenerator_ && !generatedBodyLength_)
+            {
+                output->append("transfer-encoding: chunked\r\n");
+            }
+            else
+            {
+                char buf[64];
+                auto len = snprintf(
+                    buf,
+                    sizeof(buf),
+                    contentLengthFormatString<decltype(content.length())>(),
+                    content.length() + content_.length() + piecesLength +
+                        generatedBodyLength_.value_or(0));
+                output->append(buf, len);
+            }
             if (contentTypeString_.empty())
             {
                 auto &type = contentTypeToMime(contentType_);
@@ -378,6 +414,7 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
             output->append("\r\n");
         }
     }
+    materializeHeaders();
     for (auto it = headers_.begin(); it != headers_.end(); ++it)
     {
         output->append(it->first);
@@ -385,6 +422,7 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
         output->append(it->second);
         output->append("\r\n");
     }
+    materializeCookies();
     if (cookies_.size() > 0)
     {
         output->append("cookie: ");
@@ -404,110 +442,179 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
         output->append(content);
     if (!content_.empty())
         output->append(content_);
+    if (bodyPieces)
+    {
+        *bodyPieces = std::move(pieces);
+        return;
+    }
+    for (auto &piece : pieces)
+    {
+        if (piece.path.empty())
+            output->append(piece.data);
+        else
+            appendFileRange(output, piece);
+    }
+}
+
+bool HttpRequestImpl::bodyChunks(
+    const std::function<bool(std::string_view)> &callback,
+    size_t chunkSize) const
+{
+    if (isStreamMode())
+        return true;
+    if (chunkSize == 0)
+        chunkSize = 1024 * 1024;
+    if (cacheFilePtr_)
+        return cacheFilePtr_->readChunks(chunkSize, callback);
+    std::string_view body = content_;
+    while (!body.empty())
+    {
+        auto n = (std::min)(chunkSize, body.length());
+        if (!callback(body.substr(0, n)))
+            return false;
+        body.remove_prefix(n);
+    }
+    return true;
 }
 
 void HttpRequestImpl::addHeader(const char *start,
                                 const char *colon,
                                 const char *end)
 {
-    std::string field(start, colon);
-    // Field name is case-insensitive.so we transform it to lower;(rfc2616-4.2)
-    std::transform(field.begin(),
-                   field.end(),
-                   field.begin(),
-                   [](unsigned char c) { return tolower(c); });
+    std::string_view field(start, colon - start);
     ++colon;
     while (colon < end && isspace(static_cast<unsigned char>(*colon)))
     {
         ++colon;
     }
-    std::string value(colon, end);
-    while (!value.empty() &&
-           isspace(static_cast<unsigned char>(value[value.size() - 1])))
+    while (end > colon && isspace(static_cast<unsigned char>(*(end - 1))))
     {
-        value.resize(value.size() - 1);
+        --end;
     }
-    if (field.length() == 6 && field == "cookie")
+    std::string_view value(colon, end - colon);
+    // Field name is case-insensitive.(rfc2616-4.2)
+    auto id = findHttpHeaderId(field);
+    if (id == HttpHeaderId::kCookie)
     {
         LOG_TRACE << "cookies!!!:" << value;
-        std::string::size_type pos;
-        while ((pos = value.find(';')) != std::string::npos)
-        {
-            std::string coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string::npos)
-            {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(static_cast<unsigned char>(cookie_name[cpos])))
-                    ++cpos;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                cpos = 0;
-                while (cpos < cookie_value.length() &&
-                       isspace(static_cast<unsigned char>(cookie_value[cpos])))
-                    ++cpos;
-                cookie_value = cookie_value.substr(cpos);
-                cookies_[std::move(cookie_name)] = std::move(cookie_value);
-            }
-            value = value.substr(pos + 1);
-        }
-        if (value.length() > 0)
+        // Parsed when a cookie is read, the requests carry cookies the
+        // server never reads
+        if (cookiesState_.load(std::memory_order_relaxed) == kLazyBuilt)
         {
-            std::string &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string::npos)
-            {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(static_cast<unsigned char>(cookie_name[cpos])))
-                    ++cpos;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                cpos = 0;
-                while (cpos < cookie_value.length() &&
-                       isspace(static_cast<unsigned char>(cookie_value[cpos])))
-                    ++cpos;
-                cookie_value = cookie_value.substr(cpos);
-                cookies_[std::move(cookie_name)] = std::move(cookie_value);
-            }
+            forEachCookie(value,
+                          [this](std::string_view name, std::string_view val) {
+                              nodeCache_.assign(cookies_, name, val);
+                          });
+            return;
         }
+        if (!rawCookies_.empty())
+            rawCookies_.append(1, ';');
+        rawCookies_.append(value);
+        return;
     }
-    else
+    switch (id)
     {
-        switch (field.length())
-        {
-            case 6:
-                if (field == "expect")
-                {
-                    expectPtr_ = std::make_unique<std::string>(value);
-                }
-                break;
-            case 10:
+        case HttpHeaderId::kExpect:
+            expectPtr_ = std::make_unique<std::string>(value);
+            break;
+        case HttpHeaderId::kConnection:
+            if (version_ == Version::kHttp11)
             {
-                if (field == "connection")
-                {
-                    if (version_ == Version::kHttp11)
-                    {
-                        if (value.length() == 5 && value == "close")
-                            keepAlive_ = false;
-                    }
-                    else if (value.length() == 10 &&
-                             (value == "Keep-Alive" || value == "keep-alive"))
-                    {
-                        keepAlive_ = true;
-                    }
-                }
+                if (value.length() == 5 && value == "close")
+                    keepAlive_ = false;
+            }
+            else if (value.length() == 10 &&
+                     (value == "Keep-Alive" || value == "keep-alive"))
+            {
+                keepAlive_ = true;
             }
             break;
+        default:
+            break;
+    }
+    if (headersState_.load(std::memory_order_relaxed) == kLazyBuilt)
+    {
+        // The header map is already in use
+        nodeCache_.emplace(headers_, field, value, true);
+        return;
+    }
+    RawHeaderSlice slice;
+    slice.fieldOffset = static_cast<uint32_t>(rawHeaders_.length());
+    slice.fieldLength = static_cast<uint32_t>(field.length());
+    rawHeaders_.append(field);
+    slice.valueOffset = static_cast<uint32_t>(rawHeaders_.length());
+    slice.valueLength = static_cast<uint32_t>(value.length());
+    rawHeaders_.append(value);
+    rawHeaderSlices_.push_back(slice);
+    // The first header with the name is the one returned by the lookups
+    auto &knownSlot = knownHeaderSlots_[static_cast<size_t>(id)];
+    if (id != HttpHeaderId::kUnknown && knownSlot == 0)
+        knownSlot = static_cast<uint32_t>(rawHeaderSlices_.size());
+}
 
-            default:
-                break;
-        }
-        headers_.emplace(std::move(field), std::move(value));
+bool HttpRequestImpl::lockLazyMap(std::atomic<uint8_t> &state)
+{
+    uint8_t expected = kLazyRaw;
+    if (state.compare_exchange_strong(expected,
+                                      kLazyBuilding,
+                                      std::memory_order_acquire))
+        return true;
+    // Another thread builds the map
+    while (state.load(std::memory_order_acquire) != kLazyBuilt)
+        std::this_thread::yield();
+    return false;
+}
+
+void HttpRequestImpl::parseCookies() const
+{
+    if (!lockLazyMap(cookiesState_))
+        return;
+    forEachCookie(rawCookies_,
+                  [this](std::string_view name, std::string_view value) {
+                      nodeCache_.assign(cookies_, name, value);
+                  });
+    cookiesState_.store(kLazyBuilt, std::memory_order_release);
+}
+
+std::string_view HttpRequestImpl::getCookieView(std::string_view name) const
+{
+    if (cookiesState_.load(std::memory_order_acquire) == kLazyBuilt)
+    {
+        auto it = cookies_.find(std::string(name));
+        if (it != cookies_.end())
+            return it->second;
+        return {};
     }
+    // The last one, as in the cookie map
+    std::string_view found;
+    forEachCookie(rawCookies_,
+                  [name, &found](std::string_view n, std::string_view value) {
+                      if (n == name)
+                          found = value;
+                  });
+    return found;
+}
+
+void HttpRequestImpl::buildHeaderMap() const
+{
+    if (!lockLazyMap(headersState_))
+        return;
+    for (auto &slice : rawHeaderSlices_)
+    {
+        nodeCache_.emplace(
+            headers_,
+            std::string_view(rawHeaders_.data() + slice.fieldOffset,
+                             slice.fieldLength),
+            std::string_view(rawHeaders_.data() + slice.valueOffset,
+                             slice.valueLength),
+            true);
+    }
+    headersState_.store(kLazyBuilt, std::memory_order_release);
+}
+
+bool HttpRequest::isNotModified(const std::string &etag) const
+{
+    return dynamic_etag::matches(getHeader("if-none-match"), etag);
 }
 
 HttpRequestPtr HttpRequest::newHttpRequest()
@@ -518,6 +625,24 @@ HttpRequestPtr HttpRequest::newHttpRequest()
     return req;
 }
 
+HttpRequestPtr HttpRequest::newSubrequest(const HttpRequestPtr &parent)
+{
+    auto parentImpl = static_cast<HttpRequestImpl *>(parent.get());
+    auto req = std::make_shared<HttpRequestImpl>(parentImpl->getLoop());
+    req->setMethod(drogon::Get);
+    req->setVersion(parentImpl->version());
+    req->setPeerAddr(parentImpl->peerAddr());
+    req->setLocalAddr(parentImpl->localAddr());
+    req->setSecure(parentImpl->isOnSecureConnection());
+    req->setSession(parentImpl->session());
+    req->setTraceContext(parentImpl->traceContext());
+    if (parentImpl->deadline())
+    {
+        req->setDeadline(*parentImpl->deadline());
+    }
+    return req;
+}
+
 HttpRequestPtr HttpRequest::newHttpFormPostRequest()
 {
     auto req = std::make_shared<HttpRequestImpl>(nullptr);
@@ -530,31 +655,40 @@ HttpRequestPtr HttpRequest::newHttpFormPostRequest()
 
 HttpRequestPtr HttpRequest::newHttpJsonRequest(const Json::Value &data)
 {
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-        if (!app().isUnicodeEscapingUsedInJson())
-        {
-            builder["emitUTF8"] = true;
-        }
-        auto &precision = app().getFloatPrecisionInJson();
-        if (precision.first != 0)
-        {
-            builder["precision"] = precision.first;
-            builder["precisionType"] = precision.second;
-        }
-    });
     auto req = std::make_shared<HttpRequestImpl>(nullptr);
     req->setMethod(drogon::Get);
     req->setVersion(drogon::Version::kHttp11);
     req->contentType_ = CT_APPLICATION_JSON;
-    req->setContent(writeString(builder, data));
+    req->setContent(app().getJsonBackend()->write(data));
     req->flagForParsingContentType_ = true;
     return req;
 }
 
+HttpRequestPtr HttpRequest::newHttpMsgPackRequest(const Json::Value &data)
+{
+    auto req = std::make_shared<HttpRequestImpl>(nullptr);
+    req->setMethod(drogon::Get);
+    req->setVersion(drogon::Version::kHttp11);
+    req->setContentTypeCode(CT_APPLICATION_MSGPACK);
+    req->addHeader("accept", "application/msgpack");
+    req->setContent(utils::toMsgPack(data));
+    return req;
+}
+
+std::shared_ptr<Json::Value> HttpRequest::getMsgPackObject(
+    std::string *errs) const
+{
+    auto root = std::make_shared<Json::Value>();
+    std::string errors;
+    if (!utils::fromMsgPack(getBody(), *root, errors))
+    {
+        if (errs)
+            *errs = std::move(errors);
+        return nullptr;
+    }
+    return root;
+}
+
 HttpRequestPtr HttpRequest::newFileUploadRequest(
     const std::vector<UploadFile> &files)
 {
@@ -574,7 +708,19 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(pathEncode_, that.pathEncode_);
     swap(query_, that.query_);
     swap(headers_, that.headers_);
+    swap(rawHeaders_, that.rawHeaders_);
+    swap(rawHeaderSlices_, that.rawHeaderSlices_);
+    swap(knownHeaderSlots_, that.knownHeaderSlots_);
+    auto headersState = headersState_.load(std::memory_order_relaxed);
+    headersState_.store(that.headersState_.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+    that.headersState_.store(headersState, std::memory_order_relaxed);
     swap(cookies_, that.cookies_);
+    swap(rawCookies_, that.rawCookies_);
+    auto cookiesState = cookiesState_.load(std::memory_order_relaxed);
+    cookiesState_.store(that.cookiesState_.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+    that.cookiesState_.store(cookiesState, std::memory_order_relaxed);
     swap(contentLengthHeaderValue_, that.contentLengthHeaderValue_);
     swap(realContentLength_, that.realContentLength_);
     swap(parameters_, that.parameters_);
@@ -582,9 +728,19 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(sessionPtr_, that.sessionPtr_);
     swap(attributesPtr_, that.attributesPtr_);
     swap(cacheFilePtr_, that.cacheFilePtr_);
+    swap(bodyFile_, that.bodyFile_);
+    swap(bodyGenerator_, that.bodyGenerator_);
+    swap(generatedBodyLength_, that.generatedBodyLength_);
+    swap(bodyLimit_, that.bodyLimit_);
+    swap(bodyMemory_, that.bodyMemory_);
     swap(peer_, that.peer_);
     swap(local_, that.local_);
     swap(creationDate_, that.creationDate_);
+    swap(handlingDate_, that.handlingDate_);
+    swap(phases_, that.phases_);
+    swap(traceContext_, that.traceContext_);
+    swap(span_, that.span_);
+    swap(deadline_, that.deadline_);
     swap(content_, that.content_);
     swap(expectPtr_, that.expectPtr_);
     swap(contentType_, that.contentType_);
@@ -601,6 +757,26 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(streamExceptionPtr_, that.streamExceptionPtr_);
     swap(startProcessing_, that.startProcessing_);
     swap(connPtr_, that.connPtr_);
+    swap(earlyHintsSender_, that.earlyHintsSender_);
+}
+
+void HttpRequestImpl::sendEarlyHints(const std::vector<std::string> &links)
+{
+    if (!earlyHintsSender_ || links.empty() || version_ == Version::kHttp10)
+        return;
+    std::string hints = "HTTP/1.1 103 Early Hints\r\n";
+    auto statusLength = hints.length();
+    for (auto &link : links)
+    {
+        // A value that would split the header is dropped
+        if (link.empty() || link.find_first_of("\r\n") != std::string::npos)
+            continue;
+        hints.append("Link: ").append(link).append("\r\n");
+    }
+    if (hints.length() == statusLength)
+        return;
+    hints.append("\r\n");
+    earlyHintsSender_(std::move(hints));
 }
 
 const char *HttpRequestImpl::versionString() const
@@ -616,6 +792,14 @@ const char *HttpRequestImpl::versionString() const
             result = "HTTP/1.1";
             break;
 
+        case Version::kHttp2:
+            result = "HTTP/2";
+            break;
+
+        case Version::kHttp3:
+            result = "HTTP/3";
+            break;
+
         default:
             break;
     }
@@ -736,24 +920,62 @@ bool HttpRequestImpl::setMethod(const char *start, const char *end)
 
 HttpRequestImpl::~HttpRequestImpl()
 {
+    clearBodySources();
+    releaseBodyMemory();
+    abandonSpan();
+}
+
+size_t HttpRequestImpl::maxBodySize() const
+{
+    return bodyLimit_.maxBodySize != 0
+               ? bodyLimit_.maxBodySize
+               : HttpAppFrameworkImpl::instance().getClientMaxBodySize();
+}
+
+size_t HttpRequestImpl::maxMemoryBodySize() const
+{
+    return bodyLimit_.maxMemoryBodySize != 0
+               ? bodyLimit_.maxMemoryBodySize
+               : HttpAppFrameworkImpl::instance().getClientMaxMemoryBodySize();
+}
+
+bool HttpRequestImpl::acquireBodyMemory(size_t bodyLength)
+{
+    if (bodyLength <= bodyMemory_)
+        return true;
+    if (!BodyMemoryBudget::instance().tryAcquire(bodyLength - bodyMemory_))
+        return false;
+    bodyMemory_ = bodyLength;
+    return true;
 }
 
-void HttpRequestImpl::reserveBodySize(size_t length)
+void HttpRequestImpl::releaseBodyMemory()
+{
+    BodyMemoryBudget::instance().release(bodyMemory_);
+    bodyMemory_ = 0;
+}
+
+bool HttpRequestImpl::reserveBodySize(size_t length)
 {
     assert(loop_->isInLoopThread());
     if (cacheFilePtr_)
     {
-        return;
+        return true;
     }
-    if (length <= HttpAppFrameworkImpl::instance().getClientMaxMemoryBodySize())
+    // A body larger than the whole budget could never get it
+    if (length <= maxMemoryBodySize() &&
+        length <= BodyMemoryBudget::instance().budget())
     {
+        if (!acquireBodyMemory(length))
+            return false;
         content_.reserve(length);
     }
     else
     {
         // Store data of body to a temporary file
-        createTmpFile();
+        moveBodyToTmpFile();
     }
+    return true;
 }
 
 void HttpRequestImpl::appendToBody(const char *data, size_t length)
@@ -771,21 +993,33 @@ void HttpRequestImpl::appendToBody(const char *data, size_t length)
     }
     else
     {
-        if (content_.length() + length <=
-            HttpAppFrameworkImpl::instance().getClientMaxMemoryBodySize())
+        // A body growing without a content-length moves to a temporary file
+        // when the budget is used up, as it can't wait halfway
+        auto bodyLength = content_.length() + length;
+        if (bodyLength <= maxMemoryBodySize() && acquireBodyMemory(bodyLength))
         {
             content_.append(data, length);
         }
         else
         {
-            createTmpFile();
-            cacheFilePtr_->append(content_);
+            moveBodyToTmpFile();
             cacheFilePtr_->append(data, length);
-            content_.clear();
         }
     }
 }
 
+void HttpRequestImpl::moveBodyToTmpFile()
+{
+    createTmpFile();
+    if (!content_.empty())
+    {
+        cacheFilePtr_->append(content_);
+        content_.clear();
+        content_.shrink_to_fit();
+    }
+    releaseBodyMemory();
+}
+
 void HttpRequestImpl::createTmpFile()
 {
     auto tmpfile = HttpAppFrameworkImpl::instance().getUploadPath();
@@ -812,8 +1046,12 @@ void HttpRequestImpl::setContentTypeString(const char *typeString,
 
 StreamDecompressStatus HttpRequestImpl::decompressBody()
 {
-    auto &contentEncoding = getHeaderBy("content-encoding");
-    if (contentEncoding.empty() || contentEncoding == "identity")
+    auto contentEncoding = getHeaderView(HttpHeaderId::kContentEncoding);
+    if (contentEncoding.empty())
+    {
+        return StreamDecompressStatus::Ok;
+    }
+    if (contentEncoding == "identity")
     {
         removeHeaderBy("content-encoding");
         return StreamDecompressStatus::Ok;
@@ -824,6 +1062,13 @@ StreamDecompressStatus HttpRequestImpl::decompressBody()
         removeHeaderBy("content-encoding");
         return decompressBodyBrotli();
     }
+#endif
+#ifdef USE_ZSTD
+    else if (contentEncoding == "zstd")
+    {
+        removeHeaderBy("content-encoding");
+        return decompressBodyZstd();
+    }
 #endif
     else if (contentEncoding == "gzip")
     {
@@ -853,10 +1098,8 @@ StreamDecompressStatus HttpRequestImpl::decompressBodyBrotli() noexcept
     }
 
     setBody("");
-    const size_t maxBodySize =
-        HttpAppFrameworkImpl::instance().getClientMaxBodySize();
-    const size_t maxMemorySize =
-        HttpAppFrameworkImpl::instance().getClientMaxMemoryBodySize();
+    const size_t maxBodySize = this->maxBodySize();
+    const size_t maxMemorySize = maxMemoryBodySize();
 
     size_t availableIn = compressed.size();
     auto nextIn = (const uint8_t *)(compressed.data());
@@ -906,6 +1149,64 @@ StreamDecompressStatus HttpRequestImpl::decompressBodyBrotli() noexcept
 }
 #endif
 
+#ifdef USE_ZSTD
+StreamDecompressStatus HttpRequestImpl::decompressBodyZstd() noexcept
+{
+    std::unique_ptr<CacheFile> cacheFileHolder;
+    std::string contentHolder;
+    std::string_view compressed;
+    if (cacheFilePtr_)
+    {
+        cacheFileHolder = std::move(cacheFilePtr_);
+        compressed = cacheFileHolder->getStringView();
+    }
+    else
+    {
+        contentHolder = std::move(content_);
+        compressed = contentHolder;
+    }
+
+    setBody("");
+    auto dctx = drogon::internal::getZstdDecompressContext(
+        HttpAppFrameworkImpl::instance().getZstdDictionary());
+    if (!dctx)
+        return StreamDecompressStatus::DecompressError;
+    const size_t maxBodySize = this->maxBodySize();
+    // The output is appended to the body piece by piece, the body moves to a
+    // temporary file once it is larger than the client_max_memory_body_size.
+    auto decompressed = std::string(ZSTD_DStreamOutSize(), 0);
+    ZSTD_inBuffer input{compressed.data(), compressed.size(), 0};
+    size_t totalOut{0};
+    size_t ret{0};
+    while (true)
+    {
+        ZSTD_outBuffer output{decompressed.data(), decompressed.size(), 0};
+        ret = ZSTD_decompressStream(dctx, &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            setBody("");
+            return StreamDecompressStatus::DecompressError;
+        }
+        totalOut += output.pos;
+        if (totalOut > maxBodySize)
+        {
+            setBody("");
+            return StreamDecompressStatus::TooLarge;
+        }
+        appendToBody(decompressed.data(), output.pos);
+        if (input.pos == input.size && output.pos < output.size)
+            break;
+    }
+    if (ret != 0)
+    {
+        // The last frame is truncated
+        setBody("");
+        return StreamDecompressStatus::DecompressError;
+    }
+    return StreamDecompressStatus::Ok;
+}
+#endif
+
 StreamDecompressStatus HttpRequestImpl::decompressBodyGzip() noexcept
 {
     // Workaround for Windows min and max are macros
@@ -924,39 +1225,22 @@ StreamDecompressStatus HttpRequestImpl::decompressBodyGzip() noexcept
         compressed = contentHolder;
     }
 
-    z_stream strm = {nullptr,
-                     0,
-                     0,
-                     nullptr,
-                     0,
-                     0,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     0,
-                     0,
-                     0};
+    auto strmPtr = internal::getGzipDecompressStream();
+    if (!strmPtr)
+    {
+        return StreamDecompressStatus::DecompressError;
+    }
+    auto &strm = *strmPtr;
     strm.next_in = (Bytef *)compressed.data();
     strm.avail_in = static_cast<uInt>(compressed.size());
-    strm.total_out = 0;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
     setBody("");
-    const size_t maxBodySize =
-        HttpAppFrameworkImpl::instance().getClientMaxBodySize();
-    const size_t maxMemorySize =
-        HttpAppFrameworkImpl::instance().getClientMaxMemoryBodySize();
+    const size_t maxBodySize = this->maxBodySize();
+    const size_t maxMemorySize = maxMemoryBodySize();
     auto decompressed =
         std::string(minVal(compressed.size() * 2, maxMemorySize), 0);
     strm.next_out = (Bytef *)decompressed.data();
     strm.avail_out = static_cast<uInt>(decompressed.size());
     size_t lastOut = 0;
-    if (inflateInit2(&strm, (15 + 32)) != Z_OK)
-    {
-        return StreamDecompressStatus::DecompressError;
-    }
 
     StreamDecompressStatus status = StreamDecompressStatus::Ok;
     while (true)
@@ -994,13 +1278,6 @@ StreamDecompressStatus HttpRequestImpl::decompressBodyGzip() noexcept
             strm.avail_out = static_cast<uInt>(decompressed.size());
         }
     }
-    if (inflateEnd(&strm) != Z_OK)
-    {
-        setBody("");
-        if (status == StreamDecompressStatus::Ok)
-            status = StreamDecompressStatus::DecompressError;
-        return status;
-    }
     return status;
 }
 
@@ -1030,6 +1307,7 @@ void HttpRequestImpl::setStreamReader(RequestStreamReaderPtr reader)
     {
         reader->onStreamData(content_.data(), content_.length());
         content_.clear();
+        releaseBodyMemory();
     }
     if (streamStatus_ == ReqStreamStatus::Finish)
     {
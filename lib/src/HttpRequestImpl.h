@@ -15,11 +15,16 @@
 #pragma once
 
 #include "HttpUtils.h"
+#include "HttpHeaderIds.h"
 #include "CacheFile.h"
+#include "RequestPhases.h"
+#include "StringMapNodeCache.h"
+#include "Tracing.h"
 #include "impl_forwards.h"
 #include <drogon/utils/Utilities.h>
 #include <drogon/HttpRequest.h>
 #include <drogon/RequestStream.h>
+#include <drogon/utils/HttpConstraint.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/InetAddress.h>
@@ -29,11 +34,16 @@
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/TcpConnection.h>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <future>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <assert.h>
 #include <stdio.h>
 
@@ -71,8 +81,14 @@ class HttpRequestImpl : public HttpRequest
         previousMethod_ = Invalid;
         version_ = Version::kUnknown;
         flagForParsingJson_ = false;
-        headers_.clear();
-        cookies_.clear();
+        nodeCache_.recycle(headers_);
+        rawHeaders_.clear();
+        rawHeaderSlices_.clear();
+        knownHeaderSlots_.fill(0);
+        headersState_.store(kLazyRaw, std::memory_order_relaxed);
+        nodeCache_.recycle(cookies_);
+        rawCookies_.clear();
+        cookiesState_.store(kLazyRaw, std::memory_order_relaxed);
         contentLengthHeaderValue_.reset();
         realContentLength_ = 0;
         flagForParsingParameters_ = false;
@@ -81,17 +97,24 @@ class HttpRequestImpl : public HttpRequest
         pathEncode_ = true;
         matchedPathPattern_ = "";
         query_.clear();
-        parameters_.clear();
+        nodeCache_.recycle(parameters_);
+        // Keep the buffer of the usual query strings for the next request
+        if (parametersBuffer_.capacity() > 4096)
+            std::string().swap(parametersBuffer_);
         jsonPtr_.reset();
         sessionPtr_.reset();
         attributesPtr_.reset();
         cacheFilePtr_.reset();
         expectPtr_.reset();
         content_.clear();
+        clearBodySources();
+        releaseBodyMemory();
+        bodyLimit_ = BodyLimit{};
         contentType_ = CT_TEXT_PLAIN;
         flagForParsingContentType_ = false;
         contentTypeString_.clear();
         keepAlive_ = true;
+        passThrough_ = false;
         jsonParsingErrorPtr_.reset();
         peerCertificate_.reset();
         routingParams_.clear();
@@ -101,7 +124,13 @@ class HttpRequestImpl : public HttpRequest
         streamFinishCb_ = nullptr;
         streamExceptionPtr_ = nullptr;
         startProcessing_ = false;
+        handlingDate_ = trantor::Date(0);
+        phases_.reset();
+        abandonSpan();
+        traceContext_ = TraceContext{};
+        deadline_.reset();
         connPtr_.reset();
+        earlyHintsSender_ = nullptr;
     }
 
     trantor::EventLoop *getLoop()
@@ -109,6 +138,12 @@ class HttpRequestImpl : public HttpRequest
         return loop_;
     }
 
+    /// The request is handled by another loop than the one which parsed it
+    void setLoop(trantor::EventLoop *loop)
+    {
+        loop_ = loop;
+    }
+
     void setVersion(Version v)
     {
         version_ = v;
@@ -191,6 +226,11 @@ class HttpRequestImpl : public HttpRequest
         pathEncode_ = pathEncode;
     }
 
+    bool pathEncode() const
+    {
+        return pathEncode_;
+    }
+
     const SafeStringMap<std::string> &parameters() const override
     {
         parseParametersOnce();
@@ -261,14 +301,39 @@ class HttpRequestImpl : public HttpRequest
         }
         if (cacheFilePtr_)
         {
-            return cacheFilePtr_->getStringView().length();
+            // Without mapping the file
+            return cacheFilePtr_->length();
         }
         return content_.length();
     }
 
+    bool bodyChunks(const std::function<bool(std::string_view)> &callback,
+                    size_t chunkSize = 1024 * 1024) const override;
+
+    // The temporary file storing the body, if any
+    CacheFile *cacheFile() const
+    {
+        return cacheFilePtr_.get();
+    }
+
     void appendToBody(const char *data, size_t length);
 
-    void reserveBodySize(size_t length);
+    /**
+     * @brief Reserve the memory or the temporary file of a body of the length.
+     *
+     * @return false if the body should be kept in memory but the memory of
+     * bodies is used up, the connection may wait and call it again.
+     */
+    bool reserveBodySize(size_t length);
+
+    // The limits of the route, set before the body is received
+    void setBodyLimit(const BodyLimit &bodyLimit)
+    {
+        bodyLimit_ = bodyLimit;
+    }
+
+    size_t maxBodySize() const;
+    size_t maxMemoryBodySize() const;
 
     std::string_view queryView() const
     {
@@ -316,6 +381,84 @@ class HttpRequestImpl : public HttpRequest
         creationDate_ = date;
     }
 
+    void setDeadline(std::chrono::steady_clock::time_point deadline) override
+    {
+        deadline_ = deadline;
+    }
+
+    const std::optional<std::chrono::steady_clock::time_point> &deadline()
+        const override
+    {
+        return deadline_;
+    }
+
+    void sendEarlyHints(const std::vector<std::string> &links) override;
+
+    /// Set by the server to write the 103 responses of the request to its
+    /// connection, the hints are ignored while it is not set
+    void setEarlyHintsSender(std::function<void(std::string &&)> &&sender)
+    {
+        earlyHintsSender_ = std::move(sender);
+    }
+
+    /// Called with the final response, the later hints are ignored
+    void closeEarlyHints()
+    {
+        earlyHintsSender_ = nullptr;
+    }
+
+    /// The time the request is passed to its handler, 0 if it is not
+    const trantor::Date &handlingDate() const
+    {
+        return handlingDate_;
+    }
+
+    void setHandlingDate(const trantor::Date &date)
+    {
+        handlingDate_ = date;
+    }
+
+    /// Record the phases of the request from now on, see PhaseTracing
+    void startPhaseTracing()
+    {
+        phases_ = std::make_unique<RequestPhases>();
+        phases_->stamp(RequestPhase::kReceived);
+    }
+
+    void stampPhase(RequestPhase phase)
+    {
+        if (phases_)
+            phases_->stamp(phase);
+    }
+
+    /// nullptr if the request isn't sampled
+    const RequestPhases *phases() const
+    {
+        return phases_.get();
+    }
+
+    /// The trace the handler of the request belongs to, see Tracing
+    void setTraceContext(const TraceContext &context)
+    {
+        traceContext_ = context;
+    }
+
+    const TraceContext &traceContext() const
+    {
+        return traceContext_;
+    }
+
+    /// The server span of the request if its trace is recorded
+    void setSpan(std::unique_ptr<SpanData> &&span)
+    {
+        span_ = std::move(span);
+    }
+
+    std::unique_ptr<SpanData> takeSpan()
+    {
+        return std::move(span_);
+    }
+
     void setPeerAddr(const trantor::InetAddress &peer)
     {
         peer_ = peer;
@@ -348,6 +491,7 @@ class HttpRequestImpl : public HttpRequest
 
     void removeHeaderBy(const std::string &lowerKey)
     {
+        materializeHeaders();
         headers_.erase(lowerKey);
     }
 
@@ -363,6 +507,7 @@ class HttpRequestImpl : public HttpRequest
     const std::string &getHeaderBy(const std::string &lowerField) const
     {
         static const std::string defaultVal;
+        materializeHeaders();
         auto it = headers_.find(lowerField);
         if (it != headers_.end())
         {
@@ -371,9 +516,60 @@ class HttpRequestImpl : public HttpRequest
         return defaultVal;
     }
 
+    /**
+     * @brief Get a header value without building the header map.
+     *
+     * @note The view is valid until the headers of the request are modified.
+     */
+    std::string_view getHeaderView(std::string_view lowerField) const
+    {
+        if (headersState_.load(std::memory_order_acquire) == kLazyBuilt)
+        {
+            auto it = headers_.find(std::string(lowerField));
+            if (it != headers_.end())
+                return it->second;
+            return {};
+        }
+        auto id = findHttpHeaderId(lowerField);
+        if (id != HttpHeaderId::kUnknown)
+            return getHeaderView(id);
+        for (auto &slice : rawHeaderSlices_)
+        {
+            if (equalsIgnoreCase(std::string_view(rawHeaders_.data() +
+                                                      slice.fieldOffset,
+                                                  slice.fieldLength),
+                                 lowerField))
+            {
+                return std::string_view(rawHeaders_.data() + slice.valueOffset,
+                                        slice.valueLength);
+            }
+        }
+        return {};
+    }
+
+    /// Get a well-known header value without building the header map or
+    /// hashing its name.
+    std::string_view getHeaderView(HttpHeaderId id) const
+    {
+        if (headersState_.load(std::memory_order_acquire) == kLazyBuilt)
+        {
+            auto it = headers_.find(httpHeaderName(id));
+            if (it != headers_.end())
+                return it->second;
+            return {};
+        }
+        auto slot = knownHeaderSlots_[static_cast<size_t>(id)];
+        if (slot == 0)
+            return {};
+        auto &slice = rawHeaderSlices_[slot - 1];
+        return std::string_view(rawHeaders_.data() + slice.valueOffset,
+                                slice.valueLength);
+    }
+
     const std::string &getCookie(const std::string &field) const override
     {
         static const std::string defaultVal;
+        materializeCookies();
         auto it = cookies_.find(field);
         if (it != cookies_.end())
         {
@@ -384,11 +580,20 @@ class HttpRequestImpl : public HttpRequest
 
     const SafeStringMap<std::string> &headers() const override
     {
+        materializeHeaders();
         return headers_;
     }
 
+    /**
+     * @brief Get a cookie value without parsing the cookies into the map.
+     *
+     * @note The view is valid until the cookies of the request are modified.
+     */
+    std::string_view getCookieView(std::string_view name) const;
+
     const SafeStringMap<std::string> &cookies() const override
     {
+        materializeCookies();
         return cookies_;
     }
 
@@ -423,11 +628,57 @@ class HttpRequestImpl : public HttpRequest
     void setBody(const std::string &body) override
     {
         content_ = body;
+        clearBodySources();
     }
 
     void setBody(std::string &&body) override
     {
         content_ = std::move(body);
+        clearBodySources();
+    }
+
+    bool setBodyFile(const std::string &path,
+                     size_t offset,
+                     size_t length) override;
+
+    void setBodyGenerator(
+        std::function<std::size_t(char *, std::size_t)> generator,
+        std::optional<size_t> length) override
+    {
+        content_.clear();
+        clearBodySources();
+        bodyGenerator_ = std::move(generator);
+        generatedBodyLength_ = length;
+    }
+
+    /// A piece of a body sent by HttpClient: a string or a range of a file
+    struct BodyPiece
+    {
+        std::string data;
+        std::string path;
+        size_t offset{0};
+        size_t length{0};
+    };
+
+    /**
+     * @brief Take the generator of the body, see setBodyGenerator(). The body
+     * is sent with the chunked transfer coding if generatedBodyLength() has
+     * no value.
+     */
+    std::function<std::size_t(char *, std::size_t)> takeBodyGenerator()
+    {
+        return std::exchange(bodyGenerator_, nullptr);
+    }
+
+    /// A body generator can only be sent once
+    bool hasBodyGenerator() const
+    {
+        return static_cast<bool>(bodyGenerator_);
+    }
+
+    const std::optional<size_t> &generatedBodyLength() const
+    {
+        return generatedBodyLength_;
     }
 
     void addHeader(std::string field, const std::string &value) override
@@ -436,6 +687,7 @@ class HttpRequestImpl : public HttpRequest
                   field.end(),
                   field.begin(),
                   [](unsigned char c) { return tolower(c); });
+        materializeHeaders();
         headers_[std::move(field)] = value;
     }
 
@@ -445,11 +697,13 @@ class HttpRequestImpl : public HttpRequest
                   field.end(),
                   field.begin(),
                   [](unsigned char c) { return tolower(c); });
+        materializeHeaders();
         headers_[std::move(field)] = std::move(value);
     }
 
     void addCookie(std::string key, std::string value) override
     {
+        materializeCookies();
         cookies_[std::move(key)] = std::move(value);
     }
 
@@ -463,7 +717,15 @@ class HttpRequestImpl : public HttpRequest
         return passThrough_;
     }
 
-    void appendToBuffer(trantor::MsgBuffer *output) const;
+    /**
+     * @brief Render the request. The body stored in files (a temporary file,
+     * setBodyFile() or the files of an upload) is copied into the output and
+     * a generated body is generated into it, unless bodyPieces is given: then
+     * the pieces of the body after the output are put in it, and the caller
+     * sends them followed by the generated body, see takeBodyGenerator().
+     */
+    void appendToBuffer(trantor::MsgBuffer *output,
+                        std::vector<BodyPiece> *bodyPieces = nullptr);
 
     const SessionPtr &session() const override
     {
@@ -484,6 +746,9 @@ class HttpRequestImpl : public HttpRequest
         return attributesPtr_;
     }
 
+    std::optional<Json::Value> getJsonAt(
+        std::string_view pointer) const override;
+
     const std::shared_ptr<Json::Value> &jsonObject() const override
     {
         // Not multi-thread safe but good, because we basically call this
@@ -643,8 +908,8 @@ class HttpRequestImpl : public HttpRequest
         if (!flagForParsingContentType_)
         {
             flagForParsingContentType_ = true;
-            auto &contentTypeString = getHeaderBy("content-type");
-            if (contentTypeString == "")
+            auto contentTypeString = getHeaderView("content-type");
+            if (contentTypeString.empty())
             {
                 contentType_ = CT_NONE;
             }
@@ -653,13 +918,12 @@ class HttpRequestImpl : public HttpRequest
                 auto pos = contentTypeString.find(';');
                 if (pos != std::string::npos)
                 {
-                    contentType_ = parseContentType(
-                        std::string_view(contentTypeString.data(), pos));
+                    contentType_ =
+                        parseContentType(contentTypeString.substr(0, pos));
                 }
                 else
                 {
-                    contentType_ =
-                        parseContentType(std::string_view(contentTypeString));
+                    contentType_ = parseContentType(contentTypeString);
                 }
 
                 if (contentType_ == CT_NONE)
@@ -671,6 +935,19 @@ class HttpRequestImpl : public HttpRequest
 
   private:
     void parseParameters() const;
+    void parseUrlEncoded(std::string_view input) const;
+
+    void clearBodySources()
+    {
+        bodyFile_ = BodyPiece{};
+        if (bodyGenerator_)
+        {
+            // Release the resources of the generator
+            bodyGenerator_(nullptr, 0);
+            bodyGenerator_ = nullptr;
+        }
+        generatedBodyLength_.reset();
+    }
 
     void parseParametersOnce() const
     {
@@ -684,9 +961,45 @@ class HttpRequestImpl : public HttpRequest
     }
 
     void createTmpFile();
+    void moveBodyToTmpFile();
+    bool acquireBodyMemory(size_t bodyLength);
+    void releaseBodyMemory();
+
+    void abandonSpan()
+    {
+        if (span_)
+        {
+            Tracing::instance().abandon(*span_);
+            span_.reset();
+        }
+    }
+
     void parseJson() const;
+    bool isJsonBody() const;
+    // The const getters of a request may be called from several threads, so
+    // the maps are built by the first reader while the others wait for it.
+    // The raw headers and cookies are kept for the views read meanwhile.
+    // The setters are not thread-safe.
+    void materializeHeaders() const
+    {
+        if (headersState_.load(std::memory_order_acquire) != kLazyBuilt)
+            buildHeaderMap();
+    }
+    void buildHeaderMap() const;
+    /// Return true if the caller builds the map, otherwise wait until another
+    /// thread has built it
+    static bool lockLazyMap(std::atomic<uint8_t> &state);
+    void materializeCookies() const
+    {
+        if (cookiesState_.load(std::memory_order_acquire) != kLazyBuilt)
+            parseCookies();
+    }
+    void parseCookies() const;
 #ifdef USE_BROTLI
     StreamDecompressStatus decompressBodyBrotli() noexcept;
+#endif
+#ifdef USE_ZSTD
+    StreamDecompressStatus decompressBodyZstd() noexcept;
 #endif
     StreamDecompressStatus decompressBodyGzip() noexcept;
 
@@ -705,19 +1018,63 @@ class HttpRequestImpl : public HttpRequest
     bool pathEncode_{true};
     std::string_view matchedPathPattern_{""};
     std::string query_;
-    SafeStringMap<std::string> headers_;
-    SafeStringMap<std::string> cookies_;
+    mutable SafeStringMap<std::string> headers_;
+
+    // Headers received by the parser are stored as slices of one buffer and
+    // only copied into headers_ when the map is needed, so that requests
+    // whose headers are only read through getHeaderView() don't allocate a
+    // map node per header.
+    struct RawHeaderSlice
+    {
+        uint32_t fieldOffset;
+        uint32_t fieldLength;
+        uint32_t valueOffset;
+        uint32_t valueLength;
+    };
+
+    mutable std::string rawHeaders_;
+    mutable std::vector<RawHeaderSlice> rawHeaderSlices_;
+    // The index + 1 in rawHeaderSlices_ of the first header of every
+    // well-known name, 0 if there is none
+    mutable std::array<uint32_t, static_cast<size_t>(HttpHeaderId::kCount)>
+        knownHeaderSlots_{};
+    mutable SafeStringMap<std::string> cookies_;
+    // The Cookie headers received by the parser, only parsed into cookies_
+    // when the map is needed
+    mutable std::string rawCookies_;
+    // Whether headers_ and cookies_ are built from the raw headers and
+    // cookies, after which the parser adds the new ones to the maps
+    static constexpr uint8_t kLazyRaw = 0;
+    static constexpr uint8_t kLazyBuilding = 1;
+    static constexpr uint8_t kLazyBuilt = 2;
+    mutable std::atomic<uint8_t> headersState_{kLazyRaw};
+    mutable std::atomic<uint8_t> cookiesState_{kLazyRaw};
     std::optional<size_t> contentLengthHeaderValue_;
     size_t realContentLength_{0};
     mutable SafeStringMap<std::string> parameters_;
+    mutable std::string parametersBuffer_;
+    // The map nodes of the previous requests served with this object
+    mutable StringMapNodeCache nodeCache_;
     mutable std::shared_ptr<Json::Value> jsonPtr_;
     SessionPtr sessionPtr_;
     mutable AttributesPtr attributesPtr_;
     trantor::InetAddress peer_;
     trantor::InetAddress local_;
     trantor::Date creationDate_;
+    trantor::Date handlingDate_{0};
+    std::unique_ptr<RequestPhases> phases_;
+    TraceContext traceContext_;
+    std::unique_ptr<SpanData> span_;
+    std::optional<std::chrono::steady_clock::time_point> deadline_;
     trantor::CertificatePtr peerCertificate_;
     std::unique_ptr<CacheFile> cacheFilePtr_;
+    // The body sent by HttpClient from a file, if its path is not empty
+    BodyPiece bodyFile_;
+    std::function<std::size_t(char *, std::size_t)> bodyGenerator_;
+    std::optional<size_t> generatedBodyLength_;
+    BodyLimit bodyLimit_;
+    // The bytes of the BodyMemoryBudget held by content_
+    size_t bodyMemory_{0};
     mutable std::unique_ptr<std::string> jsonParsingErrorPtr_;
     std::unique_ptr<std::string> expectPtr_;
     bool keepAlive_{true};
@@ -731,6 +1088,7 @@ class HttpRequestImpl : public HttpRequest
     std::exception_ptr streamExceptionPtr_;
     bool startProcessing_{false};
     std::weak_ptr<trantor::TcpConnection> connPtr_;
+    std::function<void(std::string &&)> earlyHintsSender_;
 
   protected:
     std::string content_;
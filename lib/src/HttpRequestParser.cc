@@ -16,11 +16,18 @@
 #include <drogon/HttpTypes.h>
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/MsgBuffer.h>
+#include <cstring>
 #include <iostream>
+#include "BuiltinMetrics.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpConnectionLimit.h"
+#include "HttpControllersRouter.h"
 #include "HttpRequestImpl.h"
+#include "HttpRequestPool.h"
 #include "HttpResponseImpl.h"
+#include "HttpScanner.h"
 #include "HttpUtils.h"
+#include "MsgBufferPool.h"
 
 using namespace trantor;
 using namespace drogon;
@@ -29,18 +36,203 @@ static constexpr size_t CRLF_LEN = 2;            // strlen("crlf")
 static constexpr size_t METHOD_MAX_LEN = 7;      // strlen("OPTIONS")
 static constexpr size_t TRUNK_LEN_MAX_LEN = 16;  // 0xFFFFFFFF,FFFFFFFF
 
+namespace
+{
+size_t bufferCapacity(const MsgBuffer &buffer)
+{
+    return buffer.readableBytes() + buffer.writableBytes();
+}
+}  // namespace
+
 HttpRequestParser::HttpRequestParser(const trantor::TcpConnectionPtr &connPtr)
     : status_(HttpRequestParseStatus::kExpectMethod),
       loop_(connPtr->getLoop()),
       conn_(connPtr)
 {
+    accountMemory(sizeof(HttpRequestParser));
+}
+
+HttpRequestParser::~HttpRequestParser()
+{
+    // Called from any thread, the buffer is not returned to the pool
+    accountMemory(-static_cast<ptrdiff_t>(memoryBytes_));
+}
+
+void HttpRequestParser::startIdleTimeout(size_t timeout)
+{
+    if (timeout == 0)
+        return;
+    idleTimeout_ = static_cast<double>(timeout);
+    auto &wheel = TimeoutWheel::instance(loop_);
+    wheel.schedule(this, idleTimeout_);
+    lastActive_ = wheel.now();
+}
+
+void HttpRequestParser::startHeaderTimeout()
+{
+    auto timeout = HttpAppFrameworkImpl::instance().getHeaderTimeout();
+    if (timeout <= 0)
+        return;
+    auto &wheel = TimeoutWheel::instance(loop_);
+    requestStart_ = wheel.now();
+    wheel.scheduleBefore(this, timeout);
+}
+
+void HttpRequestParser::startBodyTimeout()
+{
+    auto timeout = HttpAppFrameworkImpl::instance().getBodyTimeout();
+    if (timeout <= 0)
+        return;
+    auto conn = conn_.lock();
+    if (!conn)
+        return;
+    auto &wheel = TimeoutWheel::instance(loop_);
+    bodyStart_ = wheel.now();
+    bodyStartBytes_ = conn->bytesReceived();
+    wheel.scheduleBefore(this, timeout);
+}
+
+bool HttpRequestParser::requestTimeLeft(const trantor::TcpConnectionPtr &conn,
+                                        double &seconds)
+{
+    if (websockConnPtr_ || http2ConnPtr_)
+        return false;
+    auto &app = HttpAppFrameworkImpl::instance();
+    auto now = TimeoutWheel::instance(loop_).now();
+    switch (status_)
+    {
+        case HttpRequestParseStatus::kExpectMethod:
+            // Between the requests
+            if (!request_)
+                return false;
+            [[fallthrough]];
+        case HttpRequestParseStatus::kExpectRequestLine:
+        case HttpRequestParseStatus::kExpectHeaders:
+            if (app.getHeaderTimeout() <= 0)
+                return false;
+            seconds = app.getHeaderTimeout() -
+                      static_cast<double>(now - requestStart_) *
+                          TimeoutWheel::kTick;
+            return true;
+        case HttpRequestParseStatus::kExpectBodyMemory:
+            // The connection doesn't read until the body gets its memory
+            if (app.getBodyTimeout() <= 0)
+                return false;
+            bodyStart_ = now;
+            bodyStartBytes_ = conn->bytesReceived();
+            seconds = app.getBodyTimeout();
+            return true;
+        case HttpRequestParseStatus::kExpectBody:
+        case HttpRequestParseStatus::kExpectChunkLen:
+        case HttpRequestParseStatus::kExpectChunkBody:
+        case HttpRequestParseStatus::kExpectLastEmptyChunk:
+        {
+            if (app.getBodyTimeout() <= 0)
+                return false;
+            auto allowed = app.getBodyTimeout();
+            if (app.getMinBodyRate() > 0)
+            {
+                allowed +=
+                    static_cast<double>(conn->bytesReceived() -
+                                        bodyStartBytes_) /
+                    static_cast<double>(app.getMinBodyRate());
+            }
+            seconds = allowed - static_cast<double>(now - bodyStart_) *
+                                    TimeoutWheel::kTick;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void HttpRequestParser::onTimeout()
+{
+    auto conn = conn_.lock();
+    if (!conn)
+        return;
+    auto &wheel = TimeoutWheel::instance(loop_);
+    // The delay of the next check, negative if none is needed
+    double next = -1;
+    if (idleTimeout_ > 0)
+    {
+        if (conn->bytesSent() != bytesSent_)
+        {
+            // A write extends the timeout from the check that finds it
+            bytesSent_ = conn->bytesSent();
+            lastActive_ = wheel.now();
+        }
+        auto idle = static_cast<double>(wheel.now() - lastActive_) *
+                    TimeoutWheel::kTick;
+        if (idle >= idleTimeout_)
+        {
+            LOG_TRACE << "Close the idle connection "
+                      << conn->peerAddr().toIpPort();
+            conn->forceClose();
+            return;
+        }
+        next = idleTimeout_ - idle;
+    }
+    double left;
+    if (requestTimeLeft(conn, left))
+    {
+        if (left <= 0)
+        {
+            auto &peer = peerAddr(conn);
+            LOG_DEBUG << "Close the connection of the slow client "
+                      << peer.toIpPort();
+            HttpConnectionLimit::instance().addSlowClient(peer);
+            conn->forceClose();
+            return;
+        }
+        if (next < 0 || left < next)
+            next = left;
+    }
+    if (next >= 0)
+        wheel.schedule(this, next);
+}
+
+void HttpRequestParser::setProxiedAddresses(const trantor::InetAddress &peer,
+                                            const trantor::InetAddress &local)
+{
+    if (!proxied_)
+        accountMemory(sizeof(*proxied_));
+    proxied_ = std::make_unique<
+        std::pair<trantor::InetAddress, trantor::InetAddress>>(peer, local);
+}
+
+void HttpRequestParser::accountMemory(ptrdiff_t delta)
+{
+    memoryBytes_ += delta;
+    BuiltinMetrics::instance().connectionMemory(loop_,
+                                                static_cast<double>(delta));
+}
+
+MsgBuffer &HttpRequestParser::getBuffer()
+{
+    if (sendBuffer_)
+        return *sendBuffer_;
+    // The send buffers of the idle connections are kept by the loop
+    sendBuffer_ = MsgBufferPool::take(MsgBufferPool::Use::kStaging);
+    accountMemory(bufferCapacity(*sendBuffer_));
+    return *sendBuffer_;
+}
+
+void HttpRequestParser::releaseBuffer()
+{
+    assert(loop_->isInLoopThread());
+    if (!sendBuffer_)
+        return;
+    sendBuffer_->retrieveAll();
+    accountMemory(-static_cast<ptrdiff_t>(bufferCapacity(*sendBuffer_)));
+    MsgBufferPool::give(std::move(sendBuffer_));
 }
 
 bool HttpRequestParser::processRequestLine(const char *begin, const char *end)
 {
     bool succeed = false;
     const char *start = begin;
-    const char *space = std::find(start, end, ' ');
+    const char *space = http_scanner::findChar(start, end, ' ');
     if (space != end)
     {
         const char *slash = std::find(start, space, '/');
@@ -84,51 +276,15 @@ bool HttpRequestParser::processRequestLine(const char *begin, const char *end)
     return succeed;
 }
 
-HttpRequestImplPtr HttpRequestParser::makeRequestForPool(HttpRequestImpl *ptr)
-{
-    return std::shared_ptr<HttpRequestImpl>(
-        ptr, [weakPtr = weak_from_this()](HttpRequestImpl *p) {
-            auto thisPtr = weakPtr.lock();
-            if (thisPtr)
-            {
-                if (thisPtr->loop_->isInLoopThread())
-                {
-                    p->reset();
-                    thisPtr->requestsPool_.emplace_back(
-                        thisPtr->makeRequestForPool(p));
-                }
-                else
-                {
-                    auto &loop = thisPtr->loop_;
-                    loop->queueInLoop([thisPtr = std::move(thisPtr), p]() {
-                        p->reset();
-                        thisPtr->requestsPool_.emplace_back(
-                            thisPtr->makeRequestForPool(p));
-                    });
-                }
-            }
-            else
-            {
-                delete p;
-            }
-        });
-}
-
 void HttpRequestParser::reset()
 {
     assert(loop_->isInLoopThread());
     remainContentLength_ = 0;
     status_ = HttpRequestParseStatus::kExpectMethod;
-    if (requestsPool_.empty())
+    if (request_)
     {
-        request_ = makeRequestForPool(new HttpRequestImpl(loop_));
-    }
-    else
-    {
-        auto req = std::move(requestsPool_.back());
-        requestsPool_.pop_back();
-        request_ = std::move(req);
-        request_->setCreationDate(trantor::Date::now());
+        request_.reset();
+        accountMemory(-static_cast<ptrdiff_t>(sizeof(HttpRequestImpl)));
     }
 }
 
@@ -142,15 +298,22 @@ void HttpRequestParser::reset()
  */
 int HttpRequestParser::parseRequest(MsgBuffer *buf)
 {
+    if (!request_)
+    {
+        request_ = HttpRequestPool::acquire(loop_);
+        accountMemory(sizeof(HttpRequestImpl));
+        startHeaderTimeout();
+    }
     while (true)
     {
         switch (status_)
         {
             case (HttpRequestParseStatus::kExpectMethod):
             {
-                auto *space = std::find(buf->peek(),
-                                        (const char *)buf->beginWrite(),
-                                        ' ');
+                auto *space =
+                    http_scanner::findChar(buf->peek(),
+                                           (const char *)buf->beginWrite(),
+                                           ' ');
                 // no space in buffer
                 if (space == buf->beginWrite())
                 {
@@ -165,13 +328,18 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 {
                     return -k405MethodNotAllowed;
                 }
+                if (PhaseTracing::shouldSample())
+                {
+                    request_->startPhaseTracing();
+                }
                 status_ = HttpRequestParseStatus::kExpectRequestLine;
                 buf->retrieveUntil(space + 1);
                 continue;
             }
             case HttpRequestParseStatus::kExpectRequestLine:
             {
-                const char *crlf = buf->findCRLF();
+                const char *crlf = http_scanner::findCRLF(
+                    buf->peek(), (const char *)buf->beginWrite());
                 if (!crlf)
                 {
                     if (buf->readableBytes() >= 64 * 1024)
@@ -194,7 +362,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
             }
             case HttpRequestParseStatus::kExpectHeaders:
             {
-                const char *crlf = buf->findCRLF();
+                const char *crlf = http_scanner::findCRLF(
+                    buf->peek(), (const char *)buf->beginWrite());
                 if (!crlf)
                 {
                     if (buf->readableBytes() >= 64 * 1024)
@@ -206,10 +375,17 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                     return 0;
                 }
 
-                const char *colon = std::find(buf->peek(), crlf, ':');
+                const char *colon =
+                    http_scanner::findChar(buf->peek(), crlf, ':');
                 // found colon
                 if (colon != crlf)
                 {
+                    // Field names are tokens, which also rejects whitespace
+                    // before the colon (rfc7230-3.2.4)
+                    if (!http_scanner::isToken(buf->peek(), colon))
+                    {
+                        return -k400BadRequest;
+                    }
                     request_->addHeader(buf->peek(), colon, crlf);
                     buf->retrieveUntil(crlf + CRLF_LEN);
                     continue;
@@ -221,13 +397,14 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 // and maintainability.
 
                 // process header information
-                auto &len = request_->getHeaderBy("content-length");
+                auto len =
+                    request_->getHeaderView(HttpHeaderId::kContentLength);
                 if (!len.empty())
                 {
                     try
                     {
                         remainContentLength_ =
-                            static_cast<size_t>(std::stoull(len));
+                            static_cast<size_t>(std::stoull(std::string(len)));
                     }
                     catch (...)
                     {
@@ -246,8 +423,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 }
                 else
                 {
-                    const std::string &encode =
-                        request_->getHeaderBy("transfer-encoding");
+                    auto encode = request_->getHeaderView(
+                        HttpHeaderId::kTransferEncoding);
                     if (encode.empty())
                     {
                         // no content-length and no transfer-encoding,
@@ -264,9 +441,15 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                     }
                 }
 
+                // The route may have its own body limits
+                auto &router = HttpControllersRouter::instance();
+                if (router.hasBodyLimits())
+                {
+                    request_->setBodyLimit(router.bodyLimitOf(*request_));
+                }
+
                 // Check max body size
-                if (remainContentLength_ >
-                    HttpAppFrameworkImpl::instance().getClientMaxBodySize())
+                if (remainContentLength_ > request_->maxBodySize())
                 {
                     return -k413RequestEntityTooLarge;
                 }
@@ -295,7 +478,7 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                         auto httpString =
                             static_cast<HttpResponseImpl *>(resp.get())
                                 ->renderToBuffer();
-                        connPtr->send(std::move(*httpString));
+                        connPtr->send(httpString);
                     }
                 }
                 else if (!expect.empty())
@@ -307,6 +490,10 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 assert(status_ == HttpRequestParseStatus::kGotAll ||
                        status_ == HttpRequestParseStatus::kExpectBody ||
                        status_ == HttpRequestParseStatus::kExpectChunkLen);
+                if (status_ != HttpRequestParseStatus::kGotAll)
+                {
+                    startBodyTimeout();
+                }
 
                 if (app().isRequestStreamEnabled())
                 {
@@ -325,10 +512,22 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 // Reserve space for full body in non-stream mode.
                 // For stream mode requests that match a non-stream handler,
                 // we will reserve full body before waitForStreamFinish().
-                if (remainContentLength_)
+                if (remainContentLength_ &&
+                    status_ == HttpRequestParseStatus::kExpectBody)
+                {
+                    status_ = HttpRequestParseStatus::kExpectBodyMemory;
+                }
+                continue;
+            }
+            case HttpRequestParseStatus::kExpectBodyMemory:
+            {
+                // Until the body gets its memory, the connection stops
+                // reading, see HttpServer::onMessage()
+                if (!request_->reserveBodySize(remainContentLength_))
                 {
-                    request_->reserveBodySize(remainContentLength_);
+                    return 0;
                 }
+                status_ = HttpRequestParseStatus::kExpectBody;
                 continue;
             }
             case HttpRequestParseStatus::kExpectBody:
@@ -354,54 +553,18 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 return 0;
             }
             case HttpRequestParseStatus::kExpectChunkLen:
-            {
-                const char *crlf = buf->findCRLF();
-                if (!crlf)
-                {
-                    if (buf->readableBytes() > TRUNK_LEN_MAX_LEN + CRLF_LEN)
-                    {
-                        return -k400BadRequest;
-                    }
-                    return 0;
-                }
-                // chunk length line
-                std::string len(buf->peek(), crlf - buf->peek());
-                char *end;
-                currentChunkLength_ = strtol(len.c_str(), &end, 16);
-                if (currentChunkLength_ != 0)
-                {
-                    if (currentChunkLength_ + remainContentLength_ >
-                        HttpAppFrameworkImpl::instance().getClientMaxBodySize())
-                    {
-                        return -k413RequestEntityTooLarge;
-                    }
-                    status_ = HttpRequestParseStatus::kExpectChunkBody;
-                }
-                else
-                {
-                    status_ = HttpRequestParseStatus::kExpectLastEmptyChunk;
-                }
-                buf->retrieveUntil(crlf + CRLF_LEN);
-                continue;
-            }
             case HttpRequestParseStatus::kExpectChunkBody:
             {
-                if (buf->readableBytes() < (currentChunkLength_ + CRLF_LEN))
+                auto ret = decodeChunks(buf);
+                if (ret < 0)
                 {
-                    return 0;
+                    return ret;
                 }
-                if (*(buf->peek() + currentChunkLength_) != '\r' ||
-                    *(buf->peek() + currentChunkLength_ + 1) != '\n')
+                if (status_ == HttpRequestParseStatus::kExpectLastEmptyChunk)
                 {
-                    // error!
-                    return -k400BadRequest;
+                    continue;
                 }
-                request_->appendToBody(buf->peek(), currentChunkLength_);
-                buf->retrieve(currentChunkLength_ + CRLF_LEN);
-                remainContentLength_ += currentChunkLength_;
-                currentChunkLength_ = 0;
-                status_ = HttpRequestParseStatus::kExpectChunkLen;
-                continue;
+                return 0;
             }
             case HttpRequestParseStatus::kExpectLastEmptyChunk:
             {
@@ -453,6 +616,76 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
     return -1;  // won't reach here, just to make compiler happy
 }
 
+int HttpRequestParser::decodeChunks(MsgBuffer *buf)
+{
+    // The data of the complete chunks is moved over the chunk size lines
+    // already decoded, so a burst of small chunks is appended to the body, or
+    // passed to the stream reader, in one piece.
+    auto begin = const_cast<char *>(buf->peek());
+    auto end = begin + buf->readableBytes();
+    auto out = begin;
+    const char *p = begin;
+    int ret = 0;
+    while (true)
+    {
+        if (status_ == HttpRequestParseStatus::kExpectChunkLen)
+        {
+            const char *crlf = http_scanner::findCRLF(p, end);
+            if (!crlf)
+            {
+                if (static_cast<size_t>(end - p) >
+                    TRUNK_LEN_MAX_LEN + CRLF_LEN)
+                {
+                    ret = -k400BadRequest;
+                }
+                break;
+            }
+            // chunk length line, strtol stops at the '\r' or at the ';' of
+            // the chunk extensions
+            currentChunkLength_ = strtol(p, nullptr, 16);
+            p = crlf + CRLF_LEN;
+            if (currentChunkLength_ == 0)
+            {
+                status_ = HttpRequestParseStatus::kExpectLastEmptyChunk;
+                break;
+            }
+            if (currentChunkLength_ + remainContentLength_ >
+                request_->maxBodySize())
+            {
+                ret = -k413RequestEntityTooLarge;
+                break;
+            }
+            status_ = HttpRequestParseStatus::kExpectChunkBody;
+        }
+        if (static_cast<size_t>(end - p) < currentChunkLength_ + CRLF_LEN)
+        {
+            break;
+        }
+        if (*(p + currentChunkLength_) != '\r' ||
+            *(p + currentChunkLength_ + 1) != '\n')
+        {
+            // error!
+            ret = -k400BadRequest;
+            break;
+        }
+        if (out != p)
+        {
+            memmove(out, p, currentChunkLength_);
+        }
+        out += currentChunkLength_;
+        p += currentChunkLength_ + CRLF_LEN;
+        remainContentLength_ += currentChunkLength_;
+        currentChunkLength_ = 0;
+        status_ = HttpRequestParseStatus::kExpectChunkLen;
+    }
+    if (ret == 0 && out != begin)
+    {
+        request_->appendToBody(begin, out - begin);
+    }
+    buf->retrieve(p - begin);
+    return ret;
+}
+
 void HttpRequestParser::pushRequestToPipelining(const HttpRequestPtr &req,
                                                 bool isHeadMethod)
 {
@@ -479,6 +712,18 @@ bool HttpRequestParser::pushResponseToPipelining(const HttpRequestPtr &req,
     return false;
 }
 
+bool HttpRequestParser::responsesPendingBefore(
+    const HttpRequestPtr &req) const
+{
+    assert(loop_->isInLoopThread());
+    if (responseBuffer_ && !responseBuffer_->empty())
+        return true;
+    // The requests handled synchronously are pushed after their handlers
+    return !requestPipelining_.empty() &&
+           (requestPipelining_.front().first != req ||
+            requestPipelining_.front().second.first);
+}
+
 void HttpRequestParser::popReadyResponses(
     std::vector<std::pair<HttpResponsePtr, bool>> &buffer)
 {
@@ -21,12 +21,18 @@
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include "TimeoutWheel.h"
 #include "impl_forwards.h"
 
 namespace drogon
 {
-class HttpRequestParser : public trantor::NonCopyable,
-                          public std::enable_shared_from_this<HttpRequestParser>
+class Http2ServerConnection;
+
+class HttpRequestParser
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<HttpRequestParser>,
+      private TimeoutEntry
 {
   public:
     enum class HttpRequestParseStatus
@@ -34,6 +40,7 @@ class HttpRequestParser : public trantor::NonCopyable,
         kExpectMethod,
         kExpectRequestLine,
         kExpectHeaders,
+        kExpectBodyMemory,
         kExpectBody,
         kExpectChunkLen,
         kExpectChunkBody,
@@ -42,6 +49,7 @@ class HttpRequestParser : public trantor::NonCopyable,
     };
 
     explicit HttpRequestParser(const trantor::TcpConnectionPtr &connPtr);
+    ~HttpRequestParser();
 
     int parseRequest(trantor::MsgBuffer *buf);
 
@@ -50,8 +58,11 @@ class HttpRequestParser : public trantor::NonCopyable,
         return status_ == HttpRequestParseStatus::kGotAll;
     }
 
+    // Releases the request, the next one is acquired when its first bytes
+    // arrive, so idle keep-alive connections don't hold a request object
     void reset();
 
+    // Null between requests
     const HttpRequestImplPtr &requestImpl() const
     {
         return request_;
@@ -77,10 +88,75 @@ class HttpRequestParser : public trantor::NonCopyable,
         websockConnPtr_ = conn;
     }
 
+    const std::shared_ptr<Http2ServerConnection> &http2Conn() const
+    {
+        return http2ConnPtr_;
+    }
+
+    void setHttp2Connection(const std::shared_ptr<Http2ServerConnection> &conn)
+    {
+        http2ConnPtr_ = conn;
+    }
+
+    // True until the PROXY protocol header of the load balancer is received,
+    // the connection is only counted and advised once it is
+    bool waitingForProxyHeader() const
+    {
+        return waitingForProxyHeader_;
+    }
+
+    void expectProxyHeader()
+    {
+        waitingForProxyHeader_ = true;
+    }
+
+    void proxyHeaderReceived()
+    {
+        waitingForProxyHeader_ = false;
+    }
+
+    void setProxiedAddresses(const trantor::InetAddress &peer,
+                             const trantor::InetAddress &local);
+
+    // The client and the server, the ones of the connection unless the PROXY
+    // protocol header gave others
+    const trantor::InetAddress &peerAddr(
+        const trantor::TcpConnectionPtr &conn) const
+    {
+        return proxied_ ? proxied_->first : conn->peerAddr();
+    }
+
+    const trantor::InetAddress &localAddr(
+        const trantor::TcpConnectionPtr &conn) const
+    {
+        return proxied_ ? proxied_->second : conn->localAddr();
+    }
+
+    // True before the first byte of a request is parsed
+    bool atRequestStart() const
+    {
+        return status_ == HttpRequestParseStatus::kExpectMethod;
+    }
+
+    // True while the body of the request waits for the memory budget of
+    // bodies, the length of the body is given by remainContentLength()
+    bool waitingForBodyMemory() const
+    {
+        return status_ == HttpRequestParseStatus::kExpectBodyMemory;
+    }
+
+    size_t remainContentLength() const
+    {
+        return remainContentLength_;
+    }
+
     // to support request pipelining(rfc2616-8.1.2.2)
     void pushRequestToPipelining(const HttpRequestPtr &, bool isHeadMethod);
     bool pushResponseToPipelining(const HttpRequestPtr &, HttpResponsePtr);
     void popReadyResponses(std::vector<std::pair<HttpResponsePtr, bool>> &);
+    // True while a response to an earlier request is not sent, an interim
+    // response of the request can't be sent before it
+    bool responsesPendingBefore(const HttpRequestPtr &) const;
 
     size_t numberOfRequestsInPipelining() const
     {
@@ -92,6 +168,18 @@ class HttpRequestParser : public trantor::NonCopyable,
         return requestPipelining_.empty();
     }
 
+    // True while a flush of the ready pipelined responses is queued in the
+    // loop
+    bool pipelineFlushQueued() const
+    {
+        return pipelineFlushQueued_;
+    }
+
+    void setPipelineFlushQueued(bool queued)
+    {
+        pipelineFlushQueued_ = queued;
+    }
+
     bool isStop() const
     {
         return stopWorking_;
@@ -107,11 +195,29 @@ class HttpRequestParser : public trantor::NonCopyable,
         return requestsCounter_;
     }
 
-    trantor::MsgBuffer &getBuffer()
+    // Close the connection once it has been idle for the timeout in seconds,
+    // called in the loop when the connection is established
+    void startIdleTimeout(size_t timeout);
+
+    // Stop the idle timeout and the deadlines of the slow clients, called in
+    // the loop when the connection is closed
+    void stopTimeouts()
     {
-        return sendBuffer_;
+        cancel();
     }
 
+    // The connection received some data, only stores the slot of the wheel
+    void touch()
+    {
+        if (idleTimeout_ > 0)
+            lastActive_ = TimeoutWheel::instance(loop_).now();
+    }
+
+    // The buffer of the pipelined responses, it is taken from a per loop
+    // pool until releaseBuffer() is called
+    trantor::MsgBuffer &getBuffer();
+    void releaseBuffer();
+
     std::vector<std::pair<HttpResponsePtr, bool>> &getResponseBuffer()
     {
         assert(loop_->isInLoopThread());
@@ -136,25 +242,54 @@ class HttpRequestParser : public trantor::NonCopyable,
     }
 
   private:
-    HttpRequestImplPtr makeRequestForPool(HttpRequestImpl *p);
+    void onTimeout() override;
+    // The deadlines of the slow clients, see
+    // HttpAppFramework::setSlowClientTimeouts()
+    void startHeaderTimeout();
+    void startBodyTimeout();
+    // The seconds left to the deadline of the request being received, false
+    // if it has none
+    bool requestTimeLeft(const trantor::TcpConnectionPtr &conn,
+                         double &seconds);
     bool processRequestLine(const char *begin, const char *end);
+    // Decode the complete chunks of the buffer, a negative status code on
+    // error
+    int decodeChunks(trantor::MsgBuffer *buf);
+    void accountMemory(ptrdiff_t delta);
     HttpRequestParseStatus status_;
     trantor::EventLoop *loop_;
     HttpRequestImplPtr request_;
     bool firstRequest_{true};
     WebSocketConnectionImplPtr websockConnPtr_;
+    std::shared_ptr<Http2ServerConnection> http2ConnPtr_;
     std::deque<std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>
         requestPipelining_;
     size_t requestsCounter_{0};
     std::weak_ptr<trantor::TcpConnection> conn_;
     bool stopWorking_{false};
-    trantor::MsgBuffer sendBuffer_;
+    bool pipelineFlushQueued_{false};
+    bool waitingForProxyHeader_{false};
+    // Only allocated behind a load balancer
+    std::unique_ptr<std::pair<trantor::InetAddress, trantor::InetAddress>>
+        proxied_;
+    std::unique_ptr<trantor::MsgBuffer> sendBuffer_;
     std::unique_ptr<std::vector<std::pair<HttpResponsePtr, bool>>>
         responseBuffer_;
     std::unique_ptr<std::vector<HttpRequestImplPtr>> requestBuffer_;
-    std::vector<HttpRequestImplPtr> requestsPool_;
     size_t currentChunkLength_{0};
     size_t remainContentLength_{0};
+    // The bytes reported to the connection memory metric
+    size_t memoryBytes_{0};
+    // The reads store the slot of the wheel, the writes are found by the
+    // bytes sent when the timeout is checked
+    uint64_t lastActive_{0};
+    size_t bytesSent_{0};
+    double idleTimeout_{0};
+    // The slots of the first byte of the request and of the end of its
+    // headers, with the bytes received at the end of its headers
+    uint64_t requestStart_{0};
+    uint64_t bodyStart_{0};
+    size_t bodyStartBytes_{0};
 };
 
 }  // namespace drogon
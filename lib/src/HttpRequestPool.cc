@@ -0,0 +1,86 @@
+/**
+ *
+ *  @file HttpRequestPool.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpRequestPool.h"
+#include "HttpRequestImpl.h"
+#include <drogon/IOThreadStorage.h>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+using FreeList = std::vector<std::unique_ptr<HttpRequestImpl>>;
+
+IOThreadStorage<FreeList> &freeLists()
+{
+    // Created on first use, after the number of IO threads is known.
+    static IOThreadStorage<FreeList> lists;
+    return lists;
+}
+
+bool isFrameworkLoop(trantor::EventLoop *loop)
+{
+    return loop && loop->index() <= app().getThreadNum();
+}
+
+void recycle(HttpRequestImpl *p)
+{
+    p->reset();
+    auto &list = freeLists().getThreadData();
+    if (list.size() < HttpRequestPool::maxIdleRequestsPerLoop())
+    {
+        list.emplace_back(p);
+    }
+    else
+    {
+        delete p;
+    }
+}
+
+// The loop of the request may have been replaced by a handler loop, which
+// can be stopped before the request is released, so the request goes back
+// to the IO loop it was acquired in
+void release(HttpRequestImpl *p, trantor::EventLoop *loop)
+{
+    if (loop->isInLoopThread())
+    {
+        recycle(p);
+    }
+    else
+    {
+        // The handler kept the request after its callback returned.
+        loop->queueInLoop([p]() { recycle(p); });
+    }
+}
+}  // namespace
+
+HttpRequestImplPtr HttpRequestPool::acquire(trantor::EventLoop *loop)
+{
+    if (!isFrameworkLoop(loop))
+    {
+        return std::make_shared<HttpRequestImpl>(loop);
+    }
+    assert(loop->isInLoopThread());
+    auto &list = freeLists().getThreadData();
+    auto deleter = [loop](HttpRequestImpl *p) { release(p, loop); };
+    if (list.empty())
+    {
+        return HttpRequestImplPtr(new HttpRequestImpl(loop), deleter);
+    }
+    auto *p = list.back().release();
+    list.pop_back();
+    p->setCreationDate(trantor::Date::now());
+    p->setLoop(loop);
+    return HttpRequestImplPtr(p, deleter);
+}
@@ -0,0 +1,49 @@
+/**
+ *
+ *  @file HttpRequestPool.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <trantor/net/EventLoop.h>
+
+namespace drogon
+{
+/**
+ * @brief Per IO loop free-lists of request objects.
+ *
+ * Requests released by the application are reset and kept by the loop that
+ * created them, so the capacity of their strings and containers is reused by
+ * later requests of any connection served by that loop. A request can be
+ * released from any thread, it is then returned to the loop it was acquired
+ * in with queueInLoop(), even if it was handed to another loop since.
+ */
+class HttpRequestPool
+{
+  public:
+    /**
+     * @brief Get a request for a connection of the loop.
+     *
+     * @note Must be called in the loop thread. Loops that are not managed by
+     * the framework get a new, non-pooled request.
+     */
+    static HttpRequestImplPtr acquire(trantor::EventLoop *loop);
+
+    /**
+     * @brief The number of idle requests kept by each loop.
+     */
+    static constexpr size_t maxIdleRequestsPerLoop()
+    {
+        return 1024;
+    }
+};
+}  // namespace drogon
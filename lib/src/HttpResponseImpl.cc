@@ -15,11 +15,14 @@
 #include "HttpResponseImpl.h"
 #include "AOPAdvice.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpDateCache.h"
 #include "HttpUtils.h"
 #include <drogon/HttpViewData.h>
 #include <drogon/IOThreadStorage.h>
+#include <drogon/utils/MsgPack.h>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <memory>
 #include <cstdio>
 #include <string>
@@ -37,7 +40,7 @@ using namespace std::placeholders;
 namespace drogon
 {
 // "Fri, 23 Aug 2019 12:58:03 GMT" length = 29
-static const size_t httpFullDateStringLength = 29;
+static const size_t httpFullDateStringLength = HttpDateCache::length();
 
 static inline HttpResponsePtr genHttpResponse(const std::string &viewName,
                                               const HttpViewData &data,
@@ -85,6 +88,57 @@ HttpResponsePtr HttpResponse::newHttpJsonResponse(Json::Value &&data)
     return res;
 }
 
+HttpResponsePtr HttpResponse::newHttpJsonResponse(
+    const std::function<void(JsonWriter &)> &writeBody)
+{
+    auto res = std::make_shared<HttpResponseImpl>(k200OK, CT_APPLICATION_JSON);
+    std::string body;
+    {
+        JsonWriter writer(body);
+        writeBody(writer);
+    }
+    res->setBody(std::move(body));
+    AopAdvice::instance().passResponseCreationAdvices(res);
+    return res;
+}
+
+HttpResponsePtr HttpResponse::newHttpMsgPackResponse(const Json::Value &data)
+{
+    auto res =
+        std::make_shared<HttpResponseImpl>(k200OK, CT_APPLICATION_MSGPACK);
+    res->setBody(utils::toMsgPack(data));
+    AopAdvice::instance().passResponseCreationAdvices(res);
+    return res;
+}
+
+HttpResponsePtr HttpResponse::newHttpJsonOrMsgPackResponse(
+    const HttpRequestPtr &req,
+    const Json::Value &data)
+{
+    HttpResponsePtr res;
+    if (req && prefersMsgPack(req->getHeader("accept")))
+        res = newHttpMsgPackResponse(data);
+    else
+        res = newHttpJsonResponse(data);
+    // The body depends on the Accept header, the caches must know it
+    res->addHeader("vary", "accept");
+    return res;
+}
+
+std::shared_ptr<Json::Value> HttpResponse::getMsgPackObject(
+    std::string *errs) const
+{
+    auto root = std::make_shared<Json::Value>();
+    std::string errors;
+    if (!utils::fromMsgPack(getBody(), *root, errors))
+    {
+        if (errs)
+            *errs = std::move(errors);
+        return nullptr;
+    }
+    return root;
+}
+
 const char *HttpResponseImpl::versionString() const
 {
     const char *result = "UNKNOWN";
@@ -98,6 +152,14 @@ const char *HttpResponseImpl::versionString() const
             result = "HTTP/1.1";
             break;
 
+        case Version::kHttp2:
+            result = "HTTP/2";
+            break;
+
+        case Version::kHttp3:
+            result = "HTTP/3";
+            break;
+
         default:
             break;
     }
@@ -111,24 +173,8 @@ void HttpResponseImpl::generateBodyFromJson() const
         return;
     }
     flagForSerializingJson_ = true;
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-        if (!app().isUnicodeEscapingUsedInJson())
-        {
-            builder["emitUTF8"] = true;
-        }
-        auto &precision = app().getFloatPrecisionInJson();
-        if (precision.first != 0)
-        {
-            builder["precision"] = precision.first;
-            builder["precisionType"] = precision.second;
-        }
-    });
     bodyPtr_ = std::make_shared<HttpMessageStringBody>(
-        writeString(builder, *jsonPtr_));
+        app().getJsonBackend()->write(*jsonPtr_));
 }
 
 HttpResponsePtr HttpResponse::newNotFoundResponse(const HttpRequestPtr &req)
@@ -202,6 +248,49 @@ HttpResponsePtr HttpResponse::newHttpViewResponse(const std::string &viewName,
     return genHttpResponse(viewName, data, req);
 }
 
+HttpResponsePtr HttpResponse::newHttpViewStreamResponse(
+    const std::string &viewName,
+    const HttpViewData &data,
+    size_t flushThreshold,
+    const HttpRequestPtr &req)
+{
+    auto templ = DrTemplateBase::newTemplate(viewName);
+    if (!templ)
+        return drogon::HttpResponse::newNotFoundResponse(req);
+    auto resp = newAsyncStreamResponse(
+        [templ = std::move(templ), data, flushThreshold](
+            ResponseStreamPtr stream) mutable {
+            HttpAppFrameworkImpl::instance().runInComputePool(
+                [templ = std::move(templ),
+                 data = std::move(data),
+                 flushThreshold,
+                 stream = std::shared_ptr<ResponseStream>(
+                     std::move(stream))]() {
+                    OStringStream out;
+                    out.setSink(
+                        [&stream, flushThreshold](const std::string &chunk) {
+                            if (!stream->send(chunk))
+                                return false;
+                            if (stream->pendingBytes() <= 4 * flushThreshold)
+                                return true;
+                            // Wait for the connection to catch up, the drain
+                            // is completed when the connection is closed too
+                            std::promise<void> drained;
+                            stream->drain(
+                                [&drained]() { drained.set_value(); });
+                            drained.get_future().wait();
+                            return true;
+                        },
+                        flushThreshold);
+                    templ->renderTo(data, out);
+                    out.flush();
+                    stream->close();
+                });
+        });
+    resp->setContentTypeCode(CT_TEXT_HTML);
+    return resp;
+}
+
 HttpResponsePtr HttpResponse::newFileResponse(
     const unsigned char *pBuffer,
     size_t bufferLength,
@@ -617,6 +706,9 @@ void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
             buffer.append(
                 HttpAppFrameworkImpl::instance().getServerHeaderString());
         }
+        auto &altSvc = HttpAppFrameworkImpl::instance().getAltSvcHeaderString();
+        if (!altSvc.empty() && headers_.find("alt-svc") == headers_.end())
+            buffer.append(altSvc);
     }
 
     for (auto it = headers_.begin(); it != headers_.end(); ++it)
@@ -637,6 +729,13 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
         return;
     }
 
+    renderHeaderToBuffer(buffer);
+    if (bodyPtr_ && contentLengthIsAllowed())
+        buffer.append(bodyPtr_->data(), bodyPtr_->length());
+}
+
+void HttpResponseImpl::renderHeaderToBuffer(trantor::MsgBuffer &buffer)
+{
     if (!fullHeaderString_)
     {
         makeHeaderString(buffer);
@@ -651,7 +750,7 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
     {
         for (auto it = cookies_.begin(); it != cookies_.end(); ++it)
         {
-            buffer.append(it->second.cookieString());
+            it->second.appendCookieString(buffer);
         }
     }
 
@@ -660,15 +759,39 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
         drogon::HttpAppFrameworkImpl::instance().sendDateHeader())
     {
         buffer.append("date: ");
-        buffer.append(utils::getHttpFullDateStr(trantor::Date::date()));
+        buffer.append(HttpDateCache::date(), httpFullDateStringLength);
         buffer.append("\r\n\r\n");
     }
     else
     {
         buffer.append("\r\n");
     }
-    if (bodyPtr_ && contentLengthIsAllowed())
-        buffer.append(bodyPtr_->data(), bodyPtr_->length());
+}
+
+bool HttpResponseImpl::sendBodySeparately() const
+{
+    generateBodyFromJson();
+    return bodyPtr_ &&
+           bodyPtr_->length() >= separateBodyThreshold() &&
+           contentLengthIsAllowed();
+}
+
+std::shared_ptr<std::string> HttpResponseImpl::sharedBodyString() const
+{
+    if (!bodyPtr_)
+        return nullptr;
+    if (bodyPtr_->bodyType() == HttpMessageBody::BodyType::kSharedString)
+    {
+        // The connections only read the strings they send
+        return std::const_pointer_cast<std::string>(
+            static_cast<HttpMessageSharedStringBody *>(bodyPtr_.get())
+                ->sharedString());
+    }
+    if (bodyPtr_->bodyType() != HttpMessageBody::BodyType::kString)
+        return nullptr;
+    // Share the ownership of the body instead of copying it
+    return std::shared_ptr<std::string>(
+        bodyPtr_, &static_cast<HttpMessageStringBody *>(bodyPtr_.get())->str());
 }
 
 std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
@@ -680,19 +803,20 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
         {
             if (datePos_ != static_cast<size_t>(-1))
             {
-                auto now = trantor::Date::now();
-                bool isDateChanged =
-                    ((now.microSecondsSinceEpoch() /
-                      trantor::Date::MICRO_SECONDS_PER_SEC) != httpStringDate_);
+                auto second = HttpDateCache::second();
                 assert(httpString_);
-                if (isDateChanged)
+                if (second != httpStringDate_)
                 {
-                    httpStringDate_ = now.microSecondsSinceEpoch() /
-                                      trantor::Date::MICRO_SECONDS_PER_SEC;
-                    auto newDate = utils::getHttpFullDate(now);
+                    httpStringDate_ = second;
+                    auto newDate = HttpDateCache::date();
 
-                    httpString_ =
-                        std::make_shared<trantor::MsgBuffer>(*httpString_);
+                    // Patch the buffer in place unless it is still queued
+                    // for sending on some connection.
+                    if (httpString_.use_count() > 1)
+                    {
+                        httpString_ =
+                            std::make_shared<trantor::MsgBuffer>(*httpString_);
+                    }
                     memcpy((void *)&(*httpString_)[datePos_],
                            newDate,
                            httpFullDateStringLength);
@@ -708,7 +832,8 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
                 return httpString_;
         }
     }
-    auto httpString = std::make_shared<trantor::MsgBuffer>(256);
+    auto httpString = MsgBufferPool::acquire(MsgBufferPool::Use::kHeader,
+                                             bodyPtr_ ? bodyPtr_->length() : 0);
     if (!fullHeaderString_)
     {
         makeHeaderString(*httpString);
@@ -723,7 +848,7 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
     {
         for (auto it = cookies_.begin(); it != cookies_.end(); ++it)
         {
-            httpString->append(it->second.cookieString());
+            it->second.appendCookieString(*httpString);
         }
     }
 
@@ -733,7 +858,7 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
     {
         httpString->append("date: ");
         auto datePos = httpString->readableBytes();
-        httpString->append(utils::getHttpFullDateStr(trantor::Date::date()));
+        httpString->append(HttpDateCache::date(), httpFullDateStringLength);
         httpString->append("\r\n\r\n");
         datePos_ = datePos;
     }
@@ -745,6 +870,8 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
     LOG_TRACE << "response(no body):"
               << std::string_view{httpString->peek(),
                                   httpString->readableBytes()};
+    MsgBufferPool::record(MsgBufferPool::Use::kHeader,
+                          httpString->readableBytes());
     if (bodyPtr_)
         httpString->append(bodyPtr_->data(), bodyPtr_->length());
     if (expriedTime_ >= 0)
@@ -757,39 +884,10 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
 std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::
     renderHeaderForHeadMethod()
 {
-    auto httpString = std::make_shared<trantor::MsgBuffer>(256);
-    if (!fullHeaderString_)
-    {
-        makeHeaderString(*httpString);
-    }
-    else
-    {
-        httpString->append(*fullHeaderString_);
-    }
-
-    // output cookies
-    if (!cookies_.empty())
-    {
-        for (auto it = cookies_.begin(); it != cookies_.end(); ++it)
-        {
-            httpString->append(it->second.cookieString());
-        }
-    }
-
-    // output Date header
-    if (!passThrough_ &&
-        drogon::HttpAppFrameworkImpl::instance().sendDateHeader())
-    {
-        httpString->append("date: ");
-        httpString->append(utils::getHttpFullDate(trantor::Date::date()),
-                           httpFullDateStringLength);
-        httpString->append("\r\n\r\n");
-    }
-    else
-    {
-        httpString->append("\r\n");
-    }
-
+    auto httpString = MsgBufferPool::acquire(MsgBufferPool::Use::kHeader);
+    renderHeaderToBuffer(*httpString);
+    MsgBufferPool::record(MsgBufferPool::Use::kHeader,
+                          httpString->readableBytes());
     return httpString;
 }
 
@@ -906,6 +1004,7 @@ void HttpResponseImpl::swap(HttpResponseImpl &that) noexcept
     using std::swap;
     headers_.swap(that.headers_);
     cookies_.swap(that.cookies_);
+    trailers_.swap(that.trailers_);
     swap(statusCode_, that.statusCode_);
     swap(version_, that.version_);
     swap(statusMessage_, that.statusMessage_);
@@ -915,8 +1014,10 @@ void HttpResponseImpl::swap(HttpResponseImpl &that) noexcept
     swap(flagForParsingContentType_, that.flagForParsingContentType_);
     swap(flagForParsingJson_, that.flagForParsingJson_);
     swap(sendfileName_, that.sendfileName_);
+    openedFile_.swap(that.openedFile_);
     swap(streamCallback_, that.streamCallback_);
     swap(asyncStreamCallback_, that.asyncStreamCallback_);
+    swap(streamEncoding_, that.streamEncoding_);
     jsonPtr_.swap(that.jsonPtr_);
     fullHeaderString_.swap(that.fullHeaderString_);
     httpString_.swap(that.httpString_);
@@ -932,6 +1033,7 @@ void HttpResponseImpl::clear()
     fullHeaderString_.reset();
     jsonParsingErrorPtr_.reset();
     sendfileName_.clear();
+    openedFile_.reset();
     if (streamCallback_)
     {
         LOG_TRACE << "Cleanup HttpResponse stream callback";
@@ -943,8 +1045,10 @@ void HttpResponseImpl::clear()
         // asyncStreamCallback_(nullptr);
         asyncStreamCallback_ = {};
     }
+    streamEncoding_ = ContentEncoding::kNone;
     headers_.clear();
     cookies_.clear();
+    trailers_.clear();
     bodyPtr_.reset();
     jsonPtr_.reset();
     expriedTime_ = -1;
@@ -955,22 +1059,14 @@ void HttpResponseImpl::clear()
 
 void HttpResponseImpl::parseJson() const
 {
-    static std::once_flag once;
-    static Json::CharReaderBuilder builder;
-    std::call_once(once, []() {
-        builder["collectComments"] = false;
-        builder["stackLimit"] =
-            static_cast<Json::UInt>(drogon::app().getJsonParserStackLimit());
-    });
-    JSONCPP_STRING errs;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
     if (bodyPtr_)
     {
         jsonPtr_ = std::make_shared<Json::Value>();
-        if (!reader->parse(bodyPtr_->data(),
-                           bodyPtr_->data() + bodyPtr_->length(),
-                           jsonPtr_.get(),
-                           &errs))
+        std::string errs;
+        if (!app().getJsonBackend()->parse(
+                std::string_view(bodyPtr_->data(), bodyPtr_->length()),
+                *jsonPtr_,
+                errs))
         {
             LOG_ERROR << errs;
             LOG_ERROR << "body: " << bodyPtr_->getString();
@@ -1003,6 +1099,38 @@ bool HttpResponseImpl::shouldBeCompressed() const
     return true;
 }
 
+#ifdef USE_ZSTD
+void HttpResponseImpl::zstdDecompress()
+{
+    if (bodyPtr_)
+    {
+        auto body = utils::zstdDecompress(
+            bodyPtr_->data(),
+            bodyPtr_->length(),
+            HttpAppFrameworkImpl::instance().getZstdDictionary());
+        removeHeaderBy("content-encoding");
+        bodyPtr_ = std::make_shared<HttpMessageStringBody>(std::move(body));
+        addHeader("content-length", std::to_string(bodyPtr_->length()));
+    }
+}
+#endif
+
+bool HttpResponseImpl::shouldStreamBeCompressed() const
+{
+    if (!streamCallback_ && !asyncStreamCallback_)
+        return false;
+    // Event streams are text, unlike the other types after
+    // CT_APPLICATION_OCTET_STREAM
+    auto type = contentType();
+    if ((type >= CT_APPLICATION_OCTET_STREAM && type != CT_TEXT_EVENT_STREAM) ||
+        !getHeaderBy("content-encoding").empty() ||
+        !getHeaderBy("content-length").empty() || !contentLengthIsAllowed())
+    {
+        return false;
+    }
+    return true;
+}
+
 void HttpResponseImpl::setContentTypeString(const char *typeString,
                                             size_t typeStringLength)
 {
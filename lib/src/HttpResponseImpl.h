@@ -16,6 +16,8 @@
 
 #include "HttpUtils.h"
 #include "HttpMessageBody.h"
+#include "OpenedFile.h"
+#include "MsgBufferPool.h"
 #include <drogon/exports.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
@@ -25,6 +27,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <algorithm>
 #include <atomic>
 #include <unordered_map>
 
@@ -177,6 +180,20 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void addHeader(const char *start, const char *colon, const char *end);
 
+    void addTrailer(std::string field, std::string value) override
+    {
+        transform(field.begin(),
+                  field.end(),
+                  field.begin(),
+                  [](unsigned char c) { return tolower(c); });
+        trailers_[std::move(field)] = std::move(value);
+    }
+
+    const SafeStringMap<std::string> &trailers() const override
+    {
+        return trailers_;
+    }
+
     void addCookie(const std::string &key, const std::string &value) override
     {
         cookies_[key] = Cookie(key, value);
@@ -231,6 +248,21 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         }
     }
 
+    void setSharedBody(std::shared_ptr<const std::string> body) override
+    {
+        if (!body)
+        {
+            bodyPtr_.reset();
+            return;
+        }
+        bodyPtr_ =
+            std::make_shared<HttpMessageSharedStringBody>(std::move(body));
+        if (passThrough_)
+        {
+            addHeader("content-length", std::to_string(bodyPtr_->length()));
+        }
+    }
+
     void redirect(const std::string &url)
     {
         headers_["location"] = url;
@@ -239,6 +271,31 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     std::shared_ptr<trantor::MsgBuffer> renderToBuffer();
     void renderToBuffer(trantor::MsgBuffer &buffer);
     std::shared_ptr<trantor::MsgBuffer> renderHeaderForHeadMethod();
+    void renderHeaderToBuffer(trantor::MsgBuffer &buffer);
+
+    /**
+     * @brief Bodies of at least this size are not copied behind the header
+     * into the output buffer, they are handed to the connection on their own.
+     */
+    static constexpr size_t separateBodyThreshold()
+    {
+        return 4096;
+    }
+
+    /**
+     * @brief Return true if the body should be sent after the header rendered
+     * by renderHeaderToBuffer() instead of being rendered with it. This
+     * also applies to cached responses, so that their clones share the body
+     * instead of each rendering a copy of it.
+     */
+    bool sendBodySeparately() const;
+
+    /**
+     * @brief The body as a string sharing the ownership of the body, or
+     * nullptr if the body is not owned by the response. The string is not
+     * changed by the connections.
+     */
+    std::shared_ptr<std::string> sharedBodyString() const;
     void clear() override;
 
     void setExpiredTime(ssize_t expiredTime) override
@@ -314,6 +371,23 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     }
 
     bool shouldBeCompressed() const;
+
+    /**
+     * @brief Return true if the body produced by the stream callback or the
+     * async stream callback can be compressed while it is sent.
+     */
+    bool shouldStreamBeCompressed() const;
+
+    void setStreamEncoding(ContentEncoding encoding)
+    {
+        streamEncoding_ = encoding;
+    }
+
+    ContentEncoding streamEncoding() const
+    {
+        return streamEncoding_;
+    }
+
     void generateBodyFromJson() const;
 
     const std::string &sendfileName() const override
@@ -347,6 +421,23 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         sendfileRange_.second = len;
     }
 
+    /**
+     * @brief Send the range of the file from its descriptor over TLS and the
+     * HTTP/2 and HTTP/3 streams, plain TCP connections send it with
+     * sendfile(). The sendfile name and range are set as well.
+     */
+    void setOpenedFile(const OpenedFilePtr &file, size_t offset, size_t len)
+    {
+        openedFile_ = file;
+        sendfileName_ = file->path();
+        setSendfileRange(offset, len);
+    }
+
+    const OpenedFilePtr &openedFile() const
+    {
+        return openedFile_;
+    }
+
     const std::function<std::size_t(char *, std::size_t)> &streamCallback()
         const override
     {
@@ -380,7 +471,9 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void makeHeaderString()
     {
-        fullHeaderString_ = std::make_shared<trantor::MsgBuffer>(128);
+        // Kept with the cached response, not pooled
+        fullHeaderString_ = std::make_shared<trantor::MsgBuffer>((std::max)(
+            MsgBufferPool::sizeHint(MsgBufferPool::Use::kHeader), size_t{128}));
         makeHeaderString(*fullHeaderString_);
     }
 
@@ -425,6 +518,9 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
             addHeader("content-length", std::to_string(bodyPtr_->length()));
         }
     }
+#endif
+#ifdef USE_ZSTD
+    void zstdDecompress();
 #endif
     ~HttpResponseImpl() override = default;
 
@@ -506,6 +602,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     SafeStringMap<std::string> headers_;
     SafeStringMap<Cookie> cookies_;
+    SafeStringMap<std::string> trailers_;
 
     int customStatusCode_{-1};
     HttpStatusCode statusCode_{kUnknown};
@@ -518,9 +615,11 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     ssize_t expriedTime_{-1};
     std::string sendfileName_;
     SendfileRange sendfileRange_{0, 0};
+    OpenedFilePtr openedFile_;
     std::function<std::size_t(char *, std::size_t)> streamCallback_;
     std::function<void(ResponseStreamPtr)> asyncStreamCallback_;
     bool asyncStreamDisableKickoff_{false};
+    ContentEncoding streamEncoding_{ContentEncoding::kNone};
 
     mutable std::shared_ptr<Json::Value> jsonPtr_;
 
@@ -122,6 +122,15 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
                 {
                     responsePtr_->addHeader(buf->peek(), colon, crlf);
                 }
+                else if (responsePtr_->statusCode() >= k100Continue &&
+                         responsePtr_->statusCode() < k200OK &&
+                         responsePtr_->statusCode() != k101SwitchingProtocols)
+                {
+                    // An interim response such as 100 (Continue) or 103
+                    // (Early Hints) has no body, the final one follows
+                    status_ = HttpResponseParseStatus::kGotAll;
+                    hasMore = false;
+                }
                 else
                 {
                     const std::string &len =
@@ -0,0 +1,220 @@
+/**
+ *
+ *  @file HttpScanner.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpScanner.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define DROGON_SCANNER_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define DROGON_SCANNER_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define DROGON_SCANNER_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+inline unsigned countTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+#if !defined(DROGON_SCANNER_SSE2) && !defined(DROGON_SCANNER_NEON)
+const char *findCharScalar(const char *begin, const char *end, char c)
+{
+    auto p = static_cast<const char *>(memchr(begin, c, end - begin));
+    return p ? p : end;
+}
+#endif
+
+#ifdef DROGON_SCANNER_SSE2
+const char *findCharSse2(const char *begin, const char *end, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - begin >= 16)
+    {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        auto mask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask)
+            return begin + countTrailingZeros(mask);
+        begin += 16;
+    }
+    while (begin < end && *begin != c)
+        ++begin;
+    return begin;
+}
+#endif
+
+#ifdef DROGON_SCANNER_AVX2
+__attribute__((target("avx2"))) const char *findCharAvx2(const char *begin,
+                                                         const char *end,
+                                                         char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    while (end - begin >= 32)
+    {
+        __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        auto mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (mask)
+            return begin + countTrailingZeros(mask);
+        begin += 32;
+    }
+    return findCharSse2(begin, end, c);
+}
+#endif
+
+#ifdef DROGON_SCANNER_NEON
+inline unsigned countTrailingZeros64(uint64_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+const char *findCharNeon(const char *begin, const char *end, char c)
+{
+    const uint8x16_t needle = vdupq_n_u8(static_cast<uint8_t>(c));
+    while (end - begin >= 16)
+    {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(begin));
+        uint8x16_t eq = vceqq_u8(chunk, needle);
+        // Narrow every byte of the comparison to 4 bits
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask)
+            return begin + (countTrailingZeros64(mask) >> 2);
+        begin += 16;
+    }
+    while (begin < end && *begin != c)
+        ++begin;
+    return begin;
+}
+#endif
+
+using FindCharFunc = const char *(*)(const char *, const char *, char);
+
+struct Implementation
+{
+    FindCharFunc findChar;
+    const char *name;
+};
+
+Implementation selectImplementation()
+{
+#ifdef DROGON_SCANNER_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {findCharAvx2, "avx2"};
+#endif
+#if defined(DROGON_SCANNER_SSE2)
+    return {findCharSse2, "sse2"};
+#elif defined(DROGON_SCANNER_NEON)
+    return {findCharNeon, "neon"};
+#else
+    return {findCharScalar, "scalar"};
+#endif
+}
+
+const Implementation &implementation()
+{
+    static const Implementation impl = selectImplementation();
+    return impl;
+}
+
+// tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." /
+//         "^" / "_" / "`" / "|" / "~" / DIGIT / ALPHA
+struct TokenTable
+{
+    bool chars[256]{};
+
+    TokenTable()
+    {
+        for (int c = '0'; c <= '9'; ++c)
+            chars[c] = true;
+        for (int c = 'a'; c <= 'z'; ++c)
+            chars[c] = true;
+        for (int c = 'A'; c <= 'Z'; ++c)
+            chars[c] = true;
+        for (auto c : "!#$%&'*+-.^_`|~")
+        {
+            if (c)
+                chars[static_cast<unsigned char>(c)] = true;
+        }
+    }
+};
+
+const TokenTable tokenTable;
+}  // namespace
+
+const char *http_scanner::findChar(const char *begin, const char *end, char c)
+{
+    return implementation().findChar(begin, end, c);
+}
+
+const char *http_scanner::findCRLF(const char *begin, const char *end)
+{
+    auto findCharImpl = implementation().findChar;
+    while (begin < end)
+    {
+        auto cr = findCharImpl(begin, end, '\r');
+        if (cr + 1 >= end)
+            return nullptr;
+        if (cr[1] == '\n')
+            return cr;
+        begin = cr + 1;
+    }
+    return nullptr;
+}
+
+bool http_scanner::isToken(const char *begin, const char *end)
+{
+    if (begin >= end)
+        return false;
+    for (; begin < end; ++begin)
+    {
+        if (!tokenTable.chars[static_cast<unsigned char>(*begin)])
+            return false;
+    }
+    return true;
+}
+
+const char *http_scanner::implementationName()
+{
+    return implementation().name;
+}
@@ -0,0 +1,51 @@
+/**
+ *
+ *  @file HttpScanner.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+
+namespace drogon
+{
+namespace http_scanner
+{
+/**
+ * @brief Find the first "\r\n" in [begin, end).
+ *
+ * The bytes are scanned 16 (SSE2/NEON) or 32 (AVX2) at a time, the
+ * implementation is chosen once at runtime according to the CPU features.
+ *
+ * @return The position of '\r' or nullptr if there is no CRLF.
+ */
+DROGON_EXPORT const char *findCRLF(const char *begin, const char *end);
+
+/**
+ * @brief Find the first occurrence of c in [begin, end).
+ *
+ * @return The position of the character or end if it is not found.
+ */
+DROGON_EXPORT const char *findChar(const char *begin, const char *end, char c);
+
+/**
+ * @brief Check that [begin, end) is a non-empty token (rfc7230-3.2.6), which
+ * is what header field names and methods are made of.
+ */
+DROGON_EXPORT bool isToken(const char *begin, const char *end);
+
+/**
+ * @brief The name of the implementation selected for this CPU, one of
+ * "avx2", "sse2", "neon" or "scalar".
+ */
+DROGON_EXPORT const char *implementationName();
+}  // namespace http_scanner
+}  // namespace drogon
@@ -13,22 +13,45 @@
  */
 
 #include "HttpServer.h"
+#include <drogon/Grpc.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <chrono>
+#include <fstream>
 #include <functional>
 #include <memory>
+#include <type_traits>
 #include <utility>
 #include "AOPAdvice.h"
+#include "BodyMemoryBudget.h"
+#include "BuiltinMetrics.h"
+#include "CompressedBodyCache.h"
+#include "CpuProfiler.h"
+#include "DynamicETag.h"
 #include "MiddlewaresFunction.h"
+#include "HandlerLoopPool.h"
+#include "HotRestart.h"
+#include "Http2ServerConnection.h"
+#ifdef USE_QUICHE
+#include "Http3ServerConnection.h"
+#endif
 #include "HttpAppFrameworkImpl.h"
+#include "HttpChunking.h"
 #include "HttpConnectionLimit.h"
 #include "HttpControllerBinder.h"
 #include "HttpRequestImpl.h"
 #include "HttpRequestParser.h"
 #include "HttpResponseImpl.h"
 #include "HttpControllersRouter.h"
+#include "LiveConnections.h"
+#include "LoopHandoff.h"
+#include "LoopWatchdog.h"
+#include "MsgBufferPool.h"
+#include "ProxyProtocol.h"
 #include "StaticFileRouter.h"
+#include "StreamCompressor.h"
+#include "Tracing.h"
 #include "WebSocketConnectionImpl.h"
 #include "impl_forwards.h"
 
@@ -46,6 +69,8 @@ using namespace drogon;
 using namespace trantor;
 
 static inline bool isWebSocket(const HttpRequestImplPtr &req);
+static void enableWebSocketDeflate(const HttpResponsePtr &resp,
+                                   const WebSocketConnectionImplPtr &wsConn);
 static inline HttpResponsePtr tryDecompressRequest(
     const HttpRequestImplPtr &req);
 static inline bool passSyncAdvices(
@@ -57,6 +82,12 @@ static inline HttpResponsePtr getCompressedResponse(
     const HttpRequestImplPtr &req,
     const HttpResponsePtr &response,
     bool isHeadMethod);
+static void setEarlyHintsSender(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser,
+    const HttpRequestImplPtr &req);
+static inline void finishPhaseTracing(const HttpRequestImplPtr &req,
+                                      HttpResponsePtr &resp);
 
 static void handleInvalidHttpMethod(
     const HttpRequestImplPtr &req,
@@ -78,13 +109,17 @@ HttpServer::HttpServer(EventLoop *loop,
 {
     server_.setConnectionCallback(
         [this](const trantor::TcpConnectionPtr &conn) {
-            onConnection(conn);
+            onConnection(conn,
+                         proxyProtocol_,
+                         trantorKicksOffIdleConnections_
+                             ? 0
+                             : HttpAppFrameworkImpl::instance()
+                                   .getIdleConnectionTimeout());
             if (connectionCallback_)
                 connectionCallback_(conn);
         });
     server_.setRecvMessageCallback(onMessage);
-    server_.kickoffIdleConnections(
-        HttpAppFrameworkImpl::instance().getIdleConnectionTimeout());
+    idleTimeout_ = HttpAppFrameworkImpl::instance().getIdleConnectionTimeout();
 }
 
 HttpServer::~HttpServer() = default;
@@ -109,36 +144,57 @@ void HttpServer::stop()
     server_.stop();
 }
 
-void HttpServer::onConnection(const TcpConnectionPtr &conn)
+void HttpServer::onConnection(const TcpConnectionPtr &conn,
+                              bool proxyProtocol,
+                              size_t idleTimeout)
 {
     if (conn->connected())
     {
         auto parser = std::make_shared<HttpRequestParser>(conn);
         parser->reset();
         conn->setContext(parser);
-        if (!HttpConnectionLimit::instance().tryAddConnection(conn))
+        parser->startIdleTimeout(idleTimeout);
+        BuiltinMetrics::instance().connectionOpened(conn->getLoop());
+        LiveConnections::instance().opened(conn);
+        if (proxyProtocol)
         {
-            LOG_ERROR << "too much connections!force close!";
-            conn->forceClose();
-            return;
+            // Admitted with the address of the client once the header of the
+            // load balancer is received
+            parser->expectProxyHeader();
         }
-        if (!AopAdvice::instance().passNewConnectionAdvices(conn))
+        else if (!admitConnection(conn, parser))
         {
-            conn->forceClose();
+            return;
         }
+        HotRestart::instance().connectionOpened(conn);
     }
     else if (conn->disconnected())
     {
         LOG_TRACE << "conn disconnected!";
-        HttpConnectionLimit::instance().releaseConnection(conn);
         auto requestParser = conn->getContext<HttpRequestParser>();
+        // Without a context, the connection to the SSL port is closed
+        // before the SSL handshake
+        if (requestParser && !requestParser->waitingForProxyHeader())
+        {
+            HttpConnectionLimit::instance().releaseConnection(
+                requestParser->peerAddr(conn));
+        }
+        HotRestart::instance().connectionClosed(conn);
+        BuiltinMetrics::instance().connectionClosed(conn->getLoop());
+        LiveConnections::instance().closed(conn);
         if (requestParser)
         {
-            if (requestParser->webSocketConn())
+            requestParser->stopTimeouts();
+            if (requestParser->http2Conn())
+            {
+                requestParser->http2Conn()->onClose();
+            }
+            else if (requestParser->webSocketConn())
             {
                 requestParser->webSocketConn()->onClose();
             }
-            else if (requestParser->requestImpl()->isStreamMode())
+            else if (requestParser->requestImpl() &&
+                     requestParser->requestImpl()->isStreamMode())
             {
                 requestParser->requestImpl()->streamError(
                     std::make_exception_ptr(
@@ -150,6 +206,53 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
     }
 }
 
+bool HttpServer::admitConnection(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser)
+{
+    auto &peer = requestParser->peerAddr(conn);
+    if (!HttpConnectionLimit::instance().tryAddConnection(peer))
+    {
+        LOG_ERROR << "too much connections!force close!";
+        conn->forceClose();
+        return false;
+    }
+    if (!AopAdvice::instance().passNewConnectionAdvices(
+            requestParser->localAddr(conn), peer))
+    {
+        conn->forceClose();
+        return false;
+    }
+    return true;
+}
+
+bool HttpServer::receiveProxyHeader(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser,
+    MsgBuffer *buf)
+{
+    proxy_protocol::Addresses addresses;
+    switch (proxy_protocol::parse(buf, addresses))
+    {
+        case proxy_protocol::ParseResult::kIncomplete:
+            return false;
+        case proxy_protocol::ParseResult::kInvalid:
+            LOG_DEBUG << "Invalid PROXY protocol header from "
+                      << conn->peerAddr().toIpPort();
+            buf->retrieveAll();
+            conn->forceClose();
+            return false;
+        case proxy_protocol::ParseResult::kDone:
+            break;
+    }
+    requestParser->proxyHeaderReceived();
+    if (addresses.proxied)
+    {
+        requestParser->setProxiedAddresses(addresses.peer, addresses.local);
+    }
+    return admitConnection(conn, requestParser) && buf->readableBytes() > 0;
+}
+
 void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
 {
     if (!conn->hasContext())
@@ -157,12 +260,42 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     auto requestParser = conn->getContext<HttpRequestParser>();
     if (!requestParser)
         return;
+    requestParser->touch();
+    if (requestParser->waitingForProxyHeader() &&
+        !receiveProxyHeader(conn, requestParser, buf))
+    {
+        return;
+    }
     if (requestParser->webSocketConn())
     {
         // Websocket payload
         requestParser->webSocketConn()->onNewMessage(conn, buf);
         return;
     }
+    if (requestParser->http2Conn())
+    {
+        requestParser->http2Conn()->onMessage(buf);
+        return;
+    }
+    if (HttpAppFrameworkImpl::instance().isHttp2Enabled() &&
+        requestParser->numberOfRequestsParsed() == 0 &&
+        requestParser->atRequestStart())
+    {
+        // HTTP/2 is negotiated by ALPN, or known in advance by the clients
+        // which start with the connection preface
+        auto &preface = http2::kConnectionPreface;
+        auto len = (std::min)(buf->readableBytes(), preface.length());
+        bool isPreface =
+            std::string_view(buf->peek(), len) == preface.substr(0, len);
+        if (conn->applicationProtocol() == "h2" ||
+            (isPreface && len == preface.length()))
+        {
+            startHttp2(conn, requestParser)->onMessage(buf);
+            return;
+        }
+        if (isPreface)
+            return;
+    }
 
     auto &requests = requestParser->getRequestBuffer();
     // With the pipelining feature or web socket, it is possible to receive
@@ -217,12 +350,16 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
         }
         if (parseRes == 0)
         {
+            if (requestParser->waitingForBodyMemory())
+            {
+                waitForBodyMemory(conn, requestParser, buf);
+            }
             break;
         }
         if (parseRes >= 2 || parseRes == 1 && !req->isStreamMode())
         {
-            req->setPeerAddr(conn->peerAddr());
-            req->setLocalAddr(conn->localAddr());
+            req->setPeerAddr(requestParser->peerAddr(conn));
+            req->setLocalAddr(requestParser->localAddr(conn));
             req->setCreationDate(trantor::Date::date());
             req->setSecure(conn->isSSLConnection());
             req->setPeerCertificate(conn->peerCertificate());
@@ -238,6 +375,21 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
                 req->streamFinish();
             }
             requestParser->reset();
+            // The upgrade to h2c of the first request, which has no body
+            if (parseRes == 1 && requests.size() == 1 &&
+                requestParser->numberOfRequestsParsed() == 1 &&
+                !conn->isSSLConnection() && !requests[0]->isStreamMode() &&
+                requests[0]->bodyLength() == 0 &&
+                HttpAppFrameworkImpl::instance().isHttp2Enabled() &&
+                Http2ServerConnection::isUpgradeRequest(requests[0]))
+            {
+                auto upgradeReq = std::move(requests[0]);
+                requests.clear();
+                auto h2 = startHttp2(conn, requestParser, upgradeReq);
+                if (buf->readableBytes() > 0)
+                    h2->onMessage(buf);
+                return;
+            }
         }
     }
     if (!requests.empty())
@@ -247,6 +399,42 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     }
 }
 
+void HttpServer::waitForBodyMemory(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser,
+    MsgBuffer *buf)
+{
+    // The received data stays in the buffer, and the connection stops reading
+    // until other requests release the memory of their bodies.
+    conn->stopRead();
+    BodyMemoryBudget::instance().waitFor(
+        requestParser->remainContentLength(),
+        conn->getLoop(),
+        [weakConn = std::weak_ptr<trantor::TcpConnection>(conn), buf]() {
+            auto conn = weakConn.lock();
+            if (!conn || !conn->connected())
+                return;
+            conn->startRead();
+            onMessage(conn, buf);
+        });
+}
+
+Http2ServerConnectionPtr HttpServer::startHttp2(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser,
+    const HttpRequestImplPtr &upgradeReq)
+{
+    auto h2 = std::make_shared<Http2ServerConnection>(conn, onHttp2Request);
+    h2->setAddresses(requestParser->peerAddr(conn),
+                     requestParser->localAddr(conn));
+    requestParser->setHttp2Connection(h2);
+    if (upgradeReq)
+        h2->upgrade(upgradeReq);
+    else
+        h2->start();
+    return h2;
+}
+
 struct CallbackParamPack
 {
     CallbackParamPack(trantor::TcpConnectionPtr conn,
@@ -283,12 +471,14 @@ void HttpServer::onRequests(
     {
         auto &req = requests[0];
         req->startProcessing();
+        req->stampPhase(RequestPhase::kParsed);
         if (passSyncAdvices(req,
                             requestParser,
                             false /* Not pipelined */,
                             false /* Not HEAD */))
         {
             auto wsConn = std::make_shared<WebSocketConnectionImpl>(conn);
+            wsConn->setAddresses(req->localAddr(), req->peerAddr());
             wsConn->setPingMessage("", std::chrono::seconds{30});
             onWebsocketRequest(
                 req,
@@ -299,8 +489,10 @@ void HttpServer::onRequests(
                         auto resp = HttpAppFrameworkImpl::instance()
                                         .handleSessionForResponse(req, resp0);
                         AopAdvice::instance().passPreSendingAdvices(req, resp);
+                        BuiltinMetrics::instance().responseSending(req, resp);
                         if (resp->statusCode() == k101SwitchingProtocols)
                         {
+                            enableWebSocketDeflate(resp, wsConn);
                             requestParser->setWebsockConnection(wsConn);
                         }
                         auto httpString =
@@ -320,6 +512,7 @@ void HttpServer::onRequests(
                           requestParser->getResponseBuffer(),
                           requestParser->getBuffer());
             requestParser->getResponseBuffer().clear();
+            requestParser->releaseBuffer();
         }
         return;
     }
@@ -349,6 +542,8 @@ void HttpServer::onRequests(
     for (auto &req : requests)
     {
         req->startProcessing();
+        req->stampPhase(RequestPhase::kParsed);
+        Tracing::instance().requestStarted(req);
         bool isHeadMethod = (req->method() == Head);
         if (isHeadMethod)
         {
@@ -378,6 +573,7 @@ void HttpServer::onRequests(
         }
         else
         {
+            setEarlyHintsSender(conn, requestParser, req);
             // `handleResponse()` callback may be called synchronously. In this
             // case, the generated response should not be sent right away, but
             // be queued in buffer instead. Those ready responses will be sent
@@ -386,12 +582,12 @@ void HttpServer::onRequests(
             // By doing this, we could reduce some system calls when sending
             // through socket. In order to achieve this, we create a
             // `respReady` variable.
-            onHttpRequest(req,
-                          [respReadyPtr = &respReady,
-                           paramPack = std::move(paramPack)](
-                              const HttpResponsePtr &response) {
-                              handleResponse(response, paramPack, respReadyPtr);
-                          });
+            dispatchHttpRequest(
+                req,
+                [respReadyPtr = &respReady, paramPack = std::move(paramPack)](
+                    const HttpResponsePtr &response) {
+                    handleResponse(response, paramPack, respReadyPtr);
+                });
         }
         if (!reqPipelined && !respReady)
         {
@@ -405,9 +601,51 @@ void HttpServer::onRequests(
                       requestParser->getResponseBuffer(),
                       requestParser->getBuffer());
         requestParser->getResponseBuffer().clear();
+        requestParser->releaseBuffer();
     }
 }
 
+void HttpServer::dispatchHttpRequest(
+    const HttpRequestImplPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    auto loop =
+        HttpAppFrameworkImpl::instance().loopAffinity().loopFor(*req);
+    if (!loop)
+    {
+        auto &handlerLoops = HandlerLoopPool::instance();
+        if (!handlerLoops.started())
+        {
+            onHttpRequest(req, std::move(callback));
+            return;
+        }
+        // Handled in a handler loop, the IO loop of the connection only
+        // parses the request and sends the response
+        handlerLoops.run([req, callback = std::move(callback)](
+                             trantor::EventLoop *loop) mutable {
+            req->setLoop(loop);
+            onHttpRequest(req,
+                          [loop, callback = std::move(callback)](
+                              const HttpResponsePtr &resp) mutable {
+                              if (loop)
+                              {
+                                  HandlerLoopPool::instance().done(loop);
+                                  loop = nullptr;
+                              }
+                              callback(resp);
+                          });
+        });
+        return;
+    }
+    // Handled by the loop of its key, the response goes back to the loop of
+    // the connection like the ones of the handlers running in other threads
+    req->setLoop(loop);
+    LoopHandoff::runInLoop(
+        loop, [req, callback = std::move(callback)]() mutable {
+            onHttpRequest(req, std::move(callback));
+        });
+}
+
 void HttpServer::onHttpRequest(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
@@ -427,7 +665,39 @@ void HttpServer::onHttpRequest(
     }
 
     // TODO: move session related codes to its own singleton class
-    HttpAppFrameworkImpl::instance().findSessionForRequest(req);
+    auto &frameworkImpl = HttpAppFrameworkImpl::instance();
+    if (req->method() == Get)
+    {
+        // Sent before the sessions, the middlewares and the handler
+        if (auto links = frameworkImpl.getEarlyHints(req->path()))
+            req->sendEarlyHints(*links);
+    }
+    auto requestDeadline = frameworkImpl.getRequestDeadline();
+    if (requestDeadline > 0 && !req->deadline())
+    {
+        // Counted from the arrival of the request
+        auto elapsed = trantor::Date::now().microSecondsSinceEpoch() -
+                       req->creationDate().microSecondsSinceEpoch();
+        req->setDeadline(std::chrono::steady_clock::now() +
+                         std::chrono::microseconds(
+                             static_cast<int64_t>(requestDeadline * 1e6) -
+                             elapsed));
+    }
+    if (!frameworkImpl.findSessionForRequest(req))
+    {
+        frameworkImpl.loadSessionForRequest(
+            req, [req, callback = std::move(callback)]() mutable {
+                httpRequestPreRouting(req, std::move(callback));
+            });
+        return;
+    }
+    httpRequestPreRouting(req, std::move(callback));
+}
+
+void HttpServer::httpRequestPreRouting(
+    const HttpRequestImplPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
     // pre-routing aop
     auto &aop = AopAdvice::instance();
     aop.passPreRoutingObservers(req);
@@ -456,9 +726,11 @@ void HttpServer::httpRequestRouting(
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
     // How to access router here?? Make router class singleton?
+    req->stampPhase(RequestPhase::kRouting);
     RouteResult result = HttpControllersRouter::instance().route(req);
     if (result.result == RouteResult::Success)
     {
+        req->stampPhase(RequestPhase::kRouted);
         HttpRequestParamPack pack{std::move(result.binderPtr),
                                   std::move(callback)};
         requestPostRouting(req, std::move(pack));
@@ -497,7 +769,10 @@ void HttpServer::requestPostRouting(const HttpRequestImplPtr &req, Pack &&pack)
             auto contentLength = req->getContentLengthHeaderValue();
             if (contentLength.has_value())
             {
-                req->reserveBodySize(contentLength.value());
+                // Part of the body may be received, it can't wait for the
+                // memory budget, appendToBody() moves it to a temporary file
+                // if the budget is used up.
+                (void)req->reserveBodySize(contentLength.value());
             }
             req->waitForStreamFinish([weakReq = std::weak_ptr(req),
                                       pack =
@@ -524,6 +799,12 @@ void HttpServer::requestPostRouting(const HttpRequestImplPtr &req, Pack &&pack)
         }
     }
 
+    if (pack.binderPtr->passThrough_)
+    {
+        requestPreHandling(req, std::forward<Pack>(pack));
+        return;
+    }
+
     // post-routing aop
     auto &aop = AopAdvice::instance();
     aop.passPostRoutingObservers(req);
@@ -561,8 +842,7 @@ void HttpServer::requestPassMiddlewares(const HttpRequestImplPtr &req,
 
     auto callback = std::move(pack.callback);
     pack.callback = nullptr;
-    middlewares_function::passMiddlewares(
-        middlewares,
+    middlewares.pass(
         req,
         std::move(callback),
         [req, pack = std::forward<Pack>(pack)](
@@ -584,10 +864,14 @@ void HttpServer::requestPreHandling(const HttpRequestImplPtr &req, Pack &&pack)
         return;
     }
 
+    BuiltinMetrics::instance().requestHandling(req);
+    req->stampPhase(RequestPhase::kHandling);
     // pre-handling aop
     auto &aop = AopAdvice::instance();
-    aop.passPreHandlingObservers(req);
-    if (!aop.hasPreHandlingAdvices())
+    bool passThrough = pack.binderPtr->passThrough_;
+    if (!passThrough)
+        aop.passPreHandlingObservers(req);
+    if (passThrough || !aop.hasPreHandlingAdvices())
     {
         if constexpr (std::is_same_v<std::decay_t<Pack>, HttpRequestParamPack>)
         {
@@ -646,6 +930,7 @@ void HttpServer::httpRequestHandling(
         {
             // use cached response!
             LOG_TRACE << "Use cached response";
+            req->stampPhase(RequestPhase::kHandled);
 
             // post-handling aop
             AopAdvice::instance().passPostHandlingAdvices(req, cachedResp);
@@ -659,11 +944,11 @@ void HttpServer::httpRequestHandling(
     }
 
     auto &binderRef = *binderPtr;
-    binderRef.handleRequest(
-        req,
-        // This is the actual callback being passed to controller
+    // This is the actual callback being passed to controller
+    auto handlerCallback =
         [req, binderPtr = std::move(binderPtr), callback = std::move(callback)](
             const HttpResponsePtr &resp) mutable {
+            req->stampPhase(RequestPhase::kHandled);
             // Check if we need to cache the response
             if (resp->expiredTime() >= 0 && resp->statusCode() != k404NotFound)
             {
@@ -675,8 +960,8 @@ void HttpServer::httpRequestHandling(
                 }
                 else
                 {
-                    loop->queueInLoop(
-                        [binderPtr = std::move(binderPtr), resp]() {
+                    LoopHandoff::runInLoop(
+                        loop, [binderPtr = std::move(binderPtr), resp]() {
                             binderPtr->responseCache_.setThreadData(resp);
                         });
                 }
@@ -684,7 +969,45 @@ void HttpServer::httpRequestHandling(
             // post-handling aop
             AopAdvice::instance().passPostHandlingAdvices(req, resp);
             callback(resp);
-        });
+        };
+    if (binderRef.offload_)
+    {
+        // The binder is kept alive by the callback
+        HttpAppFrameworkImpl::instance().runInComputePool(
+            [req,
+             binder = &binderRef,
+             handlerCallback = std::move(handlerCallback)]() mutable {
+                internal::TraceScope traceScope(req->traceContext());
+#ifdef __cpp_impl_coroutine
+                internal::DeadlineScope deadlineScope(req->deadline());
+#endif
+                CpuProfiler::RouteScope profilerScope(
+                    req->matchedPathPattern());
+                // Answer from the IO loop of the request
+                binder->handleRequest(
+                    req,
+                    [loop = req->getLoop(),
+                     handlerCallback = std::move(handlerCallback)](
+                        const HttpResponsePtr &resp) mutable {
+                        LoopHandoff::runInLoop(
+                            loop,
+                            [handlerCallback = std::move(handlerCallback),
+                             resp]() mutable { handlerCallback(resp); });
+                    });
+            });
+        return;
+    }
+    // The client calls of the handler are spans of the trace of the request
+    internal::TraceScope traceScope(req->traceContext());
+#ifdef __cpp_impl_coroutine
+    // The coroutines of the handler inherit the deadline of the request
+    internal::DeadlineScope deadlineScope(req->deadline());
+#endif
+    // Named in the logs of the loop watchdog if it blocks the loop
+    LoopWatchdog::HandlerScope watchdogScope(req);
+    // The CPU samples taken in the handler are labelled with its route
+    CpuProfiler::RouteScope profilerScope(req->matchedPathPattern());
+    binderRef.handleRequest(req, std::move(handlerCallback));
 }
 
 void HttpServer::onWebsocketRequest(
@@ -692,7 +1015,28 @@ void HttpServer::onWebsocketRequest(
     std::function<void(const HttpResponsePtr &)> &&callback,
     WebSocketConnectionImplPtr &&wsConnPtr)
 {
-    HttpAppFrameworkImpl::instance().findSessionForRequest(req);
+    auto &frameworkImpl = HttpAppFrameworkImpl::instance();
+    if (!frameworkImpl.findSessionForRequest(req))
+    {
+        frameworkImpl.loadSessionForRequest(
+            req,
+            [req,
+             callback = std::move(callback),
+             wsConnPtr = std::move(wsConnPtr)]() mutable {
+                websocketRequestPreRouting(req,
+                                           std::move(callback),
+                                           std::move(wsConnPtr));
+            });
+        return;
+    }
+    websocketRequestPreRouting(req, std::move(callback), std::move(wsConnPtr));
+}
+
+void HttpServer::websocketRequestPreRouting(
+    const HttpRequestImplPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback,
+    WebSocketConnectionImplPtr &&wsConnPtr)
+{
     // pre-routing aop
     auto &aop = AopAdvice::instance();
     aop.passPreRoutingObservers(req);
@@ -785,15 +1129,25 @@ void HttpServer::handleResponse(
                      "Ignoring later response";
         return;
     }
+    req->closeEarlyHints();
 
     auto resp =
         HttpAppFrameworkImpl::instance().handleSessionForResponse(req,
                                                                   response);
+    if (HttpAppFrameworkImpl::instance().useDynamicETags())
+        resp = dynamic_etag::apply(req, resp);
     resp->setVersion(req->getVersion());
-    resp->setCloseConnection(!req->keepAlive());
+    // A draining process closes the connections after their responses
+    resp->setCloseConnection(!req->keepAlive() ||
+                             HotRestart::instance().draining());
+    req->stampPhase(RequestPhase::kSending);
     AopAdvice::instance().passPreSendingAdvices(req, resp);
+    BuiltinMetrics::instance().responseSending(req, resp);
+    Tracing::instance().responseSending(req, resp);
 
+    req->stampPhase(RequestPhase::kCompressing);
     auto newResp = getCompressedResponse(req, resp, isHeadMethod);
+    finishPhaseTracing(req, newResp);
     if (conn->getLoop()->isInLoopThread())
     {
         /*
@@ -815,21 +1169,26 @@ void HttpServer::handleResponse(
         }
         if (requestParser->pushResponseToPipelining(req, std::move(newResp)))
         {
-            auto &responseBuffer = requestParser->getResponseBuffer();
-            requestParser->popReadyResponses(responseBuffer);
-            if (!*loopFlagPtr)
+            if (*loopFlagPtr)
+            {
+                // `onRequests()` sends the ready responses after its loop
+                requestParser->popReadyResponses(
+                    requestParser->getResponseBuffer());
+            }
+            else
             {
                 // We have passed the point where `onRequests()` sends
                 // responses. So, at here we should send ready responses from
                 // the beginning of pipeline queue.
-                sendResponses(conn, responseBuffer, requestParser->getBuffer());
-                responseBuffer.clear();
+                flushPipelinedResponses(conn, requestParser);
             }
         }
     }
     else
     {
-        conn->getLoop()->queueInLoop(
+        // Batched with the other responses completed off the loop
+        LoopHandoff::runInLoop(
+            conn->getLoop(),
             [conn, req, requestParser, newResp = std::move(newResp)]() mutable {
                 if (!conn->connected())
                 {
@@ -838,129 +1197,223 @@ void HttpServer::handleResponse(
                 if (requestParser->pushResponseToPipelining(req,
                                                             std::move(newResp)))
                 {
-                    std::vector<std::pair<HttpResponsePtr, bool>> responses;
-                    requestParser->popReadyResponses(responses);
-                    sendResponses(conn, responses, requestParser->getBuffer());
+                    flushPipelinedResponses(conn, requestParser);
                 }
             });
     }
 }
 
-struct ChunkingParams
+void HttpServer::flushPipelinedResponses(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser)
+{
+    if (requestParser->pipelineFlushQueued())
+        return;
+    if (requestParser->numberOfRequestsInPipelining() > 1)
+    {
+        // The responses which complete in this loop iteration, out of order
+        // or not, are sent with one write at the start of the next one
+        requestParser->setPipelineFlushQueued(true);
+        conn->getLoop()->queueInLoop([conn, requestParser]() {
+            requestParser->setPipelineFlushQueued(false);
+            if (!conn->connected())
+                return;
+            auto &responses = requestParser->getResponseBuffer();
+            requestParser->popReadyResponses(responses);
+            sendResponses(conn, responses, requestParser->getBuffer());
+            responses.clear();
+            requestParser->releaseBuffer();
+        });
+        return;
+    }
+    // Nothing else can join the write of the last response
+    auto &responses = requestParser->getResponseBuffer();
+    requestParser->popReadyResponses(responses);
+    sendResponses(conn, responses, requestParser->getBuffer());
+    responses.clear();
+    requestParser->releaseBuffer();
+}
+
+struct CompressingStreamParams
 {
     using DataCallback = std::function<std::size_t(char *, std::size_t)>;
 
-    explicit ChunkingParams(DataCallback cb) : dataCallback(std::move(cb))
+    CompressingStreamParams(DataCallback cb,
+                            std::unique_ptr<StreamCompressor> comp)
+        : dataCallback(std::move(cb)),
+          compressor(std::move(comp)),
+          input(16384, '\0')
     {
     }
 
     DataCallback dataCallback;
+    std::unique_ptr<StreamCompressor> compressor;
+    std::string input;
+    std::string output;
+    std::size_t outputPos{0};
     bool bFinished{false};
-#ifndef NDEBUG  // defined by CMake for release build
-    std::size_t nDataReturned{0};
-#endif
 };
 
-static std::size_t chunkingCallback(
-    const std::shared_ptr<ChunkingParams> &cbParams,
+static std::size_t compressingCallback(
+    const std::shared_ptr<CompressingStreamParams> &cbParams,
     char *pBuffer,
     std::size_t nSize)
 {
-    if (!cbParams)
-        return 0;
     // Cleanup
     if (pBuffer == nullptr)
     {
-        LOG_TRACE << "Chunking callback cleanup";
-        if (cbParams && cbParams->dataCallback)
+        if (cbParams->dataCallback)
         {
             cbParams->dataCallback(pBuffer, nSize);
             cbParams->dataCallback = {};
         }
         return 0;
     }
-    // Terminal chunk already returned
-    if (cbParams->bFinished)
+    // Pull data from the user callback until there are compressed bytes to
+    // return, the compressor buffers small pieces of data.
+    while (cbParams->outputPos == cbParams->output.length())
     {
-        LOG_TRACE << "Chunking callback has no more data";
-#ifndef NDEBUG  // defined by CMake for release build
-        LOG_TRACE << "Chunking callback: total data returned: "
-                  << cbParams->nDataReturned << " bytes";
-#endif
-        return 0;
+        cbParams->output.clear();
+        cbParams->outputPos = 0;
+        if (cbParams->bFinished)
+            return 0;
+        auto nDataSize = cbParams->dataCallback(&cbParams->input[0],
+                                                cbParams->input.length());
+        bool ok;
+        if (nDataSize == 0)
+        {
+            cbParams->bFinished = true;
+            ok = cbParams->compressor->finish(cbParams->output);
+        }
+        else
+        {
+            ok = cbParams->compressor->compress(cbParams->input.data(),
+                                                nDataSize,
+                                                false,
+                                                cbParams->output);
+        }
+        if (!ok)
+        {
+            LOG_ERROR << "Failed to compress the stream response";
+            cbParams->bFinished = true;
+            cbParams->output.clear();
+            return 0;
+        }
     }
+    auto len =
+        (std::min)(nSize, cbParams->output.length() - cbParams->outputPos);
+    memcpy(pBuffer, cbParams->output.data() + cbParams->outputPos, len);
+    cbParams->outputPos += len;
+    return len;
+}
 
-    // Reserve size to prepend the chunk size & append cr/lf, and get data
-    struct
-    {
-        std::size_t operator()(std::size_t n)
+/**
+ * Return the stream callback of the response, wrapped to compress its data if
+ * a content encoding was chosen for the stream.
+ */
+static ChunkingParams::DataCallback getStreamCallback(
+    HttpResponseImpl *respImplPtr)
+{
+    auto compressor =
+        StreamCompressor::newCompressor(respImplPtr->streamEncoding());
+    if (!compressor)
+        return respImplPtr->streamCallback();
+    return [ctx = std::make_shared<CompressingStreamParams>(
+                respImplPtr->streamCallback(), std::move(compressor))](
+               char *buffer, size_t len) {
+        return compressingCallback(ctx, buffer, len);
+    };
+}
+
+static ResponseStream::Encoder newStreamEncoder(
+    HttpResponseImpl *respImplPtr)
+{
+    std::shared_ptr<StreamCompressor> compressor =
+        StreamCompressor::newCompressor(respImplPtr->streamEncoding());
+    if (!compressor)
+        return nullptr;
+    // Every piece is flushed, pushed streams such as SSE must reach the client
+    // without waiting for more data.
+    return [compressor](const std::string &data, bool finish) {
+        std::string out;
+        if (!data.empty() &&
+            !compressor->compress(data.data(), data.length(), true, out))
+        {
+            LOG_ERROR << "Failed to compress the async stream response";
+        }
+        if (finish && !compressor->finish(out))
         {
-            return n == 0 ? 0 : 1 + (*this)(n >> 4);
+            LOG_ERROR << "Failed to compress the async stream response";
         }
-    } neededDigits;
+        return out;
+    };
+}
 
-    auto nHeaderSize = neededDigits(nSize) + 2;
-    auto nDataSize =
-        cbParams->dataCallback(pBuffer + nHeaderSize, nSize - nHeaderSize - 2);
-    if (nDataSize == 0)
+static ResponseStreamPtr newResponseStream(const TcpConnectionPtr &conn,
+                                           HttpResponseImpl *respImplPtr)
+{
+    auto asyncStream =
+        conn->sendAsyncStream(respImplPtr->asyncStreamKickoffDisabled());
+    auto encoder = newStreamEncoder(respImplPtr);
+    auto stream =
+        encoder ? std::make_unique<ResponseStream>(std::move(asyncStream),
+                                                   std::move(encoder))
+                : std::make_unique<ResponseStream>(std::move(asyncStream));
+    stream->setConnection(conn);
+    return stream;
+}
+
+static inline void sendBody(const TcpConnectionPtr &conn,
+                            HttpResponseImpl *respImplPtr)
+{
+    if (auto body = respImplPtr->sharedBodyString())
     {
-        // Terminal chunk + cr/lf
-        cbParams->bFinished = true;
-#ifdef _WIN32
-        memcpy_s(pBuffer, nSize, "0\r\n\r\n", 5);
-#else
-        memcpy(pBuffer, "0\r\n\r\n", 5);
-#endif
-        LOG_TRACE << "Chunking callback: no more data, return last chunk of "
-                     "size 0 & end of message";
-        return 5;
-    }
-    // Non-terminal chunks
-    pBuffer[nHeaderSize + nDataSize] = '\r';
-    pBuffer[nHeaderSize + nDataSize + 1] = '\n';
-    // The spec does not say if the chunk size is allowed tohave leading zeroes
-    // Use a fixed size header with leading zeroes
-    // (tested to work with Chrome, Firefox, Safari, Edge, wget, curl and VLC)
-#ifdef _WIN32
-    char pszFormat[]{"%04llx\r"};
-#else
-    char pszFormat[]{"%04lx\r"};
-#endif
-    pszFormat[2] = '0' + char(nHeaderSize - 2);
-    snprintf(pBuffer, nHeaderSize, pszFormat, nDataSize);
-    pBuffer[nHeaderSize - 1] = '\n';
-    LOG_TRACE << "Chunking callback: return chunk of size " << nDataSize;
-#ifndef NDEBUG  // defined by CMake for release build
-    cbParams->nDataReturned += nDataSize;
-#endif
-    return nHeaderSize + nDataSize + 2;
-    // Alternative code if there are client software that do not support chunk
-    // size with leading zeroes
-    //    auto nHeaderLen =
-    // #ifdef _WIN32
-    //    sprintf_s(pBuffer,
-    //    nHeaderSize, "%llx\r",
-    //    nDataSize);
-    // #else
-    //    sprintf(pBuffer, "%lx\r",
-    //    nDataSize);
-    // #endif
-    //    pBuffer[nHeaderLen++] = '\n';
-    //    if (nHeaderLen < nHeaderSize)  // smaller that what was reserved ->
-    //    move data
-    // #ifdef _WIN32
-    //    memmove_s(pBuffer +
-    //    nHeaderLen,
-    //              nSize - nHeaderLen,
-    //              pBuffer +
-    //              nHeaderSize,
-    //              nDataSize + 2);
-    // #else
-    //    memmove(pBuffer + nHeaderLen,
-    //            pBuffer + nHeaderSize,
-    //            nDataSize + 2);
-    // #endif
-    //    return nHeaderLen + nDataSize + 2;
+        conn->send(body);
+    }
+    else
+    {
+        // The memory of a string view body outlives the response
+        conn->send(respImplPtr->getBodyData(), respImplPtr->getBodyLength());
+    }
+}
+
+static void sendFile(const TcpConnectionPtr &conn,
+                     HttpResponseImpl *respImplPtr)
+{
+    const auto &range = respImplPtr->sendfileRange();
+    const auto &file = respImplPtr->openedFile();
+    // Over plain TCP the kernel copies the file into the socket. Over TLS the
+    // records are encrypted by the TLS provider of trantor through memory
+    // BIOs, so the kernel can not encrypt them, and reading the range from
+    // the open file into the send buffer saves opening it again.
+    if (!file || !file->isOpen() || !conn->isSSLConnection())
+    {
+        conn->sendFile(respImplPtr->sendfileName().c_str(),
+                       range.first,
+                       range.second);
+        return;
+    }
+    std::weak_ptr<trantor::TcpConnection> weakConn = conn;
+    conn->sendStream([file,
+                      weakConn,
+                      pos = range.first,
+                      end = range.first + range.second](char *buffer,
+                                                        size_t len) mutable {
+        if (buffer == nullptr)
+            return size_t(0);
+        auto n = std::min(len, end - pos);
+        if (n > 0 && file->read(pos, buffer, n) != n)
+        {
+            // The file was truncated while it was sent, the response can
+            // not be completed
+            LOG_ERROR << "File truncated while sending: " << file->path();
+            if (auto c = weakConn.lock())
+                c->forceClose();
+            return size_t(0);
+        }
+        pos += n;
+        return n;
+    });
 }
 
 void HttpServer::sendResponse(const TcpConnectionPtr &conn,
@@ -971,8 +1424,16 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
     auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
     if (!isHeadMethod)
     {
-        auto httpString = respImplPtr->renderToBuffer();
-        conn->send(httpString);
+        if (respImplPtr->sendBodySeparately())
+        {
+            conn->send(respImplPtr->renderHeaderForHeadMethod());
+            sendBody(conn, respImplPtr);
+        }
+        else
+        {
+            auto httpString = respImplPtr->renderToBuffer();
+            conn->send(httpString);
+        }
         if (!respImplPtr->contentLengthIsAllowed())
             return;
         auto &asyncStreamCallback = respImplPtr->asyncStreamCallback();
@@ -980,9 +1441,7 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
         {
             if (!respImplPtr->ifCloseConnection())
             {
-                asyncStreamCallback(
-                    std::make_unique<ResponseStream>(conn->sendAsyncStream(
-                        respImplPtr->asyncStreamKickoffDisabled())));
+                asyncStreamCallback(newResponseStream(conn, respImplPtr));
             }
             else
             {
@@ -1002,21 +1461,22 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
                     !respImplPtr->ifCloseConnection() &&
                     (headers.find("transfer-encoding") != headers.end()) &&
                     (headers.at("transfer-encoding") == "chunked");
+                auto dataCallback = getStreamCallback(respImplPtr);
                 if (bChunked)
                 {
                     conn->sendStream(
                         [ctx = std::make_shared<ChunkingParams>(
-                             streamCallback)](char *buffer, size_t len) {
+                             std::move(dataCallback))](char *buffer,
+                                                       size_t len) {
                             return chunkingCallback(ctx, buffer, len);
                         });
                 }
                 else
-                    conn->sendStream(streamCallback);
+                    conn->sendStream(std::move(dataCallback));
             }
             else
             {
-                const auto &range = respImplPtr->sendfileRange();
-                conn->sendFile(sendfileName.c_str(), range.first, range.second);
+                sendFile(conn, respImplPtr);
             }
         }
         COZ_PROGRESS
@@ -1024,7 +1484,7 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
     else
     {
         auto httpString = respImplPtr->renderHeaderForHeadMethod();
-        conn->send(std::move(*httpString));
+        conn->send(httpString);
         COZ_PROGRESS
     }
 
@@ -1054,7 +1514,19 @@ void HttpServer::sendResponses(
         if (!resp.second)
         {
             // Not HEAD method
-            respImplPtr->renderToBuffer(buffer);
+            if (respImplPtr->sendBodySeparately())
+            {
+                // Flush the pending responses with this header, the body
+                // follows without being copied into the buffer
+                respImplPtr->renderHeaderToBuffer(buffer);
+                conn->send(buffer);
+                buffer.retrieveAll();
+                sendBody(conn, respImplPtr);
+            }
+            else
+            {
+                respImplPtr->renderToBuffer(buffer);
+            }
             if (!respImplPtr->contentLengthIsAllowed())
                 continue;
             auto &asyncStreamCallback = respImplPtr->asyncStreamCallback();
@@ -1064,9 +1536,7 @@ void HttpServer::sendResponses(
                 buffer.retrieveAll();
                 if (!respImplPtr->ifCloseConnection())
                 {
-                    asyncStreamCallback(
-                        std::make_unique<ResponseStream>(conn->sendAsyncStream(
-                            respImplPtr->asyncStreamKickoffDisabled())));
+                    asyncStreamCallback(newResponseStream(conn, respImplPtr));
                 }
                 else
                 {
@@ -1088,23 +1558,22 @@ void HttpServer::sendResponses(
                         !respImplPtr->ifCloseConnection() &&
                         (headers.find("transfer-encoding") != headers.end()) &&
                         (headers.at("transfer-encoding") == "chunked");
+                    auto dataCallback = getStreamCallback(respImplPtr);
                     if (bChunked)
                     {
                         conn->sendStream(
                             [ctx = std::make_shared<ChunkingParams>(
-                                 streamCallback)](char *buffer, size_t len) {
+                                 std::move(dataCallback))](char *buffer,
+                                                           size_t len) {
                                 return chunkingCallback(ctx, buffer, len);
                             });
                     }
                     else
-                        conn->sendStream(streamCallback);
+                        conn->sendStream(std::move(dataCallback));
                 }
                 else
                 {
-                    const auto &range = respImplPtr->sendfileRange();
-                    conn->sendFile(sendfileName.c_str(),
-                                   range.first,
-                                   range.second);
+                    sendFile(conn, respImplPtr);
                 }
                 COZ_PROGRESS
             }
@@ -1128,28 +1597,243 @@ void HttpServer::sendResponses(
     }
     if (conn->connected() && buffer.readableBytes() > 0)
     {
+        MsgBufferPool::record(MsgBufferPool::Use::kStaging,
+                              buffer.readableBytes());
         conn->send(buffer);
         COZ_PROGRESS
     }
     buffer.retrieveAll();
 }
 
+/**
+ * Return the DATA source of the range of the file of the response, from its
+ * open file if there is one.
+ */
+static std::function<size_t(char *, size_t)> getFileCallback(
+    HttpResponseImpl *respImplPtr)
+{
+    const auto &range = respImplPtr->sendfileRange();
+    const auto &file = respImplPtr->openedFile();
+    if (file && file->isOpen())
+    {
+        return [file,
+                pos = range.first,
+                end = range.first + range.second](char *buffer,
+                                                  size_t len) mutable {
+            if (buffer == nullptr)
+                return size_t(0);
+            auto n = (std::min)(len, end - pos);
+            // The stream ends short if the file was truncated meanwhile
+            auto done = n > 0 ? file->read(pos, buffer, n) : 0;
+            if (done < n)
+                LOG_ERROR << "File truncated while sending: " << file->path();
+            pos += done;
+            return done;
+        };
+    }
+    auto in = std::make_shared<std::ifstream>(
+        drogon::utils::toNativePath(respImplPtr->sendfileName()),
+        std::ios::binary);
+    in->seekg(static_cast<std::streamoff>(range.first));
+    // A length of 0 is the rest of the file
+    return [in, remaining = range.second > 0 ? range.second : SIZE_MAX](
+               char *buffer, size_t len) mutable {
+        if (buffer == nullptr || remaining == 0 || !*in)
+            return size_t(0);
+        in->read(buffer,
+                 static_cast<std::streamsize>((std::min)(len, remaining)));
+        auto n = static_cast<size_t>(in->gcount());
+        remaining -= n;
+        return n;
+    };
+}
+
+// The responses of the HTTP/2 and HTTP/3 streams
+template <typename Connection, typename StreamId>
+static void sendStreamResponse(const std::shared_ptr<Connection> &conn,
+                               StreamId streamId,
+                               const HttpResponsePtr &response,
+                               bool isHeadMethod)
+{
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    // The connection converts the HTTP/1 header, so the responses are
+    // rendered, and cached, the same way over all the protocols
+    trantor::MsgBuffer header;
+    respImplPtr->renderHeaderToBuffer(header);
+    if (isHeadMethod || !respImplPtr->contentLengthIsAllowed())
+    {
+        conn->sendHeaders(streamId, header, true);
+        return;
+    }
+    if constexpr (std::is_same_v<Connection, Http2ServerConnection>)
+    {
+        // The trailers, of an async stream too, are read once the body is
+        // sent
+        conn->setResponse(streamId, response);
+    }
+    if (auto &asyncStreamCallback = respImplPtr->asyncStreamCallback())
+    {
+        conn->sendHeaders(streamId, header, false);
+        asyncStreamCallback(
+            std::make_unique<ResponseStream>(conn->newAsyncStream(streamId),
+                                             newStreamEncoder(respImplPtr),
+                                             false /* Not chunked */));
+        return;
+    }
+    if (respImplPtr->streamCallback())
+    {
+        conn->sendHeaders(streamId, header, false);
+        conn->sendBody(streamId, getStreamCallback(respImplPtr));
+        return;
+    }
+    if (!respImplPtr->sendfileName().empty())
+    {
+        conn->sendHeaders(streamId, header, false);
+        conn->sendBody(streamId, getFileCallback(respImplPtr));
+        return;
+    }
+    auto length = respImplPtr->getBodyLength();
+    bool endStream = length == 0 && respImplPtr->trailers().empty();
+    conn->sendHeaders(streamId, header, endStream);
+    if (endStream)
+        return;
+    // The body is copied into the DATA frames from the response
+    conn->sendBody(streamId,
+                   [response,
+                    data = respImplPtr->getBodyData(),
+                    length,
+                    pos = size_t(0)](char *buffer, size_t len) mutable {
+                       if (buffer == nullptr)
+                           return size_t(0);
+                       auto n = (std::min)(len, length - pos);
+                       memcpy(buffer, data + pos, n);
+                       pos += n;
+                       return n;
+                   });
+}
+
+void HttpServer::onHttp2Request(const Http2ServerConnectionPtr &h2,
+                                uint32_t streamId,
+                                const HttpRequestImplPtr &req)
+{
+    onStreamRequest(h2, streamId, req);
+}
+
+#ifdef USE_QUICHE
+void HttpServer::onHttp3Request(const Http3ServerConnectionPtr &h3,
+                                uint64_t streamId,
+                                const HttpRequestImplPtr &req)
+{
+    onStreamRequest(h3, streamId, req);
+}
+#endif
+
+template <typename Connection, typename StreamId>
+void HttpServer::onStreamRequest(const std::shared_ptr<Connection> &conn,
+                                 StreamId streamId,
+                                 const HttpRequestImplPtr &req)
+{
+    req->startProcessing();
+    if (PhaseTracing::shouldSample())
+    {
+        // The frames of the request are parsed by the connection
+        req->startPhaseTracing();
+        req->stampPhase(RequestPhase::kParsed);
+    }
+    Tracing::instance().requestStarted(req);
+    bool isHeadMethod = (req->method() == Head);
+    if (isHeadMethod)
+    {
+        req->setMethod(Get);
+    }
+    // The deadline of a gRPC call is the one of its client
+    std::chrono::nanoseconds grpcTimeout;
+    if (grpc::parseTimeout(req->getHeader("grpc-timeout"), grpcTimeout))
+        req->setDeadline(std::chrono::steady_clock::now() + grpcTimeout);
+    // The handler counts toward the concurrent streams of its connection
+    // until it drops the callback, even if the stream is reset before
+    auto handling = conn->handlerToken();
+    // The streams are independent, their responses are sent once they are
+    // ready in any order
+    auto callback = [conn,
+                     streamId,
+                     req,
+                     isHeadMethod,
+                     handling = std::move(handling),
+                     sent = std::make_shared<std::atomic<bool>>(false)](
+                        const HttpResponsePtr &response) {
+        if (!response)
+            return;
+        if (sent->exchange(true, std::memory_order_acq_rel))
+        {
+            LOG_ERROR << "Sending more than 1 response for request. "
+                         "Ignoring later response";
+            return;
+        }
+        req->closeEarlyHints();
+        auto resp =
+            HttpAppFrameworkImpl::instance().handleSessionForResponse(req,
+                                                                      response);
+        if (HttpAppFrameworkImpl::instance().useDynamicETags())
+            resp = dynamic_etag::apply(req, resp);
+        req->stampPhase(RequestPhase::kSending);
+        AopAdvice::instance().passPreSendingAdvices(req, resp);
+        BuiltinMetrics::instance().responseSending(req, resp);
+        Tracing::instance().responseSending(req, resp);
+        req->stampPhase(RequestPhase::kCompressing);
+        auto newResp = getCompressedResponse(req, resp, isHeadMethod);
+        finishPhaseTracing(req, newResp);
+        conn->getLoop()->runInLoop(
+            [conn, streamId, newResp = std::move(newResp), isHeadMethod]() {
+                sendStreamResponse(conn, streamId, newResp, isHeadMethod);
+            });
+    };
+    if (auto resp = AopAdvice::instance().passSyncAdvices(req))
+    {
+        callback(resp);
+        return;
+    }
+    if (auto errResp = tryDecompressRequest(req))
+    {
+        callback(errResp);
+        return;
+    }
+    // The interim responses are HEADERS of the stream which don't end it
+    req->setEarlyHintsSender(
+        [weakConn = std::weak_ptr<Connection>(conn),
+         streamId](std::string &&hints) {
+            auto conn = weakConn.lock();
+            if (!conn)
+                return;
+            conn->getLoop()->runInLoop(
+                [weakConn, streamId, hints = std::move(hints)]() {
+                    auto conn = weakConn.lock();
+                    if (!conn)
+                        return;
+                    trantor::MsgBuffer header;
+                    header.append(hints);
+                    conn->sendHeaders(streamId, header, false);
+                });
+        });
+    dispatchHttpRequest(req, std::move(callback));
+}
+
 static inline bool isWebSocket(const HttpRequestImplPtr &req)
 {
     if (req->method() != Get)
         return false;
 
-    auto &headers = req->headers();
-    if (headers.find("upgrade") == headers.end() ||
-        headers.find("connection") == headers.end())
+    auto connectionView = req->getHeaderView(HttpHeaderId::kConnection);
+    auto upgradeView = req->getHeaderView(HttpHeaderId::kUpgrade);
+    if (upgradeView.empty() || connectionView.empty())
         return false;
 
-    auto connectionField = req->getHeaderBy("connection");
+    std::string connectionField(connectionView);
     std::transform(connectionField.begin(),
                    connectionField.end(),
                    connectionField.begin(),
                    [](unsigned char c) { return tolower(c); });
-    auto upgradeField = req->getHeaderBy("upgrade");
+    std::string upgradeField(upgradeView);
     std::transform(upgradeField.begin(),
                    upgradeField.end(),
                    upgradeField.begin(),
@@ -1163,6 +1847,35 @@ static inline bool isWebSocket(const HttpRequestImplPtr &req)
     return false;
 }
 
+/**
+ * @brief Compress the messages of the connection if the handshake response
+ * accepts the permessage-deflate extension.
+ */
+static void enableWebSocketDeflate(const HttpResponsePtr &resp,
+                                   const WebSocketConnectionImplPtr &wsConn)
+{
+    auto &extension = resp->getHeader("sec-websocket-extensions");
+    if (extension.empty())
+        return;
+    auto &app = HttpAppFrameworkImpl::instance();
+    WebSocketDeflateParams params;
+    if (WebSocketDeflate::parseResponse(extension, params))
+    {
+        auto deflate = std::make_unique<WebSocketDeflate>(
+            params,
+            app.getWebSocketCompressionOptions(),
+            true,
+            app.getClientMaxWebSocketMessageSize());
+        if (deflate->ok())
+        {
+            wsConn->setDeflate(std::move(deflate));
+            return;
+        }
+    }
+    LOG_ERROR << "Bad permessage-deflate response: " << extension;
+    resp->removeHeader("sec-websocket-extensions");
+}
+
 /**
  * @brief calling req->decompressBody(), if not success, generate corresponding
  * error response
@@ -1215,7 +1928,8 @@ static inline bool passSyncAdvices(
     {
         // Rejected by sync advice
         resp->setVersion(req->getVersion());
-        resp->setCloseConnection(!req->keepAlive());
+        resp->setCloseConnection(!req->keepAlive() ||
+                                 HotRestart::instance().draining());
         if (!shouldBePipelined)
         {
             requestParser->getResponseBuffer().emplace_back(
@@ -1236,64 +1950,106 @@ static inline HttpResponsePtr getCompressedResponse(
     const HttpResponsePtr &response,
     bool isHeadMethod)
 {
-    if (isHeadMethod ||
-        !static_cast<HttpResponseImpl *>(response.get())->shouldBeCompressed())
+    if (isHeadMethod)
+        return response;
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    auto isStream = respImplPtr->shouldStreamBeCompressed();
+    if (!isStream && !respImplPtr->shouldBeCompressed())
     {
         return response;
     }
-#ifdef USE_BROTLI
-    if (app().isBrotliEnabled() &&
-        req->getHeaderBy("accept-encoding").find("br") != std::string::npos)
+    auto encoding = getResponseEncoding(
+        req->getHeaderView(HttpHeaderId::kAcceptEncoding));
+    if (encoding == ContentEncoding::kNone)
+        return response;
+    std::shared_ptr<const std::string> compressed;
+    if (!isStream)
     {
-        auto newResp = response;
-        auto strCompress =
-            drogon::utils::brotliCompress(response->getBody().data(),
-                                          response->getBody().length());
-        if (!strCompress.empty())
+        compressed = CompressedBodyCache::instance().compress(
+            encoding,
+            response->getBody().data(),
+            response->getBody().length());
+        if (!compressed)
         {
-            if (response->expiredTime() >= 0)
-            {
-                // cached response,we need to make a clone
-                newResp = std::make_shared<HttpResponseImpl>(
-                    *static_cast<HttpResponseImpl *>(response.get()));
-                newResp->setExpiredTime(-1);
-            }
-            newResp->setBody(std::move(strCompress));
-            newResp->addHeader("Content-Encoding", "br");
+            LOG_ERROR << contentEncodingName(encoding)
+                      << " got 0 length result";
+            return response;
         }
-        else
-        {
-            LOG_ERROR << "brotli got 0 length result";
-        }
-        return newResp;
     }
-#endif
-    if (app().isGzipEnabled() &&
-        req->getHeaderBy("accept-encoding").find("gzip") != std::string::npos)
-    {
-        auto newResp = response;
-        auto strCompress =
-            drogon::utils::gzipCompress(response->getBody().data(),
-                                        response->getBody().length());
-        if (!strCompress.empty())
-        {
-            if (response->expiredTime() >= 0)
-            {
-                // cached response,we need to make a clone
-                newResp = std::make_shared<HttpResponseImpl>(
-                    *static_cast<HttpResponseImpl *>(response.get()));
-                newResp->setExpiredTime(-1);
-            }
-            newResp->setBody(std::move(strCompress));
-            newResp->addHeader("Content-Encoding", "gzip");
-        }
-        else
-        {
-            LOG_ERROR << "gzip got 0 length result";
-        }
-        return newResp;
+    auto newResp = response;
+    if (response->expiredTime() >= 0)
+    {
+        // cached response,we need to make a clone
+        newResp = std::make_shared<HttpResponseImpl>(*respImplPtr);
+        newResp->setExpiredTime(-1);
+    }
+    if (isStream)
+    {
+        // The body is compressed by the stream callbacks while it is sent
+        static_cast<HttpResponseImpl *>(newResp.get())
+            ->setStreamEncoding(encoding);
+    }
+    else
+    {
+        // Shared with the compressed body cache, the hits are not copied
+        newResp->setSharedBody(std::move(compressed));
+    }
+    newResp->addHeader("Content-Encoding", contentEncodingName(encoding));
+    return newResp;
+}
+
+/**
+ * @brief Ends the phases of a sampled request, observes them and adds them to
+ * the response in a Server-Timing header if enabled.
+ */
+static void setEarlyHintsSender(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser,
+    const HttpRequestImplPtr &req)
+{
+    req->setEarlyHintsSender(
+        [weakConn = std::weak_ptr<trantor::TcpConnection>(conn),
+         weakParser = std::weak_ptr<HttpRequestParser>(requestParser),
+         weakReq = std::weak_ptr<HttpRequestImpl>(req)](std::string &&hints) {
+            auto conn = weakConn.lock();
+            if (!conn)
+                return;
+            conn->getLoop()->runInLoop([conn,
+                                        weakParser,
+                                        weakReq,
+                                        hints = std::move(hints)]() mutable {
+                auto requestParser = weakParser.lock();
+                auto req = weakReq.lock();
+                // The responses are sent in the order of the requests, the
+                // hints can't go out before the responses of the earlier ones
+                if (!requestParser || !req || !conn->connected() ||
+                    requestParser->responsesPendingBefore(req))
+                {
+                    return;
+                }
+                conn->send(std::move(hints));
+            });
+        });
+}
+
+static inline void finishPhaseTracing(const HttpRequestImplPtr &req,
+                                      HttpResponsePtr &resp)
+{
+    auto phases = req->phases();
+    if (!phases)
+        return;
+    req->stampPhase(RequestPhase::kCompressed);
+    BuiltinMetrics::instance().requestPhases(*phases);
+    if (!PhaseTracing::serverTiming())
+        return;
+    if (resp->expiredTime() >= 0)
+    {
+        // cached response,we need to make a clone
+        resp = std::make_shared<HttpResponseImpl>(
+            *static_cast<HttpResponseImpl *>(resp.get()));
+        resp->setExpiredTime(-1);
     }
-    return response;
+    resp->addHeader("Server-Timing", PhaseTracing::serverTimingValue(*phases));
 }
 
 static void handleInvalidHttpMethod(
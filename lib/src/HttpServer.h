@@ -26,6 +26,8 @@ struct CallbackParamPack;
 namespace drogon
 {
 struct ControllerBinderBase;
+class Http2ServerConnection;
+class Http3ServerConnection;
 
 class HttpServer : trantor::NonCopyable
 {
@@ -47,6 +49,10 @@ class HttpServer : trantor::NonCopyable
     void enableSSL(trantor::TLSPolicyPtr policy)
     {
         server_.enableSSL(std::move(policy));
+        // The connection callback runs after the handshake, the timing wheel
+        // of trantor also closes the connections that never finish it
+        server_.kickoffIdleConnections(idleTimeout_);
+        trantorKicksOffIdleConnections_ = true;
     }
 
     void reloadSSL()
@@ -54,6 +60,13 @@ class HttpServer : trantor::NonCopyable
         server_.reloadSSL();
     }
 
+    /// The connections begin with the PROXY protocol header of a load
+    /// balancer, which gives the addresses of the clients.
+    void enableProxyProtocol()
+    {
+        proxyProtocol_ = true;
+    }
+
     const trantor::InetAddress &address() const
     {
         return server_.address();
@@ -75,16 +88,56 @@ class HttpServer : trantor::NonCopyable
         connectionCallback_ = std::move(cb);
     }
 
+#ifdef USE_QUICHE
+    // The requests of the HTTP/3 listeners
+    static void onHttp3Request(
+        const std::shared_ptr<Http3ServerConnection> &h3,
+        uint64_t streamId,
+        const HttpRequestImplPtr &req);
+#endif
+
   private:
     friend class HttpInternalForwardHelper;
 
-    static void onConnection(const trantor::TcpConnectionPtr &conn);
+    static void onConnection(const trantor::TcpConnectionPtr &conn,
+                             bool proxyProtocol,
+                             size_t idleTimeout);
+    // Apply the connection limits and the new connection advices to the
+    // client, false if the connection is closed
+    static bool admitConnection(
+        const trantor::TcpConnectionPtr &conn,
+        const std::shared_ptr<HttpRequestParser> &requestParser);
+    // False while the PROXY protocol header is incomplete, or if the
+    // connection is closed
+    static bool receiveProxyHeader(
+        const trantor::TcpConnectionPtr &conn,
+        const std::shared_ptr<HttpRequestParser> &requestParser,
+        trantor::MsgBuffer *buf);
     static void onMessage(const trantor::TcpConnectionPtr &,
                           trantor::MsgBuffer *);
+    static void waitForBodyMemory(
+        const trantor::TcpConnectionPtr &conn,
+        const std::shared_ptr<HttpRequestParser> &requestParser,
+        trantor::MsgBuffer *buf);
     static void onRequests(const trantor::TcpConnectionPtr &,
                            const std::vector<HttpRequestImplPtr> &,
                            const std::shared_ptr<HttpRequestParser> &);
 
+    // HTTP/2 connections, started by the preface or by an h2c upgrade
+    static std::shared_ptr<Http2ServerConnection> startHttp2(
+        const trantor::TcpConnectionPtr &conn,
+        const std::shared_ptr<HttpRequestParser> &requestParser,
+        const HttpRequestImplPtr &upgradeReq = nullptr);
+    static void onHttp2Request(
+        const std::shared_ptr<Http2ServerConnection> &h2,
+        uint32_t streamId,
+        const HttpRequestImplPtr &req);
+    // The requests of the HTTP/2 and HTTP/3 streams
+    template <typename Connection, typename StreamId>
+    static void onStreamRequest(const std::shared_ptr<Connection> &conn,
+                                StreamId streamId,
+                                const HttpRequestImplPtr &req);
+
     struct HttpRequestParamPack
     {
         std::shared_ptr<ControllerBinderBase> binderPtr;
@@ -99,8 +152,14 @@ class HttpServer : trantor::NonCopyable
     };
 
     // Http request handling steps
+    static void dispatchHttpRequest(
+        const HttpRequestImplPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback);
     static void onHttpRequest(const HttpRequestImplPtr &,
                               std::function<void(const HttpResponsePtr &)> &&);
+    static void httpRequestPreRouting(
+        const HttpRequestImplPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback);
     static void httpRequestRouting(
         const HttpRequestImplPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback);
@@ -114,6 +173,10 @@ class HttpServer : trantor::NonCopyable
         const HttpRequestImplPtr &,
         std::function<void(const HttpResponsePtr &)> &&,
         WebSocketConnectionImplPtr &&);
+    static void websocketRequestPreRouting(
+        const HttpRequestImplPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback,
+        WebSocketConnectionImplPtr &&wsConnPtr);
     static void websocketRequestRouting(
         const HttpRequestImplPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback,
@@ -145,12 +208,21 @@ class HttpServer : trantor::NonCopyable
         const trantor::TcpConnectionPtr &conn,
         const std::vector<std::pair<HttpResponsePtr, bool>> &responses,
         trantor::MsgBuffer &buffer);
+    static void flushPipelinedResponses(
+        const trantor::TcpConnectionPtr &conn,
+        const std::shared_ptr<HttpRequestParser> &requestParser);
 
     trantor::TcpServer server_;
 
     std::function<void(int)> beforeListenSetSockOptCallback_;
     std::function<void(int)> afterAcceptSetSockOptCallback_;
     std::function<void(const trantor::TcpConnectionPtr &)> connectionCallback_;
+    bool proxyProtocol_{false};
+    // The idle connections are kept in the timeout wheels of the loops with
+    // the current timeout, which can be reloaded, but trantor closes the ones
+    // of the TLS servers with the timeout of the start
+    size_t idleTimeout_{0};
+    bool trantorKicksOffIdleConnections_{false};
 };
 
 class HttpInternalForwardHelper
@@ -161,6 +233,14 @@ class HttpInternalForwardHelper
     {
         return HttpServer::onHttpRequest(req, std::move(callback));
     }
+
+    // Called in the loop of the request
+    static void subrequest(
+        const HttpRequestImplPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback)
+    {
+        return HttpServer::httpRequestRouting(req, std::move(callback));
+    }
 };
 
 }  // namespace drogon
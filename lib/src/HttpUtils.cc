@@ -13,8 +13,11 @@
  */
 
 #include "HttpUtils.h"
+#include <drogon/HttpAppFramework.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cstdlib>
 #include <map>
 #include <unordered_map>
 #include <mutex>
@@ -41,6 +44,11 @@ static const std::unordered_map<
         {CT_APPLICATION_GZIP, {{"application/gzip"}, ""}},
         {CT_APPLICATION_JSON,
          {{"application/json"}, "application/json; charset=utf-8"}},
+        {CT_APPLICATION_MSGPACK,
+         {{"application/msgpack",
+           "application/x-msgpack",
+           "application/vnd.msgpack"},
+          ""}},
         {CT_APPLICATION_FONT_WOFF, {{"application/font-woff"}, ""}},
         {CT_APPLICATION_FONT_WOFF2, {{"application/font-woff2"}, ""}},
         {CT_APPLICATION_JAVA_ARCHIVE,
@@ -742,4 +750,89 @@ const std::vector<std::string_view> &getFileExtensions(ContentType contentType)
     return it->second;
 }
 
+ContentEncoding getResponseEncoding(std::string_view acceptEncoding)
+{
+    if (acceptEncoding.empty())
+        return ContentEncoding::kNone;
+#ifdef USE_ZSTD
+    if (app().isZstdEnabled() &&
+        acceptEncoding.find("zstd") != std::string_view::npos)
+    {
+        return ContentEncoding::kZstd;
+    }
+#endif
+#ifdef USE_BROTLI
+    if (app().isBrotliEnabled() &&
+        acceptEncoding.find("br") != std::string_view::npos)
+    {
+        return ContentEncoding::kBrotli;
+    }
+#endif
+    if (app().isGzipEnabled() &&
+        acceptEncoding.find("gzip") != std::string_view::npos)
+    {
+        return ContentEncoding::kGzip;
+    }
+    return ContentEncoding::kNone;
+}
+
+bool prefersMsgPack(std::string_view accept)
+{
+    // The best quality of each type, -1 if it is not accepted
+    double msgPack = -1;
+    double json = -1;
+    while (!accept.empty())
+    {
+        auto end = accept.find(',');
+        auto range = accept.substr(0, end);
+        accept = end == std::string_view::npos ? std::string_view{}
+                                               : accept.substr(end + 1);
+        double quality = 1;
+        auto params = range.find(';');
+        if (params != std::string_view::npos)
+        {
+            auto q = range.find("q=", params);
+            if (q != std::string_view::npos)
+                quality = atof(std::string(range.substr(q + 2)).c_str());
+            range = range.substr(0, params);
+        }
+        auto begin = range.find_first_not_of(' ');
+        if (begin == std::string_view::npos)
+            continue;
+        range = range.substr(begin, range.find_last_not_of(' ') + 1 - begin);
+        if (parseContentType(range) == CT_APPLICATION_MSGPACK)
+            msgPack = (std::max)(msgPack, quality);
+        else if (range == "application/json" || range == "application/*" ||
+                 range == "*/*")
+            json = (std::max)(json, quality);
+    }
+    // JSON wins a tie, as the default
+    return msgPack > 0 && msgPack > json;
+}
+
+const char *contentEncodingName(ContentEncoding encoding)
+{
+    switch (encoding)
+    {
+        case ContentEncoding::kBrotli:
+            return "br";
+        case ContentEncoding::kZstd:
+            return "zstd";
+        default:
+            return "gzip";
+    }
+}
+
+std::string addHttp3AltSvc(const std::string &header, uint16_t port)
+{
+    auto altSvc = "h3=\":" + std::to_string(port) + "\"";
+    if (header.find(altSvc) != std::string::npos)
+        return header;
+    if (header.empty())
+        return "alt-svc: " + altSvc + "; ma=86400\r\n";
+    auto result = header;
+    result.insert(result.length() - 2, ", " + altSvc + "; ma=86400");
+    return result;
+}
+
 }  // namespace drogon
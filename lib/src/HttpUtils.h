@@ -16,11 +16,25 @@
 
 #include <trantor/utils/MsgBuffer.h>
 #include <drogon/HttpTypes.h>
+#include <drogon/utils/Utilities.h>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <ctype.h>
 
 namespace drogon
 {
+/**
+ * @brief The encodings used by drogon to compress response bodies.
+ */
+enum class ContentEncoding : uint8_t
+{
+    kNone = 0,
+    kGzip,
+    kBrotli,
+    kZstd
+};
+
 const std::string_view &contentTypeToMime(ContentType contentType);
 const std::string_view &statusCodeToString(int code);
 ContentType getContentType(const std::string &fileName);
@@ -43,6 +57,75 @@ inline std::string_view getFileExtension(const std::string &fileName)
 
 const std::vector<std::string_view> &getFileExtensions(ContentType contentType);
 
+/**
+ * @brief Return the preferred encoding among the enabled ones accepted by the
+ * client: zstd, then brotli, then gzip.
+ *
+ * @param acceptEncoding The Accept-Encoding header of the request.
+ */
+ContentEncoding getResponseEncoding(std::string_view acceptEncoding);
+
+/**
+ * @brief Return true if a client prefers MessagePack to JSON according to
+ * the Accept header of its request.
+ */
+bool prefersMsgPack(std::string_view accept);
+
+/// The name of an encoding in the Content-Encoding header
+const char *contentEncodingName(ContentEncoding encoding);
+
+/**
+ * @brief Return the Alt-Svc header line, empty or ending with CRLF, with the
+ * HTTP/3 endpoint on the port added once.
+ */
+std::string addHttp3AltSvc(const std::string &header, uint16_t port);
+
+/**
+ * @brief Compare two ASCII strings case-insensitively, e.g. header names.
+ */
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    if (a.length() != b.length())
+        return false;
+    for (size_t i = 0; i < a.length(); ++i)
+    {
+        auto ca = static_cast<unsigned char>(a[i]);
+        auto cb = static_cast<unsigned char>(b[i]);
+        if (ca != cb && tolower(ca) != tolower(cb))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The hash and the equality of the keys of a map looked up regardless
+ * of their case, e.g. by the path of a request without a lower case copy.
+ */
+struct IgnoreCaseHash
+{
+    size_t operator()(std::string_view str) const
+    {
+        const size_t A = 6665339;
+        const size_t B = 2534641;
+        size_t h = utils::internal::fixedRandomNumber;
+        for (unsigned char ch : str)
+            h = (h * A) ^ (static_cast<size_t>(tolower(ch)) * B);
+        return h;
+    }
+};
+
+struct IgnoreCaseEqual
+{
+    bool operator()(std::string_view a, std::string_view b) const
+    {
+        return equalsIgnoreCase(a, b);
+    }
+};
+
+template <typename T>
+using IgnoreCaseMap =
+    std::unordered_map<std::string, T, IgnoreCaseHash, IgnoreCaseEqual>;
+
 inline const std::vector<std::string_view> &getFileExtensions(
     const std::string_view &contentType)
 {
@@ -0,0 +1,574 @@
+/**
+ *
+ *  @file IncrementalHash.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "IncrementalHash.h"
+#include <cstring>
+
+using namespace drogon;
+
+namespace
+{
+inline uint32_t rotl(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+std::string toHex(const unsigned char *digest, size_t length)
+{
+    static const char hexChars[] = "0123456789ABCDEF";
+    std::string hex;
+    hex.reserve(length * 2);
+    for (size_t i = 0; i < length; ++i)
+    {
+        hex.push_back(hexChars[digest[i] >> 4]);
+        hex.push_back(hexChars[digest[i] & 0x0f]);
+    }
+    return hex;
+}
+
+// Feed the data to the transform of a hash in blocks of 64 bytes, buffering
+// the rest
+template <typename Transform>
+void feedBlocks(unsigned char *buffer,
+                uint64_t &totalLength,
+                const char *data,
+                size_t length,
+                Transform &&transform)
+{
+    auto input = reinterpret_cast<const unsigned char *>(data);
+    size_t used = totalLength % 64;
+    totalLength += length;
+    if (used > 0)
+    {
+        size_t fill = 64 - used;
+        if (length < fill)
+        {
+            memcpy(buffer + used, input, length);
+            return;
+        }
+        memcpy(buffer + used, input, fill);
+        transform(buffer);
+        input += fill;
+        length -= fill;
+    }
+    for (; length >= 64; input += 64, length -= 64)
+        transform(input);
+    if (length > 0)
+        memcpy(buffer, input, length);
+}
+
+const uint32_t md5K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+const int md5Shifts[64] = {7,  12, 17, 22, 7,  12, 17, 22, 7,  12, 17, 22, 7,
+                           12, 17, 22, 5,  9,  14, 20, 5,  9,  14, 20, 5,  9,
+                           14, 20, 5,  9,  14, 20, 4,  11, 16, 23, 4,  11, 16,
+                           23, 4,  11, 16, 23, 4,  11, 16, 23, 6,  10, 15, 21,
+                           6,  10, 15, 21, 6,  10, 15, 21, 6,  10, 15, 21};
+
+const uint32_t sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+// Write the padding of MD5-like hashes with a big endian length in bits,
+// return its length
+size_t bigEndianPadding(uint64_t length, unsigned char *padding)
+{
+    uint64_t bits = length * 8;
+    size_t used = length % 64;
+    size_t padLength = (used < 56 ? 56 : 120) - used;
+    padding[0] = 0x80;
+    memset(padding + 1, 0, padLength - 1);
+    for (int i = 0; i < 8; ++i)
+    {
+        padding[padLength + i] =
+            static_cast<unsigned char>(bits >> (8 * (7 - i)));
+    }
+    return padLength + 8;
+}
+
+inline void storeBigEndian(uint32_t x, unsigned char *out)
+{
+    for (int j = 0; j < 4; ++j)
+        out[j] = static_cast<unsigned char>(x >> (8 * (3 - j)));
+}
+
+inline uint64_t rotr64(uint64_t x, int n)
+{
+    return (x >> n) | (x << (64 - n));
+}
+
+inline uint64_t rotl64(uint64_t x, int n)
+{
+    return n == 0 ? x : (x << n) | (x >> (64 - n));
+}
+
+// SHA3-256 absorbs 136 bytes per permutation
+constexpr size_t sha3Rate = 136;
+
+const uint64_t keccakRoundConstants[24] = {
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+    0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+    0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+    0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+    0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+    0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+    0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+    0x8000000000008080, 0x0000000080000001, 0x8000000080008008};
+
+const int keccakRotations[24] = {1,  3,  6,  10, 15, 21, 28, 36,
+                                 45, 55, 2,  14, 27, 41, 56, 8,
+                                 25, 43, 62, 18, 39, 61, 20, 44};
+
+const int keccakLanes[24] = {10, 7,  11, 17, 18, 3,  5,  16,
+                             8,  21, 24, 4,  15, 23, 19, 13,
+                             12, 2,  20, 14, 22, 9,  6,  1};
+
+void keccakF(uint64_t *state)
+{
+    for (int round = 0; round < 24; ++round)
+    {
+        // Theta
+        uint64_t c[5];
+        for (int x = 0; x < 5; ++x)
+        {
+            c[x] = state[x] ^ state[x + 5] ^ state[x + 10] ^ state[x + 15] ^
+                   state[x + 20];
+        }
+        for (int x = 0; x < 5; ++x)
+        {
+            uint64_t d = c[(x + 4) % 5] ^ rotl64(c[(x + 1) % 5], 1);
+            for (int y = 0; y < 25; y += 5)
+                state[y + x] ^= d;
+        }
+        // Rho and pi
+        uint64_t current = state[1];
+        for (int i = 0; i < 24; ++i)
+        {
+            int lane = keccakLanes[i];
+            uint64_t next = state[lane];
+            state[lane] = rotl64(current, keccakRotations[i]);
+            current = next;
+        }
+        // Chi
+        for (int y = 0; y < 25; y += 5)
+        {
+            uint64_t row[5];
+            for (int x = 0; x < 5; ++x)
+                row[x] = state[y + x];
+            for (int x = 0; x < 5; ++x)
+                state[y + x] = row[x] ^ (~row[(x + 1) % 5] & row[(x + 2) % 5]);
+        }
+        // Iota
+        state[0] ^= keccakRoundConstants[round];
+    }
+}
+
+const uint64_t blake2bIv[8] = {0x6a09e667f3bcc908,
+                               0xbb67ae8584caa73b,
+                               0x3c6ef372fe94f82b,
+                               0xa54ff53a5f1d36f1,
+                               0x510e527fade682d1,
+                               0x9b05688c2b3e6c1f,
+                               0x1f83d9abfb41bd6b,
+                               0x5be0cd19137e2179};
+
+const unsigned char blake2bSigma[10][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0}};
+}  // namespace
+
+Md5Hash::Md5Hash()
+    : state_{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476}
+{
+}
+
+void Md5Hash::transform(const unsigned char *block)
+{
+    uint32_t m[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        m[i] = uint32_t(block[i * 4]) | (uint32_t(block[i * 4 + 1]) << 8) |
+               (uint32_t(block[i * 4 + 2]) << 16) |
+               (uint32_t(block[i * 4 + 3]) << 24);
+    }
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    for (int i = 0; i < 64; ++i)
+    {
+        uint32_t f;
+        int g;
+        if (i < 16)
+        {
+            f = (b & c) | (~b & d);
+            g = i;
+        }
+        else if (i < 32)
+        {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        }
+        else if (i < 48)
+        {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        }
+        else
+        {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+        f += a + md5K[i] + m[g];
+        a = d;
+        d = c;
+        c = b;
+        b += rotl(f, md5Shifts[i]);
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+}
+
+void Md5Hash::update(const char *data, size_t length)
+{
+    feedBlocks(buffer_, length_, data, length, [this](const unsigned char *b) {
+        transform(b);
+    });
+}
+
+void Md5Hash::final(unsigned char *digest)
+{
+    uint64_t bits = length_ * 8;
+    unsigned char padding[72] = {0x80};
+    size_t used = length_ % 64;
+    size_t padLength = (used < 56 ? 56 : 120) - used;
+    for (int i = 0; i < 8; ++i)
+        padding[padLength + i] = static_cast<unsigned char>(bits >> (8 * i));
+    update(reinterpret_cast<const char *>(padding), padLength + 8);
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            digest[i * 4 + j] =
+                static_cast<unsigned char>(state_[i] >> (8 * j));
+        }
+    }
+}
+
+std::string Md5Hash::hexDigest()
+{
+    unsigned char digest[16];
+    final(digest);
+    return toHex(digest, sizeof(digest));
+}
+
+Sha256Hash::Sha256Hash()
+    : state_{0x6a09e667,
+             0xbb67ae85,
+             0x3c6ef372,
+             0xa54ff53a,
+             0x510e527f,
+             0x9b05688c,
+             0x1f83d9ab,
+             0x5be0cd19}
+{
+}
+
+void Sha256Hash::transform(const unsigned char *block)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i)
+    {
+        w[i] = (uint32_t(block[i * 4]) << 24) |
+               (uint32_t(block[i * 4 + 1]) << 16) |
+               (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i)
+    {
+        uint32_t s0 =
+            rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 =
+            rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; ++i)
+    {
+        uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + ch + sha256K[i] + w[i];
+        uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+}
+
+void Sha256Hash::update(const char *data, size_t length)
+{
+    feedBlocks(buffer_, length_, data, length, [this](const unsigned char *b) {
+        transform(b);
+    });
+}
+
+void Sha256Hash::final(unsigned char *digest)
+{
+    unsigned char padding[72];
+    update(reinterpret_cast<const char *>(padding),
+           bigEndianPadding(length_, padding));
+    for (int i = 0; i < 8; ++i)
+        storeBigEndian(state_[i], digest + i * 4);
+}
+
+std::string Sha256Hash::hexDigest()
+{
+    unsigned char digest[32];
+    final(digest);
+    return toHex(digest, sizeof(digest));
+}
+
+Sha1Hash::Sha1Hash()
+    : state_{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0}
+{
+}
+
+void Sha1Hash::transform(const unsigned char *block)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i)
+    {
+        w[i] = (uint32_t(block[i * 4]) << 24) |
+               (uint32_t(block[i * 4 + 1]) << 16) |
+               (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 80; ++i)
+        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint32_t e = state_[4];
+    for (int i = 0; i < 80; ++i)
+    {
+        uint32_t f, k;
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        }
+        else if (i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t t = rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = t;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+}
+
+void Sha1Hash::update(const char *data, size_t length)
+{
+    feedBlocks(buffer_, length_, data, length, [this](const unsigned char *b) {
+        transform(b);
+    });
+}
+
+void Sha1Hash::final(unsigned char *digest)
+{
+    unsigned char padding[72];
+    update(reinterpret_cast<const char *>(padding),
+           bigEndianPadding(length_, padding));
+    for (int i = 0; i < 5; ++i)
+        storeBigEndian(state_[i], digest + i * 4);
+}
+
+void Sha3Hash::update(const char *data, size_t length)
+{
+    auto input = reinterpret_cast<const unsigned char *>(data);
+    // Absorb the whole blocks a lane at a time
+    for (; used_ == 0 && length >= sha3Rate;
+         input += sha3Rate, length -= sha3Rate)
+    {
+        for (size_t lane = 0; lane < sha3Rate / 8; ++lane)
+        {
+            uint64_t x = 0;
+            for (int j = 0; j < 8; ++j)
+                x |= uint64_t(input[lane * 8 + j]) << (8 * j);
+            state_[lane] ^= x;
+        }
+        keccakF(state_);
+    }
+    for (size_t i = 0; i < length; ++i)
+    {
+        state_[used_ / 8] ^= uint64_t(input[i]) << (8 * (used_ % 8));
+        if (++used_ == sha3Rate)
+        {
+            keccakF(state_);
+            used_ = 0;
+        }
+    }
+}
+
+void Sha3Hash::final(unsigned char *digest)
+{
+    state_[used_ / 8] ^= uint64_t(0x06) << (8 * (used_ % 8));
+    state_[(sha3Rate - 1) / 8] ^= uint64_t(0x80) << (8 * ((sha3Rate - 1) % 8));
+    keccakF(state_);
+    for (int i = 0; i < 32; ++i)
+        digest[i] = static_cast<unsigned char>(state_[i / 8] >> (8 * (i % 8)));
+}
+
+Blake2bHash::Blake2bHash()
+{
+    memcpy(state_, blake2bIv, sizeof(state_));
+    // No key, 32 bytes of digest
+    state_[0] ^= 0x01010000 ^ 32;
+}
+
+void Blake2bHash::compress(const unsigned char *block, bool last)
+{
+    uint64_t m[16], v[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        m[i] = 0;
+        for (int j = 0; j < 8; ++j)
+            m[i] |= uint64_t(block[i * 8 + j]) << (8 * j);
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        v[i] = state_[i];
+        v[i + 8] = blake2bIv[i];
+    }
+    v[12] ^= length_;
+    if (last)
+        v[14] = ~v[14];
+    auto g = [&v, &m](int a, int b, int c, int d, int x, int y) {
+        v[a] = v[a] + v[b] + m[x];
+        v[d] = rotr64(v[d] ^ v[a], 32);
+        v[c] = v[c] + v[d];
+        v[b] = rotr64(v[b] ^ v[c], 24);
+        v[a] = v[a] + v[b] + m[y];
+        v[d] = rotr64(v[d] ^ v[a], 16);
+        v[c] = v[c] + v[d];
+        v[b] = rotr64(v[b] ^ v[c], 63);
+    };
+    for (int round = 0; round < 12; ++round)
+    {
+        auto s = blake2bSigma[round % 10];
+        g(0, 4, 8, 12, s[0], s[1]);
+        g(1, 5, 9, 13, s[2], s[3]);
+        g(2, 6, 10, 14, s[4], s[5]);
+        g(3, 7, 11, 15, s[6], s[7]);
+        g(0, 5, 10, 15, s[8], s[9]);
+        g(1, 6, 11, 12, s[10], s[11]);
+        g(2, 7, 8, 13, s[12], s[13]);
+        g(3, 4, 9, 14, s[14], s[15]);
+    }
+    for (int i = 0; i < 8; ++i)
+        state_[i] ^= v[i] ^ v[i + 8];
+}
+
+void Blake2bHash::update(const char *data, size_t length)
+{
+    auto input = reinterpret_cast<const unsigned char *>(data);
+    size_t fill = 128 - used_;
+    if (length > fill)
+    {
+        memcpy(buffer_ + used_, input, fill);
+        length_ += 128;
+        compress(buffer_, false);
+        used_ = 0;
+        input += fill;
+        length -= fill;
+        for (; length > 128; input += 128, length -= 128)
+        {
+            length_ += 128;
+            compress(input, false);
+        }
+    }
+    memcpy(buffer_ + used_, input, length);
+    used_ += length;
+}
+
+void Blake2bHash::final(unsigned char *digest)
+{
+    length_ += used_;
+    memset(buffer_ + used_, 0, 128 - used_);
+    compress(buffer_, true);
+    for (int i = 0; i < 32; ++i)
+        digest[i] = static_cast<unsigned char>(state_[i / 8] >> (8 * (i % 8)));
+}
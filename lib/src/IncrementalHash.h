@@ -0,0 +1,131 @@
+/**
+ *
+ *  @file IncrementalHash.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief MD5 computed over data fed in pieces, the digest is the same as
+ * utils::getMd5() of the whole data.
+ */
+class DROGON_EXPORT Md5Hash
+{
+  public:
+    Md5Hash();
+    void update(const char *data, size_t length);
+    /// Write the 16 bytes of the digest, the hash must not be updated
+    /// afterwards.
+    void final(unsigned char *digest);
+    /// The upper case hex digest, the hash must not be updated afterwards.
+    std::string hexDigest();
+
+  private:
+    void transform(const unsigned char *block);
+
+    uint32_t state_[4];
+    uint64_t length_{0};
+    unsigned char buffer_[64];
+};
+
+/**
+ * @brief SHA-256 computed over data fed in pieces, the digest is the same as
+ * utils::getSha256() of the whole data.
+ */
+class DROGON_EXPORT Sha256Hash
+{
+  public:
+    Sha256Hash();
+    void update(const char *data, size_t length);
+    /// Write the 32 bytes of the digest, the hash must not be updated
+    /// afterwards.
+    void final(unsigned char *digest);
+    /// The upper case hex digest, the hash must not be updated afterwards.
+    std::string hexDigest();
+
+  private:
+    void transform(const unsigned char *block);
+
+    uint32_t state_[8];
+    uint64_t length_{0};
+    unsigned char buffer_[64];
+};
+
+/**
+ * @brief SHA-1 computed over data fed in pieces, the digest is the same as
+ * utils::getSha1() of the whole data.
+ */
+class DROGON_EXPORT Sha1Hash
+{
+  public:
+    Sha1Hash();
+    void update(const char *data, size_t length);
+    /// Write the 20 bytes of the digest, the hash must not be updated
+    /// afterwards.
+    void final(unsigned char *digest);
+
+  private:
+    void transform(const unsigned char *block);
+
+    uint32_t state_[5];
+    uint64_t length_{0};
+    unsigned char buffer_[64];
+};
+
+/**
+ * @brief SHA3-256 computed over data fed in pieces, the digest is the same as
+ * utils::getSha3() of the whole data.
+ */
+class DROGON_EXPORT Sha3Hash
+{
+  public:
+    void update(const char *data, size_t length);
+    /// Write the 32 bytes of the digest, the hash must not be updated
+    /// afterwards.
+    void final(unsigned char *digest);
+
+  private:
+    uint64_t state_[25]{};
+    size_t used_{0};
+};
+
+/**
+ * @brief BLAKE2b with a 32 bytes digest computed over data fed in pieces, the
+ * digest is the same as utils::getBlake2b() of the whole data.
+ */
+class DROGON_EXPORT Blake2bHash
+{
+  public:
+    Blake2bHash();
+    void update(const char *data, size_t length);
+    /// Write the 32 bytes of the digest, the hash must not be updated
+    /// afterwards.
+    void final(unsigned char *digest);
+
+  private:
+    void compress(const unsigned char *block, bool last);
+
+    uint64_t state_[8];
+    uint64_t length_{0};
+    // The last block is compressed differently, so a full block is kept
+    // until more data comes
+    unsigned char buffer_[128];
+    size_t used_{0};
+};
+
+}  // namespace drogon
@@ -0,0 +1,99 @@
+/**
+ *  @file IpFilter.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/IpFilter.h>
+#include <drogon/plugins/RealIpResolver.h>
+#include <drogon/HttpAppFramework.h>
+#include <fstream>
+#include <sstream>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+static void loadIpSet(const Json::Value &config,
+                      const std::string &listName,
+                      const std::string &filesName,
+                      IpSet &ipSet)
+{
+    const Json::Value &list = config[listName];
+    if (!list.isNull() && !list.isArray())
+    {
+        throw std::runtime_error("Invalid " + listName + ". Should be array.");
+    }
+    for (const auto &ipOrCidr : list)
+    {
+        ipSet.add(ipOrCidr.asString());
+    }
+    const Json::Value &files = config[filesName];
+    if (!files.isNull() && !files.isArray())
+    {
+        throw std::runtime_error("Invalid " + filesName +
+                                 ". Should be array.");
+    }
+    for (const auto &file : files)
+    {
+        std::ifstream in(file.asString(), std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("Can't open the ip list file " +
+                                     file.asString());
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        auto count = ipSet.addLines(text.str());
+        LOG_INFO << "Loaded " << count << " entries from " << file.asString();
+    }
+}
+
+void IpFilter::initAndStart(const Json::Value &config)
+{
+    loadIpSet(config, "allow", "allow_files", allowed_);
+    loadIpSet(config, "deny", "deny_files", denied_);
+    useRealIpResolver_ = config.get("use_real_ip_resolver", false).asBool();
+    rejectResponse_ = HttpResponse::newHttpResponse();
+    rejectResponse_->setStatusCode(static_cast<HttpStatusCode>(
+        config.get("rejection_status", 403).asInt()));
+    rejectResponse_->setBody(
+        config.get("rejection_message", "Forbidden").asString());
+
+    if (allowed_.empty() && denied_.empty())
+    {
+        LOG_WARN << "The IpFilter plugin has neither allowed nor denied ips";
+        return;
+    }
+    app().registerPreRoutingAdvice([this](const HttpRequestPtr &req,
+                                          AdviceCallback &&acb,
+                                          AdviceChainCallback &&accb) {
+        const auto &addr = useRealIpResolver_
+                               ? RealIpResolver::GetRealAddr(req)
+                               : req->getPeerAddr();
+        if (isAllowed(addr))
+        {
+            accb();
+            return;
+        }
+        acb(rejectResponse_);
+    });
+}
+
+void IpFilter::shutdown()
+{
+}
+
+bool IpFilter::isAllowed(const trantor::InetAddress &addr) const
+{
+    if (allowed_.contains(addr))
+        return true;
+    if (!allowed_.empty())
+        return false;
+    return !denied_.contains(addr);
+}
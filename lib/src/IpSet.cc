@@ -0,0 +1,271 @@
+/**
+ *
+ *  @file IpSet.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/IpSet.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+constexpr unsigned char kIpv4Bits = 32;
+constexpr unsigned char kIpv6Bits = 128;
+
+int bitAt(const std::array<unsigned char, 16> &key, size_t index)
+{
+    return (key[index / 8] >> (7 - index % 8)) & 1;
+}
+
+// The length of the common prefix of two keys, up to maxLength bits
+unsigned char commonLength(const std::array<unsigned char, 16> &a,
+                           const std::array<unsigned char, 16> &b,
+                           unsigned char maxLength)
+{
+    for (size_t i = 0; i * 8 < maxLength; ++i)
+    {
+        unsigned char diff = a[i] ^ b[i];
+        if (diff == 0)
+            continue;
+        size_t length = i * 8;
+        while ((diff & 0x80) == 0)
+        {
+            diff <<= 1;
+            ++length;
+        }
+        return static_cast<unsigned char>(
+            (std::min)(length, static_cast<size_t>(maxLength)));
+    }
+    return maxLength;
+}
+
+// Parse an address, false if it is neither an IPv4 nor an IPv6 address
+bool parseIp(std::string_view ip,
+             std::array<unsigned char, 16> &key,
+             bool &isIpV6)
+{
+    if (ip.empty() || ip.length() > 45)
+        return false;
+    std::string text(ip);
+    key.fill(0);
+    isIpV6 = text.find(':') != std::string::npos;
+    if (isIpV6)
+    {
+        in6_addr addr;
+        if (::inet_pton(AF_INET6, text.c_str(), &addr) != 1)
+            return false;
+        memcpy(key.data(), &addr, 16);
+    }
+    else
+    {
+        in_addr addr;
+        if (::inet_pton(AF_INET, text.c_str(), &addr) != 1)
+            return false;
+        memcpy(key.data(), &addr, 4);
+    }
+    return true;
+}
+
+// Look up the IPv4-mapped IPv6 addresses, ::ffff:a.b.c.d, as IPv4 ones
+bool unmapIpv4(std::array<unsigned char, 16> &key)
+{
+    for (size_t i = 0; i < 10; ++i)
+    {
+        if (key[i] != 0)
+            return false;
+    }
+    if (key[10] != 0xff || key[11] != 0xff)
+        return false;
+    memmove(key.data(), key.data() + 12, 4);
+    memset(key.data() + 4, 0, 12);
+    return true;
+}
+}  // namespace
+
+void IpSet::add(std::string_view ipOrCidr)
+{
+    auto pos = ipOrCidr.find('/');
+    Key key;
+    bool isIpV6;
+    if (!parseIp(ipOrCidr.substr(0, pos), key, isIpV6))
+    {
+        throw std::runtime_error("Bad IP address or CIDR block: " +
+                                 std::string(ipOrCidr));
+    }
+    unsigned char maxLength = isIpV6 ? kIpv6Bits : kIpv4Bits;
+    unsigned char length = maxLength;
+    if (pos != std::string_view::npos)
+    {
+        auto prefix = ipOrCidr.substr(pos + 1);
+        size_t value = 0;
+        if (prefix.empty() || prefix.length() > 3)
+            value = maxLength + 1;
+        for (auto c : prefix)
+        {
+            if (c < '0' || c > '9')
+            {
+                value = maxLength + 1;
+                break;
+            }
+            value = value * 10 + (c - '0');
+        }
+        if (value > maxLength)
+        {
+            throw std::runtime_error("Bad CIDR block: " +
+                                     std::string(ipOrCidr));
+        }
+        length = static_cast<unsigned char>(value);
+    }
+    insert(isIpV6 ? ipv6Root_ : ipv4Root_, key, length);
+    ++size_;
+}
+
+size_t IpSet::addLines(std::string_view text)
+{
+    size_t count = 0;
+    while (!text.empty())
+    {
+        auto end = text.find('\n');
+        auto line = text.substr(0, end);
+        text = end == std::string_view::npos ? std::string_view{}
+                                             : text.substr(end + 1);
+        auto comment = line.find_first_of("#;");
+        if (comment != std::string_view::npos)
+            line = line.substr(0, comment);
+        auto begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos)
+            continue;
+        line = line.substr(begin, line.find_last_not_of(" \t\r") + 1 - begin);
+        add(line);
+        ++count;
+    }
+    return count;
+}
+
+bool IpSet::contains(const trantor::InetAddress &addr) const
+{
+    Key key{};
+    if (!addr.isIpV6())
+    {
+        auto ip = addr.ipNetEndian();
+        memcpy(key.data(), &ip, 4);
+        return find(ipv4Root_, key);
+    }
+    memcpy(key.data(), addr.ip6NetEndian(), 16);
+    if (unmapIpv4(key))
+        return find(ipv4Root_, key);
+    return find(ipv6Root_, key);
+}
+
+bool IpSet::contains(std::string_view ip) const
+{
+    Key key;
+    bool isIpV6;
+    if (!parseIp(ip, key, isIpV6))
+        return false;
+    if (!isIpV6 || unmapIpv4(key))
+        return find(ipv4Root_, key);
+    return find(ipv6Root_, key);
+}
+
+void IpSet::clear()
+{
+    nodes_.clear();
+    ipv4Root_ = nullptr;
+    ipv6Root_ = nullptr;
+    size_ = 0;
+}
+
+IpSet::Node *IpSet::newNode(const Key &key, unsigned char length, bool member)
+{
+    auto &node = nodes_.emplace_back();
+    // Only the bits of the prefix are kept
+    for (size_t i = 0; i < node.key_.size() && i * 8 < length; ++i)
+    {
+        node.key_[i] = key[i];
+        auto bits = (i + 1) * 8;
+        if (bits > length)
+            node.key_[i] &=
+                static_cast<unsigned char>(0xff << (bits - length));
+    }
+    node.length_ = length;
+    node.member_ = member;
+    return &node;
+}
+
+void IpSet::insert(Node *&root, const Key &key, unsigned char length)
+{
+    Node **link = &root;
+    while (true)
+    {
+        Node *node = *link;
+        if (!node)
+        {
+            *link = newNode(key, length, true);
+            return;
+        }
+        auto common =
+            commonLength(node->key_, key, (std::min)(node->length_, length));
+        if (common == node->length_)
+        {
+            if (node->member_)
+            {
+                // Covered by a block of the set
+                return;
+            }
+            if (length == node->length_)
+            {
+                // The subtree is covered now, its nodes are unlinked but
+                // stay allocated until the set is cleared
+                node->member_ = true;
+                node->children_[0] = nullptr;
+                node->children_[1] = nullptr;
+                return;
+            }
+            link = &node->children_[bitAt(key, node->length_)];
+            continue;
+        }
+        if (common == length)
+        {
+            // The new block covers the whole subtree
+            *link = newNode(key, length, true);
+            return;
+        }
+        // Branch where the new block and the node differ
+        auto branch = newNode(key, common, false);
+        branch->children_[bitAt(node->key_, common)] = node;
+        branch->children_[bitAt(key, common)] = newNode(key, length, true);
+        *link = branch;
+        return;
+    }
+}
+
+bool IpSet::find(const Node *node, const Key &key)
+{
+    while (node)
+    {
+        if (commonLength(node->key_, key, node->length_) != node->length_)
+            return false;
+        if (node->member_)
+            return true;
+        node = node->children_[bitAt(key, node->length_)];
+    }
+    return false;
+}
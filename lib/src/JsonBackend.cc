@@ -0,0 +1,292 @@
+/**
+ *
+ *  @file JsonBackend.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/JsonBackend.h>
+#include <drogon/HttpAppFramework.h>
+#include <json/json.h>
+#include <mutex>
+#include <sstream>
+#ifdef USE_SIMDJSON
+#include <simdjson.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+class JsoncppBackend : public JsonBackend
+{
+  public:
+    const char *name() const override
+    {
+        return "jsoncpp";
+    }
+
+    bool parse(std::string_view document,
+               Json::Value &root,
+               std::string &errs) const override
+    {
+        // The readers and writers keep no state between two documents, one
+        // per thread is enough.
+        thread_local std::unique_ptr<Json::CharReader> reader(
+            readerBuilder().newCharReader());
+        JSONCPP_STRING err;
+        if (!reader->parse(document.data(),
+                           document.data() + document.size(),
+                           &root,
+                           &err))
+        {
+            errs = std::move(err);
+            return false;
+        }
+        return true;
+    }
+
+    std::string write(const Json::Value &value) const override
+    {
+        thread_local std::unique_ptr<Json::StreamWriter> writer(
+            writerBuilder().newStreamWriter());
+        thread_local std::ostringstream stream;
+        stream.str(std::string());
+        writer->write(value, &stream);
+        return stream.str();
+    }
+
+  private:
+    static const Json::CharReaderBuilder &readerBuilder()
+    {
+        static std::once_flag once;
+        static Json::CharReaderBuilder builder;
+        std::call_once(once, []() {
+            builder["collectComments"] = false;
+            builder["stackLimit"] = static_cast<Json::UInt>(
+                drogon::app().getJsonParserStackLimit());
+        });
+        return builder;
+    }
+
+    static const Json::StreamWriterBuilder &writerBuilder()
+    {
+        static std::once_flag once;
+        static Json::StreamWriterBuilder builder;
+        std::call_once(once, []() {
+            builder["commentStyle"] = "None";
+            builder["indentation"] = "";
+            if (!app().isUnicodeEscapingUsedInJson())
+            {
+                builder["emitUTF8"] = true;
+            }
+            auto &precision = app().getFloatPrecisionInJson();
+            if (precision.first != 0)
+            {
+                builder["precision"] = precision.first;
+                builder["precisionType"] = precision.second;
+            }
+        });
+        return builder;
+    }
+};
+
+#ifdef USE_SIMDJSON
+class SimdjsonBackend : public JsoncppBackend
+{
+  public:
+    const char *name() const override
+    {
+        return "simdjson";
+    }
+
+    bool parse(std::string_view document,
+               Json::Value &root,
+               std::string &errs) const override
+    {
+        simdjson::dom::element element;
+        if (parser().parse(document.data(), document.size()).get(element) !=
+            simdjson::SUCCESS)
+        {
+            // jsoncpp accepts more documents, and reports the errors
+            return JsoncppBackend::parse(document, root, errs);
+        }
+        root = Json::Value();
+        toJson(element, root);
+        return true;
+    }
+
+    bool parseAt(std::string_view document,
+                 std::string_view pointer,
+                 Json::Value &value) const override
+    {
+        simdjson::dom::element element;
+        if (parser().parse(document.data(), document.size()).get(element) !=
+            simdjson::SUCCESS)
+        {
+            return JsoncppBackend::parseAt(document, pointer, value);
+        }
+        if (element.at_pointer(pointer).get(element) != simdjson::SUCCESS)
+            return false;
+        value = Json::Value();
+        toJson(element, value);
+        return true;
+    }
+
+  private:
+    static simdjson::dom::parser &parser()
+    {
+        thread_local simdjson::dom::parser parser = []() {
+            simdjson::dom::parser p;
+            // The deeper documents are left to jsoncpp, which reports them.
+            // On failure, the parser allocates on its first document.
+            auto error = p.allocate(simdjson::SIMDJSON_PADDING,
+                                    drogon::app().getJsonParserStackLimit());
+            (void)error;
+            return p;
+        }();
+        return parser;
+    }
+
+    static void toJson(simdjson::dom::element element, Json::Value &value)
+    {
+        using simdjson::dom::element_type;
+        switch (element.type())
+        {
+            case element_type::ARRAY:
+            {
+                value = Json::Value(Json::arrayValue);
+                Json::ArrayIndex index = 0;
+                simdjson::dom::array array = element.get_array().value_unsafe();
+                for (auto child : array)
+                    toJson(child, value[index++]);
+                break;
+            }
+            case element_type::OBJECT:
+            {
+                value = Json::Value(Json::objectValue);
+                simdjson::dom::object object =
+                    element.get_object().value_unsafe();
+                for (auto field : object)
+                {
+                    toJson(field.value,
+                           *value.demand(field.key.data(),
+                                         field.key.data() + field.key.size()));
+                }
+                break;
+            }
+            case element_type::INT64:
+                value = Json::Value(static_cast<Json::Int64>(
+                    element.get_int64().value_unsafe()));
+                break;
+            case element_type::UINT64:
+                value = Json::Value(static_cast<Json::UInt64>(
+                    element.get_uint64().value_unsafe()));
+                break;
+            case element_type::DOUBLE:
+                value = Json::Value(element.get_double().value_unsafe());
+                break;
+            case element_type::STRING:
+            {
+                auto str = element.get_string().value_unsafe();
+                value = Json::Value(str.data(), str.data() + str.size());
+                break;
+            }
+            case element_type::BOOL:
+                value = Json::Value(element.get_bool().value_unsafe());
+                break;
+            default:
+                value = Json::Value();
+                break;
+        }
+    }
+};
+#endif
+}  // namespace
+
+bool JsonBackend::parseAt(std::string_view document,
+                          std::string_view pointer,
+                          Json::Value &value) const
+{
+    Json::Value root;
+    std::string errs;
+    if (!parse(document, root, errs))
+        return false;
+    auto found = resolve(root, pointer);
+    if (!found)
+        return false;
+    // The root is ours, move the value out of it
+    value.swap(*const_cast<Json::Value *>(found));
+    return true;
+}
+
+const Json::Value *JsonBackend::resolve(const Json::Value &root,
+                                        std::string_view pointer)
+{
+    if (pointer.empty())
+        return &root;
+    if (pointer[0] != '/')
+        return nullptr;
+    const Json::Value *value = &root;
+    std::string token;
+    while (!pointer.empty())
+    {
+        pointer.remove_prefix(1);
+        auto end = pointer.find('/');
+        auto escaped = pointer.substr(0, end);
+        pointer.remove_prefix(escaped.size());
+        token.clear();
+        for (size_t i = 0; i < escaped.size(); ++i)
+        {
+            if (escaped[i] != '~')
+            {
+                token += escaped[i];
+                continue;
+            }
+            if (i + 1 == escaped.size() ||
+                (escaped[i + 1] != '0' && escaped[i + 1] != '1'))
+                return nullptr;
+            token += escaped[++i] == '0' ? '~' : '/';
+        }
+        if (value->isObject())
+        {
+            value = value->find(token.data(), token.data() + token.size());
+            if (!value)
+                return nullptr;
+        }
+        else if (value->isArray())
+        {
+            // Decimal indexes without leading zeros
+            if (token.empty() || token.size() > 9 ||
+                (token.size() > 1 && token[0] == '0') ||
+                token.find_first_not_of("0123456789") != std::string::npos)
+                return nullptr;
+            auto index = static_cast<Json::ArrayIndex>(std::stoul(token));
+            if (index >= value->size())
+                return nullptr;
+            value = &(*value)[index];
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+    return value;
+}
+
+std::shared_ptr<JsonBackend> JsonBackend::create(const std::string &name)
+{
+    if (name == "jsoncpp")
+        return std::make_shared<JsoncppBackend>();
+#ifdef USE_SIMDJSON
+    if (name == "simdjson")
+        return std::make_shared<SimdjsonBackend>();
+#endif
+    return nullptr;
+}
@@ -0,0 +1,418 @@
+/**
+ *
+ *  @file JsonSaxParser.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "JsonSaxParser.h"
+
+using namespace drogon;
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool isValidNumber(const std::string &text)
+{
+    size_t i = 0, n = text.size();
+    if (i < n && text[i] == '-')
+        ++i;
+    if (i == n)
+        return false;
+    if (text[i] == '0')
+    {
+        ++i;
+    }
+    else if (isDigit(text[i]))
+    {
+        while (i < n && isDigit(text[i]))
+            ++i;
+    }
+    else
+    {
+        return false;
+    }
+    if (i < n && text[i] == '.')
+    {
+        if (++i == n || !isDigit(text[i]))
+            return false;
+        while (i < n && isDigit(text[i]))
+            ++i;
+    }
+    if (i < n && (text[i] == 'e' || text[i] == 'E'))
+    {
+        ++i;
+        if (i < n && (text[i] == '+' || text[i] == '-'))
+            ++i;
+        if (i == n || !isDigit(text[i]))
+            return false;
+        while (i < n && isDigit(text[i]))
+            ++i;
+    }
+    return i == n;
+}
+
+JsonSaxParser::JsonSaxParser(JsonSaxHandler &handler, size_t maxDepth)
+    : handler_(handler), maxDepth_(maxDepth)
+{
+}
+
+bool JsonSaxParser::fail(const char *reason)
+{
+    failed_ = true;
+    error_ = reason;
+    return false;
+}
+
+bool JsonSaxParser::parse(const char *data, size_t length)
+{
+    if (failed_)
+        return false;
+    const char *end = data + length;
+    const char *p = data;
+    while (p < end)
+    {
+        switch (token_)
+        {
+            case Token::kString:
+            {
+                if (escape_ || unicodeDigits_ > 0)
+                {
+                    if (!parseStringChar(*p++))
+                        return false;
+                    continue;
+                }
+                // Copy the plain characters in one go
+                auto start = p;
+                while (p < end && *p != '"' && *p != '\\' &&
+                       static_cast<unsigned char>(*p) >= 0x20)
+                    ++p;
+                if (p > start)
+                {
+                    if (highSurrogate_ != 0)
+                        return fail("invalid surrogate pair");
+                    text_.append(start, p);
+                }
+                if (p < end && !parseStringChar(*p++))
+                    return false;
+                continue;
+            }
+            case Token::kNumber:
+                if (isDigit(*p) || *p == '-' || *p == '+' || *p == '.' ||
+                    *p == 'e' || *p == 'E')
+                {
+                    text_.push_back(*p++);
+                    continue;
+                }
+                if (!endNumber())
+                    return false;
+                // The character ending the number is parsed below
+                break;
+            case Token::kLiteral:
+                if (*p >= 'a' && *p <= 'z')
+                {
+                    text_.push_back(*p++);
+                    if (text_.size() > 5)
+                        return fail("invalid literal");
+                    continue;
+                }
+                if (!endLiteral())
+                    return false;
+                break;
+            case Token::kNone:
+                break;
+        }
+        char c = *p++;
+        if (isSpace(c))
+            continue;
+        bool ok = true;
+        switch (expect_)
+        {
+            case Expect::kValueOrEnd:
+                ok = c == ']' ? endContainer(c) : startValue(c);
+                break;
+            case Expect::kValue:
+                ok = startValue(c);
+                break;
+            case Expect::kKeyOrEnd:
+            case Expect::kKey:
+                if (c == '}' && expect_ == Expect::kKeyOrEnd)
+                {
+                    ok = endContainer(c);
+                }
+                else if (c == '"')
+                {
+                    token_ = Token::kString;
+                    isKey_ = true;
+                    text_.clear();
+                }
+                else
+                {
+                    ok = fail("expected a member name");
+                }
+                break;
+            case Expect::kColon:
+                if (c == ':')
+                    expect_ = Expect::kValue;
+                else
+                    ok = fail("expected ':'");
+                break;
+            case Expect::kCommaOrEnd:
+                if (c == ',')
+                    expect_ =
+                        stack_.back() == '{' ? Expect::kKey : Expect::kValue;
+                else if (c == '}' || c == ']')
+                    ok = endContainer(c);
+                else
+                    ok = fail("expected ',' or the end of a container");
+                break;
+            case Expect::kNothing:
+                ok = fail("unexpected data after the document");
+                break;
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool JsonSaxParser::finish()
+{
+    if (failed_)
+        return false;
+    // A number can only end with the input at the top level
+    if (token_ == Token::kNumber && !endNumber())
+        return false;
+    if (token_ == Token::kLiteral && !endLiteral())
+        return false;
+    if (expect_ != Expect::kNothing)
+        return fail("incomplete document");
+    return true;
+}
+
+bool JsonSaxParser::startValue(char c)
+{
+    switch (c)
+    {
+        case '{':
+        case '[':
+            if (stack_.size() >= maxDepth_)
+                return fail("too deeply nested");
+            stack_.push_back(c);
+            if (c == '{')
+            {
+                expect_ = Expect::kKeyOrEnd;
+                if (!handler_.onStartObject())
+                    return fail("stopped by the handler");
+            }
+            else
+            {
+                expect_ = Expect::kValueOrEnd;
+                if (!handler_.onStartArray())
+                    return fail("stopped by the handler");
+            }
+            return true;
+        case '"':
+            token_ = Token::kString;
+            isKey_ = false;
+            text_.clear();
+            return true;
+        case 't':
+        case 'f':
+        case 'n':
+            token_ = Token::kLiteral;
+            text_.assign(1, c);
+            return true;
+        default:
+            if (c == '-' || isDigit(c))
+            {
+                token_ = Token::kNumber;
+                text_.assign(1, c);
+                return true;
+            }
+            return fail("unexpected character");
+    }
+}
+
+bool JsonSaxParser::endContainer(char c)
+{
+    if (stack_.empty() || (c == '}') != (stack_.back() == '{'))
+        return fail("mismatched bracket");
+    stack_.pop_back();
+    afterValue();
+    bool ok = c == '}' ? handler_.onEndObject() : handler_.onEndArray();
+    return ok || fail("stopped by the handler");
+}
+
+bool JsonSaxParser::endString()
+{
+    token_ = Token::kNone;
+    bool ok;
+    if (isKey_)
+    {
+        expect_ = Expect::kColon;
+        ok = handler_.onKey(text_);
+    }
+    else
+    {
+        afterValue();
+        ok = handler_.onString(text_);
+    }
+    return ok || fail("stopped by the handler");
+}
+
+bool JsonSaxParser::endNumber()
+{
+    token_ = Token::kNone;
+    if (!isValidNumber(text_))
+        return fail("invalid number");
+    afterValue();
+    return handler_.onNumber(text_) || fail("stopped by the handler");
+}
+
+bool JsonSaxParser::endLiteral()
+{
+    token_ = Token::kNone;
+    bool ok;
+    if (text_ == "true")
+        ok = handler_.onBool(true);
+    else if (text_ == "false")
+        ok = handler_.onBool(false);
+    else if (text_ == "null")
+        ok = handler_.onNull();
+    else
+        return fail("invalid literal");
+    afterValue();
+    return ok || fail("stopped by the handler");
+}
+
+bool JsonSaxParser::parseStringChar(char c)
+{
+    if (unicodeDigits_ > 0)
+    {
+        auto value = hexValue(c);
+        if (value < 0)
+            return fail("invalid unicode escape");
+        codepoint_ = (codepoint_ << 4) | static_cast<uint32_t>(value);
+        if (--unicodeDigits_ > 0)
+            return true;
+        if (highSurrogate_ != 0)
+        {
+            if (codepoint_ < 0xdc00 || codepoint_ > 0xdfff)
+                return fail("invalid surrogate pair");
+            appendCodepoint(0x10000 + ((highSurrogate_ - 0xd800) << 10) +
+                            (codepoint_ - 0xdc00));
+            highSurrogate_ = 0;
+        }
+        else if (codepoint_ >= 0xd800 && codepoint_ <= 0xdbff)
+        {
+            highSurrogate_ = codepoint_;
+        }
+        else if (codepoint_ >= 0xdc00 && codepoint_ <= 0xdfff)
+        {
+            return fail("invalid surrogate pair");
+        }
+        else
+        {
+            appendCodepoint(codepoint_);
+        }
+        return true;
+    }
+    if (escape_)
+    {
+        escape_ = false;
+        if (highSurrogate_ != 0 && c != 'u')
+            return fail("invalid surrogate pair");
+        switch (c)
+        {
+            case '"':
+            case '\\':
+            case '/':
+                text_.push_back(c);
+                return true;
+            case 'b':
+                text_.push_back('\b');
+                return true;
+            case 'f':
+                text_.push_back('\f');
+                return true;
+            case 'n':
+                text_.push_back('\n');
+                return true;
+            case 'r':
+                text_.push_back('\r');
+                return true;
+            case 't':
+                text_.push_back('\t');
+                return true;
+            case 'u':
+                unicodeDigits_ = 4;
+                codepoint_ = 0;
+                return true;
+            default:
+                return fail("invalid escape");
+        }
+    }
+    if (c == '\\')
+    {
+        escape_ = true;
+        return true;
+    }
+    if (highSurrogate_ != 0)
+        return fail("invalid surrogate pair");
+    if (c == '"')
+        return endString();
+    // The plain characters are copied by parse()
+    return fail("control character in a string");
+}
+
+void JsonSaxParser::appendCodepoint(uint32_t codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        text_.push_back(static_cast<char>(codepoint));
+    }
+    else if (codepoint < 0x800)
+    {
+        text_.push_back(static_cast<char>(0xc0 | (codepoint >> 6)));
+        text_.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    }
+    else if (codepoint < 0x10000)
+    {
+        text_.push_back(static_cast<char>(0xe0 | (codepoint >> 12)));
+        text_.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+        text_.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    }
+    else
+    {
+        text_.push_back(static_cast<char>(0xf0 | (codepoint >> 18)));
+        text_.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f)));
+        text_.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f)));
+        text_.push_back(static_cast<char>(0x80 | (codepoint & 0x3f)));
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ *
+ *  @file JsonSaxParser.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/RequestStream.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A push parser of a JSON document (RFC8259) fed in pieces of any
+ * size. Values split across pieces are buffered, the containers are tracked
+ * on an explicit stack, so the memory used is bounded by the largest string
+ * or number and the nesting depth.
+ */
+class DROGON_EXPORT JsonSaxParser
+{
+  public:
+    JsonSaxParser(JsonSaxHandler &handler, size_t maxDepth = 256);
+
+    /// Return false on a syntax error or when the handler stops the parsing.
+    bool parse(const char *data, size_t length);
+
+    /// End the input, return false if the document is incomplete.
+    bool finish();
+
+    /// The reason of the last failure
+    const std::string &error() const
+    {
+        return error_;
+    }
+
+  private:
+    enum class Expect : uint8_t
+    {
+        kValue,
+        kValueOrEnd,
+        kKeyOrEnd,
+        kKey,
+        kColon,
+        kCommaOrEnd,
+        kNothing
+    };
+
+    enum class Token : uint8_t
+    {
+        kNone,
+        kString,
+        kNumber,
+        kLiteral
+    };
+
+    bool fail(const char *reason);
+    bool startValue(char c);
+    bool endContainer(char c);
+    bool endString();
+    bool endNumber();
+    bool endLiteral();
+    bool parseStringChar(char c);
+    void appendCodepoint(uint32_t codepoint);
+
+    void afterValue()
+    {
+        expect_ = stack_.empty() ? Expect::kNothing : Expect::kCommaOrEnd;
+    }
+
+    JsonSaxHandler &handler_;
+    size_t maxDepth_;
+    std::vector<char> stack_;
+    Expect expect_{Expect::kValue};
+    Token token_{Token::kNone};
+    std::string text_;
+    bool isKey_{false};
+    bool escape_{false};
+    int unicodeDigits_{0};
+    uint32_t codepoint_{0};
+    uint32_t highSurrogate_{0};
+    bool failed_{false};
+    std::string error_;
+};
+
+}  // namespace drogon
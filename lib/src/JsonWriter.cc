@@ -0,0 +1,309 @@
+/**
+ *
+ *  @file JsonWriter.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/JsonWriter.h>
+#include <drogon/HttpResponse.h>
+#include <algorithm>
+#include <assert.h>
+#include <charconv>
+#include <clocale>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+
+using namespace drogon;
+
+JsonWriter::JsonWriter(ResponseStream &output, size_t flushThreshold)
+    : stream_(&output), flushThreshold_(flushThreshold)
+{
+    pending_.reserve(flushThreshold_ + 256);
+}
+
+JsonWriter::~JsonWriter()
+{
+    flush();
+}
+
+bool JsonWriter::flush()
+{
+    if (!stream_ || pending_.empty())
+        return true;
+    auto ret = stream_->send(pending_);
+    pending_.clear();
+    return ret;
+}
+
+void JsonWriter::write(const char *data, size_t length)
+{
+    bytesWritten_ += length;
+    if (string_)
+    {
+        string_->append(data, length);
+    }
+    else if (buffer_)
+    {
+        buffer_->append(data, length);
+    }
+    else
+    {
+        pending_.append(data, length);
+        if (pending_.length() >= flushThreshold_)
+            flush();
+    }
+}
+
+void JsonWriter::beforeValue()
+{
+    if (afterKey_)
+    {
+        afterKey_ = false;
+        return;
+    }
+    if (hasElements_.empty())
+        return;
+    if (hasElements_.back())
+        write(",", 1);
+    else
+        hasElements_.back() = true;
+}
+
+JsonWriter &JsonWriter::startObject()
+{
+    beforeValue();
+    write("{", 1);
+    hasElements_.push_back(false);
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject()
+{
+    assert(!hasElements_.empty() && !afterKey_);
+    hasElements_.pop_back();
+    write("}", 1);
+    return *this;
+}
+
+JsonWriter &JsonWriter::startArray()
+{
+    beforeValue();
+    write("[", 1);
+    hasElements_.push_back(false);
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray()
+{
+    assert(!hasElements_.empty());
+    hasElements_.pop_back();
+    write("]", 1);
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(std::string_view name)
+{
+    assert(!hasElements_.empty() && !afterKey_);
+    beforeValue();
+    writeString(name);
+    write(":", 1);
+    afterKey_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(std::string_view str)
+{
+    beforeValue();
+    writeString(str);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(bool b)
+{
+    beforeValue();
+    if (b)
+        write("true", 4);
+    else
+        write("false", 5);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(int64_t number)
+{
+    beforeValue();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), number);
+    write(buf, result.ptr - buf);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(uint64_t number)
+{
+    beforeValue();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), number);
+    write(buf, result.ptr - buf);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(double number)
+{
+    beforeValue();
+    if (!std::isfinite(number))
+    {
+        write("null", 4);
+        return *this;
+    }
+    char buf[32];
+#if defined(__cpp_lib_to_chars)
+    // The shortest representation which reads back as the same number, not
+    // depending on the locale
+    auto result = std::to_chars(buf, buf + sizeof(buf) - 2, number);
+    if (result.ec != std::errc())
+    {
+        write("null", 4);
+        return *this;
+    }
+    auto len = static_cast<int>(result.ptr - buf);
+#else
+    // No std::to_chars for floating point numbers in this library, the
+    // decimal point of the locale is replaced
+    auto len = snprintf(buf, sizeof(buf) - 2, "%.17g", number);
+    if (len <= 0 || static_cast<size_t>(len) >= sizeof(buf) - 2)
+    {
+        write("null", 4);
+        return *this;
+    }
+    auto point = localeconv()->decimal_point[0];
+    if (point != '.')
+        std::replace(buf, buf + len, point, '.');
+#endif
+    // Keep the value a real number for the readers, as jsoncpp does
+    if (!memchr(buf, '.', len) && !memchr(buf, 'e', len))
+    {
+        buf[len++] = '.';
+        buf[len++] = '0';
+    }
+    write(buf, len);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(std::nullptr_t)
+{
+    beforeValue();
+    write("null", 4);
+    return *this;
+}
+
+JsonWriter &JsonWriter::rawValue(std::string_view json)
+{
+    beforeValue();
+    write(json);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const Json::Value &json)
+{
+    switch (json.type())
+    {
+        case Json::nullValue:
+            return value(nullptr);
+        case Json::intValue:
+            return value(static_cast<int64_t>(json.asInt64()));
+        case Json::uintValue:
+            return value(static_cast<uint64_t>(json.asUInt64()));
+        case Json::realValue:
+            return value(json.asDouble());
+        case Json::booleanValue:
+            return value(json.asBool());
+        case Json::stringValue:
+        {
+            const char *begin{nullptr};
+            const char *end{nullptr};
+            json.getString(&begin, &end);
+            return value(std::string_view{begin,
+                                          static_cast<size_t>(end - begin)});
+        }
+        case Json::arrayValue:
+        {
+            startArray();
+            for (Json::ArrayIndex i = 0; i < json.size(); ++i)
+            {
+                value(json[i]);
+            }
+            return endArray();
+        }
+        case Json::objectValue:
+        {
+            startObject();
+            for (auto iter = json.begin(); iter != json.end(); ++iter)
+            {
+                const char *end{nullptr};
+                auto name = iter.memberName(&end);
+                key(std::string_view{name, static_cast<size_t>(end - name)});
+                value(*iter);
+            }
+            return endObject();
+        }
+    }
+    return *this;
+}
+
+void JsonWriter::writeString(std::string_view str)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    write("\"", 1);
+    size_t start = 0;
+    for (size_t i = 0; i < str.length(); ++i)
+    {
+        auto c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        // Write the run of characters which need no escaping at once
+        if (i > start)
+            write(str.data() + start, i - start);
+        start = i + 1;
+        switch (c)
+        {
+            case '"':
+                write("\\\"", 2);
+                break;
+            case '\\':
+                write("\\\\", 2);
+                break;
+            case '\b':
+                write("\\b", 2);
+                break;
+            case '\f':
+                write("\\f", 2);
+                break;
+            case '\n':
+                write("\\n", 2);
+                break;
+            case '\r':
+                write("\\r", 2);
+                break;
+            case '\t':
+                write("\\t", 2);
+                break;
+            default:
+            {
+                char buf[6] = {
+                    '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xf]};
+                write(buf, sizeof(buf));
+                break;
+            }
+        }
+    }
+    if (str.length() > start)
+        write(str.data() + start, str.length() - start);
+    write("\"", 1);
+}
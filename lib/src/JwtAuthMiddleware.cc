@@ -0,0 +1,239 @@
+/**
+ *
+ *  @file JwtAuthMiddleware.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/JwtAuthMiddleware.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/utils/Hasher.h>
+#include <drogon/utils/JsonBackend.h>
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+using namespace drogon;
+
+static const std::string kClaimsKey = "drogon.jwt_claims";
+static constexpr size_t kHmacBlockSize = 64;
+
+static int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+HmacJwtVerifier::HmacJwtVerifier(std::string_view secret)
+{
+    std::string key(secret);
+    if (key.length() > kHmacBlockSize)
+    {
+        // The longer keys are replaced by their digest
+        utils::Hasher hasher(utils::HashAlgorithm::kSha256);
+        hasher.update(key);
+        key.resize(hasher.final(reinterpret_cast<unsigned char *>(&key[0])));
+    }
+    key.resize(kHmacBlockSize, '\0');
+    innerPad_ = key;
+    outerPad_ = key;
+    for (size_t i = 0; i < kHmacBlockSize; ++i)
+    {
+        innerPad_[i] ^= 0x36;
+        outerPad_[i] ^= 0x5c;
+    }
+}
+
+std::string HmacJwtVerifier::sign(std::string_view data) const
+{
+    utils::Hasher hasher(utils::HashAlgorithm::kSha256);
+    unsigned char inner[utils::Hasher::kMaxDigestLength];
+    hasher.update(innerPad_);
+    hasher.update(data);
+    auto length = hasher.final(inner);
+    hasher.update(outerPad_);
+    hasher.update(inner, length);
+    std::string signature(length, '\0');
+    hasher.final(reinterpret_cast<unsigned char *>(&signature[0]));
+    return signature;
+}
+
+bool HmacJwtVerifier::verify(std::string_view signingInput,
+                             std::string_view signature) const
+{
+    auto expected = sign(signingInput);
+    if (signature.length() != expected.length())
+        return false;
+    // Compare in constant time, not to reveal the length of the right prefix
+    unsigned char diff = 0;
+    for (size_t i = 0; i < expected.length(); ++i)
+        diff |= static_cast<unsigned char>(signature[i] ^ expected[i]);
+    return diff == 0;
+}
+
+JwtAuthMiddleware::JwtAuthMiddleware(std::vector<JwtVerifierPtr> verifiers,
+                                     size_t maxCachedTokens)
+    : verifiers_(std::move(verifiers)), maxCachedTokens_(maxCachedTokens)
+{
+}
+
+bool JwtAuthMiddleware::verify(std::string_view token,
+                               Json::Value &claims,
+                               int64_t &expiry) const
+{
+    auto firstDot = token.find('.');
+    if (firstDot == std::string_view::npos)
+        return false;
+    auto secondDot = token.find('.', firstDot + 1);
+    if (secondDot == std::string_view::npos ||
+        token.find('.', secondDot + 1) != std::string_view::npos)
+        return false;
+
+    auto &backend = app().getJsonBackend();
+    Json::Value header;
+    std::string errs;
+    if (!backend->parse(utils::base64Decode(token.substr(0, firstDot)),
+                        header,
+                        errs) ||
+        !header.isObject() || !header["alg"].isString())
+        return false;
+    auto algorithm = header["alg"].asString();
+    const JwtVerifier *verifier = nullptr;
+    for (auto &v : verifiers_)
+    {
+        if (v->algorithm() == algorithm)
+        {
+            verifier = v.get();
+            break;
+        }
+    }
+    if (!verifier ||
+        !verifier->verify(token.substr(0, secondDot),
+                          utils::base64Decode(token.substr(secondDot + 1))))
+        return false;
+
+    if (!backend->parse(utils::base64Decode(token.substr(
+                            firstDot + 1, secondDot - firstDot - 1)),
+                        claims,
+                        errs) ||
+        !claims.isObject())
+        return false;
+    auto time = now();
+    expiry = 0;
+    if (claims.isMember("exp"))
+    {
+        auto &exp = claims["exp"];
+        if (!exp.isNumeric() || exp.asInt64() <= time)
+            return false;
+        expiry = exp.asInt64();
+    }
+    if (claims.isMember("nbf"))
+    {
+        auto &nbf = claims["nbf"];
+        if (!nbf.isNumeric() || nbf.asInt64() > time)
+            return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const Json::Value> JwtAuthMiddleware::lookup(
+    std::string_view token)
+{
+    if (maxCachedTokens_ == 0)
+        return nullptr;
+    std::call_once(cachesOnce_, [this]() {
+        caches_ = std::make_unique<IOThreadStorage<TokenCache>>();
+    });
+    auto &cache = caches_->getThreadData();
+    auto it = cache.find(std::string(token));
+    if (it == cache.end())
+        return nullptr;
+    if (it->second.expiry != 0 && it->second.expiry <= now())
+    {
+        cache.erase(it);
+        return nullptr;
+    }
+    return it->second.claims;
+}
+
+void JwtAuthMiddleware::cache(std::string_view token,
+                              const std::shared_ptr<const Json::Value> &claims,
+                              int64_t expiry)
+{
+    if (maxCachedTokens_ == 0)
+        return;
+    auto &cache = caches_->getThreadData();
+    if (cache.size() >= maxCachedTokens_)
+    {
+        auto time = now();
+        for (auto it = cache.begin(); it != cache.end();)
+        {
+            if (it->second.expiry != 0 && it->second.expiry <= time)
+                it = cache.erase(it);
+            else
+                ++it;
+        }
+        // Make room for the token when none of them is expired
+        if (cache.size() >= maxCachedTokens_)
+            cache.erase(cache.begin());
+    }
+    cache[std::string(token)] = CachedToken{claims, expiry};
+}
+
+void JwtAuthMiddleware::invoke(const HttpRequestPtr &req,
+                               MiddlewareNextCallback &&nextCb,
+                               MiddlewareCallback &&mcb)
+{
+    const auto &authorization = req->getHeader("authorization");
+    std::string_view token;
+    if (authorization.length() > 7)
+    {
+        std::string scheme = authorization.substr(0, 7);
+        std::transform(scheme.begin(),
+                       scheme.end(),
+                       scheme.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (scheme == "bearer ")
+            token = std::string_view(authorization).substr(7);
+    }
+    auto tokenClaims = token.empty() ? nullptr : lookup(token);
+    if (!tokenClaims && !token.empty())
+    {
+        auto parsed = std::make_shared<Json::Value>();
+        int64_t expiry;
+        if (verify(token, *parsed, expiry))
+        {
+            cache(token, parsed, expiry);
+            tokenClaims = std::move(parsed);
+        }
+    }
+    if (!tokenClaims)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k401Unauthorized);
+        resp->addHeader("www-authenticate",
+                        token.empty() ? "Bearer"
+                                      : "Bearer error=\"invalid_token\"");
+        mcb(resp);
+        return;
+    }
+    req->attributes()->insert(kClaimsKey, std::move(tokenClaims));
+    nextCb(std::move(mcb));
+}
+
+const Json::Value &JwtAuthMiddleware::claims(const HttpRequestPtr &req)
+{
+    static const Json::Value nullClaims;
+    auto &claims =
+        req->attributes()->get<std::shared_ptr<const Json::Value>>(
+            kClaimsKey);
+    return claims ? *claims : nullClaims;
+}
@@ -16,10 +16,19 @@
 #include <drogon/config.h>
 #include <fcntl.h>
 #include <trantor/utils/Logger.h>
+#include "HotRestart.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpServer.h"
+#include "HttpUtils.h"
+#include "WorkerProcesses.h"
+#ifdef USE_QUICHE
+#include "Http3Listener.h"
+#endif
 #ifndef _WIN32
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/file.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #endif
 
@@ -50,6 +59,118 @@ class DrogonFileLocker : public trantor::NonCopyable
 using namespace trantor;
 using namespace drogon;
 
+namespace
+{
+#ifndef _WIN32
+void setOption(int fd, int level, int name, int value, const char *optionName)
+{
+    if (::setsockopt(fd, level, name, &value, sizeof(value)) != 0)
+    {
+        LOG_SYSERR << "setsockopt " << optionName;
+    }
+}
+#endif
+
+// The options of the listening socket, the buffer sizes are inherited by the
+// accepted connections
+std::function<void(int)> listenOptionsCallback(
+    const ListenerSocketOptions &options,
+    std::function<void(int)> next)
+{
+#ifndef _WIN32
+    if (options.deferAccept == 0 && options.fastOpenQueueLength == 0 &&
+        options.sendBufferSize == 0 && options.receiveBufferSize == 0)
+    {
+        return next;
+    }
+    return [options, next = std::move(next)](int fd) {
+#ifdef TCP_DEFER_ACCEPT
+        if (options.deferAccept > 0)
+        {
+            setOption(fd,
+                      IPPROTO_TCP,
+                      TCP_DEFER_ACCEPT,
+                      options.deferAccept,
+                      "TCP_DEFER_ACCEPT");
+        }
+#endif
+#ifdef TCP_FASTOPEN
+        if (options.fastOpenQueueLength > 0)
+        {
+            setOption(fd,
+                      IPPROTO_TCP,
+                      TCP_FASTOPEN,
+                      options.fastOpenQueueLength,
+                      "TCP_FASTOPEN");
+        }
+#endif
+        if (options.sendBufferSize > 0)
+        {
+            setOption(fd,
+                      SOL_SOCKET,
+                      SO_SNDBUF,
+                      options.sendBufferSize,
+                      "SO_SNDBUF");
+        }
+        if (options.receiveBufferSize > 0)
+        {
+            setOption(fd,
+                      SOL_SOCKET,
+                      SO_RCVBUF,
+                      options.receiveBufferSize,
+                      "SO_RCVBUF");
+        }
+        if (next)
+            next(fd);
+    };
+#else
+    return next;
+#endif
+}
+
+// The options of the accepted connections
+std::function<void(int)> acceptOptionsCallback(
+    const ListenerSocketOptions &options,
+    std::function<void(int)> next)
+{
+#ifndef _WIN32
+    if (options.busyPoll == 0 && options.notSentLowat == 0 &&
+        !options.tcpNoDelay)
+    {
+        return next;
+    }
+    return [options, next = std::move(next)](int fd) {
+#ifdef SO_BUSY_POLL
+        if (options.busyPoll > 0)
+        {
+            setOption(fd,
+                      SOL_SOCKET,
+                      SO_BUSY_POLL,
+                      options.busyPoll,
+                      "SO_BUSY_POLL");
+        }
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+        if (options.notSentLowat > 0)
+        {
+            setOption(fd,
+                      IPPROTO_TCP,
+                      TCP_NOTSENT_LOWAT,
+                      options.notSentLowat,
+                      "TCP_NOTSENT_LOWAT");
+        }
+#endif
+        if (options.tcpNoDelay)
+            setOption(fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+        if (next)
+            next(fd);
+    };
+#else
+    return next;
+#endif
+}
+}  // namespace
+
 void ListenerManager::addListener(
     const std::string &ip,
     uint16_t port,
@@ -57,12 +178,28 @@ void ListenerManager::addListener(
     const std::string &certFile,
     const std::string &keyFile,
     bool useOldTLS,
-    const std::vector<std::pair<std::string, std::string>> &sslConfCmds)
+    const std::vector<std::pair<std::string, std::string>> &sslConfCmds,
+    bool proxyProtocol,
+    const ListenerSocketOptions &socketOptions)
 {
     if (useSSL && !utils::supportsTls())
         LOG_ERROR << "Can't use SSL without OpenSSL found in your system";
-    listeners_.emplace_back(
-        ip, port, useSSL, certFile, keyFile, useOldTLS, sslConfCmds);
+    if (useSSL && proxyProtocol)
+    {
+        // TLS starts when the connections are accepted, before the header
+        LOG_FATAL << "The PROXY protocol can't be used on the https listener "
+                  << ip << ":" << port;
+        exit(1);
+    }
+    listeners_.emplace_back(ip,
+                            port,
+                            useSSL,
+                            certFile,
+                            keyFile,
+                            useOldTLS,
+                            sslConfCmds,
+                            proxyProtocol,
+                            socketOptions);
 }
 
 std::vector<trantor::InetAddress> ListenerManager::getListeners() const
@@ -75,6 +212,17 @@ std::vector<trantor::InetAddress> ListenerManager::getListeners() const
     return listeners;
 }
 
+std::vector<trantor::InetAddress> ListenerManager::getListenAddresses() const
+{
+    std::vector<trantor::InetAddress> addresses;
+    for (auto const &listener : listeners_)
+    {
+        bool isIpv6 = (listener.ip_.find(':') != std::string::npos);
+        addresses.emplace_back(listener.ip_, listener.port_, isIpv6);
+    }
+    return addresses;
+}
+
 void ListenerManager::createListeners(
     const std::string &globalCertFile,
     const std::string &globalKeyFile,
@@ -83,8 +231,29 @@ void ListenerManager::createListeners(
 {
     LOG_TRACE << "thread num=" << ioLoops.size();
 #ifdef __linux__
+    const auto &cpus = app().getIoThreadsAffinity();
     for (size_t i = 0; i < ioLoops.size(); ++i)
     {
+        auto beforeListenCallback = beforeListenSetSockOptCallback_;
+        if (!cpus.empty())
+        {
+            // The kernel prefers the reuseport socket which is bound to the
+            // CPU that received the connection. The numbers were checked
+            // against the affinity mask by setIoThreadsAffinity()
+            int cpu = static_cast<int>(cpus[i % cpus.size()]);
+            beforeListenCallback = [cpu, cb = beforeListenCallback](int fd) {
+                if (::setsockopt(fd,
+                                 SOL_SOCKET,
+                                 SO_INCOMING_CPU,
+                                 &cpu,
+                                 sizeof(cpu)) != 0)
+                {
+                    LOG_SYSERR << "setsockopt SO_INCOMING_CPU";
+                }
+                if (cb)
+                    cb(fd);
+            };
+        }
         for (auto const &listener : listeners_)
         {
             auto const &ip = listener.ip_;
@@ -97,7 +266,11 @@ void ListenerManager::createListeners(
                              "supported. Including 'localhost')";
                 abort();
             }
-            if (i == 0 && !app().reusePort())
+            // The port is in use by the process whose sockets are taken over,
+            // or by the master of the workers
+            if (i == 0 && !app().reusePort() &&
+                !HotRestart::instance().inherits(listenAddress) &&
+                !WorkerProcesses::instance().inherits(listenAddress))
             {
                 DrogonFileLocker lock;
                 // Check whether the port is in use.
@@ -111,20 +284,32 @@ void ListenerManager::createListeners(
                 std::make_shared<HttpServer>(ioLoops[i],
                                              listenAddress,
                                              "drogon");
-            if (beforeListenSetSockOptCallback_)
+            auto listenCallback = HotRestart::instance().wrapBeforeListen(
+                listenAddress,
+                WorkerProcesses::instance().wrapBeforeListen(
+                    listenAddress,
+                    listenOptionsCallback(listener.socketOptions_,
+                                          beforeListenCallback)));
+            if (listenCallback)
             {
                 serverPtr->setBeforeListenSockOptCallback(
-                    beforeListenSetSockOptCallback_);
+                    std::move(listenCallback));
             }
-            if (afterAcceptSetSockOptCallback_)
+            if (auto acceptCallback =
+                    acceptOptionsCallback(listener.socketOptions_,
+                                          afterAcceptSetSockOptCallback_))
             {
                 serverPtr->setAfterAcceptSockOptCallback(
-                    afterAcceptSetSockOptCallback_);
+                    std::move(acceptCallback));
             }
             if (connectionCallback_)
             {
                 serverPtr->setConnectionCallback(connectionCallback_);
             }
+            if (listener.proxyProtocol_)
+            {
+                serverPtr->enableProxyProtocol();
+            }
 
             if (listener.useSSL_ && utils::supportsTls())
             {
@@ -148,7 +333,12 @@ void ListenerManager::createListeners(
                 auto policy =
                     trantor::TLSPolicy::defaultServerPolicy(cert, key);
                 policy->setConfCmds(cmds).setUseOldTLS(listener.useOldTLS_);
+                if (app().isHttp2Enabled())
+                    policy->setAlpnProtocols({"h2", "http/1.1"});
                 serverPtr->enableSSL(std::move(policy));
+                // Every loop has its own socket, like the TCP listeners
+                if (app().isHttp3Enabled())
+                    addHttp3Listener(ioLoops[i], listenAddress, cert, key);
             }
             servers_.push_back(serverPtr);
         }
@@ -164,10 +354,28 @@ void ListenerManager::createListeners(
         {
             auto ip = listener.ip_;
             bool isIpv6 = (ip.find(':') != std::string::npos);
-            auto serverPtr = std::make_shared<HttpServer>(
-                listeningThread_->getLoop(),
-                InetAddress(ip, listener.port_, isIpv6),
-                "drogon");
+            InetAddress listenAddress(ip, listener.port_, isIpv6);
+            auto serverPtr =
+                std::make_shared<HttpServer>(listeningThread_->getLoop(),
+                                             listenAddress,
+                                             "drogon");
+            if (auto listenCallback = HotRestart::instance().wrapBeforeListen(
+                    listenAddress,
+                    listenOptionsCallback(listener.socketOptions_, nullptr)))
+            {
+                serverPtr->setBeforeListenSockOptCallback(
+                    std::move(listenCallback));
+            }
+            if (auto acceptCallback =
+                    acceptOptionsCallback(listener.socketOptions_, nullptr))
+            {
+                serverPtr->setAfterAcceptSockOptCallback(
+                    std::move(acceptCallback));
+            }
+            if (listener.proxyProtocol_)
+            {
+                serverPtr->enableProxyProtocol();
+            }
             if (listener.useSSL_ && utils::supportsTls())
             {
                 auto cert = listener.certFile_;
@@ -187,7 +395,11 @@ void ListenerManager::createListeners(
                 auto policy =
                     trantor::TLSPolicy::defaultServerPolicy(cert, key);
                 policy->setConfCmds(cmds).setUseOldTLS(listener.useOldTLS_);
+                if (app().isHttp2Enabled())
+                    policy->setAlpnProtocols({"h2", "http/1.1"});
                 serverPtr->enableSSL(std::move(policy));
+                if (app().isHttp3Enabled())
+                    addHttp3Listener(ioLoops[0], listenAddress, cert, key);
             }
             serverPtr->setIoLoops(ioLoops);
             servers_.push_back(serverPtr);
@@ -196,12 +408,56 @@ void ListenerManager::createListeners(
 #endif
 }
 
+void ListenerManager::addHttp3Listener(trantor::EventLoop *loop,
+                                       const trantor::InetAddress &address,
+                                       const std::string &certFile,
+                                       const std::string &keyFile)
+{
+#ifdef USE_QUICHE
+    if (http3TicketKey_.empty())
+    {
+        http3TicketKey_.resize(48);
+        utils::secureRandomBytes(http3TicketKey_.data(),
+                                 http3TicketKey_.size());
+    }
+    http3Listeners_.push_back(
+        std::make_shared<Http3Listener>(loop,
+                                        address,
+                                        certFile,
+                                        keyFile,
+                                        http3TicketKey_,
+                                        HttpServer::onHttp3Request));
+    // The clients learn the port of HTTP/3 from the responses of any
+    // listener, the alternatives are listed once per port
+    auto &impl = HttpAppFrameworkImpl::instance();
+    impl.setAltSvcHeader(
+        addHttp3AltSvc(impl.getAltSvcHeaderString(), address.toPort()));
+#else
+    (void)loop;
+    (void)address;
+    (void)certFile;
+    (void)keyFile;
+    static bool warned = false;
+    if (!warned)
+    {
+        warned = true;
+        LOG_WARN << "HTTP/3 is not available, drogon is built without quiche";
+    }
+#endif
+}
+
 void ListenerManager::startListening()
 {
     for (auto &server : servers_)
     {
         server->start();
     }
+#ifdef USE_QUICHE
+    for (auto &listener : http3Listeners_)
+    {
+        listener->start();
+    }
+#endif
 }
 
 void ListenerManager::stopListening()
@@ -210,6 +466,12 @@ void ListenerManager::stopListening()
     {
         serverPtr->stop();
     }
+#ifdef USE_QUICHE
+    for (auto &listener : http3Listeners_)
+    {
+        listener->stop();
+    }
+#endif
     if (listeningThread_)
     {
         auto loop = listeningThread_->getLoop();
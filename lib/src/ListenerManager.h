@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <drogon/HttpAppFramework.h>
 #include <trantor/net/EventLoopThreadPool.h>
 #include <trantor/net/callbacks.h>
 #include <trantor/utils/NonCopyable.h>
@@ -30,6 +31,8 @@ class InetAddress;
 
 namespace drogon
 {
+class Http3Listener;
+
 class ListenerManager : public trantor::NonCopyable
 {
   public:
@@ -41,8 +44,12 @@ class ListenerManager : public trantor::NonCopyable
                      const std::string &keyFile = "",
                      bool useOldTLS = false,
                      const std::vector<std::pair<std::string, std::string>>
-                         &sslConfCmds = {});
+                         &sslConfCmds = {},
+                     bool proxyProtocol = false,
+                     const ListenerSocketOptions &socketOptions = {});
     std::vector<trantor::InetAddress> getListeners() const;
+    /// The addresses of the TCP listeners, before they are created
+    std::vector<trantor::InetAddress> getListenAddresses() const;
     void createListeners(
         const std::string &globalCertFile,
         const std::string &globalKeyFile,
@@ -70,6 +77,13 @@ class ListenerManager : public trantor::NonCopyable
     void reloadSSLFiles();
 
   private:
+    // The QUIC listener of an https listener on the loop, without quiche it
+    // does nothing
+    void addHttp3Listener(trantor::EventLoop *loop,
+                          const trantor::InetAddress &address,
+                          const std::string &certFile,
+                          const std::string &keyFile);
+
     struct ListenerInfo
     {
         ListenerInfo(
@@ -79,14 +93,18 @@ class ListenerManager : public trantor::NonCopyable
             std::string certFile,
             std::string keyFile,
             bool useOldTLS,
-            std::vector<std::pair<std::string, std::string>> sslConfCmds)
+            std::vector<std::pair<std::string, std::string>> sslConfCmds,
+            bool proxyProtocol,
+            const ListenerSocketOptions &socketOptions)
             : ip_(std::move(ip)),
               port_(port),
               useSSL_(useSSL),
               certFile_(std::move(certFile)),
               keyFile_(std::move(keyFile)),
               useOldTLS_(useOldTLS),
-              sslConfCmds_(std::move(sslConfCmds))
+              sslConfCmds_(std::move(sslConfCmds)),
+              proxyProtocol_(proxyProtocol),
+              socketOptions_(socketOptions)
         {
         }
 
@@ -97,10 +115,15 @@ class ListenerManager : public trantor::NonCopyable
         std::string keyFile_;
         bool useOldTLS_;
         std::vector<std::pair<std::string, std::string>> sslConfCmds_;
+        bool proxyProtocol_;
+        ListenerSocketOptions socketOptions_;
     };
 
     std::vector<ListenerInfo> listeners_;
     std::vector<std::shared_ptr<HttpServer>> servers_;
+    std::vector<std::shared_ptr<Http3Listener>> http3Listeners_;
+    // The key of the session tickets shared by the HTTP/3 listeners
+    std::vector<uint8_t> http3TicketKey_;
 
     // should have value when and only when on OS that one port can only be
     // listened by one thread
@@ -0,0 +1,120 @@
+/**
+ *
+ *  @file LiveConnections.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "LiveConnections.h"
+#include "HttpRequestParser.h"
+#include <atomic>
+
+using namespace drogon;
+
+void LiveConnections::enable(const std::vector<trantor::EventLoop *> &loops)
+{
+    if (enabled())
+        return;
+    for (auto loop : loops)
+    {
+        auto state = std::make_unique<LoopState>();
+        state->loop = loop;
+        loops_.push_back(std::move(state));
+    }
+}
+
+void LiveConnections::snapshot(size_t maxListed,
+                               std::function<void(Json::Value &&)> &&cb)
+{
+    struct Snapshot
+    {
+        // Each loop writes its own element
+        std::vector<Json::Value> loops;
+        std::atomic<size_t> remaining{0};
+        std::function<void(Json::Value &&)> callback;
+    };
+
+    if (loops_.empty())
+    {
+        cb(Json::Value(Json::arrayValue));
+        return;
+    }
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->loops.resize(loops_.size());
+    snapshot->remaining = loops_.size();
+    snapshot->callback = std::move(cb);
+    for (size_t i = 0; i < loops_.size(); ++i)
+    {
+        auto posted = trantor::Date::now();
+        // Run after the tasks already queued, so the delay is the one of
+        // the queue of the loop
+        loops_[i]->loop->queueInLoop([this, snapshot, i, maxListed, posted]() {
+            auto state = loopState(i, maxListed);
+            state["queue_delay"] =
+                static_cast<double>(
+                    trantor::Date::now().microSecondsSinceEpoch() -
+                    posted.microSecondsSinceEpoch()) /
+                1e6;
+            snapshot->loops[i] = std::move(state);
+            if (snapshot->remaining.fetch_sub(1, std::memory_order_acq_rel) !=
+                1)
+                return;
+            Json::Value loops(Json::arrayValue);
+            for (auto &loop : snapshot->loops)
+                loops.append(std::move(loop));
+            snapshot->callback(std::move(loops));
+        });
+    }
+}
+
+Json::Value LiveConnections::loopState(size_t index, size_t maxListed) const
+{
+    auto &state = *loops_[index];
+    auto now = trantor::Date::now();
+    Json::Value loop;
+    loop["index"] = static_cast<Json::UInt64>(index);
+    loop["open_connections"] =
+        static_cast<Json::UInt64>(state.connections.size());
+    Json::Value list(Json::arrayValue);
+    size_t pipelined = 0;
+    for (auto &item : state.connections)
+    {
+        auto &entry = item.second;
+        auto conn = entry.conn.lock();
+        if (!conn)
+            continue;
+        auto parser = conn->getContext<HttpRequestParser>();
+        size_t requests = parser ? parser->numberOfRequestsInPipelining() : 0;
+        pipelined += requests;
+        if (list.size() >= maxListed)
+            continue;
+        Json::Value info;
+        info["peer"] = parser ? parser->peerAddr(conn).toIpPort()
+                              : conn->peerAddr().toIpPort();
+        info["local"] = conn->localAddr().toIpPort();
+        info["age"] =
+            static_cast<double>(now.microSecondsSinceEpoch() -
+                                entry.opened.microSecondsSinceEpoch()) /
+            1e6;
+        info["bytes_received"] =
+            static_cast<Json::UInt64>(conn->bytesReceived());
+        info["bytes_sent"] = static_cast<Json::UInt64>(conn->bytesSent());
+        info["pipelined_requests"] = static_cast<Json::UInt64>(requests);
+        if (parser && parser->http2Conn())
+            info["protocol"] = "h2";
+        else if (parser && parser->webSocketConn())
+            info["protocol"] = "websocket";
+        else
+            info["protocol"] = "http/1.1";
+        list.append(std::move(info));
+    }
+    loop["pipelined_requests"] = static_cast<Json::UInt64>(pipelined);
+    loop["connections"] = std::move(list);
+    return loop;
+}
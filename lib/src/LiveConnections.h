@@ -0,0 +1,102 @@
+/**
+ *
+ *  @file LiveConnections.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/NonCopyable.h>
+#include <json/value.h>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The HTTP connections open on every IO loop, for the diagnosis.
+ *
+ * Every loop keeps its own connections, which are only touched in the loop,
+ * so the registry takes no lock. The state of the loops is read by tasks
+ * queued in them. It is only kept once enabled, before the listeners start.
+ */
+class LiveConnections : public trantor::NonCopyable
+{
+  public:
+    static LiveConnections &instance()
+    {
+        static LiveConnections inst;
+        return inst;
+    }
+
+    void enable(const std::vector<trantor::EventLoop *> &loops);
+
+    bool enabled() const
+    {
+        return !loops_.empty();
+    }
+
+    /// Called in the loop of the connection
+    void opened(const trantor::TcpConnectionPtr &conn)
+    {
+        if (auto state = stateOf(conn))
+            state->connections.emplace(conn.get(),
+                                       Entry{conn, trantor::Date::now()});
+    }
+
+    /// Called in the loop of the connection
+    void closed(const trantor::TcpConnectionPtr &conn)
+    {
+        if (auto state = stateOf(conn))
+            state->connections.erase(conn.get());
+    }
+
+    /**
+     * @brief Read the state of every loop in the loop, the callback is called
+     * with the array of the loops in the loop which answers last.
+     *
+     * @param maxListed The connections listed per loop, the others are only
+     * counted.
+     */
+    void snapshot(size_t maxListed, std::function<void(Json::Value &&)> &&cb);
+
+  private:
+    LiveConnections() = default;
+
+    struct Entry
+    {
+        std::weak_ptr<trantor::TcpConnection> conn;
+        trantor::Date opened;
+    };
+
+    struct LoopState
+    {
+        trantor::EventLoop *loop{nullptr};
+        std::unordered_map<trantor::TcpConnection *, Entry> connections;
+    };
+
+    LoopState *stateOf(const trantor::TcpConnectionPtr &conn)
+    {
+        auto index = conn->getLoop()->index();
+        if (index >= loops_.size() || loops_[index]->loop != conn->getLoop())
+            return nullptr;
+        return loops_[index].get();
+    }
+
+    Json::Value loopState(size_t index, size_t maxListed) const;
+
+    std::vector<std::unique_ptr<LoopState>> loops_;
+};
+}  // namespace drogon
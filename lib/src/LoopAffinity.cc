@@ -0,0 +1,124 @@
+/**
+ *
+ *  @file LoopAffinity.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "LoopAffinity.h"
+#include "HttpAppFrameworkImpl.h"
+#include "HttpRequestImpl.h"
+#include <trantor/net/EventLoop.h>
+#include <algorithm>
+#include <cctype>
+
+using namespace drogon;
+
+namespace
+{
+uint64_t hashOf(std::string_view text)
+{
+    // FNV-1a, finished by the mixer of MurmurHash3
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+}  // namespace
+
+bool LoopAffinity::setKey(const std::string &description)
+{
+    source_ = Source::kNone;
+    name_.clear();
+    if (description.empty())
+        return true;
+    if (description == "ip")
+    {
+        source_ = Source::kPeerIp;
+        return true;
+    }
+    auto colon = description.find(':');
+    if (colon == std::string::npos || colon + 1 == description.size())
+        return false;
+    auto kind = description.substr(0, colon);
+    name_ = description.substr(colon + 1);
+    if (kind == "header")
+    {
+        std::transform(name_.begin(),
+                       name_.end(),
+                       name_.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        source_ = Source::kHeader;
+        return true;
+    }
+    if (kind == "cookie")
+    {
+        source_ = Source::kCookie;
+        return true;
+    }
+    name_.clear();
+    return false;
+}
+
+std::string LoopAffinity::keyOf(const HttpRequestImpl &req) const
+{
+    switch (source_)
+    {
+        case Source::kPeerIp:
+            return req.peerAddr().toIp();
+        case Source::kHeader:
+            return req.getHeaderBy(name_);
+        case Source::kCookie:
+            return req.getCookie(name_);
+        default:
+            return {};
+    }
+}
+
+trantor::EventLoop *LoopAffinity::loopFor(const HttpRequestImpl &req) const
+{
+    // The streamed body is still read by the loop of the connection
+    if (!enabled() || req.streamStatus() != ReqStreamStatus::None)
+        return nullptr;
+    auto &app = HttpAppFrameworkImpl::instance();
+    auto loops = app.getThreadNum();
+    if (loops < 2)
+        return nullptr;
+    auto key = keyOf(req);
+    if (key.empty())
+        return nullptr;
+    auto loop = app.getIOLoop(pick(key, loops));
+    if (!loop || loop->isInLoopThread())
+        return nullptr;
+    return loop;
+}
+
+size_t LoopAffinity::pick(std::string_view key, size_t loops)
+{
+    // The jump consistent hash of Lamping and Veach
+    auto hash = hashOf(key);
+    int64_t bucket = -1;
+    int64_t next = 0;
+    while (next < static_cast<int64_t>(loops))
+    {
+        bucket = next;
+        hash = hash * 2862933555777941757ULL + 1;
+        next = static_cast<int64_t>(
+            static_cast<double>(bucket + 1) *
+            (static_cast<double>(1LL << 31) /
+             static_cast<double>((hash >> 33) + 1)));
+    }
+    return static_cast<size_t>(bucket);
+}
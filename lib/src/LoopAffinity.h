@@ -0,0 +1,88 @@
+/**
+ *
+ *  @file LoopAffinity.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <drogon/exports.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief Chooses the IO loop which handles a request by a key of the
+ * request, so the requests of a client or a tenant always use the per-loop
+ * data (IOThreadStorage, the fast db and redis clients, the caches) of the
+ * same loop.
+ *
+ * The key is the IP of the client ("ip"), a header ("header:X-Tenant") or a
+ * cookie ("cookie:tenant"). It is mapped to a loop by a jump consistent hash,
+ * so the keys keep their loops when the number of IO threads changes, but
+ * for the share of them moved to the new loops.
+ *
+ * A connection can't move to another loop once it is established, it is
+ * bound to its loop with its TLS state. So the requests are handed over to
+ * their loop once they are parsed and their responses are handed back, the
+ * requests without the key and the streamed ones are handled by the loop of
+ * their connection.
+ */
+class DROGON_EXPORT LoopAffinity
+{
+  public:
+    enum class Source
+    {
+        kNone = 0,
+        kPeerIp,
+        kHeader,
+        kCookie
+    };
+
+    /**
+     * @brief Set the key from its description, an empty one disables the
+     * affinity.
+     *
+     * @return false if the description is invalid, the affinity is disabled.
+     */
+    bool setKey(const std::string &description);
+
+    bool enabled() const
+    {
+        return source_ != Source::kNone;
+    }
+
+    Source source() const
+    {
+        return source_;
+    }
+
+    /// The key of the request, empty if the request has none
+    std::string keyOf(const HttpRequestImpl &req) const;
+
+    /**
+     * @brief The IO loop which should handle the request, nullptr to handle
+     * it in the current loop.
+     */
+    trantor::EventLoop *loopFor(const HttpRequestImpl &req) const;
+
+    /// The index of the loop of a key among a number of loops
+    static size_t pick(std::string_view key, size_t loops);
+
+  private:
+    Source source_{Source::kNone};
+    // The header in lower case or the cookie
+    std::string name_;
+};
+}  // namespace drogon
@@ -0,0 +1,41 @@
+/**
+ *
+ *  @file LoopHandoff.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "LoopHandoff.h"
+#include <drogon/HttpAppFramework.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace drogon;
+
+void LoopHandoff::runInLoop(trantor::EventLoop *loop,
+                            std::function<void()> &&task)
+{
+    // The IO loops are created before the application runs and live as long
+    // as it, so their handoffs are made once and never freed
+    static std::once_flag once;
+    static std::vector<std::unique_ptr<LoopHandoff>> handoffs;
+    std::call_once(once, []() {
+        for (size_t i = 0; i < app().getThreadNum(); ++i)
+            handoffs.push_back(
+                std::make_unique<LoopHandoff>(app().getIOLoop(i)));
+    });
+    auto index = loop->index();
+    if (index < handoffs.size() && handoffs[index]->loop() == loop)
+    {
+        handoffs[index]->run(std::move(task));
+        return;
+    }
+    loop->queueInLoop(std::move(task));
+}
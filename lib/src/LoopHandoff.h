@@ -0,0 +1,74 @@
+/**
+ *
+ *  @file LoopHandoff.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/LockFreeQueue.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <functional>
+
+namespace drogon
+{
+/**
+ * @brief Hands the tasks of other threads over to a loop in batches.
+ *
+ * The tasks are put in a lock-free queue, and only the one which finds no
+ * drain scheduled queues a drain in the loop, which wakes it up. The tasks
+ * handed over before the drain runs, from any thread, are run by it, so a
+ * burst of completions on a database or compute thread costs one wakeup of
+ * the loop instead of one per task. The tasks of a thread run in order.
+ */
+class LoopHandoff : public trantor::NonCopyable
+{
+  public:
+    explicit LoopHandoff(trantor::EventLoop *loop) : loop_(loop)
+    {
+    }
+
+    trantor::EventLoop *loop() const
+    {
+        return loop_;
+    }
+
+    void run(std::function<void()> &&task)
+    {
+        tasks_.enqueue(std::move(task));
+        if (!drainQueued_.exchange(true))
+            loop_->queueInLoop([this]() { drain(); });
+    }
+
+    /**
+     * @brief Run the task in the loop, batched with the other ones handed over
+     * to it if the loop is an IO loop of the application, or queued alone.
+     * The caller must not be in the loop.
+     */
+    static void runInLoop(trantor::EventLoop *loop,
+                          std::function<void()> &&task);
+
+  private:
+    void drain()
+    {
+        // Cleared first, a task put after the last dequeue queues a new drain
+        drainQueued_ = false;
+        std::function<void()> task;
+        while (tasks_.dequeue(task))
+            task();
+    }
+
+    trantor::EventLoop *loop_;
+    trantor::MpscQueue<std::function<void()>> tasks_;
+    std::atomic<bool> drainQueued_{false};
+};
+}  // namespace drogon
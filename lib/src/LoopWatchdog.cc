@@ -0,0 +1,233 @@
+/**
+ *
+ *  @file LoopWatchdog.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "LoopWatchdog.h"
+#include "BuiltinMetrics.h"
+#include "HttpRequestImpl.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#ifdef __linux__
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+int64_t steadyNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+#ifdef __linux__
+// The stack sample taken by the signal handler in the stalled thread, one at
+// a time
+constexpr int kMaxFrames = 48;
+void *sampleFrames[kMaxFrames];
+std::atomic<int> sampleDepth{-1};
+
+// SIGURG is ignored by default, so a late signal does no harm
+constexpr int kSampleSignal = SIGURG;
+
+void onSampleSignal(int)
+{
+    sampleDepth.store(backtrace(sampleFrames, kMaxFrames),
+                      std::memory_order_release);
+}
+
+int64_t threadCpuTime(pthread_t thread)
+{
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(thread, &clock) != 0 ||
+        clock_gettime(clock, &ts) != 0)
+        return -1;
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+#endif
+}  // namespace
+
+void LoopWatchdog::start(const std::vector<trantor::EventLoop *> &loops,
+                         double threshold)
+{
+    if (enabled() || threshold <= 0)
+        return;
+    threshold_ = threshold;
+    // Several beats per threshold so that a stall is seen soon
+    interval_ = (std::min)(threshold / 4, 1.0);
+#ifdef __linux__
+    // backtrace() loads libgcc on its first call, which isn't safe in the
+    // signal handler
+    void *frame;
+    backtrace(&frame, 1);
+    struct sigaction action = {};
+    action.sa_handler = onSampleSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(kSampleSignal, &action, nullptr);
+#endif
+    auto now = steadyNow();
+    for (auto loop : loops)
+    {
+        auto state = std::make_unique<LoopState>();
+        state->loop = loop;
+        state->lastBeat = now;
+        state->lastCheck = now;
+        auto statePtr = state.get();
+        loop->runInLoop([this, statePtr]() {
+#ifdef __linux__
+            statePtr->thread = pthread_self();
+            statePtr->lastCpuTime = threadCpuTime(statePtr->thread);
+#endif
+            statePtr->started.store(true, std::memory_order_release);
+            statePtr->timerId =
+                statePtr->loop->runEvery(interval_, [this, statePtr]() {
+                    auto now = steadyNow();
+                    auto previous = statePtr->lastBeat.exchange(now);
+                    auto lag = static_cast<double>(now - previous) / 1e9 -
+                               interval_;
+                    BuiltinMetrics::instance().loopLag(statePtr->loop,
+                                                       lag > 0 ? lag : 0);
+                });
+        });
+        loops_.push_back(std::move(state));
+    }
+    stopping_ = false;
+    thread_ = std::thread([this]() { watch(); });
+    enabled_.store(true, std::memory_order_release);
+}
+
+void LoopWatchdog::stop()
+{
+    if (!enabled())
+        return;
+    enabled_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+    for (auto &state : loops_)
+        state->loop->invalidateTimer(state->timerId);
+}
+
+size_t LoopWatchdog::markHandler(const HttpRequestImplPtr &req)
+{
+    auto index = req->getLoop()->index();
+    if (index >= loops_.size())
+        return static_cast<size_t>(-1);
+    auto &state = *loops_[index];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.handler.assign(req->methodString()).append(" ").append(req->path());
+    return index;
+}
+
+void LoopWatchdog::clearHandler(size_t index)
+{
+    auto &state = *loops_[index];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.handler.clear();
+}
+
+void LoopWatchdog::watch()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cond_.wait_for(lock,
+                           std::chrono::duration<double>(interval_),
+                           [this]() { return stopping_; }))
+    {
+        auto now = steadyNow();
+        for (size_t i = 0; i < loops_.size(); ++i)
+            check(i, *loops_[i], now);
+    }
+}
+
+void LoopWatchdog::check(size_t index, LoopState &state, int64_t now)
+{
+    if (!state.started.load(std::memory_order_acquire))
+        return;
+#ifdef __linux__
+    auto cpuTime = threadCpuTime(state.thread);
+    if (cpuTime >= 0 && now > state.lastCheck)
+    {
+        BuiltinMetrics::instance().loopUtilization(
+            index,
+            static_cast<double>(cpuTime - state.lastCpuTime) /
+                static_cast<double>(now - state.lastCheck));
+        state.lastCpuTime = cpuTime;
+    }
+#endif
+    state.lastCheck = now;
+
+    auto blocked = static_cast<double>(
+                       now - state.lastBeat.load(std::memory_order_relaxed)) /
+                   1e9;
+    if (blocked <= threshold_)
+    {
+        state.stalled = false;
+        return;
+    }
+    if (state.stalled)
+        return;
+    // Logged once per stall
+    state.stalled = true;
+    BuiltinMetrics::instance().loopStalled(index);
+    std::string handler;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        handler = state.handler;
+    }
+    LOG_WARN << "The IO loop " << index << " is blocked for "
+             << static_cast<int64_t>(blocked * 1000) << "ms, "
+             << (handler.empty() ? std::string("not in a handler")
+                                 : "in the handler of " + handler)
+             << sampleStack(state);
+}
+
+std::string LoopWatchdog::sampleStack(LoopState &state)
+{
+#ifdef __linux__
+    sampleDepth.store(-1, std::memory_order_relaxed);
+    if (pthread_kill(state.thread, kSampleSignal) != 0)
+        return {};
+    // The handler runs as soon as the thread is scheduled
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(100);
+    int depth;
+    while ((depth = sampleDepth.load(std::memory_order_acquire)) < 0)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            return {};
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::string stack = ", stack:";
+    auto symbols = backtrace_symbols(sampleFrames, depth);
+    if (!symbols)
+        return {};
+    // The first frames are the signal handler
+    for (int i = 2; i < depth; ++i)
+        stack.append("\n    ").append(symbols[i]);
+    free(symbols);
+    return stack;
+#else
+    (void)state;
+    return {};
+#endif
+}
@@ -0,0 +1,122 @@
+/**
+ *
+ *  @file LoopWatchdog.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace drogon
+{
+/**
+ * @brief Watches the IO loops for the handlers which block them.
+ *
+ * Every loop runs a heartbeat timer whose delay is the lag of the loop. A
+ * thread checks the heartbeats, and when one is late by more than the
+ * threshold, it logs the handler running on the loop and, on Linux, a stack
+ * sample of the loop thread. The lag, the stalls and the share of the time
+ * the loop threads are on the CPU are exported by the builtin metrics.
+ */
+class LoopWatchdog : public trantor::NonCopyable
+{
+  public:
+    static LoopWatchdog &instance()
+    {
+        static LoopWatchdog inst;
+        return inst;
+    }
+
+    /// Start watching the loops, the threshold is in seconds
+    void start(const std::vector<trantor::EventLoop *> &loops,
+               double threshold);
+    void stop();
+
+    bool enabled() const
+    {
+        return enabled_.load(std::memory_order_acquire);
+    }
+
+    /// Marks the handler of the request running on the current loop for the
+    /// stall logs
+    class HandlerScope
+    {
+      public:
+        explicit HandlerScope(const HttpRequestImplPtr &req)
+        {
+            if (LoopWatchdog::instance().enabled())
+                loop_ = LoopWatchdog::instance().markHandler(req);
+        }
+
+        ~HandlerScope()
+        {
+            if (loop_ != kNoLoop)
+                LoopWatchdog::instance().clearHandler(loop_);
+        }
+
+        HandlerScope(const HandlerScope &) = delete;
+        HandlerScope &operator=(const HandlerScope &) = delete;
+
+      private:
+        static constexpr size_t kNoLoop = static_cast<size_t>(-1);
+        size_t loop_{kNoLoop};
+    };
+
+  private:
+    LoopWatchdog() = default;
+
+    struct LoopState
+    {
+        trantor::EventLoop *loop{nullptr};
+        trantor::TimerId timerId{0};
+        // In nanoseconds of the steady clock
+        std::atomic<int64_t> lastBeat{0};
+        bool stalled{false};
+        // The thread of the loop and its CPU time at the last check
+        std::atomic<bool> started{false};
+#ifdef __linux__
+        pthread_t thread{};
+#endif
+        int64_t lastCpuTime{0};
+        int64_t lastCheck{0};
+        // The handler running on the loop, e.g. "GET /api/users"
+        std::mutex mutex;
+        std::string handler;
+    };
+
+    size_t markHandler(const HttpRequestImplPtr &req);
+    void clearHandler(size_t index);
+    void watch();
+    void check(size_t index, LoopState &state, int64_t now);
+    std::string sampleStack(LoopState &state);
+
+    std::atomic<bool> enabled_{false};
+    double threshold_{0};
+    double interval_{0};
+    std::vector<std::unique_ptr<LoopState>> loops_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stopping_{false};
+};
+}  // namespace drogon
@@ -77,76 +77,6 @@ void doFilters(const std::vector<std::shared_ptr<HttpFilterBase>> &filters,
     doFilterChains(filters, 0, req, std::move(callbackPtr));
 }
 
-/**
- * @brief
- * The middlewares are invoked according to the onion ring model.
- *
- * @param outerCallback The road back to the outer layer of the onion ring.
- * @param innermostHandler The innermost handler at the core of the onion ring.
- *
- * When going through each middleware, the `innermostHandler` is passed down as
- * is, while the `outerCallback` is passed to the user code. User code wraps the
- * outerCallback along with other post processing codes into `userPostCb`, and
- * passes it to the next middleware.
- *
- * When reaching the onion core, the `innermostHandler` is finally called. It's
- * parameter is a function that wraps the original `outerCallback` and all
- * `userPostCb`s.
- */
-static void passMiddlewareChains(
-    const std::vector<std::shared_ptr<HttpMiddlewareBase>> &middlewares,
-    size_t index,
-    const HttpRequestImplPtr &req,
-    std::function<void(const HttpResponsePtr &)> &&outerCallback,
-    std::function<void(std::function<void(const HttpResponsePtr &)> &&)>
-        &&innermostHandler)
-{
-    if (index < middlewares.size())
-    {
-        auto &middleware = middlewares[index];
-        middleware->invoke(
-            req,
-            [index,
-             req,
-             innermostHandler = std::move(innermostHandler),
-             &middlewares](std::function<void(const HttpResponsePtr &)>
-                               &&userPostCb) mutable {
-                // call next middleware
-                auto ioLoop = req->getLoop();
-                if (ioLoop && !ioLoop->isInLoopThread())
-                {
-                    ioLoop->queueInLoop(
-                        [&middlewares,
-                         index,
-                         req,
-                         innermostHandler = std::move(innermostHandler),
-                         userPostCb = std::move(userPostCb)]() mutable {
-                            passMiddlewareChains(middlewares,
-                                                 index + 1,
-                                                 req,
-                                                 std::move(userPostCb),
-                                                 std::move(innermostHandler)
-
-                            );
-                        });
-                }
-                else
-                {
-                    passMiddlewareChains(middlewares,
-                                         index + 1,
-                                         req,
-                                         std::move(userPostCb),
-                                         std::move(innermostHandler));
-                }
-            },
-            std::move(outerCallback));
-    }
-    else
-    {
-        innermostHandler(std::move(outerCallback));
-    }
-}
-
 std::vector<std::shared_ptr<HttpMiddlewareBase>> createMiddlewares(
     const std::vector<std::string> &middlewareNames)
 {
@@ -167,18 +97,48 @@ std::vector<std::shared_ptr<HttpMiddlewareBase>> createMiddlewares(
     return middlewares;
 }
 
-void passMiddlewares(
-    const std::vector<std::shared_ptr<HttpMiddlewareBase>> &middlewares,
-    const HttpRequestImplPtr &req,
-    std::function<void(const HttpResponsePtr &)> &&outermostCallback,
-    std::function<void(std::function<void(const HttpResponsePtr &)> &&)>
-        &&innermostHandler)
+/**
+ * When going through each middleware, the cursor is passed down as is, while
+ * the `outerCallback` is passed to the user code. User code wraps the
+ * outerCallback along with other post processing codes into `userPostCb`, and
+ * passes it to the next middleware.
+ *
+ * When reaching the onion core, the innermost handler of the cursor is finally
+ * called. Its parameter is a function that wraps the original
+ * `outerCallback` and all `userPostCb`s.
+ */
+void MiddlewareChain::step(
+    std::shared_ptr<Cursor> &&cursor,
+    std::function<void(const HttpResponsePtr &)> &&outerCallback) const
 {
-    passMiddlewareChains(middlewares,
-                         0,
-                         req,
-                         std::move(outermostCallback),
-                         std::move(innermostHandler));
+    if (cursor->index >= middlewares_.size())
+    {
+        cursor->core(std::move(outerCallback));
+        return;
+    }
+    auto &middleware = middlewares_[cursor->index++];
+    // The continuation may outlive the call, it owns the cursor
+    HttpRequestPtr req = cursor->req;
+    middleware->invoke(
+        req,
+        [cursor = std::move(cursor)](
+            std::function<void(const HttpResponsePtr &)> &&userPostCb) mutable {
+            // call next middleware
+            auto ioLoop = cursor->req->getLoop();
+            if (ioLoop && !ioLoop->isInLoopThread())
+            {
+                ioLoop->queueInLoop(
+                    [cursor = std::move(cursor),
+                     userPostCb = std::move(userPostCb)]() mutable {
+                        auto chain = cursor->chain;
+                        chain->step(std::move(cursor), std::move(userPostCb));
+                    });
+                return;
+            }
+            auto chain = cursor->chain;
+            chain->step(std::move(cursor), std::move(userPostCb));
+        },
+        std::move(outerCallback));
 }
 
 }  // namespace middlewares_function
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -33,12 +34,96 @@ void doFilters(const std::vector<std::shared_ptr<HttpFilterBase>> &filters,
 std::vector<std::shared_ptr<HttpMiddlewareBase>> createMiddlewares(
     const std::vector<std::string> &middlewareNames);
 
-void passMiddlewares(
-    const std::vector<std::shared_ptr<HttpMiddlewareBase>> &middlewares,
-    const HttpRequestImplPtr &req,
-    std::function<void(const HttpResponsePtr &)> &&outermostCallback,
-    std::function<void(std::function<void(const HttpResponsePtr &)> &&)>
-        &&innermostHandler);
+/**
+ * @brief The middlewares of a route, composed once when the routes are
+ * initialized.
+ *
+ * A request goes through the chain with a single cursor which holds the
+ * request, the position in the chain and the innermost handler, the
+ * continuation handed to each middleware only captures the cursor so it fits
+ * in the small buffer of std::function where the standard library allows it.
+ */
+class MiddlewareChain
+{
+  public:
+    MiddlewareChain() = default;
+
+    explicit MiddlewareChain(const std::vector<std::string> &middlewareNames)
+        : middlewares_(createMiddlewares(middlewareNames))
+    {
+    }
+
+    bool empty() const
+    {
+        return middlewares_.empty();
+    }
+
+    /**
+     * @brief Pass the request through the middlewares in the onion ring
+     * model.
+     *
+     * @param outermostCallback The road back to the client.
+     * @param innermostHandler It's called with the callback wrapping the
+     * outermost one and the post processing of all the middlewares once the
+     * last middleware calls its next callback.
+     */
+    template <typename Handler>
+    void pass(const HttpRequestImplPtr &req,
+              std::function<void(const HttpResponsePtr &)> &&outermostCallback,
+              Handler &&innermostHandler) const
+    {
+        if (middlewares_.empty())
+        {
+            innermostHandler(std::move(outermostCallback));
+            return;
+        }
+        step(std::make_shared<HandlerCursor<std::decay_t<Handler>>>(
+                 this, req, std::forward<Handler>(innermostHandler)),
+             std::move(outermostCallback));
+    }
+
+  private:
+    struct Cursor
+    {
+        Cursor(const MiddlewareChain *chain, const HttpRequestImplPtr &req)
+            : chain(chain), req(req)
+        {
+        }
+
+        virtual ~Cursor() = default;
+        virtual void core(
+            std::function<void(const HttpResponsePtr &)> &&callback) = 0;
+
+        const MiddlewareChain *chain;
+        HttpRequestImplPtr req;
+        size_t index{0};
+    };
+
+    template <typename Handler>
+    struct HandlerCursor : public Cursor
+    {
+        HandlerCursor(const MiddlewareChain *chain,
+                      const HttpRequestImplPtr &req,
+                      Handler &&handler)
+            : Cursor(chain, req), handler(std::move(handler))
+        {
+        }
+
+        void core(
+            std::function<void(const HttpResponsePtr &)> &&callback) override
+        {
+            handler(std::move(callback));
+        }
+
+        Handler handler;
+    };
+
+    void step(std::shared_ptr<Cursor> &&cursor,
+              std::function<void(const HttpResponsePtr &)> &&outerCallback)
+        const;
+
+    std::vector<std::shared_ptr<HttpMiddlewareBase>> middlewares_;
+};
 
 }  // namespace middlewares_function
 }  // namespace drogon
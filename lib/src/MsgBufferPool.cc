@@ -0,0 +1,158 @@
+/**
+ *
+ *  @file MsgBufferPool.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "MsgBufferPool.h"
+#include <drogon/HttpAppFramework.h>
+#include <drogon/IOThreadStorage.h>
+#include <trantor/net/EventLoop.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+using namespace drogon;
+using trantor::MsgBuffer;
+
+namespace
+{
+constexpr std::array<size_t, 5> kSizeClasses{256,
+                                             1024,
+                                             4096,
+                                             16 * 1024,
+                                             64 * 1024};
+static_assert(kSizeClasses.back() == MsgBufferPool::maxPooledBufferSize());
+
+using BufferList = std::vector<std::unique_ptr<MsgBuffer>>;
+using FreeLists = std::array<BufferList, kSizeClasses.size()>;
+
+IOThreadStorage<FreeLists> &freeLists()
+{
+    // Created on first use, after the number of IO threads is known.
+    static IOThreadStorage<FreeLists> lists;
+    return lists;
+}
+
+std::array<std::atomic<size_t>, 3> &sizeHints()
+{
+    static std::array<std::atomic<size_t>, 3> hints{};
+    return hints;
+}
+
+trantor::EventLoop *currentFrameworkLoop()
+{
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (loop && loop->index() <= app().getThreadNum())
+        return loop;
+    return nullptr;
+}
+
+size_t bufferCapacity(const MsgBuffer &buffer)
+{
+    return buffer.readableBytes() + buffer.writableBytes();
+}
+
+size_t wantedSize(MsgBufferPool::Use use, size_t extra)
+{
+    return (std::max)(MsgBufferPool::sizeHint(use) + extra, kSizeClasses[0]);
+}
+
+// The index of the smallest class holding the size, kSizeClasses.size() if
+// none does
+size_t classIndex(size_t size)
+{
+    return static_cast<size_t>(
+        std::lower_bound(kSizeClasses.begin(), kSizeClasses.end(), size) -
+        kSizeClasses.begin());
+}
+
+std::unique_ptr<MsgBuffer> takeFrom(size_t index)
+{
+    auto &list = freeLists().getThreadData()[index];
+    if (list.empty())
+        return std::make_unique<MsgBuffer>(kSizeClasses[index]);
+    auto buffer = std::move(list.back());
+    list.pop_back();
+    return buffer;
+}
+}  // namespace
+
+std::shared_ptr<MsgBuffer> MsgBufferPool::acquire(Use use, size_t extra)
+{
+    auto want = wantedSize(use, extra);
+    auto index = classIndex(want);
+    auto loop = currentFrameworkLoop();
+    if (!loop || index == kSizeClasses.size())
+        return std::make_shared<MsgBuffer>(want);
+    auto *buffer = takeFrom(index).release();
+    return std::shared_ptr<MsgBuffer>(buffer, [loop](MsgBuffer *p) {
+        if (loop->isInLoopThread())
+        {
+            give(std::unique_ptr<MsgBuffer>(p));
+        }
+        else
+        {
+            // Sent by the connection of another loop
+            loop->queueInLoop([p]() { give(std::unique_ptr<MsgBuffer>(p)); });
+        }
+    });
+}
+
+std::unique_ptr<MsgBuffer> MsgBufferPool::take(Use use, size_t extra)
+{
+    auto want = wantedSize(use, extra);
+    auto index = classIndex(want);
+    if (!currentFrameworkLoop() || index == kSizeClasses.size())
+        return std::make_unique<MsgBuffer>(want);
+    return takeFrom(index);
+}
+
+void MsgBufferPool::give(std::unique_ptr<MsgBuffer> buffer)
+{
+    if (!buffer || !currentFrameworkLoop())
+        return;
+    buffer->retrieveAll();
+    // Kept in the largest class it can hold
+    auto capacity = bufferCapacity(*buffer);
+    if (capacity < kSizeClasses[0] || capacity > maxPooledBufferSize())
+        return;
+    auto index = classIndex(capacity);
+    if (kSizeClasses[index] > capacity)
+        --index;
+    auto &list = freeLists().getThreadData()[index];
+    if (list.size() < maxIdleBuffersPerClass())
+        list.push_back(std::move(buffer));
+}
+
+void MsgBufferPool::record(Use use, size_t bytes)
+{
+    // Follow a larger size at once and a smaller one slowly
+    auto &hint = sizeHints()[static_cast<size_t>(use)];
+    auto current = hint.load(std::memory_order_relaxed);
+    if (bytes >= current)
+        hint.store(bytes, std::memory_order_relaxed);
+    else
+        hint.store(current - (current - bytes) / 16,
+                   std::memory_order_relaxed);
+}
+
+size_t MsgBufferPool::sizeHint(Use use)
+{
+    return sizeHints()[static_cast<size_t>(use)].load(
+        std::memory_order_relaxed);
+}
+
+size_t MsgBufferPool::sizeClass(size_t size)
+{
+    auto index = classIndex(size);
+    return index == kSizeClasses.size() ? 0 : kSizeClasses[index];
+}
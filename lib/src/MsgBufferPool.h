@@ -0,0 +1,93 @@
+/**
+ *
+ *  @file MsgBufferPool.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/MsgBuffer.h>
+#include <cstddef>
+#include <memory>
+
+namespace drogon
+{
+/**
+ * @brief Per IO loop free-lists of output buffers, by size class.
+ *
+ * The rendered responses, the staging buffers of pipelined responses and the
+ * WebSocket frames are taken from the loop rendering them and given back to it
+ * once sent, so their memory is reused instead of being allocated and grown
+ * for each message. A buffer has room for the bytes recently needed by its
+ * use and the extra bytes known by the caller (a body to append), rounded up
+ * to a size class.
+ *
+ * Outside the IO loops of the framework, and above maxPooledBufferSize(),
+ * the buffers are plain allocations.
+ */
+class MsgBufferPool
+{
+  public:
+    enum class Use
+    {
+        kHeader = 0,
+        kStaging,
+        kFrame,
+    };
+
+    /**
+     * @brief Get an empty buffer for the current thread, shared with the
+     * connection that sends it.
+     *
+     * The buffer can be released in any thread, it is then given back to its
+     * loop with queueInLoop().
+     */
+    static std::shared_ptr<trantor::MsgBuffer> acquire(Use use,
+                                                       size_t extra = 0);
+
+    /**
+     * @brief Same as acquire(), for a buffer owned by the caller.
+     */
+    static std::unique_ptr<trantor::MsgBuffer> take(Use use, size_t extra = 0);
+
+    /**
+     * @brief Give back a buffer got by take(), in the thread that took it.
+     */
+    static void give(std::unique_ptr<trantor::MsgBuffer> buffer);
+
+    /**
+     * @brief Learn the number of bytes a use needed.
+     */
+    static void record(Use use, size_t bytes);
+
+    /**
+     * @brief The size recently needed by a use, 0 if none yet.
+     */
+    static size_t sizeHint(Use use);
+
+    /**
+     * @brief The size class of a buffer of the size, 0 if it is not pooled.
+     */
+    static size_t sizeClass(size_t size);
+
+    static constexpr size_t maxPooledBufferSize()
+    {
+        return 64 * 1024;
+    }
+
+    /**
+     * @brief The number of idle buffers kept by each loop for each size class.
+     */
+    static constexpr size_t maxIdleBuffersPerClass()
+    {
+        return 256;
+    }
+};
+}  // namespace drogon
@@ -0,0 +1,423 @@
+/**
+ *
+ *  @file MsgPack.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/MsgPack.h>
+#include <cstdint>
+#include <cstring>
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t kMaxDepth = 1000;
+
+void putBigEndian(std::string &out, uint64_t value, size_t bytes)
+{
+    for (size_t i = bytes; i > 0; --i)
+        out.push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xff));
+}
+
+void putUnsigned(std::string &out, uint64_t value)
+{
+    if (value < 0x80)
+    {
+        out.push_back(static_cast<char>(value));
+    }
+    else if (value <= 0xff)
+    {
+        out.push_back('\xcc');
+        putBigEndian(out, value, 1);
+    }
+    else if (value <= 0xffff)
+    {
+        out.push_back('\xcd');
+        putBigEndian(out, value, 2);
+    }
+    else if (value <= 0xffffffffu)
+    {
+        out.push_back('\xce');
+        putBigEndian(out, value, 4);
+    }
+    else
+    {
+        out.push_back('\xcf');
+        putBigEndian(out, value, 8);
+    }
+}
+
+void putSigned(std::string &out, int64_t value)
+{
+    if (value >= 0)
+    {
+        putUnsigned(out, static_cast<uint64_t>(value));
+    }
+    else if (value >= -32)
+    {
+        out.push_back(static_cast<char>(value));
+    }
+    else if (value >= INT8_MIN)
+    {
+        out.push_back('\xd0');
+        putBigEndian(out, static_cast<uint64_t>(value), 1);
+    }
+    else if (value >= INT16_MIN)
+    {
+        out.push_back('\xd1');
+        putBigEndian(out, static_cast<uint64_t>(value), 2);
+    }
+    else if (value >= INT32_MIN)
+    {
+        out.push_back('\xd2');
+        putBigEndian(out, static_cast<uint64_t>(value), 4);
+    }
+    else
+    {
+        out.push_back('\xd3');
+        putBigEndian(out, static_cast<uint64_t>(value), 8);
+    }
+}
+
+// The header of a str, an array or a map of a length
+void putHeader(std::string &out,
+               size_t length,
+               unsigned char fixType,
+               size_t fixMax,
+               unsigned char type8,
+               unsigned char type16)
+{
+    if (length <= fixMax)
+    {
+        out.push_back(static_cast<char>(fixType | length));
+    }
+    else if (type8 != 0 && length <= 0xff)
+    {
+        out.push_back(static_cast<char>(type8));
+        putBigEndian(out, length, 1);
+    }
+    else if (length <= 0xffff)
+    {
+        out.push_back(static_cast<char>(type16));
+        putBigEndian(out, length, 2);
+    }
+    else
+    {
+        out.push_back(static_cast<char>(type16 + 1));
+        putBigEndian(out, length, 4);
+    }
+}
+
+void putString(std::string &out, const char *begin, const char *end)
+{
+    auto length = static_cast<size_t>(end - begin);
+    putHeader(out, length, 0xa0, 31, 0xd9, 0xda);
+    out.append(begin, length);
+}
+
+class Decoder
+{
+  public:
+    explicit Decoder(std::string_view data) : data_(data)
+    {
+    }
+
+    bool decode(Json::Value &value, size_t depth)
+    {
+        if (depth > kMaxDepth)
+            return fail("the document is nested too deeply");
+        unsigned char type;
+        if (!readByte(type))
+            return false;
+        if (type < 0x80)
+        {
+            value = Json::Value(static_cast<Json::Int64>(type));
+            return true;
+        }
+        if (type >= 0xe0)
+        {
+            value = Json::Value(static_cast<Json::Int64>(
+                static_cast<int8_t>(static_cast<uint8_t>(type))));
+            return true;
+        }
+        if ((type & 0xe0) == 0xa0)
+            return decodeString(value, type & 0x1f);
+        if ((type & 0xf0) == 0x90)
+            return decodeArray(value, type & 0x0f, depth);
+        if ((type & 0xf0) == 0x80)
+            return decodeMap(value, type & 0x0f, depth);
+        uint64_t number;
+        switch (type)
+        {
+            case 0xc0:
+                value = Json::Value();
+                return true;
+            case 0xc2:
+                value = Json::Value(false);
+                return true;
+            case 0xc3:
+                value = Json::Value(true);
+                return true;
+            case 0xc4:
+            case 0xd9:
+                return readBigEndian(1, number) &&
+                       decodeString(value, number);
+            case 0xc5:
+            case 0xda:
+                return readBigEndian(2, number) &&
+                       decodeString(value, number);
+            case 0xc6:
+            case 0xdb:
+                return readBigEndian(4, number) &&
+                       decodeString(value, number);
+            case 0xca:
+            {
+                if (!readBigEndian(4, number))
+                    return false;
+                auto bits = static_cast<uint32_t>(number);
+                float real;
+                memcpy(&real, &bits, sizeof(real));
+                value = Json::Value(static_cast<double>(real));
+                return true;
+            }
+            case 0xcb:
+            {
+                if (!readBigEndian(8, number))
+                    return false;
+                double real;
+                memcpy(&real, &number, sizeof(real));
+                value = Json::Value(real);
+                return true;
+            }
+            case 0xcc:
+            case 0xcd:
+            case 0xce:
+            case 0xcf:
+                if (!readBigEndian(size_t{1} << (type - 0xcc), number))
+                    return false;
+                // Signed when it fits, like the numbers parsed from JSON
+                if (number <= static_cast<uint64_t>(INT64_MAX))
+                    value = Json::Value(static_cast<Json::Int64>(number));
+                else
+                    value = Json::Value(static_cast<Json::UInt64>(number));
+                return true;
+            case 0xd0:
+                if (!readBigEndian(1, number))
+                    return false;
+                value = Json::Value(static_cast<Json::Int64>(
+                    static_cast<int8_t>(static_cast<uint8_t>(number))));
+                return true;
+            case 0xd1:
+                if (!readBigEndian(2, number))
+                    return false;
+                value = Json::Value(static_cast<Json::Int64>(
+                    static_cast<int16_t>(static_cast<uint16_t>(number))));
+                return true;
+            case 0xd2:
+                if (!readBigEndian(4, number))
+                    return false;
+                value = Json::Value(static_cast<Json::Int64>(
+                    static_cast<int32_t>(static_cast<uint32_t>(number))));
+                return true;
+            case 0xd3:
+                if (!readBigEndian(8, number))
+                    return false;
+                value = Json::Value(static_cast<Json::Int64>(number));
+                return true;
+            case 0xdc:
+                return readBigEndian(2, number) &&
+                       decodeArray(value, number, depth);
+            case 0xdd:
+                return readBigEndian(4, number) &&
+                       decodeArray(value, number, depth);
+            case 0xde:
+                return readBigEndian(2, number) &&
+                       decodeMap(value, number, depth);
+            case 0xdf:
+                return readBigEndian(4, number) &&
+                       decodeMap(value, number, depth);
+            default:
+                return fail("unsupported type " + std::to_string(type));
+        }
+    }
+
+    bool atEnd() const
+    {
+        return offset_ == data_.length();
+    }
+
+    bool fail(std::string errs)
+    {
+        errs_ = std::move(errs) + " at offset " + std::to_string(offset_);
+        return false;
+    }
+
+    const std::string &errs() const
+    {
+        return errs_;
+    }
+
+  private:
+    bool readByte(unsigned char &byte)
+    {
+        if (offset_ >= data_.length())
+            return fail("unexpected end of the document");
+        byte = static_cast<unsigned char>(data_[offset_++]);
+        return true;
+    }
+
+    bool readBigEndian(size_t bytes, uint64_t &value)
+    {
+        if (data_.length() - offset_ < bytes)
+            return fail("unexpected end of the document");
+        value = 0;
+        for (size_t i = 0; i < bytes; ++i)
+            value = (value << 8) |
+                    static_cast<unsigned char>(data_[offset_ + i]);
+        offset_ += bytes;
+        return true;
+    }
+
+    // Every item takes one byte at least
+    bool checkItems(uint64_t items)
+    {
+        if (items > data_.length() - offset_)
+            return fail("unexpected end of the document");
+        return true;
+    }
+
+    bool decodeString(Json::Value &value, uint64_t length)
+    {
+        if (!checkItems(length))
+            return false;
+        auto begin = data_.data() + offset_;
+        value = Json::Value(begin, begin + length);
+        offset_ += static_cast<size_t>(length);
+        return true;
+    }
+
+    bool decodeArray(Json::Value &value, uint64_t items, size_t depth)
+    {
+        if (!checkItems(items))
+            return false;
+        value = Json::Value(Json::arrayValue);
+        if (items == 0)
+            return true;
+        value.resize(static_cast<Json::ArrayIndex>(items));
+        for (Json::ArrayIndex i = 0; i < items; ++i)
+        {
+            if (!decode(value[i], depth + 1))
+                return false;
+        }
+        return true;
+    }
+
+    bool decodeMap(Json::Value &value, uint64_t items, size_t depth)
+    {
+        // Every pair takes two bytes at least
+        if (!checkItems(items * 2))
+            return false;
+        value = Json::Value(Json::objectValue);
+        Json::Value key;
+        for (uint64_t i = 0; i < items; ++i)
+        {
+            if (!decode(key, depth + 1))
+                return false;
+            std::string name;
+            if (key.isString())
+                name = key.asString();
+            else if (key.isInt64())
+                name = std::to_string(key.asInt64());
+            else if (key.isUInt64())
+                name = std::to_string(key.asUInt64());
+            else
+                return fail("a key of a map is not a string");
+            if (!decode(value[name], depth + 1))
+                return false;
+        }
+        return true;
+    }
+
+    std::string_view data_;
+    size_t offset_{0};
+    std::string errs_;
+};
+}  // namespace
+
+void utils::toMsgPack(const Json::Value &value, std::string &out)
+{
+    switch (value.type())
+    {
+        case Json::nullValue:
+            out.push_back('\xc0');
+            break;
+        case Json::booleanValue:
+            out.push_back(value.asBool() ? '\xc3' : '\xc2');
+            break;
+        case Json::intValue:
+            putSigned(out, value.asInt64());
+            break;
+        case Json::uintValue:
+            putUnsigned(out, value.asUInt64());
+            break;
+        case Json::realValue:
+        {
+            auto real = value.asDouble();
+            uint64_t bits;
+            memcpy(&bits, &real, sizeof(bits));
+            out.push_back('\xcb');
+            putBigEndian(out, bits, 8);
+            break;
+        }
+        case Json::stringValue:
+        {
+            const char *begin = nullptr;
+            const char *end = nullptr;
+            value.getString(&begin, &end);
+            putString(out, begin, end);
+            break;
+        }
+        case Json::arrayValue:
+            putHeader(out, value.size(), 0x90, 15, 0, 0xdc);
+            for (const auto &item : value)
+                toMsgPack(item, out);
+            break;
+        case Json::objectValue:
+            putHeader(out, value.size(), 0x80, 15, 0, 0xde);
+            for (auto iter = value.begin(); iter != value.end(); ++iter)
+            {
+                const char *end = nullptr;
+                const char *begin = iter.memberName(&end);
+                putString(out, begin, end);
+                toMsgPack(*iter, out);
+            }
+            break;
+    }
+}
+
+bool utils::fromMsgPack(std::string_view data,
+                        Json::Value &root,
+                        std::string &errs)
+{
+    Decoder decoder(data);
+    if (!decoder.decode(root, 0))
+    {
+        errs = decoder.errs();
+        return false;
+    }
+    if (!decoder.atEnd())
+    {
+        decoder.fail("trailing bytes");
+        errs = decoder.errs();
+        return false;
+    }
+    return true;
+}
@@ -12,6 +12,7 @@
  *
  */
 
+#include "BoundaryMatcher.h"
 #include "HttpRequestImpl.h"
 #include "HttpUtils.h"
 #include "HttpAppFrameworkImpl.h"
@@ -228,10 +229,11 @@ int MultiPartParser::parse(const HttpRequestPtr &req,
     std::string_view boundary{boundaryData, boundaryLen};
     if (boundary.size() > 2 && boundary[0] == '\"')
         boundary = boundary.substr(1, boundary.size() - 2);
+    BoundaryMatcher matcher(boundary);
     std::string_view::size_type pos1, pos2;
     pos1 = 0;
     auto content = static_cast<HttpRequestImpl *>(req.get())->bodyView();
-    pos2 = content.find(boundary);
+    pos2 = matcher.find(content);
     while (true)
     {
         pos1 = pos2;
@@ -240,7 +242,7 @@ int MultiPartParser::parse(const HttpRequestPtr &req,
         pos1 += boundary.length();
         if (content[pos1] == '\r' && content[pos1 + 1] == '\n')
             pos1 += 2;
-        pos2 = content.find(boundary, pos1);
+        pos2 = matcher.find(content, pos1);
         if (pos2 == std::string_view::npos)
             break;
         bool flag = false;
@@ -14,6 +14,7 @@
 
 #include "MultipartStreamParser.h"
 #include <cassert>
+#include <cstring>
 
 using namespace drogon;
 
@@ -84,6 +85,8 @@ MultipartStreamParser::MultipartStreamParser(const std::string &contentType)
     boundary_ = contentType.substr(pos, pos2 - pos);
     dashBoundaryCrlf_ = dash_ + boundary_ + crlf_;
     crlfDashBoundary_ = crlf_ + dash_ + boundary_;
+    dashBoundaryCrlfMatcher_ = BoundaryMatcher(dashBoundaryCrlf_);
+    crlfDashBoundaryMatcher_ = BoundaryMatcher(crlfDashBoundary_);
 }
 
 // TODO: same function in HttpRequestParser.cc
@@ -126,17 +129,13 @@ void drogon::MultipartStreamParser::parse(
         {
             case Status::kExpectFirstBoundary:
             {
-                if (buffer_.size() < dashBoundaryCrlf_.size())
-                {
-                    return;
-                }
                 std::string_view v = buffer_.view();
-                auto pos = v.find(dashBoundaryCrlf_);
+                auto pos = dashBoundaryCrlfMatcher_.find(v);
                 // ignore everything before the first boundary
                 if (pos == std::string::npos)
                 {
-                    buffer_.eraseFront(buffer_.size() -
-                                       dashBoundaryCrlf_.size());
+                    buffer_.eraseFront(
+                        dashBoundaryCrlfMatcher_.partialMatch(v));
                     return;
                 }
                 // found
@@ -155,7 +154,8 @@ void drogon::MultipartStreamParser::parse(
             case Status::kExpectHeader:
             {
                 std::string_view v = buffer_.view();
-                auto pos = v.find(crlf_);
+                // Resume the search where the previous chunk ended
+                auto pos = v.find(crlf_, headerScanned_);
                 if (pos == std::string::npos)
                 {
                     // same magic number in HttpRequestParser::parseRequest()
@@ -163,8 +163,10 @@ void drogon::MultipartStreamParser::parse(
                     {
                         isValid_ = false;
                     }
+                    headerScanned_ = v.size() - 1;
                     return;  // header incomplete, wait for more data
                 }
+                headerScanned_ = 0;
                 // empty line
                 if (pos == 0)
                 {
@@ -246,16 +248,13 @@ void drogon::MultipartStreamParser::parse(
             }
             case Status::kExpectBody:
             {
-                if (buffer_.size() < crlfDashBoundary_.size())
-                {
-                    return;  // not enough data to check boundary
-                }
                 std::string_view v = buffer_.view();
-                auto pos = v.find(crlfDashBoundary_);
+                auto pos = crlfDashBoundaryMatcher_.find(v);
                 if (pos == std::string::npos)
                 {
-                    // boundary not found, leave potential partial boundary
-                    size_t len = v.size() - crlfDashBoundary_.size();
+                    // boundary not found, only leave the bytes which may
+                    // begin a boundary completed by the next chunk
+                    size_t len = crlfDashBoundaryMatcher_.partialMatch(v);
                     if (len > 0)
                     {
                         dataCb(v.data(), len);
@@ -317,10 +316,7 @@ void MultipartStreamParser::Buffer::append(const char *data, size_t length)
     // Move existing data to the front
     if (remainSize > 0 && bufHead_ > 0)
     {
-        for (size_t i = 0; i < remainSize; i++)
-        {
-            buffer_[i] = buffer_[bufHead_ + i];
-        }
+        memmove(&buffer_[0], &buffer_[bufHead_], remainSize);
     }
     bufHead_ = 0;
     bufTail_ = remainSize;
@@ -330,9 +326,9 @@ void MultipartStreamParser::Buffer::append(const char *data, size_t length)
         buffer_.resize(remainSize + length);
     }
 
-    for (size_t i = 0; i < length; ++i)
+    if (length > 0)
     {
-        buffer_[bufTail_ + i] = data[i];
+        memcpy(&buffer_[bufTail_], data, length);
     }
     bufTail_ += length;
 }
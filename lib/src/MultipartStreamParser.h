@@ -15,6 +15,7 @@
 #pragma once
 #include <drogon/exports.h>
 #include <drogon/RequestStream.h>
+#include "BoundaryMatcher.h"
 #include <string>
 
 namespace drogon
@@ -45,6 +46,10 @@ class DROGON_EXPORT MultipartStreamParser
     std::string boundary_;
     std::string dashBoundaryCrlf_;
     std::string crlfDashBoundary_;
+    BoundaryMatcher dashBoundaryCrlfMatcher_;
+    BoundaryMatcher crlfDashBoundaryMatcher_;
+    // The bytes of the buffer already searched for the end of a header line
+    size_t headerScanned_{0};
 
     struct Buffer
     {
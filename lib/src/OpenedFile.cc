@@ -0,0 +1,115 @@
+/**
+ *
+ *  @file OpenedFile.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "OpenedFile.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#elif !defined(__MINGW32__)
+#define stat _wstati64
+#define S_ISREG(m) (((m) & 0170000) == (0100000))
+#endif
+
+using namespace drogon;
+
+OpenedFilePtr OpenedFile::open(const std::string &path)
+{
+    std::shared_ptr<OpenedFile> file(new OpenedFile(path));
+#ifndef _WIN32
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    // Closed by the destructor
+    file->fd_ = fd;
+#elif !defined(__MINGW32__)
+    struct _stati64 fileStat;
+    if (stat(utils::toNativePath(path).c_str(), &fileStat) != 0 ||
+        !S_ISREG(fileStat.st_mode))
+        return nullptr;
+#else
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+        return nullptr;
+#endif
+    file->size_ = static_cast<size_t>(fileStat.st_size);
+    file->modifiedTime_ = fileStat.st_mtime;
+
+    struct tm modifiedTime;
+#ifdef _WIN32
+    gmtime_s(&modifiedTime, &fileStat.st_mtime);
+#else
+    gmtime_r(&fileStat.st_mtime, &modifiedTime);
+#endif
+    char buf[64];
+    auto len = strftime(buf,
+                        sizeof(buf),
+                        "%a, %d %b %Y %H:%M:%S GMT",
+                        &modifiedTime);
+    file->lastModified_.assign(buf, len);
+    // Any change of the file changes its size or its modified time
+    len = snprintf(buf,
+                   sizeof(buf),
+                   "\"%llx-%llx\"",
+                   static_cast<unsigned long long>(fileStat.st_mtime),
+                   static_cast<unsigned long long>(file->size_));
+    file->etag_.assign(buf, len);
+
+    return file;
+}
+
+size_t OpenedFile::read(size_t offset, char *buffer, size_t length) const
+{
+#ifndef _WIN32
+    size_t done = 0;
+    while (done < length)
+    {
+        auto n = ::pread(fd_,
+                         buffer + done,
+                         length - done,
+                         static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            if (n < 0)
+                LOG_SYSERR << "pread " << path_;
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return done;
+#else
+    (void)offset;
+    (void)buffer;
+    (void)length;
+    return 0;
+#endif
+}
+
+OpenedFile::~OpenedFile()
+{
+#ifndef _WIN32
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+}
@@ -0,0 +1,104 @@
+/**
+ *
+ *  @file OpenedFile.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <ctime>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief The metadata of a regular file and, where pread() is available, a
+ * descriptor of it kept open.
+ *
+ * The metadata is read once when the file is opened, so a cached instance
+ * answers the size, Last-Modified and ETag of a file without calling stat()
+ * and its slices are read without opening the file again.
+ *
+ * The slices are read from the descriptor, so they come from the file that
+ * was opened even if another one was renamed over the path meanwhile. A file
+ * truncated in place only makes read() return fewer bytes, unlike a mapping
+ * which raises SIGBUS on the lost pages.
+ */
+class OpenedFile : public trantor::NonCopyable
+{
+  public:
+    /**
+     * @brief Open the regular file at the path.
+     *
+     * @return nullptr if the file does not exist or is not a regular file.
+     */
+    static std::shared_ptr<const OpenedFile> open(const std::string &path);
+
+    ~OpenedFile();
+
+    const std::string &path() const
+    {
+        return path_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    time_t modifiedTime() const
+    {
+        return modifiedTime_;
+    }
+
+    /// The modified time formatted for the Last-Modified header.
+    const std::string &lastModified() const
+    {
+        return lastModified_;
+    }
+
+    /// The strong ETag of the file, quoted.
+    const std::string &etag() const
+    {
+        return etag_;
+    }
+
+    /// Return true if the contents can be read with read().
+    bool isOpen() const
+    {
+        return fd_ >= 0;
+    }
+
+    /**
+     * @brief Read up to length bytes at the offset into the buffer, from any
+     * thread.
+     *
+     * @return The number of bytes read, fewer than length only if the file
+     * was truncated since it was opened or on an error.
+     */
+    size_t read(size_t offset, char *buffer, size_t length) const;
+
+  private:
+    explicit OpenedFile(const std::string &path) : path_(path)
+    {
+    }
+
+    std::string path_;
+    int fd_{-1};
+    size_t size_{0};
+    time_t modifiedTime_{0};
+    std::string lastModified_;
+    std::string etag_;
+};
+
+using OpenedFilePtr = std::shared_ptr<const OpenedFile>;
+}  // namespace drogon
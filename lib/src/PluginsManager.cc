@@ -14,9 +14,19 @@
 
 #include "PluginsManager.h"
 #include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
 
 using namespace drogon;
 
+namespace
+{
+// When the plugin initializing in this thread started, its dependencies are
+// initialized before it
+thread_local std::chrono::steady_clock::time_point initStart;
+}  // namespace
+
 PluginsManager::~PluginsManager()
 {
     // Shut down all plugins in reverse order of initialization.
@@ -34,6 +44,7 @@ void PluginsManager::initializeAllPlugins(
 {
     assert(configs.isArray());
     std::vector<PluginBase *> plugins;
+    std::set<PluginBase *> parallelPlugins;
     for (auto &config : configs)
     {
         auto name = config.get("name", "").asString();
@@ -75,18 +86,97 @@ void PluginsManager::initializeAllPlugins(
         }
         pluginPtr->setInitializedCallback([this](PluginBase *p) {
             LOG_TRACE << "Plugin " << p->className() << " initialized!";
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(mutex_);
             initializedPlugins_.push_back(p);
+            initTimes_.emplace_back(
+                p->className(),
+                std::chrono::duration<double>(now - initStart).count());
+            initStart = now;
         });
+        if (config.get("init_in_parallel", false).asBool())
+            parallelPlugins.insert(pluginPtr);
         plugins.push_back(pluginPtr);
     }
+    if (!parallelPlugins.empty())
+    {
+        initializeInParallel(plugins, parallelPlugins, forEachCallback);
+        return;
+    }
     // Initialize them, Depth first
     for (auto plugin : plugins)
     {
+        initStart = std::chrono::steady_clock::now();
         plugin->initialize();
         forEachCallback(plugin);
     }
 }
 
+void PluginsManager::initializeInParallel(
+    const std::vector<PluginBase *> &plugins,
+    const std::set<PluginBase *> &parallelPlugins,
+    const std::function<void(PluginBase *)> &forEachCallback)
+{
+    // The plugins of a level only depend on the plugins of the lower levels,
+    // which are all initialized before it starts.
+    std::map<PluginBase *, size_t> levels;
+    std::vector<std::vector<PluginBase *>> pluginsByLevel;
+    for (auto plugin : plugins)
+    {
+        auto level = pluginLevel(plugin, levels, 0);
+        if (pluginsByLevel.size() <= level)
+            pluginsByLevel.resize(level + 1);
+        pluginsByLevel[level].push_back(plugin);
+    }
+    for (auto &level : pluginsByLevel)
+    {
+        std::vector<std::future<void>> futures;
+        for (auto plugin : level)
+        {
+            if (parallelPlugins.count(plugin) == 0)
+                continue;
+            futures.push_back(std::async(std::launch::async, [plugin]() {
+                initStart = std::chrono::steady_clock::now();
+                plugin->initialize();
+            }));
+        }
+        // The other plugins are initialized in this thread meanwhile
+        for (auto plugin : level)
+        {
+            if (parallelPlugins.count(plugin) != 0)
+                continue;
+            initStart = std::chrono::steady_clock::now();
+            plugin->initialize();
+        }
+        for (auto &future : futures)
+            future.get();
+        for (auto plugin : level)
+            forEachCallback(plugin);
+    }
+}
+
+size_t PluginsManager::pluginLevel(PluginBase *plugin,
+                                   std::map<PluginBase *, size_t> &levels,
+                                   size_t depth)
+{
+    auto iter = levels.find(plugin);
+    if (iter != levels.end())
+        return iter->second;
+    if (depth > pluginsMap_.size())
+    {
+        LOG_FATAL << "There are a circular dependency within plugins.";
+        abort();
+    }
+    size_t level = 0;
+    for (auto dependency : plugin->dependencies_)
+    {
+        level = (std::max)(level,
+                           pluginLevel(dependency, levels, depth + 1) + 1);
+    }
+    levels[plugin] = level;
+    return level;
+}
+
 void PluginsManager::createPlugin(const std::string &pluginName)
 {
     auto pluginPtr = std::dynamic_pointer_cast<PluginBase>(
@@ -15,6 +15,11 @@
 #pragma once
 #include <drogon/plugins/Plugin.h>
 #include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace drogon
 {
@@ -31,12 +36,29 @@ class PluginsManager : trantor::NonCopyable
 
     std::shared_ptr<PluginBase> getSharedPlugin(const std::string &pluginName);
 
+    /// The class name and the initialization time in seconds of every plugin,
+    /// in the order of initialization
+    const std::vector<std::pair<std::string, double>> &initTimes() const
+    {
+        return initTimes_;
+    }
+
     ~PluginsManager();
 
   private:
     void createPlugin(const std::string &pluginName);
+    void initializeInParallel(
+        const std::vector<PluginBase *> &plugins,
+        const std::set<PluginBase *> &parallelPlugins,
+        const std::function<void(PluginBase *)> &forEachCallback);
+    size_t pluginLevel(PluginBase *plugin,
+                       std::map<PluginBase *, size_t> &levels,
+                       size_t depth);
     std::map<std::string, PluginBasePtr> pluginsMap_;
+    // Guards the two vectors below while plugins initialize in parallel
+    std::mutex mutex_;
     std::vector<PluginBase *> initializedPlugins_;
+    std::vector<std::pair<std::string, double>> initTimes_;
 };
 
 }  // namespace drogon
@@ -0,0 +1,128 @@
+/**
+ *
+ *  @file Profiler.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/Profiler.h>
+#include <drogon/HttpAppFramework.h>
+#include "AdminAuth.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+static HttpResponsePtr newTextResponse(HttpStatusCode code,
+                                       const std::string &text)
+{
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setStatusCode(code);
+    resp->setContentTypeCode(CT_TEXT_PLAIN);
+    resp->setBody(text);
+    return resp;
+}
+
+void Profiler::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    token_ = config.get("token", token_).asString();
+    defaultSeconds_ =
+        config.get("default_seconds", defaultSeconds_).asDouble();
+    maxSeconds_ = config.get("max_seconds", maxSeconds_).asDouble();
+    frequency_ = config.get("frequency", frequency_).asInt();
+    maxSamples_ = static_cast<size_t>(
+        config.get("max_samples", static_cast<Json::UInt64>(maxSamples_))
+            .asUInt64());
+
+    std::weak_ptr<Profiler> weakPtr = shared_from_this();
+    app().registerHandler(
+        path_,
+        [weakPtr](const HttpRequestPtr &req,
+                  std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                callback(HttpResponse::newNotFoundResponse(req));
+                return;
+            }
+            if (!isAdminRequest(req, thisPtr->token_))
+            {
+                auto resp = HttpResponse::newHttpResponse();
+                resp->setStatusCode(k401Unauthorized);
+                if (!thisPtr->token_.empty())
+                    resp->addHeader("www-authenticate", "Bearer");
+                callback(resp);
+                return;
+            }
+            auto seconds = thisPtr->defaultSeconds_;
+            auto &param = req->getParameter("seconds");
+            if (!param.empty())
+            {
+                char *end;
+                seconds = strtod(param.c_str(), &end);
+                if (*end != '\0' || !(seconds > 0))
+                {
+                    callback(newTextResponse(k400BadRequest,
+                                             "Invalid seconds parameter"));
+                    return;
+                }
+            }
+            seconds = (std::min)(seconds, thisPtr->maxSeconds_);
+
+            auto &profiler = CpuProfiler::instance();
+            if (profiler.active())
+            {
+                callback(newTextResponse(k409Conflict,
+                                         "A profile is being taken"));
+                return;
+            }
+            // The samples of the loop threads are labelled with their index
+            for (size_t i = 0; i < app().getThreadNum(); ++i)
+            {
+                app().getIOLoop(i)->runInLoop([i]() {
+                    CpuProfiler::setLoop(static_cast<int32_t>(i));
+                });
+            }
+            if (!profiler.start(thisPtr->frequency_, thisPtr->maxSamples_))
+            {
+                callback(newTextResponse(
+                    profiler.active() ? k409Conflict : k501NotImplemented,
+                    profiler.active() ? "A profile is being taken"
+                                      : "The profiler is not available"));
+                return;
+            }
+            LOG_INFO << "Taking a CPU profile for " << seconds << "s";
+            app().getLoop()->runAfter(seconds, [callback]() {
+                // Symbolized out of the loop, it takes a while
+                app().offload([]() { return CpuProfiler::instance().stop(); },
+                              [callback](std::string profile) {
+                                  auto resp = HttpResponse::newHttpResponse();
+                                  resp->setContentTypeCode(
+                                      CT_APPLICATION_OCTET_STREAM);
+                                  resp->addHeader(
+                                      "content-disposition",
+                                      "attachment; filename=\"profile.pb.gz\"");
+                                  resp->setBody(std::move(profile));
+                                  callback(resp);
+                              });
+            });
+        },
+        {Get},
+        "Profiler");
+}
+
+void Profiler::shutdown()
+{
+    auto &profiler = CpuProfiler::instance();
+    if (profiler.active())
+        profiler.stop();
+}
@@ -3,15 +3,137 @@
 #include <drogon/utils/monitoring/Counter.h>
 #include <drogon/utils/monitoring/Gauge.h>
 #include <drogon/utils/monitoring/Histogram.h>
+#include <drogon/utils/monitoring/Summary.h>
 #include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/Utilities.h>
+#include "BuiltinMetrics.h"
+#include "WorkerProcesses.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 
 using namespace drogon;
 using namespace drogon::monitoring;
 using namespace drogon::plugin;
 
+namespace
+{
+void appendNumber(std::string &out, double value)
+{
+    if (std::isnan(value))
+    {
+        out.append("NaN");
+        return;
+    }
+    if (std::isinf(value))
+    {
+        out.append(value > 0 ? "+Inf" : "-Inf");
+        return;
+    }
+    char buf[32];
+    // The counters and the most of the gauges are integers
+    if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0)
+    {
+        auto result =
+            std::to_chars(buf, buf + sizeof(buf), static_cast<int64_t>(value));
+        out.append(buf, result.ptr - buf);
+        return;
+    }
+    // The shortest of the exact representations
+    auto len = snprintf(buf, sizeof(buf), "%.15g", value);
+    if (strtod(buf, nullptr) != value)
+        len = snprintf(buf, sizeof(buf), "%.17g", value);
+    out.append(buf, len);
+}
+
+void appendHelp(std::string &out, const std::string &help)
+{
+    for (auto c : help)
+    {
+        if (c == '\n')
+            out.append("\\n");
+        else if (c == '\\')
+            out.append("\\\\");
+        else
+            out.push_back(c);
+    }
+}
+
+bool endsWith(std::string_view str, std::string_view suffix)
+{
+    return str.size() >= suffix.size() &&
+           str.substr(str.size() - suffix.size()) == suffix;
+}
+
+void exportCollector(const CollectorBase &collector,
+                     bool openMetrics,
+                     std::string &out)
+{
+    auto sampleGroups = collector.collect();
+    auto type = collector.type();
+    // OpenMetrics names the counter families without the _total suffix of
+    // their samples
+    bool counter = openMetrics && type == "counter";
+    std::string_view family = collector.name();
+    if (counter && endsWith(family, "_total"))
+        family.remove_suffix(6);
+    out.append("# HELP ").append(family).append(" ");
+    appendHelp(out, collector.help());
+    out.append("\n# TYPE ").append(family).append(" ").append(type).append(
+        "\n");
+    for (auto const &sampleGroup : sampleGroups)
+    {
+        auto const &labels = sampleGroup.metric->labelsText();
+        for (auto &sample : sampleGroup.samples)
+        {
+            out.append(sample.name);
+            if (counter && !endsWith(sample.name, "_total"))
+                out.append("_total");
+            if (!sample.exLabels.empty() || !labels.empty())
+            {
+                out.push_back('{');
+                out.append(labels);
+                for (auto const &label : sample.exLabels)
+                {
+                    if (out.back() != '{')
+                        out.push_back(',');
+                    out.append(label.first)
+                        .append("=\"")
+                        .append(label.second)
+                        .push_back('"');
+                }
+                out.push_back('}');
+            }
+            out.push_back(' ');
+            appendNumber(out, sample.value);
+            auto milliseconds =
+                sample.timestamp.microSecondsSinceEpoch() / 1000;
+            if (milliseconds > 0)
+            {
+                out.push_back(' ');
+                if (openMetrics)
+                    appendNumber(out, static_cast<double>(milliseconds) / 1000);
+                else
+                    appendNumber(out, static_cast<double>(milliseconds));
+            }
+            out.push_back('\n');
+        }
+    }
+}
+
+bool acceptsOpenMetrics(std::string_view accept)
+{
+    return accept.find("application/openmetrics-text") !=
+           std::string_view::npos;
+}
+}  // namespace
+
 void PromExporter::initAndStart(const Json::Value &config)
 {
     path_ = config.get("path", path_).asString();
+    gzip_ = config.get("gzip", gzip_).asBool();
     LOG_TRACE << path_;
     auto &app = drogon::app();
     std::weak_ptr<PromExporter> weakPtr = shared_from_this();
@@ -26,14 +148,71 @@ void PromExporter::initAndStart(const Json::Value &config)
                 callback(resp);
                 return;
             }
-            auto resp = HttpResponse::newHttpResponse();
-            resp->setBody(thisPtr->exportMetrics());
-            resp->setContentTypeCode(CT_TEXT_PLAIN);
-            resp->setExpiredTime(5);
-            callback(resp);
+            auto &workers = WorkerProcesses::instance();
+            // The texts of the other workers are merged in the classic format
+            bool openMetrics = !workers.enabled() &&
+                               acceptsOpenMetrics(req->getHeader("accept"));
+            bool gzip = thisPtr->gzip_ &&
+                        req->getHeader("accept-encoding").find("gzip") !=
+                            std::string::npos;
+            // Rendered out of the IO loop, it takes a while with many series
+            drogon::app().offload(
+                [thisPtr, openMetrics, gzip]() {
+                    std::string body;
+                    auto &workers = WorkerProcesses::instance();
+                    if (workers.enabled())
+                    {
+                        // The metrics of this worker are the freshest ones
+                        auto texts = workers.otherMetrics();
+                        texts.insert(texts.begin(), thisPtr->exportMetrics());
+                        body = WorkerProcesses::mergeMetrics(texts);
+                    }
+                    else
+                    {
+                        body = thisPtr->exportMetrics(openMetrics);
+                    }
+                    if (gzip)
+                    {
+                        auto compressed =
+                            utils::gzipCompress(body.data(), body.length());
+                        if (!compressed.empty())
+                            return std::make_pair(std::move(compressed), true);
+                    }
+                    return std::make_pair(std::move(body), false);
+                },
+                [callback = std::move(callback),
+                 openMetrics](std::pair<std::string, bool> body) {
+                    auto resp = HttpResponse::newHttpResponse();
+                    resp->setBody(std::move(body.first));
+                    if (openMetrics)
+                    {
+                        resp->setContentTypeString(
+                            "application/openmetrics-text; version=1.0.0; "
+                            "charset=utf-8");
+                    }
+                    else
+                    {
+                        resp->setContentTypeCode(CT_TEXT_PLAIN);
+                    }
+                    if (body.second)
+                        resp->addHeader("content-encoding", "gzip");
+                    resp->addHeader("vary", "accept, accept-encoding");
+                    callback(resp);
+                });
         },
         {Get, Options},
         "PromExporter");
+    if (WorkerProcesses::instance().enabled())
+    {
+        // Read by the other workers when they are scraped
+        app.getLoop()->runEvery(1.0, [weakPtr]() {
+            if (auto thisPtr = weakPtr.lock())
+            {
+                WorkerProcesses::instance().publishMetrics(
+                    thisPtr->exportMetrics());
+            }
+        });
+    }
     if (config.isMember("collectors"))
     {
         std::lock_guard<std::mutex> guard(mutex_);
@@ -87,6 +266,14 @@ void PromExporter::initAndStart(const Json::Value &config)
                             collectors_.insert(
                                 std::make_pair(name, histogramCollector));
                         }
+                        else if (type == "summary")
+                        {
+                            auto summaryCollector =
+                                std::make_shared<Collector<Summary>>(
+                                    name, help, labelNames);
+                            collectors_.insert(
+                                std::make_pair(name, summaryCollector));
+                        }
                         else
                         {
                             LOG_ERROR << "Unknown collector type: " << type;
@@ -108,75 +295,49 @@ void PromExporter::initAndStart(const Json::Value &config)
             LOG_ERROR << "collectors must be an array!";
         }
     }
-}
-
-static std::string exportCollector(
-    const std::shared_ptr<CollectorBase> &collector)
-{
-    auto sampleGroups = collector->collect();
-    std::string res;
-    res.append("# HELP ")
-        .append(collector->name())
-        .append(" ")
-        .append(collector->help())
-        .append("\n");
-    res.append("# TYPE ")
-        .append(collector->name())
-        .append(" ")
-        .append(collector->type())
-        .append("\n");
-    for (auto const &sampleGroup : sampleGroups)
+    if (config.get("builtin_metrics", false).asBool())
     {
-        auto const &metricPtr = sampleGroup.metric;
-        auto const &samples = sampleGroup.samples;
-        for (auto &sample : samples)
+        std::vector<double> latencyBuckets{
+            0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5};
+        auto &buckets = config["latency_buckets"];
+        if (buckets.isArray() && !buckets.empty())
         {
-            res.append(sample.name);
-            if (!sample.exLabels.empty() || !metricPtr->labels().empty())
-            {
-                res.append("{");
-                for (auto const &label : metricPtr->labels())
-                {
-                    res.append(label.first)
-                        .append("=\"")
-                        .append(label.second)
-                        .append("\",");
-                }
-                for (auto const &label : sample.exLabels)
-                {
-                    res.append(label.first)
-                        .append("=\"")
-                        .append(label.second)
-                        .append("\",");
-                }
-                res.pop_back();
-                res.append("}");
-            }
-            res.append(" ").append(std::to_string(sample.value));
-            if (sample.timestamp.microSecondsSinceEpoch() > 0)
+            latencyBuckets.clear();
+            for (auto const &bucket : buckets)
             {
-                res.append(" ")
-                    .append(std::to_string(
-                        sample.timestamp.microSecondsSinceEpoch() / 1000))
-                    .append("\n");
-            }
-            else
-            {
-                res.append("\n");
+                latencyBuckets.push_back(bucket.asDouble());
             }
         }
+        if (std::adjacent_find(latencyBuckets.begin(),
+                               latencyBuckets.end(),
+                               std::greater_equal<double>()) !=
+            latencyBuckets.end())
+        {
+            throw std::runtime_error(
+                "The latency_buckets of PromExporter must be sorted");
+        }
+        BuiltinMetrics::instance().enable(*this, latencyBuckets);
     }
-    return res;
 }
 
-std::string PromExporter::exportMetrics()
+std::string PromExporter::exportMetrics(bool openMetrics)
 {
-    std::lock_guard<std::mutex> guard(mutex_);
-    std::string result;
-    for (auto const &collector : collectors_)
+    // Rendered without the lock, the registration of the collectors doesn't
+    // wait for the scrapes
+    std::vector<std::shared_ptr<CollectorBase>> collectors;
     {
-        result.append(exportCollector(collector.second));
+        std::lock_guard<std::mutex> guard(mutex_);
+        collectors.reserve(collectors_.size());
+        for (auto const &collector : collectors_)
+            collectors.push_back(collector.second);
     }
+    std::string result;
+    result.reserve(lastSize_.load(std::memory_order_relaxed) * 9 / 8);
+    for (auto const &collector : collectors)
+        exportCollector(*collector, openMetrics, result);
+    lastSize_.store(result.size(), std::memory_order_relaxed);
+    if (openMetrics)
+        result.append("# EOF\n");
     return result;
 }
 
@@ -0,0 +1,216 @@
+/**
+ *
+ *  @file ProxyProtocol.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ProxyProtocol.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+using namespace drogon;
+using namespace drogon::proxy_protocol;
+
+namespace
+{
+constexpr std::string_view kV1Prefix{"PROXY "};
+// The longest line, "PROXY TCP6" with the longest addresses and ports
+constexpr size_t kV1MaxLength = 107;
+constexpr std::string_view kV2Signature{"\r\n\r\n\0\r\nQUIT\n", 12};
+// The signature, the version and command, the family and the length
+constexpr size_t kV2HeaderLength = 16;
+constexpr uint8_t kV2Version = 2;
+constexpr uint8_t kV2Local = 0;
+constexpr uint8_t kV2Proxy = 1;
+constexpr uint8_t kV2Inet = 1;
+constexpr uint8_t kV2Inet6 = 2;
+constexpr uint8_t kV2Stream = 1;
+
+bool parsePort(std::string_view text, uint16_t &port)
+{
+    if (text.empty() || text.length() > 5 ||
+        (text[0] == '0' && text.length() > 1))
+    {
+        return false;
+    }
+    uint32_t value = 0;
+    for (auto c : text)
+    {
+        if (c < '0' || c > '9')
+            return false;
+        value = value * 10 + (c - '0');
+    }
+    if (value > 65535)
+        return false;
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+bool toAddress(std::string_view ip,
+               std::string_view port,
+               bool isIpV6,
+               trantor::InetAddress &address)
+{
+    uint16_t portNumber;
+    if (!parsePort(port, portNumber))
+        return false;
+    std::string ipString(ip);
+    if (isIpV6)
+    {
+        sockaddr_in6 addr{};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = htons(portNumber);
+        if (::inet_pton(AF_INET6, ipString.c_str(), &addr.sin6_addr) != 1)
+            return false;
+        address = trantor::InetAddress(addr);
+    }
+    else
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(portNumber);
+        if (::inet_pton(AF_INET, ipString.c_str(), &addr.sin_addr) != 1)
+            return false;
+        address = trantor::InetAddress(addr);
+    }
+    return true;
+}
+
+// PROXY <protocol> <source> <destination> <source port> <destination port>
+ParseResult parseV1(trantor::MsgBuffer *buf, Addresses &addresses)
+{
+    std::string_view data(buf->peek(),
+                          (std::min)(buf->readableBytes(), kV1MaxLength));
+    auto end = data.find("\r\n");
+    if (end == std::string_view::npos)
+    {
+        return data.length() == kV1MaxLength ? ParseResult::kInvalid
+                                             : ParseResult::kIncomplete;
+    }
+    auto line = data.substr(kV1Prefix.length(), end - kV1Prefix.length());
+    std::string_view fields[5];
+    size_t count = 0;
+    while (count < 5)
+    {
+        auto space = line.find(' ');
+        fields[count++] = line.substr(0, space);
+        if (space == std::string_view::npos)
+        {
+            line = {};
+            break;
+        }
+        line.remove_prefix(space + 1);
+    }
+    if (fields[0] == "UNKNOWN")
+    {
+        // The addresses that may follow are ignored
+        buf->retrieve(end + 2);
+        return ParseResult::kDone;
+    }
+    if (count != 5 || !line.empty() ||
+        (fields[0] != "TCP4" && fields[0] != "TCP6"))
+    {
+        return ParseResult::kInvalid;
+    }
+    bool isIpV6 = fields[0] == "TCP6";
+    if (!toAddress(fields[1], fields[3], isIpV6, addresses.peer) ||
+        !toAddress(fields[2], fields[4], isIpV6, addresses.local))
+    {
+        return ParseResult::kInvalid;
+    }
+    addresses.proxied = true;
+    buf->retrieve(end + 2);
+    return ParseResult::kDone;
+}
+
+ParseResult parseV2(trantor::MsgBuffer *buf, Addresses &addresses)
+{
+    auto data = reinterpret_cast<const uint8_t *>(buf->peek());
+    auto versionCommand = data[12];
+    auto command = versionCommand & 0x0F;
+    if ((versionCommand >> 4) != kV2Version ||
+        (command != kV2Local && command != kV2Proxy))
+    {
+        return ParseResult::kInvalid;
+    }
+    size_t length = (static_cast<size_t>(data[14]) << 8) | data[15];
+    if (buf->readableBytes() < kV2HeaderLength + length)
+        return ParseResult::kIncomplete;
+    auto family = data[13] >> 4;
+    auto transport = data[13] & 0x0F;
+    // The addresses are followed by the TLVs, which are ignored
+    auto body = data + kV2HeaderLength;
+    if (command == kV2Proxy && transport == kV2Stream && family == kV2Inet)
+    {
+        if (length < 12)
+            return ParseResult::kInvalid;
+        sockaddr_in peer{};
+        sockaddr_in local{};
+        peer.sin_family = AF_INET;
+        local.sin_family = AF_INET;
+        memcpy(&peer.sin_addr, body, 4);
+        memcpy(&local.sin_addr, body + 4, 4);
+        memcpy(&peer.sin_port, body + 8, 2);
+        memcpy(&local.sin_port, body + 10, 2);
+        addresses.peer = trantor::InetAddress(peer);
+        addresses.local = trantor::InetAddress(local);
+        addresses.proxied = true;
+    }
+    else if (command == kV2Proxy && transport == kV2Stream &&
+             family == kV2Inet6)
+    {
+        if (length < 36)
+            return ParseResult::kInvalid;
+        sockaddr_in6 peer{};
+        sockaddr_in6 local{};
+        peer.sin6_family = AF_INET6;
+        local.sin6_family = AF_INET6;
+        memcpy(&peer.sin6_addr, body, 16);
+        memcpy(&local.sin6_addr, body + 16, 16);
+        memcpy(&peer.sin6_port, body + 32, 2);
+        memcpy(&local.sin6_port, body + 34, 2);
+        addresses.peer = trantor::InetAddress(peer);
+        addresses.local = trantor::InetAddress(local);
+        addresses.proxied = true;
+    }
+    buf->retrieve(kV2HeaderLength + length);
+    return ParseResult::kDone;
+}
+}  // namespace
+
+ParseResult proxy_protocol::parse(trantor::MsgBuffer *buf,
+                                  Addresses &addresses)
+{
+    auto length = buf->readableBytes();
+    if (length == 0)
+        return ParseResult::kIncomplete;
+    std::string_view data(buf->peek(), length);
+    if (data[0] == kV1Prefix[0])
+    {
+        auto n = (std::min)(length, kV1Prefix.length());
+        if (data.substr(0, n) != kV1Prefix.substr(0, n))
+            return ParseResult::kInvalid;
+        return n < kV1Prefix.length() ? ParseResult::kIncomplete
+                                      : parseV1(buf, addresses);
+    }
+    auto n = (std::min)(length, kV2Signature.length());
+    if (data.substr(0, n) != kV2Signature.substr(0, n))
+        return ParseResult::kInvalid;
+    return length < kV2HeaderLength ? ParseResult::kIncomplete
+                                    : parseV2(buf, addresses);
+}
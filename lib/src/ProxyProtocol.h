@@ -0,0 +1,52 @@
+/**
+ *
+ *  @file ProxyProtocol.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/MsgBuffer.h>
+
+namespace drogon
+{
+namespace proxy_protocol
+{
+enum class ParseResult
+{
+    kIncomplete,
+    kInvalid,
+    kDone
+};
+
+struct Addresses
+{
+    // False for the health checks of the load balancer (the LOCAL command)
+    // and for the protocols other than TCP over IPv4 or IPv6
+    bool proxied{false};
+    trantor::InetAddress peer;
+    trantor::InetAddress local;
+};
+
+/**
+ * @brief Parse the PROXY protocol header, v1 (text) or v2 (binary), which
+ * load balancers send at the start of a connection to give the addresses of
+ * the client and of the server it connected to.
+ *
+ * The header is consumed from the buffer once it is complete, the data that
+ * follows it is left in the buffer.
+ *
+ * @see https://www.haproxy.org/download/2.9/doc/proxy-protocol.txt
+ */
+ParseResult parse(trantor::MsgBuffer *buf, Addresses &addresses);
+
+}  // namespace proxy_protocol
+}  // namespace drogon
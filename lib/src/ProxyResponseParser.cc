@@ -0,0 +1,270 @@
+/**
+ *
+ *  @file ProxyResponseParser.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ProxyResponseParser.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t kMaxLineSize = 1024;
+
+std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+        text.remove_suffix(1);
+    return text;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return tolower(static_cast<unsigned char>(x)) ==
+                      tolower(static_cast<unsigned char>(y));
+           });
+}
+
+// Whether a comma separated list of tokens holds the token
+bool hasToken(std::string_view list, std::string_view token)
+{
+    while (!list.empty())
+    {
+        auto comma = list.find(',');
+        if (equalsIgnoreCase(trim(list.substr(0, comma)), token))
+            return true;
+        if (comma == std::string_view::npos)
+            break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// The last transfer coding must be chunked for the body to be chunked
+bool isChunked(std::string_view codings)
+{
+    auto comma = codings.rfind(',');
+    if (comma != std::string_view::npos)
+        codings.remove_prefix(comma + 1);
+    return equalsIgnoreCase(trim(codings), "chunked");
+}
+}  // namespace
+
+long ProxyResponseParser::parse(const char *data, size_t length)
+{
+    size_t pos = 0;
+    while (pos < length && state_ != State::kDone)
+    {
+        switch (state_)
+        {
+            case State::kHead:
+            case State::kChunkSize:
+            case State::kTrailers:
+            {
+                auto n = state_ == State::kHead
+                             ? parseHead(data + pos, length - pos)
+                         : state_ == State::kChunkSize
+                             ? parseChunkSize(data + pos, length - pos)
+                             : parseTrailers(data + pos, length - pos);
+                if (n < 0)
+                    return -1;
+                if (n == 0)
+                    return static_cast<long>(pos);
+                pos += static_cast<size_t>(n);
+                break;
+            }
+            case State::kLength:
+            case State::kChunkData:
+            {
+                auto n = static_cast<size_t>(
+                    (std::min)(remaining_, uint64_t(length - pos)));
+                remaining_ -= n;
+                if (remaining_ == 0)
+                {
+                    state_ = state_ == State::kLength ? State::kDone
+                                                      : State::kChunkEnd;
+                }
+                bodyCallback_(data + pos, n);
+                pos += n;
+                break;
+            }
+            case State::kChunkEnd:
+                if (length - pos < 2)
+                    return static_cast<long>(pos);
+                if (data[pos] != '\r' || data[pos + 1] != '\n')
+                    return -1;
+                pos += 2;
+                state_ = State::kChunkSize;
+                break;
+            case State::kUntilClose:
+                bodyCallback_(data + pos, length - pos);
+                pos = length;
+                break;
+            case State::kDone:
+                break;
+        }
+    }
+    return static_cast<long>(pos);
+}
+
+long ProxyResponseParser::parseHead(const char *data, size_t length)
+{
+    std::string_view text(data, length);
+    auto end = text.find("\r\n\r\n");
+    if (end == std::string_view::npos)
+        return length > maxHeaderSize_ ? -1 : 0;
+    if (end + 4 > maxHeaderSize_)
+        return -1;
+    text = text.substr(0, end + 2);
+
+    auto eol = text.find("\r\n");
+    auto statusLine = text.substr(0, eol);
+    if (statusLine.size() < 12 || statusLine.substr(0, 7) != "HTTP/1." ||
+        statusLine[8] != ' ')
+        return -1;
+    bool http10 = statusLine[7] == '0';
+    int statusCode = 0;
+    for (size_t i = 9; i < 12; ++i)
+    {
+        if (!isdigit(static_cast<unsigned char>(statusLine[i])))
+            return -1;
+        statusCode = statusCode * 10 + (statusLine[i] - '0');
+    }
+    if (statusLine.size() > 12 && statusLine[12] != ' ')
+        return -1;
+
+    Head head;
+    head.statusCode = statusCode;
+    if (statusLine.size() > 13)
+        head.statusMessage = statusLine.substr(13);
+    bool chunked{false};
+    bool hasLength{false};
+    uint64_t contentLength{0};
+    keepAlive_ = !http10;
+    text.remove_prefix(eol + 2);
+    while (!text.empty())
+    {
+        eol = text.find("\r\n");
+        auto line = text.substr(0, eol);
+        text.remove_prefix(eol + 2);
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0)
+            return -1;
+        std::string name(line.substr(0, colon));
+        std::transform(name.begin(),
+                       name.end(),
+                       name.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        auto value = trim(line.substr(colon + 1));
+        if (name == "transfer-encoding")
+        {
+            chunked = isChunked(value);
+        }
+        else if (name == "content-length")
+        {
+            uint64_t len{0};
+            if (value.empty())
+                return -1;
+            for (auto c : value)
+            {
+                if (!isdigit(static_cast<unsigned char>(c)) ||
+                    len > UINT64_MAX / 10)
+                    return -1;
+                len = len * 10 + static_cast<uint64_t>(c - '0');
+            }
+            // Different lengths would allow smuggling a response
+            if (hasLength && len != contentLength)
+                return -1;
+            hasLength = true;
+            contentLength = len;
+        }
+        else if (name == "connection")
+        {
+            if (hasToken(value, "close"))
+                keepAlive_ = false;
+            else if (hasToken(value, "keep-alive"))
+                keepAlive_ = true;
+        }
+        head.headers.emplace_back(std::move(name), std::string(value));
+    }
+
+    if (statusCode < 200)
+    {
+        // Switching protocols is not proxied, the interim responses are
+        // dropped.
+        if (statusCode == 101)
+            return -1;
+        return static_cast<long>(end + 4);
+    }
+    if (headRequest_ || statusCode == 204 || statusCode == 304)
+    {
+        state_ = State::kDone;
+    }
+    else if (chunked)
+    {
+        state_ = State::kChunkSize;
+    }
+    else if (hasLength)
+    {
+        remaining_ = contentLength;
+        state_ = contentLength > 0 ? State::kLength : State::kDone;
+    }
+    else
+    {
+        state_ = State::kUntilClose;
+        keepAlive_ = false;
+    }
+    headCallback_(std::move(head));
+    return static_cast<long>(end + 4);
+}
+
+long ProxyResponseParser::parseChunkSize(const char *data, size_t length)
+{
+    std::string_view text(data, length);
+    auto eol = text.find("\r\n");
+    if (eol == std::string_view::npos)
+        return length > kMaxLineSize ? -1 : 0;
+    // Chunk extensions are ignored
+    auto sizeText = trim(text.substr(0, (std::min)(eol, text.find(';'))));
+    if (sizeText.empty() || sizeText.size() > 15)
+        return -1;
+    uint64_t size{0};
+    for (auto c : sizeText)
+    {
+        if (!isxdigit(static_cast<unsigned char>(c)))
+            return -1;
+        size = size * 16 +
+               static_cast<uint64_t>(isdigit(static_cast<unsigned char>(c))
+                                         ? c - '0'
+                                         : tolower(c) - 'a' + 10);
+    }
+    remaining_ = size;
+    state_ = size > 0 ? State::kChunkData : State::kTrailers;
+    return static_cast<long>(eol + 2);
+}
+
+long ProxyResponseParser::parseTrailers(const char *data, size_t length)
+{
+    std::string_view text(data, length);
+    auto eol = text.find("\r\n");
+    if (eol == std::string_view::npos)
+        return length > maxHeaderSize_ ? -1 : 0;
+    // The trailer fields are dropped, the empty line ends the response
+    if (eol == 0)
+        state_ = State::kDone;
+    return static_cast<long>(eol + 2);
+}
@@ -0,0 +1,128 @@
+/**
+ *
+ *  @file ProxyResponseParser.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief An incremental parser of the HTTP/1 responses of an upstream server.
+ * The header is parsed as a whole, the body is passed on in the pieces it is
+ * received in, without its chunked framing, so it is never held in memory.
+ */
+class DROGON_EXPORT ProxyResponseParser
+{
+  public:
+    struct Head
+    {
+        int statusCode{0};
+        std::string statusMessage;
+        /// The names are in lower case, in the order of the response
+        std::vector<std::pair<std::string, std::string>> headers;
+    };
+
+    using HeadCallback = std::function<void(Head &&head)>;
+    using BodyCallback = std::function<void(const char *data, size_t length)>;
+
+    ProxyResponseParser(HeadCallback headCb,
+                        BodyCallback bodyCb,
+                        size_t maxHeaderSize = 64 * 1024)
+        : headCallback_(std::move(headCb)),
+          bodyCallback_(std::move(bodyCb)),
+          maxHeaderSize_(maxHeaderSize)
+    {
+    }
+
+    /// Expect the response to a new request, HEAD responses have no body.
+    void reset(bool headRequest)
+    {
+        state_ = State::kHead;
+        headRequest_ = headRequest;
+        keepAlive_ = true;
+        remaining_ = 0;
+    }
+
+    /**
+     * @brief Parse the data received, the callbacks are called on the way.
+     *
+     * @return The number of bytes consumed, the rest is an incomplete header
+     * or chunk size line to be passed again with more data. -1 on a protocol
+     * error.
+     */
+    long parse(const char *data, size_t length);
+
+    /**
+     * @brief The connection was closed, return true if this completes the
+     * response, i.e. its body was delimited by the close.
+     */
+    bool finishOnClose()
+    {
+        if (state_ != State::kUntilClose)
+            return false;
+        state_ = State::kDone;
+        return true;
+    }
+
+    /// The response is complete
+    bool done() const
+    {
+        return state_ == State::kDone;
+    }
+
+    /// The header has been parsed
+    bool headReceived() const
+    {
+        return state_ != State::kHead;
+    }
+
+    /// Whether the connection can carry another request after this response
+    bool keepAlive() const
+    {
+        return keepAlive_ && state_ == State::kDone;
+    }
+
+  private:
+    enum class State : uint8_t
+    {
+        kHead,
+        kLength,
+        kChunkSize,
+        kChunkData,
+        kChunkEnd,
+        kTrailers,
+        kUntilClose,
+        kDone
+    };
+
+    long parseHead(const char *data, size_t length);
+    long parseChunkSize(const char *data, size_t length);
+    long parseTrailers(const char *data, size_t length);
+
+    HeadCallback headCallback_;
+    BodyCallback bodyCallback_;
+    size_t maxHeaderSize_;
+    State state_{State::kDone};
+    bool headRequest_{false};
+    bool keepAlive_{true};
+    uint64_t remaining_{0};
+};
+
+}  // namespace drogon
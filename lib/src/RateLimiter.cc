@@ -1,4 +1,6 @@
 #include <drogon/RateLimiter.h>
+#include "AtomicSlidingWindowRateLimiter.h"
+#include "AtomicTokenBucketRateLimiter.h"
 #include "FixedWindowRateLimiter.h"
 #include "SlidingWindowRateLimiter.h"
 #include "TokenBucketRateLimiter.h"
@@ -19,6 +21,12 @@ RateLimiterPtr RateLimiter::newRateLimiter(
                                                               timeUnit);
         case RateLimiterType::kTokenBucket:
             return std::make_shared<TokenBucketRateLimiter>(capacity, timeUnit);
+        case RateLimiterType::kAtomicSlidingWindow:
+            return std::make_shared<AtomicSlidingWindowRateLimiter>(capacity,
+                                                                    timeUnit);
+        case RateLimiterType::kAtomicTokenBucket:
+            return std::make_shared<AtomicTokenBucketRateLimiter>(capacity,
+                                                                  timeUnit);
     }
     return std::make_shared<TokenBucketRateLimiter>(capacity, timeUnit);
 }
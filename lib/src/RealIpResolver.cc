@@ -62,12 +62,41 @@ struct XForwardedForParser : public trantor::NonCopyable
 
 static trantor::InetAddress parseAddress(const std::string &addr)
 {
+    if (!addr.empty() && addr[0] == '[')
+    {
+        // [ipv6]:port or [ipv6]
+        auto end = addr.find(']');
+        if (end == std::string::npos)
+        {
+            return trantor::InetAddress(addr, 0, true);
+        }
+        uint16_t port = 0;
+        if (end + 1 < addr.length() && addr[end + 1] == ':')
+        {
+            try
+            {
+                port = std::stoi(addr.substr(end + 2));
+            }
+            catch (const std::exception &ex)
+            {
+                (void)ex;
+                LOG_ERROR << "Error in ipv6 address: " + addr;
+                port = 0;
+            }
+        }
+        return trantor::InetAddress(addr.substr(1, end - 1), port, true);
+    }
     auto pos = addr.find(':');
     uint16_t port = 0;
     if (pos == std::string::npos)
     {
         return trantor::InetAddress(addr, 0);
     }
+    if (addr.find(':', pos + 1) != std::string::npos)
+    {
+        // An ipv6 address without a port
+        return trantor::InetAddress(addr, 0, true);
+    }
     try
     {
         port = std::stoi(addr.substr(pos + 1));
@@ -102,14 +131,14 @@ void RealIpResolver::initAndStart(const Json::Value &config)
     }
     for (const auto &ipOrCidr : trustIps)
     {
-        trustCIDRs_.emplace_back(ipOrCidr.asString());
+        trustIps_.add(ipOrCidr.asString());
     }
 
     drogon::app().registerPreRoutingAdvice([this](const HttpRequestPtr &req) {
         const auto &headers = req->headers();
         auto ipHeaderFind = headers.find(fromHeader_);
         const trantor::InetAddress &peerAddr = req->getPeerAddr();
-        if (ipHeaderFind == headers.end() || !matchCidr(peerAddr, trustCIDRs_))
+        if (ipHeaderFind == headers.end() || !trustIps_.contains(peerAddr))
         {
             // Target header is empty, or
             // direct peer is already a non-proxy
@@ -138,7 +167,7 @@ void RealIpResolver::initAndStart(const Json::Value &config)
         while (!(ip = parser.getNext()).empty())
         {
             trantor::InetAddress addr = parseAddress(ip);
-            if (addr.isUnspecified() || matchCidr(addr, trustCIDRs_))
+            if (addr.isUnspecified() || trustIps_.contains(addr))
             {
                 continue;
             }
@@ -175,52 +204,3 @@ const trantor::InetAddress &RealIpResolver::getRealAddr(
     }
     return attributesPtr->get<trantor::InetAddress>(attributeKey_);
 }
-
-bool RealIpResolver::matchCidr(const trantor::InetAddress &addr,
-                               const CIDRs &trustCIDRs)
-{
-    for (const auto &cidr : trustCIDRs)
-    {
-        if ((addr.ipNetEndian() & cidr.mask_) == cidr.addr_)
-        {
-            return true;
-        }
-    }
-    return false;
-}
-
-RealIpResolver::CIDR::CIDR(const std::string &ipOrCidr)
-{
-    // Find CIDR slash
-    auto pos = ipOrCidr.find('/');
-    std::string ipv4;
-    if (pos != std::string::npos)
-    {
-        // parameter is a CIDR block
-        std::string prefixLen = ipOrCidr.substr(pos + 1);
-        ipv4 = ipOrCidr.substr(0, pos);
-        uint16_t prefix = std::stoi(prefixLen);
-        if (prefix > 32)
-        {
-            throw std::runtime_error("Bad CIDR block: " + ipOrCidr);
-        }
-        mask_ = htonl(0xffffffffu << (32 - prefix));
-    }
-    else
-    {
-        // parameter is an IP
-        ipv4 = ipOrCidr;
-        mask_ = 0xffffffffu;
-    }
-
-    trantor::InetAddress addr(ipv4, 0);
-    if (addr.isIpV6())
-    {
-        throw std::runtime_error("Ipv6 is not supported by RealIpResolver.");
-    }
-    if (addr.isUnspecified())
-    {
-        throw std::runtime_error("Bad ipv4 address: " + ipv4);
-    }
-    addr_ = addr.ipNetEndian() & mask_;
-}
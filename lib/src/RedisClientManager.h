@@ -21,6 +21,7 @@
 #include <trantor/net/EventLoop.h>
 #include <string>
 #include <memory>
+#include <stdexcept>
 
 namespace drogon
 {
@@ -40,7 +41,25 @@ class RedisClientManager : public trantor::NonCopyable
     RedisClientPtr getFastRedisClient(const std::string &name)
     {
         auto iter = redisFastClientsMap_.find(name);
+        // The fast clients are bound to the IO loops, other threads get the
+        // shared client of a client having both.
+        if (iter == redisFastClientsMap_.end() ||
+            app().getCurrentThreadIndex() >= app().getThreadNum())
+        {
+            auto sharedIter = redisClientsMap_.find(name);
+            if (sharedIter != redisClientsMap_.end())
+                return sharedIter->second;
+        }
         assert(iter != redisFastClientsMap_.end());
+        // The handler loops and the other threads have no fast client
+        if (app().getCurrentThreadIndex() > app().getThreadNum())
+        {
+            throw std::runtime_error(
+                "The fast redis client '" + name +
+                "' can only be used in the IO loops and the main loop, set "
+                "its fastConnectionNum instead of isFast to share a client "
+                "with the other threads");
+        }
         return iter->second.getThreadData();
     }
 
@@ -52,11 +71,21 @@ class RedisClientManager : public trantor::NonCopyable
                            size_t connectionNum,
                            bool isFast,
                            double timeout,
-                           unsigned int db);
+                           unsigned int db,
+                           bool cluster = false,
+                           size_t fastConnectionNum = 0,
+                           const std::string &sentinelMaster = "",
+                           bool replicaReads = false);
     // bool areAllRedisClientsAvailable() const noexcept;
 
     ~RedisClientManager();
 
+    /// The shared clients by name, the fast ones are not included
+    const std::map<std::string, RedisClientPtr> &redisClients() const
+    {
+        return redisClientsMap_;
+    }
+
   private:
     std::map<std::string, RedisClientPtr> redisClientsMap_;
     std::map<std::string, IOThreadStorage<RedisClientPtr>> redisFastClientsMap_;
@@ -72,6 +101,12 @@ class RedisClientManager : public trantor::NonCopyable
         size_t connectionNumber_;
         double timeout_;
         unsigned int db_;
+        bool cluster_;
+        // The connections of the fast client of every IO loop
+        size_t fastConnectionNumber_;
+        // The replication group followed through the Sentinel at addr_
+        std::string sentinelMaster_;
+        bool replicaReads_;
     };
 
     std::vector<RedisInfo> redisInfos_;
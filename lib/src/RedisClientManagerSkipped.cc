@@ -27,15 +27,20 @@ void RedisClientManager::createRedisClients(
     return;
 }
 
-void RedisClientManager::createRedisClient(const std::string & /*name*/,
-                                           const std::string & /*host*/,
-                                           unsigned short /*port*/,
-                                           const std::string & /*username*/,
-                                           const std::string & /*password*/,
-                                           size_t /*connectionNum*/,
-                                           bool /*isFast*/,
-                                           double /*timeout*/,
-                                           unsigned int /*db*/)
+void RedisClientManager::createRedisClient(
+    const std::string & /*name*/,
+    const std::string & /*host*/,
+    unsigned short /*port*/,
+    const std::string & /*username*/,
+    const std::string & /*password*/,
+    size_t /*connectionNum*/,
+    bool /*isFast*/,
+    double /*timeout*/,
+    unsigned int /*db*/,
+    bool /*cluster*/,
+    size_t /*fastConnectionNum*/,
+    const std::string & /*sentinelMaster*/,
+    bool /*replicaReads*/)
 {
     LOG_FATAL << "Redis is not supported by drogon, please install the "
                  "hiredis library first.";
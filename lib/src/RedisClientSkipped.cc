@@ -29,5 +29,38 @@ std::shared_ptr<RedisClient> RedisClient::newRedisClient(
                  "hiredis library first.";
     abort();
 }
+
+std::shared_ptr<RedisClient> RedisClient::newRedisClusterClient(
+    const std::vector<trantor::InetAddress> & /*seedNodes*/,
+    size_t /*connectionsPerNode*/,
+    const std::string & /*password*/,
+    const std::string & /*username*/)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+
+std::shared_ptr<RedisClient> RedisClient::newRedisSentinelClient(
+    const std::vector<trantor::InetAddress> & /*sentinels*/,
+    const std::string & /*masterName*/,
+    size_t /*connectionsPerNode*/,
+    bool /*readFromReplicas*/,
+    const std::string & /*password*/,
+    unsigned int /*db*/,
+    const std::string & /*username*/)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+
+RedisPipeline &RedisPipeline::add(std::string_view /*command*/,
+                                  ...) noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
 }  // namespace nosql
 }  // namespace drogon
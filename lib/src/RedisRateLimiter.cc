@@ -0,0 +1,166 @@
+/**
+ *
+ *  @file RedisRateLimiter.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisRateLimiter.h"
+#include <algorithm>
+
+using namespace drogon;
+using namespace drogon::nosql;
+
+namespace
+{
+// KEYS[1]: the counter, ARGV[1]: the number of tokens requested,
+// ARGV[2]: the capacity, ARGV[3]: the window in milliseconds.
+// Return the number of tokens granted and the remaining time of the window.
+const char *const kLeaseScript =
+    "local n = redis.call('INCRBY', KEYS[1], ARGV[1]) "
+    "local ttl = redis.call('PTTL', KEYS[1]) "
+    "if ttl < 0 then "
+    "redis.call('PEXPIRE', KEYS[1], ARGV[3]) ttl = tonumber(ARGV[3]) end "
+    "local over = n - tonumber(ARGV[2]) "
+    "local granted = tonumber(ARGV[1]) "
+    "if over > 0 then granted = math.max(granted - over, 0) end "
+    "return {granted, ttl}";
+}  // namespace
+
+RedisRateLimiter::RedisRateLimiter(nosql::RedisClientPtr client,
+                                   std::string key,
+                                   size_t capacity,
+                                   std::chrono::duration<double> timeUnit,
+                                   size_t leaseSize)
+    : client_(std::move(client)),
+      key_(std::move(key)),
+      capacity_(capacity),
+      timeUnit_(timeUnit),
+      leaseSize_((std::max)(static_cast<size_t>(1),
+                            (std::min)(leaseSize, capacity)))
+{
+}
+
+bool RedisRateLimiter::isAllowed()
+{
+    auto now = Clock::now();
+    size_t requested{0};
+    bool allowed{false};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (now < fallbackUntil_)
+            return fallbackLimiter_->isAllowed();
+        if (now >= windowEnd_)
+            tokens_ = 0;
+        if (tokens_ * 2 <= leaseSize_ && !leasing_ && now >= exhaustedUntil_)
+        {
+            leasing_ = true;
+            requested = leaseSize_ + debt_;
+        }
+        if (tokens_ > 0)
+        {
+            --tokens_;
+            allowed = true;
+        }
+        else if (leasing_ && debt_ < leaseSize_)
+        {
+            ++debt_;
+            allowed = true;
+        }
+    }
+    // Not locked, in case the callbacks are called in this thread
+    if (requested > 0)
+        requestLease(requested, now);
+    return allowed;
+}
+
+void RedisRateLimiter::requestLease(size_t requested, Clock::time_point now)
+{
+    auto windowMs = static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(timeUnit_)
+            .count());
+    std::weak_ptr<RedisRateLimiter> weakPtr = shared_from_this();
+    client_->execCommandAsync(
+        [weakPtr, requested, now](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            try
+            {
+                auto values = result.asArray();
+                if (values.size() == 2)
+                {
+                    thisPtr->onLease(requested,
+                                     values[0].asInteger(),
+                                     values[1].asInteger(),
+                                     now);
+                    return;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR << "Bad result of the rate limiter: " << e.what();
+            }
+            thisPtr->onLeaseError(Clock::now());
+        },
+        [weakPtr](const RedisException &err) {
+            LOG_ERROR << "Failed to lease tokens of the rate limiter: "
+                      << err.what();
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->onLeaseError(Clock::now());
+        },
+        "eval %s 1 %b %s %s %s",
+        kLeaseScript,
+        key_.data(),
+        key_.size(),
+        std::to_string(requested).c_str(),
+        std::to_string(capacity_).c_str(),
+        std::to_string(windowMs).c_str());
+}
+
+void RedisRateLimiter::onLease(size_t requested,
+                               long long granted,
+                               long long ttlMs,
+                               Clock::time_point sent)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    leasing_ = false;
+    auto grantedTokens = static_cast<size_t>((std::max)(granted, 0LL));
+    // The window is counted from when the lease was sent, so it never ends
+    // later here than in Redis.
+    auto windowEnd = sent + std::chrono::milliseconds(ttlMs);
+    if (windowEnd > windowEnd_)
+    {
+        windowEnd_ = windowEnd;
+    }
+    if (grantedTokens < requested)
+    {
+        exhaustedUntil_ = windowEnd_;
+    }
+    auto paid = (std::min)(grantedTokens, debt_);
+    debt_ -= paid;
+    tokens_ += grantedTokens - paid;
+}
+
+void RedisRateLimiter::onLeaseError(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    leasing_ = false;
+    debt_ = 0;
+    if (!fallbackLimiter_)
+    {
+        fallbackLimiter_ =
+            RateLimiter::newRateLimiter(RateLimiterType::kFixedWindow,
+                                        capacity_,
+                                        timeUnit_);
+    }
+    fallbackUntil_ =
+        now + std::chrono::duration_cast<Clock::duration>(timeUnit_);
+}
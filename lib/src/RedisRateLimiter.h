@@ -0,0 +1,78 @@
+/**
+ *
+ *  @file RedisRateLimiter.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/RateLimiter.h>
+#include <drogon/nosql/RedisClient.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief A rate limiter shared by all the instances which use the same redis
+ * key.
+ *
+ * The counter of the current window is kept in Redis and changed by a lua
+ * script, and every instance leases a small batch of tokens from it, so most
+ * requests are decided locally. The next batch is leased when half of the
+ * current one is used. While the lease is in flight and the local tokens are
+ * run out, up to one batch of requests is allowed and charged to the next
+ * lease, that is the most an instance can exceed the limit in a window.
+ *
+ * If Redis fails, the limiter falls back to a local fixed window limiter for
+ * a time unit.
+ */
+class RedisRateLimiter : public RateLimiter,
+                         public std::enable_shared_from_this<RedisRateLimiter>
+{
+  public:
+    RedisRateLimiter(nosql::RedisClientPtr client,
+                     std::string key,
+                     size_t capacity,
+                     std::chrono::duration<double> timeUnit,
+                     size_t leaseSize);
+    bool isAllowed() override;
+    ~RedisRateLimiter() noexcept override = default;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    void requestLease(size_t requested, Clock::time_point now);
+    void onLease(size_t requested,
+                 long long granted,
+                 long long ttlMs,
+                 Clock::time_point sent);
+    void onLeaseError(Clock::time_point now);
+
+    nosql::RedisClientPtr client_;
+    const std::string key_;
+    const size_t capacity_;
+    const std::chrono::duration<double> timeUnit_;
+    const size_t leaseSize_;
+
+    std::mutex mutex_;
+    size_t tokens_{0};
+    size_t debt_{0};
+    bool leasing_{false};
+    // The leased tokens are only valid in the window they were counted in
+    Clock::time_point windowEnd_;
+    // No more lease until then because the window is used up
+    Clock::time_point exhaustedUntil_;
+    Clock::time_point fallbackUntil_;
+    RateLimiterPtr fallbackLimiter_;
+};
+}  // namespace drogon
@@ -68,5 +68,41 @@ bool RedisResult::isNil() const noexcept
                  "hiredis library first.";
     abort();
 }
+
+std::string_view RedisResult::asStringView() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+
+double RedisResult::asDouble() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+
+bool RedisResult::asBool() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+
+std::vector<std::pair<RedisResult, RedisResult>> RedisResult::asMap() const
+    noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
+
+Json::Value RedisResult::asJson() const noexcept(false)
+{
+    LOG_FATAL << "Redis is not supported by drogon, please install the "
+                 "hiredis library first.";
+    abort();
+}
 }  // namespace nosql
 }  // namespace drogon
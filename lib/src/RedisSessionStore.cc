@@ -0,0 +1,95 @@
+/**
+ *
+ *  @file RedisSessionStore.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/SessionStore.h>
+
+using namespace drogon;
+using namespace drogon::nosql;
+
+void RedisSessionStore::load(const std::string &sessionId,
+                             size_t timeout,
+                             LoadCallback &&callback)
+{
+    auto key = keyPrefix_ + sessionId;
+    auto sharedCallback = std::make_shared<LoadCallback>(std::move(callback));
+    client_->execCommandAsync(
+        [client = client_, key, timeout, sharedCallback](
+            const RedisResult &result) {
+            if (result.isNil() || result.type() != RedisResultType::kString)
+            {
+                (*sharedCallback)(std::nullopt);
+                return;
+            }
+            if (timeout > 0)
+            {
+                // Restart counting of the expiration like the local sessions
+                client->execCommandAsync(
+                    [](const RedisResult &) {},
+                    [](const RedisException &err) {
+                        LOG_ERROR << "Failed to touch the session: "
+                                  << err.what();
+                    },
+                    "expire %s %s",
+                    key.c_str(),
+                    std::to_string(timeout).c_str());
+            }
+            (*sharedCallback)(result.asString());
+        },
+        [sharedCallback](const RedisException &err) {
+            LOG_ERROR << "Failed to load the session: " << err.what();
+            (*sharedCallback)(std::nullopt);
+        },
+        "get %s",
+        key.c_str());
+}
+
+void RedisSessionStore::save(const std::string &sessionId,
+                             const std::string &data,
+                             size_t timeout)
+{
+    auto key = keyPrefix_ + sessionId;
+    auto errorCallback = [](const RedisException &err) {
+        LOG_ERROR << "Failed to save the session: " << err.what();
+    };
+    if (timeout > 0)
+    {
+        client_->execCommandAsync([](const RedisResult &) {},
+                                  std::move(errorCallback),
+                                  "set %s %b ex %s",
+                                  key.c_str(),
+                                  data.data(),
+                                  data.size(),
+                                  std::to_string(timeout).c_str());
+    }
+    else
+    {
+        client_->execCommandAsync([](const RedisResult &) {},
+                                  std::move(errorCallback),
+                                  "set %s %b",
+                                  key.c_str(),
+                                  data.data(),
+                                  data.size());
+    }
+}
+
+void RedisSessionStore::erase(const std::string &sessionId)
+{
+    auto key = keyPrefix_ + sessionId;
+    client_->execCommandAsync(
+        [](const RedisResult &) {},
+        [](const RedisException &err) {
+            LOG_ERROR << "Failed to erase the session: " << err.what();
+        },
+        "del %s",
+        key.c_str());
+}
@@ -0,0 +1,86 @@
+/**
+ *
+ *  @file RequestPhases.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RequestPhases.h"
+#include <cstdio>
+#include <limits>
+
+using namespace drogon;
+
+std::atomic<uint64_t> PhaseTracing::threshold_{0};
+std::atomic<bool> PhaseTracing::serverTiming_{false};
+
+double RequestPhases::seconds(RequestPhase phase) const
+{
+    auto index = static_cast<size_t>(phase);
+    if (index == 0 || index >= kCount || stamps[index] == 0)
+        return -1;
+    for (auto previous = index; previous-- > 0;)
+    {
+        if (stamps[previous] != 0)
+            return static_cast<double>(stamps[index] - stamps[previous]) / 1e9;
+    }
+    return -1;
+}
+
+const char *RequestPhases::name(RequestPhase phase)
+{
+    static const char *names[] = {"received",
+                                  "parse",
+                                  "pre_route",
+                                  "route",
+                                  "middleware",
+                                  "handler",
+                                  "post_handle",
+                                  "pre_send",
+                                  "compress"};
+    static_assert(sizeof(names) / sizeof(names[0]) == kCount);
+    auto index = static_cast<size_t>(phase);
+    return index < kCount ? names[index] : "";
+}
+
+void PhaseTracing::configure(double sampleRate, bool serverTiming)
+{
+    uint64_t threshold;
+    if (sampleRate <= 0)
+        threshold = 0;
+    else if (sampleRate >= 1)
+        threshold = (std::numeric_limits<uint64_t>::max)();
+    else
+        threshold = static_cast<uint64_t>(
+            sampleRate *
+            static_cast<double>((std::numeric_limits<uint64_t>::max)()));
+    threshold_.store(threshold, std::memory_order_relaxed);
+    serverTiming_.store(serverTiming, std::memory_order_relaxed);
+}
+
+std::string PhaseTracing::serverTimingValue(const RequestPhases &phases)
+{
+    std::string value;
+    char buffer[64];
+    for (size_t i = 1; i < RequestPhases::kCount; ++i)
+    {
+        auto phase = static_cast<RequestPhase>(i);
+        auto seconds = phases.seconds(phase);
+        if (seconds < 0)
+            continue;
+        auto len = snprintf(buffer,
+                            sizeof(buffer),
+                            "%s%s;dur=%.3f",
+                            value.empty() ? "" : ", ",
+                            RequestPhases::name(phase),
+                            seconds * 1000);
+        value.append(buffer, static_cast<size_t>(len));
+    }
+    return value;
+}
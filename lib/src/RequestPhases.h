@@ -0,0 +1,130 @@
+/**
+ *
+ *  @file RequestPhases.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief The points a request passes on its way through the server, in
+ * order. A phase is named by the point it ends at and lasts from the
+ * previous point which was reached, e.g. the static files have no kRouted
+ * point, so their kHandling phase counts the routing too.
+ */
+enum class RequestPhase : uint8_t
+{
+    /// The method of the request is received
+    kReceived = 0,
+    /// The request is complete, "parse"
+    kParsed,
+    /// The router is called, "pre_route": the sync advices, the session
+    /// loading and the pre-routing advices
+    kRouting,
+    /// The router found the handler, "route"
+    kRouted,
+    /// The request is passed to its handler, "middleware": the post-routing
+    /// advices, the middlewares and the pre-handling advices
+    kHandling,
+    /// The handler answered, "handler"
+    kHandled,
+    /// The response is being sent, "post_handle": the post-handling advices
+    /// and the session cookie
+    kSending,
+    /// The response is going to be compressed, "pre_send": the pre-sending
+    /// advices, e.g. the access log
+    kCompressing,
+    /// The response is compressed and passed to the connection, "compress"
+    kCompressed,
+    kCount
+};
+
+/**
+ * @brief The times of the phases of a sampled request, in nanoseconds of the
+ * steady clock, 0 for the points not reached.
+ */
+struct RequestPhases
+{
+    static constexpr size_t kCount = static_cast<size_t>(RequestPhase::kCount);
+
+    std::array<int64_t, kCount> stamps{};
+
+    void stamp(RequestPhase phase)
+    {
+        stamps[static_cast<size_t>(phase)] =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    /**
+     * @brief The duration of the phase ending at the point in seconds, -1 if
+     * the point wasn't reached.
+     */
+    double seconds(RequestPhase phase) const;
+
+    /// The name of the phase ending at the point, e.g. "route"
+    static const char *name(RequestPhase phase);
+};
+
+/**
+ * @brief The settings of the phase tracing, see
+ * HttpAppFramework::setPhaseTracing().
+ *
+ * Only the sampled requests record their phases, the others pay one relaxed
+ * load when their method is parsed.
+ */
+class DROGON_EXPORT PhaseTracing
+{
+  public:
+    static void configure(double sampleRate, bool serverTiming);
+
+    static bool shouldSample()
+    {
+        auto threshold = threshold_.load(std::memory_order_relaxed);
+        if (threshold == 0)
+            return false;
+        // xorshift64, good enough to pick the requests
+        thread_local uint64_t state =
+            0x9e3779b97f4a7c15ULL ^
+            reinterpret_cast<uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state <= threshold;
+    }
+
+    static bool serverTiming()
+    {
+        return serverTiming_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief The value of the Server-Timing header, e.g.
+     * "parse;dur=0.012, route;dur=0.003" with the durations in milliseconds.
+     */
+    static std::string serverTimingValue(const RequestPhases &phases);
+
+  private:
+    // A request is sampled if a random 64 bits number is not greater, 0
+    // disables the tracing
+    static std::atomic<uint64_t> threshold_;
+    static std::atomic<bool> serverTiming_;
+};
+}  // namespace drogon
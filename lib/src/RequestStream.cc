@@ -14,9 +14,21 @@
 
 #include "MultipartStreamParser.h"
 #include "HttpRequestImpl.h"
+#include "JsonSaxParser.h"
+#include "StreamDecompressor.h"
 
 #include <drogon/RequestStream.h>
+#include <drogon/utils/Utilities.h>
+#include <filesystem>
+#include <optional>
 #include <variant>
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace drogon
 {
@@ -196,6 +208,483 @@ class MultipartStreamReader : public RequestStreamReader
     StreamFinishCallback finishCb_;
 };
 
+/**
+ * Fail the stream once the data exceeds a size
+ */
+class SizeLimitReader : public RequestStreamReader
+{
+  public:
+    SizeLimitReader(size_t maxSize, RequestStreamReaderPtr next)
+        : maxSize_(maxSize), next_(std::move(next))
+    {
+    }
+
+    void onStreamData(const char *data, size_t length) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        size_ += length;
+        if (size_ > maxSize_)
+        {
+            done_ = true;
+            next_->onStreamFinish(std::make_exception_ptr(
+                StreamError(StreamErrorCode::kBadRequest,
+                            "request body too large")));
+            return;
+        }
+        next_->onStreamData(data, length);
+    }
+
+    void onStreamFinish(std::exception_ptr ex) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        done_ = true;
+        next_->onStreamFinish(std::move(ex));
+    }
+
+  private:
+    size_t maxSize_;
+    size_t size_{0};
+    RequestStreamReaderPtr next_;
+    bool done_{false};
+};
+
+/**
+ * Inflate the data according to its content coding
+ */
+class DecompressReader : public RequestStreamReader
+{
+  public:
+    DecompressReader(std::unique_ptr<StreamDecompressor> decompressor,
+                     RequestStreamReaderPtr next)
+        : decompressor_(std::move(decompressor)), next_(std::move(next))
+    {
+    }
+
+    void onStreamData(const char *data, size_t length) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        if (!decompressor_)
+        {
+            fail("unsupported content encoding");
+            return;
+        }
+        // The next reader may fail the stream while it is being fed.
+        auto ok = decompressor_->decompress(data,
+                                            length,
+                                            [this](const char *out,
+                                                   size_t outLength) {
+                                                next_->onStreamData(out,
+                                                                    outLength);
+                                                return !done_;
+                                            });
+        if (!ok && !done_)
+        {
+            fail("invalid compressed data");
+        }
+    }
+
+    void onStreamFinish(std::exception_ptr ex) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        if (!ex && (!decompressor_ || !decompressor_->finished()))
+        {
+            fail("incomplete compressed data");
+            return;
+        }
+        done_ = true;
+        next_->onStreamFinish(std::move(ex));
+    }
+
+  private:
+    void fail(const char *reason)
+    {
+        done_ = true;
+        next_->onStreamFinish(std::make_exception_ptr(
+            StreamError(StreamErrorCode::kBadRequest, reason)));
+    }
+
+    std::unique_ptr<StreamDecompressor> decompressor_;
+    RequestStreamReaderPtr next_;
+    bool done_{false};
+};
+
+/**
+ * Compute the digest of the data on its way to the next reader
+ */
+class DigestReader : public RequestStreamReader
+{
+  public:
+    DigestReader(StreamDigest algorithm,
+                 DigestCallback digestCb,
+                 RequestStreamReaderPtr next)
+        : hasher_(algorithm),
+          digestCb_(std::move(digestCb)),
+          next_(std::move(next))
+    {
+    }
+
+    void onStreamData(const char *data, size_t length) override
+    {
+        hasher_.update(data, length);
+        next_->onStreamData(data, length);
+    }
+
+    void onStreamFinish(std::exception_ptr ex) override
+    {
+        if (!ex && digestCb_)
+        {
+            digestCb_(hasher_.hexDigest());
+        }
+        next_->onStreamFinish(std::move(ex));
+    }
+
+  private:
+    utils::Hasher hasher_;
+    DigestCallback digestCb_;
+    RequestStreamReaderPtr next_;
+};
+
+/**
+ * Parse a JSON document incrementally
+ */
+class JsonStreamReader : public RequestStreamReader
+{
+  public:
+    JsonStreamReader(std::shared_ptr<JsonSaxHandler> handler,
+                     StreamFinishCallback finishCb,
+                     size_t maxDepth)
+        : handler_(std::move(handler)),
+          parser_(*handler_, maxDepth),
+          finishCb_(std::move(finishCb))
+    {
+    }
+
+    void onStreamData(const char *data, size_t length) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        if (!parser_.parse(data, length))
+        {
+            fail();
+        }
+    }
+
+    void onStreamFinish(std::exception_ptr ex) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        if (ex)
+        {
+            done_ = true;
+            finishCb_(std::move(ex));
+        }
+        else if (!parser_.finish())
+        {
+            fail();
+        }
+        else
+        {
+            done_ = true;
+            finishCb_({});
+        }
+    }
+
+  private:
+    void fail()
+    {
+        done_ = true;
+        finishCb_(std::make_exception_ptr(
+            StreamError(StreamErrorCode::kBadRequest,
+                        "invalid JSON: " + parser_.error())));
+    }
+
+    std::shared_ptr<JsonSaxHandler> handler_;
+    JsonSaxParser parser_;
+    StreamFinishCallback finishCb_;
+    bool done_{false};
+};
+
+/**
+ * A file written sequentially, with pwrite() where it is available
+ */
+class UploadFile
+{
+  public:
+    ~UploadFile()
+    {
+        close();
+    }
+
+    bool open(const std::filesystem::path &path)
+    {
+#ifdef _WIN32
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        return file_.is_open();
+#else
+        fd_ = ::open(path.c_str(),
+                     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                     0644);
+        offset_ = 0;
+        return fd_ >= 0;
+#endif
+    }
+
+    bool write(const char *data, size_t length)
+    {
+#ifdef _WIN32
+        file_.write(data, static_cast<std::streamsize>(length));
+        return file_.good();
+#else
+        while (length > 0)
+        {
+            auto n = ::pwrite(fd_, data, length, offset_);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += n;
+            length -= static_cast<size_t>(n);
+            offset_ += n;
+        }
+        return true;
+#endif
+    }
+
+    bool close()
+    {
+#ifdef _WIN32
+        if (!file_.is_open())
+            return true;
+        file_.close();
+        return !file_.fail();
+#else
+        if (fd_ < 0)
+            return true;
+        auto ret = ::close(fd_);
+        fd_ = -1;
+        return ret == 0;
+#endif
+    }
+
+  private:
+#ifdef _WIN32
+    std::ofstream file_;
+#else
+    int fd_{-1};
+    off_t offset_{0};
+#endif
+};
+
+/**
+ * Parse multipart data and write the files to their destinations
+ */
+class UploadStreamReader : public RequestStreamReader
+{
+  public:
+    UploadStreamReader(const std::string &contentType,
+                       UploadOptions options,
+                       UploadFinishCallback finishCb)
+        : parser_(contentType),
+          options_(std::move(options)),
+          finishCb_(std::move(finishCb)),
+          headerCb_([this](MultipartHeader header) {
+              onPartHeader(std::move(header));
+          }),
+          dataCb_([this](const char *data, size_t length) {
+              onPartData(data, length);
+          })
+    {
+    }
+
+    ~UploadStreamReader() override
+    {
+        if (!done_)
+            removeFiles();
+    }
+
+    void onStreamData(const char *data, size_t length) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        parser_.parse(data, length, headerCb_, dataCb_);
+        if (error_)
+        {
+            fail(error_);
+        }
+        else if (!parser_.isValid())
+        {
+            fail(std::make_exception_ptr(
+                std::runtime_error("invalid multipart data")));
+        }
+        else if (parser_.isFinished())
+        {
+            done_ = true;
+            finishCb_({}, std::move(parts_));
+        }
+    }
+
+    void onStreamFinish(std::exception_ptr ex) override
+    {
+        if (done_)
+        {
+            return;
+        }
+        if (!ex)
+        {
+            ex = std::make_exception_ptr(
+                std::runtime_error("incomplete multipart data"));
+        }
+        fail(std::move(ex));
+    }
+
+  private:
+    void onPartHeader(MultipartHeader header)
+    {
+        if (error_)
+            return;
+        current_ = UploadedPart{};
+        current_.header = std::move(header);
+        discarded_ = false;
+        if (current_.header.filename.empty())
+            return;
+        if (options_.pathOf)
+            current_.path = options_.pathOf(current_.header);
+        if (current_.path.empty())
+        {
+            discarded_ = true;
+            return;
+        }
+        std::filesystem::path fsPath(utils::toNativePath(current_.path));
+        std::error_code err;
+        if (fsPath.has_parent_path())
+            std::filesystem::create_directories(fsPath.parent_path(), err);
+        if (!file_.open(fsPath))
+        {
+            error_ = std::make_exception_ptr(
+                std::runtime_error("cannot open " + current_.path));
+            return;
+        }
+        writtenPaths_.push_back(std::move(fsPath));
+        if (options_.computeMd5)
+            md5_.emplace(utils::HashAlgorithm::kMd5);
+        if (options_.computeSha256)
+            sha256_.emplace(utils::HashAlgorithm::kSha256);
+    }
+
+    void onPartData(const char *data, size_t length)
+    {
+        if (error_ || discarded_)
+            return;
+        // The end of a part is notified with an empty piece of data.
+        if (length == 0)
+        {
+            finishPart();
+            return;
+        }
+        current_.size += length;
+        if (current_.path.empty())
+        {
+            if (current_.size > options_.maxFieldSize)
+            {
+                error_ = std::make_exception_ptr(
+                    std::runtime_error("form field too large"));
+                return;
+            }
+            current_.value.append(data, length);
+            return;
+        }
+        if (options_.maxFileSize > 0 && current_.size > options_.maxFileSize)
+        {
+            error_ =
+                std::make_exception_ptr(std::runtime_error("file too large"));
+            return;
+        }
+        if (!file_.write(data, length))
+        {
+            error_ = std::make_exception_ptr(
+                std::runtime_error("cannot write " + current_.path));
+            return;
+        }
+        if (md5_)
+            md5_->update(data, length);
+        if (sha256_)
+            sha256_->update(data, length);
+    }
+
+    void finishPart()
+    {
+        if (!current_.path.empty())
+        {
+            if (!file_.close())
+            {
+                error_ = std::make_exception_ptr(
+                    std::runtime_error("cannot write " + current_.path));
+                return;
+            }
+            if (md5_)
+                current_.md5 = md5_->hexDigest();
+            if (sha256_)
+                current_.sha256 = sha256_->hexDigest();
+            md5_.reset();
+            sha256_.reset();
+        }
+        parts_.push_back(std::move(current_));
+        current_ = UploadedPart{};
+    }
+
+    void fail(std::exception_ptr ex)
+    {
+        done_ = true;
+        removeFiles();
+        parts_.clear();
+        finishCb_(std::move(ex), {});
+    }
+
+    void removeFiles()
+    {
+        file_.close();
+        std::error_code err;
+        for (auto &path : writtenPaths_)
+            std::filesystem::remove(path, err);
+        writtenPaths_.clear();
+    }
+
+    MultipartStreamParser parser_;
+    UploadOptions options_;
+    UploadFinishCallback finishCb_;
+    MultipartHeaderCallback headerCb_;
+    StreamDataCallback dataCb_;
+    UploadedPart current_;
+    bool discarded_{false};
+    UploadFile file_;
+    std::optional<utils::Hasher> md5_;
+    std::optional<utils::Hasher> sha256_;
+    std::vector<UploadedPart> parts_;
+    std::vector<std::filesystem::path> writtenPaths_;
+    std::exception_ptr error_;
+    bool done_{false};
+};
+
 RequestStreamReaderPtr RequestStreamReader::newReader(
     StreamDataCallback dataCb,
     StreamFinishCallback finishCb)
@@ -222,4 +711,54 @@ RequestStreamReaderPtr RequestStreamReader::newMultipartReader(
                                                    std::move(finishCb));
 }
 
+RequestStreamReaderPtr RequestStreamReader::newSizeLimiter(
+    size_t maxSize,
+    RequestStreamReaderPtr next)
+{
+    return std::make_shared<SizeLimitReader>(maxSize, std::move(next));
+}
+
+RequestStreamReaderPtr RequestStreamReader::newDecompressor(
+    const HttpRequestPtr &req,
+    RequestStreamReaderPtr next)
+{
+    auto &encoding = req->getHeader("content-encoding");
+    if (encoding.empty() || encoding == "identity")
+    {
+        return next;
+    }
+    return std::make_shared<DecompressReader>(
+        StreamDecompressor::newDecompressor(encoding), std::move(next));
+}
+
+RequestStreamReaderPtr RequestStreamReader::newDigestReader(
+    StreamDigest algorithm,
+    DigestCallback digestCb,
+    RequestStreamReaderPtr next)
+{
+    return std::make_shared<DigestReader>(algorithm,
+                                          std::move(digestCb),
+                                          std::move(next));
+}
+
+RequestStreamReaderPtr RequestStreamReader::newJsonReader(
+    std::shared_ptr<JsonSaxHandler> handler,
+    StreamFinishCallback finishCb,
+    size_t maxDepth)
+{
+    return std::make_shared<JsonStreamReader>(std::move(handler),
+                                              std::move(finishCb),
+                                              maxDepth);
+}
+
+RequestStreamReaderPtr RequestStreamReader::newUploadReader(
+    const HttpRequestPtr &req,
+    UploadOptions options,
+    UploadFinishCallback finishCb)
+{
+    return std::make_shared<UploadStreamReader>(req->getHeader("content-type"),
+                                                std::move(options),
+                                                std::move(finishCb));
+}
+
 }  // namespace drogon
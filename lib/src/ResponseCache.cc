@@ -0,0 +1,715 @@
+/**
+ *  @file ResponseCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/ResponseCache.h>
+#include <drogon/nosql/RedisClient.h>
+#include "BuiltinMetrics.h"
+#include "CompressedBodyCache.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include "HttpUtils.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+namespace
+{
+const char *const kLeaderKey = "drogon.responseCache";
+// The first bytes of an entry stored in redis, changed with the format
+const std::string_view kMagic{"DRC1"};
+// The first byte of the keys of the requests with credentials, which are
+// kept apart from the others. A path never starts with it.
+constexpr char kCredentialsMark = '\x01';
+
+// Report the changes of the bytes of the caches to the memory gauge
+void accountBytes(double delta)
+{
+    BuiltinMetrics::instance().memory(
+        BuiltinMetrics::MemoryUser::kResponseCache, delta);
+}
+
+int64_t nowMicroseconds()
+{
+    return trantor::Date::now().microSecondsSinceEpoch();
+}
+
+void appendInteger(std::string &buffer, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void appendString(std::string &buffer, std::string_view str)
+{
+    appendInteger(buffer, str.length(), 4);
+    buffer.append(str.data(), str.length());
+}
+
+/// Reads the fields written by appendInteger() and appendString()
+class EntryReader
+{
+  public:
+    explicit EntryReader(std::string_view data) : data_(data)
+    {
+    }
+
+    bool readInteger(uint64_t &value, size_t bytes)
+    {
+        if (data_.length() < bytes)
+            return false;
+        value = 0;
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data_[i]))
+                     << (8 * i);
+        }
+        data_.remove_prefix(bytes);
+        return true;
+    }
+
+    bool readString(std::string_view &str)
+    {
+        uint64_t length;
+        if (!readInteger(length, 4) || data_.length() < length)
+            return false;
+        str = data_.substr(0, length);
+        data_.remove_prefix(length);
+        return true;
+    }
+
+    std::string_view rest() const
+    {
+        return data_;
+    }
+
+  private:
+    std::string_view data_;
+};
+
+// Set by the framework or meaningless for another response
+bool isSkippedHeader(const std::string &field)
+{
+    return field == "content-length" || field == "content-type" ||
+           field == "date" || field == "server" || field == "connection" ||
+           field == "transfer-encoding";
+}
+
+// Whether the responses varying on the fields listed by Vary can share an
+// entry: every field must be part of the key, except accept-encoding which
+// is handled by the compressed variants of the entry
+bool isVaryKeyed(std::string_view vary, const std::vector<std::string> &keyed)
+{
+    while (!vary.empty())
+    {
+        auto comma = vary.find(',');
+        auto name = vary.substr(0, comma);
+        vary = comma == std::string_view::npos ? std::string_view{}
+                                               : vary.substr(comma + 1);
+        while (!name.empty() && (name.front() == ' ' || name.front() == '\t'))
+            name.remove_prefix(1);
+        while (!name.empty() && (name.back() == ' ' || name.back() == '\t'))
+            name.remove_suffix(1);
+        if (name.empty())
+            continue;
+        if (name == "*")
+            return false;
+        std::string lower(name);
+        std::transform(lower.begin(),
+                       lower.end(),
+                       lower.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (lower != "accept-encoding" &&
+            std::find(keyed.begin(), keyed.end(), lower) == keyed.end())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+class ResponseCache::Leader
+{
+  public:
+    Leader(ResponseCache *cache, std::string key)
+        : cache_(cache), key_(std::move(key))
+    {
+    }
+
+    const std::string &key() const
+    {
+        return key_;
+    }
+
+    /// The request is handled, its response is cached if possible
+    void finish(const HttpResponsePtr &resp)
+    {
+        if (finished_.exchange(true))
+            return;
+        cache_->onResponse(key_, resp);
+    }
+
+    /// The response was found in redis
+    void finish(const EntryPtr &entry)
+    {
+        if (finished_.exchange(true))
+            return;
+        cache_->land(key_, entry);
+    }
+
+    /// The request was rejected by another advice or dropped, the waiters
+    /// are handled by themselves
+    ~Leader()
+    {
+        if (!finished_)
+            cache_->land(key_, nullptr);
+    }
+
+  private:
+    ResponseCache *cache_;
+    std::string key_;
+    std::atomic<bool> finished_{false};
+};
+
+static std::string encodeEntry(const std::string &key,
+                               const HttpResponsePtr &resp,
+                               int64_t storedAt)
+{
+    auto body = resp->getBody();
+    std::string buffer;
+    buffer.reserve(body.length() + key.length() + 256);
+    buffer.append(kMagic.data(), kMagic.length());
+    appendInteger(buffer, static_cast<uint64_t>(storedAt), 8);
+    appendInteger(buffer, static_cast<uint64_t>(resp->statusCode()), 2);
+    appendInteger(buffer, static_cast<uint64_t>(resp->contentType()), 2);
+    appendString(buffer, resp->contentTypeString());
+    auto &headers = resp->getHeaders();
+    size_t count = 0;
+    for (auto &header : headers)
+    {
+        if (!isSkippedHeader(header.first))
+            ++count;
+    }
+    appendInteger(buffer, count, 4);
+    for (auto &header : headers)
+    {
+        if (isSkippedHeader(header.first))
+            continue;
+        appendString(buffer, header.first);
+        appendString(buffer, header.second);
+    }
+    buffer.append(body.data(), body.length());
+    return buffer;
+}
+
+void ResponseCache::initAndStart(const Json::Value &config)
+{
+    ttl_ = static_cast<int64_t>(config.get("ttl", 60).asDouble() * 1000000);
+    staleWhileRevalidate_ = static_cast<int64_t>(
+        config.get("stale_while_revalidate", 30).asDouble() * 1000000);
+    if (ttl_ <= 0 || staleWhileRevalidate_ < 0)
+    {
+        throw std::runtime_error(
+            "The ttl of ResponseCache must be positive and its "
+            "stale_while_revalidate can't be negative");
+    }
+    keyQuery_ = config.get("key_query", true).asBool();
+    for (auto &header : config["key_headers"])
+    {
+        auto field = header.asString();
+        std::transform(field.begin(),
+                       field.end(),
+                       field.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        keyHeaders_.push_back(std::move(field));
+    }
+    if (config.isMember("status_codes") && config["status_codes"].isArray())
+    {
+        for (auto &code : config["status_codes"])
+        {
+            statusCodes_.push_back(code.asInt());
+        }
+    }
+    else
+    {
+        statusCodes_.push_back(k200OK);
+    }
+    maxBytes_ = config.get("local_max_bytes", 64 * 1024 * 1024).asUInt64();
+    maxBodySize_ = config.get("max_body_size", 1024 * 1024).asUInt64();
+    redisClientName_ = config.get("redis_client", "").asString();
+    redisKeyPrefix_ =
+        config.get("redis_key_prefix", "drogon:response:").asString();
+
+    if (config.isMember("urls") && config["urls"].isArray())
+    {
+        std::string regexString;
+        for (auto &str : config["urls"])
+        {
+            assert(str.isString());
+            regexString.append("(").append(str.asString()).append(")|");
+        }
+        if (!regexString.empty())
+        {
+            regexString.resize(regexString.length() - 1);
+            urlsRegex_ = std::regex(regexString);
+            regexFlag_ = true;
+        }
+    }
+
+    app().registerPreHandlingAdvice(
+        [this](const HttpRequestPtr &req,
+               AdviceCallback &&adviceCallback,
+               AdviceChainCallback &&chainCallback) {
+            auto method = req->method();
+            if ((method != Get && method != Head) ||
+                (regexFlag_ && !std::regex_match(req->path(), urlsRegex_)) ||
+                req->attributes()->find(kLeaderKey))
+            {
+                // A request refreshing an entry has the leader attribute
+                chainCallback();
+                return;
+            }
+            lookup(req,
+                   cacheKey(req),
+                   std::move(adviceCallback),
+                   std::move(chainCallback));
+        });
+    app().registerPostHandlingAdvice(
+        [](const HttpRequestPtr &req, const HttpResponsePtr &resp) {
+            auto &attributes = req->attributes();
+            if (!attributes->find(kLeaderKey))
+                return;
+            auto &leader =
+                attributes->get<std::shared_ptr<Leader>>(kLeaderKey);
+            if (leader)
+                leader->finish(resp);
+        });
+}
+
+void ResponseCache::shutdown()
+{
+    LOG_TRACE << "ResponseCache plugin is shutdown!";
+}
+
+std::string ResponseCache::cacheKey(const HttpRequestPtr &req) const
+{
+    std::string key;
+    // The response to a request with credentials may be personalized, it is
+    // neither served to nor taken from the other clients
+    if (!req->getHeader("authorization").empty() || !req->getCookies().empty())
+        key.push_back(kCredentialsMark);
+    // The virtual hosts served by the application don't share their pages,
+    // a host never contains the slash starting the path
+    key.append(req->getHeader("host")).append(req->path());
+    if (keyQuery_ && !req->query().empty())
+    {
+        key.append(1, '?').append(req->query());
+    }
+    for (auto &field : keyHeaders_)
+    {
+        key.append(1, '\n').append(req->getHeader(field));
+    }
+    return key;
+}
+
+void ResponseCache::invalidate(const std::string &key)
+{
+    // The entry of the requests with credentials goes with the other one
+    if (!key.empty() && key[0] != kCredentialsMark)
+        invalidate(kCredentialsMark + key);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = index_.find(key);
+        if (iter != index_.end())
+        {
+            bytes_ -= (*iter->second)->bytes;
+            accountBytes(-static_cast<double>((*iter->second)->bytes));
+            entries_.erase(iter->second);
+            index_.erase(iter);
+        }
+    }
+    if (redisClientName_.empty())
+        return;
+    auto client = app().getRedisClient(redisClientName_);
+    if (!client)
+        return;
+    client->execArgsAsync([](const nosql::RedisResult &) {},
+                          [](const nosql::RedisException &err) {
+                              LOG_ERROR << "ResponseCache: " << err.what();
+                          },
+                          "DEL",
+                          redisKeyPrefix_ + key);
+}
+
+void ResponseCache::lookup(const HttpRequestPtr &req,
+                           std::string &&key,
+                           AdviceCallback &&adviceCallback,
+                           AdviceChainCallback &&chainCallback)
+{
+    auto now = nowMicroseconds();
+    EntryPtr entry;
+    bool refresh{false};
+    bool lead{false};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = index_.find(key);
+        if (iter != index_.end())
+        {
+            auto &cached = *iter->second;
+            if (isUsable(*cached, now))
+            {
+                entries_.splice(entries_.begin(), entries_, iter->second);
+                entry = cached;
+                // Only one request refreshes a stale entry
+                refresh = !isFresh(*entry, now) && req->method() == Get &&
+                          flights_.emplace(key, std::vector<Waiter>{}).second;
+            }
+            else
+            {
+                bytes_ -= cached->bytes;
+                accountBytes(-static_cast<double>(cached->bytes));
+                entries_.erase(iter->second);
+                index_.erase(iter);
+            }
+        }
+        if (!entry && req->method() == Get)
+        {
+            auto flight = flights_.find(key);
+            if (flight != flights_.end())
+            {
+                flight->second.push_back({req,
+                                          std::move(adviceCallback),
+                                          std::move(chainCallback)});
+                return;
+            }
+            flights_.emplace(key, std::vector<Waiter>{});
+            lead = true;
+        }
+    }
+    if (entry)
+    {
+        adviceCallback(responseOf(req, entry));
+        if (refresh)
+            revalidate(req, key);
+        return;
+    }
+    if (!lead)
+    {
+        chainCallback();
+        return;
+    }
+    auto leader = std::make_shared<Leader>(this, std::move(key));
+    req->attributes()->insert(kLeaderKey, leader);
+    fetch(req, leader, std::move(adviceCallback), std::move(chainCallback));
+}
+
+void ResponseCache::fetch(const HttpRequestPtr &req,
+                          const std::shared_ptr<Leader> &leader,
+                          AdviceCallback &&adviceCallback,
+                          AdviceChainCallback &&chainCallback)
+{
+    nosql::RedisClientPtr client;
+    if (!redisClientName_.empty())
+        client = app().getRedisClient(redisClientName_);
+    if (!client)
+    {
+        chainCallback();
+        return;
+    }
+    client->execArgsAsync(
+        [this,
+         req,
+         leader,
+         adviceCallback = std::move(adviceCallback),
+         chainCallback](const nosql::RedisResult &result) {
+            EntryPtr entry;
+            if (result.type() == nosql::RedisResultType::kString)
+            {
+                entry = decodeEntry(leader->key(), result.asString());
+            }
+            auto now = nowMicroseconds();
+            if (!entry || !isUsable(*entry, now))
+            {
+                chainCallback();
+                return;
+            }
+            store(entry);
+            leader->finish(entry);
+            adviceCallback(responseOf(req, entry));
+            if (isFresh(*entry, now))
+                return;
+            bool refresh;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                refresh =
+                    flights_.emplace(entry->key, std::vector<Waiter>{}).second;
+            }
+            if (refresh)
+                revalidate(req, entry->key);
+        },
+        [chainCallback](const nosql::RedisException &err) {
+            LOG_ERROR << "ResponseCache: " << err.what();
+            chainCallback();
+        },
+        "GET",
+        redisKeyPrefix_ + leader->key());
+}
+
+void ResponseCache::revalidate(const HttpRequestPtr &req,
+                               const std::string &key)
+{
+    // The refreshing request is handled while the stale response is sent, a
+    // new request keeps them apart. Without the cookies and the
+    // authorization, the response can't depend on the client.
+    auto origin = static_cast<HttpRequestImpl *>(req.get());
+    auto refreshReq = std::make_shared<HttpRequestImpl>(origin->getLoop());
+    refreshReq->setMethod(Get);
+    refreshReq->setVersion(Version::kHttp11);
+    refreshReq->setPath(origin->path());
+    refreshReq->setQuery(origin->query());
+    refreshReq->setPeerAddr(origin->peerAddr());
+    refreshReq->setLocalAddr(origin->localAddr());
+    for (auto &header : origin->getHeaders())
+    {
+        if (header.first != "cookie" && header.first != "authorization")
+            refreshReq->addHeader(header.first, header.second);
+    }
+    refreshReq->attributes()->insert(kLeaderKey,
+                                     std::make_shared<Leader>(this, key));
+    LOG_TRACE << "ResponseCache: refresh " << key;
+    app().forward(refreshReq, [](const HttpResponsePtr &) {});
+}
+
+void ResponseCache::onResponse(const std::string &key,
+                               const HttpResponsePtr &resp)
+{
+    auto entry = makeEntry(key, resp);
+    if (entry)
+    {
+        store(entry);
+        nosql::RedisClientPtr client;
+        if (!redisClientName_.empty())
+            client = app().getRedisClient(redisClientName_);
+        if (client)
+        {
+            client->execArgsAsync(
+                [](const nosql::RedisResult &) {},
+                [](const nosql::RedisException &err) {
+                    LOG_ERROR << "ResponseCache: " << err.what();
+                },
+                "SET",
+                redisKeyPrefix_ + key,
+                encodeEntry(key, entry->response, entry->storedAt),
+                "PX",
+                (std::max)(static_cast<int64_t>(1),
+                           (ttl_ + staleWhileRevalidate_ + 999) / 1000));
+        }
+    }
+    land(key, entry);
+}
+
+void ResponseCache::land(const std::string &key, const EntryPtr &entry)
+{
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = flights_.find(key);
+        if (iter == flights_.end())
+            return;
+        waiters = std::move(iter->second);
+        flights_.erase(iter);
+    }
+    for (auto &waiter : waiters)
+    {
+        if (entry)
+            waiter.adviceCallback(responseOf(waiter.req, entry));
+        else
+            waiter.chainCallback();
+    }
+}
+
+ResponseCache::EntryPtr ResponseCache::makeEntry(
+    const std::string &key,
+    const HttpResponsePtr &resp) const
+{
+    if (!resp ||
+        std::find(statusCodes_.begin(),
+                  statusCodes_.end(),
+                  static_cast<int>(resp->statusCode())) == statusCodes_.end())
+    {
+        return nullptr;
+    }
+    auto respImpl = static_cast<HttpResponseImpl *>(resp.get());
+    if (!respImpl->sendfileName().empty() || respImpl->streamCallback() ||
+        respImpl->asyncStreamCallback() ||
+        resp->getBody().length() > maxBodySize_ ||
+        !resp->getCookies().empty() ||
+        !respImpl->getHeaderBy("set-cookie").empty())
+    {
+        return nullptr;
+    }
+    auto &cacheControl = respImpl->getHeaderBy("cache-control");
+    if (cacheControl.find("no-store") != std::string::npos ||
+        cacheControl.find("private") != std::string::npos)
+    {
+        return nullptr;
+    }
+    // One entry holds one variant, a response varying on a field out of the
+    // key would be served to the requests with other values
+    if (!isVaryKeyed(respImpl->getHeaderBy("vary"), keyHeaders_))
+        return nullptr;
+    // A response to a request with credentials is shared only if it says it
+    // may be (RFC 9111 3.5)
+    if (!key.empty() && key[0] == kCredentialsMark &&
+        cacheControl.find("public") == std::string::npos)
+    {
+        return nullptr;
+    }
+    auto prototype = std::make_shared<HttpResponseImpl>(*respImpl);
+    prototype->setExpiredTime(-1);
+    return makeEntry(key, prototype, nowMicroseconds());
+}
+
+ResponseCache::EntryPtr ResponseCache::makeEntry(
+    const std::string &key,
+    const std::shared_ptr<HttpResponseImpl> &prototype,
+    int64_t storedAt)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->compressible = prototype->shouldBeCompressed();
+    entry->storedAt = storedAt;
+    entry->bytes = key.length() + prototype->getBody().length() + 256;
+    for (auto &header : prototype->getHeaders())
+    {
+        entry->bytes += header.first.length() + header.second.length();
+    }
+    entry->response = prototype;
+    return entry;
+}
+
+ResponseCache::EntryPtr ResponseCache::decodeEntry(const std::string &key,
+                                                   std::string_view data)
+{
+    if (data.substr(0, kMagic.length()) != kMagic)
+        return nullptr;
+    EntryReader reader(data.substr(kMagic.length()));
+    uint64_t storedAt, statusCode, contentType, count;
+    std::string_view contentTypeString;
+    if (!reader.readInteger(storedAt, 8) ||
+        !reader.readInteger(statusCode, 2) ||
+        !reader.readInteger(contentType, 2) ||
+        !reader.readString(contentTypeString) ||
+        !reader.readInteger(count, 4))
+    {
+        return nullptr;
+    }
+    auto prototype = std::make_shared<HttpResponseImpl>();
+    prototype->setStatusCode(static_cast<HttpStatusCode>(statusCode));
+    prototype->setContentTypeCodeAndCustomString(
+        static_cast<ContentType>(contentType),
+        contentTypeString.data(),
+        contentTypeString.length());
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        std::string_view field, value;
+        if (!reader.readString(field) || !reader.readString(value))
+            return nullptr;
+        prototype->addHeader(std::string{field}, std::string{value});
+    }
+    prototype->setBody(std::string{reader.rest()});
+    return makeEntry(key, prototype, static_cast<int64_t>(storedAt));
+}
+
+void ResponseCache::store(const EntryPtr &entry)
+{
+    if (entry->bytes > maxBytes_)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = index_.find(entry->key);
+    if (iter != index_.end())
+    {
+        bytes_ -= (*iter->second)->bytes;
+        accountBytes(-static_cast<double>((*iter->second)->bytes));
+        entries_.erase(iter->second);
+        index_.erase(iter);
+    }
+    entries_.push_front(entry);
+    index_.emplace(entry->key, entries_.begin());
+    bytes_ += entry->bytes;
+    accountBytes(static_cast<double>(entry->bytes));
+    while (bytes_ > maxBytes_)
+    {
+        auto &last = entries_.back();
+        bytes_ -= last->bytes;
+        accountBytes(-static_cast<double>(last->bytes));
+        index_.erase(last->key);
+        entries_.pop_back();
+    }
+}
+
+HttpResponsePtr ResponseCache::responseOf(const HttpRequestPtr &req,
+                                          const EntryPtr &entry)
+{
+    auto encoding = ContentEncoding::kNone;
+    if (entry->compressible && req->method() != Head)
+    {
+        encoding = getResponseEncoding(req->getHeader("accept-encoding"));
+    }
+    HttpResponsePtr prototype;
+    if (encoding != ContentEncoding::kNone)
+    {
+        auto index = static_cast<size_t>(encoding);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            prototype = entry->variants[index];
+        }
+        if (!prototype)
+        {
+            auto body = entry->response->getBody();
+            auto compressed = CompressedBodyCache::instance().compress(
+                encoding, body.data(), body.length());
+            if (compressed)
+            {
+                auto variant = std::make_shared<HttpResponseImpl>(
+                    *static_cast<HttpResponseImpl *>(entry->response.get()));
+                auto size = compressed->length();
+                variant->setSharedBody(std::move(compressed));
+                variant->addHeader("content-encoding",
+                                   contentEncodingName(encoding));
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!entry->variants[index])
+                {
+                    entry->variants[index] = variant;
+                    // Only counted if the entry is still in the cache
+                    auto iter = index_.find(entry->key);
+                    if (iter != index_.end() && *iter->second == entry)
+                    {
+                        entry->bytes += size;
+                        bytes_ += size;
+                        accountBytes(static_cast<double>(size));
+                    }
+                }
+                prototype = entry->variants[index];
+            }
+        }
+    }
+    if (!prototype)
+        prototype = entry->response;
+    // Every response gets its own copy, the body is shared
+    return std::make_shared<HttpResponseImpl>(
+        *static_cast<HttpResponseImpl *>(prototype.get()));
+}
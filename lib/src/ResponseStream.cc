@@ -0,0 +1,213 @@
+/**
+ *
+ *  @file ResponseStream.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/HttpResponse.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <vector>
+
+using namespace drogon;
+
+struct ResponseStream::FlowState
+{
+    explicit FlowState(const trantor::TcpConnectionPtr &conn)
+        : conn(conn), loop(conn->getLoop()), baseBytes(conn->bytesSent())
+    {
+    }
+
+    size_t pendingBytes() const
+    {
+        auto connPtr = conn.lock();
+        if (!connPtr)
+            return 0;
+        // The connection carries nothing else while the stream is open, what
+        // it has written since then belongs to the stream.
+        auto written = connPtr->bytesSent() - baseBytes;
+        auto sent = sentBytes.load(std::memory_order_relaxed);
+        return sent > written ? sent - written : 0;
+    }
+
+    void onHighWaterMark()
+    {
+        if (aboveHigh)
+            return;
+        aboveHigh = true;
+        if (onHigh)
+            onHigh();
+    }
+
+    void onWriteComplete()
+    {
+        // Data sent from other threads may still be on its way to the
+        // connection.
+        if (pendingBytes() > 0)
+            return;
+        if (aboveHigh)
+        {
+            aboveHigh = false;
+            if (onDrained)
+                onDrained();
+        }
+        auto callbacks = std::move(drainCallbacks);
+        drainCallbacks.clear();
+        for (auto &callback : callbacks)
+            callback();
+    }
+
+    // The keep-alive connection may carry other responses once the stream is
+    // closed, the callbacks holding this state are replaced by no-ops
+    void detach()
+    {
+        onHigh = nullptr;
+        onDrained = nullptr;
+        auto connPtr = conn.lock();
+        if (!connPtr)
+            return;
+        connPtr->setWriteCompleteCallback(
+            [](const trantor::TcpConnectionPtr &) {});
+        if (highWatermark > 0)
+        {
+            connPtr->setHighWaterMarkCallback(
+                [](const trantor::TcpConnectionPtr &, size_t) {},
+                highWatermark);
+        }
+    }
+
+    std::weak_ptr<trantor::TcpConnection> conn;
+    trantor::EventLoop *loop;
+    size_t baseBytes;
+    std::atomic<size_t> sentBytes{0};
+    // Only accessed in the loop
+    std::function<void()> onHigh;
+    std::function<void()> onDrained;
+    size_t highWatermark{0};
+    bool aboveHigh{false};
+    std::vector<std::function<void()>> drainCallbacks;
+
+    // Held by the callbacks of the connection, which complete the drains of
+    // the stream when they are released with the connection.
+    struct DrainGuard
+    {
+        explicit DrainGuard(std::shared_ptr<FlowState> state)
+            : state(std::move(state))
+        {
+        }
+
+        ~DrainGuard()
+        {
+            auto callbacks = std::move(state->drainCallbacks);
+            for (auto &callback : callbacks)
+                callback();
+        }
+
+        std::shared_ptr<FlowState> state;
+    };
+};
+
+void ResponseStream::setConnection(const trantor::TcpConnectionPtr &conn)
+{
+    flow_ = std::make_shared<FlowState>(conn);
+    auto guard = std::make_shared<FlowState::DrainGuard>(flow_);
+    // Queued, like the detachment of the stream closed before this one, so
+    // the callbacks of the new stream are never removed by it
+    flow_->loop->queueInLoop([guard = std::move(guard)]() {
+        auto connPtr = guard->state->conn.lock();
+        if (!connPtr)
+            return;
+        connPtr->setWriteCompleteCallback(
+            [guard](const trantor::TcpConnectionPtr &) {
+                guard->state->onWriteComplete();
+            });
+    });
+}
+
+void ResponseStream::setWatermarkCallbacks(size_t highWatermark,
+                                           std::function<void()> onHigh,
+                                           std::function<void()> onDrained)
+{
+    highWatermark_ = highWatermark;
+    if (!flow_)
+        return;
+    flow_->loop->queueInLoop([state = flow_,
+                              highWatermark,
+                              onHigh = std::move(onHigh),
+                              onDrained = std::move(onDrained)]() mutable {
+        state->onHigh = std::move(onHigh);
+        state->onDrained = std::move(onDrained);
+        state->highWatermark = highWatermark;
+        auto connPtr = state->conn.lock();
+        if (!connPtr)
+            return;
+        connPtr->setHighWaterMarkCallback(
+            [state](const trantor::TcpConnectionPtr &, size_t) {
+                state->onHighWaterMark();
+            },
+            highWatermark);
+    });
+}
+
+void ResponseStream::detachConnection()
+{
+    // Queued even in the loop, the stream may be closed by a callback of the
+    // connection which can't be replaced while it runs
+    auto loop = flow_->loop;
+    loop->queueInLoop([state = std::move(flow_)]() { state->detach(); });
+}
+
+void ResponseStream::drain(std::function<void()> callback)
+{
+    if (!flow_)
+    {
+        callback();
+        return;
+    }
+    flow_->loop->runInLoop(
+        [state = flow_, callback = std::move(callback)]() mutable {
+            if (state->pendingBytes() == 0)
+            {
+                callback();
+                return;
+            }
+            state->drainCallbacks.push_back(std::move(callback));
+        });
+}
+
+size_t ResponseStream::pendingBytes() const
+{
+    return flow_ ? flow_->pendingBytes() : 0;
+}
+
+void ResponseStream::onSent(size_t length)
+{
+    if (flow_)
+        flow_->sentBytes.fetch_add(length, std::memory_order_relaxed);
+}
+
+bool ResponseStream::overflows(size_t length)
+{
+    auto pending = pendingBytes();
+    if (pending == 0 || pending + length <= maxBufferedBytes_)
+        return false;
+    if (overflowPolicy_ == OverflowPolicy::kClose)
+    {
+        LOG_WARN << "The response stream buffers " << pending
+                 << " bytes, closing the connection";
+        if (auto conn = flow_->conn.lock())
+            conn->forceClose();
+        asyncStream_.reset();
+        encoder_ = nullptr;
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+/**
+ *
+ *  @file RetryBudget.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RetryBudget.h"
+#include <algorithm>
+
+using namespace drogon;
+
+RetryBudget::RetryBudget(double ratio, double capacity)
+    : ratio_(static_cast<int64_t>(std::max(ratio, 0.0) * kScale)),
+      capacity_(static_cast<int64_t>(std::max(capacity, 1.0) * kScale)),
+      tokens_(capacity_)
+{
+}
+
+void RetryBudget::deposit()
+{
+    auto tokens = tokens_.load(std::memory_order_relaxed);
+    while (tokens < capacity_ &&
+           !tokens_.compare_exchange_weak(tokens,
+                                          std::min(tokens + ratio_, capacity_),
+                                          std::memory_order_relaxed))
+    {
+    }
+}
+
+bool RetryBudget::withdraw()
+{
+    auto tokens = tokens_.load(std::memory_order_relaxed);
+    while (tokens >= kScale)
+    {
+        if (tokens_.compare_exchange_weak(tokens,
+                                          tokens - kScale,
+                                          std::memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+LatencyWindow::LatencyWindow(size_t size, size_t minSamples)
+    : size_(size == 0 ? 1 : size),
+      minSamples_(std::min(std::max<size_t>(minSamples, 1), size_))
+{
+    samples_.reserve(size_);
+}
+
+void LatencyWindow::observe(double seconds)
+{
+    if (samples_.size() < size_)
+        samples_.push_back(seconds);
+    else
+        samples_[next_] = seconds;
+    next_ = (next_ + 1) % size_;
+    ++fresh_;
+}
+
+std::optional<double> LatencyWindow::percentile(double quantile)
+{
+    if (samples_.size() < minSamples_)
+        return std::nullopt;
+    quantile = std::clamp(quantile, 0.0, 1.0);
+    if (quantile == cachedQuantile_ && fresh_ * 8 < samples_.size())
+        return cachedValue_;
+    sorted_ = samples_;
+    auto rank = static_cast<size_t>(quantile * (sorted_.size() - 1) + 0.5);
+    std::nth_element(sorted_.begin(), sorted_.begin() + rank, sorted_.end());
+    cachedValue_ = sorted_[rank];
+    cachedQuantile_ = quantile;
+    fresh_ = 0;
+    return cachedValue_;
+}
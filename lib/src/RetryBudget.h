@@ -0,0 +1,104 @@
+/**
+ *
+ *  @file RetryBudget.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A token bucket refilled by the traffic, which bounds the extra
+ * requests (hedges and retries) to a share of the requests.
+ *
+ * Every request deposits ratio tokens, up to capacity, and every extra
+ * request withdraws one token. So with a ratio of 0.1 at most one request in
+ * ten is duplicated in the long run, however slow or broken the server is,
+ * and the budget does not turn an outage into a retry storm. The bucket
+ * starts full, which allows a burst of capacity extra requests.
+ *
+ * It is shared by all the threads, the tokens are kept in thousandths in an
+ * atomic.
+ */
+class DROGON_EXPORT RetryBudget
+{
+  public:
+    RetryBudget(double ratio, double capacity);
+
+    /// A request is sent
+    void deposit();
+
+    /// Take a token for an extra request, false if the budget is exhausted
+    bool withdraw();
+
+    /// The tokens left
+    double tokens() const
+    {
+        return static_cast<double>(tokens_.load(std::memory_order_relaxed)) /
+               kScale;
+    }
+
+  private:
+    static constexpr int64_t kScale = 1000;
+
+    const int64_t ratio_;
+    const int64_t capacity_;
+    std::atomic<int64_t> tokens_;
+};
+
+/**
+ * @brief The latencies of the last responses, to derive a percentile from
+ * them. Only used in one thread.
+ */
+class DROGON_EXPORT LatencyWindow
+{
+  public:
+    /**
+     * @param size The number of latencies kept.
+     * @param minSamples The latencies needed before a percentile is given.
+     */
+    explicit LatencyWindow(size_t size = 256, size_t minSamples = 32);
+
+    void observe(double seconds);
+
+    /**
+     * @brief The percentile (between 0 and 1) of the kept latencies, nullopt
+     * until there are minSamples of them.
+     *
+     * It is computed again once an eighth of the window is new, so calling it
+     * for every request is cheap.
+     */
+    std::optional<double> percentile(double quantile);
+
+    size_t samples() const
+    {
+        return samples_.size();
+    }
+
+  private:
+    const size_t size_;
+    const size_t minSamples_;
+    std::vector<double> samples_;
+    size_t next_{0};
+    size_t fresh_{0};
+    double cachedQuantile_{-1};
+    double cachedValue_{0};
+    std::vector<double> sorted_;
+};
+
+}  // namespace drogon
@@ -0,0 +1,1136 @@
+/**
+ *  @file ReverseProxy.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/ReverseProxy.h>
+#include <drogon/IOThreadStorage.h>
+#include <drogon/RequestStream.h>
+#include <drogon/utils/Utilities.h>
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include "ProxyResponseParser.h"
+#include "UpstreamBalancer.h"
+#include <trantor/net/Resolver.h>
+#include <trantor/net/TcpClient.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+namespace
+{
+// A request which got no response is sent at most this number of times
+constexpr size_t kMaxAttempts = 2;
+
+int64_t steadyMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// The fields of a connection, not forwarded (RFC9110 7.6.1)
+bool isHopByHop(const std::string &field)
+{
+    return field == "connection" || field == "keep-alive" ||
+           field == "proxy-connection" || field == "te" ||
+           field == "trailer" || field == "transfer-encoding" ||
+           field == "upgrade";
+}
+
+// Whether the Connection header names the field as hop-by-hop as well
+bool isNamedBy(std::string_view connection, const std::string &field)
+{
+    while (!connection.empty())
+    {
+        auto comma = connection.find(',');
+        auto token = connection.substr(0, comma);
+        while (!token.empty() && token.front() == ' ')
+            token.remove_prefix(1);
+        while (!token.empty() && token.back() == ' ')
+            token.remove_suffix(1);
+        if (token.length() == field.length() &&
+            std::equal(token.begin(),
+                       token.end(),
+                       field.begin(),
+                       [](char a, char b) {
+                           return tolower(static_cast<unsigned char>(a)) == b;
+                       }))
+            return true;
+        if (comma == std::string_view::npos)
+            break;
+        connection.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool isIpLiteral(const std::string &host)
+{
+    return host.find(':') != std::string::npos ||
+           std::all_of(host.begin(), host.end(), [](char c) {
+               return c == '.' || (c >= '0' && c <= '9');
+           });
+}
+}  // namespace
+
+struct ReverseProxy::Upstream
+{
+    std::string url;
+    std::string domain;
+    // The authority of the url, sent as the Host header
+    std::string hostHeader;
+    // Prepended to the paths, without a trailing slash
+    std::string basePath;
+    trantor::InetAddress address;
+    bool ssl{false};
+};
+
+struct ReverseProxy::LoopPool
+{
+    // The idle connections of every upstream server, the latest used last
+    std::vector<std::vector<ConnectionPtr>> idle;
+};
+
+class ReverseProxy::Connection
+{
+  public:
+    explicit Connection(size_t backendIndex);
+
+    void close()
+    {
+        exchange.reset();
+        if (conn)
+            conn->forceClose();
+        else if (client)
+            client->stop();
+    }
+
+    size_t backend;
+    std::shared_ptr<trantor::TcpClient> client;
+    trantor::TcpConnectionPtr conn;
+    ProxyResponseParser parser;
+    // The exchange using the connection, nullptr while it's idle
+    std::shared_ptr<Exchange> exchange;
+    int64_t idleSince{0};
+};
+
+/**
+ * One proxied request, sent to an upstream server, sent again to another one
+ * if it got no response and it's safe to do so.
+ */
+class ReverseProxy::Exchange : public std::enable_shared_from_this<Exchange>
+{
+  public:
+    Exchange(ReverseProxy *proxy,
+             const HttpRequestPtr &req,
+             size_t prefixLength,
+             AdviceCallback &&callback)
+        : proxy_(proxy),
+          req_(req),
+          loop_(trantor::EventLoop::getEventLoopOfCurrentThread()),
+          callback_(std::move(callback)),
+          prefixLength_(prefixLength),
+          isHead_(req->isHead()),
+          hashKey_(proxy->hashKeyOf(req))
+    {
+        auto method = req->method();
+        idempotent_ = method == Get || method == Head || method == Put ||
+                      method == Delete || method == Options;
+    }
+
+    ~Exchange()
+    {
+        cancelTimer();
+        cancelBalancer();
+        if (callback_)
+            respondError(k502BadGateway);
+    }
+
+    void start()
+    {
+        auto requestStream = internal::createRequestStream(req_);
+        if (requestStream)
+        {
+            streamed_ = true;
+            chunkedUpload_ = req_->getHeader("content-length").empty();
+            std::weak_ptr<Exchange> weakPtr = shared_from_this();
+            requestStream->setStreamReader(RequestStreamReader::newReader(
+                [weakPtr](const char *data, size_t length) {
+                    if (auto thisPtr = weakPtr.lock())
+                        thisPtr->onUploadData(data, length);
+                },
+                [weakPtr](std::exception_ptr ex) {
+                    if (auto thisPtr = weakPtr.lock())
+                        thisPtr->onUploadFinish(std::move(ex));
+                }));
+        }
+        attempt();
+    }
+
+    void onConnected()
+    {
+        auto thisPtr = shared_from_this();
+        connected_ = true;
+        auto &conn = connection_->conn;
+        connection_->parser.reset(isHead_);
+        conn->send(requestHead());
+        if (!streamed_)
+        {
+            auto body = req_->body();
+            if (!body.empty())
+                conn->send(body.data(), body.length());
+            requestSent_ = true;
+            return;
+        }
+        if (!pendingUpload_.empty())
+        {
+            conn->send(std::move(pendingUpload_));
+            pendingUpload_.clear();
+        }
+        requestSent_ = uploadFinished_;
+    }
+
+    void onUpstreamData(trantor::MsgBuffer *buf)
+    {
+        auto thisPtr = shared_from_this();
+        // The callbacks may release the connection
+        auto connection = connection_;
+        auto n = connection->parser.parse(buf->peek(), buf->readableBytes());
+        if (n < 0)
+        {
+            LOG_ERROR << "Invalid response from the upstream server "
+                      << proxy_->upstreams_[backend_].url;
+            buf->retrieveAll();
+            fail(true, k502BadGateway);
+            return;
+        }
+        buf->retrieve(static_cast<size_t>(n));
+        if (downstreamGone_)
+        {
+            // Not a failure of the server
+            release(false);
+            finishBalancer(true);
+            return;
+        }
+        if (connection->parser.done() && connection_ == connection)
+            complete(buf->readableBytes() == 0);
+    }
+
+    void onUpstreamClosed()
+    {
+        auto thisPtr = shared_from_this();
+        if (connection_->parser.finishOnClose())
+        {
+            complete(false);
+            return;
+        }
+        // A kept alive connection may be closed by the server at any time
+        fail(!reused_ || headReceived_, k502BadGateway);
+    }
+
+    void onHead(ProxyResponseParser::Head &&head)
+    {
+        cancelTimer();
+        headReceived_ = true;
+        latency_ = steadyMicroseconds() - startTime_;
+        failedStatus_ = head.statusCode >= 502 && head.statusCode <= 504;
+        bool bodyless = connection_->parser.done();
+        HttpResponsePtr resp;
+        if (bodyless)
+        {
+            resp = HttpResponse::newHttpResponse();
+        }
+        else
+        {
+            auto guard = std::make_shared<StreamGuard>(shared_from_this());
+            resp = HttpResponse::newAsyncStreamResponse(
+                [guard](ResponseStreamPtr stream) {
+                    guard->deliver(std::move(stream));
+                },
+                true);
+            // The type isn't sent with passThrough, it keeps the body from
+            // being compressed again.
+            resp->setContentTypeCode(CT_APPLICATION_OCTET_STREAM);
+        }
+        resp->setPassThrough(true);
+        resp->setStatusCode(static_cast<HttpStatusCode>(head.statusCode));
+        auto respImpl = static_cast<HttpResponseImpl *>(resp.get());
+        std::string connection;
+        for (auto &field : head.headers)
+        {
+            if (field.first == "connection")
+                connection = field.second;
+        }
+        for (auto &[field, value] : head.headers)
+        {
+            if (isHopByHop(field) || isNamedBy(connection, field) ||
+                (!bodyless && field == "content-length"))
+                continue;
+            if (field == "set-cookie")
+            {
+                auto line = field + ": " + value;
+                respImpl->addHeader(line.data(),
+                                    line.data() + field.length(),
+                                    line.data() + line.length());
+                continue;
+            }
+            auto &existing = resp->getHeader(field);
+            if (existing.empty())
+                resp->addHeader(field, value);
+            else
+                resp->addHeader(field, existing + ", " + value);
+        }
+        if (!bodyless)
+            resp->addHeader("transfer-encoding", "chunked");
+        respond(resp);
+    }
+
+    void onBody(const char *data, size_t length)
+    {
+        if (downstreamGone_)
+            return;
+        if (stream_)
+        {
+            if (!stream_->send(std::string(data, length)))
+                downstreamGone_ = true;
+            return;
+        }
+        // Until the response header is sent
+        pending_.append(data, length);
+        if (pending_.length() > proxy_->highWatermark_)
+            pauseUpstream(true);
+    }
+
+    void onUpstreamHigh()
+    {
+        if (streamed_)
+            pauseDownstream(true);
+    }
+
+    void onUpstreamDrained()
+    {
+        pauseDownstream(false);
+    }
+
+  private:
+    /// Hand the stream of the response to the exchange, or abort the
+    /// exchange if the response is dropped before it is sent.
+    struct StreamGuard
+    {
+        explicit StreamGuard(std::shared_ptr<Exchange> exchangePtr)
+            : exchange(std::move(exchangePtr))
+        {
+        }
+
+        ~StreamGuard()
+        {
+            if (!exchange)
+                return;
+            auto loop = exchange->loop_;
+            loop->queueInLoop(
+                [exchange = std::move(exchange)]() { exchange->abort(); });
+        }
+
+        void deliver(ResponseStreamPtr stream)
+        {
+            auto exchangePtr = std::move(exchange);
+            exchange.reset();
+            exchangePtr->onStream(std::move(stream));
+        }
+
+        std::shared_ptr<Exchange> exchange;
+    };
+
+    void attempt()
+    {
+        // The request stream may have failed already
+        if (!callback_)
+            return;
+        ++attempts_;
+        auto now = steadyMicroseconds();
+        auto &balancer = *proxy_->balancer_;
+        backend_ = balancer.pick(hashKey_, now, excluded_);
+        if (backend_ == UpstreamBalancer::npos)
+        {
+            respondError(k502BadGateway);
+            return;
+        }
+        balancer.onStart(backend_);
+        counted_ = true;
+        startTime_ = now;
+        connected_ = false;
+        if (proxy_->responseTimeout_ > 0)
+        {
+            std::weak_ptr<Exchange> weakPtr = shared_from_this();
+            timerId_ = loop_->runAfter(proxy_->responseTimeout_, [weakPtr]() {
+                if (auto thisPtr = weakPtr.lock())
+                    thisPtr->onTimeout();
+            });
+        }
+        connection_ = proxy_->takeIdle(backend_);
+        reused_ = connection_ != nullptr;
+        if (reused_)
+        {
+            connection_->exchange = shared_from_this();
+            onConnected();
+            return;
+        }
+        connection_ = proxy_->newConnection(backend_, loop_);
+        connection_->exchange = shared_from_this();
+        connection_->client->connect();
+    }
+
+    std::string requestHead() const
+    {
+        auto &upstream = proxy_->upstreams_[backend_];
+        std::string head;
+        head.reserve(512);
+        head.append(isHead_ ? "HEAD" : req_->methodString()).append(1, ' ');
+        head.append(upstream.basePath);
+        auto &path = req_->getOriginalPath();
+        if (proxy_->stripPrefix_ && prefixLength_ > 0)
+        {
+            std::string_view rest(path);
+            rest.remove_prefix((std::min)(prefixLength_, rest.length()));
+            if (rest.empty() || rest.front() != '/')
+                head.append(1, '/');
+            head.append(rest);
+        }
+        else
+        {
+            head.append(path);
+        }
+        if (!req_->query().empty())
+            head.append(1, '?').append(req_->query());
+        head.append(" HTTP/1.1\r\n");
+
+        bool forwarded = proxy_->forwardedHeaders_;
+        auto &connection = req_->getHeader("connection");
+        for (auto &[field, value] : req_->headers())
+        {
+            if (isHopByHop(field) || field == "host" ||
+                field == "content-length" || field == "expect" ||
+                isNamedBy(connection, field) ||
+                (forwarded &&
+                 (field == "x-forwarded-for" || field == "x-forwarded-proto")))
+                continue;
+            head.append(field).append(": ").append(value).append("\r\n");
+        }
+        // The cookies are parsed out of the header
+        if (!req_->cookies().empty())
+        {
+            head.append("cookie: ");
+            for (auto &[name, value] : req_->cookies())
+                head.append(name).append(1, '=').append(value).append("; ");
+            head.resize(head.length() - 2);
+            head.append("\r\n");
+        }
+        auto &host = req_->getHeader("host");
+        head.append("host: ")
+            .append(proxy_->preserveHost_ && !host.empty()
+                        ? host
+                        : upstream.hostHeader)
+            .append("\r\n");
+        if (forwarded)
+        {
+            auto &forwardedFor = req_->getHeader("x-forwarded-for");
+            head.append("x-forwarded-for: ");
+            if (!forwardedFor.empty())
+                head.append(forwardedFor).append(", ");
+            head.append(req_->peerAddr().toIp()).append("\r\n");
+            head.append("x-forwarded-proto: ")
+                .append(req_->isOnSecureConnection() ? "https" : "http")
+                .append("\r\n");
+        }
+        if (streamed_)
+        {
+            if (chunkedUpload_)
+                head.append("transfer-encoding: chunked\r\n");
+            else
+                head.append("content-length: ")
+                    .append(req_->getHeader("content-length"))
+                    .append("\r\n");
+        }
+        else
+        {
+            auto length = req_->body().length();
+            auto method = req_->method();
+            if (length > 0 || method == Post || method == Put ||
+                method == Patch)
+            {
+                head.append("content-length: ")
+                    .append(std::to_string(length))
+                    .append("\r\n");
+            }
+        }
+        head.append("\r\n");
+        return head;
+    }
+
+    void onUploadData(const char *data, size_t length)
+    {
+        if (length == 0)
+            return;
+        if (!chunkedUpload_)
+        {
+            sendUpload(std::string(data, length));
+            return;
+        }
+        char size[24];
+        auto n = snprintf(size, sizeof(size), "%zx\r\n", length);
+        std::string chunk;
+        chunk.reserve(n + length + 2);
+        chunk.append(size, n).append(data, length).append("\r\n");
+        sendUpload(std::move(chunk));
+    }
+
+    void onUploadFinish(std::exception_ptr ex)
+    {
+        auto thisPtr = shared_from_this();
+        if (ex)
+        {
+            // The client is gone or sent a malformed body, the upstream
+            // request can't be completed.
+            release(false);
+            cancelBalancer();
+            respondError(k400BadRequest);
+            return;
+        }
+        uploadFinished_ = true;
+        if (chunkedUpload_)
+            sendUpload("0\r\n\r\n");
+        if (connected_)
+            requestSent_ = true;
+    }
+
+    void sendUpload(std::string &&data)
+    {
+        // After the response, or after a failure
+        if (!connection_ && attempts_ > 0)
+            return;
+        if (connected_)
+        {
+            connection_->conn->send(std::move(data));
+            return;
+        }
+        pendingUpload_.append(data);
+        if (pendingUpload_.length() > proxy_->highWatermark_)
+            pauseDownstream(true);
+    }
+
+    void onStream(ResponseStreamPtr stream)
+    {
+        auto thisPtr = shared_from_this();
+        if (downstreamGone_)
+        {
+            abortDownstream();
+            return;
+        }
+        stream_ = std::move(stream);
+        std::weak_ptr<Exchange> weakPtr = thisPtr;
+        stream_->setWatermarkCallbacks(
+            proxy_->highWatermark_,
+            [weakPtr]() {
+                if (auto exchange = weakPtr.lock())
+                    exchange->pauseUpstream(true);
+            },
+            [weakPtr]() {
+                if (auto exchange = weakPtr.lock())
+                    exchange->pauseUpstream(false);
+            });
+        if (!pending_.empty())
+        {
+            bool sent = stream_->send(pending_);
+            pending_.clear();
+            pending_.shrink_to_fit();
+            if (!sent)
+            {
+                abort();
+                return;
+            }
+        }
+        if (upstreamDone_)
+        {
+            stream_->close();
+            stream_.reset();
+            return;
+        }
+        if (stream_->writable())
+            pauseUpstream(false);
+    }
+
+    /// The client is gone or the response can't be completed
+    void abort()
+    {
+        auto thisPtr = shared_from_this();
+        if (connection_)
+        {
+            release(false);
+            if (headReceived_)
+                finishBalancer(!failedStatus_);
+            else
+                cancelBalancer();
+        }
+        abortDownstream();
+    }
+
+    void onTimeout()
+    {
+        auto thisPtr = shared_from_this();
+        timerId_ = 0;
+        if (headReceived_ || !connection_)
+            return;
+        LOG_WARN << "The upstream server " << proxy_->upstreams_[backend_].url
+                 << " timed out";
+        fail(true, k504GatewayTimeout);
+    }
+
+    /// The upstream request failed
+    void fail(bool serverFault, HttpStatusCode code)
+    {
+        release(false);
+        if (serverFault)
+            finishBalancer(false);
+        else
+            cancelBalancer();
+        if (headReceived_)
+        {
+            // The body is cut, the client must not take it as complete
+            abortDownstream();
+            return;
+        }
+        if (!streamed_ && attempts_ < kMaxAttempts &&
+            (!connected_ || idempotent_))
+        {
+            if (serverFault)
+                excluded_ = backend_;
+            attempt();
+            return;
+        }
+        respondError(code);
+    }
+
+    /// The upstream response is complete
+    void complete(bool clean)
+    {
+        upstreamDone_ = true;
+        bool reusable =
+            clean && requestSent_ && connection_->parser.keepAlive();
+        release(reusable);
+        finishBalancer(!failedStatus_);
+        if (stream_)
+        {
+            stream_->close();
+            stream_.reset();
+        }
+    }
+
+    void release(bool reusable)
+    {
+        cancelTimer();
+        pauseDownstream(false);
+        if (!connection_)
+            return;
+        auto connection = std::move(connection_);
+        connection_.reset();
+        connection->exchange.reset();
+        if (upstreamPaused_)
+        {
+            upstreamPaused_ = false;
+            if (connection->conn)
+                connection->conn->startRead();
+        }
+        if (reusable && connection->conn && connection->conn->connected())
+            proxy_->putIdle(connection);
+        else
+            connection->close();
+    }
+
+    void abortDownstream()
+    {
+        downstreamGone_ = true;
+        // Closing the stream would end the body as if it was complete. The
+        // streams of HTTP/2 and HTTP/3 share the connection, they are closed
+        // instead.
+        if (req_->version() != Version::kHttp2 &&
+            req_->version() != Version::kHttp3)
+        {
+            if (auto conn = req_->getConnectionPtr().lock())
+                conn->forceClose();
+        }
+        stream_.reset();
+    }
+
+    void respond(const HttpResponsePtr &resp)
+    {
+        if (!callback_)
+            return;
+        auto callback = std::move(callback_);
+        callback_ = nullptr;
+        callback(resp);
+    }
+
+    void respondError(HttpStatusCode code)
+    {
+        respond(app().getCustomErrorHandler()(code, req_));
+    }
+
+    void finishBalancer(bool ok)
+    {
+        if (!counted_)
+            return;
+        counted_ = false;
+        proxy_->balancer_->onFinish(backend_,
+                                    ok,
+                                    latency_,
+                                    steadyMicroseconds());
+    }
+
+    void cancelBalancer()
+    {
+        if (!counted_)
+            return;
+        counted_ = false;
+        proxy_->balancer_->onCancel(backend_);
+    }
+
+    void cancelTimer()
+    {
+        if (timerId_ != 0)
+        {
+            loop_->invalidateTimer(timerId_);
+            timerId_ = 0;
+        }
+    }
+
+    void pauseUpstream(bool pause)
+    {
+        if (pause == upstreamPaused_ || !connection_ || !connection_->conn)
+            return;
+        upstreamPaused_ = pause;
+        if (pause)
+            connection_->conn->stopRead();
+        else
+            connection_->conn->startRead();
+    }
+
+    void pauseDownstream(bool pause)
+    {
+        if (pause == downstreamPaused_)
+            return;
+        auto conn = req_->getConnectionPtr().lock();
+        if (!conn)
+            return;
+        downstreamPaused_ = pause;
+        if (pause)
+            conn->stopRead();
+        else
+            conn->startRead();
+    }
+
+    ReverseProxy *proxy_;
+    HttpRequestPtr req_;
+    trantor::EventLoop *loop_;
+    AdviceCallback callback_;
+    size_t prefixLength_;
+    bool isHead_;
+    bool idempotent_{false};
+    std::string hashKey_;
+
+    size_t attempts_{0};
+    size_t backend_{UpstreamBalancer::npos};
+    size_t excluded_{UpstreamBalancer::npos};
+    ConnectionPtr connection_;
+    bool counted_{false};
+    bool reused_{false};
+    bool connected_{false};
+    trantor::TimerId timerId_{0};
+    int64_t startTime_{0};
+    int64_t latency_{0};
+
+    // The request body read from a RequestStream
+    bool streamed_{false};
+    bool chunkedUpload_{false};
+    std::string pendingUpload_;
+    bool uploadFinished_{false};
+    bool requestSent_{false};
+    bool downstreamPaused_{false};
+
+    bool headReceived_{false};
+    bool failedStatus_{false};
+    bool upstreamDone_{false};
+    bool upstreamPaused_{false};
+    bool downstreamGone_{false};
+    // The body received before the stream of the response
+    std::string pending_;
+    ResponseStreamPtr stream_;
+};
+
+ReverseProxy::Connection::Connection(size_t backendIndex)
+    : backend(backendIndex),
+      parser(
+          [this](ProxyResponseParser::Head &&head) {
+              if (exchange)
+                  exchange->onHead(std::move(head));
+          },
+          [this](const char *data, size_t length) {
+              if (exchange)
+                  exchange->onBody(data, length);
+          })
+{
+}
+
+ReverseProxy::ReverseProxy() = default;
+
+ReverseProxy::~ReverseProxy() = default;
+
+void ReverseProxy::initAndStart(const Json::Value &config)
+{
+    for (auto &backend : config["backends"])
+    {
+        auto url = backend.asString();
+        Upstream upstream;
+        upstream.url = url;
+        std::string_view rest(url);
+        if (rest.substr(0, 7) == "http://")
+        {
+            rest.remove_prefix(7);
+        }
+        else if (rest.substr(0, 8) == "https://")
+        {
+            rest.remove_prefix(8);
+            upstream.ssl = true;
+        }
+        else
+        {
+            throw std::runtime_error("Invalid backend of ReverseProxy: " + url);
+        }
+        auto slash = rest.find('/');
+        auto authority = rest.substr(0, slash);
+        if (slash != std::string_view::npos)
+        {
+            upstream.basePath = std::string(rest.substr(slash));
+            while (!upstream.basePath.empty() &&
+                   upstream.basePath.back() == '/')
+                upstream.basePath.pop_back();
+        }
+        upstream.hostHeader = std::string(authority);
+        std::string_view portText;
+        if (!authority.empty() && authority.front() == '[')
+        {
+            auto close = authority.find(']');
+            if (close == std::string_view::npos)
+                throw std::runtime_error("Invalid backend of ReverseProxy: " +
+                                         url);
+            upstream.domain = std::string(authority.substr(1, close - 1));
+            authority.remove_prefix(close + 1);
+            if (!authority.empty() && authority.front() != ':')
+                throw std::runtime_error("Invalid backend of ReverseProxy: " +
+                                         url);
+            portText = authority.substr((std::min)(authority.size(),
+                                                   size_t(1)));
+        }
+        else
+        {
+            auto colon = authority.find(':');
+            upstream.domain = std::string(authority.substr(0, colon));
+            if (colon != std::string_view::npos)
+                portText = authority.substr(colon + 1);
+        }
+        int port = upstream.ssl ? 443 : 80;
+        if (!portText.empty())
+        {
+            port = 0;
+            for (auto c : portText)
+            {
+                if (c < '0' || c > '9' || port > 65535)
+                    break;
+                port = port * 10 + (c - '0');
+            }
+        }
+        if (upstream.domain.empty() || port <= 0 || port > 65535 ||
+            (!portText.empty() &&
+             std::to_string(port).length() != portText.length()))
+        {
+            throw std::runtime_error("Invalid backend of ReverseProxy: " + url);
+        }
+        if (upstream.ssl && !utils::supportsTls())
+        {
+            throw std::runtime_error(
+                "ReverseProxy needs TLS support for the backend " + url);
+        }
+        if (isIpLiteral(upstream.domain))
+        {
+            upstream.address =
+                trantor::InetAddress(upstream.domain,
+                                     static_cast<uint16_t>(port),
+                                     upstream.domain.find(':') !=
+                                         std::string::npos);
+        }
+        else
+        {
+            // Resolved once, as the other clients created from the
+            // configuration
+            std::promise<trantor::InetAddress> promise;
+            auto future = promise.get_future();
+            trantor::Resolver::newResolver()->resolve(
+                upstream.domain,
+                [&promise](const trantor::InetAddress &address) {
+                    promise.set_value(address);
+                });
+            auto address = future.get();
+            if (!address.isIpV6() && address.ipNetEndian() == 0)
+            {
+                throw std::runtime_error(
+                    "Failed to resolve the backend of ReverseProxy: " + url);
+            }
+            upstream.address = trantor::InetAddress(address.toIp(),
+                                                    static_cast<uint16_t>(
+                                                        port),
+                                                    address.isIpV6());
+        }
+        upstreams_.push_back(std::move(upstream));
+    }
+    if (upstreams_.empty())
+    {
+        throw std::runtime_error("ReverseProxy needs at least one backend");
+    }
+
+    for (auto &prefix : config["path_prefixes"])
+    {
+        pathPrefixes_.push_back(prefix.asString());
+    }
+    stripPrefix_ = config.get("strip_prefix", false).asBool();
+    bool ok;
+    auto policy = UpstreamBalancer::parsePolicy(
+        config.get("balancing", "round_robin").asString(), &ok);
+    if (!ok)
+    {
+        throw std::runtime_error("Unknown balancing of ReverseProxy: " +
+                                 config["balancing"].asString());
+    }
+    auto hashKey = config.get("hash_key", "ip").asString();
+    if (hashKey == "ip")
+    {
+        hashKey_ = HashKey::kIp;
+    }
+    else if (hashKey == "path")
+    {
+        hashKey_ = HashKey::kPath;
+    }
+    else if (hashKey.compare(0, 7, "header:") == 0 && hashKey.length() > 7)
+    {
+        hashKey_ = HashKey::kHeader;
+        hashHeader_ = hashKey.substr(7);
+        std::transform(hashHeader_.begin(),
+                       hashHeader_.end(),
+                       hashHeader_.begin(),
+                       [](unsigned char c) { return tolower(c); });
+    }
+    else
+    {
+        throw std::runtime_error("Unknown hash_key of ReverseProxy: " +
+                                 hashKey);
+    }
+
+    UpstreamBalancer::Options options;
+    options.maxFails = config.get("max_fails", 3).asUInt();
+    options.failTimeout = static_cast<int64_t>(
+        config.get("fail_timeout", 10).asDouble() * 1000000);
+    maxIdle_ = config.get("max_idle_connections", 32).asUInt();
+    idleTimeout_ = static_cast<int64_t>(
+        config.get("idle_timeout", 60).asDouble() * 1000000);
+    responseTimeout_ = config.get("response_timeout", 60).asDouble();
+    highWatermark_ = config.get("high_watermark", 1024 * 1024).asUInt64();
+    preserveHost_ = config.get("preserve_host", false).asBool();
+    forwardedHeaders_ = config.get("forwarded_headers", true).asBool();
+    validateCert_ = config.get("validate_cert", true).asBool();
+
+    std::vector<std::string> names;
+    for (auto &upstream : upstreams_)
+        names.push_back(upstream.url);
+    balancer_ = std::make_unique<UpstreamBalancer>(names, policy, options);
+    pools_ = std::make_unique<IOThreadStorage<LoopPool>>();
+    pools_->init([this](LoopPool &pool, size_t) {
+        pool.idle.resize(upstreams_.size());
+    });
+
+    app().registerPreRoutingAdvice([this](const HttpRequestPtr &req,
+                                          AdviceCallback &&adviceCallback,
+                                          AdviceChainCallback &&chainCallback) {
+        auto prefixLength = matchPrefix(req->getOriginalPath());
+        if (prefixLength < 0)
+        {
+            chainCallback();
+            return;
+        }
+        auto exchange =
+            std::make_shared<Exchange>(this,
+                                       req,
+                                       static_cast<size_t>(prefixLength),
+                                       std::move(adviceCallback));
+        exchange->start();
+    });
+}
+
+void ReverseProxy::shutdown()
+{
+    LOG_TRACE << "ReverseProxy plugin is shutdown!";
+}
+
+long ReverseProxy::matchPrefix(const std::string &path) const
+{
+    if (pathPrefixes_.empty())
+        return 0;
+    for (auto &prefix : pathPrefixes_)
+    {
+        if (path.compare(0, prefix.length(), prefix) == 0)
+            return static_cast<long>(prefix.length());
+    }
+    return -1;
+}
+
+std::string ReverseProxy::hashKeyOf(const HttpRequestPtr &req) const
+{
+    switch (hashKey_)
+    {
+        case HashKey::kPath:
+            return req->path();
+        case HashKey::kHeader:
+            return req->getHeader(hashHeader_);
+        case HashKey::kIp:
+        default:
+            return req->peerAddr().toIp();
+    }
+}
+
+ReverseProxy::ConnectionPtr ReverseProxy::takeIdle(size_t backend)
+{
+    auto &idle = pools_->getThreadData().idle[backend];
+    auto now = steadyMicroseconds();
+    while (!idle.empty())
+    {
+        auto connection = std::move(idle.back());
+        idle.pop_back();
+        if (connection->conn && connection->conn->connected() &&
+            now - connection->idleSince < idleTimeout_)
+            return connection;
+        connection->close();
+    }
+    return nullptr;
+}
+
+void ReverseProxy::putIdle(const ConnectionPtr &connection)
+{
+    auto &idle = pools_->getThreadData().idle[connection->backend];
+    auto now = steadyMicroseconds();
+    while (!idle.empty() && now - idle.front()->idleSince >= idleTimeout_)
+    {
+        auto stale = std::move(idle.front());
+        idle.erase(idle.begin());
+        stale->close();
+    }
+    if (idle.size() >= maxIdle_)
+    {
+        connection->close();
+        return;
+    }
+    connection->idleSince = now;
+    idle.push_back(connection);
+}
+
+void ReverseProxy::removeIdle(const ConnectionPtr &connection)
+{
+    auto &idle = pools_->getThreadData().idle[connection->backend];
+    auto it = std::find(idle.begin(), idle.end(), connection);
+    if (it != idle.end())
+        idle.erase(it);
+}
+
+ReverseProxy::ConnectionPtr ReverseProxy::newConnection(
+    size_t backend,
+    trantor::EventLoop *loop)
+{
+    auto &upstream = upstreams_[backend];
+    auto connection = std::make_shared<Connection>(backend);
+    connection->client = std::make_shared<trantor::TcpClient>(loop,
+                                                              upstream.address,
+                                                              "ReverseProxy");
+    if (upstream.ssl)
+    {
+        auto policy = trantor::TLSPolicy::defaultClientPolicy();
+        policy->setValidate(validateCert_).setHostname(upstream.domain);
+        connection->client->enableSSL(std::move(policy));
+    }
+    std::weak_ptr<Connection> weakConnection = connection;
+    auto onClosed = [this, weakConnection, loop]() {
+        auto connection = weakConnection.lock();
+        if (!connection)
+            return;
+        connection->conn.reset();
+        // The client can't be destroyed in its own callback
+        loop->queueInLoop([connection]() {});
+        auto exchange = std::move(connection->exchange);
+        connection->exchange.reset();
+        if (exchange)
+            exchange->onUpstreamClosed();
+        else
+            removeIdle(connection);
+    };
+    connection->client->setConnectionCallback(
+        [this, weakConnection, onClosed](
+            const trantor::TcpConnectionPtr &conn) {
+            if (!conn->connected())
+            {
+                onClosed();
+                return;
+            }
+            auto connection = weakConnection.lock();
+            if (!connection)
+                return;
+            connection->conn = conn;
+            conn->setHighWaterMarkCallback(
+                [weakConnection](const trantor::TcpConnectionPtr &, size_t) {
+                    auto connection = weakConnection.lock();
+                    if (connection && connection->exchange)
+                        connection->exchange->onUpstreamHigh();
+                },
+                highWatermark_);
+            conn->setWriteCompleteCallback(
+                [weakConnection](const trantor::TcpConnectionPtr &) {
+                    auto connection = weakConnection.lock();
+                    if (connection && connection->exchange)
+                        connection->exchange->onUpstreamDrained();
+                });
+            if (connection->exchange)
+                connection->exchange->onConnected();
+            else
+                connection->close();
+        });
+    connection->client->setConnectionErrorCallback(onClosed);
+    connection->client->setMessageCallback(
+        [weakConnection](const trantor::TcpConnectionPtr &conn,
+                         trantor::MsgBuffer *buf) {
+            auto connection = weakConnection.lock();
+            if (connection && connection->exchange)
+            {
+                auto exchange = connection->exchange;
+                exchange->onUpstreamData(buf);
+                return;
+            }
+            // Nothing is expected on an idle connection
+            buf->retrieveAll();
+            conn->forceClose();
+        });
+    return connection;
+}
@@ -0,0 +1,99 @@
+/**
+ *
+ *  @file RoutePlaceholders.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cctype>
+#include <string_view>
+
+namespace drogon
+{
+namespace internal
+{
+// The routes are parsed by hand rather than with std::regex, whose
+// construction and matching dominated the startup of the applications with
+// thousands of routes.
+
+/**
+ * Find the next {name} placeholder of a path from pos, like searching for
+ * \{([^/]*)\}: the first '{' followed by a '}' in its segment, up to the
+ * last '}' of the segment.
+ */
+inline bool nextPathPlaceholder(std::string_view path,
+                                size_t &pos,
+                                std::string_view &name)
+{
+    for (auto open = path.find('{', pos); open != std::string_view::npos;
+         open = path.find('{', open + 1))
+    {
+        auto segmentEnd = path.find('/', open + 1);
+        if (segmentEnd == std::string_view::npos)
+            segmentEnd = path.size();
+        auto close = path.rfind('}', segmentEnd - 1);
+        if (close != std::string_view::npos && close > open)
+        {
+            name = path.substr(open + 1, close - open - 1);
+            pos = close + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Find the next key={name} placeholder of a query from pos, like searching
+ * for ([^&]*)=\{([^&]*)\}&*.
+ */
+inline bool nextQueryPlaceholder(std::string_view query,
+                                 size_t &pos,
+                                 std::string_view &key,
+                                 std::string_view &name)
+{
+    while (pos < query.size())
+    {
+        auto end = query.find('&', pos);
+        if (end == std::string_view::npos)
+            end = query.size();
+        auto param = query.substr(pos, end - pos);
+        pos = end + 1;
+        auto close = param.rfind('}');
+        if (close == std::string_view::npos)
+            continue;
+        // The last "={" before the '}'
+        for (auto eq = param.rfind("={", close); eq != std::string_view::npos;)
+        {
+            if (eq + 1 < close)
+            {
+                key = param.substr(0, eq);
+                name = param.substr(eq + 2, close - eq - 2);
+                return true;
+            }
+            if (eq == 0)
+                break;
+            eq = param.rfind("={", eq - 1);
+        }
+    }
+    return false;
+}
+
+/// Whether the name of a placeholder is like ([0-9]+):.*
+inline bool isNumberAndName(std::string_view name)
+{
+    size_t digits = 0;
+    while (digits < name.size() &&
+           isdigit(static_cast<unsigned char>(name[digits])))
+        ++digits;
+    return digits > 0 && digits < name.size() && name[digits] == ':';
+}
+}  // namespace internal
+}  // namespace drogon
@@ -0,0 +1,301 @@
+/**
+ *
+ *  @file RouteTrie.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A segment-level trie used to route paths with parameter
+ * placeholders (e.g. /api/v1/user/{1}/info) without regular expressions.
+ *
+ * Every path segment (the text between two slashes) is one of:
+ *  - a static segment, matched case-insensitively;
+ *  - a placeholder segment like {1} or {id}, matching any segment;
+ *  - a mixed segment like {1}.json or v{version}, matching a segment with
+ *    the same literal prefix and suffix.
+ *
+ * The placeholder in a segment spans from its first '{' to its last '}',
+ * which is exactly what the ([^/]*) substitution in the former regex based
+ * router did. When matching, static children are preferred over mixed
+ * segments, which are preferred over placeholder segments. The trie
+ * backtracks when a branch fails, so the outcome only depends on the
+ * registered patterns and not on the registration order.
+ *
+ * Matching does not allocate: captured parameters are string_views into the
+ * path being matched.
+ */
+template <typename Item>
+class RouteTrie
+{
+  public:
+    /**
+     * @brief Get the item stored for the pattern, creating it if necessary.
+     *
+     * @param pattern The path pattern without the query part.
+     * @param created Set to true if a new item was created.
+     */
+    Item &insert(std::string_view pattern, bool &created)
+    {
+        Node *node = &root_;
+        forEachSegment(pattern, [&node](std::string_view segment) {
+            node = node->child(segment);
+        });
+        created = !node->item_;
+        if (created)
+        {
+            node->item_ = std::make_unique<Item>();
+            items_.push_back(node->item_.get());
+        }
+        return *node->item_;
+    }
+
+    /**
+     * @brief Find the item matching the path.
+     *
+     * @param path The request path.
+     * @param captures Receives the parameters captured by the placeholders,
+     * in the order they appear in the path.
+     * @param accept Called on every candidate item, the first one for which
+     * it returns true is returned.
+     *
+     * @return The matched item or nullptr if nothing matches.
+     */
+    template <typename Predicate>
+    Item *match(std::string_view path,
+                std::vector<std::string_view> &captures,
+                Predicate &&accept) const
+    {
+        captures.clear();
+        if (items_.empty())
+            return nullptr;
+        return root_.match(path, 0, captures, accept);
+    }
+
+    /**
+     * @brief Items in registration order.
+     */
+    const std::vector<Item *> &items() const
+    {
+        return items_;
+    }
+
+    bool empty() const
+    {
+        return items_.empty();
+    }
+
+    void clear()
+    {
+        root_ = Node();
+        items_.clear();
+    }
+
+  private:
+    static char toLower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static int compareNoCase(std::string_view a, std::string_view b)
+    {
+        auto len = std::min(a.length(), b.length());
+        for (size_t i = 0; i < len; ++i)
+        {
+            auto ca = static_cast<unsigned char>(toLower(a[i]));
+            auto cb = static_cast<unsigned char>(toLower(b[i]));
+            if (ca != cb)
+                return ca < cb ? -1 : 1;
+        }
+        if (a.length() == b.length())
+            return 0;
+        return a.length() < b.length() ? -1 : 1;
+    }
+
+    static bool equalsNoCase(std::string_view a, std::string_view b)
+    {
+        return a.length() == b.length() && compareNoCase(a, b) == 0;
+    }
+
+    static std::string lowered(std::string_view str)
+    {
+        std::string ret(str);
+        for (auto &c : ret)
+        {
+            c = toLower(c);
+        }
+        return ret;
+    }
+
+    template <typename Func>
+    static void forEachSegment(std::string_view path, Func &&func)
+    {
+        size_t pos = 0;
+        while (true)
+        {
+            auto next = path.find('/', pos);
+            if (next == std::string_view::npos)
+            {
+                func(path.substr(pos));
+                return;
+            }
+            func(path.substr(pos, next - pos));
+            pos = next + 1;
+        }
+    }
+
+    struct Node;
+
+    struct MixedSegment
+    {
+        std::string prefix_;
+        std::string suffix_;
+        std::unique_ptr<Node> node_;
+    };
+
+    struct Node
+    {
+        // Sorted by lowered segment for binary search
+        std::vector<std::pair<std::string, std::unique_ptr<Node>>> statics_;
+        std::vector<MixedSegment> mixed_;
+        std::unique_ptr<Node> param_;
+        std::unique_ptr<Item> item_;
+
+        Node *child(std::string_view segment)
+        {
+            auto open = segment.find('{');
+            auto close = segment.rfind('}');
+            if (open == std::string_view::npos ||
+                close == std::string_view::npos || close < open)
+            {
+                auto key = lowered(segment);
+                auto iter = std::lower_bound(
+                    statics_.begin(),
+                    statics_.end(),
+                    key,
+                    [](const auto &item, const std::string &k) {
+                        return item.first < k;
+                    });
+                if (iter == statics_.end() || iter->first != key)
+                {
+                    iter = statics_.emplace(iter,
+                                            std::move(key),
+                                            std::make_unique<Node>());
+                }
+                return iter->second.get();
+            }
+            if (open == 0 && close == segment.length() - 1)
+            {
+                if (!param_)
+                    param_ = std::make_unique<Node>();
+                return param_.get();
+            }
+            auto prefix = lowered(segment.substr(0, open));
+            auto suffix = lowered(segment.substr(close + 1));
+            for (auto &m : mixed_)
+            {
+                if (m.prefix_ == prefix && m.suffix_ == suffix)
+                    return m.node_.get();
+            }
+            MixedSegment m;
+            m.prefix_ = std::move(prefix);
+            m.suffix_ = std::move(suffix);
+            m.node_ = std::make_unique<Node>();
+            // Keep the most specific (longest literal) segments first
+            auto pos = std::find_if(mixed_.begin(),
+                                    mixed_.end(),
+                                    [&m](const MixedSegment &other) {
+                                        return other.prefix_.length() +
+                                                   other.suffix_.length() <
+                                               m.prefix_.length() +
+                                                   m.suffix_.length();
+                                    });
+            return mixed_.insert(pos, std::move(m))->node_.get();
+        }
+
+        template <typename Predicate>
+        Item *match(std::string_view path,
+                    size_t pos,
+                    std::vector<std::string_view> &captures,
+                    Predicate &accept) const
+        {
+            if (pos > path.length())
+            {
+                if (item_ && accept(*item_))
+                    return item_.get();
+                return nullptr;
+            }
+            auto next = path.find('/', pos);
+            if (next == std::string_view::npos)
+                next = path.length();
+            auto segment = path.substr(pos, next - pos);
+            auto nextPos = next + 1;
+
+            if (!statics_.empty())
+            {
+                auto iter = std::lower_bound(
+                    statics_.begin(),
+                    statics_.end(),
+                    segment,
+                    [](const auto &item, std::string_view seg) {
+                        return compareNoCase(item.first, seg) < 0;
+                    });
+                if (iter != statics_.end() &&
+                    equalsNoCase(iter->first, segment))
+                {
+                    if (auto ret = iter->second->match(path,
+                                                       nextPos,
+                                                       captures,
+                                                       accept))
+                        return ret;
+                }
+            }
+            for (auto &m : mixed_)
+            {
+                auto literalLength = m.prefix_.length() + m.suffix_.length();
+                if (segment.length() < literalLength ||
+                    !equalsNoCase(segment.substr(0, m.prefix_.length()),
+                                  m.prefix_) ||
+                    !equalsNoCase(segment.substr(segment.length() -
+                                                 m.suffix_.length()),
+                                  m.suffix_))
+                    continue;
+                captures.push_back(
+                    segment.substr(m.prefix_.length(),
+                                   segment.length() - literalLength));
+                if (auto ret = m.node_->match(path, nextPos, captures, accept))
+                    return ret;
+                captures.pop_back();
+            }
+            if (param_)
+            {
+                captures.push_back(segment);
+                if (auto ret = param_->match(path, nextPos, captures, accept))
+                    return ret;
+                captures.pop_back();
+            }
+            return nullptr;
+        }
+    };
+
+    Node root_;
+    std::vector<Item *> items_;
+};
+}  // namespace drogon
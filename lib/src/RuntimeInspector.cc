@@ -0,0 +1,105 @@
+/**
+ *
+ *  @file RuntimeInspector.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/RuntimeInspector.h>
+#include <drogon/HttpAppFramework.h>
+#include "AdminAuth.h"
+#include "HttpAppFrameworkImpl.h"
+#include "LiveConnections.h"
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+static Json::Value clientsState()
+{
+    auto &framework = HttpAppFrameworkImpl::instance();
+    Json::Value state;
+    Json::Value dbClients(Json::objectValue);
+    for (auto &[name, client] : framework.dbClients())
+    {
+        auto status = client->poolStatus();
+        Json::Value item;
+        item["connections"] = static_cast<Json::UInt64>(status.connections);
+        item["busy"] = static_cast<Json::UInt64>(status.busy);
+        item["idle"] = static_cast<Json::UInt64>(status.idle);
+        item["queued"] = static_cast<Json::UInt64>(status.queued);
+        item["queued_transactions"] =
+            static_cast<Json::UInt64>(status.queuedTransactions);
+        dbClients[name] = std::move(item);
+    }
+    state["db_clients"] = std::move(dbClients);
+    Json::Value redisClients(Json::objectValue);
+    for (auto &[name, client] : framework.redisClients())
+    {
+        auto status = client->poolStatus();
+        Json::Value item;
+        item["connections"] = static_cast<Json::UInt64>(status.connections);
+        item["ready"] = static_cast<Json::UInt64>(status.ready);
+        item["queued"] = static_cast<Json::UInt64>(status.queued);
+        item["unanswered"] = static_cast<Json::UInt64>(status.unanswered);
+        redisClients[name] = std::move(item);
+    }
+    state["redis_clients"] = std::move(redisClients);
+    state["sessions"] = static_cast<Json::UInt64>(framework.sessionCount());
+    return state;
+}
+
+void RuntimeInspector::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    token_ = config.get("token", token_).asString();
+    maxListedConnections_ = static_cast<size_t>(
+        config
+            .get("max_listed_connections",
+                 static_cast<Json::UInt64>(maxListedConnections_))
+            .asUInt64());
+
+    // Called before the listeners start, so all the connections are seen
+    std::vector<trantor::EventLoop *> loops;
+    for (size_t i = 0; i < app().getThreadNum(); ++i)
+        loops.push_back(app().getIOLoop(i));
+    LiveConnections::instance().enable(loops);
+
+    std::weak_ptr<RuntimeInspector> weakPtr = shared_from_this();
+    app().registerHandler(
+        path_,
+        [weakPtr](const HttpRequestPtr &req,
+                  std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                callback(HttpResponse::newNotFoundResponse(req));
+                return;
+            }
+            if (!isAdminRequest(req, thisPtr->token_))
+            {
+                auto resp = HttpResponse::newHttpResponse();
+                resp->setStatusCode(k401Unauthorized);
+                if (!thisPtr->token_.empty())
+                    resp->addHeader("www-authenticate", "Bearer");
+                callback(resp);
+                return;
+            }
+            auto state = std::make_shared<Json::Value>(clientsState());
+            LiveConnections::instance().snapshot(
+                thisPtr->maxListedConnections_,
+                [state, callback = std::move(callback)](Json::Value &&loops) {
+                    (*state)["loops"] = std::move(loops);
+                    auto resp = HttpResponse::newHttpJsonResponse(*state);
+                    resp->setExpiredTime(-1);
+                    callback(resp);
+                });
+        },
+        {Get},
+        "RuntimeInspector");
+}
@@ -0,0 +1,179 @@
+/**
+ *
+ *  @file SecureRandom.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SecureRandom.h"
+#include <trantor/utils/Utilities.h>
+#include <atomic>
+#include <cstring>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+// Incremented in the child processes, whose generators must not hand out the
+// bytes the parent hands out too
+std::atomic<uint64_t> forkGeneration{0};
+
+inline uint32_t rotl(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+inline void quarterRound(uint32_t *x, int a, int b, int c, int d)
+{
+    x[a] += x[b];
+    x[d] = rotl(x[d] ^ x[a], 16);
+    x[c] += x[d];
+    x[b] = rotl(x[b] ^ x[c], 12);
+    x[a] += x[b];
+    x[d] = rotl(x[d] ^ x[a], 8);
+    x[c] += x[d];
+    x[b] = rotl(x[b] ^ x[c], 7);
+}
+
+// Wipe the memory even though it is not read afterwards
+void secureZero(void *ptr, size_t size)
+{
+    volatile unsigned char *p = static_cast<volatile unsigned char *>(ptr);
+    while (size--)
+        *p++ = 0;
+}
+}  // namespace
+
+ChaChaRandom &ChaChaRandom::instance()
+{
+#ifndef _WIN32
+    static const int registered = pthread_atfork(nullptr, nullptr, []() {
+        forkGeneration.fetch_add(1, std::memory_order_relaxed);
+    });
+    (void)registered;
+#endif
+    thread_local ChaChaRandom generator;
+    return generator;
+}
+
+ChaChaRandom::~ChaChaRandom()
+{
+    secureZero(key_, sizeof(key_));
+    secureZero(buffer_, sizeof(buffer_));
+}
+
+void ChaChaRandom::block(const uint32_t key[8],
+                         uint32_t counter,
+                         const uint32_t nonce[3],
+                         unsigned char *out)
+{
+    uint32_t state[16] = {0x61707865,
+                          0x3320646e,
+                          0x79622d32,
+                          0x6b206574,
+                          key[0],
+                          key[1],
+                          key[2],
+                          key[3],
+                          key[4],
+                          key[5],
+                          key[6],
+                          key[7],
+                          counter,
+                          nonce[0],
+                          nonce[1],
+                          nonce[2]};
+    uint32_t x[16];
+    memcpy(x, state, sizeof(x));
+    for (int i = 0; i < 10; ++i)
+    {
+        quarterRound(x, 0, 4, 8, 12);
+        quarterRound(x, 1, 5, 9, 13);
+        quarterRound(x, 2, 6, 10, 14);
+        quarterRound(x, 3, 7, 11, 15);
+        quarterRound(x, 0, 5, 10, 15);
+        quarterRound(x, 1, 6, 11, 12);
+        quarterRound(x, 2, 7, 8, 13);
+        quarterRound(x, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t word = x[i] + state[i];
+        for (int j = 0; j < 4; ++j)
+            out[i * 4 + j] = static_cast<unsigned char>(word >> (8 * j));
+    }
+}
+
+bool ChaChaRandom::reseed()
+{
+    uint32_t seed[8];
+    if (!trantor::utils::secureRandomBytes(seed, sizeof(seed)))
+        return false;
+    for (int i = 0; i < 8; ++i)
+        key_[i] ^= seed[i];
+    secureZero(seed, sizeof(seed));
+    secureZero(buffer_, sizeof(buffer_));
+    available_ = 0;
+    refills_ = 0;
+    seeded_ = true;
+    return true;
+}
+
+bool ChaChaRandom::refill()
+{
+    auto generation = forkGeneration.load(std::memory_order_relaxed);
+    if (!seeded_ || generation != forkGeneration_ || refills_ >= 4096)
+    {
+        // Keep using the current key if the OS fails to give bytes after
+        // the generator was seeded once, it is still unpredictable
+        if (!reseed() && (!seeded_ || generation != forkGeneration_))
+            return false;
+        forkGeneration_ = generation;
+    }
+    // The key changes on every refill, so the nonce and the counters don't
+    // need to
+    static const uint32_t nonce[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < kBufferSize / 64; ++i)
+        block(key_, i, nonce, buffer_ + i * 64);
+    for (int i = 0; i < 8; ++i)
+    {
+        key_[i] = uint32_t(buffer_[i * 4]) |
+                  (uint32_t(buffer_[i * 4 + 1]) << 8) |
+                  (uint32_t(buffer_[i * 4 + 2]) << 16) |
+                  (uint32_t(buffer_[i * 4 + 3]) << 24);
+    }
+    secureZero(buffer_, sizeof(key_));
+    available_ = kBufferSize - sizeof(key_);
+    ++refills_;
+    return true;
+}
+
+bool ChaChaRandom::fill(void *ptr, size_t size)
+{
+    auto out = static_cast<unsigned char *>(ptr);
+    if (forkGeneration.load(std::memory_order_relaxed) != forkGeneration_)
+        available_ = 0;
+    while (size > 0)
+    {
+        if (available_ == 0 && !refill())
+            return false;
+        size_t n = size < available_ ? size : available_;
+        // The bytes after the next key are handed out in order
+        auto src = buffer_ + kBufferSize - available_;
+        memcpy(out, src, n);
+        secureZero(src, n);
+        available_ -= n;
+        out += n;
+        size -= n;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+/**
+ *
+ *  @file SecureRandom.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace drogon
+{
+/**
+ * @brief A ChaCha20 random generator per thread, behind
+ * utils::secureRandomBytes() and the other random helpers.
+ *
+ * The key is read from the OS when a thread first asks for bytes. Every
+ * refill computes four blocks of the keystream, the first 32 bytes become the
+ * next key and the others are handed out, so the bytes given before can't be
+ * recovered from the state of the generator (fast key erasure). Bytes are
+ * erased from the buffer as they are handed out. The key is mixed with bytes
+ * from the OS again after a fork and every 4096 refills.
+ */
+class ChaChaRandom : public trantor::NonCopyable
+{
+  public:
+    /// The generator of the calling thread
+    static ChaChaRandom &instance();
+
+    /// Return false if the OS gave no bytes to seed the generator.
+    bool fill(void *ptr, size_t size);
+
+    /// Compute one 64 bytes block of the ChaCha20 keystream (RFC 8439).
+    static void block(const uint32_t key[8],
+                      uint32_t counter,
+                      const uint32_t nonce[3],
+                      unsigned char *out);
+
+    ~ChaChaRandom();
+
+  private:
+    ChaChaRandom() = default;
+    bool reseed();
+    bool refill();
+
+    static constexpr size_t kBufferSize = 256;
+    uint32_t key_[8]{};
+    unsigned char buffer_[kBufferSize];
+    size_t available_{0};
+    size_t refills_{0};
+    uint64_t forkGeneration_{0};
+    bool seeded_{false};
+};
+}  // namespace drogon
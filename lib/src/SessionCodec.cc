@@ -0,0 +1,142 @@
+/**
+ *
+ *  @file SessionCodec.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SessionCodec.h"
+#include <json/json.h>
+#include <memory>
+#include <mutex>
+
+using namespace drogon;
+
+namespace
+{
+// Every value is kept as [type name, value], so it is restored as the same
+// type and Session::get<T>() still finds it.
+template <typename T>
+bool encodeAs(const std::any &value, const char *name, Json::Value &out)
+{
+    auto ptr = std::any_cast<T>(&value);
+    if (!ptr)
+        return false;
+    out.append(name);
+    if constexpr (std::is_same_v<T, long> || std::is_same_v<T, long long>)
+        out.append(static_cast<Json::Int64>(*ptr));
+    else if constexpr (std::is_same_v<T, unsigned long> ||
+                       std::is_same_v<T, unsigned long long>)
+        out.append(static_cast<Json::UInt64>(*ptr));
+    else
+        out.append(*ptr);
+    return true;
+}
+
+bool encode(const std::any &value, Json::Value &out)
+{
+    return encodeAs<std::string>(value, "string", out) ||
+           encodeAs<bool>(value, "bool", out) ||
+           encodeAs<int>(value, "int", out) ||
+           encodeAs<unsigned int>(value, "uint", out) ||
+           encodeAs<long>(value, "long", out) ||
+           encodeAs<unsigned long>(value, "ulong", out) ||
+           encodeAs<long long>(value, "llong", out) ||
+           encodeAs<unsigned long long>(value, "ullong", out) ||
+           encodeAs<float>(value, "float", out) ||
+           encodeAs<double>(value, "double", out) ||
+           encodeAs<Json::Value>(value, "json", out);
+}
+
+bool decode(const Json::Value &item, std::any &value)
+{
+    if (!item.isArray() || item.size() != 2 || !item[0].isString())
+        return false;
+    const auto &type = item[0].asString();
+    const auto &v = item[1];
+    if (type == "string" && v.isString())
+        value = v.asString();
+    else if (type == "bool" && v.isBool())
+        value = v.asBool();
+    else if (type == "int" && v.isInt())
+        value = v.asInt();
+    else if (type == "uint" && v.isUInt())
+        value = v.asUInt();
+    else if (type == "long" && v.isInt64())
+        value = static_cast<long>(v.asInt64());
+    else if (type == "ulong" && v.isUInt64())
+        value = static_cast<unsigned long>(v.asUInt64());
+    else if (type == "llong" && v.isInt64())
+        value = static_cast<long long>(v.asInt64());
+    else if (type == "ullong" && v.isUInt64())
+        value = static_cast<unsigned long long>(v.asUInt64());
+    else if (type == "float" && v.isNumeric())
+        value = v.asFloat();
+    else if (type == "double" && v.isNumeric())
+        value = v.asDouble();
+    else if (type == "json")
+        value = v;
+    else
+        return false;
+    return true;
+}
+}  // namespace
+
+std::string drogon::serializeSessionData(const Session::SessionMap &data)
+{
+    static std::once_flag once;
+    static Json::StreamWriterBuilder builder;
+    std::call_once(once, []() {
+        builder["commentStyle"] = "None";
+        builder["indentation"] = "";
+        builder["emitUTF8"] = true;
+    });
+    Json::Value root(Json::objectValue);
+    for (auto const &[key, value] : data)
+    {
+        Json::Value item(Json::arrayValue);
+        if (!encode(value, item))
+        {
+            LOG_ERROR << "The session data '" << key << "' of the type "
+                      << value.type().name()
+                      << " can't be saved to the session store";
+            continue;
+        }
+        root[key] = std::move(item);
+    }
+    return Json::writeString(builder, root);
+}
+
+bool drogon::deserializeSessionData(const std::string &str,
+                                    Session::SessionMap &data)
+{
+    static std::once_flag once;
+    static Json::CharReaderBuilder builder;
+    std::call_once(once, []() { builder["collectComments"] = false; });
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value root;
+    JSONCPP_STRING errs;
+    if (!reader->parse(str.data(), str.data() + str.size(), &root, &errs) ||
+        !root.isObject())
+    {
+        LOG_ERROR << "Bad session data: " << errs;
+        return false;
+    }
+    for (auto it = root.begin(); it != root.end(); ++it)
+    {
+        std::any value;
+        if (!decode(*it, value))
+        {
+            LOG_ERROR << "Bad session data: " << it.name();
+            return false;
+        }
+        data[it.name()] = std::move(value);
+    }
+    return true;
+}
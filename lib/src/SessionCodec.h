@@ -0,0 +1,35 @@
+/**
+ *
+ *  @file SessionCodec.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/Session.h>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief Serialize the data of a session to be kept in a session store.
+ *
+ * Only the values of the types which can be restored are serialized:
+ * std::string, bool, the integers, float, double and Json::Value. The others
+ * are skipped with an error log.
+ */
+std::string serializeSessionData(const Session::SessionMap &data);
+
+/**
+ * @brief Restore the data serialized by serializeSessionData(), return false
+ * if the string is malformed.
+ */
+bool deserializeSessionData(const std::string &str, Session::SessionMap &data);
+}  // namespace drogon
@@ -13,6 +13,7 @@
  */
 
 #include "SessionManager.h"
+#include "SessionCodec.h"
 
 using namespace drogon;
 
@@ -21,72 +22,45 @@ SessionManager::SessionManager(
     size_t timeout,
     const std::vector<AdviceStartSessionCallback> &startAdvices,
     const std::vector<AdviceDestroySessionCallback> &destroyAdvices,
-    IdGeneratorCallback idGeneratorCallback)
-    : loop_(loop),
+    IdGeneratorCallback idGeneratorCallback,
+    SessionStorePtr store,
+    size_t nearCacheTtl,
+    bool copyOnWrite)
+    : store_(std::move(store)),
+      nearCacheTtl_(nearCacheTtl),
+      copyOnWrite_(copyOnWrite),
+      loop_(loop),
       timeout_(timeout),
       sessionStartAdvices_(startAdvices),
       sessionDestroyAdvices_(destroyAdvices),
       idGeneratorCallback_(idGeneratorCallback)
 {
-    if (timeout_ > 0)
+    if (store_)
     {
-        size_t wheelNum = 1;
-        size_t bucketNum = 0;
-        if (timeout_ < 500)
-        {
-            bucketNum = timeout_ + 1;
-        }
-        else
-        {
-            auto tmpTimeout = timeout_;
-            bucketNum = 100;
-            while (tmpTimeout > 100)
+        // The sessions expire in the store, the near cache only keeps the
+        // recently used ones for a short time.
+        if (nearCacheTtl_ > 0)
+            nearCachePtr_ = std::make_unique<NearCache>(loop_, 1.0f);
+        return;
+    }
+    // The wheel of the sharded map takes as many turns as the timeout needs
+    sessionMapPtr_ = std::make_unique<SessionMap>(
+        loop_,
+        timeout_ > 0 ? 1.0f : 0.0f,
+        SessionMap::kDefaultBucketsNum,
+        SessionMap::kDefaultShardsNum,
+        [this](const std::string &key) {
+            for (auto &advice : sessionStartAdvices_)
             {
-                ++wheelNum;
-                tmpTimeout = tmpTimeout / 100;
+                advice(key);
             }
-        }
-
-        sessionMapPtr_ = std::unique_ptr<CacheMap<std::string, SessionPtr>>(
-            new CacheMap<std::string, SessionPtr>(
-                loop_,
-                1.0,
-                wheelNum,
-                bucketNum,
-                [this](const std::string &key) {
-                    for (auto &advice : sessionStartAdvices_)
-                    {
-                        advice(key);
-                    }
-                },
-                [this](const std::string &key) {
-                    for (auto &advice : sessionDestroyAdvices_)
-                    {
-                        advice(key);
-                    }
-                }));
-    }
-    else if (timeout_ == 0)
-    {
-        sessionMapPtr_ = std::unique_ptr<CacheMap<std::string, SessionPtr>>(
-            new CacheMap<std::string, SessionPtr>(
-                loop_,
-                0,
-                0,
-                0,
-                [this](const std::string &key) {
-                    for (auto &advice : sessionStartAdvices_)
-                    {
-                        advice(key);
-                    }
-                },
-                [this](const std::string &key) {
-                    for (auto &advice : sessionDestroyAdvices_)
-                    {
-                        advice(key);
-                    }
-                }));
-    }
+        },
+        [this](const std::string &key) {
+            for (auto &advice : sessionDestroyAdvices_)
+            {
+                advice(key);
+            }
+        });
 }
 
 SessionPtr SessionManager::getSession(const std::string &sessionID,
@@ -94,17 +68,45 @@ SessionPtr SessionManager::getSession(const std::string &sessionID,
 {
     assert(!sessionID.empty());
     SessionPtr sessionPtr;
+    if (store_)
+    {
+        if (needToSet)
+        {
+            // A new ID, no need to look for it in the store
+            sessionPtr = std::shared_ptr<Session>(
+                new Session(sessionID, needToSet, copyOnWrite_));
+            for (auto &advice : sessionStartAdvices_)
+            {
+                advice(sessionID);
+            }
+            if (nearCachePtr_)
+                nearCachePtr_->insert(sessionID,
+                                      CachedSession{sessionPtr,
+                                                    trantor::Date::now()},
+                                      nearCacheTtl_);
+            return sessionPtr;
+        }
+        CachedSession cached;
+        if (nearCachePtr_ && nearCachePtr_->findAndFetch(sessionID, cached) &&
+            trantor::Date::now() < cached.loaded.after(nearCacheTtl_))
+        {
+            return cached.session;
+        }
+        // Stale or not cached, load it from the store
+        return nullptr;
+    }
     sessionMapPtr_->modify(
         sessionID,
-        [&sessionPtr, &sessionID, needToSet](SessionPtr &sessionInCache) {
+        [this, &sessionPtr, &sessionID, needToSet](
+            SessionPtr &sessionInCache) {
             if (sessionInCache)
             {
                 sessionPtr = sessionInCache;
             }
             else
             {
-                sessionPtr =
-                    std::shared_ptr<Session>(new Session(sessionID, needToSet));
+                sessionPtr = std::shared_ptr<Session>(
+                    new Session(sessionID, needToSet, copyOnWrite_));
                 sessionInCache = sessionPtr;
             }
         },
@@ -113,11 +115,78 @@ SessionPtr SessionManager::getSession(const std::string &sessionID,
     return sessionPtr;
 }
 
+void SessionManager::loadSession(
+    const std::string &sessionID,
+    std::function<void(const SessionPtr &)> &&callback)
+{
+    assert(store_);
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    assert(loop);
+    store_->load(
+        sessionID,
+        timeout_,
+        [this, loop, sessionID, callback = std::move(callback)](
+            std::optional<std::string> &&data) mutable {
+            auto sessionPtr = std::shared_ptr<Session>(
+                new Session(sessionID, false, copyOnWrite_));
+            Session::SessionMap sessionData;
+            if (data && deserializeSessionData(*data, sessionData))
+            {
+                sessionPtr->setData(std::move(sessionData));
+            }
+            else
+            {
+                // Unknown or expired, start a new session with the ID like
+                // the local sessions do.
+                for (auto &advice : sessionStartAdvices_)
+                {
+                    advice(sessionID);
+                }
+            }
+            if (nearCachePtr_)
+                nearCachePtr_->insert(sessionID,
+                                      CachedSession{sessionPtr,
+                                                    trantor::Date::now()},
+                                      nearCacheTtl_);
+            loop->queueInLoop(
+                [callback = std::move(callback),
+                 sessionPtr = std::move(sessionPtr)]() {
+                    callback(sessionPtr);
+                });
+        });
+}
+
+void SessionManager::saveSession(const SessionPtr &sessionPtr)
+{
+    if (!store_ || !sessionPtr->takeDirty())
+        return;
+    std::string data;
+    sessionPtr->visit([&data](const Session::SessionMap &sessionData) {
+        data = serializeSessionData(sessionData);
+    });
+    store_->save(sessionPtr->sessionId(), data, timeout_);
+}
+
 void SessionManager::changeSessionId(const SessionPtr &sessionPtr)
 {
     auto oldId = sessionPtr->sessionId();
     auto newId = idGeneratorCallback_();
     sessionPtr->setSessionId(newId);
+    if (store_)
+    {
+        // Written to the store with the new ID by saveSession()
+        sessionPtr->dirty_ = true;
+        if (nearCachePtr_)
+            nearCachePtr_->insert(newId,
+                                  CachedSession{sessionPtr,
+                                                trantor::Date::now()},
+                                  nearCacheTtl_);
+        loop_->runAfter(10, [store = store_, oldId = std::move(oldId)]() {
+            LOG_TRACE << "remove the old slot of the session";
+            store->erase(oldId);
+        });
+        return;
+    }
     sessionMapPtr_->insert(newId, sessionPtr, timeout_);
     // For requests sent before setting the new session ID to the client, we
     // reserve the old session slot for a period of time.
@@ -16,9 +16,11 @@
 
 #include <drogon/Session.h>
 #include <drogon/drogon_callbacks.h>
-#include <drogon/CacheMap.h>
+#include <drogon/SessionStore.h>
+#include <drogon/ShardedCacheMap.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoop.h>
+#include <trantor/utils/Date.h>
 #include <functional>
 #include <memory>
 #include <string>
@@ -37,18 +39,59 @@ class SessionManager : public trantor::NonCopyable
         size_t timeout,
         const std::vector<AdviceStartSessionCallback> &startAdvices,
         const std::vector<AdviceDestroySessionCallback> &destroyAdvices,
-        IdGeneratorCallback idGeneratorCallback);
+        IdGeneratorCallback idGeneratorCallback,
+        SessionStorePtr store = nullptr,
+        size_t nearCacheTtl = 0,
+        bool copyOnWrite = false);
 
     ~SessionManager()
     {
         sessionMapPtr_.reset();
+        nearCachePtr_.reset();
     }
 
+    /**
+     * @brief Return the session, or nullptr if it has to be loaded from the
+     * session store by loadSession().
+     */
     SessionPtr getSession(const std::string &sessionID, bool needToSet);
+
+    /**
+     * @brief Load the session from the store, the callback is called in the
+     * current thread.
+     */
+    void loadSession(const std::string &sessionID,
+                     std::function<void(const SessionPtr &)> &&callback);
+
+    /// Write the session back to the store if its data has been changed.
+    void saveSession(const SessionPtr &sessionPtr);
+
     void changeSessionId(const SessionPtr &sessionPtr);
 
+    /// The sessions held in memory, the ones of the near cache with a store
+    size_t sessionCount()
+    {
+        if (sessionMapPtr_)
+            return sessionMapPtr_->size();
+        return nearCachePtr_ ? nearCachePtr_->size() : 0;
+    }
+
   private:
-    std::unique_ptr<CacheMap<std::string, SessionPtr>> sessionMapPtr_;
+    using SessionMap = ShardedCacheMap<std::string, SessionPtr>;
+
+    /// A session loaded from the store and when it was loaded
+    struct CachedSession
+    {
+        SessionPtr session;
+        trantor::Date loaded;
+    };
+
+    using NearCache = ShardedCacheMap<std::string, CachedSession>;
+    std::unique_ptr<SessionMap> sessionMapPtr_;
+    std::unique_ptr<NearCache> nearCachePtr_;
+    SessionStorePtr store_;
+    size_t nearCacheTtl_;
+    bool copyOnWrite_;
     trantor::EventLoop *loop_;
     size_t timeout_;
     const std::vector<AdviceStartSessionCallback> &sessionStartAdvices_;
@@ -0,0 +1,482 @@
+/**
+ *
+ *  @file SharedMemoryMap.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/SharedMemoryMap.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#ifdef __linux__
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+
+struct SharedMemoryMap::Header
+{
+    char magic[8];
+    uint64_t capacity;
+    uint64_t slotSize;
+    // The slot being written, repaired by the next writer if its writer dies
+    int64_t writing;
+#ifdef __linux__
+    pthread_mutex_t mutex;
+#endif
+};
+
+// Followed by the key and the value
+struct SharedMemoryMap::Slot
+{
+    // Odd while the slot is written
+    std::atomic<uint32_t> sequence;
+    uint8_t state;
+    uint8_t reserved;
+    uint16_t keyLength;
+    uint32_t valueLength;
+    uint32_t reserved2;
+    uint64_t hash;
+    // Milliseconds since the epoch, 0 if the entry never expires
+    int64_t expiry;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "The sequences of the slots are shared by the processes");
+
+namespace
+{
+constexpr char kMagic[8] = {'D', 'R', 'S', 'H', 'M', 'A', 'P', '1'};
+constexpr uint8_t kEmpty = 0;
+constexpr uint8_t kUsed = 1;
+constexpr uint8_t kDeleted = 2;
+// The slots after the one the hash points to in which a key may be
+constexpr size_t kMaxProbes = 32;
+// A slot written for longer is the one of a writer which died
+constexpr int kMaxReadAttempts = 1000;
+constexpr size_t kHeaderSize = 256;
+
+// FNV-1a, the same in every process
+uint64_t hashOf(std::string_view key)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+int64_t expiryOf(size_t timeout)
+{
+    return timeout == 0 ? 0 : now() + static_cast<int64_t>(timeout) * 1000;
+}
+
+bool expired(int64_t expiry, int64_t time)
+{
+    return expiry != 0 && expiry <= time;
+}
+}  // namespace
+
+class SharedMemoryMap::WriteLock
+{
+  public:
+    explicit WriteLock(SharedMemoryMap &map) : map_(map)
+    {
+#ifdef __linux__
+        auto header = map_.header_;
+        if (pthread_mutex_lock(&header->mutex) == EOWNERDEAD)
+        {
+            // The previous writer died, maybe in the middle of a slot
+            if (header->writing >= 0)
+            {
+                auto slot = map_.slotAt(static_cast<size_t>(header->writing));
+                slot->state = kDeleted;
+                auto sequence = slot->sequence.load(std::memory_order_relaxed);
+                if (sequence & 1)
+                    slot->sequence.store(sequence + 1,
+                                         std::memory_order_release);
+                header->writing = -1;
+            }
+            pthread_mutex_consistent(&header->mutex);
+        }
+#endif
+    }
+
+    ~WriteLock()
+    {
+#ifdef __linux__
+        pthread_mutex_unlock(&map_.header_->mutex);
+#endif
+    }
+
+  private:
+    SharedMemoryMap &map_;
+};
+
+SharedMemoryMap::SharedMemoryMap(const std::string &path,
+                                 size_t capacity,
+                                 size_t slotSize)
+    : capacity_(capacity), slotSize_((slotSize + 7) / 8 * 8)
+{
+    static_assert(sizeof(Header) <= kHeaderSize,
+                  "The header must fit before the slots");
+    if (capacity_ == 0 || slotSize_ <= sizeof(Slot))
+    {
+        throw std::runtime_error(
+            "The slots of a SharedMemoryMap must be greater than 32 bytes");
+    }
+#ifdef __linux__
+    mappedSize_ = kHeaderSize + capacity_ * slotSize_;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Can't open " + path + ": " +
+                                 strerror(errno));
+    }
+    auto fail = [this, fd, &path](const std::string &reason) {
+        if (header_)
+            ::munmap(header_, mappedSize_);
+        header_ = nullptr;
+        ::close(fd);
+        throw std::runtime_error("Can't map " + path + ": " + reason);
+    };
+    // The file is initialized by the first process which opens it
+    ::flock(fd, LOCK_EX);
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+        fail(strerror(errno));
+    bool created = st.st_size == 0;
+    if (created && ::ftruncate(fd, static_cast<off_t>(mappedSize_)) != 0)
+        fail(strerror(errno));
+    if (!created && static_cast<size_t>(st.st_size) != mappedSize_)
+        fail("it was created with another capacity or slot size");
+    auto mapped = ::mmap(nullptr,
+                         mappedSize_,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED,
+                         fd,
+                         0);
+    if (mapped == MAP_FAILED)
+        fail(strerror(errno));
+    header_ = static_cast<Header *>(mapped);
+    slots_ = static_cast<char *>(mapped) + kHeaderSize;
+    if (created || memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0)
+    {
+        // Also when the process which created the file died before
+        memset(mapped, 0, mappedSize_);
+        header_->capacity = capacity_;
+        header_->slotSize = slotSize_;
+        header_->writing = -1;
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header_->mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+        memcpy(header_->magic, kMagic, sizeof(kMagic));
+    }
+    else if (header_->capacity != capacity_ || header_->slotSize != slotSize_)
+    {
+        fail("it was created with another capacity or slot size");
+    }
+    ::flock(fd, LOCK_UN);
+    ::close(fd);
+#else
+    (void)path;
+    throw std::runtime_error("SharedMemoryMap is only supported on Linux");
+#endif
+}
+
+SharedMemoryMap::~SharedMemoryMap()
+{
+#ifdef __linux__
+    if (header_)
+        ::munmap(header_, mappedSize_);
+#endif
+}
+
+size_t SharedMemoryMap::maxEntrySize() const
+{
+    return slotSize_ - sizeof(Slot);
+}
+
+SharedMemoryMap::Slot *SharedMemoryMap::slotAt(size_t index) const
+{
+    return reinterpret_cast<Slot *>(slots_ + index * slotSize_);
+}
+
+bool SharedMemoryMap::lookup(std::string_view key, std::string *value) const
+{
+    if (key.size() > maxEntrySize())
+        return false;
+    auto hash = hashOf(key);
+    auto time = now();
+    for (size_t probe = 0; probe < kMaxProbes && probe < capacity_; ++probe)
+    {
+        auto slot = slotAt((hash + probe) % capacity_);
+        auto data = reinterpret_cast<const char *>(slot + 1);
+        for (int attempt = 0;; ++attempt)
+        {
+            if (attempt == kMaxReadAttempts)
+                return false;
+            auto sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            auto state = slot->state;
+            bool match = state == kUsed && slot->hash == hash &&
+                         slot->keyLength == key.size() &&
+                         memcmp(data, key.data(), key.size()) == 0;
+            bool live = match && !expired(slot->expiry, time);
+            if (live && value)
+            {
+                auto length = (std::min)(static_cast<size_t>(
+                                             slot->valueLength),
+                                         maxEntrySize() - key.size());
+                value->assign(data + key.size(), length);
+            }
+            // The slot was not changed while it was read
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) != sequence)
+                continue;
+            if (match)
+                return live;
+            if (state == kEmpty)
+                return false;
+            break;
+        }
+    }
+    return false;
+}
+
+int64_t SharedMemoryMap::locate(uint64_t hash,
+                                std::string_view key,
+                                int64_t *vacant) const
+{
+    int64_t reusable = -1;
+    int64_t victim = -1;
+    int64_t victimExpiry = 0;
+    auto time = now();
+    for (size_t probe = 0; probe < kMaxProbes && probe < capacity_; ++probe)
+    {
+        auto index = static_cast<int64_t>((hash + probe) % capacity_);
+        auto slot = slotAt(static_cast<size_t>(index));
+        if (slot->state == kEmpty)
+        {
+            if (reusable < 0)
+                reusable = index;
+            break;
+        }
+        if (slot->state == kDeleted)
+        {
+            if (reusable < 0)
+                reusable = index;
+            continue;
+        }
+        if (slot->hash == hash && slot->keyLength == key.size() &&
+            memcmp(slot + 1, key.data(), key.size()) == 0)
+            return index;
+        if (reusable < 0 && expired(slot->expiry, time))
+            reusable = index;
+        // The entry which expires first is evicted when all are used
+        auto expiry = slot->expiry == 0 ? std::numeric_limits<int64_t>::max()
+                                        : slot->expiry;
+        if (victim < 0 || expiry < victimExpiry)
+        {
+            victim = index;
+            victimExpiry = expiry;
+        }
+    }
+    if (vacant)
+        *vacant = reusable >= 0 ? reusable : victim;
+    return -1;
+}
+
+SharedMemoryMap::Slot *SharedMemoryMap::beginWrite(size_t index)
+{
+    auto slot = slotAt(index);
+    header_->writing = static_cast<int64_t>(index);
+    auto sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot;
+}
+
+void SharedMemoryMap::endWrite(Slot *slot)
+{
+    auto sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_release);
+    header_->writing = -1;
+}
+
+void SharedMemoryMap::write(size_t index,
+                            uint64_t hash,
+                            std::string_view key,
+                            std::string_view value,
+                            int64_t expiry)
+{
+    auto slot = beginWrite(index);
+    slot->state = kUsed;
+    slot->keyLength = static_cast<uint16_t>(key.size());
+    slot->valueLength = static_cast<uint32_t>(value.size());
+    slot->hash = hash;
+    slot->expiry = expiry;
+    auto data = reinterpret_cast<char *>(slot + 1);
+    memcpy(data, key.data(), key.size());
+    memcpy(data + key.size(), value.data(), value.size());
+    endWrite(slot);
+}
+
+void SharedMemoryMap::remove(size_t index)
+{
+    auto next = slotAt((index + 1) % capacity_);
+    // A deleted slot before an empty one ends the probes like an empty one
+    auto state = next->state == kEmpty ? kEmpty : kDeleted;
+    auto slot = beginWrite(index);
+    slot->state = state;
+    endWrite(slot);
+    while (state == kEmpty)
+    {
+        index = (index + capacity_ - 1) % capacity_;
+        if (slotAt(index)->state != kDeleted)
+            break;
+        slot = beginWrite(index);
+        slot->state = kEmpty;
+        endWrite(slot);
+    }
+}
+
+bool SharedMemoryMap::insert(std::string_view key,
+                             std::string_view value,
+                             size_t timeout)
+{
+    if (key.size() > std::numeric_limits<uint16_t>::max() ||
+        key.size() + value.size() > maxEntrySize())
+        return false;
+    auto hash = hashOf(key);
+    WriteLock lock(*this);
+    int64_t vacant = -1;
+    auto index = locate(hash, key, &vacant);
+    write(static_cast<size_t>(index >= 0 ? index : vacant),
+          hash,
+          key,
+          value,
+          expiryOf(timeout));
+    return true;
+}
+
+bool SharedMemoryMap::findAndFetch(std::string_view key,
+                                   std::string &value) const
+{
+    return lookup(key, &value);
+}
+
+bool SharedMemoryMap::find(std::string_view key) const
+{
+    return lookup(key, nullptr);
+}
+
+void SharedMemoryMap::erase(std::string_view key)
+{
+    if (key.size() > maxEntrySize())
+        return;
+    auto hash = hashOf(key);
+    WriteLock lock(*this);
+    auto index = locate(hash, key);
+    if (index >= 0)
+        remove(static_cast<size_t>(index));
+}
+
+bool SharedMemoryMap::touch(std::string_view key, size_t timeout)
+{
+    if (key.size() > maxEntrySize())
+        return false;
+    auto hash = hashOf(key);
+    WriteLock lock(*this);
+    auto index = locate(hash, key);
+    if (index < 0 || expired(slotAt(static_cast<size_t>(index))->expiry, now()))
+        return false;
+    auto slot = beginWrite(static_cast<size_t>(index));
+    slot->expiry = expiryOf(timeout);
+    endWrite(slot);
+    return true;
+}
+
+int64_t SharedMemoryMap::increment(std::string_view key,
+                                   int64_t delta,
+                                   size_t timeout)
+{
+    if (key.size() > std::numeric_limits<uint16_t>::max() ||
+        key.size() + sizeof(int64_t) > maxEntrySize())
+        return delta;
+    auto hash = hashOf(key);
+    WriteLock lock(*this);
+    int64_t vacant = -1;
+    auto index = locate(hash, key, &vacant);
+    if (index >= 0)
+    {
+        auto slot = slotAt(static_cast<size_t>(index));
+        auto data = reinterpret_cast<char *>(slot + 1) + key.size();
+        if (!expired(slot->expiry, now()) &&
+            slot->valueLength == sizeof(int64_t))
+        {
+            int64_t count;
+            memcpy(&count, data, sizeof(count));
+            count += delta;
+            beginWrite(static_cast<size_t>(index));
+            memcpy(data, &count, sizeof(count));
+            endWrite(slot);
+            return count;
+        }
+        vacant = index;
+    }
+    write(static_cast<size_t>(vacant),
+          hash,
+          key,
+          std::string_view(reinterpret_cast<const char *>(&delta),
+                           sizeof(delta)),
+          expiryOf(timeout));
+    return delta;
+}
+
+void SharedMemoryMap::clear()
+{
+    WriteLock lock(*this);
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+        if (slotAt(i)->state == kEmpty)
+            continue;
+        auto slot = beginWrite(i);
+        slot->state = kEmpty;
+        endWrite(slot);
+    }
+}
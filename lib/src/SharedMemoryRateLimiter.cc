@@ -0,0 +1,42 @@
+/**
+ *
+ *  @file SharedMemoryRateLimiter.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SharedMemoryRateLimiter.h"
+#include <cmath>
+
+using namespace drogon;
+
+SharedMemoryRateLimiter::SharedMemoryRateLimiter(
+    SharedMemoryMapPtr map,
+    std::string key,
+    size_t capacity,
+    std::chrono::duration<double> timeUnit)
+    : map_(std::move(map)),
+      key_(std::move(key)),
+      capacity_(capacity),
+      timeUnit_(timeUnit),
+      counterTimeout_(static_cast<size_t>(std::ceil(timeUnit.count())) + 1)
+{
+}
+
+bool SharedMemoryRateLimiter::isAllowed()
+{
+    // The same windows in every process
+    auto window = static_cast<int64_t>(
+        std::chrono::duration<double>(
+            std::chrono::system_clock::now().time_since_epoch()) /
+        timeUnit_);
+    auto count =
+        map_->increment(key_ + std::to_string(window), 1, counterTimeout_);
+    return count <= static_cast<int64_t>(capacity_);
+}
@@ -0,0 +1,49 @@
+/**
+ *
+ *  @file SharedMemoryRateLimiter.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/RateLimiter.h>
+#include <drogon/SharedMemoryMap.h>
+#include <chrono>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief A rate limiter shared by all the processes which map the same file.
+ *
+ * The requests of the current fixed window are counted by a counter of the
+ * map whose key is the key of the limiter and the index of the window since
+ * the epoch, so the processes agree on the windows without talking to each
+ * other.
+ */
+class SharedMemoryRateLimiter : public RateLimiter
+{
+  public:
+    SharedMemoryRateLimiter(SharedMemoryMapPtr map,
+                            std::string key,
+                            size_t capacity,
+                            std::chrono::duration<double> timeUnit);
+    bool isAllowed() override;
+    ~SharedMemoryRateLimiter() noexcept override = default;
+
+  private:
+    SharedMemoryMapPtr map_;
+    const std::string key_;
+    const size_t capacity_;
+    const std::chrono::duration<double> timeUnit_;
+    // The counters expire after their window
+    const size_t counterTimeout_;
+};
+}  // namespace drogon
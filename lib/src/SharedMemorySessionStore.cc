@@ -0,0 +1,50 @@
+/**
+ *
+ *  @file SharedMemorySessionStore.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/SessionStore.h>
+#include <trantor/utils/Logger.h>
+
+using namespace drogon;
+
+void SharedMemorySessionStore::load(const std::string &sessionId,
+                                    size_t timeout,
+                                    LoadCallback &&callback)
+{
+    auto key = keyPrefix_ + sessionId;
+    std::string data;
+    if (!map_->findAndFetch(key, data))
+    {
+        callback(std::nullopt);
+        return;
+    }
+    // Restart counting of the expiration like the local sessions
+    if (timeout > 0)
+        map_->touch(key, timeout);
+    callback(std::move(data));
+}
+
+void SharedMemorySessionStore::save(const std::string &sessionId,
+                                    const std::string &data,
+                                    size_t timeout)
+{
+    if (!map_->insert(keyPrefix_ + sessionId, data, timeout))
+    {
+        LOG_ERROR << "The session " << sessionId << " of " << data.size()
+                  << " bytes doesn't fit in the shared memory map";
+    }
+}
+
+void SharedMemorySessionStore::erase(const std::string &sessionId)
+{
+    map_->erase(keyPrefix_ + sessionId);
+}
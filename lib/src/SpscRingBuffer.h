@@ -0,0 +1,97 @@
+/**
+ *
+ *  @file SpscRingBuffer.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A bounded lock-free queue for one producer thread and one consumer
+ * thread.
+ *
+ * The slots are allocated once and reused, a value is assigned to a slot
+ * instead of being moved into it, so a slot of std::string keeps its capacity
+ * and pushing a line does not allocate once the ring is warmed up.
+ */
+template <typename T>
+class SpscRingBuffer : public trantor::NonCopyable
+{
+  public:
+    /// The capacity is rounded up to a power of 2
+    explicit SpscRingBuffer(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    size_t capacity() const
+    {
+        return slots_.size();
+    }
+
+    /**
+     * @brief Assign the value to the next slot, called by the producer only.
+     * @return false if the ring is full.
+     */
+    template <typename U>
+    bool push(U &&value)
+    {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ >= slots_.size())
+        {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ >= slots_.size())
+                return false;
+        }
+        slots_[tail & mask_] = std::forward<U>(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Call the callback with every value in the ring and release their
+     * slots, called by the consumer only.
+     * @return The number of values consumed.
+     */
+    template <typename Callback>
+    size_t consumeAll(Callback &&callback)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        auto tail = tail_.load(std::memory_order_acquire);
+        for (auto i = head; i != tail; ++i)
+        {
+            callback(slots_[i & mask_]);
+        }
+        head_.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+  private:
+    std::vector<T> slots_;
+    size_t mask_{0};
+    // The consumer and the producer positions are on their own cache lines
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    // The head seen by the producer, refreshed only when the ring looks full
+    size_t headCache_{0};
+};
+}  // namespace drogon
@@ -231,10 +231,8 @@ bool SseClientContext::parseBody(trantor::MsgBuffer *buf)
                     std::min(currentChunkLength_, buf->readableBytes());
                 if (toRead > 0)
                 {
-                    // Create a temporary buffer for SSE parsing
-                    trantor::MsgBuffer tempBuf;
-                    tempBuf.append(buf->peek(), toRead);
-                    eventParser_->parse(&tempBuf);
+                    // A line split across chunks is kept by the parser
+                    eventParser_->feed(buf->peek(), toRead);
                     buf->retrieve(toRead);
                     currentChunkLength_ -= toRead;
                 }
@@ -262,7 +260,8 @@ bool SseClientContext::parseBody(trantor::MsgBuffer *buf)
         size_t toRead = std::min(remaining, buf->readableBytes());
         if (toRead > 0)
         {
-            eventParser_->parse(buf);
+            eventParser_->feed(buf->peek(), toRead);
+            buf->retrieve(toRead);
             bytesRead_ += toRead;
         }
 
@@ -14,51 +14,107 @@
 #include "SseEventParser.h"
 #include <trantor/utils/Logger.h>
 #include <algorithm>
-#include <cstdlib>
+#include <charconv>
+#include <cstring>
 
 namespace drogon
 {
-bool SseEventParser::parse(trantor::MsgBuffer *buf)
+void SseEventParser::Field::assign(std::string_view text, bool stable)
 {
-    while (buf->readableBytes() > 0)
+    if (stable)
     {
-        // Find end of line (LF or CRLF)
-        const char *data = buf->peek();
-        const char *end = data + buf->readableBytes();
-        const char *lineEnd = nullptr;
+        value = text;
+        owned = false;
+        return;
+    }
+    storage.assign(text.data(), text.size());
+    value = storage;
+    owned = true;
+}
 
-        for (const char *p = data; p < end; ++p)
-        {
-            if (*p == '\n')
-            {
-                lineEnd = p;
-                break;
-            }
-        }
+void SseEventParser::Field::append(std::string_view text)
+{
+    keep();
+    storage.push_back('\n');
+    storage.append(text.data(), text.size());
+    value = storage;
+}
+
+void SseEventParser::Field::keep()
+{
+    if (owned)
+        return;
+    storage.assign(value.data(), value.size());
+    value = storage;
+    owned = true;
+}
+
+void SseEventParser::Field::clear()
+{
+    // The storage keeps its capacity for the next events
+    value = {};
+    storage.clear();
+    owned = false;
+}
+
+bool SseEventParser::parse(trantor::MsgBuffer *buf)
+{
+    feed(buf->peek(), buf->readableBytes());
+    buf->retrieveAll();
+    return true;
+}
 
+void SseEventParser::feed(const char *data, size_t length)
+{
+    const char *p = data;
+    const char *end = data + length;
+    while (p < end)
+    {
+        // Find end of line (LF or CRLF), the bytes of an incomplete line are
+        // kept and not scanned again
+        auto lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
         if (!lineEnd)
         {
-            // No complete line yet, wait for more data
+            lineBuffer_.append(p, end - p);
             break;
         }
 
-        // Extract the line (excluding LF, and optionally CR before LF)
-        size_t lineLen = lineEnd - data;
-        if (lineLen > 0 && data[lineLen - 1] == '\r')
+        std::string_view line;
+        bool stable = lineBuffer_.empty();
+        if (stable)
         {
-            --lineLen;
+            line = std::string_view(p, lineEnd - p);
         }
-
-        std::string line(data, lineLen);
-        buf->retrieve(lineEnd - data + 1);  // +1 for LF
-
-        processLine(line);
+        else
+        {
+            lineBuffer_.append(p, lineEnd - p);
+            line = lineBuffer_;
+        }
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        processLine(line, stable);
+        lineBuffer_.clear();
+        p = lineEnd + 1;
     }
+    // The data is gone after the feed
+    event_.keep();
+    data_.keep();
+    id_.keep();
+}
 
-    return true;
+void SseEventParser::reset()
+{
+    event_.clear();
+    data_.clear();
+    id_.clear();
+    hasData_ = false;
+    eventRetry_ = 0;
+    lineBuffer_.clear();
 }
 
-void SseEventParser::processLine(const std::string &line)
+void SseEventParser::processLine(std::string_view line, bool stable)
 {
     // Empty line means dispatch the current event
     if (line.empty())
@@ -73,53 +129,45 @@ void SseEventParser::processLine(const std::string &line)
         return;
     }
 
-    // Find the field name and value
-    std::string field;
-    std::string value;
-
+    // Find the field name and value, no colon means an empty value
     auto colonPos = line.find(':');
-    if (colonPos == std::string::npos)
-    {
-        // No colon, the entire line is the field name with empty value
-        field = line;
-    }
-    else
+    auto field = line.substr(0, colonPos);
+    std::string_view value;
+    if (colonPos != std::string_view::npos)
     {
-        field = line.substr(0, colonPos);
         // Skip the colon and optional space after it
-        size_t valueStart = colonPos + 1;
-        if (valueStart < line.size() && line[valueStart] == ' ')
+        value = line.substr(colonPos + 1);
+        if (!value.empty() && value[0] == ' ')
         {
-            ++valueStart;
+            value.remove_prefix(1);
         }
-        value = line.substr(valueStart);
     }
 
     // Process the field
     if (field == "event")
     {
-        currentEvent_->setEvent(value);
+        event_.assign(value, stable);
     }
     else if (field == "data")
     {
         // Multiple data fields are concatenated with newlines
-        if (!currentEvent_->data().empty())
+        if (hasData_)
         {
-            std::string newData = currentEvent_->data() + '\n' + value;
-            currentEvent_->setData(std::move(newData));
+            data_.append(value);
         }
         else
         {
-            currentEvent_->setData(value);
+            data_.assign(value, stable);
+            hasData_ = true;
         }
     }
     else if (field == "id")
     {
         // ID must not contain null characters
-        if (value.find('\0') == std::string::npos)
+        if (value.find('\0') == std::string_view::npos)
         {
-            currentEvent_->setId(value);
-            lastEventId_ = value;
+            id_.assign(value, stable);
+            lastEventId_.assign(value.data(), value.size());
         }
     }
     else if (field == "retry")
@@ -127,9 +175,13 @@ void SseEventParser::processLine(const std::string &line)
         // Retry value must be all digits
         bool allDigits = !value.empty() &&
                          std::all_of(value.begin(), value.end(), ::isdigit);
-        if (allDigits)
+        int retry = 0;
+        if (allDigits &&
+            std::from_chars(value.data(), value.data() + value.size(), retry)
+                    .ec == std::errc())
         {
-            currentEvent_->setRetry(std::atoi(value.c_str()));
+            eventRetry_ = retry;
+            retry_ = retry;
         }
     }
     // Ignore unknown fields
@@ -137,21 +189,35 @@ void SseEventParser::processLine(const std::string &line)
 
 void SseEventParser::dispatchEvent()
 {
-    if (currentEvent_->isValid())
+    if (!data_.value.empty())
     {
         // If no event type specified, use "message"
-        if (currentEvent_->event().empty())
+        SseEventView view;
+        view.event = event_.value.empty() ? std::string_view("message")
+                                          : event_.value;
+        view.data = data_.value;
+        view.id = id_.value;
+        view.retry = eventRetry_;
+
+        if (viewCallback_)
         {
-            currentEvent_->setEvent("message");
+            viewCallback_(view);
         }
-
         if (eventCallback_)
         {
-            eventCallback_(currentEvent_);
+            auto event = SseEvent::newEvent(std::string(view.event),
+                                            std::string(view.data));
+            event->setId(std::string(view.id));
+            event->setRetry(view.retry);
+            eventCallback_(event);
         }
     }
 
-    currentEvent_ = SseEvent::newEvent();
+    event_.clear();
+    data_.clear();
+    id_.clear();
+    hasData_ = false;
+    eventRetry_ = 0;
 }
 
 }  // namespace drogon
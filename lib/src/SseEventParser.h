@@ -17,6 +17,7 @@
 #include <trantor/utils/MsgBuffer.h>
 #include <trantor/utils/NonCopyable.h>
 #include <string>
+#include <string_view>
 #include <functional>
 
 namespace drogon
@@ -30,33 +31,47 @@ namespace drogon
  *   retry: <retry-time-ms>
  *   data: <event-data>
  *   <blank line>
+ *
+ * The stream is parsed as it arrives, every byte is scanned once. The fields
+ * of an event are passed as views into the data fed when they can be, they
+ * are copied only when the event is split across pieces of the stream or
+ * has several data lines.
  */
 class SseEventParser : public trantor::NonCopyable
 {
   public:
     using EventCallback = std::function<void(const SseEventPtr &)>;
+    using EventViewCallback = SseEventViewCallback;
 
     explicit SseEventParser(EventCallback callback)
         : eventCallback_(std::move(callback))
     {
     }
 
+    explicit SseEventParser(EventViewCallback callback)
+        : viewCallback_(std::move(callback))
+    {
+    }
+
     /**
-     * @brief Parse data from buffer and emit events
+     * @brief Parse all the data of the buffer and emit events, the last
+     * line is kept by the parser until its end arrives.
      *
      * @param buf The message buffer containing SSE data
      * @return true if parsing was successful
      */
     bool parse(trantor::MsgBuffer *buf);
 
+    /**
+     * @brief Parse the next piece of the stream and emit the events it
+     * completes.
+     */
+    void feed(const char *data, size_t length);
+
     /**
      * @brief Reset the parser state
      */
-    void reset()
-    {
-        currentEvent_ = SseEvent::newEvent();
-        lineBuffer_.clear();
-    }
+    void reset();
 
     /**
      * @brief Get the last event ID received
@@ -66,11 +81,34 @@ class SseEventParser : public trantor::NonCopyable
         return lastEventId_;
     }
 
+    /**
+     * @brief Get the last retry time received in milliseconds, 0 if none
+     */
+    int retry() const
+    {
+        return retry_;
+    }
+
   private:
+    // A field of the current event. It is a view into the data being fed
+    // until the feed returns or another line is appended to it.
+    struct Field
+    {
+        std::string_view value;
+        std::string storage;
+        bool owned{false};
+
+        void assign(std::string_view text, bool stable);
+        void append(std::string_view text);
+        void keep();
+        void clear();
+    };
+
     /**
-     * @brief Process a single line of SSE data
+     * @brief Process a single line of SSE data, stable if the line is in
+     * the data being fed
      */
-    void processLine(const std::string &line);
+    void processLine(std::string_view line, bool stable);
 
     /**
      * @brief Dispatch the current event if valid
@@ -78,9 +116,15 @@ class SseEventParser : public trantor::NonCopyable
     void dispatchEvent();
 
     EventCallback eventCallback_;
-    SseEventPtr currentEvent_{SseEvent::newEvent()};
+    EventViewCallback viewCallback_;
+    Field event_;
+    Field data_;
+    Field id_;
+    bool hasData_{false};
+    int eventRetry_{0};
     std::string lineBuffer_;
     std::string lastEventId_;
+    int retry_{0};
 };
 
 }  // namespace drogon
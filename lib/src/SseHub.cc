@@ -0,0 +1,320 @@
+/**
+ *
+ *  @file SseHub.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/SseHub.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+using WireBytes = std::shared_ptr<const std::string>;
+
+struct Entry
+{
+    uint64_t seq;
+    std::string id;
+    WireBytes bytes;
+};
+
+struct Subscriber
+{
+    SseWriterPtr writer;
+    // The sequence number of the last event the subscriber has been sent
+    uint64_t lastSeq;
+};
+
+struct Channel
+{
+    uint64_t lastSeq{0};
+    std::deque<Entry> ring;
+    // The number of subscribers per IO loop
+    std::unordered_map<trantor::EventLoop *, size_t> loops;
+};
+
+struct Bucket
+{
+    explicit Bucket(trantor::EventLoop *loop) : loop(loop)
+    {
+    }
+
+    trantor::EventLoop *loop;
+    // Guarded by the mutex of the hub
+    std::vector<std::pair<std::string, Entry>> pending;
+    bool flushQueued{false};
+    // Only accessed in the loop
+    std::unordered_map<std::string, std::vector<Subscriber>> subscribers;
+};
+
+using BucketPtr = std::shared_ptr<Bucket>;
+}  // namespace
+
+struct SseHub::Impl : public std::enable_shared_from_this<SseHub::Impl>
+{
+    explicit Impl(const SseHubOptions &options) : options(options)
+    {
+    }
+
+    std::string publish(const std::string &name, const SseEvent &event);
+    bool subscribe(const std::string &name,
+                   const SseWriterPtr &writer,
+                   const std::string &lastEventId);
+    void flush(const BucketPtr &bucket);
+    void removeSubscriber(const std::string &name, trantor::EventLoop *loop);
+
+    const SseHubOptions options;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Channel> channels;
+    std::unordered_map<trantor::EventLoop *, BucketPtr> buckets;
+};
+
+std::string SseHub::Impl::publish(const std::string &name,
+                                  const SseEvent &event)
+{
+    std::vector<BucketPtr> toFlush;
+    std::string id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &channel = channels[name];
+        Entry entry;
+        entry.seq = ++channel.lastSeq;
+        if (event.id().empty())
+        {
+            SseEvent numbered(event);
+            numbered.setId(std::to_string(entry.seq));
+            entry.bytes = std::make_shared<const std::string>(
+                SseWriter::formatEvent(numbered));
+            entry.id = numbered.id();
+        }
+        else
+        {
+            entry.bytes = std::make_shared<const std::string>(
+                SseWriter::formatEvent(event));
+            entry.id = event.id();
+        }
+        id = entry.id;
+        for (auto &[loop, count] : channel.loops)
+        {
+            auto &bucket = buckets[loop];
+            bucket->pending.emplace_back(name, entry);
+            if (!bucket->flushQueued)
+            {
+                bucket->flushQueued = true;
+                toFlush.push_back(bucket);
+            }
+        }
+        if (options.replayCapacity > 0)
+        {
+            channel.ring.push_back(std::move(entry));
+            if (channel.ring.size() > options.replayCapacity)
+                channel.ring.pop_front();
+        }
+    }
+    for (auto &bucket : toFlush)
+    {
+        bucket->loop->queueInLoop(
+            [thisPtr = shared_from_this(), bucket]() {
+                thisPtr->flush(bucket);
+            });
+    }
+    return id;
+}
+
+bool SseHub::Impl::subscribe(const std::string &name,
+                             const SseWriterPtr &writer,
+                             const std::string &lastEventId)
+{
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!loop)
+    {
+        LOG_ERROR << "SseHub::subscribe() must be called in an IO loop";
+        return false;
+    }
+    if (!writer || !writer->isOpen())
+        return false;
+    std::string replay;
+    uint64_t lastSeq;
+    BucketPtr bucket;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &channel = channels[name];
+        lastSeq = channel.lastSeq;
+        if (!lastEventId.empty())
+        {
+            // Search from the newest, clients usually miss few events.
+            auto iter = channel.ring.rbegin();
+            while (iter != channel.ring.rend() && iter->id != lastEventId)
+                ++iter;
+            if (iter != channel.ring.rend())
+            {
+                for (auto it = iter.base(); it != channel.ring.end(); ++it)
+                    replay.append(*it->bytes);
+            }
+        }
+        ++channel.loops[loop];
+        auto &ptr = buckets[loop];
+        if (!ptr)
+            ptr = std::make_shared<Bucket>(loop);
+        bucket = ptr;
+    }
+    // The pending events of the loop up to lastSeq are either replayed or
+    // older than the subscription, the flush skips them for this subscriber.
+    bucket->subscribers[name].push_back({writer, lastSeq});
+    if (!replay.empty() && !writer->sendFormatted(replay))
+    {
+        // The subscriber is dropped by the next flush of the channel.
+        writer->close();
+    }
+    return true;
+}
+
+void SseHub::Impl::flush(const BucketPtr &bucket)
+{
+    std::vector<std::pair<std::string, Entry>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(bucket->pending);
+        bucket->flushQueued = false;
+    }
+    // Group the events by channel, keeping the order of publication.
+    std::vector<std::pair<std::string, std::vector<Entry>>> batches;
+    std::unordered_map<std::string, size_t> indexes;
+    for (auto &[name, entry] : pending)
+    {
+        auto [iter, inserted] = indexes.emplace(name, batches.size());
+        if (inserted)
+            batches.emplace_back(name, std::vector<Entry>());
+        batches[iter->second].second.push_back(std::move(entry));
+    }
+    for (auto &[name, entries] : batches)
+    {
+        auto subIter = bucket->subscribers.find(name);
+        if (subIter == bucket->subscribers.end())
+            continue;
+        // The batch is built once, the subscribers that have already been
+        // sent some of its events are sent the rest of it.
+        std::string batch;
+        std::vector<size_t> offsets;
+        offsets.reserve(entries.size());
+        for (auto &entry : entries)
+        {
+            offsets.push_back(batch.size());
+            batch.append(*entry.bytes);
+        }
+        auto newestSeq = entries.back().seq;
+        auto &subscribers = subIter->second;
+        size_t removed = 0;
+        for (auto iter = subscribers.begin(); iter != subscribers.end();)
+        {
+            auto &sub = *iter;
+            bool keep = sub.writer->isOpen();
+            if (keep && sub.lastSeq < newestSeq)
+            {
+                size_t first = 0;
+                while (entries[first].seq <= sub.lastSeq)
+                    ++first;
+                sub.lastSeq = newestSeq;
+                if (options.maxPendingBytes > 0 &&
+                    sub.writer->pendingBytes() > options.maxPendingBytes)
+                {
+                    if (options.backpressurePolicy ==
+                        SseBackpressurePolicy::kDisconnect)
+                    {
+                        sub.writer->close();
+                        keep = false;
+                    }
+                }
+                else if (first == 0)
+                {
+                    keep = sub.writer->sendFormatted(batch);
+                }
+                else
+                {
+                    keep = sub.writer->sendFormatted(
+                        batch.substr(offsets[first]));
+                }
+            }
+            if (keep)
+            {
+                ++iter;
+                continue;
+            }
+            iter = subscribers.erase(iter);
+            ++removed;
+        }
+        if (subscribers.empty())
+            bucket->subscribers.erase(subIter);
+        for (size_t i = 0; i < removed; ++i)
+            removeSubscriber(name, bucket->loop);
+    }
+}
+
+void SseHub::Impl::removeSubscriber(const std::string &name,
+                                    trantor::EventLoop *loop)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = channels.find(name);
+    if (iter == channels.end())
+        return;
+    auto loopIter = iter->second.loops.find(loop);
+    if (loopIter != iter->second.loops.end() && --loopIter->second == 0)
+        iter->second.loops.erase(loopIter);
+}
+
+SseHub::SseHub(const SseHubOptions &options)
+    : impl_(std::make_shared<Impl>(options))
+{
+}
+
+SseHub::~SseHub() = default;
+
+std::string SseHub::publish(const std::string &channel, const SseEvent &event)
+{
+    return impl_->publish(channel, event);
+}
+
+bool SseHub::subscribe(const std::string &channel,
+                       const SseWriterPtr &writer,
+                       const std::string &lastEventId)
+{
+    return impl_->subscribe(channel, writer, lastEventId);
+}
+
+HttpResponsePtr SseHub::newResponse(const HttpRequestPtr &req,
+                                    const std::string &channel)
+{
+    return HttpResponse::newSseResponse(
+        [impl = impl_,
+         channel,
+         lastEventId = req->getHeader("last-event-id")](SseWriterPtr writer) {
+            if (!impl->subscribe(channel, writer, lastEventId))
+                writer->close();
+        });
+}
+
+size_t SseHub::subscriberCount(const std::string &channel) const
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto iter = impl_->channels.find(channel);
+    if (iter == impl_->channels.end())
+        return 0;
+    size_t count = 0;
+    for (auto &pair : iter->second.loops)
+        count += pair.second;
+    return count;
+}
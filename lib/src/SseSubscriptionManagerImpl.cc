@@ -0,0 +1,307 @@
+/**
+ *
+ *  @file SseSubscriptionManagerImpl.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SseSubscriptionManagerImpl.h"
+#include "HttpAppFrameworkImpl.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace drogon;
+
+SseSubscriptionManagerPtr SseSubscriptionManager::newSseSubscriptionManager(
+    const std::vector<trantor::EventLoop *> &loops,
+    bool validateCert)
+{
+    return std::make_shared<SseSubscriptionManagerImpl>(loops, validateCert);
+}
+
+SseSubscriptionManagerImpl::SseSubscriptionManagerImpl(
+    const std::vector<trantor::EventLoop *> &loops,
+    bool validateCert)
+    : validateCert_(validateCert)
+{
+    auto managerLoops = loops;
+    if (managerLoops.empty())
+    {
+        auto &app = HttpAppFrameworkImpl::instance();
+        for (size_t i = 0; i < app.getThreadNum(); ++i)
+        {
+            auto loop = app.getIOLoop(i);
+            if (!loop)
+                break;
+            managerLoops.push_back(loop);
+        }
+        if (managerLoops.empty())
+            managerLoops.push_back(app.getLoop());
+    }
+    loops_.resize(managerLoops.size());
+    for (size_t i = 0; i < managerLoops.size(); ++i)
+    {
+        loops_[i].loop = managerLoops[i];
+    }
+}
+
+SseSubscriptionManagerImpl::~SseSubscriptionManagerImpl()
+{
+    for (auto &state : loops_)
+    {
+        // The connections and timers are closed in their loop
+        state.loop->runInLoop(
+            [loop = state.loop,
+             subscriptions = std::move(state.subscriptions),
+             clients = std::move(state.clients)]() {
+                for (auto &[id, sub] : subscriptions)
+                {
+                    sub->closed = true;
+                    if (sub->timerId != 0)
+                        loop->invalidateTimer(sub->timerId);
+                    if (sub->stream)
+                        sub->stream->cancel();
+                }
+            });
+    }
+}
+
+SseSubscriptionManager::SubscriptionId SseSubscriptionManagerImpl::subscribe(
+    const std::string &hostString,
+    const HttpRequestPtr &req,
+    SseEventViewCallback eventCallback,
+    SseClosedCallback closedCallback)
+{
+    auto sub = std::make_shared<Subscription>();
+    sub->id = nextId_.fetch_add(1, std::memory_order_relaxed);
+    sub->hostString = hostString;
+    sub->req = req;
+    sub->eventCallback = std::move(eventCallback);
+    sub->closedCallback = std::move(closedCallback);
+    if (req->getHeader("accept").empty())
+        req->addHeader("accept", "text/event-stream");
+    if (req->getHeader("cache-control").empty())
+        req->addHeader("cache-control", "no-cache");
+    // The parser only calls back while the data callback of the stream
+    // holds the manager and the subscription.
+    sub->parser = std::make_unique<SseEventParser>(
+        SseEventViewCallback([this, s = sub.get()](const SseEventView &event) {
+            if (s->closed)
+                return;
+            s->failures = 0;
+            events_.fetch_add(1, std::memory_order_relaxed);
+            s->eventCallback(event);
+        }));
+    subscriptions_.fetch_add(1, std::memory_order_relaxed);
+
+    std::weak_ptr<SseSubscriptionManagerImpl> weakPtr = shared_from_this();
+    loopOf(sub->id).loop->runInLoop([weakPtr, sub]() {
+        if (auto thisPtr = weakPtr.lock())
+            thisPtr->start(sub);
+    });
+    return sub->id;
+}
+
+void SseSubscriptionManagerImpl::unsubscribe(SubscriptionId id)
+{
+    // Queued after the start of the subscription in the same loop
+    std::weak_ptr<SseSubscriptionManagerImpl> weakPtr = shared_from_this();
+    loopOf(id).loop->runInLoop([weakPtr, id]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        auto &subscriptions = thisPtr->loopOf(id).subscriptions;
+        auto iter = subscriptions.find(id);
+        if (iter == subscriptions.end())
+            return;
+        auto sub = std::move(iter->second);
+        subscriptions.erase(iter);
+        thisPtr->close(*sub);
+    });
+}
+
+SseSubscriptionManager::Metrics SseSubscriptionManagerImpl::metrics() const
+{
+    Metrics metrics;
+    metrics.subscriptions = subscriptions_.load(std::memory_order_relaxed);
+    metrics.connected = connected_.load(std::memory_order_relaxed);
+    metrics.reconnects = reconnects_.load(std::memory_order_relaxed);
+    metrics.events = events_.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+double SseSubscriptionManagerImpl::reconnectDelay(double initialDelay,
+                                                  double maxDelay,
+                                                  int retry,
+                                                  size_t failures)
+{
+    auto base = retry > 0 ? retry / 1000.0 : initialDelay;
+    // Doubled by every failure after the first one
+    auto doublings = (std::min)(failures, size_t{32});
+    if (doublings > 0)
+        --doublings;
+    auto backoff =
+        (std::min)(maxDelay, base * std::pow(2.0, static_cast<int>(doublings)));
+    thread_local std::mt19937_64 engine{std::random_device{}()};
+    return backoff / 2 +
+           std::uniform_real_distribution<double>(0, backoff / 2)(engine);
+}
+
+void SseSubscriptionManagerImpl::start(const SubscriptionPtr &sub)
+{
+    auto &state = loopOf(sub->id);
+    auto &client = state.clients[sub->hostString];
+    if (!client)
+    {
+        client = HttpClient::newHttpClient(sub->hostString,
+                                           state.loop,
+                                           false,
+                                           validateCert_);
+        if (initializer_)
+            initializer_(client);
+    }
+    sub->client = client;
+    state.subscriptions.emplace(sub->id, sub);
+    connect(sub);
+}
+
+void SseSubscriptionManagerImpl::connect(const SubscriptionPtr &sub)
+{
+    sub->parser->reset();
+    if (!sub->parser->lastEventId().empty())
+        sub->req->addHeader("last-event-id", sub->parser->lastEventId());
+
+    std::weak_ptr<SseSubscriptionManagerImpl> weakPtr = shared_from_this();
+    std::weak_ptr<Subscription> weakSub = sub;
+    sub->client->sendRequestForStream(
+        sub->req,
+        [weakPtr, weakSub](const HttpResponsePtr &resp,
+                           const HttpBodyStreamPtr &stream) {
+            auto thisPtr = weakPtr.lock();
+            auto sub = weakSub.lock();
+            if (thisPtr && sub && !sub->closed)
+                thisPtr->onHeaders(sub, resp, stream);
+            else
+                stream->cancel();
+        },
+        [weakPtr, weakSub](const char *data, size_t length) {
+            auto thisPtr = weakPtr.lock();
+            auto sub = weakSub.lock();
+            if (thisPtr && sub && !sub->closed)
+                sub->parser->feed(data, length);
+        },
+        [weakPtr, weakSub](ReqResult result, const HttpResponsePtr &resp) {
+            auto thisPtr = weakPtr.lock();
+            auto sub = weakSub.lock();
+            if (thisPtr && sub && !sub->closed)
+                thisPtr->onFinished(sub, result, resp);
+        },
+        timeout_);
+}
+
+void SseSubscriptionManagerImpl::onHeaders(const SubscriptionPtr &sub,
+                                           const HttpResponsePtr &resp,
+                                           const HttpBodyStreamPtr &stream)
+{
+    sub->stream = stream;
+    auto status = resp->statusCode();
+    if (status == k200OK)
+    {
+        sub->connected = true;
+        connected_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // No callback of the stream is called after the cancellation
+    stream->cancel();
+    sub->stream.reset();
+    if (status == k204NoContent ||
+        (status >= 400 && status < 500 && status != k408RequestTimeout &&
+         status != k429TooManyRequests))
+    {
+        end(sub, ReqResult::Ok, resp);
+        return;
+    }
+    retry(sub, ReqResult::BadResponse, resp);
+}
+
+void SseSubscriptionManagerImpl::onFinished(const SubscriptionPtr &sub,
+                                            ReqResult result,
+                                            const HttpResponsePtr &resp)
+{
+    sub->stream.reset();
+    if (sub->connected)
+    {
+        sub->connected = false;
+        connected_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    retry(sub, result, resp);
+}
+
+void SseSubscriptionManagerImpl::retry(const SubscriptionPtr &sub,
+                                       ReqResult result,
+                                       const HttpResponsePtr &resp)
+{
+    ++sub->failures;
+    if (maxRetries_ > 0 && sub->failures > maxRetries_)
+    {
+        end(sub, result, resp);
+        return;
+    }
+    reconnects_.fetch_add(1, std::memory_order_relaxed);
+    auto delay = reconnectDelay(initialDelay_,
+                                maxDelay_,
+                                sub->parser->retry(),
+                                sub->failures);
+    std::weak_ptr<SseSubscriptionManagerImpl> weakPtr = shared_from_this();
+    std::weak_ptr<Subscription> weakSub = sub;
+    sub->timerId =
+        loopOf(sub->id).loop->runAfter(delay, [weakPtr, weakSub]() {
+            auto thisPtr = weakPtr.lock();
+            auto sub = weakSub.lock();
+            if (!thisPtr || !sub || sub->closed)
+                return;
+            sub->timerId = 0;
+            thisPtr->connect(sub);
+        });
+}
+
+void SseSubscriptionManagerImpl::end(const SubscriptionPtr &sub,
+                                     ReqResult result,
+                                     const HttpResponsePtr &resp)
+{
+    loopOf(sub->id).subscriptions.erase(sub->id);
+    auto closedCallback = std::move(sub->closedCallback);
+    close(*sub);
+    if (closedCallback)
+        closedCallback(result, resp);
+}
+
+void SseSubscriptionManagerImpl::close(Subscription &sub)
+{
+    if (sub.closed)
+        return;
+    sub.closed = true;
+    if (sub.timerId != 0)
+    {
+        loopOf(sub.id).loop->invalidateTimer(sub.timerId);
+        sub.timerId = 0;
+    }
+    if (sub.stream)
+    {
+        sub.stream->cancel();
+        sub.stream.reset();
+    }
+    if (sub.connected)
+    {
+        sub.connected = false;
+        connected_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    subscriptions_.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,140 @@
+/**
+ *
+ *  @file SseSubscriptionManagerImpl.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "SseEventParser.h"
+#include <drogon/SseSubscriptionManager.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+class SseSubscriptionManagerImpl final
+    : public SseSubscriptionManager,
+      public std::enable_shared_from_this<SseSubscriptionManagerImpl>
+{
+  public:
+    SseSubscriptionManagerImpl(const std::vector<trantor::EventLoop *> &loops,
+                               bool validateCert);
+    ~SseSubscriptionManagerImpl() override;
+
+    SubscriptionId subscribe(const std::string &hostString,
+                             const HttpRequestPtr &req,
+                             SseEventViewCallback eventCallback,
+                             SseClosedCallback closedCallback) override;
+    void unsubscribe(SubscriptionId id) override;
+
+    void setReconnectDelay(double initialDelay, double maxDelay) override
+    {
+        initialDelay_ = initialDelay;
+        maxDelay_ = maxDelay < initialDelay ? initialDelay : maxDelay;
+    }
+
+    void setMaxRetries(size_t maxRetries) override
+    {
+        maxRetries_ = maxRetries;
+    }
+
+    void setTimeout(double timeout) override
+    {
+        timeout_ = timeout;
+    }
+
+    void setClientInitializer(
+        std::function<void(const HttpClientPtr &)> initializer) override
+    {
+        initializer_ = std::move(initializer);
+    }
+
+    Metrics metrics() const override;
+
+    /**
+     * @brief The delay in seconds before the reconnection after a number of
+     * failures in a row, jittered between the half of the backoff and the
+     * whole.
+     *
+     * @param retry The retry time sent by the server in milliseconds, 0 if
+     * none.
+     */
+    static double reconnectDelay(double initialDelay,
+                                 double maxDelay,
+                                 int retry,
+                                 size_t failures);
+
+  private:
+    // Only touched in the loop of the subscription
+    struct Subscription
+    {
+        SubscriptionId id{0};
+        std::string hostString;
+        HttpClientPtr client;
+        HttpRequestPtr req;
+        SseEventViewCallback eventCallback;
+        SseClosedCallback closedCallback;
+        // Kept across the connections for the last event ID and retry time
+        std::unique_ptr<SseEventParser> parser;
+        HttpBodyStreamPtr stream;
+        size_t failures{0};
+        trantor::TimerId timerId{0};
+        bool connected{false};
+        bool closed{false};
+    };
+
+    using SubscriptionPtr = std::shared_ptr<Subscription>;
+
+    struct LoopState
+    {
+        trantor::EventLoop *loop{nullptr};
+        std::unordered_map<SubscriptionId, SubscriptionPtr> subscriptions;
+        std::unordered_map<std::string, HttpClientPtr> clients;
+    };
+
+    LoopState &loopOf(SubscriptionId id)
+    {
+        return loops_[id % loops_.size()];
+    }
+
+    void start(const SubscriptionPtr &sub);
+    void connect(const SubscriptionPtr &sub);
+    void onHeaders(const SubscriptionPtr &sub,
+                   const HttpResponsePtr &resp,
+                   const HttpBodyStreamPtr &stream);
+    void onFinished(const SubscriptionPtr &sub,
+                    ReqResult result,
+                    const HttpResponsePtr &resp);
+    void retry(const SubscriptionPtr &sub,
+               ReqResult result,
+               const HttpResponsePtr &resp);
+    void end(const SubscriptionPtr &sub,
+             ReqResult result,
+             const HttpResponsePtr &resp);
+    void close(Subscription &sub);
+
+    std::vector<LoopState> loops_;
+    bool validateCert_;
+    double initialDelay_{1};
+    double maxDelay_{30};
+    size_t maxRetries_{0};
+    double timeout_{10};
+    std::function<void(const HttpClientPtr &)> initializer_;
+    std::atomic<SubscriptionId> nextId_{0};
+    std::atomic<size_t> subscriptions_{0};
+    std::atomic<size_t> connected_{0};
+    std::atomic<size_t> reconnects_{0};
+    std::atomic<size_t> events_{0};
+};
+}  // namespace drogon
@@ -32,10 +32,28 @@ bool SseWriter::send(const SseEventPtr &event)
         return false;
     }
 
-    std::string message = formatEvent(event);
+    std::string message = formatEvent(*event);
     return stream_->send(message);
 }
 
+bool SseWriter::sendFormatted(const std::string &message)
+{
+    if (!stream_ || closed_)
+    {
+        return false;
+    }
+    return stream_->send(message);
+}
+
+size_t SseWriter::pendingBytes() const
+{
+    if (!stream_ || closed_)
+    {
+        return 0;
+    }
+    return stream_->pendingBytes();
+}
+
 bool SseWriter::sendJson(const Json::Value &json, const std::string &eventType)
 {
     Json::StreamWriterBuilder builder;
@@ -85,32 +103,32 @@ void SseWriter::close()
     }
 }
 
-std::string SseWriter::formatEvent(const SseEventPtr &event) const
+std::string SseWriter::formatEvent(const SseEvent &event)
 {
     std::ostringstream oss;
 
     // Event type (if not empty)
-    if (!event->event().empty())
+    if (!event.event().empty())
     {
-        oss << "event:" << event->event() << "\n";
+        oss << "event:" << event.event() << "\n";
     }
 
     // Event ID
-    if (!event->id().empty())
+    if (!event.id().empty())
     {
-        oss << "id:" << event->id() << "\n";
+        oss << "id:" << event.id() << "\n";
     }
 
     // Retry interval
-    if (event->retry() > 0)
+    if (event.retry() > 0)
     {
-        oss << "retry:" << event->retry() << "\n";
+        oss << "retry:" << event.retry() << "\n";
     }
 
     // Data lines (split by newlines)
-    if (!event->data().empty())
+    if (!event.data().empty())
     {
-        std::istringstream dataStream(event->data());
+        std::istringstream dataStream(event.data());
         std::string line;
         while (std::getline(dataStream, line))
         {
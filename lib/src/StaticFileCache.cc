@@ -0,0 +1,491 @@
+/**
+ *
+ *  @file StaticFileCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "StaticFileCache.h"
+#include "HttpResponseImpl.h"
+#include <drogon/HttpAppFramework.h>
+#include <trantor/net/Channel.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+// The approximate size of the headers of a cached response, they are owned
+// by the clone of every IO thread.
+constexpr size_t kHeaderBytes = 512;
+
+// The files are not counted in the budget, they are read from the page
+// cache, but every handle costs a descriptor
+constexpr size_t kMaxFiles = 1024;
+
+const char *const kVariantSuffixes[] = {".br", ".gz", ".zst"};
+}  // namespace
+
+StaticFileCache::StaticFileCache(size_t maxBytes,
+                                 int cacheTime,
+                                 trantor::EventLoop *loop)
+    : maxBytes_(maxBytes),
+      cacheTime_(cacheTime),
+      loop_(loop)
+{
+    auto snapshot = std::make_shared<Snapshot>();
+    auto empty = std::make_shared<const Shard>();
+    for (auto &shard : snapshot->shards)
+        shard = empty;
+    snapshot_ = std::move(snapshot);
+#ifdef __linux__
+    notifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd_ < 0)
+    {
+        LOG_WARN << "inotify_init1 failed, static files are cached for "
+                 << cacheTime_ << " seconds";
+        return;
+    }
+    notifyChannel_ = std::make_unique<trantor::Channel>(loop_, notifyFd_);
+    notifyChannel_->setReadCallback([this]() { onFileEvents(); });
+    loop_->runInLoop([this]() { notifyChannel_->enableReading(); });
+#endif
+}
+
+StaticFileCache::~StaticFileCache()
+{
+#ifdef __linux__
+    if (notifyChannel_)
+    {
+        auto removeChannel = [this]() {
+            notifyChannel_->disableAll();
+            notifyChannel_->remove();
+        };
+        if (loop_->isInLoopThread())
+        {
+            removeChannel();
+        }
+        else if (loop_->isRunning())
+        {
+            // The channel can only be removed in its loop, which may be
+            // calling it
+            std::promise<void> removed;
+            loop_->runInLoop([&removeChannel, &removed]() {
+                removeChannel();
+                removed.set_value();
+            });
+            removed.get_future().wait();
+        }
+        else
+        {
+            // The loop is stopped and nothing calls the channel any more, it
+            // can't be removed from another thread
+            (void)notifyChannel_.release();
+        }
+    }
+    if (notifyFd_ >= 0)
+        ::close(notifyFd_);
+#endif
+}
+
+int64_t StaticFileCache::now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+size_t StaticFileCache::shardOf(const std::string &key)
+{
+    return std::hash<std::string>{}(key) % kShards;
+}
+
+StaticFileCache::Shard &StaticFileCache::SnapshotUpdate::shard(size_t index)
+{
+    auto &copy = copies[index];
+    if (!copy)
+    {
+        copy = std::make_shared<Shard>(*snapshot->shards[index]);
+        snapshot->shards[index] = copy;
+    }
+    return *copy;
+}
+
+HttpResponsePtr StaticFileCache::clone(const HttpResponsePtr &resp)
+{
+    // The clone shares the body with the prototype
+    return std::make_shared<HttpResponseImpl>(
+        *static_cast<HttpResponseImpl *>(resp.get()));
+}
+
+void StaticFileCache::refreshView(ThreadView &view)
+{
+    auto previous = std::move(view.snapshot);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        view.snapshot = snapshot_;
+        view.version = version_.load(std::memory_order_relaxed);
+    }
+    // Drop the clones of the entries which are not cached any more, their
+    // bodies must not outlive the entries. Only the changed shards are
+    // checked.
+    for (size_t i = 0; i < kShards; ++i)
+    {
+        auto &shard = view.snapshot->shards[i];
+        if (previous && previous->shards[i] == shard)
+            continue;
+        auto &clones = view.clones[i];
+        for (auto iter = clones.begin(); iter != clones.end();)
+        {
+            auto entryIter = shard->find(iter->first);
+            if (entryIter == shard->end() ||
+                entryIter->second != iter->second.first)
+            {
+                iter = clones.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+}
+
+HttpResponsePtr StaticFileCache::find(const std::string &key)
+{
+    auto threadIndex = app().getCurrentThreadIndex();
+    if (threadIndex > app().getThreadNum())
+    {
+        // Not an IO thread or the main thread
+        EntryPtr entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto &shard = *snapshot_->shards[shardOf(key)];
+            auto iter = shard.find(key);
+            if (iter == shard.end())
+                return nullptr;
+            entry = iter->second;
+        }
+        if (entry->expiry != 0 && now() >= entry->expiry)
+            return nullptr;
+        return clone(entry->response);
+    }
+
+    auto &view = views_.getThreadData();
+    if (view.version != version_.load(std::memory_order_acquire))
+    {
+        refreshView(view);
+    }
+    auto index = shardOf(key);
+    auto &shard = *view.snapshot->shards[index];
+    auto iter = shard.find(key);
+    if (iter == shard.end())
+        return nullptr;
+    auto &entry = iter->second;
+    auto current = now();
+    if (entry->expiry != 0 && current >= entry->expiry)
+        return nullptr;
+    entry->lastUsed.store(current, std::memory_order_relaxed);
+    auto &clonedResp = view.clones[index][key];
+    if (clonedResp.first != entry)
+    {
+        clonedResp.first = entry;
+        clonedResp.second = clone(entry->response);
+    }
+    return clonedResp.second;
+}
+
+HttpResponsePtr StaticFileCache::insert(const std::string &key,
+                                        const std::string &filePath,
+                                        const HttpResponsePtr &resp,
+                                        uint64_t generation)
+{
+    auto size = resp->getBody().length() + kHeaderBytes;
+    // A response larger than a quarter of the budget would evict most of the
+    // others
+    if (size > maxBytes_ / 4)
+        return resp;
+    auto current = now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The file may have changed after the response was read from it
+        if (generation != invalidations_)
+            return resp;
+        // A change notification only shortens the life of the entry
+        watch(filePath);
+        SnapshotUpdate update(*snapshot_);
+        auto &entry = update.shard(shardOf(key))[key];
+        if (entry)
+            bytes_ -= entry->bytes;
+        entry = std::make_shared<const Entry>(
+            filePath, resp, size, expiryFrom(current), current);
+        bytes_ += size;
+        if (bytes_ > maxBytes_)
+            evict(update, key);
+        publish(update);
+    }
+    auto cachedResp = find(key);
+    return cachedResp ? cachedResp : resp;
+}
+
+uint64_t StaticFileCache::generation()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return invalidations_;
+}
+
+OpenedFilePtr StaticFileCache::openFile(const std::string &path)
+{
+    auto current = now();
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = files_.find(path);
+        if (iter != files_.end())
+        {
+            if (iter->second.expiry == 0 || current < iter->second.expiry)
+            {
+                iter->second.lastUsed = current;
+                return iter->second.file;
+            }
+            files_.erase(iter);
+        }
+        // Watch before opening so that no change is missed
+        watch(path);
+        generation = invalidations_;
+    }
+    auto file = OpenedFile::open(path);
+    if (!file)
+        return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != invalidations_)
+        return file;
+    if (files_.size() >= kMaxFiles)
+    {
+        auto oldest = std::min_element(files_.begin(),
+                                       files_.end(),
+                                       [](const auto &a, const auto &b) {
+                                           return a.second.lastUsed <
+                                                  b.second.lastUsed;
+                                       });
+        files_.erase(oldest);
+    }
+    files_[path] = FileEntry{file, expiryFrom(current), current};
+    return file;
+}
+
+void StaticFileCache::publish(SnapshotUpdate &update)
+{
+    snapshot_ = std::move(update.snapshot);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void StaticFileCache::evict(SnapshotUpdate &update, const std::string &keptKey)
+{
+    // Evict down to 90% of the budget so that the next insertions do not
+    // have to evict again
+    auto target = maxBytes_ / 10 * 9;
+    struct Candidate
+    {
+        int64_t lastUsed;
+        size_t shard;
+        std::string key;
+        size_t bytes;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < kShards; ++i)
+    {
+        for (auto &entry : *update.snapshot->shards[i])
+        {
+            if (entry.first == keptKey)
+                continue;
+            candidates.push_back(
+                {entry.second->lastUsed.load(std::memory_order_relaxed),
+                 i,
+                 entry.first,
+                 entry.second->bytes});
+        }
+    }
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [](const auto &a, const auto &b) {
+                  return a.lastUsed < b.lastUsed;
+              });
+    for (auto &candidate : candidates)
+    {
+        if (bytes_ <= target)
+            break;
+        bytes_ -= candidate.bytes;
+        update.shard(candidate.shard).erase(candidate.key);
+    }
+}
+
+template <typename Pred>
+void StaticFileCache::removeIf(Pred &&pred)
+{
+    std::unique_ptr<SnapshotUpdate> update;
+    for (size_t i = 0; i < kShards; ++i)
+    {
+        // The shard of the current snapshot, not changed by the update
+        auto &shard = *snapshot_->shards[i];
+        for (auto &entry : shard)
+        {
+            if (!pred(*entry.second))
+                continue;
+            if (!update)
+                update = std::make_unique<SnapshotUpdate>(*snapshot_);
+            bytes_ -= entry.second->bytes;
+            update->shard(i).erase(entry.first);
+        }
+    }
+    if (update)
+        publish(*update);
+}
+
+void StaticFileCache::invalidate(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeFiles({path});
+}
+
+void StaticFileCache::removeFiles(const std::vector<std::string> &paths)
+{
+    if (paths.empty())
+        return;
+    std::unordered_set<std::string_view> removed;
+    for (auto &path : paths)
+    {
+        removed.insert(path);
+        // A change of foo.js.gz invalidates the responses of foo.js
+        std::string_view basePath{path};
+        for (auto suffix : kVariantSuffixes)
+        {
+            std::string_view suffixView{suffix};
+            if (basePath.length() > suffixView.length() &&
+                basePath.substr(basePath.length() - suffixView.length()) ==
+                    suffixView)
+            {
+                basePath.remove_suffix(suffixView.length());
+                removed.insert(basePath);
+                break;
+            }
+        }
+        files_.erase(path);
+    }
+    removeIf([&removed](const Entry &entry) {
+        return removed.find(entry.filePath) != removed.end();
+    });
+    ++invalidations_;
+}
+
+bool StaticFileCache::watch(const std::string &filePath)
+{
+#ifdef __linux__
+    if (notifyFd_ < 0)
+        return false;
+    auto pos = filePath.rfind('/');
+    if (pos == std::string::npos)
+        return false;
+    auto dir = filePath.substr(0, pos);
+    if (dirWatches_.find(dir) != dirWatches_.end())
+        return true;
+    auto wd = inotify_add_watch(notifyFd_,
+                                dir.empty() ? "/" : dir.c_str(),
+                                IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                    IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                    IN_MOVED_TO | IN_DELETE_SELF |
+                                    IN_MOVE_SELF);
+    if (wd < 0)
+    {
+        LOG_WARN << "Cannot watch " << dir << ", its static files are cached "
+                 << "for " << cacheTime_ << " seconds";
+        return false;
+    }
+    dirWatches_[dir] = wd;
+    watchedDirs_[wd] = dir;
+    return true;
+#else
+    (void)filePath;
+    return false;
+#endif
+}
+
+void StaticFileCache::onFileEvents()
+{
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[8192];
+    while (true)
+    {
+        auto len = ::read(notifyFd_, buffer, sizeof(buffer));
+        if (len <= 0)
+            break;
+        // The changed files of a read are removed at once
+        std::vector<std::string> changed;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (ssize_t offset = 0; offset < len;)
+        {
+            auto event =
+                reinterpret_cast<struct inotify_event *>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // Events are lost, nothing cached can be trusted
+                removeIf([](const Entry &) { return true; });
+                files_.clear();
+                ++invalidations_;
+                continue;
+            }
+            auto iter = watchedDirs_.find(event->wd);
+            if (iter == watchedDirs_.end())
+                continue;
+            const auto &dir = iter->second;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                auto prefix = dir + "/";
+                auto inDir = [&prefix](const std::string &filePath) {
+                    return filePath.compare(0, prefix.length(), prefix) == 0;
+                };
+                removeIf([&inDir](const Entry &entry) {
+                    return inDir(entry.filePath);
+                });
+                for (auto fileIter = files_.begin(); fileIter != files_.end();)
+                {
+                    if (inDir(fileIter->first))
+                        fileIter = files_.erase(fileIter);
+                    else
+                        ++fileIter;
+                }
+                ++invalidations_;
+                if (event->mask & IN_IGNORED)
+                {
+                    dirWatches_.erase(dir);
+                    watchedDirs_.erase(iter);
+                }
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+            std::string path = dir + "/" + event->name;
+            LOG_TRACE << "Static file changed: " << path;
+            changed.push_back(std::move(path));
+        }
+        removeFiles(changed);
+    }
+#endif
+}
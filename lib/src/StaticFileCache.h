@@ -0,0 +1,219 @@
+/**
+ *
+ *  @file StaticFileCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "BuiltinMetrics.h"
+#include "OpenedFile.h"
+#include <drogon/HttpResponse.h>
+#include <drogon/IOThreadStorage.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace trantor
+{
+class Channel;
+}
+
+namespace drogon
+{
+/**
+ * @brief The cache of static file responses shared by all the IO threads.
+ *
+ * The responses are stored once per process within a byte budget, the least
+ * recently used ones are evicted first. Lookups do not take any lock: every
+ * IO thread keeps the last snapshot of the cache and only refreshes it when
+ * the cache has changed. The snapshot is split in shards copied on write, so
+ * a change only copies the shard of the entry. A thread sends its own clones
+ * of the cached responses, which share the body of the cached response and
+ * only own their rendered headers.
+ *
+ * The cache also keeps the handles of the files it has opened, see
+ * OpenedFile.
+ *
+ * On Linux, the directories of the cached files are watched with inotify and
+ * the entries are dropped as soon as their files change. The entries still
+ * expire after the cache time, which is the only bound on the other
+ * platforms or if a directory cannot be watched.
+ */
+class StaticFileCache : public trantor::NonCopyable
+{
+  public:
+    /**
+     * @param maxBytes The budget of all the cached responses.
+     * @param cacheTime The lifetime in seconds of the entries, 0 means until
+     * their files change.
+     * @param loop The loop reading the file change notifications.
+     */
+    StaticFileCache(size_t maxBytes, int cacheTime, trantor::EventLoop *loop);
+    ~StaticFileCache();
+
+    /**
+     * @brief Return the response cached for the key, or nullptr.
+     */
+    HttpResponsePtr find(const std::string &key);
+
+    /**
+     * @brief Cache the response of the file for the key.
+     *
+     * @param generation The generation() read before the response was built
+     * from the file, the response is not cached if a file has changed since.
+     * @return The response to send instead of resp.
+     */
+    HttpResponsePtr insert(const std::string &key,
+                           const std::string &filePath,
+                           const HttpResponsePtr &resp,
+                           uint64_t generation);
+
+    /**
+     * @brief Return the handle of the file, the file is opened again only
+     * after it has changed or after the cache time.
+     *
+     * @return nullptr if the path is not a regular file.
+     */
+    OpenedFilePtr openFile(const std::string &path);
+
+    /**
+     * @brief The number of invalidations so far.
+     */
+    uint64_t generation();
+
+    /**
+     * @brief Drop the entries of the file, including those sent from a
+     * precompressed variant of it.
+     */
+    void invalidate(const std::string &path);
+
+    size_t bytes() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+  private:
+    struct Entry
+    {
+        Entry(const std::string &path,
+              const HttpResponsePtr &resp,
+              size_t size,
+              int64_t expiryTime,
+              int64_t now)
+            : filePath(path),
+              response(resp),
+              bytes(size),
+              expiry(expiryTime),
+              lastUsed(now)
+        {
+        }
+
+        std::string filePath;
+        // The prototype of the clones sent by the IO threads, never sent
+        // itself
+        HttpResponsePtr response;
+        size_t bytes;
+        int64_t expiry;  // In milliseconds of the steady clock, 0 for never
+        mutable std::atomic<int64_t> lastUsed;
+    };
+
+    struct FileEntry
+    {
+        OpenedFilePtr file;
+        int64_t expiry;
+        int64_t lastUsed;
+    };
+
+    using EntryPtr = std::shared_ptr<const Entry>;
+    using Shard = std::unordered_map<std::string, EntryPtr>;
+
+    static constexpr size_t kShards = 64;
+
+    struct Snapshot
+    {
+        // Shared by the snapshots until one of them changes it
+        std::array<std::shared_ptr<const Shard>, kShards> shards;
+    };
+
+    // A new snapshot being built under the mutex, a shard is copied the
+    // first time it is changed
+    struct SnapshotUpdate
+    {
+        explicit SnapshotUpdate(const Snapshot &base)
+            : snapshot(std::make_shared<Snapshot>(base))
+        {
+        }
+
+        Shard &shard(size_t index);
+
+        std::shared_ptr<Snapshot> snapshot;
+        std::array<std::shared_ptr<Shard>, kShards> copies;
+    };
+
+    using Clones =
+        std::unordered_map<std::string, std::pair<EntryPtr, HttpResponsePtr>>;
+
+    struct ThreadView
+    {
+        std::shared_ptr<const Snapshot> snapshot;
+        uint64_t version{0};
+        // Indexed like the shards
+        std::array<Clones, kShards> clones;
+    };
+
+    static int64_t now();
+    static size_t shardOf(const std::string &key);
+    static HttpResponsePtr clone(const HttpResponsePtr &resp);
+    void refreshView(ThreadView &view);
+    // The functions below must be called with the mutex locked
+    void publish(SnapshotUpdate &update);
+    template <typename Pred>
+    void removeIf(Pred &&pred);
+    void removeFiles(const std::vector<std::string> &paths);
+    void evict(SnapshotUpdate &update, const std::string &keptKey);
+    bool watch(const std::string &filePath);
+    void onFileEvents();
+    int64_t expiryFrom(int64_t current) const
+    {
+        return cacheTime_ > 0
+                   ? current + static_cast<int64_t>(cacheTime_) * 1000
+                   : 0;
+    }
+
+    const size_t maxBytes_;
+    const int cacheTime_;
+    trantor::EventLoop *loop_;
+
+    // Guards the fields below, lookups only take it when the snapshot of their
+    // thread is out of date
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Snapshot> snapshot_;
+    AccountedBytes bytes_{BuiltinMetrics::MemoryUser::kStaticFiles};
+    uint64_t invalidations_{0};
+    std::unordered_map<std::string, FileEntry> files_;
+    std::atomic<uint64_t> version_{1};
+    IOThreadStorage<ThreadView> views_;
+
+    int notifyFd_{-1};
+    std::unique_ptr<trantor::Channel> notifyChannel_;
+    std::unordered_map<int, std::string> watchedDirs_;
+    std::unordered_map<std::string, int> dirWatches_;
+};
+}  // namespace drogon
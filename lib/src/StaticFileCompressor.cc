@@ -0,0 +1,264 @@
+/**
+ *
+ *  @file StaticFileCompressor.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "StaticFileCompressor.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+// Smaller files do not gain from compression, the compression of larger
+// ones would hold their thread for too long
+constexpr size_t kMinSize = 1024;
+constexpr size_t kMaxSize = 64 * 1024 * 1024;
+// A failed compression is tried again after this many seconds, and at most
+// this many failures are remembered
+constexpr double kFailureTimeout = 600.0;
+constexpr size_t kMaxFailedPaths = 4096;
+}  // namespace
+
+StaticFileCompressor::StaticFileCompressor(const std::string &cachePath)
+    : cachePath_(cachePath),
+      queue_(std::min(2u, std::max(1u, std::thread::hardware_concurrency())),
+             "StaticFileCompressor")
+{
+    std::error_code err;
+#ifdef _WIN32
+    std::filesystem::create_directories(utils::toNativePath(cachePath_), err);
+    if (err)
+    {
+        LOG_ERROR << "Cannot create the static file compression cache "
+                  << cachePath_ << ": " << err.message();
+        return;
+    }
+    usable_ = true;
+#else
+    // The cache itself is created private
+    auto parent = std::filesystem::path(cachePath_).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, err);
+    if (::mkdir(cachePath_.c_str(), 0700) != 0 && errno != EEXIST)
+    {
+        LOG_ERROR << "Cannot create the static file compression cache "
+                  << cachePath_ << ": " << strerror(errno);
+        return;
+    }
+    // The files of the cache are sent to the clients, another local user
+    // must not be able to plant them, e.g. by creating the directory first
+    struct stat st;
+    if (::lstat(cachePath_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) ||
+        st.st_uid != ::geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+    {
+        LOG_ERROR << "The static file compression cache " << cachePath_
+                  << " must be a directory owned by the user of the "
+                     "process and only writable by it";
+        return;
+    }
+    usable_ = true;
+#endif
+}
+
+StaticFileCompressor::~StaticFileCompressor()
+{
+    queue_.stop();
+}
+
+bool StaticFileCompressor::isCompressible(const OpenedFile &file,
+                                          ContentEncoding encoding)
+{
+    if (file.size() < kMinSize || file.size() > kMaxSize)
+        return false;
+    switch (encoding)
+    {
+        case ContentEncoding::kGzip:
+            break;
+#ifdef USE_BROTLI
+        case ContentEncoding::kBrotli:
+            break;
+#endif
+        default:
+            return false;
+    }
+    // Formats before CT_APPLICATION_OCTET_STREAM are text
+    auto type = getContentType(file.path());
+    return (type != CT_NONE && type < CT_APPLICATION_OCTET_STREAM) ||
+           type == CT_IMAGE_SVG_XML || type == CT_APPLICATION_XHTML ||
+           type == CT_APPLICATION_X_FONT_TRUETYPE ||
+           type == CT_APPLICATION_X_FONT_OPENTYPE ||
+           type == CT_APPLICATION_VND_MS_FONTOBJ;
+}
+
+std::string StaticFileCompressor::compressedPath(const OpenedFile &file,
+                                                 ContentEncoding encoding) const
+{
+    std::string path = cachePath_;
+    path.append("/").append(utils::getMd5(file.path())).append("-");
+    // Without the quotes
+    path.append(file.etag(), 1, file.etag().length() - 2);
+    path.append(encoding == ContentEncoding::kBrotli ? ".br" : ".gz");
+    return path;
+}
+
+StaticFileCompressor::Status StaticFileCompressor::status(
+    const std::string &path) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pendingPaths_.find(path) != pendingPaths_.end())
+        return Status::kPending;
+    auto iter = failedPaths_.find(path);
+    if (iter != failedPaths_.end() &&
+        iter->second.after(kFailureTimeout) > trantor::Date::now())
+        return Status::kFailed;
+    return Status::kUnknown;
+}
+
+void StaticFileCompressor::schedule(const OpenedFilePtr &file,
+                                    ContentEncoding encoding,
+                                    const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pendingPaths_.insert(path).second)
+            return;
+    }
+    queue_.runTaskInQueue([this, file, encoding, path]() {
+        auto done = compress(file, encoding, path);
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingPaths_.erase(path);
+        if (done)
+        {
+            failedPaths_.erase(path);
+            return;
+        }
+        // A file which can not be compressed is not compressed again for a
+        // while
+        auto now = trantor::Date::now();
+        if (failedPaths_.size() >= kMaxFailedPaths)
+        {
+            for (auto iter = failedPaths_.begin(); iter != failedPaths_.end();)
+            {
+                if (iter->second.after(kFailureTimeout) <= now)
+                    iter = failedPaths_.erase(iter);
+                else
+                    ++iter;
+            }
+            if (failedPaths_.size() >= kMaxFailedPaths)
+                failedPaths_.clear();
+        }
+        failedPaths_[path] = now;
+    });
+}
+
+bool StaticFileCompressor::compress(const OpenedFilePtr &file,
+                                    ContentEncoding encoding,
+                                    const std::string &path)
+{
+    std::string data(file->size(), '\0');
+    if (file->isOpen())
+    {
+        // Truncated since it was opened, it is compressed again once its
+        // new version is requested
+        if (file->read(0, &data[0], data.length()) != data.length())
+        {
+            LOG_ERROR << "Cannot read " << file->path();
+            return false;
+        }
+    }
+    else
+    {
+        std::ifstream in(utils::toNativePath(file->path()),
+                         std::ios::binary);
+        if (!in.read(&data[0], static_cast<std::streamsize>(data.length())))
+        {
+            LOG_ERROR << "Cannot read " << file->path();
+            return false;
+        }
+    }
+
+    auto compressed =
+        encoding == ContentEncoding::kBrotli
+            ? utils::brotliCompress(data.data(), data.length(), 11)
+            : utils::gzipCompress(data.data(), data.length(), 9);
+    if (compressed.empty() || compressed.length() >= data.length())
+        return false;
+
+    auto tmpPath = path + "." + utils::genRandomString(8) + ".tmp";
+    {
+        std::ofstream out(utils::toNativePath(tmpPath),
+                          std::ios::binary | std::ios::trunc);
+        if (!out.write(compressed.data(),
+                       static_cast<std::streamsize>(compressed.length())))
+        {
+            LOG_ERROR << "Cannot write " << tmpPath;
+            return false;
+        }
+    }
+    std::error_code err;
+    std::filesystem::rename(utils::toNativePath(tmpPath),
+                            utils::toNativePath(path),
+                            err);
+    if (err)
+    {
+        LOG_ERROR << "Cannot rename " << tmpPath << ": " << err.message();
+        std::filesystem::remove(utils::toNativePath(tmpPath), err);
+        return false;
+    }
+    LOG_TRACE << "Compressed " << file->path() << " into " << path;
+    removeOtherVariants(path);
+    return true;
+}
+
+void StaticFileCompressor::removeOtherVariants(const std::string &path) const
+{
+    // The variants of the source share the md5 of its path and the
+    // extension, they differ in the ETag
+    auto name = path.substr(cachePath_.length() + 1);
+    auto dash = name.find('-');
+    auto dot = name.rfind('.');
+    if (dash == std::string::npos || dot == std::string::npos || dot < dash)
+        return;
+    std::string_view prefix(name.data(), dash + 1);
+    std::string_view extension(name.data() + dot);
+    std::error_code err;
+    std::filesystem::directory_iterator iter(utils::toNativePath(cachePath_),
+                                             err);
+    for (; !err && iter != std::filesystem::directory_iterator();
+         iter.increment(err))
+    {
+        // The names in the cache are ASCII
+        auto other = iter->path().filename().string();
+        if (other == name || other.length() < prefix.length() +
+                                                  extension.length() ||
+            other.compare(0, prefix.length(), prefix) != 0 ||
+            other.compare(other.length() - extension.length(),
+                          extension.length(),
+                          extension) != 0)
+            continue;
+        std::error_code removeErr;
+        std::filesystem::remove(iter->path(), removeErr);
+        if (!removeErr)
+            LOG_TRACE << "Removed the old compressed file " << other;
+    }
+}
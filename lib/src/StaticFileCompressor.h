@@ -0,0 +1,103 @@
+/**
+ *
+ *  @file StaticFileCompressor.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpUtils.h"
+#include "OpenedFile.h"
+#include <trantor/utils/ConcurrentTaskQueue.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/NonCopyable.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace drogon
+{
+/**
+ * @brief Compresses the static files which have no precompressed sibling on
+ * background threads, into a cache directory.
+ *
+ * A compressed file is named after the path and the ETag of its source, so
+ * a changed source never matches an old compressed file, which is deleted
+ * once the new one is written. Compressed files are written under a
+ * temporary name and renamed, so they are complete once they can be opened.
+ *
+ * The cache directory is created with the mode 0700 and it is only used if
+ * it is owned by the user of the process and not writable by other users.
+ */
+class StaticFileCompressor : public trantor::NonCopyable
+{
+  public:
+    explicit StaticFileCompressor(const std::string &cachePath);
+    ~StaticFileCompressor();
+
+    /**
+     * @brief Return false if the cache directory can't be used, nothing is
+     * compressed then.
+     */
+    bool usable() const
+    {
+        return usable_;
+    }
+
+    /**
+     * @brief Return true if the file is worth compressing for the content
+     * encoding.
+     */
+    static bool isCompressible(const OpenedFile &file,
+                               ContentEncoding encoding);
+
+    /**
+     * @brief The path of the compressed variant of the file.
+     */
+    std::string compressedPath(const OpenedFile &file,
+                               ContentEncoding encoding) const;
+
+    enum class Status
+    {
+        kUnknown,  // Not compressed by this process, it may exist on disk
+        kPending,
+        kFailed  // Including the files which compression does not reduce
+    };
+
+    /**
+     * @brief The status of the compression into the path, the path only needs
+     * to be opened if it is kUnknown.
+     */
+    Status status(const std::string &path) const;
+
+    /**
+     * @brief Compress the file into the path on the background threads.
+     */
+    void schedule(const OpenedFilePtr &file,
+                  ContentEncoding encoding,
+                  const std::string &path);
+
+  private:
+    bool compress(const OpenedFilePtr &file,
+                  ContentEncoding encoding,
+                  const std::string &path);
+    void removeOtherVariants(const std::string &path) const;
+
+    std::string cachePath_;
+    bool usable_{false};
+    mutable std::mutex mutex_;
+    std::unordered_set<std::string> pendingPaths_;
+    // The paths which failed and when, they are tried again after a while
+    std::unordered_map<std::string, trantor::Date> failedPaths_;
+    // Destroyed first, the running tasks use the fields above
+    trantor::ConcurrentTaskQueue queue_;
+};
+}  // namespace drogon
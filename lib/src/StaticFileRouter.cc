@@ -13,6 +13,7 @@
  */
 
 #include "StaticFileRouter.h"
+#include "AOPAdvice.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
@@ -21,35 +22,40 @@
 #include <iostream>
 #include <algorithm>
 #include <memory>
-#include <fcntl.h>
+#include <filesystem>
 #ifndef _WIN32
-#include <sys/file.h>
-#elif !defined(__MINGW32__)
-#define stat _wstati64
-#define S_ISREG(m) (((m) & 0170000) == (0100000))
-#define S_ISDIR(m) (((m) & 0170000) == (0040000))
+#include <unistd.h>
 #endif
-#include <sys/stat.h>
-#include <filesystem>
 
 using namespace drogon;
 
 void StaticFileRouter::init(const std::vector<trantor::EventLoop *> &ioLoops)
 {
-    // Max timeout up to about 70 days;
-    staticFilesCacheMap_ = std::make_unique<
-        IOThreadStorage<std::unique_ptr<CacheMap<std::string, char>>>>();
-    staticFilesCacheMap_->init(
-        [&ioLoops](std::unique_ptr<CacheMap<std::string, char>> &mapPtr,
-                   size_t i) {
-            assert(i == ioLoops[i]->index());
-            mapPtr = std::make_unique<CacheMap<std::string, char>>(ioLoops[i],
-                                                                   1.0f,
-                                                                   4,
-                                                                   50);
-        });
-    staticFilesCache_ = std::make_unique<
-        IOThreadStorage<std::unordered_map<std::string, HttpResponsePtr>>>();
+    if (staticFilesCacheTime_ >= 0 && staticFilesCacheSize_ > 0)
+    {
+        staticFilesCache_ = std::make_unique<StaticFileCache>(
+            staticFilesCacheSize_, staticFilesCacheTime(), app().getLoop());
+    }
+    if (staticFilesCompression_)
+    {
+        auto cachePath = staticFilesCompressionPath_;
+        if (cachePath.empty())
+        {
+            // A directory of each user, the compressor checks its owner
+            std::string name = "drogon_compressed_static_files";
+#ifndef _WIN32
+            name.append("_").append(std::to_string(::geteuid()));
+#endif
+            cachePath =
+                (std::filesystem::temp_directory_path() / name).string();
+        }
+        compressor_ = std::make_unique<StaticFileCompressor>(cachePath);
+        if (!compressor_->usable())
+        {
+            LOG_ERROR << "The static files are not compressed";
+            compressor_.reset();
+        }
+    }
     ioLocationsPtr_ =
         std::make_shared<IOThreadStorage<std::vector<Location>>>();
     for (auto *loop : ioLoops)
@@ -63,8 +69,8 @@ void StaticFileRouter::init(const std::vector<trantor::EventLoop *> &ioLoops)
 
 void StaticFileRouter::reset()
 {
-    staticFilesCacheMap_.reset();
     staticFilesCache_.reset();
+    compressor_.reset();
     ioLocationsPtr_.reset();
     locations_.clear();
 }
@@ -159,14 +165,22 @@ void StaticFileRouter::route(
             std::string filePath =
                 location.realLocation_ +
                 std::string{restOfThePath.data(), restOfThePath.length()};
-            std::filesystem::path fsFilePath(utils::toNativePath(filePath));
-            std::error_code err;
-            if (!std::filesystem::exists(fsFilePath, err))
+            // A cached file is known to exist, the cache is invalidated
+            // when it is removed
+            bool isDirectory = false;
+            if (!isCached(filePath, req))
             {
-                defaultHandler_(req, std::move(callback));
-                return;
+                std::filesystem::path fsFilePath(
+                    utils::toNativePath(filePath));
+                std::error_code err;
+                if (!std::filesystem::exists(fsFilePath, err))
+                {
+                    defaultHandler_(req, std::move(callback));
+                    return;
+                }
+                isDirectory = std::filesystem::is_directory(fsFilePath, err);
             }
-            if (std::filesystem::is_directory(fsFilePath, err))
+            if (isDirectory)
             {
                 // Check if path is eligible for an implicit index.html
                 if (implicitPageEnable_)
@@ -215,8 +229,7 @@ void StaticFileRouter::route(
             }
             else
             {
-                middlewares_function::passMiddlewares(
-                    location.middlewares_,
+                location.middlewares_.pass(
                     req,
                     std::move(callback),
                     [this,
@@ -239,9 +252,10 @@ void StaticFileRouter::route(
         HttpAppFrameworkImpl::instance().getDocumentRoot() + path;
     std::filesystem::path fsDirectoryPath(utils::toNativePath(directoryPath));
     std::error_code err;
-    if (std::filesystem::exists(fsDirectoryPath, err))
+    bool cached = isCached(directoryPath, req);
+    if (cached || std::filesystem::exists(fsDirectoryPath, err))
     {
-        if (std::filesystem::is_directory(fsDirectoryPath, err))
+        if (!cached && std::filesystem::is_directory(fsDirectoryPath, err))
         {
             // Check if path is eligible for an implicit index.html
             if (implicitPageEnable_)
@@ -278,46 +292,203 @@ void StaticFileRouter::route(
     defaultHandler_(req, std::move(callback));
 }
 
-// Expand this struct as you need, nothing to worry about
-struct FileStat
+static HttpResponsePtr newNotModifiedResponse(const std::string &etag)
 {
-    size_t fileSize_;
-    struct tm modifiedTime_;
-    std::string modifiedTimeStr_;
-};
+    LOG_TRACE << "Not modified!";
+    std::shared_ptr<HttpResponseImpl> resp =
+        std::make_shared<HttpResponseImpl>();
+    resp->setStatusCode(k304NotModified);
+    resp->setContentTypeCode(CT_NONE);
+    if (!etag.empty())
+        resp->addHeader("ETag", etag);
+    return resp;
+}
 
-// A wrapper to call stat()
-// std::filesystem::file_time_type::clock::to_time_t still not
-// implemented by M$, even in c++20, so keep calls to stat()
-static bool getFileStat(const std::string &filePath, FileStat &myStat)
+// rfc9110-13.1.3, If-Modified-Since is ignored when If-None-Match is present
+static bool isNotModified(const HttpRequestImplPtr &req,
+                          const std::string &lastModified,
+                          const std::string &etag)
 {
-#if defined(_WIN32) && !defined(__MINGW32__)
-    struct _stati64 fileStat;
-#else   // _WIN32
-    struct stat fileStat;
-#endif  // _WIN32
-    if (stat(utils::toNativePath(filePath).c_str(), &fileStat) == 0 &&
-        S_ISREG(fileStat.st_mode))
+    auto noneMatch = req->getHeaderView(HttpHeaderId::kIfNoneMatch);
+    if (!noneMatch.empty())
     {
-        LOG_TRACE << "last modify time:" << fileStat.st_mtime;
-#ifdef _WIN32
-        gmtime_s(&myStat.modifiedTime_, &fileStat.st_mtime);
-#else
-        gmtime_r(&fileStat.st_mtime, &myStat.modifiedTime_);
-#endif
-        std::string &timeStr = myStat.modifiedTimeStr_;
-        timeStr.resize(64);
-        size_t len = strftime((char *)timeStr.data(),
-                              timeStr.size(),
-                              "%a, %d %b %Y %H:%M:%S GMT",
-                              &myStat.modifiedTime_);
-        timeStr.resize(len);
+        return !etag.empty() &&
+               (noneMatch == "*" || noneMatch.find(etag) != std::string::npos);
+    }
+    return req->getHeaderView(HttpHeaderId::kIfModifiedSince) == lastModified;
+}
+
+static HttpResponsePtr newFileResponse(const OpenedFilePtr &file,
+                                       size_t offset,
+                                       size_t length,
+                                       bool setContentRange,
+                                       const std::string &filePath,
+                                       const HttpRequestImplPtr &req)
+{
+    auto ct = fileNameToContentTypeAndMime(filePath);
+    auto fromDisk = [&]() {
+        return HttpResponse::newFileResponse(file->path(),
+                                             offset,
+                                             length,
+                                             setContentRange,
+                                             "",
+                                             ct.first,
+                                             std::string(ct.second),
+                                             req);
+    };
+    if (!file->isOpen())
+        return fromDisk();
+    if (length == 0)
+        length = file->size() - offset;
+    auto resp = std::make_shared<HttpResponseImpl>();
+    if (HttpAppFrameworkImpl::instance().useSendfile() && length > 1024 * 200)
+    {
+        resp->setOpenedFile(file, offset, length);
+    }
+    else
+    {
+        std::string body(length, '\0');
+        // A file truncated in place since it was opened is read again
+        if (length > 0 && file->read(offset, &body[0], length) != length)
+            return fromDisk();
+        resp->setBody(std::move(body));
+    }
+    resp->setStatusCode(length < file->size() ? k206PartialContent : k200OK);
+    if (ct.second.empty())
+    {
+        resp->setContentTypeCode(CT_APPLICATION_OCTET_STREAM);
+    }
+    else
+    {
+        static_cast<HttpResponse *>(resp.get())
+            ->setContentTypeCodeAndCustomString(ct.first, ct.second);
+    }
+    if (setContentRange)
+    {
+        char buf[128];
+        snprintf(buf,
+                 sizeof(buf),
+                 "bytes %zu-%zu/%zu",
+                 offset,
+                 offset + length - 1,
+                 file->size());
+        resp->addHeader("Content-Range", std::string(buf));
+    }
+    AopAdvice::instance().passResponseCreationAdvices(resp);
+    return resp;
+}
 
-        myStat.fileSize_ = fileStat.st_size;
-        return true;
+namespace
+{
+struct MultipartRanges
+{
+    OpenedFilePtr file;
+    // parts[i] precedes ranges[i], the last part closes the body
+    std::vector<std::string> parts;
+    std::vector<FileRange> ranges;
+    size_t index{0};
+    size_t pos{0};
+    bool inPart{true};
+};
+}  // namespace
+
+// rfc7233-4.1, sends the ranges from the open file
+static HttpResponsePtr newMultipartRangesResponse(
+    const OpenedFilePtr &file,
+    std::vector<FileRange> &&ranges,
+    const std::string &filePath)
+{
+    auto ct = fileNameToContentTypeAndMime(filePath);
+    auto boundary = utils::genRandomString(32);
+    auto ctx = std::make_shared<MultipartRanges>();
+    ctx->file = file;
+    ctx->ranges = std::move(ranges);
+    size_t length = 0;
+    for (auto &range : ctx->ranges)
+    {
+        char buf[64];
+        snprintf(buf,
+                 sizeof(buf),
+                 "bytes %zu-%zu/%zu",
+                 range.start,
+                 range.end - 1,
+                 file->size());
+        std::string part;
+        part.append("\r\n--").append(boundary);
+        part.append("\r\ncontent-type: ")
+            .append(ct.second.empty() ? "application/octet-stream"
+                                      : ct.second);
+        part.append("\r\ncontent-range: ").append(buf).append("\r\n\r\n");
+        length += part.length() + range.end - range.start;
+        ctx->parts.emplace_back(std::move(part));
     }
+    ctx->parts.emplace_back("\r\n--" + boundary + "--\r\n");
+    length += ctx->parts.back().length();
+
+    auto resp = std::make_shared<HttpResponseImpl>();
+    resp->setStatusCode(k206PartialContent);
+    static_cast<HttpResponse *>(resp.get())
+        ->setContentTypeCodeAndCustomString(
+            CT_CUSTOM, "multipart/byteranges; boundary=" + boundary);
+    resp->addHeader("content-length", std::to_string(length));
+    resp->setStreamCallback([ctx](char *buffer, size_t len) -> size_t {
+        if (buffer == nullptr)
+            return 0;
+        size_t written = 0;
+        while (written < len && ctx->index < ctx->parts.size())
+        {
+            size_t pieceLength;
+            size_t n;
+            if (ctx->inPart)
+            {
+                auto &part = ctx->parts[ctx->index];
+                pieceLength = part.length();
+                n = std::min(len - written, pieceLength - ctx->pos);
+                memcpy(buffer + written, part.data() + ctx->pos, n);
+            }
+            else
+            {
+                auto &range = ctx->ranges[ctx->index];
+                pieceLength = range.end - range.start;
+                n = std::min(len - written, pieceLength - ctx->pos);
+                if (n > 0 &&
+                    ctx->file->read(range.start + ctx->pos,
+                                    buffer + written,
+                                    n) != n)
+                {
+                    // Truncated meanwhile, the body can not be completed
+                    LOG_ERROR << "File truncated while sending: "
+                              << ctx->file->path();
+                    return written;
+                }
+            }
+            written += n;
+            ctx->pos += n;
+            if (ctx->pos == pieceLength)
+            {
+                ctx->pos = 0;
+                if (ctx->inPart && ctx->index < ctx->ranges.size())
+                {
+                    ctx->inPart = false;
+                }
+                else
+                {
+                    ctx->inPart = true;
+                    ++ctx->index;
+                }
+            }
+        }
+        return written;
+    });
+    AopAdvice::instance().passResponseCreationAdvices(resp);
+    return resp;
+}
 
-    return false;
+OpenedFilePtr StaticFileRouter::openFile(const std::string &filePath)
+{
+    if (staticFilesCache_)
+        return staticFilesCache_->openFile(filePath);
+    return OpenedFile::open(filePath);
 }
 
 void StaticFileRouter::sendStaticFileResponse(
@@ -332,61 +503,72 @@ void StaticFileRouter::sendStaticFileResponse(
         return;
     }
 
-    FileStat fileStat;
-    bool fileExists = false;
+    // Read before any file is opened
+    uint64_t generation =
+        staticFilesCache_ ? staticFilesCache_->generation() : 0;
+    OpenedFilePtr file;
     const std::string &rangeStr = req->getHeaderBy("range");
     if (enableRange_ && !rangeStr.empty())
     {
-        if (!getFileStat(filePath, fileStat))
+        file = openFile(filePath);
+        if (!file)
         {
             defaultHandler_(req, std::move(callback));
             return;
         }
-        fileExists = true;
         // Check last modified time, rfc2616-14.25
         // If-Modified-Since: Mon, 15 Oct 2018 06:26:33 GMT
         // According to rfc 7233-3.1, preconditions must be evaluated before
-        const std::string &modiStr = req->getHeaderBy("if-modified-since");
-        if (enableLastModify_ && modiStr == fileStat.modifiedTimeStr_)
+        if (enableLastModify_ &&
+            isNotModified(req, file->lastModified(), file->etag()))
         {
-            LOG_TRACE << "Not modified!";
-            std::shared_ptr<HttpResponseImpl> resp =
-                std::make_shared<HttpResponseImpl>();
-            resp->setStatusCode(k304NotModified);
-            resp->setContentTypeCode(CT_NONE);
-            callback(resp);
+            callback(newNotModifiedResponse(file->etag()));
             return;
         }
         // Check If-Range precondition
-        const std::string &ifRange = req->getHeaderBy("if-range");
-        if (ifRange.empty() || ifRange == fileStat.modifiedTimeStr_)
+        auto ifRange = req->getHeaderView(HttpHeaderId::kIfRange);
+        if (ifRange.empty() || ifRange == file->lastModified() ||
+            ifRange == file->etag())
         {
             std::vector<FileRange> ranges;
-            switch (parseRangeHeader(rangeStr, fileStat.fileSize_, ranges))
+            auto result = parseRangeHeader(rangeStr, file->size(), ranges);
+            // Without an open file, only the first range is sent
+            if (result == FileRangeParseResult::MultiPart &&
+                !file->isOpen())
+            {
+                result = FileRangeParseResult::SinglePart;
+            }
+            switch (result)
             {
-                // TODO: support only single range now
-                // Contributions are welcomed.
                 case FileRangeParseResult::SinglePart:
-                case FileRangeParseResult::MultiPart:
                 {
                     auto firstRange = ranges.front();
-                    auto ct = fileNameToContentTypeAndMime(filePath);
                     auto resp =
-                        HttpResponse::newFileResponse(filePath,
-                                                      firstRange.start,
-                                                      firstRange.end -
-                                                          firstRange.start,
-                                                      true,
-                                                      "",
-                                                      ct.first,
-                                                      std::string(ct.second),
-                                                      req);
-                    if (!fileStat.modifiedTimeStr_.empty())
+                        newFileResponse(file,
+                                        firstRange.start,
+                                        firstRange.end - firstRange.start,
+                                        true,
+                                        filePath,
+                                        req);
+                    if (enableLastModify_)
                     {
-                        resp->addHeader("Last-Modified",
-                                        fileStat.modifiedTimeStr_);
+                        resp->addHeader("Last-Modified", file->lastModified());
                         resp->addHeader("Expires",
                                         "Thu, 01 Jan 1970 00:00:00 GMT");
+                        resp->addHeader("ETag", file->etag());
+                    }
+                    callback(resp);
+                    return;
+                }
+                case FileRangeParseResult::MultiPart:
+                {
+                    auto resp = newMultipartRangesResponse(file,
+                                                           std::move(ranges),
+                                                           filePath);
+                    if (enableLastModify_)
+                    {
+                        resp->addHeader("Last-Modified", file->lastModified());
+                        resp->addHeader("ETag", file->etag());
                     }
                     callback(resp);
                     return;
@@ -396,10 +578,7 @@ void StaticFileRouter::sendStaticFileResponse(
                     auto resp = HttpResponse::newHttpResponse();
                     resp->setStatusCode(k416RequestedRangeNotSatisfiable);
                     char buf[64];
-                    snprintf(buf,
-                             sizeof(buf),
-                             "bytes */%zu",
-                             fileStat.fileSize_);
+                    snprintf(buf, sizeof(buf), "bytes */%zu", file->size());
                     resp->addHeader("Content-Range", std::string(buf));
                     callback(resp);
                     return;
@@ -423,122 +602,127 @@ void StaticFileRouter::sendStaticFileResponse(
 
     // find cached response
     HttpResponsePtr cachedResp;
-    auto &cacheMap = staticFilesCache_->getThreadData();
-    auto iter = cacheMap.find(filePath);
-    if (iter != cacheMap.end())
+    std::string key;
+    if (staticFilesCache_)
     {
-        cachedResp = iter->second;
+        key = cacheKey(filePath, req);
+        cachedResp = staticFilesCache_->find(key);
     }
-
-    if (enableLastModify_)
+    if (cachedResp)
     {
-        if (cachedResp)
+        auto respImplPtr = static_cast<HttpResponseImpl *>(cachedResp.get());
+        const std::string &etag = respImplPtr->getHeaderBy("etag");
+        if (enableLastModify_ &&
+            isNotModified(req,
+                          respImplPtr->getHeaderBy("last-modified"),
+                          etag))
         {
-            if (static_cast<HttpResponseImpl *>(cachedResp.get())
-                    ->getHeaderBy("last-modified") ==
-                req->getHeaderBy("if-modified-since"))
-            {
-                std::shared_ptr<HttpResponseImpl> resp =
-                    std::make_shared<HttpResponseImpl>();
-                resp->setStatusCode(k304NotModified);
-                resp->setContentTypeCode(CT_NONE);
-                callback(resp);
-                return;
-            }
-        }
-        else
-        {
-            LOG_TRACE << "enabled LastModify";
-            if (!fileExists && !getFileStat(filePath, fileStat))
-            {
-                defaultHandler_(req, std::move(callback));
-                return;
-            }
-            fileExists = true;
-            const std::string &modiStr = req->getHeaderBy("if-modified-since");
-            if (modiStr == fileStat.modifiedTimeStr_)
-            {
-                LOG_TRACE << "not Modified!";
-                std::shared_ptr<HttpResponseImpl> resp =
-                    std::make_shared<HttpResponseImpl>();
-                resp->setStatusCode(k304NotModified);
-                resp->setContentTypeCode(CT_NONE);
-                callback(resp);
-                return;
-            }
+            callback(newNotModifiedResponse(etag));
+            return;
         }
-    }
-    if (cachedResp)
-    {
         LOG_TRACE << "Using file cache";
         callback(cachedResp);
         return;
     }
     // Check existence
-    if (!fileExists)
+    if (!file)
     {
-        std::filesystem::path fsFilePath(utils::toNativePath(filePath));
-        std::error_code err;
-        if (!std::filesystem::exists(fsFilePath, err) ||
-            !std::filesystem::is_regular_file(fsFilePath, err))
+        file = openFile(filePath);
+        if (!file)
         {
             defaultHandler_(req, std::move(callback));
             return;
         }
     }
 
-    HttpResponsePtr resp;
-    auto &acceptEncoding = req->getHeaderBy("accept-encoding");
-
+    // The file actually sent, a precompressed variant is preferred
+    OpenedFilePtr sentFile;
+    const char *contentEncoding = nullptr;
+    auto acceptEncoding = req->getHeaderView(HttpHeaderId::kAcceptEncoding);
     if (brStaticFlag_ && acceptEncoding.find("br") != std::string::npos)
     {
-        // Find compressed file first.
-        auto brFileName = filePath + ".br";
-        std::filesystem::path fsBrFile(utils::toNativePath(brFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsBrFile, err) &&
-            std::filesystem::is_regular_file(fsBrFile, err))
-        {
-            auto ct = fileNameToContentTypeAndMime(filePath);
-            resp = HttpResponse::newFileResponse(
-                brFileName, "", ct.first, std::string(ct.second), req);
-            resp->addHeader("Content-Encoding", "br");
-        }
+        sentFile = openFile(filePath + ".br");
+        if (sentFile)
+            contentEncoding = "br";
     }
-    if (!resp && gzipStaticFlag_ &&
+    if (!sentFile && gzipStaticFlag_ &&
         acceptEncoding.find("gzip") != std::string::npos)
     {
-        // Find compressed file first.
-        auto gzipFileName = filePath + ".gz";
-        std::filesystem::path fsGzipFile(utils::toNativePath(gzipFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsGzipFile, err) &&
-            std::filesystem::is_regular_file(fsGzipFile, err))
+        sentFile = openFile(filePath + ".gz");
+        if (sentFile)
+            contentEncoding = "gzip";
+    }
+    // Without a precompressed sibling, the file is compressed for the next
+    // requests
+    bool compressing = false;
+    if (!sentFile && compressor_)
+    {
+        auto encoding = ContentEncoding::kNone;
+#ifdef USE_BROTLI
+        if (brStaticFlag_ && acceptEncoding.find("br") != std::string::npos)
+            encoding = ContentEncoding::kBrotli;
+#endif
+        if (encoding == ContentEncoding::kNone && gzipStaticFlag_ &&
+            acceptEncoding.find("gzip") != std::string::npos)
+            encoding = ContentEncoding::kGzip;
+        if (encoding != ContentEncoding::kNone &&
+            StaticFileCompressor::isCompressible(*file, encoding))
         {
-            auto ct = fileNameToContentTypeAndMime(filePath);
-            resp = HttpResponse::newFileResponse(
-                gzipFileName, "", ct.first, std::string(ct.second), req);
-            resp->addHeader("Content-Encoding", "gzip");
+            auto path = compressor_->compressedPath(*file, encoding);
+            switch (compressor_->status(path))
+            {
+                case StaticFileCompressor::Status::kUnknown:
+                    sentFile = openFile(path);
+                    if (sentFile)
+                    {
+                        contentEncoding =
+                            encoding == ContentEncoding::kBrotli ? "br"
+                                                                 : "gzip";
+                        break;
+                    }
+                    compressor_->schedule(file, encoding, path);
+                    compressing = true;
+                    break;
+                case StaticFileCompressor::Status::kPending:
+                    compressing = true;
+                    break;
+                case StaticFileCompressor::Status::kFailed:
+                    break;
+            }
         }
     }
-    if (!resp)
+    if (!sentFile)
+        sentFile = file;
+
+    if (enableLastModify_)
     {
-        auto ct = fileNameToContentTypeAndMime(filePath);
-        resp = HttpResponse::newFileResponse(
-            filePath, "", ct.first, std::string(ct.second), req);
+        LOG_TRACE << "enabled LastModify";
+        if (isNotModified(req, file->lastModified(), sentFile->etag()))
+        {
+            callback(newNotModifiedResponse(sentFile->etag()));
+            return;
+        }
     }
+
+    auto resp = newFileResponse(sentFile, 0, 0, false, filePath, req);
     if (resp->statusCode() != k404NotFound)
     {
+        if (contentEncoding)
+        {
+            resp->addHeader("Content-Encoding", contentEncoding);
+        }
         if (resp->getContentType() == CT_APPLICATION_OCTET_STREAM &&
             !defaultContentType.empty())
         {
             resp->setContentTypeCodeAndCustomString(CT_CUSTOM,
                                                     defaultContentType);
         }
-        if (!fileStat.modifiedTimeStr_.empty())
+        if (enableLastModify_)
         {
-            resp->addHeader("Last-Modified", fileStat.modifiedTimeStr_);
+            resp->addHeader("Last-Modified", file->lastModified());
             resp->addHeader("Expires", "Thu, 01 Jan 1970 00:00:00 GMT");
+            // Every representation has its own strong ETag
+            resp->addHeader("ETag", sentFile->etag());
         }
         if (enableRange_)
         {
@@ -551,20 +735,14 @@ void StaticFileRouter::sendStaticFileResponse(
                 resp->addHeader(header.first, header.second);
             }
         }
-        // cache the response for 5 seconds by default
-        if (staticFilesCacheTime_ >= 0)
+        // cache the response for 5 seconds by default, the compressed file
+        // is sent once it is ready
+        if (staticFilesCache_ && !compressing)
         {
-            LOG_TRACE << "Save in cache for " << staticFilesCacheTime_
-                      << " seconds";
-            resp->setExpiredTime(staticFilesCacheTime_);
-            staticFilesCache_->getThreadData()[filePath] = resp;
-            staticFilesCacheMap_->getThreadData()->insert(
-                filePath, 0, staticFilesCacheTime_, [this, filePath]() {
-                    LOG_TRACE << "Erase cache";
-                    assert(staticFilesCache_->getThreadData().find(filePath) !=
-                           staticFilesCache_->getThreadData().end());
-                    staticFilesCache_->getThreadData().erase(filePath);
-                });
+            int cacheTime = staticFilesCacheTime_;
+            LOG_TRACE << "Save in cache for " << cacheTime << " seconds";
+            resp->setExpiredTime(cacheTime);
+            resp = staticFilesCache_->insert(key, filePath, resp, generation);
         }
         callback(resp);
         return;
@@ -572,6 +750,32 @@ void StaticFileRouter::sendStaticFileResponse(
     callback(resp);
 }
 
+std::string StaticFileRouter::cacheKey(const std::string &filePath,
+                                       const HttpRequestImplPtr &req) const
+{
+    // The response of a file depends on the precompressed variants the
+    // client accepts
+    auto acceptEncoding = req->getHeaderView(HttpHeaderId::kAcceptEncoding);
+    char variants = '0';
+    if (brStaticFlag_ && acceptEncoding.find("br") != std::string::npos)
+        variants |= 1;
+    if (gzipStaticFlag_ && acceptEncoding.find("gzip") != std::string::npos)
+        variants |= 2;
+    std::string key;
+    key.reserve(filePath.length() + 2);
+    key.append(filePath);
+    key.push_back('\0');
+    key.push_back(variants);
+    return key;
+}
+
+bool StaticFileRouter::isCached(const std::string &filePath,
+                                const HttpRequestImplPtr &req) const
+{
+    return staticFilesCache_ &&
+           staticFilesCache_->find(cacheKey(filePath, req)) != nullptr;
+}
+
 void StaticFileRouter::setFileTypes(const std::vector<std::string> &types)
 {
     fileTypeSet_.clear();
@@ -16,8 +16,10 @@
 
 #include "impl_forwards.h"
 #include "MiddlewaresFunction.h"
-#include <drogon/CacheMap.h>
+#include "StaticFileCache.h"
+#include "StaticFileCompressor.h"
 #include <drogon/IOThreadStorage.h>
+#include <atomic>
 #include <functional>
 #include <set>
 #include <string>
@@ -48,6 +50,16 @@ class StaticFileRouter
         return staticFilesCacheTime_;
     }
 
+    void setStaticFilesCacheSize(size_t cacheSize)
+    {
+        staticFilesCacheSize_ = cacheSize;
+    }
+
+    size_t staticFilesCacheSize() const
+    {
+        return staticFilesCacheSize_;
+    }
+
     void setGzipStatic(bool useGzipStatic)
     {
         gzipStaticFlag_ = useGzipStatic;
@@ -58,6 +70,17 @@ class StaticFileRouter
         brStaticFlag_ = useBrStatic;
     }
 
+    void setStaticFilesCompression(bool enable, const std::string &cachePath)
+    {
+        staticFilesCompression_ = enable;
+        staticFilesCompressionPath_ = cachePath;
+    }
+
+    bool isStaticFilesCompressionEnabled() const
+    {
+        return staticFilesCompression_;
+    }
+
     void init(const std::vector<trantor::EventLoop *> &ioLoops);
     void reset();
 
@@ -119,6 +142,11 @@ class StaticFileRouter
     static void defaultHandler(
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback);
+    std::string cacheKey(const std::string &filePath,
+                         const HttpRequestImplPtr &req) const;
+    bool isCached(const std::string &filePath,
+                  const HttpRequestImplPtr &req) const;
+    OpenedFilePtr openFile(const std::string &filePath);
 
     std::set<std::string> fileTypeSet_{"html",
                                        "js",
@@ -140,17 +168,17 @@ class StaticFileRouter
                                        "ico",
                                        "icns"};
 
-    int staticFilesCacheTime_{5};
+    // Can be reloaded while the IO threads read it
+    std::atomic<int> staticFilesCacheTime_{5};
+    size_t staticFilesCacheSize_{64 * 1024 * 1024};
     bool enableLastModify_{true};
     bool enableRange_{true};
     bool gzipStaticFlag_{true};
     bool brStaticFlag_{true};
-    std::unique_ptr<
-        IOThreadStorage<std::unique_ptr<CacheMap<std::string, char>>>>
-        staticFilesCacheMap_;
-    std::unique_ptr<
-        IOThreadStorage<std::unordered_map<std::string, HttpResponsePtr>>>
-        staticFilesCache_;
+    bool staticFilesCompression_{false};
+    std::string staticFilesCompressionPath_;
+    std::unique_ptr<StaticFileCache> staticFilesCache_;
+    std::unique_ptr<StaticFileCompressor> compressor_;
     std::vector<std::pair<std::string, std::string>> headers_;
     bool implicitPageEnable_{true};
     std::string implicitPage_{"index.html"};
@@ -165,7 +193,7 @@ class StaticFileRouter
         bool isCaseSensitive_;
         bool allowAll_;
         bool isRecursive_;
-        std::vector<std::shared_ptr<drogon::HttpMiddlewareBase>> middlewares_;
+        middlewares_function::MiddlewareChain middlewares_;
 
         Location(const std::string &uriPrefix,
                  const std::string &defaultContentType,
@@ -179,7 +207,7 @@ class StaticFileRouter
               isCaseSensitive_(isCaseSensitive),
               allowAll_(allowAll),
               isRecursive_(isRecursive),
-              middlewares_(middlewares_function::createMiddlewares(middlewares))
+              middlewares_(middlewares)
         {
             if (!defaultContentType.empty())
             {
@@ -0,0 +1,222 @@
+/**
+ *
+ *  @file StreamClientContext.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "StreamClientContext.h"
+#include <trantor/utils/Logger.h>
+
+namespace drogon
+{
+StreamClientContext::StreamClientContext(trantor::EventLoop *loop,
+                                         bool headRequest,
+                                         HttpStreamHeadersCallback headersCb,
+                                         HttpStreamDataCallback dataCb,
+                                         HttpReqCallback finishCb)
+    : loop_(loop),
+      headersCallback_(std::move(headersCb)),
+      dataCallback_(std::move(dataCb)),
+      finishCallback_(std::move(finishCb)),
+      parser_(
+          [this](ProxyResponseParser::Head &&head) {
+              onHead(std::move(head));
+          },
+          [this](const char *data, size_t length) { onBody(data, length); })
+{
+    parser_.reset(headRequest);
+}
+
+void StreamClientContext::start(double timeout)
+{
+    self_ = shared_from_this();
+    if (timeout > 0)
+    {
+        std::weak_ptr<StreamClientContext> weakPtr = self_;
+        timerId_ = loop_->runAfter(timeout, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->timerId_ = 0;
+            if (!thisPtr->response_)
+                thisPtr->finish(ReqResult::Timeout);
+        });
+    }
+}
+
+void StreamClientContext::onConnected(const trantor::TcpConnectionPtr &conn)
+{
+    conn_ = conn;
+    if (paused_)
+        conn_->stopRead();
+}
+
+void StreamClientContext::onMessage(trantor::MsgBuffer *buf)
+{
+    if (finished_)
+    {
+        buf->retrieveAll();
+        return;
+    }
+    // The callbacks may finish the request
+    auto thisPtr = shared_from_this();
+    auto n = parser_.parse(buf->peek(), buf->readableBytes());
+    if (n < 0)
+    {
+        buf->retrieveAll();
+        finish(ReqResult::BadResponse);
+        return;
+    }
+    buf->retrieve(static_cast<size_t>(n));
+    if (parser_.done())
+        finish(ReqResult::Ok);
+}
+
+void StreamClientContext::onClose(ReqResult result)
+{
+    conn_.reset();
+    if (finished_)
+        return;
+    if (parser_.finishOnClose())
+    {
+        finish(ReqResult::Ok);
+        return;
+    }
+    finish(result == ReqResult::Ok ? ReqResult::NetworkFailure : result);
+}
+
+void StreamClientContext::onHead(ProxyResponseParser::Head &&head)
+{
+    if (timerId_ != 0)
+    {
+        loop_->invalidateTimer(timerId_);
+        timerId_ = 0;
+    }
+    response_ = std::make_shared<HttpResponseImpl>();
+    response_->setStatusCode(static_cast<HttpStatusCode>(head.statusCode));
+    for (auto &[field, value] : head.headers)
+    {
+        if (field == "set-cookie")
+        {
+            auto line = field + ": " + value;
+            response_->addHeader(line.data(),
+                                 line.data() + field.length(),
+                                 line.data() + line.length());
+            continue;
+        }
+        auto &existing = response_->getHeaderBy(field);
+        if (existing.empty())
+            response_->addHeader(field, value);
+        else
+            response_->addHeader(field, existing + ", " + value);
+    }
+    auto &coding = response_->getHeaderBy("content-encoding");
+    if (coding == "gzip" || coding == "br" || coding == "zstd")
+    {
+        decompressor_ = StreamDecompressor::newDecompressor(coding);
+        if (decompressor_)
+        {
+            // The body passed on is decoded
+            response_->removeHeaderBy("content-encoding");
+            response_->removeHeaderBy("content-length");
+        }
+    }
+    if (conn_)
+        response_->setPeerCertificate(conn_->peerCertificate());
+    if (headersCallback_)
+        headersCallback_(response_, shared_from_this());
+}
+
+void StreamClientContext::onBody(const char *data, size_t length)
+{
+    if (finished_ || length == 0)
+        return;
+    if (!decompressor_)
+    {
+        dataCallback_(data, length);
+        return;
+    }
+    if (!decompressor_->decompress(data,
+                                   length,
+                                   [this](const char *out, size_t outLength) {
+                                       dataCallback_(out, outLength);
+                                       return !finished_;
+                                   }) &&
+        !finished_)
+    {
+        LOG_ERROR << "Failed to decode the streamed response body";
+        finish(ReqResult::BadResponse);
+    }
+}
+
+void StreamClientContext::finish(ReqResult result)
+{
+    if (finished_)
+        return;
+    finished_ = true;
+    if (timerId_ != 0)
+    {
+        loop_->invalidateTimer(timerId_);
+        timerId_ = 0;
+    }
+    if (conn_)
+    {
+        conn_->forceClose();
+        conn_.reset();
+    }
+    else if (client_)
+    {
+        client_->stop();
+    }
+    // The callbacks are released after the last one is called, they may own
+    // what the last one uses.
+    auto headersCallback = std::move(headersCallback_);
+    auto dataCallback = std::move(dataCallback_);
+    auto finishCallback = std::move(finishCallback_);
+    headersCallback_ = nullptr;
+    dataCallback_ = nullptr;
+    finishCallback_ = nullptr;
+    if (finishCallback)
+        finishCallback(result, response_);
+    // The client can't be destroyed in its own callbacks
+    loop_->queueInLoop([self = std::move(self_)]() {});
+    self_.reset();
+}
+
+void StreamClientContext::pause()
+{
+    auto thisPtr = shared_from_this();
+    loop_->runInLoop([thisPtr]() {
+        thisPtr->paused_ = true;
+        if (thisPtr->conn_)
+            thisPtr->conn_->stopRead();
+    });
+}
+
+void StreamClientContext::resume()
+{
+    auto thisPtr = shared_from_this();
+    loop_->runInLoop([thisPtr]() {
+        thisPtr->paused_ = false;
+        if (thisPtr->conn_)
+            thisPtr->conn_->startRead();
+    });
+}
+
+void StreamClientContext::cancel()
+{
+    auto thisPtr = shared_from_this();
+    loop_->runInLoop([thisPtr]() {
+        thisPtr->finishCallback_ = nullptr;
+        thisPtr->finish(ReqResult::NetworkFailure);
+    });
+}
+
+}  // namespace drogon
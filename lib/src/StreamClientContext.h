@@ -0,0 +1,93 @@
+/**
+ *
+ *  @file StreamClientContext.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpResponseImpl.h"
+#include "ProxyResponseParser.h"
+#include "StreamDecompressor.h"
+#include <drogon/HttpClient.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/TcpClient.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <memory>
+
+namespace drogon
+{
+/**
+ * @brief The state of a request sent by HttpClient::sendRequestForStream(),
+ * which receives the response body in pieces on a connection of its own.
+ *
+ * Everything but the methods of HttpBodyStream runs in the event loop of the
+ * client. The context keeps itself alive until the request is finished.
+ */
+class StreamClientContext
+    : public HttpBodyStream,
+      public std::enable_shared_from_this<StreamClientContext>
+{
+  public:
+    StreamClientContext(trantor::EventLoop *loop,
+                        bool headRequest,
+                        HttpStreamHeadersCallback headersCb,
+                        HttpStreamDataCallback dataCb,
+                        HttpReqCallback finishCb);
+
+    /// Keep the context alive until it's finished, and arm the timeout of
+    /// the header
+    void start(double timeout);
+
+    /// Own the client of the connection
+    void setClient(std::shared_ptr<trantor::TcpClient> client)
+    {
+        client_ = std::move(client);
+    }
+
+    void onConnected(const trantor::TcpConnectionPtr &conn);
+
+    void onMessage(trantor::MsgBuffer *buf);
+
+    /// The connection is closed, or failed with the result
+    void onClose(ReqResult result);
+
+    bool finished() const
+    {
+        return finished_;
+    }
+
+    void pause() override;
+    void resume() override;
+    void cancel() override;
+
+  private:
+    void onHead(ProxyResponseParser::Head &&head);
+    void onBody(const char *data, size_t length);
+    void finish(ReqResult result);
+
+    trantor::EventLoop *loop_;
+    HttpStreamHeadersCallback headersCallback_;
+    HttpStreamDataCallback dataCallback_;
+    HttpReqCallback finishCallback_;
+    ProxyResponseParser parser_;
+    std::unique_ptr<StreamDecompressor> decompressor_;
+    HttpResponseImplPtr response_;
+    std::shared_ptr<trantor::TcpClient> client_;
+    trantor::TcpConnectionPtr conn_;
+    std::shared_ptr<StreamClientContext> self_;
+    trantor::TimerId timerId_{0};
+    bool paused_{false};
+    bool finished_{false};
+};
+
+using StreamClientContextPtr = std::shared_ptr<StreamClientContext>;
+
+}  // namespace drogon
@@ -0,0 +1,286 @@
+/**
+ *
+ *  @file StreamCompressor.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "StreamCompressor.h"
+#include <drogon/config.h>
+#include <trantor/utils/Logger.h>
+#ifdef USE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef USE_ZSTD
+#include <drogon/HttpAppFramework.h>
+#include <zstd.h>
+#endif
+#include <zlib.h>
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t kOutputStep = 16384;
+
+class GzipStreamCompressor : public StreamCompressor
+{
+  public:
+    GzipStreamCompressor()
+    {
+        ok_ = deflateInit2(&strm_,
+                           Z_DEFAULT_COMPRESSION,
+                           Z_DEFLATED,
+                           MAX_WBITS + 16,
+                           8,
+                           Z_DEFAULT_STRATEGY) == Z_OK;
+        if (!ok_)
+        {
+            LOG_ERROR << "deflateInit2 error!";
+        }
+    }
+
+    ~GzipStreamCompressor() override
+    {
+        if (ok_)
+            (void)deflateEnd(&strm_);
+    }
+
+    bool compress(const char *data,
+                  size_t length,
+                  bool flush,
+                  std::string &out) override
+    {
+        return deflateData(data,
+                           length,
+                           flush ? Z_SYNC_FLUSH : Z_NO_FLUSH,
+                           out);
+    }
+
+    bool finish(std::string &out) override
+    {
+        return deflateData(nullptr, 0, Z_FINISH, out);
+    }
+
+  private:
+    bool deflateData(const char *data,
+                     size_t length,
+                     int mode,
+                     std::string &out)
+    {
+        if (!ok_)
+            return false;
+        strm_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        strm_.avail_in = static_cast<uInt>(length);
+        do
+        {
+            auto oldSize = out.size();
+            out.resize(oldSize + kOutputStep);
+            strm_.next_out = reinterpret_cast<Bytef *>(&out[oldSize]);
+            strm_.avail_out = static_cast<uInt>(kOutputStep);
+            auto ret = deflate(&strm_, mode);
+            out.resize(out.size() - strm_.avail_out);
+            if (ret == Z_STREAM_ERROR)
+            {
+                ok_ = false;
+                return false;
+            }
+            // With Z_FINISH, deflate() returns Z_STREAM_END once all the
+            // output has been written.
+            if (ret == Z_STREAM_END)
+                break;
+        } while (strm_.avail_out == 0 || strm_.avail_in > 0);
+        return true;
+    }
+
+    z_stream strm_{};
+    bool ok_{false};
+};
+
+#ifdef USE_BROTLI
+class BrotliStreamCompressor : public StreamCompressor
+{
+  public:
+    BrotliStreamCompressor()
+        : state_(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr))
+    {
+        if (state_)
+        {
+            // The same quality as utils::brotliCompress()
+            BrotliEncoderSetParameter(state_, BROTLI_PARAM_QUALITY, 5);
+        }
+        else
+        {
+            LOG_ERROR << "BrotliEncoderCreateInstance error!";
+        }
+    }
+
+    ~BrotliStreamCompressor() override
+    {
+        if (state_)
+            BrotliEncoderDestroyInstance(state_);
+    }
+
+    bool compress(const char *data,
+                  size_t length,
+                  bool flush,
+                  std::string &out) override
+    {
+        return encode(data,
+                      length,
+                      flush ? BROTLI_OPERATION_FLUSH : BROTLI_OPERATION_PROCESS,
+                      out);
+    }
+
+    bool finish(std::string &out) override
+    {
+        return encode(nullptr, 0, BROTLI_OPERATION_FINISH, out);
+    }
+
+  private:
+    bool encode(const char *data,
+                size_t length,
+                BrotliEncoderOperation op,
+                std::string &out)
+    {
+        if (!state_)
+            return false;
+        auto nextIn = reinterpret_cast<const uint8_t *>(data);
+        size_t availableIn = length;
+        while (true)
+        {
+            auto oldSize = out.size();
+            out.resize(oldSize + kOutputStep);
+            auto nextOut = reinterpret_cast<uint8_t *>(&out[oldSize]);
+            size_t availableOut = kOutputStep;
+            if (!BrotliEncoderCompressStream(state_,
+                                             op,
+                                             &availableIn,
+                                             &nextIn,
+                                             &availableOut,
+                                             &nextOut,
+                                             nullptr))
+            {
+                out.resize(oldSize);
+                return false;
+            }
+            out.resize(out.size() - availableOut);
+            if (availableIn == 0 && !BrotliEncoderHasMoreOutput(state_))
+                break;
+        }
+        return true;
+    }
+
+    BrotliEncoderState *state_;
+};
+#endif
+
+#ifdef USE_ZSTD
+class ZstdStreamCompressor : public StreamCompressor
+{
+  public:
+    ZstdStreamCompressor() : cctx_(ZSTD_createCCtx())
+    {
+        if (!cctx_)
+        {
+            LOG_ERROR << "ZSTD_createCCtx error!";
+            return;
+        }
+        ZSTD_CCtx_setParameter(cctx_,
+                               ZSTD_c_compressionLevel,
+                               app().getZstdCompressionLevel());
+        // A stream lives longer than the per thread contexts used by
+        // utils::zstdCompress(), it gets its own copy of the dictionary.
+        auto &dictionary = app().getZstdDictionary();
+        if (!dictionary.empty() &&
+            ZSTD_isError(ZSTD_CCtx_loadDictionary(cctx_,
+                                                  dictionary.data(),
+                                                  dictionary.length())))
+        {
+            LOG_ERROR << "Failed to load the zstd dictionary!";
+            ZSTD_freeCCtx(cctx_);
+            cctx_ = nullptr;
+        }
+    }
+
+    ~ZstdStreamCompressor() override
+    {
+        ZSTD_freeCCtx(cctx_);
+    }
+
+    bool compress(const char *data,
+                  size_t length,
+                  bool flush,
+                  std::string &out) override
+    {
+        return encode(data,
+                      length,
+                      flush ? ZSTD_e_flush : ZSTD_e_continue,
+                      out);
+    }
+
+    bool finish(std::string &out) override
+    {
+        return encode(nullptr, 0, ZSTD_e_end, out);
+    }
+
+  private:
+    bool encode(const char *data,
+                size_t length,
+                ZSTD_EndDirective mode,
+                std::string &out)
+    {
+        if (!cctx_)
+            return false;
+        ZSTD_inBuffer input{data, length, 0};
+        while (true)
+        {
+            auto oldSize = out.size();
+            out.resize(oldSize + kOutputStep);
+            ZSTD_outBuffer output{&out[oldSize], kOutputStep, 0};
+            auto remaining = ZSTD_compressStream2(cctx_, &output, &input, mode);
+            out.resize(oldSize + output.pos);
+            if (ZSTD_isError(remaining))
+            {
+                LOG_ERROR << "zstd error: " << ZSTD_getErrorName(remaining);
+                return false;
+            }
+            // With ZSTD_e_continue, the input is consumed when it returns.
+            // Otherwise it returns the number of bytes left to flush.
+            if (mode == ZSTD_e_continue ? input.pos == input.size
+                                        : remaining == 0)
+                break;
+        }
+        return true;
+    }
+
+    ZSTD_CCtx *cctx_;
+};
+#endif
+}  // namespace
+
+std::unique_ptr<StreamCompressor> StreamCompressor::newCompressor(
+    ContentEncoding encoding)
+{
+    switch (encoding)
+    {
+        case ContentEncoding::kGzip:
+            return std::make_unique<GzipStreamCompressor>();
+#ifdef USE_BROTLI
+        case ContentEncoding::kBrotli:
+            return std::make_unique<BrotliStreamCompressor>();
+#endif
+#ifdef USE_ZSTD
+        case ContentEncoding::kZstd:
+            return std::make_unique<ZstdStreamCompressor>();
+#endif
+        default:
+            return nullptr;
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ *
+ *  @file StreamCompressor.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpUtils.h"
+#include <drogon/exports.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief An incremental encoder used to compress streamed response bodies,
+ * which are never held in memory as a whole.
+ */
+class DROGON_EXPORT StreamCompressor
+{
+  public:
+    /**
+     * @brief Create a compressor for the encoding.
+     *
+     * @return nullptr if the encoding is not supported by this build.
+     */
+    static std::unique_ptr<StreamCompressor> newCompressor(
+        ContentEncoding encoding);
+
+    virtual ~StreamCompressor() = default;
+
+    /**
+     * @brief Compress the data and append the output to out.
+     *
+     * @param flush If true, the output is flushed so that everything passed
+     * so far can be decoded by the client. Flushing costs a few bytes and
+     * some compression ratio, it is used for pushed streams (async streams,
+     * SSE) whose chunks must arrive without delay.
+     *
+     * @return false on error.
+     */
+    virtual bool compress(const char *data,
+                          size_t length,
+                          bool flush,
+                          std::string &out) = 0;
+
+    /**
+     * @brief End the compressed stream and append the last bytes to out.
+     */
+    virtual bool finish(std::string &out) = 0;
+};
+}  // namespace drogon
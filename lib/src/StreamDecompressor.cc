@@ -0,0 +1,232 @@
+/**
+ *
+ *  @file StreamDecompressor.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "StreamDecompressor.h"
+#include <drogon/config.h>
+#include <trantor/utils/Logger.h>
+#ifdef USE_BROTLI
+#include <brotli/decode.h>
+#endif
+#ifdef USE_ZSTD
+#include <drogon/HttpAppFramework.h>
+#include <zstd.h>
+#endif
+#include <zlib.h>
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t kOutputStep = 16384;
+
+class GzipStreamDecompressor : public StreamDecompressor
+{
+  public:
+    GzipStreamDecompressor()
+    {
+        // Detect the gzip or zlib header
+        ok_ = inflateInit2(&strm_, MAX_WBITS + 32) == Z_OK;
+        if (!ok_)
+        {
+            LOG_ERROR << "inflateInit2 error!";
+        }
+    }
+
+    ~GzipStreamDecompressor() override
+    {
+        if (ok_)
+            (void)inflateEnd(&strm_);
+    }
+
+    bool decompress(const char *data, size_t length, const Sink &sink) override
+    {
+        if (!ok_)
+            return false;
+        if (finished_)
+            return length == 0;
+        char out[kOutputStep];
+        strm_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        strm_.avail_in = static_cast<uInt>(length);
+        // A full output buffer may leave more output without more input.
+        do
+        {
+            strm_.next_out = reinterpret_cast<Bytef *>(out);
+            strm_.avail_out = sizeof(out);
+            auto ret = inflate(&strm_, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+                return false;
+            auto produced = sizeof(out) - strm_.avail_out;
+            if (produced > 0 && !sink(out, produced))
+                return false;
+            if (ret == Z_STREAM_END)
+            {
+                finished_ = true;
+                break;
+            }
+            if (ret == Z_BUF_ERROR)
+                break;
+        } while (strm_.avail_in > 0 || strm_.avail_out == 0);
+        // Data after the end of the stream is an error.
+        return strm_.avail_in == 0;
+    }
+
+    bool finished() const override
+    {
+        return finished_;
+    }
+
+  private:
+    z_stream strm_{};
+    bool ok_{false};
+    bool finished_{false};
+};
+
+#ifdef USE_BROTLI
+class BrotliStreamDecompressor : public StreamDecompressor
+{
+  public:
+    BrotliStreamDecompressor()
+        : state_(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr))
+    {
+        if (!state_)
+        {
+            LOG_ERROR << "BrotliDecoderCreateInstance error!";
+        }
+    }
+
+    ~BrotliStreamDecompressor() override
+    {
+        if (state_)
+            BrotliDecoderDestroyInstance(state_);
+    }
+
+    bool decompress(const char *data, size_t length, const Sink &sink) override
+    {
+        if (!state_)
+            return false;
+        if (finished_)
+            return length == 0;
+        uint8_t out[kOutputStep];
+        auto nextIn = reinterpret_cast<const uint8_t *>(data);
+        size_t availIn = length;
+        while (true)
+        {
+            auto nextOut = out;
+            size_t availOut = sizeof(out);
+            auto ret = BrotliDecoderDecompressStream(
+                state_, &availIn, &nextIn, &availOut, &nextOut, nullptr);
+            if (ret == BROTLI_DECODER_RESULT_ERROR)
+                return false;
+            auto produced = sizeof(out) - availOut;
+            if (produced > 0 &&
+                !sink(reinterpret_cast<const char *>(out), produced))
+                return false;
+            if (ret == BROTLI_DECODER_RESULT_SUCCESS)
+            {
+                finished_ = true;
+                return availIn == 0;
+            }
+            if (ret == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT)
+                return true;
+        }
+    }
+
+    bool finished() const override
+    {
+        return finished_;
+    }
+
+  private:
+    BrotliDecoderState *state_;
+    bool finished_{false};
+};
+#endif
+
+#ifdef USE_ZSTD
+class ZstdStreamDecompressor : public StreamDecompressor
+{
+  public:
+    ZstdStreamDecompressor() : dctx_(ZSTD_createDCtx())
+    {
+        if (!dctx_)
+        {
+            LOG_ERROR << "ZSTD_createDCtx error!";
+            return;
+        }
+        auto &dictionary = app().getZstdDictionary();
+        if (!dictionary.empty() &&
+            ZSTD_isError(ZSTD_DCtx_loadDictionary(dctx_,
+                                                  dictionary.data(),
+                                                  dictionary.size())))
+        {
+            LOG_ERROR << "ZSTD_DCtx_loadDictionary error!";
+            ZSTD_freeDCtx(dctx_);
+            dctx_ = nullptr;
+        }
+    }
+
+    ~ZstdStreamDecompressor() override
+    {
+        if (dctx_)
+            ZSTD_freeDCtx(dctx_);
+    }
+
+    bool decompress(const char *data, size_t length, const Sink &sink) override
+    {
+        if (!dctx_)
+            return false;
+        char out[kOutputStep];
+        ZSTD_inBuffer input{data, length, 0};
+        while (true)
+        {
+            ZSTD_outBuffer output{out, sizeof(out), 0};
+            auto ret = ZSTD_decompressStream(dctx_, &output, &input);
+            if (ZSTD_isError(ret))
+                return false;
+            // A frame is complete when it returns 0, the body may hold more
+            // frames.
+            finished_ = ret == 0;
+            if (output.pos > 0 && !sink(out, output.pos))
+                return false;
+            if (input.pos == input.size && output.pos < output.size)
+                return true;
+        }
+    }
+
+    bool finished() const override
+    {
+        return finished_;
+    }
+
+  private:
+    ZSTD_DCtx *dctx_;
+    bool finished_{false};
+};
+#endif
+}  // namespace
+
+std::unique_ptr<StreamDecompressor> StreamDecompressor::newDecompressor(
+    std::string_view contentEncoding)
+{
+    if (contentEncoding == "gzip" || contentEncoding == "deflate")
+        return std::make_unique<GzipStreamDecompressor>();
+#ifdef USE_BROTLI
+    if (contentEncoding == "br")
+        return std::make_unique<BrotliStreamDecompressor>();
+#endif
+#ifdef USE_ZSTD
+    if (contentEncoding == "zstd")
+        return std::make_unique<ZstdStreamDecompressor>();
+#endif
+    return nullptr;
+}
@@ -0,0 +1,57 @@
+/**
+ *
+ *  @file StreamDecompressor.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+namespace drogon
+{
+/**
+ * @brief An incremental decoder of the content codings of streamed request
+ * bodies, which are never held in memory as a whole.
+ */
+class DROGON_EXPORT StreamDecompressor
+{
+  public:
+    /// Receive a piece of output, return false to stop decompressing.
+    using Sink = std::function<bool(const char *data, size_t length)>;
+
+    /**
+     * @brief Create a decompressor for a Content-Encoding header value, gzip,
+     * deflate, br or zstd.
+     *
+     * @return nullptr if the encoding is not supported by this build.
+     */
+    static std::unique_ptr<StreamDecompressor> newDecompressor(
+        std::string_view contentEncoding);
+
+    virtual ~StreamDecompressor() = default;
+
+    /**
+     * @brief Decompress the data, passing the output to the sink in pieces of
+     * bounded size, so a small input can't inflate to a large buffer.
+     *
+     * @return false on error or when the sink stops.
+     */
+    virtual bool decompress(const char *data,
+                            size_t length,
+                            const Sink &sink) = 0;
+
+    /// Return true once the end of the compressed data has been decoded.
+    virtual bool finished() const = 0;
+};
+}  // namespace drogon
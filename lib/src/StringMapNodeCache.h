@@ -0,0 +1,119 @@
+/**
+ *
+ *  @file StringMapNodeCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/Utilities.h>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The nodes of the cleared string maps of a pooled object.
+ *
+ * A pooled request moves the nodes of its header, cookie and parameter maps
+ * here when it is reset, with the capacity of their strings. The next
+ * requests served with the object insert their entries in these nodes, so
+ * filling the maps doesn't allocate unless an entry is longer than the one
+ * the node held before.
+ */
+class StringMapNodeCache
+{
+  public:
+    using Map = SafeStringMap<std::string>;
+
+    static constexpr size_t maxNodes()
+    {
+        return 128;
+    }
+
+    /// Move the nodes of the map into the cache, and clear the map. The nodes
+    /// holding long strings are freed.
+    void recycle(Map &map)
+    {
+        for (auto iter = map.begin();
+             iter != map.end() && nodes_.size() < maxNodes();)
+        {
+            auto next = std::next(iter);
+            if (iter->first.capacity() + iter->second.capacity() <= 1024)
+                nodes_.push_back(map.extract(iter));
+            iter = next;
+        }
+        map.clear();
+    }
+
+    /// Insert the entry if the key is not in the map, like Map::emplace()
+    void emplace(Map &map,
+                 std::string_view key,
+                 std::string_view value,
+                 bool lowerCaseKey = false)
+    {
+        insert(map, key, value, false, lowerCaseKey);
+    }
+
+    /// Insert the entry or assign its value, like map[key] = value
+    void assign(Map &map, std::string_view key, std::string_view value)
+    {
+        insert(map, key, value, true, false);
+    }
+
+    size_t size() const
+    {
+        return nodes_.size();
+    }
+
+  private:
+    static void toLower(std::string &str)
+    {
+        for (auto &c : str)
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+
+    void insert(Map &map,
+                std::string_view key,
+                std::string_view value,
+                bool overwrite,
+                bool lowerCaseKey)
+    {
+        if (nodes_.empty())
+        {
+            std::string k(key);
+            if (lowerCaseKey)
+                toLower(k);
+            auto result = map.try_emplace(std::move(k));
+            if (result.second || overwrite)
+                result.first->second.assign(value.data(), value.size());
+            return;
+        }
+        auto node = std::move(nodes_.back());
+        nodes_.pop_back();
+        node.key().assign(key.data(), key.size());
+        if (lowerCaseKey)
+            toLower(node.key());
+        node.mapped().assign(value.data(), value.size());
+        auto result = map.insert(std::move(node));
+        if (!result.inserted)
+        {
+            // Keep the node, and its buffers, for the next entry
+            if (overwrite)
+                result.position->second.swap(result.node.mapped());
+            nodes_.push_back(std::move(result.node));
+        }
+    }
+
+    std::vector<Map::node_type> nodes_;
+};
+}  // namespace drogon
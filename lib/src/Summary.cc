@@ -0,0 +1,242 @@
+#include <drogon/utils/monitoring/Summary.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+using namespace drogon;
+using namespace drogon::monitoring;
+
+// The values below are too close to 0 to have a bucket
+static constexpr double kMinIndexableValue = 1e-9;
+
+DDSketch::DDSketch(double relativeAccuracy, size_t maxBuckets) noexcept(false)
+    : relativeAccuracy_(relativeAccuracy),
+      gamma_((1 + relativeAccuracy) / (1 - relativeAccuracy)),
+      logGamma_(std::log(gamma_)),
+      maxBuckets_(maxBuckets)
+{
+    if (relativeAccuracy <= 0 || relativeAccuracy >= 1)
+    {
+        throw std::runtime_error("The relative accuracy must be in (0, 1)");
+    }
+    if (maxBuckets == 0)
+    {
+        throw std::runtime_error("maxBuckets must be greater than 0");
+    }
+}
+
+int32_t DDSketch::indexOf(double value) const
+{
+    return static_cast<int32_t>(std::ceil(std::log(value) / logGamma_));
+}
+
+double DDSketch::valueOf(int32_t index) const
+{
+    // The value in the bucket with the least relative error to both bounds
+    return 2 * std::pow(gamma_, index) / (gamma_ + 1);
+}
+
+void DDSketch::add(double value, uint64_t count)
+{
+    if (count == 0 || !std::isfinite(value))
+        return;
+    if (count_ == 0)
+    {
+        min_ = value;
+        max_ = value;
+    }
+    else
+    {
+        min_ = (std::min)(min_, value);
+        max_ = (std::max)(max_, value);
+    }
+    count_ += count;
+    sum_ += value * static_cast<double>(count);
+    if (value <= kMinIndexableValue)
+    {
+        zeroCount_ += count;
+        return;
+    }
+    addToBuckets(indexOf(value), count);
+}
+
+void DDSketch::addToBuckets(int32_t index, uint64_t count)
+{
+    if (buckets_.empty())
+    {
+        buckets_.push_back(0);
+        minIndex_ = index;
+    }
+    if (index < minIndex_)
+    {
+        size_t growth = static_cast<size_t>(minIndex_ - index);
+        if (buckets_.size() + growth > maxBuckets_)
+        {
+            // Collapsed into the lowest bucket
+            growth = maxBuckets_ - buckets_.size();
+            buckets_.insert(buckets_.begin(), growth, 0);
+            minIndex_ -= static_cast<int32_t>(growth);
+            buckets_.front() += count;
+            return;
+        }
+        buckets_.insert(buckets_.begin(), growth, 0);
+        minIndex_ = index;
+    }
+    else if (static_cast<size_t>(index - minIndex_) >= buckets_.size())
+    {
+        buckets_.resize(static_cast<size_t>(index - minIndex_) + 1, 0);
+        if (buckets_.size() > maxBuckets_)
+        {
+            // Collapse the lowest buckets to keep the high quantiles
+            auto excess = buckets_.size() - maxBuckets_;
+            uint64_t collapsed{0};
+            for (size_t i = 0; i < excess; ++i)
+            {
+                collapsed += buckets_[i];
+            }
+            buckets_.erase(buckets_.begin(),
+                           buckets_.begin() + static_cast<ptrdiff_t>(excess));
+            buckets_.front() += collapsed;
+            minIndex_ += static_cast<int32_t>(excess);
+        }
+    }
+    buckets_[static_cast<size_t>(index - minIndex_)] += count;
+}
+
+void DDSketch::merge(const DDSketch &other) noexcept(false)
+{
+    if (other.relativeAccuracy_ != relativeAccuracy_)
+    {
+        throw std::runtime_error(
+            "Can't merge sketches of different relative accuracies");
+    }
+    if (other.count_ == 0)
+        return;
+    if (count_ == 0)
+    {
+        min_ = other.min_;
+        max_ = other.max_;
+    }
+    else
+    {
+        min_ = (std::min)(min_, other.min_);
+        max_ = (std::max)(max_, other.max_);
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    zeroCount_ += other.zeroCount_;
+    // Add the highest buckets first so that a collapse happens once at most
+    for (size_t i = other.buckets_.size(); i > 0; --i)
+    {
+        if (other.buckets_[i - 1] > 0)
+        {
+            addToBuckets(other.minIndex_ + static_cast<int32_t>(i - 1),
+                         other.buckets_[i - 1]);
+        }
+    }
+}
+
+double DDSketch::quantile(double q) const
+{
+    if (count_ == 0)
+        return 0;
+    if (q <= 0)
+        return min_;
+    if (q >= 1)
+        return max_;
+    auto rank = static_cast<uint64_t>(q * static_cast<double>(count_ - 1));
+    if (rank < zeroCount_)
+        return (std::max)(min_, 0.0);
+    uint64_t seen{zeroCount_};
+    for (size_t i = 0; i < buckets_.size(); ++i)
+    {
+        seen += buckets_[i];
+        if (seen > rank)
+        {
+            auto value = valueOf(minIndex_ + static_cast<int32_t>(i));
+            return (std::min)((std::max)(value, min_), max_);
+        }
+    }
+    return max_;
+}
+
+void DDSketch::clear()
+{
+    buckets_.clear();
+    minIndex_ = 0;
+    zeroCount_ = 0;
+    count_ = 0;
+    sum_ = 0;
+    min_ = 0;
+    max_ = 0;
+}
+
+Summary::Summary(const std::string &name,
+                 const std::vector<std::string> &labelNames,
+                 const std::vector<std::string> &labelValues,
+                 const std::vector<double> &quantiles,
+                 double relativeAccuracy,
+                 size_t maxBuckets) noexcept(false)
+    : Metric(name, labelNames, labelValues),
+      quantiles_(quantiles),
+      relativeAccuracy_(relativeAccuracy),
+      maxBuckets_(maxBuckets)
+{
+    for (auto q : quantiles)
+    {
+        if (q < 0 || q > 1)
+        {
+            throw std::runtime_error("The quantiles must be in [0, 1]");
+        }
+    }
+    for (auto &shard : shards_)
+    {
+        shard.sketch = DDSketch(relativeAccuracy, maxBuckets);
+    }
+}
+
+void Summary::observe(double value)
+{
+    auto &shard = shards_[internal::shardOfThisThread()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sketch.add(value);
+}
+
+DDSketch Summary::sketch() const
+{
+    DDSketch result(relativeAccuracy_, maxBuckets_);
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result.merge(shard.sketch);
+    }
+    return result;
+}
+
+std::vector<Sample> Summary::collect() const
+{
+    auto merged = sketch();
+    std::vector<Sample> samples;
+    for (auto q : quantiles_)
+    {
+        Sample sample;
+        sample.name = name_;
+        auto label = std::to_string(q);
+        // Remove the trailing zeros, 0.500000 -> 0.5
+        label.erase(label.find_last_not_of('0') + 1);
+        if (label.back() == '.')
+            label.pop_back();
+        sample.exLabels.emplace_back("quantile", std::move(label));
+        sample.value = merged.quantile(q);
+        samples.emplace_back(std::move(sample));
+    }
+    Sample sumSample;
+    sumSample.name = name_ + "_sum";
+    sumSample.value = merged.sum();
+    samples.emplace_back(std::move(sumSample));
+    Sample countSample;
+    countSample.name = name_ + "_count";
+    countSample.value = static_cast<double>(merged.count());
+    samples.emplace_back(std::move(countSample));
+    return samples;
+}
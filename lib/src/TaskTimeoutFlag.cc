@@ -24,18 +24,36 @@ TaskTimeoutFlag::TaskTimeoutFlag(trantor::EventLoop *loop,
 
 void TaskTimeoutFlag::runTimer()
 {
-    std::weak_ptr<TaskTimeoutFlag> weakPtr = shared_from_this();
-    loop_->runAfter(timeout_, [weakPtr]() {
-        auto thisPtr = weakPtr.lock();
-        if (!thisPtr)
-            return;
-        if (thisPtr->done())
-            return;
-        thisPtr->timeoutFunc_();
+    if (loop_->isInLoopThread())
+    {
+        schedule();
+        return;
+    }
+    loop_->queueInLoop([thisPtr = shared_from_this()]() {
+        thisPtr->schedule();
     });
 }
 
+void TaskTimeoutFlag::schedule()
+{
+    self_ = shared_from_this();
+    TimeoutWheel::instance(loop_).schedule(this, timeout_.count());
+}
+
+void TaskTimeoutFlag::onTimeout()
+{
+    auto thisPtr = std::move(self_);
+    if (isDone_.exchange(true))
+        return;
+    timeoutFunc_();
+}
+
 bool TaskTimeoutFlag::done()
 {
-    return isDone_.exchange(true);
+    if (isDone_.exchange(true))
+        return true;
+    // The timeout can't run anymore, what its callback holds is released
+    // without waiting for the deadline
+    timeoutFunc_ = nullptr;
+    return false;
 }
@@ -15,6 +15,7 @@
 
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoop.h>
+#include "TimeoutWheel.h"
 #include <chrono>
 #include <functional>
 #include <atomic>
@@ -23,7 +24,8 @@
 namespace drogon
 {
 class TaskTimeoutFlag : public trantor::NonCopyable,
-                        public std::enable_shared_from_this<TaskTimeoutFlag>
+                        public std::enable_shared_from_this<TaskTimeoutFlag>,
+                        private TimeoutEntry
 {
   public:
     TaskTimeoutFlag(trantor::EventLoop *loop,
@@ -33,9 +35,14 @@ class TaskTimeoutFlag : public trantor::NonCopyable,
     void runTimer();
 
   private:
+    void schedule();
+    void onTimeout() override;
+
     std::atomic<bool> isDone_{false};
     trantor::EventLoop *loop_;
     std::chrono::duration<double> timeout_;
     std::function<void()> timeoutFunc_;
+    // Kept by the timeout wheel of the loop until the deadline
+    std::shared_ptr<TaskTimeoutFlag> self_;
 };
 }  // namespace drogon
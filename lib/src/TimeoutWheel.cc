@@ -0,0 +1,159 @@
+/**
+ *
+ *  @file TimeoutWheel.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "TimeoutWheel.h"
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+using namespace drogon;
+
+namespace
+{
+thread_local std::unique_ptr<TimeoutWheel> loopWheel;
+}  // namespace
+
+void TimeoutEntry::cancel()
+{
+    if (!wheel_)
+        return;
+    prev_->next_ = next_;
+    next_->prev_ = prev_;
+    prev_ = next_ = nullptr;
+    --wheel_->size_;
+    wheel_ = nullptr;
+}
+
+TimeoutWheel &TimeoutWheel::instance(trantor::EventLoop *loop)
+{
+    assert(loop->isInLoopThread());
+    if (!loopWheel)
+        loopWheel.reset(new TimeoutWheel(loop));
+    assert(loopWheel->loop_ == loop);
+    return *loopWheel;
+}
+
+TimeoutWheel::TimeoutWheel(trantor::EventLoop *loop)
+    : loop_(loop), start_(std::chrono::steady_clock::now())
+{
+}
+
+TimeoutWheel::~TimeoutWheel()
+{
+    // Destroyed with the thread, after its loop, the entries left are only
+    // unlinked
+    for (auto &slot : slots_)
+    {
+        while (slot.next_ != &slot)
+            slot.next_->cancel();
+    }
+}
+
+uint64_t TimeoutWheel::elapsed() const
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      start_)
+            .count() /
+        kTick);
+}
+
+void TimeoutWheel::schedule(TimeoutEntry *entry, double delay)
+{
+    assert(loop_->isInLoopThread());
+    entry->cancel();
+    start();
+    entry->deadline_ = deadlineOf(delay);
+    entry->wheel_ = this;
+    ++size_;
+    link(entry);
+}
+
+void TimeoutWheel::scheduleBefore(TimeoutEntry *entry, double delay)
+{
+    assert(loop_->isInLoopThread());
+    if (entry->wheel_ == this && entry->deadline_ <= deadlineOf(delay))
+        return;
+    schedule(entry, delay);
+}
+
+void TimeoutWheel::start()
+{
+    if (timerId_ != trantor::InvalidTimerId)
+        return;
+    // The wheel was empty, no slot is behind the clock
+    now_ = elapsed();
+    timerId_ = loop_->runEvery(kTick, [this]() { turn(); });
+}
+
+uint64_t TimeoutWheel::deadlineOf(double delay) const
+{
+    // Rounded up to the end of a slot, so an entry never times out early
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_)
+                       .count() +
+                   (std::max)(delay, 0.0);
+    return (std::max)(static_cast<uint64_t>(std::ceil(seconds / kTick)),
+                      now_ + 1);
+}
+
+void TimeoutWheel::link(TimeoutEntry *entry)
+{
+    auto &slot = slots_[entry->deadline_ % kSlots];
+    entry->prev_ = slot.prev_;
+    entry->next_ = &slot;
+    slot.prev_->next_ = entry;
+    slot.prev_ = entry;
+}
+
+void TimeoutWheel::turn()
+{
+    auto last = now_;
+    // The timer runs late when the loop is busy, the slots behind the clock
+    // are turned at once
+    now_ = (std::max)(elapsed(), last);
+    auto end = (std::min)(now_, last + kSlots);
+    for (auto tick = last + 1; tick <= end; ++tick)
+    {
+        // The entries of the later turns go back to the slot, the others are
+        // moved out first, as their callbacks may schedule or cancel any
+        // entry
+        auto &slot = slots_[tick % kSlots];
+        if (slot.next_ == &slot)
+            continue;
+        Slot expired;
+        expired.next_ = slot.next_;
+        expired.prev_ = slot.prev_;
+        expired.next_->prev_ = &expired;
+        expired.prev_->next_ = &expired;
+        slot.next_ = slot.prev_ = &slot;
+        while (expired.next_ != &expired)
+        {
+            auto entry = expired.next_;
+            if (entry->deadline_ > now_)
+            {
+                expired.next_ = entry->next_;
+                entry->next_->prev_ = &expired;
+                link(entry);
+                continue;
+            }
+            entry->cancel();
+            entry->onTimeout();
+        }
+    }
+    if (size_ == 0)
+    {
+        loop_->invalidateTimer(timerId_);
+        timerId_ = trantor::InvalidTimerId;
+    }
+}
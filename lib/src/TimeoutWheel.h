@@ -0,0 +1,137 @@
+/**
+ *
+ *  @file TimeoutWheel.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace drogon
+{
+class TimeoutWheel;
+
+/**
+ * @brief A node of the timeout wheel of a loop, embedded in the objects that
+ * time out. Scheduling or cancelling it moves a few pointers, it neither
+ * allocates nor creates a timer.
+ *
+ * An entry is only used in the thread of the loop it is scheduled in, and is
+ * cancelled before it is destroyed.
+ */
+class TimeoutEntry
+{
+  public:
+    TimeoutEntry() = default;
+    TimeoutEntry(const TimeoutEntry &) = delete;
+    TimeoutEntry &operator=(const TimeoutEntry &) = delete;
+
+    virtual ~TimeoutEntry()
+    {
+        cancel();
+    }
+
+    bool scheduled() const
+    {
+        return wheel_ != nullptr;
+    }
+
+    void cancel();
+
+  private:
+    friend class TimeoutWheel;
+
+    /// Called in the loop once the deadline is passed, the entry is no
+    /// longer scheduled and may be scheduled again.
+    virtual void onTimeout() = 0;
+
+    TimeoutEntry *prev_{nullptr};
+    TimeoutEntry *next_{nullptr};
+    TimeoutWheel *wheel_{nullptr};
+    uint64_t deadline_{0};
+};
+
+/**
+ * @brief The timeouts of an IO loop: the idle connections, the deadlines of
+ * TaskTimeoutFlag and the WebSocket pings, kept in a hashed wheel of 100ms
+ * slots.
+ *
+ * A single timer of the loop turns the wheel while an entry is scheduled. The
+ * entries time out within one slot after their deadline, never before it.
+ */
+class TimeoutWheel
+{
+  public:
+    /// The duration of a slot
+    static constexpr double kTick = 0.1;
+
+    /// The wheel of the loop of the current thread, created on the first call
+    static TimeoutWheel &instance(trantor::EventLoop *loop);
+
+    ~TimeoutWheel();
+
+    /// Schedule the entry to time out after the delay, rescheduling it if it
+    /// is already scheduled
+    void schedule(TimeoutEntry *entry, double delay);
+
+    /// Schedule the entry to time out after the delay unless it is scheduled
+    /// to time out before
+    void scheduleBefore(TimeoutEntry *entry, double delay);
+
+    /// The slots turned since the wheel was created, read without the clock
+    uint64_t now() const
+    {
+        return now_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    explicit TimeoutWheel(trantor::EventLoop *loop);
+
+    // The heads of the circular lists of the slots
+    struct Slot final : TimeoutEntry
+    {
+        Slot()
+        {
+            prev_ = next_ = this;
+        }
+
+        void onTimeout() override
+        {
+        }
+    };
+
+    friend class TimeoutEntry;
+    static constexpr size_t kSlots = 512;
+
+    uint64_t elapsed() const;
+    void start();
+    uint64_t deadlineOf(double delay) const;
+    void link(TimeoutEntry *entry);
+    void turn();
+
+    trantor::EventLoop *loop_;
+    std::chrono::steady_clock::time_point start_;
+    std::array<Slot, kSlots> slots_;
+    uint64_t now_{0};
+    size_t size_{0};
+    trantor::TimerId timerId_{trantor::InvalidTimerId};
+};
+}  // namespace drogon
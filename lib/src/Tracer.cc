@@ -0,0 +1,184 @@
+/**
+ *
+ *  @file Tracer.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/plugins/Tracer.h>
+#include <drogon/HttpAppFramework.h>
+#include "Tracing.h"
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+namespace
+{
+std::string toHex(uint64_t value)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i, value >>= 4)
+        hex[i] = digits[value & 0xf];
+    return hex;
+}
+
+Json::Value stringAttribute(const std::string &key, const std::string &value)
+{
+    Json::Value attribute;
+    attribute["key"] = key;
+    attribute["value"]["stringValue"] = value;
+    return attribute;
+}
+}  // namespace
+
+Tracer::Tracer() = default;
+
+Tracer::~Tracer() = default;
+
+void Tracer::initAndStart(const Json::Value &config)
+{
+    auto endpoint = config.get("endpoint", "http://127.0.0.1:4318").asString();
+    path_ = config.get("path", path_).asString();
+    serviceName_ = config.get("service_name", serviceName_).asString();
+    auto &headers = config["headers"];
+    for (auto &name : headers.getMemberNames())
+        headers_[name] = headers[name].asString();
+    batchSize_ = (std::max)(config.get("batch_size", 512).asUInt64(),
+                            Json::UInt64(1));
+    maxQueueSize_ = config.get("max_queue_size", 4096).asUInt64();
+    auto interval = config.get("export_interval", 5.0).asDouble();
+
+    TracingOptions options;
+    options.sampleRatio = config.get("sample_ratio", 1.0).asDouble();
+    options.tailSampling = config.get("tail_sampling", false).asBool();
+    options.tailLatency = config.get("tail_latency", 0.0).asDouble();
+    options.keepErrors = config.get("keep_errors", true).asBool();
+
+    auto loop = app().getLoop();
+    client_ = HttpClient::newHttpClient(endpoint, loop);
+    std::weak_ptr<Tracer> weakPtr = shared_from_this();
+    Tracing::instance().enable(options,
+                               [weakPtr](std::vector<SpanData> &&spans) {
+                                   if (auto thisPtr = weakPtr.lock())
+                                       thisPtr->enqueue(std::move(spans));
+                               });
+    timerId_ = loop->runEvery(interval > 0 ? interval : 5.0, [weakPtr]() {
+        if (auto thisPtr = weakPtr.lock())
+            thisPtr->flush();
+    });
+}
+
+void Tracer::shutdown()
+{
+    app().getLoop()->invalidateTimer(timerId_);
+    flush();
+}
+
+void Tracer::enqueue(std::vector<SpanData> &&spans)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() + spans.size() > maxQueueSize_)
+    {
+        dropped_ += spans.size();
+        return;
+    }
+    for (auto &span : spans)
+        queue_.push_back(std::move(span));
+    if (queue_.size() >= batchSize_ && !flushQueued_)
+    {
+        flushQueued_ = true;
+        std::weak_ptr<Tracer> weakPtr = shared_from_this();
+        app().getLoop()->queueInLoop([weakPtr]() {
+            if (auto thisPtr = weakPtr.lock())
+                thisPtr->flush();
+        });
+    }
+}
+
+void Tracer::flush()
+{
+    std::vector<SpanData> spans;
+    size_t dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spans.swap(queue_);
+        flushQueued_ = false;
+        dropped = dropped_;
+        dropped_ = 0;
+    }
+    if (dropped > 0)
+        LOG_WARN << "Tracer: " << dropped
+                 << " spans are dropped, the export queue is full";
+    for (size_t begin = 0; begin < spans.size(); begin += batchSize_)
+    {
+        auto end = (std::min)(begin + batchSize_, spans.size());
+        std::vector<SpanData> batch(
+            std::make_move_iterator(spans.begin() + begin),
+            std::make_move_iterator(spans.begin() + end));
+        auto req = HttpRequest::newHttpRequest();
+        req->setMethod(Post);
+        req->setPath(path_);
+        req->setContentTypeCode(CT_APPLICATION_JSON);
+        for (auto &[name, value] : headers_)
+            req->addHeader(name, value);
+        req->setBody(toOtlpJson(batch));
+        auto count = batch.size();
+        client_->sendRequest(
+            req,
+            [count](ReqResult result, const HttpResponsePtr &resp) {
+                if (result != ReqResult::Ok)
+                    LOG_ERROR << "Tracer: failed to export " << count
+                              << " spans: " << to_string(result);
+                else if (resp->statusCode() >= 300)
+                    LOG_ERROR << "Tracer: the collector refused " << count
+                              << " spans with status " << resp->statusCode();
+            },
+            10);
+    }
+}
+
+std::string Tracer::toOtlpJson(const std::vector<SpanData> &spans) const
+{
+    Json::Value jsonSpans(Json::arrayValue);
+    for (auto &span : spans)
+    {
+        Json::Value jsonSpan;
+        jsonSpan["traceId"] = span.context.traceIdHex();
+        jsonSpan["spanId"] = toHex(span.context.spanId);
+        if (span.parentSpanId != 0)
+            jsonSpan["parentSpanId"] = toHex(span.parentSpanId);
+        jsonSpan["name"] = span.name;
+        jsonSpan["kind"] = static_cast<int>(span.kind);
+        // The 64 bits integers are strings in the JSON encoding of OTLP
+        jsonSpan["startTimeUnixNano"] = std::to_string(span.startTime);
+        jsonSpan["endTimeUnixNano"] = std::to_string(span.endTime);
+        auto &attributes = jsonSpan["attributes"];
+        attributes = Json::Value(Json::arrayValue);
+        for (auto &[key, value] : span.attributes)
+            attributes.append(stringAttribute(key, value));
+        // STATUS_CODE_ERROR, the others are left unset
+        if (span.error)
+            jsonSpan["status"]["code"] = 2;
+        jsonSpans.append(std::move(jsonSpan));
+    }
+    Json::Value root;
+    auto &resourceSpans = root["resourceSpans"][0];
+    resourceSpans["resource"]["attributes"].append(
+        stringAttribute("service.name", serviceName_));
+    auto &scopeSpans = resourceSpans["scopeSpans"][0];
+    scopeSpans["scope"]["name"] = "drogon";
+    scopeSpans["spans"] = std::move(jsonSpans);
+    static Json::StreamWriterBuilder builder = []() {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        return builder;
+    }();
+    return Json::writeString(builder, root);
+}
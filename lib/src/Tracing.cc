@@ -0,0 +1,256 @@
+/**
+ *
+ *  @file Tracing.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Tracing.h"
+#include "HttpRequestImpl.h"
+#include <drogon/HttpResponse.h>
+#include <chrono>
+#include <random>
+
+using namespace drogon;
+
+namespace
+{
+char hexDigit(unsigned value)
+{
+    return "0123456789abcdef"[value & 0xf];
+}
+
+void appendHex(std::string &out, uint64_t value)
+{
+    for (int shift = 60; shift >= 0; shift -= 4)
+        out.push_back(hexDigit(static_cast<unsigned>(value >> shift)));
+}
+
+bool parseHex(std::string_view text, uint64_t &value)
+{
+    value = 0;
+    for (auto c : text)
+    {
+        value <<= 4;
+        if (c >= '0' && c <= '9')
+            value |= static_cast<uint64_t>(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            value |= static_cast<uint64_t>(c - 'a' + 10);
+        else
+            return false;
+    }
+    return true;
+}
+
+std::mt19937_64 &randomEngine()
+{
+    thread_local std::mt19937_64 engine{std::random_device{}()};
+    return engine;
+}
+}  // namespace
+
+std::string TraceContext::traceparent() const
+{
+    std::string value;
+    value.reserve(55);
+    value.append("00-");
+    appendHex(value, traceIdHigh);
+    appendHex(value, traceIdLow);
+    value.push_back('-');
+    appendHex(value, spanId);
+    value.append(sampled ? "-01" : "-00");
+    return value;
+}
+
+std::string TraceContext::traceIdHex() const
+{
+    std::string value;
+    value.reserve(32);
+    appendHex(value, traceIdHigh);
+    appendHex(value, traceIdLow);
+    return value;
+}
+
+TraceContext TraceContext::fromTraceparent(std::string_view value)
+{
+    // version-traceid-parentid-flags, the later versions may append fields
+    TraceContext context;
+    if (value.size() < 55 || value[2] != '-' || value[35] != '-' ||
+        value[52] != '-' || (value.size() > 55 && value[55] != '-'))
+        return {};
+    uint64_t version, flags;
+    if (!parseHex(value.substr(0, 2), version) || version == 0xff ||
+        (version == 0 && value.size() != 55) ||
+        !parseHex(value.substr(3, 16), context.traceIdHigh) ||
+        !parseHex(value.substr(19, 16), context.traceIdLow) ||
+        !parseHex(value.substr(36, 16), context.spanId) ||
+        !parseHex(value.substr(53, 2), flags) || !context.valid())
+        return {};
+    context.sampled = (flags & 1) != 0;
+    return context;
+}
+
+uint64_t Tracing::randomId()
+{
+    uint64_t id;
+    do
+    {
+        id = randomEngine()();
+    } while (id == 0);
+    return id;
+}
+
+int64_t Tracing::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void Tracing::enable(const TracingOptions &options, Exporter &&exporter)
+{
+    if (enabled())
+        return;
+    options_ = options;
+    exporter_ = std::move(exporter);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void Tracing::startServerSpan(const HttpRequestImplPtr &req)
+{
+    TraceContext context;
+    auto &header = req->getHeaderBy("traceparent");
+    auto parent = header.empty() ? TraceContext{}
+                                 : TraceContext::fromTraceparent(header);
+    if (parent.valid())
+    {
+        context.traceIdHigh = parent.traceIdHigh;
+        context.traceIdLow = parent.traceIdLow;
+        context.sampled = parent.sampled;
+    }
+    else
+    {
+        context.traceIdHigh = randomId();
+        context.traceIdLow = randomId();
+        context.sampled =
+            options_.sampleRatio >= 1 ||
+            std::uniform_real_distribution<double>(0, 1)(randomEngine()) <
+                options_.sampleRatio;
+    }
+    context.spanId = randomId();
+    context.recorded = context.sampled || options_.tailSampling;
+    req->setTraceContext(context);
+    if (!context.recorded)
+        return;
+    auto span = std::make_unique<SpanData>();
+    span->context = context;
+    span->parentSpanId = parent.valid() ? parent.spanId : 0;
+    span->kind = SpanKind::kServer;
+    span->startTime = now();
+    req->setSpan(std::move(span));
+    if (!context.sampled)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingTraces_[context.spanId];
+    }
+}
+
+void Tracing::endServerSpan(const HttpRequestImplPtr &req,
+                            const HttpResponsePtr &resp)
+{
+    auto span = req->takeSpan();
+    if (!span)
+        return;
+    span->endTime = now();
+    auto route = req->matchedPathPattern();
+    span->name = req->methodString();
+    if (!route.empty())
+        span->name.append(" ").append(route);
+    span->attributes.emplace_back("http.request.method", req->methodString());
+    span->attributes.emplace_back("url.path", req->path());
+    if (!route.empty())
+        span->attributes.emplace_back("http.route", std::string(route));
+    span->attributes.emplace_back("http.response.status_code",
+                                  std::to_string(resp->statusCode()));
+    span->error = resp->statusCode() >= 500;
+    if (span->context.sampled)
+    {
+        finish(std::move(*span));
+        return;
+    }
+    std::vector<SpanData> spans;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = pendingTraces_.find(span->context.spanId);
+        if (iter != pendingTraces_.end())
+        {
+            spans = std::move(iter->second);
+            pendingTraces_.erase(iter);
+        }
+    }
+    bool keep = options_.tailLatency > 0 &&
+                static_cast<double>(span->endTime - span->startTime) / 1e9 >=
+                    options_.tailLatency;
+    if (!keep && options_.keepErrors)
+    {
+        keep = span->error;
+        for (auto &child : spans)
+            keep = keep || child.error;
+    }
+    if (!keep)
+        return;
+    spans.push_back(std::move(*span));
+    exporter_(std::move(spans));
+}
+
+void Tracing::abandon(const SpanData &span)
+{
+    if (span.context.sampled)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    pendingTraces_.erase(span.context.spanId);
+}
+
+SpanPtr Tracing::newClientSpan(std::string &&name)
+{
+    auto &current = internal::currentTraceContext();
+    auto span = std::make_shared<SpanData>();
+    span->context = current;
+    span->context.spanId = randomId();
+    span->parentSpanId = current.spanId;
+    span->kind = SpanKind::kClient;
+    span->name = std::move(name);
+    span->startTime = now();
+    return span;
+}
+
+void Tracing::endClientSpan(const SpanPtr &span, bool error)
+{
+    if (!span)
+        return;
+    span->endTime = now();
+    span->error = error;
+    if (span->context.sampled)
+    {
+        finish(std::move(*span));
+        return;
+    }
+    // Held for the tail sampling until the request is answered
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = pendingTraces_.find(span->parentSpanId);
+    if (iter != pendingTraces_.end())
+        iter->second.push_back(std::move(*span));
+}
+
+void Tracing::finish(SpanData &&span)
+{
+    std::vector<SpanData> spans;
+    spans.push_back(std::move(span));
+    exporter_(std::move(spans));
+}
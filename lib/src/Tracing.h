@@ -0,0 +1,157 @@
+/**
+ *
+ *  @file Tracing.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <drogon/exports.h>
+#include <drogon/utils/TraceContext.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/// The kinds of spans, valued as in OTLP
+enum class SpanKind : uint8_t
+{
+    kServer = 2,
+    kClient = 3
+};
+
+struct SpanData
+{
+    TraceContext context;
+    uint64_t parentSpanId{0};
+    SpanKind kind{SpanKind::kClient};
+    std::string name;
+    /// In nanoseconds since the unix epoch
+    int64_t startTime{0};
+    int64_t endTime{0};
+    bool error{false};
+    std::vector<std::pair<std::string, std::string>> attributes;
+};
+
+using SpanPtr = std::shared_ptr<SpanData>;
+
+struct TracingOptions
+{
+    /// The fraction of the traces started here which are sampled
+    double sampleRatio{1.0};
+    /// Record the traces not sampled too, and keep the ones with an error or
+    /// slower than tailLatency when their request is answered
+    bool tailSampling{false};
+    bool keepErrors{true};
+    /// In seconds, 0 keeps no trace for its latency
+    double tailLatency{0};
+};
+
+/**
+ * @brief The spans made by the framework itself, enabled by the Tracer
+ * plugin which exports them.
+ *
+ * A request gets a server span continuing the trace of its traceparent
+ * header, and the http, database and redis client calls made from its
+ * handler, its coroutines included, get child spans. The http requests
+ * carry the traceparent header of their span.
+ *
+ * The head sampling decides at the start of a trace, a trace continued from
+ * another service follows its sampled flag. With the tail sampling, the
+ * spans of the traces not sampled are held until their request is answered
+ * and exported only if the trace had an error or was slow; the client calls
+ * which end after the response are dropped then.
+ */
+class DROGON_EXPORT Tracing : public trantor::NonCopyable
+{
+  public:
+    using Exporter = std::function<void(std::vector<SpanData> &&)>;
+
+    static Tracing &instance()
+    {
+        static Tracing inst;
+        return inst;
+    }
+
+    /// The exporter is called with the spans to export from any thread
+    void enable(const TracingOptions &options, Exporter &&exporter);
+
+    bool enabled() const
+    {
+        return enabled_.load(std::memory_order_acquire);
+    }
+
+    /// Called when the request is parsed
+    void requestStarted(const HttpRequestImplPtr &req)
+    {
+        if (enabled())
+            startServerSpan(req);
+    }
+
+    /// Called when the response of the request is about to be sent
+    void responseSending(const HttpRequestImplPtr &req,
+                         const HttpResponsePtr &resp)
+    {
+        if (enabled())
+            endServerSpan(req, resp);
+    }
+
+    /// Called when a request is dropped before its response, e.g. when its
+    /// connection is closed
+    void abandon(const SpanData &span);
+
+    /**
+     * @brief Start a client span in the trace of the current thread, see
+     * internal::TraceScope.
+     *
+     * @return nullptr if no trace is recorded
+     */
+    SpanPtr startClientSpan(std::string name)
+    {
+        if (!enabled() || !internal::currentTraceContext().recorded)
+            return nullptr;
+        return newClientSpan(std::move(name));
+    }
+
+    void endClientSpan(const SpanPtr &span, bool error);
+
+    /// A random non-zero id
+    static uint64_t randomId();
+
+    /// The current time in nanoseconds since the unix epoch
+    static int64_t now();
+
+  private:
+    Tracing() = default;
+
+    void startServerSpan(const HttpRequestImplPtr &req);
+    void endServerSpan(const HttpRequestImplPtr &req,
+                       const HttpResponsePtr &resp);
+    SpanPtr newClientSpan(std::string &&name);
+    void finish(SpanData &&span);
+
+    std::atomic<bool> enabled_{false};
+    TracingOptions options_;
+    Exporter exporter_;
+
+    // The spans of the traces waiting for the tail sampling, by the id of
+    // their server span
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::vector<SpanData>> pendingTraces_;
+};
+}  // namespace drogon
@@ -0,0 +1,344 @@
+/**
+ *
+ *  @file TrafficCapture.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SpscRingBuffer.h"
+#include <drogon/drogon.h>
+#include <drogon/plugins/TrafficCapture.h>
+#include <trantor/net/EventLoopThread.h>
+#include <algorithm>
+#include <random>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+namespace
+{
+void appendVarint(std::string &output, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        output.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<char>(value));
+}
+
+void appendString(std::string &output, std::string_view value)
+{
+    appendVarint(output, value.size());
+    output.append(value);
+}
+
+// Reads the fields of a record, every read fails once one did
+class Reader
+{
+  public:
+    explicit Reader(std::string_view data) : data_(data)
+    {
+    }
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (!ok_ || pos_ >= data_.size())
+                break;
+            auto byte = static_cast<unsigned char>(data_[pos_++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        ok_ = false;
+        return 0;
+    }
+
+    unsigned char byte()
+    {
+        if (!ok_ || pos_ >= data_.size())
+        {
+            ok_ = false;
+            return 0;
+        }
+        return static_cast<unsigned char>(data_[pos_++]);
+    }
+
+    std::string string()
+    {
+        auto size = varint();
+        if (!ok_ || size > data_.size() - pos_)
+        {
+            ok_ = false;
+            return {};
+        }
+        std::string value(data_.substr(pos_, size));
+        pos_ += size;
+        return value;
+    }
+
+    bool ok() const
+    {
+        return ok_;
+    }
+
+    size_t position() const
+    {
+        return pos_;
+    }
+
+  private:
+    std::string_view data_;
+    size_t pos_{0};
+    bool ok_{true};
+};
+
+bool sampled(double ratio)
+{
+    if (ratio >= 1)
+        return true;
+    thread_local std::mt19937_64 engine{std::random_device{}()};
+    return std::uniform_real_distribution<double>(0, 1)(engine) < ratio;
+}
+}  // namespace
+
+TrafficCapture::TrafficCapture() = default;
+
+TrafficCapture::~TrafficCapture()
+{
+    shutdown();
+}
+
+void TrafficCapture::initAndStart(const Json::Value &config)
+{
+    sampleRatio_ = config.get("sample_ratio", 1.0).asDouble();
+    maxBodySize_ = config.get("max_body_size", 65536).asUInt64();
+    maxFileSize_ = config.get("max_file_size", 0).asUInt64();
+    if (config.isMember("exclude_headers"))
+    {
+        for (const auto &header : config["exclude_headers"])
+            excludedHeaders_.insert(header.asString());
+    }
+    else
+    {
+        excludedHeaders_ = {"authorization", "proxy-authorization", "cookie"};
+    }
+    if (sampleRatio_ <= 0)
+    {
+        LOG_WARN << "The sample ratio of TrafficCapture is 0, no request is "
+                    "captured";
+        return;
+    }
+
+    auto path = config.get("file", "./traffic.cap").asString();
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open())
+    {
+        LOG_ERROR << "Can't open the traffic capture " << path;
+        return;
+    }
+    file_.write(fileMagic().data(),
+                static_cast<std::streamsize>(fileMagic().size()));
+    fileSize_ = fileMagic().size();
+
+    auto queueSize = config.get("queue_size", 8192).asUInt64();
+    if (queueSize == 0)
+    {
+        queueSize = 8192;
+    }
+    for (size_t i = 0; i < app().getThreadNum(); ++i)
+    {
+        ioLoops_.push_back(app().getIOLoop(i));
+        rings_.push_back(std::make_unique<PendingRing>(queueSize));
+    }
+    sharedRing_ = std::make_unique<PendingRing>(queueSize);
+    auto interval = config.get("flush_interval", 0.1).asDouble();
+    if (interval <= 0)
+    {
+        interval = 0.1;
+    }
+    writerThread_ =
+        std::make_unique<trantor::EventLoopThread>("TrafficCapture");
+    writerThread_->run();
+    writerThread_->getLoop()->runEvery(interval,
+                                       [this]() { writeRecords(); });
+    running_ = true;
+
+    app().registerPreSendingAdvice([this](const HttpRequestPtr &req,
+                                          const HttpResponsePtr &) {
+        if (!running_.load(std::memory_order_relaxed) ||
+            !sampled(sampleRatio_))
+        {
+            return;
+        }
+        Pending pending;
+        pending.arrival = req->creationDate().microSecondsSinceEpoch();
+        auto &record = pending.record;
+        record.method = req->method();
+        record.path = req->path();
+        record.query = req->query();
+        for (const auto &[name, value] : req->headers())
+        {
+            if (excludedHeaders_.find(name) == excludedHeaders_.end())
+                record.headers.emplace_back(name, value);
+        }
+        auto body = req->body();
+        record.body = body.substr(0, maxBodySize_);
+        push(std::move(pending));
+    });
+}
+
+void TrafficCapture::shutdown()
+{
+    if (!writerThread_)
+    {
+        return;
+    }
+    // Join the writer thread, then write the remaining requests in this thread
+    running_ = false;
+    writerThread_.reset();
+    writeRecords();
+    file_.close();
+}
+
+void TrafficCapture::encode(const Record &record, std::string &output)
+{
+    std::string fields;
+    appendVarint(fields, record.gap);
+    fields.push_back(static_cast<char>(record.method));
+    appendString(fields, record.path);
+    appendString(fields, record.query);
+    appendVarint(fields, record.headers.size());
+    for (const auto &[name, value] : record.headers)
+    {
+        appendString(fields, name);
+        appendString(fields, value);
+    }
+    appendString(fields, record.body);
+    appendString(output, fields);
+}
+
+size_t TrafficCapture::decode(std::string_view data, Record &record)
+{
+    Reader frame(data);
+    auto size = frame.varint();
+    if (!frame.ok() || size > data.size() - frame.position())
+        return 0;
+    Reader reader(data.substr(frame.position(), size));
+    record.gap = reader.varint();
+    auto method = reader.byte();
+    if (method >= Invalid)
+        return 0;
+    record.method = static_cast<HttpMethod>(method);
+    record.path = reader.string();
+    record.query = reader.string();
+    auto headers = reader.varint();
+    record.headers.clear();
+    for (uint64_t i = 0; i < headers && reader.ok(); ++i)
+    {
+        auto name = reader.string();
+        auto value = reader.string();
+        record.headers.emplace_back(std::move(name), std::move(value));
+    }
+    record.body = reader.string();
+    if (!reader.ok())
+        return 0;
+    return frame.position() + size;
+}
+
+void TrafficCapture::push(Pending &&pending)
+{
+    bool pushed;
+    // Every IO loop is the only producer of its ring, the other threads
+    // share a ring under a lock.
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (loop && loop->index() < ioLoops_.size() &&
+        ioLoops_[loop->index()] == loop)
+    {
+        pushed = rings_[loop->index()]->push(std::move(pending));
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(sharedRingMutex_);
+        pushed = sharedRing_->push(std::move(pending));
+    }
+    if (!pushed)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TrafficCapture::writeRecords()
+{
+    auto collect = [this](Pending &pending) {
+        batch_.push_back(std::move(pending));
+    };
+    for (auto &ring : rings_)
+    {
+        ring->consumeAll(collect);
+    }
+    if (sharedRing_)
+    {
+        sharedRing_->consumeAll(collect);
+    }
+    if (batch_.empty())
+    {
+        return;
+    }
+    // The rings are written in turn, the gaps are those of the arrivals
+    std::stable_sort(batch_.begin(),
+                     batch_.end(),
+                     [](const Pending &a, const Pending &b) {
+                         return a.arrival < b.arrival;
+                     });
+    uint64_t written = 0;
+    for (auto &pending : batch_)
+    {
+        if (lastArrival_ != 0 && pending.arrival > lastArrival_)
+            pending.record.gap =
+                static_cast<uint64_t>(pending.arrival - lastArrival_);
+        else
+            pending.record.gap = 0;
+        lastArrival_ = (std::max)(lastArrival_, pending.arrival);
+        auto size = buffer_.size();
+        encode(pending.record, buffer_);
+        if (full_ ||
+            (maxFileSize_ > 0 && fileSize_ + buffer_.size() > maxFileSize_))
+        {
+            buffer_.resize(size);
+            if (!full_)
+            {
+                full_ = true;
+                running_ = false;
+                LOG_WARN << "The traffic capture reached its size limit of "
+                         << maxFileSize_ << " bytes, it is stopped";
+            }
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        ++written;
+    }
+    batch_.clear();
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    fileSize_ += buffer_.size();
+    buffer_.clear();
+    captured_.fetch_add(written, std::memory_order_relaxed);
+
+    auto dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops_)
+    {
+        LOG_WARN << dropped - reportedDrops_
+                 << " captured requests were dropped";
+        reportedDrops_ = dropped;
+    }
+}
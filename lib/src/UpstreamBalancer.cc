@@ -0,0 +1,202 @@
+/**
+ *
+ *  @file UpstreamBalancer.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "UpstreamBalancer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace drogon;
+
+namespace
+{
+// FNV-1a with a final mix, stable across processes so the instances of an
+// application map a key to the same server
+uint64_t hashOf(std::string_view text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// The cost of a server which has requests in flight but no latency yet, in
+// microseconds, so a new server doesn't take all the requests at once
+constexpr double kUnknownLatencyPenalty = 1e7;
+}  // namespace
+
+UpstreamBalancer::UpstreamBalancer(const std::vector<std::string> &names,
+                                   Policy policy,
+                                   Options options)
+    : policy_(policy),
+      options_(options),
+      size_(names.size()),
+      backends_(new Backend[names.size()])
+{
+    if (policy_ != Policy::kConsistentHash)
+        return;
+    auto nodes = (std::max)(options_.virtualNodes, size_t(1));
+    ring_.reserve(size_ * nodes);
+    for (size_t i = 0; i < size_; ++i)
+    {
+        for (size_t v = 0; v < nodes; ++v)
+        {
+            ring_.emplace_back(hashOf(names[i] + "#" + std::to_string(v)), i);
+        }
+    }
+    std::sort(ring_.begin(), ring_.end());
+}
+
+size_t UpstreamBalancer::pick(std::string_view key,
+                              int64_t now,
+                              size_t exclude)
+{
+    for (bool checkHealth : {true, false})
+    {
+        auto index = policy_ == Policy::kConsistentHash
+                         ? pickOnRing(key, now, exclude, checkHealth)
+                         : pickByScore(now, exclude, checkHealth);
+        if (index != npos)
+            return index;
+    }
+    return npos;
+}
+
+size_t UpstreamBalancer::pickByScore(int64_t now,
+                                     size_t exclude,
+                                     bool checkHealth)
+{
+    if (size_ == 0)
+        return npos;
+    // The scan starts at the next server, so ties are broken in turn
+    auto start = next_.fetch_add(1, std::memory_order_relaxed) % size_;
+    size_t best = npos;
+    double bestCost = 0;
+    for (size_t n = 0; n < size_; ++n)
+    {
+        auto index = (start + n) % size_;
+        if (index == exclude || (checkHealth && !isAvailable(index, now)))
+            continue;
+        if (policy_ == Policy::kRoundRobin)
+            return index;
+        auto &backend = backends_[index];
+        auto active = static_cast<double>(
+            backend.active.load(std::memory_order_relaxed));
+        double cost = active;
+        if (policy_ == Policy::kEwmaLatency)
+        {
+            auto ewma = backend.ewma.load(std::memory_order_relaxed);
+            if (ewma > 0)
+                cost = ewma * (active + 1);
+            else if (active > 0)
+                cost = kUnknownLatencyPenalty + active;
+        }
+        if (best == npos || cost < bestCost)
+        {
+            best = index;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+size_t UpstreamBalancer::pickOnRing(std::string_view key,
+                                    int64_t now,
+                                    size_t exclude,
+                                    bool checkHealth) const
+{
+    if (ring_.empty())
+        return npos;
+    auto hash = hashOf(key);
+    auto it = std::lower_bound(ring_.begin(),
+                               ring_.end(),
+                               std::make_pair(hash, size_t(0)));
+    // The keys of an unavailable server move to the next ones on the ring
+    for (size_t n = 0; n < ring_.size(); ++n, ++it)
+    {
+        if (it == ring_.end())
+            it = ring_.begin();
+        auto index = it->second;
+        if (index == exclude || (checkHealth && !isAvailable(index, now)))
+            continue;
+        return index;
+    }
+    return npos;
+}
+
+void UpstreamBalancer::onFinish(size_t index,
+                                bool ok,
+                                int64_t latency,
+                                int64_t now)
+{
+    auto &backend = backends_[index];
+    backend.active.fetch_sub(1, std::memory_order_relaxed);
+    if (ok)
+    {
+        backend.fails.store(0, std::memory_order_relaxed);
+        auto previous = backend.ewma.load(std::memory_order_relaxed);
+        auto stamp = backend.ewmaStamp.exchange(now, std::memory_order_relaxed);
+        auto sample = static_cast<double>((std::max)(latency, int64_t(1)));
+        // Rising to a slower sample at once makes a degrading server lose
+        // its traffic quickly, the average only recovers with time.
+        if (previous > 0 && sample < previous && options_.ewmaDecay > 0)
+        {
+            auto weight = std::exp(-static_cast<double>(now - stamp) /
+                                   static_cast<double>(options_.ewmaDecay));
+            sample = previous * weight + sample * (1 - weight);
+        }
+        backend.ewma.store(sample, std::memory_order_relaxed);
+        return;
+    }
+    if (options_.maxFails == 0)
+        return;
+    size_t fails;
+    if (now - backend.firstFail.load(std::memory_order_relaxed) >
+        options_.failTimeout)
+    {
+        backend.firstFail.store(now, std::memory_order_relaxed);
+        backend.fails.store(1, std::memory_order_relaxed);
+        fails = 1;
+    }
+    else
+    {
+        fails = backend.fails.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    if (fails >= options_.maxFails)
+    {
+        backend.downUntil.store(now + options_.failTimeout,
+                                std::memory_order_relaxed);
+        backend.fails.store(0, std::memory_order_relaxed);
+    }
+}
+
+UpstreamBalancer::Policy UpstreamBalancer::parsePolicy(const std::string &name,
+                                                       bool *ok)
+{
+    if (ok)
+        *ok = true;
+    if (name == "least_connections")
+        return Policy::kLeastConnections;
+    if (name == "ewma_latency")
+        return Policy::kEwmaLatency;
+    if (name == "consistent_hash")
+        return Policy::kConsistentHash;
+    if (ok && name != "round_robin")
+        *ok = false;
+    return Policy::kRoundRobin;
+}
@@ -0,0 +1,154 @@
+/**
+ *
+ *  @file UpstreamBalancer.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Choose the upstream server of each proxied request, shared by all
+ * the IO threads.
+ *
+ * The passive health check marks a server down for failTimeout once it
+ * failed maxFails times within failTimeout, the servers which are down are
+ * skipped until then. When all of them are down they are all tried, so a
+ * general outage doesn't outlast the servers.
+ *
+ * The counters are relaxed atomics, a decision may use a slightly stale
+ * view of the other threads.
+ */
+class DROGON_EXPORT UpstreamBalancer
+{
+  public:
+    enum class Policy
+    {
+        kRoundRobin,
+        kLeastConnections,
+        /// The lowest decaying average of the latency, weighted by the
+        /// requests in flight
+        kEwmaLatency,
+        /// A ring of virtual nodes keyed by the hash key of the request
+        kConsistentHash
+    };
+
+    struct Options
+    {
+        size_t maxFails{3};
+        /// In microseconds
+        int64_t failTimeout{10000000};
+        /// The time constant of the latency average in microseconds
+        int64_t ewmaDecay{10000000};
+        size_t virtualNodes{160};
+    };
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /// The names of the servers only feed the hash ring
+    UpstreamBalancer(const std::vector<std::string> &names,
+                     Policy policy,
+                     Options options);
+
+    /**
+     * @brief Pick a server for a request.
+     *
+     * @param key The hash key, used by the kConsistentHash policy.
+     * @param now The steady time in microseconds.
+     * @param exclude A server not to pick, e.g. the one that just failed.
+     * @return npos if there is no other server than exclude.
+     */
+    size_t pick(std::string_view key, int64_t now, size_t exclude = npos);
+
+    /// A request is sent to the server
+    void onStart(size_t index)
+    {
+        backends_[index].active.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief The request sent to the server is done.
+     *
+     * @param ok false if the server failed, which counts for the passive
+     * health check.
+     * @param latency The time to the response header in microseconds, only
+     * counted when ok is true.
+     */
+    void onFinish(size_t index, bool ok, int64_t latency, int64_t now);
+
+    /// The request got no response for a reason not related to the server,
+    /// e.g. a kept alive connection closed by the server.
+    void onCancel(size_t index)
+    {
+        backends_[index].active.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    bool isAvailable(size_t index, int64_t now) const
+    {
+        return backends_[index].downUntil.load(std::memory_order_relaxed) <=
+               now;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t activeRequests(size_t index) const
+    {
+        return backends_[index].active.load(std::memory_order_relaxed);
+    }
+
+    /// The average latency in microseconds, 0 until the first response
+    double latency(size_t index) const
+    {
+        return backends_[index].ewma.load(std::memory_order_relaxed);
+    }
+
+    static Policy parsePolicy(const std::string &name, bool *ok = nullptr);
+
+  private:
+    // Padded to a cache line, the IO threads update them concurrently
+    struct alignas(64) Backend
+    {
+        std::atomic<size_t> active{0};
+        std::atomic<double> ewma{0};
+        std::atomic<int64_t> ewmaStamp{0};
+        std::atomic<size_t> fails{0};
+        std::atomic<int64_t> firstFail{0};
+        std::atomic<int64_t> downUntil{0};
+    };
+
+    size_t pickByScore(int64_t now, size_t exclude, bool checkHealth);
+    size_t pickOnRing(std::string_view key,
+                      int64_t now,
+                      size_t exclude,
+                      bool checkHealth) const;
+
+    Policy policy_;
+    Options options_;
+    size_t size_;
+    std::unique_ptr<Backend[]> backends_;
+    // Sorted by the hash of the virtual nodes
+    std::vector<std::pair<uint64_t, size_t>> ring_;
+    std::atomic<size_t> next_{0};
+};
+
+}  // namespace drogon
@@ -20,20 +20,24 @@
 #include <brotli/decode.h>
 #include <brotli/encode.h>
 #endif
+#include "BinaryCodecs.h"
+#include "SecureRandom.h"
+#include "ZlibContext.h"
+#include "ZstdContext.h"
 #ifdef _WIN32
 #include <rpc.h>
 #include <direct.h>
 #include <io.h>
 #include <iomanip>
 #else
-#include <uuid.h>
 #include <unistd.h>
 #endif
 #include <zlib.h>
 #include <sstream>
 #include <string>
 #include <mutex>
-#include <random>
+#include <chrono>
+#include <stdexcept>
 #include <algorithm>
 #include <array>
 #include <locale>
@@ -161,70 +165,74 @@ bool isBase64(std::string_view str)
     return true;
 }
 
+namespace
+{
+void fillRandom(void *ptr, size_t size)
+{
+    if (!ChaChaRandom::instance().fill(ptr, size))
+        throw std::runtime_error("Failed to generate random bytes");
+}
+}  // namespace
+
 std::string genRandomString(int length)
 {
     static const std::string_view char_space =
         "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    std::uniform_int_distribution<size_t> dist(0, char_space.size() - 1);
-    thread_local std::mt19937 rng(std::random_device{}());
-
     std::string str;
     str.resize(length);
+    unsigned char bytes[64];
+    size_t used = sizeof(bytes);
     for (char &ch : str)
     {
-        ch = char_space[dist(rng)];
+        // Drop the bytes above the largest multiple of 62, so every
+        // character is as likely
+        unsigned char byte;
+        do
+        {
+            if (used == sizeof(bytes))
+            {
+                fillRandom(bytes, sizeof(bytes));
+                used = 0;
+            }
+            byte = bytes[used++];
+        } while (byte >= 248);
+        ch = char_space[byte % char_space.size()];
     }
-
     return str;
 }
 
-std::vector<char> hexToBinaryVector(const char *ptr, size_t length)
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool hexToBinary(const char *ptr, size_t length, char *out)
 {
     assert(length % 2 == 0);
-    std::vector<char> ret(length / 2, '\0');
-    for (size_t i = 0; i < ret.size(); ++i)
+    for (size_t i = binary_codecs::hexDecode(ptr, length, out); i < length;
+         i += 2)
     {
-        auto p = i * 2;
-        char c1 = ptr[p];
-        if (c1 >= '0' && c1 <= '9')
-        {
-            c1 -= '0';
-        }
-        else if (c1 >= 'a' && c1 <= 'f')
-        {
-            c1 -= 'a';
-            c1 += 10;
-        }
-        else if (c1 >= 'A' && c1 <= 'F')
-        {
-            c1 -= 'A';
-            c1 += 10;
-        }
-        else
-        {
-            return std::vector<char>();
-        }
-        char c2 = ptr[p + 1];
-        if (c2 >= '0' && c2 <= '9')
-        {
-            c2 -= '0';
-        }
-        else if (c2 >= 'a' && c2 <= 'f')
-        {
-            c2 -= 'a';
-            c2 += 10;
-        }
-        else if (c2 >= 'A' && c2 <= 'F')
-        {
-            c2 -= 'A';
-            c2 += 10;
-        }
-        else
-        {
-            return std::vector<char>();
-        }
-        ret[i] = c1 * 16 + c2;
+        int c1 = hexValue(ptr[i]);
+        int c2 = hexValue(ptr[i + 1]);
+        if (c1 < 0 || c2 < 0)
+            return false;
+        out[i / 2] = static_cast<char>(c1 * 16 + c2);
     }
+    return true;
+}
+
+std::vector<char> hexToBinaryVector(const char *ptr, size_t length)
+{
+    assert(length % 2 == 0);
+    std::vector<char> ret(length / 2, '\0');
+    if (!hexToBinary(ptr, length, ret.data()))
+        return std::vector<char>();
     return ret;
 }
 
@@ -232,49 +240,8 @@ std::string hexToBinaryString(const char *ptr, size_t length)
 {
     assert(length % 2 == 0);
     std::string ret(length / 2, '\0');
-    for (size_t i = 0; i < ret.length(); ++i)
-    {
-        auto p = i * 2;
-        char c1 = ptr[p];
-        if (c1 >= '0' && c1 <= '9')
-        {
-            c1 -= '0';
-        }
-        else if (c1 >= 'a' && c1 <= 'f')
-        {
-            c1 -= 'a';
-            c1 += 10;
-        }
-        else if (c1 >= 'A' && c1 <= 'F')
-        {
-            c1 -= 'A';
-            c1 += 10;
-        }
-        else
-        {
-            return "";
-        }
-        char c2 = ptr[p + 1];
-        if (c2 >= '0' && c2 <= '9')
-        {
-            c2 -= '0';
-        }
-        else if (c2 >= 'a' && c2 <= 'f')
-        {
-            c2 -= 'a';
-            c2 += 10;
-        }
-        else if (c2 >= 'A' && c2 <= 'F')
-        {
-            c2 -= 'A';
-            c2 += 10;
-        }
-        else
-        {
-            return "";
-        }
-        ret[i] = c1 * 16 + c2;
-    }
+    if (!hexToBinary(ptr, length, &ret[0]))
+        return "";
     return ret;
 }
 
@@ -283,7 +250,9 @@ DROGON_EXPORT void binaryStringToHex(const char *ptr,
                                      char *out,
                                      bool lowerCase)
 {
-    for (size_t i = 0; i < length; ++i)
+    for (size_t i = binary_codecs::hexEncode(ptr, length, out, lowerCase);
+         i < length;
+         ++i)
     {
         int value = (ptr[i] & 0xf0) >> 4;
         if (value < 10)
@@ -373,60 +342,46 @@ inline std::string createUuidString(const char *str, size_t len, bool lowercase)
 
 std::string getUuid(bool lowercase)
 {
-#if USE_OSSP_UUID
-    uuid_t *uuid;
-    uuid_create(&uuid);
-    uuid_make(uuid, UUID_MAKE_V4);
-    char *str{nullptr};
-    size_t len{0};
-    uuid_export(uuid, UUID_FMT_BIN, &str, &len);
-    uuid_destroy(uuid);
-    auto ret = createUuidString(str, len, lowercase);
-    free(str);
-    return ret;
-#elif defined __FreeBSD__ || defined __OpenBSD__
-    uuid_t *uuid = new uuid_t;
-    char *binstr = (char *)malloc(16);
-#if defined __FreeBSD__
-    uuidgen(uuid, 1);
-#else
-    uint32_t status;
-    uuid_create(uuid, &status);
-#endif
-#if _BYTE_ORDER == _LITTLE_ENDIAN
-    uuid_enc_le(binstr, uuid);
-#else  /* _BYTE_ORDER != _LITTLE_ENDIAN */
-    uuid_enc_be(binstr, uuid);
-#endif /* _BYTE_ORDER == _LITTLE_ENDIAN */
-    delete uuid;
-    auto ret = createUuidString(binstr, 16, lowercase);
-    free(binstr);
-    return ret;
-#elif defined _WIN32
-    uuid_t uu;
-    UuidCreate(&uu);
-    char tempStr[100];
-    auto len = snprintf(tempStr,
-                        sizeof(tempStr),
-                        "%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-                        uu.Data1,
-                        uu.Data2,
-                        uu.Data3,
-                        uu.Data4[0],
-                        uu.Data4[1],
-                        uu.Data4[2],
-                        uu.Data4[3],
-                        uu.Data4[4],
-                        uu.Data4[5],
-                        uu.Data4[6],
-                        uu.Data4[7]);
-    return std::string{tempStr, static_cast<size_t>(len)};
-#else
-    uuid_t uu;
-    uuid_generate(uu);
-    auto uuid = createUuidString((const char *)uu, 16, lowercase);
-    return uuid;
-#endif
+    unsigned char bytes[16];
+    fillRandom(bytes, sizeof(bytes));
+    bytes[6] = (bytes[6] & 0x0f) | 0x40;
+    bytes[8] = (bytes[8] & 0x3f) | 0x80;
+    return createUuidString(reinterpret_cast<const char *>(bytes),
+                            sizeof(bytes),
+                            lowercase);
+}
+
+std::string getUuidV7(bool lowercase)
+{
+    // The last timestamp and counter of the thread (RFC 9562 6.2, method 1)
+    thread_local uint64_t lastMilliseconds = 0;
+    thread_local uint16_t counter = 0;
+    unsigned char bytes[16];
+    fillRandom(bytes, sizeof(bytes));
+    uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+    if (now > lastMilliseconds)
+    {
+        lastMilliseconds = now;
+        // Start low enough to leave room for the next ones in the millisecond
+        counter = ((bytes[6] << 8) | bytes[7]) & 0x7ff;
+    }
+    else if (++counter > 0xfff)
+    {
+        // The counter overflows, or the clock went back, borrow the next
+        // millisecond
+        ++lastMilliseconds;
+        counter = ((bytes[6] << 8) | bytes[7]) & 0x7ff;
+    }
+    for (int i = 0; i < 6; ++i)
+        bytes[i] = static_cast<unsigned char>(lastMilliseconds >> (40 - 8 * i));
+    bytes[6] = static_cast<unsigned char>(0x70 | (counter >> 8));
+    bytes[7] = static_cast<unsigned char>(counter);
+    bytes[8] = (bytes[8] & 0x3f) | 0x80;
+    return createUuidString(reinterpret_cast<const char *>(bytes),
+                            sizeof(bytes),
+                            lowercase);
 }
 
 void base64Encode(const unsigned char *bytesToEncode,
@@ -441,7 +396,14 @@ void base64Encode(const unsigned char *bytesToEncode,
 
     const std::string_view charSet = urlSafe ? urlBase64Chars : base64Chars;
 
-    size_t a = 0;
+    // The whole blocks first, the loop below encodes the rest
+    auto done = binary_codecs::base64Encode(bytesToEncode,
+                                            inLen,
+                                            outputBuffer,
+                                            urlSafe);
+    bytesToEncode += done;
+    inLen -= done;
+    size_t a = done / 3 * 4;
     while (inLen--)
     {
         charArray3[i++] = *(bytesToEncode++);
@@ -487,61 +449,10 @@ void base64Encode(const unsigned char *bytesToEncode,
 std::vector<char> base64DecodeToVector(std::string_view encodedString)
 {
     auto inLen = encodedString.size();
-    int i = 0;
-    int in_{0};
-    char charArray4[4], charArray3[3];
-    std::vector<char> ret;
-    ret.reserve(base64DecodedLength(inLen));
-
-    while (inLen-- && (encodedString[in_] != '='))
-    {
-        if (!isBase64(encodedString[in_]))
-        {
-            ++in_;
-            continue;
-        }
-
-        charArray4[i++] = encodedString[in_];
-        ++in_;
-        if (i == 4)
-        {
-            for (i = 0; i < 4; ++i)
-            {
-                charArray4[i] = base64CharMap.getIndex(charArray4[i]);
-            }
-
-            charArray3[0] =
-                (charArray4[0] << 2) + ((charArray4[1] & 0x30) >> 4);
-            charArray3[1] =
-                ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-            charArray3[2] = ((charArray4[2] & 0x3) << 6) + charArray4[3];
-
-            for (i = 0; (i < 3); ++i)
-                ret.push_back(charArray3[i]);
-            i = 0;
-        }
-    }
-
-    if (i)
-    {
-        for (int j = i; j < 4; ++j)
-            charArray4[j] = 0;
-
-        for (int j = 0; j < 4; ++j)
-        {
-            charArray4[j] = base64CharMap.getIndex(charArray4[j]);
-        }
-
-        charArray3[0] = (charArray4[0] << 2) + ((charArray4[1] & 0x30) >> 4);
-        charArray3[1] =
-            ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-        charArray3[2] = ((charArray4[2] & 0x3) << 6) + charArray4[3];
-
-        --i;
-        for (int j = 0; (j < i); ++j)
-            ret.push_back(charArray3[j]);
-    }
-
+    std::vector<char> ret(base64DecodedLength(inLen));
+    ret.resize(base64Decode(encodedString.data(),
+                            inLen,
+                            reinterpret_cast<unsigned char *>(ret.data())));
     return ret;
 }
 
@@ -550,10 +461,14 @@ size_t base64Decode(const char *encodedString,
                     unsigned char *outputBuffer)
 {
     int i = 0;
-    int in_{0};
     unsigned char charArray4[4], charArray3[3];
 
-    size_t a = 0;
+    // The whole blocks of valid characters first, the loop below decodes the
+    // rest
+    size_t in_ =
+        binary_codecs::base64Decode(encodedString, inLen, outputBuffer);
+    inLen -= in_;
+    size_t a = in_ / 4 * 3;
     while (inLen-- && (encodedString[in_] != '='))
     {
         if (!isBase64(encodedString[in_]))
@@ -823,127 +738,85 @@ std::string urlEncode(const std::string &src)
 
 bool needUrlDecoding(const char *begin, const char *end)
 {
-    return std::find_if(begin, end, [](const char c) {
+    size_t len = end - begin;
+    size_t i = binary_codecs::urlPlainLength(begin, len);
+    return std::find_if(begin + i, end, [](const char c) {
                return c == '+' || c == '%';
            }) != end;
 }
 
-std::string urlDecode(const char *begin, const char *end)
+size_t urlDecode(const char *begin, const char *end, char *out)
 {
-    std::string result;
     size_t len = end - begin;
-    result.reserve(len * 2);
-    int hex = 0;
-    for (size_t i = 0; i < len; ++i)
+    size_t i = 0;
+    char *p = out;
+    while (i < len)
     {
-        switch (begin[i])
+        // Copy the characters which decode to themselves at once
+        size_t n = binary_codecs::urlPlainLength(begin + i, len - i);
+        while (i + n < len && begin[i + n] != '+' && begin[i + n] != '%')
+            ++n;
+        memmove(p, begin + i, n);
+        p += n;
+        i += n;
+        if (i == len)
+            break;
+        if (begin[i] == '+')
         {
-            case '+':
-                result += ' ';
-                break;
-            case '%':
-                if ((i + 2) < len && isxdigit(begin[i + 1]) &&
-                    isxdigit(begin[i + 2]))
-                {
-                    unsigned int x1 = begin[i + 1];
-                    if (x1 >= '0' && x1 <= '9')
-                    {
-                        x1 -= '0';
-                    }
-                    else if (x1 >= 'a' && x1 <= 'f')
-                    {
-                        x1 = x1 - 'a' + 10;
-                    }
-                    else if (x1 >= 'A' && x1 <= 'F')
-                    {
-                        x1 = x1 - 'A' + 10;
-                    }
-                    unsigned int x2 = begin[i + 2];
-                    if (x2 >= '0' && x2 <= '9')
-                    {
-                        x2 -= '0';
-                    }
-                    else if (x2 >= 'a' && x2 <= 'f')
-                    {
-                        x2 = x2 - 'a' + 10;
-                    }
-                    else if (x2 >= 'A' && x2 <= 'F')
-                    {
-                        x2 = x2 - 'A' + 10;
-                    }
-                    hex = x1 * 16 + x2;
-
-                    result += char(hex);
-                    i += 2;
-                }
-                else
-                {
-                    result += '%';
-                }
-                break;
-            default:
-                result += begin[i];
-                break;
+            *p++ = ' ';
+            ++i;
+            continue;
+        }
+        int x1, x2;
+        if ((i + 2) < len && (x1 = hexValue(begin[i + 1])) >= 0 &&
+            (x2 = hexValue(begin[i + 2])) >= 0)
+        {
+            *p++ = char(x1 * 16 + x2);
+            i += 3;
+        }
+        else
+        {
+            *p++ = '%';
+            ++i;
         }
     }
+    return p - out;
+}
+
+std::string urlDecode(const char *begin, const char *end)
+{
+    std::string result;
+    result.resize(end - begin);
+    result.resize(urlDecode(begin, end, &result[0]));
     return result;
 }
 
 /* Compress gzip data */
-std::string gzipCompress(const char *data, const size_t ndata)
+std::string gzipCompress(const char *data, const size_t ndata, int level)
 {
-    z_stream strm = {nullptr,
-                     0,
-                     0,
-                     nullptr,
-                     0,
-                     0,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     0,
-                     0,
-                     0};
     if (data && ndata > 0)
     {
-        if (deflateInit2(&strm,
-                         Z_DEFAULT_COMPRESSION,
-                         Z_DEFLATED,
-                         MAX_WBITS + 16,
-                         8,
-                         Z_DEFAULT_STRATEGY) != Z_OK)
+        auto strm = drogon::internal::getGzipCompressStream(level);
+        if (!strm)
         {
             LOG_ERROR << "deflateInit2 error!";
             return std::string{};
         }
+        // The bound of the stream, with the gzip wrapper, lets it finish in
+        // one call
         std::string outstr;
-        outstr.resize(compressBound(static_cast<uLong>(ndata)));
-        strm.next_in = (Bytef *)data;
-        strm.avail_in = static_cast<uInt>(ndata);
-        int ret;
-        do
+        outstr.resize(deflateBound(strm, static_cast<uLong>(ndata)));
+        strm->next_in = (Bytef *)data;
+        strm->avail_in = static_cast<uInt>(ndata);
+        strm->next_out = (Bytef *)outstr.data();
+        strm->avail_out = static_cast<uInt>(outstr.size());
+        auto ret = deflate(strm, Z_FINISH);
+        if (ret != Z_STREAM_END)
         {
-            if (strm.total_out >= outstr.size())
-            {
-                outstr.resize(strm.total_out * 2);
-            }
-            assert(outstr.size() >= strm.total_out);
-            strm.avail_out = static_cast<uInt>(outstr.size() - strm.total_out);
-            strm.next_out = (Bytef *)outstr.data() + strm.total_out;
-            ret = deflate(&strm, Z_FINISH); /* no bad return value */
-            if (ret == Z_STREAM_ERROR)
-            {
-                (void)deflateEnd(&strm);
-                return std::string{};
-            }
-        } while (strm.avail_out == 0);
-        assert(strm.avail_in == 0);
-        assert(ret == Z_STREAM_END); /* stream will be complete */
-        outstr.resize(strm.total_out);
-        /* clean up and return */
-        (void)deflateEnd(&strm);
+            LOG_ERROR << "deflate error: " << ret;
+            return std::string{};
+        }
+        outstr.resize(strm->total_out);
         return outstr;
     }
     return std::string{};
@@ -954,47 +827,43 @@ std::string gzipDecompress(const char *data, const size_t ndata)
     if (ndata == 0)
         return std::string(data, ndata);
 
-    auto full_length = ndata;
-
-    auto decompressed = std::string(full_length * 2, 0);
+    // A single gzip member ends with its size modulo 2^32, trusted up to a
+    // ratio so a forged one doesn't allocate much
+    size_t outSize = ndata * 2;
+    if (ndata >= 18 && static_cast<unsigned char>(data[0]) == 0x1f &&
+        static_cast<unsigned char>(data[1]) == 0x8b)
+    {
+        auto trailer = reinterpret_cast<const unsigned char *>(data) + ndata;
+        size_t isize = static_cast<size_t>(trailer[-4]) |
+                       (static_cast<size_t>(trailer[-3]) << 8) |
+                       (static_cast<size_t>(trailer[-2]) << 16) |
+                       (static_cast<size_t>(trailer[-1]) << 24);
+        if (isize > 0 && isize <= ndata * 16)
+            outSize = isize;
+    }
+    auto decompressed = std::string(outSize, 0);
     bool done = false;
 
-    z_stream strm = {nullptr,
-                     0,
-                     0,
-                     nullptr,
-                     0,
-                     0,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     nullptr,
-                     0,
-                     0,
-                     0};
-    strm.next_in = (Bytef *)data;
-    strm.avail_in = static_cast<uInt>(ndata);
-    strm.total_out = 0;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    if (inflateInit2(&strm, (15 + 32)) != Z_OK)
+    auto strm = drogon::internal::getGzipDecompressStream();
+    if (!strm)
     {
         LOG_ERROR << "inflateInit2 error!";
         return std::string{};
     }
+    strm->next_in = (Bytef *)data;
+    strm->avail_in = static_cast<uInt>(ndata);
     while (!done)
     {
         // Make sure we have enough room and reset the lengths.
-        if (strm.total_out >= decompressed.length())
+        if (strm->total_out >= decompressed.length())
         {
             decompressed.resize(decompressed.length() * 2);
         }
-        strm.next_out = (Bytef *)decompressed.data() + strm.total_out;
-        strm.avail_out =
-            static_cast<uInt>(decompressed.length() - strm.total_out);
+        strm->next_out = (Bytef *)decompressed.data() + strm->total_out;
+        strm->avail_out =
+            static_cast<uInt>(decompressed.length() - strm->total_out);
         // Inflate another chunk.
-        int status = inflate(&strm, Z_SYNC_FLUSH);
+        int status = inflate(strm, Z_SYNC_FLUSH);
         if (status == Z_STREAM_END)
         {
             done = true;
@@ -1004,12 +873,10 @@ std::string gzipDecompress(const char *data, const size_t ndata)
             break;
         }
     }
-    if (inflateEnd(&strm) != Z_OK)
-        return std::string{};
     // Set real length.
     if (done)
     {
-        decompressed.resize(strm.total_out);
+        decompressed.resize(strm->total_out);
         return decompressed;
     }
     else
@@ -1017,125 +884,6 @@ std::string gzipDecompress(const char *data, const size_t ndata)
         return std::string{};
     }
 }
-
-char *getHttpFullDate(const trantor::Date &date)
-{
-    static thread_local int64_t lastSecond = 0;
-    static thread_local char lastTimeString[128] = {0};
-    auto nowSecond =
-        date.microSecondsSinceEpoch() / trantor::Date::MICRO_SECONDS_PER_SEC;
-    if (nowSecond == lastSecond)
-    {
-        return lastTimeString;
-    }
-    lastSecond = nowSecond;
-    date.toCustomFormattedString("%a, %d %b %Y %H:%M:%S GMT",
-                                 lastTimeString,
-                                 sizeof(lastTimeString));
-    return lastTimeString;
-}
-
-void dateToCustomFormattedString(const std::string &fmtStr,
-                                 std::string &str,
-                                 const trantor::Date &date)
-{
-    auto nowSecond =
-        date.microSecondsSinceEpoch() / trantor::Date::MICRO_SECONDS_PER_SEC;
-    struct tm tm_LValue = date.tmStruct();
-    std::stringstream Out;
-    Out.imbue(std::locale{"C"});
-    Out << std::put_time(&tm_LValue, fmtStr.c_str());
-    str = Out.str();
-}
-
-const std::string &getHttpFullDateStr(const trantor::Date &date)
-{
-    static thread_local int64_t lastSecond = 0;
-    static thread_local std::string lastTimeString(128, 0);
-    auto nowSecond =
-        date.microSecondsSinceEpoch() / trantor::Date::MICRO_SECONDS_PER_SEC;
-    if (nowSecond == lastSecond)
-    {
-        return lastTimeString;
-    }
-    lastSecond = nowSecond;
-    dateToCustomFormattedString("%a, %d %b %Y %H:%M:%S GMT",
-                                lastTimeString,
-                                date);
-    return lastTimeString;
-}
-
-trantor::Date getHttpDate(const std::string &httpFullDateString)
-{
-    static const std::array<const char *, 4> formats = {
-        // RFC822 (default)
-        "%a, %d %b %Y %H:%M:%S",
-        // RFC 850 (deprecated)
-        "%a, %d-%b-%y %H:%M:%S",
-        // ansi asctime format
-        "%a %b %d %H:%M:%S %Y",
-        // weird RFC 850-hybrid thing that reddit uses
-        "%a, %d-%b-%Y %H:%M:%S",
-    };
-    struct tm tmptm;
-    for (const char *format : formats)
-    {
-        if (strptime(httpFullDateString.c_str(), format, &tmptm) != NULL)
-        {
-            auto epoch = timegm(&tmptm);
-            return trantor::Date(epoch * trantor::Date::MICRO_SECONDS_PER_SEC);
-        }
-    }
-    LOG_WARN << "invalid datetime format: '" << httpFullDateString << "'";
-    return trantor::Date((std::numeric_limits<int64_t>::max)());
-}
-
-std::string formattedString(const char *format, ...)
-{
-    std::string strBuffer(128, 0);
-    va_list ap, backup_ap;
-    va_start(ap, format);
-    va_copy(backup_ap, ap);
-    auto result = vsnprintf((char *)strBuffer.data(),
-                            strBuffer.size(),
-                            format,
-                            backup_ap);
-    va_end(backup_ap);
-    if ((result >= 0) && ((std::string::size_type)result < strBuffer.size()))
-    {
-        strBuffer.resize(result);
-    }
-    else
-    {
-        while (true)
-        {
-            if (result < 0)
-            {
-                // Older snprintf() behavior. Just try doubling the buffer size
-                strBuffer.resize(strBuffer.size() * 2);
-            }
-            else
-            {
-                strBuffer.resize(result + 1);
-            }
-
-            va_copy(backup_ap, ap);
-            auto result = vsnprintf((char *)strBuffer.data(),
-                                    strBuffer.size(),
-                                    format,
-                                    backup_ap);
-            va_end(backup_ap);
-
-            if ((result >= 0) &&
-                ((std::string::size_type)result < strBuffer.size()))
-            {
-                strBuffer.resize(result);
-                break;
-            }
-        }
-    }
-    va_end(ap);
-    return strBuffer;
 }
 
 int createPath(const std::string &path)
@@ -1157,14 +905,14 @@ int createPath(const std::string &path)
     return 0;
 }
 #ifdef USE_BROTLI
-std::string brotliCompress(const char *data, const size_t ndata)
+std::string brotliCompress(const char *data, const size_t ndata, int quality)
 {
     std::string ret;
     if (ndata == 0)
         return ret;
     ret.resize(BrotliEncoderMaxCompressedSize(ndata));
     size_t encodedSize{ret.size()};
-    auto r = BrotliEncoderCompress(5,
+    auto r = BrotliEncoderCompress(quality,
                                    BROTLI_DEFAULT_WINDOW,
                                    BROTLI_DEFAULT_MODE,
                                    ndata,
@@ -1217,7 +965,9 @@ std::string brotliDecompress(const char *data, const size_t ndata)
     return decompressed;
 }
 #else
-std::string brotliCompress(const char * /*data*/, const size_t /*ndata*/)
+std::string brotliCompress(const char * /*data*/,
+                           const size_t /*ndata*/,
+                           int /*quality*/)
 {
     LOG_ERROR << "If you do not have the brotli package installed, you cannot "
                  "use brotliCompress()";
@@ -1232,6 +982,103 @@ std::string brotliDecompress(const char * /*data*/, const size_t /*ndata*/)
 }
 #endif
 
+#ifdef USE_ZSTD
+std::string zstdCompress(const char *data,
+                         const size_t ndata,
+                         int level,
+                         std::string_view dictionary)
+{
+    std::string ret;
+    if (ndata == 0)
+        return ret;
+    auto cctx = drogon::internal::getZstdCompressContext(level, dictionary);
+    if (!cctx)
+    {
+        LOG_ERROR << "Failed to create the zstd compression context!";
+        return ret;
+    }
+    ret.resize(ZSTD_compressBound(ndata));
+    auto r = ZSTD_compress2(cctx, ret.data(), ret.size(), data, ndata);
+    if (ZSTD_isError(r))
+    {
+        LOG_ERROR << "zstd compression error: " << ZSTD_getErrorName(r);
+        ret.resize(0);
+    }
+    else
+        ret.resize(r);
+    return ret;
+}
+
+std::string zstdDecompress(const char *data,
+                           const size_t ndata,
+                           std::string_view dictionary)
+{
+    if (ndata == 0)
+        return std::string(data, ndata);
+    auto dctx = drogon::internal::getZstdDecompressContext(dictionary);
+    if (!dctx)
+    {
+        LOG_ERROR << "Failed to create the zstd decompression context!";
+        return std::string{};
+    }
+    // The frame header usually records the size of the content
+    auto contentSize = ZSTD_getFrameContentSize(data, ndata);
+    auto decompressed = std::string(
+        (contentSize != ZSTD_CONTENTSIZE_UNKNOWN &&
+         contentSize != ZSTD_CONTENTSIZE_ERROR && contentSize > 0)
+            ? static_cast<size_t>(contentSize)
+            : ndata * 3,
+        0);
+    ZSTD_inBuffer input{data, ndata, 0};
+    ZSTD_outBuffer output{decompressed.data(), decompressed.size(), 0};
+    size_t r = 0;
+    while (true)
+    {
+        r = ZSTD_decompressStream(dctx, &output, &input);
+        if (ZSTD_isError(r))
+        {
+            LOG_ERROR << "zstd decompression error: " << ZSTD_getErrorName(r);
+            return std::string{};
+        }
+        // 0 means a frame is complete, following frames are decoded too
+        if (input.pos == input.size && (r == 0 || output.pos < output.size))
+            break;
+        if (output.pos == output.size)
+        {
+            decompressed.resize(decompressed.size() * 2);
+            output.dst = decompressed.data();
+            output.size = decompressed.size();
+        }
+    }
+    if (r != 0)
+    {
+        LOG_ERROR << "zstd decompression error: truncated input";
+        return std::string{};
+    }
+    decompressed.resize(output.pos);
+    return decompressed;
+}
+#else
+std::string zstdCompress(const char * /*data*/,
+                         const size_t /*ndata*/,
+                         int /*level*/,
+                         std::string_view /*dictionary*/)
+{
+    LOG_ERROR << "If you do not have the zstd package installed, you cannot "
+                 "use zstdCompress()";
+    abort();
+}
+
+std::string zstdDecompress(const char * /*data*/,
+                           const size_t /*ndata*/,
+                           std::string_view /*dictionary*/)
+{
+    LOG_ERROR << "If you do not have the zstd package installed, you cannot "
+                 "use zstdDecompress()";
+    abort();
+}
+#endif
+
 std::string getMd5(const char *data, const size_t dataLen)
 {
     return trantor::utils::toHexString(trantor::utils::md5(data, dataLen));
@@ -1274,7 +1121,7 @@ bool supportsTls() noexcept
 
 bool secureRandomBytes(void *ptr, size_t size)
 {
-    return trantor::utils::secureRandomBytes(ptr, size);
+    return ChaChaRandom::instance().fill(ptr, size);
 }
 
 std::string secureRandomString(size_t size)
@@ -1290,26 +1137,9 @@ std::string secureRandomString(size_t size)
         "+-";
     assert(chars.size() == 64);
 
-    // batch up to 32 bytes of random data for efficiency. Calling
-    // secureRandomBytes can be expensive.
-    auto randByte = []() {
-        thread_local trantor::utils::Hash256 hash;
-        thread_local size_t i = 0;
-        if (i == 0)
-        {
-            bool ok = trantor::utils::secureRandomBytes(&hash, sizeof(hash));
-            if (!ok)
-                throw std::runtime_error(
-                    "Failed to generate random bytes for secureRandomString");
-        }
-        unsigned char *hashBytes = reinterpret_cast<unsigned char *>(&hash);
-        auto ret = hashBytes[i];
-        i = (i + 1) % sizeof(hash);
-        return ret;
-    };
-
-    for (size_t i = 0; i < size; ++i)
-        ret[i] = chars[randByte() % 64];
+    fillRandom(&ret[0], size);
+    for (auto &c : ret)
+        c = chars[static_cast<unsigned char>(c) % 64];
     return ret;
 }
 
@@ -0,0 +1,131 @@
+/**
+ *
+ *  @file WebSocketBroadcastGroup.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/WebSocketBroadcastGroup.h>
+#include "WebSocketConnectionImpl.h"
+#include <vector>
+
+using namespace drogon;
+
+struct WebSocketBroadcastGroup::Bucket
+{
+    std::mutex mutex;
+    std::unordered_map<WebSocketConnection *, WebSocketConnectionPtr>
+        connections;
+
+    void send(const WebSocketFrame &frame)
+    {
+        // Sending may close a connection and remove it from the group, so the
+        // connections are not sent the frame under the lock.
+        std::vector<WebSocketConnectionPtr> targets;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            targets.reserve(connections.size());
+            for (auto iter = connections.begin(); iter != connections.end();)
+            {
+                if (!iter->second->connected())
+                {
+                    iter = connections.erase(iter);
+                    continue;
+                }
+                targets.push_back(iter->second);
+                ++iter;
+            }
+        }
+        for (auto &conn : targets)
+        {
+            if (auto impl = dynamic_cast<WebSocketConnectionImpl *>(conn.get()))
+            {
+                impl->sendFrame(frame);
+            }
+            else
+            {
+                conn->send(frame.buffer->peek() + frame.headerLength,
+                           frame.buffer->readableBytes() - frame.headerLength,
+                           frame.type);
+            }
+        }
+    }
+};
+
+/// The loop of a connection, nullptr if it is not a drogon connection
+static trantor::EventLoop *loopOf(const WebSocketConnectionPtr &conn)
+{
+    auto impl = dynamic_cast<WebSocketConnectionImpl *>(conn.get());
+    return impl ? impl->getLoop() : nullptr;
+}
+
+void WebSocketBroadcastGroup::add(const WebSocketConnectionPtr &conn)
+{
+    BucketPtr bucket;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &ptr = buckets_[loopOf(conn)];
+        if (!ptr)
+            ptr = std::make_shared<Bucket>();
+        bucket = ptr;
+    }
+    std::lock_guard<std::mutex> lock(bucket->mutex);
+    bucket->connections.emplace(conn.get(), conn);
+}
+
+void WebSocketBroadcastGroup::remove(const WebSocketConnectionPtr &conn)
+{
+    BucketPtr bucket;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = buckets_.find(loopOf(conn));
+        if (iter == buckets_.end())
+            return;
+        bucket = iter->second;
+    }
+    std::lock_guard<std::mutex> lock(bucket->mutex);
+    bucket->connections.erase(conn.get());
+}
+
+size_t WebSocketBroadcastGroup::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (auto &pair : buckets_)
+    {
+        std::lock_guard<std::mutex> bucketLock(pair.second->mutex);
+        count += pair.second->connections.size();
+    }
+    return count;
+}
+
+void WebSocketBroadcastGroup::broadcast(std::string_view message,
+                                        WebSocketMessageType type)
+{
+    std::vector<std::pair<trantor::EventLoop *, BucketPtr>> buckets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buckets.assign(buckets_.begin(), buckets_.end());
+    }
+    if (buckets.empty())
+        return;
+    auto frame = WebSocketConnectionImpl::makeFrame(message.data(),
+                                                    message.size(),
+                                                    type);
+    for (auto &[loop, bucket] : buckets)
+    {
+        if (!loop)
+        {
+            bucket->send(frame);
+            continue;
+        }
+        loop->runInLoop(
+            [bucket = std::move(bucket), frame]() { bucket->send(frame); });
+    }
+}
@@ -13,6 +13,7 @@
  */
 
 #include "WebSocketClientImpl.h"
+#include "DnsCache.h"
 #include "HttpResponseImpl.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseParser.h"
@@ -23,6 +24,7 @@
 #include <drogon/config.h>
 #include <trantor/net/InetAddress.h>
 #include <trantor/utils/Utilities.h>
+#include <limits>
 
 using namespace drogon;
 using namespace trantor;
@@ -54,14 +56,18 @@ void WebSocketClientImpl::createTcpClient()
         std::make_shared<trantor::TcpClient>(loop_, serverAddr_, "httpClient");
     if (useSSL_)
     {
-        auto policy = trantor::TLSPolicy::defaultClientPolicy();
-        policy->setUseOldTLS(useOldTLS_)
-            .setValidate(validateCert_)
-            .setHostname(domain_)
-            .setConfCmds(sslConfCmds_)
-            .setCertPath(clientCertPath_)
-            .setKeyPath(clientKeyPath_);
-        tcpClientPtr_->enableSSL(std::move(policy));
+        // Shared by the reconnections of the client
+        if (!tlsPolicy_)
+        {
+            tlsPolicy_ = trantor::TLSPolicy::defaultClientPolicy();
+            tlsPolicy_->setUseOldTLS(useOldTLS_)
+                .setValidate(validateCert_)
+                .setHostname(domain_)
+                .setConfCmds(sslConfCmds_)
+                .setCertPath(clientCertPath_)
+                .setKeyPath(clientKeyPath_);
+        }
+        tcpClientPtr_->enableSSL(tlsPolicy_);
     }
     auto thisPtr = shared_from_this();
     std::weak_ptr<WebSocketClientImpl> weakPtr = thisPtr;
@@ -144,6 +150,20 @@ void WebSocketClientImpl::connectToServerInLoop()
     wsAccept_ = utils::base64Encode(accKey, 20);
 
     upgradeRequest_->addHeader("Sec-WebSocket-Key", wsKey_);
+    compressionOffered_ = false;
+    if (compressionOptions_.enabled)
+    {
+        auto offer = WebSocketDeflate::makeOffer(compressionOptions_);
+        if (!offer.empty())
+        {
+            upgradeRequest_->addHeader("Sec-WebSocket-Extensions", offer);
+            compressionOffered_ = true;
+        }
+        else
+        {
+            LOG_WARN << "The memory limit is too low for permessage-deflate";
+        }
+    }
     // upgradeRequest_->addHeader("Sec-WebSocket-Version","13");
 
     assert(!tcpClientPtr_);
@@ -165,34 +185,25 @@ void WebSocketClientImpl::connectToServerInLoop()
     if (serverAddr_.ipNetEndian() == 0 && !hasIpv6Address && !domain_.empty() &&
         serverAddr_.portNetEndian() != 0)
     {
-        if (!resolver_)
-        {
-            resolver_ = trantor::Resolver::newResolver(loop_);
-        }
-        resolver_->resolve(
+        DnsCache::instance().resolve(
             domain_,
-            [thisPtr = shared_from_this(),
-             hasIpv6Address](const trantor::InetAddress &addr) {
-                thisPtr->loop_->runInLoop([thisPtr, addr, hasIpv6Address]() {
-                    auto port = thisPtr->serverAddr_.portNetEndian();
-                    thisPtr->serverAddr_ = addr;
-                    thisPtr->serverAddr_.setPortNetEndian(port);
-                    LOG_TRACE << "dns:domain=" << thisPtr->domain_
-                              << ";ip=" << thisPtr->serverAddr_.toIp();
-                    if ((thisPtr->serverAddr_.ipNetEndian() != 0 ||
-                         hasIpv6Address) &&
-                        thisPtr->serverAddr_.portNetEndian() != 0)
-                    {
-                        thisPtr->createTcpClient();
-                    }
-                    else
-                    {
-                        thisPtr->requestCallback_(ReqResult::BadServerAddress,
-                                                  nullptr,
-                                                  thisPtr);
-                        return;
-                    }
-                });
+            loop_,
+            [thisPtr = shared_from_this()](
+                const std::vector<trantor::InetAddress> &addrs) {
+                if (addrs.empty())
+                {
+                    thisPtr->requestCallback_(ReqResult::BadServerAddress,
+                                              nullptr,
+                                              thisPtr);
+                    return;
+                }
+                // The first address in the order of RFC 8305
+                auto port = thisPtr->serverAddr_.portNetEndian();
+                thisPtr->serverAddr_ = addrs.front();
+                thisPtr->serverAddr_.setPortNetEndian(port);
+                LOG_TRACE << "dns:domain=" << thisPtr->domain_
+                          << ";ip=" << thisPtr->serverAddr_.toIp();
+                thisPtr->createTcpClient();
             });
         return;
     }
@@ -248,9 +259,24 @@ void WebSocketClientImpl::onRecvMessage(
         auto resp = responseParser->responseImpl();
         responseParser->reset();
         auto acceptStr = resp->getHeaderBy("sec-websocket-accept");
+        auto &extension = resp->getHeaderBy("sec-websocket-extensions");
+        std::unique_ptr<WebSocketDeflate> deflate;
+        if (!extension.empty() && compressionOffered_)
+        {
+            WebSocketDeflateParams params;
+            if (WebSocketDeflate::parseResponse(extension, params))
+            {
+                deflate = std::make_unique<WebSocketDeflate>(
+                    params,
+                    compressionOptions_,
+                    false,
+                    (std::numeric_limits<size_t>::max)());
+            }
+        }
 
         if (resp->statusCode() != k101SwitchingProtocols ||
-            acceptStr != wsAccept_)
+            acceptStr != wsAccept_ ||
+            (!extension.empty() && !(deflate && deflate->ok())))
         {
             requestCallback_(ReqResult::BadResponse,
                              nullptr,
@@ -276,22 +302,49 @@ void WebSocketClientImpl::onRecvMessage(
         {
             resp->brDecompress();
         }
+#endif
+#ifdef USE_ZSTD
+        else if (coding == "zstd")
+        {
+            resp->zstdDecompress();
+        }
 #endif
         upgraded_ = true;
         websockConnPtr_ =
             std::make_shared<WebSocketConnectionImpl>(connPtr, false);
+        if (deflate)
+        {
+            websockConnPtr_->setDeflate(std::move(deflate));
+        }
         websockConnPtr_->setPingMessage("", std::chrono::seconds{30});
         auto thisPtr = shared_from_this();
         std::weak_ptr<WebSocketClientImpl> weakPtr = thisPtr;
-        websockConnPtr_->setMessageCallback(
-            [weakPtr](std::string &&message,
-                      const WebSocketConnectionImplPtr &,
-                      const WebSocketMessageType &type) {
-                auto thisPtr = weakPtr.lock();
-                if (!thisPtr)
-                    return;
-                thisPtr->messageCallback_(std::move(message), thisPtr, type);
-            });
+        if (messageViewCallback_)
+        {
+            websockConnPtr_->setMessageViewCallback(
+                [weakPtr](std::string_view message,
+                          const WebSocketConnectionImplPtr &,
+                          const WebSocketMessageType &type) {
+                    auto thisPtr = weakPtr.lock();
+                    if (!thisPtr)
+                        return;
+                    thisPtr->messageViewCallback_(message, thisPtr, type);
+                });
+        }
+        else
+        {
+            websockConnPtr_->setMessageCallback(
+                [weakPtr](std::string &&message,
+                          const WebSocketConnectionImplPtr &,
+                          const WebSocketMessageType &type) {
+                    auto thisPtr = weakPtr.lock();
+                    if (!thisPtr)
+                        return;
+                    thisPtr->messageCallback_(std::move(message),
+                                              thisPtr,
+                                              type);
+                });
+        }
         requestCallback_(ReqResult::Ok, resp, thisPtr);
         if (msgBuffer->readableBytes() > 0)
         {
@@ -460,6 +513,7 @@ void WebSocketClientImpl::setCertPath(const std::string &cert,
 {
     clientCertPath_ = cert;
     clientKeyPath_ = key;
+    tlsPolicy_.reset();
 }
 
 void WebSocketClientImpl::addSSLConfigs(
@@ -469,6 +523,7 @@ void WebSocketClientImpl::addSSLConfigs(
     {
         sslConfCmds_.push_back(cmd);
     }
+    tlsPolicy_.reset();
 }
 
 WebSocketClientPtr WebSocketClient::newWebSocketClient(const std::string &ip,
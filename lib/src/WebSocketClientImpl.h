@@ -22,6 +22,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace drogon
 {
@@ -41,6 +42,15 @@ class WebSocketClientImpl
         messageCallback_ = callback;
     }
 
+    void setMessageViewHandler(
+        const std::function<void(std::string_view message,
+                                 const WebSocketClientPtr &,
+                                 const WebSocketMessageType &)> &callback)
+        override
+    {
+        messageViewCallback_ = callback;
+    }
+
     void setConnectionClosedHandler(
         const std::function<void(const WebSocketClientPtr &)> &callback)
         override
@@ -56,6 +66,12 @@ class WebSocketClientImpl
     void addSSLConfigs(const std::vector<std::pair<std::string, std::string>>
                            &sslConfCmds) override;
 
+    void setCompressionOptions(
+        const WebSocketCompressionOptions &options) override
+    {
+        compressionOptions_ = options;
+    }
+
     trantor::EventLoop *getLoop() override
     {
         return loop_;
@@ -91,6 +107,9 @@ class WebSocketClientImpl
     std::string clientCertPath_;
     std::string clientKeyPath_;
     std::vector<std::pair<std::string, std::string>> sslConfCmds_;
+    std::shared_ptr<trantor::TLSPolicy> tlsPolicy_;
+    WebSocketCompressionOptions compressionOptions_;
+    bool compressionOffered_{false};
 
     HttpRequestPtr upgradeRequest_;
     std::function<void(std::string &&,
@@ -99,6 +118,10 @@ class WebSocketClientImpl
         messageCallback_ = [](std::string &&,
                               const WebSocketClientPtr &,
                               const WebSocketMessageType &) {};
+    std::function<void(std::string_view,
+                       const WebSocketClientPtr &,
+                       const WebSocketMessageType &)>
+        messageViewCallback_;
     std::function<void(const WebSocketClientPtr &)> connectionClosedCallback_ =
         [](const WebSocketClientPtr &) {};
     WebSocketRequestCallback requestCallback_;
@@ -111,7 +134,6 @@ class WebSocketClientImpl
                          trantor::MsgBuffer *);
     void reconnect();
     void createTcpClient();
-    std::shared_ptr<trantor::Resolver> resolver_;
 };
 
 }  // namespace drogon
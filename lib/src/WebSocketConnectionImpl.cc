@@ -14,19 +14,36 @@
 
 #include "WebSocketConnectionImpl.h"
 #include "HttpAppFrameworkImpl.h"
+#include "MsgBufferPool.h"
+#include "WebSocketMask.h"
 #include <json/value.h>
 #include <json/writer.h>
+#include <cmath>
 #include <thread>
 #include <limits>
 
 using namespace drogon;
 
+namespace
+{
+const std::shared_ptr<const WebSocketCallbacks> &defaultCallbacks()
+{
+    static const auto callbacks = std::make_shared<const WebSocketCallbacks>();
+    return callbacks;
+}
+
+bool sameAddress(const trantor::InetAddress &a, const trantor::InetAddress &b)
+{
+    return a.isIpV6() == b.isIpV6() && a.toPort() == b.toPort() &&
+           a.toIp() == b.toIp();
+}
+}  // namespace
+
 WebSocketConnectionImpl::WebSocketConnectionImpl(
     const trantor::TcpConnectionPtr &conn,
     bool isServer)
     : tcpConnectionPtr_(conn),
-      localAddr_(conn->localAddr()),
-      peerAddr_(conn->peerAddr()),
+      callbacks_(defaultCallbacks()),
       isServer_(isServer),
       usingMask_(false)
 {
@@ -34,82 +51,183 @@ WebSocketConnectionImpl::WebSocketConnectionImpl(
 
 WebSocketConnectionImpl::~WebSocketConnectionImpl()
 {
-    shutdown();
+    // No ping is scheduled, it would keep the connection
+    sendClose(CloseCode::kNormalClosure, "");
 }
 
-void WebSocketConnectionImpl::send(const char *msg,
-                                   uint64_t len,
-                                   const WebSocketMessageType type)
+static unsigned char toOpcode(WebSocketMessageType type, uint64_t len)
 {
-    unsigned char opcode;
-    if (type == WebSocketMessageType::Text)
-        opcode = 1;
-    else if (type == WebSocketMessageType::Binary)
-        opcode = 2;
-    else if (type == WebSocketMessageType::Close)
+    (void)len;
+    switch (type)
     {
-        assert(len <= 125);
-        opcode = 8;
+        case WebSocketMessageType::Text:
+            return 1;
+        case WebSocketMessageType::Binary:
+            return 2;
+        case WebSocketMessageType::Close:
+            assert(len <= 125);
+            return 8;
+        case WebSocketMessageType::Ping:
+            assert(len <= 125);
+            return 9;
+        case WebSocketMessageType::Pong:
+            assert(len <= 125);
+            return 10;
+        default:
+            assert(0);
+            return 0;
     }
-    else if (type == WebSocketMessageType::Ping)
+}
+
+/// Write the header of a frame without mask, return its length
+static size_t formatFrameHeader(char *header,
+                                uint64_t len,
+                                unsigned char firstByte)
+{
+    header[0] = static_cast<char>(firstByte);
+    if (len <= 125)
     {
-        assert(len <= 125);
-        opcode = 9;
+        header[1] = static_cast<char>(len);
+        return 2;
     }
-    else if (type == WebSocketMessageType::Pong)
+    if (len <= 65535)
     {
-        assert(len <= 125);
-        opcode = 10;
+        header[1] = 126;
+        header[2] = static_cast<char>((len >> 8) & 255);
+        header[3] = static_cast<char>(len & 255);
+        return 4;
     }
-    else
+    header[1] = 127;
+    for (int i = 0; i < 8; ++i)
     {
-        opcode = 0;
-        assert(0);
+        header[2 + i] = static_cast<char>((len >> (56 - 8 * i)) & 255);
     }
-    sendWsData(msg, len, opcode);
+    return 10;
 }
 
-void WebSocketConnectionImpl::sendWsData(const char *msg,
-                                         uint64_t len,
-                                         unsigned char opcode)
+WebSocketFrame WebSocketConnectionImpl::makeFrame(const char *msg,
+                                                  uint64_t len,
+                                                  WebSocketMessageType type)
 {
-    LOG_TRACE << "send " << len << " bytes";
-
-    // Format the frame
-    std::string bytesFormatted;
-    bytesFormatted.resize(len + 10);
-    bytesFormatted[0] = char(0x80 | (opcode & 0x0f));
+    WebSocketFrame frame;
+    frame.type = type;
+    frame.opcode = toOpcode(type, len);
+    char header[10];
+    frame.headerLength =
+        formatFrameHeader(header, len, 0x80 | (frame.opcode & 0x0f));
+    frame.buffer = MsgBufferPool::acquire(MsgBufferPool::Use::kFrame,
+                                          frame.headerLength + len);
+    frame.buffer->append(header, frame.headerLength);
+    frame.buffer->append(msg, len);
+    return frame;
+}
 
-    int indexStartRawData = -1;
+void WebSocketConnectionImpl::sendFrame(const WebSocketFrame &frame)
+{
+    if (isServer_)
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (!coalescing_)
+            tcpConnectionPtr_->send(frame.buffer);
+        else
+            appendPending(frame.buffer->peek(),
+                          frame.buffer->readableBytes());
+        return;
+    }
+    // The frames sent by a client are masked one by one
+    sendWsData(frame.buffer->peek() + frame.headerLength,
+               frame.buffer->readableBytes() - frame.headerLength,
+               frame.opcode);
+}
 
-    if (len <= 125)
+void WebSocketConnectionImpl::send(const char *msg,
+                                   uint64_t len,
+                                   const WebSocketMessageType type)
+{
+    auto opcode = toOpcode(type, len);
+    if (!deflate_)
     {
-        bytesFormatted[1] = static_cast<char>(len);
-        indexStartRawData = 2;
+        sendWsData(msg, len, opcode);
+        return;
     }
-    else if (len <= 65535)
+    std::string data;
+    std::lock_guard<std::mutex> lock(*deflateMutex_);
+    if (!formatMessage(data, msg, len, opcode))
     {
-        bytesFormatted[1] = 126;
-        bytesFormatted[2] = ((len >> 8) & 255);
-        bytesFormatted[3] = ((len) & 255);
-        LOG_TRACE << "bytes[2]=" << (size_t)bytesFormatted[2];
-        LOG_TRACE << "bytes[3]=" << (size_t)bytesFormatted[3];
-        indexStartRawData = 4;
+        LOG_ERROR << "Failed to compress a WebSocket message";
+        tcpConnectionPtr_->forceClose();
+        return;
     }
-    else
+    write(std::move(data));
+}
+
+void WebSocketConnectionImpl::sendBatch(
+    const std::vector<std::string_view> &messages,
+    const WebSocketMessageType type)
+{
+    std::string data;
+    std::unique_lock<std::mutex> lock;
+    if (deflate_)
+        lock = std::unique_lock<std::mutex>(*deflateMutex_);
+    for (auto &msg : messages)
+    {
+        if (!formatMessage(data,
+                           msg.data(),
+                           msg.length(),
+                           toOpcode(type, msg.length())))
+        {
+            LOG_ERROR << "Failed to compress a WebSocket message";
+            tcpConnectionPtr_->forceClose();
+            return;
+        }
+    }
+    if (!data.empty())
+        write(std::move(data));
+}
+
+bool WebSocketConnectionImpl::formatMessage(std::string &output,
+                                            const char *msg,
+                                            uint64_t len,
+                                            unsigned char opcode)
+{
+    if (deflate_ && opcode <= 2 && deflate_->shouldCompress(len))
     {
-        bytesFormatted[1] = 127;
-        bytesFormatted[2] = ((len >> 56) & 255);
-        bytesFormatted[3] = ((len >> 48) & 255);
-        bytesFormatted[4] = ((len >> 40) & 255);
-        bytesFormatted[5] = ((len >> 32) & 255);
-        bytesFormatted[6] = ((len >> 24) & 255);
-        bytesFormatted[7] = ((len >> 16) & 255);
-        bytesFormatted[8] = ((len >> 8) & 255);
-        bytesFormatted[9] = ((len) & 255);
-
-        indexStartRawData = 10;
+        std::string payload;
+        if (!deflate_->compress(msg, len, payload))
+            return false;
+        formatFrame(output, payload.data(), payload.length(), opcode, true);
+        return true;
     }
+    formatFrame(output, msg, len, opcode, false);
+    return true;
+}
+
+void WebSocketConnectionImpl::sendWsData(const char *msg,
+                                         uint64_t len,
+                                         unsigned char opcode,
+                                         bool compressed)
+{
+    std::string bytesFormatted;
+    formatFrame(bytesFormatted, msg, len, opcode, compressed);
+    write(std::move(bytesFormatted));
+}
+
+void WebSocketConnectionImpl::formatFrame(std::string &output,
+                                          const char *msg,
+                                          uint64_t len,
+                                          unsigned char opcode,
+                                          bool compressed)
+{
+    LOG_TRACE << "send " << len << " bytes";
+
+    // Format the frame
+    auto start = output.length();
+    output.resize(start + len + 10);
+    size_t indexStartRawData =
+        start + formatFrameHeader(&output[start],
+                                  len,
+                                  0x80 | (compressed ? 0x40 : 0) |
+                                      (opcode & 0x0f));
     if (!isServer_)
     {
         int random;
@@ -145,21 +263,75 @@ void WebSocketConnectionImpl::sendWsData(const char *msg,
             }
         }
 
-        bytesFormatted[1] = (bytesFormatted[1] | 0x80);
-        bytesFormatted.resize(indexStartRawData + 4 + len);
-        memcpy(&bytesFormatted[indexStartRawData], &random, sizeof(random));
-        for (size_t i = 0; i < len; ++i)
-        {
-            bytesFormatted[indexStartRawData + 4 + i] =
-                (msg[i] ^ bytesFormatted[indexStartRawData + (i % 4)]);
-        }
+        output[start + 1] = (output[start + 1] | 0x80);
+        output.resize(indexStartRawData + 4 + len);
+        memcpy(&output[indexStartRawData], &random, sizeof(random));
+        websocket_mask::apply(&output[indexStartRawData + 4],
+                              msg,
+                              len,
+                              &output[indexStartRawData]);
+    }
+    else
+    {
+        output.resize(indexStartRawData);
+        output.append(msg, len);
     }
+}
+
+void WebSocketConnectionImpl::write(std::string &&data)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    if (!coalescing_)
+        tcpConnectionPtr_->send(std::move(data));
     else
+        appendPending(data.data(), data.length());
+}
+
+void WebSocketConnectionImpl::appendPending(const char *data, size_t len)
+{
+    if (coalescing_->frames.empty())
     {
-        bytesFormatted.resize(indexStartRawData);
-        bytesFormatted.append(msg, len);
+        // The first frame schedules the flush of the ones which follow it
+        auto flush = [weakSelf = weak_from_this()]() {
+            if (auto self = weakSelf.lock())
+                self->flush();
+        };
+        if (coalescing_->window == 0)
+            getLoop()->queueInLoop(std::move(flush));
+        else
+            getLoop()->runAfter(coalescing_->window, std::move(flush));
     }
-    tcpConnectionPtr_->send(std::move(bytesFormatted));
+    coalescing_->frames.append(data, len);
+}
+
+void WebSocketConnectionImpl::sendPending()
+{
+    if (!coalescing_ || coalescing_->frames.empty())
+        return;
+    tcpConnectionPtr_->send(std::move(coalescing_->frames));
+    coalescing_->frames.clear();
+}
+
+void WebSocketConnectionImpl::flush()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    sendPending();
+}
+
+void WebSocketConnectionImpl::enableCoalescing(
+    const std::chrono::microseconds &window)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    if (!coalescing_)
+        coalescing_ = std::make_unique<Coalescing>();
+    coalescing_->window = std::chrono::duration<double>(window).count();
+}
+
+void WebSocketConnectionImpl::disableCoalescing()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    sendPending();
+    coalescing_.reset();
 }
 
 void WebSocketConnectionImpl::send(const std::string_view msg,
@@ -191,14 +363,30 @@ void WebSocketConnectionImpl::sendJson(const Json::Value &json,
     send(msg.data(), msg.length(), type);
 }
 
+void WebSocketConnectionImpl::setAddresses(const trantor::InetAddress &local,
+                                           const trantor::InetAddress &peer)
+{
+    if (sameAddress(local, tcpConnectionPtr_->localAddr()) &&
+        sameAddress(peer, tcpConnectionPtr_->peerAddr()))
+    {
+        addresses_.reset();
+        return;
+    }
+    addresses_ = std::make_unique<Addresses>(Addresses{local, peer});
+}
+
 const trantor::InetAddress &WebSocketConnectionImpl::localAddr() const
 {
-    return localAddr_;
+    if (addresses_)
+        return addresses_->local;
+    return tcpConnectionPtr_->localAddr();
 }
 
 const trantor::InetAddress &WebSocketConnectionImpl::peerAddr() const
 {
-    return peerAddr_;
+    if (addresses_)
+        return addresses_->peer;
+    return tcpConnectionPtr_->peerAddr();
 }
 
 bool WebSocketConnectionImpl::connected() const
@@ -215,7 +403,13 @@ void WebSocketConnectionImpl::WebSocketConnectionImpl::shutdown(
     const CloseCode code,
     const std::string &reason)
 {
-    tcpConnectionPtr_->getLoop()->invalidateTimer(pingTimerId_);
+    disablePing();
+    sendClose(code, reason);
+}
+
+void WebSocketConnectionImpl::sendClose(CloseCode code,
+                                        const std::string &reason)
+{
     if (!tcpConnectionPtr_->connected())
         return;
     std::string message;
@@ -225,6 +419,7 @@ void WebSocketConnectionImpl::WebSocketConnectionImpl::shutdown(
     if (!reason.empty())
         memcpy(&message[2], reason.data(), reason.length());
     send(message, WebSocketMessageType::Close);
+    flush();
     tcpConnectionPtr_->shutdown();
 }
 
@@ -268,11 +463,26 @@ void WebSocketConnectionImpl::disablePing()
 bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
 {
     // According to the rfc6455
-    gotAll_ = false;
+    if (gotAll_)
+    {
+        // The last message has been handled
+        buffer->retrieve(frameLength_);
+        frameLength_ = 0;
+        frameData_ = {};
+        message_.clear();
+        gotAll_ = false;
+    }
     while (buffer->readableBytes() >= 2)
     {
         unsigned char opcode = (*buffer)[0] & 0x0f;
+        bool isCompressed = (((*buffer)[0] & 0x40) == 0x40);
         bool isControlFrame = false;
+        if (isCompressed && (!compressionEnabled_ || opcode == 0 || opcode > 2))
+        {
+            // rfc7692-6.1, only the first frame of a data message has RSV1
+            LOG_ERROR << "Bad frame: unexpected RSV1 bit";
+            return false;
+        }
         switch (opcode)
         {
             case 0:
@@ -280,9 +490,11 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
                 break;
             case 1:
                 type_ = WebSocketMessageType::Text;
+                compressed_ = isCompressed;
                 break;
             case 2:
                 type_ = WebSocketMessageType::Binary;
+                compressed_ = isCompressed;
                 break;
             case 8:
                 type_ = WebSocketMessageType::Close;
@@ -383,12 +595,22 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
                 auto masks = buffer->peek() + indexFirstMask;
                 auto indexFirstDataByte = indexFirstMask + 4;
                 auto rawData = buffer->peek() + indexFirstDataByte;
-                auto oldLen = message_.length();
-                message_.resize(oldLen + length);
-                for (size_t i = 0; i < length; ++i)
+                if (isFin && message_.empty())
                 {
-                    message_[oldLen + i] = (rawData[i] ^ masks[i % 4]);
+                    // Unmask a single frame message in place
+                    auto data = const_cast<char *>(rawData);
+                    websocket_mask::apply(data, rawData, length, masks);
+                    frameData_ = std::string_view(data, length);
+                    frameLength_ = indexFirstDataByte + length;
+                    gotAll_ = true;
+                    return true;
                 }
+                auto oldLen = message_.length();
+                message_.resize(oldLen + length);
+                websocket_mask::apply(&message_[oldLen],
+                                      rawData,
+                                      length,
+                                      masks);
                 buffer->retrieve(indexFirstMask + 4 + length);
                 if (isFin)
                 {
@@ -407,6 +629,13 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
             if (buffer->readableBytes() >= (indexFirstMask + length))
             {
                 auto rawData = buffer->peek() + indexFirstMask;
+                if (isFin && message_.empty())
+                {
+                    frameData_ = std::string_view(rawData, length);
+                    frameLength_ = indexFirstMask + length;
+                    gotAll_ = true;
+                    return true;
+                }
                 message_.append(rawData, length);
                 buffer->retrieve(indexFirstMask + length);
                 if (isFin)
@@ -430,15 +659,33 @@ void WebSocketConnectionImpl::onNewMessage(
     trantor::MsgBuffer *buffer)
 {
     auto self = shared_from_this();
+    // Kept if a callback replaces them
+    auto callbacks = callbacks_;
     while (buffer->readableBytes() > 0)
     {
         auto success = parser_.parse(buffer);
         if (success)
         {
-            std::string message;
+            std::string_view message;
             WebSocketMessageType type;
             if (parser_.gotAll(message, type))
             {
+                // Only the decompressed messages are not in the parser
+                std::string decompressed;
+                bool owned = false;
+                if ((type == WebSocketMessageType::Text ||
+                     type == WebSocketMessageType::Binary) &&
+                    parser_.compressed())
+                {
+                    decompressed = parser_.takeMessage();
+                    if (!deflate_->decompress(decompressed))
+                    {
+                        connPtr->shutdown();
+                        return;
+                    }
+                    message = decompressed;
+                    owned = true;
+                }
                 if (type == WebSocketMessageType::Ping)
                 {
                     // ping
@@ -455,7 +702,17 @@ void WebSocketConnectionImpl::onNewMessage(
                 }
                 // LOG_TRACE << "new message received: " << message
                 //           << "\n(type=" << (int)type << ")";
-                messageCallback_(std::move(message), self, type);
+                if (callbacks->messageView)
+                {
+                    callbacks->messageView(message, self, type);
+                }
+                else
+                {
+                    callbacks->message(owned ? std::move(decompressed)
+                                             : parser_.takeMessage(),
+                                       self,
+                                       type);
+                }
             }
             else
             {
@@ -474,24 +731,41 @@ void WebSocketConnectionImpl::onNewMessage(
 
 void WebSocketConnectionImpl::disablePingInLoop()
 {
-    if (pingTimerId_ != trantor::InvalidTimerId)
-    {
-        tcpConnectionPtr_->getLoop()->invalidateTimer(pingTimerId_);
-    }
+    cancel();
+    pingSelf_.reset();
 }
 
 void WebSocketConnectionImpl::setPingMessageInLoop(
     std::string &&message,
     const std::chrono::duration<double> &interval)
 {
-    std::weak_ptr<WebSocketConnectionImpl> weakPtr = shared_from_this();
-    disablePingInLoop();
-    pingTimerId_ = tcpConnectionPtr_->getLoop()->runEvery(
-        interval.count(), [weakPtr, message = std::move(message)]() {
-            auto thisPtr = weakPtr.lock();
-            if (thisPtr)
-            {
-                thisPtr->send(message, WebSocketMessageType::Ping);
-            }
-        });
+    if (message.empty())
+        pingMessage_.reset();
+    else
+        pingMessage_ = std::make_unique<std::string>(std::move(message));
+    pingInterval_ = static_cast<float>(interval.count());
+    pingSelf_ = shared_from_this();
+    // The connections accepted together would ping in the same slot of the
+    // wheel forever, their first pings are spread over the last quarter of
+    // the interval so every turn sends a share of them
+    static thread_local uint32_t sequence = 0;
+    auto spread = std::fmod(++sequence * 0.6180339887, 1.0);
+    TimeoutWheel::instance(getLoop()).schedule(this,
+                                               pingInterval_ *
+                                                   (1 - spread / 4));
+}
+
+void WebSocketConnectionImpl::onTimeout()
+{
+    if (tcpConnectionPtr_->disconnected())
+    {
+        // The clients drop their connections without closing them
+        pingSelf_.reset();
+        return;
+    }
+    if (pingMessage_)
+        send(*pingMessage_, WebSocketMessageType::Ping);
+    else
+        send(std::string_view{}, WebSocketMessageType::Ping);
+    TimeoutWheel::instance(getLoop()).schedule(this, pingInterval_);
 }
@@ -15,8 +15,13 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include "TimeoutWheel.h"
+#include "WebSocketDeflate.h"
 #include <drogon/WebSocketConnection.h>
 #include <json/value.h>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/TcpConnection.h>
@@ -26,31 +31,99 @@ namespace drogon
 class WebSocketConnectionImpl;
 using WebSocketConnectionImplPtr = std::shared_ptr<WebSocketConnectionImpl>;
 
+/// A frame built once and sent to many connections
+struct WebSocketFrame
+{
+    std::shared_ptr<trantor::MsgBuffer> buffer;
+    size_t headerLength{0};
+    unsigned char opcode{0};
+    WebSocketMessageType type{WebSocketMessageType::Unknown};
+};
+
 class WebSocketMessageParser
 {
   public:
     bool parse(trantor::MsgBuffer *buffer);
 
-    bool gotAll(std::string &message, WebSocketMessageType &type)
+    /**
+     * @brief Get the message parsed by the last call of parse(), which is
+     * valid until the next call.
+     *
+     * A message of a single frame is unmasked in place and points to the
+     * buffer, only the fragmented messages are copied to be reassembled.
+     */
+    bool gotAll(std::string_view &message, WebSocketMessageType &type) const
     {
-        assert(message.empty());
         if (!gotAll_)
             return false;
-        message.swap(message_);
+        message = message_.empty() ? frameData_ : std::string_view(message_);
         type = type_;
         return true;
     }
 
+    /// The message got by gotAll() as a string, moved out of the parser when
+    /// it was reassembled
+    std::string takeMessage()
+    {
+        assert(gotAll_);
+        if (message_.empty())
+            return std::string(frameData_);
+        std::string message;
+        message.swap(message_);
+        return message;
+    }
+
+    /// Accept the frames with the RSV1 bit set (RFC7692)
+    void enableCompression()
+    {
+        compressionEnabled_ = true;
+    }
+
+    /// Whether the last data message is compressed
+    bool compressed() const
+    {
+        return compressed_;
+    }
+
   private:
     std::string message_;
+    // The data of the single frame message left in the buffer until the
+    // next parse()
+    std::string_view frameData_;
+    size_t frameLength_{0};
     WebSocketMessageType type_;
     bool gotAll_{false};
+    bool compressionEnabled_{false};
+    bool compressed_{false};
+};
+
+/**
+ * @brief The callbacks of the connections, a controller shares one set with
+ * all its connections.
+ */
+struct WebSocketCallbacks
+{
+    std::function<void(std::string &&,
+                       const WebSocketConnectionImplPtr &,
+                       const WebSocketMessageType &)>
+        message = [](std::string &&,
+                     const WebSocketConnectionImplPtr &,
+                     const WebSocketMessageType &) {};
+    /// Receives the messages as views, valid during the call, instead of the
+    /// strings of the message callback when it is set
+    std::function<void(std::string_view,
+                       const WebSocketConnectionImplPtr &,
+                       const WebSocketMessageType &)>
+        messageView;
+    std::function<void(const WebSocketConnectionImplPtr &)> close =
+        [](const WebSocketConnectionImplPtr &) {};
 };
 
 class WebSocketConnectionImpl final
     : public WebSocketConnection,
       public std::enable_shared_from_this<WebSocketConnectionImpl>,
-      public trantor::NonCopyable
+      public trantor::NonCopyable,
+      private TimeoutEntry
 {
   public:
     explicit WebSocketConnectionImpl(const trantor::TcpConnectionPtr &conn,
@@ -68,9 +141,20 @@ class WebSocketConnectionImpl final
         const Json::Value &json,
         const WebSocketMessageType type = WebSocketMessageType::Text) override;
 
+    void sendBatch(
+        const std::vector<std::string_view> &messages,
+        const WebSocketMessageType type = WebSocketMessageType::Text) override;
+    void enableCoalescing(const std::chrono::microseconds &window =
+                              std::chrono::microseconds::zero()) override;
+    void disableCoalescing() override;
+
     const trantor::InetAddress &localAddr() const override;
     const trantor::InetAddress &peerAddr() const override;
 
+    // The addresses of the client when a load balancer gave others
+    void setAddresses(const trantor::InetAddress &local,
+                      const trantor::InetAddress &peer);
+
     bool connected() const override;
     bool disconnected() const override;
 
@@ -83,49 +167,136 @@ class WebSocketConnectionImpl final
 
     void disablePing() override;
 
+    /// Share the callbacks with other connections, set before the first
+    /// message is received
+    void setCallbacks(std::shared_ptr<const WebSocketCallbacks> callbacks)
+    {
+        callbacks_ = std::move(callbacks);
+    }
+
+    // These copy the callbacks of the connection
     void setMessageCallback(
         const std::function<void(std::string &&,
                                  const WebSocketConnectionImplPtr &,
                                  const WebSocketMessageType &)> &callback)
     {
-        messageCallback_ = callback;
+        auto callbacks = std::make_shared<WebSocketCallbacks>(*callbacks_);
+        callbacks->message = callback;
+        callbacks_ = std::move(callbacks);
+    }
+
+    void setMessageViewCallback(
+        const std::function<void(std::string_view,
+                                 const WebSocketConnectionImplPtr &,
+                                 const WebSocketMessageType &)> &callback)
+    {
+        auto callbacks = std::make_shared<WebSocketCallbacks>(*callbacks_);
+        callbacks->messageView = callback;
+        callbacks_ = std::move(callbacks);
     }
 
     void setCloseCallback(
         const std::function<void(const WebSocketConnectionImplPtr &)> &callback)
     {
-        closeCallback_ = callback;
+        auto callbacks = std::make_shared<WebSocketCallbacks>(*callbacks_);
+        callbacks->close = callback;
+        callbacks_ = std::move(callbacks);
     }
 
     void onNewMessage(const trantor::TcpConnectionPtr &connPtr,
                       trantor::MsgBuffer *buffer);
 
+    /// Build an unmasked and uncompressed frame
+    static WebSocketFrame makeFrame(const char *msg,
+                                    uint64_t len,
+                                    WebSocketMessageType type);
+
+    /// Send a frame built by makeFrame(), shared by the server connections
+    void sendFrame(const WebSocketFrame &frame);
+
+    trantor::EventLoop *getLoop() const
+    {
+        return tcpConnectionPtr_->getLoop();
+    }
+
+    /**
+     * @brief Compress the messages with the negotiated permessage-deflate
+     * extension, must be called before any message is sent or received.
+     */
+    void setDeflate(std::unique_ptr<WebSocketDeflate> &&deflate)
+    {
+        deflate_ = std::move(deflate);
+        deflateMutex_ = std::make_unique<std::mutex>();
+        parser_.enableCompression();
+    }
+
     void onClose()
     {
-        if (pingTimerId_ != trantor::InvalidTimerId)
-            tcpConnectionPtr_->getLoop()->invalidateTimer(pingTimerId_);
-        closeCallback_(shared_from_this());
+        disablePingInLoop();
+        auto callbacks = callbacks_;
+        callbacks->close(shared_from_this());
     }
 
   private:
+    // An idle connection of a server is mostly this object, what only some
+    // of them use is allocated when it is first used
+    struct Addresses
+    {
+        trantor::InetAddress local;
+        trantor::InetAddress peer;
+    };
+
+    struct Coalescing
+    {
+        // The frames waiting for the flush
+        std::string frames;
+        double window{0};
+    };
+
     trantor::TcpConnectionPtr tcpConnectionPtr_;
-    trantor::InetAddress localAddr_;
-    trantor::InetAddress peerAddr_;
-    bool isServer_{true};
+    // Null when they are the ones of the TCP connection
+    std::unique_ptr<Addresses> addresses_;
+    std::shared_ptr<const WebSocketCallbacks> callbacks_;
     WebSocketMessageParser parser_;
-    trantor::TimerId pingTimerId_{trantor::InvalidTimerId};
-    std::vector<uint32_t> masks_;
+    // The pings are scheduled in the timeout wheel of the loop, which keeps
+    // the connection until they are disabled or the connection is closed.
+    // The message is null when it is empty.
+    std::unique_ptr<std::string> pingMessage_;
+    WebSocketConnectionImplPtr pingSelf_;
+    float pingInterval_{0};
+    bool isServer_{true};
     std::atomic<bool> usingMask_;
-
-    std::function<void(std::string &&,
-                       const WebSocketConnectionImplPtr &,
-                       const WebSocketMessageType &)>
-        messageCallback_ = [](std::string &&,
-                              const WebSocketConnectionImplPtr &,
-                              const WebSocketMessageType &) {};
-    std::function<void(const WebSocketConnectionImplPtr &)> closeCallback_ =
-        [](const WebSocketConnectionImplPtr &) {};
-    void sendWsData(const char *msg, uint64_t len, unsigned char opcode);
+    std::vector<uint32_t> masks_;
+    std::unique_ptr<WebSocketDeflate> deflate_;
+    // Keeps the messages in the order of the compression context, set with
+    // it
+    std::unique_ptr<std::mutex> deflateMutex_;
+    // Null when the writes are not coalesced
+    std::mutex pendingMutex_;
+    std::unique_ptr<Coalescing> coalescing_;
+    void sendWsData(const char *msg,
+                    uint64_t len,
+                    unsigned char opcode,
+                    bool compressed = false);
+    // Append a frame to the output
+    void formatFrame(std::string &output,
+                     const char *msg,
+                     uint64_t len,
+                     unsigned char opcode,
+                     bool compressed);
+    // Append a message to the output, compressed if it should be, with the
+    // deflate mutex held. Returns false if the compression fails.
+    bool formatMessage(std::string &output,
+                       const char *msg,
+                       uint64_t len,
+                       unsigned char opcode);
+    void write(std::string &&data);
+    // These are called with the pending mutex held
+    void appendPending(const char *data, size_t len);
+    void sendPending();
+    void flush();
+    void sendClose(CloseCode code, const std::string &reason);
+    void onTimeout() override;
     void disablePingInLoop();
     void setPingMessageInLoop(std::string &&message,
                               const std::chrono::duration<double> &interval);
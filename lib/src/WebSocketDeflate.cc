@@ -0,0 +1,415 @@
+/**
+ *
+ *  @file WebSocketDeflate.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "WebSocketDeflate.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t kOutputStep = 16384;
+// zlib can't compress raw deflate streams with a 8 bits window
+constexpr uint8_t kMinWindowBits = 9;
+constexpr uint8_t kMaxWindowBits = 15;
+constexpr std::string_view kExtensionName{"permessage-deflate"};
+constexpr char kTail[] = {'\x00', '\x00', '\xff', '\xff'};
+
+// The memory used by zlib, according to zconf.h
+size_t contextMemory(int deflateBits, int memLevel, int inflateBits)
+{
+    return (size_t{1} << (deflateBits + 2)) + (size_t{1} << (memLevel + 9)) +
+           (size_t{1} << inflateBits) + 13 * 1024;
+}
+
+/**
+ * Lower the window of the compressor, then the one of the decompressor if the
+ * peer can be asked to, until the contexts fit the memory limit with the
+ * lowest memory level.
+ */
+bool fitMemory(uint8_t &ownBits,
+               uint8_t &peerBits,
+               bool peerAdjustable,
+               size_t maxMemory)
+{
+    while (contextMemory(ownBits, 1, peerBits) > maxMemory)
+    {
+        if (ownBits > kMinWindowBits)
+            --ownBits;
+        else if (peerAdjustable && peerBits > kMinWindowBits)
+            --peerBits;
+        else
+            return false;
+    }
+    return true;
+}
+
+uint8_t clampWindowBits(uint8_t bits)
+{
+    return std::clamp(bits, kMinWindowBits, kMaxWindowBits);
+}
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+        str.remove_suffix(1);
+    return str;
+}
+
+std::vector<std::string_view> split(std::string_view str, char separator)
+{
+    std::vector<std::string_view> parts;
+    size_t pos;
+    while ((pos = str.find(separator)) != std::string_view::npos)
+    {
+        parts.push_back(trim(str.substr(0, pos)));
+        str.remove_prefix(pos + 1);
+    }
+    parts.push_back(trim(str));
+    return parts;
+}
+
+struct ParsedExtension
+{
+    bool serverNoContextTakeover{false};
+    bool clientNoContextTakeover{false};
+    // 0 if the parameter is absent, 16 if it has no value
+    uint8_t serverMaxWindowBits{0};
+    uint8_t clientMaxWindowBits{0};
+};
+
+/// Parse a window size, return 0 if it is invalid
+uint8_t parseWindowBits(std::string_view value)
+{
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+    {
+        value = value.substr(1, value.size() - 2);
+    }
+    if (value.size() == 1 && value[0] >= '8' && value[0] <= '9')
+        return static_cast<uint8_t>(value[0] - '0');
+    if (value.size() == 2 && value[0] == '1' && value[1] >= '0' &&
+        value[1] <= '5')
+        return static_cast<uint8_t>(10 + value[1] - '0');
+    return 0;
+}
+
+/// Parse the parameters of permessage-deflate, return false if they are
+/// invalid or it is another extension
+bool parseExtension(std::string_view extension, ParsedExtension &parsed)
+{
+    auto params = split(extension, ';');
+    if (params[0] != kExtensionName)
+        return false;
+    for (size_t i = 1; i < params.size(); ++i)
+    {
+        auto param = params[i];
+        std::string_view value;
+        bool hasValue = false;
+        auto pos = param.find('=');
+        if (pos != std::string_view::npos)
+        {
+            value = trim(param.substr(pos + 1));
+            param = trim(param.substr(0, pos));
+            hasValue = true;
+        }
+        if (param == "server_no_context_takeover" ||
+            param == "client_no_context_takeover")
+        {
+            auto &flag = param[0] == 's' ? parsed.serverNoContextTakeover
+                                         : parsed.clientNoContextTakeover;
+            if (hasValue || flag)
+                return false;
+            flag = true;
+        }
+        else if (param == "server_max_window_bits" ||
+                 param == "client_max_window_bits")
+        {
+            auto &bits = param[0] == 's' ? parsed.serverMaxWindowBits
+                                         : parsed.clientMaxWindowBits;
+            if (bits != 0)
+                return false;
+            if (hasValue)
+            {
+                bits = parseWindowBits(value);
+                if (bits == 0)
+                    return false;
+            }
+            else
+            {
+                bits = 16;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+struct WebSocketDeflate::Stream
+{
+    Stream(bool isDeflater, int windowBits, int memLevel)
+        : isDeflater_(isDeflater)
+    {
+        if (isDeflater_)
+        {
+            ok_ = deflateInit2(&strm_,
+                               Z_DEFAULT_COMPRESSION,
+                               Z_DEFLATED,
+                               -windowBits,
+                               memLevel,
+                               Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+        else
+        {
+            ok_ = inflateInit2(&strm_, -windowBits) == Z_OK;
+        }
+    }
+
+    ~Stream()
+    {
+        if (!ok_)
+            return;
+        if (isDeflater_)
+            (void)deflateEnd(&strm_);
+        else
+            (void)inflateEnd(&strm_);
+    }
+
+    z_stream strm_{};
+    bool isDeflater_;
+    bool ok_{false};
+};
+
+bool WebSocketDeflate::acceptOffer(std::string_view header,
+                                   const WebSocketCompressionOptions &options,
+                                   std::string &response)
+{
+    for (auto offer : split(header, ','))
+    {
+        ParsedExtension parsed;
+        if (!parseExtension(offer, parsed))
+            continue;
+        // The client must accept the window of the server
+        if (parsed.serverMaxWindowBits == 16)
+            continue;
+        uint8_t serverBits = clampWindowBits(options.serverMaxWindowBits);
+        if (parsed.serverMaxWindowBits != 0)
+        {
+            if (parsed.serverMaxWindowBits < kMinWindowBits)
+                continue;
+            serverBits = (std::min)(serverBits, parsed.serverMaxWindowBits);
+        }
+        // The window of the client can be limited only if it supports it
+        bool clientBitsOffered = parsed.clientMaxWindowBits != 0;
+        uint8_t clientBits = kMaxWindowBits;
+        if (clientBitsOffered)
+        {
+            clientBits = (std::min)(parsed.clientMaxWindowBits,
+                                    clampWindowBits(
+                                        options.clientMaxWindowBits));
+        }
+        if (!fitMemory(serverBits,
+                       clientBits,
+                       clientBitsOffered,
+                       options.maxMemoryPerConnection))
+        {
+            continue;
+        }
+        response = kExtensionName;
+        if (parsed.serverNoContextTakeover || options.serverNoContextTakeover)
+            response.append("; server_no_context_takeover");
+        if (parsed.clientNoContextTakeover || options.clientNoContextTakeover)
+            response.append("; client_no_context_takeover");
+        if (parsed.serverMaxWindowBits != 0 || serverBits < kMaxWindowBits)
+        {
+            response.append("; server_max_window_bits=")
+                .append(std::to_string(serverBits));
+        }
+        if (clientBitsOffered && clientBits < kMaxWindowBits)
+        {
+            response.append("; client_max_window_bits=")
+                .append(std::to_string(clientBits));
+        }
+        return true;
+    }
+    return false;
+}
+
+std::string WebSocketDeflate::makeOffer(
+    const WebSocketCompressionOptions &options)
+{
+    uint8_t clientBits = clampWindowBits(options.clientMaxWindowBits);
+    uint8_t serverBits = clampWindowBits(options.serverMaxWindowBits);
+    if (!fitMemory(clientBits,
+                   serverBits,
+                   true,
+                   options.maxMemoryPerConnection))
+    {
+        return {};
+    }
+    std::string offer{kExtensionName};
+    if (options.serverNoContextTakeover)
+        offer.append("; server_no_context_takeover");
+    if (options.clientNoContextTakeover)
+        offer.append("; client_no_context_takeover");
+    if (serverBits < kMaxWindowBits)
+    {
+        offer.append("; server_max_window_bits=")
+            .append(std::to_string(serverBits));
+    }
+    offer.append("; client_max_window_bits");
+    if (clientBits < kMaxWindowBits)
+        offer.append("=").append(std::to_string(clientBits));
+    return offer;
+}
+
+bool WebSocketDeflate::parseResponse(std::string_view header,
+                                     WebSocketDeflateParams &params)
+{
+    ParsedExtension parsed;
+    if (!parseExtension(trim(header), parsed) ||
+        parsed.serverMaxWindowBits == 16 || parsed.clientMaxWindowBits == 16)
+    {
+        return false;
+    }
+    params.serverNoContextTakeover = parsed.serverNoContextTakeover;
+    params.clientNoContextTakeover = parsed.clientNoContextTakeover;
+    params.serverMaxWindowBits = parsed.serverMaxWindowBits != 0
+                                     ? parsed.serverMaxWindowBits
+                                     : kMaxWindowBits;
+    params.clientMaxWindowBits = parsed.clientMaxWindowBits != 0
+                                     ? parsed.clientMaxWindowBits
+                                     : kMaxWindowBits;
+    return true;
+}
+
+WebSocketDeflate::WebSocketDeflate(const WebSocketDeflateParams &params,
+                                   const WebSocketCompressionOptions &options,
+                                   bool isServer,
+                                   size_t maxMessageSize)
+    : threshold_(options.threshold), maxMessageSize_(maxMessageSize)
+{
+    uint8_t ownBits = isServer ? params.serverMaxWindowBits
+                               : params.clientMaxWindowBits;
+    uint8_t peerBits = isServer ? params.clientMaxWindowBits
+                                : params.serverMaxWindowBits;
+    // A smaller window than the negotiated one is always allowed
+    ownBits = (std::min)(clampWindowBits(ownBits),
+                         clampWindowBits(isServer
+                                             ? options.serverMaxWindowBits
+                                             : options.clientMaxWindowBits));
+    (void)fitMemory(ownBits, peerBits, false, options.maxMemoryPerConnection);
+    int memLevel = 8;
+    while (memLevel > 1 && contextMemory(ownBits, memLevel, peerBits) >
+                               options.maxMemoryPerConnection)
+    {
+        --memLevel;
+    }
+    resetDeflater_ = isServer ? params.serverNoContextTakeover
+                              : params.clientNoContextTakeover;
+    resetInflater_ = isServer ? params.clientNoContextTakeover
+                              : params.serverNoContextTakeover;
+    auto deflater = std::make_unique<Stream>(true, ownBits, memLevel);
+    auto inflater = std::make_unique<Stream>(false, peerBits, 0);
+    if (!deflater->ok_ || !inflater->ok_)
+    {
+        LOG_ERROR << "Failed to create the permessage-deflate contexts";
+        return;
+    }
+    deflater_ = std::move(deflater);
+    inflater_ = std::move(inflater);
+}
+
+WebSocketDeflate::~WebSocketDeflate() = default;
+
+bool WebSocketDeflate::compress(const char *data,
+                                size_t length,
+                                std::string &out)
+{
+    auto &strm = deflater_->strm_;
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    strm.avail_in = static_cast<uInt>(length);
+    auto start = out.size();
+    out.reserve(start + length / 2 + 64);
+    do
+    {
+        auto oldSize = out.size();
+        out.resize(oldSize + kOutputStep);
+        strm.next_out = reinterpret_cast<Bytef *>(&out[oldSize]);
+        strm.avail_out = static_cast<uInt>(kOutputStep);
+        auto ret = deflate(&strm, Z_SYNC_FLUSH);
+        out.resize(out.size() - strm.avail_out);
+        if (ret == Z_STREAM_ERROR)
+            return false;
+    } while (strm.avail_out == 0 || strm.avail_in > 0);
+    // RFC7692-7.2.1, the empty stored block ending the flush is removed
+    if (out.size() - start >= sizeof(kTail) &&
+        memcmp(out.data() + out.size() - sizeof(kTail),
+               kTail,
+               sizeof(kTail)) == 0)
+    {
+        out.resize(out.size() - sizeof(kTail));
+    }
+    if (resetDeflater_)
+        (void)deflateReset(&strm);
+    return true;
+}
+
+bool WebSocketDeflate::decompress(std::string &message)
+{
+    message.append(kTail, sizeof(kTail));
+    auto &strm = inflater_->strm_;
+    strm.next_in = reinterpret_cast<Bytef *>(message.data());
+    strm.avail_in = static_cast<uInt>(message.size());
+    std::string out;
+    out.reserve((std::min)(message.size() * 4, maxMessageSize_));
+    do
+    {
+        auto oldSize = out.size();
+        out.resize(oldSize + kOutputStep);
+        strm.next_out = reinterpret_cast<Bytef *>(&out[oldSize]);
+        strm.avail_out = static_cast<uInt>(kOutputStep);
+        auto ret = inflate(&strm, Z_SYNC_FLUSH);
+        out.resize(out.size() - strm.avail_out);
+        if (ret == Z_STREAM_END)
+        {
+            // The peer ended the stream with a final block
+            (void)inflateReset(&strm);
+            break;
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            LOG_ERROR << "Failed to inflate a WebSocket message";
+            return false;
+        }
+        if (out.size() > maxMessageSize_)
+        {
+            LOG_ERROR << "The size of the inflated WebSocket message is too "
+                         "large!";
+            return false;
+        }
+    } while (strm.avail_out == 0 || strm.avail_in > 0);
+    if (resetInflater_)
+        (void)inflateReset(&strm);
+    message.swap(out);
+    return true;
+}
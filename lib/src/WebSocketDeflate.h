@@ -0,0 +1,101 @@
+/**
+ *
+ *  @file WebSocketDeflate.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/WebSocketConnection.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/// The negotiated parameters of the permessage-deflate extension
+struct WebSocketDeflateParams
+{
+    uint8_t serverMaxWindowBits{15};
+    uint8_t clientMaxWindowBits{15};
+    bool serverNoContextTakeover{false};
+    bool clientNoContextTakeover{false};
+};
+
+/**
+ * @brief The compression contexts of a WebSocket connection using the
+ * permessage-deflate extension (RFC7692), and the negotiation of the
+ * extension.
+ */
+class WebSocketDeflate : public trantor::NonCopyable
+{
+  public:
+    /**
+     * @brief Choose the first acceptable offer of a Sec-WebSocket-Extensions
+     * header sent by a client.
+     *
+     * @param response The value of the Sec-WebSocket-Extensions header of the
+     * response.
+     * @return false if no offer is acceptable.
+     */
+    static bool acceptOffer(std::string_view header,
+                            const WebSocketCompressionOptions &options,
+                            std::string &response);
+
+    /// The value of the Sec-WebSocket-Extensions header sent by a client
+    static std::string makeOffer(const WebSocketCompressionOptions &options);
+
+    /**
+     * @brief Parse the extension accepted by a server.
+     *
+     * @return false if the header is malformed or doesn't accept
+     * permessage-deflate.
+     */
+    static bool parseResponse(std::string_view header,
+                              WebSocketDeflateParams &params);
+
+    /**
+     * @param maxMessageSize The size limit of an inflated message.
+     */
+    WebSocketDeflate(const WebSocketDeflateParams &params,
+                     const WebSocketCompressionOptions &options,
+                     bool isServer,
+                     size_t maxMessageSize);
+    ~WebSocketDeflate();
+
+    /// Return false if the contexts couldn't be created.
+    bool ok() const
+    {
+        return deflater_ && inflater_;
+    }
+
+    bool shouldCompress(size_t length) const
+    {
+        return length >= threshold_;
+    }
+
+    /// Compress a message into the payload of a frame with RSV1 set.
+    bool compress(const char *data, size_t length, std::string &out);
+
+    /// Inflate the payload of a compressed message in place.
+    bool decompress(std::string &message);
+
+  private:
+    struct Stream;
+    std::unique_ptr<Stream> deflater_;
+    std::unique_ptr<Stream> inflater_;
+    bool resetDeflater_{false};
+    bool resetInflater_{false};
+    size_t threshold_;
+    size_t maxMessageSize_;
+};
+
+}  // namespace drogon
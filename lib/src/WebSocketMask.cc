@@ -0,0 +1,155 @@
+/**
+ *
+ *  @file WebSocketMask.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "WebSocketMask.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define DROGON_WSMASK_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define DROGON_WSMASK_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define DROGON_WSMASK_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+// Every step below consumes a multiple of 4 bytes, so the key keeps its phase
+// and the rest is passed to the next step with the same key.
+void applyScalar(char *dst, const char *src, size_t len, const char *key)
+{
+    uint32_t key32;
+    memcpy(&key32, key, 4);
+    // The key repeated twice in memory order, whatever the endianness
+    const uint64_t key64 = (static_cast<uint64_t>(key32) << 32) | key32;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, src + i, 8);
+        word ^= key64;
+        memcpy(dst + i, &word, 8);
+    }
+    for (; i < len; ++i)
+    {
+        dst[i] = static_cast<char>(src[i] ^ key[i & 3]);
+    }
+}
+
+#ifdef DROGON_WSMASK_SSE2
+void applySse2(char *dst, const char *src, size_t len, const char *key)
+{
+    int32_t key32;
+    memcpy(&key32, key, 4);
+    const __m128i keys = _mm_set1_epi32(key32);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_xor_si128(chunk, keys));
+    }
+    applyScalar(dst + i, src + i, len - i, key);
+}
+#endif
+
+#ifdef DROGON_WSMASK_AVX2
+__attribute__((target("avx2"))) void applyAvx2(char *dst,
+                                               const char *src,
+                                               size_t len,
+                                               const char *key)
+{
+    int32_t key32;
+    memcpy(&key32, key, 4);
+    const __m256i keys = _mm256_set1_epi32(key32);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_xor_si256(chunk, keys));
+    }
+    applySse2(dst + i, src + i, len - i, key);
+}
+#endif
+
+#ifdef DROGON_WSMASK_NEON
+void applyNeon(char *dst, const char *src, size_t len, const char *key)
+{
+    uint32_t key32;
+    memcpy(&key32, key, 4);
+    const uint8x16_t keys = vreinterpretq_u8_u32(vdupq_n_u32(key32));
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        uint8x16_t chunk =
+            vld1q_u8(reinterpret_cast<const uint8_t *>(src + i));
+        vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), veorq_u8(chunk, keys));
+    }
+    applyScalar(dst + i, src + i, len - i, key);
+}
+#endif
+
+using ApplyFunc = void (*)(char *, const char *, size_t, const char *);
+
+struct Implementation
+{
+    ApplyFunc apply;
+    const char *name;
+};
+
+Implementation selectImplementation()
+{
+#ifdef DROGON_WSMASK_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {applyAvx2, "avx2"};
+#endif
+#if defined(DROGON_WSMASK_SSE2)
+    return {applySse2, "sse2"};
+#elif defined(DROGON_WSMASK_NEON)
+    return {applyNeon, "neon"};
+#else
+    return {applyScalar, "scalar"};
+#endif
+}
+
+const Implementation &implementation()
+{
+    static const Implementation impl = selectImplementation();
+    return impl;
+}
+}  // namespace
+
+void websocket_mask::apply(char *dst,
+                           const char *src,
+                           size_t len,
+                           const char *key)
+{
+    implementation().apply(dst, src, len, key);
+}
+
+const char *websocket_mask::implementationName()
+{
+    return implementation().name;
+}
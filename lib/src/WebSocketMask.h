@@ -0,0 +1,42 @@
+/**
+ *
+ *  @file WebSocketMask.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <stddef.h>
+
+namespace drogon
+{
+namespace websocket_mask
+{
+/**
+ * @brief XOR [src, src + len) with the 4 bytes masking key of a WebSocket
+ * frame (rfc6455-5.3) into dst, which may be src to mask in place.
+ *
+ * The bytes are processed 8 (scalar), 16 (SSE2/NEON) or 32 (AVX2) at a time,
+ * the implementation is chosen once at runtime according to the CPU features.
+ * The first byte is XORed with key[0].
+ */
+DROGON_EXPORT void apply(char *dst,
+                         const char *src,
+                         size_t len,
+                         const char *key);
+
+/**
+ * @brief The name of the implementation selected for this CPU, one of
+ * "avx2", "sse2", "neon" or "scalar".
+ */
+DROGON_EXPORT const char *implementationName();
+}  // namespace websocket_mask
+}  // namespace drogon
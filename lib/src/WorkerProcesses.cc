@@ -0,0 +1,455 @@
+/**
+ *
+ *  @file WorkerProcesses.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "WorkerProcesses.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#ifdef __linux__
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+// The metrics of a worker, written under a seqlock: the sequence is odd
+// while the text is written
+struct SlotHeader
+{
+    std::atomic<uint32_t> sequence;
+    uint32_t length;
+};
+
+constexpr size_t kSlotBytes = 1024 * 1024;
+constexpr size_t kSlotCapacity = kSlotBytes - sizeof(SlotHeader);
+
+SlotHeader *slotOf(char *shared, size_t index)
+{
+    return reinterpret_cast<SlotHeader *>(shared + index * kSlotBytes);
+}
+
+char *textOf(SlotHeader *slot)
+{
+    return reinterpret_cast<char *>(slot + 1);
+}
+
+#ifdef __linux__
+// The signals the master waits for, and the mask restored in the workers
+sigset_t masterSignals;
+sigset_t previousMask;
+
+int listenOn(const trantor::InetAddress &address)
+{
+    int fd = ::socket(address.isIpV6() ? AF_INET6 : AF_INET,
+                      SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                      IPPROTO_TCP);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "socket";
+        exit(1);
+    }
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    // The listeners of the workers bind the address before their sockets
+    // are replaced by this one
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    socklen_t length = address.isIpV6() ? sizeof(sockaddr_in6)
+                                        : sizeof(sockaddr_in);
+    if (::bind(fd, address.getSockAddr(), length) < 0 ||
+        ::listen(fd, SOMAXCONN) < 0)
+    {
+        LOG_SYSERR << "Can't listen on " << address.toIpPort();
+        exit(1);
+    }
+    return fd;
+}
+#endif
+}  // namespace
+
+void WorkerProcesses::start(size_t workers,
+                            const std::vector<trantor::InetAddress> &addresses,
+                            bool forwardSighup)
+{
+#ifdef __linux__
+    workers_ = workers;
+    masterPid_ = ::getpid();
+    for (auto &address : addresses)
+    {
+        auto key = address.toIpPort();
+        if (sockets_.find(key) == sockets_.end())
+            sockets_[key] = listenOn(address);
+    }
+    auto shared = ::mmap(nullptr,
+                         workers * kSlotBytes,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS,
+                         -1,
+                         0);
+    if (shared == MAP_FAILED)
+        LOG_SYSERR << "mmap, the metrics of the workers are not aggregated";
+    else
+        shared_ = static_cast<char *>(shared);
+
+    // Waited for with sigtimedwait(), no handler runs in the master
+    sigemptyset(&masterSignals);
+    sigaddset(&masterSignals, SIGCHLD);
+    sigaddset(&masterSignals, SIGTERM);
+    sigaddset(&masterSignals, SIGINT);
+    if (forwardSighup)
+        sigaddset(&masterSignals, SIGHUP);
+    sigprocmask(SIG_BLOCK, &masterSignals, &previousMask);
+    pids_.assign(workers, -1);
+    for (size_t i = 0; i < workers; ++i)
+    {
+        if (spawn(i))
+            return;
+    }
+    LOG_INFO << "The master process " << masterPid_ << " runs " << workers
+             << " workers";
+    supervise();
+#else
+    (void)addresses;
+    (void)forwardSighup;
+    LOG_WARN << "The worker processes are only supported on Linux, " << workers
+             << " workers are not started";
+#endif
+}
+
+bool WorkerProcesses::spawn(size_t index)
+{
+#ifdef __linux__
+    auto pid = ::fork();
+    if (pid < 0)
+    {
+        LOG_SYSERR << "fork";
+        return false;
+    }
+    if (pid == 0)
+    {
+        index_ = static_cast<int>(index);
+        pids_.clear();
+        sigprocmask(SIG_SETMASK, &previousMask, nullptr);
+        // The workers stop with the master, even when it is killed
+        ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (::getppid() != masterPid_)
+            ::_exit(1);
+        return true;
+    }
+    pids_[index] = pid;
+    LOG_INFO << "Worker " << index << " started, pid " << pid;
+#else
+    (void)index;
+#endif
+    return false;
+}
+
+void WorkerProcesses::supervise()
+{
+#ifdef __linux__
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> started(workers_, Clock::now());
+    bool stopping = false;
+    const timespec tick{1, 0};
+    while (true)
+    {
+        int signal = ::sigtimedwait(&masterSignals, nullptr, &tick);
+        if (signal == SIGCHLD)
+        {
+            int status = 0;
+            pid_t pid;
+            while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+            {
+                auto iter = std::find(pids_.begin(), pids_.end(), pid);
+                if (iter == pids_.end())
+                    continue;
+                *iter = -1;
+                if (stopping)
+                    continue;
+                if (WIFSIGNALED(status))
+                {
+                    LOG_ERROR << "Worker " << iter - pids_.begin()
+                              << " was killed by the signal "
+                              << WTERMSIG(status);
+                }
+                else
+                {
+                    LOG_ERROR << "Worker " << iter - pids_.begin()
+                              << " exited with the status "
+                              << WEXITSTATUS(status);
+                }
+            }
+        }
+        else if (signal == SIGHUP && !stopping)
+        {
+            LOG_INFO << "Reloading the configuration of the workers";
+            for (auto pid : pids_)
+            {
+                if (pid > 0)
+                    ::kill(pid, SIGHUP);
+            }
+        }
+        else if ((signal == SIGTERM || signal == SIGINT) && !stopping)
+        {
+            stopping = true;
+            LOG_INFO << "Stopping the workers";
+            for (auto pid : pids_)
+            {
+                if (pid > 0)
+                    ::kill(pid, SIGTERM);
+            }
+        }
+        if (stopping)
+        {
+            if (std::all_of(pids_.begin(), pids_.end(), [](int pid) {
+                    return pid < 0;
+                }))
+            {
+                LOG_INFO << "The workers are stopped";
+                exit(0);
+            }
+            continue;
+        }
+        // A worker which fails at once is restarted once per second
+        auto now = Clock::now();
+        for (size_t i = 0; i < workers_; ++i)
+        {
+            if (pids_[i] >= 0 || now - started[i] < std::chrono::seconds(1))
+                continue;
+            started[i] = now;
+            if (spawn(i))
+                return;
+        }
+    }
+#endif
+}
+
+std::function<void(int)> WorkerProcesses::wrapBeforeListen(
+    const trantor::InetAddress &address,
+    std::function<void(int)> callback) const
+{
+    auto iter = sockets_.find(address.toIpPort());
+    if (index_ < 0 || iter == sockets_.end())
+        return callback;
+    return [shared = iter->second, callback = std::move(callback)](int fd) {
+#ifdef __linux__
+        // Every loop of every worker accepts on the socket of the master
+        if (::dup3(shared, fd, O_CLOEXEC) < 0)
+            LOG_SYSERR << "dup3";
+#endif
+        if (callback)
+            callback(fd);
+    };
+}
+
+void WorkerProcesses::publishMetrics(const std::string &text)
+{
+    if (!shared_ || index_ < 0)
+        return;
+    auto length = text.length();
+    if (length > kSlotCapacity)
+    {
+        // Cut after the last whole sample
+        auto end = text.rfind('\n', kSlotCapacity - 1);
+        length = end == std::string::npos ? 0 : end + 1;
+        if (!truncationLogged_)
+        {
+            LOG_WARN << "The metrics of the worker exceed " << kSlotCapacity
+                     << " bytes, the other workers don't see all of them";
+            truncationLogged_ = true;
+        }
+    }
+    auto slot = slotOf(shared_, static_cast<size_t>(index_));
+    // Even if the previous worker died while it wrote the slot
+    auto sequence = slot->sequence.load(std::memory_order_relaxed) & ~1u;
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->length = static_cast<uint32_t>(length);
+    memcpy(textOf(slot), text.data(), length);
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::vector<std::string> WorkerProcesses::otherMetrics() const
+{
+    std::vector<std::string> texts;
+    if (!shared_ || index_ < 0)
+        return texts;
+    for (size_t i = 0; i < workers_; ++i)
+    {
+        if (i == static_cast<size_t>(index_))
+            continue;
+        auto slot = slotOf(shared_, i);
+        // Retried while the worker writes the slot, a worker which died
+        // while writing it is skipped
+        for (int attempt = 0; attempt < 10; ++attempt)
+        {
+            auto sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            auto length =
+                (std::min)(static_cast<size_t>(slot->length), kSlotCapacity);
+            std::string text(textOf(slot), length);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) != sequence)
+                continue;
+            if (!text.empty())
+                texts.push_back(std::move(text));
+            break;
+        }
+    }
+    return texts;
+}
+
+std::string WorkerProcesses::mergeMetrics(
+    const std::vector<std::string> &texts)
+{
+    struct Sample
+    {
+        std::string key;
+        double value;
+        // The timestamp, of the first worker
+        std::string suffix;
+    };
+
+    struct Family
+    {
+        std::string help;
+        std::string type;
+        bool summary{false};
+        std::vector<Sample> samples;
+        std::unordered_map<std::string, size_t> index;
+    };
+
+    // In the order of the first text
+    std::vector<std::string> names;
+    std::unordered_map<std::string, Family> families;
+    for (auto &text : texts)
+    {
+        Family *family = nullptr;
+        std::string_view rest(text);
+        while (!rest.empty())
+        {
+            auto end = rest.find('\n');
+            auto line = rest.substr(0, end);
+            rest = end == std::string_view::npos ? std::string_view{}
+                                                 : rest.substr(end + 1);
+            if (line.empty())
+                continue;
+            if (line[0] == '#')
+            {
+                // # HELP name text, or # TYPE name type
+                auto words = line.substr(1);
+                while (!words.empty() && words.front() == ' ')
+                    words.remove_prefix(1);
+                auto keywordEnd = words.find(' ');
+                if (keywordEnd == std::string_view::npos)
+                    continue;
+                auto keyword = words.substr(0, keywordEnd);
+                auto name = words.substr(keywordEnd + 1);
+                auto nameEnd = name.find(' ');
+                auto remainder = nameEnd == std::string_view::npos
+                                     ? std::string_view{}
+                                     : name.substr(nameEnd + 1);
+                name = name.substr(0, nameEnd);
+                auto [iter, inserted] = families.try_emplace(std::string(name));
+                if (inserted)
+                    names.emplace_back(name);
+                family = &iter->second;
+                if (keyword == "HELP" && family->help.empty())
+                {
+                    family->help = std::string(line);
+                }
+                else if (keyword == "TYPE" && family->type.empty())
+                {
+                    family->type = std::string(line);
+                    family->summary = remainder == "summary";
+                }
+                continue;
+            }
+            if (!family)
+            {
+                auto [iter, inserted] = families.try_emplace(std::string());
+                if (inserted)
+                    names.emplace_back();
+                family = &iter->second;
+            }
+            // name{labels} value [timestamp], the labels may have spaces
+            auto brace = line.rfind('}');
+            auto space =
+                line.find(' ', brace == std::string_view::npos ? 0 : brace);
+            if (space == std::string_view::npos)
+                continue;
+            std::string key(line.substr(0, space));
+            auto valueText = line.substr(space + 1);
+            auto valueEnd = valueText.find(' ');
+            std::string number(valueText.substr(0, valueEnd));
+            char *parsedEnd = nullptr;
+            auto value = strtod(number.c_str(), &parsedEnd);
+            if (parsedEnd == number.c_str())
+                continue;
+            auto [iter, inserted] =
+                family->index.try_emplace(key, family->samples.size());
+            if (inserted)
+            {
+                family->samples.push_back(
+                    {std::move(key),
+                     value,
+                     valueEnd == std::string_view::npos
+                         ? std::string()
+                         : std::string(valueText.substr(valueEnd))});
+                continue;
+            }
+            auto &sample = family->samples[iter->second];
+            if (family->summary &&
+                sample.key.find("quantile=\"") != std::string::npos)
+                sample.value = (std::max)(sample.value, value);
+            else
+                sample.value += value;
+        }
+    }
+
+    std::string result;
+    for (auto &name : names)
+    {
+        auto &family = families[name];
+        if (!family.help.empty())
+            result.append(family.help).append("\n");
+        if (!family.type.empty())
+            result.append(family.type).append("\n");
+        for (auto &sample : family.samples)
+        {
+            result.append(sample.key)
+                .append(" ")
+                .append(std::to_string(sample.value))
+                .append(sample.suffix)
+                .append("\n");
+        }
+    }
+    return result;
+}
@@ -0,0 +1,115 @@
+/**
+ *
+ *  @file WorkerProcesses.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Runs the application in several worker processes sharing the
+ * listening sockets.
+ *
+ * The master process binds a socket per listener and forks the workers,
+ * which listen on these sockets in place of the ones they bind, so the
+ * connections waiting in their queues outlive a crashed worker. The master
+ * restarts the workers which die and forwards SIGTERM and SIGINT to them, as
+ * well as SIGHUP when they reload their configuration on it.
+ * Every worker publishes the text of its metrics to a shared memory slot,
+ * from which the other ones aggregate them. This is only supported on Linux.
+ */
+class WorkerProcesses : public trantor::NonCopyable
+{
+  public:
+    static WorkerProcesses &instance()
+    {
+        static WorkerProcesses inst;
+        return inst;
+    }
+
+    /**
+     * @brief Bind the listening sockets and fork the workers, before any
+     * thread is started. Only returns in the workers: the master supervises
+     * them and exits when they are all stopped.
+     *
+     * @param forwardSighup Send the SIGHUP received by the master to the
+     * workers, which reload their configuration.
+     */
+    void start(size_t workers,
+               const std::vector<trantor::InetAddress> &addresses,
+               bool forwardSighup = false);
+
+    /// True in a worker process
+    bool enabled() const
+    {
+        return index_ >= 0;
+    }
+
+    /// The index of the worker, 0 in the single process mode
+    size_t index() const
+    {
+        return index_ < 0 ? 0 : static_cast<size_t>(index_);
+    }
+
+    /// True if the master listens on the address
+    bool inherits(const trantor::InetAddress &address) const
+    {
+        return sockets_.find(address.toIpPort()) != sockets_.end();
+    }
+
+    /**
+     * @brief Wrap the callback called before a listener listens: the socket
+     * bound by the listener is replaced by the one of the master.
+     */
+    std::function<void(int)> wrapBeforeListen(
+        const trantor::InetAddress &address,
+        std::function<void(int)> callback) const;
+
+    /// Publish the metrics of this worker to the other ones
+    void publishMetrics(const std::string &text);
+
+    /// The metrics last published by the other workers
+    std::vector<std::string> otherMetrics() const;
+
+    /**
+     * @brief Merge the metrics of the workers in the Prometheus text format:
+     * the values of the same samples are summed, but the quantiles of the
+     * summaries, of which the greatest is kept.
+     */
+    static std::string mergeMetrics(const std::vector<std::string> &texts);
+
+  private:
+    WorkerProcesses() = default;
+
+    // Fork the worker, returns true in the worker
+    bool spawn(size_t index);
+    // Only returns in a worker forked to replace a dead one
+    void supervise();
+
+    int index_{-1};
+    size_t workers_{0};
+    int masterPid_{0};
+    std::vector<int> pids_;
+    // The listening sockets of the master, by address
+    std::map<std::string, int> sockets_;
+    // The metrics slots of the workers
+    char *shared_{nullptr};
+    bool truncationLogged_{false};
+};
+}  // namespace drogon
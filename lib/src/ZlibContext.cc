@@ -0,0 +1,88 @@
+/**
+ *
+ *  @file ZlibContext.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ZlibContext.h"
+
+using namespace drogon;
+
+namespace
+{
+struct DeflateStream
+{
+    ~DeflateStream()
+    {
+        if (initialized)
+            (void)deflateEnd(&strm);
+    }
+
+    z_stream strm{};
+    bool initialized{false};
+    int level{Z_DEFAULT_COMPRESSION};
+};
+
+struct InflateStream
+{
+    ~InflateStream()
+    {
+        if (initialized)
+            (void)inflateEnd(&strm);
+    }
+
+    z_stream strm{};
+    bool initialized{false};
+};
+}  // namespace
+
+z_stream *internal::getGzipCompressStream(int level)
+{
+    thread_local DeflateStream stream;
+    if (!stream.initialized)
+    {
+        if (deflateInit2(&stream.strm,
+                         level,
+                         Z_DEFLATED,
+                         MAX_WBITS + 16,
+                         8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+            return nullptr;
+        stream.initialized = true;
+        stream.level = level;
+        return &stream.strm;
+    }
+    if (deflateReset(&stream.strm) != Z_OK)
+        return nullptr;
+    if (stream.level != level)
+    {
+        // Nothing is pending after the reset, the level applies to all data
+        if (deflateParams(&stream.strm, level, Z_DEFAULT_STRATEGY) != Z_OK)
+            return nullptr;
+        stream.level = level;
+    }
+    return &stream.strm;
+}
+
+z_stream *internal::getGzipDecompressStream()
+{
+    thread_local InflateStream stream;
+    if (!stream.initialized)
+    {
+        // Detects the gzip or zlib header
+        if (inflateInit2(&stream.strm, MAX_WBITS + 32) != Z_OK)
+            return nullptr;
+        stream.initialized = true;
+        return &stream.strm;
+    }
+    if (inflateReset(&stream.strm) != Z_OK)
+        return nullptr;
+    return &stream.strm;
+}
@@ -0,0 +1,39 @@
+/**
+ *
+ *  @file ZlibContext.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <zlib.h>
+
+namespace drogon
+{
+namespace internal
+{
+/**
+ * @brief Return the deflate stream of the current thread, reset and set up to
+ * compress a gzip member with the level.
+ *
+ * Initializing a deflate stream allocates and clears about 256KB of window
+ * and hash tables, which costs more than compressing a small body, so the
+ * stream is kept per thread and reset instead. The stream must not be used
+ * after another call on the same thread.
+ */
+z_stream *getGzipCompressStream(int level);
+
+/**
+ * @brief Return the inflate stream of the current thread, reset to
+ * decompress gzip or zlib data.
+ */
+z_stream *getGzipDecompressStream();
+}  // namespace internal
+}  // namespace drogon
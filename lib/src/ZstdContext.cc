@@ -0,0 +1,111 @@
+/**
+ *
+ *  @file ZstdContext.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ZstdContext.h"
+#ifdef USE_ZSTD
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+struct CompressContext
+{
+    CompressContext() : cctx(ZSTD_createCCtx())
+    {
+    }
+
+    ~CompressContext()
+    {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeCCtx(cctx);
+    }
+
+    ZSTD_CCtx *cctx;
+    ZSTD_CDict *cdict{nullptr};
+    std::string dictionary;
+    int dictionaryLevel{0};
+};
+
+struct DecompressContext
+{
+    DecompressContext() : dctx(ZSTD_createDCtx())
+    {
+    }
+
+    ~DecompressContext()
+    {
+        ZSTD_freeDDict(ddict);
+        ZSTD_freeDCtx(dctx);
+    }
+
+    ZSTD_DCtx *dctx;
+    ZSTD_DDict *ddict{nullptr};
+    std::string dictionary;
+};
+}  // namespace
+
+ZSTD_CCtx *internal::getZstdCompressContext(int level,
+                                            std::string_view dictionary)
+{
+    thread_local CompressContext context;
+    if (!context.cctx)
+        return nullptr;
+    ZSTD_CCtx_reset(context.cctx, ZSTD_reset_session_and_parameters);
+    if (dictionary.empty())
+    {
+        ZSTD_CCtx_setParameter(context.cctx, ZSTD_c_compressionLevel, level);
+        return context.cctx;
+    }
+    if (!context.cdict || context.dictionaryLevel != level ||
+        context.dictionary != dictionary)
+    {
+        ZSTD_freeCDict(context.cdict);
+        context.cdict =
+            ZSTD_createCDict(dictionary.data(), dictionary.length(), level);
+        if (!context.cdict)
+        {
+            context.dictionary.clear();
+            return nullptr;
+        }
+        context.dictionary.assign(dictionary.data(), dictionary.length());
+        context.dictionaryLevel = level;
+    }
+    ZSTD_CCtx_refCDict(context.cctx, context.cdict);
+    return context.cctx;
+}
+
+ZSTD_DCtx *internal::getZstdDecompressContext(std::string_view dictionary)
+{
+    thread_local DecompressContext context;
+    if (!context.dctx)
+        return nullptr;
+    ZSTD_DCtx_reset(context.dctx, ZSTD_reset_session_and_parameters);
+    if (dictionary.empty())
+        return context.dctx;
+    if (!context.ddict || context.dictionary != dictionary)
+    {
+        ZSTD_freeDDict(context.ddict);
+        context.ddict =
+            ZSTD_createDDict(dictionary.data(), dictionary.length());
+        if (!context.ddict)
+        {
+            context.dictionary.clear();
+            return nullptr;
+        }
+        context.dictionary.assign(dictionary.data(), dictionary.length());
+    }
+    ZSTD_DCtx_refDDict(context.dctx, context.ddict);
+    return context.dctx;
+}
+#endif
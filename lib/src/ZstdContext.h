@@ -0,0 +1,43 @@
+/**
+ *
+ *  @file ZstdContext.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#include <string_view>
+
+namespace drogon
+{
+namespace internal
+{
+/**
+ * @brief Return the zstd compression context of the current thread, reset and
+ * set up to compress a frame with the level and the dictionary.
+ *
+ * Creating a context and digesting a dictionary cost much more than
+ * compressing a small body, so both are kept per thread. The digested
+ * dictionary of the last call is reused when the next call passes the same
+ * dictionary bytes. The context must not be used after another call on the
+ * same thread.
+ */
+ZSTD_CCtx *getZstdCompressContext(int level, std::string_view dictionary);
+
+/**
+ * @brief Return the zstd decompression context of the current thread, reset
+ * and set up to decompress frames compressed with the dictionary.
+ */
+ZSTD_DCtx *getZstdDecompressContext(std::string_view dictionary);
+}  // namespace internal
+}  // namespace drogon
+#endif
@@ -0,0 +1,138 @@
+#define DROGON_TEST_MAIN
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <drogon/drogon.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+static constexpr size_t kRequests = 5;
+
+DROGON_TEST(AdmissionScheduler)
+{
+    // One request is handled at a time and two wait in the queue. While the
+    // first one is handled, three default requests are queued and a gold one
+    // comes last. The oldest default requests are shed to make room, and the
+    // gold request is admitted before the default one left in the queue.
+    struct Results
+    {
+        std::vector<std::string> handled;
+        size_t rejected{0};
+        size_t finished{0};
+    };
+    auto results = std::make_shared<Results>();
+    auto send = [TEST_CTX, results](const std::string &name,
+                                    const std::string &tier) {
+        auto client = HttpClient::newHttpClient("http://127.0.0.1:8019",
+                                                app().getLoop());
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/slow");
+        if (!tier.empty())
+            req->addHeader("x-tier", tier);
+        client->sendRequest(
+            req,
+            [TEST_CTX, client, results, name](ReqResult res,
+                                              const HttpResponsePtr &resp) {
+                REQUIRE(res == ReqResult::Ok);
+                if (resp->getStatusCode() == k200OK)
+                {
+                    results->handled.push_back(name);
+                }
+                else
+                {
+                    CHECK(resp->getStatusCode() == k503ServiceUnavailable);
+                    CHECK(resp->body() == "Busy");
+                    ++results->rejected;
+                }
+                if (++results->finished < kRequests)
+                    return;
+                CHECK(results->rejected == 2);
+                MANDATE(results->handled.size() == 3);
+                CHECK(results->handled[0] == "first");
+                CHECK(results->handled[1] == "gold");
+                CHECK(results->handled[2] == "default3");
+            });
+    };
+
+    app().getLoop()->queueInLoop([send]() { send("first", ""); });
+    for (size_t i = 1; i <= 3; ++i)
+    {
+        app().getLoop()->runAfter(0.05 * static_cast<double>(i), [send, i]() {
+            send("default" + std::to_string(i), "");
+        });
+    }
+    app().getLoop()->runAfter(0.2, [send]() { send("gold", "gold"); });
+}
+
+// -- main
+int main(int argc, char **argv)
+{
+    trantor::Logger::setLogLevel(trantor::Logger::kInfo);
+    std::promise<void> p1;
+    std::future<void> f1 = p1.get_future();
+
+    std::stringstream ss;
+    ss << R"({
+    "listeners": [
+        {
+            "address": "127.0.0.1",
+            "port": 8019
+        }
+    ],
+    "app": {
+        "number_of_threads": 1
+    },
+    "plugins": [
+        {
+            "name": "drogon::plugin::AdmissionScheduler",
+            "config": {
+                "max_concurrency": 1,
+                "max_queue": 2,
+                "queue_timeout": 10.0,
+                "classes": [
+                    {
+                        "name": "gold",
+                        "weight": 8,
+                        "header": "x-tier",
+                        "header_values": ["gold"]
+                    },
+                    {
+                        "name": "default",
+                        "weight": 1
+                    }
+                ],
+                "rejection_message": "Busy"
+            }
+        }
+    ]
+})";
+    Json::Value config;
+    ss >> config;
+
+    app().registerHandler(
+        "/slow",
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            trantor::EventLoop::getEventLoopOfCurrentThread()->runAfter(
+                0.5, [callback = std::move(callback)]() {
+                    callback(HttpResponse::newHttpResponse());
+                });
+        },
+        {Get});
+
+    std::thread thr([&]() {
+        app().loadConfigJson(config);
+        app().getLoop()->queueInLoop([&p1]() { p1.set_value(); });
+        app().run();
+    });
+
+    f1.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int testStatus = test::run(argc, argv);
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+    thr.join();
+    return testStatus;
+}
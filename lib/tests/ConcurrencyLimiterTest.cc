@@ -0,0 +1,137 @@
+#define DROGON_TEST_MAIN
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <drogon/plugins/ConcurrencyLimiter.h>
+#include <drogon/drogon.h>
+#include <memory>
+#include <vector>
+
+using namespace drogon;
+
+static constexpr size_t kClients = 4;
+
+DROGON_TEST(ConcurrencyLimiter)
+{
+    auto limiter = app().getPlugin<plugin::ConcurrencyLimiter>();
+    REQUIRE(limiter != nullptr);
+    CHECK(limiter->limitOf("/slow", Get) == 1);
+    CHECK(limiter->limitOf("/fast", Get) == 0);
+
+    // The handler of /slow takes longer than it takes to send all the
+    // requests, so only one of them is handled at a time and the others are
+    // rejected
+    struct Results
+    {
+        size_t handled{0};
+        size_t rejected{0};
+        size_t finished{0};
+    };
+    auto results = std::make_shared<Results>();
+    std::vector<HttpClientPtr> clients;
+    for (size_t i = 0; i < kClients; ++i)
+    {
+        auto client = HttpClient::newHttpClient("http://127.0.0.1:8018",
+                                                app().getLoop());
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/slow");
+        client->sendRequest(
+            req,
+            [TEST_CTX, client, results](ReqResult res,
+                                        const HttpResponsePtr &resp) {
+                REQUIRE(res == ReqResult::Ok);
+                if (resp->getStatusCode() == k200OK)
+                {
+                    ++results->handled;
+                }
+                else
+                {
+                    CHECK(resp->getStatusCode() == k503ServiceUnavailable);
+                    CHECK(resp->body() == "Too busy");
+                    ++results->rejected;
+                }
+                if (++results->finished < kClients)
+                    return;
+                CHECK(results->handled >= 1);
+                CHECK(results->rejected >= 1);
+            });
+        clients.push_back(std::move(client));
+    }
+
+    // The handlers which are not limited are never rejected
+    auto client =
+        HttpClient::newHttpClient("http://127.0.0.1:8018", app().getLoop());
+    for (size_t i = 0; i < kClients; ++i)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/fast");
+        client->sendRequest(
+            req, [TEST_CTX](ReqResult res, const HttpResponsePtr &resp) {
+                REQUIRE(res == ReqResult::Ok);
+                CHECK(resp->getStatusCode() == k200OK);
+            });
+    }
+}
+
+// -- main
+int main(int argc, char **argv)
+{
+    trantor::Logger::setLogLevel(trantor::Logger::kInfo);
+    std::promise<void> p1;
+    std::future<void> f1 = p1.get_future();
+
+    std::stringstream ss;
+    ss << R"({
+    "listeners": [
+        {
+            "address": "127.0.0.1",
+            "port": 8018
+        }
+    ],
+    "plugins": [
+        {
+            "name": "drogon::plugin::ConcurrencyLimiter",
+            "config": {
+                "urls": ["^/slow$"],
+                "initial_limit": 1,
+                "min_limit": 1,
+                "max_limit": 1,
+                "rejection_message": "Too busy"
+            }
+        }
+    ]
+})";
+    Json::Value config;
+    ss >> config;
+
+    app().registerHandler(
+        "/slow",
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            trantor::EventLoop::getEventLoopOfCurrentThread()->runAfter(
+                0.5, [callback = std::move(callback)]() {
+                    callback(HttpResponse::newHttpResponse());
+                });
+        },
+        {Get});
+    app().registerHandler(
+        "/fast",
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            callback(HttpResponse::newHttpResponse());
+        },
+        {Get});
+
+    std::thread thr([&]() {
+        app().loadConfigJson(config);
+        app().getLoop()->queueInLoop([&p1]() { p1.set_value(); });
+        app().run();
+    });
+
+    f1.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int testStatus = test::run(argc, argv);
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+    thr.join();
+    return testStatus;
+}
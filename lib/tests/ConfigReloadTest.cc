@@ -0,0 +1,197 @@
+#define DROGON_TEST_MAIN
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/drogon.h>
+#include <drogon/plugins/Plugin.h>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string>
+
+using namespace drogon;
+
+// Applies any value it is given
+class ReloadablePlugin : public Plugin<ReloadablePlugin>
+{
+  public:
+    void initAndStart(const Json::Value &config) override
+    {
+        value_ = config["value"].asInt();
+    }
+
+    void shutdown() override
+    {
+    }
+
+    bool reloadConfig(const Json::Value &config) override
+    {
+        value_ = config["value"].asInt();
+        return true;
+    }
+
+    int value() const
+    {
+        return value_;
+    }
+
+  private:
+    int value_{0};
+};
+
+// Rejects a value which isn't an integer
+class StrictPlugin : public Plugin<StrictPlugin>
+{
+  public:
+    void initAndStart(const Json::Value &config) override
+    {
+        value_ = config["value"].asInt();
+    }
+
+    void shutdown() override
+    {
+    }
+
+    bool reloadConfig(const Json::Value &config) override
+    {
+        if (!config["value"].isInt())
+            throw std::invalid_argument("The value must be an integer");
+        value_ = config["value"].asInt();
+        return true;
+    }
+
+    int value() const
+    {
+        return value_;
+    }
+
+  private:
+    int value_{0};
+};
+
+static const std::filesystem::path configPath =
+    std::filesystem::temp_directory_path() / "drogon_config_reload_test.json";
+
+static Json::Value initialConfig()
+{
+    Json::Value config;
+    Json::Value listener;
+    listener["address"] = "127.0.0.1";
+    listener["port"] = 8022;
+    config["listeners"].append(listener);
+    auto &appConfig = config["app"];
+    appConfig["number_of_threads"] = 1;
+    appConfig["use_gzip"] = true;
+    appConfig["zstd_compression_level"] = 3;
+    appConfig["static_files_cache_time"] = 5;
+    appConfig["request_deadline"] = 0.0;
+    appConfig["log"]["log_level"] = "INFO";
+    for (auto name : {"ReloadablePlugin", "StrictPlugin"})
+    {
+        Json::Value plugin;
+        plugin["name"] = name;
+        plugin["config"]["value"] = 1;
+        config["plugins"].append(plugin);
+    }
+    return config;
+}
+
+static void writeConfig(const Json::Value &config)
+{
+    std::ofstream file(configPath, std::ios::trunc);
+    file << config;
+}
+
+// Returns once the main loop has reloaded the configuration
+static void reloadConfig(const Json::Value &config)
+{
+    writeConfig(config);
+    app().reloadConfigFile();
+    std::promise<void> reloaded;
+    app().getLoop()->queueInLoop([&reloaded]() { reloaded.set_value(); });
+    reloaded.get_future().get();
+}
+
+DROGON_TEST(ConfigReload)
+{
+    auto reloadable = app().getPlugin<ReloadablePlugin>();
+    auto strict = app().getPlugin<StrictPlugin>();
+    MANDATE(reloadable != nullptr);
+    MANDATE(strict != nullptr);
+
+    // The tunables, the log level and the plugin configurations are applied
+    auto config = initialConfig();
+    auto &appConfig = config["app"];
+    appConfig["use_gzip"] = false;
+    appConfig["zstd_compression_level"] = 9;
+    appConfig["static_files_cache_time"] = 10;
+    appConfig["request_deadline"] = 2.5;
+    appConfig["log"]["log_level"] = "WARN";
+    config["plugins"][0]["config"]["value"] = 2;
+    config["plugins"][1]["config"]["value"] = 2;
+    reloadConfig(config);
+    CHECK(app().isGzipEnabled() == false);
+    CHECK(app().getZstdCompressionLevel() == 9);
+    CHECK(app().staticFilesCacheTime() == 10);
+    CHECK(app().getRequestDeadline() == 2.5);
+    CHECK(trantor::Logger::logLevel() == trantor::Logger::kWarn);
+    CHECK(reloadable->value() == 2);
+    CHECK(strict->value() == 2);
+
+    // An invalid size leaves every setting unchanged
+    auto invalidSize = config;
+    invalidSize["app"]["client_max_body_size"] = "huge";
+    invalidSize["app"]["use_gzip"] = true;
+    invalidSize["app"]["zstd_compression_level"] = 5;
+    invalidSize["app"]["log"]["log_level"] = "DEBUG";
+    invalidSize["plugins"][0]["config"]["value"] = 3;
+    invalidSize["plugins"][1]["config"]["value"] = 3;
+    reloadConfig(invalidSize);
+    CHECK(app().isGzipEnabled() == false);
+    CHECK(app().getZstdCompressionLevel() == 9);
+    CHECK(trantor::Logger::logLevel() == trantor::Logger::kWarn);
+    CHECK(reloadable->value() == 2);
+    CHECK(strict->value() == 2);
+
+    // A plugin rejecting its configuration leaves every setting unchanged,
+    // the plugin reloaded before it included
+    auto invalidPlugin = config;
+    invalidPlugin["app"]["use_gzip"] = true;
+    invalidPlugin["app"]["zstd_compression_level"] = 5;
+    invalidPlugin["plugins"][0]["config"]["value"] = 3;
+    invalidPlugin["plugins"][1]["config"]["value"] = "bad";
+    reloadConfig(invalidPlugin);
+    CHECK(app().isGzipEnabled() == false);
+    CHECK(app().getZstdCompressionLevel() == 9);
+    CHECK(reloadable->value() == 2);
+    CHECK(strict->value() == 2);
+
+    // The rolled back plugin takes a later configuration
+    config["plugins"][0]["config"]["value"] = 3;
+    reloadConfig(config);
+    CHECK(reloadable->value() == 3);
+}
+
+// -- main
+int main(int argc, char **argv)
+{
+    trantor::Logger::setLogLevel(trantor::Logger::kInfo);
+    std::promise<void> p1;
+    std::future<void> f1 = p1.get_future();
+
+    writeConfig(initialConfig());
+
+    std::thread thr([&]() {
+        app().loadConfigFile(configPath.string());
+        app().getLoop()->queueInLoop([&p1]() { p1.set_value(); });
+        app().run();
+    });
+
+    f1.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int testStatus = test::run(argc, argv);
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+    thr.join();
+    std::filesystem::remove(configPath);
+    return testStatus;
+}
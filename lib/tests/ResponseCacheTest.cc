@@ -0,0 +1,265 @@
+#define DROGON_TEST_MAIN
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <drogon/drogon.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+// The number of times the handler of every path was called
+static std::map<std::string, std::atomic<int>> handled;
+
+using Headers = std::vector<std::pair<std::string, std::string>>;
+
+static void request(const std::string &path,
+                    const Headers &headers,
+                    std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    auto client =
+        HttpClient::newHttpClient("http://127.0.0.1:8020", app().getLoop());
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath(path);
+    for (auto &header : headers)
+        req->addHeader(header.first, header.second);
+    client->sendRequest(req,
+                        [client, callback = std::move(callback)](
+                            ReqResult res, const HttpResponsePtr &resp) {
+                            callback(res == ReqResult::Ok ? resp : nullptr);
+                        });
+}
+
+DROGON_TEST(ResponseCacheHit)
+{
+    request("/hit", {}, [TEST_CTX](const HttpResponsePtr &resp) {
+        REQUIRE(resp != nullptr);
+        CHECK(resp->body() == "1");
+        request("/hit", {}, [TEST_CTX](const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "1");
+            CHECK(handled.at("/hit") == 1);
+        });
+    });
+}
+
+DROGON_TEST(ResponseCacheHost)
+{
+    // The same path of two virtual hosts has two entries
+    const Headers hostA{{"host", "a.example.com"}};
+    const Headers hostB{{"host", "b.example.com"}};
+    request("/host", hostA, [TEST_CTX, hostA, hostB](
+                                const HttpResponsePtr &resp) {
+        REQUIRE(resp != nullptr);
+        CHECK(resp->body() == "1");
+        request("/host", hostB, [TEST_CTX, hostA](const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "2");
+            request("/host", hostA, [TEST_CTX](const HttpResponsePtr &resp) {
+                REQUIRE(resp != nullptr);
+                CHECK(resp->body() == "1");
+                CHECK(handled.at("/host") == 2);
+            });
+        });
+    });
+}
+
+DROGON_TEST(ResponseCacheVary)
+{
+    // The response varies on a field out of the key, it isn't cached
+    request("/vary", {{"x-flavor", "a"}}, [TEST_CTX](
+                                              const HttpResponsePtr &resp) {
+        REQUIRE(resp != nullptr);
+        CHECK(resp->body() == "a");
+        request("/vary", {{"x-flavor", "b"}}, [TEST_CTX](
+                                                  const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "b");
+            CHECK(handled.at("/vary") == 2);
+        });
+    });
+    // The response varies on a field of the key, one entry per value
+    const Headers english{{"accept-language", "en"}};
+    const Headers french{{"accept-language", "fr"}};
+    request("/lang", english, [TEST_CTX, english, french](
+                                  const HttpResponsePtr &resp) {
+        REQUIRE(resp != nullptr);
+        CHECK(resp->body() == "en");
+        request("/lang", english, [TEST_CTX, french](
+                                      const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "en");
+            CHECK(handled.at("/lang") == 1);
+            request("/lang", french, [TEST_CTX](const HttpResponsePtr &resp) {
+                REQUIRE(resp != nullptr);
+                CHECK(resp->body() == "fr");
+                CHECK(handled.at("/lang") == 2);
+            });
+        });
+    });
+}
+
+DROGON_TEST(ResponseCacheCredentials)
+{
+    // The response to a request with credentials isn't public, it is neither
+    // cached nor taken from the entry of the anonymous requests
+    const Headers credentials{{"authorization", "Bearer token"}};
+    request("/private", {}, [TEST_CTX, credentials](
+                                const HttpResponsePtr &resp) {
+        REQUIRE(resp != nullptr);
+        CHECK(resp->body() == "1");
+        request("/private", credentials, [TEST_CTX, credentials](
+                                             const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "2");
+            request("/private", credentials, [TEST_CTX](
+                                                 const HttpResponsePtr &resp) {
+                REQUIRE(resp != nullptr);
+                CHECK(resp->body() == "3");
+            });
+        });
+    });
+}
+
+DROGON_TEST(ResponseCacheCoalescing)
+{
+    // The requests missing the cache together are handled once
+    constexpr int kRequests = 3;
+    auto finished = std::make_shared<int>(0);
+    for (int i = 0; i < kRequests; ++i)
+    {
+        request("/slow", {}, [TEST_CTX, finished](const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "1");
+            if (++*finished == kRequests)
+                CHECK(handled.at("/slow") == 1);
+        });
+    }
+}
+
+DROGON_TEST(ResponseCacheStaleWhileRevalidate)
+{
+    // After the ttl, the stale response is served once more while a request
+    // refreshes it in the background
+    auto last = [TEST_CTX]() {
+        request("/stale", {}, [TEST_CTX](const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "2");
+            CHECK(handled.at("/stale") == 2);
+        });
+    };
+    auto stale = [TEST_CTX, last]() {
+        request("/stale", {}, [TEST_CTX, last](const HttpResponsePtr &resp) {
+            REQUIRE(resp != nullptr);
+            CHECK(resp->body() == "1");
+            app().getLoop()->runAfter(0.3, last);
+        });
+    };
+    request("/stale", {}, [TEST_CTX, stale](const HttpResponsePtr &resp) {
+        REQUIRE(resp != nullptr);
+        CHECK(resp->body() == "1");
+        app().getLoop()->runAfter(1.2, stale);
+    });
+}
+
+// -- main
+int main(int argc, char **argv)
+{
+    trantor::Logger::setLogLevel(trantor::Logger::kInfo);
+    std::promise<void> p1;
+    std::future<void> f1 = p1.get_future();
+
+    std::stringstream ss;
+    ss << R"({
+    "listeners": [
+        {
+            "address": "127.0.0.1",
+            "port": 8020
+        }
+    ],
+    "app": {
+        "number_of_threads": 1
+    },
+    "plugins": [
+        {
+            "name": "drogon::plugin::ResponseCache",
+            "config": {
+                "ttl": 1,
+                "stale_while_revalidate": 30,
+                "key_headers": ["accept-language"]
+            }
+        }
+    ]
+})";
+    Json::Value config;
+    ss >> config;
+
+    for (auto path : {"/hit", "/host", "/private", "/stale"})
+    {
+        handled[path] = 0;
+        app().registerHandler(
+            path,
+            [path](const HttpRequestPtr &,
+                   std::function<void(const HttpResponsePtr &)> &&callback) {
+                auto resp = HttpResponse::newHttpResponse();
+                resp->setBody(std::to_string(++handled.at(path)));
+                callback(resp);
+            },
+            {Get});
+    }
+    handled["/slow"] = 0;
+    app().registerHandler(
+        "/slow",
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto count = ++handled.at("/slow");
+            trantor::EventLoop::getEventLoopOfCurrentThread()->runAfter(
+                0.3, [callback = std::move(callback), count]() {
+                    auto resp = HttpResponse::newHttpResponse();
+                    resp->setBody(std::to_string(count));
+                    callback(resp);
+                });
+        },
+        {Get});
+    handled["/vary"] = 0;
+    app().registerHandler(
+        "/vary",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            ++handled.at("/vary");
+            auto resp = HttpResponse::newHttpResponse();
+            resp->addHeader("vary", "X-Flavor");
+            resp->setBody(req->getHeader("x-flavor"));
+            callback(resp);
+        },
+        {Get});
+    handled["/lang"] = 0;
+    app().registerHandler(
+        "/lang",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            ++handled.at("/lang");
+            auto resp = HttpResponse::newHttpResponse();
+            resp->addHeader("vary", "Accept-Language, Accept-Encoding");
+            resp->setBody(req->getHeader("accept-language"));
+            callback(resp);
+        },
+        {Get});
+
+    std::thread thr([&]() {
+        app().loadConfigJson(config);
+        app().getLoop()->queueInLoop([&p1]() { p1.set_value(); });
+        app().run();
+    });
+
+    f1.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int testStatus = test::run(argc, argv);
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+    thr.join();
+    return testStatus;
+}
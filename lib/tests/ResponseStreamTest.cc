@@ -0,0 +1,96 @@
+#define DROGON_TEST_MAIN
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <drogon/drogon.h>
+#include <memory>
+#include <string>
+
+using namespace drogon;
+
+// Only accessed in the IO loop of the server
+static std::weak_ptr<int> flowToken;
+static int drained{0};
+static std::string streamPeer;
+
+DROGON_TEST(ResponseStreamDetach)
+{
+    // Once the stream is closed, the keep-alive connection releases the
+    // callbacks of its flow control and carries the next response
+    auto client =
+        HttpClient::newHttpClient("http://127.0.0.1:8021", app().getLoop());
+    auto check = [TEST_CTX, client]() {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/check");
+        client->sendRequest(req,
+                            [TEST_CTX, client](ReqResult res,
+                                               const HttpResponsePtr &resp) {
+                                REQUIRE(res == ReqResult::Ok);
+                                CHECK(resp->body() ==
+                                      "released drained:1 same");
+                            });
+    };
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath("/stream");
+    client->sendRequest(req,
+                        [TEST_CTX, check](ReqResult res,
+                                          const HttpResponsePtr &resp) {
+                            REQUIRE(res == ReqResult::Ok);
+                            CHECK(resp->body() == "hello");
+                            app().getLoop()->runAfter(0.1, check);
+                        });
+}
+
+// -- main
+int main(int argc, char **argv)
+{
+    trantor::Logger::setLogLevel(trantor::Logger::kInfo);
+    std::promise<void> p1;
+    std::future<void> f1 = p1.get_future();
+
+    app().registerHandler(
+        "/stream",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            streamPeer = req->peerAddr().toIpPort();
+            callback(HttpResponse::newAsyncStreamResponse(
+                [](ResponseStreamPtr stream) {
+                    auto token = std::make_shared<int>(0);
+                    flowToken = token;
+                    stream->setWatermarkCallbacks(1024 * 1024,
+                                                  [token]() {},
+                                                  [token]() {});
+                    stream->send("hello");
+                    stream->drain([token]() { ++drained; });
+                    stream->close();
+                }));
+        },
+        {Get});
+    app().registerHandler(
+        "/check",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto resp = HttpResponse::newHttpResponse();
+            std::string body = flowToken.expired() ? "released" : "held";
+            body.append(" drained:").append(std::to_string(drained));
+            body.append(req->peerAddr().toIpPort() == streamPeer ? " same"
+                                                                 : " other");
+            resp->setBody(std::move(body));
+            callback(resp);
+        },
+        {Get});
+
+    std::thread thr([&]() {
+        app().addListener("127.0.0.1", 8021);
+        app().setThreadNum(1);
+        app().getLoop()->queueInLoop([&p1]() { p1.set_value(); });
+        app().run();
+    });
+
+    f1.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int testStatus = test::run(argc, argv);
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+    thr.join();
+    return testStatus;
+}
@@ -0,0 +1,169 @@
+/**
+ *
+ *  @file Benchmark.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace benchmark
+{
+/**
+ * @brief Keep the compiler from optimizing away a value computed in a
+ * benchmark.
+ */
+template <typename T>
+inline void doNotOptimize(T const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief The number of allocations made by the calling thread, counted by the
+ * operator new of the benchmark program.
+ */
+uint64_t allocationCount();
+
+struct Result
+{
+    std::string name;
+    uint64_t iterations{0};
+    // The median of the repetitions
+    double nsPerOp{0};
+    // The median absolute deviation of the repetitions from the median
+    double madNsPerOp{0};
+    double minNsPerOp{0};
+    double p90NsPerOp{0};
+    double maxNsPerOp{0};
+    // Allocations made by one operation, negative if not measured
+    double allocsPerOp{-1};
+    // Bytes processed by one operation, 0 if not meaningful
+    uint64_t bytesPerOp{0};
+};
+
+/**
+ * @brief A small harness in the style of nanobench.
+ *
+ * Every benchmark is calibrated to run for about minTime per repetition,
+ * which also warms it up, then repeated and reported by its median, so a
+ * single noisy run doesn't decide the result. The results are printed as a
+ * table, or as json with --json for comparing runs in CI.
+ *
+ * With --baseline=<file>, the results are compared with the json output of a
+ * previous run, and the program fails if a median is slower than the
+ * baseline by more than the tolerance and the noise of both runs, or if an
+ * operation allocates more.
+ *
+ * Options: --json, --filter=<substring>, --min-time=<seconds>,
+ * --repetitions=<n>, --baseline=<file>, --tolerance=<percent>.
+ */
+class Runner
+{
+  public:
+    Runner(int argc, char *argv[]);
+
+    /**
+     * @brief Run op repeatedly and record the time of one call.
+     *
+     * @param bytesPerOp The bytes processed by one call, for the throughput.
+     */
+    template <typename Op>
+    void run(const std::string &name, Op &&op, uint64_t bytesPerOp = 0)
+    {
+        if (!selected(name))
+            return;
+        using Clock = std::chrono::steady_clock;
+        auto timeOf = [&op](uint64_t iterations) {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i)
+                op();
+            return std::chrono::duration<double>(Clock::now() - start)
+                .count();
+        };
+        // Grow the iterations until a repetition takes long enough to be
+        // measured precisely
+        uint64_t iterations = 1;
+        double seconds = timeOf(iterations);
+        while (seconds < minTime_ && iterations < (uint64_t(1) << 40))
+        {
+            auto factor = seconds > 0 ? minTime_ * 1.2 / seconds : 10.0;
+            iterations = static_cast<uint64_t>(
+                iterations * (std::min)((std::max)(factor, 1.5), 10.0));
+            seconds = timeOf(iterations);
+        }
+        // The calibration runs were the warmup
+        std::vector<double> samples;
+        auto allocations = allocationCount();
+        for (size_t i = 0; i < repetitions_; ++i)
+            samples.push_back(timeOf(iterations) * 1e9 / iterations);
+        auto allocsPerOp = static_cast<double>(allocationCount() -
+                                               allocations) /
+                           static_cast<double>(iterations * repetitions_);
+        addResult(
+            name, iterations, std::move(samples), bytesPerOp, allocsPerOp);
+    }
+
+    /**
+     * @brief Record a benchmark timed by the caller, e.g. an end-to-end test
+     * which runs on other threads.
+     */
+    void record(const std::string &name,
+                uint64_t operations,
+                double seconds,
+                uint64_t bytesPerOp = 0);
+
+    bool selected(const std::string &name) const
+    {
+        return filter_.empty() || name.find(filter_) != std::string::npos;
+    }
+
+    /**
+     * @brief Print the results and compare them with the baseline.
+     *
+     * @return The exit code of the program, 1 if a benchmark regressed.
+     */
+    int report() const;
+
+  private:
+    void addResult(const std::string &name,
+                   uint64_t iterations,
+                   std::vector<double> samples,
+                   uint64_t bytesPerOp,
+                   double allocsPerOp = -1);
+    // The number of the benchmarks which regressed from the baseline
+    size_t compareWithBaseline() const;
+
+    bool json_{false};
+    std::string filter_;
+    double minTime_{0.1};
+    size_t repetitions_{5};
+    std::string baseline_;
+    double tolerance_{10};
+    std::vector<Result> results_;
+};
+
+void runUtilityBenchmarks(Runner &runner);
+void runHttpBenchmarks(Runner &runner);
+void runLoopbackBenchmarks(Runner &runner);
+}  // namespace benchmark
+}  // namespace drogon
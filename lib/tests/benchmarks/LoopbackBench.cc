@@ -0,0 +1,123 @@
+#include "Benchmark.h"
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <trantor/net/EventLoopThreadPool.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+using namespace drogon::benchmark;
+
+namespace
+{
+constexpr uint16_t kPort = 18855;
+constexpr size_t kConnections = 32;
+constexpr size_t kRequests = 200000;
+
+// Send kRequests requests over kConnections connections, every connection
+// keeping max(depth, 1) requests in flight, and return the seconds taken.
+double runClients(trantor::EventLoopThreadPool &loops, size_t depth)
+{
+    struct State
+    {
+        std::vector<HttpClientPtr> clients;
+        std::atomic<size_t> sent{0};
+        std::atomic<size_t> done{0};
+        std::promise<void> finished;
+        std::function<void(const HttpClientPtr &)> send;
+    };
+    auto state = std::make_shared<State>();
+    std::weak_ptr<State> weakState = state;
+    state->send = [weakState](const HttpClientPtr &client) {
+        auto state = weakState.lock();
+        if (!state || state->sent++ >= kRequests)
+            return;
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/plaintext");
+        client->sendRequest(req,
+                            [weakState, client](ReqResult,
+                                                const HttpResponsePtr &) {
+                                auto state = weakState.lock();
+                                if (!state)
+                                    return;
+                                if (++state->done == kRequests)
+                                    state->finished.set_value();
+                                else
+                                    state->send(client);
+                            });
+    };
+    for (size_t i = 0; i < kConnections; ++i)
+    {
+        auto client = HttpClient::newHttpClient("127.0.0.1",
+                                                kPort,
+                                                false,
+                                                loops.getNextLoop());
+        client->setPipeliningDepth(depth);
+        state->clients.push_back(std::move(client));
+    }
+    // Open the connections before the clock starts
+    for (auto &client : state->clients)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/plaintext");
+        client->sendRequest(req, 5);
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto finished = state->finished.get_future();
+    for (auto &client : state->clients)
+    {
+        for (size_t n = 0; n < (std::max)(depth, size_t(1)); ++n)
+            state->send(client);
+    }
+    finished.wait();
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    state->send = nullptr;
+    return seconds;
+}
+}  // namespace
+
+void drogon::benchmark::runLoopbackBenchmarks(Runner &runner)
+{
+    if (!runner.selected("loopback/"))
+        return;
+    app()
+        .setLogLevel(trantor::Logger::kWarn)
+        .addListener("127.0.0.1", kPort)
+        .setThreadNum(2)
+        .registerHandler(
+            "/plaintext",
+            [](const HttpRequestPtr &,
+               std::function<void(const HttpResponsePtr &)> &&callback) {
+                auto resp = HttpResponse::newHttpResponse();
+                resp->setContentTypeCode(CT_TEXT_PLAIN);
+                resp->setBody("Hello, World!");
+                callback(resp);
+            });
+    std::promise<void> listening;
+    app().registerBeginningAdvice([&listening]() {
+        // The listeners start right after the advices, in the same task
+        app().getLoop()->queueInLoop([&listening]() { listening.set_value(); });
+    });
+    std::thread server([]() { app().run(); });
+    listening.get_future().wait();
+
+    {
+        trantor::EventLoopThreadPool loops(2);
+        loops.start();
+        runner.record("loopback/plaintext/keepalive",
+                      kRequests,
+                      runClients(loops, 0));
+        runner.record("loopback/plaintext/pipelined16",
+                      kRequests,
+                      runClients(loops, 16));
+    }
+
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+    server.join();
+}
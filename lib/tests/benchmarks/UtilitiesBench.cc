@@ -0,0 +1,117 @@
+#include "Benchmark.h"
+#include "../../lib/src/RouteTrie.h"
+#include <drogon/CacheMap.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoopThread.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace drogon;
+using namespace drogon::benchmark;
+
+namespace
+{
+void benchmarkCodecs(Runner &runner)
+{
+    std::string encoded;
+    for (int i = 0; i < 32; ++i)
+        encoded += "name%20" + std::to_string(i) + "=%E4%B8%AD%E6%96%87&";
+    runner.run(
+        "utils/urlDecode",
+        [&encoded]() { doNotOptimize(utils::urlDecode(encoded)); },
+        encoded.size());
+
+    std::string binary(4096, '\0');
+    for (size_t i = 0; i < binary.size(); ++i)
+        binary[i] = static_cast<char>(i * 131 + 7);
+    runner.run(
+        "utils/base64Encode/4k",
+        [&binary]() { doNotOptimize(utils::base64Encode(binary)); },
+        binary.size());
+
+    std::string text;
+    while (text.size() < 64 * 1024)
+        text += "{\"id\":" + std::to_string(text.size()) +
+                ",\"name\":\"drogon\",\"tags\":[\"web\",\"framework\"]},";
+    runner.run(
+        "utils/gzipCompress/64k",
+        [&text]() {
+            doNotOptimize(utils::gzipCompress(text.data(), text.size()));
+        },
+        text.size());
+}
+
+void benchmarkRouteTrie(Runner &runner)
+{
+    struct Item
+    {
+        bool enabled{true};
+    };
+    for (size_t routes : {10, 100, 1000})
+    {
+        RouteTrie<Item> trie;
+        bool created;
+        for (size_t i = 0; i < routes; ++i)
+        {
+            auto prefix = "/api/v" + std::to_string(i % 3) + "/res" +
+                          std::to_string(i);
+            trie.insert(prefix, created);
+            trie.insert(prefix + "/{id}", created);
+            trie.insert(prefix + "/{id}/items/{item}", created);
+        }
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < 64; ++i)
+        {
+            auto n = (i * 7919) % routes;
+            paths.push_back("/api/v" + std::to_string(n % 3) + "/res" +
+                            std::to_string(n) + "/42/items/abc");
+        }
+        std::vector<std::string_view> captures;
+        size_t next = 0;
+        runner.run("router/match/" + std::to_string(routes * 3) + "routes",
+                   [&]() {
+                       auto &path = paths[next++ % paths.size()];
+                       doNotOptimize(trie.match(path,
+                                                captures,
+                                                [](const Item &item) {
+                                                    return item.enabled;
+                                                }));
+                   });
+    }
+}
+
+void benchmarkCacheMap(Runner &runner)
+{
+    if (!runner.selected("cachemap/"))
+        return;
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    CacheMap<std::string, std::string> cache(loopThread.getLoop(),
+                                             0.1f,
+                                             4,
+                                             200);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 10000; ++i)
+        keys.push_back("session" + std::to_string(i));
+    size_t next = 0;
+    runner.run("cachemap/insert", [&]() {
+        cache.insert(keys[next++ % keys.size()], "value");
+    });
+    runner.run("cachemap/insert-timeout", [&]() {
+        cache.insert(keys[next++ % keys.size()], "value", 600);
+    });
+    std::string value;
+    runner.run("cachemap/findAndFetch", [&]() {
+        doNotOptimize(
+            cache.findAndFetch(keys[next++ % keys.size()], value));
+    });
+}
+}  // namespace
+
+void drogon::benchmark::runUtilityBenchmarks(Runner &runner)
+{
+    benchmarkCodecs(runner);
+    benchmarkRouteTrie(runner);
+    benchmarkCacheMap(runner);
+}
@@ -0,0 +1,269 @@
+#include "Benchmark.h"
+#include "../../lib/src/HttpScanner.h"
+#include <json/json.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <unordered_map>
+
+using namespace drogon::benchmark;
+
+// Count the allocations of every thread, the counters are plain thread local
+// integers not to slow down the benchmarks
+static thread_local uint64_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (auto p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+uint64_t drogon::benchmark::allocationCount()
+{
+    return allocations;
+}
+
+Runner::Runner(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--json")
+        {
+            json_ = true;
+        }
+        else if (arg.compare(0, 9, "--filter=") == 0)
+        {
+            filter_ = arg.substr(9);
+        }
+        else if (arg.compare(0, 11, "--min-time=") == 0)
+        {
+            minTime_ = std::atof(arg.c_str() + 11);
+        }
+        else if (arg.compare(0, 14, "--repetitions=") == 0)
+        {
+            repetitions_ = (std::max)(std::atoi(arg.c_str() + 14), 1);
+        }
+        else if (arg.compare(0, 11, "--baseline=") == 0)
+        {
+            baseline_ = arg.substr(11);
+        }
+        else if (arg.compare(0, 12, "--tolerance=") == 0)
+        {
+            tolerance_ = std::atof(arg.c_str() + 12);
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--json] [--filter=<substring>] "
+                         "[--min-time=<seconds>] [--repetitions=<n>] "
+                         "[--baseline=<file>] [--tolerance=<percent>]"
+                      << std::endl;
+            exit(1);
+        }
+    }
+}
+
+static double median(std::vector<double> &values)
+{
+    std::sort(values.begin(), values.end());
+    auto size = values.size();
+    return size % 2 ? values[size / 2]
+                    : (values[size / 2 - 1] + values[size / 2]) / 2;
+}
+
+void Runner::addResult(const std::string &name,
+                       uint64_t iterations,
+                       std::vector<double> samples,
+                       uint64_t bytesPerOp,
+                       double allocsPerOp)
+{
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = median(samples);
+    result.minNsPerOp = samples.front();
+    // The nearest rank
+    result.p90NsPerOp = samples[static_cast<size_t>(
+        std::ceil(0.9 * static_cast<double>(samples.size()))) - 1];
+    result.maxNsPerOp = samples.back();
+    std::vector<double> deviations;
+    for (auto sample : samples)
+        deviations.push_back(std::fabs(sample - result.nsPerOp));
+    result.madNsPerOp = median(deviations);
+    result.allocsPerOp = allocsPerOp;
+    result.bytesPerOp = bytesPerOp;
+    if (!json_)
+    {
+        std::cerr << name << " done" << std::endl;
+    }
+    results_.push_back(std::move(result));
+}
+
+void Runner::record(const std::string &name,
+                    uint64_t operations,
+                    double seconds,
+                    uint64_t bytesPerOp)
+{
+    if (operations == 0)
+        return;
+    auto ns = seconds * 1e9 / operations;
+    addResult(name, operations, {ns}, bytesPerOp);
+}
+
+int Runner::report() const
+{
+    if (json_)
+    {
+        Json::Value root;
+        root["context"]["http_scanner"] =
+            drogon::http_scanner::implementationName();
+#ifdef NDEBUG
+        root["context"]["build"] = "release";
+#else
+        root["context"]["build"] = "debug";
+#endif
+        auto &benchmarks = root["benchmarks"];
+        benchmarks = Json::Value(Json::arrayValue);
+        for (const auto &result : results_)
+        {
+            Json::Value item;
+            item["name"] = result.name;
+            item["iterations"] = static_cast<Json::UInt64>(result.iterations);
+            item["ns_per_op"] = result.nsPerOp;
+            item["mad_ns_per_op"] = result.madNsPerOp;
+            item["min_ns_per_op"] = result.minNsPerOp;
+            item["p90_ns_per_op"] = result.p90NsPerOp;
+            item["max_ns_per_op"] = result.maxNsPerOp;
+            if (result.allocsPerOp >= 0)
+                item["allocs_per_op"] = result.allocsPerOp;
+            item["ops_per_second"] = 1e9 / result.nsPerOp;
+            if (result.bytesPerOp > 0)
+            {
+                item["bytes_per_second"] =
+                    result.bytesPerOp * 1e9 / result.nsPerOp;
+            }
+            benchmarks.append(std::move(item));
+        }
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "  ";
+        std::cout << Json::writeString(builder, root) << std::endl;
+    }
+    else
+    {
+        std::cout << std::left << std::setw(44) << "benchmark" << std::right
+                  << std::setw(14) << "ns/op" << std::setw(10) << "+/-"
+                  << std::setw(16) << "ops/s" << std::setw(14) << "MB/s"
+                  << std::setw(12) << "allocs/op" << std::endl;
+        std::cout << std::fixed << std::setprecision(1);
+        for (const auto &result : results_)
+        {
+            std::cout << std::left << std::setw(44) << result.name
+                      << std::right << std::setw(14) << result.nsPerOp
+                      << std::setw(10) << result.madNsPerOp << std::setw(16)
+                      << 1e9 / result.nsPerOp << std::setw(14);
+            if (result.bytesPerOp > 0)
+                std::cout << result.bytesPerOp * 1e3 / result.nsPerOp;
+            else
+                std::cout << "-";
+            std::cout << std::setw(12);
+            if (result.allocsPerOp >= 0)
+                std::cout << result.allocsPerOp;
+            else
+                std::cout << "-";
+            std::cout << std::endl;
+        }
+    }
+    if (!baseline_.empty() && compareWithBaseline() > 0)
+        return 1;
+    return 0;
+}
+
+size_t Runner::compareWithBaseline() const
+{
+    std::ifstream file(baseline_);
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    if (!file || !Json::parseFromStream(builder, file, &root, &errors))
+    {
+        std::cerr << "Can't read the baseline " << baseline_ << ": "
+                  << errors << std::endl;
+        return 1;
+    }
+    std::unordered_map<std::string, const Json::Value *> baseline;
+    for (const auto &item : root["benchmarks"])
+        baseline[item["name"].asString()] = &item;
+
+    size_t regressions = 0;
+    for (const auto &result : results_)
+    {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end())
+            continue;
+        const auto &item = *it->second;
+        // Some noise of both runs is tolerated besides the slowdown
+        auto limit = item["ns_per_op"].asDouble() * (1 + tolerance_ / 100) +
+                     2 * (item["mad_ns_per_op"].asDouble() + result.madNsPerOp);
+        if (result.nsPerOp > limit)
+        {
+            std::cerr << "Regression: " << result.name << " takes "
+                      << result.nsPerOp << " ns/op, the baseline "
+                      << item["ns_per_op"].asDouble() << " ns/op"
+                      << std::endl;
+            ++regressions;
+        }
+        // The allocations don't depend on the noise, half an allocation
+        // per operation is allowed for the rounding of the averages
+        if (result.allocsPerOp >= 0 && item.isMember("allocs_per_op") &&
+            result.allocsPerOp > item["allocs_per_op"].asDouble() + 0.5)
+        {
+            std::cerr << "Regression: " << result.name << " makes "
+                      << result.allocsPerOp << " allocations per op, the "
+                      << "baseline " << item["allocs_per_op"].asDouble()
+                      << std::endl;
+            ++regressions;
+        }
+    }
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    Runner runner(argc, argv);
+    runUtilityBenchmarks(runner);
+    runHttpBenchmarks(runner);
+    runLoopbackBenchmarks(runner);
+    return runner.report();
+}
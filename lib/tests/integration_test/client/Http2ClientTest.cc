@@ -0,0 +1,50 @@
+#include <drogon/HttpClient.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/drogon_test.h>
+#include <string>
+using namespace drogon;
+
+DROGON_TEST(Http2ClientTest)
+{
+    // Cleartext HTTP/2 with prior knowledge, the requests are sent at once
+    // as concurrent streams of one connection
+    auto client = HttpClient::newHttpClient("http://127.0.0.1:8848");
+    client->enableHttp2();
+
+    for (int i = 0; i < 16; ++i)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/drogon.jpg");
+        client->sendRequest(
+            req, [TEST_CTX, client](ReqResult r, const HttpResponsePtr &resp) {
+                REQUIRE(r == ReqResult::Ok);
+                CHECK(resp->getStatusCode() == k200OK);
+                CHECK(resp->getVersion() == Version::kHttp2);
+                CHECK(resp->getBody().length() == 44618UL);
+            });
+    }
+
+    // The request bodies are sent in DATA frames
+    Json::Value json;
+    json["request"] = "json";
+    auto req = HttpRequest::newHttpJsonRequest(json);
+    req->setMethod(Post);
+    req->setPath("/api/v1/apitest/json");
+    client->sendRequest(req,
+                        [TEST_CTX](ReqResult r, const HttpResponsePtr &resp) {
+                            REQUIRE(r == ReqResult::Ok);
+                            CHECK(resp->getVersion() == Version::kHttp2);
+                            auto ret = resp->getJsonObject();
+                            REQUIRE(ret != nullptr);
+                            CHECK((*ret)["result"].asString() == "ok");
+                        });
+
+    auto notFound = HttpRequest::newHttpRequest();
+    notFound->setPath("/no/such/path");
+    client->sendRequest(notFound,
+                        [TEST_CTX](ReqResult r, const HttpResponsePtr &resp) {
+                            REQUIRE(r == ReqResult::Ok);
+                            CHECK(resp->getStatusCode() == k404NotFound);
+                            CHECK(resp->getVersion() == Version::kHttp2);
+                        });
+}
@@ -0,0 +1,38 @@
+#include <drogon/HttpClientPool.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/drogon_test.h>
+#include <atomic>
+#include <memory>
+using namespace drogon;
+
+static constexpr size_t kPoolRequests = 8;
+
+DROGON_TEST(HttpClientPoolTest)
+{
+    // Two connections with one request in flight each, the other requests
+    // wait in the pool
+    auto pool = HttpClientPool::newHttpClientPool("http://127.0.0.1:8848",
+                                                  2,
+                                                  {app().getLoop()});
+    auto finished = std::make_shared<std::atomic<size_t>>(0);
+    for (size_t i = 0; i < kPoolRequests; ++i)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/drogon.jpg");
+        pool->sendRequest(
+            req,
+            [TEST_CTX, pool, finished](ReqResult r,
+                                       const HttpResponsePtr &resp) {
+                REQUIRE(r == ReqResult::Ok);
+                CHECK(resp->getBody().length() == 44618UL);
+                auto metrics = pool->metrics();
+                CHECK(metrics.connections <= 2);
+                if (++*finished < kPoolRequests)
+                    return;
+                CHECK(metrics.completed == kPoolRequests);
+                CHECK(metrics.failed == 0);
+                CHECK(metrics.inFlight == 0);
+                CHECK(metrics.queued == 0);
+            });
+    }
+}
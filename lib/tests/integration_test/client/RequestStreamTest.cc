@@ -129,6 +129,17 @@ DROGON_TEST(RequestStreamTest)
                        // Good response
                        "HTTP/1.1 200 OK\r\n");
 
+    checkStreamRequest(TEST_CTX,
+                       client->getLoop(),
+                       trantor::InetAddress{ip, port},
+                       // Many small chunks in one piece
+                       {"POST /stream_chunk HTTP/1.1\r\n"
+                        "Transfer-Encoding: chunked\r\n\r\n",
+                        "1\r\nz\r\n2;ext=1\r\nzz\r\n3\r\nzzz\r\n4\r\nzz",
+                        "zz\r\n0\r\n\r\n"},
+                       // Good response
+                       "HTTP/1.1 200 OK\r\n");
+
     checkStreamRequest(TEST_CTX,
                        client->getLoop(),
                        trantor::InetAddress{ip, port},
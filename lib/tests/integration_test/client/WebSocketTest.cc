@@ -60,6 +60,10 @@ DROGON_TEST(WebSocketTest)
                                 REQUIRE(resp != nullptr);
                                 wsPtr->getConnection()->setPingMessage("", 1s);
                                 wsPtr->getConnection()->send("hello!");
+                                // Written together with the pings
+                                wsPtr->getConnection()->enableCoalescing();
+                                wsPtr->getConnection()->sendBatch(
+                                    {"hello", "again!"});
                                 CHECK(wsPtr->getConnection()->connected());
                                 // Drop the testing context as WS controllers
                                 // stores the lambda and never release it.
@@ -131,6 +131,19 @@ void doTest(const HttpClientPtr &client, std::shared_ptr<test::Case> TEST_CTX)
                             REQUIRE(result == ReqResult::Ok);
                             CHECK(resp->getBody().length() == 4994UL);
                         });
+#endif
+/// Test zstd
+#ifdef USE_ZSTD
+    req = HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Get);
+    req->addHeader("accept-encoding", "zstd, br, gzip");
+    req->setPath("/api/v1/apitest/get/111");
+    client->sendRequest(req,
+                        [req, TEST_CTX](ReqResult result,
+                                        const HttpResponsePtr &resp) {
+                            REQUIRE(result == ReqResult::Ok);
+                            CHECK(resp->getBody().length() == 4994UL);
+                        });
 #endif
     /// Post json
     Json::Value json;
@@ -197,6 +210,42 @@ void doTest(const HttpClientPtr &client, std::shared_ptr<test::Case> TEST_CTX)
                             CHECK(resp->getBody() == "<p>Hello, world!</p>");
                             // LOG_DEBUG << resp->getBody();
                         });
+    /// 2. Get a view rendered from a typed model
+    req = HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Get);
+    req->setPath("/typed_view");
+    client->sendRequest(
+        req, [req, TEST_CTX](ReqResult result, const HttpResponsePtr &resp) {
+            REQUIRE(result == ReqResult::Ok);
+            auto body = resp->body();
+            CHECK(body.find("<title>TypedView</title>") !=
+                  std::string_view::npos);
+            CHECK(body.find("<td>apple</td><td>3</td>") !=
+                  std::string_view::npos);
+            CHECK(body.find("<td>pear</td><td>5</td>") !=
+                  std::string_view::npos);
+        });
+    req = HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Get);
+    req->setPath("/typed_view_stream");
+    client->sendRequest(
+        req, [req, TEST_CTX](ReqResult result, const HttpResponsePtr &resp) {
+            REQUIRE(result == ReqResult::Ok);
+            auto body = resp->body();
+            CHECK(body.find("<title>TypedView</title>") !=
+                  std::string_view::npos);
+            CHECK(body.find("<td>pear</td><td>5</td>") !=
+                  std::string_view::npos);
+            CHECK(body.find("</html>") != std::string_view::npos);
+        });
+    req = HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Get);
+    req->setPath("/subrequests");
+    client->sendRequest(
+        req, [req, TEST_CTX](ReqResult result, const HttpResponsePtr &resp) {
+            REQUIRE(result == ReqResult::Ok);
+            CHECK(resp->body() == "static response|static response|");
+        });
     /// 3. Post to /tpost to test Http Method constraint
     req = HttpRequest::newHttpRequest();
     req->setMethod(drogon::Get);
@@ -472,6 +521,21 @@ void doTest(const HttpClientPtr &client, std::shared_ptr<test::Case> TEST_CTX)
             CHECK(body.find("<td>string p3</td>\n        <td></td>") !=
                   std::string::npos);
         });
+    /// Test static response
+    for (int i = 0; i < 2; ++i)
+    {
+        req = HttpRequest::newHttpRequest();
+        req->setMethod(drogon::Get);
+        req->setPath("/api/static_response");
+        client->sendRequest(req,
+                            [req, TEST_CTX](ReqResult result,
+                                            const HttpResponsePtr &resp) {
+                                REQUIRE(result == ReqResult::Ok);
+                                CHECK(resp->getStatusCode() == k200OK);
+                                CHECK(resp->getBody() == "static response");
+                                CHECK(resp->contentType() == CT_TEXT_PLAIN);
+                            });
+    }
     /// Test lambda
     req = HttpRequest::newHttpRequest();
     req->setMethod(drogon::Get);
@@ -1046,6 +1110,23 @@ void doTest(const HttpClientPtr &client, std::shared_ptr<test::Case> TEST_CTX)
                         });
 #endif
 
+#ifdef USE_ZSTD
+    // Post compressed data
+    req = HttpRequest::newHttpRequest();
+    req->setPath("/api/v1/ApiTest/echoBody");
+    req->addHeader("Content-Encoding", "zstd");
+    req->setMethod(drogon::Post);
+    req->setBody(
+        utils::zstdCompress(largeString.c_str(), largeString.size()));
+    client->sendRequest(req,
+                        [largeString, TEST_CTX](ReqResult result,
+                                                const HttpResponsePtr &resp) {
+                            REQUIRE(result == ReqResult::Ok);
+                            CHECK(resp->getStatusCode() == k200OK);
+                            CHECK(resp->body() == largeString);
+                        });
+#endif
+
     // Test middleware
     req = HttpRequest::newHttpRequest();
     req->setPath("/test-middleware");
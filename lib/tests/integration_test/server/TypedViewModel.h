@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct TypedViewModel
+{
+    struct Row
+    {
+        std::string name;
+        int count;
+    };
+
+    std::string title;
+    std::vector<Row> rows;
+};
@@ -3,6 +3,7 @@
 #include "CustomCtrl.h"
 #include "CustomHeaderFilter.h"
 #include "DigestAuthFilter.h"
+#include "TypedViewModel.h"
 
 #include <drogon/drogon.h>
 #include <iostream>
@@ -244,6 +245,60 @@ int main()
            std::function<void(const HttpResponsePtr &)> &&callback) {
             throw std::runtime_error("this should fail");
         });
+    // A view with a typed model
+    app().registerHandler(
+        "/typed_view",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            HttpViewData data;
+            data.insert("model",
+                        TypedViewModel{"TypedView",
+                                       {{"apple", 3}, {"pear", 5}}});
+            callback(HttpResponse::newHttpViewResponse("TypedView", data));
+        });
+    app().registerHandler(
+        "/typed_view_stream",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            HttpViewData data;
+            data.insert("model",
+                        TypedViewModel{"TypedView",
+                                       {{"apple", 3}, {"pear", 5}}});
+            // Small chunks to send the page in several pieces
+            callback(HttpResponse::newHttpViewStreamResponse("TypedView",
+                                                             data,
+                                                             64));
+        });
+    auto staticResp = HttpResponse::newHttpResponse();
+    staticResp->setContentTypeCode(CT_TEXT_PLAIN);
+    staticResp->setBody("static response");
+    app().registerStaticResponse("/api/static_response", staticResp, {Get});
+    // Aggregate the responses of two routes handled in the same process
+    app().registerHandler(
+        "/subrequests",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            std::vector<HttpRequestPtr> subreqs;
+            for (int i = 0; i < 2; ++i)
+            {
+                auto subreq = HttpRequest::newSubrequest(req);
+                subreq->setPath("/api/static_response");
+                subreqs.push_back(std::move(subreq));
+            }
+            app().subrequests(
+                std::move(subreqs),
+                [callback = std::move(callback)](
+                    std::vector<HttpResponsePtr> &&resps) {
+                    std::string body;
+                    for (auto &resp : resps)
+                    {
+                        body.append(resp->body()).append("|");
+                    }
+                    auto resp = HttpResponse::newHttpResponse();
+                    resp->setBody(std::move(body));
+                    callback(resp);
+                });
+        });
 
     app().setDocumentRoot("./");
     app().enableSession(60);
@@ -255,6 +310,8 @@ int main()
     app().loadConfigFile("config.example.json");
     app().setImplicitPageEnable(true);
     app().setImplicitPage("page.html");
+    // For the clients which speak h2c with prior knowledge
+    app().enableHttp2();
     auto &json = app().getCustomConfig();
     if (json.empty())
     {
@@ -398,6 +455,7 @@ int main()
     app().setCustom404Page(resp);
     app().addListener("0.0.0.0", 0);
     app().enableCompressedRequest(true);
+    app().enableZstd(true);
     app().registerBeginningAdvice([]() {
         auto addresses = app().getListeners();
         for (auto &address : addresses)
@@ -0,0 +1,212 @@
+#include <drogon/drogon_test.h>
+#include <drogon/AsyncLoadingCache.h>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+namespace
+{
+using Cache = AsyncLoadingCache<std::string, std::string>;
+
+struct PendingLoad
+{
+    std::string key;
+    Cache::ValueCallback callback;
+    Cache::ErrorCallback errorCallback;
+};
+
+// A loader whose loads end when the test says so
+struct ManualLoader
+{
+    Cache::Loader loader()
+    {
+        return [this](const std::string &key,
+                      Cache::ValueCallback &&callback,
+                      Cache::ErrorCallback &&errorCallback) {
+            loads.push_back(
+                {key, std::move(callback), std::move(errorCallback)});
+        };
+    }
+
+    void finish(const std::string &value)
+    {
+        auto load = std::move(loads.front());
+        loads.pop_front();
+        load.callback(std::string(value));
+    }
+
+    std::deque<PendingLoad> loads;
+};
+
+std::string getNow(const std::shared_ptr<Cache> &cache,
+                   const std::string &key)
+{
+    // The loads may end after the call
+    auto result = std::make_shared<std::string>("<pending>");
+    cache->get(
+        key,
+        [result](const std::string &value) { *result = value; },
+        [result](const std::exception_ptr &) { *result = "<error>"; });
+    return *result;
+}
+}  // namespace
+
+DROGON_TEST(AsyncLoadingCacheSingleFlight)
+{
+    ManualLoader loader;
+    auto cache = Cache::newCache(loader.loader());
+
+    // The requests of a key during its load wait for the same load
+    std::vector<std::string> results;
+    for (int i = 0; i < 3; ++i)
+    {
+        cache->get(
+            "a",
+            [&results](const std::string &value) { results.push_back(value); },
+            [](const std::exception_ptr &) {});
+    }
+    REQUIRE(loader.loads.size() == 1u);
+    CHECK(results.empty());
+    loader.finish("A");
+    CHECK(results.size() == 3u);
+    CHECK(results[2] == "A");
+    CHECK(getNow(cache, "a") == "A");
+    CHECK(loader.loads.empty());
+    CHECK(cache->getIfPresent("a") == std::optional<std::string>("A"));
+    CHECK(!cache->getIfPresent("b"));
+
+    // A failed load is passed to all its waiters and not cached
+    int errors{0};
+    for (int i = 0; i < 2; ++i)
+    {
+        cache->get(
+            "b",
+            [](const std::string &) {},
+            [&errors](const std::exception_ptr &) { ++errors; });
+    }
+    REQUIRE(loader.loads.size() == 1u);
+    loader.loads.front().errorCallback(
+        std::make_exception_ptr(std::runtime_error("down")));
+    loader.loads.pop_front();
+    CHECK(errors == 2);
+    CHECK(getNow(cache, "b") == "<pending>");
+    loader.finish("B");
+    CHECK(getNow(cache, "b") == "B");
+
+    // A load overtaken by an invalidation is not cached
+    cache->invalidate("b");
+    CHECK(getNow(cache, "b") == "<pending>");
+    cache->invalidate("b");
+    CHECK(getNow(cache, "b") == "<pending>");
+    REQUIRE(loader.loads.size() == 2u);
+    loader.finish("old");
+    CHECK(!cache->getIfPresent("b"));
+    loader.finish("new");
+    CHECK(getNow(cache, "b") == "new");
+
+    cache->put("c", "C");
+    CHECK(getNow(cache, "c") == "C");
+    CHECK(cache->size() == 3u);
+    cache->invalidateAll();
+    CHECK(cache->size() == 0u);
+
+    // The waiters get the value of a load which ends after the cache is gone
+    std::string late;
+    cache->get(
+        "d",
+        [&late](const std::string &value) { late = value; },
+        [](const std::exception_ptr &) {});
+    cache.reset();
+    loader.finish("D");
+    CHECK(late == "D");
+}
+
+DROGON_TEST(AsyncLoadingCacheEviction)
+{
+    ManualLoader loader;
+    AsyncLoadingCacheOptions options;
+    options.maxEntries = 3;
+    options.shards = 1;
+    options.eviction = CacheEviction::kLru;
+    auto lru = Cache::newCache(loader.loader(), options);
+    for (auto key : {"a", "b", "c"})
+        lru->put(key, key);
+    CHECK(getNow(lru, "a") == "a");
+    lru->put("d", "d");
+    CHECK(lru->size() == 3u);
+    CHECK(lru->getIfPresent("a"));
+    CHECK(!lru->getIfPresent("b"));
+
+    // A popular key survives a scan of keys requested once
+    options.maxEntries = 100;
+    options.eviction = CacheEviction::kTinyLfu;
+    auto tinyLfu = Cache::newCache(loader.loader(), options);
+    for (int i = 0; i < 100; ++i)
+        tinyLfu->put("hot" + std::to_string(i), "x");
+    for (int round = 0; round < 5; ++round)
+    {
+        for (int i = 0; i < 100; ++i)
+            getNow(tinyLfu, "hot" + std::to_string(i));
+    }
+    for (int i = 0; i < 1000; ++i)
+        tinyLfu->put("cold" + std::to_string(i), "y");
+    size_t hot{0};
+    for (int i = 0; i < 100; ++i)
+    {
+        if (tinyLfu->getIfPresent("hot" + std::to_string(i)))
+            ++hot;
+    }
+    CHECK(hot > 90u);
+    CHECK(tinyLfu->size() <= 100u);
+    CHECK(loader.loads.empty());
+
+    // The limit of bytes
+    options.maxEntries = 100;
+    options.maxBytes = 10;
+    options.eviction = CacheEviction::kLru;
+    auto weighed =
+        Cache::newCache(loader.loader(),
+                        options,
+                        [](const std::string &, const std::string &value) {
+                            return value.size();
+                        });
+    weighed->put("a", "1234");
+    weighed->put("b", "1234");
+    CHECK(weighed->bytes() == 8u);
+    weighed->put("c", "1234");
+    CHECK(weighed->bytes() == 8u);
+    CHECK(!weighed->getIfPresent("a"));
+    weighed->put("d", "12345678901");
+    CHECK(!weighed->getIfPresent("d"));
+    CHECK(weighed->size() == 2u);
+}
+
+DROGON_TEST(AsyncLoadingCacheExpiration)
+{
+    ManualLoader loader;
+    AsyncLoadingCacheOptions options;
+    options.ttl = 0.2;
+    options.refreshAfter = 0.05;
+    auto cache = Cache::newCache(loader.loader(), options);
+    cache->put("a", "1");
+    CHECK(getNow(cache, "a") == "1");
+    CHECK(loader.loads.empty());
+
+    // After refreshAfter, a hit returns the value and reloads it once
+    std::this_thread::sleep_for(80ms);
+    CHECK(getNow(cache, "a") == "1");
+    CHECK(getNow(cache, "a") == "1");
+    REQUIRE(loader.loads.size() == 1u);
+    loader.finish("2");
+    CHECK(getNow(cache, "a") == "2");
+
+    // After the ttl, the value is loaded again
+    std::this_thread::sleep_for(250ms);
+    CHECK(getNow(cache, "a") == "<pending>");
+    loader.finish("3");
+    CHECK(getNow(cache, "a") == "3");
+}
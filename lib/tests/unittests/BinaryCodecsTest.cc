@@ -0,0 +1,122 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+#include "../../lib/src/BinaryCodecs.h"
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+// One character at a time, to check the blocks of the implementation
+std::string referenceBase64(const std::string &in, bool urlSafe, bool padded)
+{
+    std::string alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    alphabet += urlSafe ? "-_" : "+/";
+    std::string out;
+    size_t bits = 0;
+    unsigned value = 0;
+    for (unsigned char c : in)
+    {
+        value = (value << 8) | c;
+        bits += 8;
+        while (bits >= 6)
+        {
+            bits -= 6;
+            out += alphabet[(value >> bits) & 0x3f];
+        }
+    }
+    if (bits > 0)
+        out += alphabet[(value << (6 - bits)) & 0x3f];
+    while (padded && out.size() % 4 != 0)
+        out += '=';
+    return out;
+}
+
+std::string referenceHex(const std::string &in, bool lowerCase)
+{
+    const char *digits = lowerCase ? "0123456789abcdef" : "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : in)
+    {
+        out += digits[c >> 4];
+        out += digits[c & 0x0f];
+    }
+    return out;
+}
+}  // namespace
+
+DROGON_TEST(BinaryCodecsTest)
+{
+    MANDATE(binary_codecs::implementationName() != nullptr);
+
+    // Every tail length across the 16 to 64 bytes blocks
+    std::string input;
+    for (int i = 0; i < 300; ++i)
+        input.push_back(static_cast<char>(i * 37 + 11));
+    for (size_t len = 0; len <= input.size(); len += 7)
+    {
+        auto in = input.substr(0, len);
+        for (bool urlSafe : {false, true})
+        {
+            for (bool padded : {false, true})
+            {
+                auto encoded = utils::base64Encode(in, urlSafe, padded);
+                CHECK(encoded == referenceBase64(in, urlSafe, padded));
+                CHECK(utils::base64Decode(encoded) == in);
+            }
+        }
+        auto hex = utils::binaryStringToHex(
+            reinterpret_cast<const unsigned char *>(in.data()), in.size());
+        CHECK(hex == referenceHex(in, false));
+        CHECK(utils::hexToBinaryString(hex.data(), hex.size()) == in);
+        auto lowerHex = utils::binaryStringToHex(
+            reinterpret_cast<const unsigned char *>(in.data()),
+            in.size(),
+            true);
+        CHECK(lowerHex == referenceHex(in, true));
+        CHECK(utils::hexToBinaryString(lowerHex.data(), lowerHex.size()) ==
+              in);
+    }
+
+    SUBSECTION(Base64Fallback)
+    {
+        // The blocks with padding, separators or mixed alphabets decode like
+        // the scalar loop does
+        std::string in(200, '\0');
+        for (size_t i = 0; i < in.size(); ++i)
+            in[i] = static_cast<char>(i * 13 + 5);
+        auto encoded = utils::base64Encode(in);
+        auto urlSafe = utils::base64Encode(in, true);
+        std::string mixed = encoded.substr(0, 100) + urlSafe.substr(100);
+        CHECK(utils::base64Decode(mixed) == in);
+
+        std::string wrapped;
+        for (size_t i = 0; i < encoded.size(); i += 76)
+            wrapped += encoded.substr(i, 76) + "\r\n";
+        CHECK(utils::base64Decode(wrapped) == in);
+        auto vec = utils::base64DecodeToVector(wrapped);
+        CHECK(std::string(vec.data(), vec.size()) == in);
+
+        // The decoding stops at the first '='
+        auto truncated = encoded.substr(0, 120) + "=" + encoded.substr(120);
+        CHECK(utils::base64Decode(truncated) == in.substr(0, 90));
+    }
+
+    SUBSECTION(HexInvalid)
+    {
+        std::string hex(128, 'a');
+        for (size_t pos : {0, 31, 32, 100, 127})
+        {
+            auto invalid = hex;
+            invalid[pos] = 'g';
+            CHECK(utils::hexToBinaryString(invalid.data(), invalid.size())
+                      .empty());
+            CHECK(utils::hexToBinaryVector(invalid.data(), invalid.size())
+                      .empty());
+        }
+        std::string out(64, '\0');
+        CHECK(utils::hexToBinary(hex.data(), hex.size(), &out[0]));
+        CHECK(out == std::string(64, '\xaa'));
+    }
+}
@@ -0,0 +1,43 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/BodyMemoryBudget.h"
+#include <trantor/net/EventLoopThread.h>
+#include <future>
+
+using namespace drogon;
+
+DROGON_TEST(BodyMemoryBudgetTest)
+{
+    auto &budget = BodyMemoryBudget::instance();
+    auto oldBudget = budget.budget();
+    budget.setBudget(100);
+
+    CHECK(budget.tryAcquire(60));
+    CHECK(budget.tryAcquire(40));
+    CHECK(budget.tryAcquire(1) == false);
+    CHECK(budget.used() == 100u);
+
+    // A waiter runs once some memory is released
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    std::promise<void> woken;
+    budget.waitFor(30, loopThread.getLoop(), [&woken]() { woken.set_value(); });
+    auto future = woken.get_future();
+    CHECK(future.wait_for(std::chrono::milliseconds(50)) ==
+          std::future_status::timeout);
+    budget.release(40);
+    CHECK(future.wait_for(std::chrono::seconds(5)) ==
+          std::future_status::ready);
+    CHECK(budget.tryAcquire(30));
+
+    // The memory is available, the callback runs at once
+    std::promise<void> immediate;
+    budget.waitFor(10, loopThread.getLoop(), [&immediate]() {
+        immediate.set_value();
+    });
+    CHECK(immediate.get_future().wait_for(std::chrono::seconds(5)) ==
+          std::future_status::ready);
+
+    budget.release(90);
+    CHECK(budget.used() == 0u);
+    budget.setBudget(oldBudget);
+}
@@ -0,0 +1,73 @@
+#include "../../lib/src/CacheFile.h"
+#include <drogon/drogon_test.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+
+DROGON_TEST(CacheFile)
+{
+    auto path =
+        (std::filesystem::temp_directory_path() / "drogon_cache_file.tmp")
+            .string();
+    std::string data;
+    for (int i = 0; i < 200000; ++i)
+        data.push_back(static_cast<char>('a' + i % 26));
+    {
+        CacheFile file(path);
+        file.append(data.data(), 1000);
+        file.append(data.data() + 1000, data.length() - 1000);
+        CHECK(file.length() == data.length());
+
+        // Windows of the file are mapped one by one
+        std::string read;
+        size_t pieces = 0;
+        CHECK(file.readChunks(70000, [&](std::string_view piece) {
+            CHECK(piece.length() <= 70000u);
+            read.append(piece);
+            ++pieces;
+            return true;
+        }));
+        CHECK(read == data);
+        CHECK(pieces == 3u);
+
+        // Stopped by the callback
+        pieces = 0;
+        CHECK(file.readChunks(1000, [&](std::string_view) {
+                  return ++pieces < 5;
+              }) == false);
+        CHECK(pieces == 5u);
+
+        // The same pieces once the whole file is mapped
+        CHECK(file.getStringView() == data);
+        read.clear();
+        CHECK(file.readChunks(70000, [&](std::string_view piece) {
+            read.append(piece);
+            return true;
+        }));
+        CHECK(read == data);
+
+#ifdef __linux__
+        // A range copied by the kernel, at the offset of the target
+        auto copyPath = path + ".copy";
+        int fd = ::open(copyPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        CHECK(fd >= 0);
+        CHECK(::write(fd, "head", 4) == 4);
+        auto copied = file.copyRangeTo(1234, 100000, fd);
+        CHECK(copied == 100000u);
+        ::close(fd);
+        std::ifstream copy(copyPath, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(copy)),
+                            std::istreambuf_iterator<char>());
+        CHECK(content == "head" + data.substr(1234, 100000));
+        std::filesystem::remove(copyPath);
+#endif
+    }
+    CHECK(!std::filesystem::exists(path));
+}
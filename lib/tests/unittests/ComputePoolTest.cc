@@ -0,0 +1,44 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/ComputePool.h"
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace drogon;
+
+DROGON_TEST(ComputePoolTest)
+{
+    auto &pool = ComputePool::instance();
+    pool.setThreadNum(4);
+
+    // Every task runs once, the tasks queued by the workers too
+    constexpr int kTasks = 10000;
+    std::atomic<int> counter{0};
+    std::promise<void> finished;
+    auto onDone = [&counter, &finished]() {
+        if (counter.fetch_add(1) + 1 == 2 * kTasks)
+            finished.set_value();
+    };
+    for (int i = 0; i < kTasks; ++i)
+    {
+        pool.run([&pool, onDone]() {
+            pool.run([onDone]() { onDone(); });
+            onDone();
+        });
+    }
+    CHECK(finished.get_future().wait_for(std::chrono::seconds(10)) ==
+          std::future_status::ready);
+    CHECK(counter == 2 * kTasks);
+
+    // The tasks don't run on the calling thread
+    std::promise<std::thread::id> threadId;
+    pool.run([&threadId]() { threadId.set_value(std::this_thread::get_id()); });
+    CHECK(threadId.get_future().get() != std::this_thread::get_id());
+
+    // A throwing task doesn't stop its worker
+    pool.run([]() { throw std::runtime_error("Test exception"); });
+    std::promise<void> after;
+    pool.run([&after]() { after.set_value(); });
+    CHECK(after.get_future().wait_for(std::chrono::seconds(5)) ==
+          std::future_status::ready);
+}
@@ -1,5 +1,7 @@
 #include <drogon/Cookie.h>
 #include <drogon/drogon_test.h>
+#include "../../lib/src/HttpRequestImpl.h"
+#include <string>
 
 DROGON_TEST(CookieTest)
 {
@@ -61,3 +63,48 @@ DROGON_TEST(CookieTest)
         cookie9.cookieString() ==
         "Set-Cookie: test=9; SameSite=Lax; Secure; HttpOnly; Partitioned\r\n");
 }
+
+DROGON_TEST(CookieBufferTest)
+{
+    drogon::Cookie cookie("test", "1");
+    cookie.setDomain("drogon.org");
+    cookie.setPath("/");
+    cookie.setMaxAge(3600);
+    cookie.setSameSite(drogon::Cookie::SameSite::kStrict);
+    trantor::MsgBuffer buffer;
+    cookie.appendCookieString(buffer);
+    CHECK(std::string(buffer.peek(), buffer.readableBytes()) ==
+          cookie.cookieString());
+    CHECK(cookie.cookieString() ==
+          "Set-Cookie: test=1; Max-Age=3600; Domain=drogon.org; Path=/; "
+          "SameSite=Strict; HttpOnly\r\n");
+}
+
+DROGON_TEST(RequestCookieTest)
+{
+    drogon::HttpRequestImpl req(nullptr);
+    auto addHeader = [&req](const std::string &line) {
+        auto colon = line.find(':');
+        req.addHeader(line.data(),
+                      line.data() + colon,
+                      line.data() + line.length());
+    };
+    addHeader("Cookie: a=1; sid=abc;  b = 2");
+    addHeader("Cookie: a=3; flag");
+    // Read without parsing the cookies, the last value wins
+    CHECK(req.getCookieView("sid") == "abc");
+    CHECK(req.getCookieView("a") == "3");
+    CHECK(req.getCookieView("b ") == "2");
+    CHECK(req.getCookieView("c").empty());
+
+    CHECK(req.cookies().size() == 3);
+    CHECK(req.getCookie("a") == "3");
+    CHECK(req.getCookieView("sid") == "abc");
+    CHECK(req.headers().empty());
+
+    req.reset();
+    addHeader("Cookie: a=4");
+    req.addCookie("c", "5");
+    CHECK(req.getCookie("a") == "4");
+    CHECK(req.getCookie("c") == "5");
+}
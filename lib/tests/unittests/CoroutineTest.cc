@@ -11,6 +11,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
 #include <type_traits>
 
 using namespace drogon;
@@ -38,6 +39,55 @@ struct StructAwaiter : public CallbackAwaiter<std::shared_ptr<SomeStruct>>
     }
 };
 
+// Completes in the call when its value is known, like a cache hit
+struct InlineAwaiter : public CallbackAwaiter<int>
+{
+    explicit InlineAwaiter(int value, bool preset = false) : value_(value)
+    {
+        if (preset)
+            setValue(value);
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        ++suspended;
+        setValue(value_);
+        resumeIfSuspended(handle);
+        return suspendUnlessCompleted();
+    }
+
+    static int suspended;
+
+  private:
+    int value_;
+};
+
+int InlineAwaiter::suspended = 0;
+
+// Completes with 1 if it has a deadline
+struct DeadlineProbe : public DeadlineAwaiter<int>
+{
+    DeadlineProbe()
+    {
+    }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle)
+    {
+        auto done = armDeadline(handle, []() {
+            return std::make_exception_ptr(std::runtime_error("Deadline"));
+        });
+        if (!done)
+            return false;
+        if (complete(done))
+        {
+            setValue(deadline_ ? 1 : 0);
+            handle.resume();
+        }
+        return true;
+    }
+};
+
 }  // namespace drogon::internal
 
 // Workaround limitation of macros
@@ -205,6 +255,33 @@ DROGON_TEST(AsyncWaitLifetime)
     }));
 }
 
+DROGON_TEST(InlineCompletion)
+{
+    // Resuming from within await_suspend() would grow the stack each time
+    auto sum = sync_wait([]() -> Task<int64_t> {
+        int64_t sum = 0;
+        for (int i = 0; i < 1000000; ++i)
+            sum += co_await internal::InlineAwaiter(1);
+        co_return sum;
+    }());
+    CHECK(sum == 1000000);
+    CHECK(internal::InlineAwaiter::suspended == 1000000);
+
+    // A value known at construction does not even reach await_suspend()
+    internal::InlineAwaiter::suspended = 0;
+    auto value = sync_wait([]() -> Task<int> {
+        co_return co_await internal::InlineAwaiter(7, true);
+    }());
+    CHECK(value == 7);
+    CHECK(internal::InlineAwaiter::suspended == 0);
+
+    // No task to wait for
+    auto results = sync_wait([]() -> Task<std::vector<int>> {
+        co_return co_await when_all(std::vector<Task<int>>{});
+    }());
+    CHECK(results.empty());
+}
+
 DROGON_TEST(SwitchThread)
 {
     trantor::EventLoopThread thread;
@@ -328,3 +405,213 @@ DROGON_TEST(WhenAll)
         CHECK(counter == 1);
     }(TEST_CTX);
 }
+
+#ifndef DROGON_NO_CORO_FRAME_POOL
+DROGON_TEST(CoroFramePool)
+{
+    using internal::CoroFramePool;
+    // A freed frame is reused by the next one of the same size class
+    auto p1 = CoroFramePool::allocate(100);
+    CoroFramePool::deallocate(p1, 100);
+    auto p2 = CoroFramePool::allocate(120);
+    CHECK(p1 == p2);
+    CoroFramePool::deallocate(p2, 120);
+
+    // Large frames are not cached
+    auto p3 = CoroFramePool::allocate(4096);
+    CHECK(p3 != nullptr);
+    CoroFramePool::deallocate(p3, 4096);
+
+    // A frame freed by another thread goes to the cache of that thread
+    auto p4 = CoroFramePool::allocate(200);
+    std::thread([p4]() { CoroFramePool::deallocate(p4, 200); }).join();
+
+    // Nested tasks allocate and free their frames through the pool
+    auto add = [](int a, int b) -> Task<int> { co_return a + b; };
+    auto sum = [add](int n) -> Task<int> {
+        int total = 0;
+        for (int i = 0; i < n; ++i)
+            total = co_await add(total, 1);
+        co_return total;
+    };
+    CHECK(sync_wait(sum(1000)) == 1000);
+
+    // Compare the pool with the global allocator on frame sized blocks
+    constexpr size_t kRounds = 100000;
+    constexpr size_t kSizes[] = {96, 160, 320, 640};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kRounds; ++i)
+    {
+        void *blocks[4];
+        for (size_t j = 0; j < 4; ++j)
+            blocks[j] = CoroFramePool::allocate(kSizes[j]);
+        for (size_t j = 0; j < 4; ++j)
+            CoroFramePool::deallocate(blocks[j], kSizes[j]);
+    }
+    auto pooled = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kRounds; ++i)
+    {
+        void *blocks[4];
+        for (size_t j = 0; j < 4; ++j)
+            blocks[j] = ::operator new(kSizes[j]);
+        for (size_t j = 0; j < 4; ++j)
+            ::operator delete(blocks[j]);
+    }
+    auto global = std::chrono::steady_clock::now() - start;
+    using std::chrono::microseconds;
+    LOG_DEBUG << "Frame pool: "
+              << std::chrono::duration_cast<microseconds>(pooled).count()
+              << "us, operator new: "
+              << std::chrono::duration_cast<microseconds>(global).count()
+              << "us";
+}
+#endif
+
+DROGON_TEST(WhenAny)
+{
+    [](TestCtx TEST_CTX) -> AsyncTask {
+        auto delayed = [](double delay, int value) -> Task<int> {
+            co_await drogon::sleepCoro(app().getLoop(), delay);
+            co_return value;
+        };
+        std::vector<Task<int>> tasks;
+        tasks.emplace_back(delayed(0.3, 1));
+        tasks.emplace_back(delayed(0.1, 2));
+        CancellationToken token;
+        auto [index, value] = co_await when_any(std::move(tasks), token);
+        CHECK(index == 1);
+        CHECK(value == 2);
+        CHECK(token.isCancelled());
+    }(TEST_CTX);
+
+    [](TestCtx TEST_CTX) -> AsyncTask {
+        auto failing = []() -> Task<> {
+            throw std::runtime_error("Test exception");
+            co_return;
+        };
+        std::vector<Task<>> tasks;
+        tasks.emplace_back(failing());
+        CO_REQUIRE_THROWS(co_await when_any(std::move(tasks)));
+        CO_REQUIRE_THROWS(co_await when_any(std::vector<Task<>>{}));
+    }(TEST_CTX);
+}
+
+DROGON_TEST(AsyncSemaphore)
+{
+    AsyncSemaphore semaphore(2);
+    CHECK(semaphore.try_acquire());
+    CHECK(semaphore.try_acquire());
+    CHECK(semaphore.try_acquire() == false);
+
+    // A waiter is resumed by the release of a unit
+    bool acquired = false;
+    auto waiter = [](AsyncSemaphore *semaphore, bool *acquired) -> AsyncTask {
+        co_await semaphore->acquire(nullptr);
+        *acquired = true;
+    };
+    waiter(&semaphore, &acquired);
+    CHECK(acquired == false);
+    semaphore.release();
+    CHECK(acquired == true);
+    CHECK(semaphore.available() == 0);
+    semaphore.release();
+    semaphore.release();
+    CHECK(semaphore.available() == 2);
+}
+
+DROGON_TEST(ParallelFor)
+{
+    [](TestCtx TEST_CTX) -> AsyncTask {
+        std::vector<int> values(20);
+        for (int i = 0; i < 20; ++i)
+            values[i] = i;
+        std::atomic<int> running{0}, maxRunning{0}, sum{0};
+        co_await co_parallel_for(values, 4, [&](int value) -> Task<> {
+            auto now = ++running;
+            auto max = maxRunning.load();
+            while (now > max && !maxRunning.compare_exchange_weak(max, now))
+                ;
+            co_await drogon::sleepCoro(app().getLoop(), 0.01);
+            sum += value;
+            --running;
+        });
+        CHECK(sum == 190);
+        CHECK(maxRunning <= 4);
+        CHECK(maxRunning > 1);
+
+        // The first exception stops starting more work
+        std::atomic<int> started{0};
+        CO_REQUIRE_THROWS(
+            co_await co_parallel_for(values, 2, [&](int value) -> Task<> {
+                ++started;
+                co_await drogon::sleepCoro(app().getLoop(), 0.01);
+                if (value == 3)
+                    throw std::runtime_error("Test exception");
+            }));
+        CHECK(started < 20);
+    }(TEST_CTX);
+}
+
+DROGON_TEST(CancellationToken)
+{
+    CancellationToken token;
+    int called = 0;
+    token.onCancel([&called]() { ++called; });
+    CHECK(token.isCancelled() == false);
+    auto copy = token;
+    copy.cancel();
+    token.cancel();
+    CHECK(token.isCancelled());
+    CHECK(called == 1);
+    // Callbacks registered after cancellation run at once
+    token.onCancel([&called]() { ++called; });
+    CHECK(called == 2);
+
+    [](TestCtx TEST_CTX) -> AsyncTask {
+        CancellationToken token;
+        token.cancelAfter(app().getLoop(), 0.05);
+        co_await drogon::sleepCoro(app().getLoop(), 0.2);
+        CHECK(token.isCancelled());
+    }(TEST_CTX);
+}
+
+DROGON_TEST(DeadlinePropagation)
+{
+    auto leaf = []() -> Task<int> {
+        co_return co_await internal::DeadlineProbe{};
+    };
+    auto handler = [leaf]() -> Task<int> { co_return co_await leaf(); };
+    CHECK(sync_wait(handler()) == 0);
+
+    // The tasks created in the scope and the tasks they await inherit it
+    std::optional<Task<int>> task;
+    {
+        internal::DeadlineScope scope(std::chrono::steady_clock::now() +
+                                      std::chrono::seconds(10));
+        task.emplace(handler());
+    }
+    CHECK(sync_wait(std::move(*task)) == 1);
+
+    // Past the deadline the awaits throw
+    {
+        internal::DeadlineScope scope(std::chrono::steady_clock::now() -
+                                      std::chrono::seconds(1));
+        task.emplace(handler());
+    }
+    CHECK_THROWS_AS(sync_wait(std::move(*task)), std::runtime_error);
+    CHECK(sync_wait(handler()) == 0);
+}
+
+DROGON_TEST(OffloadCoro)
+{
+    [](TestCtx TEST_CTX) -> AsyncTask {
+        auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        auto value = co_await app().offloadCoro([]() { return 42; });
+        CHECK(value == 42);
+        // Resumed in the loop it was suspended in
+        CHECK(trantor::EventLoop::getEventLoopOfCurrentThread() == loop);
+        CO_REQUIRE_THROWS(co_await app().offloadCoro(
+            []() { throw std::runtime_error("Test exception"); }));
+    }(TEST_CTX);
+}
@@ -0,0 +1,53 @@
+#include "../../lib/src/CpuProfiler.h"
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+#include <chrono>
+
+using namespace drogon;
+
+static double spin(int milliseconds)
+{
+    auto end = std::chrono::steady_clock::now() +
+               std::chrono::milliseconds(milliseconds);
+    double x = 0;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        for (int i = 0; i < 1000; ++i)
+            x += i * 0.5;
+    }
+    return x;
+}
+
+DROGON_TEST(CpuProfilerTest)
+{
+    auto &profiler = CpuProfiler::instance();
+    CHECK(!profiler.active());
+    CHECK(profiler.stop().empty());
+#ifdef __linux__
+    REQUIRE(profiler.start(1000, 10000));
+    CHECK(profiler.active());
+    // One profile at a time
+    CHECK(!profiler.start(1000, 10000));
+    {
+        CpuProfiler::RouteScope scope("/api/users/{id}");
+        CHECK(spin(300) > 0);
+    }
+    CHECK(profiler.sampleCount() > 0);
+    auto profile = profiler.stop();
+    CHECK(!profiler.active());
+    REQUIRE(!profile.empty());
+    auto decoded = utils::gzipDecompress(profile.data(), profile.length());
+    // The string table of the pprof profile
+    CHECK(decoded.find("/api/users/{id}") != std::string::npos);
+    CHECK(decoded.find("nanoseconds") != std::string::npos);
+
+    // Not tagged out of the scope
+    REQUIRE(profiler.start(1000, 10000));
+    CHECK(spin(100) > 0);
+    profile = profiler.stop();
+    decoded = utils::gzipDecompress(profile.data(), profile.length());
+    CHECK(decoded.find("/api/users/{id}") == std::string::npos);
+#else
+    CHECK(!profiler.start(100, 100));
+#endif
+}
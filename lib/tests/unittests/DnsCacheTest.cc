@@ -0,0 +1,28 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/DnsCache.h"
+
+using namespace drogon;
+
+DROGON_TEST(DnsCacheTest)
+{
+    using trantor::InetAddress;
+    std::vector<InetAddress> addresses{InetAddress("10.0.0.1", 0),
+                                       InetAddress("10.0.0.2", 0),
+                                       InetAddress("10.0.0.1", 0),
+                                       InetAddress("2001:db8::1", 0, true),
+                                       InetAddress("10.0.0.3", 0),
+                                       InetAddress("2001:db8::2", 0, true)};
+    auto sorted = DnsCache::sortForConnecting(addresses);
+    REQUIRE(sorted.size() == 5u);
+    // The families alternate, IPv6 first
+    CHECK(sorted[0].toIp() == "2001:db8::1");
+    CHECK(sorted[1].toIp() == "10.0.0.1");
+    CHECK(sorted[2].toIp() == "2001:db8::2");
+    CHECK(sorted[3].toIp() == "10.0.0.2");
+    CHECK(sorted[4].toIp() == "10.0.0.3");
+
+    CHECK(DnsCache::sortForConnecting({}).empty());
+    sorted = DnsCache::sortForConnecting({InetAddress("10.0.0.1", 0)});
+    REQUIRE(sorted.size() == 1u);
+    CHECK(sorted[0].toIp() == "10.0.0.1");
+}
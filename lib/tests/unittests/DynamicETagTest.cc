@@ -0,0 +1,63 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/DynamicETag.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include "../../lib/src/HttpResponseImpl.h"
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(DynamicETagTest)
+{
+    // The XXH64 reference values
+    CHECK(dynamic_etag::hash("", 0) == 0xEF46DB3751D8E999ULL);
+    CHECK(dynamic_etag::hash("abc", 3) == 0x44BC2CF5AD770999ULL);
+    std::string text = "Nobody inspects the spammish repetition";
+    CHECK(dynamic_etag::hash(text.data(), text.length()) ==
+          0xFBCEA83C8A378BF1ULL);
+
+    CHECK(dynamic_etag::matches("\"a\", W/\"b\"", "W/\"b\""));
+    CHECK(dynamic_etag::matches("W/\"a\"", "\"a\""));
+    CHECK(dynamic_etag::matches(" * ", "\"a\""));
+    CHECK(!dynamic_etag::matches("\"ab\"", "\"a\""));
+    CHECK(!dynamic_etag::matches("*", ""));
+
+    auto req = std::make_shared<HttpRequestImpl>(nullptr);
+    req->setMethod(Get);
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody("hello");
+    resp->addCookie("a", "1");
+    auto tagged = dynamic_etag::apply(req, resp);
+    auto &etag = tagged->getHeader("etag");
+    CHECK(etag.substr(0, 3) == "W/\"");
+    CHECK(etag.length() == 20);
+    CHECK(tagged->statusCode() == k200OK);
+
+    // The same body is not sent again
+    req->addHeader("If-None-Match", etag);
+    auto again = HttpResponse::newHttpResponse();
+    again->setBody("hello");
+    again->addCookie("a", "1");
+    auto notModified = dynamic_etag::apply(req, again);
+    CHECK(notModified->statusCode() == k304NotModified);
+    CHECK(notModified->getHeader("etag") == etag);
+    CHECK(notModified->getCookie("a").value() == "1");
+    CHECK(req->isNotModified(etag));
+
+    // A changed body or an ETag set by the handler
+    auto changed = HttpResponse::newHttpResponse();
+    changed->setBody("world");
+    CHECK(dynamic_etag::apply(req, changed)->statusCode() == k200OK);
+    auto versioned = HttpResponse::newHttpResponse();
+    versioned->addHeader("ETag", "\"v2\"");
+    req->addHeader("If-None-Match", "\"v1\", \"v2\"");
+    CHECK(dynamic_etag::apply(req, versioned)->statusCode() ==
+          k304NotModified);
+    CHECK(!req->isNotModified("\"v3\""));
+
+    // Only the 200 responses to GET requests
+    auto created = HttpResponse::newHttpResponse();
+    created->setStatusCode(k201Created);
+    CHECK(dynamic_etag::apply(req, created) == created);
+    req->setMethod(Post);
+    CHECK(dynamic_etag::apply(req, changed) == changed);
+}
@@ -0,0 +1,83 @@
+#include <drogon/drogon_test.h>
+#include <drogon/Grpc.h>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+DROGON_TEST(GrpcFramingTest)
+{
+    std::string body;
+    grpc::appendMessage(body, std::string("abc"));
+    grpc::appendMessage(body, std::string());
+    CHECK(body == std::string("\0\0\0\0\x03"
+                              "abc"
+                              "\0\0\0\0\0",
+                              13));
+
+    std::vector<std::string_view> messages;
+    CHECK(grpc::splitFrames(body, messages).ok());
+    CHECK(messages.size() == 2);
+    CHECK(messages[0] == "abc");
+    CHECK(messages[1].empty());
+
+    // A truncated message and a compressed one
+    CHECK(grpc::splitFrames(std::string_view(body).substr(0, 7), messages)
+              .code == grpc::StatusCode::kInternal);
+    body[0] = 1;
+    CHECK(grpc::splitFrames(body, messages).code ==
+          grpc::StatusCode::kUnimplemented);
+}
+
+DROGON_TEST(GrpcTimeoutTest)
+{
+    std::chrono::nanoseconds timeout;
+    CHECK(grpc::parseTimeout("100m", timeout));
+    CHECK(timeout == 100ms);
+    CHECK(grpc::parseTimeout("5S", timeout));
+    CHECK(timeout == 5s);
+    CHECK(grpc::parseTimeout("2H", timeout));
+    CHECK(timeout == 2h);
+    CHECK(!grpc::parseTimeout("5", timeout));
+    CHECK(!grpc::parseTimeout("1x", timeout));
+    CHECK(!grpc::parseTimeout("123456789S", timeout));
+
+    CHECK(grpc::formatTimeout(1500ms) == "1500000u");
+    CHECK(grpc::formatTimeout(200h) == "720000S");
+    CHECK(grpc::parseTimeout(grpc::formatTimeout(123456789012ns), timeout));
+    CHECK(timeout >= 123456789012ns);
+}
+
+DROGON_TEST(GrpcResponseTest)
+{
+    auto resp = grpc::newResponse(std::string("reply"));
+    CHECK(resp->contentTypeString() == "application/grpc");
+    CHECK(resp->trailers().at("grpc-status") == "0");
+    std::string message;
+    CHECK(grpc::parseResponse(resp, message).ok());
+    CHECK(message == "reply");
+
+    resp = grpc::newErrorResponse(grpc::StatusCode::kNotFound, "no 100%");
+    CHECK(resp->getHeader("grpc-message") == "no 100%25");
+    auto status = grpc::statusOf(resp);
+    CHECK(status.code == grpc::StatusCode::kNotFound);
+    CHECK(status.message == "no 100%");
+
+    auto req = grpc::newRequest("/pkg.Service/Method", std::string("hi"), 1s);
+    CHECK(req->method() == Post);
+    CHECK(req->getHeader("te") == "trailers");
+    CHECK(req->getHeader("grpc-timeout") == "1000000u");
+
+    // A request as the server receives it
+    req = HttpRequest::newHttpRequest();
+    req->addHeader("content-type", "application/grpc+proto");
+    req->setBody(std::string("\0\0\0\0\x02"
+                             "hi",
+                             7));
+    CHECK(grpc::parseRequest(req, message).ok());
+    CHECK(message == "hi");
+    req->addHeader("content-type", "application/json");
+    CHECK(grpc::parseRequest(req, message).code ==
+          grpc::StatusCode::kInvalidArgument);
+}
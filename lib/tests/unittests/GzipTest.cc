@@ -1,5 +1,6 @@
 #include <drogon/drogon_test.h>
 #include <drogon/utils/Utilities.h>
+#include <string>
 
 using namespace drogon;
 
@@ -317,3 +318,39 @@ DROGON_TEST(Gzip)
     auto decompressStr = utils::gzipDecompress(ret.data(), ret.length());
     CHECK(inStr == decompressStr);
 }
+
+DROGON_TEST(GzipReuse)
+{
+    // The streams of the thread are reset between the calls, whatever the
+    // levels and sizes
+    std::string text;
+    for (int i = 0; text.size() < 200000; ++i)
+        text.append("line ").append(std::to_string(i * 7919 % 1000)).append(
+            "\n");
+    for (size_t size : {1, 17, 1000, 65536, 200000})
+    {
+        for (int level : {1, 6, 9, 6})
+        {
+            auto compressed = utils::gzipCompress(text.data(), size, level);
+            REQUIRE(!compressed.empty());
+            CHECK(utils::gzipDecompress(compressed.data(),
+                                        compressed.size()) ==
+                  text.substr(0, size));
+        }
+    }
+
+    // A forged size in the trailer is only a hint
+    auto compressed = utils::gzipCompress(text.data(), 1000);
+    compressed[compressed.size() - 4] = 1;
+    compressed[compressed.size() - 3] = 0;
+    compressed[compressed.size() - 2] = 0;
+    compressed[compressed.size() - 1] = 0;
+    CHECK(utils::gzipDecompress(compressed.data(), compressed.size()).empty());
+
+    // Random bytes fail without spoiling the next call
+    std::string garbage(100, '\x1f');
+    CHECK(utils::gzipDecompress(garbage.data(), garbage.size()).empty());
+    compressed = utils::gzipCompress(text.data(), 5000);
+    CHECK(utils::gzipDecompress(compressed.data(), compressed.size()) ==
+          text.substr(0, 5000));
+}
@@ -0,0 +1,122 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HandlerLoopPool.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include "../../lib/src/HttpRequestPool.h"
+#include <drogon/HttpAppFramework.h>
+#include <trantor/net/EventLoopThread.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <set>
+#include <thread>
+
+using namespace drogon;
+
+DROGON_TEST(HandlerLoopPoolTest)
+{
+    trantor::EventLoopThread mainThread("HandlerLoopPoolTest");
+    mainThread.run();
+    auto &pool = HandlerLoopPool::instance();
+    pool.setThreadNum(1, 3);
+    pool.setIdleTimeout(0.5);
+    pool.start(mainThread.getLoop(), 100);
+    REQUIRE(pool.started());
+    CHECK(pool.loopNum() == 1u);
+
+    // Slow handlers add loops, which take the waiting requests
+    constexpr int kTasks = 40;
+    std::atomic<int> counter{0};
+    std::promise<void> finished;
+    std::mutex mutex;
+    std::set<size_t> indexes;
+    trantor::EventLoop *extraLoop{nullptr};
+    for (int i = 0; i < kTasks; ++i)
+    {
+        pool.run([&](trantor::EventLoop *loop) {
+            CHECK(loop->isInLoopThread());
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                indexes.insert(loop->index());
+                if (loop->index() > 100)
+                    extraLoop = loop;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            pool.done(loop);
+            if (counter.fetch_add(1) + 1 == kTasks)
+                finished.set_value();
+        });
+    }
+    REQUIRE(finished.get_future().wait_for(std::chrono::seconds(10)) ==
+            std::future_status::ready);
+    CHECK(pool.queueDepth() == 0u);
+    CHECK(indexes.size() > 1u);
+    CHECK(*indexes.begin() >= 100u);
+    CHECK(*indexes.rbegin() < 103u);
+
+    // The idle loops are retired down to the minimum
+    for (int i = 0; i < 50 && pool.loopNum() > 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(pool.loopNum() == 1u);
+
+    // A retired loop is parked, the timers scheduled in it by the handlers
+    // still run after the next resizes
+    REQUIRE(extraLoop != nullptr);
+    std::promise<void> timerFired;
+    extraLoop->runAfter(1.5, [&timerFired]() { timerFired.set_value(); });
+    CHECK(timerFired.get_future().wait_for(std::chrono::seconds(5)) ==
+          std::future_status::ready);
+
+    // A request handed to a handler loop which is retired before the request
+    // is released goes back to the loop it was acquired in
+    auto ioLoop = app().getLoop();
+    std::promise<HttpRequestImplPtr> acquired;
+    ioLoop->runInLoop([&acquired, ioLoop]() {
+        acquired.set_value(HttpRequestPool::acquire(ioLoop));
+    });
+    auto held = acquired.get_future().get();
+    auto *raw = held.get();
+    std::atomic<bool> handed{false};
+    std::atomic<int> resized{0};
+    std::promise<void> resizedAll;
+    for (int i = 0; i < kTasks; ++i)
+    {
+        pool.run([&, held](trantor::EventLoop *loop) {
+            // Only the first loop is never retired
+            if (loop->index() > 100 && !handed.exchange(true))
+                held->setLoop(loop);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            pool.done(loop);
+            if (resized.fetch_add(1) + 1 == kTasks)
+                resizedAll.set_value();
+        });
+    }
+    REQUIRE(resizedAll.get_future().wait_for(std::chrono::seconds(10)) ==
+            std::future_status::ready);
+    REQUIRE(handed);
+    for (int i = 0; i < 50 && pool.loopNum() > 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(pool.loopNum() == 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    held.reset();
+    std::promise<void> recycled;
+    ioLoop->queueInLoop([TEST_CTX, &recycled, ioLoop, raw]() {
+        auto again = HttpRequestPool::acquire(ioLoop);
+        CHECK(again.get() == raw);
+        CHECK(again->getLoop() == ioLoop);
+        recycled.set_value();
+    });
+    CHECK(recycled.get_future().wait_for(std::chrono::seconds(5)) ==
+          std::future_status::ready);
+
+    std::promise<void> after;
+    pool.run([&pool, &after](trantor::EventLoop *loop) {
+        pool.done(loop);
+        after.set_value();
+    });
+    CHECK(after.get_future().wait_for(std::chrono::seconds(5)) ==
+          std::future_status::ready);
+    mainThread.getLoop()->runInLoop([&pool]() { pool.stop(); });
+    for (int i = 0; i < 50 && pool.started(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(!pool.started());
+}
@@ -0,0 +1,134 @@
+#include "../../lib/src/Hpack.h"
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon;
+
+static std::string fromHex(const std::string &hex)
+{
+    std::string bytes;
+    for (size_t i = 0; i + 1 < hex.length(); i += 2)
+    {
+        bytes.push_back(
+            static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+static bool decode(HpackDecoder &decoder,
+                   const std::string &block,
+                   HpackHeaders &headers)
+{
+    headers.clear();
+    return decoder.decode(reinterpret_cast<const uint8_t *>(block.data()),
+                          block.length(),
+                          headers);
+}
+
+DROGON_TEST(HpackDecoder)
+{
+    // RFC 7541 C.4, requests with Huffman coding sharing a dynamic table
+    HpackDecoder decoder;
+    HpackHeaders headers;
+    REQUIRE(decode(decoder,
+                   fromHex("828684418cf1e3c2e5f23a6ba0ab90f4ff"),
+                   headers));
+    REQUIRE(headers.size() == 4u);
+    CHECK(headers[0] == HpackHeaders::value_type(":method", "GET"));
+    CHECK(headers[1] == HpackHeaders::value_type(":scheme", "http"));
+    CHECK(headers[2] == HpackHeaders::value_type(":path", "/"));
+    CHECK(headers[3] ==
+          HpackHeaders::value_type(":authority", "www.example.com"));
+
+    REQUIRE(decode(decoder, fromHex("828684be5886a8eb10649cbf"), headers));
+    REQUIRE(headers.size() == 5u);
+    CHECK(headers[3] ==
+          HpackHeaders::value_type(":authority", "www.example.com"));
+    CHECK(headers[4] == HpackHeaders::value_type("cache-control", "no-cache"));
+
+    REQUIRE(decode(
+        decoder,
+        fromHex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"),
+        headers));
+    REQUIRE(headers.size() == 5u);
+    CHECK(headers[1] == HpackHeaders::value_type(":scheme", "https"));
+    CHECK(headers[2] == HpackHeaders::value_type(":path", "/index.html"));
+    CHECK(headers[4] ==
+          HpackHeaders::value_type("custom-key", "custom-value"));
+
+    // An index beyond the dynamic table
+    CHECK(!decode(decoder, fromHex("ff00"), headers));
+    // A size update after a field
+    HpackDecoder other;
+    CHECK(!decode(other, fromHex("8220"), headers));
+    // A size update beyond the advertised size
+    CHECK(!decode(other, fromHex("3fe21f"), headers));
+    // A truncated literal
+    CHECK(!decode(other, fromHex("400a637573746f6d"), headers));
+}
+
+DROGON_TEST(HpackRoundTrip)
+{
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    HpackHeaders response{{":status", "200"},
+                          {"content-type", "application/json"},
+                          {"content-length", "1234"},
+                          {"server", "drogon"},
+                          {"set-cookie", "JSESSIONID=1234; path=/"},
+                          {"x-custom", std::string(300, 'x')}};
+    std::string first, second;
+    encoder.encode(response, first);
+    encoder.encode(response, second);
+    // The repeated fields are indexed by the second block
+    CHECK(second.length() < first.length());
+
+    HpackHeaders headers;
+    REQUIRE(decode(decoder, first, headers));
+    CHECK(headers == response);
+    REQUIRE(decode(decoder, second, headers));
+    CHECK(headers == response);
+
+    // The new table size is signaled at the start of the next block
+    encoder.setMaxTableSize(0);
+    std::string third;
+    encoder.encode(response, third);
+    CHECK(static_cast<uint8_t>(third[0]) == 0x20);
+    REQUIRE(decode(decoder, third, headers));
+    CHECK(headers == response);
+}
+
+DROGON_TEST(HpackHuffman)
+{
+    std::string all;
+    for (int c = 0; c < 256; ++c)
+    {
+        all.push_back(static_cast<char>(c));
+    }
+    for (auto &str :
+         {std::string("www.example.com"), std::string("no-cache"), all})
+    {
+        std::string encoded;
+        hpack::huffmanEncode(str, encoded);
+        CHECK(encoded.length() == hpack::huffmanEncodedLength(str));
+        std::string decoded;
+        REQUIRE(hpack::huffmanDecode(
+            reinterpret_cast<const uint8_t *>(encoded.data()),
+            encoded.length(),
+            decoded));
+        CHECK(decoded == str);
+    }
+    std::string decoded;
+    // "a" padded with zeros instead of ones
+    auto badPadding = fromHex("18");
+    CHECK(!hpack::huffmanDecode(
+        reinterpret_cast<const uint8_t *>(badPadding.data()),
+        badPadding.length(),
+        decoded));
+    // A whole byte of padding
+    auto longPadding = fromHex("f1e3c2e5f23a6ba0ab90f4ffff");
+    CHECK(!hpack::huffmanDecode(
+        reinterpret_cast<const uint8_t *>(longPadding.data()),
+        longPadding.length(),
+        decoded));
+}
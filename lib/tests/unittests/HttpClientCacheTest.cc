@@ -0,0 +1,48 @@
+#include "../../lib/src/HttpClientCache.h"
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+
+using namespace drogon;
+
+DROGON_TEST(HttpClientCacheFreshnessTest)
+{
+    constexpr int64_t kSecond = 1000000;
+    auto now = trantor::Date::now().microSecondsSinceEpoch();
+    auto req = HttpRequest::newHttpRequest();
+    auto resp = HttpResponse::newHttpResponse();
+    resp->addHeader("cache-control", "max-age=60, stale-while-revalidate=30");
+    resp->addHeader("age", "10");
+    auto freshness =
+        HttpClientCache::freshnessOf(*req, *resp, now - kSecond, now);
+    CHECK(freshness.storable);
+    CHECK(freshness.lifetime == 60 * kSecond);
+    CHECK(freshness.initialAge == 11 * kSecond);
+    CHECK(freshness.staleWhileRevalidate == 30 * kSecond);
+
+    // The responses shared by no one, or to requests with credentials
+    resp->addHeader("cache-control", "private, max-age=60");
+    CHECK(!HttpClientCache::freshnessOf(*req, *resp, now, now).storable);
+    resp->addHeader("cache-control", "max-age=60");
+    req->addHeader("authorization", "Basic dXNlcg==");
+    CHECK(!HttpClientCache::freshnessOf(*req, *resp, now, now).storable);
+    resp->addHeader("cache-control", "public, max-age=60");
+    CHECK(HttpClientCache::freshnessOf(*req, *resp, now, now).storable);
+    resp->addHeader("vary", "*");
+    CHECK(!HttpClientCache::freshnessOf(*req, *resp, now, now).storable);
+
+    // A tenth of the age of Last-Modified
+    req = HttpRequest::newHttpRequest();
+    resp = HttpResponse::newHttpResponse();
+    resp->addHeader("last-modified",
+                    utils::getHttpFullDate(trantor::Date(now - 100 * kSecond)));
+    freshness = HttpClientCache::freshnessOf(*req, *resp, now, now);
+    CHECK(freshness.storable);
+    CHECK(freshness.lifetime >= 9 * kSecond);
+    CHECK(freshness.lifetime <= 11 * kSecond);
+
+    // No lifetime and no validator
+    resp = HttpResponse::newHttpResponse();
+    CHECK(!HttpClientCache::freshnessOf(*req, *resp, now, now).storable);
+    resp->addHeader("etag", "\"v1\"");
+    CHECK(HttpClientCache::freshnessOf(*req, *resp, now, now).storable);
+}
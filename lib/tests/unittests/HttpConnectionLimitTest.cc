@@ -0,0 +1,33 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpConnectionLimit.h"
+
+using namespace drogon;
+
+DROGON_TEST(HttpConnectionLimitTest)
+{
+    auto &limit = HttpConnectionLimit::instance();
+    limit.setMaxConnectionNumPerIP(2);
+    trantor::InetAddress slow("192.0.2.10", 1000);
+    trantor::InetAddress other("192.0.2.11", 1000);
+
+    CHECK(limit.tryAddConnection(slow));
+    CHECK(limit.tryAddConnection(slow));
+    CHECK(limit.tryAddConnection(slow) == false);
+    limit.releaseConnection(slow);
+    limit.releaseConnection(slow);
+    limit.releaseConnection(slow);
+
+    // A client is refused once it had as many slow connections as it may
+    // open at once
+    limit.addSlowClient(slow);
+    CHECK(limit.tryAddConnection(slow));
+    limit.releaseConnection(slow);
+    limit.addSlowClient(slow);
+    CHECK(limit.tryAddConnection(slow) == false);
+    limit.releaseConnection(slow);
+    CHECK(limit.tryAddConnection(other));
+    limit.releaseConnection(other);
+
+    CHECK(limit.getConnectionNum() == 0u);
+    limit.setMaxConnectionNumPerIP(0);
+}
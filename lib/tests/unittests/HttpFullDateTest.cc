@@ -1,5 +1,8 @@
 #include <drogon/utils/Utilities.h>
 #include <drogon/drogon_test.h>
+#include "../../lib/src/HttpDateCache.h"
+#include <trantor/net/EventLoopThread.h>
+#include <future>
 #include <string>
 #include <iostream>
 
@@ -11,3 +14,29 @@ DROGON_TEST(HttpFullDateTest)
     auto date = utils::getHttpDate(str);
     CHECK(utils::getHttpFullDate(date) == str);
 }
+
+DROGON_TEST(HttpDateCacheTest)
+{
+    auto seconds = [](const std::string &date) {
+        return utils::getHttpDate(date).microSecondsSinceEpoch() /
+               trantor::Date::MICRO_SECONDS_PER_SEC;
+    };
+    // Formatted on demand outside of the loops
+    std::string date(HttpDateCache::date(), HttpDateCache::length());
+    CHECK(HttpDateCache::second() - seconds(date) <= 1);
+
+    trantor::EventLoopThread thread;
+    thread.run();
+    auto loop = thread.getLoop();
+    std::promise<std::pair<std::string, int64_t>> started;
+    loop->queueInLoop([loop, &started]() {
+        HttpDateCache::start(loop);
+        started.set_value({std::string(HttpDateCache::date(),
+                                       HttpDateCache::length()),
+                           HttpDateCache::second()});
+    });
+    auto result = started.get_future().get();
+    CHECK(seconds(result.first) == result.second);
+    CHECK(result.second - seconds(date) <= 1);
+    loop->quit();
+}
@@ -0,0 +1,101 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpHeaderIds.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include <atomic>
+#include <cctype>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(HttpHeaderIdsTest)
+{
+    for (size_t i = 1; i < static_cast<size_t>(HttpHeaderId::kCount); ++i)
+    {
+        auto id = static_cast<HttpHeaderId>(i);
+        std::string name = httpHeaderName(id);
+        CHECK(findHttpHeaderId(name) == id);
+        for (auto &c : name)
+            c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        CHECK(findHttpHeaderId(name) == id);
+    }
+    for (auto name : {"", "x-foo", "dnt", "content-typ", "content-types"})
+        CHECK(findHttpHeaderId(name) == HttpHeaderId::kUnknown);
+
+    HttpRequestImpl req(nullptr);
+    auto addHeader = [&req](const std::string &line) {
+        auto colon = line.find(':');
+        req.addHeader(line.data(),
+                      line.data() + colon,
+                      line.data() + line.length());
+    };
+    addHeader("Host: example.com");
+    addHeader("Accept-Encoding: gzip, br");
+    addHeader("X-Custom: 1");
+    addHeader("accept-encoding: zstd");
+    CHECK(req.getHeaderView(HttpHeaderId::kHost) == "example.com");
+    // The first one, as in the header map
+    CHECK(req.getHeaderView(HttpHeaderId::kAcceptEncoding) == "gzip, br");
+    CHECK(req.getHeaderView("accept-encoding") == "gzip, br");
+    CHECK(req.getHeaderView(HttpHeaderId::kContentType).empty());
+    CHECK(req.getHeaderView("x-custom") == "1");
+
+    // The same values from the header map
+    CHECK(req.headers().size() == 3);
+    CHECK(req.getHeaderView(HttpHeaderId::kHost) == "example.com");
+    CHECK(req.getHeaderView(HttpHeaderId::kAcceptEncoding) == "gzip, br");
+
+    req.reset();
+    addHeader("Content-Type: text/plain");
+    CHECK(req.getHeaderView(HttpHeaderId::kContentType) == "text/plain");
+    CHECK(req.getHeaderView(HttpHeaderId::kHost).empty());
+}
+
+DROGON_TEST(HttpHeaderConcurrentReadTest)
+{
+    // The const getters build the maps of a parsed request, the first reader
+    // does it while the others wait or read the raw headers
+    HttpRequestImpl req(nullptr);
+    for (std::string line : {"Host: example.com",
+                             "X-Custom: 1",
+                             "Cookie: a=1; b=2",
+                             "Cookie: c=3"})
+    {
+        auto colon = line.find(':');
+        req.addHeader(line.data(),
+                      line.data() + colon,
+                      line.data() + line.length());
+    }
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&req, &failures, i]() {
+            const HttpRequestImpl &reader = req;
+            bool ok;
+            if (i % 2 == 0)
+            {
+                ok = reader.getHeaderView("x-custom") == "1" &&
+                     reader.getHeader("host") == "example.com" &&
+                     reader.getCookieView("c") == "3" &&
+                     reader.getCookie("b") == "2";
+            }
+            else
+            {
+                ok = reader.headers().size() == 2 &&
+                     reader.getHeaderView(HttpHeaderId::kHost) ==
+                         "example.com" &&
+                     reader.cookies().size() == 3 &&
+                     reader.getCookieView("a") == "1";
+            }
+            if (!ok)
+                ++failures;
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    CHECK(failures == 0);
+    CHECK(req.getHeader("x-custom") == "1");
+    CHECK(req.getCookie("a") == "1");
+}
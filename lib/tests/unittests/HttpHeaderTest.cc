@@ -1,7 +1,10 @@
 #include <drogon/drogon_test.h>
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpResponse.h>
+#include "../../lib/src/HttpAppFrameworkImpl.h"
 #include "../../lib/src/HttpResponseImpl.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include "../../lib/src/HttpUtils.h"
 
 using namespace drogon;
 
@@ -16,6 +19,36 @@ DROGON_TEST(HttpHeaderRequest)
     CHECK(req->getHeader("abc") == "");
 }
 
+DROGON_TEST(HttpHeaderRequestParsed)
+{
+    HttpRequestImpl req(nullptr);
+    auto addLine = [&req](const std::string &line) {
+        auto colon = line.find(':');
+        req.addHeader(line.data(),
+                      line.data() + colon,
+                      line.data() + line.length());
+    };
+    addLine("Host: example.com");
+    addLine("X-Custom-Header:  value with spaces  ");
+    addLine("x-custom-header: duplicated");
+    addLine("Cookie: a=1; b=2");
+
+    // Lookups on the raw header slices
+    CHECK(req.getHeaderView("host") == "example.com");
+    CHECK(req.getHeaderView("x-custom-header") == "value with spaces");
+    CHECK(req.getHeaderView("cookie").empty());
+    CHECK(req.getCookie("b") == "2");
+
+    // The map is built on demand and keeps the same content
+    CHECK(req.getHeader("X-CUSTOM-HEADER") == "value with spaces");
+    CHECK(req.headers().size() == 2);
+    CHECK(req.getHeaderView("host") == "example.com");
+
+    req.removeHeader("Host");
+    CHECK(req.getHeaderView("host").empty());
+    CHECK(req.getHeader("host") == "");
+}
+
 DROGON_TEST(HttpHeaderResponse)
 {
     auto resp = std::dynamic_pointer_cast<HttpResponseImpl>(
@@ -37,6 +70,47 @@ DROGON_TEST(HttpHeaderResponse)
     CHECK(resp->getHeader("abc") == "");
 }
 
+DROGON_TEST(HttpResponseSeparateBody)
+{
+    auto resp = std::dynamic_pointer_cast<HttpResponseImpl>(
+        HttpResponse::newHttpResponse());
+    REQUIRE(resp != nullptr);
+    resp->setBody("small");
+    CHECK(resp->sendBodySeparately() == false);
+
+    std::string body(HttpResponseImpl::separateBodyThreshold(), 'x');
+    resp->setBody(body);
+    CHECK(resp->sendBodySeparately() == true);
+    auto shared = resp->sharedBodyString();
+    REQUIRE(shared != nullptr);
+    CHECK(shared->data() == resp->getBodyData());
+
+    trantor::MsgBuffer header;
+    resp->renderHeaderToBuffer(header);
+    trantor::MsgBuffer full;
+    resp->renderToBuffer(full);
+    auto headerStr = std::string{header.peek(), header.readableBytes()};
+    auto fullStr = std::string{full.peek(), full.readableBytes()};
+    // The Date header may differ, so only compare the lengths and the body
+    CHECK(fullStr.length() == headerStr.length() + body.length());
+    CHECK(fullStr.compare(headerStr.length(), body.length(), body) == 0);
+
+    // A shared body is sent without being copied
+    auto sharedBody = std::make_shared<const std::string>(body);
+    resp->setSharedBody(sharedBody);
+    CHECK(resp->body() == body);
+    CHECK(resp->sendBodySeparately() == true);
+    CHECK(resp->sharedBodyString().get() == sharedBody.get());
+
+    // Cached responses send their large bodies after the header too, so the
+    // clones of the IO threads share them
+    resp->setExpiredTime(0);
+    CHECK(resp->sendBodySeparately() == true);
+    HttpResponseImpl clone(*resp);
+    CHECK(clone.sendBodySeparately() == true);
+    CHECK(clone.sharedBodyString().get() == sharedBody.get());
+}
+
 DROGON_TEST(ResponseSetCustomContentTypeString)
 {
     auto resp = HttpResponse::newHttpResponse();
@@ -66,3 +140,63 @@ DROGON_TEST(ResquestSetCustomContentTypeString)
     req->setContentTypeString("thisdoesnotexist/unknown");
     CHECK(req->getContentType() == CT_CUSTOM);
 }
+
+DROGON_TEST(HttpHeaderEarlyHints)
+{
+    HttpRequestImpl req(nullptr);
+    std::vector<std::string> sent;
+    // Ignored until the server sets the sender
+    req.sendEarlyHints({"</a.css>; rel=preload; as=style"});
+    req.setEarlyHintsSender(
+        [&sent](std::string &&hints) { sent.push_back(std::move(hints)); });
+    req.setVersion(Version::kHttp11);
+    req.sendEarlyHints(
+        {"</a.css>; rel=preload; as=style", "</b.js>\r\nX: y", ""});
+    REQUIRE(sent.size() == 1);
+    CHECK(sent[0] ==
+          "HTTP/1.1 103 Early Hints\r\n"
+          "Link: </a.css>; rel=preload; as=style\r\n\r\n");
+
+    req.sendEarlyHints({"</b.js>\r\nX: y"});
+    CHECK(sent.size() == 1);
+    req.setVersion(Version::kHttp10);
+    req.sendEarlyHints({"</a.css>; rel=preload; as=style"});
+    CHECK(sent.size() == 1);
+    req.setVersion(Version::kHttp11);
+    req.closeEarlyHints();
+    req.sendEarlyHints({"</a.css>; rel=preload; as=style"});
+    CHECK(sent.size() == 1);
+}
+
+DROGON_TEST(HttpHeaderAltSvc)
+{
+    // The HTTP/3 listeners add their ports once
+    auto header = addHttp3AltSvc("", 443);
+    CHECK(header == "alt-svc: h3=\":443\"; ma=86400\r\n");
+    header = addHttp3AltSvc(header, 8443);
+    CHECK(header ==
+          "alt-svc: h3=\":443\"; ma=86400, h3=\":8443\"; ma=86400\r\n");
+    CHECK(addHttp3AltSvc(header, 443) == header);
+    CHECK(addHttp3AltSvc(header, 44) != header);
+
+    // And every response advertises them, unless it has its own Alt-Svc
+    auto &app = HttpAppFrameworkImpl::instance();
+    app.setAltSvcHeader(addHttp3AltSvc("", 443));
+    auto resp = std::make_shared<HttpResponseImpl>();
+    resp->setBody("h3");
+    auto buffer = resp->renderToBuffer();
+    std::string rendered(buffer->peek(), buffer->readableBytes());
+    CHECK(rendered.find("alt-svc: h3=\":443\"; ma=86400\r\n") !=
+          std::string::npos);
+
+    resp = std::make_shared<HttpResponseImpl>();
+    resp->addHeader("Alt-Svc", "clear");
+    buffer = resp->renderToBuffer();
+    rendered.assign(buffer->peek(), buffer->readableBytes());
+    CHECK(rendered.find("h3=") == std::string::npos);
+    CHECK(rendered.find("alt-svc: clear\r\n") != std::string::npos);
+    app.setAltSvcHeader("");
+
+    resp->setVersion(Version::kHttp3);
+    CHECK(std::string(resp->versionString()) == "HTTP/3");
+}
@@ -0,0 +1,49 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpScanner.h"
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(HttpScannerTest)
+{
+    MANDATE(http_scanner::implementationName() != nullptr);
+
+    // Check every position across the 16 and 32 byte vector widths
+    for (size_t len = 2; len < 80; ++len)
+    {
+        for (size_t pos = 0; pos + 1 < len; ++pos)
+        {
+            std::string str(len, 'a');
+            str[pos] = '\r';
+            str[pos + 1] = '\n';
+            auto begin = str.data();
+            auto end = str.data() + str.length();
+            CHECK(http_scanner::findCRLF(begin, end) == begin + pos);
+            CHECK(http_scanner::findChar(begin, end, '\n') == begin + pos + 1);
+            CHECK(http_scanner::findChar(begin, end, ':') == end);
+        }
+    }
+
+    std::string lone = std::string(40, 'x') + "\r" + std::string(40, 'y');
+    CHECK(http_scanner::findCRLF(lone.data(),
+                                 lone.data() + lone.length()) == nullptr);
+    std::string trailing = std::string(31, 'x') + "\r";
+    CHECK(http_scanner::findCRLF(trailing.data(),
+                                 trailing.data() + trailing.length()) ==
+          nullptr);
+    std::string twice = "a\rb\r\n";
+    CHECK(http_scanner::findCRLF(twice.data(),
+                                 twice.data() + twice.length()) ==
+          twice.data() + 3);
+
+    auto isToken = [](const std::string &str) {
+        return http_scanner::isToken(str.data(), str.data() + str.length());
+    };
+    CHECK(isToken("Content-Type"));
+    CHECK(isToken("x_custom.header~1"));
+    CHECK(!isToken(""));
+    CHECK(!isToken("Content Type"));
+    CHECK(!isToken("Host "));
+    CHECK(!isToken("a(b)"));
+    CHECK(!isToken("caf\xc3\xa9"));
+}
@@ -0,0 +1,42 @@
+#include <drogon/drogon_test.h>
+#include <drogon/IOThreadStorage.h>
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+using namespace drogon;
+
+namespace
+{
+struct Flags
+{
+    int value;
+};
+}  // namespace
+
+DROGON_TEST(IOThreadSnapshotTest)
+{
+    IOThreadSnapshot<Flags> flags(std::make_shared<Flags>(Flags{1}));
+
+    // Off the loops, a raw pointer could be freed by a concurrent publish()
+    CHECK_THROWS_AS(flags.get(), std::logic_error);
+    CHECK(flags->value == 1);
+    CHECK(flags.getShared()->value == 1);
+
+    // The version read through operator->() is kept alive while it is used
+    auto pinned = flags.operator->();
+    std::weak_ptr<const Flags> first = flags.getShared();
+    flags.publish(std::make_shared<Flags>(Flags{2}));
+    CHECK(!first.expired());
+    CHECK(pinned->value == 1);
+    CHECK(flags->value == 2);
+    CHECK(flags.getShared()->value == 2);
+
+    // The main loop reads its own slot, updated before the task runs
+    std::promise<int> read;
+    app().getLoop()->queueInLoop([TEST_CTX, &flags, &read]() {
+        CHECK(flags.get() == flags.getShared().get());
+        read.set_value(flags->value + (*flags).value);
+    });
+    CHECK(read.get_future().get() == 4);
+}
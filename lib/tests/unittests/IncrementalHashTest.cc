@@ -0,0 +1,87 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Hasher.h>
+#include <drogon/utils/Utilities.h>
+#include "../../lib/src/IncrementalHash.h"
+#include <algorithm>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(IncrementalHashTest)
+{
+    std::string data;
+    for (int i = 0; i < 1000; ++i)
+        data.push_back(static_cast<char>(i * 131 + 7));
+
+    // Every padding case around the 56 and 64 byte boundaries, fed in pieces
+    // not aligned to the blocks
+    for (size_t len : {0, 1, 55, 56, 63, 64, 65, 119, 120, 1000})
+    {
+        for (size_t step : {1, 7, 64, 1000})
+        {
+            Md5Hash md5;
+            Sha256Hash sha256;
+            for (size_t pos = 0; pos < len; pos += step)
+            {
+                auto n = (std::min)(step, len - pos);
+                md5.update(data.data() + pos, n);
+                sha256.update(data.data() + pos, n);
+            }
+            CHECK(md5.hexDigest() == utils::getMd5(data.data(), len));
+            CHECK(sha256.hexDigest() == utils::getSha256(data.data(), len));
+        }
+    }
+
+    Sha256Hash abc;
+    abc.update("abc", 3);
+    CHECK(abc.hexDigest() ==
+          "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD");
+}
+
+DROGON_TEST(HasherTest)
+{
+    using utils::HashAlgorithm;
+    std::string data;
+    for (int i = 0; i < 1000; ++i)
+        data.push_back(static_cast<char>(i * 131 + 7));
+    std::pair<HashAlgorithm, std::string (*)(const char *, size_t)>
+        algorithms[] = {{HashAlgorithm::kMd5, utils::getMd5},
+                        {HashAlgorithm::kSha1, utils::getSha1},
+                        {HashAlgorithm::kSha256, utils::getSha256},
+                        {HashAlgorithm::kSha3, utils::getSha3},
+                        {HashAlgorithm::kBlake2b, utils::getBlake2b}};
+    for (auto &algorithm : algorithms)
+    {
+        // Reused after every digest, SHA3 absorbs 136 bytes and BLAKE2b 128
+        // bytes blocks
+        utils::Hasher hasher(algorithm.first);
+        for (size_t len : {0, 1, 56, 64, 127, 128, 129, 135, 136, 137, 1000})
+        {
+            for (size_t step : {1, 7, 128, 1000})
+            {
+                for (size_t pos = 0; pos < len; pos += step)
+                {
+                    hasher.update(data.data() + pos,
+                                  (std::min)(step, len - pos));
+                }
+                CHECK(hasher.hexDigest() ==
+                      algorithm.second(data.data(), len));
+            }
+        }
+    }
+
+    utils::Hasher sha1(HashAlgorithm::kSha1);
+    sha1.update("abc");
+    unsigned char digest[utils::Hasher::kMaxDigestLength];
+    CHECK(sha1.final(digest) == 20);
+    CHECK(utils::binaryStringToHex(digest, 20) ==
+          "A9993E364706816ABA3E25717850C26C9CD0D89D");
+    utils::Hasher sha3(HashAlgorithm::kSha3);
+    sha3.update("abc");
+    CHECK(sha3.hexDigest() ==
+          "3A985DA74FE225B2045C172D6BD390BD855F086E3E9D525B46BFE24511431532");
+    utils::Hasher blake2b(HashAlgorithm::kBlake2b);
+    blake2b.update("abc");
+    CHECK(blake2b.hexDigest() ==
+          "BDDD813C634239723171EF3FEE98579B94964E3BB1CB3E427262C8C068D52319");
+}
@@ -0,0 +1,40 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace drogon;
+
+DROGON_TEST(IoThreadsAffinityTest)
+{
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    REQUIRE(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    const auto setSize = static_cast<unsigned int>(CPU_SETSIZE);
+    std::vector<unsigned int> available;
+    unsigned int unavailable = setSize;
+    for (unsigned int cpu = 0; cpu < setSize; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &allowed))
+            available.push_back(cpu);
+        else if (unavailable == setSize)
+            unavailable = cpu;
+    }
+
+    // The CPUs out of the affinity mask of the process, which may be below
+    // the count of the online CPUs in a cpuset, and those out of a cpu_set_t
+    // are dropped
+    auto requested = available;
+    requested.push_back(setSize);
+    if (unavailable < setSize)
+        requested.push_back(unavailable);
+    app().setIoThreadsAffinity(requested);
+    CHECK(app().getIoThreadsAffinity() == available);
+
+    app().setIoThreadsAffinity({});
+    CHECK(app().getIoThreadsAffinity().empty());
+#endif
+}
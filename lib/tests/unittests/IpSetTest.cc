@@ -0,0 +1,64 @@
+#include <drogon/drogon_test.h>
+#include <drogon/IpSet.h>
+#include <stdexcept>
+
+using namespace drogon;
+
+DROGON_TEST(IpSetTest)
+{
+    IpSet ips;
+    ips.add("10.0.0.0/8");
+    ips.add("192.168.1.7");
+    ips.add("172.16.0.0/12");
+    ips.add("2001:db8::/32");
+    CHECK(ips.size() == 4);
+
+    CHECK(ips.contains("10.255.1.2"));
+    CHECK(!ips.contains("11.0.0.1"));
+    CHECK(ips.contains("192.168.1.7"));
+    CHECK(!ips.contains("192.168.1.8"));
+    CHECK(ips.contains("172.31.255.255"));
+    CHECK(!ips.contains("172.32.0.0"));
+    CHECK(ips.contains("2001:db8:1::5"));
+    CHECK(!ips.contains("2001:db9::1"));
+    CHECK(!ips.contains("not an ip"));
+    // IPv4-mapped IPv6 addresses are looked up as IPv4 ones
+    CHECK(ips.contains("::ffff:10.1.1.1"));
+    CHECK(ips.contains(trantor::InetAddress("10.2.3.4", 0)));
+    CHECK(ips.contains(trantor::InetAddress("2001:db8::1", 0, true)));
+    CHECK(!ips.contains(trantor::InetAddress("::1", 0, true)));
+
+    // A covering block replaces the blocks it covers
+    ips.add("192.168.0.0/16");
+    CHECK(ips.contains("192.168.200.1"));
+    CHECK(ips.contains("192.168.1.7"));
+
+    CHECK_THROWS_AS(ips.add("1.2.3.4/33"), std::runtime_error);
+    CHECK_THROWS_AS(ips.add("2001:db8::/129"), std::runtime_error);
+    CHECK_THROWS_AS(ips.add("1.2.3/8"), std::runtime_error);
+
+    IpSet all;
+    all.add("0.0.0.0/0");
+    CHECK(all.contains("8.8.8.8"));
+    CHECK(!all.contains("::2"));
+
+    auto moved = std::move(ips);
+    CHECK(moved.contains("10.1.1.1"));
+    CHECK(ips.empty());
+    CHECK(!ips.contains("10.1.1.1"));
+}
+
+DROGON_TEST(IpSetLinesTest)
+{
+    IpSet ips;
+    CHECK(ips.addLines("# A threat feed\n"
+                       "1.2.3.0/24 ; SBL1\r\n"
+                       "\n"
+                       "  5.6.7.8  \n"
+                       "2001:db8::1") == 3);
+    CHECK(ips.contains("1.2.3.200"));
+    CHECK(ips.contains("5.6.7.8"));
+    CHECK(!ips.contains("5.6.7.9"));
+    CHECK(ips.contains("2001:db8::1"));
+    CHECK_THROWS_AS(ips.addLines("1.2.3.4\nbad\n"), std::runtime_error);
+}
@@ -0,0 +1,87 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/JsonBackend.h>
+#include <drogon/HttpAppFramework.h>
+#include "../../lib/src/HttpRequestImpl.h"
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(JsonBackendTest)
+{
+    auto jsoncpp = JsonBackend::create("jsoncpp");
+    MANDATE(jsoncpp);
+    CHECK(JsonBackend::create("unknown") == nullptr);
+    CHECK(std::string(app().getJsonBackend()->name()) == "jsoncpp");
+
+    const std::string doc =
+        R"({"a":[1,{"x/y":{"z":[5,6]}}],"":3,"m~n":4})";
+    Json::Value root;
+    std::string errs;
+    MANDATE(jsoncpp->parse(doc, root, errs));
+    CHECK(jsoncpp->write(root) ==
+          R"({"":3,"a":[1,{"x/y":{"z":[5,6]}}],"m~n":4})");
+    CHECK(!jsoncpp->parse("[1,", root, errs));
+    CHECK(!errs.empty());
+
+    SUBSECTION(Pointer)
+    {
+        CHECK(JsonBackend::resolve(root, "") == &root);
+        CHECK(JsonBackend::resolve(root, "/a/1/x~1y/z/1")->asInt() == 6);
+        CHECK(JsonBackend::resolve(root, "/")->asInt() == 3);
+        CHECK(JsonBackend::resolve(root, "/m~0n")->asInt() == 4);
+        CHECK(JsonBackend::resolve(root, "/a/01") == nullptr);
+        CHECK(JsonBackend::resolve(root, "/a/2") == nullptr);
+        CHECK(JsonBackend::resolve(root, "/a/-") == nullptr);
+        CHECK(JsonBackend::resolve(root, "/a/1/x~2y") == nullptr);
+        CHECK(JsonBackend::resolve(root, "a") == nullptr);
+
+        Json::Value value;
+        CHECK(jsoncpp->parseAt(doc, "/a/1/x~1y", value));
+        CHECK(value["z"][0].asInt() == 5);
+        CHECK(!jsoncpp->parseAt(doc, "/b", value));
+    }
+
+    SUBSECTION(Simdjson)
+    {
+        // Only in the builds with simdjson
+        auto simdjson = JsonBackend::create("simdjson");
+        if (simdjson)
+        {
+            // The documents simdjson rejects are parsed by jsoncpp
+            for (auto &input : {doc,
+                                std::string("// comment\n{\"a\":1}"),
+                                std::string("{\"a\":1} trailing"),
+                                std::string("123456789012345678901234567890"),
+                                std::string("{\"a\":1,\"a\":-2.5e3}"),
+                                std::string("[1,")})
+            {
+                Json::Value expected, actual;
+                std::string expectedErrs, actualErrs;
+                CHECK(jsoncpp->parse(input, expected, expectedErrs) ==
+                      simdjson->parse(input, actual, actualErrs));
+                CHECK(expected == actual);
+                CHECK(expectedErrs == actualErrs);
+            }
+            Json::Value value;
+            CHECK(simdjson->parseAt(doc, "/a/1/x~1y/z", value));
+            CHECK(value.size() == 2);
+            CHECK(!simdjson->parseAt(doc, "/a/01", value));
+        }
+    }
+
+    SUBSECTION(Request)
+    {
+        HttpRequestImpl req(nullptr);
+        req.setContentTypeCode(CT_APPLICATION_JSON);
+        req.setBody(doc);
+        CHECK(req.getJsonAt("/a/1/x~1y/z/0")->asInt() == 5);
+        CHECK(!req.getJsonAt("/b"));
+        MANDATE(req.getJsonObject());
+        CHECK(req.getJsonAt("/m~0n")->asInt() == 4);
+
+        HttpRequestImpl text(nullptr);
+        text.setContentTypeCode(CT_TEXT_PLAIN);
+        text.setBody(doc);
+        CHECK(!text.getJsonAt(""));
+    }
+}
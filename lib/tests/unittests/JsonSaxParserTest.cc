@@ -0,0 +1,152 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/JsonSaxParser.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+// Rebuild the document in its compact form
+struct CompactWriter : public JsonSaxHandler
+{
+    bool onStartObject() override
+    {
+        value("{");
+        first_.push_back(true);
+        return true;
+    }
+
+    bool onEndObject() override
+    {
+        out += '}';
+        first_.pop_back();
+        return true;
+    }
+
+    bool onStartArray() override
+    {
+        value("[");
+        first_.push_back(true);
+        return true;
+    }
+
+    bool onEndArray() override
+    {
+        out += ']';
+        first_.pop_back();
+        return true;
+    }
+
+    bool onKey(std::string_view key) override
+    {
+        value("\"" + std::string(key) + "\":");
+        afterKey_ = true;
+        return true;
+    }
+
+    bool onString(std::string_view str) override
+    {
+        value("\"" + std::string(str) + "\"");
+        return true;
+    }
+
+    bool onNumber(std::string_view number) override
+    {
+        value(std::string(number));
+        return true;
+    }
+
+    bool onBool(bool b) override
+    {
+        value(b ? "true" : "false");
+        return true;
+    }
+
+    bool onNull() override
+    {
+        value("null");
+        return true;
+    }
+
+    void value(const std::string &text)
+    {
+        if (afterKey_)
+            afterKey_ = false;
+        else if (!first_.back())
+            out += ',';
+        first_.back() = false;
+        out += text;
+    }
+
+    std::string out;
+
+  private:
+    std::vector<bool> first_{true};
+    bool afterKey_{false};
+};
+
+bool parseInPieces(const std::string &doc, size_t step, std::string *out)
+{
+    CompactWriter writer;
+    JsonSaxParser parser(writer, 8);
+    for (size_t pos = 0; pos < doc.size(); pos += step)
+    {
+        if (!parser.parse(doc.data() + pos, (std::min)(step, doc.size() - pos)))
+            return false;
+    }
+    if (!parser.finish())
+        return false;
+    if (out)
+        *out = writer.out;
+    return true;
+}
+}  // namespace
+
+DROGON_TEST(JsonSaxParserTest)
+{
+    const std::string doc =
+        " {\"a\" : [1, -2.5e+3, 0, true, false, null, "
+        "\"x\\\"\\n\\u00e9\\ud83d\\ude00\"], \"b\":{}, \"c\":[], "
+        "\"d\":{\"e\":[[]]}} ";
+    const std::string compact =
+        "{\"a\":[1,-2.5e+3,0,true,false,null,"
+        "\"x\"\n\xc3\xa9\xf0\x9f\x98\x80\"],\"b\":{},\"c\":[],"
+        "\"d\":{\"e\":[[]]}}";
+    // Every token split across pieces
+    for (size_t step : {1, 2, 3, 5, 1000})
+    {
+        std::string out;
+        CHECK(parseInPieces(doc, step, &out));
+        CHECK(out == compact);
+    }
+
+    for (auto good : {"1", " -0.5E-2 ", "\"s\"", "null", "[]", "{}"})
+    {
+        CHECK(parseInPieces(good, 1, nullptr));
+        CHECK(parseInPieces(good, 100, nullptr));
+    }
+
+    for (auto bad : {"",
+                     "{",
+                     "[1,]",
+                     "{\"a\"}",
+                     "{\"a\":1,}",
+                     "01",
+                     "1.",
+                     "-",
+                     "tru",
+                     "truex",
+                     "[1 2]",
+                     "[}",
+                     "1 2",
+                     "\"\\ud83d\"",
+                     "\"\\x\"",
+                     "\"a\nb\"",
+                     "[[[[[[[[[1]]]]]]]]]"})
+    {
+        CHECK(!parseInPieces(bad, 1, nullptr));
+        CHECK(!parseInPieces(bad, 100, nullptr));
+    }
+}
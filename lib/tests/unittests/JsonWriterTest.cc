@@ -0,0 +1,61 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/JsonWriter.h>
+#include <json/json.h>
+#include <limits>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(JsonWriterTest)
+{
+    std::string out;
+    {
+        JsonWriter writer(out);
+        writer.startObject();
+        writer.key("int").value(-42);
+        writer.key("uint").value(std::numeric_limits<uint64_t>::max());
+        writer.key("real").value(1.5);
+        writer.key("whole").value(2.0);
+        writer.key("fraction").value(0.25);
+        writer.key("large").value(1e22);
+        writer.key("nan").value(std::numeric_limits<double>::quiet_NaN());
+        writer.key("bool").value(true);
+        writer.key("null").value(nullptr);
+        writer.key("str").value("a\"b\\c\n\x01 \xe4\xb8\xad");
+        writer.key("empty").startArray().endArray();
+        writer.key("list").startArray();
+        writer.value(1).value("two").startObject().endObject();
+        writer.endArray();
+        writer.key("raw").rawValue("{\"x\":1}");
+        writer.endObject();
+    }
+    CHECK(out ==
+          "{\"int\":-42,\"uint\":18446744073709551615,\"real\":1.5,"
+          "\"whole\":2.0,\"fraction\":0.25,\"large\":1e+22,\"nan\":null,"
+          "\"bool\":true,\"null\":null,"
+          "\"str\":\"a\\\"b\\\\c\\n\\u0001 \xe4\xb8\xad\",\"empty\":[],"
+          "\"list\":[1,\"two\",{}],\"raw\":{\"x\":1}}");
+
+    // The output can be read back by jsoncpp
+    Json::Value root;
+    std::string errs;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    REQUIRE(reader->parse(out.data(), out.data() + out.size(), &root, &errs));
+    CHECK(root["int"].asInt() == -42);
+    CHECK(root["str"].asString() == "a\"b\\c\n\x01 \xe4\xb8\xad");
+    CHECK(root["list"][1].asString() == "two");
+
+    // A Json::Value is written as an equivalent document
+    std::string copy;
+    {
+        JsonWriter writer(copy);
+        writer.value(root);
+    }
+    Json::Value copyRoot;
+    REQUIRE(reader->parse(copy.data(),
+                          copy.data() + copy.size(),
+                          &copyRoot,
+                          &errs));
+    CHECK(copyRoot == root);
+}
@@ -0,0 +1,82 @@
+#include <drogon/drogon_test.h>
+#include <drogon/JwtAuthMiddleware.h>
+#include <drogon/utils/Utilities.h>
+#include <chrono>
+#include <string>
+
+using namespace drogon;
+
+static std::string makeToken(const HmacJwtVerifier &verifier,
+                             const std::string &payload)
+{
+    auto input =
+        utils::base64EncodeUnpadded(R"({"alg":"HS256","typ":"JWT"})", true) +
+        "." + utils::base64EncodeUnpadded(payload, true);
+    return input + "." +
+           utils::base64EncodeUnpadded(verifier.sign(input), true);
+}
+
+DROGON_TEST(JwtAuthMiddlewareTest)
+{
+    auto verifier =
+        std::make_shared<HmacJwtVerifier>("your-256-bit-secret");
+    JwtAuthMiddleware middleware({verifier});
+    Json::Value claims;
+    int64_t expiry;
+
+    // The example token of RFC 7519 debuggers
+    std::string token =
+        "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9."
+        "eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4gRG9lIiwiaWF0IjoxNTE2MjM5"
+        "MDIyfQ.SflKxwRJSMeKKF2QT4fwpMeJf36POk6yJV_adQssw5c";
+    REQUIRE(middleware.verify(token, claims, expiry));
+    CHECK(claims["sub"].asString() == "1234567890");
+    CHECK(claims["name"].asString() == "John Doe");
+    CHECK(expiry == 0);
+
+    // A tampered payload or signature
+    auto tampered = token;
+    tampered[40] = tampered[40] == 'A' ? 'B' : 'A';
+    CHECK(!middleware.verify(tampered, claims, expiry));
+    tampered = token;
+    auto &c = tampered[tampered.length() - 10];
+    c = c == 'A' ? 'B' : 'A';
+    CHECK(!middleware.verify(tampered, claims, expiry));
+    CHECK(!middleware.verify("abc.def", claims, expiry));
+
+    // Another secret
+    JwtAuthMiddleware other({std::make_shared<HmacJwtVerifier>("secret")});
+    CHECK(!other.verify(token, claims, expiry));
+
+    // An algorithm without verifier
+    auto none = utils::base64EncodeUnpadded(R"({"alg":"none"})", true) + "." +
+                utils::base64EncodeUnpadded(R"({"sub":"1"})", true) + ".";
+    CHECK(!middleware.verify(none, claims, expiry));
+
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count();
+    auto valid = makeToken(*verifier,
+                           R"({"sub":"2","exp":)" + std::to_string(now + 60) +
+                               "}");
+    REQUIRE(middleware.verify(valid, claims, expiry));
+    CHECK(claims["sub"].asString() == "2");
+    CHECK(expiry == now + 60);
+
+    auto expired = makeToken(*verifier,
+                             R"({"sub":"2","exp":)" +
+                                 std::to_string(now - 1) + "}");
+    CHECK(!middleware.verify(expired, claims, expiry));
+    auto early = makeToken(*verifier,
+                           R"({"sub":"2","nbf":)" + std::to_string(now + 60) +
+                               "}");
+    CHECK(!middleware.verify(early, claims, expiry));
+
+    // A secret longer than the block is replaced by its digest
+    HmacJwtVerifier longVerifier(std::string(100, 'k'));
+    auto signature = longVerifier.sign("data");
+    CHECK(utils::binaryStringToHex(
+              reinterpret_cast<const unsigned char *>(signature.data()),
+              signature.length()) ==
+          "09380EE4B802DA2363BC96E8E0D133BA275458EA8DDBC564F986FC12B31F8CB1");
+}
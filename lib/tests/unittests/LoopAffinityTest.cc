@@ -0,0 +1,61 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpRequestImpl.h"
+#include "../../lib/src/LoopAffinity.h"
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(LoopAffinityTest)
+{
+    LoopAffinity affinity;
+    CHECK(affinity.setKey(""));
+    CHECK(!affinity.enabled());
+    CHECK(affinity.setKey("ip"));
+    CHECK(affinity.source() == LoopAffinity::Source::kPeerIp);
+    CHECK(!affinity.setKey("header:"));
+    CHECK(!affinity.enabled());
+    CHECK(!affinity.setKey("query:tenant"));
+    CHECK(!affinity.enabled());
+
+    HttpRequestImpl req(nullptr);
+    req.addHeader("X-Tenant", "acme");
+    req.addCookie("tenant", "globex");
+    CHECK(affinity.setKey("header:X-Tenant"));
+    CHECK(affinity.keyOf(req) == "acme");
+    CHECK(affinity.setKey("cookie:tenant"));
+    CHECK(affinity.keyOf(req) == "globex");
+    CHECK(affinity.setKey("cookie:user"));
+    CHECK(affinity.keyOf(req).empty());
+
+    // The keys are spread over the loops
+    std::vector<size_t> counts(8);
+    for (int i = 0; i < 8000; ++i)
+    {
+        auto loop = LoopAffinity::pick("tenant-" + std::to_string(i), 8);
+        REQUIRE(loop < 8u);
+        ++counts[loop];
+    }
+    for (auto count : counts)
+    {
+        CHECK(count > 800u);
+        CHECK(count < 1200u);
+    }
+
+    // A new loop only takes keys from the other ones
+    size_t moved{0};
+    for (int i = 0; i < 8000; ++i)
+    {
+        auto key = "tenant-" + std::to_string(i);
+        auto before = LoopAffinity::pick(key, 8);
+        auto after = LoopAffinity::pick(key, 9);
+        if (before != after)
+        {
+            CHECK(after == 8u);
+            ++moved;
+        }
+    }
+    CHECK(moved > 600u);
+    CHECK(moved < 1200u);
+    CHECK(LoopAffinity::pick("anything", 1) == 0u);
+}
@@ -0,0 +1,52 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/LoopHandoff.h"
+#include <trantor/net/EventLoopThread.h>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(LoopHandoffTest)
+{
+    trantor::EventLoopThread thread;
+    thread.run();
+    auto loop = thread.getLoop();
+    LoopHandoff handoff(loop);
+    constexpr size_t producers = 4;
+    constexpr size_t tasks = 10000;
+    // Only touched in the loop
+    std::vector<size_t> next(producers, 0);
+    size_t outOfOrder = 0;
+    size_t outOfLoop = 0;
+    std::promise<void> done;
+    size_t remaining = producers * tasks;
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]() {
+            for (size_t i = 0; i < tasks; ++i)
+            {
+                handoff.run([&, p, i]() {
+                    if (!loop->isInLoopThread())
+                        ++outOfLoop;
+                    if (next[p]++ != i)
+                        ++outOfOrder;
+                    if (--remaining == 0)
+                        done.set_value();
+                });
+            }
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+    done.get_future().wait();
+    // A drain may still be queued after the one which ran the last task
+    std::promise<void> drained;
+    loop->queueInLoop([&drained]() { drained.set_value(); });
+    drained.get_future().wait();
+    CHECK(outOfLoop == 0);
+    CHECK(outOfOrder == 0);
+    for (auto n : next)
+        CHECK(n == tasks);
+}
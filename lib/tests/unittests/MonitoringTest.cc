@@ -0,0 +1,123 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Gauge.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <drogon/utils/monitoring/Summary.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace drogon::monitoring;
+
+static const std::vector<std::string> kNoLabels;
+
+DROGON_TEST(MonitoringCounterTest)
+{
+    auto counter = std::make_shared<Counter>("requests", kNoLabels, kNoLabels);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back([counter]() {
+            for (int j = 0; j < 10000; ++j)
+                counter->increment();
+            counter->increment(0.5);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    auto samples = counter->collect();
+    REQUIRE(samples.size() == 1u);
+    CHECK(samples[0].value == 80004.0);
+    counter->reset();
+    CHECK(counter->collect()[0].value == 0.0);
+
+    auto gauge = std::make_shared<Gauge>("connections", kNoLabels, kNoLabels);
+    gauge->increment(3);
+    gauge->decrement();
+    CHECK(gauge->collect()[0].value == 2.0);
+    gauge->set(7);
+    CHECK(gauge->collect()[0].value == 7.0);
+}
+
+DROGON_TEST(MonitoringHistogramTest)
+{
+    auto histogram =
+        std::make_shared<Histogram>("latency",
+                                    kNoLabels,
+                                    kNoLabels,
+                                    std::vector<double>{1, 2, 5},
+                                    std::chrono::seconds(0),
+                                    0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([histogram]() {
+            for (int j = 0; j < 1000; ++j)
+            {
+                histogram->observe(0.5);
+                histogram->observe(2);
+                histogram->observe(10);
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    auto samples = histogram->collect();
+    // 4 buckets, _sum and _count
+    REQUIRE(samples.size() == 6u);
+    CHECK(samples[0].value == 4000.0);
+    CHECK(samples[1].value == 8000.0);
+    CHECK(samples[2].value == 8000.0);
+    CHECK(samples[3].value == 12000.0);
+    CHECK(samples[3].exLabels[0].second == "+Inf");
+    CHECK(samples[4].value == 4000 * 12.5);
+    CHECK(samples[5].value == 12000.0);
+}
+
+DROGON_TEST(MonitoringSummaryTest)
+{
+    DDSketch sketch(0.01);
+    DDSketch other(0.01);
+    for (int i = 1; i <= 10000; ++i)
+    {
+        if (i % 2)
+            sketch.add(i);
+        else
+            other.add(i);
+    }
+    sketch.merge(other);
+    CHECK(sketch.count() == 10000u);
+    for (auto q : {0.1, 0.5, 0.9, 0.99})
+    {
+        auto exact = std::floor(q * 9999) + 1;
+        CHECK(std::abs(sketch.quantile(q) - exact) <= exact * 0.01);
+    }
+    CHECK(sketch.quantile(0) == 1.0);
+    CHECK(sketch.quantile(1) == 10000.0);
+    CHECK_THROWS(sketch.merge(DDSketch(0.05)));
+
+    // Only the lowest values lose accuracy when the buckets are collapsed
+    DDSketch small(0.01, 100);
+    for (int i = 1; i <= 10000; ++i)
+        small.add(i);
+    CHECK(std::abs(small.quantile(0.99) - 9900) <= 9900 * 0.01);
+
+    auto summary = std::make_shared<Summary>("latency", kNoLabels, kNoLabels);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([summary]() {
+            for (int j = 1; j <= 1000; ++j)
+                summary->observe(j);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    auto samples = summary->collect();
+    // 3 quantiles, _sum and _count
+    REQUIRE(samples.size() == 5u);
+    CHECK(samples[0].exLabels[0].second == "0.5");
+    CHECK(std::abs(samples[0].value - 500) <= 5);
+    CHECK(samples[3].value == 4 * 500500.0);
+    CHECK(samples[4].value == 4000.0);
+}
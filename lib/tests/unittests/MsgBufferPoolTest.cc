@@ -0,0 +1,61 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/MsgBufferPool.h"
+#include <drogon/HttpAppFramework.h>
+#include <future>
+#include <thread>
+
+using namespace drogon;
+
+DROGON_TEST(MsgBufferPoolTest)
+{
+    CHECK(MsgBufferPool::sizeClass(1) == 256u);
+    CHECK(MsgBufferPool::sizeClass(256) == 256u);
+    CHECK(MsgBufferPool::sizeClass(257) == 1024u);
+    CHECK(MsgBufferPool::sizeClass(64 * 1024) == 64u * 1024);
+    CHECK(MsgBufferPool::sizeClass(64 * 1024 + 1) == 0u);
+
+    // Not pooled outside the IO loops
+    auto plain = MsgBufferPool::take(MsgBufferPool::Use::kFrame, 100);
+    CHECK(plain->writableBytes() >= 100u);
+    MsgBufferPool::give(std::move(plain));
+
+    std::promise<void> done;
+    app().getLoop()->runInLoop([TEST_CTX, &done]() {
+        // A buffer given back is taken again, empty, for the same size class
+        auto buffer = MsgBufferPool::take(MsgBufferPool::Use::kFrame, 100);
+        auto *p = buffer.get();
+        CHECK(buffer->writableBytes() == 256u);
+        buffer->append(std::string(200, 'x'));
+        MsgBufferPool::give(std::move(buffer));
+        buffer = MsgBufferPool::take(MsgBufferPool::Use::kFrame, 200);
+        CHECK(buffer.get() == p);
+        CHECK(buffer->readableBytes() == 0u);
+        MsgBufferPool::give(std::move(buffer));
+
+        // A shared buffer released in another thread returns to its loop
+        auto shared = MsgBufferPool::acquire(MsgBufferPool::Use::kFrame, 5000);
+        auto *q = shared.get();
+        CHECK(shared->writableBytes() == 16u * 1024);
+        std::thread([shared = std::move(shared)]() mutable {
+            shared.reset();
+        }).join();
+        app().getLoop()->queueInLoop([TEST_CTX, q, &done]() {
+            auto again =
+                MsgBufferPool::acquire(MsgBufferPool::Use::kFrame, 5000);
+            CHECK(again.get() == q);
+            done.set_value();
+        });
+    });
+    done.get_future().get();
+
+    // The hint follows a larger size at once and a smaller one slowly
+    MsgBufferPool::record(MsgBufferPool::Use::kStaging, 100000);
+    CHECK(MsgBufferPool::sizeHint(MsgBufferPool::Use::kStaging) == 100000u);
+    MsgBufferPool::record(MsgBufferPool::Use::kStaging, 0);
+    auto hint = MsgBufferPool::sizeHint(MsgBufferPool::Use::kStaging);
+    CHECK(hint < 100000u);
+    CHECK(hint > 90000u);
+    for (int i = 0; i < 200; ++i)
+        MsgBufferPool::record(MsgBufferPool::Use::kStaging, 0);
+    CHECK(MsgBufferPool::sizeHint(MsgBufferPool::Use::kStaging) < 256u);
+}
@@ -0,0 +1,70 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/MsgPack.h>
+#include "../lib/src/HttpUtils.h"
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(MsgPackTest)
+{
+    Json::Value value;
+    value["int"] = -33;
+    value["uint"] = Json::UInt64(18446744073709551615ULL);
+    value["big"] = Json::Int64(-5000000000LL);
+    value["real"] = 1.5;
+    value["text"] = std::string(40, 'x');
+    value["null"] = Json::Value();
+    value["bool"] = true;
+    value["list"].append(1);
+    value["list"].append(300);
+    value["list"].append("a");
+
+    auto data = utils::toMsgPack(value);
+    Json::Value decoded;
+    std::string errs;
+    CHECK(utils::fromMsgPack(data, decoded, errs));
+    CHECK(decoded == value);
+
+    // {"compact":true,"schema":0} from the MessagePack specification
+    std::string known("\x82\xa7"
+                      "compact"
+                      "\xc3\xa6"
+                      "schema"
+                      "\x00",
+                      18);
+    CHECK(utils::fromMsgPack(known, decoded, errs));
+    CHECK(decoded["compact"].asBool());
+    CHECK(decoded["schema"].asInt() == 0);
+    CHECK(utils::toMsgPack(decoded) == known);
+
+    // A float 32 and a map with an integer key
+    CHECK(utils::fromMsgPack(std::string("\xca\x3f\xc0\x00\x00", 5),
+                             decoded,
+                             errs));
+    CHECK(decoded.asDouble() == 1.5);
+    CHECK(utils::fromMsgPack(std::string("\x81\x01\xa1x", 4), decoded, errs));
+    CHECK(decoded["1"].asString() == "x");
+
+    // A truncated array, trailing bytes, an ext and a deep document
+    CHECK(!utils::fromMsgPack(std::string("\xdd\xff\xff\xff\xff", 5),
+                              decoded,
+                              errs));
+    CHECK(!errs.empty());
+    CHECK(!utils::fromMsgPack(std::string("\xc0\xc0", 2), decoded, errs));
+    CHECK(!utils::fromMsgPack(std::string("\xd4\x01\x02", 3), decoded, errs));
+    std::string deep(2000, '\x91');
+    deep.push_back('\xc0');
+    CHECK(!utils::fromMsgPack(deep, decoded, errs));
+}
+
+DROGON_TEST(MsgPackAcceptTest)
+{
+    CHECK(prefersMsgPack("application/msgpack"));
+    CHECK(prefersMsgPack("application/json;q=0.5, application/x-msgpack"));
+    CHECK(!prefersMsgPack(""));
+    CHECK(!prefersMsgPack("*/*"));
+    CHECK(!prefersMsgPack("application/json, application/msgpack"));
+    CHECK(!prefersMsgPack("application/msgpack;q=0"));
+    CHECK(parseContentType("application/vnd.msgpack") ==
+          CT_APPLICATION_MSGPACK);
+}
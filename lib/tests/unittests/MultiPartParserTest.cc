@@ -1,6 +1,7 @@
 #include <drogon/MultiPart.h>
 #include <drogon/drogon_test.h>
 #include <drogon/HttpRequest.h>
+#include "../../lib/src/BoundaryMatcher.h"
 #include "../../lib/src/MultipartStreamParser.h"
 
 DROGON_TEST(MultiPartParser)
@@ -75,6 +76,17 @@ DROGON_TEST(MultiPartStreamParser)
         "\r\n"
         "value2\r\n"
         "--12345--";
+    // The file holds a prefix of the delimiter, which may end a chunk
+    static const std::string_view partialBoundaryData =
+        "--12345\r\n"
+        "Content-Disposition: form-data; name=\"key1\"; filename=\"file1\"\r\n"
+        "\r\n"
+        "Hello;\r\n--1234\r World\r\n"
+        "--12345\r\n"
+        "Content-Disposition: form-data; name=\"key2\"\r\n"
+        "\r\n"
+        "value2\r\n"
+        "--12345--";
 
     struct Entry
     {
@@ -83,7 +95,9 @@ DROGON_TEST(MultiPartStreamParser)
         std::string fileContent;
     };
 
-    auto check = [TEST_CTX](size_t step) {
+    auto check = [TEST_CTX](std::string_view body,
+                            std::string_view fileContent,
+                            size_t step) {
         drogon::MultipartStreamParser parser(ct);
 
         auto entries = std::make_shared<std::vector<Entry>>();
@@ -108,25 +122,42 @@ DROGON_TEST(MultiPartStreamParser)
         };
 
         size_t i = 0;
-        while (i < data.length() && parser.isValid())
+        while (i < body.length() && parser.isValid())
         {
-            size_t end = i + step < data.length() ? i + step : data.length();
-            parser.parse(data.data() + i, end - i, headerCb, dataCb);
+            size_t end = i + step < body.length() ? i + step : body.length();
+            parser.parse(body.data() + i, end - i, headerCb, dataCb);
             CHECK(parser.isValid());
             i = end;
         }
-        MANDATE(i == data.length());
+        MANDATE(i == body.length());
         MANDATE(parser.isFinished());
 
         MANDATE(entries->size() == 2);
         CHECK(entries->at(0).header.name == "key1");
-        CHECK(entries->at(0).fileContent == "Hello; World");
+        CHECK(entries->at(0).fileContent == fileContent);
         CHECK(entries->at(1).header.name == "key2");
         CHECK(entries->at(1).value == "value2");
     };
 
-    check(1);
-    check(3);
-    check(7);
-    check(20);
+    for (size_t step : {1, 3, 7, 20})
+    {
+        check(data, "Hello; World", step);
+        check(partialBoundaryData, "Hello;\r\n--1234\r World", step);
+    }
+}
+
+DROGON_TEST(BoundaryMatcher)
+{
+    drogon::BoundaryMatcher matcher("\r\n--12345");
+    CHECK(matcher.find("abc\r\n--12345def") == 3);
+    CHECK(matcher.find("\r\n--12345\r\n--12345", 1) == 9);
+    CHECK(matcher.find("\r\n--1234\r\n--1234") == std::string_view::npos);
+    CHECK(matcher.find("\r\n--123") == std::string_view::npos);
+
+    // The trailing bytes which may begin a match with the next chunk
+    CHECK(matcher.partialMatch("abcdef") == 6);
+    CHECK(matcher.partialMatch("abc\r") == 3);
+    CHECK(matcher.partialMatch("abc\r\n--12") == 3);
+    CHECK(matcher.partialMatch("\r\n--1234\r\n-") == 8);
+    CHECK(matcher.partialMatch("abc\r\n-x") == 7);
 }
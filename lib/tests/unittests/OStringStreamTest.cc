@@ -3,6 +3,7 @@
 #include <string>
 #include <string_view>
 #include <iostream>
+#include <vector>
 
 DROGON_TEST(OStringStreamTest)
 {
@@ -74,4 +75,26 @@ DROGON_TEST(OStringStreamTest)
 
         CHECK(ss.str() == "hello world!1233.14");
     }
+
+    SUBSECTION(sink)
+    {
+        drogon::OStringStream ss;
+        std::vector<std::string> chunks;
+        ss.setSink(
+            [&chunks](const std::string &chunk) {
+                chunks.push_back(chunk);
+                return true;
+            },
+            8);
+        ss << "hello";
+        CHECK(chunks.empty());
+        ss << " world" << 123;
+        CHECK(chunks.size() == 1);
+        CHECK(chunks[0] == "hello world");
+        CHECK(ss.str() == "123");
+        CHECK(ss.flush());
+        CHECK(chunks.size() == 2);
+        CHECK(chunks[1] == "123");
+        CHECK(ss.str().empty());
+    }
 }
@@ -0,0 +1,69 @@
+#include "../../lib/src/OpenedFile.h"
+#include <drogon/drogon_test.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(OpenedFile)
+{
+    auto path = (std::filesystem::temp_directory_path() / "drogon_opened.txt")
+                    .string();
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "0123456789";
+    }
+    auto file = OpenedFile::open(path);
+    REQUIRE(file != nullptr);
+    CHECK(file->size() == 10u);
+    CHECK(!file->lastModified().empty());
+    CHECK(file->etag().front() == '"');
+    CHECK(file->etag().back() == '"');
+#ifndef _WIN32
+    REQUIRE(file->isOpen());
+    char buffer[16];
+    REQUIRE(file->read(2, buffer, 3) == 3u);
+    CHECK(std::string(buffer, 3) == "234");
+#endif
+
+    // A new size changes the ETag
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << "abc";
+    }
+    auto newFile = OpenedFile::open(path);
+    REQUIRE(newFile != nullptr);
+    CHECK(newFile->size() == 13u);
+    CHECK(newFile->etag() != file->etag());
+    std::filesystem::remove(path);
+
+    CHECK(OpenedFile::open(path) == nullptr);
+    CHECK(OpenedFile::open(
+              std::filesystem::temp_directory_path().string()) == nullptr);
+
+#ifndef _WIN32
+    // A file truncated in place is read short instead of faulting
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "0123456789";
+    }
+    file = OpenedFile::open(path);
+    REQUIRE(file != nullptr);
+    std::filesystem::resize_file(path, 4);
+    CHECK(file->read(2, buffer, 8) == 2u);
+    CHECK(std::string(buffer, 2) == "23");
+    CHECK(file->read(6, buffer, 2) == 0u);
+
+    // A file renamed over the path leaves the opened one readable
+    auto newPath = path + ".new";
+    {
+        std::ofstream out(newPath, std::ios::binary);
+        out << "abcdefghij";
+    }
+    std::filesystem::rename(newPath, path);
+    CHECK(file->read(0, buffer, 4) == 4u);
+    CHECK(std::string(buffer, 4) == "0123");
+    std::filesystem::remove(path);
+#endif
+}
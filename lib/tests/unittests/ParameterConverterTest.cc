@@ -0,0 +1,70 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpController.h>
+#include <string>
+#include <string_view>
+
+using namespace drogon;
+
+namespace
+{
+struct Point
+{
+    int x;
+    int y;
+};
+
+template <typename T>
+bool conversionFails(std::string_view str)
+{
+    try
+    {
+        ParameterConverter<T>::fromString(str);
+    }
+    catch (const std::exception &)
+    {
+        return true;
+    }
+    return false;
+}
+}  // namespace
+
+template <>
+struct drogon::ParameterConverter<Point>
+{
+    static Point fromString(std::string_view str)
+    {
+        auto comma = str.find(',');
+        if (comma == std::string_view::npos)
+            throw std::invalid_argument("bad point");
+        return {ParameterConverter<int>::fromString(str.substr(0, comma)),
+                ParameterConverter<int>::fromString(str.substr(comma + 1))};
+    }
+};
+
+DROGON_TEST(ParameterConverterTest)
+{
+    // As lenient as std::stoi() and std::stod()
+    CHECK(ParameterConverter<int>::fromString(" +42abc") == 42);
+    CHECK(ParameterConverter<long long>::fromString("-7") == -7);
+    CHECK(ParameterConverter<unsigned short>::fromString("65535") == 65535);
+    CHECK(ParameterConverter<double>::fromString("1.5e3x") == 1500.0);
+    CHECK(ParameterConverter<float>::fromString("+0.25") == 0.25f);
+    CHECK(conversionFails<int>(""));
+    CHECK(conversionFails<int>("abc"));
+    CHECK(conversionFails<int>("+-1"));
+    CHECK(conversionFails<int>("99999999999"));
+    CHECK(conversionFails<unsigned short>("65536"));
+    CHECK(conversionFails<double>("1e999"));
+
+    CHECK(internal::HasParameterConverter<int>::value);
+    CHECK(internal::HasParameterConverter<Point>::value);
+    CHECK(!internal::HasParameterConverter<bool>::value);
+    CHECK(!internal::HasParameterConverter<char>::value);
+    CHECK(!internal::HasParameterConverter<std::string>::value);
+
+    auto point = internal::getHandlerArgumentValue<Point>("3,-4");
+    CHECK(point.x == 3);
+    CHECK(point.y == -4);
+    CHECK(internal::getHandlerArgumentValue<int>("12") == 12);
+    CHECK(internal::getHandlerArgumentValue<std::string>("12") == "12");
+}
@@ -0,0 +1,122 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/ProxyProtocol.h"
+#include <string>
+
+using namespace drogon;
+using namespace drogon::proxy_protocol;
+
+namespace
+{
+ParseResult parseString(const std::string &data,
+                        Addresses &addresses,
+                        trantor::MsgBuffer &buf)
+{
+    buf.append(data);
+    return parse(&buf, addresses);
+}
+
+std::string v2Header(uint8_t command,
+                     uint8_t family,
+                     const std::string &addresses)
+{
+    std::string header("\r\n\r\n\0\r\nQUIT\n", 12);
+    header.push_back(static_cast<char>(0x20 | command));
+    header.push_back(static_cast<char>(family));
+    header.push_back(static_cast<char>(addresses.size() >> 8));
+    header.push_back(static_cast<char>(addresses.size() & 0xFF));
+    return header + addresses;
+}
+}  // namespace
+
+DROGON_TEST(ProxyProtocolTest)
+{
+    // v1 over IPv4, the request that follows is left in the buffer
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        CHECK(parseString("PROXY TCP4 192.0.2.1 198.51.100.2 56324 443\r\n"
+                          "GET / HTTP/1.1\r\n",
+                          addresses,
+                          buf) == ParseResult::kDone);
+        CHECK(addresses.proxied);
+        CHECK(addresses.peer.toIpPort() == "192.0.2.1:56324");
+        CHECK(addresses.local.toIpPort() == "198.51.100.2:443");
+        CHECK(std::string(buf.peek(), buf.readableBytes()) ==
+              "GET / HTTP/1.1\r\n");
+    }
+    // v1 over IPv6, split at every byte
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        std::string header = "PROXY TCP6 2001:db8::1 2001:db8::2 1000 80\r\n";
+        for (size_t i = 0; i + 1 < header.size(); ++i)
+        {
+            buf.append(header.data() + i, 1);
+            CHECK(parse(&buf, addresses) == ParseResult::kIncomplete);
+        }
+        CHECK(parseString(header.substr(header.size() - 1), addresses, buf) ==
+              ParseResult::kDone);
+        CHECK(addresses.proxied);
+        CHECK(addresses.peer.toIp() == "2001:db8::1");
+        CHECK(addresses.peer.toPort() == 1000);
+        CHECK(buf.readableBytes() == 0);
+    }
+    // v1 with an unknown protocol keeps the connection addresses
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        CHECK(parseString("PROXY UNKNOWN\r\n", addresses, buf) ==
+              ParseResult::kDone);
+        CHECK(!addresses.proxied);
+    }
+    // v2 over IPv4 with a TLV
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        std::string body("\xC0\x00\x02\x01\xC6\x33\x64\x02\xDC\x04\x01\xBB"
+                         "\x04\x00\x01\x00",
+                         16);
+        CHECK(parseString(v2Header(1, 0x11, body) + "data", addresses, buf) ==
+              ParseResult::kDone);
+        CHECK(addresses.proxied);
+        CHECK(addresses.peer.toIpPort() == "192.0.2.1:56324");
+        CHECK(addresses.local.toIpPort() == "198.51.100.2:443");
+        CHECK(std::string(buf.peek(), buf.readableBytes()) == "data");
+    }
+    // v2 LOCAL command of the health checks
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        CHECK(parseString(v2Header(0, 0x00, ""), addresses, buf) ==
+              ParseResult::kDone);
+        CHECK(!addresses.proxied);
+        CHECK(buf.readableBytes() == 0);
+    }
+    // v2 waits for the addresses
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        auto header = v2Header(1, 0x11, std::string(12, '\0'));
+        CHECK(parseString(header.substr(0, 20), addresses, buf) ==
+              ParseResult::kIncomplete);
+    }
+    // Connections without the header
+    for (const std::string &data :
+         {std::string("GET / HTTP/1.1\r\n"),
+          std::string("PROXY TCP4 192.0.2.1 198.51.100.2 56324\r\n"),
+          std::string("PROXY TCP4 192.0.2.1 198.51.100.2 1 99999\r\n"),
+          std::string("PROXY TCP4 2001:db8::1 198.51.100.2 1 2\r\n"),
+          std::string("PROXY TCP5 192.0.2.1 198.51.100.2 1 2\r\n"),
+          "PROXY TCP4 " + std::string(100, '1')})
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        CHECK(parseString(data, addresses, buf) == ParseResult::kInvalid);
+    }
+    {
+        Addresses addresses;
+        trantor::MsgBuffer buf;
+        auto header = v2Header(2, 0x11, std::string(12, '\0'));
+        CHECK(parseString(header, addresses, buf) == ParseResult::kInvalid);
+    }
+}
@@ -0,0 +1,140 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/ProxyResponseParser.h"
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+struct Collector
+{
+    Collector()
+        : parser(
+              [this](ProxyResponseParser::Head &&h) {
+                  ++heads;
+                  head = std::move(h);
+              },
+              [this](const char *data, size_t length) {
+                  body.append(data, length);
+              })
+    {
+    }
+
+    // Feed the data one byte at a time, as the worst split of the packets
+    long feedBytes(const std::string &data)
+    {
+        std::string pending;
+        for (auto c : data)
+        {
+            pending.push_back(c);
+            auto n = parser.parse(pending.data(), pending.size());
+            if (n < 0)
+                return -1;
+            pending.erase(0, static_cast<size_t>(n));
+        }
+        return static_cast<long>(pending.size());
+    }
+
+    ProxyResponseParser parser;
+    ProxyResponseParser::Head head;
+    int heads{0};
+    std::string body;
+};
+}  // namespace
+
+DROGON_TEST(ProxyResponseParserTest)
+{
+    // Content-Length
+    {
+        Collector c;
+        c.parser.reset(false);
+        std::string resp =
+            "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nX-A: 1\r\n\r\nhello";
+        CHECK(c.parser.parse(resp.data(), resp.size()) == (long)resp.size());
+        CHECK(c.heads == 1);
+        CHECK(c.head.statusCode == 200);
+        CHECK(c.head.statusMessage == "OK");
+        REQUIRE(c.head.headers.size() == 2u);
+        CHECK(c.head.headers[1].first == "x-a");
+        CHECK(c.body == "hello");
+        CHECK(c.parser.done());
+        CHECK(c.parser.keepAlive());
+    }
+    // Chunked, split at every byte, with an interim response and trailers
+    {
+        Collector c;
+        c.parser.reset(false);
+        std::string resp =
+            "HTTP/1.1 100 Continue\r\n\r\n"
+            "HTTP/1.1 201 Created\r\nTransfer-Encoding: gzip, chunked\r\n\r\n"
+            "3;ext=1\r\nabc\r\nA\r\n0123456789\r\n0\r\nX-T: 1\r\n\r\n";
+        CHECK(c.feedBytes(resp) == 0);
+        CHECK(c.heads == 1);
+        CHECK(c.head.statusCode == 201);
+        CHECK(c.body == "abc0123456789");
+        CHECK(c.parser.done());
+        CHECK(c.parser.keepAlive());
+    }
+    // The bytes after the response are left
+    {
+        Collector c;
+        c.parser.reset(false);
+        std::string resp = "HTTP/1.1 204 No Content\r\n\r\nHTTP/1.1";
+        CHECK(c.parser.parse(resp.data(), resp.size()) == 27);
+        CHECK(c.parser.done());
+        CHECK(c.body.empty());
+    }
+    // HEAD responses have no body
+    {
+        Collector c;
+        c.parser.reset(true);
+        std::string resp = "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n";
+        CHECK(c.parser.parse(resp.data(), resp.size()) == (long)resp.size());
+        CHECK(c.parser.done());
+    }
+    // Delimited by the close
+    {
+        Collector c;
+        c.parser.reset(false);
+        std::string resp = "HTTP/1.0 200 OK\r\n\r\nsome data";
+        CHECK(c.parser.parse(resp.data(), resp.size()) == (long)resp.size());
+        CHECK(!c.parser.done());
+        CHECK(c.parser.finishOnClose());
+        CHECK(c.parser.done());
+        CHECK(!c.parser.keepAlive());
+        CHECK(c.body == "some data");
+    }
+    // Connection: close
+    {
+        Collector c;
+        c.parser.reset(false);
+        std::string resp =
+            "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+        CHECK(c.parser.parse(resp.data(), resp.size()) == (long)resp.size());
+        CHECK(c.parser.done());
+        CHECK(!c.parser.keepAlive());
+        CHECK(!c.parser.finishOnClose());
+    }
+    // Protocol errors
+    for (std::string resp :
+         {"HTTP/1.1 200 OK\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n",
+          "HTTP/1.1 2x0 OK\r\n\r\n",
+          "HTTP/1.1 101 Switching Protocols\r\n\r\n",
+          "HTTP/1.1 200 OK\r\nBad header\r\n\r\n",
+          "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n"})
+    {
+        Collector c;
+        c.parser.reset(false);
+        CHECK(c.parser.parse(resp.data(), resp.size()) == -1);
+    }
+    // The header size is limited
+    {
+        ProxyResponseParser parser([](ProxyResponseParser::Head &&) {},
+                                   [](const char *, size_t) {},
+                                   32);
+        parser.reset(false);
+        std::string resp = "HTTP/1.1 200 OK\r\nX-Long: " +
+                           std::string(64, 'a') + "\r\n\r\n";
+        CHECK(parser.parse(resp.data(), resp.size()) == -1);
+    }
+}
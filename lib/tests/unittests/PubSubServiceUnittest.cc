@@ -1,5 +1,7 @@
 #include <drogon/PubSubService.h>
 #include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <future>
 
 DROGON_TEST(PubSubServiceTest)
 {
@@ -16,3 +18,32 @@ DROGON_TEST(PubSubServiceTest)
     service.unsubscribe("topic1", id);
     CHECK(service.size() == 0UL);
 }
+
+DROGON_TEST(LoopTopicTest)
+{
+    drogon::LoopTopic<std::string> topic;
+    trantor::EventLoopThread thread;
+    thread.run();
+    auto loop = thread.getLoop();
+
+    std::promise<std::string> received;
+    auto id = topic.subscribe(
+        [&received, loop](const std::string &message) {
+            // The handler runs on its own loop
+            if (loop->isInLoopThread())
+                received.set_value(message);
+        },
+        loop);
+    int calls = 0;
+    auto syncId =
+        topic.subscribe([&calls](const std::string &) { ++calls; }, nullptr);
+    topic.publish("hello world");
+    CHECK(calls == 1);
+    CHECK(received.get_future().get() == "hello world");
+
+    topic.unsubscribe(id);
+    topic.unsubscribe(syncId);
+    CHECK(topic.empty());
+    topic.publish("hello world");
+    CHECK(calls == 1);
+}
@@ -0,0 +1,20 @@
+#include <drogon/drogon_test.h>
+#include "../../orm_lib/src/QueryStatistics.h"
+
+using drogon::orm::QueryStatistics;
+
+DROGON_TEST(QueryStatisticsNormalize)
+{
+    CHECK(QueryStatistics::normalize(
+              "SELECT *  FROM users\n WHERE id = 42 AND name = 'o''brien'") ==
+          "SELECT * FROM users WHERE id = ? AND name = ?");
+    // The placeholders and the digits of the names are kept
+    CHECK(QueryStatistics::normalize(
+              "update t1 set x=$1, y=-1.5e-3 where z in (1,0x1F)") ==
+          "update t1 set x=$1, y=-? where z in (?,?)");
+    CHECK(QueryStatistics::normalize("select 1 -- the answer\n/* a */ ;") ==
+          "select ? ;");
+    CHECK(QueryStatistics::normalize("  select 'unterminated") ==
+          "select ?");
+    CHECK(QueryStatistics::normalize(std::string(600, 'x')).length() == 515);
+}
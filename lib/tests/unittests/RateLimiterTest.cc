@@ -0,0 +1,67 @@
+#include <drogon/drogon_test.h>
+#include <drogon/RateLimiter.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+DROGON_TEST(RateLimiterTest)
+{
+    for (auto type : {RateLimiterType::kFixedWindow,
+                      RateLimiterType::kSlidingWindow,
+                      RateLimiterType::kAtomicSlidingWindow,
+                      RateLimiterType::kAtomicTokenBucket})
+    {
+        auto limiter = RateLimiter::newRateLimiter(type, 10, 1h);
+        size_t allowed{0};
+        for (int i = 0; i < 100; ++i)
+        {
+            if (limiter->isAllowed())
+                ++allowed;
+        }
+        CHECK(allowed == 10u);
+    }
+    auto limiter =
+        RateLimiter::newRateLimiter(RateLimiterType::kAtomicTokenBucket, 0);
+    CHECK(limiter->isAllowed() == false);
+
+    // The tokens come back with the time
+    limiter =
+        RateLimiter::newRateLimiter(RateLimiterType::kAtomicTokenBucket,
+                                    10,
+                                    100ms);
+    while (limiter->isAllowed())
+        ;
+    std::this_thread::sleep_for(50ms);
+    CHECK(limiter->isAllowed());
+}
+
+DROGON_TEST(AtomicRateLimiterThreads)
+{
+    for (auto type : {RateLimiterType::kAtomicSlidingWindow,
+                      RateLimiterType::kAtomicTokenBucket})
+    {
+        CHECK(isThreadSafeRateLimiterType(type));
+        auto limiter = RateLimiter::newRateLimiter(type, 1000, 1h);
+        std::atomic<size_t> allowed{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i)
+        {
+            threads.emplace_back([&limiter, &allowed]() {
+                for (int j = 0; j < 1000; ++j)
+                {
+                    if (limiter->isAllowed())
+                        ++allowed;
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        // The sliding window may allow one more request per thread
+        CHECK(allowed.load() >= 1000u);
+        CHECK(allowed.load() <= 1008u);
+    }
+}
@@ -0,0 +1,34 @@
+#include <drogon/drogon_test.h>
+#include "../../nosql_lib/redis/src/RedisClusterClient.h"
+#include <string>
+
+using namespace drogon::nosql;
+
+DROGON_TEST(RedisClusterSlotTest)
+{
+    // The CRC16 check value of the Redis Cluster specification
+    CHECK(RedisClusterClient::keySlot("123456789") == 0x31C3 % 16384);
+    CHECK(RedisClusterClient::keySlot("{user1000}.following") ==
+          RedisClusterClient::keySlot("user1000"));
+    CHECK(RedisClusterClient::keySlot("foo{bar}{zap}") ==
+          RedisClusterClient::keySlot("bar"));
+    // An empty hash tag doesn't count
+    CHECK(RedisClusterClient::keySlot("foo{}{bar}") !=
+          RedisClusterClient::keySlot("bar"));
+
+    auto slot = RedisClusterClient::keySlot("foo");
+    CHECK(RedisClusterClient::commandSlot(
+              "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n") == slot);
+    CHECK(RedisClusterClient::commandSlot(
+              "*4\r\n$4\r\neval\r\n$1\r\nx\r\n$1\r\n1\r\n$3\r\nfoo\r\n") ==
+          slot);
+    CHECK(RedisClusterClient::commandSlot("*4\r\n$5\r\nXREAD\r\n"
+                                          "$7\r\nSTREAMS\r\n$3\r\nfoo\r\n"
+                                          "$1\r\n0\r\n") == slot);
+    CHECK(RedisClusterClient::commandSlot(
+              "*3\r\n$4\r\nEVAL\r\n$1\r\nx\r\n$1\r\n0\r\n") == -1);
+    CHECK(RedisClusterClient::commandSlot("*1\r\n$4\r\nPING\r\n") == -1);
+    CHECK(RedisClusterClient::commandSlot(
+              "*2\r\n$4\r\ninfo\r\n$6\r\nserver\r\n") == -1);
+    CHECK(RedisClusterClient::commandSlot("garbage") == -1);
+}
@@ -0,0 +1,160 @@
+#include <drogon/drogon_test.h>
+#include "../../nosql_lib/redis/src/RedisScannerImpl.h"
+#include <drogon/nosql/RedisCommandFormat.h>
+#include <hiredis/hiredis.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace drogon::nosql;
+
+namespace
+{
+// A SCAN reply built in memory
+struct ScanReply
+{
+    ScanReply(std::string cursor, std::vector<std::string> elements)
+        : cursor_(std::move(cursor)), elements_(std::move(elements))
+    {
+        cursorReply_.type = REDIS_REPLY_STRING;
+        cursorReply_.str = cursor_.data();
+        cursorReply_.len = cursor_.size();
+        elementReplies_.resize(elements_.size());
+        for (size_t i = 0; i < elements_.size(); ++i)
+        {
+            elementReplies_[i].type = REDIS_REPLY_STRING;
+            elementReplies_[i].str = elements_[i].data();
+            elementReplies_[i].len = elements_[i].size();
+            elementPointers_.push_back(&elementReplies_[i]);
+        }
+        elementsReply_.type = REDIS_REPLY_ARRAY;
+        elementsReply_.elements = elementPointers_.size();
+        elementsReply_.element = elementPointers_.data();
+        replyPointers_ = {&cursorReply_, &elementsReply_};
+        reply_.type = REDIS_REPLY_ARRAY;
+        reply_.elements = 2;
+        reply_.element = replyPointers_.data();
+    }
+
+    RedisResult result()
+    {
+        return RedisResult(&reply_);
+    }
+
+    std::string cursor_;
+    std::vector<std::string> elements_;
+    redisReply cursorReply_{};
+    std::vector<redisReply> elementReplies_;
+    std::vector<redisReply *> elementPointers_;
+    redisReply elementsReply_{};
+    std::vector<redisReply *> replyPointers_;
+    redisReply reply_{};
+};
+
+struct Sent
+{
+    std::string command;
+    RedisResultCallback resultCallback;
+    RedisExceptionCallback exceptionCallback;
+};
+}  // namespace
+
+DROGON_TEST(RedisScannerTest)
+{
+    std::deque<Sent> sent;
+    auto scanner = std::make_shared<RedisScannerImpl>(
+        RedisScanOptions{"HSCAN", "hash", "f*", 100},
+        [&sent](std::string &&command,
+                RedisResultCallback &&resultCallback,
+                RedisExceptionCallback &&exceptionCallback) {
+            sent.push_back({std::move(command),
+                            std::move(resultCallback),
+                            std::move(exceptionCallback)});
+        });
+    CHECK(sent.empty());
+
+    std::vector<std::string> pages;
+    bool lastSeen{false};
+    auto next = [&]() {
+        scanner->nextAsync(
+            [&](std::vector<std::string> &&page, bool last) {
+                std::string joined;
+                for (auto &element : page)
+                    joined += element + ",";
+                pages.push_back(joined);
+                lastSeen = last;
+            },
+            [](const RedisException &) {});
+    };
+
+    next();
+    REQUIRE(sent.size() == 1u);
+    CHECK(sent[0].command == formatRedisCommand("HSCAN",
+                                                "hash",
+                                                "0",
+                                                "MATCH",
+                                                "f*",
+                                                "COUNT",
+                                                "100"));
+
+    // The page is passed and the next one is requested at once
+    ScanReply first("17", {"f1", "v1"});
+    sent[0].resultCallback(first.result());
+    CHECK(pages.size() == 1u);
+    CHECK(pages[0] == "f1,v1,");
+    CHECK(!lastSeen);
+    REQUIRE(sent.size() == 2u);
+    CHECK(sent[1].command.find("$2\r\n17\r\n") != std::string::npos);
+
+    // An empty page is skipped, the page read ahead waits for the consumer
+    ScanReply empty("23", {});
+    sent[1].resultCallback(empty.result());
+    REQUIRE(sent.size() == 3u);
+    ScanReply second("0", {"f2", "v2"});
+    sent[2].resultCallback(second.result());
+    CHECK(pages.size() == 1u);
+    CHECK(!scanner->done());
+
+    next();
+    CHECK(pages.size() == 2u);
+    CHECK(pages[1] == "f2,v2,");
+    CHECK(lastSeen);
+    CHECK(scanner->done());
+    CHECK(sent.size() == 3u);
+
+    // After the last page
+    next();
+    CHECK(pages.size() == 3u);
+    CHECK(pages[2].empty());
+    CHECK(sent.size() == 3u);
+
+    // The pages passed to forEachAsync, and the error of a failed scan
+    sent.clear();
+    auto failing = std::make_shared<RedisScannerImpl>(
+        RedisScanOptions{},
+        [&sent](std::string &&command,
+                RedisResultCallback &&resultCallback,
+                RedisExceptionCallback &&exceptionCallback) {
+            sent.push_back({std::move(command),
+                            std::move(resultCallback),
+                            std::move(exceptionCallback)});
+        });
+    size_t keys{0};
+    int errors{0};
+    failing->forEachAsync(
+        [&keys](std::vector<std::string> &&page) {
+            keys += page.size();
+            return true;
+        },
+        []() {},
+        [&errors](const RedisException &) { ++errors; });
+    REQUIRE(sent.size() == 1u);
+    ScanReply keysPage("5", {"a", "b", "c"});
+    sent[0].resultCallback(keysPage.result());
+    CHECK(keys == 3u);
+    REQUIRE(sent.size() == 2u);
+    sent[1].exceptionCallback(
+        RedisException(RedisErrorCode::kConnectionBroken, "broken"));
+    CHECK(errors == 1);
+    CHECK(!failing->done());
+}
@@ -0,0 +1,25 @@
+#include <drogon/drogon_test.h>
+#include "../../nosql_lib/redis/src/RedisSentinelClient.h"
+#include <string>
+
+using namespace drogon::nosql;
+
+DROGON_TEST(RedisSentinelRoutingTest)
+{
+    CHECK(RedisSentinelClient::isReadOnlyCommand(
+        "*2\r\n$3\r\nGET\r\n$3\r\nfoo\r\n"));
+    CHECK(RedisSentinelClient::isReadOnlyCommand(
+        "*2\r\n$7\r\nhgetall\r\n$3\r\nfoo\r\n"));
+    CHECK(RedisSentinelClient::isReadOnlyCommand(
+        "*4\r\n$7\r\nEVAL_RO\r\n$1\r\nx\r\n$1\r\n1\r\n$3\r\nfoo\r\n"));
+    CHECK(!RedisSentinelClient::isReadOnlyCommand(
+        "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n"));
+    CHECK(!RedisSentinelClient::isReadOnlyCommand(
+        "*4\r\n$4\r\nEVAL\r\n$1\r\nx\r\n$1\r\n1\r\n$3\r\nfoo\r\n"));
+    // A prefix of a read-only command is not one
+    CHECK(!RedisSentinelClient::isReadOnlyCommand(
+        "*3\r\n$6\r\nGETSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n"));
+    CHECK(!RedisSentinelClient::isReadOnlyCommand("*1\r\n$3\r\nGE"));
+    CHECK(!RedisSentinelClient::isReadOnlyCommand("garbage"));
+    CHECK(!RedisSentinelClient::isReadOnlyCommand(""));
+}
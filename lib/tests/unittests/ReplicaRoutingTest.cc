@@ -0,0 +1,27 @@
+#include <drogon/drogon_test.h>
+#include "../../orm_lib/src/ReplicatedDbClient.h"
+
+using namespace drogon::orm;
+
+DROGON_TEST(ReplicaRoutingTest)
+{
+    CHECK(ReplicatedDbClient::isReadOnly("SELECT * FROM users WHERE id = $1"));
+    CHECK(ReplicatedDbClient::isReadOnly(
+        "  with t as (select 1 as n) select n from t"));
+    CHECK(ReplicatedDbClient::isReadOnly("show server_version"));
+    CHECK(ReplicatedDbClient::isReadOnly(
+        "/* update */ select 'delete', \"insert\" from t -- lock"));
+
+    CHECK(!ReplicatedDbClient::isReadOnly("insert into t values (1)"));
+    CHECK(!ReplicatedDbClient::isReadOnly("update t set a = 1"));
+    CHECK(!ReplicatedDbClient::isReadOnly("select * from t for update"));
+    CHECK(!ReplicatedDbClient::isReadOnly("select * from t for key share"));
+    CHECK(!ReplicatedDbClient::isReadOnly(
+        "with d as (delete from t returning *) select * from d"));
+    CHECK(!ReplicatedDbClient::isReadOnly("select * into t2 from t"));
+    CHECK(!ReplicatedDbClient::isReadOnly("select nextval('seq')"));
+    CHECK(!ReplicatedDbClient::isReadOnly("select pg_advisory_lock(1)"));
+    CHECK(!ReplicatedDbClient::isReadOnly("explain analyze delete from t"));
+    CHECK(!ReplicatedDbClient::isReadOnly("select 'unterminated"));
+    CHECK(!ReplicatedDbClient::isReadOnly(""));
+}
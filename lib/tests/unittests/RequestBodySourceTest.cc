@@ -0,0 +1,92 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpChunking.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(RequestBodySourceTest)
+{
+    auto path = std::string("./request_body_source_test.txt");
+    {
+        std::ofstream file(path, std::ofstream::binary);
+        file << "0123456789";
+    }
+
+    // A range of a file, sent after the headers or read into them
+    auto req = std::make_shared<HttpRequestImpl>(nullptr);
+    req->setMethod(Put);
+    CHECK(!req->setBodyFile(path, 4, 7));
+    REQUIRE(req->setBodyFile(path, 2, 5));
+    std::vector<HttpRequestImpl::BodyPiece> pieces;
+    trantor::MsgBuffer buffer;
+    req->appendToBuffer(&buffer, &pieces);
+    std::string text(buffer.peek(), buffer.readableBytes());
+    CHECK(text.find("content-length: 5\r\n") != std::string::npos);
+    CHECK(text.substr(text.length() - 4) == "\r\n\r\n");
+    REQUIRE(pieces.size() == 1);
+    CHECK(pieces[0].path == path);
+    CHECK(pieces[0].offset == 2);
+    CHECK(pieces[0].length == 5);
+    trantor::MsgBuffer whole;
+    req->appendToBuffer(&whole);
+    text.assign(whole.peek(), whole.readableBytes());
+    CHECK(text.substr(text.length() - 9) == "\r\n\r\n23456");
+
+    // A generated body of unknown length is chunked, or generated into the
+    // buffer
+    auto generator = [sent = false](char *buf, size_t len) mutable {
+        if (!buf || sent || len < 5)
+            return size_t(0);
+        sent = true;
+        memcpy(buf, "hello", 5);
+        return size_t(5);
+    };
+    req = std::make_shared<HttpRequestImpl>(nullptr);
+    req->setMethod(Post);
+    req->setBodyGenerator(generator);
+    buffer.retrieveAll();
+    pieces.clear();
+    req->appendToBuffer(&buffer, &pieces);
+    text.assign(buffer.peek(), buffer.readableBytes());
+    CHECK(text.find("transfer-encoding: chunked\r\n") != std::string::npos);
+    CHECK(text.find("content-length") == std::string::npos);
+    CHECK(pieces.empty());
+    auto ctx = std::make_shared<ChunkingParams>(req->takeBodyGenerator());
+    char chunk[64];
+    auto n = chunkingCallback(ctx, chunk, sizeof(chunk));
+    CHECK(std::string(chunk, n) == "05\r\nhello\r\n");
+    n = chunkingCallback(ctx, chunk, sizeof(chunk));
+    CHECK(std::string(chunk, n) == "0\r\n\r\n");
+
+    req = std::make_shared<HttpRequestImpl>(nullptr);
+    req->setMethod(Post);
+    req->setBodyGenerator(generator);
+    whole.retrieveAll();
+    req->appendToBuffer(&whole);
+    text.assign(whole.peek(), whole.readableBytes());
+    CHECK(text.find("content-length: 5\r\n") != std::string::npos);
+    CHECK(text.substr(text.length() - 9) == "\r\n\r\nhello");
+
+    // The files of an upload are not read into memory
+    auto upload = HttpRequest::newFileUploadRequest({UploadFile(path)});
+    auto uploadImpl = static_cast<HttpRequestImpl *>(upload.get());
+    buffer.retrieveAll();
+    pieces.clear();
+    uploadImpl->appendToBuffer(&buffer, &pieces);
+    REQUIRE(pieces.size() == 3);
+    CHECK(pieces[0].data.find("filename=\"request_body_source_test.txt\"") !=
+          std::string::npos);
+    CHECK(pieces[1].path == path);
+    CHECK(pieces[1].length == 10);
+    CHECK(pieces[2].data.substr(pieces[2].data.length() - 2) == "--");
+    whole.retrieveAll();
+    uploadImpl->appendToBuffer(&whole);
+    text.assign(whole.peek(), whole.readableBytes());
+    CHECK(text.find("\r\n\r\n0123456789\r\n--") != std::string::npos);
+
+    std::remove(path.c_str());
+}
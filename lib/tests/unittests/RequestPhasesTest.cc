@@ -0,0 +1,47 @@
+#include "../../lib/src/RequestPhases.h"
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(RequestPhases)
+{
+    RequestPhases phases;
+    phases.stamps[static_cast<size_t>(RequestPhase::kReceived)] = 1000;
+    phases.stamps[static_cast<size_t>(RequestPhase::kParsed)] = 3000;
+    phases.stamps[static_cast<size_t>(RequestPhase::kRouting)] = 4000;
+    // No kRouted point, the routing is counted by the next phase
+    phases.stamps[static_cast<size_t>(RequestPhase::kHandling)] = 2004000;
+
+    CHECK(phases.seconds(RequestPhase::kReceived) == -1);
+    CHECK(phases.seconds(RequestPhase::kParsed) == 2e-6);
+    CHECK(phases.seconds(RequestPhase::kRouted) == -1);
+    CHECK(phases.seconds(RequestPhase::kHandling) == 2e-3);
+    CHECK(phases.seconds(RequestPhase::kHandled) == -1);
+    CHECK(std::string(RequestPhases::name(RequestPhase::kHandling)) ==
+          "middleware");
+
+    CHECK(PhaseTracing::serverTimingValue(phases) ==
+          "parse;dur=0.002, pre_route;dur=0.001, middleware;dur=2.000");
+}
+
+DROGON_TEST(PhaseTracingSampling)
+{
+    PhaseTracing::configure(0, false);
+    CHECK(!PhaseTracing::shouldSample());
+
+    PhaseTracing::configure(1, true);
+    CHECK(PhaseTracing::serverTiming());
+    bool all = true;
+    for (int i = 0; i < 1000; ++i)
+        all = all && PhaseTracing::shouldSample();
+    CHECK(all);
+
+    PhaseTracing::configure(0.25, false);
+    int sampled = 0;
+    for (int i = 0; i < 100000; ++i)
+        sampled += PhaseTracing::shouldSample() ? 1 : 0;
+    CHECK(sampled > 20000);
+    CHECK(sampled < 30000);
+    PhaseTracing::configure(0, false);
+}
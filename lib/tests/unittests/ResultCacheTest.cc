@@ -0,0 +1,124 @@
+#include <drogon/drogon_test.h>
+#include "../../orm_lib/src/CachedDbClientImpl.h"
+#include <chrono>
+#include <thread>
+
+using namespace drogon::orm;
+
+namespace
+{
+// Answers every query with an empty result and counts them
+class CountingClient : public DbClient
+{
+  public:
+    CountingClient()
+    {
+        type_ = ClientType::PostgreSQL;
+    }
+
+    std::shared_ptr<Transaction> newTransaction(
+        const std::function<void(bool)> & = std::function<void(bool)>())
+        noexcept(false) override
+    {
+        return nullptr;
+    }
+
+    void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)> &)
+        override
+    {
+    }
+
+    bool hasAvailableConnections() const noexcept override
+    {
+        return true;
+    }
+
+    void setTimeout(double) override
+    {
+    }
+
+    void closeAll() override
+    {
+    }
+
+    int queries_{0};
+
+  private:
+    void execSql(const char *,
+                 size_t,
+                 size_t,
+                 std::vector<const char *> &&,
+                 std::vector<int> &&,
+                 std::vector<int> &&,
+                 ResultCallback &&rcb,
+                 std::function<void(const std::exception_ptr &)> &&) override
+    {
+        ++queries_;
+        rcb(Result(nullptr));
+    }
+};
+}  // namespace
+
+DROGON_TEST(ResultCacheTablesTest)
+{
+    using Tables = std::vector<std::string>;
+    CHECK(CachedDbClientImpl::tablesOf("select * from users where id = $1") ==
+          Tables{"users"});
+    CHECK(CachedDbClientImpl::tablesOf(
+              "SELECT a.x FROM public.Users a JOIN \"Orders\" o ON o.u = a.id, "
+              "items i WHERE 1 = 1") == (Tables{"users", "Orders", "items"}));
+    CHECK(CachedDbClientImpl::tablesOf(
+              "with d as (select * from a) select * from d, "
+              "(select 1 from b) s, c") == (Tables{"a", "d", "b", "c"}));
+    CHECK(CachedDbClientImpl::tablesOf("insert into t (a) values (1)") ==
+          Tables{"t"});
+    CHECK(CachedDbClientImpl::tablesOf("update a, b set a.x = b.y") ==
+          (Tables{"a", "b"}));
+    CHECK(CachedDbClientImpl::tablesOf("truncate table foo") == Tables{"foo"});
+    CHECK(CachedDbClientImpl::tablesOf("select 'from x' -- from y").empty());
+}
+
+DROGON_TEST(ResultCacheTest)
+{
+    auto counting = std::make_shared<CountingClient>();
+    auto client = CachedDbClient::newCachedClient(counting, 60.0);
+    auto query = [&client](int id) {
+        client->execSqlAsync(
+            "select * from users where id = $1",
+            [](const Result &) {},
+            [](const DrogonDbException &) {},
+            id);
+    };
+
+    query(1);
+    query(1);
+    CHECK(counting->queries_ == 1);
+    query(2);
+    CHECK(counting->queries_ == 2);
+
+    client->invalidate("orders");
+    query(1);
+    CHECK(counting->queries_ == 2);
+    client->invalidate("users");
+    query(1);
+    CHECK(counting->queries_ == 3);
+
+    // A write through the client invalidates its table
+    client->execSqlAsync(
+        "update users set name = $1",
+        [](const Result &) {},
+        [](const DrogonDbException &) {},
+        std::string("a"));
+    query(1);
+    query(2);
+    CHECK(counting->queries_ == 6);
+
+    auto shortLived = CachedDbClient::newCachedClient(counting, 0.01);
+    shortLived->execSqlAsync(
+        "select 1", [](const Result &) {}, [](const DrogonDbException &) {});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    shortLived->execSqlAsync(
+        "select 1", [](const Result &) {}, [](const DrogonDbException &) {});
+    CHECK(counting->queries_ == 8);
+}
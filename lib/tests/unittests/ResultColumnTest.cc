@@ -0,0 +1,164 @@
+#include <drogon/drogon_test.h>
+#include <drogon/orm/Exception.h>
+#include <drogon/orm/Field.h>
+#include <drogon/utils/JsonWriter.h>
+#include "../../orm_lib/src/ResultImpl.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace drogon::orm;
+
+namespace
+{
+// A result of text values like the ones of MySQL, NULL as a null pointer
+class TextResultImpl : public ResultImpl
+{
+  public:
+    TextResultImpl(std::vector<std::string> names,
+                   std::vector<std::vector<const char *>> rows)
+        : names_(std::move(names)), rows_(std::move(rows))
+    {
+    }
+
+    SizeType size() const noexcept override
+    {
+        return rows_.size();
+    }
+
+    RowSizeType columns() const noexcept override
+    {
+        return names_.size();
+    }
+
+    const char *columnName(RowSizeType number) const override
+    {
+        return names_[number].c_str();
+    }
+
+    SizeType affectedRows() const noexcept override
+    {
+        return 0;
+    }
+
+    RowSizeType columnNumber(const char colName[]) const override
+    {
+        for (RowSizeType i = 0; i < names_.size(); ++i)
+        {
+            if (names_[i] == colName)
+                return i;
+        }
+        throw RangeError(std::string("there is no column named ") + colName);
+    }
+
+    const char *getValue(SizeType row, RowSizeType column) const override
+    {
+        return rows_[row][column];
+    }
+
+    bool isNull(SizeType row, RowSizeType column) const override
+    {
+        return rows_[row][column] == nullptr;
+    }
+
+    FieldSizeType getLength(SizeType row, RowSizeType column) const override
+    {
+        auto value = rows_[row][column];
+        return value ? strlen(value) : 0;
+    }
+
+    unsigned long long insertId() const noexcept override
+    {
+        return 42;
+    }
+
+    JsonType jsonType(RowSizeType column) const override
+    {
+        return column < jsonTypes_.size() ? jsonTypes_[column] : kJsonString;
+    }
+
+    std::vector<JsonType> jsonTypes_;
+
+  private:
+    std::vector<std::string> names_;
+    std::vector<std::vector<const char *>> rows_;
+};
+
+Result makeResult()
+{
+    return Result(std::make_shared<TextResultImpl>(
+        std::vector<std::string>{"id", "Name"},
+        std::vector<std::vector<const char *>>{{"1", "alice"},
+                                               {"2", nullptr},
+                                               {"30", "carol"}}));
+}
+}  // namespace
+
+DROGON_TEST(ResultColumn)
+{
+    auto result = makeResult();
+    CHECK(result.column<int>(0) == (std::vector<int>{1, 2, 30}));
+    CHECK(result.column<std::string>("Name") ==
+          (std::vector<std::string>{"alice", "", "carol"}));
+    CHECK_THROWS_AS(result.column<int>("missing"), RangeError);
+}
+
+DROGON_TEST(ResultCompact)
+{
+    auto compact = makeResult().compact();
+    CHECK(compact.size() == 3);
+    CHECK(compact.columns() == 2);
+    CHECK(std::string(compact.columnName(1)) == "Name");
+    CHECK(compact.insertId() == 42);
+    // The names are looked up regardless of their case, as the drivers do
+    CHECK(compact.column<std::string>("name") ==
+          (std::vector<std::string>{"alice", "", "carol"}));
+    CHECK(compact.column<long>(0) == (std::vector<long>{1, 2, 30}));
+    CHECK(compact[1]["name"].isNull());
+    CHECK(compact[1]["name"].c_str() == nullptr);
+    CHECK(compact[2]["name"].length() == 5);
+    CHECK(std::string(compact[2]["name"].c_str()) == "carol");
+}
+
+DROGON_TEST(ResultWriteJson)
+{
+    auto impl = std::make_shared<TextResultImpl>(
+        std::vector<std::string>{"id", "name", "price", "ok", "doc", "raw"},
+        std::vector<std::vector<const char *>>{
+            {"1", "a\"b", "1.50", "t", "{\"x\":[1]}", "hi"},
+            {"2", nullptr, "NaN", "f", "null", nullptr},
+            {"3", "c", "007", "t", "[]", "\x01"}});
+    impl->jsonTypes_ = {ResultImpl::kJsonNumber,
+                        ResultImpl::kJsonString,
+                        ResultImpl::kJsonNumber,
+                        ResultImpl::kJsonBool,
+                        ResultImpl::kJsonDocument,
+                        ResultImpl::kJsonBinary};
+    Result result(impl);
+    std::string json;
+    {
+        drogon::JsonWriter writer(json);
+        result.writeJson(writer);
+    }
+    CHECK(json ==
+          "[{\"id\":1,\"name\":\"a\\\"b\",\"price\":1.50,\"ok\":true,"
+          "\"doc\":{\"x\":[1]},\"raw\":\"aGk=\"},"
+          "{\"id\":2,\"name\":null,\"price\":null,\"ok\":false,"
+          "\"doc\":null,\"raw\":null},"
+          "{\"id\":3,\"name\":\"c\",\"price\":\"007\",\"ok\":true,"
+          "\"doc\":[],\"raw\":\"AQ==\"}]");
+    // The compact copy keeps the types of the columns
+    std::string compactJson;
+    {
+        drogon::JsonWriter writer(compactJson);
+        result.compact().writeJson(writer);
+    }
+    CHECK(compactJson == json);
+
+    std::string empty;
+    {
+        drogon::JsonWriter writer(empty);
+        Result(nullptr).writeJson(writer);
+    }
+    CHECK(empty == "[]");
+}
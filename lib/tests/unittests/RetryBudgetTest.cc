@@ -0,0 +1,50 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/RetryBudget.h"
+
+using namespace drogon;
+
+DROGON_TEST(RetryBudgetTest)
+{
+    RetryBudget budget(0.1, 2);
+    // The bucket starts full
+    CHECK(budget.withdraw());
+    CHECK(budget.withdraw());
+    CHECK(!budget.withdraw());
+
+    // Ten requests pay for one extra request
+    for (int i = 0; i < 9; ++i)
+        budget.deposit();
+    CHECK(!budget.withdraw());
+    budget.deposit();
+    CHECK(budget.withdraw());
+    CHECK(!budget.withdraw());
+
+    // The tokens never exceed the capacity
+    for (int i = 0; i < 1000; ++i)
+        budget.deposit();
+    CHECK(budget.tokens() == 2.0);
+}
+
+DROGON_TEST(LatencyWindowTest)
+{
+    LatencyWindow window(100, 10);
+    for (int i = 1; i <= 9; ++i)
+        window.observe(i * 0.001);
+    CHECK(!window.percentile(0.95));
+    window.observe(0.01);
+    CHECK(window.percentile(0.5).has_value());
+
+    for (int i = 1; i <= 100; ++i)
+        window.observe(i * 0.001);
+    CHECK(window.samples() == 100u);
+    auto p95 = window.percentile(0.95);
+    REQUIRE(p95.has_value());
+    CHECK(*p95 > 0.0945);
+    CHECK(*p95 < 0.0965);
+
+    // The old latencies leave the window
+    for (int i = 0; i < 100; ++i)
+        window.observe(1.0);
+    CHECK(window.percentile(0.95) == 1.0);
+    CHECK(window.percentile(0.0) == 1.0);
+}
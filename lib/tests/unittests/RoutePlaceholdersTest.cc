@@ -0,0 +1,65 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/RoutePlaceholders.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace drogon::internal;
+
+namespace
+{
+std::vector<std::string> pathPlaceholders(std::string_view path)
+{
+    std::vector<std::string> names;
+    size_t pos = 0;
+    std::string_view name;
+    while (nextPathPlaceholder(path, pos, name))
+        names.emplace_back(name);
+    return names;
+}
+
+std::vector<std::pair<std::string, std::string>> queryPlaceholders(
+    std::string_view query)
+{
+    std::vector<std::pair<std::string, std::string>> placeholders;
+    size_t pos = 0;
+    std::string_view key, name;
+    while (nextQueryPlaceholder(query, pos, key, name))
+        placeholders.emplace_back(key, name);
+    return placeholders;
+}
+}  // namespace
+
+DROGON_TEST(RoutePlaceholdersTest)
+{
+    using Names = std::vector<std::string>;
+    CHECK(pathPlaceholders("/api/v1/user") == Names{});
+    CHECK(pathPlaceholders("/api/{}/info") == Names{""});
+    CHECK(pathPlaceholders("/api/{1}") == Names{"1"});
+    CHECK(pathPlaceholders("/user/{name}/posts/{2}") == (Names{"name", "2"}));
+    CHECK(pathPlaceholders("/user/{1:name}") == Names{"1:name"});
+    CHECK(pathPlaceholders("/files/{1}.json") == Names{"1"});
+    // A placeholder does not span segments
+    CHECK(pathPlaceholders("/api/{1/info}") == Names{});
+    CHECK(pathPlaceholders("/api/{1") == Names{});
+    CHECK(pathPlaceholders("/api/{1/{2}") == Names{"2"});
+    CHECK(pathPlaceholders("/api/1}/{2}") == Names{"2"});
+
+    using Pairs = std::vector<std::pair<std::string, std::string>>;
+    CHECK(queryPlaceholders("") == Pairs{});
+    CHECK(queryPlaceholders("a=1&b=2") == Pairs{});
+    CHECK(queryPlaceholders("a={}") == (Pairs{{"a", ""}}));
+    CHECK(queryPlaceholders("a={1}&b={name}&c=3&d={2:id}") ==
+          (Pairs{{"a", "1"}, {"b", "name"}, {"d", "2:id"}}));
+    CHECK(queryPlaceholders("a={1&b={2}") == (Pairs{{"b", "2"}}));
+    CHECK(queryPlaceholders("&&a={1}&") == (Pairs{{"a", "1"}}));
+
+    CHECK(isNumberAndName("1:name"));
+    CHECK(isNumberAndName("12:id"));
+    CHECK(isNumberAndName("1:"));
+    CHECK(!isNumberAndName(""));
+    CHECK(!isNumberAndName("1"));
+    CHECK(!isNumberAndName("name"));
+    CHECK(!isNumberAndName(":name"));
+    CHECK(!isNumberAndName("a1:name"));
+}
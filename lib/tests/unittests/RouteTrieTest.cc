@@ -0,0 +1,114 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpUtils.h"
+#include "../../lib/src/RouteTrie.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+struct TestItem
+{
+    std::string name;
+    bool enabled{true};
+};
+
+TestItem &add(RouteTrie<TestItem> &trie, const std::string &pattern)
+{
+    bool created;
+    auto &item = trie.insert(pattern, created);
+    item.name = pattern;
+    return item;
+}
+}  // namespace
+
+DROGON_TEST(RouteTrieTest)
+{
+    RouteTrie<TestItem> trie;
+    add(trie, "/api/v1/user/{1}");
+    add(trie, "/api/v1/user/{1}/posts/{2}");
+    add(trie, "/api/v1/user/me/posts/{1}");
+    add(trie, "/files/{1}.json");
+    add(trie, "/files/{1}");
+    auto &disabled = add(trie, "/disabled/{1}");
+    disabled.enabled = false;
+    add(trie, "/disabled/{1}/{2}");
+
+    std::vector<std::string_view> captures;
+    auto accept = [](const TestItem &item) { return item.enabled; };
+
+    auto item = trie.match("/api/v1/user/42", captures, accept);
+    REQUIRE(item != nullptr);
+    CHECK(item->name == "/api/v1/user/{1}");
+    REQUIRE(captures.size() == 1);
+    CHECK(captures[0] == "42");
+
+    item = trie.match("/API/V1/User/42/posts/7", captures, accept);
+    REQUIRE(item != nullptr);
+    CHECK(item->name == "/api/v1/user/{1}/posts/{2}");
+    REQUIRE(captures.size() == 2);
+    CHECK(captures[0] == "42");
+    CHECK(captures[1] == "7");
+
+    // Static segments win over placeholders
+    item = trie.match("/api/v1/user/me/posts/7", captures, accept);
+    REQUIRE(item != nullptr);
+    CHECK(item->name == "/api/v1/user/me/posts/{1}");
+    REQUIRE(captures.size() == 1);
+    CHECK(captures[0] == "7");
+
+    // Placeholders match empty segments like ([^/]*) did
+    item = trie.match("/api/v1/user/", captures, accept);
+    REQUIRE(item != nullptr);
+    CHECK(item->name == "/api/v1/user/{1}");
+    REQUIRE(captures.size() == 1);
+    CHECK(captures[0].empty());
+
+    item = trie.match("/files/data.JSON", captures, accept);
+    REQUIRE(item != nullptr);
+    CHECK(item->name == "/files/{1}.json");
+    REQUIRE(captures.size() == 1);
+    CHECK(captures[0] == "data");
+
+    item = trie.match("/files/data.xml", captures, accept);
+    REQUIRE(item != nullptr);
+    CHECK(item->name == "/files/{1}");
+    REQUIRE(captures.size() == 1);
+    CHECK(captures[0] == "data.xml");
+
+    // Rejected items are skipped
+    CHECK(trie.match("/disabled/1", captures, accept) == nullptr);
+    CHECK(captures.empty());
+    item = trie.match("/disabled/1/2", captures, accept);
+    REQUIRE(item != nullptr);
+    CHECK(item->name == "/disabled/{1}/{2}");
+
+    CHECK(trie.match("/api/v1/user/42/other", captures, accept) == nullptr);
+    CHECK(trie.match("/api/v1", captures, accept) == nullptr);
+    CHECK(trie.match("/nothing", captures, accept) == nullptr);
+
+    // Patterns with the same shape share one item
+    bool created;
+    trie.insert("/API/v1/user/{2}", created);
+    CHECK(created == false);
+    CHECK(trie.items().size() == 7);
+
+    trie.clear();
+    CHECK(trie.empty());
+    CHECK(trie.match("/api/v1/user/42", captures, accept) == nullptr);
+}
+
+// The maps of the exact paths of the controllers
+DROGON_TEST(IgnoreCaseMapTest)
+{
+    IgnoreCaseMap<int> map;
+    map["/api/users"] = 1;
+    CHECK(map.find("/API/Users") != map.end());
+    CHECK(map.find("/api/users")->second == 1);
+    CHECK(map.find("/api/user") == map.end());
+    CHECK(IgnoreCaseHash{}("/Api") == IgnoreCaseHash{}("/aPI"));
+    CHECK(IgnoreCaseEqual{}("/Api/V1", "/aPI/v1"));
+    CHECK(!IgnoreCaseEqual{}("/api/v1", "/api/v2"));
+}
@@ -0,0 +1,38 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+#include "../../lib/src/SecureRandom.h"
+#include <cstring>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(SecureRandomTest)
+{
+    // RFC 8439 2.3.2
+    uint32_t key[8];
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        key[i] = (i * 4) | ((i * 4 + 1) << 8) | ((i * 4 + 2) << 16) |
+                 ((i * 4 + 3) << 24);
+    }
+    const uint32_t nonce[3] = {0x09000000, 0x4a000000, 0};
+    unsigned char block[64];
+    ChaChaRandom::block(key, 1, nonce, block);
+    CHECK(utils::binaryStringToHex(block, 64, true) ==
+          "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+          "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e");
+
+    // Over several refills of the buffer
+    std::string a(1000, '\0'), b(1000, '\0');
+    CHECK(utils::secureRandomBytes(&a[0], a.size()));
+    CHECK(utils::secureRandomBytes(&b[0], b.size()));
+    CHECK(a != b);
+    CHECK(a != std::string(1000, '\0'));
+
+    auto str = utils::genRandomString(1000);
+    CHECK(str.size() == 1000);
+    CHECK(str.find_first_not_of("0123456789abcdefghijklmnopqrstuvwxyz"
+                                "ABCDEFGHIJKLMNOPQRSTUVWXYZ") ==
+          std::string::npos);
+    CHECK(utils::secureRandomString(100).size() == 100);
+}
@@ -0,0 +1,43 @@
+#include <drogon/drogon_test.h>
+#include <drogon/Session.h>
+#include <json/json.h>
+#include "../../lib/src/SessionCodec.h"
+
+using namespace drogon;
+
+DROGON_TEST(SessionCodecTest)
+{
+    Session::SessionMap data;
+    Json::Value json;
+    json["a"] = 1;
+    data["string"] = std::string("drogon");
+    data["bool"] = true;
+    data["int"] = -42;
+    data["uint"] = 42u;
+    data["long"] = -1234567890123L;
+    data["ullong"] = 18446744073709551615ULL;
+    data["double"] = 0.5;
+    data["json"] = json;
+    // Not serializable, skipped
+    data["pointer"] = static_cast<void *>(nullptr);
+
+    auto str = serializeSessionData(data);
+    Session::SessionMap restored;
+    REQUIRE(deserializeSessionData(str, restored));
+    CHECK(restored.size() == data.size() - 1);
+    CHECK(restored.find("pointer") == restored.end());
+    CHECK(std::any_cast<std::string>(restored["string"]) == "drogon");
+    CHECK(std::any_cast<bool>(restored["bool"]) == true);
+    CHECK(std::any_cast<int>(restored["int"]) == -42);
+    CHECK(std::any_cast<unsigned int>(restored["uint"]) == 42u);
+    CHECK(std::any_cast<long>(restored["long"]) == -1234567890123L);
+    CHECK(std::any_cast<unsigned long long>(restored["ullong"]) ==
+          18446744073709551615ULL);
+    CHECK(std::any_cast<double>(restored["double"]) == 0.5);
+    CHECK(std::any_cast<Json::Value>(restored["json"])["a"].asInt() == 1);
+
+    Session::SessionMap bad;
+    CHECK(deserializeSessionData("[]", bad) == false);
+    CHECK(deserializeSessionData("{\"k\":[\"int\",\"x\"]}", bad) == false);
+    CHECK(deserializeSessionData("not json", bad) == false);
+}
@@ -0,0 +1,98 @@
+#include <drogon/drogon_test.h>
+#include <drogon/Session.h>
+#include <trantor/net/EventLoopThread.h>
+#include "../../lib/src/SessionManager.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+void checkSession(const SessionPtr &session,
+                  const std::shared_ptr<drogon::test::Case> &TEST_CTX)
+{
+    session->insert("user", std::string("drogon"));
+    CHECK(session->get<std::string>("user") == "drogon");
+    CHECK(session->find("user"));
+    CHECK(session->get<int>("user") == 0);  // bad type
+    CHECK(session->getOptional<int>("none").has_value() == false);
+    session->modify<int>("count", [](int &count) { count = 1; });
+    session->modify<int>("count", [](int &count) { ++count; });
+    CHECK(session->get<int>("count") == 2);
+    session->modify(
+        [](Session::SessionMap &data) { data["extra"] = std::string("a"); });
+    CHECK(session->getOptional<std::string>("extra").value_or("") == "a");
+    session->erase("extra");
+    CHECK(session->find("extra") == false);
+    session->clear();
+    CHECK(session->find("user") == false);
+}
+}  // namespace
+
+DROGON_TEST(SessionTest)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    std::vector<AdviceStartSessionCallback> startAdvices;
+    std::vector<AdviceDestroySessionCallback> destroyAdvices;
+    SessionManager manager(
+        loopThread.getLoop(), 0, startAdvices, destroyAdvices, []() {
+            return std::string("id");
+        });
+    auto session = manager.getSession("a", false);
+    CHECK(session->isCopyOnWrite() == false);
+    checkSession(session, TEST_CTX);
+
+    SessionManager cowManager(loopThread.getLoop(),
+                              0,
+                              startAdvices,
+                              destroyAdvices,
+                              []() { return std::string("id"); },
+                              nullptr,
+                              0,
+                              true);
+    auto cowSession = cowManager.getSession("b", false);
+    CHECK(cowSession->isCopyOnWrite());
+    checkSession(cowSession, TEST_CTX);
+}
+
+DROGON_TEST(SessionCopyOnWriteThreads)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    std::vector<AdviceStartSessionCallback> startAdvices;
+    std::vector<AdviceDestroySessionCallback> destroyAdvices;
+    SessionManager manager(loopThread.getLoop(),
+                           0,
+                           startAdvices,
+                           destroyAdvices,
+                           []() { return std::string("id"); },
+                           nullptr,
+                           0,
+                           true);
+    auto session = manager.getSession("a", false);
+    std::atomic<bool> ordered{true};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&session, &ordered]() {
+            int last = 0;
+            for (int j = 0; j < 10000; ++j)
+            {
+                // A reader never sees the counter go back
+                auto count = session->get<int>("count");
+                if (count < last)
+                    ordered = false;
+                last = count;
+            }
+        });
+    }
+    for (int i = 0; i < 1000; ++i)
+        session->modify<int>("count", [](int &count) { ++count; });
+    for (auto &reader : readers)
+        reader.join();
+    CHECK(ordered);
+    CHECK(session->get<int>("count") == 1000);
+}
@@ -0,0 +1,67 @@
+#include <drogon/drogon_test.h>
+#include <drogon/ShardedCacheMap.h>
+#include <trantor/net/EventLoopThread.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+using namespace std::chrono_literals;
+
+DROGON_TEST(ShardedCacheMapTest)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    drogon::ShardedCacheMap<std::string, std::string> cache(
+        loopThread.getLoop(), 0.1f, 30);
+
+    for (size_t i = 1; i < 40; i++)
+        cache.insert(std::to_string(i), "a", i);
+    cache.insert("bla", "");
+    cache.insert("zzz", "-");
+    std::this_thread::sleep_for(3s);
+    CHECK(cache.find("0") == false);  // doesn't exist
+    CHECK(cache.find("1") == false);  // timeout
+    CHECK(cache.find("15") == true);
+    CHECK(cache.find("bla") == true);
+
+    cache.erase("30");
+    CHECK(cache.find("30") == false);
+
+    cache.modify("bla", [](std::string &s) { s = "asd"; });
+    CHECK(cache["bla"] == "asd");
+
+    std::string content;
+    cache.findAndFetch("zzz", content);
+    CHECK(content == "-");
+}
+
+DROGON_TEST(ShardedCacheMapThreads)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    drogon::ShardedCacheMap<std::string, size_t> cache(loopThread.getLoop(),
+                                                       0.1f);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&cache, t]() {
+            for (size_t i = 0; i < 10000; ++i)
+            {
+                auto key = std::to_string(t * 100 + i % 100);
+                cache.modify(key, [](size_t &count) { ++count; }, 1);
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    CHECK(cache.size() == 400u);
+    size_t count{0};
+    CHECK(cache.findAndFetch("0", count));
+    CHECK(count == 100u);
+    // Every entry expires once it is not accessed anymore
+    std::this_thread::sleep_for(1500ms);
+    CHECK(cache.size() == 0u);
+}
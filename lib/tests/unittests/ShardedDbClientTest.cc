@@ -0,0 +1,69 @@
+#include <drogon/drogon_test.h>
+#include <drogon/orm/ShardedDbClient.h>
+#include <map>
+
+using namespace drogon::orm;
+
+DROGON_TEST(ShardedDbClientTest)
+{
+    ShardedDbClient empty({});
+    CHECK(empty.client("tenant") == nullptr);
+    CHECK(empty.shard("tenant").empty());
+
+    ShardedDbClient sharded(
+        {{"s0", nullptr}, {"s1", nullptr}, {"s2", nullptr}, {"s3", nullptr}});
+    CHECK(sharded.shards().size() == 4);
+
+    // The keys are spread over all the shards, and always the same way
+    std::map<std::string, std::string> before;
+    std::map<std::string, size_t> counts;
+    for (int i = 0; i < 4000; ++i)
+    {
+        auto key = "tenant" + std::to_string(i);
+        before[key] = sharded.shard(key);
+        ++counts[before[key]];
+    }
+    CHECK(counts.size() == 4);
+    for (auto &[name, count] : counts)
+    {
+        CHECK(count > 600);
+        CHECK(count < 1400);
+    }
+    CHECK(sharded.shard("tenant42") == before["tenant42"]);
+
+    // A new shard only takes keys from the others
+    CHECK(sharded.addShard("s4", nullptr));
+    CHECK(!sharded.addShard("s4", nullptr));
+    size_t moved = 0;
+    for (auto &[key, shard] : before)
+    {
+        auto now = sharded.shard(key);
+        if (now != shard)
+        {
+            CHECK(now == "s4");
+            ++moved;
+        }
+    }
+    CHECK(moved > 400);
+    CHECK(moved < 1400);
+
+    // Removing it moves its keys back where they were
+    CHECK(sharded.removeShard("s4"));
+    CHECK(!sharded.removeShard("s4"));
+    for (auto &[key, shard] : before)
+        CHECK(sharded.shard(key) == shard);
+
+    // A pinned key goes to its shard whatever the ring says
+    auto other = before["tenant7"] == "s0" ? "s1" : "s0";
+    CHECK(sharded.pinKey("tenant7", other));
+    CHECK(!sharded.pinKey("tenant7", "unknown"));
+    CHECK(sharded.shard("tenant7") == other);
+    sharded.unpinKey("tenant7");
+    CHECK(sharded.shard("tenant7") == before["tenant7"]);
+
+    // The pinned keys of a removed shard go back to the ring
+    CHECK(sharded.pinKey("tenant7", "s3"));
+    CHECK(sharded.removeShard("s3"));
+    CHECK(sharded.shard("tenant7") != "s3");
+    CHECK(!sharded.shard("tenant7").empty());
+}
@@ -0,0 +1,50 @@
+#include <drogon/SharedMemoryMap.h>
+#include <drogon/drogon_test.h>
+#include <filesystem>
+#include <string>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+
+#ifdef __linux__
+DROGON_TEST(SharedMemoryMapTest)
+{
+    auto path = (std::filesystem::temp_directory_path() /
+                 ("drogon_shm_test_" + std::to_string(getpid())))
+                    .string();
+    std::filesystem::remove(path);
+    {
+        SharedMemoryMap map(path, 64, 64);
+        CHECK(map.maxEntrySize() == 32);
+        CHECK(map.insert("key", "value"));
+        std::string value;
+        CHECK(map.findAndFetch("key", value));
+        CHECK(value == "value");
+        CHECK(!map.insert("large", std::string(40, 'x')));
+        CHECK(!map.find("large"));
+
+        // Another mapping of the file, like the one of another process
+        SharedMemoryMap other(path, 64, 64);
+        CHECK(other.findAndFetch("key", value));
+        CHECK(value == "value");
+        other.erase("key");
+        CHECK(!map.find("key"));
+        CHECK_THROWS(SharedMemoryMap(path, 32, 64));
+
+        CHECK(map.increment("counter") == 1);
+        CHECK(other.increment("counter", 5) == 6);
+        CHECK(map.touch("counter", 60));
+        CHECK(!map.touch("missing", 60));
+
+        // The entry expiring first is evicted when the neighbours are used
+        for (size_t i = 1; i <= 200; ++i)
+            CHECK(map.insert("key" + std::to_string(i), "value", i));
+        CHECK(map.find("key200"));
+        map.clear();
+        CHECK(!map.find("key200"));
+    }
+    std::filesystem::remove(path);
+}
+#endif
@@ -0,0 +1,49 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/SpscRingBuffer.h"
+#include <string>
+#include <string_view>
+#include <thread>
+
+using namespace drogon;
+
+DROGON_TEST(SpscRingBufferTest)
+{
+    SpscRingBuffer<std::string> ring(3);
+    CHECK(ring.capacity() == 4u);
+    for (int i = 0; i < 4; ++i)
+    {
+        CHECK(ring.push(std::string_view("line")));
+    }
+    // Full
+    CHECK(ring.push(std::string_view("dropped")) == false);
+    std::string lines;
+    CHECK(ring.consumeAll([&lines](std::string &line) {
+        lines += line;
+        line.clear();
+    }) == 4u);
+    CHECK(lines == "linelinelineline");
+    CHECK(ring.consumeAll([](std::string &) {}) == 0u);
+
+    // One producer and one consumer
+    SpscRingBuffer<size_t> numbers(64);
+    constexpr size_t count = 100000;
+    std::thread producer([&numbers]() {
+        for (size_t i = 0; i < count; ++i)
+        {
+            while (!numbers.push(i))
+                std::this_thread::yield();
+        }
+    });
+    size_t expected{0};
+    bool ordered{true};
+    while (expected < count)
+    {
+        numbers.consumeAll([&expected, &ordered](size_t n) {
+            if (n != expected)
+                ordered = false;
+            ++expected;
+        });
+    }
+    producer.join();
+    CHECK(ordered);
+}
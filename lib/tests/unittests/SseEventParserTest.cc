@@ -0,0 +1,116 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/SseEventParser.h"
+#include "../../lib/src/SseSubscriptionManagerImpl.h"
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+struct Received
+{
+    std::string event;
+    std::string data;
+    std::string id;
+    int retry;
+};
+}  // namespace
+
+DROGON_TEST(SseEventParserTest)
+{
+    const std::string stream =
+        ": comment\r\n"
+        "event: update\r\n"
+        "id: 7\r\n"
+        "data: first\r\n"
+        "data:\r\n"
+        "data: third\r\n"
+        "\r\n"
+        "retry: 1500\n"
+        "data: {\"x\":1}\n"
+        "\n"
+        "id\n"
+        "data\n"
+        "\n"
+        "data: last\n"
+        "\n";
+
+    // The same events whatever the pieces of the stream are
+    for (size_t split = 0; split <= stream.size(); ++split)
+    {
+        std::vector<Received> events;
+        SseEventParser parser(SseEventParser::EventViewCallback(
+            [&events](const SseEventView &e) {
+                events.push_back({std::string(e.event),
+                                  std::string(e.data),
+                                  std::string(e.id),
+                                  e.retry});
+            }));
+        parser.feed(stream.data(), split);
+        parser.feed(stream.data() + split, stream.size() - split);
+        REQUIRE(events.size() == 3u);
+        CHECK(events[0].event == "update");
+        CHECK(events[0].data == "first\n\nthird");
+        CHECK(events[0].id == "7");
+        CHECK(events[1].event == "message");
+        CHECK(events[1].data == "{\"x\":1}");
+        CHECK(events[1].id.empty());
+        CHECK(events[1].retry == 1500);
+        CHECK(events[2].data == "last");
+        CHECK(events[2].retry == 0);
+        // The empty id resets the last one, the empty data is not an event
+        CHECK(parser.lastEventId().empty());
+        CHECK(parser.retry() == 1500);
+    }
+
+    // A single-line event received in one piece is not copied
+    const std::string simple = "event: tick\ndata: 42\n\n";
+    bool inPlace = false;
+    SseEventParser viewParser(SseEventParser::EventViewCallback(
+        [&simple, &inPlace](const SseEventView &e) {
+            inPlace = e.data.data() == simple.data() + 18 &&
+                      e.event.data() == simple.data() + 7;
+        }));
+    viewParser.feed(simple.data(), simple.size());
+    CHECK(inPlace);
+
+    // The events as shared objects, a line split by the buffer is kept
+    std::vector<SseEventPtr> shared;
+    SseEventParser eventParser(
+        [&shared](const SseEventPtr &event) { shared.push_back(event); });
+    trantor::MsgBuffer buffer;
+    buffer.append("id: a\ndata: he");
+    REQUIRE(eventParser.parse(&buffer));
+    CHECK(buffer.readableBytes() == 0u);
+    buffer.append("llo\r");
+    eventParser.parse(&buffer);
+    buffer.append("\n\r\n");
+    eventParser.parse(&buffer);
+    REQUIRE(shared.size() == 1u);
+    CHECK(shared[0]->data() == "hello");
+    CHECK(shared[0]->id() == "a");
+    CHECK(shared[0]->event() == "message");
+    CHECK(eventParser.lastEventId() == "a");
+}
+
+DROGON_TEST(SseReconnectDelayTest)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        // Jittered between the half of the backoff and the whole
+        auto first = SseSubscriptionManagerImpl::reconnectDelay(1, 30, 0, 1);
+        CHECK(first >= 0.5);
+        CHECK(first <= 1);
+        auto third = SseSubscriptionManagerImpl::reconnectDelay(1, 30, 0, 3);
+        CHECK(third >= 2);
+        CHECK(third <= 4);
+        auto capped = SseSubscriptionManagerImpl::reconnectDelay(1, 30, 0, 50);
+        CHECK(capped >= 15);
+        CHECK(capped <= 30);
+        // The retry time of the server replaces the initial delay
+        auto retry = SseSubscriptionManagerImpl::reconnectDelay(1, 30, 200, 1);
+        CHECK(retry >= 0.1);
+        CHECK(retry <= 0.2);
+    }
+}
@@ -0,0 +1,99 @@
+#include "../../lib/src/StaticFileCompressor.h"
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace drogon;
+
+DROGON_TEST(StaticFileCompressor)
+{
+    auto dir = std::filesystem::temp_directory_path() / "drogon_compressor";
+    std::filesystem::remove_all(dir);
+    auto sourcePath = (std::filesystem::temp_directory_path() /
+                       "drogon_compressor_source.js")
+                          .string();
+    std::string source;
+    for (int i = 0; i < 1000; ++i)
+    {
+        source += "console.log(" + std::to_string(i) + ");\n";
+    }
+    {
+        std::ofstream out(sourcePath, std::ios::binary);
+        out << source;
+    }
+    auto file = OpenedFile::open(sourcePath);
+    REQUIRE(file != nullptr);
+    CHECK(StaticFileCompressor::isCompressible(*file, ContentEncoding::kGzip));
+    CHECK(!StaticFileCompressor::isCompressible(*file, ContentEncoding::kNone));
+
+    StaticFileCompressor compressor(dir.string());
+    REQUIRE(compressor.usable());
+#ifndef _WIN32
+    // The cache is private
+    CHECK((std::filesystem::status(dir).permissions() &
+           std::filesystem::perms::all) == std::filesystem::perms::owner_all);
+#endif
+    auto path = compressor.compressedPath(*file, ContentEncoding::kGzip);
+    CHECK(path.find(dir.string()) == 0u);
+    CHECK(path.substr(path.length() - 3) == ".gz");
+    CHECK(compressor.status(path) == StaticFileCompressor::Status::kUnknown);
+
+    compressor.schedule(file, ContentEncoding::kGzip, path);
+    for (int i = 0; i < 500 && compressor.status(path) ==
+                                   StaticFileCompressor::Status::kPending;
+         ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(compressor.status(path) == StaticFileCompressor::Status::kUnknown);
+    auto compressed = OpenedFile::open(path);
+    REQUIRE(compressed != nullptr);
+    CHECK(compressed->size() < file->size());
+    std::ifstream in(path, std::ios::binary);
+    std::string data{std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>()};
+    CHECK(utils::gzipDecompress(data.data(), data.length()) == source);
+
+    // A changed source is compressed into another file
+    {
+        std::ofstream out(sourcePath, std::ios::binary | std::ios::app);
+        out << "console.log('changed');\n";
+    }
+    auto changedFile = OpenedFile::open(sourcePath);
+    REQUIRE(changedFile != nullptr);
+    CHECK(compressor.compressedPath(*changedFile, ContentEncoding::kGzip) !=
+          path);
+
+    std::filesystem::remove(sourcePath);
+    std::filesystem::remove_all(dir);
+}
+
+#ifndef _WIN32
+DROGON_TEST(StaticFileCompressorSharedCache)
+{
+    // Another user could plant files in a directory writable by others
+    auto dir =
+        std::filesystem::temp_directory_path() / "drogon_compressor_shared";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+    std::filesystem::permissions(dir, std::filesystem::perms::all);
+    CHECK(!StaticFileCompressor(dir.string()).usable());
+
+    std::filesystem::permissions(dir, std::filesystem::perms::owner_all);
+    CHECK(StaticFileCompressor(dir.string()).usable());
+
+    // A symbolic link is not followed
+    auto link =
+        std::filesystem::temp_directory_path() / "drogon_compressor_link";
+    std::filesystem::remove(link);
+    std::filesystem::create_directory_symlink(dir, link);
+    CHECK(!StaticFileCompressor(link.string()).usable());
+
+    std::filesystem::remove(link);
+    std::filesystem::remove_all(dir);
+}
+#endif
@@ -0,0 +1,73 @@
+#include "../../lib/src/StreamCompressor.h"
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+#include <string>
+
+using namespace drogon;
+
+static std::string makeInput()
+{
+    std::string input;
+    for (int i = 0; i < 2000; ++i)
+    {
+        input +=
+            "data: {\"id\":" + std::to_string(i) + ",\"value\":\"test\"}\n";
+    }
+    return input;
+}
+
+static void checkEncoding(ContentEncoding encoding,
+                          std::string (*decompress)(const char *, size_t),
+                          const std::shared_ptr<drogon::test::Case> &TEST_CTX)
+{
+    auto input = makeInput();
+    auto compressor = StreamCompressor::newCompressor(encoding);
+    REQUIRE(compressor != nullptr);
+    std::string out;
+    size_t pos = 0;
+    size_t step = 1000;
+    while (pos < input.length())
+    {
+        auto len = std::min(step, input.length() - pos);
+        // Every flushed prefix must be a decodable part of the stream
+        CHECK(compressor->compress(input.data() + pos, len, pos == 0, out));
+        pos += len;
+    }
+    CHECK(compressor->finish(out));
+    CHECK(out.length() < input.length() / 5);
+    CHECK(decompress(out.data(), out.length()) == input);
+}
+
+DROGON_TEST(StreamCompressorGzip)
+{
+    checkEncoding(ContentEncoding::kGzip, utils::gzipDecompress, TEST_CTX);
+
+    // Flushing after every piece keeps the stream decodable
+    auto compressor = StreamCompressor::newCompressor(ContentEncoding::kGzip);
+    REQUIRE(compressor != nullptr);
+    std::string out;
+    CHECK(compressor->compress("hello ", 6, true, out));
+    CHECK(!out.empty());
+    CHECK(compressor->compress("world", 5, true, out));
+    CHECK(compressor->finish(out));
+    CHECK(utils::gzipDecompress(out.data(), out.length()) == "hello world");
+}
+
+#ifdef USE_BROTLI
+DROGON_TEST(StreamCompressorBrotli)
+{
+    checkEncoding(ContentEncoding::kBrotli, utils::brotliDecompress, TEST_CTX);
+}
+#endif
+
+#ifdef USE_ZSTD
+DROGON_TEST(StreamCompressorZstd)
+{
+    checkEncoding(
+        ContentEncoding::kZstd,
+        [](const char *data, size_t length) {
+            return utils::zstdDecompress(data, length);
+        },
+        TEST_CTX);
+}
+#endif
@@ -0,0 +1,59 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/StringMapNodeCache.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(StringMapNodeCacheTest)
+{
+    StringMapNodeCache cache;
+    StringMapNodeCache::Map map;
+    cache.emplace(map, "Host", "example.com", true);
+    cache.emplace(map, "HOST", "ignored", true);
+    cache.assign(map, "a", "1");
+    cache.assign(map, "a", "2");
+    map["long"] = std::string(2000, 'x');
+    CHECK(map.size() == 3);
+    CHECK(map["host"] == "example.com");
+    CHECK(map["a"] == "2");
+
+    // The nodes holding long strings are not kept
+    cache.recycle(map);
+    CHECK(map.empty());
+    CHECK(cache.size() == 2);
+
+    cache.assign(map, "b", "1");
+    cache.assign(map, "b", "2");
+    cache.emplace(map, "b", "3");
+    cache.emplace(map, "c", "4");
+    CHECK(map.size() == 2);
+    CHECK(map["b"] == "2");
+    CHECK(map["c"] == "4");
+    CHECK(cache.size() == 0);
+
+    SUBSECTION(PooledRequest)
+    {
+        HttpRequestImpl req(nullptr);
+        auto addLine = [&req](const std::string &line) {
+            auto colon = line.find(':');
+            req.addHeader(line.data(),
+                          line.data() + colon,
+                          line.data() + line.length());
+        };
+        for (int i = 0; i < 2; ++i)
+        {
+            addLine("Host: example.com");
+            addLine("Accept: */*");
+            addLine("Cookie: a=1; b=2; a=3");
+            req.setQuery("x=1&y=2");
+            CHECK(req.headers().size() == 2);
+            CHECK(req.getHeader("host") == "example.com");
+            CHECK(req.getCookie("a") == "3");
+            CHECK(req.getParameter("y") == "2");
+            req.reset();
+            CHECK(req.headers().empty());
+            CHECK(req.cookies().empty());
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/TimeoutWheel.h"
+#include <trantor/net/EventLoopThread.h>
+#include <chrono>
+#include <future>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+struct Entry : TimeoutEntry
+{
+    Entry(std::string name, std::string &log) : name(std::move(name)), log(log)
+    {
+    }
+
+    void onTimeout() override
+    {
+        log += name;
+        if (repeat > 0)
+        {
+            --repeat;
+            TimeoutWheel::instance(loop).schedule(this, 0.1);
+        }
+    }
+
+    std::string name;
+    std::string &log;
+    trantor::EventLoop *loop{nullptr};
+    int repeat{0};
+};
+}  // namespace
+
+DROGON_TEST(TimeoutWheelTest)
+{
+    trantor::EventLoopThread thread;
+    thread.run();
+    auto loop = thread.getLoop();
+    std::string log;
+    Entry a("a", log), b("b", log), c("c", log), d("d", log);
+    d.loop = loop;
+    d.repeat = 2;
+    auto start = std::chrono::steady_clock::now();
+    std::promise<void> scheduled;
+    loop->queueInLoop([&]() {
+        auto &wheel = TimeoutWheel::instance(loop);
+        wheel.schedule(&b, 0.3);
+        wheel.schedule(&a, 0.1);
+        wheel.schedule(&c, 0.2);
+        wheel.schedule(&d, 0.15);
+        // Rescheduled and cancelled entries
+        wheel.schedule(&c, 0.6);
+        wheel.schedule(&a, 0.05);
+        b.cancel();
+        scheduled.set_value();
+    });
+    scheduled.get_future().wait();
+
+    std::promise<double> done;
+    loop->runAfter(0.9, [&]() {
+        auto &wheel = TimeoutWheel::instance(loop);
+        CHECK(wheel.size() == 0u);
+        CHECK(!c.scheduled());
+        done.set_value(std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count());
+    });
+    CHECK(done.get_future().get() >= 0.9);
+    // d times out at 0.15, 0.25 and 0.35 seconds, c at 0.6
+    CHECK(log == "adddc");
+
+    // An entry that doesn't time out before its delay
+    std::promise<double> elapsed;
+    struct Timed : TimeoutEntry
+    {
+        void onTimeout() override
+        {
+            result->set_value(std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count());
+        }
+
+        std::chrono::steady_clock::time_point start;
+        std::promise<double> *result;
+    } timed;
+    timed.result = &elapsed;
+    loop->queueInLoop([&]() {
+        timed.start = std::chrono::steady_clock::now();
+        TimeoutWheel::instance(loop).schedule(&timed, 0.25);
+    });
+    auto seconds = elapsed.get_future().get();
+    CHECK(seconds >= 0.25);
+    CHECK(seconds < 0.25 + TimeoutWheel::kTick + 0.2);
+    loop->quit();
+}
@@ -0,0 +1,60 @@
+#include <drogon/utils/TraceContext.h>
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(TraceContext)
+{
+    auto context = TraceContext::fromTraceparent(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01");
+    CHECK(context.valid());
+    CHECK(context.sampled);
+    CHECK(context.traceIdHigh == 0x4bf92f3577b34da6ULL);
+    CHECK(context.traceIdLow == 0xa3ce929d0e0e4736ULL);
+    CHECK(context.spanId == 0x00f067aa0ba902b7ULL);
+    CHECK(context.traceIdHex() == "4bf92f3577b34da6a3ce929d0e0e4736");
+    CHECK(context.traceparent() ==
+          "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01");
+
+    context = TraceContext::fromTraceparent(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00");
+    CHECK(context.valid());
+    CHECK(!context.sampled);
+
+    // The later versions may append fields
+    CHECK(TraceContext::fromTraceparent(
+              "01-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-xyz")
+              .valid());
+
+    // Malformed
+    CHECK(!TraceContext::fromTraceparent("").valid());
+    CHECK(!TraceContext::fromTraceparent(
+               "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-xyz")
+               .valid());
+    CHECK(!TraceContext::fromTraceparent(
+               "ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01")
+               .valid());
+    CHECK(!TraceContext::fromTraceparent(
+               "00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01")
+               .valid());
+    CHECK(!TraceContext::fromTraceparent(
+               "00-00000000000000000000000000000000-00f067aa0ba902b7-01")
+               .valid());
+    CHECK(!TraceContext::fromTraceparent(
+               "00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01")
+               .valid());
+}
+
+DROGON_TEST(TraceScope)
+{
+    CHECK(!internal::currentTraceContext().valid());
+    {
+        TraceContext context;
+        context.traceIdLow = 1;
+        context.spanId = 2;
+        internal::TraceScope scope(context);
+        CHECK(internal::currentTraceContext().spanId == 2);
+    }
+    CHECK(!internal::currentTraceContext().valid());
+}
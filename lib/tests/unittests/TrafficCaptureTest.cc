@@ -0,0 +1,49 @@
+#include <drogon/drogon_test.h>
+#include <drogon/plugins/TrafficCapture.h>
+#include <string>
+
+using namespace drogon;
+using drogon::plugin::TrafficCapture;
+
+DROGON_TEST(TrafficCaptureTest)
+{
+    TrafficCapture::Record first;
+    first.gap = 1500;
+    first.method = Post;
+    first.path = "/api/items";
+    first.query = "page=2";
+    first.headers = {{"content-type", "application/json"}, {"x-id", ""}};
+    first.body = std::string(300, 'b') + std::string(1, '\0');
+    TrafficCapture::Record second;
+    second.path = "/";
+
+    std::string log;
+    TrafficCapture::encode(first, log);
+    TrafficCapture::encode(second, log);
+
+    TrafficCapture::Record record;
+    auto size = TrafficCapture::decode(log, record);
+    REQUIRE(size > 0u);
+    CHECK(record.gap == 1500u);
+    CHECK(record.method == Post);
+    CHECK(record.path == first.path);
+    CHECK(record.query == first.query);
+    CHECK(record.headers == first.headers);
+    CHECK(record.body == first.body);
+
+    auto rest = std::string_view(log).substr(size);
+    CHECK(TrafficCapture::decode(rest, record) == rest.size());
+    CHECK(record.gap == 0u);
+    CHECK(record.method == Get);
+    CHECK(record.path == "/");
+    CHECK(record.headers.empty());
+    CHECK(record.body.empty());
+
+    // A record cut by the end of the log, and a corrupted one
+    CHECK(TrafficCapture::decode(std::string_view(log).substr(0, size - 1),
+                                 record) == 0u);
+    CHECK(TrafficCapture::decode({}, record) == 0u);
+    auto corrupted = log;
+    corrupted[0] = static_cast<char>(0xff);
+    CHECK(TrafficCapture::decode(corrupted, record) == 0u);
+}
@@ -0,0 +1,121 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/UpstreamBalancer.h"
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(UpstreamBalancerTest)
+{
+    std::vector<std::string> names{"http://a", "http://b", "http://c"};
+    UpstreamBalancer::Options options;
+    options.maxFails = 2;
+    options.failTimeout = 1000;
+
+    // Round robin, with a server down after two failures
+    {
+        UpstreamBalancer balancer(names,
+                                  UpstreamBalancer::Policy::kRoundRobin,
+                                  options);
+        std::vector<size_t> counts(3);
+        for (int i = 0; i < 30; ++i)
+            ++counts[balancer.pick("", 0)];
+        CHECK(counts[0] == 10u);
+        CHECK(counts[1] == 10u);
+        CHECK(counts[2] == 10u);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            balancer.onStart(1);
+            balancer.onFinish(1, false, 0, 100);
+        }
+        CHECK(!balancer.isAvailable(1, 100));
+        for (int i = 0; i < 10; ++i)
+            CHECK(balancer.pick("", 200) != 1u);
+        CHECK(balancer.isAvailable(1, 1100));
+        CHECK(balancer.pick("", 200, 0) == 2u);
+        CHECK(balancer.activeRequests(1) == 0u);
+
+        // All down, they are still tried
+        for (size_t index : {0, 2})
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                balancer.onStart(index);
+                balancer.onFinish(index, false, 0, 100);
+            }
+        }
+        CHECK(balancer.pick("", 200) != UpstreamBalancer::npos);
+    }
+    // Least connections
+    {
+        UpstreamBalancer balancer(names,
+                                  UpstreamBalancer::Policy::kLeastConnections,
+                                  options);
+        balancer.onStart(0);
+        balancer.onStart(0);
+        balancer.onStart(2);
+        CHECK(balancer.pick("", 0) == 1u);
+        balancer.onStart(1);
+        balancer.onStart(1);
+        CHECK(balancer.pick("", 0) == 2u);
+        balancer.onCancel(0);
+        balancer.onCancel(0);
+        CHECK(balancer.pick("", 0) == 0u);
+    }
+    // Latency
+    {
+        UpstreamBalancer balancer(names,
+                                  UpstreamBalancer::Policy::kEwmaLatency,
+                                  options);
+        int64_t latencies[] = {5000, 1000, 3000};
+        for (size_t i = 0; i < 3; ++i)
+        {
+            balancer.onStart(i);
+            balancer.onFinish(i, true, latencies[i], 10);
+        }
+        CHECK(balancer.latency(1) == 1000.0);
+        CHECK(balancer.pick("", 20) == 1u);
+        // The requests in flight weigh on the latency
+        for (int i = 0; i < 3; ++i)
+            balancer.onStart(1);
+        CHECK(balancer.pick("", 20) == 2u);
+    }
+    // Consistent hash
+    {
+        UpstreamBalancer balancer(names,
+                                  UpstreamBalancer::Policy::kConsistentHash,
+                                  options);
+        std::vector<size_t> counts(3);
+        std::vector<size_t> picks;
+        for (int i = 0; i < 300; ++i)
+        {
+            auto index = balancer.pick("client" + std::to_string(i), 0);
+            CHECK(index == balancer.pick("client" + std::to_string(i), 0));
+            ++counts[index];
+            picks.push_back(index);
+        }
+        for (auto count : counts)
+            CHECK(count > 50u);
+        // Only the keys of the server which is down move
+        for (int i = 0; i < 2; ++i)
+        {
+            balancer.onStart(0);
+            balancer.onFinish(0, false, 0, 100);
+        }
+        for (int i = 0; i < 300; ++i)
+        {
+            auto index = balancer.pick("client" + std::to_string(i), 200);
+            CHECK(index != 0u);
+            if (picks[i] != 0)
+                CHECK(index == picks[i]);
+        }
+    }
+
+    bool ok;
+    CHECK(UpstreamBalancer::parsePolicy("ewma_latency", &ok) ==
+          UpstreamBalancer::Policy::kEwmaLatency);
+    CHECK(ok);
+    UpstreamBalancer::parsePolicy("random", &ok);
+    CHECK(!ok);
+}
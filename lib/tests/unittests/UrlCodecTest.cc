@@ -2,6 +2,7 @@
 #include <drogon/utils/Utilities.h>
 #include <iostream>
 #include <drogon/drogon_test.h>
+#include "../../lib/src/HttpRequestImpl.h"
 
 DROGON_TEST(URLCodec)
 {
@@ -12,3 +13,49 @@ DROGON_TEST(URLCodec)
     CHECK(encoded == "k1=1&k2=%E5%AE%89");
     CHECK(input == decoded);
 }
+
+DROGON_TEST(URLDecodeBlocks)
+{
+    // Escapes on both sides of the blocks the decoding copies at once
+    std::string plain(100, 'x');
+    for (size_t pos : {0, 15, 16, 31, 32, 63, 97})
+    {
+        auto encoded = plain;
+        encoded.replace(pos, 1, "%41");
+        auto expected = plain;
+        expected[pos] = 'A';
+        CHECK(drogon::utils::needUrlDecoding(encoded.data(),
+                                             encoded.data() + encoded.size()));
+        CHECK(drogon::utils::urlDecode(encoded) == expected);
+        encoded[pos] = '+';
+        expected.replace(pos, 1, " 41");
+        CHECK(drogon::utils::urlDecode(encoded) == expected);
+    }
+    CHECK(!drogon::utils::needUrlDecoding(plain.data(),
+                                          plain.data() + plain.size()));
+    CHECK(drogon::utils::urlDecode(std::string_view{"%4"}) == "%4");
+    CHECK(drogon::utils::urlDecode(std::string_view{"%zz%41"}) == "%zzA");
+
+    // In place
+    std::string buffer = plain + "%E5%AE%89+" + plain;
+    buffer.resize(drogon::utils::urlDecode(buffer.data(),
+                                           buffer.data() + buffer.size(),
+                                           &buffer[0]));
+    CHECK(buffer == plain + "安 " + plain);
+}
+
+DROGON_TEST(URLEncodedParameters)
+{
+    drogon::HttpRequestImpl req(nullptr);
+    req.setQuery("? a=1&b=%E5%AE%89&c&&a=2&long+key=" + std::string(40, 'v'));
+    req.addHeader("Content-Type", "Application/X-WWW-Form-Urlencoded");
+    req.setBody("b=x+y&d=%zz");
+    auto &params = req.getParameters();
+    CHECK(params.size() == 6);
+    CHECK(req.getParameter("a") == "2");
+    CHECK(req.getParameter("b") == "x y");
+    CHECK(params.count("c") == 1);
+    CHECK(params.count("") == 1);
+    CHECK(req.getParameter("d") == "%zz");
+    CHECK(req.getParameter("long key") == std::string(40, 'v'));
+}
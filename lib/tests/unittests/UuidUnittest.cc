@@ -15,3 +15,23 @@ DROGON_TEST(UuidTest)
     CHECK(uuid[23] == '-');
     CHECK(uuid.size() == 36);
 }
+
+DROGON_TEST(UuidVersionTest)
+{
+    auto uuid = drogon::utils::getUuid();
+    CHECK(uuid[14] == '4');
+    CHECK(std::string_view("89ab").find(uuid[19]) != std::string_view::npos);
+    CHECK(drogon::utils::getUuid(false) != drogon::utils::getUuid(false));
+
+    // Time ordered, also inside a millisecond
+    std::string last = drogon::utils::getUuidV7();
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto next = drogon::utils::getUuidV7();
+        CHECK(next > last);
+        CHECK(next[14] == '7');
+        CHECK(std::string_view("89ab").find(next[19]) !=
+              std::string_view::npos);
+        last = std::move(next);
+    }
+}
@@ -0,0 +1,107 @@
+#include "../../lib/src/WebSocketDeflate.h"
+#include <drogon/drogon_test.h>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(WebSocketDeflateNegotiation)
+{
+    WebSocketCompressionOptions options;
+    options.enabled = true;
+    std::string response;
+
+    auto offer = WebSocketDeflate::makeOffer(options);
+    CHECK(offer == "permessage-deflate; client_max_window_bits");
+    CHECK(WebSocketDeflate::acceptOffer("x-webkit-deflate-frame, " + offer,
+                                        options,
+                                        response));
+    CHECK(response == "permessage-deflate");
+
+    CHECK(WebSocketDeflate::acceptOffer(
+        "permessage-deflate; server_max_window_bits=10; "
+        "client_max_window_bits; client_no_context_takeover",
+        options,
+        response));
+    CHECK(response ==
+          "permessage-deflate; client_no_context_takeover; "
+          "server_max_window_bits=10");
+
+    // zlib can't compress with a 8 bits window
+    CHECK(!WebSocketDeflate::acceptOffer(
+        "permessage-deflate; server_max_window_bits=8", options, response));
+    CHECK(!WebSocketDeflate::acceptOffer("permessage-deflate; unknown",
+                                         options,
+                                         response));
+    CHECK(!WebSocketDeflate::acceptOffer(
+        "permessage-deflate; server_no_context_takeover; "
+        "server_no_context_takeover",
+        options,
+        response));
+
+    // The windows are lowered to fit the memory limit
+    options.maxMemoryPerConnection = 64 * 1024;
+    CHECK(WebSocketDeflate::acceptOffer(
+        "permessage-deflate; client_max_window_bits", options, response));
+    CHECK(response == "permessage-deflate; server_max_window_bits=12");
+    options.maxMemoryPerConnection = 1024;
+    CHECK(WebSocketDeflate::makeOffer(options).empty());
+
+    WebSocketDeflateParams params;
+    CHECK(WebSocketDeflate::parseResponse(
+        "permessage-deflate; server_no_context_takeover; "
+        "client_max_window_bits=12",
+        params));
+    CHECK(params.serverNoContextTakeover);
+    CHECK(!params.clientNoContextTakeover);
+    CHECK(params.serverMaxWindowBits == 15);
+    CHECK(params.clientMaxWindowBits == 12);
+    CHECK(!WebSocketDeflate::parseResponse(
+        "permessage-deflate; client_max_window_bits", params));
+    CHECK(!WebSocketDeflate::parseResponse("x-webkit-deflate-frame", params));
+}
+
+DROGON_TEST(WebSocketDeflateMessages)
+{
+    WebSocketCompressionOptions options;
+    options.enabled = true;
+    WebSocketDeflateParams params;
+    params.serverNoContextTakeover = true;
+    WebSocketDeflate server(params, options, true, 1024 * 1024);
+    WebSocketDeflate client(params, options, false, 1024 * 1024);
+    REQUIRE(server.ok());
+    REQUIRE(client.ok());
+    CHECK(!server.shouldCompress(100));
+    CHECK(server.shouldCompress(256));
+
+    std::string message;
+    for (int i = 0; i < 200; ++i)
+    {
+        message += "{\"id\":" + std::to_string(i % 10) + ",\"value\":1}";
+    }
+    // The context of the client is kept, the one of the server is reset
+    size_t firstClientSize = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        std::string payload;
+        CHECK(server.compress(message.data(), message.length(), payload));
+        CHECK(payload.length() < message.length() / 10);
+        CHECK(client.decompress(payload));
+        CHECK(payload == message);
+
+        payload.clear();
+        CHECK(client.compress(message.data(), message.length(), payload));
+        if (i == 0)
+            firstClientSize = payload.length();
+        else
+            CHECK(payload.length() < firstClientSize);
+        CHECK(server.decompress(payload));
+        CHECK(payload == message);
+    }
+
+    // An inflated message larger than the limit is rejected
+    WebSocketDeflate small(params, options, false, 1000);
+    REQUIRE(small.ok());
+    std::string payload;
+    CHECK(server.compress(message.data(), message.length(), payload));
+    CHECK(!small.decompress(payload));
+}
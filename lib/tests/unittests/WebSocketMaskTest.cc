@@ -0,0 +1,42 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/WebSocketMask.h"
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(WebSocketMaskTest)
+{
+    MANDATE(websocket_mask::implementationName() != nullptr);
+    const char key[4] = {'\x37', '\xfa', '\x21', '\x3d'};
+
+    // Value from rfc6455-5.7
+    std::string hello("\x7f\x9f\x4d\x51\x58", 5);
+    websocket_mask::apply(&hello[0], hello.data(), hello.length(), key);
+    CHECK(hello == "Hello");
+
+    // Check every tail length across the 8, 16 and 32 byte widths, with
+    // unaligned buffers
+    std::string input;
+    for (int i = 0; i < 200; ++i)
+        input.push_back(static_cast<char>(i * 7 + 3));
+    for (size_t offset = 0; offset < 4; ++offset)
+    {
+        for (size_t len = 0; len + offset <= input.length(); len += 3)
+        {
+            const char *src = input.data() + offset;
+            std::string expected(len, '\0');
+            for (size_t i = 0; i < len; ++i)
+                expected[i] = static_cast<char>(src[i] ^ key[i % 4]);
+            std::string out(len + 1, '\0');
+            websocket_mask::apply(&out[1], src, len, key);
+            CHECK(out.substr(1) == expected);
+
+            // In place, and masking twice restores the data
+            std::string inPlace(src, len);
+            websocket_mask::apply(&inPlace[0], inPlace.data(), len, key);
+            CHECK(inPlace == expected);
+            websocket_mask::apply(&inPlace[0], inPlace.data(), len, key);
+            CHECK(inPlace == std::string(src, len));
+        }
+    }
+}
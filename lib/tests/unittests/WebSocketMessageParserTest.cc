@@ -0,0 +1,49 @@
+#include <drogon/drogon_test.h>
+#include <trantor/utils/MsgBuffer.h>
+#include "../../lib/src/WebSocketConnectionImpl.h"
+
+using namespace drogon;
+
+DROGON_TEST(WebSocketMessageParserTest)
+{
+    WebSocketMessageParser parser;
+    trantor::MsgBuffer buffer;
+    std::string_view message;
+    WebSocketMessageType type;
+
+    // A masked single frame message, from rfc6455-5.7
+    const unsigned char masked[] = {
+        0x81, 0x85, 0x37, 0xfa, 0x21, 0x3d, 0x7f, 0x9f, 0x4d, 0x51, 0x58};
+    buffer.append(reinterpret_cast<const char *>(masked), sizeof(masked));
+    REQUIRE(parser.parse(&buffer));
+    REQUIRE(parser.gotAll(message, type));
+    CHECK(message == "Hello");
+    CHECK(type == WebSocketMessageType::Text);
+    // Unmasked in the buffer, which is retrieved by the next call
+    CHECK(message.data() == buffer.peek() + 6);
+    CHECK(parser.takeMessage() == "Hello");
+
+    // A fragmented unmasked message
+    const unsigned char fragmented[] = {
+        0x01, 0x03, 0x48, 0x65, 0x6c, 0x80, 0x02, 0x6c, 0x6f};
+    buffer.append(reinterpret_cast<const char *>(fragmented),
+                  sizeof(fragmented));
+    REQUIRE(parser.parse(&buffer));
+    CHECK(buffer.readableBytes() == 0);
+    REQUIRE(parser.gotAll(message, type));
+    CHECK(message == "Hello");
+    CHECK(parser.takeMessage() == "Hello");
+
+    // An incomplete frame
+    buffer.append(reinterpret_cast<const char *>(masked), 4);
+    REQUIRE(parser.parse(&buffer));
+    CHECK(!parser.gotAll(message, type));
+    buffer.append(reinterpret_cast<const char *>(masked) + 4,
+                  sizeof(masked) - 4);
+    REQUIRE(parser.parse(&buffer));
+    REQUIRE(parser.gotAll(message, type));
+    CHECK(message == "Hello");
+    REQUIRE(parser.parse(&buffer));
+    CHECK(!parser.gotAll(message, type));
+    CHECK(buffer.readableBytes() == 0);
+}
@@ -0,0 +1,41 @@
+#include "../../lib/src/WorkerProcesses.h"
+#include <drogon/drogon_test.h>
+
+using namespace drogon;
+
+DROGON_TEST(WorkerProcessesMergeTest)
+{
+    std::string first =
+        "# HELP requests The requests\n"
+        "# TYPE requests counter\n"
+        "requests{path=\"/a b\"} 1.000000\n"
+        "requests{path=\"/c\"} 2.000000\n"
+        "# HELP latency The latency\n"
+        "# TYPE latency summary\n"
+        "latency{quantile=\"0.5\"} 3.000000\n"
+        "latency_count 4.000000\n";
+    std::string second =
+        "# HELP requests The requests\n"
+        "# TYPE requests counter\n"
+        "requests{path=\"/c\"} 5.000000\n"
+        "requests{path=\"/d\"} 1.000000\n"
+        "# HELP latency The latency\n"
+        "# TYPE latency summary\n"
+        "latency{quantile=\"0.5\"} 7.000000\n"
+        "latency_count 1.000000\n";
+    CHECK(WorkerProcesses::mergeMetrics({first, second}) ==
+          "# HELP requests The requests\n"
+          "# TYPE requests counter\n"
+          "requests{path=\"/a b\"} 1.000000\n"
+          "requests{path=\"/c\"} 7.000000\n"
+          "requests{path=\"/d\"} 1.000000\n"
+          "# HELP latency The latency\n"
+          "# TYPE latency summary\n"
+          "latency{quantile=\"0.5\"} 7.000000\n"
+          "latency_count 5.000000\n");
+    CHECK(WorkerProcesses::mergeMetrics({first}) == first);
+
+    // Not a worker
+    CHECK(WorkerProcesses::instance().index() == 0);
+    CHECK(WorkerProcesses::instance().otherMetrics().empty());
+}
@@ -0,0 +1,54 @@
+#include <drogon/utils/Utilities.h>
+#include <drogon/drogon_test.h>
+#include <string>
+using namespace drogon::utils;
+
+DROGON_TEST(ZstdTest)
+{
+    SUBSECTION(shortText)
+    {
+        std::string source{"123中文顶替要枯械"};
+        auto compressed = zstdCompress(source.data(), source.length());
+        auto decompressed =
+            zstdDecompress(compressed.data(), compressed.length());
+        CHECK(source == decompressed);
+    }
+
+    SUBSECTION(longText)
+    {
+        std::string source;
+        for (size_t i = 0; i < 100000; i++)
+        {
+            source.append(std::to_string(i));
+        }
+        auto compressed = zstdCompress(source.data(), source.length(), 19);
+        auto decompressed =
+            zstdDecompress(compressed.data(), compressed.length());
+        CHECK(source == decompressed);
+        // Truncated input
+        CHECK(zstdDecompress(compressed.data(), compressed.length() / 2)
+                  .empty());
+    }
+
+    SUBSECTION(dictionary)
+    {
+        std::string dictionary;
+        for (size_t i = 0; i < 200; i++)
+        {
+            dictionary.append("{\"id\":" + std::to_string(i * 7) +
+                              ",\"name\":\"drogon\"}");
+        }
+        std::string source{"{\"id\":42,\"name\":\"drogon\"}"};
+        auto compressed =
+            zstdCompress(source.data(), source.length(), 3, dictionary);
+        auto plain = zstdCompress(source.data(), source.length());
+        CHECK(compressed.length() < plain.length());
+        // The digested dictionary is reused by the second call
+        for (int i = 0; i < 2; ++i)
+        {
+            CHECK(zstdDecompress(compressed.data(),
+                                 compressed.length(),
+                                 dictionary) == source);
+        }
+    }
+}
@@ -15,7 +15,11 @@
 
 #include <drogon/exports.h>
 #include <drogon/nosql/RedisResult.h>
+#include <drogon/nosql/RedisCommandFormat.h>
 #include <drogon/nosql/RedisException.h>
+#include <drogon/nosql/RedisPipeline.h>
+#include <drogon/nosql/RedisScanner.h>
+#include <drogon/nosql/RedisStreamConsumer.h>
 #include <drogon/nosql/RedisSubscriber.h>
 #include <string_view>
 #include <trantor/net/InetAddress.h>
@@ -23,6 +27,7 @@
 #include <memory>
 #include <functional>
 #include <future>
+#include <vector>
 #ifdef __cpp_impl_coroutine
 #include <drogon/utils/coroutine.h>
 #endif
@@ -37,7 +42,8 @@ class RedisTransaction;
 
 namespace internal
 {
-struct [[nodiscard]] RedisAwaiter : public CallbackAwaiter<RedisResult>
+struct [[nodiscard]] RedisAwaiter
+    : public drogon::internal::DeadlineAwaiter<RedisResult>
 {
     using RedisFunction =
         std::function<void(RedisResultCallback &&, RedisExceptionCallback &&)>;
@@ -47,18 +53,37 @@ struct [[nodiscard]] RedisAwaiter : public CallbackAwaiter<RedisResult>
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle)
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle)
     {
-        function_(
-            [handle, this](const RedisResult &result) {
-                this->setValue(result);
-                handle.resume();
-            },
-            [handle, this](const RedisException &e) {
-                LOG_ERROR << e.what();
-                this->setException(std::make_exception_ptr(e));
-                handle.resume();
-            });
+        auto done = armDeadline(handle, []() {
+            return std::make_exception_ptr(
+                RedisException(RedisErrorCode::kTimeout,
+                               "The deadline of the request is exceeded"));
+        });
+        if (!done)
+            return false;
+        {
+            // The command is a child span of the trace of the coroutine
+            drogon::internal::TraceScope traceScope(
+                drogon::internal::traceContextOf(handle));
+            function_(
+                [handle, this, done](const RedisResult &result) {
+                    if (!complete(done))
+                        return;
+                    this->setValue(result);
+                    this->resumeIfSuspended(handle);
+                },
+                [handle, this, done](const RedisException &e) {
+                    if (!complete(done))
+                        return;
+                    LOG_ERROR << e.what();
+                    this->setException(std::make_exception_ptr(e));
+                    this->resumeIfSuspended(handle);
+                });
+        }
+        // A near cache hit completes in the call
+        return this->suspendUnlessCompleted();
     }
 
   private:
@@ -82,6 +107,20 @@ struct [[nodiscard]] RedisTransactionAwaiter
 
 class RedisTransaction;
 
+/// The state of the connections of a client, see RedisClient::poolStatus()
+struct RedisPoolStatus
+{
+    /// The connections established or being established
+    size_t connections{0};
+    /// The connections the commands are pipelined on, the others are being
+    /// established or run a transaction
+    size_t ready{0};
+    /// The commands and transactions waiting for a connection
+    size_t queued{0};
+    /// The commands sent and waiting for their reply
+    size_t unanswered{0};
+};
+
 /**
  * @brief This class represents a redis client that contains several connections
  * to a redis server.
@@ -105,6 +144,63 @@ class DROGON_EXPORT RedisClient
         const std::string &password = "",
         unsigned int db = 0,
         const std::string &username = "");
+
+    /**
+     * @brief Create a client of a Redis Cluster.
+     *
+     * Every command is sent to the primary node serving the hash slot of its
+     * key (the first key for commands with several keys, which must all hash
+     * to the same slot), through a pool of connections per node. The slot map
+     * is loaded from the seed nodes by CLUSTER SLOTS and refreshed every 10
+     * seconds, MOVED and ASK redirections are followed transparently.
+     * Commands without a key are sent to any node.
+     *
+     * A transaction is bound to the slot of its first command with a key,
+     * commands with keys of other slots fail with a CROSSSLOT error.
+     *
+     * @param seedNodes Some nodes of the cluster, the others are discovered.
+     * @param connectionsPerNode The number of connections to every node.
+     * @param password The password to authenticate if necessary.
+     * @param username The username to authenticate if necessary.
+     * @note The cluster nodes must be announced by IP addresses.
+     */
+    static std::shared_ptr<RedisClient> newRedisClusterClient(
+        const std::vector<trantor::InetAddress> &seedNodes,
+        size_t connectionsPerNode = 1,
+        const std::string &password = "",
+        const std::string &username = "");
+
+    /**
+     * @brief Create a client of a Redis replication group monitored by
+     * Sentinels.
+     *
+     * The primary is asked to the Sentinels at startup, every 5 seconds and
+     * when they announce a failover, so the writes follow the promotions.
+     * With readFromReplicas, the read-only commands (GET, HGETALL, ZRANGE,
+     * EVAL_RO...) are sent to the healthy replica with the fewest commands
+     * waiting, and to the primary when no replica is connected. Pipelines,
+     * transactions, scripts and subscriptions always use the primary.
+     *
+     * @param sentinels Some Sentinels of the group, asked in turn.
+     * @param masterName The name of the group known by the Sentinels.
+     * @param connectionsPerNode The number of connections to every node.
+     * @param readFromReplicas Send the reads to the replicas.
+     * @param password The password to authenticate to the nodes if
+     * necessary.
+     * @param db The database of the nodes.
+     * @param username The username to authenticate if necessary.
+     * @note A replica may lag behind the primary, so a read sent to it right
+     * after a write may not see the write.
+     */
+    static std::shared_ptr<RedisClient> newRedisSentinelClient(
+        const std::vector<trantor::InetAddress> &sentinels,
+        const std::string &masterName,
+        size_t connectionsPerNode = 1,
+        bool readFromReplicas = false,
+        const std::string &password = "",
+        unsigned int db = 0,
+        const std::string &username = "");
+
     /**
      * @brief Execute a redis command
      *
@@ -130,6 +226,49 @@ class DROGON_EXPORT RedisClient
                                   std::string_view command,
                                   ...) noexcept = 0;
 
+    /**
+     * @brief Execute a command already formatted in the RESP format, e.g. by
+     * formatRedisCommand() or appendRedisCommand().
+     */
+    virtual void execFormattedCommandAsync(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback) noexcept
+    {
+        (void)command;
+        (void)resultCallback;
+        exceptionCallback(
+            RedisException(RedisErrorCode::kInternalError,
+                           "This redis client doesn't support formatted "
+                           "commands"));
+    }
+
+    /**
+     * @brief Execute a redis command of binary safe arguments asynchronously.
+     *
+     * Unlike execCommandAsync(), there is no format string to parse: the
+     * arguments (strings, numbers, pairs or ranges of them) are written
+     * directly as RESP bulk strings by formatRedisCommand(), so they can
+     * contain spaces or null bytes.
+     * For example:
+     * @code
+       redisClientPtr->execArgsAsync([](const RedisResult &r){
+           ...
+       },[](const RedisException &err){
+           ...
+       }, "XACK", stream, group, ids);
+       @endcode
+     */
+    template <typename... Arguments>
+    void execArgsAsync(RedisResultCallback &&resultCallback,
+                       RedisExceptionCallback &&exceptionCallback,
+                       const Arguments &...args)
+    {
+        execFormattedCommandAsync(formatRedisCommand(args...),
+                                  std::move(resultCallback),
+                                  std::move(exceptionCallback));
+    }
+
     /**
      * @brief Execute a redis command synchronously
      *
@@ -200,6 +339,52 @@ class DROGON_EXPORT RedisClient
         return prom.get_future().get();
     }
 
+    /**
+     * @brief Register a Lua script run by execScriptAsync() with its name.
+     *
+     * The script is run by EVALSHA with its SHA1 digest, so its source is
+     * only sent once per server. It's loaded on the current connections and
+     * on every new connection, and a NOSCRIPT error (e.g. after SCRIPT FLUSH
+     * or a failover) is retried transparently by EVAL with the source.
+     * Registering a name again replaces its script.
+     */
+    virtual void registerScript(const std::string & /*name*/,
+                                const std::string & /*source*/)
+    {
+        LOG_ERROR << "This redis client doesn't support registered scripts";
+    }
+
+    /**
+     * @brief Run a script registered by registerScript() asynchronously.
+     *
+     * @param name The name of the script.
+     * @param arguments The number of keys, the keys and the arguments of the
+     * script, which can contain placeholders like the command of
+     * execCommandAsync().
+     * For example:
+     * @code
+       redisClientPtr->registerScript("incrby_capped", source);
+       redisClientPtr->execScriptAsync([](const RedisResult &r){
+           ...
+       },[](const RedisException &err){
+           ...
+       }, "incrby_capped", "1 %s %d %d", key.data(), step, cap);
+       @endcode
+     */
+    virtual void execScriptAsync(RedisResultCallback &&resultCallback,
+                                 RedisExceptionCallback &&exceptionCallback,
+                                 const std::string &name,
+                                 std::string_view arguments,
+                                 ...) noexcept
+    {
+        (void)resultCallback;
+        (void)name;
+        (void)arguments;
+        exceptionCallback(
+            RedisException(RedisErrorCode::kInternalError,
+                           "This redis client doesn't support scripts"));
+    }
+
     /**
      * @brief Create a subscriber for redis subscribe commands.
      *
@@ -209,6 +394,102 @@ class DROGON_EXPORT RedisClient
      */
     virtual std::shared_ptr<RedisSubscriber> newSubscriber() noexcept = 0;
 
+    /**
+     * @brief Create a subscriber sharing one connection with the other
+     * shared subscribers of the client.
+     *
+     * Every channel is subscribed once on the shared connection, whose
+     * messages are demultiplexed locally: a message is received once and
+     * queued once to every event loop having callbacks for it. A callback is
+     * called in the event loop of the thread which called subscribe() (e.g.
+     * the IO loop of a websocket connection), or in the loop of the shared
+     * connection if that thread has no event loop.
+     *
+     * @note Prefer it to newSubscriber() when many objects subscribe, the
+     * default implementation falls back to newSubscriber().
+     */
+    virtual std::shared_ptr<RedisSubscriber> newSharedSubscriber() noexcept
+    {
+        return newSubscriber();
+    }
+
+    /**
+     * @brief Create a pipeline sending a batch of commands in one write.
+     *
+     * @return std::shared_ptr<RedisPipeline>, or nullptr if the client
+     * doesn't support pipelines (e.g. transactions).
+     * @note The commands queued on a connection before its event loop runs
+     * are always coalesced into one write, a pipeline also keeps its
+     * commands on one connection and returns their replies together.
+     */
+    virtual std::shared_ptr<RedisPipeline> newPipeline() noexcept
+    {
+        LOG_ERROR << "This redis client doesn't support pipelines";
+        return nullptr;
+    }
+
+    /**
+     * @brief Create a consumer of a stream consumer group, see
+     * RedisStreamConsumer.
+     *
+     * @param config The stream, the group, the consumer name and the
+     * batching options.
+     * @param batchCallback Called with every batch of messages.
+     * @param loop The event loop of the callback, the loop of the dedicated
+     * connection of the consumer if it's nullptr.
+     * @return std::shared_ptr<RedisStreamConsumer>, or nullptr if the client
+     * doesn't support stream consumers. The consumer stops when it's
+     * destroyed.
+     */
+    virtual std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig & /*config*/,
+        RedisStreamBatchCallback && /*batchCallback*/,
+        trantor::EventLoop * /*loop*/ = nullptr)
+    {
+        LOG_ERROR << "This redis client doesn't support stream consumers";
+        return nullptr;
+    }
+
+    /**
+     * @brief Create a scanner iterating the keys with SCAN, or the elements
+     * of a key with HSCAN, SSCAN or ZSCAN, see RedisScanner.
+     *
+     * @return std::shared_ptr<RedisScanner>, or nullptr if the client
+     * doesn't support scanners (e.g. transactions, or SCAN on a cluster,
+     * whose keys are spread over the nodes).
+     */
+    virtual std::shared_ptr<RedisScanner> newScanner(
+        const RedisScanOptions & /*options*/)
+    {
+        LOG_ERROR << "This redis client doesn't support scanners";
+        return nullptr;
+    }
+
+    /**
+     * @brief Enable a near cache serving the replies of GET and HGETALL from
+     * the memory of the process.
+     *
+     * The cache is kept coherent by client tracking in broadcasting mode
+     * (Redis 6.0 or later): a dedicated connection subscribes to the
+     * invalidation messages of the keys starting with the prefixes, the
+     * cached replies are dropped when their keys are modified by any client.
+     * Cached replies are only served while that connection is subscribed,
+     * and the callbacks of the hits are called in the calling thread.
+     *
+     * @param keyPrefixes The prefixes of the cached keys, all the keys are
+     * cached if it's empty. Keep them specific, the server sends the
+     * invalidations of all the modified keys starting with them.
+     * @param maxBytes The memory budget of the cached replies, the least
+     * recently used ones are dropped beyond it.
+     * @note Call it once, before sending commands.
+     */
+    virtual void enableNearCache(
+        const std::vector<std::string> & /*keyPrefixes*/,
+        size_t /*maxBytes*/ = 64 * 1024 * 1024)
+    {
+        LOG_ERROR << "This redis client doesn't support the near cache";
+    }
+
     /**
      * @brief Create a redis transaction object.
      *
@@ -249,6 +530,15 @@ class DROGON_EXPORT RedisClient
      * */
     virtual void closeAll() = 0;
 
+    /**
+     * @brief Get the state of the connections, for the diagnosis. The
+     * clients which have no pool return zeros.
+     */
+    virtual RedisPoolStatus poolStatus() const noexcept
+    {
+        return {};
+    }
+
 #ifdef __cpp_impl_coroutine
     /**
      * @brief Send a Redis command and await the RedisResult in a coroutine.
@@ -0,0 +1,209 @@
+/**
+ *
+ *  @file RedisCommandFormat.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <charconv>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace drogon
+{
+namespace nosql
+{
+namespace internal
+{
+/// A number printed in a local buffer
+class RedisNumberArgument
+{
+  public:
+    template <typename T,
+              std::enable_if_t<std::is_integral_v<T>, std::nullptr_t> = nullptr>
+    explicit RedisNumberArgument(T value) noexcept
+    {
+        auto res = std::to_chars(data_, data_ + sizeof(data_), value);
+        size_ = static_cast<size_t>(res.ptr - data_);
+    }
+
+    explicit RedisNumberArgument(double value) noexcept
+    {
+        auto len = snprintf(data_, sizeof(data_), "%.17g", value);
+        size_ = len > 0 ? static_cast<size_t>(len) : 0;
+    }
+
+    std::string_view view() const noexcept
+    {
+        return {data_, size_};
+    }
+
+  private:
+    char data_[32];
+    size_t size_{0};
+};
+
+template <typename T>
+constexpr bool isRedisString =
+    std::is_convertible_v<const T &, std::string_view>;
+
+template <typename T, typename = void>
+struct IsRedisRange : std::false_type
+{
+};
+
+template <typename T>
+struct IsRedisRange<T,
+                    std::void_t<decltype(std::begin(std::declval<const T &>())),
+                                decltype(std::end(std::declval<const T &>()))>>
+    : std::bool_constant<!isRedisString<T>>
+{
+};
+
+template <typename T>
+struct IsRedisPair : std::false_type
+{
+};
+
+template <typename A, typename B>
+struct IsRedisPair<std::pair<A, B>> : std::true_type
+{
+};
+
+inline size_t redisDigits(size_t n) noexcept
+{
+    size_t digits = 1;
+    while (n >= 10)
+    {
+        n /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+inline void appendRedisLength(std::string &buffer, char prefix, size_t n)
+{
+    char tmp[24];
+    tmp[0] = prefix;
+    auto res = std::to_chars(tmp + 1, tmp + sizeof(tmp) - 2, n);
+    res.ptr[0] = '\r';
+    res.ptr[1] = '\n';
+    buffer.append(tmp, res.ptr + 2);
+}
+
+template <typename T>
+void measureRedisArgument(const T &arg, size_t &count, size_t &bytes)
+{
+    if constexpr (IsRedisRange<T>::value)
+    {
+        for (auto &item : arg)
+        {
+            measureRedisArgument(item, count, bytes);
+        }
+    }
+    else if constexpr (IsRedisPair<T>::value)
+    {
+        measureRedisArgument(arg.first, count, bytes);
+        measureRedisArgument(arg.second, count, bytes);
+    }
+    else
+    {
+        size_t size;
+        if constexpr (isRedisString<T>)
+        {
+            size = std::string_view(arg).size();
+        }
+        else
+        {
+            static_assert(std::is_arithmetic_v<T>,
+                          "A redis argument must be a string, a number, a "
+                          "pair or a range of them");
+            size = RedisNumberArgument(arg).view().size();
+        }
+        ++count;
+        // $<size>\r\n<data>\r\n
+        bytes += redisDigits(size) + size + 5;
+    }
+}
+
+template <typename T>
+void appendRedisArgument(std::string &buffer, const T &arg)
+{
+    if constexpr (IsRedisRange<T>::value)
+    {
+        for (auto &item : arg)
+        {
+            appendRedisArgument(buffer, item);
+        }
+    }
+    else if constexpr (IsRedisPair<T>::value)
+    {
+        appendRedisArgument(buffer, arg.first);
+        appendRedisArgument(buffer, arg.second);
+    }
+    else if constexpr (isRedisString<T>)
+    {
+        std::string_view view(arg);
+        appendRedisLength(buffer, '$', view.size());
+        buffer.append(view.data(), view.size()).append("\r\n", 2);
+    }
+    else
+    {
+        RedisNumberArgument number(arg);
+        auto view = number.view();
+        appendRedisLength(buffer, '$', view.size());
+        buffer.append(view.data(), view.size()).append("\r\n", 2);
+    }
+}
+}  // namespace internal
+
+/**
+ * @brief Append a command to a buffer in the RESP format, without parsing a
+ * format string.
+ *
+ * Every argument is sent as a binary safe bulk string. An argument can be
+ * anything convertible to std::string_view, an integer, a floating-point
+ * number, a std::pair (two arguments) or a range of them, e.g. a
+ * std::vector<std::string_view> of ids or a std::map of fields. The size of
+ * the command is computed first so the buffer grows at most once, and the
+ * same buffer can be reused for many commands.
+ * For example:
+ * @code
+   std::string buffer;
+   appendRedisCommand(buffer, "HSET", key, fieldsMap);
+   appendRedisCommand(buffer, "EXPIRE", key, 60);
+   @endcode
+ */
+template <typename... Arguments>
+void appendRedisCommand(std::string &buffer, const Arguments &...args)
+{
+    size_t count = 0;
+    size_t bytes = 0;
+    (internal::measureRedisArgument(args, count, bytes), ...);
+    buffer.reserve(buffer.size() + bytes + internal::redisDigits(count) + 3);
+    internal::appendRedisLength(buffer, '*', count);
+    (internal::appendRedisArgument(buffer, args), ...);
+}
+
+/// Format a command like appendRedisCommand() into a new string
+template <typename... Arguments>
+std::string formatRedisCommand(const Arguments &...args)
+{
+    std::string command;
+    appendRedisCommand(command, args...);
+    return command;
+}
+
+}  // namespace nosql
+}  // namespace drogon
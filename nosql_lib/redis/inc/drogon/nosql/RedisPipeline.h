@@ -0,0 +1,94 @@
+/**
+ *
+ *  @file RedisPipeline.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/nosql/RedisCommandFormat.h>
+#include <drogon/nosql/RedisException.h>
+#include <drogon/nosql/RedisResult.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+using RedisPipelineCallback =
+    std::function<void(const std::vector<RedisResult> &)>;
+
+/**
+ * @brief A batch of commands sent in one write, whose replies are returned
+ * together. The commands are not atomic, use a transaction for that.
+ *
+ * For example:
+ * @code
+   auto pipeline = redisClientPtr->newPipeline();
+   for (auto &key : keys)
+       pipeline->add("get %s", key.c_str());
+   pipeline->execute([](const std::vector<RedisResult> &results) {
+       ...
+   }, [](const RedisException &err) {
+       ...
+   });
+   @endcode
+ */
+class DROGON_EXPORT RedisPipeline
+{
+  public:
+    virtual ~RedisPipeline() = default;
+
+    /**
+     * @brief Append a command, formatted like
+     * RedisClient::execCommandAsync() does.
+     *
+     * @throw RedisException if the command can't be formatted.
+     */
+    RedisPipeline &add(std::string_view command, ...) noexcept(false);
+
+    /**
+     * @brief Append a command of binary safe arguments, formatted by
+     * formatRedisCommand() without a format string.
+     */
+    template <typename... Arguments>
+    RedisPipeline &addArgs(const Arguments &...args)
+    {
+        commands_.emplace_back(formatRedisCommand(args...));
+        return *this;
+    }
+
+    /// The number of commands added since the last execution
+    size_t size() const noexcept
+    {
+        return commands_.size();
+    }
+
+    /**
+     * @brief Send the added commands and clear them.
+     *
+     * @param resultCallback Called with the replies in the order of the
+     * commands once they all arrived. A command rejected by the server gets a
+     * result of the kError type, the others are not affected.
+     * @param exceptionCallback Called instead if a connection is broken or
+     * the timeout of the client expires.
+     */
+    virtual void execute(RedisPipelineCallback &&resultCallback,
+                         RedisExceptionCallback &&exceptionCallback) = 0;
+
+  protected:
+    std::vector<std::string> commands_;
+};
+
+}  // namespace nosql
+}  // namespace drogon
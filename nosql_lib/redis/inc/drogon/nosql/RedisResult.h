@@ -15,10 +15,19 @@
 #pragma once
 
 #include <drogon/exports.h>
+#include <drogon/nosql/RedisException.h>
+#include <json/value.h>
+#include <charconv>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <map>
 #include <memory>
 #include <functional>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 struct redisReply;
 
@@ -33,9 +42,39 @@ enum class RedisResultType
     kArray,
     kStatus,
     kNil,
-    kError
+    kError,
+    // RESP3 types, only obtained from connections speaking RESP3
+    kDouble,
+    kBool,
+    kMap,
+    kSet,
+    kAttribute,
+    kPush,
+    kBigNumber,
+    kVerbatim
 };
 
+class RedisResult;
+
+/**
+ * @brief Converts a result to T for RedisResult::as<T>(), specialize it to
+ * decode a reply straight into a user struct:
+ * @code
+   template <>
+   struct drogon::nosql::RedisDecoder<User>
+   {
+       static User decode(const RedisResult &result)
+       {
+           auto fields = result.as<std::unordered_map<std::string_view,
+                                                      std::string_view>>();
+           return User{std::string(fields["name"]), ...};
+       }
+   };
+   @endcode
+ */
+template <typename T, typename Enable = void>
+struct RedisDecoder;
+
 /**
  * @brief This class represents a redis reply with no error.
  * @note Limited by the hiredis library, the RedisResult object is only
@@ -54,7 +93,8 @@ class DROGON_EXPORT RedisResult
     /**
      * @brief Return the type of the result_
      * @return RedisResultType
-     * @note The kError type is never obtained here.
+     * @note The kError type is only obtained in the results of a
+     * RedisPipeline.
      */
     RedisResultType type() const noexcept;
 
@@ -67,6 +107,14 @@ class DROGON_EXPORT RedisResult
      */
     std::string asString() const noexcept(false);
 
+    /**
+     * @brief Get the string value of the result without copying it.
+     *
+     * @note The view points into the reply, it is only valid in the context
+     * of the result callback like the result itself.
+     */
+    std::string_view asStringView() const noexcept(false);
+
     /**
      * @brief Get the array value of the result.
      *
@@ -85,6 +133,51 @@ class DROGON_EXPORT RedisResult
      */
     long long asInteger() const noexcept(false);
 
+    /**
+     * @brief Get the double value of a kDouble result, or parse the value of
+     * a kString or kInteger result.
+     */
+    double asDouble() const noexcept(false);
+
+    /**
+     * @brief Get the value of a kBool result, or of a kInteger one (1 or 0).
+     */
+    bool asBool() const noexcept(false);
+
+    /**
+     * @brief Get the key-value pairs of a kMap or kAttribute result, or of a
+     * flat kArray result such as the RESP2 reply of HGETALL.
+     *
+     * @note The array must have an even number of elements, otherwise a
+     * runtime exception is thrown.
+     */
+    std::vector<std::pair<RedisResult, RedisResult>> asMap() const
+        noexcept(false);
+
+    /**
+     * @brief Convert the result to JSON: strings, numbers, booleans and
+     * null, arrays for kArray, kSet and kPush results, objects for kMap and
+     * kAttribute results (with the keys converted to strings).
+     */
+    Json::Value asJson() const noexcept(false);
+
+    /**
+     * @brief Decode the result into T without intermediate strings.
+     *
+     * Supported out of the box: std::string, std::string_view, the
+     * arithmetic types, bool, Json::Value, std::optional<T> (empty for nil),
+     * std::vector<T>, and std::map<K, V> or std::unordered_map<K, V> from
+     * the results accepted by asMap(). Other types are decoded by a
+     * specialization of RedisDecoder<T>.
+     * @note std::string_view values are only valid in the context of the
+     * result callback.
+     */
+    template <typename T>
+    T as() const noexcept(false)
+    {
+        return RedisDecoder<T>::decode(*this);
+    }
+
     /**
      * @brief Get the string for displaying the result.
      *
@@ -121,9 +214,133 @@ class DROGON_EXPORT RedisResult
     }
 
   private:
+    friend struct RedisReplyCopy;
     redisReply *result_;
 };
 
+template <>
+struct RedisDecoder<std::string>
+{
+    static std::string decode(const RedisResult &result)
+    {
+        return result.asString();
+    }
+};
+
+template <>
+struct RedisDecoder<std::string_view>
+{
+    static std::string_view decode(const RedisResult &result)
+    {
+        return result.asStringView();
+    }
+};
+
+template <>
+struct RedisDecoder<bool>
+{
+    static bool decode(const RedisResult &result)
+    {
+        return result.asBool();
+    }
+};
+
+template <typename T>
+struct RedisDecoder<
+    T,
+    std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+{
+    static T decode(const RedisResult &result)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return static_cast<T>(result.asDouble());
+        }
+        else
+        {
+            if (result.type() != RedisResultType::kString)
+                return static_cast<T>(result.asInteger());
+            // Numbers are usually stored as strings
+            auto str = result.asStringView();
+            T value{};
+            auto [ptr, ec] =
+                std::from_chars(str.data(), str.data() + str.size(), value);
+            if (ec != std::errc() || ptr != str.data() + str.size())
+                throw RedisException(RedisErrorCode::kBadType, "bad type");
+            return value;
+        }
+    }
+};
+
+template <>
+struct RedisDecoder<Json::Value>
+{
+    static Json::Value decode(const RedisResult &result)
+    {
+        return result.asJson();
+    }
+};
+
+template <typename T>
+struct RedisDecoder<std::optional<T>>
+{
+    static std::optional<T> decode(const RedisResult &result)
+    {
+        if (result.isNil())
+            return std::nullopt;
+        return RedisDecoder<T>::decode(result);
+    }
+};
+
+template <typename T>
+struct RedisDecoder<std::vector<T>>
+{
+    static std::vector<T> decode(const RedisResult &result)
+    {
+        std::vector<T> values;
+        auto elements = result.asArray();
+        values.reserve(elements.size());
+        for (auto &element : elements)
+        {
+            values.emplace_back(RedisDecoder<T>::decode(element));
+        }
+        return values;
+    }
+};
+
+namespace internal
+{
+template <typename Map>
+Map decodeRedisMap(const RedisResult &result)
+{
+    Map values;
+    for (auto &[key, value] : result.asMap())
+    {
+        values.emplace(RedisDecoder<typename Map::key_type>::decode(key),
+                       RedisDecoder<typename Map::mapped_type>::decode(value));
+    }
+    return values;
+}
+}  // namespace internal
+
+template <typename K, typename V>
+struct RedisDecoder<std::map<K, V>>
+{
+    static std::map<K, V> decode(const RedisResult &result)
+    {
+        return internal::decodeRedisMap<std::map<K, V>>(result);
+    }
+};
+
+template <typename K, typename V>
+struct RedisDecoder<std::unordered_map<K, V>>
+{
+    static std::unordered_map<K, V> decode(const RedisResult &result)
+    {
+        return internal::decodeRedisMap<std::unordered_map<K, V>>(result);
+    }
+};
+
 using RedisResultCallback = std::function<void(const RedisResult &)>;
 using RedisMessageCallback =
     std::function<void(const std::string &channel, const std::string &message)>;
@@ -0,0 +1,153 @@
+/**
+ *
+ *  @file RedisScanner.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/nosql/RedisException.h>
+#include <drogon/nosql/RedisResult.h>
+#include <functional>
+#include <string>
+#include <vector>
+#ifdef __cpp_impl_coroutine
+#include <drogon/utils/coroutine.h>
+#endif
+
+namespace drogon
+{
+namespace nosql
+{
+/// The options of a scan, see RedisClient::newScanner()
+struct RedisScanOptions
+{
+    /// SCAN, HSCAN, SSCAN or ZSCAN
+    std::string command{"SCAN"};
+    /// The key of the hash, set or sorted set, empty for SCAN
+    std::string key;
+    /// The glob pattern of MATCH, empty for all the elements
+    std::string match;
+    /// The COUNT hint, the number of elements the server visits per page
+    size_t count{1000};
+    /// The type of the keys of SCAN (Redis 6.0 or later), empty for all
+    std::string type;
+};
+
+/**
+ * @brief The callback of a page of a scan, the keys of SCAN, the members of
+ * SSCAN, the fields and values of HSCAN or the members and scores of ZSCAN,
+ * one after the other. The last page may be empty.
+ */
+using RedisScanPageCallback =
+    std::function<void(std::vector<std::string> &&page, bool last)>;
+
+class RedisScanner;
+
+#ifdef __cpp_impl_coroutine
+namespace internal
+{
+struct [[nodiscard]] RedisScanAwaiter
+    : public CallbackAwaiter<std::vector<std::string>>
+{
+    explicit RedisScanAwaiter(RedisScanner *scanner) : scanner_(scanner)
+    {
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle);
+
+  private:
+    RedisScanner *scanner_;
+};
+}  // namespace internal
+#endif
+
+/**
+ * @brief Iterates the keyspace, a hash, a set or a sorted set with the
+ * cursor of a SCAN command.
+ *
+ * The next page is requested as soon as a page is handed to the consumer,
+ * so the round trip of a page overlaps the processing of the previous one,
+ * and at most one page is read ahead. The empty pages the server returns
+ * for a sparse MATCH are skipped.
+ *
+ * @code
+   auto scanner = redisClient->newScanner({"SCAN", "", "session:*", 1000});
+   while (!scanner->done())
+   {
+       auto keys = co_await scanner->nextCoro();
+       ...
+   }
+   @endcode
+ *
+ * @note The guarantees of SCAN hold: an element present during the whole
+ * scan is returned, maybe more than once, the elements added or removed
+ * during the scan may or may not be.
+ */
+class DROGON_EXPORT RedisScanner
+{
+  public:
+    virtual ~RedisScanner() = default;
+
+    /**
+     * @brief Get the next page.
+     *
+     * The callbacks are called in the thread of the reply, or in the
+     * calling thread when the page was read ahead. After the last page,
+     * the callback is called with an empty last page. After an error, the
+     * exception callback is called with the same error.
+     */
+    virtual void nextAsync(RedisScanPageCallback &&pageCallback,
+                           RedisExceptionCallback &&exceptionCallback) = 0;
+
+    /**
+     * @brief Pass all the pages to a callback.
+     *
+     * @param pageCallback Called with every non-empty page, the scan stops
+     * if it returns false.
+     * @param doneCallback Called once the last page is passed.
+     */
+    virtual void forEachAsync(
+        std::function<bool(std::vector<std::string> &&)> &&pageCallback,
+        std::function<void()> &&doneCallback,
+        RedisExceptionCallback &&exceptionCallback) = 0;
+
+    /// True once the last page is passed to the consumer
+    virtual bool done() const = 0;
+
+#ifdef __cpp_impl_coroutine
+    /// Await the next page, see nextAsync()
+    internal::RedisScanAwaiter nextCoro()
+    {
+        return internal::RedisScanAwaiter(this);
+    }
+#endif
+};
+
+#ifdef __cpp_impl_coroutine
+// A page read ahead completes the call
+inline bool internal::RedisScanAwaiter::await_suspend(
+    std::coroutine_handle<> handle)
+{
+    scanner_->nextAsync(
+        [handle, this](std::vector<std::string> &&page, bool) {
+            setValue(std::move(page));
+            resumeIfSuspended(handle);
+        },
+        [handle, this](const RedisException &e) {
+            setException(std::make_exception_ptr(e));
+            resumeIfSuspended(handle);
+        });
+    return suspendUnlessCompleted();
+}
+#endif
+
+}  // namespace nosql
+}  // namespace drogon
@@ -0,0 +1,118 @@
+/**
+ *
+ *  @file RedisStreamConsumer.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace trantor
+{
+class EventLoop;
+}
+
+namespace drogon
+{
+namespace nosql
+{
+/// An entry of a stream
+struct RedisStreamMessage
+{
+    std::string id_;
+    std::vector<std::pair<std::string, std::string>> fields_;
+};
+
+using RedisStreamBatchCallback =
+    std::function<void(const std::vector<RedisStreamMessage> &)>;
+
+/// The options of a consumer of a stream consumer group
+struct RedisStreamConsumerConfig
+{
+    std::string stream;
+    std::string group;
+    std::string consumer;
+    /// The maximum number of messages read at once
+    size_t batchSize{256};
+    /// How long XREADGROUP blocks waiting for new messages, in milliseconds
+    size_t blockMs{5000};
+    /**
+     * The id the group starts from if it's created by the consumer ("$" for
+     * the new messages), the group and the stream are created if they don't
+     * exist. An empty id disables the creation.
+     */
+    std::string createGroupFrom{"$"};
+    /// Acknowledge the messages of a batch once its callback returns
+    bool autoAck{true};
+    /// The number of acknowledgements sent in one XACK
+    size_t ackBatchSize{512};
+    /// The longest delay of an acknowledgement before it's sent, in seconds
+    double ackInterval{0.01};
+    /**
+     * The messages pending for longer than this (in milliseconds) in other
+     * consumers of the group are claimed by XAUTOCLAIM, 0 disables it.
+     */
+    size_t claimMinIdleMs{60000};
+    /// The period of XAUTOCLAIM, in seconds
+    double claimInterval{30.0};
+    /**
+     * The number of batches delivered but whose callbacks didn't return yet
+     * beyond which the reading pauses.
+     */
+    size_t maxPendingBatches{4};
+};
+
+/**
+ * @brief Reads a stream as a member of a consumer group.
+ *
+ * A dedicated connection runs the blocking XREADGROUP commands, the messages
+ * are delivered in batches to the callback in the chosen event loop, the
+ * acknowledgements are batched into XACK commands sent through the pool of
+ * the client. The messages left pending by the failed consumers are claimed
+ * periodically by XAUTOCLAIM (Redis 6.2 or later) and delivered like the
+ * others.
+ *
+ * For example:
+ * @code
+   RedisStreamConsumerConfig config;
+   config.stream = "jobs";
+   config.group = "workers";
+   config.consumer = "worker-1";
+   auto consumer = redisClientPtr->newStreamConsumer(
+       config, [](const std::vector<RedisStreamMessage> &messages) {
+           for (auto &message : messages)
+               ...
+       });
+   @endcode
+ * @note A message is only acknowledged if the callback of its batch returns
+ * normally (with autoAck) or after ack() is called with its id, so that the
+ * messages of a failed batch are claimed again later.
+ */
+class DROGON_EXPORT RedisStreamConsumer
+{
+  public:
+    virtual ~RedisStreamConsumer() = default;
+
+    /**
+     * @brief Acknowledge a message, it's sent with the other ones within
+     * the ack interval of the config.
+     */
+    virtual void ack(const std::string &id) = 0;
+
+    /// Stop reading, the pending acknowledgements are sent
+    virtual void stop() = 0;
+};
+
+}  // namespace nosql
+}  // namespace drogon
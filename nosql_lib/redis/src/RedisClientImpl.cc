@@ -14,12 +14,24 @@
 
 #include "RedisConnection.h"
 #include "RedisClientImpl.h"
+#include "RedisPipelineImpl.h"
+#include "RedisScannerImpl.h"
 #include "RedisSubscriberImpl.h"
 #include "RedisTransactionImpl.h"
+#include "../../lib/src/BuiltinMetrics.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
 
 using namespace drogon::nosql;
 
+static void observeWait(const trantor::Date &bufferedDate)
+{
+    auto wait = trantor::Date::now().microSecondsSinceEpoch() -
+                bufferedDate.microSecondsSinceEpoch();
+    drogon::BuiltinMetrics::instance().poolWaited(
+        drogon::BuiltinMetrics::Pool::kRedis,
+        static_cast<double>(wait) / 1000000);
+}
+
 std::shared_ptr<RedisClient> RedisClient::newRedisClient(
     const trantor::InetAddress &serverAddress,
     size_t connectionNumber,
@@ -72,6 +84,18 @@ RedisConnectionPtr RedisClientImpl::newConnection(trantor::EventLoop *loop)
         auto thisPtr = thisWeakPtr.lock();
         if (thisPtr)
         {
+            // The server may have restarted or failed over since the scripts
+            // were loaded, they are loaded before the first command.
+            for (auto &script : thisPtr->scripts_.scripts())
+            {
+                conn->sendFormattedCommand(
+                    RedisScriptRegistry::loadCommand(script.second),
+                    [](const RedisResult &) {},
+                    [name = script.first](const RedisException &err) {
+                        LOG_ERROR << "Failed to load the script " << name
+                                  << ": " << err.what();
+                    });
+            }
             {
                 std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
                 thisPtr->readyConnections_.push_back(conn);
@@ -114,19 +138,59 @@ RedisConnectionPtr RedisClientImpl::newConnection(trantor::EventLoop *loop)
     return conn;
 }
 
+// CLIENT ID, then CLIENT TRACKING redirected to that id, then SUBSCRIBE.
+// The invalidations are only published once the channel is subscribed.
+static void startTracking(const RedisConnectionPtr &conn,
+                          const std::shared_ptr<RedisSubscriberImpl> &subPtr,
+                          const std::shared_ptr<RedisNearCache> &nearCache)
+{
+    std::weak_ptr<RedisConnection> weakConn(conn);
+    conn->sendCommand(
+        [weakConn, subPtr, nearCache](const RedisResult &result) {
+            auto conn = weakConn.lock();
+            if (!conn)
+                return;
+            conn->sendFormattedCommand(
+                nearCache->trackingCommand(result.asInteger()),
+                [weakConn, subPtr](const RedisResult &) {
+                    auto conn = weakConn.lock();
+                    if (!conn)
+                        return;
+                    subPtr->setConnection(conn);
+                    subPtr->subscribeAll();
+                },
+                [](const RedisException &err) {
+                    LOG_ERROR << "Failed to enable client tracking, the near "
+                                 "cache is disabled: "
+                              << err.what();
+                });
+        },
+        [](const RedisException &err) {
+            LOG_ERROR << "Failed to get the client id: " << err.what();
+        },
+        "CLIENT ID");
+}
+
 RedisConnectionPtr RedisClientImpl::newSubscribeConnection(
     trantor::EventLoop *loop,
-    const std::shared_ptr<RedisSubscriberImpl> &subscriber)
+    const std::shared_ptr<RedisSubscriberImpl> &subscriber,
+    const std::shared_ptr<RedisNearCache> &nearCache)
 {
     auto conn = std::make_shared<RedisConnection>(
         serverAddr_, username_, password_, db_, loop);
     std::weak_ptr<RedisClientImpl> weakThis = shared_from_this();
     std::weak_ptr<RedisSubscriberImpl> weakSub(subscriber);
-    conn->setConnectCallback([weakThis, weakSub](RedisConnectionPtr &&conn) {
+    conn->setConnectCallback([weakThis, weakSub, nearCache](
+                                 RedisConnectionPtr &&conn) {
         auto thisPtr = weakThis.lock();
         if (!thisPtr)
             return;
         auto subPtr = weakSub.lock();
+        if (subPtr && nearCache)
+        {
+            startTracking(conn, subPtr, nearCache);
+            return;
+        }
 
         std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
         if (subPtr)
@@ -139,8 +203,14 @@ RedisConnectionPtr RedisClientImpl::newSubscribeConnection(
             thisPtr->connections_.erase(conn);
         }
     });
-    conn->setDisconnectCallback([weakThis, weakSub](RedisConnectionPtr &&conn) {
+    conn->setDisconnectCallback([weakThis, weakSub, nearCache](
+                                    RedisConnectionPtr &&conn) {
         // assert(status == REDIS_CONNECTED);
+        if (nearCache)
+        {
+            // The invalidations are lost until the tracking is restored
+            nearCache->setActive(false);
+        }
         auto thisPtr = weakThis.lock();
         if (!thisPtr)
             return;
@@ -153,10 +223,10 @@ RedisConnectionPtr RedisClientImpl::newSubscribeConnection(
 
         auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
         assert(loop);
-        loop->runAfter(2.0, [thisPtr, loop, subPtr]() {
+        loop->runAfter(2.0, [thisPtr, loop, subPtr, nearCache]() {
             std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
             thisPtr->connections_.insert(
-                thisPtr->newSubscribeConnection(loop, subPtr));
+                thisPtr->newSubscribeConnection(loop, subPtr, nearCache));
         });
     });
     conn->setIdleCallback([weakThis, weakSub](const RedisConnectionPtr &) {
@@ -171,21 +241,121 @@ RedisConnectionPtr RedisClientImpl::newSubscribeConnection(
     return conn;
 }
 
+RedisConnectionPtr RedisClientImpl::newStreamConnection(
+    trantor::EventLoop *loop,
+    const std::shared_ptr<RedisStreamConsumerImpl> &consumer)
+{
+    auto conn = std::make_shared<RedisConnection>(
+        serverAddr_, username_, password_, db_, loop);
+    std::weak_ptr<RedisClientImpl> weakThis = shared_from_this();
+    std::weak_ptr<RedisStreamConsumerImpl> weakConsumer(consumer);
+    conn->setConnectCallback([weakThis,
+                              weakConsumer](RedisConnectionPtr &&conn) {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        auto consumerPtr = weakConsumer.lock();
+        if (consumerPtr && !consumerPtr->stopped())
+        {
+            consumerPtr->setConnection(conn);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
+            thisPtr->connections_.erase(conn);
+        }
+        conn->disconnect();
+    });
+    conn->setDisconnectCallback([weakThis,
+                                 weakConsumer](RedisConnectionPtr &&conn) {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
+            thisPtr->connections_.erase(conn);
+        }
+        auto consumerPtr = weakConsumer.lock();
+        if (!consumerPtr)
+            return;
+        consumerPtr->clearConnection();
+        if (consumerPtr->stopped())
+            return;
+        auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        assert(loop);
+        loop->runAfter(2.0, [thisPtr, loop, weakConsumer]() {
+            auto consumerPtr = weakConsumer.lock();
+            if (!consumerPtr || consumerPtr->stopped())
+                return;
+            std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
+            thisPtr->connections_.insert(
+                thisPtr->newStreamConnection(loop, consumerPtr));
+        });
+    });
+    return conn;
+}
+
 void RedisClientImpl::execCommandAsync(
     RedisResultCallback &&resultCallback,
     RedisExceptionCallback &&exceptionCallback,
     std::string_view command,
     ...) noexcept
 {
+    LOG_TRACE << "redis command: " << command;
+    std::string formattedCmd;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCmd = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    execFormattedCommandAsync(std::move(formattedCmd),
+                              std::move(resultCallback),
+                              std::move(exceptionCallback));
+}
+
+void RedisClientImpl::execFormattedCommandAsync(
+    std::string &&command,
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    bool asking) noexcept
+{
+    // The redirections of the cluster client are sent again with asking
+    if (!asking)
+        RedisConnection::traceCommand(RedisConnection::getCommandName(command),
+                                      resultCallback,
+                                      exceptionCallback);
+    if (hasNearCache_.load(std::memory_order_acquire) && !asking)
+    {
+        auto cacheKey = nearCache_->cacheKeyOf(command);
+        if (!cacheKey.empty())
+        {
+            if (nearCache_->lookup(cacheKey, resultCallback))
+                return;
+            auto ticket = nearCache_->ticketOf(cacheKey);
+            resultCallback = [nearCache = nearCache_,
+                              cacheKey = std::move(cacheKey),
+                              ticket,
+                              resultCallback = std::move(resultCallback)](
+                                 const RedisResult &result) {
+                nearCache->store(cacheKey, result, ticket);
+                resultCallback(result);
+            };
+        }
+    }
     if (timeout_ > 0.0)
     {
-        va_list args;
-        va_start(args, command);
-        execCommandAsyncWithTimeout(command,
+        execCommandAsyncWithTimeout(std::move(command),
                                     std::move(resultCallback),
                                     std::move(exceptionCallback),
-                                    args);
-        va_end(args);
+                                    asking);
         return;
     }
     RedisConnectionPtr connPtr;
@@ -206,35 +376,112 @@ void RedisClientImpl::execCommandAsync(
     }
     if (connPtr)
     {
-        va_list args;
-        va_start(args, command);
-        connPtr->sendvCommand(command,
-                              std::move(resultCallback),
-                              std::move(exceptionCallback),
-                              args);
-        va_end(args);
+        drogon::BuiltinMetrics::instance().poolWaited(
+            drogon::BuiltinMetrics::Pool::kRedis, 0);
+        sendFormattedCommand(connPtr,
+                             std::move(command),
+                             std::move(resultCallback),
+                             std::move(exceptionCallback),
+                             asking);
     }
     else
     {
         LOG_TRACE << "no connection available, push command to buffer";
-        va_list args;
-        va_start(args, command);
-        auto formattedCmd = RedisConnection::getFormattedCommand(command, args);
-        va_end(args);
         std::lock_guard<std::mutex> lock(connectionsMutex_);
         tasks_.emplace_back(
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(resultCallback),
                  exceptionCallback = std::move(exceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 command = std::move(command),
+                 asking,
+                 bufferedDate = trantor::Date::now()](
+                    const RedisConnectionPtr &connPtr) mutable {
+                    observeWait(bufferedDate);
+                    sendFormattedCommand(connPtr,
+                                         std::move(command),
+                                         std::move(resultCallback),
+                                         std::move(exceptionCallback),
+                                         asking);
+                }));
+    }
+}
+
+void RedisClientImpl::execFormattedCommandsAsync(
+    std::vector<RedisCommand> &&commands) noexcept
+{
+    RedisConnectionPtr connPtr;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        if (!readyConnections_.empty())
+        {
+            if (connectionPos_ >= readyConnections_.size())
+            {
+                connPtr = readyConnections_[0];
+                connectionPos_ = 1;
+            }
+            else
+            {
+                connPtr = readyConnections_[connectionPos_++];
+            }
+        }
+    }
+    if (connPtr)
+    {
+        drogon::BuiltinMetrics::instance().poolWaited(
+            drogon::BuiltinMetrics::Pool::kRedis, 0);
+        connPtr->sendFormattedCommands(std::move(commands));
+    }
+    else
+    {
+        LOG_TRACE << "no connection available, push commands to buffer";
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        tasks_.emplace_back(
+            std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
+                [commands = std::move(commands),
+                 bufferedDate = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
-                    connPtr->sendFormattedCommand(std::move(formattedCmd),
-                                                  std::move(resultCallback),
-                                                  std::move(exceptionCallback));
+                    observeWait(bufferedDate);
+                    connPtr->sendFormattedCommands(std::move(commands));
                 }));
     }
 }
 
+std::shared_ptr<RedisPipeline> RedisClientImpl::newPipeline() noexcept
+{
+    return std::make_shared<RedisPipelineImpl>(
+        [thisPtr = shared_from_this()](std::vector<RedisCommand> &&commands) {
+            thisPtr->execFormattedCommandsAsync(std::move(commands));
+        },
+        loops_.getNextLoop(),
+        timeout_);
+}
+
+std::shared_ptr<RedisScanner> RedisClientImpl::newScanner(
+    const RedisScanOptions &options)
+{
+    return RedisScannerImpl::newScanner(shared_from_this(), options);
+}
+
+void RedisClientImpl::sendFormattedCommand(
+    const RedisConnectionPtr &connPtr,
+    std::string &&command,
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    bool asking)
+{
+    if (asking)
+    {
+        // ASKING only applies to the next command of the same connection
+        static const std::string askingCmd{"*1\r\n$6\r\nASKING\r\n"};
+        connPtr->sendFormattedCommand(std::string{askingCmd},
+                                      [](const RedisResult &) {},
+                                      [](const RedisException &) {});
+    }
+    connPtr->sendFormattedCommand(std::move(command),
+                                  std::move(resultCallback),
+                                  std::move(exceptionCallback));
+}
+
 RedisClientImpl::~RedisClientImpl()
 {
     closeAll();
@@ -251,6 +498,18 @@ void RedisClientImpl::closeAll()
     connections_.clear();
 }
 
+RedisPoolStatus RedisClientImpl::poolStatus() const noexcept
+{
+    RedisPoolStatus status;
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    status.connections = connections_.size();
+    status.ready = readyConnections_.size();
+    status.queued = tasks_.size();
+    for (auto &conn : connections_)
+        status.unanswered += conn->unansweredCommands();
+    return status;
+}
+
 void RedisClientImpl::newTransactionAsync(
     const std::function<void(const std::shared_ptr<RedisTransaction> &)>
         &callback)
@@ -379,10 +638,10 @@ void RedisClientImpl::handleNextTask(const RedisConnectionPtr &connPtr)
 }
 
 void RedisClientImpl::execCommandAsyncWithTimeout(
-    std::string_view command,
+    std::string &&command,
     RedisResultCallback &&resultCallback,
     RedisExceptionCallback &&exceptionCallback,
-    va_list ap)
+    bool asking)
 {
     auto expCbPtr =
         std::make_shared<RedisExceptionCallback>(std::move(exceptionCallback));
@@ -451,24 +710,31 @@ void RedisClientImpl::execCommandAsyncWithTimeout(
     }
     if (connPtr)
     {
-        connPtr->sendvCommand(command,
-                              std::move(newResultCallback),
-                              std::move(newExceptionCallback),
-                              ap);
+        drogon::BuiltinMetrics::instance().poolWaited(
+            drogon::BuiltinMetrics::Pool::kRedis, 0);
+        sendFormattedCommand(connPtr,
+                             std::move(command),
+                             std::move(newResultCallback),
+                             std::move(newExceptionCallback),
+                             asking);
     }
     else
     {
         LOG_TRACE << "no connection available, push command to buffer";
-        auto formattedCmd = RedisConnection::getFormattedCommand(command, ap);
         auto bfCbPtr =
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(newResultCallback),
                  exceptionCallback = std::move(newExceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 command = std::move(command),
+                 asking,
+                 bufferedDate = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
-                    connPtr->sendFormattedCommand(std::move(formattedCmd),
-                                                  std::move(resultCallback),
-                                                  std::move(exceptionCallback));
+                    observeWait(bufferedDate);
+                    sendFormattedCommand(connPtr,
+                                         std::move(command),
+                                         std::move(resultCallback),
+                                         std::move(exceptionCallback),
+                                         asking);
                 });
         (*bufferCbPtr) = bfCbPtr;
         std::lock_guard<std::mutex> lock(connectionsMutex_);
@@ -477,6 +743,128 @@ void RedisClientImpl::execCommandAsyncWithTimeout(
     timeoutFlagPtr->runTimer();
 }
 
+std::shared_ptr<RedisStreamConsumer> RedisClientImpl::newStreamConsumer(
+    const RedisStreamConsumerConfig &config,
+    RedisStreamBatchCallback &&batchCallback,
+    trantor::EventLoop *loop)
+{
+    if (config.stream.empty() || config.group.empty() ||
+        config.consumer.empty())
+    {
+        LOG_ERROR << "A stream consumer needs a stream, a group and a name";
+        return nullptr;
+    }
+    std::weak_ptr<RedisClientImpl> weakPtr = shared_from_this();
+    auto connLoop = loops_.getNextLoop();
+    // The blocking reads run on a dedicated connection, the other commands
+    // go through the pool.
+    auto consumer = std::make_shared<RedisStreamConsumerImpl>(
+        config,
+        std::move(batchCallback),
+        connLoop,
+        loop,
+        [weakPtr](std::string &&command,
+                  RedisResultCallback &&resultCallback,
+                  RedisExceptionCallback &&exceptionCallback) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                exceptionCallback(
+                    RedisException(RedisErrorCode::kNoConnectionAvailable,
+                                   "The redis client is destroyed"));
+                return;
+            }
+            thisPtr->execFormattedCommandAsync(std::move(command),
+                                               std::move(resultCallback),
+                                               std::move(exceptionCallback));
+        });
+    connLoop->queueInLoop([this, connLoop, consumer]() {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        connections_.insert(newStreamConnection(connLoop, consumer));
+    });
+    return consumer;
+}
+
+void RedisClientImpl::registerScript(const std::string &name,
+                                     const std::string &source)
+{
+    scripts_.add(name, source);
+    // The script cache is shared by all the connections to the server
+    execFormattedCommandAsync(
+        RedisScriptRegistry::loadCommand(source),
+        [](const RedisResult &) {},
+        [name](const RedisException &err) {
+            LOG_ERROR << "Failed to load the script " << name << ": "
+                      << err.what();
+        });
+}
+
+void RedisClientImpl::execScriptAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    const std::string &name,
+    std::string_view arguments,
+    ...) noexcept
+{
+    std::weak_ptr<RedisClientImpl> weakPtr = shared_from_this();
+    va_list args;
+    va_start(args, arguments);
+    scripts_.exec(
+        [weakPtr](std::string &&command,
+                  RedisResultCallback &&resultCallback,
+                  RedisExceptionCallback &&exceptionCallback) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                exceptionCallback(
+                    RedisException(RedisErrorCode::kNoConnectionAvailable,
+                                   "The redis client is destroyed"));
+                return;
+            }
+            thisPtr->execFormattedCommandAsync(std::move(command),
+                                               std::move(resultCallback),
+                                               std::move(exceptionCallback));
+        },
+        name,
+        arguments,
+        args,
+        std::move(resultCallback),
+        std::move(exceptionCallback));
+    va_end(args);
+}
+
+void RedisClientImpl::enableNearCache(
+    const std::vector<std::string> &keyPrefixes,
+    size_t maxBytes)
+{
+    if (hasNearCache_.load(std::memory_order_acquire))
+    {
+        LOG_ERROR << "The near cache is already enabled";
+        return;
+    }
+    nearCache_ = std::make_shared<RedisNearCache>(keyPrefixes, maxBytes);
+    trackingSubscriber_ = std::make_shared<RedisSubscriberImpl>();
+    trackingSubscriber_->subscribe(
+        RedisNearCache::kInvalidationChannel,
+        [nearCache = nearCache_](const std::string &,
+                                 const std::string &key) {
+            nearCache->invalidate(key);
+        });
+    trackingSubscriber_->setSubscribeCallback(
+        RedisNearCache::kInvalidationChannel,
+        [nearCache = nearCache_]() { nearCache->setActive(true); });
+    auto loop = loops_.getNextLoop();
+    loop->queueInLoop([this,
+                       loop,
+                       subscriber = trackingSubscriber_,
+                       nearCache = nearCache_]() {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        connections_.insert(
+            newSubscribeConnection(loop, subscriber, nearCache));
+    });
+    hasNearCache_.store(true, std::memory_order_release);
+}
+
 std::shared_ptr<RedisSubscriber> RedisClientImpl::newSubscriber() noexcept
 {
     auto subscriber = std::make_shared<RedisSubscriberImpl>();
@@ -488,3 +876,23 @@ std::shared_ptr<RedisSubscriber> RedisClientImpl::newSubscriber() noexcept
 
     return subscriber;
 }
+
+std::shared_ptr<RedisSubscriber> RedisClientImpl::newSharedSubscriber() noexcept
+{
+    std::shared_ptr<RedisSubscriberHub> hub;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        hub = subscriberHub_;
+    }
+    if (!hub)
+    {
+        auto subscriber = newSubscriber();
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        if (!subscriberHub_)
+        {
+            subscriberHub_ = std::make_shared<RedisSubscriberHub>(subscriber);
+        }
+        hub = subscriberHub_;
+    }
+    return std::make_shared<RedisSharedSubscriber>(hub);
+}
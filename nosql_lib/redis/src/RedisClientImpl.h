@@ -14,6 +14,10 @@
 #pragma once
 
 #include "RedisConnection.h"
+#include "RedisNearCache.h"
+#include "RedisScriptRegistry.h"
+#include "RedisStreamConsumerImpl.h"
+#include "RedisSubscriberHub.h"
 #include "RedisSubscriberImpl.h"
 #include "SubscribeContext.h"
 #include <drogon/nosql/RedisClient.h>
@@ -21,6 +25,7 @@
 #include <trantor/net/EventLoopThreadPool.h>
 #include <vector>
 #include <unordered_set>
+#include <atomic>
 #include <list>
 #include <future>
 
@@ -48,6 +53,23 @@ class RedisClientImpl final
                           ...) noexcept override;
     ~RedisClientImpl() override;
     std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override;
+    std::shared_ptr<RedisSubscriber> newSharedSubscriber() noexcept override;
+    std::shared_ptr<RedisPipeline> newPipeline() noexcept override;
+    std::shared_ptr<RedisScanner> newScanner(
+        const RedisScanOptions &options) override;
+    void enableNearCache(const std::vector<std::string> &keyPrefixes,
+                         size_t maxBytes) override;
+    std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig &config,
+        RedisStreamBatchCallback &&batchCallback,
+        trantor::EventLoop *loop) override;
+    void registerScript(const std::string &name,
+                        const std::string &source) override;
+    void execScriptAsync(RedisResultCallback &&resultCallback,
+                         RedisExceptionCallback &&exceptionCallback,
+                         const std::string &name,
+                         std::string_view arguments,
+                         ...) noexcept override;
 
     RedisTransactionPtr newTransaction() noexcept(false) override
     {
@@ -77,10 +99,37 @@ class RedisClientImpl final
 
     void init();
     void closeAll() override;
+    RedisPoolStatus poolStatus() const noexcept override;
+
+    void execFormattedCommandAsync(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback) noexcept override
+    {
+        execFormattedCommandAsync(std::move(command),
+                                  std::move(resultCallback),
+                                  std::move(exceptionCallback),
+                                  false);
+    }
+
+    /**
+     * @brief Send a formatted command
+     *
+     * @param asking Send ASKING before the command on the same connection,
+     * used to follow the ASK redirections of a Redis Cluster.
+     */
+    void execFormattedCommandAsync(std::string &&command,
+                                   RedisResultCallback &&resultCallback,
+                                   RedisExceptionCallback &&exceptionCallback,
+                                   bool asking) noexcept;
+
+    /// Send the formatted commands in order through the same connection
+    void execFormattedCommandsAsync(
+        std::vector<RedisCommand> &&commands) noexcept;
 
   private:
     trantor::EventLoopThreadPool loops_;
-    std::mutex connectionsMutex_;
+    mutable std::mutex connectionsMutex_;
     std::unordered_set<RedisConnectionPtr> connections_;
     std::vector<RedisConnectionPtr> readyConnections_;
     size_t connectionPos_{0};
@@ -92,19 +141,41 @@ class RedisClientImpl final
     double timeout_{-1.0};
     std::list<std::shared_ptr<std::function<void(const RedisConnectionPtr &)>>>
         tasks_;
+    // Set once by enableNearCache(), before hasNearCache_
+    std::shared_ptr<RedisNearCache> nearCache_;
+    std::shared_ptr<RedisSubscriberImpl> trackingSubscriber_;
+    std::atomic<bool> hasNearCache_{false};
+    // Created by the first shared subscriber, guarded by connectionsMutex_
+    std::shared_ptr<RedisSubscriberHub> subscriberHub_;
+    // Loaded on every new connection
+    RedisScriptRegistry scripts_;
 
     RedisConnectionPtr newConnection(trantor::EventLoop *loop);
+    /**
+     * @param nearCache If set, the connection enables the client tracking of
+     * the cache, redirected to itself, before subscribing.
+     */
     RedisConnectionPtr newSubscribeConnection(
         trantor::EventLoop *loop,
-        const std::shared_ptr<RedisSubscriberImpl> &subscriber);
+        const std::shared_ptr<RedisSubscriberImpl> &subscriber,
+        const std::shared_ptr<RedisNearCache> &nearCache = nullptr);
+
+    RedisConnectionPtr newStreamConnection(
+        trantor::EventLoop *loop,
+        const std::shared_ptr<RedisStreamConsumerImpl> &consumer);
 
     std::shared_ptr<RedisTransaction> makeTransaction(
         const RedisConnectionPtr &connPtr);
     void handleNextTask(const RedisConnectionPtr &connPtr);
-    void execCommandAsyncWithTimeout(std::string_view command,
+    void execCommandAsyncWithTimeout(std::string &&command,
+                                     RedisResultCallback &&resultCallback,
+                                     RedisExceptionCallback &&exceptionCallback,
+                                     bool asking);
+    static void sendFormattedCommand(const RedisConnectionPtr &connPtr,
+                                     std::string &&command,
                                      RedisResultCallback &&resultCallback,
                                      RedisExceptionCallback &&exceptionCallback,
-                                     va_list ap);
+                                     bool asking);
 };
 }  // namespace nosql
 }  // namespace drogon
@@ -14,11 +14,23 @@
 
 #include "RedisConnection.h"
 #include "RedisClientLockFree.h"
+#include "RedisPipelineImpl.h"
+#include "RedisScannerImpl.h"
 #include "RedisSubscriberImpl.h"
 #include "RedisTransactionImpl.h"
+#include "../../lib/src/BuiltinMetrics.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
 using namespace drogon::nosql;
 
+static void observeWait(const trantor::Date &bufferedDate)
+{
+    auto wait = trantor::Date::now().microSecondsSinceEpoch() -
+                bufferedDate.microSecondsSinceEpoch();
+    drogon::BuiltinMetrics::instance().poolWaited(
+        drogon::BuiltinMetrics::Pool::kRedisFast,
+        static_cast<double>(wait) / 1000000);
+}
+
 RedisClientLockFree::RedisClientLockFree(
     const trantor::InetAddress &serverAddress,
     size_t numberOfConnections,
@@ -46,19 +58,42 @@ RedisConnectionPtr RedisClientLockFree::newConnection()
     auto conn = std::make_shared<RedisConnection>(
         serverAddr_, username_, password_, db_, loop_);
     std::weak_ptr<RedisClientLockFree> thisWeakPtr = shared_from_this();
-    conn->setConnectCallback([thisWeakPtr](RedisConnectionPtr &&conn) {
+    // Counted in the metrics from the connection until the disconnection
+    auto connected = std::make_shared<bool>(false);
+    conn->setConnectCallback([thisWeakPtr,
+                              connected](RedisConnectionPtr &&conn) {
         auto thisPtr = thisWeakPtr.lock();
         if (thisPtr)
         {
+            *connected = true;
+            drogon::BuiltinMetrics::instance().redisFastConnectionOpened(
+                thisPtr->loop_);
+            for (auto &script : thisPtr->scripts_.scripts())
+            {
+                conn->sendFormattedCommand(
+                    RedisScriptRegistry::loadCommand(script.second),
+                    [](const RedisResult &) {},
+                    [name = script.first](const RedisException &err) {
+                        LOG_ERROR << "Failed to load the script " << name
+                                  << ": " << err.what();
+                    });
+            }
             thisPtr->readyConnections_.push_back(conn);
             thisPtr->handleNextTask(conn);
         }
     });
-    conn->setDisconnectCallback([thisWeakPtr](RedisConnectionPtr &&conn) {
+    conn->setDisconnectCallback([thisWeakPtr,
+                                 connected](RedisConnectionPtr &&conn) {
         // assert(status == REDIS_CONNECTED);
         auto thisPtr = thisWeakPtr.lock();
         if (thisPtr)
         {
+            if (*connected)
+            {
+                *connected = false;
+                drogon::BuiltinMetrics::instance().redisFastConnectionClosed(
+                    thisPtr->loop_);
+            }
             thisPtr->connections_.erase(conn);
             for (auto iter = thisPtr->readyConnections_.begin();
                  iter != thisPtr->readyConnections_.end();
@@ -146,15 +181,28 @@ void RedisClientLockFree::execCommandAsync(
     ...) noexcept
 {
     loop_->assertInLoopThread();
+    RedisConnection::traceCommand(command.substr(0, command.find(' ')),
+                                  resultCallback,
+                                  exceptionCallback);
     if (timeout_ > 0.0)
     {
+        std::string formattedCmd;
         va_list args;
         va_start(args, command);
-        execCommandAsyncWithTimeout(command,
-                                    std::move(resultCallback),
-                                    std::move(exceptionCallback),
-                                    args);
+        try
+        {
+            formattedCmd = RedisConnection::getFormattedCommand(command, args);
+        }
+        catch (const RedisException &err)
+        {
+            va_end(args);
+            exceptionCallback(err);
+            return;
+        }
         va_end(args);
+        execCommandAsyncWithTimeout(std::move(formattedCmd),
+                                    std::move(resultCallback),
+                                    std::move(exceptionCallback));
         return;
     }
     RedisConnectionPtr connPtr;
@@ -174,6 +222,8 @@ void RedisClientLockFree::execCommandAsync(
     }
     if (connPtr)
     {
+        drogon::BuiltinMetrics::instance().poolWaited(
+            drogon::BuiltinMetrics::Pool::kRedisFast, 0);
         va_list args;
         va_start(args, command);
         connPtr->sendvCommand(command,
@@ -195,8 +245,10 @@ void RedisClientLockFree::execCommandAsync(
                 [thisWeakPtr,
                  resultCallback = std::move(resultCallback),
                  exceptionCallback = std::move(exceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 formattedCmd = std::move(formattedCmd),
+                 bufferedDate = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
+                    observeWait(bufferedDate);
                     connPtr->sendFormattedCommand(std::move(formattedCmd),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
@@ -204,6 +256,162 @@ void RedisClientLockFree::execCommandAsync(
     }
 }
 
+void RedisClientLockFree::execFormattedCommandAsync(
+    std::string &&command,
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback) noexcept
+{
+    loop_->assertInLoopThread();
+    RedisConnection::traceCommand(RedisConnection::getCommandName(command),
+                                  resultCallback,
+                                  exceptionCallback);
+    if (timeout_ > 0.0)
+    {
+        execCommandAsyncWithTimeout(std::move(command),
+                                    std::move(resultCallback),
+                                    std::move(exceptionCallback));
+        return;
+    }
+    RedisConnectionPtr connPtr;
+    if (!readyConnections_.empty())
+    {
+        if (connectionPos_ >= readyConnections_.size())
+        {
+            connPtr = readyConnections_[0];
+            connectionPos_ = 1;
+        }
+        else
+        {
+            connPtr = readyConnections_[connectionPos_++];
+        }
+    }
+    if (connPtr)
+    {
+        drogon::BuiltinMetrics::instance().poolWaited(
+            drogon::BuiltinMetrics::Pool::kRedisFast, 0);
+        connPtr->sendFormattedCommand(std::move(command),
+                                      std::move(resultCallback),
+                                      std::move(exceptionCallback));
+    }
+    else
+    {
+        LOG_TRACE << "no connection available, push command to buffer";
+        tasks_.emplace_back(
+            std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
+                [resultCallback = std::move(resultCallback),
+                 exceptionCallback = std::move(exceptionCallback),
+                 command = std::move(command),
+                 bufferedDate = trantor::Date::now()](
+                    const RedisConnectionPtr &connPtr) mutable {
+                    observeWait(bufferedDate);
+                    connPtr->sendFormattedCommand(std::move(command),
+                                                  std::move(resultCallback),
+                                                  std::move(exceptionCallback));
+                }));
+    }
+}
+
+void RedisClientLockFree::execFormattedCommands(
+    std::vector<RedisCommand> &&commands)
+{
+    loop_->assertInLoopThread();
+    RedisConnectionPtr connPtr;
+    if (!readyConnections_.empty())
+    {
+        if (connectionPos_ >= readyConnections_.size())
+        {
+            connPtr = readyConnections_[0];
+            connectionPos_ = 1;
+        }
+        else
+        {
+            connPtr = readyConnections_[connectionPos_++];
+        }
+    }
+    if (connPtr)
+    {
+        connPtr->sendFormattedCommands(std::move(commands));
+    }
+    else
+    {
+        LOG_TRACE << "no connection available, push commands to buffer";
+        tasks_.emplace_back(
+            std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
+                [commands = std::move(commands)](
+                    const RedisConnectionPtr &connPtr) mutable {
+                    connPtr->sendFormattedCommands(std::move(commands));
+                }));
+    }
+}
+
+std::shared_ptr<RedisPipeline> RedisClientLockFree::newPipeline() noexcept
+{
+    return std::make_shared<RedisPipelineImpl>(
+        [thisPtr = shared_from_this()](std::vector<RedisCommand> &&commands) {
+            thisPtr->execFormattedCommands(std::move(commands));
+        },
+        loop_,
+        timeout_);
+}
+
+std::shared_ptr<RedisScanner> RedisClientLockFree::newScanner(
+    const RedisScanOptions &options)
+{
+    return RedisScannerImpl::newScanner(shared_from_this(), options);
+}
+
+void RedisClientLockFree::registerScript(const std::string &name,
+                                         const std::string &source)
+{
+    loop_->assertInLoopThread();
+    scripts_.add(name, source);
+    std::vector<RedisCommand> commands;
+    commands.push_back({RedisScriptRegistry::loadCommand(source),
+                        [](const RedisResult &) {},
+                        [name](const RedisException &err) {
+                            LOG_ERROR << "Failed to load the script " << name
+                                      << ": " << err.what();
+                        }});
+    execFormattedCommands(std::move(commands));
+}
+
+void RedisClientLockFree::execScriptAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    const std::string &name,
+    std::string_view arguments,
+    ...) noexcept
+{
+    loop_->assertInLoopThread();
+    std::weak_ptr<RedisClientLockFree> weakPtr = shared_from_this();
+    va_list args;
+    va_start(args, arguments);
+    scripts_.exec(
+        [weakPtr](std::string &&command,
+                  RedisResultCallback &&resultCallback,
+                  RedisExceptionCallback &&exceptionCallback) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                exceptionCallback(
+                    RedisException(RedisErrorCode::kNoConnectionAvailable,
+                                   "The redis client is destroyed"));
+                return;
+            }
+            std::vector<RedisCommand> commands;
+            commands.push_back({std::move(command),
+                                std::move(resultCallback),
+                                std::move(exceptionCallback)});
+            thisPtr->execFormattedCommands(std::move(commands));
+        },
+        name,
+        arguments,
+        args,
+        std::move(resultCallback),
+        std::move(exceptionCallback));
+    va_end(args);
+}
+
 RedisClientLockFree::~RedisClientLockFree()
 {
     closeAll();
@@ -339,10 +547,9 @@ void RedisClientLockFree::handleNextTask(const RedisConnectionPtr &connPtr)
 }
 
 void RedisClientLockFree::execCommandAsyncWithTimeout(
-    std::string_view command,
+    std::string &&command,
     RedisResultCallback &&resultCallback,
-    RedisExceptionCallback &&exceptionCallback,
-    va_list ap)
+    RedisExceptionCallback &&exceptionCallback)
 {
     auto expCbPtr =
         std::make_shared<RedisExceptionCallback>(std::move(exceptionCallback));
@@ -409,22 +616,24 @@ void RedisClientLockFree::execCommandAsyncWithTimeout(
     }
     if (connPtr)
     {
-        connPtr->sendvCommand(command,
-                              std::move(newResultCallback),
-                              std::move(newExceptionCallback),
-                              ap);
+        drogon::BuiltinMetrics::instance().poolWaited(
+            drogon::BuiltinMetrics::Pool::kRedisFast, 0);
+        connPtr->sendFormattedCommand(std::move(command),
+                                      std::move(newResultCallback),
+                                      std::move(newExceptionCallback));
     }
     else
     {
         LOG_TRACE << "no connection available, push command to buffer";
-        auto formattedCmd = RedisConnection::getFormattedCommand(command, ap);
         auto bfCbPtr =
             std::make_shared<std::function<void(const RedisConnectionPtr &)>>(
                 [resultCallback = std::move(newResultCallback),
                  exceptionCallback = std::move(newExceptionCallback),
-                 formattedCmd = std::move(formattedCmd)](
+                 command = std::move(command),
+                 bufferedDate = trantor::Date::now()](
                     const RedisConnectionPtr &connPtr) mutable {
-                    connPtr->sendFormattedCommand(std::move(formattedCmd),
+                    observeWait(bufferedDate);
+                    connPtr->sendFormattedCommand(std::move(command),
                                                   std::move(resultCallback),
                                                   std::move(exceptionCallback));
                 });
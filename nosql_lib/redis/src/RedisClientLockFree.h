@@ -14,6 +14,7 @@
 #pragma once
 
 #include "RedisConnection.h"
+#include "RedisScriptRegistry.h"
 #include "RedisSubscriberImpl.h"
 #include <drogon/nosql/RedisClient.h>
 #include <trantor/utils/NonCopyable.h>
@@ -46,8 +47,22 @@ class RedisClientLockFree final
                           RedisExceptionCallback &&exceptionCallback,
                           std::string_view command,
                           ...) noexcept override;
+    void execFormattedCommandAsync(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback) noexcept override;
     ~RedisClientLockFree() override;
     std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override;
+    std::shared_ptr<RedisPipeline> newPipeline() noexcept override;
+    std::shared_ptr<RedisScanner> newScanner(
+        const RedisScanOptions &options) override;
+    void registerScript(const std::string &name,
+                        const std::string &source) override;
+    void execScriptAsync(RedisResultCallback &&resultCallback,
+                         RedisExceptionCallback &&exceptionCallback,
+                         const std::string &name,
+                         std::string_view arguments,
+                         ...) noexcept override;
 
     RedisTransactionPtr newTransaction() override
     {
@@ -83,6 +98,7 @@ class RedisClientLockFree final
     std::list<std::shared_ptr<std::function<void(const RedisConnectionPtr &)>>>
         tasks_;
     double timeout_{-1.0};
+    RedisScriptRegistry scripts_;
 
     RedisConnectionPtr newConnection();
     RedisConnectionPtr newSubscribeConnection(
@@ -90,10 +106,11 @@ class RedisClientLockFree final
     std::shared_ptr<RedisTransaction> makeTransaction(
         const RedisConnectionPtr &connPtr);
     void handleNextTask(const RedisConnectionPtr &connPtr);
-    void execCommandAsyncWithTimeout(std::string_view command,
-                                     RedisResultCallback &&resultCallback,
-                                     RedisExceptionCallback &&exceptionCallback,
-                                     va_list ap);
+    void execFormattedCommands(std::vector<RedisCommand> &&commands);
+    void execCommandAsyncWithTimeout(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback);
 };
 }  // namespace nosql
 }  // namespace drogon
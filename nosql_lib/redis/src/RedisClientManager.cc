@@ -15,6 +15,8 @@
 #include "../../lib/src/RedisClientManager.h"
 #include "RedisClientLockFree.h"
 #include "RedisClientImpl.h"
+#include "RedisClusterClient.h"
+#include "RedisSentinelClient.h"
 
 #include <algorithm>
 
@@ -28,17 +30,38 @@ void RedisClientManager::createRedisClients(
     assert(redisFastClientsMap_.empty());
     for (auto &redisInfo : redisInfos_)
     {
-        if (redisInfo.isFast_)
+        auto sentinel = !redisInfo.sentinelMaster_.empty();
+        if (!redisInfo.isFast_ && (redisInfo.cluster_ || sentinel) &&
+            redisInfo.fastConnectionNumber_ > 0)
         {
+            LOG_WARN << "Redis Cluster and Sentinel are not supported by fast "
+                        "clients, the fast_connection_number option of "
+                     << redisInfo.name_ << " is ignored";
+        }
+        else if (redisInfo.isFast_ || redisInfo.fastConnectionNumber_ > 0)
+        {
+            if (redisInfo.cluster_ || sentinel)
+            {
+                LOG_WARN << "Redis Cluster and Sentinel are not supported by "
+                            "fast clients, the cluster and sentinel_master "
+                            "options of "
+                         << redisInfo.name_ << " are ignored";
+            }
+            auto connNum = redisInfo.fastConnectionNumber_ > 0
+                               ? redisInfo.fastConnectionNumber_
+                               : redisInfo.connectionNumber_;
             redisFastClientsMap_[redisInfo.name_] =
                 IOThreadStorage<RedisClientPtr>();
             redisFastClientsMap_[redisInfo.name_].init([&](RedisClientPtr &c,
                                                            size_t idx) {
+                // The handler loops come and go, they have no fast clients
+                if (idx >= ioLoops.size())
+                    return;
                 assert(idx == ioLoops[idx]->index());
                 LOG_TRACE << "create fast redis client for the thread " << idx;
                 c = std::make_shared<RedisClientLockFree>(
                     trantor::InetAddress(redisInfo.addr_, redisInfo.port_),
-                    redisInfo.connectionNumber_,
+                    connNum,
                     ioLoops[idx],
                     redisInfo.username_,
                     redisInfo.password_,
@@ -48,6 +71,41 @@ void RedisClientManager::createRedisClients(
                     c->setTimeout(redisInfo.timeout_);
                 }
             });
+            if (redisInfo.isFast_)
+                continue;
+        }
+        if (redisInfo.cluster_)
+        {
+            auto clientPtr = std::make_shared<RedisClusterClient>(
+                std::vector<trantor::InetAddress>{
+                    trantor::InetAddress(redisInfo.addr_, redisInfo.port_)},
+                redisInfo.connectionNumber_,
+                redisInfo.username_,
+                redisInfo.password_);
+            if (redisInfo.timeout_ > 0.0)
+            {
+                clientPtr->setTimeout(redisInfo.timeout_);
+            }
+            clientPtr->init();
+            redisClientsMap_[redisInfo.name_] = std::move(clientPtr);
+        }
+        else if (sentinel)
+        {
+            auto clientPtr = std::make_shared<RedisSentinelClient>(
+                std::vector<trantor::InetAddress>{
+                    trantor::InetAddress(redisInfo.addr_, redisInfo.port_)},
+                redisInfo.sentinelMaster_,
+                redisInfo.connectionNumber_,
+                redisInfo.replicaReads_,
+                redisInfo.username_,
+                redisInfo.password_,
+                redisInfo.db_);
+            if (redisInfo.timeout_ > 0.0)
+            {
+                clientPtr->setTimeout(redisInfo.timeout_);
+            }
+            clientPtr->init();
+            redisClientsMap_[redisInfo.name_] = std::move(clientPtr);
         }
         else
         {
@@ -75,7 +133,11 @@ void RedisClientManager::createRedisClient(const std::string &name,
                                            const size_t connectionNum,
                                            const bool isFast,
                                            double timeout,
-                                           unsigned int db)
+                                           unsigned int db,
+                                           bool cluster,
+                                           size_t fastConnectionNum,
+                                           const std::string &sentinelMaster,
+                                           bool replicaReads)
 {
     RedisInfo info;
     info.name_ = name;
@@ -87,6 +149,10 @@ void RedisClientManager::createRedisClient(const std::string &name,
     info.isFast_ = isFast;
     info.timeout_ = timeout;
     info.db_ = db;
+    info.cluster_ = cluster;
+    info.fastConnectionNumber_ = fastConnectionNum;
+    info.sentinelMaster_ = sentinelMaster;
+    info.replicaReads_ = replicaReads;
 
     redisInfos_.emplace_back(std::move(info));
 }
@@ -119,6 +185,9 @@ RedisClientManager::~RedisClientManager()
     for (auto &pair : redisFastClientsMap_)
     {
         pair.second.init([](RedisClientPtr &clientPtr, size_t index) {
+            // The slots of the handler loops are empty
+            if (!clientPtr)
+                return;
             // the main loop;
             std::promise<void> p;
             auto f = p.get_future();
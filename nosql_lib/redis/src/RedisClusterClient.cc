@@ -0,0 +1,752 @@
+/**
+ *
+ *  @file RedisClusterClient.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisClusterClient.h"
+#include "RedisClientImpl.h"
+#include "RedisConnection.h"
+#include "RedisPipelineImpl.h"
+#include "RedisScannerImpl.h"
+#include "RedisSubscriberHub.h"
+#include "RedisTransactionImpl.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdarg>
+
+using namespace drogon::nosql;
+
+namespace
+{
+constexpr int kMaxRedirections{5};
+constexpr double kRefreshInterval{10.0};
+
+std::array<uint16_t, 256> makeCrc16Table()
+{
+    // CRC16-CCITT (XMODEM), the checksum of the Redis Cluster key slots
+    std::array<uint16_t, 256> table{};
+    for (uint16_t i = 0; i < 256; ++i)
+    {
+        uint16_t crc = static_cast<uint16_t>(i << 8);
+        for (int j = 0; j < 8; ++j)
+        {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                                 : static_cast<uint16_t>(crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+// The arguments of a command in the RESP format: *<n>\r\n($<len>\r\n<arg>\r\n)*
+std::vector<std::string_view> commandArguments(std::string_view command)
+{
+    std::vector<std::string_view> args;
+    auto readNumber = [&command](size_t &pos) -> long {
+        auto end = command.find("\r\n", pos);
+        if (end == std::string_view::npos)
+            return -1;
+        long n = 0;
+        for (auto i = pos; i < end; ++i)
+        {
+            if (!isdigit(static_cast<unsigned char>(command[i])))
+                return -1;
+            n = n * 10 + (command[i] - '0');
+        }
+        pos = end + 2;
+        return n;
+    };
+    size_t pos = 1;
+    if (command.empty() || command[0] != '*')
+        return args;
+    auto count = readNumber(pos);
+    for (long i = 0; i < count; ++i)
+    {
+        if (pos >= command.size() || command[pos] != '$')
+            break;
+        ++pos;
+        auto len = readNumber(pos);
+        if (len < 0 || pos + len > command.size())
+            break;
+        args.emplace_back(command.data() + pos, static_cast<size_t>(len));
+        pos += len + 2;
+    }
+    return args;
+}
+
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs)
+{
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+               return tolower(static_cast<unsigned char>(a)) ==
+                      tolower(static_cast<unsigned char>(b));
+           });
+}
+
+// The position of the first key of a command, 0 if it has none
+size_t keyPosition(const std::vector<std::string_view> &args)
+{
+    static const char *const keylessCommands[] = {
+        "asking",   "auth",     "bgrewriteaof", "bgsave",    "client",
+        "cluster",  "command",  "config",       "dbsize",    "discard",
+        "echo",     "exec",     "flushall",     "flushdb",   "function",
+        "hello",    "info",     "lastsave",     "latency",   "multi",
+        "ping",     "quit",     "readonly",     "readwrite", "role",
+        "save",     "script",   "select",       "slowlog",   "time",
+        "unwatch",  "wait"};
+    const auto &name = args[0];
+    for (auto keyless : keylessCommands)
+    {
+        if (equalsIgnoreCase(name, keyless))
+            return 0;
+    }
+    if (equalsIgnoreCase(name, "eval") || equalsIgnoreCase(name, "evalsha") ||
+        equalsIgnoreCase(name, "eval_ro") ||
+        equalsIgnoreCase(name, "evalsha_ro") ||
+        equalsIgnoreCase(name, "fcall") || equalsIgnoreCase(name, "fcall_ro"))
+    {
+        // EVAL script numkeys key...
+        return args.size() > 3 && args[2] != "0" ? 3 : 0;
+    }
+    if (equalsIgnoreCase(name, "xread") || equalsIgnoreCase(name, "xreadgroup"))
+    {
+        for (size_t i = 1; i + 1 < args.size(); ++i)
+        {
+            if (equalsIgnoreCase(args[i], "streams"))
+                return i + 1;
+        }
+        return 0;
+    }
+    if (equalsIgnoreCase(name, "object") || equalsIgnoreCase(name, "memory") ||
+        equalsIgnoreCase(name, "xinfo"))
+    {
+        // OBJECT ENCODING key
+        return 2;
+    }
+    return 1;
+}
+}  // namespace
+
+std::shared_ptr<RedisClient> RedisClient::newRedisClusterClient(
+    const std::vector<trantor::InetAddress> &seedNodes,
+    size_t connectionsPerNode,
+    const std::string &password,
+    const std::string &username)
+{
+    auto client = std::make_shared<RedisClusterClient>(seedNodes,
+                                                       connectionsPerNode,
+                                                       username,
+                                                       password);
+    client->init();
+    return client;
+}
+
+RedisClusterClient::RedisClusterClient(
+    const std::vector<trantor::InetAddress> &seedNodes,
+    size_t connectionsPerNode,
+    std::string username,
+    std::string password)
+    : connectionsPerNode_(connectionsPerNode),
+      username_(std::move(username)),
+      password_(std::move(password)),
+      slots_(kSlotNumber)
+{
+    assert(!seedNodes.empty());
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const &seed : seedNodes)
+    {
+        nodeAt(seed.toIp(), seed.toPort());
+    }
+}
+
+RedisClusterClient::~RedisClusterClient()
+{
+    if (refreshTimer_ != 0)
+        refreshThread_.getLoop()->invalidateTimer(refreshTimer_);
+    closeAll();
+}
+
+void RedisClusterClient::init()
+{
+    refreshThread_.run();
+    std::weak_ptr<RedisClusterClient> weakPtr = shared_from_this();
+    refreshTimer_ =
+        refreshThread_.getLoop()->runEvery(kRefreshInterval, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->refreshSlots();
+        });
+    refreshSlots();
+}
+
+uint16_t RedisClusterClient::keySlot(std::string_view key)
+{
+    static const auto table = makeCrc16Table();
+    auto open = key.find('{');
+    if (open != std::string_view::npos)
+    {
+        auto close = key.find('}', open + 1);
+        if (close != std::string_view::npos && close > open + 1)
+            key = key.substr(open + 1, close - open - 1);
+    }
+    uint16_t crc = 0;
+    for (unsigned char c : key)
+    {
+        crc = static_cast<uint16_t>((crc << 8) ^
+                                    table[((crc >> 8) ^ c) & 0xff]);
+    }
+    return static_cast<uint16_t>(crc & (kSlotNumber - 1));
+}
+
+int RedisClusterClient::commandSlot(std::string_view formattedCommand)
+{
+    auto args = commandArguments(formattedCommand);
+    if (args.size() < 2)
+        return -1;
+    auto pos = keyPosition(args);
+    if (pos == 0 || pos >= args.size())
+        return -1;
+    return keySlot(args[pos]);
+}
+
+void RedisClusterClient::execCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    std::string_view command,
+    ...) noexcept
+{
+    LOG_TRACE << "redis command: " << command;
+    auto request = std::make_shared<Request>();
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        request->command_ = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    request->resultCallback_ = std::move(resultCallback);
+    request->exceptionCallback_ = std::move(exceptionCallback);
+    send(request, nodeOfSlot(commandSlot(request->command_)), false);
+}
+
+void RedisClusterClient::execFormattedCommandAsync(
+    std::string &&command,
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback) noexcept
+{
+    auto request = std::make_shared<Request>();
+    request->command_ = std::move(command);
+    request->resultCallback_ = std::move(resultCallback);
+    request->exceptionCallback_ = std::move(exceptionCallback);
+    send(request, nodeOfSlot(commandSlot(request->command_)), false);
+}
+
+std::shared_ptr<RedisPipeline> RedisClusterClient::newPipeline() noexcept
+{
+    // Every command goes to the node of its slot, the commands of a node are
+    // still coalesced by its connections.
+    return std::make_shared<RedisPipelineImpl>(
+        [thisPtr = shared_from_this()](std::vector<RedisCommand> &&commands) {
+            for (auto &cmd : commands)
+            {
+                auto request = std::make_shared<Request>();
+                request->command_ = std::move(cmd.command_);
+                request->resultCallback_ = std::move(cmd.resultCallback_);
+                request->exceptionCallback_ =
+                    std::move(cmd.exceptionCallback_);
+                thisPtr->send(request,
+                              thisPtr->nodeOfSlot(
+                                  commandSlot(request->command_)),
+                              false);
+            }
+        },
+        refreshThread_.getLoop(),
+        timeout_);
+}
+
+std::shared_ptr<RedisScanner> RedisClusterClient::newScanner(
+    const RedisScanOptions &options)
+{
+    // The cursor of SCAN is only valid on one node, the elements of a key
+    // are on the node of its slot
+    if (options.key.empty())
+    {
+        LOG_ERROR << "SCAN is not supported by the cluster client, scan "
+                     "the nodes one by one";
+        return nullptr;
+    }
+    return RedisScannerImpl::newScanner(shared_from_this(), options);
+}
+
+std::shared_ptr<RedisStreamConsumer> RedisClusterClient::newStreamConsumer(
+    const RedisStreamConsumerConfig &config,
+    RedisStreamBatchCallback &&batchCallback,
+    trantor::EventLoop *loop)
+{
+    // The consumer stays on the node serving the stream when it's created
+    return nodeOfSlot(keySlot(config.stream))
+        ->newStreamConsumer(config, std::move(batchCallback), loop);
+}
+
+void RedisClusterClient::registerScript(const std::string &name,
+                                        const std::string &source)
+{
+    std::vector<std::shared_ptr<RedisClientImpl>> nodes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scripts_.add(name, source);
+        nodes.reserve(nodes_.size());
+        for (auto &node : nodes_)
+        {
+            nodes.push_back(node.second);
+        }
+    }
+    for (auto &node : nodes)
+    {
+        node->registerScript(name, source);
+    }
+}
+
+void RedisClusterClient::execScriptAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    const std::string &name,
+    std::string_view arguments,
+    ...) noexcept
+{
+    // EVALSHA and EVAL are routed by their first key, the NOSCRIPT fallback
+    // is routed again in case the slot moved meanwhile.
+    std::weak_ptr<RedisClusterClient> weakPtr = shared_from_this();
+    va_list args;
+    va_start(args, arguments);
+    scripts_.exec(
+        [weakPtr](std::string &&command,
+                  RedisResultCallback &&resultCallback,
+                  RedisExceptionCallback &&exceptionCallback) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                exceptionCallback(
+                    RedisException(RedisErrorCode::kNoConnectionAvailable,
+                                   "The redis client is destroyed"));
+                return;
+            }
+            auto request = std::make_shared<Request>();
+            request->command_ = std::move(command);
+            request->resultCallback_ = std::move(resultCallback);
+            request->exceptionCallback_ = std::move(exceptionCallback);
+            thisPtr->send(request,
+                          thisPtr->nodeOfSlot(commandSlot(request->command_)),
+                          false);
+        },
+        name,
+        arguments,
+        args,
+        std::move(resultCallback),
+        std::move(exceptionCallback));
+    va_end(args);
+}
+
+void RedisClusterClient::send(const std::shared_ptr<Request> &request,
+                              const std::shared_ptr<RedisClientImpl> &node,
+                              bool asking)
+{
+    std::weak_ptr<RedisClusterClient> weakPtr = shared_from_this();
+    node->execFormattedCommandAsync(
+        std::string{request->command_},
+        [request](const RedisResult &result) {
+            request->resultCallback_(result);
+        },
+        [request, weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+            {
+                if (err.code() == RedisErrorCode::kRedisError &&
+                    request->redirections_ < kMaxRedirections &&
+                    thisPtr->redirect(request, err.what()))
+                    return;
+                if (err.code() == RedisErrorCode::kConnectionBroken)
+                    thisPtr->refreshSlots();
+            }
+            request->exceptionCallback_(err);
+        },
+        asking);
+}
+
+bool RedisClusterClient::redirect(const std::shared_ptr<Request> &request,
+                                  std::string_view error)
+{
+    // MOVED <slot> <host>:<port> or ASK <slot> <host>:<port>
+    bool moved = error.substr(0, 6) == "MOVED ";
+    if (!moved && error.substr(0, 4) != "ASK ")
+        return false;
+    auto slotPos = error.find(' ') + 1;
+    auto addrPos = error.find(' ', slotPos);
+    if (addrPos == std::string_view::npos)
+        return false;
+    auto addr = error.substr(addrPos + 1);
+    auto colon = addr.rfind(':');
+    if (colon == std::string_view::npos)
+        return false;
+    size_t slot = 0;
+    unsigned long port = 0;
+    try
+    {
+        slot =
+            std::stoul(std::string{error.substr(slotPos, addrPos - slotPos)});
+        port = std::stoul(std::string{addr.substr(colon + 1)});
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    if (slot >= kSlotNumber || port == 0 || port > 65535)
+        return false;
+    std::shared_ptr<RedisClientImpl> node;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        node = nodeAt(std::string{addr.substr(0, colon)},
+                      static_cast<unsigned short>(port));
+        if (moved)
+            slots_[slot] = node;
+    }
+    // A moved slot means the map is stale, an asked one is being migrated
+    if (moved)
+        refreshSlots();
+    ++request->redirections_;
+    send(request, node, !moved);
+    return true;
+}
+
+std::shared_ptr<RedisClientImpl> RedisClusterClient::nodeOfSlot(int slot)
+{
+    if (slot >= 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slots_[slot])
+            return slots_[slot];
+    }
+    return anyNode();
+}
+
+std::shared_ptr<RedisClientImpl> RedisClusterClient::anyNode(std::string *host)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(!nodes_.empty());
+    auto iter = nodes_.begin();
+    std::advance(iter, nextNode_++ % nodes_.size());
+    if (host)
+        *host = iter->first.substr(0, iter->first.rfind(':'));
+    return iter->second;
+}
+
+std::shared_ptr<RedisClientImpl> RedisClusterClient::nodeAt(
+    const std::string &host,
+    unsigned short port)
+{
+    auto name = host + ":" + std::to_string(port);
+    auto &node = nodes_[name];
+    if (!node)
+    {
+        LOG_DEBUG << "New Redis Cluster node " << name;
+        node = std::make_shared<RedisClientImpl>(
+            trantor::InetAddress(host, port),
+            connectionsPerNode_,
+            username_,
+            password_);
+        if (timeout_ > 0.0)
+            node->setTimeout(timeout_);
+        node->init();
+        for (auto &script : scripts_.scripts())
+        {
+            node->registerScript(script.first, script.second);
+        }
+    }
+    return node;
+}
+
+void RedisClusterClient::refreshSlots()
+{
+    if (refreshing_.exchange(true))
+        return;
+    std::string host;
+    auto node = anyNode(&host);
+    std::weak_ptr<RedisClusterClient> weakPtr = shared_from_this();
+    node->execCommandAsync(
+        [weakPtr, host](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->applySlots(result, host);
+            thisPtr->refreshing_ = false;
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            LOG_WARN << "Failed to load the Redis Cluster slots: "
+                     << err.what();
+            thisPtr->refreshing_ = false;
+        },
+        "CLUSTER SLOTS");
+}
+
+void RedisClusterClient::applySlots(const RedisResult &result,
+                                    const std::string &queriedHost)
+{
+    // Every element is [start, end, [host, port, id], replicas...]
+    try
+    {
+        std::vector<std::pair<std::pair<long long, long long>,
+                              std::pair<std::string, unsigned short>>>
+            ranges;
+        for (auto const &range : result.asArray())
+        {
+            auto fields = range.asArray();
+            if (fields.size() < 3)
+                continue;
+            auto primary = fields[2].asArray();
+            if (primary.size() < 2)
+                continue;
+            auto host = primary[0].asString();
+            // An unknown address is the one of the queried node
+            if (host.empty() || host == "?")
+                host = queriedHost;
+            ranges.push_back(
+                {{fields[0].asInteger(), fields[1].asInteger()},
+                 {std::move(host),
+                  static_cast<unsigned short>(primary[1].asInteger())}});
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto const &range : ranges)
+        {
+            auto node = nodeAt(range.second.first, range.second.second);
+            auto start = (std::max)(range.first.first, 0LL);
+            auto end = (std::min)(range.first.second,
+                                  static_cast<long long>(kSlotNumber) - 1);
+            for (auto slot = start; slot <= end; ++slot)
+            {
+                slots_[slot] = node;
+            }
+        }
+    }
+    catch (const RedisException &err)
+    {
+        LOG_WARN << "Bad CLUSTER SLOTS reply: " << err.what();
+    }
+}
+
+std::shared_ptr<RedisSubscriber> RedisClusterClient::newSubscriber() noexcept
+{
+    // Messages are propagated to all the nodes of a cluster
+    return anyNode()->newSubscriber();
+}
+
+std::shared_ptr<RedisSubscriber> RedisClusterClient::newSharedSubscriber()
+    noexcept
+{
+    std::shared_ptr<RedisSubscriberHub> hub;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hub = subscriberHub_;
+    }
+    if (!hub)
+    {
+        auto subscriber = newSubscriber();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!subscriberHub_)
+        {
+            subscriberHub_ = std::make_shared<RedisSubscriberHub>(subscriber);
+        }
+        hub = subscriberHub_;
+    }
+    return std::make_shared<RedisSharedSubscriber>(hub);
+}
+
+RedisTransactionPtr RedisClusterClient::newTransaction() noexcept(false)
+{
+    return std::make_shared<RedisClusterTransaction>(shared_from_this());
+}
+
+void RedisClusterClient::newTransactionAsync(
+    const std::function<void(const RedisTransactionPtr &)> &callback)
+{
+    callback(newTransaction());
+}
+
+void RedisClusterClient::setTimeout(double timeout)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_ = timeout;
+    for (auto &node : nodes_)
+    {
+        node.second->setTimeout(timeout);
+    }
+}
+
+void RedisClusterClient::closeAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &node : nodes_)
+    {
+        node.second->closeAll();
+    }
+}
+
+void RedisClusterTransaction::execCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    std::string_view command,
+    ...) noexcept
+{
+    LOG_TRACE << "redis command: " << command;
+    std::string formattedCmd;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCmd = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    execFormattedCommandAsync(std::move(formattedCmd),
+                              std::move(resultCallback),
+                              std::move(exceptionCallback));
+}
+
+void RedisClusterTransaction::execFormattedCommandAsync(
+    std::string &&command,
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback) noexcept
+{
+    auto slot = RedisClusterClient::commandSlot(command);
+    send(std::move(command),
+         slot,
+         false,
+         std::move(resultCallback),
+         std::move(exceptionCallback));
+}
+
+void RedisClusterTransaction::execute(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback)
+{
+    send(std::string{"*1\r\n$4\r\nEXEC\r\n"},
+         -1,
+         true,
+         std::move(resultCallback),
+         std::move(exceptionCallback));
+}
+
+void RedisClusterTransaction::send(std::string &&command,
+                                   int slot,
+                                   bool bindNow,
+                                   RedisResultCallback &&resultCallback,
+                                   RedisExceptionCallback &&exceptionCallback)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (slot >= 0)
+    {
+        if (slot_ < 0 && !binding_ && !transaction_)
+        {
+            slot_ = slot;
+        }
+        else if (slot != slot_)
+        {
+            lock.unlock();
+            exceptionCallback(RedisException(
+                RedisErrorCode::kRedisError,
+                "CROSSSLOT Keys in request don't hash to the same slot"));
+            return;
+        }
+    }
+    if (transaction_)
+    {
+        auto transaction = transaction_;
+        lock.unlock();
+        transaction->execFormattedCommandAsync(std::move(command),
+                                               std::move(resultCallback),
+                                               std::move(exceptionCallback));
+        return;
+    }
+    pending_.push_back({std::move(command),
+                        std::move(resultCallback),
+                        std::move(exceptionCallback)});
+    // Commands without a key wait for the first one with a key
+    if (binding_ || (slot_ < 0 && !bindNow))
+        return;
+    binding_ = true;
+    auto bindSlot = slot_;
+    lock.unlock();
+    bind(bindSlot);
+}
+
+void RedisClusterTransaction::bind(int slot)
+{
+    std::weak_ptr<RedisClusterTransaction> weakPtr = shared_from_this();
+    client_->nodeOfSlot(slot)->newTransactionAsync(
+        [weakPtr](const RedisTransactionPtr &transPtr) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            auto transaction =
+                std::static_pointer_cast<RedisTransactionImpl>(transPtr);
+            if (transaction)
+                transaction->setTimeout(thisPtr->timeout_);
+            // The commands sent meanwhile are appended to pending_, the
+            // transaction is published once they are all flushed in order.
+            for (;;)
+            {
+                std::vector<Command> commands;
+                {
+                    std::lock_guard<std::mutex> lock(thisPtr->mutex_);
+                    if (thisPtr->pending_.empty())
+                    {
+                        thisPtr->transaction_ = transaction;
+                        thisPtr->binding_ = false;
+                        if (!transaction)
+                            thisPtr->slot_ = -1;
+                        return;
+                    }
+                    commands.swap(thisPtr->pending_);
+                }
+                for (auto &cmd : commands)
+                {
+                    if (transaction)
+                    {
+                        transaction->execFormattedCommandAsync(
+                            std::move(cmd.command_),
+                            std::move(cmd.resultCallback_),
+                            std::move(cmd.exceptionCallback_));
+                    }
+                    else
+                    {
+                        cmd.exceptionCallback_(RedisException(
+                            RedisErrorCode::kTimeout,
+                            "Timeout, no connection available for "
+                            "transaction"));
+                    }
+                }
+            }
+        });
+}
@@ -0,0 +1,214 @@
+/**
+ *
+ *  @file RedisClusterClient.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include "RedisScriptRegistry.h"
+#include <drogon/nosql/RedisClient.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+class RedisClientImpl;
+class RedisSubscriberHub;
+class RedisTransactionImpl;
+
+/**
+ * @brief Sends every command to the Redis Cluster node serving the hash slot
+ * of its key, through a connection pool per node.
+ *
+ * The slot map is loaded by CLUSTER SLOTS and refreshed in the background,
+ * MOVED and ASK redirections are followed transparently.
+ */
+class RedisClusterClient final
+    : public RedisClient,
+      public trantor::NonCopyable,
+      public std::enable_shared_from_this<RedisClusterClient>
+{
+  public:
+    static constexpr size_t kSlotNumber{16384};
+
+    RedisClusterClient(const std::vector<trantor::InetAddress> &seedNodes,
+                       size_t connectionsPerNode,
+                       std::string username,
+                       std::string password);
+    ~RedisClusterClient() override;
+
+    /// Load the slot map and start its periodic refresh
+    void init();
+
+    void execCommandAsync(RedisResultCallback &&resultCallback,
+                          RedisExceptionCallback &&exceptionCallback,
+                          std::string_view command,
+                          ...) noexcept override;
+    void execFormattedCommandAsync(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback) noexcept override;
+    std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override;
+    std::shared_ptr<RedisSubscriber> newSharedSubscriber() noexcept override;
+    std::shared_ptr<RedisPipeline> newPipeline() noexcept override;
+    std::shared_ptr<RedisScanner> newScanner(
+        const RedisScanOptions &options) override;
+    std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig &config,
+        RedisStreamBatchCallback &&batchCallback,
+        trantor::EventLoop *loop) override;
+    void registerScript(const std::string &name,
+                        const std::string &source) override;
+    void execScriptAsync(RedisResultCallback &&resultCallback,
+                         RedisExceptionCallback &&exceptionCallback,
+                         const std::string &name,
+                         std::string_view arguments,
+                         ...) noexcept override;
+    RedisTransactionPtr newTransaction() noexcept(false) override;
+    void newTransactionAsync(
+        const std::function<void(const RedisTransactionPtr &)> &callback)
+        override;
+    void setTimeout(double timeout) override;
+    void closeAll() override;
+
+    /// The node serving the slot, or any node if the slot is unknown or -1
+    std::shared_ptr<RedisClientImpl> nodeOfSlot(int slot);
+
+    /// The hash slot of a key, only the {hash tag} is hashed if there is one
+    static uint16_t keySlot(std::string_view key);
+
+    /// The hash slot of the key of a formatted command, -1 if it has no key
+    static int commandSlot(std::string_view formattedCommand);
+
+  private:
+    struct Request
+    {
+        std::string command_;
+        RedisResultCallback resultCallback_;
+        RedisExceptionCallback exceptionCallback_;
+        int redirections_{0};
+    };
+
+    void send(const std::shared_ptr<Request> &request,
+              const std::shared_ptr<RedisClientImpl> &node,
+              bool asking);
+    bool redirect(const std::shared_ptr<Request> &request,
+                  std::string_view error);
+    void refreshSlots();
+    void applySlots(const RedisResult &result, const std::string &queriedHost);
+    std::shared_ptr<RedisClientImpl> anyNode(std::string *host = nullptr);
+    // Must be called with mutex_ held
+    std::shared_ptr<RedisClientImpl> nodeAt(const std::string &host,
+                                            unsigned short port);
+
+    const size_t connectionsPerNode_;
+    const std::string username_;
+    const std::string password_;
+    std::mutex mutex_;
+    // Keyed by "host:port"
+    std::unordered_map<std::string, std::shared_ptr<RedisClientImpl>> nodes_;
+    std::vector<std::shared_ptr<RedisClientImpl>> slots_;
+    std::shared_ptr<RedisSubscriberHub> subscriberHub_;
+    // Also registered in every node, which loads them on its connections
+    RedisScriptRegistry scripts_;
+    size_t nextNode_{0};
+    double timeout_{-1.0};
+    std::atomic<bool> refreshing_{false};
+    trantor::EventLoopThread refreshThread_{"RedisClusterRefresh"};
+    trantor::TimerId refreshTimer_{0};
+};
+
+/**
+ * @brief A transaction of a cluster client, bound to the node of the slot of
+ * its first command with a key. Commands of other slots fail with CROSSSLOT.
+ */
+class RedisClusterTransaction final
+    : public RedisTransaction,
+      public std::enable_shared_from_this<RedisClusterTransaction>
+{
+  public:
+    explicit RedisClusterTransaction(std::shared_ptr<RedisClusterClient> client)
+        : client_(std::move(client))
+    {
+    }
+
+    void execute(RedisResultCallback &&resultCallback,
+                 RedisExceptionCallback &&exceptionCallback) override;
+    void execCommandAsync(RedisResultCallback &&resultCallback,
+                          RedisExceptionCallback &&exceptionCallback,
+                          std::string_view command,
+                          ...) noexcept override;
+    void execFormattedCommandAsync(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback) noexcept override;
+
+    std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override
+    {
+        LOG_ERROR << "You can't create subscriber from redis transaction";
+        assert(0);
+        return nullptr;
+    }
+
+    std::shared_ptr<RedisTransaction> newTransaction() override
+    {
+        return shared_from_this();
+    }
+
+    void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<RedisTransaction> &)>
+            &callback) override
+    {
+        callback(shared_from_this());
+    }
+
+    void setTimeout(double timeout) override
+    {
+        timeout_ = timeout;
+    }
+
+  private:
+    struct Command
+    {
+        std::string command_;
+        RedisResultCallback resultCallback_;
+        RedisExceptionCallback exceptionCallback_;
+    };
+
+    void send(std::string &&command,
+              int slot,
+              bool bindNow,
+              RedisResultCallback &&resultCallback,
+              RedisExceptionCallback &&exceptionCallback);
+    void bind(int slot);
+
+    std::shared_ptr<RedisClusterClient> client_;
+    std::mutex mutex_;
+    int slot_{-1};
+    bool binding_{false};
+    std::shared_ptr<RedisTransactionImpl> transaction_;
+    // The commands sent before the transaction of the node is ready
+    std::vector<Command> pending_;
+    double timeout_{-1.0};
+};
+
+}  // namespace nosql
+}  // namespace drogon
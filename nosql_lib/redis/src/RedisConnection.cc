@@ -13,6 +13,7 @@
  */
 
 #include "RedisConnection.h"
+#include "../../lib/src/Tracing.h"
 #include <drogon/nosql/RedisResult.h>
 #include <future>
 #include <string.h>
@@ -253,6 +254,8 @@ void RedisConnection::handleDisconnect()
         resultCallbacks_.pop();
         exceptionCallbacks_.pop();
     }
+    unansweredCommands_.store(resultCallbacks_.size(),
+                              std::memory_order_relaxed);
     status_ = ConnectStatus::kEnd;
     channel_->disableAll();
     channel_->remove();
@@ -268,7 +271,9 @@ void RedisConnection::addWrite(void *userData)
 {
     auto thisPtr = static_cast<RedisConnection *>(userData);
     assert(thisPtr->channel_);
-    thisPtr->channel_->enableWriting();
+    // hiredis asks for every command, the poller is only updated once
+    if (!thisPtr->channel_->isWriting())
+        thisPtr->channel_->enableWriting();
 }
 
 void RedisConnection::delWrite(void *userData)
@@ -320,6 +325,8 @@ void RedisConnection::sendCommandInLoop(
 {
     resultCallbacks_.emplace(std::move(resultCallback));
     exceptionCallbacks_.emplace(std::move(exceptionCallback));
+    unansweredCommands_.store(resultCallbacks_.size(),
+                              std::memory_order_relaxed);
 
     redisAsyncFormattedCommand(
         redisContext_,
@@ -332,12 +339,54 @@ void RedisConnection::sendCommandInLoop(
         command.length());
 }
 
+void RedisConnection::queueCommands(std::vector<RedisCommand> &&commands)
+{
+    bool flush{false};
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (pendingCommands_.empty())
+        {
+            flush = true;
+            pendingCommands_ = std::move(commands);
+        }
+        else
+        {
+            for (auto &cmd : commands)
+            {
+                pendingCommands_.emplace_back(std::move(cmd));
+            }
+        }
+    }
+    // Only the first command wakes the loop up, the following ones ride along
+    if (flush)
+    {
+        loop_->queueInLoop([this]() { flushPendingCommands(); });
+    }
+}
+
+void RedisConnection::flushPendingCommands()
+{
+    std::vector<RedisCommand> commands;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        commands.swap(pendingCommands_);
+    }
+    for (auto &cmd : commands)
+    {
+        sendCommandInLoop(cmd.command_,
+                          std::move(cmd.resultCallback_),
+                          std::move(cmd.exceptionCallback_));
+    }
+}
+
 void RedisConnection::handleResult(redisReply *result)
 {
     auto commandCallback = std::move(resultCallbacks_.front());
     resultCallbacks_.pop();
     auto exceptionCallback = std::move(exceptionCallbacks_.front());
     exceptionCallbacks_.pop();
+    unansweredCommands_.store(resultCallbacks_.size(),
+                              std::memory_order_relaxed);
     if (result && result->type != REDIS_REPLY_ERROR)
     {
         commandCallback(RedisResult(result));
@@ -459,19 +508,35 @@ void RedisConnection::handleSubscribeResult(redisReply *result,
         {
             std::string channel(result->element[1 + isPattern]->str,
                                 result->element[1 + isPattern]->len);
-            std::string message(result->element[2 + isPattern]->str,
-                                result->element[2 + isPattern]->len);
+            auto payload = result->element[2 + isPattern];
             if (!subCtx->alive())
             {
                 LOG_DEBUG << "Subscribe callback receive message, but "
                              "context is no "
                              "longer alive"
-                          << ", channel: " << channel
-                          << ", message: " << message;
+                          << ", channel: " << channel;
+            }
+            else if (payload->type == REDIS_REPLY_ARRAY)
+            {
+                // The invalidation messages of client tracking carry an
+                // array of keys, each key is delivered as a message.
+                for (size_t i = 0; i < payload->elements; ++i)
+                {
+                    auto key = payload->element[i];
+                    subCtx->onMessage(channel,
+                                      key->str ? std::string(key->str, key->len)
+                                               : std::string());
+                }
+            }
+            else if (payload->type == REDIS_REPLY_NIL)
+            {
+                // A flush of the tracked keys
+                subCtx->onMessage(channel, std::string());
             }
             else
             {
-                subCtx->onMessage(channel, message);
+                subCtx->onMessage(channel,
+                                  std::string(payload->str, payload->len));
             }
             // Message callback, no need to call idleCallback_
             return;
@@ -520,3 +585,41 @@ void RedisConnection::handleSubscribeResult(redisReply *result,
         idleCallback_(shared_from_this());
     }
 }
+
+std::string_view RedisConnection::getCommandName(std::string_view command)
+{
+    // *<number of arguments>\r\n$<length>\r\n<name>\r\n...
+    auto pos = command.find("\r\n$");
+    if (pos == std::string_view::npos)
+        return {};
+    pos = command.find("\r\n", pos + 3);
+    if (pos == std::string_view::npos)
+        return {};
+    pos += 2;
+    return command.substr(pos, command.find("\r\n", pos) - pos);
+}
+
+void RedisConnection::traceCommand(std::string_view name,
+                                   RedisResultCallback &resultCallback,
+                                   RedisExceptionCallback &exceptionCallback)
+{
+    auto span = drogon::Tracing::instance().startClientSpan({});
+    if (!span)
+        return;
+    span->name = name;
+    span->attributes.emplace_back("db.system", "redis");
+    span->attributes.emplace_back("db.operation.name", std::string(name));
+    resultCallback = [span, resultCallback = std::move(resultCallback)](
+                         const RedisResult &result) {
+        drogon::Tracing::instance().endClientSpan(span, false);
+        if (resultCallback)
+            resultCallback(result);
+    };
+    exceptionCallback = [span,
+                         exceptionCallback = std::move(exceptionCallback)](
+                            const RedisException &err) {
+        drogon::Tracing::instance().endClientSpan(span, true);
+        if (exceptionCallback)
+            exceptionCallback(err);
+    };
+}
@@ -14,6 +14,7 @@
 
 #pragma once
 #include <string_view>
+#include <drogon/nosql/RedisCommandFormat.h>
 #include <drogon/nosql/RedisException.h>
 #include <drogon/nosql/RedisResult.h>
 #include <drogon/utils/Utilities.h>
@@ -23,8 +24,11 @@
 #include <trantor/net/Channel.h>
 #include <hiredis/async.h>
 #include <hiredis/hiredis.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <vector>
 
 #include "SubscribeContext.h"
 
@@ -40,6 +44,14 @@ enum class ConnectStatus
     kEnd
 };
 
+/// A command formatted by RedisConnection::getFormattedCommand()
+struct RedisCommand
+{
+    std::string command_;
+    RedisResultCallback resultCallback_;
+    RedisExceptionCallback exceptionCallback_;
+};
+
 class RedisConnection : public trantor::NonCopyable,
                         public std::enable_shared_from_this<RedisConnection>
 {
@@ -96,6 +108,23 @@ class RedisConnection : public trantor::NonCopyable,
         return fullCommand;
     }
 
+    /// The name of a command formatted in RESP, e.g. "GET"
+    static std::string_view getCommandName(std::string_view command);
+
+    /**
+     * @brief Make the command a child span of the trace of the current
+     * thread, see drogon::Tracing.
+     */
+    static void traceCommand(std::string_view name,
+                             RedisResultCallback &resultCallback,
+                             RedisExceptionCallback &exceptionCallback);
+
+    /// Format a command of any number of arguments, e.g. XACK with its ids
+    static std::string formatCommand(const std::vector<std::string_view> &argv)
+    {
+        return formatRedisCommand(argv);
+    }
+
     void sendFormattedCommand(std::string &&command,
                               RedisResultCallback &&resultCallback,
                               RedisExceptionCallback &&exceptionCallback)
@@ -108,15 +137,32 @@ class RedisConnection : public trantor::NonCopyable,
         }
         else
         {
-            loop_->queueInLoop(
-                [this,
-                 callback = std::move(resultCallback),
-                 exceptionCallback = std::move(exceptionCallback),
-                 command = std::move(command)]() mutable {
-                    sendCommandInLoop(command,
-                                      std::move(callback),
-                                      std::move(exceptionCallback));
-                });
+            std::vector<RedisCommand> commands;
+            commands.push_back({std::move(command),
+                                std::move(resultCallback),
+                                std::move(exceptionCallback)});
+            queueCommands(std::move(commands));
+        }
+    }
+
+    /**
+     * @brief Send the commands in order, they are written to the socket
+     * together with the other commands sent in the same loop iteration.
+     */
+    void sendFormattedCommands(std::vector<RedisCommand> &&commands)
+    {
+        if (loop_->isInLoopThread())
+        {
+            for (auto &cmd : commands)
+            {
+                sendCommandInLoop(cmd.command_,
+                                  std::move(cmd.resultCallback_),
+                                  std::move(cmd.exceptionCallback_));
+            }
+        }
+        else
+        {
+            queueCommands(std::move(commands));
         }
     }
 
@@ -137,15 +183,11 @@ class RedisConnection : public trantor::NonCopyable,
             }
             else
             {
-                loop_->queueInLoop(
-                    [this,
-                     callback = std::move(resultCallback),
-                     exceptionCallback = std::move(exceptionCallback),
-                     fullCommand = std::move(fullCommand)]() mutable {
-                        sendCommandInLoop(fullCommand,
-                                          std::move(callback),
-                                          std::move(exceptionCallback));
-                    });
+                std::vector<RedisCommand> commands;
+                commands.push_back({std::move(fullCommand),
+                                    std::move(resultCallback),
+                                    std::move(exceptionCallback)});
+                queueCommands(std::move(commands));
             }
         }
         catch (const RedisException &err)
@@ -185,6 +227,12 @@ class RedisConnection : public trantor::NonCopyable,
         return loop_;
     }
 
+    /// The commands sent and not answered yet, read from any thread
+    size_t unansweredCommands() const
+    {
+        return unansweredCommands_.load(std::memory_order_relaxed);
+    }
+
   private:
     redisAsyncContext *redisContext_{nullptr};
     const trantor::InetAddress serverAddr_;
@@ -199,6 +247,11 @@ class RedisConnection : public trantor::NonCopyable,
     std::function<void(const std::shared_ptr<RedisConnection> &)> idleCallback_;
     std::queue<RedisResultCallback> resultCallbacks_;
     std::queue<RedisExceptionCallback> exceptionCallbacks_;
+    // The size of the queues, mirrored for the readers of other threads
+    std::atomic<size_t> unansweredCommands_{0};
+    // The commands sent from other threads, flushed by one queued functor
+    std::mutex pendingMutex_;
+    std::vector<RedisCommand> pendingCommands_;
     ConnectStatus status_{ConnectStatus::kNone};
 
     // used to keep the lifetime of context object
@@ -217,6 +270,8 @@ class RedisConnection : public trantor::NonCopyable,
     void sendCommandInLoop(const std::string &command,
                            RedisResultCallback &&resultCallback,
                            RedisExceptionCallback &&exceptionCallback);
+    void queueCommands(std::vector<RedisCommand> &&commands);
+    void flushPendingCommands();
     void sendSubscribeInLoop(const std::shared_ptr<SubscribeContext> &subCtx);
     void sendUnsubscribeInLoop(const std::shared_ptr<SubscribeContext> &subCtx);
     void handleSubscribeResult(redisReply *result, SubscribeContext *subCtx);
@@ -0,0 +1,199 @@
+/**
+ *
+ *  @file RedisNearCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisNearCache.h"
+#include "RedisReplyCopy.h"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+
+using namespace drogon::nosql;
+
+namespace
+{
+// Parse "<prefix><number>\r\n" at pos, -1 on a malformed command
+long long parseNumber(std::string_view cmd, size_t &pos, char prefix)
+{
+    if (pos >= cmd.size() || cmd[pos] != prefix)
+        return -1;
+    auto end = cmd.find("\r\n", ++pos);
+    if (end == std::string_view::npos || end == pos)
+        return -1;
+    long long value = 0;
+    for (; pos < end; ++pos)
+    {
+        if (!isdigit(static_cast<unsigned char>(cmd[pos])))
+            return -1;
+        value = value * 10 + (cmd[pos] - '0');
+    }
+    pos = end + 2;
+    return value;
+}
+
+bool parseBulk(std::string_view cmd, size_t &pos, std::string_view &bulk)
+{
+    auto len = parseNumber(cmd, pos, '$');
+    if (len < 0 || pos + static_cast<size_t>(len) + 2 > cmd.size())
+        return false;
+    bulk = cmd.substr(pos, static_cast<size_t>(len));
+    pos += static_cast<size_t>(len) + 2;
+    return true;
+}
+
+std::string_view keyOf(std::string_view cacheKey)
+{
+    return cacheKey.substr(cacheKey.find('\n') + 1);
+}
+}  // namespace
+
+std::string RedisNearCache::trackingCommand(long long clientId) const
+{
+    std::vector<std::string> argv{"CLIENT",
+                                  "TRACKING",
+                                  "on",
+                                  "REDIRECT",
+                                  std::to_string(clientId),
+                                  "BCAST"};
+    for (auto &prefix : keyPrefixes_)
+    {
+        argv.emplace_back("PREFIX");
+        argv.emplace_back(prefix);
+    }
+    std::string command = "*" + std::to_string(argv.size()) + "\r\n";
+    for (auto &arg : argv)
+    {
+        command.append("$")
+            .append(std::to_string(arg.size()))
+            .append("\r\n")
+            .append(arg)
+            .append("\r\n");
+    }
+    return command;
+}
+
+std::string RedisNearCache::cacheKeyOf(std::string_view formattedCommand) const
+{
+    size_t pos = 0;
+    std::string_view name, key;
+    if (parseNumber(formattedCommand, pos, '*') != 2 ||
+        !parseBulk(formattedCommand, pos, name) ||
+        !parseBulk(formattedCommand, pos, key))
+        return {};
+    std::string cacheKey(name);
+    std::transform(cacheKey.begin(),
+                   cacheKey.end(),
+                   cacheKey.begin(),
+                   [](unsigned char c) { return toupper(c); });
+    if (cacheKey != "GET" && cacheKey != "HGETALL")
+        return {};
+    if (!keyPrefixes_.empty() &&
+        std::none_of(keyPrefixes_.begin(),
+                     keyPrefixes_.end(),
+                     [key](const std::string &prefix) {
+                         return key.substr(0, prefix.size()) == prefix;
+                     }))
+        return {};
+    cacheKey.append("\n").append(key);
+    return cacheKey;
+}
+
+bool RedisNearCache::lookup(const std::string &cacheKey,
+                            const RedisResultCallback &callback)
+{
+    std::shared_ptr<redisReply> reply;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_)
+            return false;
+        auto iter = map_.find(cacheKey);
+        if (iter == map_.end())
+            return false;
+        lru_.splice(lru_.begin(), lru_, iter->second);
+        reply = iter->second->second.reply_;
+    }
+    callback(RedisResult(reply.get()));
+    return true;
+}
+
+RedisNearCache::Ticket RedisNearCache::ticketOf(const std::string &cacheKey)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {active_ ? epoch_ : ~uint64_t(0), generationOf(keyOf(cacheKey))};
+}
+
+void RedisNearCache::store(const std::string &cacheKey,
+                           const RedisResult &result,
+                           const Ticket &ticket)
+{
+    auto reply = RedisReplyCopy::copy(result);
+    auto bytes = cacheKey.size() + RedisReplyCopy::sizeOf(reply.get());
+    if (bytes > maxBytes_)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_ || ticket.epoch_ != epoch_ ||
+        ticket.generation_ != generationOf(keyOf(cacheKey)))
+        return;
+    erase(cacheKey);
+    lru_.emplace_front(cacheKey, Entry{std::move(reply), bytes});
+    map_.emplace(lru_.front().first, lru_.begin());
+    bytes_ += bytes;
+    while (bytes_ > maxBytes_)
+    {
+        erase(lru_.back().first);
+    }
+}
+
+void RedisNearCache::invalidate(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (key.empty())
+    {
+        clear();
+        return;
+    }
+    ++generationOf(key);
+    erase("GET\n" + key);
+    erase("HGETALL\n" + key);
+}
+
+void RedisNearCache::setActive(bool active)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = active;
+    clear();
+}
+
+void RedisNearCache::erase(const std::string &cacheKey)
+{
+    auto iter = map_.find(cacheKey);
+    if (iter == map_.end())
+        return;
+    auto entry = iter->second;
+    bytes_ -= entry->second.bytes_;
+    map_.erase(iter);
+    lru_.erase(entry);
+}
+
+void RedisNearCache::clear()
+{
+    ++epoch_;
+    map_.clear();
+    lru_.clear();
+    bytes_ = 0;
+}
+
+uint64_t &RedisNearCache::generationOf(std::string_view key)
+{
+    return generations_[std::hash<std::string_view>{}(key) %
+                        kGenerationBuckets];
+}
@@ -0,0 +1,112 @@
+/**
+ *
+ *  @file RedisNearCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/nosql/RedisResult.h>
+#include <trantor/utils/NonCopyable.h>
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief The replies of GET and HGETALL on the tracked keys, kept coherent by
+ * the invalidation messages of client tracking in broadcasting mode.
+ *
+ * The cache only serves replies while the invalidation channel is subscribed,
+ * it is flushed whenever the tracking connection is lost.
+ */
+class RedisNearCache : public trantor::NonCopyable
+{
+  public:
+    static constexpr const char *kInvalidationChannel{"__redis__:invalidate"};
+
+    /// The generations of a key when its command was sent
+    struct Ticket
+    {
+        uint64_t epoch_;
+        uint64_t generation_;
+    };
+
+    RedisNearCache(std::vector<std::string> keyPrefixes, size_t maxBytes)
+        : keyPrefixes_(std::move(keyPrefixes)), maxBytes_(maxBytes)
+    {
+    }
+
+    /// The CLIENT TRACKING command redirecting the invalidations to a client
+    std::string trackingCommand(long long clientId) const;
+
+    /**
+     * @brief The cache key of a formatted GET or HGETALL command on a
+     * tracked key, empty if the command isn't cached.
+     */
+    std::string cacheKeyOf(std::string_view formattedCommand) const;
+
+    /// Call the callback with the cached reply, false on a miss
+    bool lookup(const std::string &cacheKey,
+                const RedisResultCallback &callback);
+
+    Ticket ticketOf(const std::string &cacheKey);
+
+    /// Store the reply unless its key was invalidated since the ticket
+    void store(const std::string &cacheKey,
+               const RedisResult &result,
+               const Ticket &ticket);
+
+    /// The message of the invalidation channel, an empty key flushes all
+    void invalidate(const std::string &key);
+
+    /// Start or stop serving the replies, both flush the cache
+    void setActive(bool active);
+
+  private:
+    struct Entry
+    {
+        std::shared_ptr<redisReply> reply_;
+        size_t bytes_;
+    };
+
+    using LruList = std::list<std::pair<std::string, Entry>>;
+
+    static constexpr size_t kGenerationBuckets{256};
+
+    // Must be called with mutex_ held
+    void erase(const std::string &cacheKey);
+    void clear();
+    uint64_t &generationOf(std::string_view key);
+
+    const std::vector<std::string> keyPrefixes_;
+    const size_t maxBytes_;
+    std::mutex mutex_;
+    bool active_{false};
+    // The most recently used reply is at the front
+    LruList lru_;
+    std::unordered_map<std::string_view, LruList::iterator> map_;
+    size_t bytes_{0};
+    // Bumped by a flush and by the invalidations of the keys hashed to a
+    // bucket, a reply is only stored if neither moved while it was queried.
+    uint64_t epoch_{0};
+    std::array<uint64_t, kGenerationBuckets> generations_{};
+};
+
+}  // namespace nosql
+}  // namespace drogon
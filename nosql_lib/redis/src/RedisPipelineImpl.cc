@@ -0,0 +1,135 @@
+/**
+ *
+ *  @file RedisPipelineImpl.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisPipelineImpl.h"
+#include "RedisReplyCopy.h"
+#include "../../lib/src/TaskTimeoutFlag.h"
+#include <atomic>
+#include <cstdarg>
+#include <memory>
+
+using namespace drogon::nosql;
+
+namespace
+{
+struct Execution
+{
+    Execution(size_t size,
+              RedisPipelineCallback &&resultCallback,
+              RedisExceptionCallback &&exceptionCallback)
+        : replies_(size),
+          remaining_(size),
+          resultCallback_(std::move(resultCallback)),
+          exceptionCallback_(std::move(exceptionCallback))
+    {
+    }
+
+    // Every slot is written by the callback of its command only
+    std::vector<std::shared_ptr<redisReply>> replies_;
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> finished_{false};
+    RedisPipelineCallback resultCallback_;
+    RedisExceptionCallback exceptionCallback_;
+
+    void fail(const RedisException &err)
+    {
+        if (!finished_.exchange(true) && exceptionCallback_)
+        {
+            exceptionCallback_(err);
+        }
+    }
+
+    void arrive()
+    {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1 ||
+            finished_.exchange(true))
+        {
+            return;
+        }
+        std::vector<RedisResult> results;
+        results.reserve(replies_.size());
+        for (auto &reply : replies_)
+        {
+            results.emplace_back(reply.get());
+        }
+        if (resultCallback_)
+        {
+            resultCallback_(results);
+        }
+        replies_.clear();
+    }
+};
+}  // namespace
+
+RedisPipeline &RedisPipeline::add(std::string_view command,
+                                  ...) noexcept(false)
+{
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        commands_.emplace_back(
+            RedisConnection::getFormattedCommand(command, args));
+    }
+    catch (...)
+    {
+        va_end(args);
+        throw;
+    }
+    va_end(args);
+    return *this;
+}
+
+void RedisPipelineImpl::execute(RedisPipelineCallback &&resultCallback,
+                                RedisExceptionCallback &&exceptionCallback)
+{
+    if (commands_.empty())
+    {
+        resultCallback({});
+        return;
+    }
+    auto execution = std::make_shared<Execution>(commands_.size(),
+                                                 std::move(resultCallback),
+                                                 std::move(exceptionCallback));
+    std::vector<RedisCommand> commands;
+    commands.reserve(commands_.size());
+    for (size_t i = 0; i < commands_.size(); ++i)
+    {
+        commands.push_back(
+            {std::move(commands_[i]),
+             [execution, i](const RedisResult &result) {
+                 execution->replies_[i] = RedisReplyCopy::copy(result);
+                 execution->arrive();
+             },
+             [execution, i](const RedisException &err) {
+                 if (err.code() != RedisErrorCode::kRedisError)
+                 {
+                     execution->fail(err);
+                     return;
+                 }
+                 execution->replies_[i] = RedisReplyCopy::error(err.what());
+                 execution->arrive();
+             }});
+    }
+    commands_.clear();
+    if (timeout_ > 0.0)
+    {
+        auto timeoutFlagPtr = std::make_shared<TaskTimeoutFlag>(
+            loop_, std::chrono::duration<double>(timeout_), [execution]() {
+                execution->fail(RedisException(RedisErrorCode::kTimeout,
+                                               "Command execution timeout"));
+            });
+        timeoutFlagPtr->runTimer();
+    }
+    sender_(std::move(commands));
+}
@@ -0,0 +1,51 @@
+/**
+ *
+ *  @file RedisPipelineImpl.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include "RedisConnection.h"
+#include <drogon/nosql/RedisPipeline.h>
+#include <trantor/net/EventLoop.h>
+#include <functional>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+class RedisPipelineImpl final : public RedisPipeline
+{
+  public:
+    /// Sends the formatted commands of an execution
+    using Sender = std::function<void(std::vector<RedisCommand> &&)>;
+
+    /**
+     * @param loop The loop running the timer of the timeout.
+     * @param timeout The timeout of an execution in seconds, no limit if it
+     * isn't positive.
+     */
+    RedisPipelineImpl(Sender &&sender, trantor::EventLoop *loop, double timeout)
+        : sender_(std::move(sender)), loop_(loop), timeout_(timeout)
+    {
+    }
+
+    void execute(RedisPipelineCallback &&resultCallback,
+                 RedisExceptionCallback &&exceptionCallback) override;
+
+  private:
+    Sender sender_;
+    trantor::EventLoop *loop_;
+    double timeout_;
+};
+
+}  // namespace nosql
+}  // namespace drogon
@@ -0,0 +1,102 @@
+/**
+ *
+ *  @file RedisReplyCopy.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisReplyCopy.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace drogon::nosql;
+
+namespace
+{
+void freeReplyCopy(redisReply *reply)
+{
+    if (!reply)
+        return;
+    for (size_t i = 0; i < reply->elements; ++i)
+    {
+        freeReplyCopy(reply->element[i]);
+    }
+    free(reply->element);
+    free(reply->str);
+    free(reply);
+}
+
+redisReply *copyReply(const redisReply *reply)
+{
+    auto copy = static_cast<redisReply *>(malloc(sizeof(redisReply)));
+    if (!copy)
+        throw std::bad_alloc();
+    // Copies the fields of every hiredis version, then owns the buffers
+    memcpy(copy, reply, sizeof(redisReply));
+    copy->str = nullptr;
+    copy->element = nullptr;
+    copy->elements = 0;
+    std::unique_ptr<redisReply, void (*)(redisReply *)> guard(copy,
+                                                              freeReplyCopy);
+    if (reply->str)
+    {
+        copy->str = static_cast<char *>(malloc(reply->len + 1));
+        if (!copy->str)
+            throw std::bad_alloc();
+        memcpy(copy->str, reply->str, reply->len);
+        copy->str[reply->len] = '\0';
+    }
+    if (reply->element && reply->elements > 0)
+    {
+        copy->element = static_cast<redisReply **>(
+            calloc(reply->elements, sizeof(redisReply *)));
+        if (!copy->element)
+            throw std::bad_alloc();
+        copy->elements = reply->elements;
+        for (size_t i = 0; i < reply->elements; ++i)
+        {
+            copy->element[i] = copyReply(reply->element[i]);
+        }
+    }
+    return guard.release();
+}
+}  // namespace
+
+std::shared_ptr<redisReply> RedisReplyCopy::copy(const RedisResult &result)
+{
+    return std::shared_ptr<redisReply>(copyReply(result.result_),
+                                       freeReplyCopy);
+}
+
+std::shared_ptr<redisReply> RedisReplyCopy::error(const std::string &message)
+{
+    auto reply = static_cast<redisReply *>(calloc(1, sizeof(redisReply)));
+    if (!reply)
+        throw std::bad_alloc();
+    std::shared_ptr<redisReply> ptr(reply, freeReplyCopy);
+    reply->type = REDIS_REPLY_ERROR;
+    reply->str = static_cast<char *>(malloc(message.length() + 1));
+    if (!reply->str)
+        throw std::bad_alloc();
+    memcpy(reply->str, message.c_str(), message.length() + 1);
+    reply->len = message.length();
+    return ptr;
+}
+
+size_t RedisReplyCopy::sizeOf(const redisReply *reply)
+{
+    size_t size = sizeof(redisReply) + reply->len +
+                  reply->elements * sizeof(redisReply *);
+    for (size_t i = 0; i < reply->elements; ++i)
+    {
+        size += sizeOf(reply->element[i]);
+    }
+    return size;
+}
@@ -0,0 +1,41 @@
+/**
+ *
+ *  @file RedisReplyCopy.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/nosql/RedisResult.h>
+#include <hiredis/hiredis.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief Copies of redis replies outliving their callbacks, hiredis frees a
+ * reply as soon as its callback returns.
+ */
+struct RedisReplyCopy
+{
+    /// A deep copy of the reply of the result
+    static std::shared_ptr<redisReply> copy(const RedisResult &result);
+
+    /// An error reply with the message
+    static std::shared_ptr<redisReply> error(const std::string &message);
+
+    /// The approximate memory used by a copy of the reply
+    static size_t sizeOf(const redisReply *reply);
+};
+
+}  // namespace nosql
+}  // namespace drogon
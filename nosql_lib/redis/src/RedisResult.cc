@@ -15,9 +15,29 @@
 #include <drogon/nosql/RedisResult.h>
 #include <drogon/nosql/RedisClient.h>
 #include <hiredis/hiredis.h>
+#include <json/json.h>
+#include <cstdlib>
 
 using namespace drogon::nosql;
 
+namespace
+{
+bool isStringLike(RedisResultType type)
+{
+    return type == RedisResultType::kString ||
+           type == RedisResultType::kStatus ||
+           type == RedisResultType::kError ||
+           type == RedisResultType::kBigNumber ||
+           type == RedisResultType::kVerbatim;
+}
+
+bool isArrayLike(RedisResultType type)
+{
+    return type == RedisResultType::kArray || type == RedisResultType::kSet ||
+           type == RedisResultType::kPush;
+}
+}  // namespace
+
 std::string RedisResult::getStringForDisplaying() const noexcept
 {
     return getStringForDisplayingWithIndent(0);
@@ -38,6 +58,18 @@ std::string RedisResult::getStringForDisplayingWithIndent(
             return "(nil)";
         case REDIS_REPLY_INTEGER:
             return std::to_string(result_->integer);
+#ifdef REDIS_REPLY_MAP
+        case REDIS_REPLY_DOUBLE:
+        case REDIS_REPLY_BIGNUM:
+        case REDIS_REPLY_VERB:
+            return std::string{result_->str, result_->len};
+        case REDIS_REPLY_BOOL:
+            return result_->integer ? "(true)" : "(false)";
+        case REDIS_REPLY_MAP:
+        case REDIS_REPLY_ATTR:
+        case REDIS_REPLY_SET:
+        case REDIS_REPLY_PUSH:
+#endif
         case REDIS_REPLY_ARRAY:
         {
             std::string ret;
@@ -66,8 +98,7 @@ std::string RedisResult::getStringForDisplayingWithIndent(
 std::string RedisResult::asString() const noexcept(false)
 {
     auto rtype = type();
-    if (rtype == RedisResultType::kString ||
-        rtype == RedisResultType::kStatus || rtype == RedisResultType::kError)
+    if (isStringLike(rtype) || rtype == RedisResultType::kDouble)
     {
         return std::string(result_->str, result_->len);
     }
@@ -81,6 +112,16 @@ std::string RedisResult::asString() const noexcept(false)
     }
 }
 
+std::string_view RedisResult::asStringView() const noexcept(false)
+{
+    auto rtype = type();
+    if (isStringLike(rtype) || rtype == RedisResultType::kDouble)
+    {
+        return std::string_view(result_->str, result_->len);
+    }
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
 RedisResultType RedisResult::type() const noexcept
 {
     switch (result_->type)
@@ -95,6 +136,24 @@ RedisResultType RedisResult::type() const noexcept
             return RedisResultType::kNil;
         case REDIS_REPLY_STATUS:
             return RedisResultType::kStatus;
+#ifdef REDIS_REPLY_MAP
+        case REDIS_REPLY_DOUBLE:
+            return RedisResultType::kDouble;
+        case REDIS_REPLY_BOOL:
+            return RedisResultType::kBool;
+        case REDIS_REPLY_MAP:
+            return RedisResultType::kMap;
+        case REDIS_REPLY_SET:
+            return RedisResultType::kSet;
+        case REDIS_REPLY_ATTR:
+            return RedisResultType::kAttribute;
+        case REDIS_REPLY_PUSH:
+            return RedisResultType::kPush;
+        case REDIS_REPLY_BIGNUM:
+            return RedisResultType::kBigNumber;
+        case REDIS_REPLY_VERB:
+            return RedisResultType::kVerbatim;
+#endif
         case REDIS_REPLY_ERROR:
         default:
             return RedisResultType::kError;
@@ -103,10 +162,10 @@ RedisResultType RedisResult::type() const noexcept
 
 std::vector<RedisResult> RedisResult::asArray() const noexcept(false)
 {
-    auto rtype = type();
-    if (rtype == RedisResultType::kArray)
+    if (isArrayLike(type()))
     {
         std::vector<RedisResult> array;
+        array.reserve(result_->elements);
         for (size_t i = 0; i < result_->elements; ++i)
         {
             array.emplace_back(result_->element[i]);
@@ -123,6 +182,107 @@ long long RedisResult::asInteger() const noexcept(false)
     throw RedisException(RedisErrorCode::kBadType, "bad type");
 }
 
+double RedisResult::asDouble() const noexcept(false)
+{
+    auto rtype = type();
+#ifdef REDIS_REPLY_MAP
+    if (rtype == RedisResultType::kDouble)
+        return result_->dval;
+#endif
+    if (rtype == RedisResultType::kInteger)
+        return static_cast<double>(result_->integer);
+    if (rtype == RedisResultType::kString)
+    {
+        // The reply is terminated by hiredis
+        char *end{nullptr};
+        auto value = strtod(result_->str, &end);
+        if (end == result_->str + result_->len && result_->len > 0)
+            return value;
+    }
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
+bool RedisResult::asBool() const noexcept(false)
+{
+    auto rtype = type();
+    if (rtype == RedisResultType::kBool || rtype == RedisResultType::kInteger)
+        return result_->integer != 0;
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
+std::vector<std::pair<RedisResult, RedisResult>> RedisResult::asMap() const
+    noexcept(false)
+{
+    auto rtype = type();
+    if ((rtype == RedisResultType::kMap ||
+         rtype == RedisResultType::kAttribute ||
+         rtype == RedisResultType::kArray) &&
+        result_->elements % 2 == 0)
+    {
+        // hiredis stores the keys and the values of a map alternately
+        std::vector<std::pair<RedisResult, RedisResult>> map;
+        map.reserve(result_->elements / 2);
+        for (size_t i = 0; i < result_->elements; i += 2)
+        {
+            map.emplace_back(RedisResult(result_->element[i]),
+                             RedisResult(result_->element[i + 1]));
+        }
+        return map;
+    }
+    throw RedisException(RedisErrorCode::kBadType, "bad type");
+}
+
+Json::Value RedisResult::asJson() const noexcept(false)
+{
+    switch (type())
+    {
+        case RedisResultType::kInteger:
+            return Json::Value(static_cast<Json::Int64>(result_->integer));
+        case RedisResultType::kBool:
+            return Json::Value(result_->integer != 0);
+        case RedisResultType::kDouble:
+            return Json::Value(asDouble());
+        case RedisResultType::kNil:
+            return Json::Value();
+        case RedisResultType::kArray:
+        case RedisResultType::kSet:
+        case RedisResultType::kPush:
+        {
+            Json::Value array(Json::arrayValue);
+            for (size_t i = 0; i < result_->elements; ++i)
+            {
+                array.append(RedisResult(result_->element[i]).asJson());
+            }
+            return array;
+        }
+        case RedisResultType::kMap:
+        case RedisResultType::kAttribute:
+        {
+            Json::Value object(Json::objectValue);
+            for (size_t i = 0; i + 1 < result_->elements; i += 2)
+            {
+                RedisResult key(result_->element[i]);
+                auto value = RedisResult(result_->element[i + 1]).asJson();
+                if (isStringLike(key.type()))
+                {
+                    auto name = key.asStringView();
+                    object[std::string(name)] = std::move(value);
+                }
+                else
+                {
+                    object[key.getStringForDisplaying()] = std::move(value);
+                }
+            }
+            return object;
+        }
+        default:
+        {
+            auto str = asStringView();
+            return Json::Value(str.data(), str.data() + str.size());
+        }
+    }
+}
+
 bool RedisResult::isNil() const noexcept
 {
     return type() == RedisResultType::kNil;
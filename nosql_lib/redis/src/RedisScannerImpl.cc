@@ -0,0 +1,207 @@
+/**
+ *
+ *  @file RedisScannerImpl.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisScannerImpl.h"
+#include <drogon/nosql/RedisCommandFormat.h>
+
+using namespace drogon::nosql;
+
+RedisScannerImpl::RedisScannerImpl(RedisScanOptions options, Sender sender)
+    : options_(std::move(options)), sender_(std::move(sender))
+{
+}
+
+std::pair<std::string, std::vector<std::string>> RedisScannerImpl::parseReply(
+    const RedisResult &result) noexcept(false)
+{
+    auto reply = result.asArray();
+    if (reply.size() != 2)
+    {
+        throw RedisException(RedisErrorCode::kBadType,
+                             "Bad reply of a SCAN command");
+    }
+    std::pair<std::string, std::vector<std::string>> page;
+    page.first = reply[0].asString();
+    auto elements = reply[1].asArray();
+    page.second.reserve(elements.size());
+    for (auto &element : elements)
+        page.second.push_back(element.asString());
+    return page;
+}
+
+void RedisScannerImpl::nextAsync(RedisScanPageCallback &&pageCallback,
+                                 RedisExceptionCallback &&exceptionCallback)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (lastPassed_)
+    {
+        lock.unlock();
+        pageCallback({}, true);
+        return;
+    }
+    if (error_)
+    {
+        auto error = *error_;
+        lock.unlock();
+        exceptionCallback(error);
+        return;
+    }
+    if (pageCallback_)
+    {
+        lock.unlock();
+        exceptionCallback(RedisException(RedisErrorCode::kInternalError,
+                                         "A page of the scan is awaited"));
+        return;
+    }
+    if (ready_)
+    {
+        auto page = std::move(*ready_);
+        ready_.reset();
+        bool last = finished_;
+        lastPassed_ = last;
+        // Read the next page ahead while this one is processed
+        bool fetchNext = !finished_ && !fetching_;
+        fetching_ = fetching_ || fetchNext;
+        auto cursor = cursor_;
+        lock.unlock();
+        if (fetchNext)
+            fetch(std::move(cursor));
+        pageCallback(std::move(page), last);
+        return;
+    }
+    pageCallback_ = std::move(pageCallback);
+    exceptionCallback_ = std::move(exceptionCallback);
+    bool fetchNext = !fetching_;
+    fetching_ = true;
+    auto cursor = cursor_;
+    lock.unlock();
+    if (fetchNext)
+        fetch(std::move(cursor));
+}
+
+void RedisScannerImpl::forEachAsync(
+    std::function<bool(std::vector<std::string> &&)> &&pageCallback,
+    std::function<void()> &&doneCallback,
+    RedisExceptionCallback &&exceptionCallback)
+{
+    auto exceptionCallbackCopy = exceptionCallback;
+    nextAsync(
+        [thisPtr = shared_from_this(),
+         pageCallback = std::move(pageCallback),
+         doneCallback = std::move(doneCallback),
+         exceptionCallback = std::move(exceptionCallback)](
+            std::vector<std::string> &&page, bool last) mutable {
+            if (!page.empty() && !pageCallback(std::move(page)))
+                return;
+            if (last)
+            {
+                doneCallback();
+                return;
+            }
+            thisPtr->forEachAsync(std::move(pageCallback),
+                                  std::move(doneCallback),
+                                  std::move(exceptionCallback));
+        },
+        std::move(exceptionCallbackCopy));
+}
+
+void RedisScannerImpl::fetch(std::string cursor)
+{
+    std::vector<std::string> arguments{options_.command};
+    if (!options_.key.empty())
+        arguments.push_back(options_.key);
+    arguments.push_back(std::move(cursor));
+    if (!options_.match.empty())
+    {
+        arguments.emplace_back("MATCH");
+        arguments.push_back(options_.match);
+    }
+    arguments.emplace_back("COUNT");
+    arguments.push_back(std::to_string(options_.count));
+    if (!options_.type.empty())
+    {
+        arguments.emplace_back("TYPE");
+        arguments.push_back(options_.type);
+    }
+    auto thisPtr = shared_from_this();
+    sender_(
+        formatRedisCommand(arguments),
+        [thisPtr](const RedisResult &result) {
+            std::pair<std::string, std::vector<std::string>> page;
+            try
+            {
+                page = parseReply(result);
+            }
+            catch (const RedisException &e)
+            {
+                thisPtr->onError(e);
+                return;
+            }
+            catch (const std::exception &e)
+            {
+                thisPtr->onError(
+                    RedisException(RedisErrorCode::kBadType, e.what()));
+                return;
+            }
+            thisPtr->onPage(std::move(page.first), std::move(page.second));
+        },
+        [thisPtr](const RedisException &e) { thisPtr->onError(e); });
+}
+
+void RedisScannerImpl::onPage(std::string &&cursor,
+                              std::vector<std::string> &&page)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    fetching_ = false;
+    finished_ = cursor == "0";
+    cursor_ = std::move(cursor);
+    if (page.empty() && !finished_)
+    {
+        // A page without a match, go on with the next one
+        fetching_ = true;
+        auto next = cursor_;
+        lock.unlock();
+        fetch(std::move(next));
+        return;
+    }
+    if (!pageCallback_)
+    {
+        ready_ = std::move(page);
+        return;
+    }
+    auto pageCallback = std::move(pageCallback_);
+    pageCallback_ = nullptr;
+    exceptionCallback_ = nullptr;
+    bool last = finished_;
+    lastPassed_ = last;
+    fetching_ = !last;
+    auto next = cursor_;
+    lock.unlock();
+    if (!last)
+        fetch(std::move(next));
+    pageCallback(std::move(page), last);
+}
+
+void RedisScannerImpl::onError(const RedisException &e)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    fetching_ = false;
+    error_ = e;
+    if (!exceptionCallback_)
+        return;
+    auto exceptionCallback = std::move(exceptionCallback_);
+    pageCallback_ = nullptr;
+    exceptionCallback_ = nullptr;
+    lock.unlock();
+    exceptionCallback(e);
+}
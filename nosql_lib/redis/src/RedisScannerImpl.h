@@ -0,0 +1,108 @@
+/**
+ *
+ *  @file RedisScannerImpl.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/nosql/RedisScanner.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+class RedisScannerImpl final
+    : public RedisScanner,
+      public trantor::NonCopyable,
+      public std::enable_shared_from_this<RedisScannerImpl>
+{
+  public:
+    /// Sends a formatted command through the pool of the client
+    using Sender = std::function<void(std::string &&,
+                                      RedisResultCallback &&,
+                                      RedisExceptionCallback &&)>;
+
+    RedisScannerImpl(RedisScanOptions options, Sender sender);
+
+    /**
+     * @brief Create a scanner sending its commands through a client, which
+     * may be destroyed before it.
+     */
+    template <typename Client>
+    static std::shared_ptr<RedisScanner> newScanner(
+        const std::shared_ptr<Client> &client,
+        RedisScanOptions options)
+    {
+        std::weak_ptr<Client> weakPtr = client;
+        return std::make_shared<RedisScannerImpl>(
+            std::move(options),
+            [weakPtr](std::string &&command,
+                      RedisResultCallback &&resultCallback,
+                      RedisExceptionCallback &&exceptionCallback) {
+                auto clientPtr = weakPtr.lock();
+                if (!clientPtr)
+                {
+                    exceptionCallback(
+                        RedisException(RedisErrorCode::kNoConnectionAvailable,
+                                       "The redis client is destroyed"));
+                    return;
+                }
+                clientPtr->execFormattedCommandAsync(
+                    std::move(command),
+                    std::move(resultCallback),
+                    std::move(exceptionCallback));
+            });
+    }
+
+    void nextAsync(RedisScanPageCallback &&pageCallback,
+                   RedisExceptionCallback &&exceptionCallback) override;
+    void forEachAsync(
+        std::function<bool(std::vector<std::string> &&)> &&pageCallback,
+        std::function<void()> &&doneCallback,
+        RedisExceptionCallback &&exceptionCallback) override;
+
+    bool done() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lastPassed_;
+    }
+
+    /// Parse a reply of a SCAN command into its cursor and its elements
+    static std::pair<std::string, std::vector<std::string>> parseReply(
+        const RedisResult &result) noexcept(false);
+
+  private:
+    void fetch(std::string cursor);
+    void onPage(std::string &&cursor, std::vector<std::string> &&page);
+    void onError(const RedisException &e);
+
+    const RedisScanOptions options_;
+    const Sender sender_;
+    mutable std::mutex mutex_;
+    std::string cursor_{"0"};
+    bool fetching_{false};
+    // The server returned the cursor 0
+    bool finished_{false};
+    bool lastPassed_{false};
+    // The page read ahead
+    std::optional<std::vector<std::string>> ready_;
+    std::optional<RedisException> error_;
+    RedisScanPageCallback pageCallback_;
+    RedisExceptionCallback exceptionCallback_;
+};
+}  // namespace nosql
+}  // namespace drogon
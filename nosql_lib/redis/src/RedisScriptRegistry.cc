@@ -0,0 +1,147 @@
+/**
+ *
+ *  @file RedisScriptRegistry.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisScriptRegistry.h"
+#include "RedisConnection.h"
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <cctype>
+#include <memory>
+
+using namespace drogon::nosql;
+
+namespace
+{
+std::string bulk(std::string_view value)
+{
+    std::string str{"$"};
+    str.append(std::to_string(value.size()))
+        .append("\r\n")
+        .append(value)
+        .append("\r\n");
+    return str;
+}
+}  // namespace
+
+void RedisScriptRegistry::add(const std::string &name,
+                              const std::string &source)
+{
+    auto sha1 = drogon::utils::getSha1(source);
+    std::transform(sha1.begin(), sha1.end(), sha1.begin(), [](unsigned char c) {
+        return tolower(c);
+    });
+    std::lock_guard<std::mutex> lock(mutex_);
+    scripts_[name] = Script{std::move(sha1), source};
+}
+
+std::vector<std::pair<std::string, std::string>> RedisScriptRegistry::scripts()
+    const
+{
+    std::vector<std::pair<std::string, std::string>> scripts;
+    std::lock_guard<std::mutex> lock(mutex_);
+    scripts.reserve(scripts_.size());
+    for (auto &item : scripts_)
+    {
+        scripts.emplace_back(item.first, item.second.source_);
+    }
+    return scripts;
+}
+
+std::string RedisScriptRegistry::loadCommand(std::string_view source)
+{
+    return "*3\r\n" + bulk("SCRIPT") + bulk("LOAD") + bulk(source);
+}
+
+std::string RedisScriptRegistry::scriptCommand(
+    std::string_view command,
+    std::string_view script,
+    std::string_view formattedArguments)
+{
+    // "*<n>\r\n<bulk strings>" becomes "*<n + 2>\r\n<command><script><...>"
+    auto headerEnd = formattedArguments.find("\r\n");
+    auto count = std::stoul(std::string(formattedArguments.substr(
+        1, headerEnd == std::string_view::npos ? 0 : headerEnd - 1)));
+    std::string formatted{"*"};
+    formatted.append(std::to_string(count + 2))
+        .append("\r\n")
+        .append(bulk(command))
+        .append(bulk(script))
+        .append(formattedArguments.substr(headerEnd + 2));
+    return formatted;
+}
+
+void RedisScriptRegistry::exec(const Sender &sender,
+                               const std::string &name,
+                               std::string_view arguments,
+                               va_list ap,
+                               RedisResultCallback &&resultCallback,
+                               RedisExceptionCallback &&exceptionCallback) const
+{
+    Script script;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = scripts_.find(name);
+        if (iter == scripts_.end())
+        {
+            exceptionCallback(RedisException(RedisErrorCode::kBadType,
+                                             "Unknown script " + name));
+            return;
+        }
+        script = iter->second;
+    }
+    std::string formattedArguments;
+    try
+    {
+        // Keeps at least the number of keys, which EVALSHA requires
+        formattedArguments = RedisConnection::getFormattedCommand(
+            arguments.empty() ? std::string_view{"0"} : arguments, ap);
+    }
+    catch (const RedisException &err)
+    {
+        exceptionCallback(err);
+        return;
+    }
+    auto evalsha =
+        scriptCommand("EVALSHA", script.sha1_, formattedArguments);
+    auto exceptionCallbackPtr =
+        std::make_shared<RedisExceptionCallback>(std::move(exceptionCallback));
+    auto resultCallbackPtr =
+        std::make_shared<RedisResultCallback>(std::move(resultCallback));
+    sender(
+        std::move(evalsha),
+        [resultCallbackPtr](const RedisResult &result) {
+            (*resultCallbackPtr)(result);
+        },
+        [sender,
+         resultCallbackPtr,
+         exceptionCallbackPtr,
+         source = std::move(script.source_),
+         formattedArguments =
+             std::move(formattedArguments)](const RedisException &err) {
+            if (err.code() != RedisErrorCode::kRedisError ||
+                std::string_view(err.what()).substr(0, 8) != "NOSCRIPT")
+            {
+                (*exceptionCallbackPtr)(err);
+                return;
+            }
+            // The script cache of the server was flushed or this is another
+            // server, EVAL runs the script and caches it again.
+            sender(scriptCommand("EVAL", source, formattedArguments),
+                   [resultCallbackPtr](const RedisResult &result) {
+                       (*resultCallbackPtr)(result);
+                   },
+                   [exceptionCallbackPtr](const RedisException &err) {
+                       (*exceptionCallbackPtr)(err);
+                   });
+        });
+}
@@ -0,0 +1,84 @@
+/**
+ *
+ *  @file RedisScriptRegistry.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/nosql/RedisException.h>
+#include <drogon/nosql/RedisResult.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstdarg>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief The Lua scripts registered in a client, run by EVALSHA with their
+ * digests and by EVAL when the server doesn't know them (NOSCRIPT), which
+ * also loads them into the script cache of the server.
+ */
+class RedisScriptRegistry : public trantor::NonCopyable
+{
+  public:
+    /// Sends a formatted command
+    using Sender = std::function<void(std::string &&,
+                                      RedisResultCallback &&,
+                                      RedisExceptionCallback &&)>;
+
+    /// Register the script, replacing the script of the same name
+    void add(const std::string &name, const std::string &source);
+
+    /// The names and the sources of the scripts
+    std::vector<std::pair<std::string, std::string>> scripts() const;
+
+    /// The formatted SCRIPT LOAD command of a source
+    static std::string loadCommand(std::string_view source);
+
+    /**
+     * @brief Run the script by EVALSHA, followed by the arguments formatted
+     * like RedisClient::execCommandAsync() does, e.g. "1 %s %s".
+     */
+    void exec(const Sender &sender,
+              const std::string &name,
+              std::string_view arguments,
+              va_list ap,
+              RedisResultCallback &&resultCallback,
+              RedisExceptionCallback &&exceptionCallback) const;
+
+    /**
+     * @brief The formatted command running a script by EVALSHA or EVAL,
+     * followed by the formatted arguments without their array header.
+     */
+    static std::string scriptCommand(std::string_view command,
+                                     std::string_view script,
+                                     std::string_view formattedArguments);
+
+  private:
+    struct Script
+    {
+        std::string sha1_;
+        std::string source_;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Script> scripts_;
+};
+
+}  // namespace nosql
+}  // namespace drogon
@@ -0,0 +1,727 @@
+/**
+ *
+ *  @file RedisSentinelClient.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisSentinelClient.h"
+#include "RedisClientImpl.h"
+#include "RedisConnection.h"
+#include "RedisSubscriberHub.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <limits>
+
+using namespace drogon::nosql;
+
+namespace
+{
+constexpr double kRefreshInterval{5.0};
+// A Sentinel not answering doesn't stall the refreshes
+constexpr double kSentinelTimeout{2.0};
+
+bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs)
+{
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+               return tolower(static_cast<unsigned char>(a)) ==
+                      tolower(static_cast<unsigned char>(b));
+           });
+}
+
+// The name of a command in the RESP format: *<n>\r\n$<len>\r\n<name>\r\n...
+std::string_view commandName(std::string_view command)
+{
+    if (command.empty() || command[0] != '*')
+        return {};
+    auto pos = command.find("\r\n");
+    if (pos == std::string_view::npos || pos + 2 >= command.size() ||
+        command[pos + 2] != '$')
+        return {};
+    pos += 3;
+    auto end = command.find("\r\n", pos);
+    if (end == std::string_view::npos)
+        return {};
+    size_t len = 0;
+    for (auto i = pos; i < end; ++i)
+    {
+        if (!isdigit(static_cast<unsigned char>(command[i])))
+            return {};
+        len = len * 10 + (command[i] - '0');
+    }
+    if (end + 2 + len > command.size())
+        return {};
+    return command.substr(end + 2, len);
+}
+}  // namespace
+
+std::shared_ptr<RedisClient> RedisClient::newRedisSentinelClient(
+    const std::vector<trantor::InetAddress> &sentinels,
+    const std::string &masterName,
+    size_t connectionsPerNode,
+    bool readFromReplicas,
+    const std::string &password,
+    unsigned int db,
+    const std::string &username)
+{
+    auto client = std::make_shared<RedisSentinelClient>(sentinels,
+                                                        masterName,
+                                                        connectionsPerNode,
+                                                        readFromReplicas,
+                                                        username,
+                                                        password,
+                                                        db);
+    client->init();
+    return client;
+}
+
+RedisSentinelClient::RedisSentinelClient(
+    const std::vector<trantor::InetAddress> &sentinels,
+    std::string masterName,
+    size_t connectionsPerNode,
+    bool readFromReplicas,
+    std::string username,
+    std::string password,
+    unsigned int db)
+    : masterName_(std::move(masterName)),
+      connectionsPerNode_(connectionsPerNode),
+      readFromReplicas_(readFromReplicas),
+      username_(std::move(username)),
+      password_(std::move(password)),
+      db_(db)
+{
+    assert(!sentinels.empty());
+    for (auto const &sentinel : sentinels)
+    {
+        auto client = std::make_shared<RedisClientImpl>(sentinel, 1);
+        client->setTimeout(kSentinelTimeout);
+        client->init();
+        sentinels_.push_back(std::move(client));
+    }
+}
+
+RedisSentinelClient::~RedisSentinelClient()
+{
+    if (refreshTimer_ != 0)
+        refreshThread_.getLoop()->invalidateTimer(refreshTimer_);
+    failoverSubscribers_.clear();
+    closeAll();
+    for (auto &sentinel : sentinels_)
+    {
+        sentinel->closeAll();
+    }
+}
+
+void RedisSentinelClient::init(double timeout)
+{
+    refreshThread_.run();
+    std::weak_ptr<RedisSentinelClient> weakPtr = shared_from_this();
+    refreshTimer_ =
+        refreshThread_.getLoop()->runEvery(kRefreshInterval, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->refresh();
+        });
+    watchFailovers();
+    refresh();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!primaryFound_.wait_for(lock,
+                                std::chrono::duration<double>(timeout),
+                                [this]() { return primary_ != nullptr; }))
+    {
+        LOG_ERROR << "The Redis Sentinels don't know the primary of "
+                  << masterName_ << " yet";
+    }
+}
+
+bool RedisSentinelClient::isReadOnlyCommand(std::string_view formattedCommand)
+{
+    static const char *const readOnlyCommands[] = {
+        "bitcount", "bitfield_ro", "bitpos", "dbsize", "dump", "eval_ro",
+        "evalsha_ro", "exists", "expiretime", "fcall_ro", "geodist", "geohash",
+        "geopos", "geosearch", "get", "getbit", "getrange", "hexists", "hget",
+        "hgetall", "hkeys", "hlen", "hmget", "hrandfield", "hscan", "hstrlen",
+        "hvals", "keys", "lcs", "lindex", "llen", "lpos", "lrange", "mget",
+        "pexpiretime", "pfcount", "pttl", "randomkey", "scan", "scard", "sdiff",
+        "sinter", "sintercard", "sismember", "smembers", "smismember",
+        "srandmember", "sscan", "strlen", "substr", "sunion", "ttl", "type",
+        "xinfo", "xlen", "xpending", "xrange", "xread", "xrevrange", "zcard",
+        "zcount", "zdiff", "zinter", "zintercard", "zlexcount", "zmscore",
+        "zrandmember", "zrange", "zrangebylex", "zrangebyscore", "zrank",
+        "zrevrange", "zrevrangebylex", "zrevrangebyscore", "zrevrank", "zscan",
+        "zscore", "zunion"};
+    auto name = commandName(formattedCommand);
+    if (name.empty())
+        return false;
+    for (auto command : readOnlyCommands)
+    {
+        if (equalsIgnoreCase(name, command))
+            return true;
+    }
+    return false;
+}
+
+void RedisSentinelClient::execCommandAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    std::string_view command,
+    ...) noexcept
+{
+    LOG_TRACE << "redis command: " << command;
+    std::string formattedCommand;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCommand = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    send(std::move(formattedCommand),
+         std::move(resultCallback),
+         std::move(exceptionCallback));
+}
+
+void RedisSentinelClient::execFormattedCommandAsync(
+    std::string &&command,
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback) noexcept
+{
+    send(std::move(command),
+         std::move(resultCallback),
+         std::move(exceptionCallback));
+}
+
+void RedisSentinelClient::send(std::string &&command,
+                               RedisResultCallback &&resultCallback,
+                               RedisExceptionCallback &&exceptionCallback)
+{
+    std::shared_ptr<RedisClientImpl> node;
+    if (readFromReplicas_ && isReadOnlyCommand(command))
+        node = leastBusyReplica();
+    if (!node)
+        node = primary();
+    if (!node)
+    {
+        refresh();
+        exceptionCallback(
+            RedisException(RedisErrorCode::kNoConnectionAvailable,
+                           "The Redis primary of " + masterName_ +
+                               " is unknown"));
+        return;
+    }
+    std::weak_ptr<RedisSentinelClient> weakPtr = shared_from_this();
+    node->execFormattedCommandAsync(
+        std::move(command),
+        std::move(resultCallback),
+        [weakPtr, exceptionCallback = std::move(exceptionCallback)](
+            const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            // A demoted primary refuses the writes with READONLY
+            if (thisPtr &&
+                (err.code() == RedisErrorCode::kConnectionBroken ||
+                 (err.code() == RedisErrorCode::kRedisError &&
+                  std::string_view(err.what()).substr(0, 9) == "READONLY ")))
+                thisPtr->refresh();
+            exceptionCallback(err);
+        });
+}
+
+std::shared_ptr<RedisClientImpl> RedisSentinelClient::primary() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return primary_;
+}
+
+std::shared_ptr<RedisClientImpl> RedisSentinelClient::leastBusyReplica() const
+{
+    std::vector<std::shared_ptr<RedisClientImpl>> replicas;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (replicas_.empty())
+            return nullptr;
+        replicas.reserve(replicas_.size());
+        for (auto &replica : replicas_)
+        {
+            replicas.push_back(replica.second);
+        }
+    }
+    std::shared_ptr<RedisClientImpl> best;
+    auto bestLoad = (std::numeric_limits<size_t>::max)();
+    auto start = nextReplica_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < replicas.size(); ++i)
+    {
+        auto &replica = replicas[(start + i) % replicas.size()];
+        auto status = replica->poolStatus();
+        // Not connected yet, or lost
+        if (status.ready == 0)
+            continue;
+        auto load = status.queued + status.unanswered;
+        if (load < bestLoad)
+        {
+            best = replica;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+std::shared_ptr<RedisClientImpl> RedisSentinelClient::nextSentinel()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sentinels_[nextSentinel_++ % sentinels_.size()];
+}
+
+std::shared_ptr<RedisClientImpl> RedisSentinelClient::newNode(
+    const std::string &host,
+    unsigned short port)
+{
+    double timeout;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timeout = timeout_;
+    }
+    auto node =
+        std::make_shared<RedisClientImpl>(trantor::InetAddress(host, port),
+                                          connectionsPerNode_,
+                                          username_,
+                                          password_,
+                                          db_);
+    if (timeout > 0.0)
+        node->setTimeout(timeout);
+    node->init();
+    for (auto &script : scripts_.scripts())
+    {
+        node->registerScript(script.first, script.second);
+    }
+    return node;
+}
+
+void RedisSentinelClient::refresh()
+{
+    if (refreshing_.exchange(true))
+        return;
+    // Another Sentinel is asked next time if this one doesn't answer
+    auto sentinel = nextSentinel();
+    std::weak_ptr<RedisSentinelClient> weakPtr = shared_from_this();
+    sentinel->execCommandAsync(
+        [weakPtr, sentinel](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            try
+            {
+                // [ip, port], or nil if the Sentinel doesn't know the name
+                if (result.type() == RedisResultType::kNil)
+                {
+                    LOG_ERROR << "The Redis Sentinel doesn't know "
+                              << thisPtr->masterName_;
+                }
+                else
+                {
+                    auto address = result.asArray();
+                    if (address.size() >= 2)
+                    {
+                        auto port = std::stoul(address[1].asString());
+                        if (port > 0 && port <= 65535)
+                            thisPtr->setPrimary(
+                                address[0].asString(),
+                                static_cast<unsigned short>(port));
+                    }
+                }
+            }
+            catch (const std::exception &err)
+            {
+                LOG_WARN << "Bad reply of the Redis Sentinel: " << err.what();
+            }
+            thisPtr->queryReplicas(sentinel);
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            LOG_WARN << "Failed to ask the Redis Sentinel for the primary of "
+                     << thisPtr->masterName_ << ": " << err.what();
+            thisPtr->refreshing_ = false;
+        },
+        "SENTINEL get-master-addr-by-name %s",
+        masterName_.c_str());
+}
+
+void RedisSentinelClient::queryReplicas(
+    const std::shared_ptr<RedisClientImpl> &sentinel)
+{
+    if (!readFromReplicas_)
+    {
+        refreshing_ = false;
+        return;
+    }
+    std::weak_ptr<RedisSentinelClient> weakPtr = shared_from_this();
+    sentinel->execCommandAsync(
+        [weakPtr](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->setReplicas(result);
+            thisPtr->refreshing_ = false;
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            LOG_WARN << "Failed to ask the Redis Sentinel for the replicas of "
+                     << thisPtr->masterName_ << ": " << err.what();
+            thisPtr->refreshing_ = false;
+        },
+        "SENTINEL replicas %s",
+        masterName_.c_str());
+}
+
+void RedisSentinelClient::setPrimary(const std::string &host,
+                                     unsigned short port)
+{
+    auto address = host + ":" + std::to_string(port);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (address == primaryAddress_)
+            return;
+    }
+    // Connected out of the lock, the commands keep going to the old primary
+    // meanwhile
+    auto node = newNode(host, port);
+    // The clients replaced are destroyed out of the lock
+    std::shared_ptr<RedisClientImpl> oldPrimary;
+    std::shared_ptr<RedisClientImpl> promotedReplica;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (address == primaryAddress_)
+            return;
+        LOG_INFO << "The Redis primary of " << masterName_ << " is "
+                 << address;
+        oldPrimary = std::move(primary_);
+        primary_ = std::move(node);
+        primaryAddress_ = address;
+        auto iter = replicas_.find(address);
+        if (iter != replicas_.end())
+        {
+            promotedReplica = std::move(iter->second);
+            replicas_.erase(iter);
+        }
+    }
+    primaryFound_.notify_all();
+}
+
+void RedisSentinelClient::setReplicas(const RedisResult &result)
+{
+    // Every element is a map of the fields of a replica
+    std::vector<std::pair<std::string, std::string>> healthy;
+    try
+    {
+        for (auto const &replica : result.asArray())
+        {
+            std::string host;
+            std::string port;
+            std::string flags;
+            std::string linkStatus;
+            for (auto const &field : replica.asMap())
+            {
+                auto key = field.first.asString();
+                if (key == "ip")
+                    host = field.second.asString();
+                else if (key == "port")
+                    port = field.second.asString();
+                else if (key == "flags")
+                    flags = field.second.asString();
+                else if (key == "master-link-status")
+                    linkStatus = field.second.asString();
+            }
+            if (host.empty() || port.empty() || linkStatus != "ok" ||
+                flags.find("s_down") != std::string::npos ||
+                flags.find("o_down") != std::string::npos ||
+                flags.find("disconnected") != std::string::npos)
+                continue;
+            healthy.emplace_back(std::move(host), std::move(port));
+        }
+    }
+    catch (const RedisException &err)
+    {
+        LOG_WARN << "Bad SENTINEL REPLICAS reply: " << err.what();
+        return;
+    }
+    std::map<std::string, std::shared_ptr<RedisClientImpl>> replicas;
+    std::vector<std::pair<std::string, std::string>> added;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &replica : healthy)
+        {
+            auto address = replica.first + ":" + replica.second;
+            if (address == primaryAddress_)
+                continue;
+            auto iter = replicas_.find(address);
+            if (iter != replicas_.end())
+                replicas[address] = iter->second;
+            else
+                added.push_back(std::move(replica));
+        }
+    }
+    for (auto &replica : added)
+    {
+        unsigned long port = 0;
+        try
+        {
+            port = std::stoul(replica.second);
+        }
+        catch (const std::exception &)
+        {
+        }
+        if (port == 0 || port > 65535)
+            continue;
+        LOG_DEBUG << "New Redis replica " << replica.first << ":" << port;
+        replicas[replica.first + ":" + replica.second] =
+            newNode(replica.first, static_cast<unsigned short>(port));
+    }
+    // The replicas gone are closed when their last commands are answered
+    std::lock_guard<std::mutex> lock(mutex_);
+    replicas_.swap(replicas);
+}
+
+void RedisSentinelClient::watchFailovers()
+{
+    std::weak_ptr<RedisSentinelClient> weakPtr = shared_from_this();
+    for (auto &sentinel : sentinels_)
+    {
+        auto subscriber = sentinel->newSubscriber();
+        // <master name> <old ip> <old port> <new ip> <new port>
+        subscriber->subscribe(
+            "+switch-master",
+            [weakPtr](const std::string &, const std::string &message) {
+                auto thisPtr = weakPtr.lock();
+                if (!thisPtr ||
+                    message.compare(0,
+                                    thisPtr->masterName_.size() + 1,
+                                    thisPtr->masterName_ + " ") != 0)
+                    return;
+                LOG_INFO << "Redis failover: " << message;
+                // The new replicas are also asked for
+                thisPtr->refreshing_ = false;
+                thisPtr->refresh();
+            });
+        failoverSubscribers_.push_back(std::move(subscriber));
+    }
+}
+
+std::shared_ptr<RedisSubscriber> RedisSentinelClient::newSubscriber() noexcept
+{
+    auto node = primary();
+    if (!node)
+    {
+        LOG_ERROR << "The Redis primary of " << masterName_ << " is unknown";
+        return nullptr;
+    }
+    return node->newSubscriber();
+}
+
+std::shared_ptr<RedisSubscriber> RedisSentinelClient::newSharedSubscriber()
+    noexcept
+{
+    std::shared_ptr<RedisSubscriberHub> hub;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hub = subscriberHub_;
+    }
+    if (!hub)
+    {
+        auto subscriber = newSubscriber();
+        if (!subscriber)
+            return nullptr;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!subscriberHub_)
+        {
+            subscriberHub_ = std::make_shared<RedisSubscriberHub>(subscriber);
+        }
+        hub = subscriberHub_;
+    }
+    return std::make_shared<RedisSharedSubscriber>(hub);
+}
+
+std::shared_ptr<RedisPipeline> RedisSentinelClient::newPipeline() noexcept
+{
+    // The commands of a pipeline are answered in order, they all go to the
+    // primary
+    auto node = primary();
+    if (!node)
+    {
+        LOG_ERROR << "The Redis primary of " << masterName_ << " is unknown";
+        return nullptr;
+    }
+    return node->newPipeline();
+}
+
+std::shared_ptr<RedisScanner> RedisSentinelClient::newScanner(
+    const RedisScanOptions &options)
+{
+    // The cursor is only valid on the server which returned it, so the scan
+    // stays on the primary instead of the replicas
+    auto node = primary();
+    if (!node)
+    {
+        LOG_ERROR << "The Redis primary of " << masterName_ << " is unknown";
+        return nullptr;
+    }
+    return node->newScanner(options);
+}
+
+std::shared_ptr<RedisStreamConsumer> RedisSentinelClient::newStreamConsumer(
+    const RedisStreamConsumerConfig &config,
+    RedisStreamBatchCallback &&batchCallback,
+    trantor::EventLoop *loop)
+{
+    auto node = primary();
+    if (!node)
+    {
+        LOG_ERROR << "The Redis primary of " << masterName_ << " is unknown";
+        return nullptr;
+    }
+    return node->newStreamConsumer(config, std::move(batchCallback), loop);
+}
+
+void RedisSentinelClient::registerScript(const std::string &name,
+                                         const std::string &source)
+{
+    std::vector<std::shared_ptr<RedisClientImpl>> nodes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scripts_.add(name, source);
+        if (primary_)
+            nodes.push_back(primary_);
+        for (auto &replica : replicas_)
+        {
+            nodes.push_back(replica.second);
+        }
+    }
+    for (auto &node : nodes)
+    {
+        node->registerScript(name, source);
+    }
+}
+
+void RedisSentinelClient::execScriptAsync(
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback,
+    const std::string &name,
+    std::string_view arguments,
+    ...) noexcept
+{
+    // The scripts may write, EVALSHA and EVAL go to the primary
+    std::weak_ptr<RedisSentinelClient> weakPtr = shared_from_this();
+    va_list args;
+    va_start(args, arguments);
+    scripts_.exec(
+        [weakPtr](std::string &&command,
+                  RedisResultCallback &&resultCallback,
+                  RedisExceptionCallback &&exceptionCallback) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+            {
+                exceptionCallback(
+                    RedisException(RedisErrorCode::kNoConnectionAvailable,
+                                   "The redis client is destroyed"));
+                return;
+            }
+            thisPtr->send(std::move(command),
+                          std::move(resultCallback),
+                          std::move(exceptionCallback));
+        },
+        name,
+        arguments,
+        args,
+        std::move(resultCallback),
+        std::move(exceptionCallback));
+    va_end(args);
+}
+
+RedisTransactionPtr RedisSentinelClient::newTransaction() noexcept(false)
+{
+    auto node = primary();
+    if (!node)
+    {
+        throw RedisException(RedisErrorCode::kNoConnectionAvailable,
+                             "The Redis primary of " + masterName_ +
+                                 " is unknown");
+    }
+    return node->newTransaction();
+}
+
+void RedisSentinelClient::newTransactionAsync(
+    const std::function<void(const RedisTransactionPtr &)> &callback)
+{
+    auto node = primary();
+    if (!node)
+    {
+        callback(nullptr);
+        return;
+    }
+    node->newTransactionAsync(callback);
+}
+
+void RedisSentinelClient::setTimeout(double timeout)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_ = timeout;
+    if (primary_)
+        primary_->setTimeout(timeout);
+    for (auto &replica : replicas_)
+    {
+        replica.second->setTimeout(timeout);
+    }
+}
+
+void RedisSentinelClient::closeAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (primary_)
+        primary_->closeAll();
+    for (auto &replica : replicas_)
+    {
+        replica.second->closeAll();
+    }
+}
+
+RedisPoolStatus RedisSentinelClient::poolStatus() const noexcept
+{
+    std::vector<std::shared_ptr<RedisClientImpl>> nodes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (primary_)
+            nodes.push_back(primary_);
+        for (auto &replica : replicas_)
+        {
+            nodes.push_back(replica.second);
+        }
+    }
+    RedisPoolStatus status;
+    for (auto &node : nodes)
+    {
+        auto nodeStatus = node->poolStatus();
+        status.connections += nodeStatus.connections;
+        status.ready += nodeStatus.ready;
+        status.queued += nodeStatus.queued;
+        status.unanswered += nodeStatus.unanswered;
+    }
+    return status;
+}
@@ -0,0 +1,144 @@
+/**
+ *
+ *  @file RedisSentinelClient.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include "RedisScriptRegistry.h"
+#include <drogon/nosql/RedisClient.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+class RedisClientImpl;
+class RedisSubscriberHub;
+
+/**
+ * @brief Sends the commands to the primary of a Redis replication group
+ * found by its Sentinels, and optionally the read-only ones to its replicas.
+ *
+ * The primary and the healthy replicas are asked to the Sentinels every few
+ * seconds, when a Sentinel announces a failover (+switch-master) and when
+ * the primary breaks a connection or refuses a write (READONLY). Every node
+ * has its own connection pool, a read is sent to the replica with the least
+ * commands waiting or to the primary if no replica is connected.
+ */
+class RedisSentinelClient final
+    : public RedisClient,
+      public trantor::NonCopyable,
+      public std::enable_shared_from_this<RedisSentinelClient>
+{
+  public:
+    RedisSentinelClient(const std::vector<trantor::InetAddress> &sentinels,
+                        std::string masterName,
+                        size_t connectionsPerNode,
+                        bool readFromReplicas,
+                        std::string username,
+                        std::string password,
+                        unsigned int db);
+    ~RedisSentinelClient() override;
+
+    /**
+     * @brief Find the nodes, waiting for the primary at most the timeout in
+     * seconds, and start the periodic refresh.
+     */
+    void init(double timeout = 5.0);
+
+    void execCommandAsync(RedisResultCallback &&resultCallback,
+                          RedisExceptionCallback &&exceptionCallback,
+                          std::string_view command,
+                          ...) noexcept override;
+    void execFormattedCommandAsync(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback) noexcept override;
+    std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override;
+    std::shared_ptr<RedisSubscriber> newSharedSubscriber() noexcept override;
+    std::shared_ptr<RedisPipeline> newPipeline() noexcept override;
+    std::shared_ptr<RedisScanner> newScanner(
+        const RedisScanOptions &options) override;
+    std::shared_ptr<RedisStreamConsumer> newStreamConsumer(
+        const RedisStreamConsumerConfig &config,
+        RedisStreamBatchCallback &&batchCallback,
+        trantor::EventLoop *loop) override;
+    void registerScript(const std::string &name,
+                        const std::string &source) override;
+    void execScriptAsync(RedisResultCallback &&resultCallback,
+                         RedisExceptionCallback &&exceptionCallback,
+                         const std::string &name,
+                         std::string_view arguments,
+                         ...) noexcept override;
+    RedisTransactionPtr newTransaction() noexcept(false) override;
+    void newTransactionAsync(
+        const std::function<void(const RedisTransactionPtr &)> &callback)
+        override;
+    void setTimeout(double timeout) override;
+    void closeAll() override;
+    RedisPoolStatus poolStatus() const noexcept override;
+
+    /// True if the formatted command only reads, so a replica can serve it
+    static bool isReadOnlyCommand(std::string_view formattedCommand);
+
+  private:
+    void send(std::string &&command,
+              RedisResultCallback &&resultCallback,
+              RedisExceptionCallback &&exceptionCallback);
+    std::shared_ptr<RedisClientImpl> primary() const;
+    std::shared_ptr<RedisClientImpl> leastBusyReplica() const;
+    void refresh();
+    void queryReplicas(const std::shared_ptr<RedisClientImpl> &sentinel);
+    void setPrimary(const std::string &host, unsigned short port);
+    void setReplicas(const RedisResult &result);
+    void watchFailovers();
+    std::shared_ptr<RedisClientImpl> nextSentinel();
+    std::shared_ptr<RedisClientImpl> newNode(const std::string &host,
+                                             unsigned short port);
+
+    const std::string masterName_;
+    const size_t connectionsPerNode_;
+    const bool readFromReplicas_;
+    const std::string username_;
+    const std::string password_;
+    const unsigned int db_;
+    std::vector<std::shared_ptr<RedisClientImpl>> sentinels_;
+    size_t nextSentinel_{0};
+    mutable std::mutex mutex_;
+    std::condition_variable primaryFound_;
+    std::string primaryAddress_;
+    std::shared_ptr<RedisClientImpl> primary_;
+    // Keyed by "host:port"
+    std::map<std::string, std::shared_ptr<RedisClientImpl>> replicas_;
+    std::vector<std::shared_ptr<RedisSubscriber>> failoverSubscribers_;
+    // Where the search of the least busy replica starts, to spread the reads
+    // of an idle group
+    mutable std::atomic<size_t> nextReplica_{0};
+    std::shared_ptr<RedisSubscriberHub> subscriberHub_;
+    // Also registered in every node, which loads them on its connections
+    RedisScriptRegistry scripts_;
+    double timeout_{-1.0};
+    std::atomic<bool> refreshing_{false};
+    trantor::EventLoopThread refreshThread_{"RedisSentinelRefresh"};
+    trantor::TimerId refreshTimer_{0};
+};
+
+}  // namespace nosql
+}  // namespace drogon
@@ -0,0 +1,443 @@
+/**
+ *
+ *  @file RedisStreamConsumerImpl.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisStreamConsumerImpl.h"
+#include <trantor/utils/Logger.h>
+
+using namespace drogon::nosql;
+
+namespace
+{
+std::string readCommandOf(const RedisStreamConsumerConfig &config)
+{
+    auto count = std::to_string(config.batchSize);
+    auto block = std::to_string(config.blockMs);
+    return RedisConnection::formatCommand({"XREADGROUP",
+                                           "GROUP",
+                                           config.group,
+                                           config.consumer,
+                                           "COUNT",
+                                           count,
+                                           "BLOCK",
+                                           block,
+                                           "STREAMS",
+                                           config.stream,
+                                           ">"});
+}
+
+bool startsWith(const char *str, std::string_view prefix)
+{
+    return std::string_view(str).substr(0, prefix.size()) == prefix;
+}
+}  // namespace
+
+RedisStreamConsumerImpl::RedisStreamConsumerImpl(
+    RedisStreamConsumerConfig config,
+    RedisStreamBatchCallback &&callback,
+    trantor::EventLoop *connLoop,
+    trantor::EventLoop *loop,
+    Sender sender)
+    : config_(std::move(config)),
+      callback_(std::move(callback)),
+      connLoop_(connLoop),
+      loop_(loop ? loop : connLoop),
+      sender_(std::move(sender)),
+      readCommand_(readCommandOf(config_))
+{
+}
+
+RedisStreamConsumerImpl::~RedisStreamConsumerImpl()
+{
+    // No callback holds this object anymore
+    stopped_.store(true, std::memory_order_release);
+    flushAcks();
+    if (claimTimer_ != 0)
+    {
+        connLoop_->invalidateTimer(claimTimer_);
+    }
+    if (conn_)
+    {
+        auto conn = std::move(conn_);
+        conn->getLoop()->runInLoop([conn]() { conn->disconnect(); });
+    }
+}
+
+void RedisStreamConsumerImpl::ack(const std::string &id)
+{
+    addAcks({id});
+}
+
+void RedisStreamConsumerImpl::stop()
+{
+    if (stopped_.exchange(true, std::memory_order_acq_rel))
+        return;
+    flushAcks();
+    connLoop_->runInLoop([thisPtr = shared_from_this()]() {
+        if (thisPtr->claimTimer_ != 0)
+        {
+            thisPtr->connLoop_->invalidateTimer(thisPtr->claimTimer_);
+            thisPtr->claimTimer_ = 0;
+        }
+        if (thisPtr->conn_)
+        {
+            auto conn = std::move(thisPtr->conn_);
+            conn->disconnect();
+        }
+    });
+}
+
+void RedisStreamConsumerImpl::setConnection(const RedisConnectionPtr &conn)
+{
+    connLoop_->assertInLoopThread();
+    conn_ = conn;
+    if (config_.claimMinIdleMs > 0 && claimTimer_ == 0)
+    {
+        std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+        claimTimer_ = connLoop_->runEvery(config_.claimInterval, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr && !thisPtr->stopped() && !thisPtr->claiming_)
+                thisPtr->claim("0-0");
+        });
+        claim("0-0");
+    }
+    if (!groupCreated_ && !config_.createGroupFrom.empty())
+        createGroup();
+    else
+        read();
+}
+
+void RedisStreamConsumerImpl::clearConnection()
+{
+    connLoop_->assertInLoopThread();
+    conn_.reset();
+    reading_ = false;
+}
+
+void RedisStreamConsumerImpl::createGroup()
+{
+    if (stopped() || !conn_)
+        return;
+    std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+    conn_->sendFormattedCommand(
+        RedisConnection::formatCommand({"XGROUP",
+                                        "CREATE",
+                                        config_.stream,
+                                        config_.group,
+                                        config_.createGroupFrom,
+                                        "MKSTREAM"}),
+        [weakPtr](const RedisResult &) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->groupCreated_ = true;
+            thisPtr->read();
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr || err.code() != RedisErrorCode::kRedisError)
+                return;
+            if (!startsWith(err.what(), "BUSYGROUP"))
+            {
+                LOG_ERROR << "Failed to create the consumer group "
+                          << thisPtr->config_.group << ": " << err.what();
+            }
+            // Reading reports the errors if the group doesn't exist
+            thisPtr->groupCreated_ = true;
+            thisPtr->read();
+        });
+}
+
+void RedisStreamConsumerImpl::read()
+{
+    if (stopped() || !conn_ || reading_)
+        return;
+    if (pendingBatches_ >= config_.maxPendingBatches)
+    {
+        paused_ = true;
+        return;
+    }
+    reading_ = true;
+    std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+    conn_->sendFormattedCommand(
+        std::string{readCommand_},
+        [weakPtr](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->onRead(result);
+        },
+        [weakPtr](const RedisException &err) {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->onReadError(err);
+        });
+}
+
+void RedisStreamConsumerImpl::onRead(const RedisResult &result)
+{
+    reading_ = false;
+    std::vector<RedisStreamMessage> messages;
+    try
+    {
+        // Nil if no message arrived within the block time
+        if (result.type() == RedisResultType::kMap)
+        {
+            for (auto &stream : result.asMap())
+            {
+                parseEntries(stream.second, messages);
+            }
+        }
+        else if (!result.isNil())
+        {
+            for (auto &stream : result.asArray())
+            {
+                auto nameAndEntries = stream.asArray();
+                if (nameAndEntries.size() == 2)
+                    parseEntries(nameAndEntries[1], messages);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << "Bad reply of XREADGROUP: " << e.what();
+    }
+    if (!messages.empty())
+        deliver(std::move(messages));
+    read();
+}
+
+void RedisStreamConsumerImpl::onReadError(const RedisException &err)
+{
+    reading_ = false;
+    // A broken connection is restored by the client
+    if (stopped() || err.code() != RedisErrorCode::kRedisError)
+        return;
+    LOG_ERROR << "Failed to read the stream " << config_.stream << ": "
+              << err.what();
+    if (startsWith(err.what(), "NOGROUP"))
+        groupCreated_ = false;
+    std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+    connLoop_->runAfter(2.0, [weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        if (!thisPtr->groupCreated_ &&
+            !thisPtr->config_.createGroupFrom.empty())
+            thisPtr->createGroup();
+        else
+            thisPtr->read();
+    });
+}
+
+void RedisStreamConsumerImpl::deliver(
+    std::vector<RedisStreamMessage> &&messages)
+{
+    ++pendingBatches_;
+    loop_->queueInLoop([thisPtr = shared_from_this(),
+                        messages = std::move(messages)]() {
+        bool handled = true;
+        try
+        {
+            thisPtr->callback_(messages);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "The stream messages are not acknowledged: "
+                      << e.what();
+            handled = false;
+        }
+        catch (...)
+        {
+            LOG_ERROR << "The stream messages are not acknowledged";
+            handled = false;
+        }
+        if (handled && thisPtr->config_.autoAck)
+        {
+            std::vector<std::string> ids;
+            ids.reserve(messages.size());
+            for (auto &message : messages)
+            {
+                ids.push_back(message.id_);
+            }
+            thisPtr->addAcks(std::move(ids));
+        }
+        thisPtr->connLoop_->runInLoop([thisPtr]() { thisPtr->batchDone(); });
+    });
+}
+
+void RedisStreamConsumerImpl::batchDone()
+{
+    --pendingBatches_;
+    if (paused_)
+    {
+        paused_ = false;
+        read();
+    }
+}
+
+void RedisStreamConsumerImpl::claim(const std::string &cursor)
+{
+    claiming_ = true;
+    auto minIdle = std::to_string(config_.claimMinIdleMs);
+    auto count = std::to_string(config_.batchSize);
+    std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+    sender_(
+        RedisConnection::formatCommand({"XAUTOCLAIM",
+                                        config_.stream,
+                                        config_.group,
+                                        config_.consumer,
+                                        minIdle,
+                                        cursor,
+                                        "COUNT",
+                                        count}),
+        [weakPtr](const RedisResult &result) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            // The next cursor, the claimed entries and, since Redis 7.0, the
+            // ids of the deleted entries.
+            std::string next;
+            std::vector<RedisStreamMessage> messages;
+            try
+            {
+                auto items = result.asArray();
+                if (items.size() >= 2)
+                {
+                    next = items[0].asString();
+                    parseEntries(items[1], messages);
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR << "Bad reply of XAUTOCLAIM: " << e.what();
+                next.clear();
+            }
+            thisPtr->connLoop_->queueInLoop(
+                [thisPtr,
+                 next = std::move(next),
+                 messages = std::move(messages)]() mutable {
+                    if (!messages.empty() && !thisPtr->stopped())
+                        thisPtr->deliver(std::move(messages));
+                    // The rest is claimed by the next round if the handler
+                    // is behind
+                    if (!thisPtr->stopped() && !next.empty() &&
+                        next != "0-0" &&
+                        thisPtr->pendingBatches_ <
+                            thisPtr->config_.maxPendingBatches)
+                        thisPtr->claim(next);
+                    else
+                        thisPtr->claiming_ = false;
+                });
+        },
+        [weakPtr](const RedisException &err) {
+            LOG_ERROR << "Failed to claim the pending stream messages: "
+                      << err.what();
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->connLoop_->queueInLoop(
+                [thisPtr]() { thisPtr->claiming_ = false; });
+        });
+}
+
+void RedisStreamConsumerImpl::addAcks(std::vector<std::string> &&ids)
+{
+    std::vector<std::string> batch;
+    bool schedule{false};
+    {
+        std::lock_guard<std::mutex> lock(ackMutex_);
+        if (acks_.empty())
+        {
+            acks_ = std::move(ids);
+        }
+        else
+        {
+            acks_.insert(acks_.end(),
+                         std::make_move_iterator(ids.begin()),
+                         std::make_move_iterator(ids.end()));
+        }
+        if (acks_.size() >= config_.ackBatchSize)
+        {
+            batch.swap(acks_);
+        }
+        else if (!acks_.empty() && !ackTimerScheduled_)
+        {
+            ackTimerScheduled_ = true;
+            schedule = true;
+        }
+    }
+    if (!batch.empty())
+        sendAcks(std::move(batch));
+    if (schedule)
+    {
+        std::weak_ptr<RedisStreamConsumerImpl> weakPtr = shared_from_this();
+        connLoop_->runAfter(config_.ackInterval, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->flushAcks();
+        });
+    }
+}
+
+void RedisStreamConsumerImpl::flushAcks()
+{
+    std::vector<std::string> batch;
+    {
+        std::lock_guard<std::mutex> lock(ackMutex_);
+        ackTimerScheduled_ = false;
+        batch.swap(acks_);
+    }
+    if (!batch.empty())
+        sendAcks(std::move(batch));
+}
+
+void RedisStreamConsumerImpl::sendAcks(std::vector<std::string> &&ids)
+{
+    std::vector<std::string_view> argv;
+    argv.reserve(ids.size() + 3);
+    argv.emplace_back("XACK");
+    argv.emplace_back(config_.stream);
+    argv.emplace_back(config_.group);
+    for (auto &id : ids)
+    {
+        argv.emplace_back(id);
+    }
+    sender_(RedisConnection::formatCommand(argv),
+            [](const RedisResult &) {},
+            [](const RedisException &err) {
+                LOG_ERROR << "Failed to acknowledge the stream messages: "
+                          << err.what();
+            });
+}
+
+void RedisStreamConsumerImpl::parseEntries(
+    const RedisResult &entries,
+    std::vector<RedisStreamMessage> &messages)
+{
+    // [[id, [field, value, ...]], ...], the fields of a deleted entry are nil
+    for (auto &entry : entries.asArray())
+    {
+        auto idAndFields = entry.asArray();
+        if (idAndFields.size() != 2 || idAndFields[1].isNil())
+            continue;
+        auto fields = idAndFields[1].asArray();
+        RedisStreamMessage message;
+        message.id_ = idAndFields[0].asString();
+        message.fields_.reserve(fields.size() / 2);
+        for (size_t i = 0; i + 1 < fields.size(); i += 2)
+        {
+            message.fields_.emplace_back(fields[i].asString(),
+                                         fields[i + 1].asString());
+        }
+        messages.push_back(std::move(message));
+    }
+}
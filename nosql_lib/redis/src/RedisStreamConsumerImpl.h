@@ -0,0 +1,104 @@
+/**
+ *
+ *  @file RedisStreamConsumerImpl.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include "RedisConnection.h"
+#include <drogon/nosql/RedisStreamConsumer.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+class RedisStreamConsumerImpl final
+    : public RedisStreamConsumer,
+      public trantor::NonCopyable,
+      public std::enable_shared_from_this<RedisStreamConsumerImpl>
+{
+  public:
+    /// Sends a formatted command through the pool of the client
+    using Sender = std::function<void(std::string &&,
+                                      RedisResultCallback &&,
+                                      RedisExceptionCallback &&)>;
+
+    /**
+     * @param connLoop The loop of the dedicated connection, where the
+     * reading runs.
+     * @param loop The loop of the callback, connLoop if it's nullptr.
+     */
+    RedisStreamConsumerImpl(RedisStreamConsumerConfig config,
+                            RedisStreamBatchCallback &&callback,
+                            trantor::EventLoop *connLoop,
+                            trantor::EventLoop *loop,
+                            Sender sender);
+    ~RedisStreamConsumerImpl() override;
+
+    void ack(const std::string &id) override;
+    void stop() override;
+
+    bool stopped() const
+    {
+        return stopped_.load(std::memory_order_acquire);
+    }
+
+    // Called in the loop of the dedicated connection
+    void setConnection(const RedisConnectionPtr &conn);
+    void clearConnection();
+
+    /// Parse the entries of a XREADGROUP or XAUTOCLAIM reply
+    static void parseEntries(const RedisResult &entries,
+                             std::vector<RedisStreamMessage> &messages);
+
+  private:
+    void createGroup();
+    void read();
+    void onRead(const RedisResult &result);
+    void onReadError(const RedisException &err);
+    void deliver(std::vector<RedisStreamMessage> &&messages);
+    void batchDone();
+    void claim(const std::string &cursor);
+    void addAcks(std::vector<std::string> &&ids);
+    void flushAcks();
+    void sendAcks(std::vector<std::string> &&ids);
+
+    const RedisStreamConsumerConfig config_;
+    const RedisStreamBatchCallback callback_;
+    trantor::EventLoop *const connLoop_;
+    trantor::EventLoop *const loop_;
+    const Sender sender_;
+    const std::string readCommand_;
+    std::atomic<bool> stopped_{false};
+
+    // Accessed in connLoop_ only
+    RedisConnectionPtr conn_;
+    bool groupCreated_{false};
+    bool reading_{false};
+    bool paused_{false};
+    bool claiming_{false};
+    size_t pendingBatches_{0};
+    trantor::TimerId claimTimer_{0};
+
+    std::mutex ackMutex_;
+    std::vector<std::string> acks_;
+    bool ackTimerScheduled_{false};
+};
+
+}  // namespace nosql
+}  // namespace drogon
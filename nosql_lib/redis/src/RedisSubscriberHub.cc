@@ -0,0 +1,180 @@
+/**
+ *
+ *  @file RedisSubscriberHub.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RedisSubscriberHub.h"
+#include <algorithm>
+
+using namespace drogon::nosql;
+
+void RedisSubscriberHub::subscribe(uint64_t owner,
+                                   const std::string &channel,
+                                   bool isPattern,
+                                   RedisMessageCallback &&messageCallback)
+{
+    auto handler = std::make_shared<Handler>();
+    handler->owner_ = owner;
+    handler->callback_ = std::move(messageCallback);
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &slots = isPattern ? patterns_ : channels_;
+    auto &slot = slots[channel];
+    bool first = !slot;
+    if (first)
+    {
+        slot = std::make_shared<Slot>();
+    }
+    {
+        std::lock_guard<std::mutex> slotLock(slot->mutex_);
+        auto routes = slot->routes_ ? std::make_shared<Routes>(*slot->routes_)
+                                    : std::make_shared<Routes>();
+        auto iter = std::find_if(routes->begin(),
+                                 routes->end(),
+                                 [loop](const auto &route) {
+                                     return route.first == loop;
+                                 });
+        if (iter == routes->end())
+        {
+            routes->emplace_back(loop, std::vector<HandlerPtr>{});
+            iter = routes->end() - 1;
+        }
+        iter->second.emplace_back(std::move(handler));
+        slot->routes_ = std::move(routes);
+    }
+    if (!first)
+        return;
+
+    auto dispatcher = [slot = slot](const std::string &channel,
+                                    const std::string &message) {
+        dispatch(slot, channel, message);
+    };
+    if (isPattern)
+    {
+        subscriber_->psubscribe(channel, std::move(dispatcher));
+    }
+    else
+    {
+        subscriber_->subscribe(channel, std::move(dispatcher));
+    }
+}
+
+void RedisSubscriberHub::unsubscribe(uint64_t owner,
+                                     const std::string &channel,
+                                     bool isPattern)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &slots = isPattern ? patterns_ : channels_;
+    auto iter = slots.find(channel);
+    if (iter != slots.end())
+    {
+        removeHandlers(slots, iter, owner, isPattern);
+    }
+}
+
+void RedisSubscriberHub::unsubscribeAll(uint64_t owner)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto iter = channels_.begin(); iter != channels_.end();)
+    {
+        removeHandlers(channels_, iter++, owner, false);
+    }
+    for (auto iter = patterns_.begin(); iter != patterns_.end();)
+    {
+        removeHandlers(patterns_, iter++, owner, true);
+    }
+}
+
+void RedisSubscriberHub::removeHandlers(SlotMap &slots,
+                                        SlotMap::iterator iter,
+                                        uint64_t owner,
+                                        bool isPattern)
+{
+    bool empty{false};
+    {
+        auto &slot = iter->second;
+        std::lock_guard<std::mutex> slotLock(slot->mutex_);
+        auto routes = std::make_shared<Routes>();
+        bool found{false};
+        for (auto &[loop, handlers] : *slot->routes_)
+        {
+            std::vector<HandlerPtr> kept;
+            for (auto &handler : handlers)
+            {
+                if (handler->owner_ == owner)
+                {
+                    handler->active_ = false;
+                    found = true;
+                }
+                else
+                {
+                    kept.push_back(handler);
+                }
+            }
+            if (!kept.empty())
+            {
+                routes->emplace_back(loop, std::move(kept));
+            }
+        }
+        if (!found)
+            return;
+        empty = routes->empty();
+        slot->routes_ = std::move(routes);
+    }
+    if (!empty)
+        return;
+    // The last callback is gone, the channel is no longer needed
+    auto channel = iter->first;
+    slots.erase(iter);
+    if (isPattern)
+    {
+        subscriber_->punsubscribe(channel);
+    }
+    else
+    {
+        subscriber_->unsubscribe(channel);
+    }
+}
+
+void RedisSubscriberHub::dispatch(const SlotPtr &slot,
+                                  const std::string &channel,
+                                  const std::string &message)
+{
+    std::shared_ptr<const Routes> routes;
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex_);
+        routes = slot->routes_;
+    }
+    if (!routes)
+        return;
+    // Shared by the loops, the message is copied once. The callbacks are
+    // always queued, even in the loop of the connection, since the
+    // subscriber holds a lock while dispatching and a callback may
+    // unsubscribe.
+    auto payload = std::make_shared<std::pair<std::string, std::string>>(
+        channel, message);
+    for (size_t i = 0; i < routes->size(); ++i)
+    {
+        auto loop = (*routes)[i].first;
+        if (!loop)
+        {
+            loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        }
+        loop->queueInLoop([routes, i, payload]() {
+            for (auto &handler : (*routes)[i].second)
+            {
+                if (handler->active_)
+                    handler->callback_(payload->first, payload->second);
+            }
+        });
+    }
+}
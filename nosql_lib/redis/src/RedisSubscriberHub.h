@@ -0,0 +1,155 @@
+/**
+ *
+ *  @file RedisSubscriberHub.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/nosql/RedisSubscriber.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace nosql
+{
+/**
+ * @brief Demultiplexes the messages of one subscriber connection to the
+ * callbacks of many shared subscribers, grouped by event loop.
+ *
+ * A channel is subscribed on the connection while it has callbacks, a
+ * message is copied once and queued once per loop having callbacks for it.
+ */
+class RedisSubscriberHub
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<RedisSubscriberHub>
+{
+  public:
+    explicit RedisSubscriberHub(std::shared_ptr<RedisSubscriber> subscriber)
+        : subscriber_(std::move(subscriber))
+    {
+    }
+
+    /// A new id for the callbacks of a shared subscriber
+    uint64_t newOwner()
+    {
+        return ++maxOwner_;
+    }
+
+    /**
+     * @brief Add a callback delivered in the loop of the calling thread, or
+     * in the loop of the connection if the thread has no loop.
+     */
+    void subscribe(uint64_t owner,
+                   const std::string &channel,
+                   bool isPattern,
+                   RedisMessageCallback &&messageCallback);
+
+    /// Remove the callbacks of the owner for the channel or the pattern
+    void unsubscribe(uint64_t owner,
+                     const std::string &channel,
+                     bool isPattern);
+
+    /// Remove all the callbacks of the owner
+    void unsubscribeAll(uint64_t owner);
+
+  private:
+    struct Handler
+    {
+        uint64_t owner_;
+        RedisMessageCallback callback_;
+        // Cleared on unsubscription, the messages already queued are dropped
+        std::atomic<bool> active_{true};
+    };
+
+    using HandlerPtr = std::shared_ptr<Handler>;
+
+    // The handlers of a channel grouped by loop
+    using Routes =
+        std::vector<std::pair<trantor::EventLoop *, std::vector<HandlerPtr>>>;
+
+    // The routes of a channel, replaced on every change so that a message is
+    // dispatched from a snapshot. Its mutex is never held while calling the
+    // subscriber, which calls the dispatch with its own mutex held.
+    struct Slot
+    {
+        std::mutex mutex_;
+        std::shared_ptr<const Routes> routes_;
+    };
+
+    using SlotPtr = std::shared_ptr<Slot>;
+    using SlotMap = std::unordered_map<std::string, SlotPtr>;
+
+    static void dispatch(const SlotPtr &slot,
+                         const std::string &channel,
+                         const std::string &message);
+    // Must be called with mutex_ held
+    void removeHandlers(SlotMap &slots,
+                        SlotMap::iterator iter,
+                        uint64_t owner,
+                        bool isPattern);
+
+    std::shared_ptr<RedisSubscriber> subscriber_;
+    std::atomic<uint64_t> maxOwner_{0};
+    std::mutex mutex_;
+    SlotMap channels_;
+    SlotMap patterns_;
+};
+
+/// A subscriber whose callbacks are registered in a RedisSubscriberHub
+class RedisSharedSubscriber final : public RedisSubscriber
+{
+  public:
+    explicit RedisSharedSubscriber(std::shared_ptr<RedisSubscriberHub> hub)
+        : hub_(std::move(hub)), owner_(hub_->newOwner())
+    {
+    }
+
+    ~RedisSharedSubscriber() override
+    {
+        hub_->unsubscribeAll(owner_);
+    }
+
+    void subscribe(const std::string &channel,
+                   RedisMessageCallback &&messageCallback) noexcept override
+    {
+        hub_->subscribe(owner_, channel, false, std::move(messageCallback));
+    }
+
+    void psubscribe(const std::string &pattern,
+                    RedisMessageCallback &&messageCallback) noexcept override
+    {
+        hub_->subscribe(owner_, pattern, true, std::move(messageCallback));
+    }
+
+    void unsubscribe(const std::string &channel) noexcept override
+    {
+        hub_->unsubscribe(owner_, channel, false);
+    }
+
+    void punsubscribe(const std::string &pattern) noexcept override
+    {
+        hub_->unsubscribe(owner_, pattern, true);
+    }
+
+  private:
+    std::shared_ptr<RedisSubscriberHub> hub_;
+    const uint64_t owner_;
+};
+
+}  // namespace nosql
+}  // namespace drogon
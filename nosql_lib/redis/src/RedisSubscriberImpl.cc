@@ -173,6 +173,20 @@ void RedisSubscriberImpl::punsubscribe(const std::string &pattern) noexcept
     connPtr->sendUnsubscribe(subCtx);
 }
 
+void RedisSubscriberImpl::setSubscribeCallback(
+    const std::string &channel,
+    std::function<void()> &&callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = subContexts_.find(channel);
+    if (iter == subContexts_.end())
+    {
+        LOG_ERROR << "Attempt to watch the unknown channel " << channel;
+        return;
+    }
+    iter->second->setSubscribeCallback(std::move(callback));
+}
+
 void RedisSubscriberImpl::setConnection(const RedisConnectionPtr &conn)
 {
     assert(conn);
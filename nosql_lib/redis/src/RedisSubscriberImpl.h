@@ -39,6 +39,11 @@ class RedisSubscriberImpl
     void unsubscribe(const std::string &channel) noexcept override;
     void punsubscribe(const std::string &pattern) noexcept override;
 
+    // Set the callback called whenever the subscribed channel is
+    // (re)subscribed.
+    void setSubscribeCallback(const std::string &channel,
+                              std::function<void()> &&callback);
+
     // Set a connected connection to subscriber.
     void setConnection(const RedisConnectionPtr &conn);
     // Clear connection and task queue.
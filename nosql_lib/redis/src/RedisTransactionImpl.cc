@@ -40,6 +40,31 @@ void RedisTransactionImpl::execCommandAsync(
     RedisExceptionCallback &&exceptionCallback,
     std::string_view command,
     ...) noexcept
+{
+    LOG_TRACE << "redis command: " << command;
+    std::string formattedCmd;
+    va_list args;
+    va_start(args, command);
+    try
+    {
+        formattedCmd = RedisConnection::getFormattedCommand(command, args);
+    }
+    catch (const RedisException &err)
+    {
+        va_end(args);
+        exceptionCallback(err);
+        return;
+    }
+    va_end(args);
+    execFormattedCommandAsync(std::move(formattedCmd),
+                              std::move(resultCallback),
+                              std::move(exceptionCallback));
+}
+
+void RedisTransactionImpl::execFormattedCommandAsync(
+    std::string &&command,
+    RedisResultCallback &&resultCallback,
+    RedisExceptionCallback &&exceptionCallback) noexcept
 {
     if (isExecutedOrCancelled_)
     {
@@ -49,10 +74,8 @@ void RedisTransactionImpl::execCommandAsync(
     }
     if (timeout_ <= 0.0)
     {
-        va_list args;
-        va_start(args, command);
-        connPtr_->sendvCommand(
-            command,
+        connPtr_->sendFormattedCommand(
+            std::move(command),
             std::move(resultCallback),
             [thisPtr = shared_from_this(),
              exceptionCallback =
@@ -60,9 +83,7 @@ void RedisTransactionImpl::execCommandAsync(
                 LOG_ERROR << err.what();
                 thisPtr->isExecutedOrCancelled_ = true;
                 exceptionCallback(err);
-            },
-            args);
-        va_end(args);
+            });
     }
     else
     {
@@ -78,10 +99,8 @@ void RedisTransactionImpl::execCommandAsync(
                                                "Command execution timeout"));
                 }
             });
-        va_list args;
-        va_start(args, command);
-        connPtr_->sendvCommand(
-            command,
+        connPtr_->sendFormattedCommand(
+            std::move(command),
             [resultCallback = std::move(resultCallback),
              timeoutFlagPtr](const RedisResult &result) {
                 if (timeoutFlagPtr->done())
@@ -100,9 +119,7 @@ void RedisTransactionImpl::execCommandAsync(
                 thisPtr->isExecutedOrCancelled_ = true;
                 if (*expCbPtr)
                     (*expCbPtr)(err);
-            },
-            args);
-        va_end(args);
+            });
         timeoutFlagPtr->runTimer();
     }
 }
@@ -34,6 +34,10 @@ class RedisTransactionImpl final
                           RedisExceptionCallback &&exceptionCallback,
                           std::string_view command,
                           ...) noexcept override;
+    void execFormattedCommandAsync(
+        std::string &&command,
+        RedisResultCallback &&resultCallback,
+        RedisExceptionCallback &&exceptionCallback) noexcept override;
 
     std::shared_ptr<RedisSubscriber> newSubscriber() noexcept override
     {
@@ -126,6 +126,11 @@ void SubscribeContext::onSubscribe(const std::string &channel,
 {
     LOG_DEBUG << "Subscribe success to [" << channel << "], total "
               << numChannels;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscribeCallback_)
+    {
+        subscribeCallback_();
+    }
 }
 
 void SubscribeContext::onUnsubscribe(const std::string &channel,
@@ -59,6 +59,13 @@ class SubscribeContext
         messageCallbacks_.emplace_back(std::move(messageCallback));
     }
 
+    /// Called whenever the channel is (re)subscribed
+    void setSubscribeCallback(std::function<void()> &&callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribeCallback_ = std::move(callback);
+    }
+
     void disable()
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -109,6 +116,7 @@ class SubscribeContext
     std::string unsubscribeCommand_;
     std::mutex mutex_;
     std::list<RedisMessageCallback> messageCallbacks_;
+    std::function<void()> subscribeCallback_;
     bool disabled_{false};
 };
 
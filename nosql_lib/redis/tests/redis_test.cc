@@ -1,7 +1,9 @@
 #define DROGON_TEST_MAIN
+#include "../../../lib/src/RedisRateLimiter.h"
 #include <drogon/nosql/RedisClient.h>
 #include <drogon/drogon_test.h>
 #include <drogon/drogon.h>
+#include <atomic>
 #include <iostream>
 #include <thread>
 
@@ -181,6 +183,308 @@ DROGON_TEST(RedisTest)
     {
         MANDATE(err.what());
     }
+
+    // 13. Test pipeline, an error reply doesn't fail the other commands
+    auto pipeline = redisClient->newPipeline();
+    REQUIRE(pipeline != nullptr);
+    pipeline->add("set %s %s", "pipeline_key", "drogon")
+        .add("get %s %s", "pipeline_key", "pipeline_key")
+        .add("get %s", "pipeline_key");
+    MANDATE(pipeline->size() == 3UL);
+    pipeline->execute(
+        [TEST_CTX](const std::vector<RedisResult> &results) {
+            MANDATE(results.size() == 3UL);
+            MANDATE(results[0].asString() == "OK");
+            MANDATE(results[1].type() == RedisResultType::kError);
+            MANDATE(results[2].asString() == "drogon");
+        },
+        [TEST_CTX](const RedisException &err) { MANDATE(err.what()); });
+    MANDATE(pipeline->size() == 0UL);
+
+    // 14. Test typed decode
+    try
+    {
+        redisClient->execCommandSync(
+            [](const RedisResult &r) { return r.asInteger(); },
+            "hset %s %s %s %s %s",
+            "decode_hash",
+            "name",
+            "drogon",
+            "stars",
+            "100");
+        auto fields = redisClient->execCommandSync(
+            [](const RedisResult &r) {
+                return r.as<std::map<std::string, std::string>>();
+            },
+            "hgetall %s",
+            "decode_hash");
+        MANDATE(fields.size() == 2UL);
+        MANDATE(fields["name"] == "drogon");
+        auto values = redisClient->execCommandSync(
+            [](const RedisResult &r) {
+                return r.as<std::vector<std::optional<long long>>>();
+            },
+            "hmget %s %s %s",
+            "decode_hash",
+            "stars",
+            "nothing");
+        MANDATE(values.size() == 2UL);
+        MANDATE(values[0] == 100);
+        MANDATE(!values[1].has_value());
+        auto json = redisClient->execCommandSync(
+            [](const RedisResult &r) { return r.asJson(); },
+            "hmget %s %s",
+            "decode_hash",
+            "name");
+        MANDATE(json[0].asString() == "drogon");
+    }
+    catch (const RedisException &err)
+    {
+        MANDATE(err.what());
+    }
+
+    // 15. Test registered scripts, NOSCRIPT after a flush falls back to EVAL
+    redisClient->execCommandSync([](const RedisResult &) { return 0; },
+                                 "del %s",
+                                 "script_key");
+    redisClient->registerScript(
+        "incr_by", "return redis.call('INCRBY', KEYS[1], ARGV[1])");
+    redisClient->execScriptAsync(
+        [TEST_CTX](const RedisResult &r) {
+            MANDATE(r.asInteger() == 5);
+            redisClient->execCommandAsync(
+                [TEST_CTX](const RedisResult &) {
+                    redisClient->execScriptAsync(
+                        [TEST_CTX](const RedisResult &r) {
+                            MANDATE(r.asInteger() == 7);
+                        },
+                        [TEST_CTX](const RedisException &err) {
+                            MANDATE(err.what());
+                        },
+                        "incr_by",
+                        "1 %s %d",
+                        "script_key",
+                        2);
+                },
+                [TEST_CTX](const RedisException &err) { MANDATE(err.what()); },
+                "script flush");
+        },
+        [TEST_CTX](const RedisException &err) { MANDATE(err.what()); },
+        "incr_by",
+        "1 %s %d",
+        "script_key",
+        5);
+    redisClient->execScriptAsync(
+        [TEST_CTX](const RedisResult &) { MANDATE(false); },
+        [TEST_CTX](const RedisException &err) {
+            MANDATE(err.code() == RedisErrorCode::kBadType);
+        },
+        "unknown_script",
+        "0");
+
+    // 16. Test binary safe arguments without a format string
+    std::string binary("a b\0c", 5);
+    redisClient->execArgsAsync(
+        [TEST_CTX, binary](const RedisResult &) {
+            redisClient->execArgsAsync(
+                [TEST_CTX, binary](const RedisResult &r) {
+                    MANDATE(r.asString() == binary);
+                },
+                [TEST_CTX](const RedisException &err) { MANDATE(err.what()); },
+                "GET",
+                "binary_key");
+        },
+        [TEST_CTX](const RedisException &err) { MANDATE(err.what()); },
+        "SET",
+        "binary_key",
+        binary);
+    auto argsPipeline = redisClient->newPipeline();
+    argsPipeline->addArgs("RPUSH", "args_list", std::vector<int>{1, 2, 3})
+        .addArgs("LRANGE", "args_list", 0, -1)
+        .addArgs("DEL", "args_list");
+    argsPipeline->execute(
+        [TEST_CTX](const std::vector<RedisResult> &results) {
+            MANDATE(results[0].asInteger() == 3);
+            MANDATE(results[1].asArray()[2].asString() == "3");
+        },
+        [TEST_CTX](const RedisException &err) { MANDATE(err.what()); });
+}
+
+DROGON_TEST(RedisNearCacheTest)
+{
+    auto client = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 6379), 1);
+    client->enableNearCache({"near_cache:"});
+    auto writer = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 6379), 1);
+    auto asString = [](const RedisResult &r) { return r.asString(); };
+    try
+    {
+        writer->execCommandSync(asString, "set %s %s", "near_cache:k", "on");
+        // Wait for the tracking connection to subscribe
+        std::this_thread::sleep_for(500ms);
+        MANDATE(client->execCommandSync(asString, "get %s", "near_cache:k") ==
+                "on");
+        MANDATE(client->execCommandSync(asString, "get %s", "near_cache:k") ==
+                "on");
+        writer->execCommandSync(asString, "set %s %s", "near_cache:k", "off");
+        // Wait for the invalidation message
+        std::this_thread::sleep_for(200ms);
+        MANDATE(client->execCommandSync(asString, "get %s", "near_cache:k") ==
+                "off");
+        writer->execCommandSync([](const RedisResult &) { return 0; },
+                                "del %s",
+                                "near_cache:k");
+    }
+    catch (const RedisException &err)
+    {
+        FAULT(err.what());
+    }
+}
+
+DROGON_TEST(RedisStreamConsumerTest)
+{
+    auto client = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 6379), 1);
+    auto toInt = [](const RedisResult &r) { return r.asInteger(); };
+    try
+    {
+        client->execCommandSync(toInt, "del %s", "stream_test");
+        RedisStreamConsumerConfig config;
+        config.stream = "stream_test";
+        config.group = "workers";
+        config.consumer = "worker_1";
+        config.batchSize = 16;
+        config.blockMs = 100;
+        config.createGroupFrom = "0";
+        auto received = std::make_shared<std::atomic<size_t>>(0);
+        auto consumer = client->newStreamConsumer(
+            config,
+            [received](const std::vector<RedisStreamMessage> &messages) {
+                *received += messages.size();
+            });
+        REQUIRE(consumer != nullptr);
+        for (int i = 0; i < 100; ++i)
+        {
+            client->execCommandSync(
+                [](const RedisResult &r) { return r.asString(); },
+                "xadd %s * n %d",
+                "stream_test",
+                i);
+        }
+        std::this_thread::sleep_for(1s);
+        MANDATE(*received == 100UL);
+        // All the messages are acknowledged in batches
+        auto pending = client->execCommandSync(
+            [](const RedisResult &r) { return r.asArray()[0].asInteger(); },
+            "xpending %s %s",
+            "stream_test",
+            "workers");
+        MANDATE(pending == 0);
+        consumer->stop();
+        client->execCommandSync(toInt, "del %s", "stream_test");
+    }
+    catch (const RedisException &err)
+    {
+        FAULT(err.what());
+    }
+}
+
+DROGON_TEST(RedisRateLimiterLeaseTest)
+{
+    auto client = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 6379), 1);
+    try
+    {
+        client->execCommandSync([](const RedisResult &r) { return 0; },
+                                "del %s",
+                                "rate_limiter_test");
+    }
+    catch (const RedisException &err)
+    {
+        FAULT(err.what());
+    }
+    // Two instances share the counter, they lease 2 tokens at a time
+    auto first = std::make_shared<drogon::RedisRateLimiter>(
+        client, "rate_limiter_test", 10, 1h, 2);
+    auto second = std::make_shared<drogon::RedisRateLimiter>(
+        client, "rate_limiter_test", 10, 1h, 2);
+    // The first request of each instance is allowed while its lease is in
+    // flight and paid by it, the leases then come back between the requests.
+    // Together they allow the capacity, no more.
+    size_t allowed{0};
+    for (int i = 0; i < 15; ++i)
+    {
+        if (first->isAllowed())
+            ++allowed;
+        std::this_thread::sleep_for(20ms);
+        if (second->isAllowed())
+            ++allowed;
+        std::this_thread::sleep_for(20ms);
+    }
+    CHECK(allowed == 10UL);
+    // The window is used up, no instance leases again until it ends
+    CHECK(first->isAllowed() == false);
+    CHECK(second->isAllowed() == false);
+    try
+    {
+        auto ttl = client->execCommandSync(
+            [](const RedisResult &r) { return r.asInteger(); },
+            "pttl %s",
+            "rate_limiter_test");
+        CHECK(ttl > 0);
+        client->execCommandSync([](const RedisResult &r) { return 0; },
+                                "del %s",
+                                "rate_limiter_test");
+    }
+    catch (const RedisException &err)
+    {
+        FAULT(err.what());
+    }
+}
+
+DROGON_TEST(RedisRateLimiterFallbackTest)
+{
+    // Nothing listens on the port, the lease times out
+    auto client = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 1), 1);
+    client->setTimeout(0.3);
+    auto limiter = std::make_shared<drogon::RedisRateLimiter>(
+        client, "rate_limiter_test", 5, 1h, 2);
+    // While the first lease is in flight, up to one batch is allowed on debt
+    CHECK(limiter->isAllowed() == true);
+    CHECK(limiter->isAllowed() == true);
+    CHECK(limiter->isAllowed() == false);
+    std::this_thread::sleep_for(1s);
+    // The lease failed, the debt is dropped and the local limiter allows the
+    // capacity for the rest of the time unit
+    size_t allowed{0};
+    for (int i = 0; i < 8; ++i)
+    {
+        if (limiter->isAllowed())
+            ++allowed;
+    }
+    CHECK(allowed == 5UL);
+}
+
+DROGON_TEST(RedisRateLimiterFallbackEndTest)
+{
+    auto client = drogon::nosql::RedisClient::newRedisClient(
+        trantor::InetAddress("127.0.0.1", 1), 1);
+    client->setTimeout(0.1);
+    auto limiter = std::make_shared<drogon::RedisRateLimiter>(
+        client, "rate_limiter_test", 2, 500ms, 1);
+    CHECK(limiter->isAllowed() == true);
+    std::this_thread::sleep_for(300ms);
+    // Falling back for the time unit
+    CHECK(limiter->isAllowed() == true);
+    CHECK(limiter->isAllowed() == true);
+    CHECK(limiter->isAllowed() == false);
+    std::this_thread::sleep_for(600ms);
+    // Leasing again once the time unit is over, on debt while the lease is
+    // in flight
+    CHECK(limiter->isAllowed() == true);
+    CHECK(limiter->isAllowed() == false);
 }
 
 int main(int argc, char **argv)
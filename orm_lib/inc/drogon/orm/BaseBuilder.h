@@ -16,6 +16,7 @@
 
 #include <drogon/orm/Criteria.h>
 #include <drogon/orm/DbClient.h>
+#include <drogon/orm/PreparedQuery.h>
 #include <string_view>
 #include <future>
 #include <memory>
@@ -245,6 +246,21 @@ class BaseBuilder
         binder.exec();
         return prom->get_future();
     }
+
+    /**
+     * @brief Render the SQL of the query once, to execute it many times
+     * without building it again, see PreparedQuery.
+     *
+     * @return PreparedQuery<ResultType> The query, whose parameters are the
+     * values of the filters.
+     */
+    inline PreparedQuery<ResultType> prepare() const
+    {
+        return {gen_sql(ClientType::PostgreSQL),
+                gen_sql(ClientType::Mysql),
+                gen_args(),
+                &convert_result};
+    }
 };
 }  // namespace orm
 }  // namespace drogon
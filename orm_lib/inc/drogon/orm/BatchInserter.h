@@ -0,0 +1,324 @@
+/**
+ *
+ *  @file BatchInserter.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <drogon/orm/Mapper.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+template <typename T>
+class BatchInserter;
+
+namespace internal
+{
+#ifdef __cpp_impl_coroutine
+template <typename T>
+struct [[nodiscard]] BatchInsertAwaiter : public CallbackAwaiter<void>
+{
+    BatchInsertAwaiter(std::shared_ptr<BatchInserter<T>> inserter, T &&obj)
+        : inserter_(std::move(inserter)), obj_(std::move(obj))
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        inserter_->insertAsync(
+            std::move(obj_),
+            [handle]() { handle.resume(); },
+            [handle, this](const std::exception_ptr &e) {
+                setException(e);
+                handle.resume();
+            });
+    }
+
+  private:
+    std::shared_ptr<BatchInserter<T>> inserter_;
+    T obj_;
+};
+#endif
+}  // namespace internal
+
+/**
+ * @brief A write-behind queue which coalesces the rows inserted one at a time
+ * into multi-row insert statements.
+ *
+ * Many requests that each insert one row (events, logs, audit records) cost
+ * a statement and a commit each. The rows given to an inserter are queued and
+ * written together once maxRows rows are queued or maxDelay seconds after the
+ * first of them, and the callback of every row is called when its statement
+ * is committed. This trades a few milliseconds of latency for a much lower
+ * load of the database.
+ *
+ * @code
+   // Shared by all the handlers, e.g. created in a beginning advice
+   auto events = BatchInserter<Event>::newInserter(
+       app().getDbClient(), app().getLoop(), 500, 0.005);
+   events->insert(event, []() { ... }, [](const DrogonDbException &e) { ... });
+   co_await events->insertCoro(std::move(event));
+   @endcode
+ *
+ * The rows are written with Mapper<T>::insertMany(), so a batch is split into
+ * several statements when its rows have different columns or exceed the
+ * parameter limit of the database. When a statement of several rows fails,
+ * its rows are written again one by one, so only the invalid rows fail.
+ *
+ * @note The auto-increased primary keys are not set to the objects.
+ */
+template <typename T>
+class BatchInserter : public std::enable_shared_from_this<BatchInserter<T>>,
+                      public trantor::NonCopyable
+{
+  public:
+    using DoneCallback = std::function<void()>;
+
+    /**
+     * @param client The client which executes the statements.
+     * @param loop The loop of the timer which writes the rows after
+     * maxDelay, without it the rows are only written by maxRows and flush().
+     * @param maxRows The number of queued rows which are written at once.
+     * @param maxDelay The longest time in seconds a row is queued.
+     */
+    BatchInserter(DbClientPtr client,
+                  trantor::EventLoop *loop,
+                  size_t maxRows,
+                  double maxDelay)
+        : client_(std::move(client)),
+          loop_(loop),
+          maxRows_(maxRows == 0 ? 1 : maxRows),
+          maxDelay_(maxDelay)
+    {
+    }
+
+    ~BatchInserter()
+    {
+        std::shared_ptr<Batch> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch = std::move(queued_);
+        }
+        if (batch)
+            write(client_, std::move(batch));
+    }
+
+    static std::shared_ptr<BatchInserter<T>> newInserter(
+        DbClientPtr client,
+        trantor::EventLoop *loop,
+        size_t maxRows = 500,
+        double maxDelay = 0.005)
+    {
+        return std::make_shared<BatchInserter<T>>(std::move(client),
+                                                  loop,
+                                                  maxRows,
+                                                  maxDelay);
+    }
+
+    /**
+     * @brief Queue a row.
+     *
+     * @param rcb is called when the row is committed.
+     * @param ecb is called when the row fails.
+     */
+    void insert(T obj, DoneCallback rcb, ExceptionCallback ecb) noexcept
+    {
+        insertAsync(std::move(obj),
+                    std::move(rcb),
+                    [ecb = std::move(ecb)](const std::exception_ptr &e) {
+                        try
+                        {
+                            std::rethrow_exception(e);
+                        }
+                        catch (const DrogonDbException &err)
+                        {
+                            ecb(err);
+                        }
+                    });
+    }
+
+    /// Queue a row, the future is ready when the row is committed
+    std::future<void> insertFuture(T obj) noexcept
+    {
+        auto prom = std::make_shared<std::promise<void>>();
+        insertAsync(
+            std::move(obj),
+            [prom]() { prom->set_value(); },
+            [prom](const std::exception_ptr &e) { prom->set_exception(e); });
+        return prom->get_future();
+    }
+
+#ifdef __cpp_impl_coroutine
+    /// Queue a row, the coroutine is resumed when the row is committed
+    internal::BatchInsertAwaiter<T> insertCoro(T obj)
+    {
+        return internal::BatchInsertAwaiter<T>(this->shared_from_this(),
+                                               std::move(obj));
+    }
+#endif
+
+    /// Queue a row, the callbacks of insert() with the exception as is
+    void insertAsync(
+        T &&obj,
+        DoneCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&ecb) noexcept
+    {
+        std::shared_ptr<Batch> full;
+        bool first{false};
+        uint64_t sequence;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!queued_)
+            {
+                queued_ = std::make_shared<Batch>();
+                queued_->objs.reserve(maxRows_);
+                first = true;
+            }
+            queued_->objs.push_back(std::move(obj));
+            queued_->callbacks.emplace_back(std::move(rcb), std::move(ecb));
+            sequence = sequence_;
+            if (queued_->objs.size() >= maxRows_)
+            {
+                full = std::move(queued_);
+                ++sequence_;
+            }
+        }
+        if (full)
+        {
+            write(client_, std::move(full));
+            return;
+        }
+        if (first && loop_)
+        {
+            std::weak_ptr<BatchInserter<T>> weakPtr = this->shared_from_this();
+            loop_->runAfter(maxDelay_, [weakPtr, sequence]() {
+                if (auto thisPtr = weakPtr.lock())
+                    thisPtr->flush(sequence);
+            });
+        }
+    }
+
+    /// Write the queued rows now
+    void flush() noexcept
+    {
+        std::shared_ptr<Batch> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!queued_)
+                return;
+            batch = std::move(queued_);
+            ++sequence_;
+        }
+        write(client_, std::move(batch));
+    }
+
+    /// The number of rows waiting for their batch
+    size_t queued() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queued_ ? queued_->objs.size() : 0;
+    }
+
+  private:
+    struct Batch
+    {
+        std::vector<T> objs;
+        std::vector<
+            std::pair<DoneCallback,
+                      std::function<void(const std::exception_ptr &)>>>
+            callbacks;
+    };
+
+    // Gives access to the multi-row statements of Mapper<T>
+    class Statements : public Mapper<T>
+    {
+      public:
+        explicit Statements(const DbClientPtr &client) : Mapper<T>(client)
+        {
+        }
+
+        using Mapper<T>::insertManyStatements;
+    };
+
+    // Flush the batch of the timer unless it was written already
+    void flush(uint64_t sequence)
+    {
+        std::shared_ptr<Batch> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (sequence != sequence_ || !queued_)
+                return;
+            batch = std::move(queued_);
+            ++sequence_;
+        }
+        write(client_, std::move(batch));
+    }
+
+    static void write(const DbClientPtr &client, std::shared_ptr<Batch> batch)
+    {
+        Statements statements(client);
+        for (auto &[sql, rows] : statements.insertManyStatements(batch->objs))
+        {
+            std::vector<size_t> indexes;
+            indexes.reserve(rows.size());
+            auto binder = *client << std::move(sql);
+            for (auto obj : rows)
+            {
+                indexes.push_back(obj - batch->objs.data());
+                obj->outputArgs(binder);
+            }
+            binder >> [batch, indexes](const Result &) {
+                for (auto i : indexes)
+                    batch->callbacks[i].first();
+            };
+            binder >> [client, batch, indexes](const std::exception_ptr &e) {
+                if (indexes.size() == 1)
+                {
+                    batch->callbacks[indexes[0]].second(e);
+                    return;
+                }
+                // Find the invalid rows
+                for (auto i : indexes)
+                {
+                    auto single = std::make_shared<Batch>();
+                    single->objs.push_back(batch->objs[i]);
+                    single->callbacks.push_back(
+                        std::move(batch->callbacks[i]));
+                    write(client, std::move(single));
+                }
+            };
+        }
+    }
+
+    const DbClientPtr client_;
+    trantor::EventLoop *const loop_;
+    const size_t maxRows_;
+    const double maxDelay_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<Batch> queued_;
+    // Incremented every time the queued rows are taken
+    uint64_t sequence_{0};
+};
+
+}  // namespace orm
+}  // namespace drogon
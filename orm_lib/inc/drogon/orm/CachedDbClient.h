@@ -0,0 +1,81 @@
+/**
+ *
+ *  @file CachedDbClient.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/orm/DbClient.h>
+#include <drogon/orm/DbListener.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+namespace orm
+{
+class CachedDbClient;
+using CachedDbClientPtr = std::shared_ptr<CachedDbClient>;
+
+/// A client caching the results of the read-only queries of another client
+/**
+ * The results are keyed by the SQL statement and the bytes of its bound
+ * parameters, and tagged with the tables the statement reads (the names
+ * following FROM and JOIN, without the schema). A cached result is shared by
+ * all the hits, whose callbacks are called in the calling thread.
+ *
+ * A cached result is dropped when its time to live expires or when one of
+ * its tables is invalidated. The writes sent through this client invalidate
+ * the tables they mention, the other writes (from transactions, other
+ * clients or other processes) must be signalled by invalidate() or by
+ * notifications, see invalidateOn().
+ *
+ * @note Only cache the queries that are deterministic for a given state of
+ * their tables, e.g. not the ones calling now() or random().
+ */
+class DROGON_EXPORT CachedDbClient : public DbClient
+{
+  public:
+    /// Create a new cached client
+    /**
+     * @param client: The client executing the queries.
+     * @param ttl: The time to live of the cached results in seconds.
+     * @param capacity: The maximum number of cached results, the least
+     * recently used one is dropped beyond it.
+     */
+    static CachedDbClientPtr newCachedClient(DbClientPtr client,
+                                             double ttl,
+                                             size_t capacity = 1024);
+
+    /// Drop the results of the queries reading the table
+    /**
+     * @param table: The name of the table without the schema, in lower case
+     * unless the table is always quoted in the queries.
+     */
+    virtual void invalidate(const std::string &table) = 0;
+
+    /// Drop all the cached results
+    virtual void invalidateAll() = 0;
+
+    /// Invalidate the tables named by the notifications on the channel
+    /**
+     * Every notification payload is a table name, an empty payload
+     * invalidates all the results. With PostgreSQL, a trigger calling
+     * pg_notify('channel', TG_TABLE_NAME) after the writes of a table keeps
+     * the cache coherent without polling.
+     */
+    virtual void invalidateOn(const DbListenerPtr &listener,
+                              const std::string &channel) = 0;
+};
+
+}  // namespace orm
+}  // namespace drogon
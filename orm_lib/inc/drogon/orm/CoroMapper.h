@@ -38,17 +38,18 @@ struct [[nodiscard]] MapperAwaiter : public CallbackAwaiter<ReturnType>
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle)
+    bool await_suspend(std::coroutine_handle<> handle)
     {
         function_(
             [handle, this](ReturnType result) {
                 this->setValue(std::move(result));
-                handle.resume();
+                this->resumeIfSuspended(handle);
             },
             [handle, this](const std::exception_ptr &e) {
                 this->setException(e);
-                handle.resume();
+                this->resumeIfSuspended(handle);
             });
+        return this->suspendUnlessCompleted();
     }
 
   private:
@@ -116,7 +117,7 @@ class CoroMapper : public Mapper<T>
                     }
                     else
                     {
-                        callback(T(r[0]));
+                        callback(internal::firstRowToModel<T>(r));
                     }
                 };
                 binder >> std::move(errCallback);
@@ -200,6 +201,42 @@ class CoroMapper : public Mapper<T>
         return *this;
     }
 
+    /**
+     * @brief Seek the rows after a row of a previous page in the order of a
+     * column, see Mapper::seek().
+     *
+     * @return CoroMapper<T>& The CoroMapper itself.
+     */
+    template <typename V>
+    CoroMapper<T> &seek(const std::string &colName,
+                        V &&lastValue,
+                        const SortOrder &order = SortOrder::ASC)
+    {
+        Mapper<T>::seek(colName, std::forward<V>(lastValue), order);
+        return *this;
+    }
+
+    /**
+     * @brief Seek the rows after a row of a previous page in the order of a
+     * column and of a unique column breaking its ties, see Mapper::seek().
+     *
+     * @return CoroMapper<T>& The CoroMapper itself.
+     */
+    template <typename V1, typename V2>
+    CoroMapper<T> &seek(const std::string &colName,
+                        V1 &&lastValue,
+                        const std::string &tieColName,
+                        V2 &&lastTieValue,
+                        const SortOrder &order = SortOrder::ASC)
+    {
+        Mapper<T>::seek(colName,
+                        std::forward<V1>(lastValue),
+                        tieColName,
+                        std::forward<V2>(lastTieValue),
+                        order);
+        return *this;
+    }
+
     /**
      * @brief Lock the result for updating.
      *
@@ -296,7 +333,7 @@ class CoroMapper : public Mapper<T>
                     }
                     else
                     {
-                        callback(T(r[0]));
+                        callback(internal::firstRowToModel<T>(r));
                     }
                 };
             binder >> std::move(errCallback);
@@ -309,14 +346,15 @@ class CoroMapper : public Mapper<T>
     {
         auto lb = [this, criteria](MultipleRowsCallback &&callback,
                                    ExceptPtrCallback &&errCallback) {
+            auto condition = this->withSeek(criteria);
             std::string sql = "select * from ";
             sql += T::tableName;
             bool hasParameters = false;
-            if (criteria)
+            if (condition)
             {
                 hasParameters = true;
                 sql += " where ";
-                sql += criteria.criteriaString();
+                sql += condition.criteriaString();
             }
             sql.append(this->orderByString_);
             if (this->limit_ > 0)
@@ -336,26 +374,41 @@ class CoroMapper : public Mapper<T>
                 sql += " for update";
             }
             auto binder = *(this->client_) << std::move(sql);
-            if (criteria)
-                criteria.outputArgs(binder);
+            if (condition)
+                condition.outputArgs(binder);
             if (this->limit_ > 0)
                 binder << this->limit_;
             if (this->offset_)
                 binder << this->offset_;
             this->clear();
             binder >> [callback = std::move(callback)](const Result &r) {
-                std::vector<T> ret;
-                for (auto const &row : r)
-                {
-                    ret.push_back(T(row));
-                }
-                callback(ret);
+                callback(internal::resultToModels<T>(r));
             };
             binder >> std::move(errCallback);
         };
         return internal::MapperAwaiter<std::vector<T>>(std::move(lb));
     }
 
+    /**
+     * @brief Select the rows whose column has one of the given values, see
+     * Mapper::findIn().
+     */
+    template <typename V>
+    inline internal::MapperAwaiter<std::vector<T>> findIn(
+        const std::string &colName,
+        std::vector<V> keys)
+    {
+        auto lb = [this, colName, keys = std::move(keys)](
+                      MultipleRowsCallback &&callback,
+                      ExceptPtrCallback &&errCallback) mutable {
+            this->findInAsync(colName,
+                              std::move(keys),
+                              std::move(callback),
+                              std::move(errCallback));
+        };
+        return internal::MapperAwaiter<std::vector<T>>(std::move(lb));
+    }
+
     inline internal::MapperAwaiter<T> insert(const T &obj)
     {
         auto lb = [this, obj](SingleRowCallback &&callback,
@@ -377,7 +430,7 @@ class CoroMapper : public Mapper<T>
                     if (needSelection)
                     {
                         assert(r.size() == 1);
-                        callback(T(r[0]));
+                        callback(internal::firstRowToModel<T>(r));
                     }
                     else
                     {
@@ -411,6 +464,18 @@ class CoroMapper : public Mapper<T>
         return internal::MapperAwaiter<T>(std::move(lb));
     }
 
+    inline internal::MapperAwaiter<size_t> insertMany(
+        const std::vector<T> &objs)
+    {
+        // The arguments are bound before the awaiter suspends, the objects
+        // outlive the co_await expression
+        auto lb = [this, &objs](CountCallback &&callback,
+                                ExceptPtrCallback &&errCallback) {
+            this->insertManyAsync(objs, callback, errCallback);
+        };
+        return internal::MapperAwaiter<size_t>(std::move(lb));
+    }
+
     inline internal::MapperAwaiter<size_t> update(const T &obj)
     {
         auto lb = [this, obj](CountCallback &&callback,
@@ -26,6 +26,9 @@
 #include <functional>
 #include <future>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/NonCopyable.h>
 
@@ -39,31 +42,60 @@ namespace orm
 {
 using ResultCallback = std::function<void(const Result &)>;
 using ExceptionCallback = std::function<void(const DrogonDbException &)>;
+/// The callback type of streaming queries. See DbClient::execSqlStreamAsync()
+using RowChunkCallback = std::function<
+    void(const Result &rows, bool isLast, std::function<void()> &&resume)>;
 
 class Transaction;
 class DbClient;
 
 namespace internal
 {
+template <typename T>
+using StreamParameterType =
+    std::conditional_t<std::is_same_v<std::decay_t<T>, const char *> ||
+                           std::is_same_v<std::decay_t<T>, char *>,
+                       std::string,
+                       std::decay_t<T> >;
+
 #ifdef __cpp_impl_coroutine
-struct [[nodiscard]] SqlAwaiter : public CallbackAwaiter<Result>
+struct [[nodiscard]] SqlAwaiter
+    : public drogon::internal::DeadlineAwaiter<Result>
 {
     explicit SqlAwaiter(internal::SqlBinder &&binder)
         : binder_(std::move(binder))
     {
     }
 
-    void await_suspend(std::coroutine_handle<> handle)
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle)
     {
-        binder_ >> [handle, this](const drogon::orm::Result &result) {
+        auto done = armDeadline(handle, []() {
+            return std::make_exception_ptr(
+                TimeoutError("The deadline of the request is exceeded"));
+        });
+        if (!done)
+            return false;
+        binder_ >> [handle, this, done](const drogon::orm::Result &result) {
+            if (!complete(done))
+                return;
             setValue(result);
-            handle.resume();
+            resumeIfSuspended(handle);
         };
-        binder_ >> [handle, this](const std::exception_ptr &e) {
+        binder_ >> [handle, this, done](const std::exception_ptr &e) {
+            if (!complete(done))
+                return;
             setException(e);
-            handle.resume();
+            resumeIfSuspended(handle);
         };
-        binder_.exec();
+        {
+            // The statement is a child span of the trace of the coroutine
+            drogon::internal::TraceScope traceScope(
+                drogon::internal::traceContextOf(handle));
+            binder_.exec();
+        }
+        // A result cache hit completes in exec()
+        return suspendUnlessCompleted();
     }
 
   private:
@@ -87,6 +119,21 @@ struct [[nodiscard]] TransactionAwaiter
 
 }  // namespace internal
 
+/// The state of the connections of a client, see DbClient::poolStatus()
+struct DbPoolStatus
+{
+    /// The connections established
+    size_t connections{0};
+    /// The connections running a query or a transaction
+    size_t busy{0};
+    /// The connections ready for a query
+    size_t idle{0};
+    /// The queries waiting for a connection
+    size_t queued{0};
+    /// The transactions waiting for a connection
+    size_t queuedTransactions{0};
+};
+
 /// Database client abstract class
 class DROGON_EXPORT DbClient : public trantor::NonCopyable
 {
@@ -113,20 +160,81 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
      * - client_encoding: The character set to be used on database connections.
      *
      * For other key words on PostgreSQL, see the PostgreSQL documentation.
-     * Only a pair of key values is valid for Sqlite3, and its keyword is
-     * 'filename'.
+     * The keyword of the database file for Sqlite3 is 'filename', the
+     * 'journal_mode', 'synchronous', 'busy_timeout' and 'query_only' pragmas
+     * can be set by the keywords of the same names.
      *
      * @param connNum: The number of connections to database server;
+     * @param autoBatch: Send queries in the pipeline mode of libpq (>= 14).
+     * @param binaryResults: Request results in the binary format. Numbers,
+     * booleans and dates are then decoded without parsing text in
+     * Field::as<T>() and bytea values are not hex encoded. A query without
+     * parameters must then contain a single statement.
+     * @param preparedStatements: (MySQL only) Execute the queries with
+     * parameters as prepared statements, which are cached per connection.
      */
     static std::shared_ptr<DbClient> newPgClient(const std::string &connInfo,
                                                  size_t connNum,
-                                                 bool autoBatch = false);
-    static std::shared_ptr<DbClient> newMysqlClient(const std::string &connInfo,
-                                                    size_t connNum);
+                                                 bool autoBatch = false,
+                                                 bool binaryResults = false);
+    static std::shared_ptr<DbClient> newMysqlClient(
+        const std::string &connInfo,
+        size_t connNum,
+        bool preparedStatements = false);
     static std::shared_ptr<DbClient> newSqlite3Client(
         const std::string &connInfo,
         size_t connNum);
 
+    /// Create a SQLite client with one writer and several reader connections
+    /**
+     * The database is switched to the WAL journal mode, so the read-only
+     * queries run in parallel on the readConnNum reader connections without
+     * waiting for the writes. The writes and the transactions are serialized
+     * on the writer connection. Every connection caches its own prepared
+     * statements.
+     *
+     * @param connInfo: The connection string of newSqlite3Client().
+     * @param readConnNum: The number of reader connections.
+     * @param batchWrites: Commit the queries that pile up behind a busy
+     * writer in one transaction (up to 64 queries), which saves a disk sync
+     * per query. A failed query is rolled back alone, but the callbacks are
+     * only called when the whole batch is committed.
+     */
+    static std::shared_ptr<DbClient> newSqlite3WalClient(
+        const std::string &connInfo,
+        size_t readConnNum,
+        bool batchWrites = false);
+
+    /// Create a client that sends read-only queries to replicas
+    /**
+     * @param primary: The client of the primary server, it executes the
+     * transactions and all queries that are not recognized as read-only.
+     * @param replicas: The clients of the replica servers. A read-only query
+     * (SELECT, WITH, SHOW, VALUES or TABLE without any keyword that writes or
+     * locks) is sent to the healthy replica with the fewest outstanding
+     * queries, or to the primary if there is none.
+     * @param maxReplicaLag: The replicas are checked every second, a replica
+     * is unhealthy if the check fails or, with PostgreSQL, if it replays the
+     * WAL more than maxReplicaLag seconds behind the primary. A negative
+     * value disables the lag check.
+     *
+     * @note Queries sent to replicas may not see the latest writes, use
+     * newReadYourWritesSession() when this matters.
+     */
+    static std::shared_ptr<DbClient> newReplicatedClient(
+        std::shared_ptr<DbClient> primary,
+        std::vector<std::shared_ptr<DbClient>> replicas,
+        double maxReplicaLag = -1.0);
+
+    /**
+     * @brief Return a client for a request or session that sends all its
+     * queries to the primary server once it has written something, so it
+     * always reads its own writes. Return the client itself if it has no
+     * replicas.
+     */
+    static std::shared_ptr<DbClient> newReadYourWritesSession(
+        const std::shared_ptr<DbClient> &client);
+
     /// Async and nonblocking method
     /**
      * @param sql is the SQL statement to be executed;
@@ -238,6 +346,52 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
     }
 #endif
 
+    /// Execute a query and deliver its rows in chunks
+    /**
+     * @param sql is the SQL query, it must be a single statement;
+     * @param chunkRows is the maximum number of rows in one chunk;
+     * @param chunkCallback is called with every chunk of rows. The next chunk
+     * is not requested from the server before the resume function passed to
+     * the callback is called, so the consumer controls the pace (e.g. resume
+     * once a response stream has drained). Dropping the resume function
+     * without calling it cancels the query. The last chunk has the isLast
+     * flag set and may be empty;
+     * @param exceptCallback is called if the query fails;
+     * @param args are parameters that are bound to placeholders in the sql
+     * parameter;
+     *
+     * @note The query runs in a dedicated transaction which holds one
+     * connection until the last chunk has been delivered. With PostgreSQL the
+     * rows are fetched from a server-side cursor, so only one chunk is held
+     * in memory at a time. With MySQL and Sqlite3 the whole result is
+     * delivered as a single last chunk.
+     */
+    template <typename... Arguments>
+    void execSqlStreamAsync(const std::string &sql,
+                            size_t chunkRows,
+                            RowChunkCallback chunkCallback,
+                            std::function<void(const std::exception_ptr &)>
+                                exceptCallback,
+                            Arguments &&...args) noexcept
+    {
+        execSqlStream(
+            sql,
+            chunkRows,
+            [parameters = std::make_tuple(
+                 internal::StreamParameterType<Arguments>(
+                     std::forward<Arguments>(args))...)](
+                internal::SqlBinder &binder) {
+                std::apply(
+                    [&binder](const auto &...parameter) {
+                        (void)std::initializer_list<int>{
+                            (binder << parameter, 0)...};
+                    },
+                    parameters);
+            },
+            std::move(chunkCallback),
+            std::move(exceptCallback));
+    }
+
     /// Streaming-like method for sql execution. For more information, see the
     /// wiki page.
     internal::SqlBinder operator<<(const std::string &sql);
@@ -295,6 +449,15 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
      */
     virtual bool hasAvailableConnections() const noexcept = 0;
 
+    /**
+     * @brief Get the state of the connections, for the diagnosis. The
+     * clients which have no pool return zeros.
+     */
+    virtual DbPoolStatus poolStatus() const noexcept
+    {
+        return {};
+    }
+
     ClientType type() const
     {
         return type_;
@@ -339,6 +502,8 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
      * that the query make some changes on the database server;
      * 3. All SQL queries that are in the same call stack of the current
      * event-loop are sent to the server;
+     * If a query fails, the read-only queries that were aborted with it are
+     * sent again with their own synchronization point.
      * @note the auto-batch mode is unsafe for general purpose scenarios.
      * While the framework is doing its best to reduce the side effects of this
      * implicit transaction, there are some risks that cannot be avoided, for
@@ -365,6 +530,12 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
 
   private:
     friend internal::SqlBinder;
+    void execSqlStream(
+        const std::string &sql,
+        size_t chunkRows,
+        std::function<void(internal::SqlBinder &)> &&bindParameters,
+        RowChunkCallback &&chunkCallback,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback);
     virtual void execSql(
         const char *sql,
         size_t sqlLength,
@@ -376,6 +547,28 @@ class DROGON_EXPORT DbClient : public trantor::NonCopyable
         std::function<void(const std::exception_ptr &)> &&exceptCallback) = 0;
 
   protected:
+    /// Pass a query on to another client, used by the routing clients
+    static void forwardSql(
+        DbClient &client,
+        const char *sql,
+        size_t sqlLength,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        ResultCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback)
+    {
+        client.execSql(sql,
+                       sqlLength,
+                       paraNum,
+                       std::move(parameters),
+                       std::move(length),
+                       std::move(format),
+                       std::move(rcb),
+                       std::move(exceptCallback));
+    }
+
     ClientType type_;
     std::string connectionInfo_;
 };
@@ -17,9 +17,49 @@
 #include <string>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 namespace drogon::orm
 {
+/// A replica server, it shares the database and the credentials of the
+/// primary server
+struct ReplicaConfig
+{
+    std::string host;
+    unsigned short port;
+};
+
+/// The sizing and the upkeep of the connections of a PostgreSQL or MySQL
+/// client, the default values keep connectionNumber connections for ever
+struct PoolConfig
+{
+    // Open more connections, up to this number, when the queries wait for a
+    // connection; 0 or anything below connectionNumber keeps the pool fixed
+    size_t maxConnectionNumber{0};
+    // Close the connections above connectionNumber idle for these seconds
+    double idleTimeout{60.0};
+    // Check the connections idle for these seconds with a trivial query and
+    // replace the broken ones, 0 for no check
+    double healthCheckInterval{0.0};
+    // Replace the connections after about these seconds, spread by up to
+    // 10% so that they are not all replaced together, 0 for no limit
+    double maxLifetime{0.0};
+};
+
+/// The statistics and the slow query log of the statements of a client
+struct QueryStatsConfig
+{
+    // Export the statistics of every statement, with its literals replaced by
+    // "?", with the builtin metrics of the PromExporter plugin
+    bool enabled{false};
+    // Log the queries that take longer than these seconds, without their
+    // parameters and literals; 0 for no log
+    double slowQueryThreshold{0.0};
+    // Also log the plan of the statement of the first slow query of every
+    // statement, fetched with EXPLAIN after the query
+    bool explainSlowQueries{false};
+};
+
 struct PostgresConfig
 {
     std::string host;
@@ -34,6 +74,23 @@ struct PostgresConfig
     double timeout;
     bool autoBatch;
     std::unordered_map<std::string, std::string> connectOptions;
+    // Run the connections on the IO loops and dispatch queries to the
+    // connections of the caller's loop first, ignored if isFast is true.
+    bool loopAffine{false};
+    // Request results in the binary format, see DbClient::newPgClient()
+    bool binaryResults{false};
+    // The maximum number of prepared statements per connection, the least
+    // recently used one is deallocated beyond it; 0 means unbounded.
+    size_t statementCacheSize{0};
+    // The number of the most used statements prepared on new connections
+    size_t warmStatements{0};
+    // Read-only queries are sent to the replicas, see
+    // DbClient::newReplicatedClient(). Ignored if isFast is true.
+    std::vector<ReplicaConfig> replicas;
+    double maxReplicaLag{-1.0};
+    // Ignored if isFast or loopAffine is true
+    PoolConfig pool;
+    QueryStatsConfig queryStats;
 };
 
 struct MysqlConfig
@@ -48,6 +105,19 @@ struct MysqlConfig
     bool isFast;
     std::string characterSet;
     double timeout;
+    // See PostgresConfig::loopAffine
+    bool loopAffine{false};
+    // See PostgresConfig::replicas
+    std::vector<ReplicaConfig> replicas;
+    double maxReplicaLag{-1.0};
+    // Execute the queries with parameters as server-side prepared statements
+    // in the binary protocol, instead of interpolating the parameters
+    bool preparedStatements{false};
+    // The prepared statements kept per connection, 0 for no bound
+    size_t statementCacheSize{0};
+    // See PostgresConfig::pool
+    PoolConfig pool;
+    QueryStatsConfig queryStats;
 };
 
 struct Sqlite3Config
@@ -56,6 +126,13 @@ struct Sqlite3Config
     std::string filename;
     std::string name;
     double timeout;
+    // One writer and connectionNumber reader connections in the WAL journal
+    // mode, see DbClient::newSqlite3WalClient()
+    bool walPool{false};
+    // Commit the writes piled up behind the writer in one transaction
+    bool batchWrites{false};
+    // Ignored if walPool is true
+    QueryStatsConfig queryStats;
 };
 
 using DbConfig = std::variant<PostgresConfig, MysqlConfig, Sqlite3Config>;
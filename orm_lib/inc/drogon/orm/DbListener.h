@@ -50,6 +50,24 @@ class DROGON_EXPORT DbListener
     static DbListenerPtr newPgListener(const std::string &connInfo,
                                        trantor::EventLoop *loop = nullptr);
 
+    /// Create a subscriber of the postgresql listener shared by the database
+    /**
+     * @param connInfo: Connection string, the same as DbClient::newPgClient(),
+     * or DbClient::connectionInfo() of a client of the database.
+     * @return DbListenerPtr
+     * @return nullptr if postgresql is not supported.
+     *
+     * @note The subscribers of the same connection string share a single
+     * connection, which listens to each channel once whatever its number of
+     * subscribers. The callbacks run in the event loop that called `listen()`
+     * (the loop of the shared listener if it's not called in an event loop),
+     * the notifications received together are delivered together. Unlike
+     * the listeners of newPgListener(), `unlisten()` only cancels the
+     * callbacks of this subscriber, which are all cancelled when it's
+     * destroyed.
+     */
+    static DbListenerPtr sharedPgListener(const std::string &connInfo);
+
     /// Listen to a channel
     /**
      * @param channel channel name to listen
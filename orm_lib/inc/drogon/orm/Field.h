@@ -26,6 +26,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 #ifdef __linux__
 #include <arpa/inet.h>
@@ -51,12 +52,22 @@ class DROGON_EXPORT Field
     /// Is this field's value null?
     bool isNull() const;
 
+    /// Is this field's value in the binary format?
+    /**
+     * Only PostgreSQL clients created with binary results enabled return
+     * values in the binary format.
+     */
+    bool isBinary() const;
+
     /// Read as plain C string
     /**
      * Since the field's data is stored internally in the form of a
      * zero-terminated C string, this is the fastest way to read it.  Use the
      * to() or as() functions to convert the string to other types such as
      * @c int, or to C++ strings.
+     *
+     * For binary format values this is the raw binary representation, which
+     * is only readable as a string for text and bytea types.
      */
     const char *c_str() const;
 
@@ -67,29 +78,34 @@ class DROGON_EXPORT Field
     }
 
     /// Convert to a type T value
+    /**
+     * Binary format values are decoded directly when T is an arithmetic
+     * type, other types are read from the text representation of the value.
+     */
     template <typename T>
     T as() const
     {
         if (isNull())
             return T();
+        if (isBinary())
+        {
+            if constexpr (std::is_integral_v<T>)
+            {
+                return static_cast<T>(binaryInteger());
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                return static_cast<T>(binaryDouble());
+            }
+            else
+            {
+                T value = T();
+                std::stringstream ss(binaryText());
+                ss >> value;
+                return value;
+            }
+        }
         auto data_ = result_.getValue(row_, column_);
-        // auto dataLength_ = result_.getLength(row_, column_);
-        // For binary format!
-        // if (dataLength_ == 1)
-        // {
-        //     return *data_;
-        // }
-        // else if (dataLength_ == 4)
-        // {
-        //     const int32_t *n = (int32_t *)data_;
-        //     return ntohl(*n);
-        // }
-        // else if (dataLength_ == 8)
-        // {
-        //     const int64_t *n = (int64_t *)data_;
-        //     return ntohll(*n);
-        // }
-        // return 0;
         T value = T();
         if (data_)
         {
@@ -109,6 +125,8 @@ class DROGON_EXPORT Field
     /// Parse the field as an SQL array.
     /**
      * Call the parser to retrieve values (and structure) from the array.
+     * The parser only reads the text format, use asArray() for binary format
+     * values.
      *
      * Make sure the @c result object stays alive until parsing is finished.  If
      * you keep the @c row of @c field object alive, it will keep the @c result
@@ -123,6 +141,41 @@ class DROGON_EXPORT Field
     std::vector<std::shared_ptr<T>> asArray() const
     {
         std::vector<std::shared_ptr<T>> ret;
+        if (isBinary())
+        {
+            int elementOid{0};
+            for (auto const &element : binaryArrayElements(elementOid))
+            {
+                if (element.data() == nullptr)
+                {
+                    ret.push_back(std::shared_ptr<T>());
+                }
+                else if constexpr (std::is_integral_v<T>)
+                {
+                    ret.push_back(std::make_shared<T>(static_cast<T>(
+                        binaryInteger(elementOid,
+                                      element.data(),
+                                      element.length()))));
+                }
+                else if constexpr (std::is_floating_point_v<T>)
+                {
+                    ret.push_back(std::make_shared<T>(static_cast<T>(
+                        binaryDouble(elementOid,
+                                     element.data(),
+                                     element.length()))));
+                }
+                else
+                {
+                    T val;
+                    std::stringstream ss(binaryText(elementOid,
+                                                    element.data(),
+                                                    element.length()));
+                    ss >> val;
+                    ret.push_back(std::shared_ptr<T>(new T(val)));
+                }
+            }
+            return ret;
+        }
         auto arrParser = getArrayParser();
         while (1)
         {
@@ -155,10 +208,25 @@ class DROGON_EXPORT Field
      */
     long column_;
     friend class Row;
+    friend class Result;
     Field(const Row &row, Row::SizeType columnNum) noexcept;
+    Field(const Result &result,
+          Result::SizeType rowNum,
+          Row::SizeType columnNum) noexcept;
 
   private:
     const Result result_;
+
+    // Decoders of binary format values, see Field.cc for the supported types
+    int64_t binaryInteger() const;
+    double binaryDouble() const;
+    std::string binaryText() const;
+    // Elements of a binary format array in storage order, NULL elements have
+    // a null data() pointer.
+    std::vector<std::string_view> binaryArrayElements(int &elementOid) const;
+    static int64_t binaryInteger(int oid, const char *data, size_t length);
+    static double binaryDouble(int oid, const char *data, size_t length);
+    static std::string binaryText(int oid, const char *data, size_t length);
 };
 
 template <>
@@ -170,6 +238,7 @@ DROGON_EXPORT char *Field::as<char *>() const;
 template <>
 DROGON_EXPORT std::vector<char> Field::as<std::vector<char>>() const;
 
+/// Binary format values are returned as is, without copying.
 template <>
 inline std::string_view Field::as<std::string_view>() const
 {
@@ -183,6 +252,8 @@ inline float Field::as<float>() const
 {
     if (isNull())
         return 0.0;
+    if (isBinary())
+        return static_cast<float>(binaryDouble());
     return std::stof(result_.getValue(row_, column_));
 }
 
@@ -191,6 +262,8 @@ inline double Field::as<double>() const
 {
     if (isNull())
         return 0.0;
+    if (isBinary())
+        return binaryDouble();
     return std::stod(result_.getValue(row_, column_));
 }
 
@@ -201,6 +274,8 @@ inline bool Field::as<bool>() const
     {
         return false;
     }
+    if (isBinary())
+        return binaryInteger() != 0;
     auto value = result_.getValue(row_, column_);
     if (*value == 't' || *value == '1')
         return true;
@@ -212,6 +287,8 @@ inline int Field::as<int>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return static_cast<int>(binaryInteger());
     return std::stoi(result_.getValue(row_, column_));
 }
 
@@ -220,6 +297,8 @@ inline long Field::as<long>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return static_cast<long>(binaryInteger());
     return std::stol(result_.getValue(row_, column_));
 }
 
@@ -228,6 +307,8 @@ inline int8_t Field::as<int8_t>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return static_cast<int8_t>(binaryInteger());
     return static_cast<int8_t>(atoi(result_.getValue(row_, column_)));
 }
 
@@ -236,6 +317,8 @@ inline long long Field::as<long long>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return binaryInteger();
     return atoll(result_.getValue(row_, column_));
 }
 
@@ -244,6 +327,8 @@ inline unsigned int Field::as<unsigned int>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return static_cast<unsigned int>(binaryInteger());
     return static_cast<unsigned int>(
         std::stoul(result_.getValue(row_, column_)));
 }
@@ -253,6 +338,8 @@ inline unsigned long Field::as<unsigned long>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return static_cast<unsigned long>(binaryInteger());
     return std::stoul(result_.getValue(row_, column_));
 }
 
@@ -261,6 +348,8 @@ inline uint8_t Field::as<uint8_t>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return static_cast<uint8_t>(binaryInteger());
     return static_cast<uint8_t>(atoi(result_.getValue(row_, column_)));
 }
 
@@ -269,11 +358,29 @@ inline unsigned long long Field::as<unsigned long long>() const
 {
     if (isNull())
         return 0;
+    if (isBinary())
+        return static_cast<unsigned long long>(binaryInteger());
     return std::stoull(result_.getValue(row_, column_));
 }
 
 // std::vector<int32_t> Field::as<std::vector<int32_t>>() const;
 // template <>
 // std::vector<int64_t> Field::as<std::vector<int64_t>>() const;
+
+template <typename T>
+std::vector<T> Result::column(RowSizeType number) const
+{
+    assert(number < columns());
+    std::vector<T> values;
+    auto rows = size();
+    values.reserve(rows);
+    Field field(*this, 0, number);
+    for (SizeType row = 0; row < rows; ++row)
+    {
+        field.row_ = row;
+        values.push_back(field.as<T>());
+    }
+    return values;
+}
 }  // namespace orm
 }  // namespace drogon
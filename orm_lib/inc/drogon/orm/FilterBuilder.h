@@ -157,6 +157,31 @@ class FilterBuilder : public TransformBuilder<T, SelectAll, false>
         this->filters_.push_back({column, CompareOperator::Like, pattern});
         return *this;
     }
+
+    /**
+     * @brief Keyset pagination, seek the rows after the last row of a
+     * previous page in the order of a column, which is added to the order.
+     * Unlike the offsets, the page is found with the index of the column.
+     *
+     * @param column The column, whose values should be unique.
+     * @param lastValue The value of the column in the last row of the
+     * previous page.
+     * @param asc If `true`, ascending order. If `false`, descending order.
+     *
+     * @return FilterBuilder& The FilterBuilder itself.
+     */
+    inline FilterBuilder &seek(const std::string &column,
+                               const std::string &lastValue,
+                               bool asc = true)
+    {
+        this->assert_column(column);
+        this->filters_.push_back({column,
+                                  asc ? CompareOperator::GT
+                                      : CompareOperator::LT,
+                                  lastValue});
+        this->orders_.emplace_back(column, asc);
+        return *this;
+    }
 };
 }  // namespace orm
 }  // namespace drogon
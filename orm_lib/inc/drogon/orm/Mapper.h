@@ -16,8 +16,14 @@
 #include <drogon/orm/Criteria.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #ifdef _WIN32
@@ -82,6 +88,90 @@ struct has_sqlForDeletingByPrimaryKey
   public:
     static constexpr bool value = std::is_same_v<decltype(test<T>(0)), yes>;
 };
+
+template <typename T>
+struct has_indexedColumns
+{
+  private:
+    using yes = std::true_type;
+    using no = std::false_type;
+
+    template <typename U>
+    static auto test(int) -> decltype(U::getColumnName(0).length(),
+                                      U::getColumnNumber(),
+                                      U(std::declval<const Row &>(),
+                                        ssize_t{0}),
+                                      yes());
+
+    template <typename>
+    static no test(...);
+
+  public:
+    static constexpr bool value = std::is_same_v<decltype(test<T>(0)), yes>;
+};
+
+/**
+ * @brief Return the index offset with which the rows of the result are
+ * converted to models: 0 when the result starts with the columns of the
+ * model in order (e.g. "select * from table"), so the fields are read by
+ * index instead of being looked up by name on every row, otherwise -1.
+ */
+template <typename T>
+ssize_t modelIndexOffset(const Result &r)
+{
+    if constexpr (has_indexedColumns<T>::value)
+    {
+        auto columns = T::getColumnNumber();
+        if (r.columns() < columns)
+            return -1;
+        for (size_t i = 0; i < columns; ++i)
+        {
+            if (T::getColumnName(i) != r.columnName((Row::SizeType)i))
+                return -1;
+        }
+        return 0;
+    }
+    else
+    {
+        (void)r;
+        return -1;
+    }
+}
+
+template <typename T>
+T rowToModel(const Row &row, ssize_t indexOffset)
+{
+    if constexpr (has_indexedColumns<T>::value)
+    {
+        return T(row, indexOffset);
+    }
+    else
+    {
+        (void)indexOffset;
+        return T(row);
+    }
+}
+
+/// Convert the first row of the result to a model
+template <typename T>
+T firstRowToModel(const Result &r)
+{
+    return rowToModel<T>(r[0], modelIndexOffset<T>(r));
+}
+
+/// Convert all the rows of the result to models
+template <typename T>
+std::vector<T> resultToModels(const Result &r)
+{
+    std::vector<T> ret;
+    ret.reserve(r.size());
+    auto indexOffset = modelIndexOffset<T>(r);
+    for (auto const &row : r)
+    {
+        ret.push_back(rowToModel<T>(row, indexOffset));
+    }
+    return ret;
+}
 }  // namespace internal
 
 /**
@@ -171,6 +261,34 @@ class Mapper
      */
     Mapper<T> &paginate(size_t page, size_t perPage);
 
+    /**
+     * @brief Seek the rows after a row of a previous page in the order of a
+     * column, which is added to the order of the results. Unlike the offsets
+     * of paginate(), the page is found with the index of the column, so the
+     * deep pages are as fast as the first ones. Applies to findBy() only.
+     *
+     * @param colName The column, whose values should be unique
+     * @param lastValue The value of the column in the last row of the
+     * previous page
+     * @param order Ascending or descending order
+     * @return Mapper<T>& The Mapper itself.
+     */
+    template <typename V>
+    Mapper<T> &seek(const std::string &colName,
+                    V &&lastValue,
+                    const SortOrder &order = SortOrder::ASC);
+
+    /**
+     * @brief Seek the rows after a row of a previous page in the order of a
+     * column and of a unique column breaking its ties, like (created_at, id).
+     */
+    template <typename V1, typename V2>
+    Mapper<T> &seek(const std::string &colName,
+                    V1 &&lastValue,
+                    const std::string &tieColName,
+                    V2 &&lastTieValue,
+                    const SortOrder &order = SortOrder::ASC);
+
     /**
      * @brief Lock the result for updating.
      *
@@ -228,8 +346,7 @@ class Mapper
             {
                 throw UnexpectedRows("Found more than one row");
             }
-            auto row = r[0];
-            return T(row);
+            return internal::firstRowToModel<T>(r);
         }
         else
         {
@@ -279,7 +396,7 @@ class Mapper
                 }
                 else
                 {
-                    rcb(T(r[0]));
+                    rcb(internal::firstRowToModel<T>(r));
                 }
             };
             binder >> ecb;
@@ -338,7 +455,7 @@ class Mapper
                 }
                 else
                 {
-                    prom->set_value(T(r[0]));
+                    prom->set_value(internal::firstRowToModel<T>(r));
                 }
             };
             binder >>
@@ -469,6 +586,35 @@ class Mapper
      */
     std::future<std::vector<T>> findFutureBy(const Criteria &criteria) noexcept;
 
+    /**
+     * @brief Select the rows whose column has one of the given values, like
+     * the rows referenced by the foreign keys of many rows, with one query
+     * per 999 distinct values instead of one query per value. The limit,
+     * the offset and the order are ignored.
+     *
+     * @param colName The column.
+     * @param keys The values, duplicates are allowed.
+     * @return std::vector<T> The rows, in no particular order.
+     */
+    template <typename V>
+    std::vector<T> findIn(const std::string &colName,
+                          std::vector<V> keys) noexcept(false);
+
+    /**
+     * @brief Asynchronously select the rows whose column has one of the given
+     * values, see the synchronous version.
+     *
+     * @param colName The column.
+     * @param keys The values, duplicates are allowed.
+     * @param rcb is called with the result.
+     * @param ecb is called when an error occurs.
+     */
+    template <typename V>
+    void findIn(const std::string &colName,
+                std::vector<V> keys,
+                const MultipleRowsCallback &rcb,
+                const ExceptionCallback &ecb) noexcept;
+
     /**
      * @brief Insert a row into the table.
      *
@@ -498,6 +644,42 @@ class Mapper
      */
     std::future<T> insertFuture(const T &) noexcept;
 
+    /**
+     * @brief Insert rows into the table with multi-row insert statements.
+     *
+     * @param objs The objects to be inserted. The consecutive objects with
+     * the same columns set are inserted by the same statements, every one of
+     * which has at most 1000 rows and respects the parameter limit of the
+     * database.
+     * @return size_t The number of inserted rows.
+     * @note Unlike insert(), the auto-increased primary keys are not set to
+     * the objects. The statements are independent, use a transaction when
+     * the rows must be inserted all or none.
+     */
+    size_t insertMany(const std::vector<T> &objs) noexcept(false);
+
+    /**
+     * @brief Asynchronously insert rows into the table with multi-row insert
+     * statements, see insertMany(const std::vector<T> &).
+     *
+     * @param objs The objects to be inserted.
+     * @param rcb is called with the number of inserted rows.
+     * @param ecb is called once when an error occurs, some statements may
+     * have succeeded.
+     */
+    void insertMany(const std::vector<T> &objs,
+                    const CountCallback &rcb,
+                    const ExceptionCallback &ecb) noexcept;
+
+    /**
+     * @brief Asynchronously insert rows into the table with multi-row insert
+     * statements, see insertMany(const std::vector<T> &).
+     *
+     * @return std::future<size_t> The future object with which user can get
+     * the number of inserted rows.
+     */
+    std::future<size_t> insertManyFuture(const std::vector<T> &objs) noexcept;
+
     /**
      * @brief Update a record.
      *
@@ -719,6 +901,7 @@ class Mapper
     size_t limit_{0};
     size_t offset_{0};
     std::string orderByString_;
+    Criteria seekCriteria_;
     bool forUpdate_{false};
 
     void clear()
@@ -726,9 +909,45 @@ class Mapper
         limit_ = 0;
         offset_ = 0;
         orderByString_.clear();
+        seekCriteria_ = Criteria();
         forUpdate_ = false;
     }
 
+    Criteria withSeek(const Criteria &criteria) const
+    {
+        return seekCriteria_ ? criteria && seekCriteria_ : criteria;
+    }
+
+    // The state of the queries of findIn(), sent one after the other
+    template <typename V>
+    struct KeyBatch
+    {
+        DbClientPtr client_;
+        std::string colName_;
+        std::vector<V> keys_;
+        size_t next_{0};
+        bool forUpdate_{false};
+        std::vector<T> models_;
+        MultipleRowsCallback rcb_;
+        std::function<void(const std::exception_ptr &)> ecb_;
+    };
+
+    static constexpr size_t maxKeysPerQuery_ = 999;
+
+    std::string keysSql(const std::string &colName,
+                        size_t keysNumber,
+                        bool forUpdate) const;
+
+    template <typename V>
+    void findInAsync(
+        const std::string &colName,
+        std::vector<V> keys,
+        MultipleRowsCallback rcb,
+        std::function<void(const std::exception_ptr &)> ecb) noexcept;
+
+    template <typename V>
+    static void loadKeyBatch(const std::shared_ptr<KeyBatch<V>> &batch);
+
     template <typename PKType = decltype(T::primaryKeyName)>
     void makePrimaryKeyCriteria(std::string &sql)
     {
@@ -785,6 +1004,18 @@ class Mapper
 
     std::string replaceSqlPlaceHolder(const std::string &sqlStr,
                                       const std::string &holderStr) const;
+
+    /**
+     * @brief Split the objects into multi-row insert statements, every one
+     * with the objects whose arguments it binds.
+     */
+    std::vector<std::pair<std::string, std::vector<const T *>>>
+    insertManyStatements(const std::vector<T> &objs) const;
+
+    void insertManyAsync(
+        const std::vector<T> &objs,
+        const CountCallback &rcb,
+        const std::function<void(const std::exception_ptr &)> &ecb) noexcept;
 };
 
 template <typename T>
@@ -838,8 +1069,7 @@ inline T Mapper<T>::findOne(const Criteria &criteria) noexcept(false)
     {
         throw UnexpectedRows("Found more than one row");
     }
-    auto row = r[0];
-    return T(row);
+    return internal::firstRowToModel<T>(r);
 }
 
 template <typename T>
@@ -892,7 +1122,7 @@ inline void Mapper<T>::findOne(const Criteria &criteria,
         }
         else
         {
-            rcb(T(r[0]));
+            rcb(internal::firstRowToModel<T>(r));
         }
     };
     binder >> ecb;
@@ -950,7 +1180,7 @@ inline std::future<T> Mapper<T>::findFutureOne(
         }
         else
         {
-            prom->set_value(T(r[0]));
+            prom->set_value(internal::firstRowToModel<T>(r));
         }
     };
     binder >> [prom](const std::exception_ptr &e) { prom->set_exception(e); };
@@ -962,14 +1192,15 @@ template <typename T>
 inline std::vector<T> Mapper<T>::findBy(const Criteria &criteria) noexcept(
     false)
 {
+    auto condition = withSeek(criteria);
     std::string sql = "select * from ";
     sql += T::tableName;
     bool hasParameters = false;
-    if (criteria)
+    if (condition)
     {
         hasParameters = true;
         sql += " where ";
-        sql += criteria.criteriaString();
+        sql += condition.criteriaString();
     }
     sql.append(orderByString_);
     if (limit_ > 0)
@@ -991,8 +1222,8 @@ inline std::vector<T> Mapper<T>::findBy(const Criteria &criteria) noexcept(
     Result r(nullptr);
     {
         auto binder = *client_ << std::move(sql);
-        if (criteria)
-            criteria.outputArgs(binder);
+        if (condition)
+            condition.outputArgs(binder);
         if (limit_ > 0)
             binder << limit_;
         if (offset_)
@@ -1002,12 +1233,7 @@ inline std::vector<T> Mapper<T>::findBy(const Criteria &criteria) noexcept(
         binder >> [&r](const Result &result) { r = result; };
         binder.exec();  // exec may be throw exception;
     }
-    std::vector<T> ret;
-    for (auto const &row : r)
-    {
-        ret.push_back(T(row));
-    }
-    return ret;
+    return internal::resultToModels<T>(r);
 }
 
 template <typename T>
@@ -1015,14 +1241,15 @@ inline void Mapper<T>::findBy(const Criteria &criteria,
                               const MultipleRowsCallback &rcb,
                               const ExceptionCallback &ecb) noexcept
 {
+    auto condition = withSeek(criteria);
     std::string sql = "select * from ";
     sql += T::tableName;
     bool hasParameters = false;
-    if (criteria)
+    if (condition)
     {
         hasParameters = true;
         sql += " where ";
-        sql += criteria.criteriaString();
+        sql += condition.criteriaString();
     }
     sql.append(orderByString_);
     if (limit_ > 0)
@@ -1042,20 +1269,15 @@ inline void Mapper<T>::findBy(const Criteria &criteria,
         sql += " for update";
     }
     auto binder = *client_ << std::move(sql);
-    if (criteria)
-        criteria.outputArgs(binder);
+    if (condition)
+        condition.outputArgs(binder);
     if (limit_ > 0)
         binder << limit_;
     if (offset_)
         binder << offset_;
     clear();
     binder >> [rcb](const Result &r) {
-        std::vector<T> ret;
-        for (auto const &row : r)
-        {
-            ret.emplace_back(row);
-        }
-        rcb(std::move(ret));
+        rcb(internal::resultToModels<T>(r));
     };
     binder >> ecb;
 }
@@ -1064,14 +1286,15 @@ template <typename T>
 inline std::future<std::vector<T>> Mapper<T>::findFutureBy(
     const Criteria &criteria) noexcept
 {
+    auto condition = withSeek(criteria);
     std::string sql = "select * from ";
     sql += T::tableName;
     bool hasParameters = false;
-    if (criteria)
+    if (condition)
     {
         hasParameters = true;
         sql += " where ";
-        sql += criteria.criteriaString();
+        sql += condition.criteriaString();
     }
     sql.append(orderByString_);
     if (limit_ > 0)
@@ -1091,8 +1314,8 @@ inline std::future<std::vector<T>> Mapper<T>::findFutureBy(
         sql += " for update";
     }
     auto binder = *client_ << std::move(sql);
-    if (criteria)
-        criteria.outputArgs(binder);
+    if (condition)
+        condition.outputArgs(binder);
     if (limit_ > 0)
         binder << limit_;
     if (offset_)
@@ -1101,18 +1324,143 @@ inline std::future<std::vector<T>> Mapper<T>::findFutureBy(
     std::shared_ptr<std::promise<std::vector<T>>> prom =
         std::make_shared<std::promise<std::vector<T>>>();
     binder >> [prom](const Result &r) {
-        std::vector<T> ret;
-        for (auto const &row : r)
-        {
-            ret.push_back(T(row));
-        }
-        prom->set_value(ret);
+        prom->set_value(internal::resultToModels<T>(r));
     };
     binder >> [prom](const std::exception_ptr &e) { prom->set_exception(e); };
     binder.exec();
     return prom->get_future();
 }
 
+template <typename T>
+template <typename V>
+inline std::vector<T> Mapper<T>::findIn(const std::string &colName,
+                                        std::vector<V> keys) noexcept(false)
+{
+    auto forUpdate = forUpdate_;
+    clear();
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::vector<T> ret;
+    for (size_t begin = 0; begin < keys.size(); begin += maxKeysPerQuery_)
+    {
+        auto end = (std::min)(keys.size(), begin + maxKeysPerQuery_);
+        Result r(nullptr);
+        {
+            auto binder = *client_ << keysSql(colName, end - begin, forUpdate);
+            for (auto i = begin; i < end; ++i)
+                binder << keys[i];
+            binder << Mode::Blocking;
+            binder >> [&r](const Result &result) { r = result; };
+            binder.exec();  // exec may be throw exception;
+        }
+        auto models = internal::resultToModels<T>(r);
+        ret.insert(ret.end(),
+                   std::make_move_iterator(models.begin()),
+                   std::make_move_iterator(models.end()));
+    }
+    return ret;
+}
+
+template <typename T>
+template <typename V>
+inline void Mapper<T>::findIn(const std::string &colName,
+                              std::vector<V> keys,
+                              const MultipleRowsCallback &rcb,
+                              const ExceptionCallback &ecb) noexcept
+{
+    findInAsync(colName,
+                std::move(keys),
+                rcb,
+                [ecb](const std::exception_ptr &exception) {
+                    try
+                    {
+                        std::rethrow_exception(exception);
+                    }
+                    catch (const DrogonDbException &e)
+                    {
+                        ecb(e);
+                    }
+                });
+}
+
+template <typename T>
+inline std::string Mapper<T>::keysSql(const std::string &colName,
+                                      size_t keysNumber,
+                                      bool forUpdate) const
+{
+    std::string sql = "select * from ";
+    sql += T::tableName;
+    sql += " where ";
+    sql += colName;
+    sql += " in (";
+    for (size_t i = 0; i < keysNumber; ++i)
+    {
+        sql.append(i == 0 ? "$?" : ",$?");
+    }
+    sql += ")";
+    sql = replaceSqlPlaceHolder(sql, "$?");
+    if (forUpdate)
+    {
+        sql += " for update";
+    }
+    return sql;
+}
+
+template <typename T>
+template <typename V>
+inline void Mapper<T>::findInAsync(
+    const std::string &colName,
+    std::vector<V> keys,
+    MultipleRowsCallback rcb,
+    std::function<void(const std::exception_ptr &)> ecb) noexcept
+{
+    auto batch = std::make_shared<KeyBatch<V>>();
+    batch->client_ = client_;
+    batch->colName_ = colName;
+    batch->forUpdate_ = forUpdate_;
+    batch->rcb_ = std::move(rcb);
+    batch->ecb_ = std::move(ecb);
+    clear();
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    batch->keys_ = std::move(keys);
+    if (batch->keys_.empty())
+    {
+        batch->rcb_({});
+        return;
+    }
+    loadKeyBatch(batch);
+}
+
+template <typename T>
+template <typename V>
+inline void Mapper<T>::loadKeyBatch(const std::shared_ptr<KeyBatch<V>> &batch)
+{
+    auto begin = batch->next_;
+    auto end = (std::min)(batch->keys_.size(), begin + maxKeysPerQuery_);
+    batch->next_ = end;
+    auto sql = Mapper<T>(batch->client_)
+                   .keysSql(batch->colName_, end - begin, batch->forUpdate_);
+    auto binder = *(batch->client_) << std::move(sql);
+    for (auto i = begin; i < end; ++i)
+        binder << batch->keys_[i];
+    binder >> [batch](const Result &r) {
+        auto models = internal::resultToModels<T>(r);
+        batch->models_.insert(batch->models_.end(),
+                              std::make_move_iterator(models.begin()),
+                              std::make_move_iterator(models.end()));
+        if (batch->next_ < batch->keys_.size())
+        {
+            loadKeyBatch(batch);
+            return;
+        }
+        batch->rcb_(std::move(batch->models_));
+    };
+    binder >> [batch](const std::exception_ptr &exception) {
+        batch->ecb_(exception);
+    };
+}
+
 template <typename T>
 inline std::vector<T> Mapper<T>::findAll() noexcept(false)
 {
@@ -1228,7 +1576,7 @@ inline void Mapper<T>::insert(T &obj) noexcept(false)
         if (needSelection)
         {
             assert(r.size() == 1);
-            obj = T(r[0]);
+            obj = internal::firstRowToModel<T>(r);
         }
     }
     else  // Mysql or Sqlite3
@@ -1259,7 +1607,7 @@ inline void Mapper<T>::insert(const T &obj,
             if (needSelection)
             {
                 assert(r.size() == 1);
-                rcb(T(r[0]));
+                rcb(internal::firstRowToModel<T>(r));
             }
             else
             {
@@ -1302,7 +1650,7 @@ inline std::future<T> Mapper<T>::insertFuture(const T &obj) noexcept
             if (needSelection)
             {
                 assert(r.size() == 1);
-                prom->set_value(T(r[0]));
+                prom->set_value(internal::firstRowToModel<T>(r));
             }
             else
             {
@@ -1336,6 +1684,166 @@ inline std::future<T> Mapper<T>::insertFuture(const T &obj) noexcept
     return prom->get_future();
 }
 
+template <typename T>
+inline std::vector<std::pair<std::string, std::vector<const T *>>>
+Mapper<T>::insertManyStatements(const std::vector<T> &objs) const
+{
+    constexpr size_t maxRows = 1000;
+    const size_t maxParameters =
+        client_->type() == ClientType::Sqlite3 ? 999 : 65535;
+    std::vector<std::pair<std::string, std::vector<const T *>>> statements;
+    std::string lastSql;
+    std::string head;
+    std::string row;
+    std::string values;
+    size_t rowLimit = maxRows;
+    auto flush = [&statements, &head, &values, this]() {
+        if (values.empty())
+            return;
+        statements.back().first = replaceSqlPlaceHolder(head + values, "$?");
+        values.clear();
+    };
+    for (auto const &obj : objs)
+    {
+        bool needSelection = false;
+        auto sql = obj.sqlForInserting(needSelection);
+        if (sql != lastSql)
+        {
+            flush();
+            // The row is the parenthesized list following "values", the
+            // returning clause is dropped since only the rows are counted
+            auto pos = sql.find(" values (");
+            assert(pos != std::string::npos);
+            head = sql.substr(0, pos + 8);
+            row.clear();
+            size_t parameters = 0;
+            for (size_t i = pos + 8; i < sql.length(); ++i)
+            {
+                auto c = sql[i];
+                if (c == '?' || c == '$')
+                {
+                    row += "$?";
+                    ++parameters;
+                    while (c == '$' && i + 1 < sql.length() &&
+                           isdigit(static_cast<unsigned char>(sql[i + 1])))
+                        ++i;
+                    continue;
+                }
+                row += c;
+                if (c == ')')
+                    break;
+            }
+            rowLimit = parameters > 0
+                           ? (std::min)(maxRows, maxParameters / parameters)
+                           : maxRows;
+            lastSql = std::move(sql);
+            statements.emplace_back();
+        }
+        else if (statements.back().second.size() >= rowLimit)
+        {
+            flush();
+            statements.emplace_back();
+        }
+        if (!values.empty())
+            values += ',';
+        values += row;
+        statements.back().second.push_back(&obj);
+    }
+    flush();
+    return statements;
+}
+
+template <typename T>
+inline size_t Mapper<T>::insertMany(const std::vector<T> &objs) noexcept(
+    false)
+{
+    clear();
+    size_t count = 0;
+    for (auto &[sql, rows] : insertManyStatements(objs))
+    {
+        auto binder = *client_ << std::move(sql);
+        for (auto obj : rows)
+        {
+            obj->outputArgs(binder);
+        }
+        binder << Mode::Blocking;
+        binder >> [&count](const Result &r) { count += r.affectedRows(); };
+        binder.exec();  // Maybe throw exception;
+    }
+    return count;
+}
+
+template <typename T>
+inline void Mapper<T>::insertManyAsync(
+    const std::vector<T> &objs,
+    const CountCallback &rcb,
+    const std::function<void(const std::exception_ptr &)> &ecb) noexcept
+{
+    clear();
+    auto statements = insertManyStatements(objs);
+    if (statements.empty())
+    {
+        rcb(0);
+        return;
+    }
+    struct State
+    {
+        std::atomic<size_t> pending;
+        std::atomic<size_t> count{0};
+        std::atomic<bool> failed{false};
+    };
+    auto state = std::make_shared<State>();
+    state->pending = statements.size();
+    for (auto &[sql, rows] : statements)
+    {
+        auto binder = *client_ << std::move(sql);
+        for (auto obj : rows)
+        {
+            obj->outputArgs(binder);
+        }
+        binder >> [state, rcb](const Result &r) {
+            state->count += r.affectedRows();
+            if (--state->pending == 0 && !state->failed)
+                rcb(state->count);
+        };
+        binder >> [state, ecb](const std::exception_ptr &e) {
+            if (!state->failed.exchange(true))
+                ecb(e);
+            --state->pending;
+        };
+    }
+}
+
+template <typename T>
+inline void Mapper<T>::insertMany(const std::vector<T> &objs,
+                                  const CountCallback &rcb,
+                                  const ExceptionCallback &ecb) noexcept
+{
+    insertManyAsync(objs, rcb, [ecb](const std::exception_ptr &e) {
+        try
+        {
+            std::rethrow_exception(e);
+        }
+        catch (const DrogonDbException &err)
+        {
+            ecb(err);
+        }
+    });
+}
+
+template <typename T>
+inline std::future<size_t> Mapper<T>::insertManyFuture(
+    const std::vector<T> &objs) noexcept
+{
+    std::shared_ptr<std::promise<size_t>> prom =
+        std::make_shared<std::promise<size_t>>();
+    insertManyAsync(
+        objs,
+        [prom](const size_t count) { prom->set_value(count); },
+        [prom](const std::exception_ptr &e) { prom->set_exception(e); });
+    return prom->get_future();
+}
+
 template <typename T>
 inline size_t Mapper<T>::update(const T &obj) noexcept(false)
 {
@@ -1929,6 +2437,36 @@ inline Mapper<T> &Mapper<T>::paginate(size_t page, size_t perPage)
     return limit(perPage).offset((page - 1) * perPage);
 }
 
+template <typename T>
+template <typename V>
+inline Mapper<T> &Mapper<T>::seek(const std::string &colName,
+                                  V &&lastValue,
+                                  const SortOrder &order)
+{
+    seekCriteria_ = Criteria(colName,
+                             order == SortOrder::ASC ? CompareOperator::GT
+                                                     : CompareOperator::LT,
+                             std::forward<V>(lastValue));
+    return orderBy(colName, order);
+}
+
+template <typename T>
+template <typename V1, typename V2>
+inline Mapper<T> &Mapper<T>::seek(const std::string &colName,
+                                  V1 &&lastValue,
+                                  const std::string &tieColName,
+                                  V2 &&lastTieValue,
+                                  const SortOrder &order)
+{
+    auto opera =
+        order == SortOrder::ASC ? CompareOperator::GT : CompareOperator::LT;
+    // Not a row comparison like (a, b) > (x, y), for the older SQLite
+    Criteria tie(tieColName, opera, std::forward<V2>(lastTieValue));
+    seekCriteria_ = Criteria(colName, opera, lastValue) ||
+                    (Criteria(colName, CompareOperator::EQ, lastValue) && tie);
+    return orderBy(colName, order).orderBy(tieColName, order);
+}
+
 template <typename T>
 inline Mapper<T> &Mapper<T>::forUpdate()
 {
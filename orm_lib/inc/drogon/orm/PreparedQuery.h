@@ -0,0 +1,176 @@
+/**
+ *
+ *  @file PreparedQuery.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <cassert>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief A query whose SQL is rendered once, by QueryBuilder::prepare() for
+ * instance, and executed many times with new parameter values.
+ *
+ * The SQL is rendered for every kind of database when the query is prepared,
+ * an execution only binds the parameters. The connections prepare the
+ * statement on its first execution and find it by its text afterwards.
+ *
+ * @code
+   static const auto byName =
+       QueryBuilder<Users>{}.selectAll().eq("name", "").limit(1).prepare();
+   auto users = byName.execSync(client, name);
+   @endcode
+ *
+ * @tparam ResultType The type of the result, like the one of the builder.
+ */
+template <typename ResultType>
+class PreparedQuery
+{
+  public:
+    using Converter = ResultType (*)(const Result &);
+
+    /**
+     * @param pgSql The SQL with the numbered placeholders of PostgreSQL.
+     * @param sql The SQL with the "?" placeholders of MySQL and SQLite.
+     * @param args The parameters bound when none are given.
+     * @param converter Converts the result of the query.
+     */
+    PreparedQuery(std::string pgSql,
+                  std::string sql,
+                  std::vector<std::string> args,
+                  Converter converter)
+        : sqls_(std::make_shared<const Sqls>(
+              Sqls{std::move(pgSql), std::move(sql)})),
+          args_(std::move(args)),
+          converter_(converter)
+    {
+    }
+
+    /// The number of parameters of the query
+    size_t parametersNumber() const
+    {
+        return args_.size();
+    }
+
+    /// The SQL of the query for a kind of database
+    const std::string &sql(ClientType type) const
+    {
+        return type == ClientType::PostgreSQL ? sqls_->pgSql_ : sqls_->sql_;
+    }
+
+    /**
+     * @brief Execute the query in blocking mode.
+     *
+     * @param args The parameters, all of them or none to bind the values
+     * given to the builder.
+     */
+    template <typename... Arguments>
+    ResultType execSync(const DbClientPtr &client, Arguments &&...args) const
+    {
+        Result r(nullptr);
+        {
+            auto binder = newBinder(client, std::forward<Arguments>(args)...);
+            binder << Mode::Blocking;
+            binder >> [&r](const Result &result) { r = result; };
+            binder.exec();  // exec may throw exception
+        }
+        return converter_(r);
+    }
+
+    /**
+     * @brief Execute the query asynchronously.
+     *
+     * @param args The parameters, all of them or none to bind the values
+     * given to the builder.
+     */
+    template <typename TFn, typename EFn, typename... Arguments>
+    void execAsync(const DbClientPtr &client,
+                   TFn &&rCallback,
+                   EFn &&exceptCallback,
+                   Arguments &&...args) const noexcept
+    {
+        auto binder = newBinder(client, std::forward<Arguments>(args)...);
+        // The SQL is bound as a view, the callbacks keep it until the query
+        // is done
+        binder >> [sqls = sqls_,
+                   converter = converter_,
+                   rCallback = std::forward<TFn>(rCallback)](
+                      const Result &r) { rCallback(converter(r)); };
+        binder >> std::forward<EFn>(exceptCallback);
+    }
+
+    /**
+     * @brief Execute the query asynchronously.
+     *
+     * @param args The parameters, all of them or none to bind the values
+     * given to the builder.
+     */
+    template <typename... Arguments>
+    std::future<ResultType> execAsyncFuture(const DbClientPtr &client,
+                                            Arguments &&...args) const noexcept
+    {
+        auto binder = newBinder(client, std::forward<Arguments>(args)...);
+        auto prom = std::make_shared<std::promise<ResultType>>();
+        binder >> [sqls = sqls_, converter = converter_, prom](
+                      const Result &r) { prom->set_value(converter(r)); };
+        binder >> [sqls = sqls_, prom](const std::exception_ptr &e) {
+            prom->set_exception(e);
+        };
+        binder.exec();
+        return prom->get_future();
+    }
+
+  private:
+    struct Sqls
+    {
+        std::string pgSql_;
+        std::string sql_;
+    };
+
+    template <typename... Arguments>
+    internal::SqlBinder newBinder(const DbClientPtr &client,
+                                  Arguments &&...args) const
+    {
+        auto binder = *client << std::string_view(sql(client->type()));
+        if constexpr (sizeof...(Arguments) == 0)
+        {
+            for (const std::string &a : args_)
+            {
+                binder << a;
+            }
+        }
+        else
+        {
+            assert(sizeof...(Arguments) == args_.size());
+            (void)std::initializer_list<int>{
+                (binder << std::forward<Arguments>(args), 0)...};
+        }
+        return binder;
+    }
+
+    std::shared_ptr<const Sqls> sqls_;
+    std::vector<std::string> args_;
+    Converter converter_;
+};
+
+}  // namespace orm
+}  // namespace drogon
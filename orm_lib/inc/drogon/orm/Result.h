@@ -22,10 +22,13 @@
 #include <string>
 #include <future>
 #include <algorithm>
+#include <vector>
 #include <assert.h>
 
 namespace drogon
 {
+class JsonWriter;
+
 namespace orm
 {
 class ConstResultIterator;
@@ -139,6 +142,40 @@ class DROGON_EXPORT Result
      */
     unsigned long long insertId() const noexcept;
 
+    /// The values of a column converted to T, as Field::as<T>() does
+    /**
+     * A single field is moved down the column, instead of a row and a field
+     * being created for every value. The template is defined in Field.h.
+     */
+    template <typename T>
+    std::vector<T> column(RowSizeType number) const;
+
+    /// The values of the column with this name converted to T (throws
+    /// exception if it doesn't exist)
+    template <typename T>
+    std::vector<T> column(const std::string &name) const
+    {
+        return column<T>(columnNumber(name));
+    }
+
+    /// An owned copy of the result, stored column by column
+    /**
+     * The copy no longer holds the buffers of the database library and takes
+     * little more memory than the values, so it is the one to keep for a
+     * long time, e.g. in a cache. The values of a column are contiguous.
+     */
+    Result compact() const;
+
+    /// Write the rows as a JSON array of objects keyed by the column names
+    /**
+     * The values go straight to the writer, no Json::Value is built for the
+     * rows. Their JSON types follow the column types of the result: the
+     * numbers, booleans and json columns of PostgreSQL and MySQL are written
+     * as such, the binary strings in base64, NULL as null and everything else
+     * as strings.
+     */
+    void writeJson(drogon::JsonWriter &writer) const;
+
 #ifdef _MSC_VER
     Result() noexcept = default;
 #endif
@@ -160,6 +197,9 @@ class DROGON_EXPORT Result
     /// Get the column oid, for postgresql database
     int oid(RowSizeType column) const noexcept;
 
+    /// Is the column in the binary format? Only for postgresql database
+    bool isBinary(RowSizeType column) const noexcept;
+
     const char *getValue(SizeType row, RowSizeType column) const;
     bool isNull(SizeType row, RowSizeType column) const;
     FieldSizeType getLength(SizeType row, RowSizeType column) const;
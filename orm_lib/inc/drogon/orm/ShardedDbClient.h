@@ -0,0 +1,247 @@
+/**
+ *
+ *  @file ShardedDbClient.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/orm/DbClient.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+template <typename T>
+class IOThreadSnapshot;
+
+namespace orm
+{
+class ShardedDbClient;
+using ShardedDbClientPtr = std::shared_ptr<ShardedDbClient>;
+
+/// Routes the queries of a shard key to one of several database clients
+/**
+ * The key (a tenant, a user...) is mapped to a shard by a consistent hash
+ * ring with virtual nodes, so adding or removing a shard only moves the keys
+ * of its share of the ring. A lookup table of pinned keys takes precedence
+ * over the ring, to place a large tenant on its own shard or to move the
+ * keys one at a time while resharding.
+ *
+ * The client of a key has the whole DbClient API:
+ * @code
+   auto shards = app().getShardedDbClient("tenants");
+   shards->client(tenantId)->execSqlAsync(
+       "select * from orders where tenant_id=$1", cb, ecb, tenantId);
+   Mapper<Orders> mapper(shards->client(tenantId));
+   @endcode
+ *
+ * The routing table is read without locks by the IO loops. A change of the
+ * shards or of the pinned keys keeps the previous table, and
+ * previousClient() gives the shard of a key before the change, where its
+ * rows are until they are copied to the new one.
+ *
+ * @note Like IOThreadStorage, it must be created once the number of IO
+ * threads is set.
+ */
+class DROGON_EXPORT ShardedDbClient : public trantor::NonCopyable
+{
+  public:
+    using Shards = std::vector<std::pair<std::string, DbClientPtr>>;
+
+    /**
+     * @param shards The clients of the shards with their names, the names
+     * place the shards on the ring, so a shard keeps its keys when its
+     * client is replaced or the shards are listed in another order.
+     * @param virtualNodes The points of every shard on the ring.
+     */
+    explicit ShardedDbClient(const Shards &shards, size_t virtualNodes = 160);
+    ~ShardedDbClient();
+
+    static ShardedDbClientPtr newShardedClient(const Shards &shards,
+                                               size_t virtualNodes = 160)
+    {
+        return std::make_shared<ShardedDbClient>(shards, virtualNodes);
+    }
+
+    /// The client of the shard of a key, nullptr if there is no shard
+    DbClientPtr client(std::string_view key) const;
+
+    /// The name of the shard of a key, empty if there is no shard
+    std::string shard(std::string_view key) const;
+
+    /// The client of a key before the last change of the shards or of the
+    /// pinned keys
+    DbClientPtr previousClient(std::string_view key) const;
+
+    /// The shards, in the order they were added
+    Shards shards() const;
+
+    /**
+     * @brief Add a shard, which takes its share of the keys on the ring.
+     *
+     * @return false if a shard has the name already.
+     */
+    bool addShard(const std::string &name, DbClientPtr client);
+
+    /**
+     * @brief Remove a shard, its keys move to the next shards on the ring
+     * and its pinned keys go back to the ring.
+     *
+     * @return false if there is no shard with the name.
+     */
+    bool removeShard(const std::string &name);
+
+    /**
+     * @brief Send the queries of a key to a shard, whatever its place on
+     * the ring.
+     *
+     * @return false if there is no shard with the name.
+     */
+    bool pinKey(const std::string &key, const std::string &shard);
+
+    /// Put a pinned key back on the ring
+    void unpinKey(const std::string &key);
+
+    /// Execute a query on the shard of a key, see DbClient::execSqlAsync()
+    /**
+     * The exception callback takes a DrogonDbException, it is called with a
+     * Failure when there is no shard.
+     */
+    template <typename FUNCTION1, typename FUNCTION2, typename... Arguments>
+    void execSqlAsync(std::string_view key,
+                      const std::string &sql,
+                      FUNCTION1 &&rCallback,
+                      FUNCTION2 &&exceptCallback,
+                      Arguments &&...args) noexcept
+    {
+        auto dbClient = client(key);
+        if (!dbClient)
+        {
+            exceptCallback(Failure("No shard for the key"));
+            return;
+        }
+        dbClient->execSqlAsync(sql,
+                               std::forward<FUNCTION1>(rCallback),
+                               std::forward<FUNCTION2>(exceptCallback),
+                               std::forward<Arguments>(args)...);
+    }
+
+    /// Execute a query on all the shards in parallel and merge the results
+    /**
+     * @param initial The initial value of the merged result.
+     * @param reducer Called with the merged result, the name of a shard and
+     * its result, for every shard in the order of shards() once all of them
+     * answered, so it needs no synchronization.
+     * @param resultCallback Called with the merged result.
+     * @param exceptCallback Called with the first error, the other results
+     * are then dropped.
+     *
+     * @code
+       shards->scatterGatherAsync<size_t>(
+           "select count(*) from orders",
+           0,
+           [](size_t &total, const std::string &, const Result &r) {
+               total += r[0][0].as<size_t>();
+           },
+           [](size_t &&total) { ... },
+           [](const DrogonDbException &e) { ... });
+       @endcode
+     */
+    template <typename T, typename... Arguments>
+    void scatterGatherAsync(
+        const std::string &sql,
+        T initial,
+        std::function<void(T &, const std::string &, const Result &)>
+            reducer,
+        std::function<void(T &&)> resultCallback,
+        ExceptionCallback exceptCallback,
+        Arguments &&...args) noexcept
+    {
+        auto targets = shards();
+        if (targets.empty())
+        {
+            resultCallback(std::move(initial));
+            return;
+        }
+        struct Gather
+        {
+            explicit Gather(T initial) : value(std::move(initial))
+            {
+            }
+
+            Shards targets;
+            std::vector<std::optional<Result>> results;
+            std::atomic<size_t> pending{0};
+            std::atomic<bool> failed{false};
+            T value;
+            std::function<void(T &, const std::string &, const Result &)>
+                reducer;
+            std::function<void(T &&)> resultCallback;
+            ExceptionCallback exceptCallback;
+        };
+        auto gather = std::make_shared<Gather>(std::move(initial));
+        gather->results.resize(targets.size());
+        gather->pending = targets.size();
+        gather->reducer = std::move(reducer);
+        gather->resultCallback = std::move(resultCallback);
+        gather->exceptCallback = std::move(exceptCallback);
+        gather->targets = std::move(targets);
+        for (size_t i = 0; i < gather->targets.size(); ++i)
+        {
+            gather->targets[i].second->execSqlAsync(
+                sql,
+                [gather, i](const Result &result) {
+                    gather->results[i] = result;
+                    if (gather->pending.fetch_sub(1) != 1 ||
+                        gather->failed.load())
+                        return;
+                    for (size_t j = 0; j < gather->targets.size(); ++j)
+                    {
+                        gather->reducer(gather->value,
+                                        gather->targets[j].first,
+                                        *gather->results[j]);
+                    }
+                    gather->resultCallback(std::move(gather->value));
+                },
+                [gather](const DrogonDbException &e) {
+                    gather->pending.fetch_sub(1);
+                    if (!gather->failed.exchange(true))
+                        gather->exceptCallback(e);
+                },
+                args...);
+        }
+    }
+
+  private:
+    struct Topology;
+    using TopologyPtr = std::shared_ptr<const Topology>;
+
+    // Build the next table from the current one, under the mutex
+    void publish(std::function<void(Topology &)> &&change);
+
+    const size_t virtualNodes_;
+    std::mutex mutex_;
+    TopologyPtr latest_;
+    std::unique_ptr<IOThreadSnapshot<Topology>> topology_;
+};
+
+}  // namespace orm
+}  // namespace drogon
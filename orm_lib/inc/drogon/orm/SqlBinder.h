@@ -26,6 +26,7 @@
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/NonCopyable.h>
 #include <json/json.h>
+#include <array>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -125,6 +126,17 @@ struct RawParameter
     int format;
 };
 
+/**
+ * @brief A text or binary parameter bound without copying its data, which
+ * must stay valid until the query is done, like a constant or the data held
+ * by the callbacks of the query.
+ */
+struct ParameterView
+{
+    std::string_view data;
+    bool binary{false};
+};
+
 namespace internal
 {
 template <typename T>
@@ -333,6 +345,8 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
           lengths_(std::move(that.lengths_)),
           formats_(std::move(that.formats_)),
           objs_(std::move(that.objs_)),
+          scalars_(std::move(that.scalars_)),
+          scalarsNumber_(that.scalarsNumber_),
           mode_(that.mode_),
           callbackHolder_(std::move(that.callbackHolder_)),
           exceptionCallback_(std::move(that.exceptionCallback_)),
@@ -384,43 +398,40 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
     {
         using ParaType = std::remove_cv_t<std::remove_reference_t<T>>;
         ++parametersNumber_;
-        std::shared_ptr<void> obj = std::make_shared<ParaType>(parameter);
+        auto obj = newScalar<ParaType>(parameter);
         if (type_ == ClientType::PostgreSQL)
         {
             switch (sizeof(T))
             {
                 case 2:
-                    *std::static_pointer_cast<uint16_t>(obj) =
+                    *reinterpret_cast<uint16_t *>(obj) =
                         htons((uint16_t)parameter);
                     break;
                 case 4:
-                    *std::static_pointer_cast<uint32_t>(obj) =
+                    *reinterpret_cast<uint32_t *>(obj) =
                         htonl((uint32_t)parameter);
                     break;
                 case 8:
-                    *std::static_pointer_cast<uint64_t>(obj) =
+                    *reinterpret_cast<uint64_t *>(obj) =
                         htonll((uint64_t)parameter);
                     break;
                 case 1:
                 default:
                     break;
             }
-            objs_.push_back(obj);
-            parameters_.push_back((char *)obj.get());
+            parameters_.push_back((char *)obj);
             lengths_.push_back(sizeof(T));
             formats_.push_back(1);
         }
         else if (type_ == ClientType::Mysql)
         {
-            objs_.push_back(obj);
-            parameters_.push_back((char *)obj.get());
+            parameters_.push_back((char *)obj);
             lengths_.push_back(0);
             formats_.push_back(getMysqlType<ParaType>());
         }
         else if (type_ == ClientType::Sqlite3)
         {
-            objs_.push_back(obj);
-            parameters_.push_back((char *)obj.get());
+            parameters_.push_back((char *)obj);
             lengths_.push_back(0);
             switch (sizeof(T))
             {
@@ -452,6 +463,8 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
 
     self &operator<<(RawParameter &&);
 
+    self &operator<<(const ParameterView &param);
+
     // template <>
     self &operator<<(const char str[])
     {
@@ -601,6 +614,34 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
   private:
     static int getMysqlTypeBySize(size_t size);
 
+    static constexpr size_t kScalarSlots = 16;
+    using ScalarSlots = std::array<uint64_t, kScalarSlots>;
+
+    // Copy a scalar parameter to the slots shared by the scalars of the
+    // query, allocated once per kScalarSlots scalars instead of one by one
+    template <typename ParaType>
+    ParaType *newScalar(const ParaType &parameter)
+    {
+        if constexpr (sizeof(ParaType) <= sizeof(uint64_t) &&
+                      alignof(ParaType) <= alignof(uint64_t) &&
+                      std::is_trivially_copyable_v<ParaType>)
+        {
+            if (!scalars_ || scalarsNumber_ == kScalarSlots)
+            {
+                scalars_ = std::make_shared<ScalarSlots>();
+                objs_.push_back(scalars_);
+                scalarsNumber_ = 0;
+            }
+            return new (&(*scalars_)[scalarsNumber_++]) ParaType(parameter);
+        }
+        else
+        {
+            auto obj = std::make_shared<ParaType>(parameter);
+            objs_.push_back(obj);
+            return obj.get();
+        }
+    }
+
     template <typename T>
     static int getMysqlType()
     {
@@ -681,6 +722,8 @@ class DROGON_EXPORT SqlBinder : public trantor::NonCopyable
     std::vector<int> lengths_;
     std::vector<int> formats_;
     std::vector<std::shared_ptr<void>> objs_;
+    std::shared_ptr<ScalarSlots> scalars_;
+    size_t scalarsNumber_{0};
     Mode mode_{Mode::NonBlocking};
     std::shared_ptr<CallbackHolderBase> callbackHolder_;
     DrogonDbExceptionCallback exceptionCallback_;
@@ -0,0 +1,459 @@
+/**
+ *
+ *  @file CachedDbClientImpl.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "CachedDbClientImpl.h"
+#include "ReplicatedDbClient.h"
+#include "../../lib/src/BuiltinMetrics.h"
+#include <drogon/orm/DbTypes.h>
+#include <drogon/orm/SqlBinder.h>
+#include <cctype>
+
+using namespace drogon;
+using namespace drogon::orm;
+
+CachedDbClientPtr CachedDbClient::newCachedClient(DbClientPtr client,
+                                                  double ttl,
+                                                  size_t capacity)
+{
+    return std::make_shared<CachedDbClientImpl>(std::move(client),
+                                                ttl,
+                                                capacity);
+}
+
+CachedDbClientImpl::CachedDbClientImpl(DbClientPtr client,
+                                       double ttl,
+                                       size_t capacity)
+    : client_(std::move(client)),
+      ttl_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(ttl))),
+      capacity_(capacity)
+{
+    type_ = client_->type();
+    connectionInfo_ = client_->connectionInfo();
+}
+
+// The size of a parameter whose length is 0, or -1 if it is unknown
+static int parameterSize(ClientType type, int length, int format)
+{
+    using namespace drogon::orm::internal;
+    if (length > 0 || type == ClientType::PostgreSQL)
+        return length;
+    if (type == ClientType::Mysql)
+    {
+        switch (format)
+        {
+            case MySqlTiny:
+            case MySqlUTiny:
+                return 1;
+            case MySqlShort:
+            case MySqlUShort:
+                return 2;
+            case MySqlLong:
+            case MySqlULong:
+                return 4;
+            case MySqlLongLong:
+            case MySqlULongLong:
+                return 8;
+            case MySqlString:
+                return 0;
+            default:
+                return -1;
+        }
+    }
+    switch (format)
+    {
+        case Sqlite3TypeChar:
+            return 1;
+        case Sqlite3TypeShort:
+            return 2;
+        case Sqlite3TypeInt:
+            return 4;
+        case Sqlite3TypeInt64:
+        case Sqlite3TypeDouble:
+            return 8;
+        case Sqlite3TypeText:
+        case Sqlite3TypeBlob:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+// The sql and the formats, sizes and bytes of the parameters, false if a
+// parameter can't be keyed, e.g. a MySQL default value
+static bool buildKey(std::string &key,
+                     ClientType type,
+                     std::string_view sql,
+                     size_t paraNum,
+                     const std::vector<const char *> &parameters,
+                     const std::vector<int> &length,
+                     const std::vector<int> &format)
+{
+    key.reserve(sql.size() + paraNum * 16);
+    key.append(sql);
+    for (size_t i = 0; i < paraNum; ++i)
+    {
+        int size = 0;
+        if (parameters[i])
+        {
+            size = parameterSize(type, length[i], format[i]);
+            if (size < 0)
+                return false;
+        }
+        else if (type == ClientType::Mysql &&
+                 format[i] == internal::DrogonDefaultValue)
+        {
+            return false;
+        }
+        else
+        {
+            // Null, distinct from the empty strings
+            size = -1;
+        }
+        key.push_back('\0');
+        key.append(reinterpret_cast<const char *>(&format[i]),
+                   sizeof(format[i]));
+        key.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        if (size > 0)
+            key.append(parameters[i], size);
+    }
+    return true;
+}
+
+std::vector<std::string> CachedDbClientImpl::tablesOf(std::string_view sql)
+{
+    std::vector<std::string> tables;
+    // Whether a table name is expected after the current word, and whether
+    // a FROM list is parsed at every parenthesis depth
+    bool expectTable = false;
+    std::vector<bool> inTableList{false};
+    size_t i = 0;
+    while (i < sql.size())
+    {
+        auto c = sql[i];
+        if (c == '\'')
+        {
+            auto end = sql.find(c, i + 1);
+            i = end == std::string_view::npos ? sql.size() : end + 1;
+            expectTable = false;
+            continue;
+        }
+        if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-')
+        {
+            auto end = sql.find('\n', i);
+            i = end == std::string_view::npos ? sql.size() : end + 1;
+            continue;
+        }
+        if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*')
+        {
+            auto end = sql.find("*/", i + 2);
+            i = end == std::string_view::npos ? sql.size() : end + 2;
+            continue;
+        }
+        if (isspace(static_cast<unsigned char>(c)))
+        {
+            ++i;
+            continue;
+        }
+        if (c == '(' || c == ')')
+        {
+            if (c == '(')
+                inTableList.push_back(false);
+            else if (inTableList.size() > 1)
+                inTableList.pop_back();
+            expectTable = false;
+            ++i;
+            continue;
+        }
+        if (c == ',')
+        {
+            expectTable = inTableList.back();
+            ++i;
+            continue;
+        }
+        if (c != '"' && c != '`' && !isalpha(static_cast<unsigned char>(c)) &&
+            c != '_')
+        {
+            expectTable = false;
+            ++i;
+            continue;
+        }
+        // A possibly quoted and qualified name, only its last part is kept
+        std::string name;
+        bool quoted = false;
+        while (i < sql.size())
+        {
+            c = sql[i];
+            if (c == '"' || c == '`')
+            {
+                auto end = sql.find(c, i + 1);
+                if (end == std::string_view::npos)
+                    end = sql.size();
+                name.assign(sql.data() + i + 1, end - i - 1);
+                quoted = true;
+                i = end + 1;
+            }
+            else
+            {
+                name.clear();
+                quoted = false;
+                while (i < sql.size() &&
+                       (isalnum(static_cast<unsigned char>(sql[i])) ||
+                        sql[i] == '_' || sql[i] == '$'))
+                {
+                    name.push_back(static_cast<char>(
+                        tolower(static_cast<unsigned char>(sql[i]))));
+                    ++i;
+                }
+            }
+            if (i < sql.size() && sql[i] == '.')
+            {
+                ++i;
+                continue;
+            }
+            break;
+        }
+        if (expectTable)
+        {
+            if (!quoted && (name == "only" || name == "lateral" ||
+                            name == "table" || name == "ignore"))
+                continue;
+            if (!name.empty())
+                tables.push_back(name);
+            expectTable = false;
+            continue;
+        }
+        if (quoted)
+            continue;
+        if (name == "from" || name == "join" || name == "into" ||
+            name == "update" || name == "table" || name == "truncate")
+        {
+            expectTable = true;
+            if (name == "from" || name == "update")
+                inTableList.back() = true;
+        }
+        else if (name == "where" || name == "group" || name == "order" ||
+                 name == "having" || name == "limit" || name == "union" ||
+                 name == "except" || name == "intersect" ||
+                 name == "window" || name == "returning" || name == "set" ||
+                 name == "select" || name == "values" || name == "for")
+        {
+            inTableList.back() = false;
+        }
+    }
+    return tables;
+}
+
+CachedDbClientImpl::Tags CachedDbClientImpl::tagsOf(
+    const std::vector<std::string> &tables)
+{
+    Tags tags;
+    tags.reserve(tables.size());
+    for (auto &table : tables)
+    {
+        auto iter = generations_.find(table);
+        tags.emplace_back(table,
+                          iter == generations_.end() ? 0 : iter->second);
+    }
+    return tags;
+}
+
+bool CachedDbClientImpl::isFresh(const Entry &entry) const
+{
+    if (entry.epoch_ != epoch_ ||
+        entry.expiry_ <= std::chrono::steady_clock::now())
+        return false;
+    for (auto &[table, generation] : entry.tags_)
+    {
+        auto iter = generations_.find(table);
+        if ((iter == generations_.end() ? 0 : iter->second) != generation)
+            return false;
+    }
+    return true;
+}
+
+void CachedDbClientImpl::store(std::string &&key,
+                               const Result &result,
+                               Tags &&tags,
+                               uint64_t epoch)
+{
+    // The cached copy doesn't hold the buffers of the database library
+    auto compact = result.compact();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry entry{std::move(compact),
+                std::move(tags),
+                epoch,
+                std::chrono::steady_clock::now() + ttl_};
+    // A table was invalidated while the query ran
+    if (!isFresh(entry))
+        return;
+    auto iter = map_.find(key);
+    if (iter != map_.end())
+    {
+        iter->second->second = std::move(entry);
+        lru_.splice(lru_.begin(), lru_, iter->second);
+        return;
+    }
+    lru_.emplace_front(std::move(key), std::move(entry));
+    map_.emplace(lru_.front().first, lru_.begin());
+    while (capacity_ > 0 && lru_.size() > capacity_)
+    {
+        map_.erase(lru_.back().first);
+        lru_.pop_back();
+        BuiltinMetrics::instance().resultCache(
+            BuiltinMetrics::ResultCacheEvent::kEviction);
+    }
+}
+
+void CachedDbClientImpl::execSql(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    std::string_view sqlView{sql, sqlLength};
+    std::weak_ptr<CachedDbClientImpl> weakPtr = shared_from_this();
+    if (!ReplicatedDbClient::isReadOnly(sqlView))
+    {
+        // Invalidate once the write is done, so a result queried meanwhile
+        // is not kept
+        auto invalidateTables = [weakPtr, tables = tablesOf(sqlView)]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            if (tables.empty())
+            {
+                thisPtr->invalidateAll();
+                return;
+            }
+            for (auto &table : tables)
+            {
+                thisPtr->invalidate(table);
+            }
+        };
+        forwardSql(*client_,
+                   sql,
+                   sqlLength,
+                   paraNum,
+                   std::move(parameters),
+                   std::move(length),
+                   std::move(format),
+                   [invalidateTables, rcb = std::move(rcb)](const Result &r) {
+                       invalidateTables();
+                       rcb(r);
+                   },
+                   [invalidateTables,
+                    exceptCallback = std::move(exceptCallback)](
+                       const std::exception_ptr &e) {
+                       invalidateTables();
+                       exceptCallback(e);
+                   });
+        return;
+    }
+    std::string key;
+    if (!buildKey(key, type_, sqlView, paraNum, parameters, length, format))
+    {
+        forwardSql(*client_,
+                   sql,
+                   sqlLength,
+                   paraNum,
+                   std::move(parameters),
+                   std::move(length),
+                   std::move(format),
+                   std::move(rcb),
+                   std::move(exceptCallback));
+        return;
+    }
+    auto tables = tablesOf(sqlView);
+    Tags tags;
+    uint64_t epoch;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto iter = map_.find(key);
+        if (iter != map_.end())
+        {
+            if (isFresh(iter->second->second))
+            {
+                lru_.splice(lru_.begin(), lru_, iter->second);
+                auto result = iter->second->second.result_;
+                lock.unlock();
+                BuiltinMetrics::instance().resultCache(
+                    BuiltinMetrics::ResultCacheEvent::kHit);
+                rcb(result);
+                return;
+            }
+            lru_.erase(iter->second);
+            map_.erase(iter);
+        }
+        tags = tagsOf(tables);
+        epoch = epoch_;
+    }
+    BuiltinMetrics::instance().resultCache(
+        BuiltinMetrics::ResultCacheEvent::kMiss);
+    forwardSql(*client_,
+               sql,
+               sqlLength,
+               paraNum,
+               std::move(parameters),
+               std::move(length),
+               std::move(format),
+               [weakPtr,
+                key = std::move(key),
+                tags = std::move(tags),
+                epoch,
+                rcb = std::move(rcb)](const Result &r) mutable {
+                   auto thisPtr = weakPtr.lock();
+                   if (thisPtr)
+                       thisPtr->store(std::move(key),
+                                      r,
+                                      std::move(tags),
+                                      epoch);
+                   rcb(r);
+               },
+               std::move(exceptCallback));
+}
+
+void CachedDbClientImpl::invalidate(const std::string &table)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The stale results are dropped when they are looked up or evicted
+    ++generations_[table];
+}
+
+void CachedDbClientImpl::invalidateAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++epoch_;
+    lru_.clear();
+    map_.clear();
+}
+
+void CachedDbClientImpl::invalidateOn(const DbListenerPtr &listener,
+                                      const std::string &channel)
+{
+    std::weak_ptr<CachedDbClientImpl> weakPtr = shared_from_this();
+    listener->listen(channel,
+                     [weakPtr](const std::string &, const std::string &table) {
+                         auto thisPtr = weakPtr.lock();
+                         if (!thisPtr)
+                             return;
+                         if (table.empty())
+                             thisPtr->invalidateAll();
+                         else
+                             thisPtr->invalidate(table);
+                     });
+}
@@ -0,0 +1,122 @@
+/**
+ *
+ *  @file CachedDbClientImpl.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/CachedDbClient.h>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+class CachedDbClientImpl
+    : public CachedDbClient,
+      public std::enable_shared_from_this<CachedDbClientImpl>
+{
+  public:
+    CachedDbClientImpl(DbClientPtr client, double ttl, size_t capacity);
+
+    void execSql(const char *sql,
+                 size_t sqlLength,
+                 size_t paraNum,
+                 std::vector<const char *> &&parameters,
+                 std::vector<int> &&length,
+                 std::vector<int> &&format,
+                 ResultCallback &&rcb,
+                 std::function<void(const std::exception_ptr &)>
+                     &&exceptCallback) override;
+    std::shared_ptr<Transaction> newTransaction(
+        const std::function<void(bool)> &commitCallback =
+            std::function<void(bool)>()) noexcept(false) override
+    {
+        return client_->newTransaction(commitCallback);
+    }
+
+    void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override
+    {
+        client_->newTransactionAsync(callback);
+    }
+
+    bool hasAvailableConnections() const noexcept override
+    {
+        return client_->hasAvailableConnections();
+    }
+
+    DbPoolStatus poolStatus() const noexcept override
+    {
+        return client_->poolStatus();
+    }
+
+    void setTimeout(double timeout) override
+    {
+        client_->setTimeout(timeout);
+    }
+
+    void closeAll() override
+    {
+        client_->closeAll();
+    }
+
+    void invalidate(const std::string &table) override;
+    void invalidateAll() override;
+    void invalidateOn(const DbListenerPtr &listener,
+                      const std::string &channel) override;
+
+    /// The tables following FROM, JOIN, INTO, UPDATE and TABLE in the sql
+    static std::vector<std::string> tablesOf(std::string_view sql);
+
+  private:
+    // The tables of a result with their generations when it was queried
+    using Tags = std::vector<std::pair<std::string, uint64_t>>;
+
+    struct Entry
+    {
+        Result result_;
+        Tags tags_;
+        uint64_t epoch_;
+        std::chrono::steady_clock::time_point expiry_;
+    };
+
+    using LruList = std::list<std::pair<std::string, Entry>>;
+
+    Tags tagsOf(const std::vector<std::string> &tables);
+    bool isFresh(const Entry &entry) const;
+    void store(std::string &&key,
+               const Result &result,
+               Tags &&tags,
+               uint64_t epoch);
+
+    DbClientPtr client_;
+    std::chrono::steady_clock::duration ttl_;
+    size_t capacity_;
+    mutable std::mutex mutex_;
+    // The most recently used result is at the front
+    LruList lru_;
+    std::unordered_map<std::string_view, LruList::iterator> map_;
+    std::unordered_map<std::string, uint64_t> generations_;
+    uint64_t epoch_{0};
+};
+
+}  // namespace orm
+}  // namespace drogon
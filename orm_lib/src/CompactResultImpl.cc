@@ -0,0 +1,130 @@
+/**
+ *
+ *  @file CompactResultImpl.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "CompactResultImpl.h"
+#include <drogon/orm/Exception.h>
+#include <algorithm>
+#include <cassert>
+
+using namespace drogon::orm;
+
+namespace
+{
+std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return tolower(c);
+    });
+    return text;
+}
+}  // namespace
+
+CompactResultImpl::CompactResultImpl(const ResultImpl &result)
+    : rows_(result.size()),
+      affectedRows_(result.affectedRows()),
+      insertId_(result.insertId())
+{
+    auto columnsNumber = result.columns();
+    columns_.resize(columnsNumber);
+    for (RowSizeType c = 0; c < columnsNumber; ++c)
+    {
+        auto &column = columns_[c];
+        column.name_ = result.columnName(c);
+        column.key_ = toLower(column.name_);
+        column.oid_ = result.oid(c);
+        column.isBinary_ = result.isBinary(c);
+        column.jsonType_ = result.jsonType(c);
+        size_t dataLength = 0;
+        for (SizeType r = 0; r < rows_; ++r)
+            dataLength += result.getLength(r, c) + 1;
+        column.data_.reserve(dataLength);
+        column.offsets_.reserve(rows_ + 1);
+        column.states_.reserve(rows_);
+        for (SizeType r = 0; r < rows_; ++r)
+        {
+            column.offsets_.push_back(column.data_.size());
+            auto value = result.getValue(r, c);
+            if (!value)
+            {
+                column.states_.push_back(kNullPointer);
+            }
+            else
+            {
+                column.states_.push_back(result.isNull(r, c) ? kNull : kValue);
+                column.data_.append(value, result.getLength(r, c));
+            }
+            column.data_.push_back('\0');
+        }
+        column.offsets_.push_back(column.data_.size());
+    }
+}
+
+const char *CompactResultImpl::columnName(RowSizeType number) const
+{
+    assert(number < columns_.size());
+    return columns_[number].name_.c_str();
+}
+
+Result::RowSizeType CompactResultImpl::columnNumber(const char colName[]) const
+{
+    auto key = toLower(colName);
+    for (RowSizeType c = 0; c < columns_.size(); ++c)
+    {
+        if (columns_[c].key_ == key)
+            return c;
+    }
+    throw RangeError(std::string("there is no column named ") + colName);
+}
+
+const char *CompactResultImpl::getValue(SizeType row, RowSizeType column) const
+{
+    assert(row < rows_);
+    assert(column < columns_.size());
+    auto &col = columns_[column];
+    if (col.states_[row] == kNullPointer)
+        return nullptr;
+    return col.data_.data() + col.offsets_[row];
+}
+
+bool CompactResultImpl::isNull(SizeType row, RowSizeType column) const
+{
+    assert(row < rows_);
+    assert(column < columns_.size());
+    return columns_[column].states_[row] != kValue;
+}
+
+Result::FieldSizeType CompactResultImpl::getLength(SizeType row,
+                                                   RowSizeType column) const
+{
+    assert(row < rows_);
+    assert(column < columns_.size());
+    auto &col = columns_[column];
+    return col.offsets_[row + 1] - col.offsets_[row] - 1;
+}
+
+int CompactResultImpl::oid(RowSizeType column) const
+{
+    assert(column < columns_.size());
+    return columns_[column].oid_;
+}
+
+bool CompactResultImpl::isBinary(RowSizeType column) const noexcept
+{
+    return column < columns_.size() && columns_[column].isBinary_;
+}
+
+ResultImpl::JsonType CompactResultImpl::jsonType(RowSizeType column) const
+{
+    assert(column < columns_.size());
+    return columns_[column].jsonType_;
+}
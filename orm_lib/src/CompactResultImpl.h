@@ -0,0 +1,95 @@
+/**
+ *
+ *  @file CompactResultImpl.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "ResultImpl.h"
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief An owned copy of a result, whatever its database, stored column by
+ * column. The values of a column are null terminated one after the other in
+ * a single buffer, the names of the columns are looked up without a map.
+ */
+class CompactResultImpl : public ResultImpl
+{
+  public:
+    explicit CompactResultImpl(const ResultImpl &result);
+
+    SizeType size() const noexcept override
+    {
+        return rows_;
+    }
+
+    RowSizeType columns() const noexcept override
+    {
+        return columns_.size();
+    }
+
+    const char *columnName(RowSizeType number) const override;
+
+    SizeType affectedRows() const noexcept override
+    {
+        return affectedRows_;
+    }
+
+    RowSizeType columnNumber(const char colName[]) const override;
+    const char *getValue(SizeType row, RowSizeType column) const override;
+    bool isNull(SizeType row, RowSizeType column) const override;
+    FieldSizeType getLength(SizeType row, RowSizeType column) const override;
+
+    unsigned long long insertId() const noexcept override
+    {
+        return insertId_;
+    }
+
+    int oid(RowSizeType column) const override;
+    bool isBinary(RowSizeType column) const noexcept override;
+    JsonType jsonType(RowSizeType column) const override;
+
+  private:
+    struct Column
+    {
+        std::string name_;
+        // Lower case, to look up the column
+        std::string key_;
+        int oid_{0};
+        bool isBinary_{false};
+        JsonType jsonType_{kJsonString};
+        std::string data_;
+        // The offset of every value in the data and the end of the last one
+        std::vector<size_t> offsets_;
+        std::vector<unsigned char> states_;
+    };
+
+    enum State : unsigned char
+    {
+        kValue = 0,
+        kNull,
+        // A null value read as a null pointer from the original result
+        kNullPointer
+    };
+
+    SizeType rows_;
+    SizeType affectedRows_;
+    unsigned long long insertId_;
+    std::vector<Column> columns_;
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -13,8 +13,10 @@
  */
 
 #include "DbClientImpl.h"
+#include "ReplicatedDbClient.h"
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
+#include <atomic>
 using namespace drogon::orm;
 using namespace drogon;
 
@@ -30,9 +32,106 @@ orm::internal::SqlBinder DbClient::operator<<(std::string &&sql)
     return orm::internal::SqlBinder(std::move(sql), *this, type_);
 }
 
+namespace
+{
+struct RowStream : public std::enable_shared_from_this<RowStream>
+{
+    std::shared_ptr<Transaction> transaction_;
+    std::string fetchSql_;
+    size_t chunkRows_{0};
+    RowChunkCallback chunkCallback_;
+    std::function<void(const std::exception_ptr &)> exceptCallback_;
+    std::atomic<bool> waitingForResume_{false};
+
+    void fetchNextChunk()
+    {
+        auto thisPtr = shared_from_this();
+        auto binder = *transaction_ << fetchSql_;
+        binder >> [thisPtr](const Result &r) { thisPtr->onChunk(r); };
+        binder >> [thisPtr](const std::exception_ptr &e) { thisPtr->fail(e); };
+        binder.exec();
+    }
+
+    void onChunk(const Result &r)
+    {
+        if (r.size() < chunkRows_)
+        {
+            // Close the cursor so that another stream can be opened in a
+            // transaction owned by the user.
+            auto transaction = std::move(transaction_);
+            *transaction << "CLOSE drogon_stream" >> [](const Result &) {} >>
+                [](const std::exception_ptr &) {};
+            chunkCallback_(r, true, []() {});
+            return;
+        }
+        waitingForResume_ = true;
+        // The resume function holds the stream, dropping it cancels the
+        // query and releases the connection.
+        chunkCallback_(r, false, [thisPtr = shared_from_this()]() {
+            if (thisPtr->waitingForResume_.exchange(false))
+                thisPtr->fetchNextChunk();
+        });
+    }
+
+    void fail(const std::exception_ptr &e)
+    {
+        transaction_.reset();
+        exceptCallback_(e);
+    }
+};
+}  // namespace
+
+void DbClient::execSqlStream(
+    const std::string &sql,
+    size_t chunkRows,
+    std::function<void(internal::SqlBinder &)> &&bindParameters,
+    RowChunkCallback &&chunkCallback,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    auto stream = std::make_shared<RowStream>();
+    stream->chunkRows_ = chunkRows == 0 ? 1 : chunkRows;
+    stream->fetchSql_ = "FETCH FORWARD " + std::to_string(stream->chunkRows_) +
+                        " FROM drogon_stream";
+    stream->chunkCallback_ = std::move(chunkCallback);
+    stream->exceptCallback_ = std::move(exceptCallback);
+    newTransactionAsync([stream,
+                         sql,
+                         type = type_,
+                         bindParameters = std::move(bindParameters)](
+                            const std::shared_ptr<Transaction> &transaction) {
+        if (!transaction)
+        {
+            stream->exceptCallback_(std::make_exception_ptr(TimeoutError(
+                "Timeout, no connection available for streaming query")));
+            return;
+        }
+        if (type != ClientType::PostgreSQL)
+        {
+            auto binder = *transaction << sql;
+            bindParameters(binder);
+            binder >> [stream, transaction](const Result &r) {
+                stream->chunkCallback_(r, true, []() {});
+            };
+            binder >> [stream](const std::exception_ptr &e) {
+                stream->exceptCallback_(e);
+            };
+            binder.exec();
+            return;
+        }
+        stream->transaction_ = transaction;
+        auto binder =
+            *transaction << "DECLARE drogon_stream NO SCROLL CURSOR FOR " + sql;
+        bindParameters(binder);
+        binder >> [stream](const Result &) { stream->fetchNextChunk(); };
+        binder >> [stream](const std::exception_ptr &e) { stream->fail(e); };
+        binder.exec();
+    });
+}
+
 std::shared_ptr<DbClient> DbClient::newPgClient(const std::string &connInfo,
                                                 size_t connNum,
-                                                bool autoBatch)
+                                                bool autoBatch,
+                                                bool binaryResults)
 {
 #if USE_POSTGRESQL
     auto client = std::make_shared<DbClientImpl>(connInfo,
@@ -43,6 +142,7 @@ std::shared_ptr<DbClient> DbClient::newPgClient(const std::string &connInfo,
 #else
                                                  ClientType::PostgreSQL);
 #endif
+    client->setBinaryResults(binaryResults);
     client->init();
     return client;
 #else
@@ -54,7 +154,8 @@ std::shared_ptr<DbClient> DbClient::newPgClient(const std::string &connInfo,
 }
 
 std::shared_ptr<DbClient> DbClient::newMysqlClient(const std::string &connInfo,
-                                                   size_t connNum)
+                                                   size_t connNum,
+                                                   bool preparedStatements)
 {
 #if USE_MYSQL
     auto client = std::make_shared<DbClientImpl>(connInfo,
@@ -65,6 +166,7 @@ std::shared_ptr<DbClient> DbClient::newMysqlClient(const std::string &connInfo,
 #else
                                                  ClientType::Mysql);
 #endif
+    client->setPreparedStatements(preparedStatements);
     client->init();
     return client;
 #else
@@ -72,6 +174,7 @@ std::shared_ptr<DbClient> DbClient::newMysqlClient(const std::string &connInfo,
     exit(1);
     (void)(connInfo);
     (void)(connNum);
+    (void)(preparedStatements);
 #endif
 }
 
@@ -97,3 +200,62 @@ std::shared_ptr<DbClient> DbClient::newSqlite3Client(
     (void)(connNum);
 #endif
 }
+
+std::shared_ptr<DbClient> DbClient::newSqlite3WalClient(
+    const std::string &connInfo,
+    size_t readConnNum,
+    bool batchWrites)
+{
+#if USE_SQLITE3
+    // The readers wait for the checkpoints of the writer instead of failing
+    auto writer = std::make_shared<DbClientImpl>(
+        connInfo + " journal_mode=wal synchronous=normal busy_timeout=5000",
+        1,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+        ClientType::Sqlite3,
+        false);
+#else
+        ClientType::Sqlite3);
+#endif
+    writer->setBatchWrites(batchWrites);
+    writer->init();
+    auto readers = std::make_shared<DbClientImpl>(
+        connInfo + " busy_timeout=5000 query_only=1",
+        readConnNum,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+        ClientType::Sqlite3,
+        false);
+#else
+        ClientType::Sqlite3);
+#endif
+    readers->init();
+    return newReplicatedClient(std::move(writer), {std::move(readers)});
+#else
+    LOG_FATAL << "Sqlite3 is not supported!";
+    exit(1);
+    (void)(connInfo);
+    (void)(readConnNum);
+    (void)(batchWrites);
+#endif
+}
+
+std::shared_ptr<DbClient> DbClient::newReplicatedClient(
+    std::shared_ptr<DbClient> primary,
+    std::vector<std::shared_ptr<DbClient>> replicas,
+    double maxReplicaLag)
+{
+    auto client = std::make_shared<ReplicatedDbClient>(std::move(primary),
+                                                       std::move(replicas),
+                                                       maxReplicaLag);
+    client->init();
+    return client;
+}
+
+std::shared_ptr<DbClient> DbClient::newReadYourWritesSession(
+    const std::shared_ptr<DbClient> &client)
+{
+    auto replicated = std::dynamic_pointer_cast<ReplicatedDbClient>(client);
+    if (!replicated)
+        return client;
+    return std::make_shared<ReadYourWritesSession>(std::move(replicated));
+}
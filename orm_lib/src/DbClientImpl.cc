@@ -14,6 +14,7 @@
 
 #include "DbClientImpl.h"
 #include "DbConnection.h"
+#include "../../lib/src/BuiltinMetrics.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
 #include <drogon/config.h>
 #include <string_view>
@@ -41,12 +42,48 @@
 #include <thread>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/Channel.h>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <random>
 #include <unordered_set>
 #include <vector>
 
 using namespace drogon;
 using namespace drogon::orm;
 
+static constexpr size_t kMaxBufferedCommands{200000};
+// The most commands sent in one pipeline or one batched transaction
+static constexpr size_t kMaxPipelinedCommands{64};
+// A growing pool opens a connection when a command waited this long
+static constexpr double kPoolGrowthWait{0.01};
+static constexpr double kPoolMaintenanceInterval{1.0};
+
+static void markBuffered(SqlCmd &cmd, bool always = false)
+{
+    if (always || BuiltinMetrics::instance().enabled())
+        cmd.bufferedDate_ = trantor::Date::now();
+}
+
+// The lifetime shortened by up to 10%, so that the connections opened
+// together are not replaced together
+static double jitteredLifetime(double lifetime)
+{
+    thread_local std::mt19937_64 engine{std::random_device{}()};
+    return lifetime *
+           (1.0 - 0.1 * std::uniform_real_distribution<double>(0, 1)(engine));
+}
+
+static void observeWait(const SqlCmd &cmd)
+{
+    if (cmd.bufferedDate_.microSecondsSinceEpoch() == 0)
+        return;
+    auto wait = trantor::Date::now().microSecondsSinceEpoch() -
+                cmd.bufferedDate_.microSecondsSinceEpoch();
+    BuiltinMetrics::instance().poolWaited(BuiltinMetrics::Pool::kDb,
+                                          static_cast<double>(wait) / 1000000);
+}
+
 DbClientImpl::DbClientImpl(const std::string &connInfo,
                            size_t connNum,
 #if LIBPQ_SUPPORTS_BATCH_MODE
@@ -72,17 +109,69 @@ DbClientImpl::DbClientImpl(const std::string &connInfo,
     assert(connNum > 0);
 }
 
+DbClientImpl::DbClientImpl(const std::string &connInfo,
+                           size_t connNum,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+                           ClientType type,
+                           bool autoBatch,
+#else
+                           ClientType type,
+#endif
+                           const std::vector<trantor::EventLoop *> &loops)
+    : numberOfConnections_(connNum),
+#if LIBPQ_SUPPORTS_BATCH_MODE
+      autoBatch_(autoBatch),
+#endif
+      loops_(0, "DbLoop")
+{
+    type_ = type;
+    connectionInfo_ = connInfo;
+    LOG_TRACE << "type=" << (int)type << ", loop affine";
+    assert(connNum > 0);
+    assert(!loops.empty());
+    assert(type != ClientType::Sqlite3);
+    for (auto *loop : loops)
+    {
+        loopQueues_.emplace_back(std::make_unique<LoopQueue>(loop));
+        loopQueueMap_[loop] = loopQueues_.back().get();
+    }
+}
+
 void DbClientImpl::init()
 {
+    if (loopAffine())
+    {
+        // Spread the connections over the loops, the first loops get one
+        // more connection when they can't be spread evenly.
+        for (size_t i = 0; i < numberOfConnections_; ++i)
+        {
+            ++loopQueues_[i % loopQueues_.size()]->connectionNumber_;
+        }
+        for (size_t i = 0; i < numberOfConnections_; ++i)
+        {
+            auto loop = loopQueues_[i % loopQueues_.size()]->loop_;
+            loop->runInLoop([this, loop]() { newConnection(loop); });
+        }
+        return;
+    }
     // LOG_DEBUG << loops_.getLoopNum();
     loops_.start();
     if (type_ == ClientType::PostgreSQL || type_ == ClientType::Mysql)
     {
+        managesPool_ = true;
         for (size_t i = 0; i < numberOfConnections_; ++i)
         {
             auto loop = loops_.getNextLoop();
             loop->runInLoop([this, loop]() { newConnection(loop); });
         }
+        std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+        poolLoop_ = loops_.getNextLoop();
+        poolTimerId_ =
+            poolLoop_->runEvery(kPoolMaintenanceInterval, [weakPtr]() {
+                auto thisPtr = weakPtr.lock();
+                if (thisPtr)
+                    thisPtr->maintainPool();
+            });
     }
     else if (type_ == ClientType::Sqlite3)
     {
@@ -103,12 +192,16 @@ DbClientImpl::~DbClientImpl() noexcept
 
 void DbClientImpl::closeAll()
 {
+    if (poolLoop_)
+        poolLoop_->invalidateTimer(poolTimerId_);
     decltype(connections_) connections;
     {
         std::lock_guard<std::mutex> lock(connectionsMutex_);
         connections.swap(connections_);
         readyConnections_.clear();
         busyConnections_.clear();
+        connectionTimes_.clear();
+        publishPoolMetrics(0, 0);
     }
     for (auto const &conn : connections)
     {
@@ -130,6 +223,9 @@ void DbClientImpl::execSql(
     assert(paraNum == length.size());
     assert(paraNum == format.size());
     assert(rcb);
+    if (queryStats_)
+        queryStats_->observe(
+            {sql, sqlLength}, paraNum, rcb, exceptCallback, shared_from_this());
     if (timeout_ > 0.0)
     {
         execSqlWithTimeout(sql,
@@ -142,14 +238,34 @@ void DbClientImpl::execSql(
                            std::move(exceptCallback));
         return;
     }
+    if (loopAffine())
+    {
+        if (pendingCommands_ > kMaxBufferedCommands)
+        {
+            exceptCallback(
+                std::make_exception_ptr(Failure("Too many queries in buffer")));
+            return;
+        }
+        execSqlLoopAffine(sql,
+                          sqlLength,
+                          paraNum,
+                          std::move(parameters),
+                          std::move(length),
+                          std::move(format),
+                          std::move(rcb),
+                          std::move(exceptCallback),
+                          nullptr);
+        return;
+    }
     DbConnectionPtr conn;
     bool busy = false;
+    trantor::EventLoop *growLoop{nullptr};
     {
         std::lock_guard<std::mutex> guard(connectionsMutex_);
 
         if (readyConnections_.size() == 0)
         {
-            if (sqlCmdBuffer_.size() > 200000)
+            if (sqlCmdBuffer_.size() > kMaxBufferedCommands)
             {
                 // too many queries in buffer;
                 busy = true;
@@ -165,7 +281,10 @@ void DbClientImpl::execSql(
                                              std::move(format),
                                              std::move(rcb),
                                              std::move(exceptCallback));
+                markBuffered(*cmd, growsPool());
                 sqlCmdBuffer_.push_back(std::move(cmd));
+                if (growsPool())
+                    growLoop = loopToGrow(trantor::Date::now());
             }
         }
         else
@@ -178,6 +297,7 @@ void DbClientImpl::execSql(
     }
     if (conn)
     {
+        BuiltinMetrics::instance().poolWaited(BuiltinMetrics::Pool::kDb, 0);
         conn->execSql({sql, sqlLength},
                       paraNum,
                       std::move(parameters),
@@ -194,12 +314,29 @@ void DbClientImpl::execSql(
         exceptCallback(exceptPtr);
         return;
     }
+    if (growLoop)
+        growPool(growLoop);
 }
 
 void DbClientImpl::newTransactionAsync(
     const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
 {
     DbConnectionPtr conn;
+    if (loopAffine())
+    {
+        auto queue = currentLoopQueue();
+        if (queue && !queue->idleConnections_.empty())
+        {
+            conn = std::move(queue->idleConnections_.back());
+            queue->idleConnections_.pop_back();
+            --queue->idleCount_;
+            makeTrans(
+                conn,
+                std::function<void(const std::shared_ptr<Transaction> &)>(
+                    callback));
+            return;
+        }
+    }
     {
         std::lock_guard<std::mutex> lock(connectionsMutex_);
         if (!readyConnections_.empty())
@@ -220,7 +357,7 @@ void DbClientImpl::newTransactionAsync(
                     std::make_shared<std::weak_ptr<std::function<void(
                         const std::shared_ptr<Transaction> &)>>>();
                 auto timeoutFlagPtr = std::make_shared<TaskTimeoutFlag>(
-                    loops_.getNextLoop(),
+                    nextLoop(),
                     std::chrono::duration<double>(timeout_),
                     [newCallbackPtr, callbackPtr, this]() {
                         auto cbPtr = (*newCallbackPtr).lock();
@@ -234,6 +371,7 @@ void DbClientImpl::newTransactionAsync(
                                 if (cbPtr == *iter)
                                 {
                                     transCallbacks_.erase(iter);
+                                    --pendingTransactions_;
                                     break;
                                 }
                             }
@@ -252,6 +390,7 @@ void DbClientImpl::newTransactionAsync(
                 timeoutFlagPtr->runTimer();
             }
             transCallbacks_.push_back(callbackPtr);
+            ++pendingTransactions_;
         }
     }
     if (conn)
@@ -259,6 +398,13 @@ void DbClientImpl::newTransactionAsync(
         makeTrans(conn,
                   std::function<void(const std::shared_ptr<Transaction> &)>(
                       callback));
+        return;
+    }
+    if (loopAffine())
+    {
+        // Wake up a loop with an idle connection to start the transaction.
+        if (auto queue = pickLoopQueue(nullptr, true))
+            scheduleDrain(queue);
     }
 }
 
@@ -335,14 +481,52 @@ std::shared_ptr<Transaction> DbClientImpl::newTransaction(
 
 void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
 {
+    if (loopAffine())
+    {
+        auto iter = loopQueueMap_.find(connPtr->loop());
+        assert(iter != loopQueueMap_.end());
+        handleIdleConnection(iter->second, connPtr);
+        return;
+    }
     std::function<void(const std::shared_ptr<Transaction> &)> transCallback;
     std::shared_ptr<SqlCmd> cmd;
+    std::deque<std::shared_ptr<SqlCmd>> cmds;
+    bool expired{false};
     {
         std::lock_guard<std::mutex> guard(connectionsMutex_);
-        if (!transCallbacks_.empty())
+        ConnectionTimes *times{nullptr};
+        if (managesPool_)
+        {
+            auto iter = connectionTimes_.find(connPtr);
+            if (iter == connectionTimes_.end())
+            {
+                // The connection was retired while it was busy
+                return;
+            }
+            times = &iter->second;
+        }
+        if (times && poolConfig_.maxLifetime > 0 &&
+            trantor::Date::now() > times->expiry_)
+        {
+            expired = true;
+        }
+        else if (!transCallbacks_.empty())
         {
             transCallback = std::move(*(transCallbacks_.front()));
             transCallbacks_.pop_front();
+            --pendingTransactions_;
+        }
+        else if (sqlCmdBuffer_.size() > 1 && batchesCommands())
+        {
+            // Queries that piled up while all connections were busy are
+            // sent to the connection as one pipeline (PostgreSQL) or as one
+            // transaction (SQLite).
+            auto n = (std::min)(sqlCmdBuffer_.size(), kMaxPipelinedCommands);
+            cmds.insert(cmds.end(),
+                        std::make_move_iterator(sqlCmdBuffer_.begin()),
+                        std::make_move_iterator(sqlCmdBuffer_.begin() + n));
+            sqlCmdBuffer_.erase(sqlCmdBuffer_.begin(),
+                                sqlCmdBuffer_.begin() + n);
         }
         else if (!sqlCmdBuffer_.empty())
         {
@@ -354,8 +538,15 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
             // Connection is idle, put it into the readyConnections_ set;
             busyConnections_.erase(connPtr);
             readyConnections_.insert(connPtr);
+            if (times)
+                times->idleSince_ = trantor::Date::now();
         }
     }
+    if (expired)
+    {
+        retireConnection(connPtr, true);
+        return;
+    }
     if (transCallback)
     {
         makeTrans(connPtr, std::move(transCallback));
@@ -363,15 +554,311 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
     }
     if (cmd)
     {
-        connPtr->execSql(std::move(cmd->sql_),
-                         cmd->parametersNumber_,
-                         std::move(cmd->parameters_),
-                         std::move(cmd->lengths_),
-                         std::move(cmd->formats_),
-                         std::move(cmd->callback_),
-                         std::move(cmd->exceptionCallback_));
+        runCommand(connPtr, std::move(cmd));
+        return;
+    }
+    if (!cmds.empty())
+    {
+        for (auto &c : cmds)
+        {
+            observeWait(*c);
+        }
+        connPtr->batchSql(std::move(cmds));
+    }
+}
+
+bool DbClientImpl::batchesCommands() const noexcept
+{
+#if LIBPQ_SUPPORTS_BATCH_MODE
+    if (type_ == ClientType::PostgreSQL)
+        return true;
+#endif
+    return type_ == ClientType::Sqlite3 && batchWrites_;
+}
+
+void DbClientImpl::runCommand(const DbConnectionPtr &connPtr,
+                              std::shared_ptr<SqlCmd> &&cmd)
+{
+    observeWait(*cmd);
+    connPtr->execSql(std::move(cmd->sql_),
+                     cmd->parametersNumber_,
+                     std::move(cmd->parameters_),
+                     std::move(cmd->lengths_),
+                     std::move(cmd->formats_),
+                     std::move(cmd->callback_),
+                     std::move(cmd->exceptionCallback_));
+}
+
+trantor::EventLoop *DbClientImpl::nextLoop()
+{
+    if (!loopAffine())
+        return loops_.getNextLoop();
+    if (auto queue = currentLoopQueue())
+        return queue->loop_;
+    return loopQueues_[nextLoopQueue_++ % loopQueues_.size()]->loop_;
+}
+
+DbClientImpl::LoopQueue *DbClientImpl::currentLoopQueue() const
+{
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!loop)
+        return nullptr;
+    auto iter = loopQueueMap_.find(loop);
+    if (iter == loopQueueMap_.end())
+        return nullptr;
+    return iter->second;
+}
+
+DbClientImpl::LoopQueue *DbClientImpl::pickLoopQueue(LoopQueue *self,
+                                                     bool needIdle)
+{
+    // Prefer the loop with the most idle connections, then the loop with the
+    // fewest queued commands per connection. The scan starts at a rotating
+    // position so that ties are spread over the loops.
+    LoopQueue *best{nullptr};
+    size_t bestIdle{0};
+    size_t bestPending{std::numeric_limits<size_t>::max()};
+    auto start = nextLoopQueue_++;
+    for (size_t i = 0; i < loopQueues_.size(); ++i)
+    {
+        auto queue = loopQueues_[(start + i) % loopQueues_.size()].get();
+        if (queue == self || queue->connectionNumber_ == 0)
+            continue;
+        auto idle = queue->idleCount_.load();
+        if (idle > bestIdle)
+        {
+            best = queue;
+            bestIdle = idle;
+            continue;
+        }
+        if (needIdle || bestIdle > 0)
+            continue;
+        auto pending = queue->pendingCount_.load() / queue->connectionNumber_;
+        if (pending < bestPending)
+        {
+            best = queue;
+            bestPending = pending;
+        }
+    }
+    return best;
+}
+
+void DbClientImpl::execSqlLoopAffine(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback,
+    std::weak_ptr<SqlCmd> *queuedCmd)
+{
+    auto self = currentLoopQueue();
+    if (self && !self->idleConnections_.empty())
+    {
+        // Fast path, the caller runs on the loop of an idle connection.
+        auto conn = std::move(self->idleConnections_.back());
+        self->idleConnections_.pop_back();
+        --self->idleCount_;
+        BuiltinMetrics::instance().poolWaited(BuiltinMetrics::Pool::kDb, 0);
+        conn->execSql({sql, sqlLength},
+                      paraNum,
+                      std::move(parameters),
+                      std::move(length),
+                      std::move(format),
+                      std::move(rcb),
+                      std::move(exceptCallback));
+        return;
+    }
+    auto cmd = std::make_shared<SqlCmd>(std::string_view{sql, sqlLength},
+                                        paraNum,
+                                        std::move(parameters),
+                                        std::move(length),
+                                        std::move(format),
+                                        std::move(rcb),
+                                        std::move(exceptCallback));
+    markBuffered(*cmd);
+    if (queuedCmd)
+        *queuedCmd = cmd;
+    LoopQueue *target{nullptr};
+    if (self && self->connectionNumber_ > 0)
+    {
+        // The connections of the caller's loop are saturated, hand the
+        // command to another loop only if it has an idle connection.
+        target = pickLoopQueue(self, true);
+        if (!target)
+            target = self;
+    }
+    else
+    {
+        target = pickLoopQueue(nullptr, false);
+    }
+    assert(target);
+    enqueueCommand(target, std::move(cmd));
+}
+
+void DbClientImpl::enqueueCommand(LoopQueue *queue,
+                                  std::shared_ptr<SqlCmd> &&cmd)
+{
+    // The counters are increased before the command is visible and the idle
+    // count is checked after it, while handleIdleConnection() does the
+    // opposite, so one of the two sides always sees the other.
+    ++pendingCommands_;
+    ++queue->pendingCount_;
+    queue->commands_.enqueue(std::move(cmd));
+    if (queue->idleCount_ > 0)
+        scheduleDrain(queue);
+}
+
+void DbClientImpl::scheduleDrain(LoopQueue *queue)
+{
+    if (queue->drainQueued_.exchange(true))
+        return;
+    std::weak_ptr<DbClientImpl> weakThis = shared_from_this();
+    queue->loop_->queueInLoop([weakThis, queue]() {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        queue->drainQueued_ = false;
+        thisPtr->drainLoopQueue(queue);
+    });
+}
+
+bool DbClientImpl::dequeueCommand(LoopQueue *queue,
+                                  std::shared_ptr<SqlCmd> &cmd)
+{
+    while (queue->commands_.dequeue(cmd))
+    {
+        --queue->pendingCount_;
+        --pendingCommands_;
+        if (!cmd->cancelled_)
+            return true;
+    }
+    return false;
+}
+
+bool DbClientImpl::assignTask(LoopQueue *queue, const DbConnectionPtr &connPtr)
+{
+    if (pendingTransactions_ > 0)
+    {
+        std::function<void(const std::shared_ptr<Transaction> &)>
+            transCallback;
+        {
+            std::lock_guard<std::mutex> guard(connectionsMutex_);
+            if (!transCallbacks_.empty())
+            {
+                transCallback = std::move(*(transCallbacks_.front()));
+                transCallbacks_.pop_front();
+                --pendingTransactions_;
+            }
+        }
+        if (transCallback)
+        {
+            makeTrans(connPtr, std::move(transCallback));
+            return true;
+        }
+    }
+    std::shared_ptr<SqlCmd> cmd;
+    if (!dequeueCommand(queue, cmd))
+        return false;
+    runCommand(connPtr, std::move(cmd));
+    return true;
+}
+
+void DbClientImpl::drainLoopQueue(LoopQueue *queue)
+{
+    queue->loop_->assertInLoopThread();
+    while (!queue->idleConnections_.empty())
+    {
+        auto conn = std::move(queue->idleConnections_.back());
+        queue->idleConnections_.pop_back();
+        --queue->idleCount_;
+        if (!assignTask(queue, conn))
+        {
+            queue->idleConnections_.push_back(std::move(conn));
+            ++queue->idleCount_;
+            return;
+        }
+    }
+}
+
+void DbClientImpl::handleIdleConnection(LoopQueue *queue,
+                                        const DbConnectionPtr &connPtr)
+{
+    queue->loop_->assertInLoopThread();
+    if (assignTask(queue, connPtr))
+        return;
+    queue->idleConnections_.push_back(connPtr);
+    ++queue->idleCount_;
+    if (queue->pendingCount_ > 0 || pendingTransactions_ > 0)
+    {
+        // Something was queued while this connection was being parked.
+        drainLoopQueue(queue);
         return;
     }
+    // Nothing to do on this loop, steal from the loop with the longest queue
+    // among the ones whose connections are all busy.
+    LoopQueue *victim{nullptr};
+    size_t maxPending{0};
+    for (auto &q : loopQueues_)
+    {
+        if (q.get() == queue || q->idleCount_ > 0)
+            continue;
+        auto pending = q->pendingCount_.load();
+        if (pending > maxPending)
+        {
+            victim = q.get();
+            maxPending = pending;
+        }
+    }
+    if (!victim)
+        return;
+    std::weak_ptr<DbClientImpl> weakThis = shared_from_this();
+    // Only the owner loop consumes a queue, so the victim moves the commands
+    // itself.
+    victim->loop_->queueInLoop([weakThis, victim, queue]() {
+        auto thisPtr = weakThis.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->stealCommands(victim, queue);
+    });
+}
+
+void DbClientImpl::stealCommands(LoopQueue *victim, LoopQueue *thief)
+{
+    victim->loop_->assertInLoopThread();
+    if (victim->idleCount_ > 0 || thief->idleCount_ == 0)
+        return;
+    // Take half of the queue, but no more than the thief can run right now.
+    auto count = std::min((victim->pendingCount_.load() + 1) / 2,
+                          thief->idleCount_.load());
+    size_t moved{0};
+    std::shared_ptr<SqlCmd> cmd;
+    while (moved < count && victim->commands_.dequeue(cmd))
+    {
+        --victim->pendingCount_;
+        if (cmd->cancelled_)
+        {
+            --pendingCommands_;
+            continue;
+        }
+        ++thief->pendingCount_;
+        thief->commands_.enqueue(std::move(cmd));
+        ++moved;
+    }
+    if (moved > 0)
+        scheduleDrain(thief);
+}
+
+void DbClientImpl::setStatementCache(size_t capacity, size_t warmCount)
+{
+    statementCacheSize_ = capacity;
+    warmStatements_ = warmCount;
+#if USE_POSTGRESQL
+    if (warmCount > 0 && type_ == ClientType::PostgreSQL)
+        statementStats_ = std::make_shared<PgStatementStats>();
+#endif
 }
 
 DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
@@ -381,11 +868,18 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     {
 #if USE_POSTGRESQL
 #if LIBPQ_SUPPORTS_BATCH_MODE
-        connPtr =
-            std::make_shared<PgConnection>(loop, connectionInfo_, autoBatch_);
+        connPtr = std::make_shared<PgConnection>(loop,
+                                                 connectionInfo_,
+                                                 autoBatch_,
+                                                 binaryResults_);
 #else
-        connPtr = std::make_shared<PgConnection>(loop, connectionInfo_, false);
+        connPtr = std::make_shared<PgConnection>(loop,
+                                                 connectionInfo_,
+                                                 false,
+                                                 binaryResults_);
 #endif
+        std::static_pointer_cast<PgConnection>(connPtr)->setStatementCache(
+            statementCacheSize_, warmStatements_, statementStats_);
 #else
         return nullptr;
 #endif
@@ -393,7 +887,11 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     else if (type_ == ClientType::Mysql)
     {
 #if USE_MYSQL
-        connPtr = std::make_shared<MysqlConnection>(loop, connectionInfo_);
+        auto mysqlConnPtr =
+            std::make_shared<MysqlConnection>(loop, connectionInfo_);
+        if (preparedStatements_)
+            mysqlConnPtr->setPreparedStatements(statementCacheSize_);
+        connPtr = mysqlConnPtr;
 #else
         return nullptr;
 #endif
@@ -419,18 +917,41 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
+        bool reconnect{true};
         {
             std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
             thisPtr->readyConnections_.erase(closeConnPtr);
             thisPtr->busyConnections_.erase(closeConnPtr);
-            assert(thisPtr->connections_.find(closeConnPtr) !=
-                   thisPtr->connections_.end());
-            thisPtr->connections_.erase(closeConnPtr);
+            if (thisPtr->connections_.erase(closeConnPtr) == 0)
+            {
+                // The connection was retired by the pool
+                return;
+            }
+            thisPtr->connectionTimes_.erase(closeConnPtr);
+            // The connections opened by a growing pool are not replaced
+            if (thisPtr->growsPool() &&
+                thisPtr->connections_.size() >= thisPtr->numberOfConnections_)
+                reconnect = false;
+        }
+        if (thisPtr->loopAffine())
+        {
+            // The close callback runs in the loop of the connection.
+            auto queue =
+                thisPtr->loopQueueMap_.find(closeConnPtr->loop())->second;
+            auto &idle = queue->idleConnections_;
+            auto iter = std::find(idle.begin(), idle.end(), closeConnPtr);
+            if (iter != idle.end())
+            {
+                idle.erase(iter);
+                --queue->idleCount_;
+            }
         }
         // Reconnect after 1 second
         auto loop = closeConnPtr->loop();
         // closeConnPtr may be not valid. Close the connection file descriptor.
         closeConnPtr->disconnect();
+        if (!reconnect)
+            return;
         loop->runAfter(1, [weakPtr, loop, closeConnPtr] {
             auto thisPtr = weakPtr.lock();
             if (!thisPtr)
@@ -466,6 +987,15 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     {
         std::lock_guard<std::mutex> guard(connectionsMutex_);
         connections_.insert(connPtr);
+        if (managesPool_)
+        {
+            auto now = trantor::Date::now();
+            auto &times = connectionTimes_[connPtr];
+            times.idleSince_ = now;
+            if (poolConfig_.maxLifetime > 0)
+                times.expiry_ =
+                    now.after(jitteredLifetime(poolConfig_.maxLifetime));
+        }
     }
 
     // Init database connection only after all callbacks are set and connPtr
@@ -482,6 +1012,188 @@ bool DbClientImpl::hasAvailableConnections() const noexcept
     return (!readyConnections_.empty()) || (!busyConnections_.empty());
 }
 
+DbPoolStatus DbClientImpl::poolStatus() const noexcept
+{
+    DbPoolStatus status;
+    status.queuedTransactions =
+        pendingTransactions_.load(std::memory_order_relaxed);
+    if (loopAffine())
+    {
+        // The idle connections of the loop queues are only counted
+        for (auto &queue : loopQueues_)
+        {
+            status.idle += queue->idleCount_.load(std::memory_order_relaxed);
+            status.queued +=
+                queue->pendingCount_.load(std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        status.connections = connections_.size();
+        status.busy = status.connections > status.idle
+                          ? status.connections - status.idle
+                          : 0;
+        return status;
+    }
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    status.connections = connections_.size();
+    status.busy = busyConnections_.size();
+    status.idle = readyConnections_.size();
+    status.queued = sqlCmdBuffer_.size();
+    return status;
+}
+
+trantor::EventLoop *DbClientImpl::loopToGrow(const trantor::Date &now)
+{
+    // Called with connectionsMutex_ held. One connection is opened at a time,
+    // the commands that keep waiting open the next ones.
+    if (growingConnections_ > 0 || sqlCmdBuffer_.empty() ||
+        connections_.size() >= poolConfig_.maxConnectionNumber ||
+        connections_.size() >
+            readyConnections_.size() + busyConnections_.size())
+    {
+        return nullptr;
+    }
+    auto buffered = sqlCmdBuffer_.front()->bufferedDate_;
+    if (buffered.microSecondsSinceEpoch() == 0 ||
+        !(now > buffered.after(kPoolGrowthWait)))
+        return nullptr;
+    ++growingConnections_;
+    return loops_.getNextLoop();
+}
+
+void DbClientImpl::growPool(trantor::EventLoop *loop)
+{
+    std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+    loop->runInLoop([weakPtr, loop]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->newConnection(loop);
+        std::lock_guard<std::mutex> guard(thisPtr->connectionsMutex_);
+        --thisPtr->growingConnections_;
+    });
+}
+
+void DbClientImpl::maintainPool()
+{
+    auto now = trantor::Date::now();
+    std::vector<DbConnectionPtr> expired;
+    std::vector<DbConnectionPtr> extra;
+    std::vector<DbConnectionPtr> unchecked;
+    trantor::EventLoop *growLoop{nullptr};
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        if (growsPool())
+            growLoop = loopToGrow(now);
+        auto removable = connections_.size() > numberOfConnections_
+                             ? connections_.size() - numberOfConnections_
+                             : 0;
+        for (auto &conn : readyConnections_)
+        {
+            auto iter = connectionTimes_.find(conn);
+            if (iter == connectionTimes_.end())
+                continue;
+            auto &times = iter->second;
+            if (poolConfig_.maxLifetime > 0 && now > times.expiry_)
+            {
+                expired.push_back(conn);
+            }
+            else if (removable > 0 && growsPool() &&
+                     poolConfig_.idleTimeout > 0 &&
+                     now > times.idleSince_.after(poolConfig_.idleTimeout))
+            {
+                extra.push_back(conn);
+                --removable;
+            }
+            else if (poolConfig_.healthCheckInterval > 0 &&
+                     now > times.idleSince_.after(
+                               poolConfig_.healthCheckInterval))
+            {
+                unchecked.push_back(conn);
+            }
+        }
+        // The connections being checked are busy until the check is done
+        for (auto &conn : unchecked)
+        {
+            readyConnections_.erase(conn);
+            busyConnections_.insert(conn);
+        }
+        publishPoolMetrics(busyConnections_.size(),
+                           readyConnections_.size() - expired.size() -
+                               extra.size());
+    }
+    for (auto &conn : expired)
+        retireConnection(conn, true);
+    for (auto &conn : extra)
+        retireConnection(conn, false);
+    for (auto &conn : unchecked)
+        checkConnection(conn);
+    if (growLoop)
+        growPool(growLoop);
+}
+
+void DbClientImpl::retireConnection(const DbConnectionPtr &connPtr,
+                                    bool replace)
+{
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        if (connections_.erase(connPtr) == 0)
+            return;
+        readyConnections_.erase(connPtr);
+        busyConnections_.erase(connPtr);
+        connectionTimes_.erase(connPtr);
+    }
+    LOG_TRACE << (replace ? "Replace" : "Close") << " the connection "
+              << connPtr.get();
+    std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+    auto loop = connPtr->loop();
+    loop->runInLoop([weakPtr, connPtr, loop, replace]() {
+        connPtr->disconnect();
+        if (!replace)
+            return;
+        auto thisPtr = weakPtr.lock();
+        if (thisPtr)
+            thisPtr->newConnection(loop);
+    });
+}
+
+void DbClientImpl::checkConnection(const DbConnectionPtr &connPtr)
+{
+    std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+    std::weak_ptr<DbConnection> weakConn = connPtr;
+    // The connection becomes idle again when the query is done
+    connPtr->execSql(
+        "SELECT 1",
+        0,
+        {},
+        {},
+        {},
+        [](const Result &) {},
+        [weakPtr, weakConn](const std::exception_ptr &) {
+            auto thisPtr = weakPtr.lock();
+            auto connPtr = weakConn.lock();
+            if (!thisPtr || !connPtr)
+                return;
+            LOG_WARN << "The health check of a database connection failed, "
+                        "replace it";
+            thisPtr->retireConnection(connPtr, true);
+        });
+}
+
+void DbClientImpl::publishPoolMetrics(size_t busy, size_t idle)
+{
+    // Called with connectionsMutex_ held, the gauges are shared by the
+    // clients, so every client adds the change of its own connections.
+    auto &metrics = BuiltinMetrics::instance();
+    metrics.dbPoolConnections(BuiltinMetrics::PoolConnectionState::kBusy,
+                              static_cast<double>(busy) -
+                                  static_cast<double>(publishedBusy_));
+    metrics.dbPoolConnections(BuiltinMetrics::PoolConnectionState::kIdle,
+                              static_cast<double>(idle) -
+                                  static_cast<double>(publishedIdle_));
+    publishedBusy_ = busy;
+    publishedIdle_ = idle;
+}
+
 void DbClientImpl::execSqlWithTimeout(
     const char *sql,
     size_t sqlLength,
@@ -500,11 +1212,17 @@ void DbClientImpl::execSqlWithTimeout(
         std::make_shared<std::function<void(const std::exception_ptr &)>>(
             std::move(ecb));
     auto timeoutFlagPtr = std::make_shared<drogon::TaskTimeoutFlag>(
-        loops_.getNextLoop(),
+        nextLoop(),
         std::chrono::duration<double>(timeout_),
         [cmd, ecpPtr, thisPtr = shared_from_this()]() {
             auto cbPtr = (*cmd).lock();
-            if (cbPtr)
+            if (cbPtr && thisPtr->loopAffine())
+            {
+                // Queued commands can't be removed from the lock-free
+                // queues, they are skipped when dequeued.
+                cbPtr->cancelled_ = true;
+            }
+            else if (cbPtr)
             {
                 std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
                 for (auto iter = thisPtr->sqlCmdBuffer_.begin();
@@ -535,12 +1253,34 @@ void DbClientImpl::execSqlWithTimeout(
         (*ecpPtr)(err);
     };
 
+    if (loopAffine())
+    {
+        if (pendingCommands_ > kMaxBufferedCommands)
+        {
+            exceptionCallback(
+                std::make_exception_ptr(Failure("Too many queries in buffer")));
+            return;
+        }
+        execSqlLoopAffine(sql,
+                          sqlLength,
+                          paraNum,
+                          std::move(parameters),
+                          std::move(length),
+                          std::move(format),
+                          std::move(resultCallback),
+                          std::move(exceptionCallback),
+                          cmd.get());
+        timeoutFlagPtr->runTimer();
+        return;
+    }
+
+    trantor::EventLoop *growLoop{nullptr};
     {
         std::lock_guard<std::mutex> guard(connectionsMutex_);
 
         if (readyConnections_.size() == 0)
         {
-            if (sqlCmdBuffer_.size() > 200000)
+            if (sqlCmdBuffer_.size() > kMaxBufferedCommands)
             {
                 // too many queries in buffer;
                 busy = true;
@@ -556,8 +1296,11 @@ void DbClientImpl::execSqlWithTimeout(
                                              std::move(format),
                                              std::move(resultCallback),
                                              std::move(exceptionCallback));
+                markBuffered(*command, growsPool());
                 sqlCmdBuffer_.emplace_back(command);
                 *cmd = command;
+                if (growsPool())
+                    growLoop = loopToGrow(trantor::Date::now());
             }
         }
         else
@@ -570,6 +1313,7 @@ void DbClientImpl::execSqlWithTimeout(
     }
     if (conn)
     {
+        BuiltinMetrics::instance().poolWaited(BuiltinMetrics::Pool::kDb, 0);
         conn->execSql(std::string_view{sql, sqlLength},
                       paraNum,
                       std::move(parameters),
@@ -589,4 +1333,6 @@ void DbClientImpl::execSqlWithTimeout(
     }
 
     timeoutFlagPtr->runTimer();
+    if (growLoop)
+        growPool(growLoop);
 }
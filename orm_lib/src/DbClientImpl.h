@@ -15,19 +15,27 @@
 #pragma once
 
 #include "DbConnection.h"
+#include "QueryStatistics.h"
 #include <drogon/orm/DbClient.h>
+#include <drogon/orm/DbConfig.h>
 #include <trantor/net/EventLoopThreadPool.h>
+#include <trantor/utils/LockFreeQueue.h>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace drogon
 {
 namespace orm
 {
+class PgStatementStats;
+
 class DbClientImpl : public DbClient,
                      public std::enable_shared_from_this<DbClientImpl>
 {
@@ -40,6 +48,26 @@ class DbClientImpl : public DbClient,
 #else
                  ClientType type);
 #endif
+    /**
+     * @brief Create a client whose connections live on the given loops
+     * (normally the IO loops of the application) instead of on its own
+     * thread pool.
+     *
+     * Queries are dispatched without taking a lock to an idle connection of
+     * the loop the caller runs on. Otherwise the query is put into the
+     * lock-free queue of that loop (or of the least busy loop when the caller
+     * is not on one of the loops), and loops with idle connections steal
+     * queued queries from saturated ones.
+     */
+    DbClientImpl(const std::string &connInfo,
+                 size_t connNum,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+                 ClientType type,
+                 bool autoBatch,
+#else
+                 ClientType type,
+#endif
+                 const std::vector<trantor::EventLoop *> &loops);
     ~DbClientImpl() noexcept override;
     void execSql(const char *sql,
                  size_t sqlLength,
@@ -57,6 +85,7 @@ class DbClientImpl : public DbClient,
         const std::function<void(const std::shared_ptr<Transaction> &)>
             &callback) override;
     bool hasAvailableConnections() const noexcept override;
+    DbPoolStatus poolStatus() const noexcept override;
 
     void setTimeout(double timeout) override
     {
@@ -66,11 +95,95 @@ class DbClientImpl : public DbClient,
     void init();
     void closeAll() override;
 
+    /**
+     * @brief Request PostgreSQL results in the binary format, must be called
+     * before the connections are created.
+     */
+    void setBinaryResults(bool binaryResults)
+    {
+        binaryResults_ = binaryResults;
+    }
+
+    /**
+     * @brief Bound the prepared statements of every PostgreSQL connection
+     * and prepare the warmCount most used statements on new connections,
+     * must be called before the connections are created.
+     */
+    void setStatementCache(size_t capacity, size_t warmCount);
+
+    /**
+     * @brief Execute the MySQL queries with parameters as server-side
+     * prepared statements, bounded by the capacity of the statement cache,
+     * must be called before the connections are created.
+     */
+    void setPreparedStatements(bool preparedStatements)
+    {
+        preparedStatements_ = preparedStatements;
+    }
+
+    /**
+     * @brief Commit the SQLite queries that piled up while the connections
+     * were busy in one transaction, instead of one transaction per query.
+     */
+    void setBatchWrites(bool batchWrites)
+    {
+        batchWrites_ = batchWrites;
+    }
+
+    /**
+     * @brief Grow, shrink, check and recycle the connections of a PostgreSQL
+     * or MySQL client, see PoolConfig. The pools of the loop-affine clients
+     * keep their size. Must be called before init().
+     */
+    void setPoolConfig(const PoolConfig &config)
+    {
+        poolConfig_ = config;
+    }
+
+    /**
+     * @brief Observe the statistics and the slow queries of the statements
+     * executed by the client, see QueryStatsConfig.
+     */
+    void setQueryStatistics(std::shared_ptr<QueryStatistics> queryStats)
+    {
+        queryStats_ = std::move(queryStats);
+    }
+
   private:
+    // Per-loop state of the loop-affine dispatch mode.
+    struct LoopQueue
+    {
+        explicit LoopQueue(trantor::EventLoop *loop) : loop_(loop)
+        {
+        }
+
+        trantor::EventLoop *loop_;
+        size_t connectionNumber_{0};
+        // Only accessed in loop_
+        std::vector<DbConnectionPtr> idleConnections_;
+        std::atomic<size_t> idleCount_{0};
+        // Multiple producers, consumed in loop_ only
+        trantor::MpscQueue<std::shared_ptr<SqlCmd>> commands_;
+        std::atomic<size_t> pendingCount_{0};
+        std::atomic<bool> drainQueued_{false};
+    };
+
     size_t numberOfConnections_;
     trantor::EventLoopThreadPool loops_;
+    std::vector<std::unique_ptr<LoopQueue>> loopQueues_;
+    std::unordered_map<trantor::EventLoop *, LoopQueue *> loopQueueMap_;
+    std::atomic<size_t> pendingCommands_{0};
+    std::atomic<size_t> pendingTransactions_{0};
+    std::atomic<size_t> nextLoopQueue_{0};
     std::shared_ptr<SharedMutex> sharedMutexPtr_;
     double timeout_{-1.0};
+    bool binaryResults_{false};
+    size_t statementCacheSize_{0};
+    size_t warmStatements_{0};
+    bool preparedStatements_{false};
+    std::shared_ptr<PgStatementStats> statementStats_;
+    bool batchWrites_{false};
+    std::shared_ptr<QueryStatistics> queryStats_;
 #if LIBPQ_SUPPORTS_BATCH_MODE
     bool autoBatch_{false};
 #endif
@@ -91,7 +204,69 @@ class DbClientImpl : public DbClient,
 
     std::deque<std::shared_ptr<SqlCmd>> sqlCmdBuffer_;
 
+    struct ConnectionTimes
+    {
+        // When the connection is replaced, if it has a maximum lifetime
+        trantor::Date expiry_;
+        // When the connection last became idle, or was established
+        trantor::Date idleSince_;
+    };
+
+    PoolConfig poolConfig_;
+    // Set by init() for the pools managed with poolConfig_
+    bool managesPool_{false};
+    // The following members are guarded by connectionsMutex_
+    std::unordered_map<DbConnectionPtr, ConnectionTimes> connectionTimes_;
+    // The connections being opened because commands waited too long
+    size_t growingConnections_{0};
+    size_t publishedBusy_{0};
+    size_t publishedIdle_{0};
+    trantor::EventLoop *poolLoop_{nullptr};
+    trantor::TimerId poolTimerId_{0};
+
+    bool growsPool() const noexcept
+    {
+        return managesPool_ &&
+               poolConfig_.maxConnectionNumber > numberOfConnections_;
+    }
+
+    trantor::EventLoop *loopToGrow(const trantor::Date &now);
+    void growPool(trantor::EventLoop *loop);
+    void maintainPool();
+    void retireConnection(const DbConnectionPtr &connPtr, bool replace);
+    void checkConnection(const DbConnectionPtr &connPtr);
+    void publishPoolMetrics(size_t busy, size_t idle);
+
     void handleNewTask(const DbConnectionPtr &connPtr);
+    bool batchesCommands() const noexcept;
+    trantor::EventLoop *nextLoop();
+
+    bool loopAffine() const noexcept
+    {
+        return !loopQueues_.empty();
+    }
+
+    LoopQueue *currentLoopQueue() const;
+    LoopQueue *pickLoopQueue(LoopQueue *self, bool needIdle);
+    void execSqlLoopAffine(
+        const char *sql,
+        size_t sqlLength,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        ResultCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback,
+        std::weak_ptr<SqlCmd> *queuedCmd);
+    void enqueueCommand(LoopQueue *queue, std::shared_ptr<SqlCmd> &&cmd);
+    void scheduleDrain(LoopQueue *queue);
+    bool dequeueCommand(LoopQueue *queue, std::shared_ptr<SqlCmd> &cmd);
+    bool assignTask(LoopQueue *queue, const DbConnectionPtr &connPtr);
+    void drainLoopQueue(LoopQueue *queue);
+    void stealCommands(LoopQueue *victim, LoopQueue *thief);
+    void handleIdleConnection(LoopQueue *queue, const DbConnectionPtr &connPtr);
+    void runCommand(const DbConnectionPtr &connPtr,
+                    std::shared_ptr<SqlCmd> &&cmd);
     void execSqlWithTimeout(
         const char *sql,
         size_t sqlLength,
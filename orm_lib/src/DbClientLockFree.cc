@@ -101,6 +101,9 @@ void DbClientLockFree::execSql(
     assert(paraNum == format.size());
     assert(rcb);
     loop_->assertInLoopThread();
+    if (queryStats_)
+        queryStats_->observe(
+            {sql, sqlLength}, paraNum, rcb, exceptCallback, shared_from_this());
     if (timeout_ > 0.0)
     {
         execSqlWithTimeout(sql,
@@ -403,6 +406,16 @@ void DbClientLockFree::handleNewTask(const DbConnectionPtr &conn)
     }
 }
 
+void DbClientLockFree::setStatementCache(size_t capacity, size_t warmCount)
+{
+    statementCacheSize_ = capacity;
+    warmStatements_ = warmCount;
+#if USE_POSTGRESQL
+    if (warmCount > 0 && type_ == ClientType::PostgreSQL)
+        statementStats_ = std::make_shared<PgStatementStats>();
+#endif
+}
+
 DbConnectionPtr DbClientLockFree::newConnection()
 {
     DbConnectionPtr connPtr;
@@ -410,11 +423,18 @@ DbConnectionPtr DbClientLockFree::newConnection()
     {
 #if USE_POSTGRESQL
 #if LIBPQ_SUPPORTS_BATCH_MODE
-        connPtr =
-            std::make_shared<PgConnection>(loop_, connectionInfo_, autoBatch_);
+        connPtr = std::make_shared<PgConnection>(loop_,
+                                                 connectionInfo_,
+                                                 autoBatch_,
+                                                 binaryResults_);
 #else
-        connPtr = std::make_shared<PgConnection>(loop_, connectionInfo_, false);
+        connPtr = std::make_shared<PgConnection>(loop_,
+                                                 connectionInfo_,
+                                                 false,
+                                                 binaryResults_);
 #endif
+        std::static_pointer_cast<PgConnection>(connPtr)->setStatementCache(
+            statementCacheSize_, warmStatements_, statementStats_);
 #else
         return nullptr;
 #endif
@@ -422,7 +442,11 @@ DbConnectionPtr DbClientLockFree::newConnection()
     else if (type_ == ClientType::Mysql)
     {
 #if USE_MYSQL
-        connPtr = std::make_shared<MysqlConnection>(loop_, connectionInfo_);
+        auto mysqlConnPtr =
+            std::make_shared<MysqlConnection>(loop_, connectionInfo_);
+        if (preparedStatements_)
+            mysqlConnPtr->setPreparedStatements(statementCacheSize_);
+        connPtr = mysqlConnPtr;
 #else
         return nullptr;
 #endif
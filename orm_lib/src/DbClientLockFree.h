@@ -15,6 +15,7 @@
 #pragma once
 
 #include "DbConnection.h"
+#include "QueryStatistics.h"
 #include <drogon/orm/DbClient.h>
 #include <trantor/net/EventLoopThreadPool.h>
 #include <functional>
@@ -29,6 +30,8 @@ namespace drogon
 {
 namespace orm
 {
+class PgStatementStats;
+
 class DbClientLockFree : public DbClient,
                          public std::enable_shared_from_this<DbClientLockFree>
 {
@@ -68,6 +71,41 @@ class DbClientLockFree : public DbClient,
 
     void closeAll() override;
 
+    /**
+     * @brief Request PostgreSQL results in the binary format, must be called
+     * before the connections are created.
+     */
+    void setBinaryResults(bool binaryResults)
+    {
+        binaryResults_ = binaryResults;
+    }
+
+    /**
+     * @brief Bound the prepared statements of every PostgreSQL connection
+     * and prepare the warmCount most used statements on new connections,
+     * must be called before the connections are created.
+     */
+    void setStatementCache(size_t capacity, size_t warmCount);
+
+    /**
+     * @brief Execute the MySQL queries with parameters as server-side
+     * prepared statements, bounded by the capacity of the statement cache,
+     * must be called before the connections are created.
+     */
+    void setPreparedStatements(bool preparedStatements)
+    {
+        preparedStatements_ = preparedStatements;
+    }
+
+    /**
+     * @brief Observe the statistics and the slow queries of the statements
+     * executed by the client, see QueryStatsConfig.
+     */
+    void setQueryStatistics(std::shared_ptr<QueryStatistics> queryStats)
+    {
+        queryStats_ = std::move(queryStats);
+    }
+
   private:
     std::string connectionInfo_;
     trantor::EventLoop *loop_;
@@ -83,6 +121,12 @@ class DbClientLockFree : public DbClient,
         transCallbacks_;
 
     double timeout_{-1.0};
+    bool binaryResults_{false};
+    size_t statementCacheSize_{0};
+    size_t warmStatements_{0};
+    bool preparedStatements_{false};
+    std::shared_ptr<PgStatementStats> statementStats_;
+    std::shared_ptr<QueryStatistics> queryStats_;
 
     void makeTrans(
         const DbConnectionPtr &conn,
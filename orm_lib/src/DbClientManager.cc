@@ -13,6 +13,7 @@
  */
 
 #include "../../lib/src/DbClientManager.h"
+#include "DbClientImpl.h"
 #include "DbClientLockFree.h"
 #include <drogon/config.h>
 #include <drogon/HttpAppFramework.h>
@@ -42,27 +43,53 @@ inline std::string escapeConnString(const std::string &str)
     return escaped;
 }
 
+static std::shared_ptr<QueryStatistics> newQueryStatistics(
+    ClientType dbType,
+    const QueryStatsConfig &config)
+{
+    auto queryStats = std::make_shared<QueryStatistics>(dbType, config);
+    if (!queryStats->enabled())
+        return nullptr;
+    return queryStats;
+}
+
 static void initFastDbClients(IOThreadStorage<orm::DbClientPtr> &storage,
                               const std::vector<trantor::EventLoop *> &ioLoops,
                               const std::string &connInfo,
                               ClientType dbType,
                               size_t connNum,
                               bool autoBatch,
-                              double timeout)
+                              double timeout,
+                              bool binaryResults,
+                              size_t statementCacheSize,
+                              size_t warmStatements,
+                              bool preparedStatements,
+                              const QueryStatsConfig &queryStatsConfig)
 {
+    // The statistics of the statements are shared by the clients of the loops
+    auto queryStats = newQueryStatistics(dbType, queryStatsConfig);
     storage.init([&](orm::DbClientPtr &c, size_t idx) {
+        // The handler loops come and go, they have no fast clients
+        if (idx >= ioLoops.size())
+            return;
         assert(idx == ioLoops[idx]->index());
         LOG_TRACE << "create fast database client for the thread " << idx;
-        c = std::shared_ptr<orm::DbClient>(
-            new drogon::orm::DbClientLockFree(connInfo,
-                                              ioLoops[idx],
-                                              dbType,
+        auto client = std::make_shared<drogon::orm::DbClientLockFree>(
+            connInfo,
+            ioLoops[idx],
+            dbType,
 #if LIBPQ_SUPPORTS_BATCH_MODE  // Bad code
-                                              connNum,
-                                              autoBatch));
+            connNum,
+            autoBatch);
 #else
-                                              connNum));
+            connNum);
 #endif
+        // The connections are created when the IO loop starts
+        client->setBinaryResults(binaryResults);
+        client->setStatementCache(statementCacheSize, warmStatements);
+        client->setPreparedStatements(preparedStatements);
+        client->setQueryStatistics(queryStats);
+        c = client;
         if (timeout > 0.0)
         {
             c->setTimeout(timeout);
@@ -70,11 +97,118 @@ static void initFastDbClients(IOThreadStorage<orm::DbClientPtr> &storage,
     });
 }
 
+static orm::DbClientPtr newLoopAffineDbClient(
+    const std::vector<trantor::EventLoop *> &ioLoops,
+    const std::string &connInfo,
+    ClientType dbType,
+    size_t connNum,
+    bool autoBatch,
+    double timeout,
+    bool binaryResults,
+    size_t statementCacheSize,
+    size_t warmStatements,
+    bool preparedStatements,
+    const QueryStatsConfig &queryStats)
+{
+#if !LIBPQ_SUPPORTS_BATCH_MODE
+    (void)autoBatch;
+#endif
+    auto client = std::make_shared<orm::DbClientImpl>(connInfo,
+                                                      connNum,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+                                                      dbType,
+                                                      autoBatch,
+#else
+                                                      dbType,
+#endif
+                                                      ioLoops);
+    client->setBinaryResults(binaryResults);
+    client->setStatementCache(statementCacheSize, warmStatements);
+    client->setPreparedStatements(preparedStatements);
+    client->setQueryStatistics(newQueryStatistics(dbType, queryStats));
+    client->init();
+    if (timeout > 0.0)
+    {
+        client->setTimeout(timeout);
+    }
+    return client;
+}
+
+static orm::DbClientPtr newPgClient(const std::string &connInfo,
+                                    const PostgresConfig &cfg)
+{
+#if USE_POSTGRESQL
+    auto client = std::make_shared<orm::DbClientImpl>(connInfo,
+                                                      cfg.connectionNumber,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+                                                      ClientType::PostgreSQL,
+                                                      cfg.autoBatch);
+#else
+                                                      ClientType::PostgreSQL);
+#endif
+    client->setBinaryResults(cfg.binaryResults);
+    client->setStatementCache(cfg.statementCacheSize, cfg.warmStatements);
+    client->setPoolConfig(cfg.pool);
+    client->setQueryStatistics(
+        newQueryStatistics(ClientType::PostgreSQL, cfg.queryStats));
+    client->init();
+    return client;
+#else
+    return orm::DbClient::newPgClient(connInfo,
+                                      cfg.connectionNumber,
+                                      cfg.autoBatch,
+                                      cfg.binaryResults);
+#endif
+}
+
+static orm::DbClientPtr newMysqlClient(const std::string &connInfo,
+                                       const MysqlConfig &cfg)
+{
+#if USE_MYSQL
+    auto client = std::make_shared<orm::DbClientImpl>(connInfo,
+                                                      cfg.connectionNumber,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+                                                      ClientType::Mysql,
+                                                      false);
+#else
+                                                      ClientType::Mysql);
+#endif
+    client->setStatementCache(cfg.statementCacheSize, 0);
+    client->setPreparedStatements(cfg.preparedStatements);
+    client->setPoolConfig(cfg.pool);
+    client->setQueryStatistics(
+        newQueryStatistics(ClientType::Mysql, cfg.queryStats));
+    client->init();
+    return client;
+#else
+    return orm::DbClient::newMysqlClient(connInfo, cfg.connectionNumber);
+#endif
+}
+
+template <typename NewClient>
+static orm::DbClientPtr newReplicatedClient(const NewClient &newClient,
+                                            const DbClientManager::DbInfo &info,
+                                            double maxReplicaLag)
+{
+    auto primary = newClient(info.connectionInfo_);
+    if (info.replicaConnectionInfos_.empty())
+        return primary;
+    std::vector<orm::DbClientPtr> replicas;
+    for (auto &connInfo : info.replicaConnectionInfos_)
+    {
+        replicas.push_back(newClient(connInfo));
+    }
+    return orm::DbClient::newReplicatedClient(std::move(primary),
+                                              std::move(replicas),
+                                              maxReplicaLag);
+}
+
 void DbClientManager::createDbClients(
     const std::vector<trantor::EventLoop *> &ioLoops)
 {
     assert(dbClientsMap_.empty());
     assert(dbFastClientsMap_.empty());
+    assert(shardedClientsMap_.empty());
     for (auto &dbInfo : dbInfos_)
     {
         if (std::holds_alternative<PostgresConfig>(dbInfo.config_))
@@ -82,6 +216,11 @@ void DbClientManager::createDbClients(
             auto &cfg = std::get<PostgresConfig>(dbInfo.config_);
             if (cfg.isFast)
             {
+                if (!cfg.replicas.empty())
+                {
+                    LOG_WARN << "The replicas of the fast db client "
+                             << cfg.name << " are ignored";
+                }
                 dbFastClientsMap_[cfg.name] =
                     IOThreadStorage<orm::DbClientPtr>();
                 initFastDbClients(dbFastClientsMap_[cfg.name],
@@ -90,18 +229,37 @@ void DbClientManager::createDbClients(
                                   ClientType::PostgreSQL,
                                   cfg.connectionNumber,
                                   cfg.autoBatch,
-                                  cfg.timeout);
+                                  cfg.timeout,
+                                  cfg.binaryResults,
+                                  cfg.statementCacheSize,
+                                  cfg.warmStatements,
+                                  false,
+                                  cfg.queryStats);
             }
             else
             {
-                dbClientsMap_[cfg.name] =
-                    drogon::orm::DbClient::newPgClient(dbInfo.connectionInfo_,
-                                                       cfg.connectionNumber,
-                                                       cfg.autoBatch);
-                if (cfg.timeout > 0.0)
-                {
-                    dbClientsMap_[cfg.name]->setTimeout(cfg.timeout);
-                }
+                auto newClient = [&](const std::string &connInfo) {
+                    if (cfg.loopAffine)
+                        return newLoopAffineDbClient(ioLoops,
+                                                     connInfo,
+                                                     ClientType::PostgreSQL,
+                                                     cfg.connectionNumber,
+                                                     cfg.autoBatch,
+                                                     cfg.timeout,
+                                                     cfg.binaryResults,
+                                                     cfg.statementCacheSize,
+                                                     cfg.warmStatements,
+                                                     false,
+                                                     cfg.queryStats);
+                    auto client = newPgClient(connInfo, cfg);
+                    if (cfg.timeout > 0.0)
+                    {
+                        client->setTimeout(cfg.timeout);
+                    }
+                    return client;
+                };
+                dbClientsMap_[cfg.name] = newReplicatedClient(
+                    newClient, dbInfo, cfg.maxReplicaLag);
             }
         }
         else if (std::holds_alternative<MysqlConfig>(dbInfo.config_))
@@ -110,6 +268,11 @@ void DbClientManager::createDbClients(
 
             if (cfg.isFast)
             {
+                if (!cfg.replicas.empty())
+                {
+                    LOG_WARN << "The replicas of the fast db client "
+                             << cfg.name << " are ignored";
+                }
                 dbFastClientsMap_[cfg.name] =
                     IOThreadStorage<orm::DbClientPtr>();
                 initFastDbClients(dbFastClientsMap_[cfg.name],
@@ -118,30 +281,111 @@ void DbClientManager::createDbClients(
                                   ClientType::Mysql,
                                   cfg.connectionNumber,
                                   false,
-                                  cfg.timeout);
+                                  cfg.timeout,
+                                  false,
+                                  cfg.statementCacheSize,
+                                  0,
+                                  cfg.preparedStatements,
+                                  cfg.queryStats);
             }
             else
             {
-                dbClientsMap_[cfg.name] = drogon::orm::DbClient::newMysqlClient(
-                    dbInfo.connectionInfo_, cfg.connectionNumber);
-                if (cfg.timeout > 0.0)
-                {
-                    dbClientsMap_[cfg.name]->setTimeout(cfg.timeout);
-                }
+                auto newClient = [&](const std::string &connInfo) {
+                    if (cfg.loopAffine)
+                        return newLoopAffineDbClient(ioLoops,
+                                                     connInfo,
+                                                     ClientType::Mysql,
+                                                     cfg.connectionNumber,
+                                                     false,
+                                                     cfg.timeout,
+                                                     false,
+                                                     cfg.statementCacheSize,
+                                                     0,
+                                                     cfg.preparedStatements,
+                                                     cfg.queryStats);
+                    auto client = newMysqlClient(connInfo, cfg);
+                    if (cfg.timeout > 0.0)
+                    {
+                        client->setTimeout(cfg.timeout);
+                    }
+                    return client;
+                };
+                dbClientsMap_[cfg.name] = newReplicatedClient(
+                    newClient, dbInfo, cfg.maxReplicaLag);
             }
         }
         else if (std::holds_alternative<Sqlite3Config>(dbInfo.config_))
         {
             auto &cfg = std::get<Sqlite3Config>(dbInfo.config_);
-            dbClientsMap_[cfg.name] =
-                drogon::orm::DbClient::newSqlite3Client(dbInfo.connectionInfo_,
-                                                        cfg.connectionNumber);
+            if (cfg.walPool)
+            {
+                dbClientsMap_[cfg.name] =
+                    drogon::orm::DbClient::newSqlite3WalClient(
+                        dbInfo.connectionInfo_,
+                        cfg.connectionNumber,
+                        cfg.batchWrites);
+            }
+            else
+            {
+                auto client = std::make_shared<DbClientImpl>(
+                    dbInfo.connectionInfo_,
+                    cfg.connectionNumber,
+#if LIBPQ_SUPPORTS_BATCH_MODE
+                    ClientType::Sqlite3,
+                    false);
+#else
+                    ClientType::Sqlite3);
+#endif
+                client->setBatchWrites(cfg.batchWrites);
+                client->setQueryStatistics(
+                    newQueryStatistics(ClientType::Sqlite3, cfg.queryStats));
+                client->init();
+                dbClientsMap_[cfg.name] = client;
+            }
             if (cfg.timeout > 0.0)
             {
                 dbClientsMap_[cfg.name]->setTimeout(cfg.timeout);
             }
         }
     }
+    // The shards are the shared clients created above
+    for (auto &info : shardedInfos_)
+    {
+        ShardedDbClient::Shards shards;
+        for (auto &name : info.shards_)
+        {
+            auto iter = dbClientsMap_.find(name);
+            if (iter == dbClientsMap_.end())
+            {
+                LOG_FATAL << "The shard " << name << " of the db client "
+                          << info.name_
+                          << " is not a db client or is a fast one";
+                abort();
+            }
+            shards.emplace_back(name, iter->second);
+        }
+        auto client =
+            ShardedDbClient::newShardedClient(shards, info.virtualNodes_);
+        for (auto &[key, shard] : info.shardMap_)
+        {
+            if (!client->pinKey(key, shard))
+            {
+                LOG_ERROR << "The key " << key << " of the db client "
+                          << info.name_ << " is pinned to the unknown shard "
+                          << shard;
+            }
+        }
+        shardedClientsMap_[info.name_] = std::move(client);
+    }
+}
+
+void DbClientManager::addShardedDbClient(
+    const std::string &name,
+    const std::vector<std::string> &shards,
+    const std::map<std::string, std::string> &shardMap,
+    size_t virtualNodes)
+{
+    shardedInfos_.push_back({name, shards, shardMap, virtualNodes});
 }
 
 static std::string buildConnStr(const std::string &host,
@@ -176,17 +420,12 @@ void DbClientManager::addDbClient(const DbConfig &config)
     {
 #if USE_POSTGRESQL
         auto &cfg = std::get<PostgresConfig>(config);
-        auto connStr = buildConnStr(cfg.host,
-                                    cfg.port,
-                                    cfg.databaseName,
-                                    cfg.username,
-                                    cfg.password,
-                                    cfg.characterSet);
         // For valid connection options, see:
         // https://www.postgresql.org/docs/16/libpq-connect.html#LIBPQ-CONNECT-OPTIONS
+        std::string optionStr;
         if (!cfg.connectOptions.empty())
         {
-            std::string optionStr = " options='";
+            optionStr = " options='";
             for (auto const &[key, value] : cfg.connectOptions)
             {
                 optionStr += " -c ";
@@ -195,9 +434,24 @@ void DbClientManager::addDbClient(const DbConfig &config)
                 optionStr += escapeConnString(value);
             }
             optionStr += "'";
-            connStr += optionStr;
         }
-        dbInfos_.emplace_back(DbInfo{connStr, config});
+        auto newConnStr = [&cfg, &optionStr](const std::string &host,
+                                             unsigned short port) {
+            return buildConnStr(host,
+                                port,
+                                cfg.databaseName,
+                                cfg.username,
+                                cfg.password,
+                                cfg.characterSet) +
+                   optionStr;
+        };
+        DbInfo info{newConnStr(cfg.host, cfg.port), config};
+        for (auto &replica : cfg.replicas)
+        {
+            info.replicaConnectionInfos_.push_back(
+                newConnStr(replica.host, replica.port));
+        }
+        dbInfos_.emplace_back(std::move(info));
 #else
         std::cout << "The PostgreSQL is not supported in current drogon build, "
                      "please install the development library first."
@@ -215,7 +469,18 @@ void DbClientManager::addDbClient(const DbConfig &config)
                                     cfg.username,
                                     cfg.password,
                                     cfg.characterSet);
-        dbInfos_.emplace_back(DbInfo{connStr, config});
+        DbInfo info{connStr, config};
+        for (auto &replica : cfg.replicas)
+        {
+            info.replicaConnectionInfos_.push_back(
+                buildConnStr(replica.host,
+                             replica.port,
+                             cfg.databaseName,
+                             cfg.username,
+                             cfg.password,
+                             cfg.characterSet));
+        }
+        dbInfos_.emplace_back(std::move(info));
 #else
         std::cout << "The Mysql is not supported in current drogon build, "
                      "please install the development library first."
@@ -270,6 +535,9 @@ DbClientManager::~DbClientManager()
     for (auto &pair : dbFastClientsMap_)
     {
         pair.second.init([](DbClientPtr &clientPtr, size_t index) {
+            // The slots of the handler loops are empty
+            if (!clientPtr)
+                return;
             // the main loop;
             std::promise<void> p;
             auto f = p.get_future();
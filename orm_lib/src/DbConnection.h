@@ -18,7 +18,9 @@
 #include <drogon/orm/DbClient.h>
 #include <string_view>
 #include <trantor/net/EventLoop.h>
+#include <trantor/utils/Date.h>
 #include <trantor/utils/NonCopyable.h>
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -55,8 +57,14 @@ struct SqlCmd
     QueryCallback callback_;
     ExceptPtrCallback exceptionCallback_;
     std::string preparingStatement_;
+    // The time the command is buffered by a client to wait for a connection
+    trantor::Date bufferedDate_{0};
+    // Set when the command times out while it is still queued
+    std::atomic<bool> cancelled_{false};
 #if LIBPQ_SUPPORTS_BATCH_MODE
     bool isChanging_{false};
+    // Set when the command is sent again after a pipeline abort
+    bool retried_{false};
 #endif
     SqlCmd(std::string_view &&sql,
            size_t paraNum,
@@ -138,6 +146,13 @@ class DbConnection : public trantor::NonCopyable
         return isWorking_;
     }
 
+    /// True if the connection takes new commands before the results of the
+    /// previous ones are received, the results are delivered in order
+    virtual bool supportsPipelining() const
+    {
+        return false;
+    }
+
   protected:
     QueryCallback callback_;
     trantor::EventLoop *loop_;
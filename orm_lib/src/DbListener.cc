@@ -16,6 +16,7 @@
 #include <drogon/orm/DbListener.h>
 #include <trantor/utils/Logger.h>
 #include <mutex>
+#include <unordered_map>
 
 #if USE_POSTGRESQL
 #include "postgresql_impl/PgListener.h"
@@ -40,3 +41,28 @@ std::shared_ptr<DbListener> DbListener::newPgListener(
     return nullptr;
 #endif
 }
+
+std::shared_ptr<DbListener> DbListener::sharedPgListener(
+    const std::string &connInfo)
+{
+#if USE_POSTGRESQL
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<PgListener>> hubs;
+    std::shared_ptr<PgListener> hub;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &weakHub = hubs[connInfo];
+        hub = weakHub.lock();
+        if (!hub)
+        {
+            hub = std::make_shared<PgListener>(connInfo, nullptr);
+            hub->init();
+            weakHub = hub;
+        }
+    }
+    return std::make_shared<PgSharedListener>(std::move(hub));
+#else
+    LOG_ERROR << "Postgresql is not supported by current drogon build";
+    return nullptr;
+#endif
+}
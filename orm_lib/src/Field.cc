@@ -15,10 +15,292 @@
 #include <drogon/orm/Field.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 
 using namespace drogon::orm;
 
+namespace
+{
+// Type oids of PostgreSQL, see pg_type.dat
+enum PgTypeOid : int
+{
+    kBool = 16,
+    kBytea = 17,
+    kChar = 18,
+    kInt8 = 20,
+    kInt2 = 21,
+    kInt4 = 23,
+    kOid = 26,
+    kFloat4 = 700,
+    kFloat8 = 701,
+    kDate = 1082,
+    kTime = 1083,
+    kTimestamp = 1114,
+    kTimestampTz = 1184,
+    kNumeric = 1700,
+    kUuid = 2950,
+    kJsonb = 3802,
+};
+
+bool isArrayOid(int oid)
+{
+    switch (oid)
+    {
+        case 1000:  // bool[]
+        case 1001:  // bytea[]
+        case 1005:  // int2[]
+        case 1007:  // int4[]
+        case 1009:  // text[]
+        case 1014:  // bpchar[]
+        case 1015:  // varchar[]
+        case 1016:  // int8[]
+        case 1021:  // float4[]
+        case 1022:  // float8[]
+        case 1028:  // oid[]
+        case 1115:  // timestamp[]
+        case 1182:  // date[]
+        case 1183:  // time[]
+        case 1185:  // timestamptz[]
+        case 1231:  // numeric[]
+        case 2951:  // uuid[]
+        case 3807:  // jsonb[]
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Binary values are in network byte order
+template <typename T>
+T readBigEndian(const char *data)
+{
+    std::make_unsigned_t<T> value{0};
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        value = static_cast<std::make_unsigned_t<T>>(
+            (value << 8) | static_cast<unsigned char>(data[i]));
+    }
+    return static_cast<T>(value);
+}
+
+double readFloat8(const char *data)
+{
+    auto bits = readBigEndian<uint64_t>(data);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+float readFloat4(const char *data)
+{
+    auto bits = readBigEndian<uint32_t>(data);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Shortest text that reads back as the same value, like PostgreSQL prints
+// floating point numbers.
+template <typename T>
+std::string formatFloat(T value)
+{
+    if (std::isnan(value))
+        return "NaN";
+    if (std::isinf(value))
+        return value > 0 ? "Infinity" : "-Infinity";
+    std::ostringstream ss;
+    for (int precision = 6; precision <= std::numeric_limits<T>::max_digits10;
+         ++precision)
+    {
+        ss.str(std::string());
+        ss << std::setprecision(precision) << value;
+        auto text = ss.str();
+        if constexpr (std::is_same_v<T, float>)
+        {
+            if (strtof(text.c_str(), nullptr) == value)
+                break;
+        }
+        else
+        {
+            if (strtod(text.c_str(), nullptr) == value)
+                break;
+        }
+    }
+    return ss.str();
+}
+
+// Days and microseconds are counted from 2000-01-01 in PostgreSQL
+constexpr int64_t kPgEpochDays{10957};
+constexpr int64_t kMicrosecondsPerDay{86400LL * 1000000};
+
+// Civil date of a day number counted from 1970-01-01, see
+// http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+std::string formatDate(int64_t days)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe =
+        (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t year = static_cast<int64_t>(yoe) + era * 400;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    if (month <= 2)
+        ++year;
+    char buf[32];
+    snprintf(buf,
+             sizeof(buf),
+             "%04lld-%02u-%02u",
+             static_cast<long long>(year),
+             month,
+             day);
+    return buf;
+}
+
+std::string formatTime(int64_t microseconds)
+{
+    auto seconds = microseconds / 1000000;
+    auto fraction = static_cast<long>(microseconds % 1000000);
+    char buf[32];
+    auto len = snprintf(buf,
+                        sizeof(buf),
+                        "%02lld:%02lld:%02lld",
+                        static_cast<long long>(seconds / 3600),
+                        static_cast<long long>(seconds / 60 % 60),
+                        static_cast<long long>(seconds % 60));
+    std::string text(buf, len);
+    if (fraction != 0)
+    {
+        snprintf(buf, sizeof(buf), ".%06ld", fraction);
+        text.append(buf);
+        while (text.back() == '0')
+            text.pop_back();
+    }
+    return text;
+}
+
+std::string formatTimestamp(int64_t microseconds)
+{
+    if (microseconds == std::numeric_limits<int64_t>::max())
+        return "infinity";
+    if (microseconds == std::numeric_limits<int64_t>::min())
+        return "-infinity";
+    auto days = microseconds / kMicrosecondsPerDay;
+    auto rest = microseconds % kMicrosecondsPerDay;
+    if (rest < 0)
+    {
+        --days;
+        rest += kMicrosecondsPerDay;
+    }
+    return formatDate(days + kPgEpochDays) + " " + formatTime(rest);
+}
+
+// See numeric_send() in PostgreSQL, the digits are in base 10000
+std::string formatNumeric(const char *data, size_t length)
+{
+    if (length < 8)
+        return std::string();
+    auto ndigits = readBigEndian<int16_t>(data);
+    auto weight = readBigEndian<int16_t>(data + 2);
+    auto sign = readBigEndian<uint16_t>(data + 4);
+    auto dscale = readBigEndian<int16_t>(data + 6);
+    if (sign == 0xC000)
+        return "NaN";
+    if (sign == 0xD000)
+        return "Infinity";
+    if (sign == 0xF000)
+        return "-Infinity";
+    if (length < 8 + static_cast<size_t>(ndigits) * 2)
+        return std::string();
+    auto digit = [data, ndigits](int index) -> int {
+        if (index < 0 || index >= ndigits)
+            return 0;
+        return readBigEndian<int16_t>(data + 8 + index * 2);
+    };
+    std::string text;
+    if (sign == 0x4000)
+        text.push_back('-');
+    char buf[8];
+    if (weight < 0)
+    {
+        text.push_back('0');
+    }
+    else
+    {
+        for (int i = 0; i <= weight; ++i)
+        {
+            snprintf(buf, sizeof(buf), i == 0 ? "%d" : "%04d", digit(i));
+            text.append(buf);
+        }
+    }
+    if (dscale > 0)
+    {
+        text.push_back('.');
+        int remaining = dscale;
+        for (int i = weight + 1; remaining > 0; ++i)
+        {
+            snprintf(buf, sizeof(buf), "%04d", digit(i));
+            text.append(buf, remaining < 4 ? remaining : 4);
+            remaining -= 4;
+        }
+    }
+    return text;
+}
+
+std::string formatUuid(const char *data)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string text;
+    text.reserve(36);
+    for (int i = 0; i < 16; ++i)
+    {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+            text.push_back('-');
+        auto byte = static_cast<unsigned char>(data[i]);
+        text.push_back(hex[byte >> 4]);
+        text.push_back(hex[byte & 0x0f]);
+    }
+    return text;
+}
+
+// Quote an array element like array_out() does
+void appendArrayElement(std::string &text, const std::string &element)
+{
+    bool needQuotes = element.empty() || element == "NULL";
+    for (auto ch : element)
+    {
+        if (ch == '{' || ch == '}' || ch == ',' || ch == '"' || ch == '\\' ||
+            isspace(static_cast<unsigned char>(ch)))
+        {
+            needQuotes = true;
+            break;
+        }
+    }
+    if (!needQuotes)
+    {
+        text.append(element);
+        return;
+    }
+    text.push_back('"');
+    for (auto ch : element)
+    {
+        if (ch == '"' || ch == '\\')
+            text.push_back('\\');
+        text.push_back(ch);
+    }
+    text.push_back('"');
+}
+}  // namespace
+
 Field::Field(const Row &row, Row::SizeType columnNum) noexcept
     : row_(Result::SizeType(row.index_)),
       column_((long)columnNum),
@@ -26,6 +308,13 @@ Field::Field(const Row &row, Row::SizeType columnNum) noexcept
 {
 }
 
+Field::Field(const Result &result,
+             Result::SizeType rowNum,
+             Row::SizeType columnNum) noexcept
+    : row_(rowNum), column_((long)columnNum), result_(result)
+{
+}
+
 const char *Field::name() const
 {
     return result_.columnName(column_);
@@ -36,9 +325,257 @@ bool Field::isNull() const
     return result_.isNull(row_, column_);
 }
 
+bool Field::isBinary() const
+{
+    return result_.isBinary(column_);
+}
+
+int64_t Field::binaryInteger() const
+{
+    return binaryInteger(result_.oid(column_),
+                         result_.getValue(row_, column_),
+                         result_.getLength(row_, column_));
+}
+
+double Field::binaryDouble() const
+{
+    return binaryDouble(result_.oid(column_),
+                        result_.getValue(row_, column_),
+                        result_.getLength(row_, column_));
+}
+
+std::string Field::binaryText() const
+{
+    return binaryText(result_.oid(column_),
+                      result_.getValue(row_, column_),
+                      result_.getLength(row_, column_));
+}
+
+int64_t Field::binaryInteger(int oid, const char *data, size_t length)
+{
+    switch (oid)
+    {
+        case kBool:
+        case kChar:
+            if (length >= 1)
+                return static_cast<int64_t>(data[0]);
+            break;
+        case kInt2:
+            if (length >= 2)
+                return readBigEndian<int16_t>(data);
+            break;
+        case kInt4:
+            if (length >= 4)
+                return readBigEndian<int32_t>(data);
+            break;
+        case kOid:
+            if (length >= 4)
+                return readBigEndian<uint32_t>(data);
+            break;
+        case kInt8:
+            if (length >= 8)
+                return readBigEndian<int64_t>(data);
+            break;
+        case kFloat4:
+        case kFloat8:
+            return static_cast<int64_t>(binaryDouble(oid, data, length));
+        default:
+            return atoll(binaryText(oid, data, length).c_str());
+    }
+    LOG_DEBUG << "Type error";
+    return 0;
+}
+
+double Field::binaryDouble(int oid, const char *data, size_t length)
+{
+    switch (oid)
+    {
+        case kFloat4:
+            if (length >= 4)
+                return readFloat4(data);
+            break;
+        case kFloat8:
+            if (length >= 8)
+                return readFloat8(data);
+            break;
+        case kBool:
+        case kChar:
+        case kInt2:
+        case kInt4:
+        case kOid:
+        case kInt8:
+            return static_cast<double>(binaryInteger(oid, data, length));
+        default:
+            return strtod(binaryText(oid, data, length).c_str(), nullptr);
+    }
+    LOG_DEBUG << "Type error";
+    return 0.0;
+}
+
+std::string Field::binaryText(int oid, const char *data, size_t length)
+{
+    switch (oid)
+    {
+        case kBool:
+            return length >= 1 && data[0] ? "t" : "f";
+        case kInt2:
+        case kInt4:
+        case kOid:
+        case kInt8:
+            return std::to_string(binaryInteger(oid, data, length));
+        case kFloat4:
+            if (length >= 4)
+                return formatFloat(readFloat4(data));
+            break;
+        case kFloat8:
+            if (length >= 8)
+                return formatFloat(readFloat8(data));
+            break;
+        case kDate:
+            if (length >= 4)
+            {
+                auto days = readBigEndian<int32_t>(data);
+                if (days == std::numeric_limits<int32_t>::max())
+                    return "infinity";
+                if (days == std::numeric_limits<int32_t>::min())
+                    return "-infinity";
+                return formatDate(days + kPgEpochDays);
+            }
+            break;
+        case kTime:
+            if (length >= 8)
+                return formatTime(readBigEndian<int64_t>(data));
+            break;
+        case kTimestamp:
+            if (length >= 8)
+                return formatTimestamp(readBigEndian<int64_t>(data));
+            break;
+        case kTimestampTz:
+            // The value is in UTC, printed as with the UTC time zone
+            if (length >= 8)
+            {
+                auto text = formatTimestamp(readBigEndian<int64_t>(data));
+                if (text.back() != 'y')
+                    text.append("+00");
+                return text;
+            }
+            break;
+        case kNumeric:
+            return formatNumeric(data, length);
+        case kUuid:
+            if (length >= 16)
+                return formatUuid(data);
+            break;
+        case kJsonb:
+            // Skip the version number
+            if (length >= 1)
+                return std::string(data + 1, length - 1);
+            break;
+        default:
+            if (isArrayOid(oid))
+            {
+                // Rebuild the text format of the array
+                std::vector<int32_t> dims;
+                if (length >= 12)
+                {
+                    auto ndim = readBigEndian<int32_t>(data);
+                    for (size_t i = 0;
+                         i < static_cast<size_t>(ndim) && 20 + i * 8 <= length;
+                         ++i)
+                    {
+                        dims.push_back(
+                            readBigEndian<int32_t>(data + 12 + i * 8));
+                    }
+                }
+                if (dims.empty())
+                    return "{}";
+                auto elementOid = readBigEndian<int32_t>(data + 8);
+                const char *pos = data + 12 + dims.size() * 8;
+                const char *end = data + length;
+                std::vector<int32_t> counters(dims.size(), 0);
+                std::string text(dims.size(), '{');
+                while (pos + 4 <= end)
+                {
+                    auto len = readBigEndian<int32_t>(pos);
+                    pos += 4;
+                    if (len < 0)
+                    {
+                        text.append("NULL");
+                    }
+                    else
+                    {
+                        if (pos + len > end)
+                            break;
+                        appendArrayElement(text,
+                                           binaryText(elementOid, pos, len));
+                        pos += len;
+                    }
+                    // Close the finished dimensions, innermost first
+                    auto d = dims.size();
+                    while (d > 0 && ++counters[d - 1] == dims[d - 1])
+                    {
+                        counters[d - 1] = 0;
+                        text.push_back('}');
+                        --d;
+                    }
+                    if (d == 0)
+                        break;
+                    text.push_back(',');
+                    text.append(dims.size() - d, '{');
+                }
+                return text;
+            }
+            // Text types, bytea, json, etc. are sent as they are
+            return std::string(data, length);
+    }
+    LOG_DEBUG << "Type error";
+    return std::string();
+}
+
+std::vector<std::string_view> Field::binaryArrayElements(
+    int &elementOid) const
+{
+    std::vector<std::string_view> elements;
+    auto data = result_.getValue(row_, column_);
+    auto length = result_.getLength(row_, column_);
+    // See array_send() in PostgreSQL
+    if (length < 12)
+        return elements;
+    auto ndim = readBigEndian<int32_t>(data);
+    elementOid = readBigEndian<int32_t>(data + 8);
+    const char *pos = data + 12;
+    const char *end = data + length;
+    size_t count = ndim > 0 ? 1 : 0;
+    for (int32_t i = 0; i < ndim; ++i)
+    {
+        if (pos + 8 > end)
+            return elements;
+        count *= static_cast<size_t>(readBigEndian<int32_t>(pos));
+        pos += 8;
+    }
+    elements.reserve(count);
+    for (size_t i = 0; i < count && pos + 4 <= end; ++i)
+    {
+        auto len = readBigEndian<int32_t>(pos);
+        pos += 4;
+        if (len < 0)
+        {
+            elements.emplace_back();
+            continue;
+        }
+        if (pos + len > end)
+            break;
+        elements.emplace_back(pos, static_cast<size_t>(len));
+        pos += len;
+    }
+    return elements;
+}
+
 template <>
 std::string Field::as<std::string>() const
 {
+    if (isBinary())
+        return binaryText();
     if (result_.oid(column_) != 17)
     {
         auto data_ = result_.getValue(row_, column_);
@@ -73,7 +610,12 @@ char *Field::as<char *>() const
 template <>
 std::vector<char> Field::as<std::vector<char>>() const
 {
-    if (result_.oid(column_) != 17)
+    if (isBinary() && result_.oid(column_) != kBytea)
+    {
+        auto text = binaryText();
+        return std::vector<char>(text.begin(), text.end());
+    }
+    if (isBinary() || result_.oid(column_) != kBytea)
     {
         char *first = (char *)result_.getValue(row_, column_);
         char *last = first + result_.getLength(row_, column_);
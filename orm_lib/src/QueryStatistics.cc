@@ -0,0 +1,291 @@
+/**
+ *
+ *  @file QueryStatistics.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "QueryStatistics.h"
+#include <drogon/orm/Exception.h>
+#include <trantor/utils/Logger.h>
+#include <cctype>
+
+using namespace drogon;
+using namespace drogon::orm;
+
+namespace
+{
+// The bounds of the memory used by the statistics of a client
+constexpr size_t kMaxStatements = 500;
+constexpr size_t kMaxQueries = 2000;
+constexpr size_t kMaxStatementLength = 512;
+
+bool isWordChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+bool isExplainable(std::string_view sql)
+{
+    auto begin = sql.find_first_not_of(" \t\r\n(");
+    if (begin == std::string_view::npos)
+        return false;
+    auto end = begin;
+    while (end < sql.length() && isalpha(static_cast<unsigned char>(sql[end])))
+        ++end;
+    std::string word;
+    for (auto i = begin; i < end; ++i)
+        word.push_back(toupper(static_cast<unsigned char>(sql[i])));
+    return word == "SELECT" || word == "INSERT" || word == "UPDATE" ||
+           word == "DELETE" || word == "WITH";
+}
+}  // namespace
+
+std::string QueryStatistics::normalize(std::string_view sql)
+{
+    std::string text;
+    text.reserve(sql.length());
+    bool space = false;
+    size_t i = 0;
+    while (i < sql.length())
+    {
+        auto c = sql[i];
+        if (isspace(static_cast<unsigned char>(c)))
+        {
+            space = true;
+            ++i;
+            continue;
+        }
+        if (c == '-' && i + 1 < sql.length() && sql[i + 1] == '-')
+        {
+            i = sql.find('\n', i);
+            if (i == std::string_view::npos)
+                break;
+            space = true;
+            continue;
+        }
+        if (c == '/' && i + 1 < sql.length() && sql[i + 1] == '*')
+        {
+            i = sql.find("*/", i + 2);
+            if (i == std::string_view::npos)
+                break;
+            i += 2;
+            space = true;
+            continue;
+        }
+        if (space && !text.empty())
+            text.push_back(' ');
+        space = false;
+        if (c == '\'')
+        {
+            // A string literal, a doubled quote doesn't end it
+            ++i;
+            while (i < sql.length())
+            {
+                if (sql[i] == '\'')
+                {
+                    if (i + 1 < sql.length() && sql[i + 1] == '\'')
+                    {
+                        i += 2;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+                ++i;
+            }
+            text.push_back('?');
+            continue;
+        }
+        if (isdigit(static_cast<unsigned char>(c)) &&
+            (i == 0 || !isWordChar(sql[i - 1])))
+        {
+            // A number, not a part of a name or of a placeholder like $1
+            ++i;
+            while (i < sql.length() &&
+                   (isalnum(static_cast<unsigned char>(sql[i])) ||
+                    sql[i] == '.' ||
+                    ((sql[i] == '+' || sql[i] == '-') &&
+                     (sql[i - 1] == 'e' || sql[i - 1] == 'E'))))
+                ++i;
+            text.push_back('?');
+            continue;
+        }
+        text.push_back(c);
+        ++i;
+    }
+    if (text.length() > kMaxStatementLength)
+    {
+        text.resize(kMaxStatementLength);
+        text.append("...");
+    }
+    return text;
+}
+
+QueryStatistics::StatementPtr QueryStatistics::statement(std::string_view sql)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = queries_.find(sql);
+    if (iter != queries_.end())
+        return iter->second.statement_;
+    auto text = normalize(sql);
+    StatementPtr statementPtr;
+    auto known = statements_.find(text);
+    if (known != statements_.end())
+    {
+        statementPtr = known->second;
+    }
+    else if (statements_.size() < kMaxStatements)
+    {
+        statementPtr =
+            std::make_shared<Statement>(text, text, std::string(sql));
+        statements_.emplace(std::move(text), statementPtr);
+    }
+    else
+    {
+        // Too many statements, this one is neither kept nor explained
+        statementPtr = std::make_shared<Statement>(std::move(text),
+                                                   "<other>",
+                                                   std::string(sql));
+        statementPtr->explained_ = true;
+        return statementPtr;
+    }
+    if (queries_.size() < kMaxQueries)
+    {
+        auto copy = std::make_unique<std::string>(sql);
+        std::string_view key(*copy);
+        queries_.emplace(key, Query{std::move(copy), statementPtr});
+    }
+    return statementPtr;
+}
+
+void QueryStatistics::observe(
+    std::string_view sql,
+    size_t paraNum,
+    ResultCallback &rcb,
+    std::function<void(const std::exception_ptr &)> &ecb,
+    const std::weak_ptr<DbClient> &client)
+{
+    auto statementPtr = statement(sql);
+    auto start = trantor::Date::now();
+    auto thisPtr = shared_from_this();
+    auto explainer =
+        config_.explainSlowQueries ? client : std::weak_ptr<DbClient>();
+    rcb = [thisPtr,
+           statementPtr,
+           start,
+           paraNum,
+           explainer,
+           rcb = std::move(rcb)](const Result &result) {
+        thisPtr->done(*statementPtr, start, paraNum, &result, explainer);
+        rcb(result);
+    };
+    ecb = [thisPtr,
+           statementPtr,
+           start,
+           paraNum,
+           explainer,
+           ecb = std::move(ecb)](const std::exception_ptr &exception) {
+        thisPtr->done(*statementPtr, start, paraNum, nullptr, explainer);
+        ecb(exception);
+    };
+}
+
+void QueryStatistics::done(Statement &statement,
+                           const trantor::Date &start,
+                           size_t paraNum,
+                           const Result *result,
+                           const std::weak_ptr<DbClient> &client)
+{
+    auto seconds =
+        static_cast<double>(trantor::Date::now().microSecondsSinceEpoch() -
+                            start.microSecondsSinceEpoch()) /
+        1000000.0;
+    if (config_.enabled)
+    {
+        auto metrics = statement.metrics_.load(std::memory_order_acquire);
+        if (!metrics)
+        {
+            metrics =
+                BuiltinMetrics::instance().statementMetrics(statement.label_);
+            statement.metrics_.store(metrics, std::memory_order_release);
+        }
+        if (metrics)
+        {
+            metrics->duration->observe(seconds);
+            if (result)
+            {
+                size_t bytes = 0;
+                for (auto const &row : *result)
+                {
+                    for (auto const &field : row)
+                        bytes += field.length();
+                }
+                metrics->rows->increment(static_cast<double>(result->size()));
+                metrics->bytes->increment(static_cast<double>(bytes));
+            }
+        }
+    }
+    if (config_.slowQueryThreshold > 0 &&
+        seconds >= config_.slowQueryThreshold)
+    {
+        // The values of the parameters are never logged
+        LOG_WARN << "Slow query (" << seconds * 1000 << " ms, " << paraNum
+                 << " parameters): " << statement.text_;
+        if (config_.explainSlowQueries && !statement.explained_.exchange(true))
+            explain(statement, paraNum, client);
+    }
+}
+
+void QueryStatistics::explain(Statement &statement,
+                              size_t paraNum,
+                              const std::weak_ptr<DbClient> &client)
+{
+    auto clientPtr = client.lock();
+    if (!clientPtr || !isExplainable(statement.sql_))
+        return;
+    std::string query;
+    switch (type_)
+    {
+        case ClientType::PostgreSQL:
+            // The generic plans of parameterized queries need PostgreSQL 16
+            query = paraNum == 0 ? "EXPLAIN " : "EXPLAIN (GENERIC_PLAN) ";
+            break;
+        case ClientType::Mysql:
+            if (paraNum > 0)
+                return;
+            query = "EXPLAIN ";
+            break;
+        default:
+            if (paraNum > 0)
+                return;
+            query = "EXPLAIN QUERY PLAN ";
+            break;
+    }
+    query.append(statement.sql_);
+    auto text = statement.text_;
+    *clientPtr << std::move(query) >> [text](const Result &plan) {
+        std::string lines;
+        for (auto const &row : plan)
+        {
+            lines.push_back('\n');
+            for (Row::SizeType i = 0; i < row.size(); ++i)
+            {
+                if (i > 0)
+                    lines.append(" | ");
+                lines.append(row[i].isNull() ? std::string("NULL")
+                                             : row[i].as<std::string>());
+            }
+        }
+        LOG_WARN << "The plan of the slow query " << text << ":" << lines;
+    } >> [text](const DrogonDbException &e) {
+        LOG_DEBUG << "Failed to explain the slow query " << text << ": "
+                  << e.base().what();
+    };
+}
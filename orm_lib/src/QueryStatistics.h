@@ -0,0 +1,116 @@
+/**
+ *
+ *  @file QueryStatistics.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "../../lib/src/BuiltinMetrics.h"
+#include <drogon/orm/DbClient.h>
+#include <drogon/orm/DbConfig.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief The statistics and the slow query log of the statements executed by
+ * a client, see QueryStatsConfig.
+ *
+ * The statements are normalized by replacing their literals with "?" and
+ * collapsing their white space, so the queries that differ only by their
+ * values share their statistics. The number of statements is bounded, the
+ * statements beyond it share the "<other>" statistics.
+ */
+class QueryStatistics : public trantor::NonCopyable,
+                        public std::enable_shared_from_this<QueryStatistics>
+{
+  public:
+    QueryStatistics(ClientType type, const QueryStatsConfig &config)
+        : type_(type), config_(config)
+    {
+    }
+
+    bool enabled() const
+    {
+        return config_.enabled || config_.slowQueryThreshold > 0;
+    }
+
+    /**
+     * @brief Wrap the callbacks of a query to observe it when it is done.
+     *
+     * @param client The client to fetch the plans of the slow queries with.
+     */
+    void observe(std::string_view sql,
+                 size_t paraNum,
+                 ResultCallback &rcb,
+                 std::function<void(const std::exception_ptr &)> &ecb,
+                 const std::weak_ptr<DbClient> &client);
+
+    /// Replace the literals of the SQL with "?" and collapse the white space
+    static std::string normalize(std::string_view sql);
+
+  private:
+    struct Statement
+    {
+        Statement(std::string text, std::string label, std::string sql)
+            : text_(std::move(text)),
+              label_(std::move(label)),
+              sql_(std::move(sql))
+        {
+        }
+
+        // The normalized statement
+        const std::string text_;
+        // The label of its metrics, the text or "<other>"
+        const std::string label_;
+        // The first query of the statement, to fetch its plan
+        const std::string sql_;
+        std::atomic<const BuiltinMetrics::StatementMetrics *> metrics_{
+            nullptr};
+        std::atomic<bool> explained_{false};
+    };
+
+    using StatementPtr = std::shared_ptr<Statement>;
+
+    // The queries seen so far, the keys are views of the owned strings
+    struct Query
+    {
+        std::unique_ptr<std::string> sql_;
+        StatementPtr statement_;
+    };
+
+    StatementPtr statement(std::string_view sql);
+    void done(Statement &statement,
+              const trantor::Date &start,
+              size_t paraNum,
+              const Result *result,
+              const std::weak_ptr<DbClient> &client);
+    void explain(Statement &statement,
+                 size_t paraNum,
+                 const std::weak_ptr<DbClient> &client);
+
+    const ClientType type_;
+    const QueryStatsConfig config_;
+    std::mutex mutex_;
+    std::unordered_map<std::string_view, Query> queries_;
+    std::unordered_map<std::string, StatementPtr> statements_;
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -0,0 +1,338 @@
+/**
+ *
+ *  @file ReplicatedDbClient.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ReplicatedDbClient.h"
+#include <trantor/utils/Logger.h>
+#include <cctype>
+#include <limits>
+#include <string>
+
+using namespace drogon;
+using namespace drogon::orm;
+
+static constexpr double kCheckInterval{1.0};
+
+// Zero on a primary server or a replica that has replayed all the WAL it
+// received, otherwise the age of the last replayed transaction.
+static const char *kPgLagSql =
+    "select case when not pg_is_in_recovery() or pg_last_wal_receive_lsn() = "
+    "pg_last_wal_replay_lsn() then 0 else coalesce(extract(epoch from now() - "
+    "pg_last_xact_replay_timestamp()), 0) end::float8";
+
+ReplicatedDbClient::ReplicatedDbClient(DbClientPtr primary,
+                                       std::vector<DbClientPtr> replicas,
+                                       double maxReplicaLag)
+    : primary_(std::move(primary)), maxReplicaLag_(maxReplicaLag)
+{
+    type_ = primary_->type();
+    connectionInfo_ = primary_->connectionInfo();
+    for (auto &replica : replicas)
+    {
+        replicas_.push_back(std::make_shared<Replica>(std::move(replica)));
+    }
+}
+
+ReplicatedDbClient::~ReplicatedDbClient() noexcept
+{
+    if (checkTimer_ != 0)
+        checkThread_.getLoop()->invalidateTimer(checkTimer_);
+}
+
+void ReplicatedDbClient::init()
+{
+    if (replicas_.empty())
+        return;
+    checkThread_.run();
+    std::weak_ptr<ReplicatedDbClient> weakPtr = shared_from_this();
+    checkTimer_ =
+        checkThread_.getLoop()->runEvery(kCheckInterval, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->checkReplicas();
+        });
+}
+
+void ReplicatedDbClient::checkReplicas()
+{
+    for (auto &replica : replicas_)
+    {
+        if (!replica->client_->hasAvailableConnections())
+        {
+            replica->healthy_ = false;
+            continue;
+        }
+        if (replica->checking_.exchange(true))
+            continue;
+        replica->client_->execSqlAsync(
+            type_ == ClientType::PostgreSQL ? kPgLagSql : "select 0",
+            [replica, maxLag = maxReplicaLag_](const Result &r) {
+                double lag = 0;
+                if (!r.empty() && !r[0][0].isNull())
+                    lag = r[0][0].as<double>();
+                bool healthy = maxLag < 0 || lag <= maxLag;
+                if (replica->healthy_.exchange(healthy) != healthy)
+                {
+                    LOG_WARN << "Database replica "
+                             << (healthy ? "is back, lag: "
+                                         : "is lagging behind, lag: ")
+                             << lag << "s";
+                }
+                replica->checking_ = false;
+            },
+            [replica](const DrogonDbException &e) {
+                if (replica->healthy_.exchange(false))
+                {
+                    LOG_WARN << "Database replica check failed: "
+                             << e.base().what();
+                }
+                replica->checking_ = false;
+            });
+    }
+}
+
+std::shared_ptr<ReplicatedDbClient::Replica> ReplicatedDbClient::pickReplica()
+{
+    // Least outstanding queries, the start rotates to spread the ties
+    std::shared_ptr<Replica> best;
+    size_t bestOutstanding = (std::numeric_limits<size_t>::max)();
+    auto start = nextReplica_++;
+    for (size_t i = 0; i < replicas_.size(); ++i)
+    {
+        auto &replica = replicas_[(start + i) % replicas_.size()];
+        if (!replica->healthy_)
+            continue;
+        auto outstanding = replica->outstanding_.load();
+        if (outstanding < bestOutstanding)
+        {
+            best = replica;
+            bestOutstanding = outstanding;
+        }
+    }
+    return best;
+}
+
+void ReplicatedDbClient::execSql(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    std::shared_ptr<Replica> replica;
+    if (!replicas_.empty() && isReadOnly({sql, sqlLength}))
+        replica = pickReplica();
+    if (!replica)
+    {
+        forwardSql(*primary_,
+                   sql,
+                   sqlLength,
+                   paraNum,
+                   std::move(parameters),
+                   std::move(length),
+                   std::move(format),
+                   std::move(rcb),
+                   std::move(exceptCallback));
+        return;
+    }
+    ++replica->outstanding_;
+    forwardSql(*replica->client_,
+               sql,
+               sqlLength,
+               paraNum,
+               std::move(parameters),
+               std::move(length),
+               std::move(format),
+               [replica, rcb = std::move(rcb)](const Result &r) {
+                   --replica->outstanding_;
+                   rcb(r);
+               },
+               [replica, exceptCallback = std::move(exceptCallback)](
+                   const std::exception_ptr &e) {
+                   --replica->outstanding_;
+                   exceptCallback(e);
+               });
+}
+
+std::shared_ptr<Transaction> ReplicatedDbClient::newTransaction(
+    const std::function<void(bool)> &commitCallback) noexcept(false)
+{
+    return primary_->newTransaction(commitCallback);
+}
+
+void ReplicatedDbClient::newTransactionAsync(
+    const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
+{
+    primary_->newTransactionAsync(callback);
+}
+
+bool ReplicatedDbClient::hasAvailableConnections() const noexcept
+{
+    return primary_->hasAvailableConnections();
+}
+
+DbPoolStatus ReplicatedDbClient::poolStatus() const noexcept
+{
+    // The connections of the primary and of the replicas
+    auto status = primary_->poolStatus();
+    for (auto &replica : replicas_)
+    {
+        auto replicaStatus = replica->client_->poolStatus();
+        status.connections += replicaStatus.connections;
+        status.busy += replicaStatus.busy;
+        status.idle += replicaStatus.idle;
+        status.queued += replicaStatus.queued;
+        status.queuedTransactions += replicaStatus.queuedTransactions;
+    }
+    return status;
+}
+
+void ReplicatedDbClient::setTimeout(double timeout)
+{
+    primary_->setTimeout(timeout);
+    for (auto &replica : replicas_)
+    {
+        replica->client_->setTimeout(timeout);
+    }
+}
+
+void ReplicatedDbClient::closeAll()
+{
+    if (checkTimer_ != 0)
+    {
+        checkThread_.getLoop()->invalidateTimer(checkTimer_);
+        checkTimer_ = 0;
+    }
+    primary_->closeAll();
+    for (auto &replica : replicas_)
+    {
+        replica->client_->closeAll();
+    }
+}
+
+bool ReplicatedDbClient::isReadOnly(std::string_view sql)
+{
+    bool first = true;
+    size_t i = 0;
+    while (i < sql.size())
+    {
+        auto c = sql[i];
+        if (c == '\'' || c == '"')
+        {
+            // Skip literals and quoted identifiers, '' and "" are escapes
+            auto end = sql.find(c, i + 1);
+            if (end == std::string_view::npos)
+                return false;
+            i = end + 1;
+            continue;
+        }
+        if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-')
+        {
+            auto end = sql.find('\n', i);
+            i = end == std::string_view::npos ? sql.size() : end + 1;
+            continue;
+        }
+        if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*')
+        {
+            auto end = sql.find("*/", i + 2);
+            i = end == std::string_view::npos ? sql.size() : end + 2;
+            continue;
+        }
+        if (!isalpha(static_cast<unsigned char>(c)) && c != '_')
+        {
+            ++i;
+            continue;
+        }
+        std::string word;
+        while (i < sql.size() &&
+               (isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_'))
+        {
+            word.push_back(
+                static_cast<char>(tolower(static_cast<unsigned char>(sql[i]))));
+            ++i;
+        }
+        if (first)
+        {
+            // EXPLAIN is left out, EXPLAIN ANALYZE runs the statement
+            if (word != "select" && word != "with" && word != "show" &&
+                word != "values" && word != "table")
+                return false;
+            first = false;
+            continue;
+        }
+        if (word == "insert" || word == "update" || word == "delete" ||
+            word == "merge" || word == "into" || word == "share" ||
+            word == "nextval" || word == "setval" ||
+            word.find("lock") != std::string::npos)
+            return false;
+    }
+    return !first;
+}
+
+ReadYourWritesSession::ReadYourWritesSession(
+    std::shared_ptr<ReplicatedDbClient> client)
+    : client_(std::move(client))
+{
+    type_ = client_->type();
+    connectionInfo_ = client_->connectionInfo();
+}
+
+void ReadYourWritesSession::execSql(
+    const char *sql,
+    size_t sqlLength,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    if (!wrote_ && ReplicatedDbClient::isReadOnly({sql, sqlLength}))
+    {
+        client_->execSql(sql,
+                         sqlLength,
+                         paraNum,
+                         std::move(parameters),
+                         std::move(length),
+                         std::move(format),
+                         std::move(rcb),
+                         std::move(exceptCallback));
+        return;
+    }
+    wrote_ = true;
+    forwardSql(*client_->primary(),
+               sql,
+               sqlLength,
+               paraNum,
+               std::move(parameters),
+               std::move(length),
+               std::move(format),
+               std::move(rcb),
+               std::move(exceptCallback));
+}
+
+std::shared_ptr<Transaction> ReadYourWritesSession::newTransaction(
+    const std::function<void(bool)> &commitCallback) noexcept(false)
+{
+    wrote_ = true;
+    return client_->newTransaction(commitCallback);
+}
+
+void ReadYourWritesSession::newTransactionAsync(
+    const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
+{
+    wrote_ = true;
+    client_->newTransactionAsync(callback);
+}
@@ -0,0 +1,140 @@
+/**
+ *
+ *  @file ReplicatedDbClient.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <trantor/net/EventLoopThread.h>
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief Sends the transactions and the writes to a primary client and the
+ * read-only queries to the least loaded healthy replica client.
+ */
+class ReplicatedDbClient
+    : public DbClient,
+      public std::enable_shared_from_this<ReplicatedDbClient>
+{
+  public:
+    ReplicatedDbClient(DbClientPtr primary,
+                       std::vector<DbClientPtr> replicas,
+                       double maxReplicaLag);
+    ~ReplicatedDbClient() noexcept override;
+
+    /// Start the health checks of the replicas
+    void init();
+
+    void execSql(const char *sql,
+                 size_t sqlLength,
+                 size_t paraNum,
+                 std::vector<const char *> &&parameters,
+                 std::vector<int> &&length,
+                 std::vector<int> &&format,
+                 ResultCallback &&rcb,
+                 std::function<void(const std::exception_ptr &)>
+                     &&exceptCallback) override;
+    std::shared_ptr<Transaction> newTransaction(
+        const std::function<void(bool)> &commitCallback =
+            std::function<void(bool)>()) noexcept(false) override;
+    void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override;
+    bool hasAvailableConnections() const noexcept override;
+    DbPoolStatus poolStatus() const noexcept override;
+    void setTimeout(double timeout) override;
+    void closeAll() override;
+
+    const DbClientPtr &primary() const
+    {
+        return primary_;
+    }
+
+    /// Whether a query can be sent to a replica, errs on the primary side
+    static bool isReadOnly(std::string_view sql);
+
+  private:
+    struct Replica
+    {
+        explicit Replica(DbClientPtr client) : client_(std::move(client))
+        {
+        }
+
+        DbClientPtr client_;
+        std::atomic<size_t> outstanding_{0};
+        std::atomic<bool> healthy_{true};
+        std::atomic<bool> checking_{false};
+    };
+
+    std::shared_ptr<Replica> pickReplica();
+    void checkReplicas();
+
+    DbClientPtr primary_;
+    std::vector<std::shared_ptr<Replica>> replicas_;
+    double maxReplicaLag_;
+    std::atomic<size_t> nextReplica_{0};
+    trantor::EventLoopThread checkThread_{"DbReplicaCheck"};
+    trantor::TimerId checkTimer_{0};
+};
+
+/**
+ * @brief Reads from the replicas of a ReplicatedDbClient until the first
+ * write, then only uses the primary.
+ */
+class ReadYourWritesSession : public DbClient
+{
+  public:
+    explicit ReadYourWritesSession(std::shared_ptr<ReplicatedDbClient> client);
+
+    void execSql(const char *sql,
+                 size_t sqlLength,
+                 size_t paraNum,
+                 std::vector<const char *> &&parameters,
+                 std::vector<int> &&length,
+                 std::vector<int> &&format,
+                 ResultCallback &&rcb,
+                 std::function<void(const std::exception_ptr &)>
+                     &&exceptCallback) override;
+    std::shared_ptr<Transaction> newTransaction(
+        const std::function<void(bool)> &commitCallback =
+            std::function<void(bool)>()) noexcept(false) override;
+    void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override;
+    bool hasAvailableConnections() const noexcept override
+    {
+        return client_->hasAvailableConnections();
+    }
+
+    void setTimeout(double timeout) override
+    {
+        client_->setTimeout(timeout);
+    }
+
+    void closeAll() override
+    {
+    }
+
+  private:
+    std::shared_ptr<ReplicatedDbClient> client_;
+    std::atomic<bool> wrote_{false};
+};
+
+}  // namespace orm
+}  // namespace drogon
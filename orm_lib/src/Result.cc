@@ -12,15 +12,66 @@
  *
  */
 
+#include "CompactResultImpl.h"
 #include "ResultImpl.h"
 #include <cassert>
 #include <drogon/orm/Result.h>
 #include <drogon/orm/ResultIterator.h>
 #include <drogon/orm/Row.h>
 #include <drogon/orm/Exception.h>
+#include <drogon/orm/Field.h>
+#include <drogon/utils/JsonWriter.h>
+#include <drogon/utils/Utilities.h>
+#include <ctype.h>
 
 using namespace drogon::orm;
 
+namespace
+{
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][-+]?[0-9]+)?
+bool isJsonNumber(std::string_view text)
+{
+    size_t i = 0;
+    auto digits = [&text, &i]() {
+        auto start = i;
+        while (i < text.length() && isdigit((unsigned char)text[i]))
+            ++i;
+        return i - start;
+    };
+    if (i < text.length() && text[i] == '-')
+        ++i;
+    auto intDigits = digits();
+    if (intDigits == 0 || (intDigits > 1 && text[i - intDigits] == '0'))
+        return false;
+    if (i < text.length() && text[i] == '.')
+    {
+        ++i;
+        if (digits() == 0)
+            return false;
+    }
+    if (i < text.length() && (text[i] == 'e' || text[i] == 'E'))
+    {
+        ++i;
+        if (i < text.length() && (text[i] == '-' || text[i] == '+'))
+            ++i;
+        if (digits() == 0)
+            return false;
+    }
+    return i == text.length();
+}
+
+void writeNumber(drogon::JsonWriter &writer, std::string_view text)
+{
+    if (isJsonNumber(text))
+        writer.rawValue(text);
+    else if (text == "NaN" || text == "Infinity" || text == "-Infinity")
+        writer.value(nullptr);
+    else
+        // e.g. the zero filled integers of MySQL
+        writer.value(text);
+}
+}  // namespace
+
 Result::ConstIterator Result::begin() const noexcept
 {
     return ConstIterator(*this, (SizeType)0);
@@ -175,6 +226,11 @@ int Result::oid(RowSizeType column) const noexcept
     return resultPtr_->oid(column);
 }
 
+bool Result::isBinary(RowSizeType column) const noexcept
+{
+    return resultPtr_->isBinary(column);
+}
+
 Result &Result::operator=(const Result &r) noexcept
 {
     resultPtr_ = r.resultPtr_;
@@ -186,3 +242,70 @@ Result &Result::operator=(Result &&r) noexcept
     resultPtr_ = std::move(r.resultPtr_);
     return *this;
 }
+
+Result Result::compact() const
+{
+    if (!resultPtr_)
+        return *this;
+    return Result(std::make_shared<CompactResultImpl>(*resultPtr_));
+}
+
+void Result::writeJson(drogon::JsonWriter &writer) const
+{
+    writer.startArray();
+    if (!resultPtr_)
+    {
+        writer.endArray();
+        return;
+    }
+    auto rowsNumber = size();
+    auto columnsNumber = columns();
+    std::vector<ResultImpl::JsonType> types;
+    types.reserve(columnsNumber);
+    for (RowSizeType c = 0; c < columnsNumber; ++c)
+        types.push_back(resultPtr_->jsonType(c));
+    for (SizeType r = 0; r < rowsNumber; ++r)
+    {
+        writer.startObject();
+        for (RowSizeType c = 0; c < columnsNumber; ++c)
+        {
+            writer.key(columnName(c));
+            if (isNull(r, c))
+            {
+                writer.value(nullptr);
+                continue;
+            }
+            std::string decoded;
+            std::string_view text;
+            if (isBinary(c) || types[c] == ResultImpl::kJsonBinary)
+            {
+                decoded = Field(*this, r, c).as<std::string>();
+                text = decoded;
+            }
+            else
+            {
+                text = std::string_view(getValue(r, c), getLength(r, c));
+            }
+            switch (types[c])
+            {
+                case ResultImpl::kJsonNumber:
+                    writeNumber(writer, text);
+                    break;
+                case ResultImpl::kJsonBool:
+                    writer.value(text == "t" || text == "1" || text == "true");
+                    break;
+                case ResultImpl::kJsonDocument:
+                    writer.rawValue(text);
+                    break;
+                case ResultImpl::kJsonBinary:
+                    writer.value(drogon::utils::base64Encode(text));
+                    break;
+                default:
+                    writer.value(text);
+                    break;
+            }
+        }
+        writer.endObject();
+    }
+    writer.endArray();
+}
@@ -48,6 +48,30 @@ class ResultImpl : public trantor::NonCopyable
         return 0;
     }
 
+    virtual bool isBinary(RowSizeType column) const noexcept
+    {
+        (void)column;
+        return false;
+    }
+
+    /// How the values of a column are written by Result::writeJson()
+    enum JsonType : unsigned char
+    {
+        kJsonString = 0,
+        kJsonNumber,
+        kJsonBool,
+        // The values are JSON documents, written as they are
+        kJsonDocument,
+        // Binary strings, written in base64
+        kJsonBinary
+    };
+
+    virtual JsonType jsonType(RowSizeType column) const
+    {
+        (void)column;
+        return kJsonString;
+    }
+
     virtual ~ResultImpl()
     {
     }
@@ -0,0 +1,211 @@
+/**
+ *
+ *  @file ShardedDbClient.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/orm/ShardedDbClient.h>
+#include <drogon/IOThreadStorage.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <map>
+
+using namespace drogon;
+using namespace drogon::orm;
+
+namespace
+{
+constexpr size_t kNoShard = static_cast<size_t>(-1);
+
+uint64_t hashOf(std::string_view text)
+{
+    // FNV-1a, finished by the mixer of MurmurHash3
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+}  // namespace
+
+struct ShardedDbClient::Topology
+{
+    Shards shards;
+    // The pinned keys and their shards by name
+    std::map<std::string, std::string, std::less<>> pinned;
+    // Derived from the above by rebuild()
+    std::map<std::string, size_t, std::less<>> indexes;
+    std::vector<std::pair<uint64_t, size_t>> ring;
+    // The table before the last change, without its own previous table
+    TopologyPtr previous;
+
+    void rebuild(size_t virtualNodes)
+    {
+        indexes.clear();
+        ring.clear();
+        ring.reserve(shards.size() * virtualNodes);
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            indexes.emplace(shards[i].first, i);
+            for (size_t v = 0; v < virtualNodes; ++v)
+            {
+                ring.emplace_back(
+                    hashOf(shards[i].first + "#" + std::to_string(v)), i);
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+    }
+
+    size_t locate(std::string_view key) const
+    {
+        if (ring.empty())
+            return kNoShard;
+        auto pin = pinned.find(key);
+        if (pin != pinned.end())
+        {
+            auto index = indexes.find(pin->second);
+            if (index != indexes.end())
+                return index->second;
+        }
+        auto hash = hashOf(key);
+        auto iter = std::lower_bound(ring.begin(),
+                                     ring.end(),
+                                     std::make_pair(hash, size_t{0}));
+        if (iter == ring.end())
+            iter = ring.begin();
+        return iter->second;
+    }
+};
+
+ShardedDbClient::ShardedDbClient(const Shards &shards, size_t virtualNodes)
+    : virtualNodes_(virtualNodes == 0 ? 1 : virtualNodes)
+{
+    auto topology = std::make_shared<Topology>();
+    for (auto &shard : shards)
+    {
+        auto duplicate = std::find_if(topology->shards.begin(),
+                                      topology->shards.end(),
+                                      [&shard](const auto &other) {
+                                          return other.first == shard.first;
+                                      });
+        if (duplicate != topology->shards.end())
+        {
+            LOG_ERROR << "Duplicate shard " << shard.first << " ignored";
+            continue;
+        }
+        topology->shards.push_back(shard);
+    }
+    topology->rebuild(virtualNodes_);
+    latest_ = topology;
+    topology_ = std::make_unique<IOThreadSnapshot<Topology>>(latest_);
+}
+
+ShardedDbClient::~ShardedDbClient() = default;
+
+DbClientPtr ShardedDbClient::client(std::string_view key) const
+{
+    auto topology = topology_->getShared();
+    auto index = topology->locate(key);
+    if (index == kNoShard)
+        return nullptr;
+    return topology->shards[index].second;
+}
+
+std::string ShardedDbClient::shard(std::string_view key) const
+{
+    auto topology = topology_->getShared();
+    auto index = topology->locate(key);
+    if (index == kNoShard)
+        return {};
+    return topology->shards[index].first;
+}
+
+DbClientPtr ShardedDbClient::previousClient(std::string_view key) const
+{
+    auto topology = topology_->getShared();
+    if (topology->previous)
+        topology = topology->previous;
+    auto index = topology->locate(key);
+    if (index == kNoShard)
+        return nullptr;
+    return topology->shards[index].second;
+}
+
+ShardedDbClient::Shards ShardedDbClient::shards() const
+{
+    return topology_->getShared()->shards;
+}
+
+bool ShardedDbClient::addShard(const std::string &name, DbClientPtr client)
+{
+    bool added{false};
+    publish([&](Topology &topology) {
+        if (topology.indexes.find(name) != topology.indexes.end())
+            return;
+        topology.shards.emplace_back(name, std::move(client));
+        added = true;
+    });
+    return added;
+}
+
+bool ShardedDbClient::removeShard(const std::string &name)
+{
+    bool removed{false};
+    publish([&](Topology &topology) {
+        auto iter = topology.indexes.find(name);
+        if (iter == topology.indexes.end())
+            return;
+        topology.shards.erase(topology.shards.begin() + iter->second);
+        for (auto pin = topology.pinned.begin(); pin != topology.pinned.end();)
+        {
+            if (pin->second == name)
+                pin = topology.pinned.erase(pin);
+            else
+                ++pin;
+        }
+        removed = true;
+    });
+    return removed;
+}
+
+bool ShardedDbClient::pinKey(const std::string &key, const std::string &shard)
+{
+    bool pinned{false};
+    publish([&](Topology &topology) {
+        if (topology.indexes.find(shard) == topology.indexes.end())
+            return;
+        topology.pinned[key] = shard;
+        pinned = true;
+    });
+    return pinned;
+}
+
+void ShardedDbClient::unpinKey(const std::string &key)
+{
+    publish([&](Topology &topology) { topology.pinned.erase(key); });
+}
+
+void ShardedDbClient::publish(std::function<void(Topology &)> &&change)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto next = std::make_shared<Topology>(*latest_);
+    change(*next);
+    next->rebuild(virtualNodes_);
+    auto previous = std::make_shared<Topology>(*latest_);
+    previous->previous.reset();
+    next->previous = std::move(previous);
+    latest_ = next;
+    topology_->publish(std::move(next));
+}
@@ -12,6 +12,7 @@
  *
  */
 
+#include "../../lib/src/Tracing.h"
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/orm/SqlBinder.h>
@@ -28,9 +29,39 @@
 using namespace drogon::orm;
 using namespace drogon::orm::internal;
 
+/**
+ * @brief Make the statement a child span of the trace of the current thread,
+ * see drogon::Tracing.
+ */
+static drogon::SpanPtr traceStatement(const char *sql,
+                                      size_t length,
+                                      ClientType type)
+{
+    auto span = drogon::Tracing::instance().startClientSpan({});
+    if (!span)
+        return nullptr;
+    // The span is named by the operation, e.g. "SELECT"
+    std::string_view statement(sql, length);
+    auto begin = statement.find_first_not_of(" \t\r\n(");
+    if (begin != std::string_view::npos)
+    {
+        auto end = statement.find_first_of(" \t\r\n;(", begin);
+        span->name = std::string(statement.substr(begin, end - begin));
+    }
+    const char *system = "sqlite";
+    if (type == ClientType::PostgreSQL)
+        system = "postgresql";
+    else if (type == ClientType::Mysql)
+        system = "mysql";
+    span->attributes.emplace_back("db.system", system);
+    span->attributes.emplace_back("db.query.text", std::string(statement));
+    return span;
+}
+
 void SqlBinder::exec()
 {
     execed_ = true;
+    auto span = traceStatement(sqlViewPtr_, sqlViewLength_, type_);
     if (mode_ == Mode::NonBlocking)
     {
         // nonblocking mode,default mode
@@ -44,8 +75,10 @@ void SqlBinder::exec()
             std::move(formats_),
             [holder = std::move(callbackHolder_),
              objs = std::move(objs_),
-             sqlptr = std::move(sqlPtr_)](const Result &r) mutable {
+             sqlptr = std::move(sqlPtr_),
+             span](const Result &r) mutable {
                 objs.clear();
+                drogon::Tracing::instance().endClientSpan(span, false);
                 if (holder)
                 {
                     holder->execCallback(r);
@@ -53,8 +86,9 @@ void SqlBinder::exec()
             },
             [exceptCb = std::move(exceptionCallback_),
              exceptPtrCb = std::move(exceptionPtrCallback_),
-             isExceptPtr =
-                 isExceptionPtr_](const std::exception_ptr &exception) {
+             isExceptPtr = isExceptionPtr_,
+             span](const std::exception_ptr &exception) {
+                drogon::Tracing::instance().endClientSpan(span, true);
                 // LOG_DEBUG<<"exp callback "<<isExceptPtr;
                 if (!isExceptPtr)
                 {
@@ -90,8 +124,12 @@ void SqlBinder::exec()
             std::move(parameters_),
             std::move(lengths_),
             std::move(formats_),
-            [pro](const Result &r) { pro->set_value(r); },
-            [pro](const std::exception_ptr &exception) {
+            [pro, span](const Result &r) {
+                drogon::Tracing::instance().endClientSpan(span, false);
+                pro->set_value(r);
+            },
+            [pro, span](const std::exception_ptr &exception) {
+                drogon::Tracing::instance().endClientSpan(span, true);
                 try
                 {
                     pro->set_exception(exception);
@@ -157,6 +195,26 @@ SqlBinder &SqlBinder::operator<<(RawParameter &&param)
     return *this;
 }
 
+SqlBinder &SqlBinder::operator<<(const ParameterView &param)
+{
+    parameters_.push_back(param.data.data());
+    lengths_.push_back(static_cast<int>(param.data.length()));
+    ++parametersNumber_;
+    if (type_ == ClientType::PostgreSQL)
+    {
+        formats_.push_back(param.binary ? 1 : 0);
+    }
+    else if (type_ == ClientType::Mysql)
+    {
+        formats_.push_back(MySqlString);
+    }
+    else if (type_ == ClientType::Sqlite3)
+    {
+        formats_.push_back(param.binary ? Sqlite3TypeBlob : Sqlite3TypeText);
+    }
+    return *this;
+}
+
 SqlBinder &SqlBinder::operator<<(const std::string_view &str)
 {
     auto obj = std::make_shared<std::string>(str.data(), str.length());
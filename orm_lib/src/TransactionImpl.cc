@@ -27,7 +27,8 @@ TransactionImpl::TransactionImpl(ClientType type,
     : connectionPtr_(connPtr),
       usedUpCallback_(std::move(usedUpCallback)),
       loop_(connPtr->loop()),
-      commitCallback_(std::move(commitCallback))
+      commitCallback_(std::move(commitCallback)),
+      pipelined_(connPtr->supportsPipelining())
 {
     type_ = type;
 }
@@ -39,9 +40,13 @@ TransactionImpl::~TransactionImpl()
     if (!isCommitedOrRolledback_)
     {
         auto loop = connectionPtr_->loop();
+        // In the pipeline mode, the commit may follow commands whose results
+        // are not received yet. A transaction aborted by one of them is
+        // rolled back by the commit.
         loop->queueInLoop([conn = connectionPtr_,
                            ucb = std::move(usedUpCallback_),
-                           commitCb = std::move(commitCallback_)]() {
+                           commitCb = std::move(commitCallback_),
+                           aborted = aborted_]() {
             conn->setIdleCallback([ucb = std::move(ucb)]() {
                 if (ucb)
                     ucb();
@@ -52,7 +57,16 @@ TransactionImpl::~TransactionImpl()
                 {},
                 {},
                 {},
-                [commitCb](const Result &) {
+                [commitCb, aborted](const Result &) {
+                    if (*aborted)
+                    {
+                        LOG_ERROR << "Transaction rolled back";
+                        if (commitCb)
+                        {
+                            commitCb(false);
+                        }
+                        return;
+                    }
                     LOG_TRACE << "Transaction committed!";
                     if (commitCb)
                     {
@@ -97,6 +111,17 @@ void TransactionImpl::execSqlInLoop(
     loop_->assertInLoopThread();
     if (!isCommitedOrRolledback_)
     {
+        if (pipelined_)
+        {
+            execSqlInPipeline(std::move(sql),
+                              paraNum,
+                              std::move(parameters),
+                              std::move(length),
+                              std::move(format),
+                              std::move(rcb),
+                              std::move(exceptCallback));
+            return;
+        }
         if (timeout_ > 0.0)
         {
             execSqlInLoopWithTimeout(std::move(sql),
@@ -157,7 +182,15 @@ void TransactionImpl::rollback()
     loop_->runInLoop([thisPtr]() {
         if (thisPtr->isCommitedOrRolledback_)
             return;
-        if (thisPtr->isWorking_)
+        if (thisPtr->pipelined_)
+        {
+            // Sent behind the commands in the pipeline, which fail once the
+            // transaction is aborted
+            if (*thisPtr->aborted_)
+                return;
+            *thisPtr->aborted_ = true;
+        }
+        else if (thisPtr->isWorking_)
         {
             // push sql cmd to buffer;
             auto cmdPtr = std::make_shared<SqlCmd>();
@@ -278,7 +311,10 @@ void TransactionImpl::doBegin()
         assert(!thisPtr->isWorking_);
         assert(!thisPtr->isCommitedOrRolledback_);
         thisPtr->isWorking_ = true;
-        thisPtr->thisPtr_ = thisPtr;
+        // In the pipeline mode, the transaction may be committed before the
+        // results of its commands are received
+        if (!thisPtr->pipelined_)
+            thisPtr->thisPtr_ = thisPtr;
         thisPtr->connectionPtr_->execSql(
             "begin",
             0,
@@ -286,9 +322,12 @@ void TransactionImpl::doBegin()
             {},
             {},
             [](const Result &) { LOG_TRACE << "Transaction begin!"; },
-            [thisPtr](const std::exception_ptr &) {
+            [weakPtr, aborted = thisPtr->aborted_](const std::exception_ptr &) {
                 LOG_ERROR << "Error occurred in transaction begin";
-                thisPtr->isCommitedOrRolledback_ = true;
+                *aborted = true;
+                auto thisPtr = weakPtr.lock();
+                if (thisPtr)
+                    thisPtr->isCommitedOrRolledback_ = true;
             });
     });
 }
@@ -389,3 +428,90 @@ void TransactionImpl::execSqlInLoopWithTimeout(
     }
     timeoutFlagPtr->runTimer();
 }
+
+void TransactionImpl::execSqlInPipeline(
+    std::string_view &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&ecb)
+{
+    auto aborted = aborted_;
+    if (*aborted)
+    {
+        ecb(std::make_exception_ptr(
+            TransactionRollback("The transaction has been rolled back")));
+        return;
+    }
+    std::weak_ptr<TransactionImpl> weakPtr = shared_from_this();
+    auto ecbPtr =
+        std::make_shared<std::function<void(const std::exception_ptr &)>>(
+            std::move(ecb));
+    std::shared_ptr<drogon::TaskTimeoutFlag> timeoutFlagPtr;
+    if (timeout_ > 0.0)
+    {
+        timeoutFlagPtr = std::make_shared<drogon::TaskTimeoutFlag>(
+            loop_,
+            std::chrono::duration<double>(timeout_),
+            [weakPtr, ecbPtr]() {
+                auto thisPtr = weakPtr.lock();
+                if (thisPtr)
+                    thisPtr->rollback();
+                if (*ecbPtr)
+                {
+                    (*ecbPtr)(std::make_exception_ptr(
+                        TimeoutError("SQL execution timeout")));
+                }
+            });
+    }
+    // Sent without waiting for the results of the previous commands. Once
+    // one of them fails, or the transaction is rolled back, the results of
+    // the commands after it are reported as rolled back.
+    isWorking_ = true;
+    connectionPtr_->execSql(
+        std::move(sql),
+        paraNum,
+        std::move(parameters),
+        std::move(length),
+        std::move(format),
+        [rcb = std::move(rcb), ecbPtr, timeoutFlagPtr, aborted](
+            const Result &result) {
+            if (timeoutFlagPtr && timeoutFlagPtr->done())
+                return;
+            if (*aborted)
+            {
+                if (*ecbPtr)
+                {
+                    (*ecbPtr)(std::make_exception_ptr(TransactionRollback(
+                        "The transaction has been rolled back")));
+                }
+                return;
+            }
+            rcb(result);
+        },
+        [weakPtr, ecbPtr, timeoutFlagPtr, aborted](
+            const std::exception_ptr &ePtr) {
+            if (timeoutFlagPtr && timeoutFlagPtr->done())
+                return;
+            if (*aborted)
+            {
+                if (*ecbPtr)
+                {
+                    (*ecbPtr)(std::make_exception_ptr(TransactionRollback(
+                        "The transaction has been rolled back")));
+                }
+                return;
+            }
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->rollback();
+            else
+                *aborted = true;
+            if (*ecbPtr)
+                (*ecbPtr)(ePtr);
+        });
+    if (timeoutFlagPtr)
+        timeoutFlagPtr->runTimer();
+}
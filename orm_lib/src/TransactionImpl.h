@@ -111,6 +111,14 @@ class TransactionImpl : public Transaction,
         std::vector<int> &&format,
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback);
+    void execSqlInPipeline(
+        std::string_view &&sql,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        ResultCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback);
 
     std::shared_ptr<Transaction> newTransaction(
         const std::function<void(bool)> &) noexcept(false) override
@@ -153,6 +161,12 @@ class TransactionImpl : public Transaction,
     std::function<void(bool)> commitCallback_;
     std::shared_ptr<TransactionImpl> thisPtr_;
     double timeout_{-1.0};
+    // Set when the connection pipelines the commands, they are sent without
+    // waiting for the results of the previous ones
+    bool pipelined_{false};
+    // Set once the transaction fails or is rolled back, shared with the
+    // callbacks of the commands in flight, which may outlive it
+    std::shared_ptr<bool> aborted_{std::make_shared<bool>(false)};
 };
 }  // namespace orm
 }  // namespace drogon
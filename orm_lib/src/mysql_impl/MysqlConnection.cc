@@ -20,6 +20,8 @@
 #include <drogon/utils/Utilities.h>
 #include <string_view>
 #include <errmsg.h>
+#include <mysqld_error.h>
+#include <string.h>
 #ifndef _WIN32
 #include <poll.h>
 #else
@@ -45,6 +47,102 @@ Result makeResult(std::shared_ptr<MYSQL_RES> &&r = nullptr,
                                                     insertId)};
 }
 
+// The size of the value of a parameter of a fixed size type, 0 for the
+// others
+static size_t fixedParameterSize(int format)
+{
+    switch (format)
+    {
+        case internal::MySqlTiny:
+        case internal::MySqlUTiny:
+            return 1;
+        case internal::MySqlShort:
+        case internal::MySqlUShort:
+            return 2;
+        case internal::MySqlLong:
+        case internal::MySqlULong:
+            return 4;
+        case internal::MySqlLongLong:
+        case internal::MySqlULongLong:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// Fetch the rows of a stored result of a statement, converted to text by the
+// client library
+static std::shared_ptr<MysqlStatementRows> fetchStatementRows(
+    MYSQL_STMT *stmt,
+    MYSQL_RES *metadata)
+{
+    auto fieldsNumber = mysql_num_fields(metadata);
+    auto fields = mysql_fetch_fields(metadata);
+    std::vector<std::string> buffers(fieldsNumber);
+    std::vector<unsigned long> lengths(fieldsNumber);
+    std::vector<my_bool> nulls(fieldsNumber);
+    std::vector<my_bool> errors(fieldsNumber);
+    std::vector<MYSQL_BIND> binds(fieldsNumber);
+    memset(binds.data(), 0, sizeof(MYSQL_BIND) * fieldsNumber);
+    for (unsigned int i = 0; i < fieldsNumber; ++i)
+    {
+        buffers[i].resize((std::max)(fields[i].max_length + 1, 64UL));
+        binds[i].buffer_type = MYSQL_TYPE_STRING;
+        binds[i].buffer = &buffers[i][0];
+        binds[i].buffer_length = buffers[i].size();
+        binds[i].length = &lengths[i];
+        binds[i].is_null = &nulls[i];
+        binds[i].error = &errors[i];
+    }
+    if (mysql_stmt_bind_result(stmt, binds.data()))
+        return nullptr;
+    auto rows = std::make_shared<MysqlStatementRows>();
+    auto rowsNumber = mysql_stmt_num_rows(stmt);
+    rows->lengths_.reserve(rowsNumber * fieldsNumber);
+    // The offsets of the values in the data, the pointers are set once it
+    // no longer grows
+    std::vector<size_t> offsets;
+    offsets.reserve(rowsNumber * fieldsNumber);
+    int ret;
+    while ((ret = mysql_stmt_fetch(stmt)) != MYSQL_NO_DATA)
+    {
+        if (ret == 1)
+            return nullptr;
+        for (unsigned int i = 0; i < fieldsNumber; ++i)
+        {
+            if (nulls[i])
+            {
+                offsets.push_back(std::string::npos);
+                rows->lengths_.push_back(0);
+                continue;
+            }
+            if (ret == MYSQL_DATA_TRUNCATED && errors[i])
+            {
+                buffers[i].resize(lengths[i] + 1);
+                binds[i].buffer = &buffers[i][0];
+                binds[i].buffer_length = buffers[i].size();
+                if (mysql_stmt_fetch_column(stmt, &binds[i], i, 0))
+                    return nullptr;
+            }
+            offsets.push_back(rows->data_.size());
+            rows->lengths_.push_back(lengths[i]);
+            rows->data_.append(buffers[i].data(), lengths[i]);
+            rows->data_.push_back('\0');
+        }
+        if (ret == MYSQL_DATA_TRUNCATED &&
+            mysql_stmt_bind_result(stmt, binds.data()))
+            return nullptr;
+    }
+    rows->values_.reserve(offsets.size());
+    for (auto offset : offsets)
+    {
+        rows->values_.push_back(offset == std::string::npos
+                                    ? nullptr
+                                    : &rows->data_[offset]);
+    }
+    return rows;
+}
+
 }  // namespace orm
 }  // namespace drogon
 
@@ -185,6 +283,9 @@ void MysqlConnection::disconnect()
         thisPtr->status_ = ConnectStatus::Bad;
         thisPtr->channelPtr_->disableAll();
         thisPtr->channelPtr_->remove();
+        thisPtr->stmt_.reset();
+        thisPtr->statements_.clear();
+        thisPtr->statementList_.clear();
         thisPtr->mysqlPtr_.reset();
         pro.set_value(1);
     });
@@ -298,6 +399,37 @@ void MysqlConnection::handleCmd(int status)
             setChannel();
             break;
         }
+        case ExecStatus::StmtPrepare:
+        {
+            int err = 0;
+            waitStatus_ = mysql_stmt_prepare_cont(&err, stmt_.get(), status);
+            if (waitStatus_ == 0)
+                finishPrepare(err);
+            else
+                setChannel();
+            break;
+        }
+        case ExecStatus::StmtExecute:
+        {
+            int err = 0;
+            waitStatus_ = mysql_stmt_execute_cont(&err, stmt_.get(), status);
+            if (waitStatus_ == 0)
+                finishExecute(err);
+            else
+                setChannel();
+            break;
+        }
+        case ExecStatus::StmtStoreResult:
+        {
+            int err = 0;
+            waitStatus_ =
+                mysql_stmt_store_result_cont(&err, stmt_.get(), status);
+            if (waitStatus_ == 0)
+                finishStoreStatementResult(err);
+            else
+                setChannel();
+            break;
+        }
         case ExecStatus::None:
         {
             // Connection closed!
@@ -444,7 +576,48 @@ void MysqlConnection::execSqlInLoop(
     callback_ = std::move(rcb);
     isWorking_ = true;
     exceptionCallback_ = std::move(exceptCallback);
-    sql_.clear();
+    if (usePreparedStatements_ && canPrepare(sql, paraNum, format))
+    {
+        sql_ = std::string(sql.data(), sql.length());
+        paraNum_ = paraNum;
+        lengths_ = std::move(length);
+        formats_ = std::move(format);
+        // Copy the values of the parameters which are used after this call
+        paramData_.clear();
+        std::vector<size_t> offsets(paraNum);
+        for (size_t i = 0; i < paraNum; ++i)
+        {
+            offsets[i] = paramData_.size();
+            auto size = fixedParameterSize(formats_[i]);
+            if (formats_[i] == internal::MySqlString)
+                size = lengths_[i];
+            if (size > 0)
+                paramData_.append(parameters[i], size);
+        }
+        parameters_.resize(paraNum);
+        for (size_t i = 0; i < paraNum; ++i)
+        {
+            parameters_[i] = formats_[i] == internal::MySqlNull
+                                 ? nullptr
+                                 : paramData_.data() + offsets[i];
+        }
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this()] { thisPtr->startStatement(); });
+        return;
+    }
+    sql_ = buildQuery(sql, paraNum, parameters, length, format);
+    startQuery();
+    setChannel();
+}
+
+std::string MysqlConnection::buildQuery(
+    std::string_view sql,
+    size_t paraNum,
+    const std::vector<const char *> &parameters,
+    const std::vector<int> &length,
+    const std::vector<int> &format)
+{
+    std::string query;
     if (paraNum > 0)
     {
         std::string::size_type pos = 0;
@@ -455,65 +628,65 @@ void MysqlConnection::execSqlInLoop(
             if (seekPos == std::string::npos)
             {
                 auto sub = sql.substr(pos);
-                sql_.append(sub.data(), sub.length());
+                query.append(sub.data(), sub.length());
                 pos = seekPos;
                 break;
             }
             else
             {
                 auto sub = sql.substr(pos, seekPos - pos);
-                sql_.append(sub.data(), sub.length());
+                query.append(sub.data(), sub.length());
                 pos = seekPos + 1;
                 switch (format[i])
                 {
                     case internal::MySqlTiny:
-                        sql_.append(std::to_string(*((char *)parameters[i])));
+                        query.append(std::to_string(*((char *)parameters[i])));
                         break;
                     case internal::MySqlShort:
-                        sql_.append(std::to_string(*((short *)parameters[i])));
+                        query.append(std::to_string(*((short *)parameters[i])));
                         break;
                     case internal::MySqlLong:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((int32_t *)parameters[i])));
                         break;
                     case internal::MySqlLongLong:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((int64_t *)parameters[i])));
                         break;
                     case internal::MySqlUTiny:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((unsigned char *)parameters[i])));
                         break;
                     case internal::MySqlUShort:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((unsigned short *)parameters[i])));
                         break;
                     case internal::MySqlULong:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((uint32_t *)parameters[i])));
                         break;
                     case internal::MySqlULongLong:
-                        sql_.append(
+                        query.append(
                             std::to_string(*((uint64_t *)parameters[i])));
                         break;
                     case internal::MySqlNull:
-                        sql_.append("NULL");
+                        query.append("NULL");
                         break;
                     case internal::MySqlString:
                     {
-                        sql_.append("'");
+                        query.append("'");
                         std::string to(length[i] * 2, '\0');
                         auto len = mysql_real_escape_string(mysqlPtr_.get(),
                                                             (char *)to.c_str(),
                                                             parameters[i],
                                                             length[i]);
                         to.resize(len);
-                        sql_.append(to);
-                        sql_.append("'");
+                        query.append(to);
+                        query.append("'");
                     }
                     break;
                     case internal::DrogonDefaultValue:
-                        sql_.append("default");
+                        query.append("default");
                         break;
                     default:
                         LOG_FATAL
@@ -526,29 +699,278 @@ void MysqlConnection::execSqlInLoop(
         if (pos < sql.length())
         {
             auto sub = sql.substr(pos);
-            sql_.append(sub.data(), sub.length());
+            query.append(sub.data(), sub.length());
         }
     }
     else
     {
-        sql_ = std::string(sql.data(), sql.length());
+        query = std::string(sql.data(), sql.length());
     }
+    return query;
+}
+
+bool MysqlConnection::canPrepare(std::string_view sql,
+                                 size_t paraNum,
+                                 const std::vector<int> &format) const
+{
+    if (paraNum == 0)
+        return false;
+    // The DEFAULT keyword is not a value that can be bound, and the stored
+    // procedures may return several results
+    for (auto f : format)
+    {
+        if (f == internal::DrogonDefaultValue)
+            return false;
+    }
+    auto pos = sql.find_first_not_of(" \t\r\n(");
+    if (pos == std::string_view::npos)
+        return false;
+    auto keyword = sql.substr(pos, 4);
+    return !(keyword.length() == 4 &&
+             (keyword[0] == 'c' || keyword[0] == 'C') &&
+             (keyword[1] == 'a' || keyword[1] == 'A') &&
+             (keyword[2] == 'l' || keyword[2] == 'L') &&
+             (keyword[3] == 'l' || keyword[3] == 'L'));
+}
+
+void MysqlConnection::startStatement()
+{
+    if (status_ != ConnectStatus::Ok)
+    {
+        LOG_ERROR << "Connection is not ready";
+        if (isWorking_)
+        {
+            exceptionCallback_(
+                std::make_exception_ptr(drogon::orm::BrokenConnection()));
+            exceptionCallback_ = nullptr;
+            callback_ = nullptr;
+            isWorking_ = false;
+        }
+        return;
+    }
+    auto iter = statements_.find(sql_);
+    if (iter != statements_.end())
+    {
+        statementList_.splice(statementList_.begin(),
+                              statementList_,
+                              iter->second);
+        stmt_ = iter->second->second;
+        startExecute();
+        return;
+    }
+    auto stmt = mysql_stmt_init(mysqlPtr_.get());
+    if (!stmt)
+    {
+        outputError();
+        return;
+    }
+    stmt_ = std::shared_ptr<MYSQL_STMT>(stmt, [](MYSQL_STMT *p) {
+        mysql_stmt_close(p);
+    });
+    my_bool updateMaxLength = 1;
+    mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+    execStatus_ = ExecStatus::StmtPrepare;
+    int err = 0;
+    waitStatus_ =
+        mysql_stmt_prepare_start(&err, stmt, sql_.data(), sql_.size());
+    if (waitStatus_ == 0)
+        finishPrepare(err);
+    else
+        setChannel();
+}
+
+void MysqlConnection::finishPrepare(int err)
+{
+    execStatus_ = ExecStatus::None;
+    if (err)
+    {
+        if (mysql_stmt_errno(stmt_.get()) == ER_UNSUPPORTED_PS)
+        {
+            fallBackToQuery();
+            return;
+        }
+        outputError(stmt_.get());
+        return;
+    }
+    // The placeholders are counted by the server, a '?' in a literal is not
+    // one of them
+    if (mysql_stmt_param_count(stmt_.get()) != paraNum_)
+    {
+        fallBackToQuery();
+        return;
+    }
+    if (statementCapacity_ > 0 && statementList_.size() >= statementCapacity_)
+    {
+        statements_.erase(statementList_.back().first);
+        statementList_.pop_back();
+    }
+    statementList_.emplace_front(sql_, stmt_);
+    statements_[statementList_.front().first] = statementList_.begin();
+    startExecute();
+}
+
+void MysqlConnection::fallBackToQuery()
+{
+    LOG_TRACE << "The statement can not be prepared, sent as a query";
+    stmt_.reset();
+    sql_ = buildQuery(sql_, paraNum_, parameters_, lengths_, formats_);
     startQuery();
     setChannel();
 }
 
-void MysqlConnection::outputError()
+void MysqlConnection::startExecute()
+{
+    binds_.resize(paraNum_);
+    memset(binds_.data(), 0, sizeof(MYSQL_BIND) * paraNum_);
+    for (size_t i = 0; i < paraNum_; ++i)
+    {
+        auto &bind = binds_[i];
+        bind.buffer = const_cast<char *>(parameters_[i]);
+        switch (formats_[i])
+        {
+            case internal::MySqlUTiny:
+                bind.is_unsigned = 1;
+                [[fallthrough]];
+            case internal::MySqlTiny:
+                bind.buffer_type = MYSQL_TYPE_TINY;
+                break;
+            case internal::MySqlUShort:
+                bind.is_unsigned = 1;
+                [[fallthrough]];
+            case internal::MySqlShort:
+                bind.buffer_type = MYSQL_TYPE_SHORT;
+                break;
+            case internal::MySqlULong:
+                bind.is_unsigned = 1;
+                [[fallthrough]];
+            case internal::MySqlLong:
+                bind.buffer_type = MYSQL_TYPE_LONG;
+                break;
+            case internal::MySqlULongLong:
+                bind.is_unsigned = 1;
+                [[fallthrough]];
+            case internal::MySqlLongLong:
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                break;
+            case internal::MySqlNull:
+                bind.buffer_type = MYSQL_TYPE_NULL;
+                break;
+            case internal::MySqlString:
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer_length = lengths_[i];
+                break;
+            default:
+                LOG_FATAL << "MySQL does not recognize the parameter type";
+                abort();
+                break;
+        }
+    }
+    if (mysql_stmt_bind_param(stmt_.get(), binds_.data()))
+    {
+        outputError(stmt_.get());
+        return;
+    }
+    execStatus_ = ExecStatus::StmtExecute;
+    int err = 0;
+    waitStatus_ = mysql_stmt_execute_start(&err, stmt_.get());
+    if (waitStatus_ == 0)
+        finishExecute(err);
+    else
+        setChannel();
+}
+
+void MysqlConnection::finishExecute(int err)
+{
+    execStatus_ = ExecStatus::None;
+    if (err)
+    {
+        outputError(stmt_.get());
+        return;
+    }
+    if (mysql_stmt_field_count(stmt_.get()) == 0)
+    {
+        deliverResult(makeResult(nullptr,
+                                 mysql_stmt_affected_rows(stmt_.get()),
+                                 mysql_stmt_insert_id(stmt_.get())));
+        return;
+    }
+    execStatus_ = ExecStatus::StmtStoreResult;
+    waitStatus_ = mysql_stmt_store_result_start(&err, stmt_.get());
+    if (waitStatus_ == 0)
+        finishStoreStatementResult(err);
+    else
+        setChannel();
+}
+
+void MysqlConnection::finishStoreStatementResult(int err)
+{
+    execStatus_ = ExecStatus::None;
+    // Kept alive while its result is freed
+    auto stmtPtr = stmt_;
+    auto stmt = stmtPtr.get();
+    if (err)
+    {
+        outputError(stmt);
+        return;
+    }
+    // Read after the result is stored, with the maximum lengths of the
+    // values
+    auto metadata = mysql_stmt_result_metadata(stmt);
+    if (!metadata)
+    {
+        outputError(stmt);
+        return;
+    }
+    auto metadataPtr =
+        std::shared_ptr<MYSQL_RES>(metadata,
+                                   [](MYSQL_RES *r) { mysql_free_result(r); });
+    auto rows = fetchStatementRows(stmt, metadata);
+    if (!rows)
+    {
+        outputError(stmt);
+        mysql_stmt_free_result(stmt);
+        return;
+    }
+    mysql_stmt_free_result(stmt);
+    deliverResult(
+        Result{std::make_shared<MysqlResultImpl>(std::move(metadataPtr),
+                                                 std::move(rows),
+                                                 mysql_stmt_affected_rows(stmt),
+                                                 0)});
+}
+
+void MysqlConnection::deliverResult(const Result &result)
+{
+    stmt_.reset();
+    if (isWorking_)
+    {
+        callback_(result);
+        callback_ = nullptr;
+        exceptionCallback_ = nullptr;
+        isWorking_ = false;
+        idleCb_();
+    }
+    setChannel();
+}
+
+void MysqlConnection::outputError(MYSQL_STMT *stmt)
 {
     channelPtr_->disableAll();
-    auto errorNo = mysql_errno(mysqlPtr_.get());
-    LOG_ERROR << "Error(" << errorNo << ") [" << mysql_sqlstate(mysqlPtr_.get())
-              << "] \"" << mysql_error(mysqlPtr_.get()) << "\"";
+    // The errors of the statements are not the ones of the connection
+    auto errorNo = stmt ? mysql_stmt_errno(stmt) : mysql_errno(mysqlPtr_.get());
+    std::string message =
+        stmt ? mysql_stmt_error(stmt) : mysql_error(mysqlPtr_.get());
+    LOG_ERROR << "Error(" << errorNo << ") ["
+              << (stmt ? mysql_stmt_sqlstate(stmt)
+                       : mysql_sqlstate(mysqlPtr_.get()))
+              << "] \"" << message << "\"";
     LOG_ERROR << "sql:" << sql_;
+    stmt_.reset();
     if (isWorking_)
     {
         // TODO: exception type
-        auto exceptPtr = std::make_exception_ptr(
-            SqlError(mysql_error(mysqlPtr_.get()), sql_, errorNo, 0));
+        auto exceptPtr =
+            std::make_exception_ptr(SqlError(message, sql_, errorNo, 0));
         exceptionCallback_(exceptPtr);
         exceptionCallback_ = nullptr;
 
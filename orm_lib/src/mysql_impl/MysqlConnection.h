@@ -21,9 +21,12 @@
 #include <trantor/utils/NonCopyable.h>
 #include <functional>
 #include <iostream>
+#include <list>
 #include <memory>
 #include <mysql.h>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace drogon
 {
@@ -94,6 +97,20 @@ class MysqlConnection : public DbConnection,
 
     void disconnect() override;
 
+    /**
+     * @brief Execute the queries with parameters as server-side prepared
+     * statements, whose parameters and rows are sent in the binary protocol.
+     *
+     * The statements are prepared once per connection and kept in a cache of
+     * the given capacity, the least recently used one is closed when it is
+     * full. 0 means an unbounded cache.
+     */
+    void setPreparedStatements(size_t capacity)
+    {
+        usePreparedStatements_ = true;
+        statementCapacity_ = capacity;
+    }
+
   private:
     class MysqlEnv
     {
@@ -135,6 +152,15 @@ class MysqlConnection : public DbConnection,
     void continueSetCharacterSet(int status);
     std::unique_ptr<trantor::Channel> channelPtr_;
     std::shared_ptr<MYSQL> mysqlPtr_;
+    // Declared after mysqlPtr_, the statements are closed before the
+    // connection
+    using StatementList =
+        std::list<std::pair<std::string, std::shared_ptr<MYSQL_STMT>>>;
+    StatementList statementList_;
+    std::unordered_map<std::string_view, StatementList::iterator> statements_;
+    std::shared_ptr<MYSQL_STMT> stmt_;
+    bool usePreparedStatements_{false};
+    size_t statementCapacity_{0};
     std::string characterSet_;
     void handleTimeout();
     void handleCmd(int status);
@@ -144,6 +170,21 @@ class MysqlConnection : public DbConnection,
     void getResult(MYSQL_RES *res);
     void startQuery();
     void startStoreResult(bool queueInLoop);
+    std::string buildQuery(std::string_view sql,
+                           size_t paraNum,
+                           const std::vector<const char *> &parameters,
+                           const std::vector<int> &length,
+                           const std::vector<int> &format);
+    bool canPrepare(std::string_view sql,
+                    size_t paraNum,
+                    const std::vector<int> &format) const;
+    void startStatement();
+    void finishPrepare(int err);
+    void startExecute();
+    void finishExecute(int err);
+    void finishStoreStatementResult(int err);
+    void fallBackToQuery();
+    void deliverResult(const Result &result);
     int waitStatus_;
     unsigned int reconnect_{1};
     enum class ExecStatus
@@ -151,12 +192,23 @@ class MysqlConnection : public DbConnection,
         None = 0,
         RealQuery,
         StoreResult,
-        NextResult
+        NextResult,
+        StmtPrepare,
+        StmtExecute,
+        StmtStoreResult
     };
     ExecStatus execStatus_{ExecStatus::None};
 
-    void outputError();
+    void outputError(MYSQL_STMT *stmt = nullptr);
     std::string sql_;
+    // The parameters of the statement being executed, copied as the
+    // statement is prepared asynchronously
+    size_t paraNum_{0};
+    std::string paramData_;
+    std::vector<const char *> parameters_;
+    std::vector<int> lengths_;
+    std::vector<int> formats_;
+    std::vector<MYSQL_BIND> binds_;
     std::string host_, user_, passwd_, dbname_, port_;
 };
 
@@ -83,3 +83,40 @@ unsigned long long MysqlResultImpl::insertId() const noexcept
 {
     return insertId_;
 }
+
+ResultImpl::JsonType MysqlResultImpl::jsonType(RowSizeType column) const
+{
+    if (!fieldArray_)
+        return kJsonString;
+    assert(column < fieldsNumber_);
+    auto &field = fieldArray_[column];
+    switch (field.type)
+    {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_LONGLONG:
+        case MYSQL_TYPE_YEAR:
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+        case MYSQL_TYPE_DECIMAL:
+        case MYSQL_TYPE_NEWDECIMAL:
+            return kJsonNumber;
+        case MYSQL_TYPE_JSON:
+            return kJsonDocument;
+        case MYSQL_TYPE_BIT:
+            return kJsonBinary;
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_BLOB:
+        case MYSQL_TYPE_STRING:
+        case MYSQL_TYPE_VAR_STRING:
+        case MYSQL_TYPE_VARCHAR:
+            // The binary character set, BINARY, VARBINARY and BLOB columns
+            return field.charsetnr == 63 ? kJsonBinary : kJsonString;
+        default:
+            return kJsonString;
+    }
+}
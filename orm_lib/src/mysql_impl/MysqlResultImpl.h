@@ -26,6 +26,20 @@ namespace drogon
 {
 namespace orm
 {
+/**
+ * @brief The rows of the result of a prepared statement, received in the
+ * binary protocol and converted by the client library to the text form of
+ * the columns, which Field parses. The values are null terminated like the
+ * rows of the text protocol.
+ */
+struct MysqlStatementRows
+{
+    std::string data_;
+    // The values of the rows one after the other, nullptr for NULL
+    std::vector<char *> values_;
+    std::vector<unsigned long> lengths_;
+};
+
 class MysqlResultImpl : public ResultImpl
 {
   public:
@@ -39,20 +53,7 @@ class MysqlResultImpl : public ResultImpl
           affectedRows_(affectedRows),
           insertId_(insertId)
     {
-        if (fieldsNumber_ > 0)
-        {
-            fieldsMapPtr_ = std::make_shared<
-                std::unordered_map<std::string, RowSizeType>>();
-            for (RowSizeType i = 0; i < fieldsNumber_; ++i)
-            {
-                std::string fieldName = fieldArray_[i].name;
-                std::transform(fieldName.begin(),
-                               fieldName.end(),
-                               fieldName.begin(),
-                               [](unsigned char c) { return tolower(c); });
-                (*fieldsMapPtr_)[fieldName] = i;
-            }
-        }
+        mapFields();
         if (size() > 0)
         {
             rowsPtr_ = std::make_shared<
@@ -71,6 +72,44 @@ class MysqlResultImpl : public ResultImpl
         }
     }
 
+    /**
+     * @param metadata The fields of the result, from
+     * mysql_stmt_result_metadata()
+     */
+    MysqlResultImpl(std::shared_ptr<MYSQL_RES> metadata,
+                    std::shared_ptr<MysqlStatementRows> rows,
+                    SizeType affectedRows,
+                    unsigned long long insertId) noexcept
+        : result_(std::move(metadata)),
+          rowsNumber_(result_ && mysql_num_fields(result_.get()) > 0
+                          ? rows->values_.size() /
+                                mysql_num_fields(result_.get())
+                          : 0),
+          fieldArray_(result_ ? mysql_fetch_fields(result_.get()) : nullptr),
+          fieldsNumber_(result_ ? mysql_num_fields(result_.get()) : 0),
+          affectedRows_(affectedRows),
+          insertId_(insertId),
+          statementRows_(std::move(rows))
+    {
+        mapFields();
+        if (size() > 0)
+        {
+            rowsPtr_ = std::make_shared<
+                std::vector<std::pair<char **, std::vector<unsigned long>>>>();
+            rowsPtr_->reserve(rowsNumber_);
+            for (SizeType i = 0; i < rowsNumber_; ++i)
+            {
+                auto offset = i * fieldsNumber_;
+                rowsPtr_->emplace_back(
+                    statementRows_->values_.data() + offset,
+                    std::vector<unsigned long>(
+                        statementRows_->lengths_.begin() + offset,
+                        statementRows_->lengths_.begin() + offset +
+                            fieldsNumber_));
+            }
+        }
+    }
+
     SizeType size() const noexcept override;
     RowSizeType columns() const noexcept override;
     const char *columnName(RowSizeType number) const override;
@@ -80,8 +119,26 @@ class MysqlResultImpl : public ResultImpl
     bool isNull(SizeType row, RowSizeType column) const override;
     FieldSizeType getLength(SizeType row, RowSizeType column) const override;
     unsigned long long insertId() const noexcept override;
+    JsonType jsonType(RowSizeType column) const override;
 
   private:
+    void mapFields()
+    {
+        if (fieldsNumber_ == 0)
+            return;
+        fieldsMapPtr_ =
+            std::make_shared<std::unordered_map<std::string, RowSizeType>>();
+        for (RowSizeType i = 0; i < fieldsNumber_; ++i)
+        {
+            std::string fieldName = fieldArray_[i].name;
+            std::transform(fieldName.begin(),
+                           fieldName.end(),
+                           fieldName.begin(),
+                           [](unsigned char c) { return tolower(c); });
+            (*fieldsMapPtr_)[fieldName] = i;
+        }
+    }
+
     const std::shared_ptr<MYSQL_RES> result_;
     const Result::SizeType rowsNumber_;
     const MYSQL_FIELD *fieldArray_;
@@ -91,6 +148,7 @@ class MysqlResultImpl : public ResultImpl
     std::shared_ptr<std::unordered_map<std::string, RowSizeType>> fieldsMapPtr_;
     std::shared_ptr<std::vector<std::pair<char **, std::vector<unsigned long>>>>
         rowsPtr_;
+    std::shared_ptr<MysqlStatementRows> statementRows_;
 };
 
 }  // namespace orm
@@ -29,6 +29,7 @@ namespace drogon
 namespace orm
 {
 static const unsigned int maxBatchCount = 256;
+static const unsigned int maxUnflushedCount = 32;
 
 Result makeResult(std::shared_ptr<PGresult> &&r = nullptr)
 {
@@ -79,13 +80,15 @@ int PgConnection::flush()
 
 PgConnection::PgConnection(trantor::EventLoop *loop,
                            const std::string &connInfo,
-                           bool autoBatch)
+                           bool autoBatch,
+                           bool binaryResults)
     : DbConnection(loop),
       autoBatch_(autoBatch),
       connectionPtr_(
           std::shared_ptr<PGconn>(PQconnectStart(connInfo.c_str()),
                                   [](PGconn *conn) { PQfinish(conn); })),
-      channel_(loop, PQsocket(connectionPtr_.get()))
+      channel_(loop, PQsocket(connectionPtr_.get())),
+      resultFormat_(binaryResults ? 1 : 0)
 {
     if (channel_.fd() < 0)
     {
@@ -210,13 +213,12 @@ void PgConnection::pgPoll()
             if (status_ != ConnectStatus::Ok)
             {
                 status_ = ConnectStatus::Ok;
-                if (!PQenterPipelineMode(connectionPtr_.get()))
+                if (!startWarming())
                 {
-                    handleClosed();
-                    return;
+                    connectionEstablished();
+                    if (status_ != ConnectStatus::Ok)
+                        return;
                 }
-                assert(okCallback_);
-                okCallback_(shared_from_this());
             }
             if (!channel_.isReading())
                 channel_.enableReading();
@@ -303,8 +305,8 @@ void PgConnection::sendBatchedSql()
         std::string statName;
         if (cmd->preparingStatement_.empty())
         {
-            auto iter = preparedStatementsMap_.find(cmd->sql_);
-            if (iter == preparedStatementsMap_.end())
+            auto entry = statementCache_.find(cmd->sql_);
+            if (!entry)
             {
                 statName = newStmtName();
                 if (PQsendPrepare(connectionPtr_.get(),
@@ -333,10 +335,10 @@ void PgConnection::sendBatchedSql()
             }
             else
             {
-                statName = iter->second.first;
+                statName = entry->name_;
                 if (autoBatch_)
                 {
-                    cmd->isChanging_ = iter->second.second;
+                    cmd->isChanging_ = entry->isChanging_;
                 }
             }
         }
@@ -357,6 +359,12 @@ void PgConnection::sendBatchedSql()
                 sendBatchEnd_ = true;
                 batchCount_ = 0;
             }
+            if (cmd->retried_)
+            {
+                // Do not let a resent command be aborted a second time
+                sendBatchEnd_ = true;
+                batchCount_ = 0;
+            }
             ++batchCount_;
         }
         if (PQsendQueryPrepared(connectionPtr_.get(),
@@ -365,7 +373,7 @@ void PgConnection::sendBatchedSql()
                                 cmd->parameters_.data(),
                                 cmd->lengths_.data(),
                                 cmd->formats_.data(),
-                                0) == 0)
+                                resultFormat_) == 0)
         {
             isWorking_ = false;
             handleFatalError(true);
@@ -375,40 +383,28 @@ void PgConnection::sendBatchedSql()
 
         batchCommandsForWaitingResults_.push_back(std::move(cmd));
         batchSqlCommands_.pop_front();
-        if (!autoBatch_)
-        {
-            if (!sendBatchEnd())
-            {
-                return;
-            }
-        }
-        else
-        {
-            if (flush())
-            {
-                return;
-            }
-        }
-        if (autoBatch_ && sendBatchEnd_)
+        if (!autoBatch_ || sendBatchEnd_)
         {
             sendBatchEnd_ = false;
             if (!sendBatchEnd())
             {
                 return;
             }
-            if (flush())
-            {
-                return;
-            }
         }
-        else
+        // Commands queued in the same loop iteration go out in as few writes
+        // as possible, the socket is only flushed once in a while to keep
+        // the output buffer of libpq bounded.
+        if (++unflushedCount_ >= maxUnflushedCount)
         {
+            unflushedCount_ = 0;
             if (flush())
             {
                 return;
             }
         }
     }
+    unflushedCount_ = 0;
+    flush();
 }
 
 void PgConnection::handleRead()
@@ -433,6 +429,11 @@ void PgConnection::handleRead()
         // need read more data from socket;
         return;
     }
+    if (isWarming_)
+    {
+        handleWarmingRead();
+        return;
+    }
     // assert((!batchCommandsForWaitingResults_.empty() ||
     //         !batchSqlCommands_.empty()));
 
@@ -471,6 +472,10 @@ void PgConnection::handleRead()
             }
         }
         auto type = PQresultStatus(res.get());
+        if (type == PGRES_PIPELINE_ABORTED && resendAbortedCommand())
+        {
+            continue;
+        }
         if (type == PGRES_BAD_RESPONSE || type == PGRES_FATAL_ERROR ||
             type == PGRES_PIPELINE_ABORTED)
         {
@@ -493,12 +498,13 @@ void PgConnection::handleRead()
             auto &cmd = batchCommandsForWaitingResults_.front();
             if (!cmd->preparingStatement_.empty())
             {
-                auto r = preparedStatements_.insert(
-                    std::string{cmd->sql_.data(), cmd->sql_.length()});
-                preparedStatementsMap_[std::string_view{r.first->c_str(),
-                                                        r.first->length()}] = {
-                    std::move(cmd->preparingStatement_), cmd->isChanging_};
+                statementCache_.insert(cmd->sql_,
+                                       std::move(cmd->preparingStatement_),
+                                       cmd->isChanging_,
+                                       evictedStatements_);
                 cmd->preparingStatement_.clear();
+                if (!evictedStatements_.empty())
+                    sendDeallocations();
                 continue;
             }
             auto r = makeResult(std::move(res));
@@ -511,17 +517,138 @@ void PgConnection::handleRead()
         auto &cmd = batchSqlCommands_.front();
         if (!cmd->preparingStatement_.empty())
         {
-            auto r = preparedStatements_.insert(
-                std::string{cmd->sql_.data(), cmd->sql_.length()});
-            preparedStatementsMap_[std::string_view{r.first->c_str(),
-                                                    r.first->length()}] = {
-                std::move(cmd->preparingStatement_), cmd->isChanging_};
+            statementCache_.insert(cmd->sql_,
+                                   std::move(cmd->preparingStatement_),
+                                   cmd->isChanging_,
+                                   evictedStatements_);
             cmd->preparingStatement_.clear();
+            if (!evictedStatements_.empty())
+                sendDeallocations();
             continue;
         }
     }
 }
 
+bool PgConnection::resendAbortedCommand()
+{
+    // In the auto-batch mode, a failed command aborts the commands that
+    // share its synchronization point. Read-only commands that were aborted
+    // never ran, so they are sent again with their own synchronization point
+    // instead of failing for an error that isn't theirs.
+    if (!autoBatch_ || batchCommandsForWaitingResults_.empty())
+        return false;
+    auto &cmd = batchCommandsForWaitingResults_.front();
+    if (cmd->isChanging_ || cmd->retried_ || !cmd->preparingStatement_.empty())
+        return false;
+    cmd->retried_ = true;
+    batchSqlCommands_.push_back(std::move(cmd));
+    batchCommandsForWaitingResults_.pop_front();
+    if (batchSqlCommands_.size() == 1 && !channel_.isWriting())
+    {
+        loop_->queueInLoop(
+            [thisPtr = shared_from_this()]() { thisPtr->sendBatchedSql(); });
+    }
+    return true;
+}
+
+void PgConnection::sendDeallocations()
+{
+    // The DEALLOCATE commands follow every command that may still use the
+    // evicted statements in the pipeline, their results are ignored.
+    for (auto &name : evictedStatements_)
+    {
+        auto query = "DEALLOCATE \"" + name + "\"";
+        if (PQsendQueryParams(connectionPtr_.get(),
+                              query.c_str(),
+                              0,
+                              nullptr,
+                              nullptr,
+                              nullptr,
+                              nullptr,
+                              0) == 0)
+        {
+            evictedStatements_.clear();
+            isWorking_ = false;
+            handleFatalError(true);
+            handleClosed();
+            return;
+        }
+        auto cmd = std::make_shared<SqlCmd>(
+            std::string_view{},
+            0,
+            std::vector<const char *>{},
+            std::vector<int>{},
+            std::vector<int>{},
+            [](const Result &) {},
+            [](const std::exception_ptr &) {});
+        cmd->isChanging_ = true;
+        batchCommandsForWaitingResults_.push_back(std::move(cmd));
+    }
+    evictedStatements_.clear();
+    isWorking_ = true;
+    if (!sendBatchEnd())
+    {
+        return;
+    }
+    flush();
+}
+
+bool PgConnection::startWarming()
+{
+    // The statements are prepared with a simple query before the connection
+    // enters the pipeline mode.
+    auto query =
+        statementCache_.startWarming([this]() { return newStmtName(); });
+    if (query.empty())
+        return false;
+    if (PQsendQuery(connectionPtr_.get(), query.c_str()) == 0)
+    {
+        LOG_ERROR << "send query error: "
+                  << PQerrorMessage(connectionPtr_.get());
+        statementCache_.finishWarming(false);
+        return false;
+    }
+    isWarming_ = true;
+    flush();
+    return true;
+}
+
+void PgConnection::handleWarmingRead()
+{
+    while (!PQisBusy(connectionPtr_.get()))
+    {
+        std::shared_ptr<PGresult> res(PQgetResult(connectionPtr_.get()),
+                                      [](PGresult *p) { PQclear(p); });
+        if (!res)
+        {
+            if (warmingFailed_)
+            {
+                // The statements are prepared on demand instead
+                LOG_WARN << "Failed to prepare the most used statements";
+            }
+            isWarming_ = false;
+            statementCache_.finishWarming(!warmingFailed_, checkSql);
+            connectionEstablished();
+            return;
+        }
+        if (PQresultStatus(res.get()) != PGRES_COMMAND_OK)
+        {
+            warmingFailed_ = true;
+        }
+    }
+}
+
+void PgConnection::connectionEstablished()
+{
+    if (!PQenterPipelineMode(connectionPtr_.get()))
+    {
+        handleClosed();
+        return;
+    }
+    assert(okCallback_);
+    okCallback_(shared_from_this());
+}
+
 void PgConnection::doAfterPreparing()
 {
 }
@@ -584,6 +711,16 @@ void PgConnection::handleFatalError(bool clearAll, bool isAbortPipeline)
 void PgConnection::batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands)
 {
     loop_->assertInLoopThread();
-    batchSqlCommands_ = std::move(sqlCommands);
+    if (batchSqlCommands_.empty())
+    {
+        batchSqlCommands_ = std::move(sqlCommands);
+    }
+    else
+    {
+        for (auto &cmd : sqlCommands)
+        {
+            batchSqlCommands_.push_back(std::move(cmd));
+        }
+    }
     sendBatchedSql();
 }
@@ -58,12 +58,14 @@ int PgConnection::flush()
 
 PgConnection::PgConnection(trantor::EventLoop *loop,
                            const std::string &connInfo,
-                           bool)
+                           bool,
+                           bool binaryResults)
     : DbConnection(loop),
       connectionPtr_(
           std::shared_ptr<PGconn>(PQconnectStart(connInfo.c_str()),
                                   [](PGconn *conn) { PQfinish(conn); })),
-      channel_(loop, PQsocket(connectionPtr_.get()))
+      channel_(loop, PQsocket(connectionPtr_.get())),
+      resultFormat_(binaryResults ? 1 : 0)
 {
     if (channel_.fd() < 0)
     {
@@ -197,8 +199,10 @@ void PgConnection::pgPoll()
             if (status_ != ConnectStatus::Ok)
             {
                 status_ = ConnectStatus::Ok;
-                assert(okCallback_);
-                okCallback_(shared_from_this());
+                if (!startWarming())
+                {
+                    connectionEstablished();
+                }
             }
             if (!channel_.isReading())
                 channel_.enableReading();
@@ -245,7 +249,18 @@ void PgConnection::execSqlInLoop(
     if (paraNum == 0)
     {
         isPreparingStatement_ = false;
-        if (PQsendQuery(connectionPtr_.get(), sql_.data()) == 0)
+        // PQsendQuery() always returns text results, PQsendQueryParams()
+        // doesn't accept several statements in one string.
+        if ((resultFormat_ == 0
+                 ? PQsendQuery(connectionPtr_.get(), sql_.data())
+                 : PQsendQueryParams(connectionPtr_.get(),
+                                     sql_.data(),
+                                     0,
+                                     nullptr,
+                                     nullptr,
+                                     nullptr,
+                                     nullptr,
+                                     resultFormat_)) == 0)
         {
             LOG_ERROR << "send query error: "
                       << PQerrorMessage(connectionPtr_.get());
@@ -263,17 +278,17 @@ void PgConnection::execSqlInLoop(
     }
     else
     {
-        auto iter = preparedStatementsMap_.find(sql_);
-        if (iter != preparedStatementsMap_.end())
+        auto entry = statementCache_.find(sql_);
+        if (entry)
         {
             isPreparingStatement_ = false;
             if (PQsendQueryPrepared(connectionPtr_.get(),
-                                    iter->second.c_str(),
+                                    entry->name_.c_str(),
                                     static_cast<int>(paraNum),
                                     parameters.data(),
                                     length.data(),
                                     format.data(),
-                                    0) == 0)
+                                    resultFormat_) == 0)
             {
                 LOG_ERROR << "send query error: "
                           << PQerrorMessage(connectionPtr_.get());
@@ -341,6 +356,11 @@ void PgConnection::handleRead()
         // need read more data from socket;
         return;
     }
+    if (isWarming_)
+    {
+        handleWarmingRead();
+        return;
+    }
     while ((res = std::shared_ptr<PGresult>(PQgetResult(connectionPtr_.get()),
                                             [](PGresult *p) { PQclear(p); })))
     {
@@ -356,7 +376,7 @@ void PgConnection::handleRead()
         }
         else
         {
-            if (isWorking_)
+            if (isWorking_ && !isDeallocating_)
             {
                 if (!isPreparingStatement_)
                 {
@@ -374,10 +394,32 @@ void PgConnection::handleRead()
         {
             doAfterPreparing();
         }
+        else if (!isDeallocating_ && !evictedStatements_.empty())
+        {
+            // Deallocate the evicted statements before taking a new command
+            std::string query;
+            for (auto &name : evictedStatements_)
+            {
+                query.append("DEALLOCATE \"").append(name).append("\";");
+            }
+            evictedStatements_.clear();
+            isDeallocating_ = true;
+            if (PQsendQuery(connectionPtr_.get(), query.c_str()) == 0)
+            {
+                LOG_ERROR << "send query error: "
+                          << PQerrorMessage(connectionPtr_.get());
+                isWorking_ = false;
+                isDeallocating_ = false;
+                idleCb_();
+                return;
+            }
+            flush();
+        }
         else
         {
             isWorking_ = false;
             isPreparingStatement_ = false;
+            isDeallocating_ = false;
             idleCb_();
         }
     }
@@ -395,17 +437,14 @@ void PgConnection::handleRead()
 void PgConnection::doAfterPreparing()
 {
     isPreparingStatement_ = false;
-    auto r = preparedStatements_.insert(std::string{sql_});
-    preparedStatementsMap_[std::string_view{r.first->data(),
-                                            r.first->length()}] =
-        statementName_;
+    statementCache_.insert(sql_, statementName_, false, evictedStatements_);
     if (PQsendQueryPrepared(connectionPtr_.get(),
                             statementName_.c_str(),
                             parametersNumber_,
                             parameters_.data(),
                             lengths_.data(),
                             formats_.data(),
-                            0) == 0)
+                            resultFormat_) == 0)
     {
         LOG_ERROR << "send query error: "
                   << PQerrorMessage(connectionPtr_.get());
@@ -421,6 +460,55 @@ void PgConnection::doAfterPreparing()
     flush();
 }
 
+bool PgConnection::startWarming()
+{
+    auto query =
+        statementCache_.startWarming([this]() { return newStmtName(); });
+    if (query.empty())
+        return false;
+    if (PQsendQuery(connectionPtr_.get(), query.c_str()) == 0)
+    {
+        LOG_ERROR << "send query error: "
+                  << PQerrorMessage(connectionPtr_.get());
+        statementCache_.finishWarming(false);
+        return false;
+    }
+    isWarming_ = true;
+    flush();
+    return true;
+}
+
+void PgConnection::handleWarmingRead()
+{
+    while (!PQisBusy(connectionPtr_.get()))
+    {
+        std::shared_ptr<PGresult> res(PQgetResult(connectionPtr_.get()),
+                                      [](PGresult *p) { PQclear(p); });
+        if (!res)
+        {
+            if (warmingFailed_)
+            {
+                // The statements are prepared on demand instead
+                LOG_WARN << "Failed to prepare the most used statements";
+            }
+            isWarming_ = false;
+            statementCache_.finishWarming(!warmingFailed_);
+            connectionEstablished();
+            return;
+        }
+        if (PQresultStatus(res.get()) != PGRES_COMMAND_OK)
+        {
+            warmingFailed_ = true;
+        }
+    }
+}
+
+void PgConnection::connectionEstablished()
+{
+    assert(okCallback_);
+    okCallback_(shared_from_this());
+}
+
 void PgConnection::handleFatalError()
 {
     if (exceptionCallback_)
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "../DbConnection.h"
+#include "PgStatementCache.h"
 #include <drogon/orm/DbClient.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/Channel.h>
@@ -26,7 +27,6 @@
 #include <functional>
 #include <iostream>
 #include <list>
-#include <set>
 
 namespace drogon
 {
@@ -43,7 +43,8 @@ class PgConnection : public DbConnection,
         std::function<void(const std::string &, const std::string &)>;
     PgConnection(trantor::EventLoop *loop,
                  const std::string &connInfo,
-                 bool autoBatch);
+                 bool autoBatch,
+                 bool binaryResults = false);
 
     void init() override;
 
@@ -93,6 +94,16 @@ class PgConnection : public DbConnection,
 
     void disconnect() override;
 
+#if LIBPQ_SUPPORTS_BATCH_MODE
+    // Every command has its own synchronization point unless it is auto
+    // batched, so a failed command in a transaction does not keep the
+    // commands after it, the COMMIT included, from running.
+    bool supportsPipelining() const override
+    {
+        return !autoBatch_;
+    }
+#endif
+
     const std::shared_ptr<PGconn> &pgConn() const
     {
         return connectionPtr_;
@@ -103,11 +114,25 @@ class PgConnection : public DbConnection,
         messageCallback_ = std::move(cb);
     }
 
+    /**
+     * @brief Bound the number of prepared statements of the connection and
+     * prepare the most used statements of the client when it is established,
+     * must be called before init().
+     */
+    void setStatementCache(size_t capacity,
+                           size_t warmCount,
+                           std::shared_ptr<PgStatementStats> stats)
+    {
+        statementCache_.setOptions(capacity, warmCount, std::move(stats));
+    }
+
   private:
     std::shared_ptr<PGconn> connectionPtr_;
     trantor::Channel channel_;
     bool isPreparingStatement_{false};
     size_t preparedStatementsID_{0};
+    // The result format passed to PQsendQueryPrepared, 1 for binary results
+    int resultFormat_{0};
 
     std::string newStmtName()
     {
@@ -135,7 +160,14 @@ class PgConnection : public DbConnection,
     std::vector<int> formats_;
     int flush();
     void handleFatalError();
-    std::set<std::string> preparedStatements_;
+    PgStatementCache statementCache_;
+    // The evicted statements waiting for DEALLOCATE
+    std::vector<std::string> evictedStatements_;
+    bool isWarming_{false};
+    bool warmingFailed_{false};
+    bool startWarming();
+    void handleWarmingRead();
+    void connectionEstablished();
     std::string_view sql_;
 #if LIBPQ_SUPPORTS_BATCH_MODE
     void handleFatalError(bool clearAll, bool isAbortPipeline = false);
@@ -146,10 +178,11 @@ class PgConnection : public DbConnection,
     bool sendBatchEnd_{false};
     bool autoBatch_{false};
     unsigned int batchCount_{0};
-    std::unordered_map<std::string_view, std::pair<std::string, bool>>
-        preparedStatementsMap_;
+    unsigned int unflushedCount_{0};
+    bool resendAbortedCommand();
+    void sendDeallocations();
 #else
-    std::unordered_map<std::string_view, std::string> preparedStatementsMap_;
+    bool isDeallocating_{false};
 #endif
 
     MessageCallback messageCallback_;
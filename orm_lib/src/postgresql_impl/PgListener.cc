@@ -14,12 +14,14 @@
 
 #include "PgListener.h"
 #include "PgConnection.h"
+#include <algorithm>
 
 using namespace drogon;
 using namespace drogon::orm;
 
 #define MAX_UNLISTEN_RETRY 3
 #define MAX_LISTEN_RETRY 10
+#define MAX_CHANNELS_PER_QUERY 100
 
 PgListener::PgListener(std::string connInfo, trantor::EventLoop *loop)
     : connectionInfo_(std::move(connInfo)), loop_(loop)
@@ -59,51 +61,95 @@ void PgListener::listen(
     const std::string &channel,
     std::function<void(std::string, std::string)> messageCallback) noexcept
 {
-    if (loop_->isInLoopThread())
-    {
-        listenChannels_[channel].push_back(std::move(messageCallback));
-        listenInLoop(channel, true);
-    }
-    else
-    {
-        std::weak_ptr<PgListener> weakThis = shared_from_this();
-        loop_->queueInLoop(
-            [weakThis, channel, cb = std::move(messageCallback)]() mutable {
-                auto thisPtr = weakThis.lock();
-                if (!thisPtr)
+    subscribe(channel, 0, nullptr, std::move(messageCallback));
+}
+
+void PgListener::unlisten(const std::string &channel) noexcept
+{
+    unsubscribe(channel, 0);
+}
+
+void PgListener::subscribe(const std::string &channel,
+                           size_t owner,
+                           trantor::EventLoop *loop,
+                           MessageCallback messageCallback) noexcept
+{
+    Subscriber subscriber{owner,
+                          loop,
+                          std::make_shared<MessageCallback>(
+                              std::move(messageCallback))};
+    runInLoop([channel, subscriber = std::move(subscriber)](
+                  PgListener &listener) mutable {
+        listener.subscribeInLoop(channel, std::move(subscriber));
+    });
+}
+
+void PgListener::unsubscribe(const std::string &channel, size_t owner) noexcept
+{
+    runInLoop([channel, owner](PgListener &listener) {
+        listener.unsubscribeInLoop(channel, owner);
+    });
+}
+
+void PgListener::unsubscribeAll(size_t owner) noexcept
+{
+    runInLoop([owner](PgListener &listener) {
+        std::vector<std::string> channels;
+        for (auto &item : listener.listenChannels_)
+        {
+            for (auto &subscriber : item.second)
+            {
+                if (subscriber.owner_ == owner)
                 {
-                    return;
+                    channels.push_back(item.first);
+                    break;
                 }
-                thisPtr->listenChannels_[channel].push_back(std::move(cb));
-                thisPtr->listenInLoop(channel, true);
-            });
+            }
+        }
+        for (auto &channel : channels)
+        {
+            listener.unsubscribeInLoop(channel, owner);
+        }
+    });
+}
+
+void PgListener::subscribeInLoop(const std::string &channel,
+                                 Subscriber subscriber)
+{
+    loop_->assertInLoopThread();
+    auto &subscribers = listenChannels_[channel];
+    subscribers.push_back(std::move(subscriber));
+    // The channel is listened to once, whatever its number of subscribers
+    if (subscribers.size() == 1)
+    {
+        listenInLoop({channel}, true);
     }
 }
 
-void PgListener::unlisten(const std::string &channel) noexcept
+void PgListener::unsubscribeInLoop(const std::string &channel, size_t owner)
 {
-    if (loop_->isInLoopThread())
+    loop_->assertInLoopThread();
+    auto iter = listenChannels_.find(channel);
+    if (iter == listenChannels_.end())
     {
-        listenChannels_.erase(channel);
-        listenInLoop(channel, false);
+        return;
     }
-    else
+    auto &subscribers = iter->second;
+    subscribers.erase(std::remove_if(subscribers.begin(),
+                                     subscribers.end(),
+                                     [owner](const Subscriber &subscriber) {
+                                         return subscriber.owner_ == owner;
+                                     }),
+                      subscribers.end());
+    if (subscribers.empty())
     {
-        std::weak_ptr<PgListener> weakThis = shared_from_this();
-        loop_->queueInLoop([weakThis, channel]() {
-            auto thisPtr = weakThis.lock();
-            if (!thisPtr)
-            {
-                return;
-            }
-            thisPtr->listenChannels_.erase(channel);
-            thisPtr->listenInLoop(channel, false);
-        });
+        listenChannels_.erase(iter);
+        listenInLoop({channel}, false);
     }
 }
 
 void PgListener::onMessage(const std::string &channel,
-                           const std::string &message) const noexcept
+                           const std::string &message) noexcept
 {
     loop_->assertInLoopThread();
 
@@ -112,10 +158,51 @@ void PgListener::onMessage(const std::string &channel,
     {
         return;
     }
-    for (auto &cb : iter->second)
+    // The callbacks may unlisten the channel
+    auto subscribers = iter->second;
+    for (auto &subscriber : subscribers)
+    {
+        if (!subscriber.loop_ || subscriber.loop_ == loop_)
+        {
+            (*subscriber.callback_)(channel, message);
+            continue;
+        }
+        deliveries_[subscriber.loop_].push_back(
+            {subscriber.callback_, channel, message});
+    }
+    if (!deliveries_.empty() && !flushQueued_)
+    {
+        // The messages of the current read are delivered together
+        flushQueued_ = true;
+        std::weak_ptr<PgListener> weakThis = shared_from_this();
+        loop_->queueInLoop([weakThis]() {
+            auto thisPtr = weakThis.lock();
+            if (thisPtr)
+            {
+                thisPtr->flushDeliveries();
+            }
+        });
+    }
+}
+
+void PgListener::flushDeliveries()
+{
+    loop_->assertInLoopThread();
+    flushQueued_ = false;
+    for (auto &item : deliveries_)
     {
-        cb(channel, message);
+        item.first->queueInLoop([deliveries = std::move(item.second)]() {
+            for (auto &delivery : deliveries)
+            {
+                auto callback = delivery.callback_.lock();
+                if (callback)
+                {
+                    (*callback)(delivery.channel_, delivery.message_);
+                }
+            }
+        });
     }
+    deliveries_.clear();
 }
 
 void PgListener::listenAll() noexcept
@@ -138,34 +225,55 @@ void PgListener::listenNext() noexcept
     {
         return;
     }
-    auto [listen, channel] = listenTasks_.front();
-    listenTasks_.pop_front();
-    listenInLoop(channel, listen);
+    // The consecutive tasks of the same kind share a query, so thousands of
+    // channels are listened to again quickly after a reconnection
+    bool listen = listenTasks_.front().first;
+    std::vector<std::string> channels;
+    while (!listenTasks_.empty() && listenTasks_.front().first == listen &&
+           channels.size() < MAX_CHANNELS_PER_QUERY)
+    {
+        channels.push_back(std::move(listenTasks_.front().second));
+        listenTasks_.pop_front();
+    }
+    listenInLoop(std::move(channels), listen);
 }
 
-void PgListener::listenInLoop(const std::string &channel,
+void PgListener::listenInLoop(std::vector<std::string> channels,
                               bool listen,
                               std::shared_ptr<unsigned int> retryCnt)
 {
     loop_->assertInLoopThread();
     if (!retryCnt)
         retryCnt = std::make_shared<unsigned int>(0);
+    auto name = channels.size() == 1
+                    ? "channel " + channels.front()
+                    : std::to_string(channels.size()) + " channels";
     if (conn_ && !conn_->isWorking())
     {
         auto pgConn = std::dynamic_pointer_cast<PgConnection>(conn_);
-        std::string escapedChannel =
-            escapeIdentifier(pgConn, channel.c_str(), channel.size());
-        if (escapedChannel.empty())
+        // Because DbConnection::execSql() takes std::string_view as parameter,
+        // sql must be hold until query finish.
+        auto sql = std::make_shared<std::string>();
+        for (auto &channel : channels)
+        {
+            std::string escapedChannel =
+                escapeIdentifier(pgConn, channel.c_str(), channel.size());
+            if (escapedChannel.empty())
+            {
+                LOG_ERROR << "Failed to escape pg identifier, stop listen "
+                          << channel;
+                // TODO: report
+                continue;
+            }
+            sql->append(listen ? "LISTEN " : "UNLISTEN ")
+                .append(escapedChannel)
+                .append(";");
+        }
+        if (sql->empty())
         {
-            LOG_ERROR << "Failed to escape pg identifier, stop listen";
-            // TODO: report
+            listenNext();
             return;
         }
-
-        // Because DbConnection::execSql() takes std::string_view as parameter,
-        // sql must be hold until query finish.
-        auto sql = std::make_shared<std::string>(
-            (listen ? "LISTEN " : "UNLISTEN ") + escapedChannel);
         std::weak_ptr<PgListener> weakThis = shared_from_this();
         conn_->execSql(
             *sql,
@@ -173,18 +281,23 @@ void PgListener::listenInLoop(const std::string &channel,
             {},
             {},
             {},
-            [listen, channel, sql](const Result &r) {
+            [listen, name, sql](const Result &r) {
                 if (listen)
                 {
-                    LOG_TRACE << "Listen channel " << channel;
+                    LOG_TRACE << "Listen " << name;
                 }
                 else
                 {
-                    LOG_TRACE << "Unlisten channel " << channel;
+                    LOG_TRACE << "Unlisten " << name;
                 }
             },
-            [listen, channel, weakThis, sql, retryCnt, loop = loop_](
-                const std::exception_ptr &exception) {
+            [listen,
+             channels = std::move(channels),
+             name,
+             weakThis,
+             sql,
+             retryCnt,
+             loop = loop_](const std::exception_ptr &exception) {
                 try
                 {
                     std::rethrow_exception(exception);
@@ -194,11 +307,11 @@ void PgListener::listenInLoop(const std::string &channel,
                     ++(*retryCnt);
                     if (listen)
                     {
-                        LOG_ERROR << "Failed to listen channel " << channel
+                        LOG_ERROR << "Failed to listen " << name
                                   << ", error: " << ex.base().what();
                         if (*retryCnt > MAX_LISTEN_RETRY)
                         {
-                            LOG_ERROR << "Failed to listen channel " << channel
+                            LOG_ERROR << "Failed to listen " << name
                                       << " after max attempt. Stop trying.";
                             // TODO: report
                             return;
@@ -206,12 +319,11 @@ void PgListener::listenInLoop(const std::string &channel,
                     }
                     else
                     {
-                        LOG_ERROR << "Failed to unlisten channel " << channel
+                        LOG_ERROR << "Failed to unlisten " << name
                                   << ", error: " << ex.base().what();
                         if (*retryCnt > MAX_UNLISTEN_RETRY)
                         {
-                            LOG_ERROR << "Failed to unlisten channel "
-                                      << channel
+                            LOG_ERROR << "Failed to unlisten " << name
                                       << " after max attempt. Stop trying.";
                             // TODO: report?
                             return;
@@ -222,7 +334,7 @@ void PgListener::listenInLoop(const std::string &channel,
                         auto thisPtr = weakThis.lock();
                         if (thisPtr)
                         {
-                            thisPtr->listenInLoop(channel, listen, retryCnt);
+                            thisPtr->listenInLoop(channels, listen, retryCnt);
                         }
                     });
                 }
@@ -230,16 +342,18 @@ void PgListener::listenInLoop(const std::string &channel,
         return;
     }
 
-    if (listenTasks_.size() > 20000)
+    if (listenTasks_.size() + channels.size() > 20000)
     {
-        LOG_WARN << "Too many queries in listen buffer. Stop listen channel "
-                 << channel;
+        LOG_WARN << "Too many queries in listen buffer. Stop listen " << name;
         // TODO: report
         return;
     }
 
-    LOG_TRACE << "Add to task queue, channel " << channel;
-    listenTasks_.emplace_back(listen, channel);
+    LOG_TRACE << "Add to task queue, " << name;
+    for (auto &channel : channels)
+    {
+        listenTasks_.emplace_back(listen, std::move(channel));
+    }
 }
 
 PgConnectionPtr PgListener::newConnection(
@@ -16,10 +16,12 @@
 
 #include <drogon/orm/DbListener.h>
 #include <trantor/net/EventLoopThread.h>
+#include <atomic>
 #include <deque>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "./PgConnection.h"
 
 namespace drogon
@@ -43,14 +45,54 @@ class PgListener : public DbListener,
                 MessageCallback messageCallback) noexcept override;
     void unlisten(const std::string &channel) noexcept override;
 
+    /// Returns a new owner of subscriptions, see subscribe()
+    size_t newOwner() noexcept
+    {
+        return ++lastOwner_;
+    }
+
+    /**
+     * @brief Subscribe to a channel, the channel is listened to while it has
+     * subscribers.
+     *
+     * @param owner The owner of the subscription, 0 for the listen() calls.
+     * @param loop The loop to run the callback in, the messages received in
+     * one read are delivered to it at once. If empty, the callback runs in
+     * the loop of the listener.
+     */
+    void subscribe(const std::string &channel,
+                   size_t owner,
+                   trantor::EventLoop *loop,
+                   MessageCallback messageCallback) noexcept;
+    /// Cancel the subscriptions of an owner to a channel
+    void unsubscribe(const std::string &channel, size_t owner) noexcept;
+    /// Cancel all the subscriptions of an owner
+    void unsubscribeAll(size_t owner) noexcept;
+
     // methods below should be called in loop
 
     void onMessage(const std::string &channel,
-                   const std::string &message) const noexcept;
+                   const std::string &message) noexcept;
     void listenAll() noexcept;
     void listenNext() noexcept;
 
   private:
+    struct Subscriber
+    {
+        size_t owner_;
+        trantor::EventLoop *loop_;
+        std::shared_ptr<MessageCallback> callback_;
+    };
+
+    // A message to deliver in the loop of a subscriber, skipped if the
+    // subscriber is gone by then
+    struct Delivery
+    {
+        std::weak_ptr<MessageCallback> callback_;
+        std::string channel_;
+        std::string message_;
+    };
+
     /// Escapes a string for use as an SQL identifier, such as a table, column,
     /// or function name. This is useful when a user-supplied identifier might
     /// contain special characters that would otherwise not be interpreted as
@@ -71,9 +113,32 @@ class PgListener : public DbListener,
                                         const char *str,
                                         size_t length);
 
-    void listenInLoop(const std::string &channel,
+    template <typename Func>
+    void runInLoop(Func &&func)
+    {
+        if (loop_->isInLoopThread())
+        {
+            func(*this);
+            return;
+        }
+        std::weak_ptr<PgListener> weakThis = shared_from_this();
+        loop_->queueInLoop(
+            [weakThis, func = std::forward<Func>(func)]() mutable {
+                auto thisPtr = weakThis.lock();
+                if (thisPtr)
+                {
+                    func(*thisPtr);
+                }
+            });
+    }
+
+    // The channels are listened to, or unlistened, in a single query
+    void listenInLoop(std::vector<std::string> channels,
                       bool listen,
                       std::shared_ptr<unsigned int> = nullptr);
+    void subscribeInLoop(const std::string &channel, Subscriber subscriber);
+    void unsubscribeInLoop(const std::string &channel, size_t owner);
+    void flushDeliveries();
 
     PgConnectionPtr newConnection(std::shared_ptr<unsigned int> = nullptr);
 
@@ -83,8 +148,48 @@ class PgListener : public DbListener,
     DbConnectionPtr connHolder_;
     DbConnectionPtr conn_;
     std::deque<std::pair<bool, std::string>> listenTasks_;
-    std::unordered_map<std::string, std::vector<MessageCallback>>
-        listenChannels_;
+    std::unordered_map<std::string, std::vector<Subscriber>> listenChannels_;
+    std::atomic<size_t> lastOwner_{0};
+    std::unordered_map<trantor::EventLoop *, std::vector<Delivery>>
+        deliveries_;
+    bool flushQueued_{false};
+};
+
+/**
+ * @brief A subscriber of a listener shared by the users of a database, see
+ * DbListener::sharedPgListener(). Its callbacks run in the loops that call
+ * listen() and unlisten() only cancels its own callbacks.
+ */
+class PgSharedListener : public DbListener
+{
+  public:
+    explicit PgSharedListener(std::shared_ptr<PgListener> hub)
+        : hub_(std::move(hub)), owner_(hub_->newOwner())
+    {
+    }
+
+    ~PgSharedListener() override
+    {
+        hub_->unsubscribeAll(owner_);
+    }
+
+    void listen(const std::string &channel,
+                MessageCallback messageCallback) noexcept override
+    {
+        hub_->subscribe(channel,
+                        owner_,
+                        trantor::EventLoop::getEventLoopOfCurrentThread(),
+                        std::move(messageCallback));
+    }
+
+    void unlisten(const std::string &channel) noexcept override
+    {
+        hub_->unsubscribe(channel, owner_);
+    }
+
+  private:
+    std::shared_ptr<PgListener> hub_;
+    const size_t owner_;
 };
 
 }  // namespace orm
@@ -0,0 +1,167 @@
+/**
+ *
+ *  PgStatementCache.cc
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "PgStatementCache.h"
+#include "../../../lib/src/BuiltinMetrics.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace drogon;
+using namespace drogon::orm;
+
+// Bounds the memory of the usage counts when the SQL is dynamic
+static constexpr size_t kMaxTrackedStatements{1024};
+// A hit is reported to the client statistics once every kUsesPerRecord hits
+static constexpr uint64_t kUsesPerRecord{64};
+
+void PgStatementStats::record(std::string_view sql, uint64_t uses)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = counts_.find(std::string{sql});
+    if (iter != counts_.end())
+    {
+        iter->second += uses;
+        return;
+    }
+    while (counts_.size() >= kMaxTrackedStatements)
+    {
+        // Age the counts so that statements that are no longer used fade out
+        for (auto it = counts_.begin(); it != counts_.end();)
+        {
+            it->second /= 2;
+            if (it->second == 0)
+                it = counts_.erase(it);
+            else
+                ++it;
+        }
+    }
+    counts_.emplace(std::string{sql}, uses);
+}
+
+std::vector<std::string> PgStatementStats::top(size_t count) const
+{
+    std::vector<std::pair<uint64_t, const std::string *>> sorted;
+    std::vector<std::string> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    sorted.reserve(counts_.size());
+    for (auto &item : counts_)
+    {
+        sorted.emplace_back(item.second, &item.first);
+    }
+    count = (std::min)(count, sorted.size());
+    std::partial_sort(sorted.begin(),
+                      sorted.begin() + count,
+                      sorted.end(),
+                      [](const auto &a, const auto &b) {
+                          return a.first > b.first;
+                      });
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        result.push_back(*sorted[i].second);
+    }
+    return result;
+}
+
+const PgStatementCache::Entry *PgStatementCache::find(std::string_view sql)
+{
+    auto iter = map_.find(sql);
+    if (iter == map_.end())
+    {
+        BuiltinMetrics::instance().statementCache(
+            BuiltinMetrics::StatementCacheEvent::kMiss);
+        return nullptr;
+    }
+    BuiltinMetrics::instance().statementCache(
+        BuiltinMetrics::StatementCacheEvent::kHit);
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    auto &entry = iter->second->second;
+    if (stats_ && ++entry.uses_ % kUsesPerRecord == 0)
+    {
+        stats_->record(sql, kUsesPerRecord);
+    }
+    return &entry;
+}
+
+void PgStatementCache::insert(std::string_view sql,
+                              std::string name,
+                              bool isChanging,
+                              std::vector<std::string> &evicted)
+{
+    auto iter = map_.find(sql);
+    if (iter != map_.end())
+    {
+        // The same SQL was prepared twice before the first one completed
+        auto &entry = iter->second->second;
+        if (entry.name_ != name)
+            evicted.push_back(std::move(entry.name_));
+        entry.name_ = std::move(name);
+        entry.isChanging_ = isChanging;
+        lru_.splice(lru_.begin(), lru_, iter->second);
+        return;
+    }
+    lru_.emplace_front(std::string{sql},
+                       Entry{std::move(name), isChanging, 1});
+    map_.emplace(std::string_view{lru_.front().first}, lru_.begin());
+    if (stats_)
+        stats_->record(sql, 1);
+    while (capacity_ > 0 && lru_.size() > capacity_)
+    {
+        auto &last = lru_.back();
+        evicted.push_back(std::move(last.second.name_));
+        map_.erase(std::string_view{last.first});
+        lru_.pop_back();
+        BuiltinMetrics::instance().statementCache(
+            BuiltinMetrics::StatementCacheEvent::kEviction);
+    }
+}
+
+std::string PgStatementCache::startWarming(
+    const std::function<std::string()> &newName)
+{
+    warming_.clear();
+    if (!stats_ || warmCount_ == 0)
+        return {};
+    auto count = warmCount_;
+    if (capacity_ > 0)
+        count = (std::min)(count, capacity_);
+    std::string query;
+    for (auto &sql : stats_->top(count))
+    {
+        auto name = newName();
+        query.append("PREPARE \"").append(name).append("\" AS ");
+        query.append(sql).append(";\n");
+        warming_.emplace_back(std::move(sql), std::move(name));
+    }
+    return query;
+}
+
+void PgStatementCache::finishWarming(
+    bool succeeded,
+    const std::function<bool(std::string_view)> &isChanging)
+{
+    if (succeeded)
+    {
+        for (auto &[sql, name] : warming_)
+        {
+            if (map_.find(sql) != map_.end())
+                continue;
+            bool changing = isChanging ? isChanging(sql) : false;
+            lru_.emplace_back(std::move(sql),
+                              Entry{std::move(name), changing, 0});
+            map_.emplace(std::string_view{lru_.back().first},
+                         std::prev(lru_.end()));
+        }
+    }
+    warming_.clear();
+}
@@ -0,0 +1,110 @@
+/**
+ *
+ *  PgStatementCache.h
+ *
+ *  Copyright 2026, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief The usage counts of the statements prepared by the connections of a
+ * client, used to prepare the most used ones on new connections.
+ */
+class PgStatementStats : public trantor::NonCopyable
+{
+  public:
+    void record(std::string_view sql, uint64_t uses);
+    std::vector<std::string> top(size_t count) const;
+
+  private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, uint64_t> counts_;
+};
+
+/**
+ * @brief The prepared statements of a connection, the least recently used
+ * one is evicted when the capacity is exceeded. Only accessed in the loop of
+ * the connection.
+ */
+class PgStatementCache : public trantor::NonCopyable
+{
+  public:
+    struct Entry
+    {
+        std::string name_;
+        bool isChanging_{false};
+        uint64_t uses_{0};
+    };
+
+    /**
+     * @param capacity The maximum number of statements, 0 means unbounded.
+     * @param warmCount The number of the most used statements prepared when
+     * the connection is established.
+     */
+    void setOptions(size_t capacity,
+                    size_t warmCount,
+                    std::shared_ptr<PgStatementStats> stats)
+    {
+        capacity_ = capacity;
+        warmCount_ = warmCount;
+        stats_ = std::move(stats);
+    }
+
+    /// Return the statement prepared for the sql, or nullptr
+    const Entry *find(std::string_view sql);
+
+    /**
+     * @brief Add a prepared statement, the names of the statements that
+     * must be deallocated are appended to the evicted parameter.
+     */
+    void insert(std::string_view sql,
+                std::string name,
+                bool isChanging,
+                std::vector<std::string> &evicted);
+
+    /**
+     * @brief Return the query preparing the most used statements of the
+     * client, or an empty string. The statements are added by
+     * finishWarming().
+     */
+    std::string startWarming(const std::function<std::string()> &newName);
+    void finishWarming(
+        bool succeeded,
+        const std::function<bool(std::string_view)> &isChanging = nullptr);
+
+  private:
+    using LruList = std::list<std::pair<std::string, Entry>>;
+    // The most recently used statement is at the front
+    LruList lru_;
+    std::unordered_map<std::string_view, LruList::iterator> map_;
+    size_t capacity_{0};
+    size_t warmCount_{0};
+    std::shared_ptr<PgStatementStats> stats_;
+    std::vector<std::pair<std::string, std::string>> warming_;
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -85,3 +85,32 @@ int PostgreSQLResultImpl::oid(RowSizeType column) const
 {
     return PQftype(result_.get(), (int)column);
 }
+
+bool PostgreSQLResultImpl::isBinary(RowSizeType column) const noexcept
+{
+    return PQfformat(result_.get(), (int)column) == 1;
+}
+
+ResultImpl::JsonType PostgreSQLResultImpl::jsonType(RowSizeType column) const
+{
+    switch (oid(column))
+    {
+        case 16:  // bool
+            return kJsonBool;
+        case 17:  // bytea
+            return kJsonBinary;
+        case 20:    // int8
+        case 21:    // int2
+        case 23:    // int4
+        case 26:    // oid
+        case 700:   // float4
+        case 701:   // float8
+        case 1700:  // numeric
+            return kJsonNumber;
+        case 114:   // json
+        case 3802:  // jsonb
+            return kJsonDocument;
+        default:
+            return kJsonString;
+    }
+}
@@ -41,6 +41,8 @@ class PostgreSQLResultImpl : public ResultImpl
     bool isNull(SizeType row, RowSizeType column) const override;
     FieldSizeType getLength(SizeType row, RowSizeType column) const override;
     int oid(RowSizeType column) const override;
+    bool isBinary(RowSizeType column) const noexcept override;
+    JsonType jsonType(RowSizeType column) const override;
 
   private:
     std::shared_ptr<PGresult> result_;
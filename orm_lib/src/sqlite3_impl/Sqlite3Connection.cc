@@ -16,6 +16,7 @@
 #include "Sqlite3ResultImpl.h"
 #include <drogon/orm/Exception.h>
 #include <drogon/utils/Utilities.h>
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -34,22 +35,18 @@ namespace
 
 std::once_flag Sqlite3Connection::once_;
 
-void Sqlite3Connection::onError(
-    const std::string_view &sql,
-    const std::function<void(const std::exception_ptr &)> &exceptCallback,
-    const int &extendedErrcode)
+std::exception_ptr Sqlite3Connection::errorOf(const std::string_view &sql,
+                                              int extendedErrcode)
 {
     int errcode = extendedErrcode & 0xFF;  // low 8 bit
 #define ORM_ERR_CASE(code, type)                                    \
     case code:                                                      \
     {                                                               \
-        auto exceptPtr = std::make_exception_ptr(                   \
+        return std::make_exception_ptr(                             \
             drogon::orm::type(sqlite3_errmsg(connectionPtr_.get()), \
                               std::string{sql},                     \
                               errcode,                              \
                               extendedErrcode));                    \
-        exceptCallback(exceptPtr);                                  \
-        return;                                                     \
     };
     switch (extendedErrcode)
     {
@@ -70,12 +67,11 @@ void Sqlite3Connection::onError(
     }
 #undef ORM_ERR_CASE
 
-    auto exceptPtr =
-        std::make_exception_ptr(SqlError(sqlite3_errmsg(connectionPtr_.get()),
-                                         std::string{sql},
-                                         errcode,
-                                         extendedErrcode));
-    exceptCallback(exceptPtr);
+    return std::make_exception_ptr(
+        SqlError(sqlite3_errmsg(connectionPtr_.get()),
+                 std::string{sql},
+                 errcode,
+                 extendedErrcode));
 }
 
 Sqlite3Connection::Sqlite3Connection(
@@ -100,6 +96,7 @@ void Sqlite3Connection::init()
     // Get the key and value
     auto connParams = parseConnString(connInfo_);
     std::string filename;
+    std::vector<std::string> pragmas;
     for (auto const &kv : connParams)
     {
         auto key = kv.first;
@@ -112,8 +109,23 @@ void Sqlite3Connection::init()
         {
             filename = value;
         }
+        else if (key == "journal_mode" || key == "busy_timeout" ||
+                 key == "query_only" || key == "synchronous")
+        {
+            if (value.empty() ||
+                !std::all_of(value.begin(), value.end(), [](char c) {
+                    return std::isalnum(static_cast<unsigned char>(c));
+                }))
+            {
+                LOG_ERROR << "Invalid value of " << key << ": " << value;
+                continue;
+            }
+            pragmas.push_back("pragma " + key + "=" + value);
+        }
     }
-    loop_->runInLoop([this, filename = std::move(filename)]() {
+    loop_->runInLoop([this,
+                      filename = std::move(filename),
+                      pragmas = std::move(pragmas)]() {
         sqlite3 *tmp = nullptr;
         auto ret = sqlite3_open(filename.data(), &tmp);
         connectionPtr_ = std::shared_ptr<sqlite3>(tmp, [](sqlite3 *ptr) {
@@ -128,6 +140,15 @@ void Sqlite3Connection::init()
         else
         {
             sqlite3_extended_result_codes(tmp, true);
+            for (auto const &pragma : pragmas)
+            {
+                if (sqlite3_exec(
+                        tmp, pragma.c_str(), nullptr, nullptr, nullptr) !=
+                    SQLITE_OK)
+                {
+                    LOG_ERROR << pragma << ": " << sqlite3_errmsg(tmp);
+                }
+            }
             status_ = ConnectStatus::Ok;
             okCallback_(thisPtr);
         }
@@ -176,6 +197,100 @@ void Sqlite3Connection::execSqlInQueue(
         exceptCallback(exceptPtr);
         return;
     }
+    std::shared_ptr<Sqlite3ResultImpl> resultPtr;
+    auto exceptPtr = runStatement(
+        sql, paraNum, parameters, length, format, resultPtr, false);
+    if (exceptPtr)
+        exceptCallback(exceptPtr);
+    else
+        rcb(Result(std::move(resultPtr)));
+    idleCb_();
+}
+
+void Sqlite3Connection::batchSql(
+    std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands)
+{
+    auto thisPtr = shared_from_this();
+    loopThread_.getLoop()->queueInLoop(
+        [thisPtr, sqlCommands = std::move(sqlCommands)]() mutable {
+            thisPtr->batchSqlInQueue(sqlCommands);
+        });
+}
+
+void Sqlite3Connection::batchSqlInQueue(
+    std::deque<std::shared_ptr<SqlCmd>> &sqlCommands)
+{
+    std::vector<std::exception_ptr> errors(sqlCommands.size());
+    std::vector<std::shared_ptr<Sqlite3ResultImpl>> results(
+        sqlCommands.size());
+    if (status_ != ConnectStatus::Ok)
+    {
+        LOG_ERROR << "Connection is not ready";
+        std::fill(errors.begin(),
+                  errors.end(),
+                  std::make_exception_ptr(drogon::orm::BrokenConnection()));
+    }
+    else
+    {
+        // All the commands are committed by one transaction, every command
+        // runs in a savepoint so that its failure doesn't abort the others.
+        auto conn = connectionPtr_.get();
+        auto exec = [this, conn](const char *sql) {
+            if (sqlite3_exec(conn, sql, nullptr, nullptr, nullptr) ==
+                SQLITE_OK)
+                return std::exception_ptr{};
+            return errorOf(sql, sqlite3_extended_errcode(conn));
+        };
+        std::unique_lock<SharedMutex> lock(*sharedMutexPtr_);
+        auto exceptPtr = exec("begin immediate");
+        for (size_t i = 0; i < sqlCommands.size() && !exceptPtr; ++i)
+        {
+            auto &cmd = *sqlCommands[i];
+            LOG_TRACE << "sql:" << cmd.sql_;
+            if ((errors[i] = exec("savepoint drogon_batch")))
+                continue;
+            errors[i] = runStatement(cmd.sql_,
+                                     cmd.parametersNumber_,
+                                     cmd.parameters_,
+                                     cmd.lengths_,
+                                     cmd.formats_,
+                                     results[i],
+                                     true);
+            if (errors[i])
+                exec("rollback to drogon_batch");
+            exec("release drogon_batch");
+        }
+        if (!exceptPtr && (exceptPtr = exec("commit")))
+            exec("rollback");
+        if (exceptPtr)
+        {
+            for (auto &error : errors)
+            {
+                if (!error)
+                    error = exceptPtr;
+            }
+        }
+    }
+    for (size_t i = 0; i < sqlCommands.size(); ++i)
+    {
+        auto &cmd = *sqlCommands[i];
+        if (errors[i])
+            cmd.exceptionCallback_(errors[i]);
+        else
+            cmd.callback_(Result(std::move(results[i])));
+    }
+    idleCb_();
+}
+
+std::exception_ptr Sqlite3Connection::runStatement(
+    const std::string_view &sql,
+    size_t paraNum,
+    const std::vector<const char *> &parameters,
+    const std::vector<int> &length,
+    const std::vector<int> &format,
+    std::shared_ptr<Sqlite3ResultImpl> &resultPtr,
+    bool writeLocked)
+{
     std::shared_ptr<sqlite3_stmt> stmtPtr;
     bool newStmt = false;
     if (paraNum > 0)
@@ -201,20 +316,15 @@ void Sqlite3Connection::execSqlInQueue(
         if (ret != SQLITE_OK || !stmtPtr)
         {
             int ext_ret = sqlite3_extended_errcode(connectionPtr_.get());
-            onError(sql, exceptCallback, ext_ret);
-            idleCb_();
-            return;
+            return errorOf(sql, ext_ret);
         }
         if (!std::all_of(remaining, sql.data() + sql.size(), [](char ch) {
                 return std::isspace(static_cast<unsigned char>(ch));
             }))
         {
-            auto exceptPtr = std::make_exception_ptr(SqlError(
+            return std::make_exception_ptr(SqlError(
                 "Multiple semicolon separated statements are unsupported",
                 std::string{sql}));
-            exceptCallback(exceptPtr);
-            idleCb_();
-            return;
         }
     }
     assert(stmtPtr);
@@ -261,15 +371,14 @@ void Sqlite3Connection::execSqlInQueue(
         if (bindRet != SQLITE_OK)
         {
             int eret = sqlite3_extended_errcode(connectionPtr_.get());
-            onError(sql, exceptCallback, eret);
+            auto exceptPtr = errorOf(sql, eret);
             sqlite3_reset(stmt);
-            idleCb_();
-            return;
+            return exceptPtr;
         }
     }
     int r, er;
     int columnNum = sqlite3_column_count(stmt);
-    auto resultPtr = std::make_shared<Sqlite3ResultImpl>();
+    resultPtr = std::make_shared<Sqlite3ResultImpl>();
     for (int i = 0; i < columnNum; ++i)
     {
         auto name = std::string(sqlite3_column_name(stmt, i));
@@ -285,7 +394,9 @@ void Sqlite3Connection::execSqlInQueue(
     if (sqlite3_stmt_readonly(stmt))
     {
         // Readonly, hold read lock;
-        std::shared_lock<SharedMutex> lock(*sharedMutexPtr_);
+        std::shared_lock<SharedMutex> lock(*sharedMutexPtr_, std::defer_lock);
+        if (!writeLocked)
+            lock.lock();
         r = stmtStep(stmt, resultPtr, columnNum);
         if (r != SQLITE_DONE)
         {
@@ -296,7 +407,9 @@ void Sqlite3Connection::execSqlInQueue(
     else
     {
         // Hold write lock
-        std::unique_lock<SharedMutex> lock(*sharedMutexPtr_);
+        std::unique_lock<SharedMutex> lock(*sharedMutexPtr_, std::defer_lock);
+        if (!writeLocked)
+            lock.lock();
         r = stmtStep(stmt, resultPtr, columnNum);
         if (r == SQLITE_DONE)
         {
@@ -313,10 +426,8 @@ void Sqlite3Connection::execSqlInQueue(
 
     if (r != SQLITE_DONE)
     {
-        onError(sql, exceptCallback, er);
-        sqlite3_reset(stmt);
-        idleCb_();
-        return;
+        resultPtr.reset();
+        return errorOf(sql, er);
     }
     if (paraNum > 0 && newStmt)
     {
@@ -324,8 +435,7 @@ void Sqlite3Connection::execSqlInQueue(
         stmtsMap_[std::string_view{r.first->data(), r.first->length()}] =
             stmtPtr;
     }
-    rcb(Result(std::move(resultPtr)));
-    idleCb_();
+    return nullptr;
 }
 
 int Sqlite3Connection::stmtStep(
@@ -55,11 +55,11 @@ class Sqlite3Connection : public DbConnection,
                  std::function<void(const std::exception_ptr &)>
                      &&exceptCallback) override;
 
-    void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&) override
-    {
-        LOG_FATAL << "The mysql library does not support batch mode";
-        exit(1);
-    }
+    /**
+     * @brief Run the commands in one transaction, a failed command is rolled
+     * back alone and doesn't prevent the others from being committed.
+     */
+    void batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands) override;
 
     void disconnect() override;
 
@@ -73,10 +73,17 @@ class Sqlite3Connection : public DbConnection,
         const std::vector<int> &format,
         const ResultCallback &rcb,
         const std::function<void(const std::exception_ptr &)> &exceptCallback);
-    void onError(
+    void batchSqlInQueue(std::deque<std::shared_ptr<SqlCmd>> &sqlCommands);
+    std::exception_ptr runStatement(
         const std::string_view &sql,
-        const std::function<void(const std::exception_ptr &)> &exceptCallback,
-        const int &extendedErrcode);
+        size_t paraNum,
+        const std::vector<const char *> &parameters,
+        const std::vector<int> &length,
+        const std::vector<int> &format,
+        std::shared_ptr<Sqlite3ResultImpl> &resultPtr,
+        bool writeLocked);
+    std::exception_ptr errorOf(const std::string_view &sql,
+                               int extendedErrcode);
     int stmtStep(sqlite3_stmt *stmt,
                  const std::shared_ptr<Sqlite3ResultImpl> &resultPtr,
                  int columnNum);
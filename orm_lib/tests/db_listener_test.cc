@@ -18,6 +18,8 @@
 #include <drogon/HttpAppFramework.h>
 #include <drogon/config.h>
 #include <drogon/orm/DbListener.h>
+#include <trantor/net/EventLoopThread.h>
+#include <atomic>
 #include <chrono>
 
 using namespace drogon;
@@ -81,6 +83,60 @@ DROGON_TEST(ListenNotifyTest)
     CHECK(numNotifications == 15);
     std::this_thread::sleep_for(1s);
 }
+
+DROGON_TEST(SharedListenNotifyTest)
+{
+    auto clientPtr = postgreClient;
+    auto first = DbListener::sharedPgListener(clientPtr->connectionInfo());
+    auto second = DbListener::sharedPgListener(clientPtr->connectionInfo());
+    MANDATE(first);
+    MANDATE(second);
+
+    static std::atomic<int> firstNotifications{0};
+    static std::atomic<int> secondNotifications{0};
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    first->listen("shared_listen_test",
+                  [](const std::string &, const std::string &) {
+                      ++firstNotifications;
+                  });
+    // The callbacks of the second subscriber run in its own loop
+    loop->runInLoop([second, loop]() {
+        second->listen("shared_listen_test",
+                       [loop](const std::string &, const std::string &) {
+                           loop->assertInLoopThread();
+                           ++secondNotifications;
+                       });
+    });
+    std::this_thread::sleep_for(1s);  // ensure listen success
+
+    auto notify = [clientPtr]() {
+        for (int i = 0; i < 5; ++i)
+        {
+            clientPtr->execSqlAsync(
+                "NOTIFY shared_listen_test, '" + std::to_string(i) + "'",
+                [](const orm::Result &) {},
+                [](const orm::DrogonDbException &ex) {
+                    LOG_ERROR << "Failed to notify " << ex.base().what();
+                });
+        }
+    };
+    notify();
+    std::this_thread::sleep_for(2s);
+    CHECK(firstNotifications == 5);
+    CHECK(secondNotifications == 5);
+
+    // Only the callbacks of the first subscriber are cancelled
+    first->unlisten("shared_listen_test");
+    std::this_thread::sleep_for(1s);
+    notify();
+    std::this_thread::sleep_for(2s);
+    CHECK(firstNotifications == 5);
+    CHECK(secondNotifications == 10);
+    second.reset();
+    std::this_thread::sleep_for(1s);
+}
 #endif
 
 int main(int argc, char **argv)
@@ -16,6 +16,7 @@
 #include <drogon/HttpAppFramework.h>
 #include <drogon/config.h>
 #include <drogon/drogon_test.h>
+#include <drogon/orm/BatchInserter.h>
 #include <drogon/orm/CoroMapper.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/orm/DbTypes.h>
@@ -24,7 +25,9 @@
 #include <trantor/utils/Logger.h>
 
 #include <stdlib.h>
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <iostream>
 #include <string>
 #include <thread>
@@ -299,6 +302,14 @@ DROGON_TEST(PostgreTest)
             FAULT("postgresql - DbClient streaming-type interface(9) what():",
                   e.base().what());
         };
+    // A view of a constant, bound without a copy
+    *clientPtr << "select * from users where user_id=$1"
+               << ParameterView{"pg1"} >>
+        [TEST_CTX](const Result &r) { MANDATE(r.size() == 1); } >>
+        [TEST_CTX](const DrogonDbException &e) {
+            FAULT("postgresql - DbClient streaming-type interface(9) what():",
+                  e.base().what());
+        };
 
     /// 1.11 clean up
     *clientPtr << "truncate table users restart identity" >>
@@ -764,6 +775,25 @@ DROGON_TEST(PostgreTest)
             FAULT("postgresql - ORM mapper asynchronous interface(5) what():",
                   e.base().what());
         });
+    /// 6.3.8 keyset pagination
+    mapper.seek(Users::Cols::_id, 1).limit(1).findAll(
+        [TEST_CTX](std::vector<Users> users) {
+            MANDATE(users.size() == 1);
+            MANDATE(users[0].getValueOfId() > 1);
+        },
+        [TEST_CTX](const DrogonDbException &e) {
+            FAULT("postgresql - ORM mapper asynchronous interface(6) what():",
+                  e.base().what());
+        });
+    /// 6.3.9 batched loading by keys
+    mapper.findIn(
+        Users::Cols::_id,
+        std::vector<int32_t>{2, 2, 200},
+        [TEST_CTX](std::vector<Users> users) { MANDATE(users.size() == 1); },
+        [TEST_CTX](const DrogonDbException &e) {
+            FAULT("postgresql - ORM mapper asynchronous interface(7) what():",
+                  e.base().what());
+        });
     /// 6.4 find by primary key. blocking
     try
     {
@@ -893,6 +923,24 @@ DROGON_TEST(PostgreTest)
         FAULT("postgresql - ORM QueryBuilder synchronous interface(3) what():",
               e.base().what());
     }
+    try
+    {
+        // Rendered once, executed with new values
+        static const auto byId = QueryBuilder<Users>{}
+                                     .from("users")
+                                     .selectAll()
+                                     .eq("id", "0")
+                                     .single()
+                                     .prepare();
+        MANDATE(byId.parametersNumber() == 1);
+        MANDATE(byId.execSync(clientPtr, 3).getPrimaryKey() == 3);
+        MANDATE(byId.execSync(clientPtr, "2").getPrimaryKey() == 2);
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("postgresql - ORM QueryBuilder synchronous interface(4) what():",
+              e.base().what());
+    }
 
     /// execAsyncFuture
     {
@@ -1486,6 +1534,156 @@ DROGON_TEST(PostgreTest)
                 e.base().what());
         }
     }
+
+    /// 8.3 bulk insert
+    {
+        Mapper<Tag> tagMapper(clientPtr);
+        std::vector<Tag> tags(2500);
+        for (size_t i = 0; i < tags.size(); ++i)
+        {
+            tags[i].setName("bulk" + std::to_string(i));
+        }
+        try
+        {
+            MANDATE(tagMapper.insertMany(tags) == 2500);
+            MANDATE(tagMapper.count(Criteria(Tag::Cols::_name,
+                                             CompareOperator::Like,
+                                             "bulk%")) == 2500);
+        }
+        catch (const DrogonDbException &e)
+        {
+            FAULT("postgresql - ORM mapper bulk insert(0) what():",
+                  e.base().what());
+        }
+        tagMapper.insertMany(
+            std::vector<Tag>(tags.begin(), tags.begin() + 10),
+            [TEST_CTX](const size_t count) { MANDATE(count == 10); },
+            [TEST_CTX](const DrogonDbException &e) {
+                FAULT("postgresql - ORM mapper bulk insert(1) what():",
+                      e.base().what());
+            });
+    }
+
+    /// 8.4 batch inserter
+    {
+        auto inserter = BatchInserter<Tag>::newInserter(clientPtr, nullptr, 4);
+        std::vector<std::future<void>> futures;
+        for (size_t i = 0; i < 10; ++i)
+        {
+            Tag tag;
+            tag.setName("batched" + std::to_string(i));
+            futures.push_back(inserter->insertFuture(std::move(tag)));
+        }
+        MANDATE(inserter->queued() == 2);
+        inserter->flush();
+        MANDATE(inserter->queued() == 0);
+        try
+        {
+            for (auto &future : futures)
+                future.get();
+            Mapper<Tag> tagMapper(clientPtr);
+            MANDATE(tagMapper.count(Criteria(Tag::Cols::_name,
+                                             CompareOperator::Like,
+                                             "batched%")) == 10);
+        }
+        catch (const DrogonDbException &e)
+        {
+            FAULT("postgresql - batch inserter what():", e.base().what());
+        }
+    }
+}
+#endif
+
+#if USE_POSTGRESQL
+DbClientPtr postgreBinaryClient;
+
+DROGON_TEST(PostgreBinaryResultTest)
+{
+    auto &clientPtr = postgreBinaryClient;
+    try
+    {
+        auto r = clientPtr->execSqlSync(
+            "select 42::int2 as i2, -7::int4 as i4, "
+            "9007199254740993::int8 as i8, true as b, 1.5::float4 as f4, "
+            "0.1::float8 as f8, -12345.678::numeric(10,3) as num, "
+            "'2000-03-01 12:34:56.5'::timestamp as ts, '1999-12-31'::date "
+            "as d, '\\x00ff'::bytea as bin, 'abc'::text as txt, "
+            "ARRAY[1,NULL,3]::int4[] as arr, "
+            "'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid as id");
+        MANDATE(r.size() == 1);
+        auto row = r[0];
+        MANDATE(row["i2"].isBinary());
+        CHECK(row["i2"].as<int>() == 42);
+        CHECK(row["i4"].as<int>() == -7);
+        CHECK(row["i4"].as<std::string>() == "-7");
+        CHECK(row["i8"].as<int64_t>() == 9007199254740993LL);
+        CHECK(row["b"].as<bool>() == true);
+        CHECK(row["b"].as<std::string>() == "t");
+        CHECK(row["f4"].as<float>() == 1.5f);
+        CHECK(row["f8"].as<double>() == 0.1);
+        CHECK(row["f8"].as<std::string>() == "0.1");
+        CHECK(row["num"].as<std::string>() == "-12345.678");
+        CHECK(row["num"].as<double>() == -12345.678);
+        CHECK(row["ts"].as<std::string>() == "2000-03-01 12:34:56.5");
+        CHECK(row["d"].as<std::string>() == "1999-12-31");
+        CHECK(row["bin"].as<std::string>() == std::string("\x00\xff", 2));
+        CHECK(row["bin"].as<std::string_view>().size() == 2);
+        CHECK(row["txt"].as<std::string>() == "abc");
+        CHECK(row["arr"].as<std::string>() == "{1,NULL,3}");
+        auto arr = row["arr"].asArray<int>();
+        MANDATE(arr.size() == 3);
+        CHECK(*arr[0] == 1);
+        CHECK(arr[1] == nullptr);
+        CHECK(*arr[2] == 3);
+        CHECK(row["id"].as<std::string>() ==
+              "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11");
+
+        r = clientPtr->execSqlSync("select $1::int8 + 1 as n",
+                                   int64_t{1} << 40);
+        CHECK(r[0]["n"].as<int64_t>() == (int64_t{1} << 40) + 1);
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("postgresql - binary results what():", e.base().what());
+    }
+}
+
+DROGON_TEST(PostgreStreamTest)
+{
+    auto &clientPtr = postgreClient;
+    auto received = std::make_shared<std::atomic<int64_t>>(0);
+    auto chunks = std::make_shared<std::atomic<int>>(0);
+    clientPtr->execSqlStreamAsync(
+        "select n from generate_series(1, $1) as n",
+        100,
+        [TEST_CTX, received, chunks](const Result &rows,
+                                     bool isLast,
+                                     std::function<void()> &&resume) {
+            MANDATE(rows.size() <= 100);
+            for (auto const &row : rows)
+            {
+                CHECK(row["n"].as<int64_t>() == ++*received);
+            }
+            ++*chunks;
+            if (!isLast)
+            {
+                resume();
+                return;
+            }
+            CHECK(*received == 250);
+            CHECK(*chunks == 3);
+        },
+        [TEST_CTX](const std::exception_ptr &e) {
+            try
+            {
+                std::rethrow_exception(e);
+            }
+            catch (const DrogonDbException &e)
+            {
+                FAULT("postgresql - stream what():", e.base().what());
+            }
+        },
+        250);
 }
 #endif
 
@@ -2738,6 +2936,135 @@ DROGON_TEST(MySQLTest)
         }
     }
 }
+
+DbClientPtr mysqlPreparedClient;
+
+DROGON_TEST(MySQLPreparedStatementTest)
+{
+    auto &clientPtr = mysqlPreparedClient;
+    REQUIRE(clientPtr != nullptr);
+    const std::string quoted{"it's a \"quoted\" \\ value"};
+    const std::string binary{"a\0b\xff", 4};
+    try
+    {
+        clientPtr->execSqlSync("CREATE DATABASE IF NOT EXISTS drogonTestMysql");
+        clientPtr->execSqlSync(
+            "DROP TABLE IF EXISTS drogonTestMysql.prepared_values");
+        clientPtr->execSqlSync(
+            "CREATE TABLE drogonTestMysql.prepared_values ("
+            "    id int AUTO_INCREMENT PRIMARY KEY,"
+            "    name varchar(64) UNIQUE,"
+            "    amount bigint,"
+            "    ratio double,"
+            "    data varbinary(16),"
+            "    note varchar(32) DEFAULT 'none'"
+            ")");
+        // The same statement runs several times from the cache
+        for (int64_t i = 0; i < 5; ++i)
+        {
+            auto r = clientPtr->execSqlSync(
+                "insert into drogonTestMysql.prepared_values "
+                "(name, amount, ratio, data) values (?, ?, ?, ?)",
+                "name" + std::to_string(i),
+                (int64_t{1} << 40) + i,
+                0.5 * static_cast<double>(i),
+                binary);
+            CHECK(r.affectedRows() == 1);
+            CHECK(r.insertId() == static_cast<unsigned long long>(i + 1));
+        }
+        auto r = clientPtr->execSqlSync(
+            "insert into drogonTestMysql.prepared_values "
+            "(name, amount, ratio, data, note) values (?, ?, ?, ?, ?)",
+            quoted,
+            nullptr,
+            nullptr,
+            nullptr,
+            "note");
+        CHECK(r.affectedRows() == 1);
+
+        r = clientPtr->execSqlSync(
+            "select id, name, amount, ratio, data, note from "
+            "drogonTestMysql.prepared_values where amount >= ? order by id",
+            (int64_t{1} << 40) + 3);
+        MANDATE(r.size() == 2);
+        CHECK(r[0]["name"].as<std::string>() == "name3");
+        CHECK(r[0]["amount"].as<int64_t>() == (int64_t{1} << 40) + 3);
+        CHECK(r[0]["amount"].as<std::string>() == "1099511627779");
+        CHECK(r[0]["ratio"].as<double>() == 1.5);
+        CHECK(r[0]["data"].as<std::string>() == binary);
+        CHECK(r[0]["note"].as<std::string>() == "none");
+        CHECK(r[1]["id"].as<int>() == 5);
+
+        r = clientPtr->execSqlSync(
+            "select amount, ratio, data, note from "
+            "drogonTestMysql.prepared_values where name = ?",
+            quoted);
+        MANDATE(r.size() == 1);
+        CHECK(r[0]["amount"].isNull());
+        CHECK(r[0]["ratio"].isNull());
+        CHECK(r[0]["data"].isNull());
+        CHECK(r[0]["note"].as<std::string>() == "note");
+
+        // The prepared statements return the rows of the text protocol
+        auto text = mysqlClient->execSqlSync(
+            "select id, name, amount, ratio, data, note from "
+            "drogonTestMysql.prepared_values where id > ? order by id",
+            0);
+        auto prepared = clientPtr->execSqlSync(
+            "select id, name, amount, ratio, data, note from "
+            "drogonTestMysql.prepared_values where id > ? order by id",
+            0);
+        MANDATE(text.size() == 6);
+        MANDATE(prepared.size() == text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            for (size_t j = 0; j < text.columns(); ++j)
+            {
+                CHECK(prepared[i][j].isNull() == text[i][j].isNull());
+                CHECK(prepared[i][j].as<std::string>() ==
+                      text[i][j].as<std::string>());
+            }
+        }
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("mysql - prepared statements what():", e.base().what());
+    }
+
+    // An execution error is reported and the cached statement still works
+    try
+    {
+        clientPtr->execSqlSync(
+            "insert into drogonTestMysql.prepared_values "
+            "(name, amount, ratio, data) values (?, ?, ?, ?)",
+            "name0",
+            int64_t{0},
+            0.0,
+            binary);
+        FAULT("mysql - prepared statements: a duplicate key is accepted");
+    }
+    catch (const DrogonDbException &e)
+    {
+        SUCCESS();
+    }
+    try
+    {
+        auto r = clientPtr->execSqlSync(
+            "insert into drogonTestMysql.prepared_values "
+            "(name, amount, ratio, data) values (?, ?, ?, ?)",
+            "name6",
+            int64_t{6},
+            3.0,
+            binary);
+        CHECK(r.affectedRows() == 1);
+        clientPtr->execSqlSync("DROP TABLE drogonTestMysql.prepared_values");
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("mysql - prepared statements after an error what():",
+              e.base().what());
+    }
+}
 #endif
 
 #if USE_SQLITE3
@@ -4061,6 +4388,64 @@ DROGON_TEST(SQLite3Test)
         }
     }
 }
+
+DbClientPtr sqlite3WalClient;
+
+DROGON_TEST(SQLite3WalTest)
+{
+    auto &clientPtr = sqlite3WalClient;
+    REQUIRE(clientPtr != nullptr);
+    try
+    {
+        clientPtr->execSqlSync("drop table if exists wal_items");
+        clientPtr->execSqlSync(
+            "create table wal_items (id integer primary key, name text)");
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("sqlite3 - WAL pool prepare what():", e.base().what());
+    }
+    // The writes pile up behind the writer and are committed in batches, the
+    // duplicate key only fails its own insert.
+    constexpr int kInserts = 200;
+    std::atomic<int> inserted{0}, violations{0}, done{0};
+    std::promise<void> allDone;
+    auto finish = [&]() {
+        if (++done == kInserts + 1)
+            allDone.set_value();
+    };
+    for (int i = 0; i <= kInserts; ++i)
+    {
+        clientPtr->execSqlAsync(
+            "insert into wal_items (id, name) values (?, ?)",
+            [&](const Result &r) {
+                inserted += static_cast<int>(r.affectedRows());
+                finish();
+            },
+            [&](const DrogonDbException &e) {
+                if (dynamic_cast<const UniqueViolation *>(&e.base()))
+                    ++violations;
+                finish();
+            },
+            i == kInserts ? 0 : i,
+            std::to_string(i));
+    }
+    allDone.get_future().wait();
+    CHECK(inserted == kInserts);
+    CHECK(violations == 1);
+    try
+    {
+        auto r = clientPtr->execSqlSync("select count(*) from wal_items");
+        CHECK(r[0][0].as<int>() == kInserts);
+        r = clientPtr->execSqlSync("pragma journal_mode");
+        CHECK(r[0][0].as<std::string>() == "wal");
+        clientPtr->execSqlSync("drop table wal_items");
+    }
+    catch (const DrogonDbException &e)
+    {
+        FAULT("sqlite3 - WAL pool what():", e.base().what());
+    }
+}
 #endif
 
 using namespace drogon;
@@ -4072,6 +4457,8 @@ int main(int argc, char **argv)
 #if USE_MYSQL
     mysqlClient = DbClient::newMysqlClient(
         "host=127.0.0.1 port=3306 user=root client_encoding=utf8mb4", 1);
+    mysqlPreparedClient = DbClient::newMysqlClient(
+        "host=127.0.0.1 port=3306 user=root client_encoding=utf8mb4", 1, true);
 #endif
 #if USE_POSTGRESQL
     postgreClient = DbClient::newPgClient(
@@ -4079,9 +4466,17 @@ int main(int argc, char **argv)
         "client_encoding=utf8",
         1,
         true);
+    postgreBinaryClient = DbClient::newPgClient(
+        "host=127.0.0.1 port=5432 dbname=postgres user=postgres password=12345 "
+        "client_encoding=utf8",
+        1,
+        false,
+        true);
 #endif
 #if USE_SQLITE3
     sqlite3Client = DbClient::newSqlite3Client("filename=:memory:", 1);
+    sqlite3WalClient =
+        DbClient::newSqlite3WalClient("filename=drogon_wal_test.db", 2, true);
 #endif
     const int testStatus = test::run(argc, argv);
     return testStatus;